@@ -0,0 +1,11 @@
+set(CTEST_CUSTOM_TESTS_IGNORE
+  CoreTests
+  IntegrationTestLibrary
+  TestGenerator
+  CryptoTests
+  IntegrationTests
+  NodeRpcProxyTests
+  PerformanceTests
+  TransfersTests
+  )
+
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Checkpoints.dir/Checkpoints/Checkpoints.cpp.o"
+  "CMakeFiles/Checkpoints.dir/Checkpoints/Checkpoints.cpp.o.d"
+  "libCheckpoints.a"
+  "libCheckpoints.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Checkpoints.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
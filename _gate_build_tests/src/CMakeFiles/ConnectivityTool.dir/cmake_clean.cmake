@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/ConnectivityTool.dir/ConnectivityTool/ConnectivityTool.cpp.o"
+  "CMakeFiles/ConnectivityTool.dir/ConnectivityTool/ConnectivityTool.cpp.o.d"
+  "connectivity_tool"
+  "connectivity_tool.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/ConnectivityTool.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/CryptoNoteProtocol.dir/CryptoNoteProtocol/CryptoNoteProtocolHandler.cpp.o"
+  "CMakeFiles/CryptoNoteProtocol.dir/CryptoNoteProtocol/CryptoNoteProtocolHandler.cpp.o.d"
+  "CMakeFiles/CryptoNoteProtocol.dir/CryptoNoteProtocol/StemPool.cpp.o"
+  "CMakeFiles/CryptoNoteProtocol.dir/CryptoNoteProtocol/StemPool.cpp.o.d"
+  "libCryptoNoteProtocol.a"
+  "libCryptoNoteProtocol.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/CryptoNoteProtocol.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,44 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/GreenWallet/AddressBook.cpp" "src/CMakeFiles/GreenWallet.dir/GreenWallet/AddressBook.cpp.o" "gcc" "src/CMakeFiles/GreenWallet.dir/GreenWallet/AddressBook.cpp.o.d"
+  "/root/repo/src/GreenWallet/CommandDispatcher.cpp" "src/CMakeFiles/GreenWallet.dir/GreenWallet/CommandDispatcher.cpp.o" "gcc" "src/CMakeFiles/GreenWallet.dir/GreenWallet/CommandDispatcher.cpp.o.d"
+  "/root/repo/src/GreenWallet/CommandImplementations.cpp" "src/CMakeFiles/GreenWallet.dir/GreenWallet/CommandImplementations.cpp.o" "gcc" "src/CMakeFiles/GreenWallet.dir/GreenWallet/CommandImplementations.cpp.o.d"
+  "/root/repo/src/GreenWallet/Commands.cpp" "src/CMakeFiles/GreenWallet.dir/GreenWallet/Commands.cpp.o" "gcc" "src/CMakeFiles/GreenWallet.dir/GreenWallet/Commands.cpp.o.d"
+  "/root/repo/src/GreenWallet/Fusion.cpp" "src/CMakeFiles/GreenWallet.dir/GreenWallet/Fusion.cpp.o" "gcc" "src/CMakeFiles/GreenWallet.dir/GreenWallet/Fusion.cpp.o.d"
+  "/root/repo/src/GreenWallet/GetInput.cpp" "src/CMakeFiles/GreenWallet.dir/GreenWallet/GetInput.cpp.o" "gcc" "src/CMakeFiles/GreenWallet.dir/GreenWallet/GetInput.cpp.o.d"
+  "/root/repo/src/GreenWallet/Menu.cpp" "src/CMakeFiles/GreenWallet.dir/GreenWallet/Menu.cpp.o" "gcc" "src/CMakeFiles/GreenWallet.dir/GreenWallet/Menu.cpp.o.d"
+  "/root/repo/src/GreenWallet/Open.cpp" "src/CMakeFiles/GreenWallet.dir/GreenWallet/Open.cpp.o" "gcc" "src/CMakeFiles/GreenWallet.dir/GreenWallet/Open.cpp.o.d"
+  "/root/repo/src/GreenWallet/ParseArguments.cpp" "src/CMakeFiles/GreenWallet.dir/GreenWallet/ParseArguments.cpp.o" "gcc" "src/CMakeFiles/GreenWallet.dir/GreenWallet/ParseArguments.cpp.o.d"
+  "/root/repo/src/GreenWallet/Sync.cpp" "src/CMakeFiles/GreenWallet.dir/GreenWallet/Sync.cpp.o" "gcc" "src/CMakeFiles/GreenWallet.dir/GreenWallet/Sync.cpp.o.d"
+  "/root/repo/src/GreenWallet/Tools.cpp" "src/CMakeFiles/GreenWallet.dir/GreenWallet/Tools.cpp.o" "gcc" "src/CMakeFiles/GreenWallet.dir/GreenWallet/Tools.cpp.o.d"
+  "/root/repo/src/GreenWallet/Transfer.cpp" "src/CMakeFiles/GreenWallet.dir/GreenWallet/Transfer.cpp.o" "gcc" "src/CMakeFiles/GreenWallet.dir/GreenWallet/Transfer.cpp.o.d"
+  "/root/repo/src/GreenWallet/ZedWallet.cpp" "src/CMakeFiles/GreenWallet.dir/GreenWallet/ZedWallet.cpp.o" "gcc" "src/CMakeFiles/GreenWallet.dir/GreenWallet/ZedWallet.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_build_tests/src/CMakeFiles/Wallet.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/Transfers.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/NodeRpcProxy.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/Rpc.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/Http.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/CryptoNoteCore.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/Logging.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/Serialization.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/Crypto.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/System.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/Checkpoints.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/Mnemonics.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/Common.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
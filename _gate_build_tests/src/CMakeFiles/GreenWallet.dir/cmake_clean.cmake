@@ -0,0 +1,35 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/GreenWallet.dir/GreenWallet/AddressBook.cpp.o"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/AddressBook.cpp.o.d"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/CommandDispatcher.cpp.o"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/CommandDispatcher.cpp.o.d"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/CommandImplementations.cpp.o"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/CommandImplementations.cpp.o.d"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/Commands.cpp.o"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/Commands.cpp.o.d"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/Fusion.cpp.o"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/Fusion.cpp.o.d"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/GetInput.cpp.o"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/GetInput.cpp.o.d"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/Menu.cpp.o"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/Menu.cpp.o.d"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/Open.cpp.o"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/Open.cpp.o.d"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/ParseArguments.cpp.o"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/ParseArguments.cpp.o.d"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/Sync.cpp.o"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/Sync.cpp.o.d"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/Tools.cpp.o"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/Tools.cpp.o.d"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/Transfer.cpp.o"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/Transfer.cpp.o.d"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/ZedWallet.cpp.o"
+  "CMakeFiles/GreenWallet.dir/GreenWallet/ZedWallet.cpp.o.d"
+  "greenwallet"
+  "greenwallet.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/GreenWallet.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
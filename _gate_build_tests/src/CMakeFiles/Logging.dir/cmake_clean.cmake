@@ -0,0 +1,27 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Logging.dir/Logging/CommonLogger.cpp.o"
+  "CMakeFiles/Logging.dir/Logging/CommonLogger.cpp.o.d"
+  "CMakeFiles/Logging.dir/Logging/ConsoleLogger.cpp.o"
+  "CMakeFiles/Logging.dir/Logging/ConsoleLogger.cpp.o.d"
+  "CMakeFiles/Logging.dir/Logging/FileLogger.cpp.o"
+  "CMakeFiles/Logging.dir/Logging/FileLogger.cpp.o.d"
+  "CMakeFiles/Logging.dir/Logging/ILogger.cpp.o"
+  "CMakeFiles/Logging.dir/Logging/ILogger.cpp.o.d"
+  "CMakeFiles/Logging.dir/Logging/LoggerGroup.cpp.o"
+  "CMakeFiles/Logging.dir/Logging/LoggerGroup.cpp.o.d"
+  "CMakeFiles/Logging.dir/Logging/LoggerManager.cpp.o"
+  "CMakeFiles/Logging.dir/Logging/LoggerManager.cpp.o.d"
+  "CMakeFiles/Logging.dir/Logging/LoggerMessage.cpp.o"
+  "CMakeFiles/Logging.dir/Logging/LoggerMessage.cpp.o.d"
+  "CMakeFiles/Logging.dir/Logging/LoggerRef.cpp.o"
+  "CMakeFiles/Logging.dir/Logging/LoggerRef.cpp.o.d"
+  "CMakeFiles/Logging.dir/Logging/StreamLogger.cpp.o"
+  "CMakeFiles/Logging.dir/Logging/StreamLogger.cpp.o.d"
+  "libLogging.a"
+  "libLogging.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Logging.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
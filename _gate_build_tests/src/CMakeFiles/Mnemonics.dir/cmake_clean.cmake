@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Mnemonics.dir/Mnemonics/electrum-words.cpp.o"
+  "CMakeFiles/Mnemonics.dir/Mnemonics/electrum-words.cpp.o.d"
+  "libMnemonics.a"
+  "libMnemonics.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Mnemonics.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Optimizer.dir/Optimizer/Optimizer.cpp.o"
+  "CMakeFiles/Optimizer.dir/Optimizer/Optimizer.cpp.o.d"
+  "optimizer"
+  "optimizer.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Optimizer.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,23 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/P2p/LevinProtocol.cpp" "src/CMakeFiles/P2P.dir/P2p/LevinProtocol.cpp.o" "gcc" "src/CMakeFiles/P2P.dir/P2p/LevinProtocol.cpp.o.d"
+  "/root/repo/src/P2p/NetNode.cpp" "src/CMakeFiles/P2P.dir/P2p/NetNode.cpp.o" "gcc" "src/CMakeFiles/P2P.dir/P2p/NetNode.cpp.o.d"
+  "/root/repo/src/P2p/NetNodeConfig.cpp" "src/CMakeFiles/P2P.dir/P2p/NetNodeConfig.cpp.o" "gcc" "src/CMakeFiles/P2P.dir/P2p/NetNodeConfig.cpp.o.d"
+  "/root/repo/src/P2p/NetworkCrawlReport.cpp" "src/CMakeFiles/P2P.dir/P2p/NetworkCrawlReport.cpp.o" "gcc" "src/CMakeFiles/P2P.dir/P2p/NetworkCrawlReport.cpp.o.d"
+  "/root/repo/src/P2p/PeerListManager.cpp" "src/CMakeFiles/P2P.dir/P2p/PeerListManager.cpp.o" "gcc" "src/CMakeFiles/P2P.dir/P2p/PeerListManager.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,19 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/P2P.dir/P2p/LevinProtocol.cpp.o"
+  "CMakeFiles/P2P.dir/P2p/LevinProtocol.cpp.o.d"
+  "CMakeFiles/P2P.dir/P2p/NetNode.cpp.o"
+  "CMakeFiles/P2P.dir/P2p/NetNode.cpp.o.d"
+  "CMakeFiles/P2P.dir/P2p/NetNodeConfig.cpp.o"
+  "CMakeFiles/P2P.dir/P2p/NetNodeConfig.cpp.o.d"
+  "CMakeFiles/P2P.dir/P2p/NetworkCrawlReport.cpp.o"
+  "CMakeFiles/P2P.dir/P2p/NetworkCrawlReport.cpp.o.d"
+  "CMakeFiles/P2P.dir/P2p/PeerListManager.cpp.o"
+  "CMakeFiles/P2P.dir/P2p/PeerListManager.cpp.o.d"
+  "libP2P.a"
+  "libP2P.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/P2P.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,23 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Transfers.dir/Transfers/BlockchainSynchronizer.cpp.o"
+  "CMakeFiles/Transfers.dir/Transfers/BlockchainSynchronizer.cpp.o.d"
+  "CMakeFiles/Transfers.dir/Transfers/SharedBlockchainSynchronizer.cpp.o"
+  "CMakeFiles/Transfers.dir/Transfers/SharedBlockchainSynchronizer.cpp.o.d"
+  "CMakeFiles/Transfers.dir/Transfers/SynchronizationState.cpp.o"
+  "CMakeFiles/Transfers.dir/Transfers/SynchronizationState.cpp.o.d"
+  "CMakeFiles/Transfers.dir/Transfers/TransfersConsumer.cpp.o"
+  "CMakeFiles/Transfers.dir/Transfers/TransfersConsumer.cpp.o.d"
+  "CMakeFiles/Transfers.dir/Transfers/TransfersContainer.cpp.o"
+  "CMakeFiles/Transfers.dir/Transfers/TransfersContainer.cpp.o.d"
+  "CMakeFiles/Transfers.dir/Transfers/TransfersSubscription.cpp.o"
+  "CMakeFiles/Transfers.dir/Transfers/TransfersSubscription.cpp.o.d"
+  "CMakeFiles/Transfers.dir/Transfers/TransfersSynchronizer.cpp.o"
+  "CMakeFiles/Transfers.dir/Transfers/TransfersSynchronizer.cpp.o.d"
+  "libTransfers.a"
+  "libTransfers.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Transfers.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
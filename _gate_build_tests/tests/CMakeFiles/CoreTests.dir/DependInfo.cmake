@@ -0,0 +1,41 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/tests/CoreTests/BlockReward.cpp" "tests/CMakeFiles/CoreTests.dir/CoreTests/BlockReward.cpp.o" "gcc" "tests/CMakeFiles/CoreTests.dir/CoreTests/BlockReward.cpp.o.d"
+  "/root/repo/tests/CoreTests/BlockValidation.cpp" "tests/CMakeFiles/CoreTests.dir/CoreTests/BlockValidation.cpp.o" "gcc" "tests/CMakeFiles/CoreTests.dir/CoreTests/BlockValidation.cpp.o.d"
+  "/root/repo/tests/CoreTests/ChainSplit1.cpp" "tests/CMakeFiles/CoreTests.dir/CoreTests/ChainSplit1.cpp.o" "gcc" "tests/CMakeFiles/CoreTests.dir/CoreTests/ChainSplit1.cpp.o.d"
+  "/root/repo/tests/CoreTests/ChainSwitch1.cpp" "tests/CMakeFiles/CoreTests.dir/CoreTests/ChainSwitch1.cpp.o" "gcc" "tests/CMakeFiles/CoreTests.dir/CoreTests/ChainSwitch1.cpp.o.d"
+  "/root/repo/tests/CoreTests/Chaingen.cpp" "tests/CMakeFiles/CoreTests.dir/CoreTests/Chaingen.cpp.o" "gcc" "tests/CMakeFiles/CoreTests.dir/CoreTests/Chaingen.cpp.o.d"
+  "/root/repo/tests/CoreTests/Chaingen001.cpp" "tests/CMakeFiles/CoreTests.dir/CoreTests/Chaingen001.cpp.o" "gcc" "tests/CMakeFiles/CoreTests.dir/CoreTests/Chaingen001.cpp.o.d"
+  "/root/repo/tests/CoreTests/ChaingenMain.cpp" "tests/CMakeFiles/CoreTests.dir/CoreTests/ChaingenMain.cpp.o" "gcc" "tests/CMakeFiles/CoreTests.dir/CoreTests/ChaingenMain.cpp.o.d"
+  "/root/repo/tests/CoreTests/DoubleSpend.cpp" "tests/CMakeFiles/CoreTests.dir/CoreTests/DoubleSpend.cpp.o" "gcc" "tests/CMakeFiles/CoreTests.dir/CoreTests/DoubleSpend.cpp.o.d"
+  "/root/repo/tests/CoreTests/IntegerOverflow.cpp" "tests/CMakeFiles/CoreTests.dir/CoreTests/IntegerOverflow.cpp.o" "gcc" "tests/CMakeFiles/CoreTests.dir/CoreTests/IntegerOverflow.cpp.o.d"
+  "/root/repo/tests/CoreTests/RandomOuts.cpp" "tests/CMakeFiles/CoreTests.dir/CoreTests/RandomOuts.cpp.o" "gcc" "tests/CMakeFiles/CoreTests.dir/CoreTests/RandomOuts.cpp.o.d"
+  "/root/repo/tests/CoreTests/RingSignature.cpp" "tests/CMakeFiles/CoreTests.dir/CoreTests/RingSignature.cpp.o" "gcc" "tests/CMakeFiles/CoreTests.dir/CoreTests/RingSignature.cpp.o.d"
+  "/root/repo/tests/CoreTests/TransactionBuilder.cpp" "tests/CMakeFiles/CoreTests.dir/CoreTests/TransactionBuilder.cpp.o" "gcc" "tests/CMakeFiles/CoreTests.dir/CoreTests/TransactionBuilder.cpp.o.d"
+  "/root/repo/tests/CoreTests/TransactionTests.cpp" "tests/CMakeFiles/CoreTests.dir/CoreTests/TransactionTests.cpp.o" "gcc" "tests/CMakeFiles/CoreTests.dir/CoreTests/TransactionTests.cpp.o.d"
+  "/root/repo/tests/CoreTests/TransactionValidation.cpp" "tests/CMakeFiles/CoreTests.dir/CoreTests/TransactionValidation.cpp.o" "gcc" "tests/CMakeFiles/CoreTests.dir/CoreTests/TransactionValidation.cpp.o.d"
+  "/root/repo/tests/CoreTests/Upgrade.cpp" "tests/CMakeFiles/CoreTests.dir/CoreTests/Upgrade.cpp.o" "gcc" "tests/CMakeFiles/CoreTests.dir/CoreTests/Upgrade.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_build_tests/tests/CMakeFiles/TestGenerator.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/CryptoNoteCore.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/Serialization.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/System.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/Logging.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/Common.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/Crypto.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/src/CMakeFiles/BlockchainExplorer.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
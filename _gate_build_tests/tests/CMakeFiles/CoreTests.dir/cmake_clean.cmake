@@ -0,0 +1,39 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/CoreTests.dir/CoreTests/BlockReward.cpp.o"
+  "CMakeFiles/CoreTests.dir/CoreTests/BlockReward.cpp.o.d"
+  "CMakeFiles/CoreTests.dir/CoreTests/BlockValidation.cpp.o"
+  "CMakeFiles/CoreTests.dir/CoreTests/BlockValidation.cpp.o.d"
+  "CMakeFiles/CoreTests.dir/CoreTests/ChainSplit1.cpp.o"
+  "CMakeFiles/CoreTests.dir/CoreTests/ChainSplit1.cpp.o.d"
+  "CMakeFiles/CoreTests.dir/CoreTests/ChainSwitch1.cpp.o"
+  "CMakeFiles/CoreTests.dir/CoreTests/ChainSwitch1.cpp.o.d"
+  "CMakeFiles/CoreTests.dir/CoreTests/Chaingen.cpp.o"
+  "CMakeFiles/CoreTests.dir/CoreTests/Chaingen.cpp.o.d"
+  "CMakeFiles/CoreTests.dir/CoreTests/Chaingen001.cpp.o"
+  "CMakeFiles/CoreTests.dir/CoreTests/Chaingen001.cpp.o.d"
+  "CMakeFiles/CoreTests.dir/CoreTests/ChaingenMain.cpp.o"
+  "CMakeFiles/CoreTests.dir/CoreTests/ChaingenMain.cpp.o.d"
+  "CMakeFiles/CoreTests.dir/CoreTests/DoubleSpend.cpp.o"
+  "CMakeFiles/CoreTests.dir/CoreTests/DoubleSpend.cpp.o.d"
+  "CMakeFiles/CoreTests.dir/CoreTests/IntegerOverflow.cpp.o"
+  "CMakeFiles/CoreTests.dir/CoreTests/IntegerOverflow.cpp.o.d"
+  "CMakeFiles/CoreTests.dir/CoreTests/RandomOuts.cpp.o"
+  "CMakeFiles/CoreTests.dir/CoreTests/RandomOuts.cpp.o.d"
+  "CMakeFiles/CoreTests.dir/CoreTests/RingSignature.cpp.o"
+  "CMakeFiles/CoreTests.dir/CoreTests/RingSignature.cpp.o.d"
+  "CMakeFiles/CoreTests.dir/CoreTests/TransactionBuilder.cpp.o"
+  "CMakeFiles/CoreTests.dir/CoreTests/TransactionBuilder.cpp.o.d"
+  "CMakeFiles/CoreTests.dir/CoreTests/TransactionTests.cpp.o"
+  "CMakeFiles/CoreTests.dir/CoreTests/TransactionTests.cpp.o.d"
+  "CMakeFiles/CoreTests.dir/CoreTests/TransactionValidation.cpp.o"
+  "CMakeFiles/CoreTests.dir/CoreTests/TransactionValidation.cpp.o.d"
+  "CMakeFiles/CoreTests.dir/CoreTests/Upgrade.cpp.o"
+  "CMakeFiles/CoreTests.dir/CoreTests/Upgrade.cpp.o.d"
+  "core_tests"
+  "core_tests.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/CoreTests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,21 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/CryptoTests.dir/crypto/crypto-ops-data.c.o"
+  "CMakeFiles/CryptoTests.dir/crypto/crypto-ops-data.c.o.d"
+  "CMakeFiles/CryptoTests.dir/crypto/crypto-ops.c.o"
+  "CMakeFiles/CryptoTests.dir/crypto/crypto-ops.c.o.d"
+  "CMakeFiles/CryptoTests.dir/crypto/crypto.cpp.o"
+  "CMakeFiles/CryptoTests.dir/crypto/crypto.cpp.o.d"
+  "CMakeFiles/CryptoTests.dir/crypto/hash.c.o"
+  "CMakeFiles/CryptoTests.dir/crypto/hash.c.o.d"
+  "CMakeFiles/CryptoTests.dir/crypto/main.cpp.o"
+  "CMakeFiles/CryptoTests.dir/crypto/main.cpp.o.d"
+  "CMakeFiles/CryptoTests.dir/crypto/random.c.o"
+  "CMakeFiles/CryptoTests.dir/crypto/random.c.o.d"
+  "crypto_tests"
+  "crypto_tests.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C CXX)
+  include(CMakeFiles/CryptoTests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,23 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/IntegrationTestLibrary.dir/IntegrationTestLib/BaseFunctionalTests.cpp.o"
+  "CMakeFiles/IntegrationTestLibrary.dir/IntegrationTestLib/BaseFunctionalTests.cpp.o.d"
+  "CMakeFiles/IntegrationTestLibrary.dir/IntegrationTestLib/InProcTestNode.cpp.o"
+  "CMakeFiles/IntegrationTestLibrary.dir/IntegrationTestLib/InProcTestNode.cpp.o.d"
+  "CMakeFiles/IntegrationTestLibrary.dir/IntegrationTestLib/Logger.cpp.o"
+  "CMakeFiles/IntegrationTestLibrary.dir/IntegrationTestLib/Logger.cpp.o.d"
+  "CMakeFiles/IntegrationTestLibrary.dir/IntegrationTestLib/Process.cpp.o"
+  "CMakeFiles/IntegrationTestLibrary.dir/IntegrationTestLib/Process.cpp.o.d"
+  "CMakeFiles/IntegrationTestLibrary.dir/IntegrationTestLib/RPCTestNode.cpp.o"
+  "CMakeFiles/IntegrationTestLibrary.dir/IntegrationTestLib/RPCTestNode.cpp.o.d"
+  "CMakeFiles/IntegrationTestLibrary.dir/IntegrationTestLib/TestNetwork.cpp.o"
+  "CMakeFiles/IntegrationTestLibrary.dir/IntegrationTestLib/TestNetwork.cpp.o.d"
+  "CMakeFiles/IntegrationTestLibrary.dir/IntegrationTestLib/TestWalletLegacy.cpp.o"
+  "CMakeFiles/IntegrationTestLibrary.dir/IntegrationTestLib/TestWalletLegacy.cpp.o.d"
+  "libIntegrationTestLibrary.a"
+  "libIntegrationTestLibrary.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/IntegrationTestLibrary.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/NetworkSimulator.dir/NetworkSimulator/main.cpp.o"
+  "CMakeFiles/NetworkSimulator.dir/NetworkSimulator/main.cpp.o.d"
+  "network_simulator"
+  "network_simulator.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/NetworkSimulator.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
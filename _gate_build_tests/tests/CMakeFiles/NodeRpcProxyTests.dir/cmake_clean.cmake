@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/NodeRpcProxyTests.dir/NodeRpcProxyTests/NodeRpcProxyTests.cpp.o"
+  "CMakeFiles/NodeRpcProxyTests.dir/NodeRpcProxyTests/NodeRpcProxyTests.cpp.o.d"
+  "node_rpc_proxy_tests"
+  "node_rpc_proxy_tests.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/NodeRpcProxyTests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/RpcLoadTest.dir/RpcLoadTest/main.cpp.o"
+  "CMakeFiles/RpcLoadTest.dir/RpcLoadTest/main.cpp.o.d"
+  "rpc_load_test"
+  "rpc_load_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/RpcLoadTest.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
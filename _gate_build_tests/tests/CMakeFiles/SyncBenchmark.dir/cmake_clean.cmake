@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/SyncBenchmark.dir/SyncBenchmark/main.cpp.o"
+  "CMakeFiles/SyncBenchmark.dir/SyncBenchmark/main.cpp.o.d"
+  "sync_benchmark"
+  "sync_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/SyncBenchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,40 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/tests/System/ContextGroupTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/ContextGroupTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/ContextGroupTests.cpp.o.d"
+  "/root/repo/tests/System/ContextGroupTimeoutTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/ContextGroupTimeoutTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/ContextGroupTimeoutTests.cpp.o.d"
+  "/root/repo/tests/System/ContextTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/ContextTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/ContextTests.cpp.o.d"
+  "/root/repo/tests/System/DispatcherTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/DispatcherTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/DispatcherTests.cpp.o.d"
+  "/root/repo/tests/System/ErrorMessageTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/ErrorMessageTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/ErrorMessageTests.cpp.o.d"
+  "/root/repo/tests/System/EventLockTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/EventLockTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/EventLockTests.cpp.o.d"
+  "/root/repo/tests/System/EventTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/EventTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/EventTests.cpp.o.d"
+  "/root/repo/tests/System/Ipv4AddressTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/Ipv4AddressTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/Ipv4AddressTests.cpp.o.d"
+  "/root/repo/tests/System/Ipv4ResolverTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/Ipv4ResolverTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/Ipv4ResolverTests.cpp.o.d"
+  "/root/repo/tests/System/OperationTimeoutTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/OperationTimeoutTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/OperationTimeoutTests.cpp.o.d"
+  "/root/repo/tests/System/ReadWriteLockTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/ReadWriteLockTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/ReadWriteLockTests.cpp.o.d"
+  "/root/repo/tests/System/RemoteContextTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/RemoteContextTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/RemoteContextTests.cpp.o.d"
+  "/root/repo/tests/System/RemoteSpawnQueueTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/RemoteSpawnQueueTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/RemoteSpawnQueueTests.cpp.o.d"
+  "/root/repo/tests/System/TcpConnectionTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/TcpConnectionTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/TcpConnectionTests.cpp.o.d"
+  "/root/repo/tests/System/TcpConnectorTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/TcpConnectorTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/TcpConnectorTests.cpp.o.d"
+  "/root/repo/tests/System/TcpListenerTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/TcpListenerTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/TcpListenerTests.cpp.o.d"
+  "/root/repo/tests/System/ThreadPoolTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/ThreadPoolTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/ThreadPoolTests.cpp.o.d"
+  "/root/repo/tests/System/TimerTests.cpp" "tests/CMakeFiles/SystemTests.dir/System/TimerTests.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/TimerTests.cpp.o.d"
+  "/root/repo/tests/System/main.cpp" "tests/CMakeFiles/SystemTests.dir/System/main.cpp.o" "gcc" "tests/CMakeFiles/SystemTests.dir/System/main.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_build_tests/src/CMakeFiles/System.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/external/gtest/CMakeFiles/gtest_main.dir/DependInfo.cmake"
+  "/root/repo/_gate_build_tests/external/gtest/CMakeFiles/gtest.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/TestGenerator.dir/TestGenerator/TestGenerator.cpp.o"
+  "CMakeFiles/TestGenerator.dir/TestGenerator/TestGenerator.cpp.o.d"
+  "libTestGenerator.a"
+  "libTestGenerator.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/TestGenerator.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
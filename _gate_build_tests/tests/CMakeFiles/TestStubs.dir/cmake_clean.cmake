@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/TestStubs.dir/TestStubs/ICoreStub.cpp.o"
+  "CMakeFiles/TestStubs.dir/TestStubs/ICoreStub.cpp.o.d"
+  "libTestStubs.a"
+  "libTestStubs.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/TestStubs.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
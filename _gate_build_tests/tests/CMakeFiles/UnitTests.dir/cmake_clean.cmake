@@ -0,0 +1,169 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/UnitTests.dir/UnitTests/ArrayRefTests.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/ArrayRefTests.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/ArrayViewTests.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/ArrayViewTests.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/Base58.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/Base58.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/BinarySerializationCompatibility.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/BinarySerializationCompatibility.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/BlockReward.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/BlockReward.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/BlockingQueue.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/BlockingQueue.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/Chacha8.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/Chacha8.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/Checkpoints.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/Checkpoints.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/DecomposeAmountIntoDigits.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/DecomposeAmountIntoDigits.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/EventWaiter.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/EventWaiter.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/ICryptoNoteProtocolQueryStub.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/ICryptoNoteProtocolQueryStub.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/INodeStubs.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/INodeStubs.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/MulDiv.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/MulDiv.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/ParseAmount.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/ParseAmount.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/PaymentGateTests.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/PaymentGateTests.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/Serialization.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/Serialization.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/SerializationKV.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/SerializationKV.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/Shuffle.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/Shuffle.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/StringBufferTests.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/StringBufferTests.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/StringViewTests.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/StringViewTests.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestBcS.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestBcS.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestBlockFilter.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestBlockFilter.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestBlockHeaderColumns.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestBlockHeaderColumns.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestBlockchainExplorer.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestBlockchainExplorer.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestBlockchainGenerator.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestBlockchainGenerator.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestClockCache.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestClockCache.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestCpuList.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestCpuList.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestCryptoPrecomp.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestCryptoPrecomp.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestCurrency.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestCurrency.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestFastHashMulti.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestFastHashMulti.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestFileMappedHashTable.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestFileMappedHashTable.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestFileMappedVector.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestFileMappedVector.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestFormatUtils.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestFormatUtils.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestHttpClientPool.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestHttpClientPool.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestHttpCompression.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestHttpCompression.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestHttpParser.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestHttpParser.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestHttpResponse.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestHttpResponse.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestHttpServerAdmission.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestHttpServerAdmission.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestInprocessNode.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestInprocessNode.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestJsonInputReader.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestJsonInputReader.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestJsonOutputWriter.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestJsonOutputWriter.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestJsonRpcBatch.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestJsonRpcBatch.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestJsonValue.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestJsonValue.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestKeyDerivationBatch.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestKeyDerivationBatch.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestLongHashCache.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestLongHashCache.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestMessageQueue.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestMessageQueue.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestMetrics.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestMetrics.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestNetworkCrawlReport.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestNetworkCrawlReport.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestPath.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestPath.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestPeerlist.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestPeerlist.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestProtocolPack.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestProtocolPack.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestRecursiveSharedMutex.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestRecursiveSharedMutex.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestRingMemberCache.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestRingMemberCache.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestRollingBloomFilter.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestRollingBloomFilter.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestRpcMetrics.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestRpcMetrics.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestRpcResponseCache.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestRpcResponseCache.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestSlidingMedian.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestSlidingMedian.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestSlowHashMulti.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestSlowHashMulti.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestStemPool.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestStemPool.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestStratumServer.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestStratumServer.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestTokenBucket.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestTokenBucket.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestTracing.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestTracing.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestTransactionPoolDetach.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestTransactionPoolDetach.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestTransfers.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestTransfers.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestTransfersConsumer.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestTransfersConsumer.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestTransfersContainer.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestTransfersContainer.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestTransfersContainerKeyImage.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestTransfersContainerKeyImage.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestTransfersSubscription.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestTransfersSubscription.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestUpgradeDetector.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestUpgradeDetector.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestViewKeyScanner.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestViewKeyScanner.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestWallet.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestWallet.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestWalletCacheChunks.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestWalletCacheChunks.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestWalletDecoyCache.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestWalletDecoyCache.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestWalletLegacy.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestWalletLegacy.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestWalletService.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestWalletService.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestWalletUserTransactionsCache.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TestWalletUserTransactionsCache.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TransactionApi.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TransactionApi.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TransactionApiHelpers.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TransactionApiHelpers.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/TransactionPool.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/TransactionPool.cpp.o.d"
+  "CMakeFiles/UnitTests.dir/UnitTests/main.cpp.o"
+  "CMakeFiles/UnitTests.dir/UnitTests/main.cpp.o.d"
+  "unit_tests"
+  "unit_tests.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/UnitTests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
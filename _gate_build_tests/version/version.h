@@ -0,0 +1,22 @@
+#define STR_HELPER(x) #x
+#define STR(x) STR_HELPER(x)
+
+#define PROJECT_NAME "Karbo"
+#define PROJECT_SITE "https://www.karbo.org"
+#define PROJECT_COPYRIGHT "Copyright 2016-2020, Karbo Developers"
+#define APP_VER_MAJOR 0
+#define APP_VER_MINOR 0
+#define APP_VER_REV   0
+#define APP_VER_BUILD 175
+#define BUILD_COMMIT_ID "768b072"
+/* #undef BUILD_REMARK */
+#define PROJECT_VERSION STR(APP_VER_MAJOR) "." STR(APP_VER_MINOR) "." STR(APP_VER_REV)
+#define PROJECT_VERSION_BUILD_NO STR(APP_VER_BUILD)
+
+#ifdef BUILD_REMARK
+#define PROJECT_VERSION_LONG PROJECT_VERSION "." PROJECT_VERSION_BUILD_NO "-" BUILD_COMMIT_ID "-" BUILD_REMARK
+#else
+#define PROJECT_VERSION_LONG PROJECT_VERSION "." PROJECT_VERSION_BUILD_NO "-" BUILD_COMMIT_ID
+#endif
+
+#define PROJECT_DESCRIPTION PROJECT_NAME " v. " PROJECT_VERSION_LONG
@@ -20,6 +20,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <system_error>
 #include <vector>
 #include <boost/lexical_cast.hpp>
@@ -58,6 +59,7 @@ struct OutsForAmount {
 struct TransactionShortInfo {
   Crypto::Hash txId;
   TransactionPrefix txPrefix;
+  std::vector<uint32_t> globalIndexes; // of the outputs, empty if the node did not send them
 };
 
 struct BlockShortEntry {
@@ -65,6 +67,12 @@ struct BlockShortEntry {
   bool hasBlock;
   CryptoNote::Block block;
   std::vector<TransactionShortInfo> txsShortInfo;
+  std::vector<uint32_t> baseTransactionGlobalIndexes;
+};
+
+struct BlockFilterEntry {
+  Crypto::Hash blockHash;
+  std::string filter;
 };
 
 struct BlockHeaderInfo {
@@ -166,7 +174,11 @@ public:
   virtual void getRandomOutsByAmounts(std::vector<uint64_t>&& amounts, uint64_t outsCount, std::vector<CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount>& result, const Callback& callback) = 0;
   virtual void getNewBlocks(std::vector<Crypto::Hash>&& knownBlockIds, std::vector<CryptoNote::block_complete_entry>& newBlocks, uint32_t& startHeight, const Callback& callback) = 0;
   virtual void getTransactionOutsGlobalIndices(const Crypto::Hash& transactionHash, std::vector<uint32_t>& outsGlobalIndices, const Callback& callback) = 0;
+  // global output indices of several transactions in one request, by default they are asked for one transaction at a time
+  virtual void getTransactionsOutsGlobalIndices(const std::vector<Crypto::Hash>& transactionHashes, std::vector<std::vector<uint32_t>>& outsGlobalIndices, const Callback& callback);
   virtual void queryBlocks(std::vector<Crypto::Hash>&& knownBlockIds, uint64_t timestamp, std::vector<BlockShortEntry>& newBlocks, uint32_t& startHeight, const Callback& callback) = 0;
+  // compact filters (see CryptoNoteCore/BlockFilter.h) of the blocks from the last known one
+  virtual void getBlockFilters(std::vector<Crypto::Hash>&& knownBlockIds, std::vector<BlockFilterEntry>& filters, uint32_t& startHeight, const Callback& callback) = 0;
   virtual void getPoolSymmetricDifference(std::vector<Crypto::Hash>&& knownPoolTxIds, Crypto::Hash knownBlockId, bool& isBcActual, std::vector<std::unique_ptr<ITransactionReader>>& newTxs, std::vector<Crypto::Hash>& deletedTxIds, const Callback& callback) = 0;
   virtual void getMultisignatureOutputByGlobalIndex(uint64_t amount, uint32_t gindex, MultisignatureOutput& out, const Callback& callback) = 0;
   virtual void getBlocks(const std::vector<uint32_t>& blockHeights, std::vector<std::vector<BlockDetails>>& blocks, const Callback& callback) = 0;
@@ -178,8 +190,39 @@ public:
   virtual void getTransactionsByPaymentId(const Crypto::Hash& paymentId, std::vector<TransactionDetails>& transactions, const Callback& callback) = 0;
   virtual void getPoolTransactions(uint64_t timestampBegin, uint64_t timestampEnd, uint32_t transactionsNumberLimit, std::vector<TransactionDetails>& transactions, uint64_t& transactionsNumberWithinTimestamps, const Callback& callback) = 0;
   virtual void getBlockTimestamp(uint32_t height, uint64_t& timestamp, const Callback& callback) = 0;
+  // for each timestamp, the height to scan from not to miss any block made at that time or later
+  virtual void getBlockHeightsByTimestamps(const std::vector<uint64_t>& timestamps, std::vector<uint32_t>& heights, const Callback& callback) = 0;
   virtual void isSynchronized(bool& syncStatus, const Callback& callback) = 0;
   virtual void getConnections(std::vector<p2pConnection>& connections, const Callback& callback) = 0;
+
+private:
+  void requestOutsGlobalIndices(std::shared_ptr<std::vector<Crypto::Hash>> transactionHashes, size_t index,
+    std::vector<std::vector<uint32_t>>& outsGlobalIndices, const Callback& callback);
 };
 
+inline void INode::getTransactionsOutsGlobalIndices(const std::vector<Crypto::Hash>& transactionHashes,
+  std::vector<std::vector<uint32_t>>& outsGlobalIndices, const Callback& callback) {
+  outsGlobalIndices.clear();
+  outsGlobalIndices.resize(transactionHashes.size());
+  requestOutsGlobalIndices(std::make_shared<std::vector<Crypto::Hash>>(transactionHashes), 0, outsGlobalIndices, callback);
+}
+
+inline void INode::requestOutsGlobalIndices(std::shared_ptr<std::vector<Crypto::Hash>> transactionHashes, size_t index,
+  std::vector<std::vector<uint32_t>>& outsGlobalIndices, const Callback& callback) {
+  if (index == transactionHashes->size()) {
+    callback(std::error_code());
+    return;
+  }
+
+  Callback next = [this, transactionHashes, index, &outsGlobalIndices, callback](std::error_code ec) {
+    if (ec) {
+      callback(ec);
+    } else {
+      requestOutsGlobalIndices(transactionHashes, index + 1, outsGlobalIndices, callback);
+    }
+  };
+
+  getTransactionOutsGlobalIndices((*transactionHashes)[index], outsGlobalIndices[index], next);
+}
+
 }
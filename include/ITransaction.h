@@ -49,6 +49,12 @@ namespace TransactionTypes {
     GlobalOutputsContainer outputs;
     OutputKeyInfo realOutput;
   };
+
+  struct KeyInputSource {
+    AccountKeys senderKeys;
+    const InputKeyInfo* info;
+    KeyPair* ephKeys;
+  };
 }
 
 //
@@ -120,6 +126,8 @@ public:
   virtual size_t addInput(const KeyInput& input) = 0;
   virtual size_t addInput(const MultisignatureInput& input) = 0;
   virtual size_t addInput(const AccountKeys& senderKeys, const TransactionTypes::InputKeyInfo& info, KeyPair& ephKeys) = 0;
+  // same for several inputs, their key images are derived in parallel; returns the index of the first one
+  virtual size_t addInputs(const std::vector<TransactionTypes::KeyInputSource>& inputs) = 0;
 
   virtual size_t addOutput(uint64_t amount, const AccountPublicAddress& to) = 0;
   virtual size_t addOutput(uint64_t amount, const std::vector<AccountPublicAddress>& to, uint32_t requiredSignatures) = 0;
@@ -131,6 +139,8 @@ public:
 
   // signing
   virtual void signInputKey(size_t input, const TransactionTypes::InputKeyInfo& info, const KeyPair& ephKeys) = 0;
+  // signs the key inputs starting from firstInput in parallel, senderKeys are not used
+  virtual void signInputKeys(size_t firstInput, const std::vector<TransactionTypes::KeyInputSource>& inputs) = 0;
   virtual void signInputMultisignature(size_t input, const Crypto::PublicKey& sourceTransactionKey, size_t outputIndex, const AccountKeys& accountKeys) = 0;
   virtual void signInputMultisignature(size_t input, const KeyPair& ephemeralKeys) = 0;
 };
@@ -97,6 +97,8 @@ public:
   virtual size_t transactionsCount() const = 0;
   virtual uint64_t balance(uint32_t flags = IncludeDefault) const = 0;
   virtual void getOutputs(std::vector<TransactionOutputInformation>& transfers, uint32_t flags = IncludeDefault) const = 0;
+  // confirmed outputs from the largest amount down, until their sum reaches the amount and there are at least minCount of them
+  virtual void getLargestOutputs(std::vector<TransactionOutputInformation>& transfers, uint32_t flags, uint64_t amount, size_t minCount) const = 0;
   virtual bool getTransactionInformation(const Crypto::Hash& transactionHash, TransactionInformation& info,
     uint64_t* amountIn = nullptr, uint64_t* amountOut = nullptr) const = 0;
   virtual std::vector<TransactionOutputInformation> getTransactionOutputs(const Crypto::Hash& transactionHash, uint32_t flags = IncludeDefault) const = 0;
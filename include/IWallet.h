@@ -20,6 +20,7 @@
 
 #include <limits>
 #include <string>
+#include <system_error>
 #include <vector>
 #include <boost/optional.hpp>
 #include "CryptoNote.h"
@@ -45,6 +46,7 @@ enum WalletEventType {
   BALANCE_UNLOCKED,
   SYNC_PROGRESS_UPDATED,
   SYNC_COMPLETED,
+  EVENTS_DROPPED, // the event queue overflowed, the events before this one are lost and the state has to be read again
 };
 
 enum class WalletSaveLevel : uint8_t {
@@ -183,6 +185,11 @@ public:
   virtual WalletTransactionWithTransfers getTransaction(const Crypto::Hash& transactionHash) const = 0;
   virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t count) const = 0;
   virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count) const = 0;
+  // only transactions with a transfer of one of the addresses (any if empty) and with the payment id (any if null)
+  virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t count,
+    const std::vector<std::string>& addresses, const Crypto::Hash* paymentId) const = 0;
+  virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count,
+    const std::vector<std::string>& addresses, const Crypto::Hash* paymentId) const = 0;
   virtual std::vector<Crypto::Hash> getBlockHashes(uint32_t blockIndex, size_t count) const = 0;
   virtual uint32_t getBlockCount() const  = 0;
   virtual std::vector<WalletTransactionWithTransfers> getUnconfirmedTransactions() const = 0;
@@ -198,6 +205,8 @@ public:
 
   virtual size_t makeTransaction(const TransactionParameters& sendingTransaction) = 0;
   virtual void commitTransaction(size_t transactionId) = 0;
+  // relays the transactions at once, the error of every one is returned in its position, empty if it was sent
+  virtual std::vector<std::error_code> commitTransactions(const std::vector<size_t>& transactionIds) = 0;
   virtual void rollbackUncommitedTransaction(size_t transactionId) = 0;
 
   virtual void start() = 0;
@@ -205,6 +214,8 @@ public:
 
   //blocks until an event occurred
   virtual WalletEvent getEvent() = 0;
+  //blocks until an event occurred, returns at most maxCount of the queued events
+  virtual std::vector<WalletEvent> getEvents(size_t maxCount) = 0;
 };
 
 }
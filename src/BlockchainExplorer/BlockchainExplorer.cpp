@@ -17,6 +17,7 @@
 
 #include "BlockchainExplorer.h"
 
+#include <algorithm>
 #include <future>
 #include <functional>
 #include <memory>
@@ -32,6 +33,9 @@ using namespace Crypto;
 
 namespace CryptoNote {
 
+// replacements of the main chain deeper than this are reported without the orphaned blocks
+const size_t KNOWN_BLOCKS_LIMIT = 100;
+
 class ContextCounterHolder
 {
 public:
@@ -183,6 +187,8 @@ void BlockchainExplorer::init() {
   }
   if (getBlockchainTop(knownBlockchainTop)) {
     knownBlockchainTopHeight = knownBlockchainTop.height;
+    std::unique_lock<std::mutex> lock(knownDetailsMutex);
+    knownBlocks[knownBlockchainTopHeight] = knownBlockchainTop;
   } else {
     logger(ERROR) << "Can't get blockchain top.";
     state.store(NOT_INITIALIZED);
@@ -198,6 +204,10 @@ void BlockchainExplorer::shutdown() {
   node.removeObserver(this);
   asyncContextCounter.waitAsyncContextsFinish();
   state.store(NOT_INITIALIZED);
+
+  std::unique_lock<std::mutex> lock(knownDetailsMutex);
+  knownBlocks.clear();
+  knownPoolTransactions.clear();
 }
 
 bool BlockchainExplorer::getBlocks(const std::vector<uint32_t>& blockHeights, std::vector<std::vector<BlockDetails>>& blocks) {
@@ -236,6 +246,10 @@ bool BlockchainExplorer::getBlocks(const std::vector<Hash>& blockHashes, std::ve
   }
 
   logger(DEBUGGING) << "Get blocks by hash request came.";
+  if (getKnownBlocks(blockHashes, blocks)) {
+    return true;
+  }
+
   NodeRequest request(
     std::bind(
       static_cast<
@@ -438,13 +452,41 @@ bool BlockchainExplorer::getPoolState(const std::vector<Hash>& knownPoolTransact
     throw std::system_error(ec);
   }
 
-  std::vector<Hash> newTransactionsHashes;
+  // only the transactions that came to the pool after the last poolChanged notification are built
+  std::vector<Hash> unknownTransactionsHashes;
+  {
+    std::unique_lock<std::mutex> lock(knownDetailsMutex);
+    for (const auto& rawTransaction : rawNewTransactions) {
+      Hash transactionHash = rawTransaction->getTransactionHash();
+      if (knownPoolTransactions.count(transactionHash) == 0) {
+        unknownTransactionsHashes.push_back(std::move(transactionHash));
+      }
+    }
+  }
+
+  std::vector<TransactionDetails> unknownTransactions;
+  if (!unknownTransactionsHashes.empty() && !getTransactions(unknownTransactionsHashes, unknownTransactions)) {
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock(knownDetailsMutex);
   for (const auto& rawTransaction : rawNewTransactions) {
     Hash transactionHash = rawTransaction->getTransactionHash();
-    newTransactionsHashes.push_back(std::move(transactionHash));
+    auto it = knownPoolTransactions.find(transactionHash);
+    if (it != knownPoolTransactions.end()) {
+      newTransactions.push_back(it->second);
+      continue;
+    }
+
+    auto unknownTransaction = std::find_if(unknownTransactions.begin(), unknownTransactions.end(), [&transactionHash](const TransactionDetails& transaction) {
+      return transaction.hash == transactionHash;
+    });
+    if (unknownTransaction != unknownTransactions.end()) {
+      newTransactions.push_back(std::move(*unknownTransaction));
+    }
   }
 
-  return getTransactions(newTransactionsHashes, newTransactions);
+  return true;
 }
 
 uint64_t BlockchainExplorer::getRewardBlocksWindow() {
@@ -561,6 +603,13 @@ void BlockchainExplorer::poolChanged() {
         }
       }
 
+      {
+        std::unique_lock<std::mutex> lock(knownDetailsMutex);
+        for (const Hash& hash : *removedTransactionsPtr) {
+          knownPoolTransactions.erase(hash);
+        }
+      }
+
       std::shared_ptr<std::vector<TransactionDetails>> newTransactionsPtr = std::make_shared<std::vector<TransactionDetails>>();
       NodeRequest request(
         std::bind(
@@ -587,6 +636,13 @@ void BlockchainExplorer::poolChanged() {
             return;
           }
 
+          {
+            std::unique_lock<std::mutex> lock(knownDetailsMutex);
+            for (const TransactionDetails& transaction : *newTransactionsPtr) {
+              knownPoolTransactions[transaction.hash] = transaction;
+            }
+          }
+
           if (!newTransactionsPtr->empty() || !removedTransactionsHashesPtr->empty()) {
             observerManager.notify(&IBlockchainObserver::poolUpdated, *newTransactionsPtr, *removedTransactionsHashesPtr);
             logger(DEBUGGING) << "poolUpdated notification was successfully sent.";
@@ -671,6 +727,8 @@ void BlockchainExplorer::localBlockchainUpdated(uint32_t height) {
 
   if (observersCounter.load() == 0) {
     knownBlockchainTopHeight = height;
+    std::unique_lock<std::mutex> lock(knownDetailsMutex);
+    knownBlocks.clear();
     return;
   }
 
@@ -678,10 +736,20 @@ void BlockchainExplorer::localBlockchainUpdated(uint32_t height) {
 
   assert(height >= knownBlockchainTopHeight);
 
+  // Only the heights above the known blocks are built, when there are none the top
+  // is fetched again to see whether it was replaced
+  uint32_t firstHeight = knownBlockchainTopHeight;
+  {
+    std::unique_lock<std::mutex> knownDetailsLock(knownDetailsMutex);
+    if (!knownBlocks.empty()) {
+      firstHeight = std::min(knownBlocks.rbegin()->first + 1, height);
+    }
+  }
+
   std::shared_ptr<std::vector<uint32_t>> blockHeightsPtr = std::make_shared<std::vector<uint32_t>>();
   std::shared_ptr<std::vector<std::vector<BlockDetails>>> blocksPtr = std::make_shared<std::vector<std::vector<BlockDetails>>>();
 
-  for (uint32_t i = knownBlockchainTopHeight; i <= height; ++i) {
+  for (uint32_t i = firstHeight; i <= height; ++i) {
     blockHeightsPtr->push_back(i);
   }
 
@@ -716,25 +784,15 @@ void BlockchainExplorer::localBlockchainUpdated(uint32_t height) {
       BlockDetails topMainchainBlock;
       bool gotTopMainchainBlock = false;
       uint64_t topHeight = 0;
-
-      std::vector<BlockDetails> newBlocks;
-      std::vector<BlockDetails> orphanedBlocks;
       for (const std::vector<BlockDetails>& sameHeightBlocks : *blocksPtr) {
         for (const BlockDetails& block : sameHeightBlocks) {
           if (topHeight < block.height) {
             topHeight = block.height;
             gotTopMainchainBlock = false;
           }
-          if (block.isOrphaned) {
-            orphanedBlocks.push_back(block);
-          } else {
-            if (block.height > knownBlockchainTop.height || block.hash != knownBlockchainTop.hash) {
-              newBlocks.push_back(block);
-            }
-            if (!gotTopMainchainBlock) {
-              topMainchainBlock = block;
-              gotTopMainchainBlock = true;
-            }
+          if (!block.isOrphaned && !gotTopMainchainBlock) {
+            topMainchainBlock = block;
+            gotTopMainchainBlock = true;
           }
         }
       }
@@ -744,12 +802,137 @@ void BlockchainExplorer::localBlockchainUpdated(uint32_t height) {
         return;
       }
 
+      std::shared_ptr<std::vector<BlockDetails>> newBlocksPtr = std::make_shared<std::vector<BlockDetails>>();
+      std::shared_ptr<std::vector<BlockDetails>> orphanedBlocksPtr = std::make_shared<std::vector<BlockDetails>>();
+      bool continuesKnownBlocks = updateKnownBlocks(*blocksPtr, *newBlocksPtr, *orphanedBlocksPtr);
       knownBlockchainTop = topMainchainBlock;
+      if (continuesKnownBlocks) {
+        observerManager.notify(&IBlockchainObserver::blockchainUpdated, *newBlocksPtr, *orphanedBlocksPtr);
+        logger(DEBUGGING) << "localBlockchainUpdated notification was successfully sent.";
+        return;
+      }
+
+      // the new blocks don't continue the known ones, the known heights are fetched
+      // again to find the replaced blocks
+      std::shared_ptr<std::vector<uint32_t>> knownHeightsPtr = std::make_shared<std::vector<uint32_t>>();
+      std::shared_ptr<std::vector<std::vector<BlockDetails>>> knownHeightsBlocksPtr = std::make_shared<std::vector<std::vector<BlockDetails>>>();
+      {
+        std::unique_lock<std::mutex> knownDetailsLock(knownDetailsMutex);
+        for (const auto& knownBlock : knownBlocks) {
+          if (knownBlock.first >= blockHeightsPtr->front()) {
+            break;
+          }
 
-      observerManager.notify(&IBlockchainObserver::blockchainUpdated, newBlocks, orphanedBlocks);
-      logger(DEBUGGING) << "localBlockchainUpdated notification was successfully sent.";
+          knownHeightsPtr->push_back(knownBlock.first);
+        }
+      }
+
+      NodeRequest request(
+        std::bind(
+          static_cast<
+            void(INode::*)(
+            const std::vector<uint32_t>&,
+              std::vector<std::vector<BlockDetails>>&, 
+              const INode::Callback&
+            )
+          >(&INode::getBlocks), 
+          std::ref(node), 
+          std::cref(*knownHeightsPtr), 
+          std::ref(*knownHeightsBlocksPtr),
+          std::placeholders::_1
+        )
+      );
+
+      request.performAsync(asyncContextCounter,
+        [this, knownHeightsPtr, knownHeightsBlocksPtr, newBlocksPtr, orphanedBlocksPtr](std::error_code ec) {
+          if (ec) {
+            logger(ERROR) << "Can't send blockchainUpdated notification because can't get blocks by height: " << ec.message();
+            return;
+          }
+
+          std::unique_lock<std::mutex> lock(mutex);
+
+          std::vector<BlockDetails> newBlocks;
+          std::vector<BlockDetails> orphanedBlocks;
+          updateKnownBlocks(*knownHeightsBlocksPtr, newBlocks, orphanedBlocks);
+          newBlocks.insert(newBlocks.end(), newBlocksPtr->begin(), newBlocksPtr->end());
+          orphanedBlocks.insert(orphanedBlocks.end(), orphanedBlocksPtr->begin(), orphanedBlocksPtr->end());
+
+          observerManager.notify(&IBlockchainObserver::blockchainUpdated, newBlocks, orphanedBlocks);
+          logger(DEBUGGING) << "localBlockchainUpdated notification was successfully sent.";
+        }
+      );
     }
   );
 }
 
+bool BlockchainExplorer::getKnownBlocks(const std::vector<Hash>& blockHashes, std::vector<BlockDetails>& blocks) {
+  uint32_t lastHeight = node.getLastLocalBlockHeight();
+  std::vector<BlockDetails> knownBlocksFound;
+
+  std::unique_lock<std::mutex> lock(knownDetailsMutex);
+  for (const Hash& hash : blockHashes) {
+    auto it = std::find_if(knownBlocks.begin(), knownBlocks.end(), [&hash](const std::pair<const uint32_t, BlockDetails>& block) {
+      return block.second.hash == hash;
+    });
+
+    if (it == knownBlocks.end() || it->first > lastHeight) {
+      return false;
+    }
+
+    knownBlocksFound.push_back(it->second);
+    knownBlocksFound.back().depth = lastHeight - it->first;
+  }
+
+  blocks.insert(blocks.end(), knownBlocksFound.begin(), knownBlocksFound.end());
+  return true;
+}
+
+// Merges the main chain blocks of the given heights into the known blocks. The blocks that
+// are neither known nor the known top are new, the known ones they replace are orphaned.
+// Returns false when the lowest block doesn't continue the known block below it.
+bool BlockchainExplorer::updateKnownBlocks(const std::vector<std::vector<BlockDetails>>& blocks, std::vector<BlockDetails>& newBlocks, std::vector<BlockDetails>& orphanedBlocks) {
+  std::unique_lock<std::mutex> lock(knownDetailsMutex);
+
+  bool continues = true;
+  bool gotLowestBlock = false;
+  for (const std::vector<BlockDetails>& sameHeightBlocks : blocks) {
+    for (const BlockDetails& block : sameHeightBlocks) {
+      if (block.isOrphaned) {
+        orphanedBlocks.push_back(block);
+        continue;
+      }
+
+      if (!gotLowestBlock && block.height > 0) {
+        auto below = knownBlocks.find(block.height - 1);
+        continues = below == knownBlocks.end() || below->second.hash == block.prevBlockHash;
+      }
+      gotLowestBlock = true;
+
+      auto known = knownBlocks.find(block.height);
+      if (known != knownBlocks.end()) {
+        if (known->second.hash == block.hash) {
+          continue;
+        }
+
+        orphanedBlocks.push_back(known->second);
+        orphanedBlocks.back().isOrphaned = true;
+        known->second = block;
+        newBlocks.push_back(block);
+      } else {
+        knownBlocks.emplace(block.height, block);
+        if (block.height != knownBlockchainTop.height || block.hash != knownBlockchainTop.hash) {
+          newBlocks.push_back(block);
+        }
+      }
+    }
+  }
+
+  while (knownBlocks.size() > KNOWN_BLOCKS_LIMIT) {
+    knownBlocks.erase(knownBlocks.begin());
+  }
+
+  return continues;
+}
+
 }
@@ -20,6 +20,8 @@
 
 #include <mutex>
 #include <atomic>
+#include <map>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "IBlockchainExplorer.h"
@@ -76,6 +78,8 @@ public:
 
 private:
   void poolUpdateEndHandler();
+  bool getKnownBlocks(const std::vector<Crypto::Hash>& blockHashes, std::vector<BlockDetails>& blocks);
+  bool updateKnownBlocks(const std::vector<std::vector<BlockDetails>>& blocks, std::vector<BlockDetails>& newBlocks, std::vector<BlockDetails>& orphanedBlocks);
 
   class PoolUpdateGuard {
   public:
@@ -103,12 +107,18 @@ private:
   uint32_t knownBlockchainTopHeight;
   std::unordered_set<Crypto::Hash> knownPoolState;
 
+  // details already built by the node: the main chain blocks of the last updates,
+  // to tell a continued chain from a replaced one, and the pool transactions
+  std::map<uint32_t, BlockDetails> knownBlocks;
+  std::unordered_map<Crypto::Hash, TransactionDetails> knownPoolTransactions;
+
   std::atomic<State> state;
   std::atomic<bool> synchronized;
   std::atomic<uint32_t> observersCounter;
   Tools::ObserverManager<IBlockchainObserver> observerManager;
 
   std::mutex mutex;
+  std::mutex knownDetailsMutex;
 
   INode& node;
   Logging::LoggerRef logger;
@@ -22,6 +22,7 @@
 #include <boost/range/combine.hpp>
 
 #include "Common/StringTools.h"
+#include "CryptoNoteCore/BlockchainIndices.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "CryptoNoteCore/TransactionExtra.h"
@@ -49,13 +50,9 @@ bool BlockchainExplorerDataBuilder::getMixin(const Transaction& transaction, uin
 }
 
 bool BlockchainExplorerDataBuilder::getPaymentId(const Transaction& transaction, Crypto::Hash& paymentId) {
-  std::vector<TransactionExtraField> txExtraFields;
-  parseTransactionExtra(transaction.extra, txExtraFields);
-  TransactionExtraNonce extraNonce;
-  if (!findTransactionExtraFieldByType(txExtraFields, extraNonce)) {
-    return false;
-  }
-  return getPaymentIdFromTransactionExtraNonce(extraNonce.nonce, paymentId);
+  TransactionExtraScan scan;
+  scanTransactionExtra(transaction.extra, scan);
+  return scan.getPaymentId(paymentId);
 }
 
 bool BlockchainExplorerDataBuilder::fillTxExtra(const std::vector<uint8_t>& rawExtra, TransactionExtraDetails2& extraDetails) {
@@ -114,10 +111,15 @@ bool BlockchainExplorerDataBuilder::fillBlockDetails(const Block &block, BlockDe
   Crypto::Hash tmpHash = m_core.getBlockIdByHeight(blockDetails.height);
   blockDetails.isOrphaned = hash != tmpHash;
 
+  // blocks of the main chain may have their sizes, rewards and proof of work precomputed
+  BlockSummary summary;
+  bool hasSummary = !blockDetails.isOrphaned && m_core.getBlockSummary(blockDetails.height, summary);
+
   blockDetails.proofOfWork = boost::value_initialized<Crypto::Hash>();
-  if (calculate_pow) {
-    Crypto::cn_context context;
-    if (!get_block_longhash(context, block, blockDetails.proofOfWork)) {
+  if (hasSummary && summary.proofOfWork != NULL_HASH) {
+    blockDetails.proofOfWork = summary.proofOfWork;
+  } else if (calculate_pow) {
+    if (!m_core.getBlockLongHash(block, blockDetails.proofOfWork)) {
       return false;
     }
   }
@@ -130,25 +132,12 @@ bool BlockchainExplorerDataBuilder::fillBlockDetails(const Block &block, BlockDe
     return false;
   }
 
-  std::vector<size_t> blocksSizes;
-  if (!m_core.getBackwardBlocksSizes(blockDetails.height, blocksSizes, parameters::CRYPTONOTE_REWARD_BLOCKS_WINDOW)) {
-    return false;
-  }
-  blockDetails.sizeMedian = median(blocksSizes);
-
-  size_t blockGrantedFullRewardZone = CryptoNote::parameters::CRYPTONOTE_BLOCK_GRANTED_FULL_REWARD_ZONE;
-  blockDetails.effectiveSizeMedian = std::max(blockDetails.sizeMedian, (uint64_t) blockGrantedFullRewardZone);
-
   size_t blockSize = 0;
   if (!m_core.getBlockSize(hash, blockSize)) {
     return false;
   }
   blockDetails.transactionsCumulativeSize = blockSize;
 
-  size_t blokBlobSize = getObjectBinarySize(block);
-  size_t minerTxBlobSize = getObjectBinarySize(block.baseTransaction);
-  blockDetails.blockSize = blokBlobSize + blockDetails.transactionsCumulativeSize - minerTxBlobSize;
-
   if (!m_core.getAlreadyGeneratedCoins(hash, blockDetails.alreadyGeneratedCoins)) {
     return false;
   }
@@ -157,32 +146,52 @@ bool BlockchainExplorerDataBuilder::fillBlockDetails(const Block &block, BlockDe
     return false;
   }
 
-  uint64_t prevBlockGeneratedCoins = 0;
-  if (blockDetails.height > 0) {
-    if (!m_core.getAlreadyGeneratedCoins(block.previousBlockHash, prevBlockGeneratedCoins)) {
+  size_t blockGrantedFullRewardZone = CryptoNote::parameters::CRYPTONOTE_BLOCK_GRANTED_FULL_REWARD_ZONE;
+  if (hasSummary) {
+    blockDetails.sizeMedian = summary.sizeMedian;
+    blockDetails.effectiveSizeMedian = std::max(blockDetails.sizeMedian, (uint64_t) blockGrantedFullRewardZone);
+    blockDetails.blockSize = summary.blockSize;
+    blockDetails.baseReward = summary.baseReward;
+    blockDetails.penalty = summary.penalty;
+  } else {
+    std::vector<size_t> blocksSizes;
+    if (!m_core.getBackwardBlocksSizes(blockDetails.height, blocksSizes, parameters::CRYPTONOTE_REWARD_BLOCKS_WINDOW)) {
       return false;
     }
-  }
+    blockDetails.sizeMedian = median(blocksSizes);
+    blockDetails.effectiveSizeMedian = std::max(blockDetails.sizeMedian, (uint64_t) blockGrantedFullRewardZone);
 
-  uint64_t maxReward = 0;
-  uint64_t currentReward = 0;
-  int64_t emissionChange = 0;
-  if (!m_core.getBlockReward(block.majorVersion, blockDetails.sizeMedian, 0, prevBlockGeneratedCoins, 0, maxReward, emissionChange)) {
-    return false;
-  }
+    size_t blokBlobSize = getObjectBinarySize(block);
+    size_t minerTxBlobSize = getObjectBinarySize(block.baseTransaction);
+    blockDetails.blockSize = blokBlobSize + blockDetails.transactionsCumulativeSize - minerTxBlobSize;
 
-  if (!m_core.getBlockReward(block.majorVersion, blockDetails.sizeMedian, blockDetails.transactionsCumulativeSize, prevBlockGeneratedCoins, 0, currentReward, emissionChange)) {
-    return false;
-  }
+    uint64_t prevBlockGeneratedCoins = 0;
+    if (blockDetails.height > 0) {
+      if (!m_core.getAlreadyGeneratedCoins(block.previousBlockHash, prevBlockGeneratedCoins)) {
+        return false;
+      }
+    }
 
-  blockDetails.baseReward = maxReward;
-  if (maxReward == 0 && currentReward == 0) {
-    blockDetails.penalty = static_cast<double>(0);
-  } else {
-    if (maxReward < currentReward) {
+    uint64_t maxReward = 0;
+    uint64_t currentReward = 0;
+    int64_t emissionChange = 0;
+    if (!m_core.getBlockReward(block.majorVersion, blockDetails.sizeMedian, 0, prevBlockGeneratedCoins, 0, maxReward, emissionChange)) {
+      return false;
+    }
+
+    if (!m_core.getBlockReward(block.majorVersion, blockDetails.sizeMedian, blockDetails.transactionsCumulativeSize, prevBlockGeneratedCoins, 0, currentReward, emissionChange)) {
       return false;
     }
-    blockDetails.penalty = static_cast<double>(maxReward - currentReward) / static_cast<double>(maxReward);
+
+    blockDetails.baseReward = maxReward;
+    if (maxReward == 0 && currentReward == 0) {
+      blockDetails.penalty = static_cast<double>(0);
+    } else {
+      if (maxReward < currentReward) {
+        return false;
+      }
+      blockDetails.penalty = static_cast<double>(maxReward - currentReward) / static_cast<double>(maxReward);
+    }
   }
 
 
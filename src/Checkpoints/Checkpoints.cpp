@@ -17,8 +17,12 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <chrono>
+#include <condition_variable>
 #include <cstdlib>
 #include <fstream>
+#include <mutex>
+#include <thread>
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
@@ -37,8 +41,25 @@
 using namespace Logging;
 
 namespace CryptoNote {
+
+#ifndef __ANDROID__
+struct Checkpoints::DnsRecords {
+  std::mutex mutex;
+  std::condition_variable fetched;
+  bool fetching = false;
+  bool failed = false;
+  uint64_t generation = 0; // incremented by every completed fetch
+  std::chrono::steady_clock::time_point fetchTime;
+  std::vector<std::string> records;
+};
+#endif
+
 //---------------------------------------------------------------------------
+#ifndef __ANDROID__
+Checkpoints::Checkpoints(Logging::ILogger &log) : logger(log, "checkpoints"), m_dns(std::make_shared<DnsRecords>()), m_dnsMergedGeneration(0) {}
+#else
 Checkpoints::Checkpoints(Logging::ILogger &log) : logger(log, "checkpoints") {}
+#endif
 //---------------------------------------------------------------------------
 bool Checkpoints::add_checkpoint(uint32_t height, const std::string &hash_str) {
   Crypto::Hash h = NULL_HASH;
@@ -147,13 +168,76 @@ std::vector<uint32_t> Checkpoints::getCheckpointHeights() const {
 //---------------------------------------------------------------------------
 bool Checkpoints::load_checkpoints_from_dns()
 {
-  std::string domain(CryptoNote::DNS_CHECKPOINTS_HOST);
-  std::vector<std::string>records;
+  start_dns_fetch();
+
+  {
+    std::unique_lock<std::mutex> lock(m_dns->mutex);
+    if (!m_dns->fetched.wait_for(lock, std::chrono::seconds(CryptoNote::DNS_CHECKPOINTS_TIMEOUT), [this] { return !m_dns->fetching; })) {
+      logger(Logging::INFO) << "DNS checkpoint records from " << CryptoNote::DNS_CHECKPOINTS_HOST << " timed out, they will be merged later";
+      return false;
+    }
+  }
+
+  merge_dns_records();
+  return true;
+}
+//---------------------------------------------------------------------------
+void Checkpoints::refresh_checkpoints_from_dns()
+{
+  merge_dns_records();
+  start_dns_fetch();
+}
+//---------------------------------------------------------------------------
+void Checkpoints::start_dns_fetch()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_dns->mutex);
+    if (m_dns->fetching || (m_dns->generation != 0 &&
+        std::chrono::steady_clock::now() - m_dns->fetchTime < std::chrono::seconds(CryptoNote::DNS_CHECKPOINTS_REFRESH_INTERVAL))) {
+      return;
+    }
+
+    m_dns->fetching = true;
+  }
+
+  logger(Logging::DEBUGGING) << "Fetching DNS checkpoint records from " << CryptoNote::DNS_CHECKPOINTS_HOST;
+
+  // the thread owns a reference to the records, it may outlive this object
+  std::shared_ptr<DnsRecords> dns = m_dns;
+  std::thread([dns] {
+    std::vector<std::string> records;
+    bool ok = Common::fetch_dns_txt(CryptoNote::DNS_CHECKPOINTS_HOST, records);
+
+    std::lock_guard<std::mutex> lock(dns->mutex);
+    if (ok) {
+      dns->records = std::move(records);
+    }
+
+    dns->failed = !ok;
+    dns->fetchTime = std::chrono::steady_clock::now();
+    ++dns->generation;
+    dns->fetching = false;
+    dns->fetched.notify_all();
+  }).detach();
+}
+//---------------------------------------------------------------------------
+void Checkpoints::merge_dns_records()
+{
+  std::vector<std::string> records;
+  bool failed;
+  {
+    std::lock_guard<std::mutex> lock(m_dns->mutex);
+    if (m_dns->generation == m_dnsMergedGeneration) {
+      return;
+    }
 
-  logger(Logging::DEBUGGING) << "Fetching DNS checkpoint records from " << domain;
+    m_dnsMergedGeneration = m_dns->generation;
+    records = m_dns->records;
+    failed = m_dns->failed;
+  }
 
-  if (!Common::fetch_dns_txt(domain, records)) {
-    logger(Logging::INFO) << "Failed to lookup DNS checkpoint records from " << domain;
+  if (failed) {
+    logger(Logging::INFO) << "Failed to lookup DNS checkpoint records from " << CryptoNote::DNS_CHECKPOINTS_HOST;
   }
 
   for (const auto& record : records) {
@@ -175,11 +259,9 @@ bool Checkpoints::load_checkpoints_from_dns()
       logger(DEBUGGING) << "Checkpoint already exists for height: " << height << ". Ignoring DNS checkpoint.";
     } else {
       add_checkpoint(height, hash_str);
-	  logger(DEBUGGING) << "Added DNS checkpoint: " << height_str << ":" << hash_str;
+      logger(DEBUGGING) << "Added DNS checkpoint: " << height_str << ":" << hash_str;
     }
   }
-
-  return true;
 }
 #endif
 }
@@ -19,6 +19,7 @@
 
 #pragma once
 #include <map>
+#include <memory>
 #include <CryptoNoteCore/CryptoNoteBasicImpl.h>
 #include <Logging/LoggerRef.h>
 
@@ -37,11 +38,27 @@ namespace CryptoNote
     bool is_alternative_block_allowed(uint32_t blockchain_height, uint32_t block_height) const;
     std::vector<uint32_t> getCheckpointHeights() const;
 #ifndef __ANDROID__
-	bool load_checkpoints_from_dns();
+    // waits for the records up to DNS_CHECKPOINTS_TIMEOUT seconds
+    bool load_checkpoints_from_dns();
+    // merges the records fetched so far and starts a background fetch
+    // when they are older than DNS_CHECKPOINTS_REFRESH_INTERVAL, never waits
+    void refresh_checkpoints_from_dns();
 #endif
 
   private:
+#ifndef __ANDROID__
+    struct DnsRecords;
+
+    void start_dns_fetch();
+    void merge_dns_records();
+#endif
+
     std::map<uint32_t, Crypto::Hash> m_points;
     Logging::LoggerRef logger;
+#ifndef __ANDROID__
+    // shared with the fetching thread and with copies of this object
+    std::shared_ptr<DnsRecords> m_dns;
+    uint64_t m_dnsMergedGeneration;
+#endif
   };
 }
@@ -0,0 +1,167 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AllocationProfiler.h"
+
+#ifdef ALLOCATION_PROFILING
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "Metrics.h"
+
+namespace Common {
+
+namespace {
+
+const size_t SUBSYSTEM_COUNT = static_cast<size_t>(AllocationSubsystem::Count);
+const uint32_t FLUSH_INTERVAL = 256; // allocations counted by a thread before they are added up
+
+const char* const SUBSYSTEM_NAMES[SUBSYSTEM_COUNT] = { "other", "blockchain", "rpc", "p2p", "transfers" };
+
+std::atomic<uint64_t> totalAllocations[SUBSYSTEM_COUNT];
+std::atomic<uint64_t> totalBytes[SUBSYSTEM_COUNT];
+
+// Plain thread locals without constructors, so operator new can use them from any thread at
+// any time. The counts of a thread reach the totals when it has done a few allocations and
+// when a scope ends, what is left at the thread's exit is lost.
+struct ThreadCounters {
+  uint64_t allocations[SUBSYSTEM_COUNT];
+  uint64_t bytes[SUBSYSTEM_COUNT];
+  uint32_t pending;
+};
+
+thread_local ThreadCounters threadCounters;
+thread_local AllocationSubsystem currentSubsystem = AllocationSubsystem::Other;
+
+void flushThreadCounters() {
+  for (size_t i = 0; i < SUBSYSTEM_COUNT; ++i) {
+    if (threadCounters.allocations[i] != 0) {
+      totalAllocations[i].fetch_add(threadCounters.allocations[i], std::memory_order_relaxed);
+      totalBytes[i].fetch_add(threadCounters.bytes[i], std::memory_order_relaxed);
+      threadCounters.allocations[i] = 0;
+      threadCounters.bytes[i] = 0;
+    }
+  }
+
+  threadCounters.pending = 0;
+}
+
+void countAllocation(size_t size) {
+  size_t subsystem = static_cast<size_t>(currentSubsystem);
+  ++threadCounters.allocations[subsystem];
+  threadCounters.bytes[subsystem] += size;
+  if (++threadCounters.pending == FLUSH_INTERVAL) {
+    flushThreadCounters();
+  }
+}
+
+void* allocate(size_t size) {
+  countAllocation(size);
+  for (;;) {
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if (pointer != nullptr) {
+      return pointer;
+    }
+
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+
+    handler();
+  }
+}
+
+void* allocateNoThrow(size_t size) noexcept {
+  try {
+    return allocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+}
+
+AllocationScope::AllocationScope(AllocationSubsystem subsystem) : m_previous(currentSubsystem) {
+  currentSubsystem = subsystem;
+}
+
+AllocationScope::~AllocationScope() {
+  currentSubsystem = m_previous;
+  flushThreadCounters();
+}
+
+void writeAllocationMetrics(std::ostream& out) {
+  flushThreadCounters();
+
+  writeMetricHeader(out, "karbo_allocations_total", "counter", "Memory allocations by the subsystem of the allocating thread.");
+  for (size_t i = 0; i < SUBSYSTEM_COUNT; ++i) {
+    out << "karbo_allocations_total{subsystem=\"" << SUBSYSTEM_NAMES[i] << "\"} " << totalAllocations[i].load(std::memory_order_relaxed) << '\n';
+  }
+
+  writeMetricHeader(out, "karbo_allocated_bytes_total", "counter", "Bytes allocated by the subsystem of the allocating thread.");
+  for (size_t i = 0; i < SUBSYSTEM_COUNT; ++i) {
+    out << "karbo_allocated_bytes_total{subsystem=\"" << SUBSYSTEM_NAMES[i] << "\"} " << totalBytes[i].load(std::memory_order_relaxed) << '\n';
+  }
+}
+
+}
+
+void* operator new(size_t size) {
+  return Common::allocate(size);
+}
+
+void* operator new[](size_t size) {
+  return Common::allocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return Common::allocateNoThrow(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return Common::allocateNoThrow(size);
+}
+
+void operator delete(void* pointer) noexcept {
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+  std::free(pointer);
+}
+
+#else
+
+namespace Common {
+
+void writeAllocationMetrics(std::ostream&) {
+}
+
+}
+
+#endif
@@ -0,0 +1,57 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+namespace Common {
+
+enum class AllocationSubsystem : uint8_t {
+  Other,
+  Blockchain,
+  Rpc,
+  P2p,
+  Transfers,
+  Count
+};
+
+// With the ALLOCATION_PROFILING build option the global operator new counts the allocations
+// and their bytes per subsystem of the calling thread, set by the innermost AllocationScope.
+// Otherwise the scopes compile to nothing and no metrics are written.
+// A scope that suspends a dispatcher context also takes what the other contexts allocate
+// on the thread meanwhile, so the scopes are kept around code which doesn't wait.
+class AllocationScope {
+public:
+#ifdef ALLOCATION_PROFILING
+  explicit AllocationScope(AllocationSubsystem subsystem);
+  ~AllocationScope();
+
+private:
+  AllocationSubsystem m_previous;
+#else
+  explicit AllocationScope(AllocationSubsystem) {}
+#endif
+
+  AllocationScope(const AllocationScope&) = delete;
+  AllocationScope& operator=(const AllocationScope&) = delete;
+};
+
+// allocations and bytes per subsystem in Prometheus text format, nothing without profiling
+void writeAllocationMetrics(std::ostream& out);
+
+}
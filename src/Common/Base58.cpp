@@ -18,6 +18,7 @@
 #include "Base58.h"
 
 #include <assert.h>
+#include <string.h>
 #include <string>
 #include <vector>
 
@@ -233,25 +234,22 @@ namespace Tools
       return encode(buf);
     }
 
-    bool decode_addr(std::string addr, uint64_t& tag, std::string& data)
+    bool decode_addr(const std::string& addr, uint64_t& tag, std::string& data)
     {
       std::string addr_data;
       bool r = decode(addr, addr_data);
       if (!r) return false;
       if (addr_data.size() <= addr_checksum_size) return false;
 
-      std::string checksum(addr_checksum_size, '\0');
-      checksum = addr_data.substr(addr_data.size() - addr_checksum_size);
+      // the checksum is compared in place and the payload is copied once
+      size_t payload_size = addr_data.size() - addr_checksum_size;
+      Crypto::Hash hash = Crypto::cn_fast_hash(addr_data.data(), payload_size);
+      if (memcmp(&hash, addr_data.data() + payload_size, addr_checksum_size) != 0) return false;
 
-      addr_data.resize(addr_data.size() - addr_checksum_size);
-      Crypto::Hash hash = Crypto::cn_fast_hash(addr_data.data(), addr_data.size());
-      std::string expected_checksum(reinterpret_cast<const char*>(&hash), addr_checksum_size);
-      if (expected_checksum != checksum) return false;
-
-      int read = Tools::read_varint(addr_data.begin(), addr_data.end(), tag);
+      int read = Tools::read_varint(addr_data.begin(), addr_data.begin() + payload_size, tag);
       if (read <= 0) return false;
 
-      data = addr_data.substr(read);
+      data.assign(addr_data, read, payload_size - read);
       return true;
     }
   }
@@ -0,0 +1,248 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Common {
+
+// Cache of shared items bounded by the total of their sizes, e.g. bytes.
+// Keys are spread over shards with a mutex each, so concurrent lookups rarely
+// contend. A shard evicts with the CLOCK algorithm: a hit only sets the
+// reference bit of an item, and the hand clears bits until it meets an item
+// which was not used since its previous pass. Items inserted unreferenced,
+// like the ones of a sequential scan, are evicted first, so a long scan
+// recycles its own slots instead of flushing the working set.
+template<class Key, class Value, class Hash = std::hash<Key>> class ClockCache {
+public:
+  explicit ClockCache(size_t capacity = 0, size_t shardCount = 16) : m_shards(shardCount == 0 ? 1 : shardCount), m_hits(0), m_misses(0) {
+    for (auto& shard : m_shards) {
+      shard.reset(new Shard());
+    }
+
+    reset(capacity);
+  }
+
+  ClockCache(const ClockCache&) = delete;
+  ClockCache& operator=(const ClockCache&) = delete;
+
+  // Drops all items. Every shard keeps at least its newest item, even if
+  // that one alone exceeds the shard's part of the capacity.
+  void reset(size_t capacity) {
+    m_capacity = capacity;
+    for (auto& shard : m_shards) {
+      std::lock_guard<std::mutex> lk(shard->mutex);
+      shard->clear();
+      shard->capacity = capacity / m_shards.size();
+    }
+
+    m_hits = 0;
+    m_misses = 0;
+  }
+
+  size_t capacity() const {
+    return m_capacity;
+  }
+
+  std::shared_ptr<Value> find(const Key& key) {
+    Shard& shard = shardOf(key);
+    std::lock_guard<std::mutex> lk(shard.mutex);
+    auto it = shard.positions.find(key);
+    if (it == shard.positions.end()) {
+      ++m_misses;
+      return nullptr;
+    }
+
+    ++m_hits;
+    Slot& slot = shard.slots[it->second];
+    slot.referenced = true;
+    return slot.value;
+  }
+
+  // Unlike find(), neither counts nor marks the item as used
+  bool contains(const Key& key) const {
+    const Shard& shard = shardOf(key);
+    std::lock_guard<std::mutex> lk(shard.mutex);
+    return shard.positions.count(key) != 0;
+  }
+
+  void insert(const Key& key, std::shared_ptr<Value> value, size_t size, bool referenced = true) {
+    std::shared_ptr<Value> replaced;
+    Shard& shard = shardOf(key);
+    std::lock_guard<std::mutex> lk(shard.mutex);
+    auto it = shard.positions.find(key);
+    if (it != shard.positions.end()) {
+      replaced = shard.remove(it->second);
+    }
+
+    while (!shard.positions.empty() && shard.size + size > shard.capacity) {
+      shard.evict();
+    }
+
+    size_t position;
+    if (shard.freeSlots.empty()) {
+      position = shard.slots.size();
+      shard.slots.emplace_back();
+    } else {
+      position = shard.freeSlots.back();
+      shard.freeSlots.pop_back();
+    }
+
+    Slot& slot = shard.slots[position];
+    slot.key = key;
+    slot.value = std::move(value);
+    slot.size = size;
+    slot.referenced = referenced;
+    shard.positions.emplace(key, position);
+    shard.size += size;
+  }
+
+  void erase(const Key& key) {
+    std::shared_ptr<Value> removed;
+    Shard& shard = shardOf(key);
+    std::lock_guard<std::mutex> lk(shard.mutex);
+    auto it = shard.positions.find(key);
+    if (it != shard.positions.end()) {
+      removed = shard.remove(it->second);
+    }
+  }
+
+  void clear() {
+    for (auto& shard : m_shards) {
+      std::lock_guard<std::mutex> lk(shard->mutex);
+      shard->clear();
+    }
+  }
+
+  uint64_t hits() const {
+    return m_hits;
+  }
+
+  uint64_t misses() const {
+    return m_misses;
+  }
+
+private:
+  struct Slot {
+    Key key;
+    std::shared_ptr<Value> value;
+    size_t size;
+    bool referenced;
+  };
+
+  struct Shard {
+    mutable std::mutex mutex;
+    std::vector<Slot> slots; // the clock, free slots hold no value
+    std::vector<size_t> freeSlots;
+    std::unordered_map<Key, size_t, Hash> positions;
+    size_t hand = 0;
+    size_t size = 0;
+    size_t capacity = 0;
+
+    // Precondition: positions is not empty
+    void evict() {
+      for (;;) {
+        if (hand >= slots.size()) {
+          hand = 0;
+        }
+
+        Slot& slot = slots[hand++];
+        if (!slot.value) {
+          continue;
+        }
+
+        if (slot.referenced) {
+          slot.referenced = false;
+        } else {
+          remove(hand - 1);
+          return;
+        }
+      }
+    }
+
+    // Returns the value, so that it can be released after the lock
+    std::shared_ptr<Value> remove(size_t position) {
+      Slot& slot = slots[position];
+      positions.erase(slot.key);
+      size -= slot.size;
+      freeSlots.push_back(position);
+      return std::move(slot.value);
+    }
+
+    void clear() {
+      slots.clear();
+      freeSlots.clear();
+      positions.clear();
+      hand = 0;
+      size = 0;
+    }
+  };
+
+  Shard& shardOf(const Key& key) {
+    return *m_shards[Hash()(key) % m_shards.size()];
+  }
+
+  const Shard& shardOf(const Key& key) const {
+    return *m_shards[Hash()(key) % m_shards.size()];
+  }
+
+  std::vector<std::unique_ptr<Shard>> m_shards;
+  size_t m_capacity;
+  std::atomic<uint64_t> m_hits;
+  std::atomic<uint64_t> m_misses;
+};
+
+// Recognizes runs of consecutive misses, e.g. a loop over all blocks, so that
+// a container can load the following items ahead of the reader.
+class SequentialReads {
+public:
+  explicit SequentialReads(size_t threshold = 4) : m_threshold(threshold), m_next(std::numeric_limits<uint64_t>::max()), m_run(0) {
+  }
+
+  // True once `threshold` misses in a row each continued the previous one
+  bool miss(uint64_t index) {
+    m_run = index == m_next ? m_run + 1 : 0;
+    m_next = index + 1;
+    return m_run >= m_threshold;
+  }
+
+  // Items before `next` were loaded ahead, the run continues there
+  void readAhead(uint64_t next) {
+    m_next = next;
+  }
+
+  void reset() {
+    m_next = std::numeric_limits<uint64_t>::max();
+    m_run = 0;
+  }
+
+private:
+  size_t m_threshold;
+  uint64_t m_next;
+  size_t m_run;
+};
+
+}
@@ -25,6 +25,9 @@
 #include <cstring>
 #include <string>
 #include <map>
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include <boost/program_options/variables_map.hpp>
 #include <iostream>
 #ifdef _WIN32
@@ -50,6 +53,12 @@ namespace Common {
 #ifndef __ANDROID__
 
 	bool fetch_dns_txt(const std::string domain, std::vector<std::string>&records) {
+		uint32_t ttl;
+		return fetch_dns_txt(domain, records, ttl);
+	}
+
+	bool fetch_dns_txt(const std::string& domain, std::vector<std::string>& records, uint32_t& ttl) {
+		ttl = std::numeric_limits<uint32_t>::max();
 
 #ifdef _WIN32
 		using namespace std;
@@ -83,6 +92,7 @@ namespace Common {
 		for (it = pDnsRecord; it != NULL; it = it->pNext) {
 			if (callbacks.count(it->wType)) {
 				callbacks[it->wType]();
+				ttl = std::min<uint32_t>(ttl, it->dwTtl);
 			}
 		}
 		DnsRecordListFree(pDnsRecord, DnsFreeRecordListDeep);
@@ -123,6 +133,7 @@ namespace Common {
 			ns_type type = ns_rr_type(rr);
 			if (callbacks.count(type)) {
 				callbacks[type](rr);
+				ttl = std::min<uint32_t>(ttl, ns_rr_ttl(rr));
 			}
 		}
 
@@ -133,6 +144,65 @@ namespace Common {
 		return true;
 	}
 
+	namespace {
+
+	const size_t DNS_CACHE_MAX_ENTRIES = 1024;
+	const uint32_t DNS_CACHE_MAX_TTL = 60 * 60;  // seconds an answer is reused at most, whatever its TTL
+	const uint32_t DNS_NEGATIVE_CACHE_TTL = 60;  // seconds a failed lookup is remembered
+
+	struct DnsTxtAnswer {
+		bool ok;
+		std::vector<std::string> records;
+		std::chrono::steady_clock::time_point expires;
+	};
+
+	// a lookup in progress is in the cache too, as a future that isn't ready yet
+	std::mutex dnsCacheMutex;
+	std::map<std::string, std::shared_future<DnsTxtAnswer>> dnsCache;
+
+	bool isExpired(const std::shared_future<DnsTxtAnswer>& answer, std::chrono::steady_clock::time_point now) {
+		return answer.wait_for(std::chrono::seconds(0)) == std::future_status::ready && answer.get().expires <= now;
+	}
+
+	}
+
+	bool fetch_dns_txt_cached(const std::string& domain, std::vector<std::string>& records) {
+		std::promise<DnsTxtAnswer> query;
+		std::shared_future<DnsTxtAnswer> answer;
+		bool queried = false;
+		{
+			std::lock_guard<std::mutex> lock(dnsCacheMutex);
+			auto now = std::chrono::steady_clock::now();
+			auto it = dnsCache.find(domain);
+			if (it != dnsCache.end() && !isExpired(it->second, now)) {
+				answer = it->second;
+			} else {
+				if (dnsCache.size() >= DNS_CACHE_MAX_ENTRIES) {
+					for (auto cached = dnsCache.begin(); cached != dnsCache.end();) {
+						cached = isExpired(cached->second, now) ? dnsCache.erase(cached) : std::next(cached);
+					}
+				}
+
+				answer = query.get_future().share();
+				dnsCache[domain] = answer;
+				queried = true;
+			}
+		}
+
+		if (queried) {
+			DnsTxtAnswer result;
+			uint32_t ttl;
+			result.ok = fetch_dns_txt(domain, result.records, ttl);
+			ttl = result.ok ? std::min(ttl, DNS_CACHE_MAX_TTL) : DNS_NEGATIVE_CACHE_TTL;
+			result.expires = std::chrono::steady_clock::now() + std::chrono::seconds(ttl);
+			query.set_value(std::move(result));
+		}
+
+		const DnsTxtAnswer& result = answer.get();
+		records = result.records;
+		return result.ok;
+	}
+
 #endif
 
 bool processServerAliasResponse(const std::string& s, std::string& address) {
@@ -174,7 +244,7 @@ std::string resolveAlias(const std::string& aliasUrl) {
   std::vector<std::string> records;
   std::string address;
 
-  if (!Common::fetch_dns_txt(aliasUrl, records)) {
+  if (!Common::fetch_dns_txt_cached(aliasUrl, records)) {
     throw std::runtime_error("Failed to lookup DNS record");
   }
 
@@ -192,7 +262,7 @@ std::vector<std::string> resolveAliases(const std::string& aliasUrl) {
   std::vector<std::string> records;
   std::vector<std::string> addresses;
   
-  if (!Common::fetch_dns_txt(aliasUrl, records)) {
+  if (!Common::fetch_dns_txt_cached(aliasUrl, records)) {
     throw std::runtime_error("Failed to lookup DNS record");
   }
 
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -25,6 +26,11 @@ namespace Common {
 #ifndef __ANDROID__
 
   bool fetch_dns_txt(const std::string domain, std::vector<std::string>&records);
+  // ttl is the smallest time to live of the answer records, in seconds
+  bool fetch_dns_txt(const std::string& domain, std::vector<std::string>& records, uint32_t& ttl);
+  // Same as fetch_dns_txt, but the answers are reused for their time to live (an hour at most)
+  // and failures for a minute. Concurrent lookups of a domain wait for a single query.
+  bool fetch_dns_txt_cached(const std::string& domain, std::vector<std::string>& records);
   bool processServerAliasResponse(const std::string& s, std::string& address);
   std::string resolveAlias(const std::string& aliasUrl);
   std::vector<std::string> resolveAliases(const std::string& aliasUrl);
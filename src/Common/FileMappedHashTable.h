@@ -0,0 +1,270 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "Common/FileMappedVector.h"
+
+namespace Common {
+
+// Hash table of POD keys and values with open addressing and linear probing, kept in a
+// memory mapped file. Only the pages being looked at stay in memory, the kernel drops the
+// rest, so the resident size doesn't grow with the number of entries like a heap table.
+// Writes aren't synced one by one: a table that wasn't closed is emptied when opened, and
+// destroying an open table leaves it that way.
+template<class Key, class Value, class Hash = std::hash<Key>>
+class FileMappedHashTable {
+public:
+  FileMappedHashTable() : m_reset(false) {
+  }
+
+  FileMappedHashTable(const FileMappedHashTable&) = delete;
+  FileMappedHashTable& operator=(const FileMappedHashTable&) = delete;
+
+  ~FileMappedHashTable() {
+    if (isOpened()) {
+      std::error_code ignore;
+      m_slots.close(ignore);
+    }
+  }
+
+  void open(const std::string& path) {
+    m_path = path;
+    m_slots.open(path, FileMappedVectorOpenMode::OPEN_OR_CREATE, sizeof(Header));
+    m_slots.setAutoFlush(false);
+
+    m_reset = m_slots.empty() || header().clean == 0;
+    if (m_reset) {
+      resize(INITIAL_BUCKET_COUNT);
+    }
+
+    header().clean = 0;
+    m_slots.flush();
+  }
+
+  void close() {
+    header().clean = 1;
+    m_slots.flush();
+    m_slots.close();
+  }
+
+  bool isOpened() const {
+    return m_slots.isOpened();
+  }
+
+  // true if open() found the table missing or not closed, so it started empty
+  bool wasReset() const {
+    return m_reset;
+  }
+
+  bool find(const Key& key, Value& value) const {
+    uint64_t index;
+    if (!findSlot(key, index)) {
+      return false;
+    }
+
+    value = m_slots[index].value;
+    return true;
+  }
+
+  bool contains(const Key& key) const {
+    uint64_t index;
+    return findSlot(key, index);
+  }
+
+  // false if the key is already there, the value isn't changed then
+  bool insert(const Key& key, const Value& value) {
+    if ((header().count + header().erased + 1) * MAX_LOAD_DENOMINATOR > m_slots.size() * MAX_LOAD_NUMERATOR) {
+      rehash();
+    }
+
+    uint64_t mask = m_slots.size() - 1;
+    uint64_t index = Hash()(key) & mask;
+    uint64_t target = m_slots.size();
+    for (;; index = (index + 1) & mask) {
+      const Slot& slot = m_slots[index];
+      if (slot.state == SLOT_EMPTY) {
+        break;
+      }
+
+      if (slot.state == SLOT_ERASED) {
+        if (target == m_slots.size()) {
+          target = index;
+        }
+      } else if (slot.key == key) {
+        return false;
+      }
+    }
+
+    if (target == m_slots.size()) {
+      target = index;
+    } else {
+      --header().erased;
+    }
+
+    Slot& slot = m_slots[target];
+    slot.key = key;
+    slot.value = value;
+    slot.state = SLOT_USED;
+    ++header().count;
+    return true;
+  }
+
+  size_t erase(const Key& key) {
+    uint64_t index;
+    if (!findSlot(key, index)) {
+      return 0;
+    }
+
+    m_slots[index].state = SLOT_ERASED;
+    --header().count;
+    ++header().erased;
+    return 1;
+  }
+
+  uint64_t size() const {
+    return header().count;
+  }
+
+  void clear() {
+    resize(INITIAL_BUCKET_COUNT);
+  }
+
+  void flush() {
+    m_slots.flush();
+  }
+
+private:
+  enum : uint8_t {
+    SLOT_EMPTY = 0,
+    SLOT_USED = 1,
+    SLOT_ERASED = 2
+  };
+
+  struct Slot {
+    Key key;
+    Value value;
+    uint8_t state;
+  };
+
+  struct Header {
+    uint64_t count;
+    uint64_t erased;
+    uint64_t clean;
+  };
+
+  // the table is rehashed to at most half full once used and erased slots reach 70%
+  static const uint64_t INITIAL_BUCKET_COUNT = 1024;
+  static const uint64_t MAX_LOAD_NUMERATOR = 7;
+  static const uint64_t MAX_LOAD_DENOMINATOR = 10;
+
+  Header& header() {
+    return *reinterpret_cast<Header*>(m_slots.prefix());
+  }
+
+  const Header& header() const {
+    return *reinterpret_cast<const Header*>(m_slots.prefix());
+  }
+
+  bool findSlot(const Key& key, uint64_t& index) const {
+    uint64_t mask = m_slots.size() - 1;
+    for (index = Hash()(key) & mask; m_slots[index].state != SLOT_EMPTY; index = (index + 1) & mask) {
+      if (m_slots[index].state == SLOT_USED && m_slots[index].key == key) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  static void appendEmptySlots(FileMappedVector<Slot>& slots, uint64_t count) {
+    std::vector<Slot> chunk(static_cast<size_t>(std::min<uint64_t>(count, 65536)));
+    for (Slot& slot : chunk) {
+      slot.state = SLOT_EMPTY;
+    }
+
+    slots.reserve(slots.size() + count);
+    while (count != 0) {
+      uint64_t n = std::min<uint64_t>(count, chunk.size());
+      slots.insert(slots.end(), chunk.begin(), chunk.begin() + static_cast<size_t>(n));
+      count -= n;
+    }
+  }
+
+  void resize(uint64_t bucketCount) {
+    m_slots.clear();
+    m_slots.shrink_to_fit();
+    appendEmptySlots(m_slots, bucketCount);
+    header().count = 0;
+    header().erased = 0;
+  }
+
+  // the entries are moved to a new file, which then replaces the table
+  void rehash() {
+    uint64_t bucketCount = m_slots.size();
+    while ((header().count + 1) * 2 > bucketCount) {
+      bucketCount *= 2;
+    }
+
+    std::string newPath = m_path + ".new";
+    boost::system::error_code ignore;
+    boost::filesystem::remove(newPath, ignore);
+
+    FileMappedVector<Slot> newSlots(newPath, FileMappedVectorOpenMode::CREATE, sizeof(Header));
+    newSlots.setAutoFlush(false);
+    appendEmptySlots(newSlots, bucketCount);
+
+    uint64_t mask = bucketCount - 1;
+    for (uint64_t i = 0; i < m_slots.size(); ++i) {
+      const Slot& slot = m_slots[i];
+      if (slot.state != SLOT_USED) {
+        continue;
+      }
+
+      uint64_t index = Hash()(slot.key) & mask;
+      while (newSlots[index].state != SLOT_EMPTY) {
+        index = (index + 1) & mask;
+      }
+
+      newSlots[index] = slot;
+    }
+
+    Header& newHeader = *reinterpret_cast<Header*>(newSlots.prefix());
+    newHeader.count = header().count;
+    newHeader.erased = 0;
+    newHeader.clean = 0;
+    newSlots.flush();
+
+    m_slots.close();
+    boost::filesystem::remove(m_path);
+    newSlots.rename(m_path);
+    m_slots.swap(newSlots);
+  }
+
+  std::string m_path;
+  FileMappedVector<Slot> m_slots;
+  bool m_reset;
+};
+
+}
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <string>
@@ -590,6 +591,11 @@ typename FileMappedVector<T>::iterator FileMappedVector<T>::erase(const_iterator
   assert(isOpened());
 
   uint64_t newSize = size() - std::distance(first, last);
+  if (last == cend()) {
+    *sizePtr() = newSize;
+    flushSize();
+    return iterator(this, first.index());
+  }
 
   atomicUpdate(newSize, capacity(), prefixSize(), suffixSize(), [this, first, last](value_type* target) {
     std::copy(cbegin(), first, target);
@@ -611,7 +617,25 @@ template<class InputIterator>
 typename FileMappedVector<T>::iterator FileMappedVector<T>::insert(const_iterator position, InputIterator first, InputIterator last) {
   assert(isOpened());
 
-  uint64_t newSize = size() + static_cast<uint64_t>(std::distance(first, last));
+  uint64_t count = static_cast<uint64_t>(std::distance(first, last));
+  uint64_t newSize = size() + count;
+  if (position == cend()) {
+    // Appending doesn't move existing elements, so the file is only copied when it has to grow
+    if (newSize > capacity()) {
+      reserve(std::max(nextCapacity(), newSize));
+    }
+
+    uint64_t index = size();
+    std::copy(first, last, vectorDataPtr() + index);
+    if (m_autoFlush && count != 0) {
+      m_file.flush(reinterpret_cast<uint8_t*>(vectorDataPtr() + index), valueSize * count);
+    }
+
+    *sizePtr() = newSize;
+    flushSize();
+    return iterator(this, index);
+  }
+
   uint64_t newCapacity;
   if (newSize > capacity()) {
     newCapacity = nextCapacity();
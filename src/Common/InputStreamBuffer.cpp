@@ -0,0 +1,60 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "InputStreamBuffer.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Common {
+
+InputStreamBuffer::InputStreamBuffer(IInputStream& in, uint64_t limit) : m_in(in), m_left(limit) {
+  setg(m_buffer, m_buffer, m_buffer);
+}
+
+void InputStreamBuffer::skipRest() {
+  setg(m_buffer, m_buffer, m_buffer);
+  while (m_left > 0) {
+    size_t size = m_in.readSome(m_buffer, static_cast<size_t>(std::min<uint64_t>(sizeof(m_buffer), m_left)));
+    if (size == 0) {
+      throw std::runtime_error("Unexpected end of stream");
+    }
+
+    m_left -= size;
+  }
+}
+
+InputStreamBuffer::int_type InputStreamBuffer::underflow() {
+  if (gptr() < egptr()) {
+    return traits_type::to_int_type(*gptr());
+  }
+
+  if (m_left == 0) {
+    return traits_type::eof();
+  }
+
+  size_t size = m_in.readSome(m_buffer, static_cast<size_t>(std::min<uint64_t>(sizeof(m_buffer), m_left)));
+  if (size == 0) {
+    return traits_type::eof();
+  }
+
+  m_left -= size;
+  setg(m_buffer, m_buffer, m_buffer + size);
+  return traits_type::to_int_type(*gptr());
+}
+
+}
@@ -0,0 +1,45 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <streambuf>
+#include "IInputStream.h"
+
+namespace Common {
+
+// Lets a std::istream read the next bytes of an IInputStream, no more than the limit,
+// so that a nested blob can be loaded in place instead of being copied out first.
+class InputStreamBuffer : public std::streambuf {
+public:
+  InputStreamBuffer(IInputStream& in, uint64_t limit);
+  InputStreamBuffer& operator=(const InputStreamBuffer&) = delete;
+
+  // reads and drops what is left up to the limit
+  void skipRest();
+
+protected:
+  int_type underflow() override;
+
+private:
+  IInputStream& m_in;
+  uint64_t m_left;
+  char m_buffer[4096];
+};
+
+}
@@ -9,6 +9,8 @@
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
+#include <unordered_map>
 
 namespace Common {
 
@@ -42,7 +44,7 @@ JsonValue::JsonValue(const JsonValue& other) {
   type = other.type;
 }
 
-JsonValue::JsonValue(JsonValue&& other) {
+JsonValue::JsonValue(JsonValue&& other) noexcept {
   switch (other.type) {
   case ARRAY:
     new(valueArray)Array(std::move(*reinterpret_cast<Array*>(other.valueArray)));
@@ -197,13 +199,17 @@ JsonValue& JsonValue::operator=(const JsonValue& other) {
   return *this;
 }
 
-JsonValue& JsonValue::operator=(JsonValue&& other) {
+JsonValue& JsonValue::operator=(JsonValue&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+
   if (type != other.type) {
     destructValue();
     switch (other.type) {
     case ARRAY:
       type = NIL;
-      new(valueArray)Array(std::move(*reinterpret_cast<const Array*>(other.valueArray)));
+      new(valueArray)Array(std::move(*reinterpret_cast<Array*>(other.valueArray)));
       reinterpret_cast<Array*>(other.valueArray)->~Array();
       break;
     case BOOL:
@@ -216,7 +222,7 @@ JsonValue& JsonValue::operator=(JsonValue&& other) {
       break;
     case OBJECT:
       type = NIL;
-      new(valueObject)Object(std::move(*reinterpret_cast<const Object*>(other.valueObject)));
+      new(valueObject)Object(std::move(*reinterpret_cast<Object*>(other.valueObject)));
       reinterpret_cast<Object*>(other.valueObject)->~Object();
       break;
     case REAL:
@@ -224,7 +230,7 @@ JsonValue& JsonValue::operator=(JsonValue&& other) {
       break;
     case STRING:
       type = NIL;
-      new(valueString)String(std::move(*reinterpret_cast<const String*>(other.valueString)));
+      new(valueString)String(std::move(*reinterpret_cast<String*>(other.valueString)));
       reinterpret_cast<String*>(other.valueString)->~String();
       break;
     }
@@ -233,7 +239,7 @@ JsonValue& JsonValue::operator=(JsonValue&& other) {
   } else {
     switch (type) {
     case ARRAY:
-      *reinterpret_cast<Array*>(valueArray) = std::move(*reinterpret_cast<const Array*>(other.valueArray));
+      *reinterpret_cast<Array*>(valueArray) = std::move(*reinterpret_cast<Array*>(other.valueArray));
       reinterpret_cast<Array*>(other.valueArray)->~Array();
       break;
     case BOOL:
@@ -245,14 +251,14 @@ JsonValue& JsonValue::operator=(JsonValue&& other) {
     case NIL:
       break;
     case OBJECT:
-      *reinterpret_cast<Object*>(valueObject) = std::move(*reinterpret_cast<const Object*>(other.valueObject));
+      *reinterpret_cast<Object*>(valueObject) = std::move(*reinterpret_cast<Object*>(other.valueObject));
       reinterpret_cast<Object*>(other.valueObject)->~Object();
       break;
     case REAL:
       valueReal = other.valueReal;
       break;
     case STRING:
-      *reinterpret_cast<String*>(valueString) = std::move(*reinterpret_cast<const String*>(other.valueString));
+      *reinterpret_cast<String*>(valueString) = std::move(*reinterpret_cast<String*>(other.valueString));
       reinterpret_cast<String*>(other.valueString)->~String();
       break;
     }
@@ -562,6 +568,127 @@ size_t JsonValue::erase(const Key& key) {
   return getObject().erase(key);
 }
 
+JsonValue::Object::iterator JsonValue::Object::find(const Key& key) {
+  for (auto it = members.begin(); it != members.end(); ++it) {
+    if (it->first == key) {
+      return it;
+    }
+  }
+
+  return members.end();
+}
+
+JsonValue::Object::const_iterator JsonValue::Object::find(const Key& key) const {
+  for (auto it = members.begin(); it != members.end(); ++it) {
+    if (it->first == key) {
+      return it;
+    }
+  }
+
+  return members.end();
+}
+
+JsonValue& JsonValue::Object::at(const Key& key) {
+  auto it = find(key);
+  if (it == members.end()) {
+    throw std::out_of_range("JsonValue object has no member " + key);
+  }
+
+  return it->second;
+}
+
+const JsonValue& JsonValue::Object::at(const Key& key) const {
+  auto it = find(key);
+  if (it == members.end()) {
+    throw std::out_of_range("JsonValue object has no member " + key);
+  }
+
+  return it->second;
+}
+
+JsonValue& JsonValue::Object::operator[](const Key& key) {
+  auto it = find(key);
+  if (it != members.end()) {
+    return it->second;
+  }
+
+  members.emplace_back(key, JsonValue());
+  return members.back().second;
+}
+
+std::pair<JsonValue::Object::iterator, bool> JsonValue::Object::emplace(const Key& key, const JsonValue& value) {
+  auto it = find(key);
+  if (it != members.end()) {
+    return std::make_pair(it, false);
+  }
+
+  members.emplace_back(key, value);
+  return std::make_pair(members.end() - 1, true);
+}
+
+std::pair<JsonValue::Object::iterator, bool> JsonValue::Object::emplace(const Key& key, JsonValue&& value) {
+  auto it = find(key);
+  if (it != members.end()) {
+    return std::make_pair(it, false);
+  }
+
+  members.emplace_back(key, std::move(value));
+  return std::make_pair(members.end() - 1, true);
+}
+
+size_t JsonValue::Object::erase(const Key& key) {
+  auto it = find(key);
+  if (it == members.end()) {
+    return 0;
+  }
+
+  members.erase(it);
+  return 1;
+}
+
+// The parser appends members unchecked. A repeated key keeps its first
+// position and its last value, as assigning into a map did. Large objects
+// are indexed, so that a hostile document can't make this quadratic.
+void JsonValue::Object::mergeDuplicates() {
+  const size_t SCAN_LIMIT = 16;
+  size_t count = 0;
+  if (members.size() <= SCAN_LIMIT) {
+    for (size_t i = 0; i < members.size(); ++i) {
+      size_t j = 0;
+      while (j < count && members[j].first != members[i].first) {
+        ++j;
+      }
+
+      if (j < count) {
+        members[j].second = std::move(members[i].second);
+      } else {
+        if (i != count) {
+          members[count] = std::move(members[i]);
+        }
+
+        ++count;
+      }
+    }
+  } else {
+    std::unordered_map<Key, size_t> positions;
+    positions.reserve(members.size());
+    for (size_t i = 0; i < members.size(); ++i) {
+      auto result = positions.emplace(members[i].first, count);
+      if (!result.second) {
+        members[result.first->second].second = std::move(members[i].second);
+      } else {
+        if (i != count) {
+          members[count] = std::move(members[i]);
+        }
+
+        ++count;
+      }
+    }
+  }
+
+  members.erase(members.begin() + count, members.end());
+}
+
 JsonValue JsonValue::fromString(const std::string& source) {
   JsonValue jsonValue;
   std::istringstream stream(source);
@@ -887,21 +1014,20 @@ void JsonValue::readObject(std::istream& in) {
   JsonValue::Object value;
 
   if (c != '}') {
-    std::string name;
-
     for (;;) {
       if (c != '"') {
         throw std::runtime_error("Unable to parse");
       }
 
-      name = readStringToken(in);
+      std::string name = readStringToken(in);
       c = readNonWsChar(in);
 
       if (c != ':') {
         throw std::runtime_error("Unable to parse");
       }
 
-      in >> value[name];
+      value.members.emplace_back(std::move(name), JsonValue());
+      in >> value.members.back().second;
       c = readNonWsChar(in);
 
       if (c == '}') {
@@ -914,6 +1040,8 @@ void JsonValue::readObject(std::istream& in) {
 
       c = readNonWsChar(in);
     }
+
+    value.mergeDuplicates();
   }
 
   if (type != JsonValue::OBJECT) {
@@ -9,8 +9,8 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace Common {
@@ -23,10 +23,47 @@ public:
   typedef bool Bool;
   typedef int64_t Integer;
   typedef std::nullptr_t Nil;
-  typedef std::map<Key, JsonValue> Object;
   typedef double Real;
   typedef std::string String;
 
+  // Members in insertion order. An object has a handful of members, which a
+  // linear scan over one contiguous block finds faster than a tree descent,
+  // and printing follows the order the members were added in. Like array
+  // elements, references to members don't survive adding another member.
+  class Object {
+  public:
+    typedef std::pair<Key, JsonValue> value_type;
+    typedef std::vector<value_type>::iterator iterator;
+    typedef std::vector<value_type>::const_iterator const_iterator;
+
+    iterator begin() { return members.begin(); }
+    const_iterator begin() const { return members.begin(); }
+    iterator end() { return members.end(); }
+    const_iterator end() const { return members.end(); }
+    size_t size() const { return members.size(); }
+    bool empty() const { return members.empty(); }
+    void clear() { members.clear(); }
+    void reserve(size_t count) { members.reserve(count); }
+    void swap(Object& other) { members.swap(other.members); }
+
+    iterator find(const Key& key);
+    const_iterator find(const Key& key) const;
+    size_t count(const Key& key) const { return find(key) != end() ? 1 : 0; }
+    JsonValue& at(const Key& key);
+    const JsonValue& at(const Key& key) const;
+    JsonValue& operator[](const Key& key);
+    std::pair<iterator, bool> emplace(const Key& key, const JsonValue& value);
+    std::pair<iterator, bool> emplace(const Key& key, JsonValue&& value);
+    size_t erase(const Key& key);
+
+  private:
+    friend class JsonValue;
+
+    std::vector<value_type> members;
+
+    void mergeDuplicates();
+  };
+
   enum Type {
     ARRAY,
     BOOL,
@@ -39,7 +76,7 @@ public:
 
   JsonValue();
   JsonValue(const JsonValue& other);
-  JsonValue(JsonValue&& other);
+  JsonValue(JsonValue&& other) noexcept;
   JsonValue(Type valueType);
   JsonValue(const Array& value);
   JsonValue(Array&& value);
@@ -59,7 +96,7 @@ public:
   ~JsonValue();
 
   JsonValue& operator=(const JsonValue& other);
-  JsonValue& operator=(JsonValue&& other);
+  JsonValue& operator=(JsonValue&& other) noexcept;
   JsonValue& operator=(const Array& value);
   JsonValue& operator=(Array&& value);
   //JsonValue& operator=(Bool value);
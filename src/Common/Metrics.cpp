@@ -0,0 +1,84 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Metrics.h"
+
+namespace Common {
+
+const std::vector<uint64_t> MetricsHistogram::DURATION_BOUNDS = { 1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000, 10000000 };
+
+MetricsHistogram::MetricsHistogram(const std::vector<uint64_t>& bounds) : m_bounds(bounds), m_buckets(bounds.size() + 1),
+  m_count(0), m_sum(0), m_max(0) {
+}
+
+void MetricsHistogram::add(uint64_t value) {
+  size_t index = 0;
+  while (index < m_bounds.size() && value > m_bounds[index]) {
+    ++index;
+  }
+
+  ++m_buckets[index];
+  ++m_count;
+  m_sum += value;
+  uint64_t max = m_max;
+  while (value > max && !m_max.compare_exchange_weak(max, value)) {
+  }
+}
+
+void MetricsHistogram::add(std::chrono::steady_clock::duration value) {
+  add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(value).count()));
+}
+
+void writeMetricHeader(std::ostream& out, const char* name, const char* type, const char* help) {
+  out << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' ' << type << '\n';
+}
+
+void writeMetricHistogram(std::ostream& out, const char* name, const std::string& labels, const MetricsHistogram& histogram, bool microseconds) {
+  std::string prefix = labels.empty() ? std::string() : labels + ",";
+  uint64_t cumulative = 0;
+  for (size_t i = 0; i < histogram.bucketCount(); ++i) {
+    cumulative += histogram.bucket(i);
+    out << name << "_bucket{" << prefix << "le=\"";
+    if (i + 1 == histogram.bucketCount()) {
+      out << "+Inf";
+    } else if (microseconds) {
+      out << formatMetricSeconds(histogram.bound(i));
+    } else {
+      out << histogram.bound(i);
+    }
+
+    out << "\"} " << cumulative << '\n';
+  }
+
+  std::string suffix = labels.empty() ? std::string() : "{" + labels + "}";
+  out << name << "_sum" << suffix << ' ';
+  if (microseconds) {
+    out << formatMetricSeconds(histogram.sum());
+  } else {
+    out << histogram.sum();
+  }
+
+  out << '\n' << name << "_count" << suffix << ' ' << histogram.count() << '\n';
+}
+
+std::string formatMetricSeconds(uint64_t microseconds) {
+  std::string fraction = std::to_string(1000000 + microseconds % 1000000).substr(1);
+  fraction.erase(fraction.find_last_not_of('0') + 1);
+  return std::to_string(microseconds / 1000000) + (fraction.empty() ? "" : "." + fraction);
+}
+
+}
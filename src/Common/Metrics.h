@@ -0,0 +1,64 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Common {
+
+// Histogram of non-negative integer observations, safe to update from several threads.
+// Durations are kept in microseconds.
+class MetricsHistogram {
+public:
+  // upper bounds in microseconds, for durations
+  static const std::vector<uint64_t> DURATION_BOUNDS;
+
+  // bounds are the ascending upper bounds of all buckets but the last, unbounded one
+  explicit MetricsHistogram(const std::vector<uint64_t>& bounds = DURATION_BOUNDS);
+  MetricsHistogram(const MetricsHistogram&) = delete;
+  MetricsHistogram& operator=(const MetricsHistogram&) = delete;
+
+  void add(uint64_t value);
+  void add(std::chrono::steady_clock::duration value);
+
+  size_t bucketCount() const { return m_buckets.size(); }
+  uint64_t bound(size_t index) const { return m_bounds[index]; }
+  uint64_t bucket(size_t index) const { return m_buckets[index]; }
+  uint64_t count() const { return m_count; }
+  uint64_t sum() const { return m_sum; }
+  uint64_t max() const { return m_max; }
+
+private:
+  const std::vector<uint64_t> m_bounds;
+  std::vector<std::atomic<uint64_t>> m_buckets;
+  std::atomic<uint64_t> m_count;
+  std::atomic<uint64_t> m_sum;
+  std::atomic<uint64_t> m_max;
+};
+
+// Prometheus text exposition format
+void writeMetricHeader(std::ostream& out, const char* name, const char* type, const char* help);
+// labels are comma separated name="value" pairs and may be empty, microseconds are written as seconds
+void writeMetricHistogram(std::ostream& out, const char* name, const std::string& labels, const MetricsHistogram& histogram, bool microseconds);
+std::string formatMetricSeconds(uint64_t microseconds);
+
+}
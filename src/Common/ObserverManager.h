@@ -18,7 +18,14 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace Tools {
@@ -26,6 +33,32 @@ namespace Tools {
 template<typename T>
 class ObserverManager {
 public:
+  struct ObserverLag {
+    T* observer;
+    // from queuing an asynchronous notification to the observer having handled it
+    std::chrono::steady_clock::duration last;
+    std::chrono::steady_clock::duration max;
+  };
+
+  ObserverManager() : m_stopping(false) {
+  }
+
+  ObserverManager(const ObserverManager&) = delete;
+  ObserverManager& operator=(const ObserverManager&) = delete;
+
+  // the queued notifications are delivered first
+  ~ObserverManager() {
+    {
+      std::unique_lock<std::mutex> lock(m_queueMutex);
+      m_stopping = true;
+    }
+
+    m_queueChanged.notify_one();
+    if (m_worker.joinable()) {
+      m_worker.join();
+    }
+  }
+
   bool add(T* observer) {
     std::unique_lock<std::mutex> lock(m_observersMutex);
     auto it = std::find(m_observers.begin(), m_observers.end(), observer);
@@ -45,6 +78,11 @@ public:
       return false;
     } else {
       m_observers.erase(it);
+      m_lags.erase(observer);
+      lock.unlock();
+
+      // once this returns the observer isn't being called any more and can be destroyed
+      waitForDelivery();
       return true;
     }
   }
@@ -52,6 +90,53 @@ public:
   void clear() {
     std::unique_lock<std::mutex> lock(m_observersMutex);
     m_observers.clear();
+    m_lags.clear();
+    lock.unlock();
+
+    waitForDelivery();
+  }
+
+  // Queues the notification for the thread of the manager, so that slow observers don't
+  // hold up the notifying thread. A notification that is still queued isn't queued again:
+  // observers of these only learn that something was updated and look it up themselves.
+  template<typename F>
+  void notifyAsync(F notification) {
+    std::string key(reinterpret_cast<const char*>(&notification), sizeof(notification));
+    {
+      std::unique_lock<std::mutex> lock(m_queueMutex);
+      for (const AsyncNotification& queued : m_queue) {
+        if (queued.key == key) {
+          return;
+        }
+      }
+
+      if (!m_worker.joinable()) {
+        m_worker = std::thread(&ObserverManager::deliverAsync, this);
+        m_workerId = m_worker.get_id();
+      }
+
+      m_queue.push_back(AsyncNotification{ [notification](T* observer) { (observer->*notification)(); }, key, std::chrono::steady_clock::now() });
+    }
+
+    m_queueChanged.notify_one();
+  }
+
+  size_t queuedNotifications() const {
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    return m_queue.size();
+  }
+
+  std::vector<ObserverLag> lags() const {
+    std::unique_lock<std::mutex> lock(m_observersMutex);
+    std::vector<ObserverLag> lags;
+    for (T* observer : m_observers) {
+      auto it = m_lags.find(observer);
+      if (it != m_lags.end()) {
+        lags.push_back(it->second);
+      }
+    }
+
+    return lags;
   }
 
 #if defined(_MSC_VER)
@@ -163,8 +248,72 @@ public:
 #endif
 
 private:
+  struct AsyncNotification {
+    std::function<void(T*)> call;
+    std::string key;
+    std::chrono::steady_clock::time_point queued;
+  };
+
+  void deliverAsync() {
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    for (;;) {
+      m_queueChanged.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+      if (m_queue.empty()) {
+        return;
+      }
+
+      AsyncNotification notification = std::move(m_queue.front());
+      m_queue.pop_front();
+      lock.unlock();
+
+      {
+        std::unique_lock<std::mutex> deliveryLock(m_deliveryMutex);
+        std::vector<T*> observersCopy;
+        {
+          std::unique_lock<std::mutex> observersLock(m_observersMutex);
+          observersCopy = m_observers;
+        }
+
+        for (T* observer : observersCopy) {
+          notification.call(observer);
+          std::chrono::steady_clock::duration lag = std::chrono::steady_clock::now() - notification.queued;
+
+          std::unique_lock<std::mutex> observersLock(m_observersMutex);
+          if (std::find(m_observers.begin(), m_observers.end(), observer) != m_observers.end()) {
+            ObserverLag& observerLag = m_lags.emplace(observer, ObserverLag{ observer, lag, lag }).first->second;
+            observerLag.last = lag;
+            observerLag.max = std::max(observerLag.max, lag);
+          }
+        }
+      }
+
+      lock.lock();
+    }
+  }
+
+  // an observer removing itself from a notification doesn't wait for its own delivery
+  void waitForDelivery() {
+    {
+      std::unique_lock<std::mutex> lock(m_queueMutex);
+      if (!m_worker.joinable() || std::this_thread::get_id() == m_workerId) {
+        return;
+      }
+    }
+
+    std::unique_lock<std::mutex> deliveryLock(m_deliveryMutex);
+  }
+
   std::vector<T*> m_observers;
-  std::mutex m_observersMutex;
+  std::unordered_map<T*, ObserverLag> m_lags;
+  mutable std::mutex m_observersMutex;
+
+  std::deque<AsyncNotification> m_queue;
+  mutable std::mutex m_queueMutex;
+  std::condition_variable m_queueChanged;
+  std::mutex m_deliveryMutex;
+  std::thread m_worker;
+  std::thread::id m_workerId;
+  bool m_stopping;
 };
 
 }
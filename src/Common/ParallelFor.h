@@ -0,0 +1,29 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace Common {
+
+// Calls body for every index in [0, count) on up to hardware_concurrency threads, the
+// calling thread included. Returns once all calls are done; the first exception thrown
+// by body is rethrown, the indices not started by then are skipped.
+void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+}
@@ -0,0 +1,167 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "RecursiveSharedMutex.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Tools {
+
+namespace {
+
+// shared lock depth of the current thread for every mutex it holds
+typedef std::vector<std::pair<const RecursiveSharedMutex*, size_t>> SharedDepths;
+
+SharedDepths& threadSharedDepths() {
+  static thread_local SharedDepths depths;
+  return depths;
+}
+
+std::chrono::steady_clock::duration& threadWaitTotal() {
+  static thread_local std::chrono::steady_clock::duration total = std::chrono::steady_clock::duration::zero();
+  return total;
+}
+
+// times the wait only when the lock is actually contended
+template<class Predicate> void waitTimed(std::condition_variable& cv, std::unique_lock<std::mutex>& lk, Predicate ready) {
+  if (ready()) {
+    return;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  cv.wait(lk, ready);
+  threadWaitTotal() += std::chrono::steady_clock::now() - start;
+}
+
+SharedDepths::iterator findDepth(SharedDepths& depths, const RecursiveSharedMutex* mutex) {
+  return std::find_if(depths.begin(), depths.end(), [mutex](const SharedDepths::value_type& entry) { return entry.first == mutex; });
+}
+
+}
+
+RecursiveSharedMutex::RecursiveSharedMutex() : m_writerDepth(0), m_readers(0), m_waitingWriters(0) {
+}
+
+void RecursiveSharedMutex::lock() {
+  std::unique_lock<std::mutex> lk(m_mutex);
+  const std::thread::id self = std::this_thread::get_id();
+  if (m_writerDepth != 0 && m_writer == self) {
+    ++m_writerDepth;
+    return;
+  }
+
+  if (findDepth(threadSharedDepths(), this) != threadSharedDepths().end()) {
+    // we would wait for our own shared lock forever
+    throw std::logic_error("RecursiveSharedMutex: upgrading a shared lock to an exclusive one");
+  }
+
+  ++m_waitingWriters;
+  waitTimed(m_writersCv, lk, [this] { return m_writerDepth == 0 && m_readers == 0; });
+  --m_waitingWriters;
+
+  m_writer = self;
+  m_writerDepth = 1;
+}
+
+bool RecursiveSharedMutex::try_lock() {
+  std::unique_lock<std::mutex> lk(m_mutex);
+  const std::thread::id self = std::this_thread::get_id();
+  if (m_writerDepth != 0 && m_writer == self) {
+    ++m_writerDepth;
+    return true;
+  }
+
+  if (m_writerDepth != 0 || m_readers != 0) {
+    return false;
+  }
+
+  m_writer = self;
+  m_writerDepth = 1;
+  return true;
+}
+
+void RecursiveSharedMutex::unlock() {
+  std::unique_lock<std::mutex> lk(m_mutex);
+  assert(m_writerDepth != 0 && m_writer == std::this_thread::get_id());
+  if (--m_writerDepth != 0) {
+    return;
+  }
+
+  m_writer = std::thread::id();
+  if (findDepth(threadSharedDepths(), this) != threadSharedDepths().end()) {
+    // shared locks taken under the exclusive one outlive it
+    ++m_readers;
+  }
+
+  if (m_waitingWriters != 0) {
+    m_writersCv.notify_one();
+  } else {
+    m_readersCv.notify_all();
+  }
+}
+
+void RecursiveSharedMutex::lock_shared() {
+  SharedDepths& depths = threadSharedDepths();
+  auto it = findDepth(depths, this);
+  if (it != depths.end()) {
+    // already holding a shared lock, a waiting writer must not block us
+    ++it->second;
+    return;
+  }
+
+  std::unique_lock<std::mutex> lk(m_mutex);
+  if (m_writerDepth != 0 && m_writer == std::this_thread::get_id()) {
+    // exclusive owner reads under its own lock
+    depths.emplace_back(this, 1);
+    return;
+  }
+
+  waitTimed(m_readersCv, lk, [this] { return m_writerDepth == 0 && m_waitingWriters == 0; });
+  ++m_readers;
+  depths.emplace_back(this, 1);
+}
+
+void RecursiveSharedMutex::unlock_shared() {
+  SharedDepths& depths = threadSharedDepths();
+  auto it = findDepth(depths, this);
+  assert(it != depths.end());
+  if (--it->second != 0) {
+    return;
+  }
+
+  depths.erase(it);
+
+  std::unique_lock<std::mutex> lk(m_mutex);
+  if (m_writerDepth != 0 && m_writer == std::this_thread::get_id()) {
+    return;
+  }
+
+  assert(m_readers != 0);
+  if (--m_readers == 0 && m_waitingWriters != 0) {
+    m_writersCv.notify_one();
+  }
+}
+
+std::chrono::steady_clock::duration RecursiveSharedMutex::threadWaitTime() {
+  return threadWaitTotal();
+}
+
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+namespace Tools {
+
+// Reader/writer lock which may be re-entered by the thread that owns it.
+// The exclusive owner may also take shared locks, those left when it unlocks
+// keep the thread a reader. Upgrading a shared lock to an exclusive one would
+// deadlock, lock() throws std::logic_error instead.
+// Waiting writers block new readers, except threads already holding a
+// shared lock, so recursive readers never deadlock against a writer.
+class RecursiveSharedMutex {
+public:
+  RecursiveSharedMutex();
+
+  RecursiveSharedMutex(const RecursiveSharedMutex&) = delete;
+  RecursiveSharedMutex& operator=(const RecursiveSharedMutex&) = delete;
+
+  void lock();
+  bool try_lock();
+  void unlock();
+
+  void lock_shared();
+  void unlock_shared();
+
+  // total time the calling thread has spent blocked on any of these mutexes
+  static std::chrono::steady_clock::duration threadWaitTime();
+
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_readersCv;
+  std::condition_variable m_writersCv;
+  std::thread::id m_writer;
+  size_t m_writerDepth;
+  size_t m_readers;
+  size_t m_waitingWriters;
+};
+
+template<class Mutex> class SharedLockGuard {
+public:
+  explicit SharedLockGuard(Mutex& mutex) : m_mutex(mutex) {
+    m_mutex.lock_shared();
+  }
+
+  ~SharedLockGuard() {
+    m_mutex.unlock_shared();
+  }
+
+  SharedLockGuard(const SharedLockGuard&) = delete;
+  SharedLockGuard& operator=(const SharedLockGuard&) = delete;
+
+private:
+  Mutex& m_mutex;
+};
+
+}
@@ -0,0 +1,122 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <set>
+
+namespace Common {
+
+// Median of a window of values that grows and shrinks at both ends, e.g. the
+// sizes of the last N blocks. Every update is O(log n) and median() is O(1);
+// the result is the same as medianValue() over the values of the window.
+template <class T>
+class SlidingMedian {
+public:
+  size_t size() const {
+    return m_values.size();
+  }
+
+  bool empty() const {
+    return m_values.empty();
+  }
+
+  void clear() {
+    m_values.clear();
+    m_lower.clear();
+    m_upper.clear();
+  }
+
+  void push_back(const T& value) {
+    m_values.push_back(value);
+    insert(value);
+  }
+
+  void push_front(const T& value) {
+    m_values.push_front(value);
+    insert(value);
+  }
+
+  void pop_back() {
+    erase(m_values.back());
+    m_values.pop_back();
+  }
+
+  void pop_front() {
+    erase(m_values.front());
+    m_values.pop_front();
+  }
+
+  T median() const {
+    if (m_values.empty()) {
+      return T();
+    }
+
+    if (m_values.size() % 2) {
+      return *m_lower.rbegin();
+    }
+
+    return (*m_lower.rbegin() + *m_upper.begin()) / 2;
+  }
+
+private:
+  std::deque<T> m_values;     // in window order
+  std::multiset<T> m_lower;   // the smallest (size + 1) / 2 values
+  std::multiset<T> m_upper;   // the rest
+
+  void insert(const T& value) {
+    if (m_lower.empty() || !(*m_lower.rbegin() < value)) {
+      m_lower.insert(value);
+    } else {
+      m_upper.insert(value);
+    }
+
+    rebalance();
+  }
+
+  void erase(const T& value) {
+    auto it = m_lower.find(value);
+    if (it != m_lower.end()) {
+      m_lower.erase(it);
+    } else {
+      m_upper.erase(m_upper.find(value));
+    }
+
+    rebalance();
+  }
+
+  void rebalance() {
+    size_t count = m_lower.size() + m_upper.size();
+    size_t lowerSize = (count + 1) / 2;
+    while (m_lower.size() > lowerSize) {
+      auto it = std::prev(m_lower.end());
+      m_upper.insert(*it);
+      m_lower.erase(it);
+    }
+
+    while (m_lower.size() < lowerSize) {
+      auto it = m_upper.begin();
+      m_lower.insert(*it);
+      m_upper.erase(it);
+    }
+  }
+};
+
+}
@@ -20,6 +20,14 @@
 #include <fstream>
 #include <iomanip>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STRING_TOOLS_HEX_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define STRING_TOOLS_HEX_NEON
+#include <arm_neon.h>
+#endif
+
 namespace Common {
 
 namespace {
@@ -85,8 +93,8 @@ size_t fromHex(const std::string& text, void* data, size_t bufferSize) {
     throw std::runtime_error("fromHex: invalid buffer size");
   }
 
-  for (size_t i = 0; i < text.size() >> 1; ++i) {
-    static_cast<uint8_t*>(data)[i] = fromHex(text[i << 1]) << 4 | fromHex(text[(i << 1) + 1]);
+  if (!decodeHex(text.data(), text.size() >> 1, data)) {
+    throw std::runtime_error("fromHex: invalid character");
   }
 
   return text.size() >> 1;
@@ -101,18 +109,8 @@ bool fromHex(const std::string& text, void* data, size_t bufferSize, size_t& siz
     return false;
   }
 
-  for (size_t i = 0; i < text.size() >> 1; ++i) {
-    uint8_t value1;
-    if (!fromHex(text[i << 1], value1)) {
-      return false;
-    }
-
-    uint8_t value2;
-    if (!fromHex(text[(i << 1) + 1], value2)) {
-      return false;
-    }
-
-    static_cast<uint8_t*>(data)[i] = value1 << 4 | value2;
+  if (!decodeHex(text.data(), text.size() >> 1, data)) {
+    return false;
   }
 
   size = text.size() >> 1;
@@ -125,8 +123,8 @@ std::vector<uint8_t> fromHex(const std::string& text) {
   }
 
   std::vector<uint8_t> data(text.size() >> 1);
-  for (size_t i = 0; i < data.size(); ++i) {
-    data[i] = fromHex(text[i << 1]) << 4 | fromHex(text[(i << 1) + 1]);
+  if (!decodeHex(text.data(), data.size(), data.data())) {
+    throw std::runtime_error("fromHex: invalid character");
   }
 
   return data;
@@ -137,55 +135,140 @@ bool fromHex(const std::string& text, std::vector<uint8_t>& data) {
     return false;
   }
 
-  for (size_t i = 0; i < text.size() >> 1; ++i) {
-    uint8_t value1;
-    if (!fromHex(text[i << 1], value1)) {
-      return false;
-    }
-
-    uint8_t value2;
-    if (!fromHex(text[(i << 1) + 1], value2)) {
-      return false;
-    }
-
-    data.push_back(value1 << 4 | value2);
+  size_t offset = data.size();
+  data.resize(offset + (text.size() >> 1));
+  if (!decodeHex(text.data(), text.size() >> 1, data.data() + offset)) {
+    data.resize(offset);
+    return false;
   }
 
   return true;
 }
 
 std::string toHex(const void* data, size_t size) {
-  std::string text;
-  for (size_t i = 0; i < size; ++i) {
-    text += "0123456789abcdef"[static_cast<const uint8_t*>(data)[i] >> 4];
-    text += "0123456789abcdef"[static_cast<const uint8_t*>(data)[i] & 15];
-  }
-
+  std::string text(size << 1, '\0');
+  encodeHex(data, size, &text[0]);
   return text;
 }
 
 void toHex(const void* data, size_t size, std::string& text) {
-  for (size_t i = 0; i < size; ++i) {
-    text += "0123456789abcdef"[static_cast<const uint8_t*>(data)[i] >> 4];
-    text += "0123456789abcdef"[static_cast<const uint8_t*>(data)[i] & 15];
-  }
+  size_t offset = text.size();
+  text.resize(offset + (size << 1));
+  encodeHex(data, size, &text[offset]);
 }
 
 std::string toHex(const std::vector<uint8_t>& data) {
-  std::string text;
-  for (size_t i = 0; i < data.size(); ++i) {
-    text += "0123456789abcdef"[data[i] >> 4];
-    text += "0123456789abcdef"[data[i] & 15];
+  return toHex(data.data(), data.size());
+}
+
+void toHex(const std::vector<uint8_t>& data, std::string& text) {
+  toHex(data.data(), data.size(), text);
+}
+
+void encodeHex(const void* data, size_t size, char* text) {
+  const uint8_t* input = static_cast<const uint8_t*>(data);
+  size_t i = 0;
+#if defined(STRING_TOOLS_HEX_SSE2)
+  const __m128i lowMask = _mm_set1_epi8(0x0f);
+  const __m128i nine = _mm_set1_epi8(9);
+  const __m128i zero = _mm_set1_epi8('0');
+  // distance from '9' + 1 to 'a'
+  const __m128i letterOffset = _mm_set1_epi8('a' - '0' - 10);
+  for (; i + 16 <= size; i += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+    __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), lowMask);
+    __m128i low = _mm_and_si128(bytes, lowMask);
+    high = _mm_add_epi8(_mm_add_epi8(high, zero), _mm_and_si128(_mm_cmpgt_epi8(high, nine), letterOffset));
+    low = _mm_add_epi8(_mm_add_epi8(low, zero), _mm_and_si128(_mm_cmpgt_epi8(low, nine), letterOffset));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(text + (i << 1)), _mm_unpacklo_epi8(high, low));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(text + (i << 1) + 16), _mm_unpackhi_epi8(high, low));
+  }
+#elif defined(STRING_TOOLS_HEX_NEON)
+  const uint8x16_t digits = vld1q_u8(reinterpret_cast<const uint8_t*>("0123456789abcdef"));
+  const uint8x16_t lowMask = vdupq_n_u8(0x0f);
+  for (; i + 16 <= size; i += 16) {
+    uint8x16_t bytes = vld1q_u8(input + i);
+    uint8x16x2_t characters;
+    characters.val[0] = vqtbl1q_u8(digits, vshrq_n_u8(bytes, 4));
+    characters.val[1] = vqtbl1q_u8(digits, vandq_u8(bytes, lowMask));
+    vst2q_u8(reinterpret_cast<uint8_t*>(text + (i << 1)), characters);
   }
+#endif
 
-  return text;
+  for (; i < size; ++i) {
+    text[i << 1] = "0123456789abcdef"[input[i] >> 4];
+    text[(i << 1) + 1] = "0123456789abcdef"[input[i] & 15];
+  }
 }
 
-void toHex(const std::vector<uint8_t>& data, std::string& text) {
-  for (size_t i = 0; i < data.size(); ++i) {
-    text += "0123456789abcdef"[data[i] >> 4];
-    text += "0123456789abcdef"[data[i] & 15];
+bool decodeHex(const char* text, size_t size, void* data) {
+  uint8_t* output = static_cast<uint8_t*>(data);
+  size_t i = 0;
+#if defined(STRING_TOOLS_HEX_SSE2)
+  const __m128i nine = _mm_set1_epi8(9);
+  const __m128i five = _mm_set1_epi8(5);
+  const __m128i zero = _mm_set1_epi8('0');
+  const __m128i a = _mm_set1_epi8('a');
+  const __m128i ten = _mm_set1_epi8(10);
+  const __m128i lowerCase = _mm_set1_epi8(0x20);
+  const __m128i byteMask = _mm_set1_epi16(0x00ff);
+  for (; i + 16 <= size; i += 16) {
+    __m128i values[2];
+    for (int half = 0; half < 2; ++half) {
+      __m128i characters = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + (i << 1) + (half << 4)));
+      // unsigned x <= n is min(x, n) == x
+      __m128i digit = _mm_sub_epi8(characters, zero);
+      __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, nine), digit);
+      __m128i letter = _mm_sub_epi8(_mm_or_si128(characters, lowerCase), a);
+      __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, five), letter);
+      if (_mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) != 0xffff) {
+        return false;
+      }
+
+      __m128i nibbles = _mm_or_si128(_mm_and_si128(isDigit, digit), _mm_and_si128(isLetter, _mm_add_epi8(letter, ten)));
+      // a 16 bit lane holds the high nibble in its low byte and the low nibble in its high byte
+      values[half] = _mm_and_si128(_mm_or_si128(_mm_slli_epi16(nibbles, 4), _mm_srli_epi16(nibbles, 8)), byteMask);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(values[0], values[1]));
   }
+#elif defined(STRING_TOOLS_HEX_NEON)
+  const uint8x16_t nine = vdupq_n_u8(9);
+  const uint8x16_t five = vdupq_n_u8(5);
+  const uint8x16_t zero = vdupq_n_u8('0');
+  const uint8x16_t a = vdupq_n_u8('a');
+  const uint8x16_t ten = vdupq_n_u8(10);
+  const uint8x16_t lowerCase = vdupq_n_u8(0x20);
+  for (; i + 16 <= size; i += 16) {
+    uint8x16x2_t characters = vld2q_u8(reinterpret_cast<const uint8_t*>(text + (i << 1)));
+    uint8x16_t nibbles[2];
+    for (int half = 0; half < 2; ++half) {
+      uint8x16_t digit = vsubq_u8(characters.val[half], zero);
+      uint8x16_t isDigit = vcleq_u8(digit, nine);
+      uint8x16_t letter = vsubq_u8(vorrq_u8(characters.val[half], lowerCase), a);
+      uint8x16_t isLetter = vcleq_u8(letter, five);
+      if (vminvq_u8(vorrq_u8(isDigit, isLetter)) != 0xff) {
+        return false;
+      }
+
+      nibbles[half] = vorrq_u8(vandq_u8(isDigit, digit), vandq_u8(isLetter, vaddq_u8(letter, ten)));
+    }
+
+    vst1q_u8(output + i, vorrq_u8(vshlq_n_u8(nibbles[0], 4), nibbles[1]));
+  }
+#endif
+
+  for (; i < size; ++i) {
+    uint8_t high = characterValues[static_cast<unsigned char>(text[i << 1])];
+    uint8_t low = characterValues[static_cast<unsigned char>(text[(i << 1) + 1])];
+    if ((high | low) > 0x0f) {
+      return false;
+    }
+
+    output[i] = high << 4 | low;
+  }
+
+  return true;
 }
 
 std::string extract(std::string& text, char delimiter) {
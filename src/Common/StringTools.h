@@ -47,6 +47,10 @@ void toHex(const void* data, size_t size, std::string& text); // Appends hex rep
 std::string toHex(const std::vector<uint8_t>& data); // Returns hex representation of 'data', does not throw
 void toHex(const std::vector<uint8_t>& data, std::string& text); // Appends hex representation of 'data' to 'text', does not throw
 
+// Vectorized with SSE2 on x86 and NEON on ARM64, the baseline instruction sets of these targets, with a table driven fallback elsewhere
+void encodeHex(const void* data, size_t size, char* text); // Writes hex representation of ('data', 'size') to 2 * 'size' characters of 'text', does not throw
+bool decodeHex(const char* text, size_t size, void* data); // Writes values of 2 * 'size' hex characters of 'text' to 'size' bytes of 'data', returns false on error, does not throw
+
 template<class T>
 std::string podToHex(const T& s) {
   return toHex(&s, sizeof(s));
@@ -0,0 +1,128 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Tracing.h"
+
+#include <fstream>
+
+namespace Common {
+
+namespace {
+
+uint32_t currentThreadNumber() {
+  static std::atomic<uint32_t> threadCount(0);
+  static thread_local uint32_t threadNumber = ++threadCount;
+  return threadNumber;
+}
+
+}
+
+Tracer::Tracer() : m_enabled(false), m_origin(std::chrono::steady_clock::now().time_since_epoch().count()), m_next(0), m_maxEvents(DEFAULT_MAX_EVENTS) {
+}
+
+Tracer& Tracer::instance() {
+  static Tracer tracer;
+  return tracer;
+}
+
+void Tracer::start(size_t maxEvents) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_events.clear();
+  m_events.shrink_to_fit();
+  m_next = 0;
+  m_maxEvents = maxEvents == 0 ? 1 : maxEvents;
+  m_origin = std::chrono::steady_clock::now().time_since_epoch().count();
+  m_enabled = true;
+}
+
+void Tracer::stop() {
+  m_enabled = false;
+}
+
+size_t Tracer::eventCount() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_events.size();
+}
+
+uint64_t Tracer::now() const {
+  std::chrono::steady_clock::duration sinceStart(std::chrono::steady_clock::now().time_since_epoch().count() - m_origin);
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(sinceStart).count());
+}
+
+void Tracer::record(Event&& event) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_events.size() < m_maxEvents) {
+    m_events.push_back(std::move(event));
+  } else {
+    m_events[m_next] = std::move(event);
+    m_next = (m_next + 1) % m_maxEvents;
+  }
+}
+
+void Tracer::writeJson(std::ostream& out) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  for (size_t i = 0; i < m_events.size(); ++i) {
+    const Event& event = m_events[(m_next + i) % m_events.size()];
+    out << (i == 0 ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"ts\":" <<
+      event.start << ",\"dur\":" << event.duration << ",\"pid\":1,\"tid\":" << event.thread;
+    if (!event.id.empty()) {
+      out << ",\"args\":{\"id\":\"" << event.id << "\"}";
+    }
+
+    out << '}';
+  }
+
+  out << "\n]}\n";
+}
+
+bool Tracer::writeJson(const std::string& path) const {
+  std::ofstream file(path, std::ios::out | std::ios::trunc);
+  if (!file) {
+    return false;
+  }
+
+  writeJson(file);
+  file.close();
+  return !file.fail();
+}
+
+TraceSpan::TraceSpan(const char* category, const char* name) : m_category(category), m_name(name), m_start(0),
+  m_active(Tracer::instance().enabled()) {
+  if (m_active) {
+    m_start = Tracer::instance().now();
+  }
+}
+
+TraceSpan::~TraceSpan() {
+  Tracer& tracer = Tracer::instance();
+  if (m_active && tracer.enabled()) {
+    uint64_t end = tracer.now();
+    // a span started before a restart of the tracer would have a bogus start time
+    if (end >= m_start) {
+      tracer.record(Tracer::Event{ m_category, m_name, std::move(m_id), m_start, end - m_start, currentThreadNumber() });
+    }
+  }
+}
+
+void TraceSpan::setId(uint64_t id) {
+  if (m_active) {
+    m_id = std::to_string(id);
+  }
+}
+
+}
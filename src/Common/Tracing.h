@@ -0,0 +1,103 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "StringTools.h"
+
+namespace Common {
+
+// Collects the spans of TraceSpan while started, keeping the most recent ones, and writes
+// them in the Chrome trace event format (chrome://tracing, ui.perfetto.dev).
+class Tracer {
+public:
+  static const size_t DEFAULT_MAX_EVENTS = 100000;
+
+  static Tracer& instance();
+
+  // clears the collected spans
+  void start(size_t maxEvents = DEFAULT_MAX_EVENTS);
+  void stop();
+  bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+  size_t eventCount() const;
+
+  void writeJson(std::ostream& out) const;
+  // false if the file can't be written
+  bool writeJson(const std::string& path) const;
+
+private:
+  friend class TraceSpan;
+
+  struct Event {
+    const char* category;
+    const char* name;
+    std::string id;
+    uint64_t start; // microseconds since start()
+    uint64_t duration;
+    uint32_t thread;
+  };
+
+  Tracer();
+  uint64_t now() const;
+  void record(Event&& event);
+
+  std::atomic<bool> m_enabled;
+  std::atomic<std::chrono::steady_clock::rep> m_origin;
+  mutable std::mutex m_mutex;
+  std::vector<Event> m_events; // ring buffer, m_next is the oldest once it is full
+  size_t m_next;
+  size_t m_maxEvents;
+};
+
+// Records the time from its construction to its destruction if the tracer is enabled,
+// otherwise costs a relaxed atomic load. Category and name must be string literals.
+class TraceSpan {
+public:
+  TraceSpan(const char* category, const char* name);
+  template<class T> TraceSpan(const char* category, const char* name, const T& podId) : TraceSpan(category, name) {
+    setPodId(podId);
+  }
+
+  ~TraceSpan();
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+  // ids are formatted only while the span is recorded
+  template<class T> void setPodId(const T& id) {
+    if (m_active) {
+      m_id = podToHex(id);
+    }
+  }
+
+  void setId(uint64_t id);
+
+private:
+  const char* m_category;
+  const char* m_name;
+  std::string m_id;
+  uint64_t m_start;
+  bool m_active;
+};
+
+}
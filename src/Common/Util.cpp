@@ -16,7 +16,10 @@
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Util.h"
+#include <algorithm>
 #include <cstdio>
+#include <stdexcept>
+#include <thread>
 
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
@@ -31,6 +34,11 @@
 #include <sys/utsname.h>
 #endif
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 
 namespace Tools
 {
@@ -382,4 +390,87 @@ std::string get_nix_version_display_string()
     return boost::filesystem::is_directory(path, ec);
   }
 
+  bool setCurrentThreadAffinity(size_t cpuIndex) {
+    unsigned cpuCount = std::thread::hardware_concurrency();
+    if (cpuCount == 0) {
+      return false;
+    }
+
+    cpuIndex %= cpuCount;
+#if defined(WIN32)
+    if (cpuIndex >= sizeof(DWORD_PTR) * 8) {
+      return false;
+    }
+
+    return ::SetThreadAffinityMask(::GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpuIndex) != 0;
+#elif defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpuIndex, &cpuSet);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#else
+    return false;
+#endif
+  }
+
+  bool setCurrentThreadAffinity(const std::vector<unsigned>& cpus) {
+    if (cpus.empty()) {
+      return true;
+    }
+#if defined(WIN32)
+    DWORD_PTR mask = 0;
+    for (unsigned cpu : cpus) {
+      if (cpu < sizeof(DWORD_PTR) * 8) {
+        mask |= static_cast<DWORD_PTR>(1) << cpu;
+      }
+    }
+
+    return mask != 0 && ::SetThreadAffinityMask(::GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (unsigned cpu : cpus) {
+      if (cpu < CPU_SETSIZE) {
+        CPU_SET(cpu, &cpuSet);
+      }
+    }
+
+    return CPU_COUNT(&cpuSet) != 0 && pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#else
+    return false;
+#endif
+  }
+
+  std::vector<unsigned> parseCpuList(const std::string& text) {
+    std::vector<unsigned> cpus;
+    std::vector<std::string> ranges;
+    boost::split(ranges, text, boost::is_any_of(","));
+    for (std::string range : ranges) {
+      boost::trim(range);
+      if (range.empty()) {
+        continue;
+      }
+
+      size_t dash = range.find('-');
+      std::string firstText = range.substr(0, dash);
+      std::string lastText = dash == std::string::npos ? firstText : range.substr(dash + 1);
+      auto isIndex = [](const std::string& value) {
+        return !value.empty() && value.size() <= 4 && value.find_first_not_of("0123456789") == std::string::npos;
+      };
+
+      if (!isIndex(firstText) || !isIndex(lastText) || std::stoul(lastText) < std::stoul(firstText)) {
+        throw std::runtime_error("Invalid CPU list \"" + text + "\", expected e.g. 0-3,8");
+      }
+
+      unsigned last = static_cast<unsigned>(std::stoul(lastText));
+      for (unsigned cpu = static_cast<unsigned>(std::stoul(firstText)); cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    }
+
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+  }
+
 }
@@ -17,8 +17,10 @@
 
 #pragma once 
 
+#include <cstddef>
 #include <string>
 #include <system_error>
+#include <vector>
 
 namespace Tools
 {
@@ -27,4 +29,12 @@ namespace Tools
   bool create_directories_if_necessary(const std::string& path);
   std::error_code replace_file(const std::string& replacement_name, const std::string& replaced_name);
   bool directoryExists(const std::string& path);
+  // Pins the calling thread to one CPU, cpuIndex is wrapped to the number of
+  // available CPUs. Returns false where pinning is unsupported or fails.
+  bool setCurrentThreadAffinity(size_t cpuIndex);
+  // Pins the calling thread to a set of CPUs, an empty set leaves it as it is.
+  // Threads started afterwards by the calling thread inherit the set.
+  bool setCurrentThreadAffinity(const std::vector<unsigned>& cpus);
+  // Parses a CPU list like "0-3,8,10-11", throws std::runtime_error when malformed
+  std::vector<unsigned> parseCpuList(const std::string& text);
 }
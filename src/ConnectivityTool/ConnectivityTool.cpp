@@ -15,6 +15,11 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <map>
+
 #include <boost/optional.hpp>
 #include <boost/program_options.hpp>
 
@@ -32,8 +37,11 @@
 #include "Common/CommandLine.h"
 #include "Common/StringTools.h"
 #include "crypto/crypto.h"
+#include "crypto/random.h"
+#include "P2p/P2pNetworks.h"
 #include "P2p/P2pProtocolDefinitions.h"
 #include "P2p/LevinProtocol.h"
+#include "P2p/NetworkCrawlReport.h"
 #include "Rpc/CoreRpcServerCommandsDefinitions.h"
 #include "Rpc/HttpClient.h"
 #include "Serialization/SerializationTools.h"
@@ -56,7 +64,11 @@ namespace {
   const command_line::arg_descriptor<bool>        arg_generate_keys      = {"generate_keys_pair", "generate private and public keys pair"};
   const command_line::arg_descriptor<bool>        arg_request_stat_info  = {"request_stat_info", "request statistics information"};
   const command_line::arg_descriptor<bool>        arg_request_net_state  = {"request_net_state", "request network state information (peer list, connections count)"};
-  const command_line::arg_descriptor<bool>        arg_get_daemon_info    = {"rpc_get_daemon_info", "request daemon state info vie rpc (--rpc_port option should be set ).", "", true};
+  const command_line::arg_descriptor<bool>        arg_get_daemon_info    = {"rpc_get_daemon_info", "request daemon state info vie rpc (--rpc_port option should be set ).", false, true};
+  const command_line::arg_descriptor<bool>        arg_crawl              = {"crawl", "walk the peer lists of the network starting from --ip:--port, print the topology and statistics as JSON"};
+  const command_line::arg_descriptor<uint32_t>    arg_crawl_connections  = {"crawl_connections", "number of nodes crawled at once", 256};
+  const command_line::arg_descriptor<uint32_t>    arg_crawl_max_nodes    = {"crawl_max_nodes", "stop discovering nodes after this many", 10000};
+  const command_line::arg_descriptor<bool>        arg_testnet            = {"testnet", "crawl the testnet"};
 }
 
 struct response_schema {
@@ -193,7 +205,7 @@ bool handle_get_daemon_info(po::variables_map& vm) {
 
   try {
     System::Dispatcher dispatcher;
-    HttpClient httpClient(dispatcher, command_line::get_arg(vm, arg_ip), command_line::get_arg(vm, arg_rpc_port));
+    HttpClient httpClient(dispatcher, command_line::get_arg(vm, arg_ip), command_line::get_arg(vm, arg_rpc_port), false);
 
     CryptoNote::COMMAND_RPC_GET_INFO::request req;
     CryptoNote::COMMAND_RPC_GET_INFO::response res;
@@ -203,8 +215,8 @@ bool handle_get_daemon_info(po::variables_map& vm) {
     std::cout << "OK" << ENDL
       << "height: " << res.height << ENDL
       << "difficulty: " << res.difficulty << ENDL
-      << "transactions_count: " << res.tx_count << ENDL
-      << "transactions_pool_size: " << res.tx_pool_size << ENDL
+      << "transactions_count: " << res.transactions_count << ENDL
+      << "transactions_pool_size: " << res.transactions_pool_size << ENDL
       << "alt_blocks_count: " << res.alt_blocks_count << ENDL
       << "outgoing_connections_count: " << res.outgoing_connections_count << ENDL
       << "incoming_connections_count: " << res.incoming_connections_count << ENDL
@@ -321,6 +333,190 @@ bool handle_request_stat(po::variables_map& vm, PeerIdType peer_id) {
   return true;
 }
 
+//---------------------------------------------------------------------------------------------------------------
+// Visits the nodes found in peer lists breadth first, a handshake each. All
+// connections are contexts of one dispatcher: the crawl waits on the network,
+// so hundreds of them in flight don't need more than one thread.
+class NetworkCrawler {
+public:
+  NetworkCrawler(System::Dispatcher& dispatcher, const uuid& networkId, unsigned timeout, size_t connections, size_t maxNodes) :
+    m_dispatcher(dispatcher), m_networkId(networkId), m_timeout(timeout), m_connections(std::max<size_t>(connections, 1)),
+    m_maxNodes(maxNodes), m_queueChanged(dispatcher), m_busy(0), m_done(false) {
+    m_syncData.current_height = 0;
+    m_syncData.top_id = NULL_HASH;
+    m_peerId = Random::randomValue<uint64_t>();
+  }
+
+  void crawl(const NetworkAddress& seed) {
+    enqueue(seed);
+
+    System::ContextGroup workers(m_dispatcher);
+    for (size_t i = 0; i < m_connections; ++i) {
+      workers.spawn([this] { work(); });
+    }
+
+    workers.wait();
+  }
+
+  CrawlReport report() const {
+    return makeCrawlReport(m_nodes);
+  }
+
+private:
+  // the seed may be a local node, addresses from peer lists must be public
+  void discover(const NetworkAddress& address) {
+    System::Ipv4Address ip(networkToHost(address.ip));
+    if (!ip.isLoopback() && !ip.isPrivate()) {
+      enqueue(address);
+    }
+  }
+
+  void enqueue(const NetworkAddress& address) {
+    if (m_known.size() >= m_maxNodes || address.port == 0 || m_known.count(address) != 0) {
+      return;
+    }
+
+    m_known.emplace(address, m_nodes.size());
+    m_queue.push_back(m_nodes.size());
+    m_nodes.emplace_back();
+    m_nodes.back().address = address;
+  }
+
+  void work() {
+    for (;;) {
+      if (m_done) {
+        return;
+      }
+
+      if (m_queue.empty()) {
+        if (m_busy == 0) {
+          m_done = true;
+          m_queueChanged.set();
+          return;
+        }
+
+        m_queueChanged.clear();
+        m_queueChanged.wait();
+        continue;
+      }
+
+      size_t index = m_queue.front();
+      m_queue.pop_front();
+      ++m_busy;
+      CrawledNode node = m_nodes[index];
+      visit(node);
+      m_nodes[index] = node;
+      for (const NetworkAddress& peer : node.peers) {
+        discover(peer);
+      }
+
+      --m_busy;
+      m_queueChanged.set();
+    }
+  }
+
+  // m_nodes may grow while this waits on the network, so it works on a copy
+  void visit(CrawledNode& node) {
+    try {
+      auto start = std::chrono::steady_clock::now();
+      System::TcpConnection connection;
+      withTimeout(m_dispatcher, m_timeout, [&] {
+        System::TcpConnector connector(m_dispatcher);
+        connection = connector.connect(System::Ipv4Address(Common::ipAddressToString(node.address.ip)), static_cast<uint16_t>(node.address.port));
+      });
+
+      auto connected = std::chrono::steady_clock::now();
+      node.connectMs = std::chrono::duration_cast<std::chrono::milliseconds>(connected - start).count();
+
+      COMMAND_HANDSHAKE::request req;
+      req.node_data.network_id = m_networkId;
+      req.node_data.version = P2P_CURRENT_VERSION;
+      req.node_data.local_time = time(nullptr);
+      req.node_data.my_port = 0;
+      req.node_data.peer_id = m_peerId;
+      req.payload_data = m_syncData;
+
+      COMMAND_HANDSHAKE::response rsp;
+      bool invoked = false;
+      withTimeout(m_dispatcher, m_timeout, [&] {
+        LevinProtocol levin(connection);
+        invoked = levin.invoke(COMMAND_HANDSHAKE::ID, req, rsp);
+      });
+
+      node.handshakeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - connected).count();
+      if (!invoked) {
+        node.status = "ERROR: handshake rejected";
+        return;
+      }
+
+      if (rsp.node_data.network_id != m_networkId) {
+        node.status = "ERROR: wrong network";
+        return;
+      }
+
+      node.status = "OK";
+      node.peerId = rsp.node_data.peer_id;
+      node.version = rsp.node_data.version;
+      node.height = rsp.payload_data.current_height;
+      node.topId = rsp.payload_data.top_id;
+      for (const PeerlistEntry& peer : rsp.local_peerlist) {
+        node.peers.push_back(peer.adr);
+      }
+
+      // Present the highest chain seen so far: nodes which have it or are
+      // behind it accept the handshake, while a height far below theirs
+      // would count as a failure against this host.
+      if (node.height > m_syncData.current_height) {
+        m_syncData = rsp.payload_data;
+      }
+    } catch (const std::exception& e) {
+      node.status = std::string("ERROR: ") + e.what();
+    }
+  }
+
+  System::Dispatcher& m_dispatcher;
+  const uuid m_networkId;
+  const unsigned m_timeout;
+  const size_t m_connections;
+  const size_t m_maxNodes;
+  PeerIdType m_peerId;
+  CORE_SYNC_DATA m_syncData;
+
+  std::vector<CrawledNode> m_nodes;
+  std::map<NetworkAddress, size_t> m_known;
+  std::deque<size_t> m_queue;
+  System::Event m_queueChanged;
+  size_t m_busy;
+  bool m_done;
+};
+
+bool handle_crawl(po::variables_map& vm) {
+  try {
+    System::Dispatcher dispatcher;
+    System::Ipv4Resolver resolver(dispatcher);
+    auto addr = resolver.resolve(command_line::get_arg(vm, arg_ip));
+    NetworkAddress seed{ hostToNetwork(addr.getValue()), command_line::get_arg(vm, arg_port) };
+    if (seed.port == 0) {
+      seed.port = P2P_DEFAULT_PORT;
+    }
+
+    uuid networkId = BYTECOIN_NETWORK;
+    if (command_line::get_arg(vm, arg_testnet)) {
+      networkId.data[0] += 1;
+    }
+
+    NetworkCrawler crawler(dispatcher, networkId, command_line::get_arg(vm, arg_timeout),
+      command_line::get_arg(vm, arg_crawl_connections), command_line::get_arg(vm, arg_crawl_max_nodes));
+    crawler.crawl(seed);
+    std::cout << storeToJson(crawler.report()) << ENDL;
+  } catch (const std::exception& e) {
+    std::cout << "ERROR: " << e.what() << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
 //---------------------------------------------------------------------------------------------------------------
 bool generate_and_print_keys() {
   Crypto::PublicKey pk;
@@ -347,6 +543,10 @@ int main(int argc, char *argv[]) {
   command_line::add_arg(desc_params, arg_peer_id);
   command_line::add_arg(desc_params, arg_priv_key);
   command_line::add_arg(desc_params, arg_get_daemon_info);
+  command_line::add_arg(desc_params, arg_crawl);
+  command_line::add_arg(desc_params, arg_crawl_connections);
+  command_line::add_arg(desc_params, arg_crawl_max_nodes);
+  command_line::add_arg(desc_params, arg_testnet);
 
   po::options_description desc_all;
   desc_all.add(desc_general).add(desc_params);
@@ -373,6 +573,10 @@ int main(int argc, char *argv[]) {
     return handle_request_stat(vm, command_line::get_arg(vm, arg_peer_id)) ? 0 : 1;
   }
   
+  if (command_line::get_arg(vm, arg_crawl)) {
+    return handle_crawl(vm) ? 0 : 1;
+  }
+
   if (command_line::has_arg(vm, arg_get_daemon_info)) {
     return handle_get_daemon_info(vm) ? 0 : 1;
   } 
@@ -74,7 +74,10 @@ const uint64_t MAX_TRANSACTION_SIZE_LIMIT                    = CRYPTONOTE_BLOCK_
 
 const size_t   DANDELION_EPOCH                               = 600;
 const size_t   DANDELION_STEMS                               = 2;
-const size_t   DANDELION_STEM_EMBARGO                        = 173;
+const size_t   DANDELION_STEM_EMBARGO                        = 173;           // seconds at most before a stem transaction is fluffed
+const size_t   DANDELION_STEM_EMBARGO_AVERAGE                = 39;            // mean of the exponentially distributed embargoes
+const size_t   DANDELION_STEM_POOL_MAX_COUNT                 = 5000;
+const size_t   DANDELION_STEM_POOL_MAX_SIZE                  = 16 * 1024 * 1024; // bytes of transaction blobs
 const uint8_t  DANDELION_STEM_TX_PROPAGATION_PROBABILITY     = 90;
 
 const size_t   DIFFICULTY_WINDOW                             = EXPECTED_NUMBER_OF_BLOCKS_PER_DAY; // blocks
@@ -99,6 +102,7 @@ const uint64_t CRYPTONOTE_LOCKED_TX_ALLOWED_DELTA_SECONDS    = DIFFICULTY_TARGET
 const uint64_t CRYPTONOTE_MEMPOOL_TX_LIVETIME                = 60 * 60 * 24;     //seconds, one day
 const uint64_t CRYPTONOTE_MEMPOOL_TX_FROM_ALT_BLOCK_LIVETIME = 60 * 60 * 24 * 7; //seconds, one week
 const uint64_t CRYPTONOTE_NUMBER_OF_PERIODS_TO_FORGET_TX_DELETED_FROM_POOL = 7;  // CRYPTONOTE_NUMBER_OF_PERIODS_TO_FORGET_TX_DELETED_FROM_POOL * CRYPTONOTE_MEMPOOL_TX_LIVETIME = time to forget tx
+const uint64_t CRYPTONOTE_MEMPOOL_DEFAULT_MAX_SIZE            = 100 * 1024 * 1024; //bytes
 
 const size_t   FUSION_TX_MAX_SIZE                            = CRYPTONOTE_BLOCK_GRANTED_FULL_REWARD_ZONE_V1 * 30 / 100;
 const size_t   FUSION_TX_MIN_INPUT_COUNT                     = 12;
@@ -120,7 +124,11 @@ static_assert(UPGRADE_VOTING_WINDOW > 1, "Bad UPGRADE_VOTING_WINDOW");
 
 const char     CRYPTONOTE_BLOCKS_FILENAME[]                  = "blocks.dat";
 const char     CRYPTONOTE_BLOCKINDEXES_FILENAME[]            = "blockindexes.dat";
+const char     CRYPTONOTE_BLOCKSTORE_FILENAME[]              = "blockstore.dat";
 const char     CRYPTONOTE_BLOCKSCACHE_FILENAME[]             = "blockscache.dat";
+const uint32_t CRYPTONOTE_BLOCKSCACHE_SNAPSHOT_INTERVAL      = 10000; // max blocks replayed on start on top of the saved cache
+const uint32_t CRYPTONOTE_LITE_BLOCKS_CACHE_DEPTH            = EXPECTED_NUMBER_OF_BLOCKS_PER_DAY; // recent blocks whose lite entries are cached for wallets
+const size_t   CRYPTONOTE_LITE_BLOCKS_CACHE_SIZE             = 64 * 1024 * 1024; // bytes
 const char     CRYPTONOTE_POOLDATA_FILENAME[]                = "poolstate.bin";
 const char     P2P_NET_DATA_FILENAME[]                       = "p2pstate.bin";
 const char     CRYPTONOTE_BLOCKCHAIN_INDICES_FILENAME[]      = "blockchainindices.dat";
@@ -130,6 +138,8 @@ const char     MINER_CONFIG_FILE_NAME[]                      = "miner_conf.json"
 const char     CRYPTONOTE_NAME[]                             = "karbowanec";
 const char     GENESIS_COINBASE_TX_HEX[]                     = "010a01ff0001fac484c69cd608029b2e4c0281c0b02e7c53291a94d1d0cbff8883f8024f5142ee494ffbbd0880712101f904925cc23f86f9f3565188862275dc556a9bdfb6aec22c5aca7f0177c45ba8";
 const char     DNS_CHECKPOINTS_HOST[]                        = "checkpoints.karbo.org";
+const uint32_t DNS_CHECKPOINTS_TIMEOUT                       = 5;   // seconds to wait for the records at startup
+const uint32_t DNS_CHECKPOINTS_REFRESH_INTERVAL              = 600; // seconds the fetched records are reused
 
 const uint8_t  CURRENT_TRANSACTION_VERSION                   =  1;
 const uint8_t  BLOCK_MAJOR_VERSION_1                         =  1;
@@ -142,6 +152,11 @@ const uint8_t  BLOCK_MINOR_VERSION_1                         =  1;
 
 const size_t   BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT        =  10000;  //by default, blocks ids count in synchronizing
 const size_t   BLOCKS_SYNCHRONIZING_DEFAULT_COUNT            =  128;    //by default, blocks count in blocks downloading
+const size_t   BLOCKS_FILTERED_SYNCHRONIZING_COUNT           =  1000;   //blocks scanned for a wallet in one filtered query
+const size_t   BLOCK_FILTERS_MAX_COUNT                       =  1000;   //compact block filters in one query
+const size_t   TRANSACTIONS_OUTPUT_INDEXES_MAX_COUNT         =  1000;   //transactions in one global output indexes query
+const size_t   TIMESTAMPS_HEIGHTS_MAX_COUNT                  =  1000;   //timestamps in one heights by timestamps query
+const size_t   BLOCK_FILTER_HEADERS_MAX_COUNT                =  10000;  //compact block filter headers in one query
 const size_t   COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT         =  1000;
 
 const int      P2P_DEFAULT_PORT                              =  32347;
@@ -164,7 +179,9 @@ const uint8_t  P2P_VERSION_1                                 = 1;
 const uint8_t  P2P_VERSION_2                                 = 2;
 const uint8_t  P2P_VERSION_3                                 = 3;
 const uint8_t  P2P_VERSION_4                                 = 4;
-const uint8_t  P2P_CURRENT_VERSION                           = P2P_VERSION_4;
+const uint8_t  P2P_VERSION_5                                 = 5;
+const uint8_t  P2P_VERSION_6                                 = 6;
+const uint8_t  P2P_CURRENT_VERSION                           = P2P_VERSION_6;
 const uint8_t  P2P_MINIMUM_VERSION                           = 1;
 
 // This defines the number of versions ahead we must see peers before
@@ -174,7 +191,18 @@ const uint8_t  P2P_UPGRADE_WINDOW                            = 2;
 // This defines the minimum P2P version required for lite blocks propogation
 const uint8_t  P2P_LITE_BLOCKS_PROPOGATION_VERSION           = 3;
 
+// This defines the minimum P2P version required for compact blocks propogation
+const uint8_t  P2P_COMPACT_BLOCKS_PROPOGATION_VERSION        = 5;
+
+// This defines the minimum P2P version required for announcing transactions by hash
+const uint8_t  P2P_TX_INVENTORY_VERSION                      = 6;
+const uint32_t P2P_TX_INVENTORY_INTERVAL                     = 1;             // seconds between announcements
+
+// This defines the minimum P2P version required for checking block headers before downloading the blocks
+const uint8_t  P2P_HEADERS_SYNC_VERSION                      = 6;
+
 const size_t   P2P_CONNECTION_MAX_WRITE_BUFFER_SIZE          = 64 * 1024 * 1024; // 64 MB
+const size_t   P2P_CONNECTION_WRITE_HIGH_WATER_MARK          = 256 * 1024;       // 256 KB per gathered write
 const uint32_t P2P_DEFAULT_CONNECTIONS_COUNT                 = 12;
 const size_t   P2P_DEFAULT_ANCHOR_CONNECTIONS_COUNT          = 2;
 const size_t   P2P_DEFAULT_WHITELIST_CONNECTIONS_PERCENT     = 70;
@@ -0,0 +1,223 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "BlockFilter.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Common/int-util.h"
+#include "Common/Varint.h"
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+#include "TransactionExtra.h"
+
+namespace CryptoNote {
+
+namespace {
+
+class BitWriter {
+public:
+  explicit BitWriter(std::string& out) : m_out(out), m_bits(0) {
+  }
+
+  void write(uint64_t value, uint8_t count) {
+    while (count > 0) {
+      if (m_bits % 8 == 0) {
+        m_out.push_back(0);
+      }
+
+      uint8_t free = static_cast<uint8_t>(8 - m_bits % 8);
+      uint8_t take = std::min(free, count);
+      uint8_t chunk = static_cast<uint8_t>((value >> (count - take)) & ((1u << take) - 1));
+      m_out.back() = static_cast<char>(static_cast<uint8_t>(m_out.back()) | (chunk << (free - take)));
+      count -= take;
+      m_bits += take;
+    }
+  }
+
+private:
+  std::string& m_out;
+  uint64_t m_bits;
+};
+
+class BitReader {
+public:
+  BitReader(const std::string& data, size_t offset) : m_data(data), m_position(offset * 8) {
+  }
+
+  bool read(uint8_t count, uint64_t& value) {
+    if (m_position + count > m_data.size() * 8) {
+      return false;
+    }
+
+    value = 0;
+    for (uint8_t i = 0; i < count; ++i, ++m_position) {
+      uint8_t byte = static_cast<uint8_t>(m_data[m_position / 8]);
+      value = (value << 1) | ((byte >> (7 - m_position % 8)) & 1);
+    }
+
+    return true;
+  }
+
+private:
+  const std::string& m_data;
+  uint64_t m_position;
+};
+
+// maps the item uniformly to [0, range)
+uint64_t hashItem(const Crypto::Hash& blockHash, const Crypto::Hash& item, uint64_t range) {
+  uint8_t data[2 * sizeof(Crypto::Hash)];
+  memcpy(data, blockHash.data, sizeof(blockHash.data));
+  memcpy(data + sizeof(blockHash.data), item.data, sizeof(item.data));
+  Crypto::Hash h = Crypto::cn_fast_hash(data, sizeof(data));
+
+  uint64_t value;
+  memcpy(&value, h.data, sizeof(value));
+  uint64_t high;
+  mul128(SWAP64LE(value), range, &high);
+  return high;
+}
+
+std::vector<uint64_t> hashItems(const Crypto::Hash& blockHash, const std::vector<Crypto::Hash>& items, uint64_t count) {
+  std::vector<uint64_t> values;
+  values.reserve(items.size());
+  for (const auto& item : items) {
+    values.push_back(hashItem(blockHash, item, count * BlockFilter::FALSE_POSITIVE_RATE));
+  }
+
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+  return values;
+}
+
+}
+
+std::vector<Crypto::Hash> BlockFilter::transactionItems(const TransactionPrefix& transaction) {
+  std::vector<Crypto::Hash> items;
+
+  Crypto::PublicKey publicKey = getTransactionPublicKeyFromExtra(transaction.extra);
+  if (publicKey != Crypto::PublicKey()) {
+    items.push_back(reinterpret_cast<const Crypto::Hash&>(publicKey));
+  }
+
+  Crypto::Hash paymentId;
+  if (getPaymentIdFromTxExtra(transaction.extra, paymentId)) {
+    items.push_back(paymentId);
+  }
+
+  return items;
+}
+
+std::string BlockFilter::build(const Crypto::Hash& blockHash, const std::vector<Crypto::Hash>& items) {
+  std::vector<Crypto::Hash> unique(items);
+  std::sort(unique.begin(), unique.end(), [](const Crypto::Hash& a, const Crypto::Hash& b) {
+    return memcmp(a.data, b.data, sizeof(a.data)) < 0;
+  });
+  unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+
+  std::string filter;
+  uint64_t count = unique.size();
+  Tools::write_varint(std::back_inserter(filter), count);
+  if (count == 0) {
+    return filter;
+  }
+
+  BitWriter writer(filter);
+  uint64_t previous = 0;
+  for (uint64_t value : hashItems(blockHash, unique, count)) {
+    uint64_t delta = value - previous;
+    previous = value;
+
+    for (uint64_t q = delta >> GOLOMB_BITS; q > 0; --q) {
+      writer.write(1, 1);
+    }
+
+    writer.write(0, 1);
+    writer.write(delta, GOLOMB_BITS);
+  }
+
+  return filter;
+}
+
+bool BlockFilter::matchAny(const Crypto::Hash& blockHash, const std::string& filter, const std::vector<Crypto::Hash>& items) {
+  uint64_t count;
+  int read = Tools::read_varint(filter.begin(), filter.end(), count);
+  if (read <= 0) {
+    return true;
+  }
+
+  if (count == 0 || items.empty()) {
+    return false;
+  }
+
+  if (count > filter.size() * 8) {
+    return true;
+  }
+
+  std::vector<uint64_t> queries = hashItems(blockHash, items, count);
+  BitReader reader(filter, static_cast<size_t>(read));
+  auto query = queries.begin();
+  uint64_t value = 0;
+
+  for (uint64_t i = 0; i < count; ++i) {
+    // fewer values than count are coded when some collided, the padding then ends the filter
+    uint64_t quotient = 0;
+    uint64_t bit;
+    for (;;) {
+      if (!reader.read(1, bit)) {
+        return false;
+      }
+
+      if (bit == 0) {
+        break;
+      }
+
+      ++quotient;
+    }
+
+    uint64_t remainder;
+    if (!reader.read(GOLOMB_BITS, remainder)) {
+      return false;
+    }
+
+    value += (quotient << GOLOMB_BITS) | remainder;
+    while (*query < value) {
+      if (++query == queries.end()) {
+        return false;
+      }
+    }
+
+    if (*query == value) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+Crypto::Hash BlockFilter::header(const std::string& filter, const Crypto::Hash& previousHeader) {
+  Crypto::Hash filterHash = Crypto::cn_fast_hash(filter.data(), filter.size());
+
+  uint8_t data[2 * sizeof(Crypto::Hash)];
+  memcpy(data, filterHash.data, sizeof(filterHash.data));
+  memcpy(data + sizeof(filterHash.data), previousHeader.data, sizeof(previousHeader.data));
+  return Crypto::cn_fast_hash(data, sizeof(data));
+}
+
+}
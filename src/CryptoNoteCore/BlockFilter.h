@@ -0,0 +1,47 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CryptoNote.h"
+
+namespace CryptoNote {
+
+// Compact filter of a block: a Golomb-Rice coded set of the public keys and payment ids
+// of its transactions, coinbase included. A client that watches known payment ids or
+// transaction keys downloads the filters and skips the blocks they rule out; a match can
+// be false with a probability of 1 / FALSE_POSITIVE_RATE per looked up item. The items
+// are hashed with the block hash, so a false match doesn't repeat in other blocks.
+class BlockFilter {
+public:
+  static const uint8_t GOLOMB_BITS = 19;
+  static const uint64_t FALSE_POSITIVE_RATE = 784931;
+
+  static std::vector<Crypto::Hash> transactionItems(const TransactionPrefix& transaction);
+  static std::string build(const Crypto::Hash& blockHash, const std::vector<Crypto::Hash>& items);
+  // false if the filter rules out every item, a filter without a readable item count matches anything
+  static bool matchAny(const Crypto::Hash& blockHash, const std::string& filter, const std::vector<Crypto::Hash>& items);
+  // commits to the filter and to the filters of all previous blocks
+  static Crypto::Hash header(const std::string& filter, const Crypto::Hash& previousHeader);
+};
+
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "CryptoNoteCore/Difficulty.h"
+
+namespace CryptoNote {
+
+// Per-height values of the main chain block headers, one contiguous array
+// per value, so that difficulty windows, size medians and statistics over
+// a range of heights are plain scans instead of block store lookups.
+class BlockHeaderColumns {
+public:
+  void push(uint64_t timestamp, difficulty_type cumulativeDifficulty, uint64_t cumulativeSize, uint64_t generatedCoins, uint32_t transactionCount) {
+    m_maxTimestamps.push_back(m_maxTimestamps.empty() ? timestamp : std::max(m_maxTimestamps.back(), timestamp));
+    m_timestamps.push_back(timestamp);
+    m_cumulativeDifficulties.push_back(cumulativeDifficulty);
+    m_cumulativeSizes.push_back(cumulativeSize);
+    m_generatedCoins.push_back(generatedCoins);
+    m_transactionCounts.push_back(transactionCount);
+    ++m_revision;
+  }
+
+  void pop() {
+    m_timestamps.pop_back();
+    m_maxTimestamps.pop_back();
+    m_cumulativeDifficulties.pop_back();
+    m_cumulativeSizes.pop_back();
+    m_generatedCoins.pop_back();
+    m_transactionCounts.pop_back();
+    ++m_revision;
+  }
+
+  void clear() {
+    m_timestamps.clear();
+    m_maxTimestamps.clear();
+    m_cumulativeDifficulties.clear();
+    m_cumulativeSizes.clear();
+    m_generatedCoins.clear();
+    m_transactionCounts.clear();
+    ++m_revision;
+  }
+
+  void reserve(size_t count) {
+    m_timestamps.reserve(count);
+    m_maxTimestamps.reserve(count);
+    m_cumulativeDifficulties.reserve(count);
+    m_cumulativeSizes.reserve(count);
+    m_generatedCoins.reserve(count);
+    m_transactionCounts.reserve(count);
+  }
+
+  size_t size() const { return m_timestamps.size(); }
+  bool empty() const { return m_timestamps.empty(); }
+  // changes with every push, pop and clear, so values derived from the columns can be cached
+  uint64_t revision() const { return m_revision; }
+
+  const std::vector<uint64_t>& timestamps() const { return m_timestamps; }
+  const std::vector<difficulty_type>& cumulativeDifficulties() const { return m_cumulativeDifficulties; }
+  const std::vector<uint64_t>& cumulativeSizes() const { return m_cumulativeSizes; }
+  const std::vector<uint64_t>& generatedCoins() const { return m_generatedCoins; }
+  // including the base transaction
+  const std::vector<uint32_t>& transactionCounts() const { return m_transactionCounts; }
+
+  // Block timestamps are not monotonic, so the search runs over the running maximum:
+  // returns the first height not below startHeight such that every block below it
+  // has a timestamp less than the given one, or size() if there is no such block.
+  size_t lowerBound(uint64_t timestamp, size_t startHeight = 0) const {
+    return std::lower_bound(m_maxTimestamps.begin() + std::min(startHeight, m_maxTimestamps.size()), m_maxTimestamps.end(), timestamp) - m_maxTimestamps.begin();
+  }
+
+private:
+  std::vector<uint64_t> m_timestamps;
+  std::vector<uint64_t> m_maxTimestamps;
+  std::vector<difficulty_type> m_cumulativeDifficulties;
+  std::vector<uint64_t> m_cumulativeSizes;
+  std::vector<uint64_t> m_generatedCoins;
+  std::vector<uint32_t> m_transactionCounts;
+  uint64_t m_revision = 0;
+};
+
+}
@@ -55,11 +55,23 @@ namespace CryptoNote {
   }
 
   std::vector<Crypto::Hash> BlockIndex::buildSparseChain(const Crypto::Hash& startBlockId) const {
-    assert(m_index.count(startBlockId) > 0);
+    assert(hasBlock(startBlockId));
 
     uint32_t startBlockHeight = 0;
     getBlockHeight(startBlockId, startBlockHeight);
+    if (startBlockHeight + 1 != m_container.size()) {
+      return doBuildSparseChain(startBlockHeight);
+    }
+
+    std::lock_guard<std::mutex> lock(m_tipSparseChainMutex);
+    if (m_tipSparseChain.empty()) {
+      m_tipSparseChain = doBuildSparseChain(startBlockHeight);
+    }
 
+    return m_tipSparseChain;
+  }
+
+  std::vector<Crypto::Hash> BlockIndex::doBuildSparseChain(uint32_t startBlockHeight) const {
     std::vector<Crypto::Hash> result;
     size_t sparseChainEnd = static_cast<size_t>(startBlockHeight + 1);
     for (size_t i = 1; i <= sparseChainEnd; i *= 2) {
@@ -80,7 +92,14 @@ namespace CryptoNote {
 
   void BlockIndex::serialize(ISerializer& s) {
     if (s.type() == ISerializer::INPUT) {
+      clear();
       readSequence<Crypto::Hash>(std::back_inserter(m_container), "index", s);
+
+      // only the ordered hashes are stored, the lookup map is rebuilt from them
+      m_heights.reserve(m_container.size());
+      for (uint32_t height = 0; height < m_container.size(); ++height) {
+        m_heights.emplace(m_container[height], height);
+      }
     } else {
       writeSequence<Crypto::Hash>(m_container.begin(), m_container.end(), "index", s);
     }
@@ -15,44 +15,51 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/random_access_index.hpp>
+#include <parallel_hashmap/phmap.h>
 
 #include "crypto/hash.h"
+#include <mutex>
 #include <vector>
 
 namespace CryptoNote
 {
   class ISerializer;
 
+  // Block hashes in height order plus a flat (open-addressing) hash -> height map,
+  // so both directions are a single contiguous lookup.
   class BlockIndex {
 
   public:
 
-    BlockIndex() : 
-      m_index(m_container.get<1>()) {}
+    BlockIndex() {}
 
     void pop() {
+      m_heights.erase(m_container.back());
       m_container.pop_back();
+      invalidateTipSparseChain();
     }
 
     // returns true if new element was inserted, false if already exists
     bool push(const Crypto::Hash& h) {
-      auto result = m_container.push_back(h);
-      return result.second;
+      if (!m_heights.emplace(h, static_cast<uint32_t>(m_container.size())).second) {
+        return false;
+      }
+
+      m_container.push_back(h);
+      invalidateTipSparseChain();
+      return true;
     }
 
     bool hasBlock(const Crypto::Hash& h) const {
-      return m_index.find(h) != m_index.end();
+      return m_heights.count(h) != 0;
     }
 
     bool getBlockHeight(const Crypto::Hash& h, uint32_t& height) const {
-      auto hi = m_index.find(h);
-      if (hi == m_index.end())
+      auto hi = m_heights.find(h);
+      if (hi == m_heights.end())
         return false;
 
-      height = static_cast<uint32_t>(std::distance(m_container.begin(), m_container.project<0>(hi)));
+      height = hi->second;
       return true;
     }
 
@@ -62,6 +69,13 @@ namespace CryptoNote
 
     void clear() {
       m_container.clear();
+      m_heights.clear();
+      invalidateTipSparseChain();
+    }
+
+    void reserve(uint32_t count) {
+      m_container.reserve(count);
+      m_heights.reserve(count);
     }
 
     Crypto::Hash getBlockId(uint32_t height) const;
@@ -74,16 +88,19 @@ namespace CryptoNote
 
   private:
 
-    typedef boost::multi_index_container <
-      Crypto::Hash,
-      boost::multi_index::indexed_by<
-        boost::multi_index::random_access<>,
-        boost::multi_index::hashed_unique<boost::multi_index::identity<Crypto::Hash>>
-      >
-    > ContainerT;
+    std::vector<Crypto::Hash> m_container;
+    phmap::flat_hash_map<Crypto::Hash, uint32_t> m_heights;
+
+    // the sparse chain from the tail is sent with every chain request, it is
+    // built on the first one after the tail has changed and copied afterwards
+    mutable std::mutex m_tipSparseChainMutex;
+    mutable std::vector<Crypto::Hash> m_tipSparseChain;
 
-    ContainerT m_container;
-    ContainerT::nth_index<1>::type& m_index;
+    std::vector<Crypto::Hash> doBuildSparseChain(uint32_t startBlockHeight) const;
+    void invalidateTipSparseChain() {
+      std::lock_guard<std::mutex> lock(m_tipSparseChainMutex);
+      m_tipSparseChain.clear();
+    }
 
   };
 }
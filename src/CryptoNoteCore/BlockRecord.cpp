@@ -0,0 +1,116 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockRecord.h"
+
+#include <stdexcept>
+
+namespace CryptoNote {
+
+namespace {
+
+void appendUint32(std::string& out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out.push_back(static_cast<char>(value >> (8 * i)));
+  }
+}
+
+void appendFrame(std::string& out, Common::ArrayView<uint8_t> data) {
+  appendUint32(out, static_cast<uint32_t>(data.getSize()));
+  out.append(reinterpret_cast<const char*>(data.getData()), data.getSize());
+}
+
+uint32_t readUint32(const uint8_t*& data, const uint8_t* end) {
+  if (end - data < 4) {
+    throw std::runtime_error("Block record is cut short");
+  }
+
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value |= static_cast<uint32_t>(data[i]) << (8 * i);
+  }
+
+  data += 4;
+  return value;
+}
+
+void readFrame(const uint8_t*& data, const uint8_t* end, BinaryArray* blob) {
+  uint32_t size = readUint32(data, end);
+  if (static_cast<uint64_t>(end - data) < size) {
+    throw std::runtime_error("Block record is cut short");
+  }
+
+  if (blob != nullptr) {
+    blob->assign(data, data + size);
+  }
+
+  data += size;
+}
+
+}
+
+void appendBlockRecord(std::string& out, const Blockchain::RawBlock& rawBlock) {
+  size_t start = out.size();
+  appendUint32(out, 0);
+  appendUint32(out, rawBlock.height);
+  appendUint32(out, static_cast<uint32_t>(rawBlock.transactions.size()));
+  appendFrame(out, rawBlock.block);
+  for (size_t i = 0; i < rawBlock.transactions.size(); ++i) {
+    appendFrame(out, rawBlock.transactions[i]);
+    appendFrame(out, rawBlock.globalIndexes[i]);
+  }
+
+  uint32_t size = static_cast<uint32_t>(out.size() - start - 4);
+  for (int i = 0; i < 4; ++i) {
+    out[start + i] = static_cast<char>(size >> (8 * i));
+  }
+}
+
+bool readBlockRecord(std::istream& in, BlockRecord& record) {
+  uint8_t sizeBytes[4];
+  in.read(reinterpret_cast<char*>(sizeBytes), sizeof(sizeBytes));
+  if (in.gcount() == 0) {
+    return false;
+  }
+
+  const uint8_t* sizeData = sizeBytes;
+  uint32_t size = readUint32(sizeData, sizeBytes + in.gcount());
+  BinaryArray body(size);
+  in.read(reinterpret_cast<char*>(body.data()), size);
+  if (static_cast<uint32_t>(in.gcount()) != size) {
+    throw std::runtime_error("Block record is cut short");
+  }
+
+  const uint8_t* data = body.data();
+  const uint8_t* end = data + body.size();
+  record.height = readUint32(data, end);
+  uint32_t transactionCount = readUint32(data, end);
+  readFrame(data, end, &record.block);
+  record.transactions.resize(transactionCount);
+  for (uint32_t i = 0; i < transactionCount; ++i) {
+    readFrame(data, end, &record.transactions[i]);
+    readFrame(data, end, nullptr);
+  }
+
+  if (data != end) {
+    throw std::runtime_error("Block record has trailing data");
+  }
+
+  return true;
+}
+
+}
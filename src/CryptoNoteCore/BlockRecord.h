@@ -0,0 +1,46 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "CryptoNoteCore/Blockchain.h"
+
+namespace CryptoNote {
+
+// A record is the little endian uint32 size of the rest of it, the height, the number
+// of transactions and the frames: the block, then each transaction with its global
+// output indexes. A frame is the uint32 size of the blob followed by the blob.
+// The /streamblocks response and the --export-blocks file are sequences of records.
+void appendBlockRecord(std::string& out, const Blockchain::RawBlock& rawBlock);
+
+// The blobs of a record, the base transaction comes first in the transactions.
+// The global output indexes are skipped, they are assigned again on import.
+struct BlockRecord {
+  uint32_t height;
+  BinaryArray block;
+  std::vector<BinaryArray> transactions;
+};
+
+// Returns false at the end of the stream, throws if the record is cut short or malformed
+bool readBlockRecord(std::istream& in, BlockRecord& record);
+
+}
@@ -0,0 +1,491 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "Common/ArrayView.h"
+#include "Common/ClockCache.h"
+#include "Common/FileMappedVector.h"
+#include "Common/MemoryInputStream.h"
+#include "Common/VectorOutputStream.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "Serialization/BinaryInputStreamSerializer.h"
+#include "Serialization/BinaryOutputStreamSerializer.h"
+
+namespace CryptoNote {
+
+// Fixed size part of a stored block, kept in the flat index so that
+// the values below are available without deserializing the entry.
+struct BlockStoreIndexEntry {
+  uint64_t offset;
+  uint64_t timestamp;
+  uint64_t cumulativeDifficulty;
+  uint64_t alreadyGeneratedCoins;
+  uint64_t blockCumulativeSize;
+  uint64_t firstTransaction;
+  uint32_t size;
+  uint32_t blockSize;
+  uint32_t transactionCount;
+  uint32_t reserved;
+};
+
+struct BlockStoreTransactionSpan {
+  uint64_t offset;
+  uint64_t size;
+};
+
+// Append-only block storage in memory mapped files. `name` holds the serialized
+// entries back to back, `name.index` one BlockStoreIndexEntry per height and
+// `name.txs` the location of every transaction blob inside its entry.
+// Entry is Blockchain::BlockEntry: the block is serialized first and the vector
+// of transaction entries last, which is how the blob spans are found.
+// Cached entries are kept without transaction signatures, see BlockEntry::dropSignatures(),
+// load() and transactionBlob() give the stored data in full.
+// Mutations require exclusive access; lookups may run concurrently with each other.
+template<class Entry> class BlockStore {
+public:
+  typedef Entry value_type;
+
+  class const_iterator {
+  public:
+    typedef ptrdiff_t difference_type;
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef const Entry* pointer;
+    typedef const Entry& reference;
+    typedef Entry value_type;
+
+    const_iterator() {
+    }
+
+    const_iterator(BlockStore* store, size_t index) : m_store(store), m_index(index) {
+    }
+
+    bool operator!=(const const_iterator& other) const {
+      return m_index != other.m_index;
+    }
+
+    bool operator<(const const_iterator& other) const {
+      return m_index < other.m_index;
+    }
+
+    bool operator==(const const_iterator& other) const {
+      return m_index == other.m_index;
+    }
+
+    const_iterator& operator++() {
+      ++m_index;
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator i = *this;
+      ++m_index;
+      return i;
+    }
+
+    const_iterator& operator--() {
+      --m_index;
+      return *this;
+    }
+
+    const_iterator& operator+=(difference_type n) {
+      m_index += n;
+      return *this;
+    }
+
+    const_iterator operator+(difference_type n) const {
+      return const_iterator(m_store, m_index + n);
+    }
+
+    difference_type operator-(const const_iterator& other) const {
+      return m_index - other.m_index;
+    }
+
+    const Entry& operator*() const {
+      return (*m_store)[m_index];
+    }
+
+    const Entry* operator->() const {
+      return &(*m_store)[m_index];
+    }
+
+    size_t index() const {
+      return m_index;
+    }
+
+  private:
+    BlockStore* m_store;
+    size_t m_index;
+  };
+
+  BlockStore();
+  BlockStore(const BlockStore&) = delete;
+  ~BlockStore();
+  BlockStore& operator=(const BlockStore&) = delete;
+
+  // cacheSize is the budget for deserialized entries, counted in serialized bytes
+  bool open(const std::string& fileName, size_t cacheSize);
+  void close();
+
+  bool empty() const;
+  uint64_t size() const;
+  const_iterator begin();
+  const_iterator end();
+  // The reference stays valid until the entry is evicted from the cache,
+  // callers which share the store between threads should use get()
+  const Entry& operator[](uint64_t index);
+  std::shared_ptr<const Entry> get(uint64_t index);
+  const Entry& back();
+  // deserializes the whole entry, signatures included, without going through the cache
+  Entry load(uint64_t index) const;
+  BlockStoreIndexEntry header(uint64_t index) const;
+  // Views point into the mapping and stay valid until the store is modified
+  Common::ArrayView<uint8_t> blob(uint64_t index) const;
+  Common::ArrayView<uint8_t> blockBlob(uint64_t index) const;
+  Common::ArrayView<uint8_t> transactionBlob(uint64_t index, size_t transaction) const;
+  void clear();
+  void pop_back();
+  void push_back(const Entry& entry);
+
+private:
+  // entries a sequential scan asks the OS to page in ahead of the reader
+  static const uint64_t READAHEAD_COUNT = 64;
+
+  Common::FileMappedVector<uint8_t> m_blobs;
+  Common::FileMappedVector<BlockStoreIndexEntry> m_index;
+  Common::FileMappedVector<BlockStoreTransactionSpan> m_transactions;
+  Common::ClockCache<uint64_t, Entry> m_cache;
+  Common::SequentialReads m_sequentialReads;
+  uint64_t m_readAheadEnd;
+  mutable std::mutex m_mutex;
+
+  template<class T> static void closeFile(Common::FileMappedVector<T>& file);
+  void recover();
+  void readAhead(uint64_t first, uint64_t last) const;
+};
+
+template<class Entry> BlockStore<Entry>::BlockStore() : m_readAheadEnd(0) {
+}
+
+template<class Entry> BlockStore<Entry>::~BlockStore() {
+  close();
+}
+
+template<class Entry> bool BlockStore<Entry>::open(const std::string& fileName, size_t cacheSize) {
+  if (cacheSize == 0) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lk(m_mutex);
+  try {
+    m_blobs.open(fileName);
+    m_index.open(fileName + ".index");
+    m_transactions.open(fileName + ".txs");
+  } catch (std::exception&) {
+    return false;
+  }
+
+  // Pages are left to the OS to write back, after a crash the files may
+  // disagree about the last entries and recover() trims them
+  m_blobs.setAutoFlush(false);
+  m_index.setAutoFlush(false);
+  m_transactions.setAutoFlush(false);
+  recover();
+
+  m_cache.reset(cacheSize);
+  m_sequentialReads.reset();
+  m_readAheadEnd = 0;
+  return true;
+}
+
+template<class Entry> void BlockStore<Entry>::close() {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  closeFile(m_blobs);
+  closeFile(m_transactions);
+  closeFile(m_index);
+  m_cache.clear();
+}
+
+template<class Entry> bool BlockStore<Entry>::empty() const {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  return m_index.empty();
+}
+
+template<class Entry> uint64_t BlockStore<Entry>::size() const {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  return m_index.size();
+}
+
+template<class Entry> typename BlockStore<Entry>::const_iterator BlockStore<Entry>::begin() {
+  return const_iterator(this, 0);
+}
+
+template<class Entry> typename BlockStore<Entry>::const_iterator BlockStore<Entry>::end() {
+  return const_iterator(this, size());
+}
+
+template<class Entry> const Entry& BlockStore<Entry>::operator[](uint64_t index) {
+  return *get(index);
+}
+
+template<class Entry> std::shared_ptr<const Entry> BlockStore<Entry>::get(uint64_t index) {
+  std::shared_ptr<Entry> item = m_cache.find(index);
+  if (item) {
+    return item;
+  }
+
+  std::unique_lock<std::mutex> lk(m_mutex);
+  if (index >= m_index.size()) {
+    throw std::runtime_error("BlockStore::get");
+  }
+
+  const BlockStoreIndexEntry& header = m_index[index];
+  const uint8_t* data = m_blobs.data() + header.offset;
+  size_t size = header.size;
+  bool sequential = m_sequentialReads.miss(index);
+  if (sequential && index + READAHEAD_COUNT / 2 >= m_readAheadEnd) {
+    uint64_t next = std::min<uint64_t>(index + 1 + READAHEAD_COUNT, m_index.size());
+    readAhead(std::max(index + 1, m_readAheadEnd), next);
+    m_readAheadEnd = next;
+  }
+
+  // the mapping only changes under exclusive access, so other readers may deserialize meanwhile
+  lk.unlock();
+  item = std::make_shared<Entry>();
+  Common::MemoryInputStream stream(data, size);
+  BinaryInputStreamSerializer archive(stream);
+  serialize(*item, archive);
+  item->dropSignatures();
+
+  // entries of a scan are inserted unreferenced, they are the first to be evicted
+  m_cache.insert(index, item, size, !sequential);
+  return item;
+}
+
+template<class Entry> const Entry& BlockStore<Entry>::back() {
+  return operator[](size() - 1);
+}
+
+template<class Entry> Entry BlockStore<Entry>::load(uint64_t index) const {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  if (index >= m_index.size()) {
+    throw std::runtime_error("BlockStore::load");
+  }
+
+  const BlockStoreIndexEntry& header = m_index[index];
+  Entry entry;
+  Common::MemoryInputStream stream(m_blobs.data() + header.offset, header.size);
+  BinaryInputStreamSerializer archive(stream);
+  serialize(entry, archive);
+  return entry;
+}
+
+template<class Entry> BlockStoreIndexEntry BlockStore<Entry>::header(uint64_t index) const {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  if (index >= m_index.size()) {
+    throw std::runtime_error("BlockStore::header");
+  }
+
+  return m_index[index];
+}
+
+template<class Entry> Common::ArrayView<uint8_t> BlockStore<Entry>::blob(uint64_t index) const {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  if (index >= m_index.size()) {
+    throw std::runtime_error("BlockStore::blob");
+  }
+
+  const BlockStoreIndexEntry& header = m_index[index];
+  return Common::ArrayView<uint8_t>(m_blobs.data() + header.offset, header.size);
+}
+
+template<class Entry> Common::ArrayView<uint8_t> BlockStore<Entry>::blockBlob(uint64_t index) const {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  if (index >= m_index.size()) {
+    throw std::runtime_error("BlockStore::blockBlob");
+  }
+
+  const BlockStoreIndexEntry& header = m_index[index];
+  return Common::ArrayView<uint8_t>(m_blobs.data() + header.offset, header.blockSize);
+}
+
+template<class Entry> Common::ArrayView<uint8_t> BlockStore<Entry>::transactionBlob(uint64_t index, size_t transaction) const {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  if (index >= m_index.size() || transaction >= m_index[index].transactionCount) {
+    throw std::runtime_error("BlockStore::transactionBlob");
+  }
+
+  const BlockStoreTransactionSpan& span = m_transactions[m_index[index].firstTransaction + transaction];
+  return Common::ArrayView<uint8_t>(m_blobs.data() + span.offset, span.size);
+}
+
+template<class Entry> void BlockStore<Entry>::clear() {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  m_index.clear();
+  m_transactions.clear();
+  m_blobs.clear();
+  m_cache.clear();
+}
+
+template<class Entry> void BlockStore<Entry>::pop_back() {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  if (m_index.empty()) {
+    throw std::runtime_error("BlockStore::pop_back");
+  }
+
+  BlockStoreIndexEntry header = m_index.back();
+  m_index.pop_back();
+  m_transactions.erase(m_transactions.begin() + header.firstTransaction, m_transactions.end());
+  m_blobs.erase(m_blobs.begin() + header.offset, m_blobs.end());
+  m_cache.erase(m_index.size());
+}
+
+template<class Entry> void BlockStore<Entry>::push_back(const Entry& entry) {
+  BinaryArray blob;
+  {
+    Common::VectorOutputStream stream(blob);
+    BinaryOutputStreamSerializer archive(stream);
+    serialize(const_cast<Entry&>(entry), archive);
+  }
+
+  // the transaction entries are the tail of the blob, each one starts with its transaction
+  std::vector<BinaryArray> transactionEntries;
+  transactionEntries.reserve(entry.transactions.size());
+  uint64_t tailSize = 0;
+  for (const auto& transaction : entry.transactions) {
+    transactionEntries.emplace_back(toBinaryArray(transaction));
+    tailSize += transactionEntries.back().size();
+  }
+
+  if (tailSize > blob.size()) {
+    throw std::runtime_error("BlockStore::push_back");
+  }
+
+  std::lock_guard<std::mutex> lk(m_mutex);
+  BlockStoreIndexEntry header;
+  header.offset = m_blobs.size();
+  header.timestamp = entry.bl.timestamp;
+  header.cumulativeDifficulty = entry.cumulative_difficulty;
+  header.alreadyGeneratedCoins = entry.already_generated_coins;
+  header.blockCumulativeSize = entry.block_cumulative_size;
+  header.firstTransaction = m_transactions.size();
+  header.size = static_cast<uint32_t>(blob.size());
+  header.blockSize = static_cast<uint32_t>(getObjectBinarySize(entry.bl));
+  header.transactionCount = static_cast<uint32_t>(entry.transactions.size());
+  header.reserved = 0;
+
+  std::vector<BlockStoreTransactionSpan> spans;
+  spans.reserve(entry.transactions.size());
+  uint64_t position = blob.size() - tailSize;
+  for (size_t i = 0; i < entry.transactions.size(); ++i) {
+    BlockStoreTransactionSpan span;
+    span.offset = header.offset + position;
+    span.size = getObjectBinarySize(entry.transactions[i].tx);
+    if (span.size > transactionEntries[i].size() || std::memcmp(blob.data() + position, transactionEntries[i].data(), static_cast<size_t>(span.size)) != 0) {
+      throw std::runtime_error("BlockStore::push_back");
+    }
+
+    spans.push_back(span);
+    position += transactionEntries[i].size();
+  }
+
+  // the index entry goes last, an entry without it is dropped by recover()
+  m_blobs.insert(m_blobs.end(), blob.begin(), blob.end());
+  m_transactions.insert(m_transactions.end(), spans.begin(), spans.end());
+  m_index.push_back(header);
+
+  std::shared_ptr<Entry> cached = std::make_shared<Entry>(entry);
+  cached->dropSignatures();
+  m_cache.insert(m_index.size() - 1, cached, blob.size());
+}
+
+template<class Entry> template<class T> void BlockStore<Entry>::closeFile(Common::FileMappedVector<T>& file) {
+  if (!file.isOpened()) {
+    return;
+  }
+
+  std::error_code ignore;
+  try {
+    file.flush();
+  } catch (std::exception&) {
+  }
+
+  file.close(ignore);
+}
+
+// Precondition: m_mutex is locked.
+template<class Entry> void BlockStore<Entry>::recover() {
+  uint64_t count = m_index.size();
+  while (count != 0) {
+    const BlockStoreIndexEntry& header = m_index[count - 1];
+    if (header.offset + header.size <= m_blobs.size() && header.firstTransaction + header.transactionCount <= m_transactions.size()) {
+      break;
+    }
+
+    --count;
+  }
+
+  if (count != m_index.size()) {
+    m_index.erase(m_index.begin() + count, m_index.end());
+  }
+
+  uint64_t blobsSize = 0;
+  uint64_t transactionsSize = 0;
+  if (count != 0) {
+    const BlockStoreIndexEntry& header = m_index.back();
+    blobsSize = header.offset + header.size;
+    transactionsSize = header.firstTransaction + header.transactionCount;
+  }
+
+  if (m_blobs.size() > blobsSize) {
+    m_blobs.erase(m_blobs.begin() + blobsSize, m_blobs.end());
+  }
+
+  if (m_transactions.size() > transactionsSize) {
+    m_transactions.erase(m_transactions.begin() + transactionsSize, m_transactions.end());
+  }
+}
+
+// Precondition: m_mutex is locked, first < last <= m_index.size().
+// Entries are mapped, not read, so reading ahead means asking the OS to page them in.
+template<class Entry> void BlockStore<Entry>::readAhead(uint64_t first, uint64_t last) const {
+#ifndef _WIN32
+  if (first >= last) {
+    return;
+  }
+
+  static const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  uintptr_t begin = reinterpret_cast<uintptr_t>(m_blobs.data() + m_index[first].offset) & ~(pageSize - 1);
+  uintptr_t end = reinterpret_cast<uintptr_t>(m_blobs.data() + m_index[last - 1].offset + m_index[last - 1].size);
+  posix_madvise(reinterpret_cast<void*>(begin), end - begin, POSIX_MADV_WILLNEED);
+#endif
+}
+
+}
@@ -23,15 +23,27 @@
 #include <numeric>
 #include <cstdio>
 #include <cmath>
+#include <future>
+#include <iomanip>
+#include <limits>
+#include <unordered_set>
+#include <thread>
 #include <boost/foreach.hpp>
+#include "Common/AllocationProfiler.h"
 #include "Common/Math.h"
+#include "Common/ScopeExit.h"
 #include "Common/int-util.h"
 #include "Common/ShuffleGenerator.h"
 #include "Common/StdInputStream.h"
 #include "Common/StdOutputStream.h"
+#include "Common/Tracing.h"
 #include "Rpc/CoreRpcServerCommandsDefinitions.h"
 #include "Serialization/BinarySerializationTools.h"
+#include "Serialization/SerializationTools.h"
+#include "BlockFilter.h"
+#include "BlockRecord.h"
 #include "CryptoNoteTools.h"
+#include "SwappedVector.h"
 #include "TransactionExtra.h"
 #include "parallel_hashmap/phmap_dump.h"
 
@@ -50,6 +62,43 @@ std::string appendPath(const std::string& path, const std::string& fileName) {
   return result;
 }
 
+// enough for several downloaded batches plus the blocks involved in a deep reorganisation
+const size_t LONG_HASH_CACHE_SIZE = 10000;
+const size_t RING_MEMBER_CACHE_SIZE = 8192; // about 2.5 KB per member
+const size_t BLOCK_CACHE_SIZE = 32 * 1024 * 1024; // bytes of serialized block entries
+// microseconds, storing a block usually takes well under a millisecond
+const std::vector<uint64_t> BLOCK_STAGE_TIME_BOUNDS = { 100, 500, 1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000 };
+const std::vector<uint64_t> REORGANIZATION_DEPTH_BOUNDS = { 1, 2, 3, 5, 10, 20, 50, 100, 1000 };
+const uint32_t BLOCKS_EXPORT_CHUNK_SIZE = 1000;
+// below LONG_HASH_CACHE_SIZE, the long hashes of a whole chunk are computed before it is pushed
+const size_t BLOCKS_IMPORT_CHUNK_SIZE = 1000;
+
+// The id of a merge mined block doesn't commit to its whole parent block,
+// which is what the long hash of such a block is taken from
+bool isLongHashCacheable(const CryptoNote::Block& block) {
+  return block.majorVersion != CryptoNote::BLOCK_MAJOR_VERSION_2 && block.majorVersion != CryptoNote::BLOCK_MAJOR_VERSION_3;
+}
+
+// additional key_image check, fix discovered by Monero Lab and suggested by "fluffypony" (bitcointalk.org)
+bool keyImagesInDomain(const CryptoNote::Transaction& tx) {
+  std::vector<Crypto::KeyImage> keyImages;
+  for (const auto& txin : tx.inputs) {
+    if (txin.type() == typeid(CryptoNote::KeyInput)) {
+      keyImages.push_back(boost::get<CryptoNote::KeyInput>(txin).keyImage);
+    }
+  }
+
+  std::unique_ptr<bool[]> inDomain(new bool[keyImages.size()]);
+  Crypto::check_key_images(keyImages.data(), keyImages.size(), inDomain.get());
+  for (size_t i = 0; i < keyImages.size(); ++i) {
+    if (!inDomain[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 }
 
 namespace std {
@@ -62,8 +111,9 @@ bool operator<(const Crypto::KeyImage& keyImage1, const Crypto::KeyImage& keyIma
 }
 }
 
-#define CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER 3
-#define CURRENT_BLOCKCHAININDICES_STORAGE_ARCHIVE_VER 1
+#define CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER 6
+#define MIN_BLOCKCACHE_STORAGE_ARCHIVE_VER 3
+#define CURRENT_BLOCKCHAININDICES_STORAGE_ARCHIVE_VER 4
 
 namespace CryptoNote {
 class BlockCacheSerializer;
@@ -134,7 +184,7 @@ class BlockCacheSerializer {
 
 public:
   BlockCacheSerializer(Blockchain& bs, const Crypto::Hash lastBlockHash, ILogger& logger) :
-    m_bs(bs), m_lastBlockHash(lastBlockHash), m_loaded(false), logger(logger, "BlockCacheSerializer") {
+    m_bs(bs), m_lastBlockHash(lastBlockHash), m_height(0), m_loaded(false), logger(logger, "BlockCacheSerializer") {
   }
 
   void load(const std::string& filename) {
@@ -145,23 +195,42 @@ public:
       }
 
       StdInputStream stream(stdStream);
-      BinaryInputStreamSerializer s(stream);
+      BinaryInputStreamSerializer s(stream, BinaryInputStreamSerializer::READ_AHEAD_SIZE);
       CryptoNote::serialize(*this, s);
     } catch (std::exception& e) {
       logger(WARNING) << "loading failed: " << e.what();
     }
   }
 
+  // Everything is written to temporary files first. The old snapshot is removed
+  // before they are renamed, so a crash leaves either a complete snapshot or none.
   bool save(const std::string& filename) {
+    m_fileSuffix = ".tmp";
     try {
-      std::ofstream file(filename, std::ios::binary);
-      if (!file) {
-        return false;
+      {
+        std::ofstream file(filename + m_fileSuffix, std::ios::binary);
+        if (!file) {
+          return false;
+        }
+
+        StdOutputStream stream(file);
+        BinaryOutputStreamSerializer s(stream);
+        CryptoNote::serialize(*this, s);
+        file.flush();
+        if (!file) {
+          return false;
+        }
       }
 
-      StdOutputStream stream(file);
-      BinaryOutputStreamSerializer s(stream);
-      CryptoNote::serialize(*this, s);
+      boost::filesystem::remove(filename);
+      if (!m_bs.m_transactionMap.onDisk()) {
+        for (const char* name : { "transactionsmap.dat", "spentkeys.dat" }) {
+          std::string path = appendPath(m_bs.m_config_folder, name);
+          boost::filesystem::rename(path + m_fileSuffix, path);
+        }
+      }
+
+      boost::filesystem::rename(filename + m_fileSuffix, filename);
     } catch (std::exception&) {
       return false;
     }
@@ -176,7 +245,7 @@ public:
     s(version, "version");
 
     // ignore old versions, do rebuild
-    if (version < CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER)
+    if (version < MIN_BLOCKCACHE_STORAGE_ARCHIVE_VER)
       return;
 
     std::string operation;
@@ -185,42 +254,73 @@ public:
       Crypto::Hash blockHash;
       s(blockHash, "last_block");
 
-      if (blockHash != m_lastBlockHash) {
+      // version 3 caches were always saved at the top of the chain
+      uint32_t height = static_cast<uint32_t>(m_bs.m_blocks.size() - 1);
+      if (version > 3) {
+        s(height, "height");
+      }
+
+      if (height >= m_bs.m_blocks.size() || blockHash != get_block_hash(m_bs.m_blocks.get(height)->bl)) {
         return;
       }
 
+      m_height = height;
+
+      // the low memory profile keeps the transaction map and the spent keys in tables
+      // of their own, a snapshot of the other profile is no use
+      bool indicesOnDisk = false;
+      if (version > 5) {
+        s(indicesOnDisk, "indices_on_disk");
+      }
+
+      if (indicesOnDisk != m_bs.m_transactionMap.onDisk()) {
+        logger(INFO) << "Blockchain cache was saved with another memory profile";
+        return;
+      }
     } else {
       operation = "- saving ";
+      m_height = static_cast<uint32_t>(m_bs.m_blocks.size() - 1);
       s(m_lastBlockHash, "last_block");
+      s(m_height, "height");
+      bool indicesOnDisk = m_bs.m_transactionMap.onDisk();
+      s(indicesOnDisk, "indices_on_disk");
     }
 
     logger(INFO) << operation << "block index...";
     s(m_bs.m_blockIndex, "block_index");
 
-    logger(INFO) << operation << "transaction map...";
-    //s(m_bs.m_transactionMap, "transactions");
-    if (s.type() == ISerializer::INPUT) {
-      phmap::BinaryInputArchive ar_in(appendPath(m_bs.m_config_folder, "transactionsmap.dat").c_str());
-      m_bs.m_transactionMap.load(ar_in);
-    }
-    else {
-      phmap::BinaryOutputArchive ar_out(appendPath(m_bs.m_config_folder, "transactionsmap.dat").c_str());
-      m_bs.m_transactionMap.dump(ar_out);
-    }
+    if (!m_bs.m_transactionMap.onDisk()) {
+      logger(INFO) << operation << "transaction map...";
+      //s(m_bs.m_transactionMap, "transactions");
+      if (s.type() == ISerializer::INPUT) {
+        phmap::BinaryInputArchive ar_in(appendPath(m_bs.m_config_folder, "transactionsmap.dat" + m_fileSuffix).c_str());
+        m_bs.m_transactionMap.memoryMap().load(ar_in);
+      }
+      else {
+        phmap::BinaryOutputArchive ar_out(appendPath(m_bs.m_config_folder, "transactionsmap.dat" + m_fileSuffix).c_str());
+        m_bs.m_transactionMap.memoryMap().dump(ar_out);
+      }
 
-    logger(INFO) << operation << "spent keys...";
-    //s(m_bs.m_spent_key_images, "spent_keys");
-    if (s.type() == ISerializer::INPUT) {
-      phmap::BinaryInputArchive ar_in(appendPath(m_bs.m_config_folder, "spentkeys.dat").c_str());
-      m_bs.m_spent_key_images.load(ar_in);
-    }
-    else {
-      phmap::BinaryOutputArchive ar_out(appendPath(m_bs.m_config_folder, "spentkeys.dat").c_str());
-      m_bs.m_spent_key_images.dump(ar_out);
+      logger(INFO) << operation << "spent keys...";
+      //s(m_bs.m_spent_key_images, "spent_keys");
+      if (s.type() == ISerializer::INPUT) {
+        phmap::BinaryInputArchive ar_in(appendPath(m_bs.m_config_folder, "spentkeys.dat" + m_fileSuffix).c_str());
+        m_bs.m_spent_key_images.memoryMap().load(ar_in);
+      }
+      else {
+        phmap::BinaryOutputArchive ar_out(appendPath(m_bs.m_config_folder, "spentkeys.dat" + m_fileSuffix).c_str());
+        m_bs.m_spent_key_images.memoryMap().dump(ar_out);
+      }
     }
 
     logger(INFO) << operation << "outputs...";
     s(m_bs.m_outputs, "outputs");
+    if (version > 4) {
+      s(m_bs.m_outputKeys, "output_keys");
+    } else if (s.type() == ISerializer::INPUT) {
+      logger(INFO) << "- building output key index...";
+      m_bs.buildOutputKeys();
+    }
 
     logger(INFO) << operation << "multi-signature outputs...";
     s(m_bs.m_multisignatureOutputs, "multisig_outputs");
@@ -236,12 +336,18 @@ public:
     return m_loaded;
   }
 
+  uint32_t height() const {
+    return m_height;
+  }
+
 private:
 
   LoggerRef logger;
   bool m_loaded;
   Blockchain& m_bs;
   Crypto::Hash m_lastBlockHash;
+  uint32_t m_height;
+  std::string m_fileSuffix;
 };
 
 class BlockchainIndicesSerializer {
@@ -278,15 +384,15 @@ public:
       s(m_lastBlockHash, "blockHash");
     }
 
-    logger(INFO) << operation << "paymentID index...";
-    s(m_bs.m_paymentIdIndex, "paymentIdIndex");
-
-    logger(INFO) << operation << "timestamp index...";
-    s(m_bs.m_timestampIndex, "timestampIndex");
-
     logger(INFO) << operation << "generated transactions index...";
     s(m_bs.m_generatedTransactionsIndex, "generatedTransactionsIndex");
 
+    logger(INFO) << operation << "block filter index...";
+    s(m_bs.m_blockFilterIndex, "blockFilterIndex");
+
+    logger(INFO) << operation << "block summary index...";
+    s(m_bs.m_blockSummaryIndex, "blockSummaryIndex");
+
     m_loaded = true;
   }
 
@@ -311,15 +417,15 @@ public:
       ar & m_lastBlockHash;
     }
 
-    logger(INFO) << operation << "paymentID index...";
-    ar & m_bs.m_paymentIdIndex;
-
-    logger(INFO) << operation << "timestamp index...";
-    ar & m_bs.m_timestampIndex;
-
     logger(INFO) << operation << "generated transactions index...";
     ar & m_bs.m_generatedTransactionsIndex;
 
+    logger(INFO) << operation << "block filter index...";
+    ar & m_bs.m_blockFilterIndex;
+
+    logger(INFO) << operation << "block summary index...";
+    ar & m_bs.m_blockSummaryIndex;
+
     m_loaded = true;
   }
 
@@ -341,16 +447,31 @@ logger(logger, "Blockchain"),
 m_currency(currency),
 m_tx_pool(tx_pool),
 m_current_block_cumul_sz_limit(0),
+m_nextDifficultyRevision(std::numeric_limits<uint64_t>::max()),
+m_nextDifficultyVersion(0),
+m_nextDifficulty(0),
 m_upgradeDetectorV2(currency, m_blocks, BLOCK_MAJOR_VERSION_2, logger),
 m_upgradeDetectorV3(currency, m_blocks, BLOCK_MAJOR_VERSION_3, logger),
 m_upgradeDetectorV4(currency, m_blocks, BLOCK_MAJOR_VERSION_4, logger),
 m_upgradeDetectorV5(currency, m_blocks, BLOCK_MAJOR_VERSION_5, logger),
 m_checkpoints(logger),
+m_longHashCache(LONG_HASH_CACHE_SIZE),
+m_ringMemberCache(RING_MEMBER_CACHE_SIZE),
+m_proofOfWorkTime(BLOCK_STAGE_TIME_BOUNDS),
+m_inputsCheckTime(BLOCK_STAGE_TIME_BOUNDS),
+m_ringSignaturesTime(BLOCK_STAGE_TIME_BOUNDS),
+m_blockStoreTime(BLOCK_STAGE_TIME_BOUNDS),
+m_blockValidationTime(BLOCK_STAGE_TIME_BOUNDS),
+m_reorganizationDepth(REORGANIZATION_DEPTH_BOUNDS),
 m_paymentIdIndex(blockchainIndexesEnabled),
 m_timestampIndex(blockchainIndexesEnabled),
 m_generatedTransactionsIndex(blockchainIndexesEnabled),
 m_orphanBlocksIndex(blockchainIndexesEnabled),
-m_blockchainIndexesEnabled(blockchainIndexesEnabled) {
+m_blockFilterIndex(blockchainIndexesEnabled),
+m_blockSummaryIndex(blockchainIndexesEnabled),
+m_blockchainIndexesEnabled(blockchainIndexesEnabled),
+m_lowMemory(false),
+m_cacheSnapshotHeight(0) {
 }
 
 bool Blockchain::addObserver(IBlockchainStorageObserver* observer) {
@@ -421,41 +542,37 @@ bool Blockchain::checkTransactionSize(size_t blobSize) {
 }
 
 bool Blockchain::haveTransaction(const Crypto::Hash &id) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-  return m_transactionMap.find(id) != m_transactionMap.end();
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  return m_transactionMap.contains(id);
 }
 
 bool Blockchain::have_tx_keyimg_as_spent(const Crypto::KeyImage &key_im) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-  return  checkIfSpent(key_im);
+  return checkIfSpent(key_im);
 }
 
 bool Blockchain::checkIfSpent(const Crypto::KeyImage& keyImage, uint32_t blockIndex) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   
-  auto it = m_spent_key_images.find(keyImage);
-  if (it == m_spent_key_images.end()) {
+  uint32_t spentIndex;
+  if (!m_spent_key_images.find(keyImage, spentIndex)) {
     return false;
   }
 
-  return it->second <= blockIndex;
+  return spentIndex <= blockIndex;
 }
 
+// Doesn't take m_blockchain_lock: the spent key images map locks the submap
+// it looks into, so relayed transactions can be checked while a block is being added
 bool Blockchain::checkIfSpent(const Crypto::KeyImage& keyImage) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-  if (m_spent_key_images.count(keyImage) != 0) {
-    return true;
-  }
-
-  return false;
+  return m_spent_key_images.contains(keyImage);
 }
 
 uint32_t Blockchain::getCurrentBlockchainHeight() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return static_cast<uint32_t>(m_blocks.size());
 }
 
-bool Blockchain::init(const std::string& config_folder, bool load_existing) {
+bool Blockchain::init(const std::string& config_folder, bool load_existing, const std::function<void()>& waitForPool) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (!config_folder.empty() && !Tools::create_directories_if_necessary(config_folder)) {
     logger(ERROR, BRIGHT_RED) << "Failed to create data directory: " << m_config_folder;
@@ -464,25 +581,95 @@ bool Blockchain::init(const std::string& config_folder, bool load_existing) {
 
   m_config_folder = config_folder;
 
-  if (!m_blocks.open(appendPath(config_folder, m_currency.blocksFileName()), appendPath(config_folder, m_currency.blockIndexesFileName()), 1024)) {
+  if (!m_blocks.open(appendPath(config_folder, m_currency.blockStoreFileName()), BLOCK_CACHE_SIZE)) {
+    logger(ERROR, BRIGHT_RED) << "Failed to open block store in " << config_folder;
+    return false;
+  }
+
+  if (load_existing && m_blocks.empty() && !importLegacyBlocks(config_folder)) {
     return false;
   }
 
+  bool indexTablesReset = false;
+  if (m_lowMemory) {
+    try {
+      m_transactionMap.openFile(appendPath(config_folder, "transactionsmap.table"));
+      m_spent_key_images.openFile(appendPath(config_folder, "spentkeys.table"));
+    } catch (std::exception& e) {
+      logger(ERROR, BRIGHT_RED) << "Failed to open index tables in " << config_folder << ": " << e.what();
+      return false;
+    }
+
+    indexTablesReset = m_transactionMap.fileWasReset() || m_spent_key_images.fileWasReset();
+  }
+
+  if (m_blockchainIndexesEnabled) {
+    try {
+      m_paymentIdIndex.open(appendPath(config_folder, m_currency.blockchainIndicesFileName() + ".paymentids"));
+    } catch (std::exception& e) {
+      logger(ERROR, BRIGHT_RED) << "Failed to open payment id index in " << config_folder << ": " << e.what();
+      return false;
+    }
+  }
+
+  m_blockColumns.clear();
+  m_lastBlocksSizes.clear();
+  if (load_existing) {
+    loadBlockColumns();
+  }
+
   if (load_existing && !m_blocks.empty()) {
+    Crypto::Hash lastBlockHash = get_block_hash(m_blocks.back().bl);
+
+    // the explorer indices have a file of their own, it is read while the cache loads
+    std::future<bool> indicesRead;
+    if (m_blockchainIndexesEnabled) {
+      indicesRead = std::async(std::launch::async, &Blockchain::readBlockchainIndices, this, lastBlockHash);
+    }
+
     logger(INFO, BRIGHT_WHITE) << "Loading blockchain...";
-    BlockCacheSerializer loader(*this, get_block_hash(m_blocks.back().bl), logger.getLogger());
-    loader.load(appendPath(config_folder, m_currency.blocksCacheFileName()));
+    std::chrono::steady_clock::time_point timePoint = std::chrono::steady_clock::now();
+    BlockCacheSerializer loader(*this, lastBlockHash, logger.getLogger());
+    if (!indexTablesReset) {
+      loader.load(appendPath(config_folder, m_currency.blocksCacheFileName()));
+    }
 
     if (!loader.loaded()) {
       logger(WARNING, BRIGHT_YELLOW) << "No actual blockchain cache found, rebuilding internal structures...";
       rebuildCache();
+    } else {
+      m_cacheSnapshotHeight = loader.height();
+      if (m_cacheSnapshotHeight + 1 < m_blocks.size()) {
+        logger(INFO, BRIGHT_WHITE) << "Blockchain cache is at height " << m_cacheSnapshotHeight << ", replaying " << m_blocks.size() - m_cacheSnapshotHeight - 1 << " blocks...";
+        indexBlocks(m_cacheSnapshotHeight + 1);
+      }
     }
 
+    std::chrono::duration<double> cacheDuration = std::chrono::steady_clock::now() - timePoint;
+    logger(INFO) << "Blockchain cache loaded in " << std::fixed << std::setprecision(2) << cacheDuration.count() << " s";
+
     if (m_blockchainIndexesEnabled) {
-      loadBlockchainIndices();
+      bool indicesLoaded = indicesRead.get();
+      std::chrono::duration<double> indicesDuration = std::chrono::steady_clock::now() - timePoint;
+      logger(INFO) << "Blockchain indices loaded in " << std::fixed << std::setprecision(2) << indicesDuration.count() << " s";
+      if (!indicesLoaded) {
+        rebuildBlockchainIndices();
+      }
+
+      loadPaymentIdIndex();
+      loadTimestampIndex();
     }
   } else {
     m_blocks.clear();
+    m_blockColumns.clear();
+    m_lastBlocksSizes.clear();
+    m_transactionMap.clear();
+    m_spent_key_images.clear();
+    m_paymentIdIndex.clear();
+  }
+
+  if (waitForPool) {
+    waitForPool();
   }
 
   if (m_blocks.empty()) {
@@ -551,8 +738,8 @@ bool Blockchain::init(const std::string& config_folder, bool load_existing) {
 
   update_next_cumulative_size_limit();
 
-  uint64_t timestamp_diff = time(NULL) - m_blocks.back().bl.timestamp;
-  if (!m_blocks.back().bl.timestamp) {
+  uint64_t timestamp_diff = time(NULL) - m_blockColumns.timestamps().back();
+  if (!m_blockColumns.timestamps().back()) {
     timestamp_diff = time(NULL) - 1341378000;
   }
 
@@ -563,55 +750,171 @@ bool Blockchain::init(const std::string& config_folder, bool load_existing) {
   return true;
 }
 
+void Blockchain::loadBlockColumns() {
+  m_blockColumns.clear();
+  m_blockColumns.reserve(m_blocks.size());
+  for (uint64_t i = 0; i < m_blocks.size(); ++i) {
+    BlockStoreIndexEntry header = m_blocks.header(i);
+    m_blockColumns.push(header.timestamp, header.cumulativeDifficulty, header.blockCumulativeSize, header.alreadyGeneratedCoins, header.transactionCount);
+  }
+
+  m_lastBlocksSizes.clear();
+  size_t count = std::min<size_t>(m_blockColumns.size(), m_currency.rewardBlocksWindow());
+  for (size_t i = m_blockColumns.size() - count; i < m_blockColumns.size(); ++i) {
+    m_lastBlocksSizes.push_back(m_blockColumns.cumulativeSizes()[i]);
+  }
+}
+
+bool Blockchain::importLegacyBlocks(const std::string& config_folder) {
+  std::string blocksFile = appendPath(config_folder, m_currency.blocksFileName());
+  std::string indexesFile = appendPath(config_folder, m_currency.blockIndexesFileName());
+  if (!boost::filesystem::exists(blocksFile) || !boost::filesystem::exists(indexesFile)) {
+    return true;
+  }
+
+  SwappedVector<BlockEntry> legacyBlocks;
+  if (!legacyBlocks.open(blocksFile, indexesFile, BLOCK_CACHE_SIZE)) {
+    logger(ERROR, BRIGHT_RED) << "Failed to open " << blocksFile;
+    return false;
+  }
+
+  uint64_t count = legacyBlocks.size();
+  if (count == 0) {
+    return true;
+  }
+
+  logger(INFO, BRIGHT_WHITE) << "Importing " << count << " blocks from " << blocksFile << " into the block store...";
+  std::chrono::steady_clock::time_point timePoint = std::chrono::steady_clock::now();
+  try {
+    for (uint64_t i = 0; i < count; ++i) {
+      if (i % 1000 == 0) {
+        logger(INFO, BRIGHT_WHITE) << "Height " << i << " of " << count;
+      }
+
+      m_blocks.push_back(*legacyBlocks.get(i));
+    }
+  } catch (std::exception& e) {
+    logger(ERROR, BRIGHT_RED) << "Failed to import blocks: " << e.what();
+    m_blocks.clear();
+    return false;
+  }
+
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - timePoint;
+  logger(INFO, BRIGHT_WHITE) << "Import completed in " << duration.count() << " seconds, "
+    << blocksFile << " and " << indexesFile << " are no longer used and may be removed";
+  return true;
+}
+
 void Blockchain::rebuildCache() {
   std::chrono::steady_clock::time_point timePoint = std::chrono::steady_clock::now();
   m_blockIndex.clear();
+  m_blockIndex.reserve(static_cast<uint32_t>(m_blocks.size()));
   m_transactionMap.clear();
   m_spent_key_images.clear();
   m_outputs.clear();
+  m_outputKeys.clear();
   m_multisignatureOutputs.clear();
-  for (uint32_t b = 0; b < m_blocks.size(); ++b) {
-    if (b % 1000 == 0) {
-      logger(INFO, BRIGHT_WHITE) << "Height " << b << " of " << m_blocks.size();
+  m_cacheSnapshotHeight = 0;
+  indexBlocks(0);
+
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - timePoint;
+  logger(INFO, BRIGHT_WHITE) << "Rebuilding internal structures took: " << duration.count() << " s, "
+    << std::fixed << std::setprecision(0) << m_blocks.size() / std::max(duration.count(), 0.001) << " blocks/s";
+}
+
+void Blockchain::indexBlocks(uint32_t startHeight) {
+  // Hashing and deserialization run on worker threads a chunk of heights at a time,
+  // the maps are then filled in height order so output indexes stay the same
+  struct PreparedBlock {
+    std::shared_ptr<const BlockEntry> entry;
+    Crypto::Hash hash;
+    std::vector<Crypto::Hash> transactionHashes;
+  };
+
+  const uint32_t chunkSize = 1000;
+  size_t workersCount = std::thread::hardware_concurrency();
+  if (workersCount == 0) {
+    workersCount = 2;
+  }
+
+  uint32_t blocksCount = static_cast<uint32_t>(m_blocks.size());
+  std::vector<PreparedBlock> prepared;
+  for (uint32_t chunkStart = startHeight; chunkStart < blocksCount; chunkStart += chunkSize) {
+    std::chrono::steady_clock::time_point chunkTimePoint = std::chrono::steady_clock::now();
+    uint32_t chunkEnd = std::min(chunkStart + chunkSize, blocksCount);
+    prepared.clear();
+    prepared.resize(chunkEnd - chunkStart);
+
+    std::vector<std::future<void>> workers;
+    for (size_t w = 0; w < workersCount; ++w) {
+      workers.push_back(std::async(std::launch::async, [this, &prepared, chunkStart, chunkEnd, w, workersCount] {
+        for (uint32_t b = chunkStart + static_cast<uint32_t>(w); b < chunkEnd; b += static_cast<uint32_t>(workersCount)) {
+          PreparedBlock& block = prepared[b - chunkStart];
+          block.entry = m_blocks.get(b);
+          block.hash = get_block_hash(block.entry->bl);
+
+          // the stored transaction blobs are hashed together instead of reserializing each transaction
+          size_t transactionsCount = block.entry->transactions.size();
+          std::vector<const void*> blobs(transactionsCount);
+          std::vector<size_t> blobSizes(transactionsCount);
+          for (size_t t = 0; t < transactionsCount; ++t) {
+            Common::ArrayView<uint8_t> blob = m_blocks.transactionBlob(b, t);
+            blobs[t] = blob.getData();
+            blobSizes[t] = blob.getSize();
+          }
+
+          block.transactionHashes.resize(transactionsCount);
+          Crypto::cn_fast_hash_multi(blobs.data(), blobSizes.data(), transactionsCount, block.transactionHashes.data());
+        }
+      }));
     }
-    const BlockEntry& block = m_blocks[b];
-    Crypto::Hash blockHash = get_block_hash(block.bl);
-    m_blockIndex.push(blockHash);
-    for (uint16_t t = 0; t < block.transactions.size(); ++t) {
-      const TransactionEntry& transaction = block.transactions[t];
-      Crypto::Hash transactionHash = getObjectHash(transaction.tx);
-      TransactionIndex transactionIndex = { b, t };
-      m_transactionMap.insert(std::make_pair(transactionHash, transactionIndex));
-
-      // process inputs
-      for (auto& i : transaction.tx.inputs) {
-        if (i.type() == typeid(KeyInput)) {
-          m_spent_key_images.insert(std::make_pair(::boost::get<KeyInput>(i).keyImage, b));
-        } else if (i.type() == typeid(MultisignatureInput)) {
-          auto out = ::boost::get<MultisignatureInput>(i);
-          m_multisignatureOutputs[out.amount][out.outputIndex].isUsed = true;
+
+    for (auto& worker : workers) {
+      worker.get();
+    }
+
+    for (uint32_t b = chunkStart; b < chunkEnd; ++b) {
+      const PreparedBlock& preparedBlock = prepared[b - chunkStart];
+      const BlockEntry& block = *preparedBlock.entry;
+      m_blockIndex.push(preparedBlock.hash);
+      for (uint16_t t = 0; t < block.transactions.size(); ++t) {
+        const TransactionEntry& transaction = block.transactions[t];
+        TransactionIndex transactionIndex = { b, t };
+        m_transactionMap.insert(preparedBlock.transactionHashes[t], transactionIndex);
+
+        // process inputs
+        for (auto& i : transaction.tx.inputs) {
+          if (i.type() == typeid(KeyInput)) {
+            m_spent_key_images.insert(::boost::get<KeyInput>(i).keyImage, b);
+          } else if (i.type() == typeid(MultisignatureInput)) {
+            auto out = ::boost::get<MultisignatureInput>(i);
+            m_multisignatureOutputs[out.amount][out.outputIndex].isUsed = true;
+          }
         }
-      }
 
-      // process outputs
-      for (uint16_t o = 0; o < transaction.tx.outputs.size(); ++o) {
-        const auto& out = transaction.tx.outputs[o];
-        if (out.target.type() == typeid(KeyOutput)) {
-          m_outputs[out.amount].push_back(std::make_pair<>(transactionIndex, o));
-        } else if (out.target.type() == typeid(MultisignatureOutput)) {
-          MultisignatureOutputUsage usage = { transactionIndex, o, false };
-          m_multisignatureOutputs[out.amount].push_back(usage);
+        // process outputs
+        for (uint16_t o = 0; o < transaction.tx.outputs.size(); ++o) {
+          const auto& out = transaction.tx.outputs[o];
+          if (out.target.type() == typeid(KeyOutput)) {
+            m_outputs[out.amount].push_back(std::make_pair<>(transactionIndex, o));
+            OutputKeyInfo keyInfo = { ::boost::get<KeyOutput>(out.target).key, transaction.tx.unlockTime, b };
+            m_outputKeys[out.amount].push_back(keyInfo);
+          } else if (out.target.type() == typeid(MultisignatureOutput)) {
+            MultisignatureOutputUsage usage = { transactionIndex, o, false };
+            m_multisignatureOutputs[out.amount].push_back(usage);
+          }
         }
       }
     }
-  }
 
-  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - timePoint;
-  logger(INFO, BRIGHT_WHITE) << "Rebuilding internal structures took: " << duration.count();
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - chunkTimePoint;
+    logger(INFO, BRIGHT_WHITE) << "Height " << chunkEnd << " of " << blocksCount << ", "
+      << std::fixed << std::setprecision(0) << (chunkEnd - chunkStart) / std::max(duration.count(), 0.001) << " blocks/s";
+  }
 }
 
 bool Blockchain::storeCache() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   logger(INFO, BRIGHT_WHITE) << "Saving blockchain at height " << m_blocks.size() - 1 << "...";
   BlockCacheSerializer ser(*this, getTailId(), logger.getLogger());
@@ -620,14 +923,568 @@ bool Blockchain::storeCache() {
     return false;
   }
 
+  m_cacheSnapshotHeight = ser.height();
+  return true;
+}
+
+bool Blockchain::compactCache() {
+  uint32_t height;
+  {
+    Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+    height = getCurrentBlockchainHeight() - 1;
+  }
+
+  if (height < m_cacheSnapshotHeight + parameters::CRYPTONOTE_BLOCKSCACHE_SNAPSHOT_INTERVAL) {
+    return true;
+  }
+
+  return storeCache();
+}
+
+namespace {
+
+const char BOOTSTRAP_MANIFEST_FILE_NAME[] = "bootstrap.json";
+const size_t BOOTSTRAP_HASH_CHUNK_SIZE = 16 * 1024 * 1024;
+const char BOOTSTRAP_STAGING_FOLDER[] = "bootstrap.tmp";
+const uint32_t BOOTSTRAP_CHECKED_BLOCKS = 256; // spread over the chain, the top block included
+
+struct BootstrapFile {
+  std::string name;
+  uint64_t size;
+  Crypto::Hash hash;
+
+  void serialize(ISerializer& s) {
+    KV_MEMBER(name)
+    KV_MEMBER(size)
+    KV_MEMBER(hash)
+  }
+};
+
+struct BootstrapManifest {
+  uint32_t height;
+  Crypto::Hash blockHash;
+  std::vector<BootstrapFile> files;
+
+  void serialize(ISerializer& s) {
+    KV_MEMBER(height)
+    KV_MEMBER(blockHash)
+    KV_MEMBER(files)
+  }
+};
+
+// The files are hashed a chunk at a time, the result is the hash of the chunk hashes
+bool hashBootstrapFile(const std::string& path, uint64_t& size, Crypto::Hash& hash) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  std::vector<char> buffer(BOOTSTRAP_HASH_CHUNK_SIZE);
+  std::vector<Crypto::Hash> chunkHashes;
+  size = 0;
+  while (file) {
+    file.read(buffer.data(), buffer.size());
+    size_t count = static_cast<size_t>(file.gcount());
+    if (count == 0) {
+      break;
+    }
+
+    chunkHashes.push_back(Crypto::cn_fast_hash(buffer.data(), count));
+    size += count;
+  }
+
+  if (file.bad()) {
+    return false;
+  }
+
+  hash = Crypto::cn_fast_hash(chunkHashes.data(), chunkHashes.size() * sizeof(Crypto::Hash));
+  return true;
+}
+
+std::vector<std::string> bootstrapFileNames(const Currency& currency) {
+  return { currency.blockStoreFileName(), currency.blockStoreFileName() + ".index", currency.blockStoreFileName() + ".txs",
+    currency.blocksCacheFileName(), "transactionsmap.dat", "spentkeys.dat" };
+}
+
+}
+
+bool Blockchain::exportBootstrap(const std::string& folder) {
+  if (!Tools::create_directories_if_necessary(folder)) {
+    logger(ERROR, BRIGHT_RED) << "Failed to create bootstrap directory " << folder;
+    return false;
+  }
+
+  BootstrapManifest manifest;
+  {
+    Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+
+    // without checkpoints, e.g. in testnet, the snapshot is taken at the top block
+    manifest.height = static_cast<uint32_t>(m_blocks.size() - 1);
+    std::vector<uint32_t> checkpointHeights = m_checkpoints.getCheckpointHeights();
+    if (!checkpointHeights.empty()) {
+      auto it = std::upper_bound(checkpointHeights.begin(), checkpointHeights.end(), manifest.height);
+      if (it == checkpointHeights.begin()) {
+        logger(ERROR, BRIGHT_RED) << "The blockchain hasn't reached the first checkpoint at " << checkpointHeights.front();
+        return false;
+      }
+
+      manifest.height = *(it - 1);
+    }
+
+    manifest.blockHash = getBlockIdByHeight(manifest.height);
+
+    logger(INFO, BRIGHT_WHITE) << "Exporting " << manifest.height + 1 << " blocks to " << folder << "...";
+    BlockStore<BlockEntry> store;
+    if (!store.open(appendPath(folder, m_currency.blockStoreFileName()), 1024 * 1024) || !store.empty()) {
+      logger(ERROR, BRIGHT_RED) << "Failed to create an empty block store in " << folder;
+      return false;
+    }
+
+    for (uint32_t i = 0; i <= manifest.height; ++i) {
+      store.push_back(m_blocks.load(i));
+    }
+  }
+
+  // the cache is built the same way as when it is missing on start
+  {
+    Blockchain snapshot(m_currency, m_tx_pool, logger.getLogger(), false);
+    if (!snapshot.init(folder, true) || !snapshot.storeCache()) {
+      logger(ERROR, BRIGHT_RED) << "Failed to build the blockchain cache in " << folder;
+      return false;
+    }
+  }
+
+  for (const std::string& name : bootstrapFileNames(m_currency)) {
+    BootstrapFile file;
+    file.name = name;
+    if (!hashBootstrapFile(appendPath(folder, name), file.size, file.hash)) {
+      logger(ERROR, BRIGHT_RED) << "Failed to read " << appendPath(folder, name);
+      return false;
+    }
+
+    manifest.files.push_back(file);
+  }
+
+  if (!Common::saveStringToFile(appendPath(folder, BOOTSTRAP_MANIFEST_FILE_NAME), storeToJson(manifest))) {
+    logger(ERROR, BRIGHT_RED) << "Failed to write " << appendPath(folder, BOOTSTRAP_MANIFEST_FILE_NAME);
+    return false;
+  }
+
+  logger(INFO, BRIGHT_GREEN) << "Bootstrap snapshot at height " << manifest.height << " written to " << folder;
   return true;
 }
 
+bool Blockchain::importBootstrap(const std::string& folder, const std::string& config_folder) {
+  std::string blockStoreFile = appendPath(config_folder, m_currency.blockStoreFileName());
+  boost::system::error_code ec;
+  if (boost::filesystem::file_size(blockStoreFile + ".index", ec) > 0 && !ec) {
+    logger(INFO, BRIGHT_WHITE) << "The data directory already has a blockchain, bootstrap snapshot ignored";
+    return true;
+  }
+
+  std::string manifestJson;
+  BootstrapManifest manifest;
+  if (!Common::loadFileToString(appendPath(folder, BOOTSTRAP_MANIFEST_FILE_NAME), manifestJson) || !loadFromJson(manifest, manifestJson)) {
+    logger(ERROR, BRIGHT_RED) << "Failed to read " << appendPath(folder, BOOTSTRAP_MANIFEST_FILE_NAME);
+    return false;
+  }
+
+  bool isCheckpoint = false;
+  if (!m_checkpoints.check_block(manifest.height, manifest.blockHash, isCheckpoint)) {
+    logger(ERROR, BRIGHT_RED) << "Bootstrap snapshot block " << manifest.blockHash << " at height " << manifest.height << " doesn't match the checkpoint";
+    return false;
+  }
+
+  if (!isCheckpoint) {
+    if (!m_checkpoints.getCheckpointHeights().empty()) {
+      logger(ERROR, BRIGHT_RED) << "Bootstrap snapshot height " << manifest.height << " isn't a checkpoint";
+      return false;
+    }
+
+    logger(WARNING, BRIGHT_YELLOW) << "No checkpoints loaded, the bootstrap snapshot at height " << manifest.height << " can't be verified";
+  }
+
+  std::vector<std::string> names = bootstrapFileNames(m_currency);
+  if (manifest.files.size() != names.size()) {
+    logger(ERROR, BRIGHT_RED) << "Bootstrap snapshot has " << manifest.files.size() << " files, " << names.size() << " expected";
+    return false;
+  }
+
+  logger(INFO, BRIGHT_WHITE) << "Verifying the bootstrap snapshot at height " << manifest.height << "...";
+  for (size_t i = 0; i < names.size(); ++i) {
+    uint64_t size;
+    Crypto::Hash hash;
+    if (manifest.files[i].name != names[i] || !hashBootstrapFile(appendPath(folder, names[i]), size, hash) ||
+        size != manifest.files[i].size || hash != manifest.files[i].hash) {
+      logger(ERROR, BRIGHT_RED) << "Bootstrap snapshot file " << appendPath(folder, names[i]) << " is missing or damaged";
+      return false;
+    }
+  }
+
+  // the copy is checked in a folder of its own, the block store is renamed before the cache files,
+  // if they don't make it the blocks are replayed on start
+  std::string stagingFolder = appendPath(config_folder, BOOTSTRAP_STAGING_FOLDER);
+  try {
+    boost::filesystem::remove_all(stagingFolder);
+    boost::filesystem::create_directory(stagingFolder);
+    for (const std::string& name : names) {
+      boost::filesystem::copy_file(appendPath(folder, name), appendPath(stagingFolder, name));
+    }
+  } catch (std::exception& e) {
+    logger(ERROR, BRIGHT_RED) << "Failed to copy the bootstrap snapshot: " << e.what();
+    return false;
+  }
+
+  if (!checkBootstrapIndexes(stagingFolder, manifest.height, manifest.blockHash)) {
+    boost::filesystem::remove_all(stagingFolder, ec);
+    return false;
+  }
+
+  try {
+    for (const std::string& name : names) {
+      boost::filesystem::rename(appendPath(stagingFolder, name), appendPath(config_folder, name));
+    }
+
+    boost::filesystem::remove_all(stagingFolder);
+  } catch (std::exception& e) {
+    logger(ERROR, BRIGHT_RED) << "Failed to move the bootstrap snapshot: " << e.what();
+    return false;
+  }
+
+  logger(INFO, BRIGHT_GREEN) << "Bootstrap snapshot imported, " << manifest.height + 1 << " blocks";
+  return true;
+}
+
+bool Blockchain::checkBootstrapIndexes(const std::string& folder, uint32_t height, const Crypto::Hash& blockHash) {
+  Blockchain snapshot(m_currency, m_tx_pool, logger.getLogger(), false);
+  snapshot.m_config_folder = folder;
+  if (!snapshot.m_blocks.open(appendPath(folder, m_currency.blockStoreFileName()), BLOCK_CACHE_SIZE)) {
+    logger(ERROR, BRIGHT_RED) << "Failed to open the bootstrap block store";
+    return false;
+  }
+
+  if (snapshot.m_blocks.size() != static_cast<uint64_t>(height) + 1 || get_block_hash(snapshot.m_blocks.back().bl) != blockHash) {
+    logger(ERROR, BRIGHT_RED) << "Bootstrap block store has " << snapshot.m_blocks.size() << " blocks, " << height + 1 << " with top block " << blockHash << " expected";
+    return false;
+  }
+
+  BlockCacheSerializer loader(snapshot, blockHash, logger.getLogger());
+  loader.load(appendPath(folder, m_currency.blocksCacheFileName()));
+  if (!loader.loaded() || loader.height() != height || snapshot.m_blockIndex.size() != height + 1) {
+    logger(ERROR, BRIGHT_RED) << "Bootstrap blockchain cache doesn't match its block store";
+    return false;
+  }
+
+  // a sample of blocks is looked up the way a synced node would
+  uint32_t checkedBlocks = std::min(height + 1, BOOTSTRAP_CHECKED_BLOCKS);
+  for (uint32_t i = 0; i < checkedBlocks; ++i) {
+    uint32_t b = height - static_cast<uint32_t>(static_cast<uint64_t>(height) * i / checkedBlocks);
+    const BlockEntry& block = snapshot.m_blocks[b];
+    bool valid = snapshot.m_blockIndex.getBlockId(b) == get_block_hash(block.bl);
+    for (uint16_t t = 0; valid && t < block.transactions.size(); ++t) {
+      Common::ArrayView<uint8_t> blob = snapshot.m_blocks.transactionBlob(b, t);
+      TransactionIndex transactionIndex;
+      valid = snapshot.m_transactionMap.find(Crypto::cn_fast_hash(blob.getData(), blob.getSize()), transactionIndex) &&
+        transactionIndex.block == b && transactionIndex.transaction == t;
+
+      for (const auto& input : block.transactions[t].tx.inputs) {
+        uint32_t spentHeight;
+        if (valid && input.type() == typeid(KeyInput)) {
+          valid = snapshot.m_spent_key_images.find(::boost::get<KeyInput>(input).keyImage, spentHeight) && spentHeight == b;
+        }
+      }
+    }
+
+    if (!valid) {
+      logger(ERROR, BRIGHT_RED) << "Bootstrap blockchain cache doesn't match block " << b;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool Blockchain::exportBlocks(const std::string& fileName) {
+  std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    logger(ERROR, BRIGHT_RED) << "Failed to create " << fileName;
+    return false;
+  }
+
+  uint32_t height = 0;
+  std::string data;
+  for (;;) {
+    data.clear();
+    uint32_t visited = visitRawBlocks(height, BLOCKS_EXPORT_CHUNK_SIZE, [&data](const RawBlock& rawBlock) {
+      appendBlockRecord(data, rawBlock);
+      return true;
+    });
+
+    if (visited == 0) {
+      break;
+    }
+
+    file.write(data.data(), data.size());
+    if (!file) {
+      logger(ERROR, BRIGHT_RED) << "Failed to write " << fileName;
+      return false;
+    }
+
+    height += visited;
+    logger(INFO, BRIGHT_WHITE) << "Exported " << height << " blocks";
+  }
+
+  logger(INFO, BRIGHT_GREEN) << "Exported " << height << " blocks to " << fileName;
+  return true;
+}
+
+bool Blockchain::importBlocks(const std::string& fileName) {
+  struct ImportedBlock {
+    Block block;
+    Crypto::Hash hash;
+    std::vector<Transaction> transactions;
+    std::vector<size_t> transactionSizes;
+    std::string error;
+  };
+
+  std::ifstream file(fileName, std::ios::binary);
+  if (!file) {
+    logger(ERROR, BRIGHT_RED) << "Failed to open " << fileName;
+    return false;
+  }
+
+  size_t workersCount = std::thread::hardware_concurrency();
+  if (workersCount == 0) {
+    workersCount = 2;
+  }
+
+  std::lock_guard<decltype(m_tx_pool)> poolLock(m_tx_pool);
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  std::chrono::steady_clock::time_point timePoint = std::chrono::steady_clock::now();
+  uint32_t startHeight = static_cast<uint32_t>(m_blocks.size());
+
+  // While the blocks are under checkpoints only the block store and the header columns grow,
+  // the maps and the indices are filled by indexBlocks once the deferred blocks end. The global
+  // output indexes are counted here, they are stored with the blocks.
+  uint32_t deferredStart = static_cast<uint32_t>(m_blocks.size());
+  bool deferring = m_checkpoints.is_in_checkpoint_zone(deferredStart);
+  Crypto::Hash tailHash = getTailId();
+  std::unordered_map<uint64_t, uint32_t> keyOutputCounts;
+  std::unordered_map<uint64_t, uint32_t> multisignatureOutputCounts;
+  auto nextOutputIndex = [](std::unordered_map<uint64_t, uint32_t>& counts, uint64_t amount, size_t stored) {
+    auto it = counts.emplace(amount, static_cast<uint32_t>(stored)).first;
+    return it->second++;
+  };
+
+  auto pushDeferredBlock = [&](ImportedBlock& imported) {
+    const Block& block = imported.block;
+    uint32_t height = static_cast<uint32_t>(m_blocks.size());
+    if (block.previousBlockHash != tailHash || !checkBlockVersion(block, imported.hash) || !check_block_timestamp_main(block) ||
+        !m_checkpoints.check_block(height, imported.hash) || !prevalidate_miner_transaction(block, height)) {
+      return false;
+    }
+
+    difficulty_type difficulty = getDifficultyForNextBlock();
+    BlockEntry entry;
+    entry.bl = block;
+    entry.height = height;
+    entry.block_cumulative_size = getObjectBinarySize(block.baseTransaction);
+    entry.transactions.resize(imported.transactions.size() + 1);
+    entry.transactions[0].tx = block.baseTransaction;
+    uint64_t fee = 0;
+    for (size_t i = 0; i < imported.transactions.size(); ++i) {
+      entry.transactions[i + 1].tx = std::move(imported.transactions[i]);
+      entry.block_cumulative_size += imported.transactionSizes[i];
+      fee += getInputAmount(entry.transactions[i + 1].tx) - getOutputAmount(entry.transactions[i + 1].tx);
+    }
+
+    uint64_t reward = 0;
+    int64_t emissionChange = 0;
+    uint64_t alreadyGeneratedCoins = m_blockColumns.empty() ? 0 : m_blockColumns.generatedCoins().back();
+    if (!checkCumulativeBlockSize(imported.hash, entry.block_cumulative_size, height) ||
+        !validate_miner_transaction(block, height, entry.block_cumulative_size, alreadyGeneratedCoins, fee, reward, emissionChange)) {
+      return false;
+    }
+
+    entry.already_generated_coins = alreadyGeneratedCoins + emissionChange;
+    entry.cumulative_difficulty = difficulty + (m_blockColumns.empty() ? 0 : m_blockColumns.cumulativeDifficulties().back());
+    for (TransactionEntry& transaction : entry.transactions) {
+      transaction.m_global_output_indexes.resize(transaction.tx.outputs.size());
+      for (size_t o = 0; o < transaction.tx.outputs.size(); ++o) {
+        const TransactionOutput& output = transaction.tx.outputs[o];
+        if (output.target.type() == typeid(KeyOutput)) {
+          auto stored = m_outputs.find(output.amount);
+          transaction.m_global_output_indexes[o] = nextOutputIndex(keyOutputCounts, output.amount, stored == m_outputs.end() ? 0 : stored->second.size());
+        } else if (output.target.type() == typeid(MultisignatureOutput)) {
+          auto stored = m_multisignatureOutputs.find(output.amount);
+          transaction.m_global_output_indexes[o] = nextOutputIndex(multisignatureOutputCounts, output.amount, stored == m_multisignatureOutputs.end() ? 0 : stored->second.size());
+        }
+      }
+    }
+
+    m_blocks.push_back(entry);
+    m_blockColumns.push(block.timestamp, entry.cumulative_difficulty, entry.block_cumulative_size, entry.already_generated_coins,
+      static_cast<uint32_t>(entry.transactions.size()));
+    m_lastBlocksSizes.push_back(entry.block_cumulative_size);
+    if (m_lastBlocksSizes.size() > m_currency.rewardBlocksWindow()) {
+      m_lastBlocksSizes.pop_front();
+    }
+
+    m_upgradeDetectorV2.blockPushed();
+    m_upgradeDetectorV3.blockPushed();
+    m_upgradeDetectorV4.blockPushed();
+    m_upgradeDetectorV5.blockPushed();
+    update_next_cumulative_size_limit();
+    tailHash = imported.hash;
+    return true;
+  };
+
+  auto finishDeferred = [&] {
+    if (deferredStart == m_blocks.size()) {
+      return;
+    }
+
+    logger(INFO, BRIGHT_WHITE) << "Indexing the imported blocks from height " << deferredStart << "...";
+    indexBlocks(deferredStart);
+    if (m_blockchainIndexesEnabled) {
+      addBlockchainIndices(deferredStart);
+    }
+
+    m_tx_pool.on_blockchain_inc(m_blocks.size(), tailHash);
+  };
+
+  bool failed = false;
+  std::vector<BlockRecord> records;
+  std::vector<ImportedBlock> chunk;
+  try {
+    for (;;) {
+      records.clear();
+      BlockRecord record;
+      while (records.size() < BLOCKS_IMPORT_CHUNK_SIZE && readBlockRecord(file, record)) {
+        // the blocks the chain already has are skipped
+        if (record.height >= m_blocks.size() + records.size()) {
+          if (record.height != m_blocks.size() + records.size()) {
+            throw std::runtime_error("Block " + std::to_string(record.height) + " doesn't continue the chain at height " + std::to_string(m_blocks.size() + records.size()));
+          }
+
+          records.push_back(std::move(record));
+        }
+      }
+
+      if (records.empty()) {
+        break;
+      }
+
+      // the records are parsed and hashed in parallel, then pushed in height order
+      chunk.clear();
+      chunk.resize(records.size());
+      std::vector<std::future<void>> workers;
+      for (size_t w = 0; w < workersCount; ++w) {
+        workers.push_back(std::async(std::launch::async, [&records, &chunk, w, workersCount] {
+          for (size_t i = w; i < records.size(); i += workersCount) {
+            ImportedBlock& imported = chunk[i];
+            const BlockRecord& record = records[i];
+            if (record.transactions.empty() || !fromBinaryArray(imported.block, record.block) || !get_block_hash(imported.block, imported.hash) ||
+                imported.block.transactionHashes.size() + 1 != record.transactions.size()) {
+              imported.error = "malformed block";
+              continue;
+            }
+
+            imported.transactions.resize(record.transactions.size() - 1);
+            imported.transactionSizes.resize(record.transactions.size() - 1);
+            for (size_t t = 1; t < record.transactions.size(); ++t) {
+              if (!fromBinaryArray(imported.transactions[t - 1], record.transactions[t]) ||
+                  getBinaryArrayHash(record.transactions[t]) != imported.block.transactionHashes[t - 1]) {
+                imported.error = "malformed transaction " + std::to_string(t);
+                break;
+              }
+
+              imported.transactionSizes[t - 1] = record.transactions[t].size();
+            }
+          }
+        }));
+      }
+
+      for (auto& worker : workers) {
+        worker.get();
+      }
+
+      size_t hashedUntil = 0;
+      for (size_t i = 0; i < chunk.size(); ++i) {
+        uint32_t height = static_cast<uint32_t>(m_blocks.size());
+        ImportedBlock& imported = chunk[i];
+        if (!imported.error.empty()) {
+          throw std::runtime_error("Block " + std::to_string(height) + ": " + imported.error);
+        }
+
+        if (deferring && !m_checkpoints.is_in_checkpoint_zone(height)) {
+          finishDeferred();
+          deferring = false;
+        }
+
+        if (deferring) {
+          if (!pushDeferredBlock(imported)) {
+            throw std::runtime_error("Block " + std::to_string(height) + " " + Common::podToHex(imported.hash) + " failed verification");
+          }
+
+          continue;
+        }
+
+        // above the checkpoints every block is verified in full, the proofs of work of the rest of the chunk are hashed in parallel first
+        if (i >= hashedUntil) {
+          std::vector<Block> blocks;
+          for (size_t j = i; j < chunk.size(); ++j) {
+            blocks.push_back(chunk[j].block);
+          }
+
+          precomputeLongHashes(blocks);
+          hashedUntil = chunk.size();
+        }
+
+        block_verification_context bvc = boost::value_initialized<block_verification_context>();
+        if (!pushBlock(imported.block, imported.transactions, imported.hash, bvc)) {
+          throw std::runtime_error("Block " + std::to_string(height) + " " + Common::podToHex(imported.hash) + " failed verification");
+        }
+      }
+
+      logger(INFO, BRIGHT_WHITE) << "Imported blocks up to height " << m_blocks.size() - 1;
+    }
+  } catch (std::exception& e) {
+    logger(ERROR, BRIGHT_RED) << "Failed to import blocks from " << fileName << ": " << e.what();
+    failed = true;
+  }
+
+  // the blocks pushed before a failure are kept
+  if (deferring) {
+    finishDeferred();
+  }
+
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - timePoint;
+  logger(INFO, BRIGHT_WHITE) << "Imported " << m_blocks.size() - startHeight << " blocks in " << duration.count() << " s, "
+    << std::fixed << std::setprecision(0) << (m_blocks.size() - startHeight) / std::max(duration.count(), 0.001) << " blocks/s";
+  if (m_blocks.size() != startHeight) {
+    m_observerManager.notify(&IBlockchainStorageObserver::blockchainUpdated);
+  }
+
+  return !failed;
+}
+
 bool Blockchain::deinit() {
-  storeCache();
+  uint32_t height = getCurrentBlockchainHeight() - 1;
+  if (height >= m_cacheSnapshotHeight && height < m_cacheSnapshotHeight + parameters::CRYPTONOTE_BLOCKSCACHE_SNAPSHOT_INTERVAL) {
+    logger(INFO, BRIGHT_WHITE) << "Blockchain cache is " << height - m_cacheSnapshotHeight << " blocks behind, they will be replayed on the next start";
+  } else {
+    storeCache();
+  }
+
   if (m_blockchainIndexesEnabled) {
     storeBlockchainIndices();
   }
+
+  // the tables are only marked complete here, if this isn't reached they are rebuilt
+  m_transactionMap.closeFile();
+  m_spent_key_images.closeFile();
+  m_paymentIdIndex.close();
   assert(m_messageQueueList.empty());
   return true;
 }
@@ -635,17 +1492,22 @@ bool Blockchain::deinit() {
 bool Blockchain::resetAndSetGenesisBlock(const Block& b) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   m_blocks.clear();
+  m_blockColumns.clear();
+  m_lastBlocksSizes.clear();
   m_blockIndex.clear();
   m_transactionMap.clear();
 
   m_spent_key_images.clear();
   m_alternative_chains.clear();
   m_outputs.clear();
+  m_outputKeys.clear();
 
   m_paymentIdIndex.clear();
   m_timestampIndex.clear();
   m_generatedTransactionsIndex.clear();
   m_orphanBlocksIndex.clear();
+  m_blockFilterIndex.clear();
+  m_blockSummaryIndex.clear();
 
   block_verification_context bvc = boost::value_initialized<block_verification_context>();
   addNewBlock(b, bvc);
@@ -654,24 +1516,24 @@ bool Blockchain::resetAndSetGenesisBlock(const Block& b) {
 
 Crypto::Hash Blockchain::getTailId(uint32_t& height) {
   assert(!m_blocks.empty());
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   height = getCurrentBlockchainHeight() - 1;
   return getTailId();
 }
 
 Crypto::Hash Blockchain::getTailId() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_blocks.empty() ? NULL_HASH : m_blockIndex.getTailId();
 }
 
 std::vector<Crypto::Hash> Blockchain::buildSparseChain() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   assert(m_blockIndex.size() != 0);
   return doBuildSparseChain(m_blockIndex.getTailId());
 }
 
 std::vector<Crypto::Hash> Blockchain::buildSparseChain(const Crypto::Hash& startBlockId) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   assert(haveBlock(startBlockId));
   return doBuildSparseChain(startBlockId);
 }
@@ -708,18 +1570,18 @@ std::vector<Crypto::Hash> Blockchain::doBuildSparseChain(const Crypto::Hash& sta
 }
 
 Crypto::Hash Blockchain::getBlockIdByHeight(uint32_t height) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   assert(height < m_blockIndex.size());
   return m_blockIndex.getBlockId(height);
 }
 
 bool Blockchain::getBlockByHash(const Crypto::Hash& blockHash, Block& b) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   uint32_t height = 0;
 
   if (m_blockIndex.getBlockHeight(blockHash, height)) {
-    b = m_blocks[height].bl;
+    b = m_blocks.get(height)->bl;
     return true;
   }
 
@@ -735,16 +1597,16 @@ bool Blockchain::getBlockByHash(const Crypto::Hash& blockHash, Block& b) {
 }
 
 bool Blockchain::getBlockHeight(const Crypto::Hash& blockId, uint32_t& blockHeight) {
-  std::lock_guard<decltype(m_blockchain_lock)> lock(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lock(m_blockchain_lock);
   return m_blockIndex.getBlockHeight(blockId, blockHeight);
 }
 
 bool Blockchain::getTransactionHeight(const Crypto::Hash &txId, uint32_t& blockHeight) {
-  std::lock_guard<decltype(m_blockchain_lock)> bcLock(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> bcLock(m_blockchain_lock);
 
-  auto it = m_transactionMap.find(txId);
-  if (it != m_transactionMap.end()) {
-    blockHeight = it->second.block;
+  TransactionIndex transactionIndex;
+  if (m_transactionMap.find(txId, transactionIndex)) {
+    blockHeight = transactionIndex.block;
     return true;
   }
 
@@ -752,31 +1614,45 @@ bool Blockchain::getTransactionHeight(const Crypto::Hash &txId, uint32_t& blockH
 }
 
 difficulty_type Blockchain::getDifficultyForNextBlock() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  uint8_t BlockMajorVersion = getBlockMajorVersionForHeight(static_cast<uint32_t>(m_blocks.size()));
+  {
+    // block templates, RPC and the validation of the next block all ask for the same value
+    std::lock_guard<std::mutex> cacheLock(m_nextDifficultyLock);
+    if (m_nextDifficultyRevision == m_blockColumns.revision() && m_nextDifficultyVersion == BlockMajorVersion) {
+      return m_nextDifficulty;
+    }
+  }
+
   std::vector<uint64_t> timestamps;
   std::vector<difficulty_type> cumulative_difficulties;
-  uint8_t BlockMajorVersion = getBlockMajorVersionForHeight(static_cast<uint32_t>(m_blocks.size()));
   size_t offset;
   offset = m_blocks.size() - std::min<size_t>(m_blocks.size(), static_cast<size_t>(m_currency.difficultyBlocksCountByBlockVersion(BlockMajorVersion)));
 
   if (offset == 0) {
     ++offset;
   }
-  for (; offset < m_blocks.size(); offset++) {
-    timestamps.push_back(m_blocks[offset].bl.timestamp);
-    cumulative_difficulties.push_back(m_blocks[offset].cumulative_difficulty);
+  if (offset < m_blockColumns.size()) {
+    timestamps.assign(m_blockColumns.timestamps().begin() + offset, m_blockColumns.timestamps().end());
+    cumulative_difficulties.assign(m_blockColumns.cumulativeDifficulties().begin() + offset, m_blockColumns.cumulativeDifficulties().end());
   }
-  return m_currency.nextDifficulty(static_cast<uint32_t>(m_blocks.size()), BlockMajorVersion, timestamps, cumulative_difficulties);
+
+  difficulty_type difficulty = m_currency.nextDifficulty(static_cast<uint32_t>(m_blocks.size()), BlockMajorVersion, timestamps, cumulative_difficulties);
+  std::lock_guard<std::mutex> cacheLock(m_nextDifficultyLock);
+  m_nextDifficultyRevision = m_blockColumns.revision();
+  m_nextDifficultyVersion = BlockMajorVersion;
+  m_nextDifficulty = difficulty;
+  return difficulty;
 }
 
 difficulty_type Blockchain::getAvgDifficulty(uint32_t height, size_t window) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   height = std::min<uint32_t>(height, (uint32_t)m_blocks.size() - 1);
   if (height <= 1)
     return 1;
 
   if (window == height) {
-    return m_blocks[height].cumulative_difficulty / height;
+    return m_blockColumns.cumulativeDifficulties()[height] / height;
   }
 
   size_t offset;
@@ -784,24 +1660,24 @@ difficulty_type Blockchain::getAvgDifficulty(uint32_t height, size_t window) {
   if (offset == 0) {
     ++offset;
   }
-  difficulty_type cumulDiffForPeriod = m_blocks[height].cumulative_difficulty - m_blocks[offset].cumulative_difficulty;
+  difficulty_type cumulDiffForPeriod = m_blockColumns.cumulativeDifficulties()[height] - m_blockColumns.cumulativeDifficulties()[offset];
   return cumulDiffForPeriod / std::min<uint32_t>(static_cast<uint32_t>(m_blocks.size() - 1), static_cast<uint32_t>(window));
 }
 
 difficulty_type Blockchain::getAvgDifficulty(uint32_t height) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (height <= 1)
     return 1;
-  return m_blocks[std::min<difficulty_type>(height, m_blocks.size())].cumulative_difficulty / std::min<difficulty_type>(height, m_blocks.size());
+  return m_blockColumns.cumulativeDifficulties().at(std::min<size_t>(height, m_blocks.size() - 1)) / std::min<difficulty_type>(height, m_blocks.size());
 }
 
 uint64_t Blockchain::getBlockTimestamp(uint32_t height) {
   assert(height < m_blocks.size());
-  return m_blocks[height].bl.timestamp;
+  return m_blockColumns.timestamps()[height];
 }
 
 uint64_t Blockchain::getMinimalFee(uint32_t height) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (height == 0 || m_blocks.size() <= 1) {
     return 0;
   }
@@ -827,31 +1703,31 @@ uint64_t Blockchain::getMinimalFee(uint32_t height) {
   // calculate average difficulty for ~last month
   uint64_t avgCurrentDifficulty = getAvgDifficulty(height, window * 7 * 4);
   // reference trailing average difficulty
-  uint64_t avgReferenceDifficulty = m_blocks[height].cumulative_difficulty / height;
+  uint64_t avgReferenceDifficulty = m_blockColumns.cumulativeDifficulties().at(height) / height;
   // calculate current base reward
-  uint64_t currentReward = m_currency.calculateReward(m_blocks[height].already_generated_coins);
+  uint64_t currentReward = m_currency.calculateReward(m_blockColumns.generatedCoins().at(height));
   // reference trailing average reward
-  uint64_t avgReferenceReward = m_blocks[height].already_generated_coins / height;
+  uint64_t avgReferenceReward = m_blockColumns.generatedCoins().at(height) / height;
 
   return m_currency.getMinimalFee(avgCurrentDifficulty, currentReward, avgReferenceDifficulty, avgReferenceReward, height);
 }
 
 uint64_t Blockchain::getCoinsInCirculation() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (m_blocks.empty()) {
     return 0;
   } else {
-    return m_blocks.back().already_generated_coins;
+    return m_blockColumns.generatedCoins().back();
   }
 }
 
 uint64_t Blockchain::getCoinsInCirculation(uint32_t height) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (m_blocks.empty()) {
     return 0;
   }
   else {
-    return m_blocks[height].already_generated_coins;
+    return m_blockColumns.generatedCoins().at(height);
   }
 }
 
@@ -869,19 +1745,16 @@ uint8_t Blockchain::getBlockMajorVersionForHeight(uint32_t height) const {
   }
 }
 
-bool Blockchain::rollback_blockchain_switching(std::list<Block> &original_chain, size_t rollback_height) {
+bool Blockchain::rollback_blockchain_switching(std::list<DisconnectedBlock> &original_chain, size_t rollback_height) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   // remove failed subchain
   for (size_t i = m_blocks.size() - 1; i >= rollback_height; i--) {
     popBlock();
   }
 
-  // return back original chain
-  for (auto &bl : original_chain) {
-    block_verification_context bvc =
-      boost::value_initialized<block_verification_context>();
-    bool r = pushBlock(bl, get_block_hash(bl), bvc);
-    if (!(r && bvc.m_added_to_main_chain)) {
+  // return back original chain, it was valid before the switch
+  for (auto &block : original_chain) {
+    if (!reconnectBlock(block)) {
       logger(ERROR, BRIGHT_RED) << "PANIC!!! failed to add (again) block while "
         "chain switching during the rollback!";
       return false;
@@ -892,6 +1765,58 @@ bool Blockchain::rollback_blockchain_switching(std::list<Block> &original_chain,
   return true;
 }
 
+void Blockchain::disconnectBlock(DisconnectedBlock& block) {
+  // in full, reconnectBlock stores it again
+  block.entry = m_blocks.load(m_blocks.size() - 1);
+  block.hash = m_blockIndex.getTailId();
+  block.hasSummary = m_blockSummaryIndex.find(block.entry.height, block.summary);
+  popBlock();
+}
+
+// Applies the same changes as the validating pushBlock to a block that was on the main chain
+bool Blockchain::reconnectBlock(DisconnectedBlock& block) {
+  assert(block.entry.height == m_blocks.size());
+  if (block.entry.bl.previousBlockHash != getTailId()) {
+    return false;
+  }
+
+  // popBlock returned the transactions to the pool
+  Transaction transaction;
+  size_t transactionSize;
+  uint64_t fee;
+  for (const auto& transactionHash : block.entry.bl.transactionHashes) {
+    m_tx_pool.take_tx(transactionHash, transaction, transactionSize, fee);
+  }
+
+  TransactionIndex transactionIndex = { block.entry.height, 0 };
+  for (; transactionIndex.transaction < block.entry.transactions.size(); ++transactionIndex.transaction) {
+    const Crypto::Hash& transactionHash = transactionIndex.transaction == 0 ? getObjectHash(block.entry.bl.baseTransaction) :
+      block.entry.bl.transactionHashes[transactionIndex.transaction - 1];
+    if (!pushTransaction(block.entry, transactionHash, transactionIndex)) {
+      if (transactionIndex.transaction != 0) {
+        block.entry.transactions.resize(transactionIndex.transaction);
+        popTransactions(block.entry, getObjectHash(block.entry.bl.baseTransaction));
+      }
+
+      return false;
+    }
+  }
+
+  pushBlock(block.entry, block.hash);
+  if (block.hasSummary) {
+    m_blockSummaryIndex.add(block.summary);
+  }
+
+  m_upgradeDetectorV2.blockPushed();
+  m_upgradeDetectorV3.blockPushed();
+  m_upgradeDetectorV4.blockPushed();
+  m_upgradeDetectorV5.blockPushed();
+
+  update_next_cumulative_size_limit();
+  m_tx_pool.on_blockchain_inc(m_blocks.size(), block.hash);
+  return true;
+}
+
 bool Blockchain::switch_to_alternative_blockchain(std::list<blocks_ext_by_hash::iterator>& alt_chain, bool discard_disconnected_chain) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
@@ -974,35 +1899,25 @@ bool Blockchain::switch_to_alternative_blockchain(std::list<blocks_ext_by_hash::
   }
 
   // Compare transactions in proposed alt chain vs current main chain and reject if some transaction is missing in the alt chain
-  std::vector<Crypto::Hash> mainChainTxHashes, altChainTxHashes;
-  for (size_t i = m_blocks.size() - 1; i >= split_height; i--) {
-    Block b = m_blocks[i].bl;
-    std::copy(b.transactionHashes.begin(), b.transactionHashes.end(), std::inserter(mainChainTxHashes, mainChainTxHashes.end()));
-  }
+  std::unordered_set<Crypto::Hash> altChainTxHashes;
   for (auto alt_ch_iter = alt_chain.begin(); alt_ch_iter != alt_chain.end(); alt_ch_iter++) {
-    auto ch_ent = *alt_ch_iter;
-    Block b = ch_ent->second.bl;
-    std::copy(b.transactionHashes.begin(), b.transactionHashes.end(), std::inserter(altChainTxHashes, altChainTxHashes.end()));
-  }
-  for (auto main_ch_it = mainChainTxHashes.begin(); main_ch_it != mainChainTxHashes.end(); main_ch_it++) {
-    auto tx_hash = *main_ch_it;
-    if (std::find(altChainTxHashes.begin(), altChainTxHashes.end(), tx_hash) == altChainTxHashes.end()) {
-      logger(ERROR, BRIGHT_RED) << "Attempting to switch to an alternate chain, but it lacks transaction " << Common::podToHex(tx_hash) << " from main chain, rejected";
-      mainChainTxHashes.clear();
-      mainChainTxHashes.shrink_to_fit();
-      altChainTxHashes.clear();
-      altChainTxHashes.shrink_to_fit();
-      return false;
+    const Block& b = (*alt_ch_iter)->second.bl;
+    altChainTxHashes.insert(b.transactionHashes.begin(), b.transactionHashes.end());
+  }
+  for (size_t i = m_blocks.size() - 1; i >= split_height; i--) {
+    for (const auto& tx_hash : m_blocks[i].bl.transactionHashes) {
+      if (altChainTxHashes.count(tx_hash) == 0) {
+        logger(ERROR, BRIGHT_RED) << "Attempting to switch to an alternate chain, but it lacks transaction " << Common::podToHex(tx_hash) << " from main chain, rejected";
+        return false;
+      }
     }
   }
 
   //disconnecting old chain
-  std::list<Block> disconnected_chain;
+  std::list<DisconnectedBlock> disconnected_chain;
   for (size_t i = m_blocks.size() - 1; i >= split_height; i--) {
-    Block b = m_blocks[i].bl;
-    popBlock();
-    //if (!(r)) { logger(ERROR, BRIGHT_RED) << "failed to remove block on chain switching"; return false; }
-    disconnected_chain.push_front(b);
+    disconnected_chain.emplace_front();
+    disconnectBlock(disconnected_chain.front());
   }
 
   //connecting new alternative chain
@@ -1033,7 +1948,7 @@ bool Blockchain::switch_to_alternative_blockchain(std::list<blocks_ext_by_hash::
     //pushing old chain as alternative chain
     for (auto& old_ch_ent : disconnected_chain) {
       block_verification_context bvc = boost::value_initialized<block_verification_context>();
-      bool r = handle_alternative_block(old_ch_ent, get_block_hash(old_ch_ent), bvc, false);
+      bool r = handle_alternative_block(old_ch_ent.entry.bl, old_ch_ent.hash, bvc, false);
       if (!r) {
         logger(WARNING, BRIGHT_YELLOW) << ("Failed to push ex-main chain blocks to alternative chain ");
         break;
@@ -1054,6 +1969,7 @@ bool Blockchain::switch_to_alternative_blockchain(std::list<blocks_ext_by_hash::
 
   sendMessage(BlockchainMessage(ChainSwitchMessage(std::move(blocksFromCommonRoot))));
 
+  m_reorganizationDepth.add(static_cast<uint64_t>(disconnected_chain.size()));
   logger(INFO, BRIGHT_GREEN) << "REORGANIZE SUCCESS! on height: " << split_height << ", new blockchain size: " << m_blocks.size();
   return true;
 }
@@ -1068,7 +1984,7 @@ difficulty_type Blockchain::get_next_difficulty_for_alternative_chain(const std:
   // if the alt chain isn't long enough to calculate the difficulty target
   // based on its blocks alone, need to get more blocks from the main chain
   if (alt_chain.size() < m_currency.difficultyBlocksCountByBlockVersion(BlockMajorVersion)) {
-    std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+    Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
     size_t main_chain_stop_offset = alt_chain.size() ? alt_chain.front()->second.height : bei.height;
     size_t main_chain_count = m_currency.difficultyBlocksCountByBlockVersion(BlockMajorVersion) - std::min(m_currency.difficultyBlocksCountByBlockVersion(BlockMajorVersion), alt_chain.size());
     main_chain_count = std::min(main_chain_count, main_chain_stop_offset);
@@ -1078,9 +1994,9 @@ difficulty_type Blockchain::get_next_difficulty_for_alternative_chain(const std:
       ++main_chain_start_offset; //skip genesis block
     
     // get difficulties and timestamps from relevant main chain blocks
-    for (; main_chain_start_offset < main_chain_stop_offset; ++main_chain_start_offset) {
-      timestamps.push_back(m_blocks[main_chain_start_offset].bl.timestamp);
-      cumulative_difficulties.push_back(m_blocks[main_chain_start_offset].cumulative_difficulty);
+    if (main_chain_start_offset < main_chain_stop_offset) {
+      timestamps.assign(m_blockColumns.timestamps().begin() + main_chain_start_offset, m_blockColumns.timestamps().begin() + main_chain_stop_offset);
+      cumulative_difficulties.assign(m_blockColumns.cumulativeDifficulties().begin() + main_chain_start_offset, m_blockColumns.cumulativeDifficulties().begin() + main_chain_stop_offset);
     }
 
     // make sure we haven't accidentally grabbed too many blocks... ???
@@ -1173,9 +2089,7 @@ bool Blockchain::validate_miner_transaction(const Block& b, uint32_t height, siz
     minerReward += o.amount;
   }
 
-  std::vector<size_t> lastBlocksSizes;
-  get_last_n_blocks_sizes(lastBlocksSizes, m_currency.rewardBlocksWindow());
-  size_t blocksSizeMedian = Common::medianValue(lastBlocksSizes);
+  size_t blocksSizeMedian = m_lastBlocksSizes.median();
 
   auto blockMajorVersion = getBlockMajorVersionForHeight(height);
   if (!m_currency.getBlockReward(blockMajorVersion, blocksSizeMedian, cumulativeBlockSize, alreadyGeneratedCoins, fee, reward, emissionChange)) {
@@ -1197,7 +2111,7 @@ bool Blockchain::validate_miner_transaction(const Block& b, uint32_t height, siz
 }
 
 bool Blockchain::getBackwardBlocksSize(size_t from_height, std::vector<size_t>& sz, size_t count) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (!(from_height < m_blocks.size())) {
     logger(ERROR, BRIGHT_RED)
       << "Internal error: get_backward_blocks_sizes called with from_height="
@@ -1205,15 +2119,13 @@ bool Blockchain::getBackwardBlocksSize(size_t from_height, std::vector<size_t>&
     return false;
   }
   size_t start_offset = (from_height + 1) - std::min((from_height + 1), count);
-  for (size_t i = start_offset; i != from_height + 1; i++) {
-    sz.push_back(m_blocks[i].block_cumulative_size);
-  }
+  sz.insert(sz.end(), m_blockColumns.cumulativeSizes().begin() + start_offset, m_blockColumns.cumulativeSizes().begin() + from_height + 1);
 
   return true;
 }
 
 bool Blockchain::get_last_n_blocks_sizes(std::vector<size_t>& sz, size_t count) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (!m_blocks.size()) {
     return true;
   }
@@ -1229,12 +2141,12 @@ bool Blockchain::complete_timestamps_vector(uint8_t blockMajorVersion, uint64_t
   if (timestamps.size() >= m_currency.timestampCheckWindow(blockMajorVersion))
     return true;
 
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   size_t need_elements = m_currency.timestampCheckWindow(blockMajorVersion) - timestamps.size();
   if (!(start_top_height < m_blocks.size())) { logger(ERROR, BRIGHT_RED) << "internal error: passed start_height = " << start_top_height << " not less then m_blocks.size()=" << m_blocks.size(); return false; }
   size_t stop_offset = start_top_height > need_elements ? start_top_height - need_elements : 0;
   do {
-    timestamps.push_back(m_blocks[start_top_height].bl.timestamp);
+    timestamps.push_back(m_blockColumns.timestamps()[start_top_height]);
     if (start_top_height == 0)
       break;
     --start_top_height;
@@ -1253,9 +2165,10 @@ bool Blockchain::handle_alternative_block(const Block& b, const Crypto::Hash& id
     return false;
   }
 
-  // get fresh checkpoints from DNS - the best we have right now
+  // merge fresh checkpoints from DNS - the best we have right now,
+  // the lookup itself runs in the background
 #ifndef __ANDROID__
-  m_checkpoints.load_checkpoints_from_dns();
+  m_checkpoints.refresh_checkpoints_from_dns();
 #endif
 
   if (!m_checkpoints.is_alternative_block_allowed(getCurrentBlockchainHeight(), block_height)) {
@@ -1311,8 +2224,7 @@ bool Blockchain::handle_alternative_block(const Block& b, const Crypto::Hash& id
       // make sure alt chain doesn't somehow start past the end of the main chain
       if (!(m_blocks.size() > alt_chain.front()->second.height)) { logger(ERROR, BRIGHT_RED) << "main blockchain wrong height"; return false; }
       // make sure block connects correctly to the main chain
-	  Crypto::Hash h = NULL_HASH;
-      get_block_hash(m_blocks[alt_chain.front()->second.height - 1].bl, h);
+      Crypto::Hash h = m_blockIndex.getBlockId(alt_chain.front()->second.height - 1);
       if (!(h == alt_chain.front()->second.bl.previousBlockHash)) { logger(ERROR, BRIGHT_RED) << "alternative chain have wrong connection to main chain"; return false; }
       complete_timestamps_vector(b.majorVersion, alt_chain.front()->second.height - 1, timestamps);
     } else {
@@ -1358,7 +2270,7 @@ bool Blockchain::handle_alternative_block(const Block& b, const Crypto::Hash& id
     if (!(current_diff)) { logger(ERROR, BRIGHT_RED) << "!!!!!!! DIFFICULTY OVERHEAD !!!!!!!"; return false; }
     Crypto::Hash proof_of_work = NULL_HASH;
     // Always check PoW for alternative blocks
-    if (!m_currency.checkProofOfWork(m_cn_context, bei.bl, current_diff, proof_of_work)) {
+    if (!checkProofOfWork(bei.bl, id, current_diff, proof_of_work)) {
       logger(INFO, BRIGHT_RED) <<
         "Block with id: " << id
         << ENDL << " for alternative chain, have not enough proof of work: " << proof_of_work
@@ -1374,7 +2286,7 @@ bool Blockchain::handle_alternative_block(const Block& b, const Crypto::Hash& id
       return false;
     }
 
-    bei.cumulative_difficulty = alt_chain.size() ? it_prev->second.cumulative_difficulty : m_blocks[mainPrevHeight].cumulative_difficulty;
+    bei.cumulative_difficulty = alt_chain.size() ? it_prev->second.cumulative_difficulty : m_blockColumns.cumulativeDifficulties()[mainPrevHeight];
     bei.cumulative_difficulty += current_diff;
 
 #ifdef _DEBUG
@@ -1402,11 +2314,11 @@ bool Blockchain::handle_alternative_block(const Block& b, const Crypto::Hash& id
         bvc.m_verification_failed = true;
       }
       return r;
-    } else if (m_blocks.back().cumulative_difficulty < bei.cumulative_difficulty) //check if difficulty bigger then in main chain
+    } else if (m_blockColumns.cumulativeDifficulties().back() < bei.cumulative_difficulty) //check if difficulty bigger then in main chain
     {
       //do reorganize!
       logger(INFO, BRIGHT_GREEN) <<
-        "###### REORGANIZE on height: " << alt_chain.front()->second.height << " of " << m_blocks.size() - 1 << " with cum_difficulty " << m_blocks.back().cumulative_difficulty
+        "###### REORGANIZE on height: " << alt_chain.front()->second.height << " of " << m_blocks.size() - 1 << " with cum_difficulty " << m_blockColumns.cumulativeDifficulties().back()
         << ENDL << " alternative blockchain size: " << alt_chain.size() << " with cum_difficulty " << bei.cumulative_difficulty;
       bool r = switch_to_alternative_blockchain(alt_chain, false);
       if (r) {
@@ -1438,13 +2350,13 @@ bool Blockchain::handle_alternative_block(const Block& b, const Crypto::Hash& id
 }
 
 bool Blockchain::getBlocks(uint32_t start_offset, uint32_t count, std::list<Block>& blocks, std::list<Transaction>& txs) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (start_offset >= m_blocks.size())
     return false;
   for (size_t i = start_offset; i < start_offset + count && i < m_blocks.size(); i++) {
-    blocks.push_back(m_blocks[i].bl);
+    blocks.push_back(m_blocks.get(i)->bl);
     std::list<Crypto::Hash> missed_ids;
-    getTransactions(m_blocks[i].bl.transactionHashes, txs, missed_ids);
+    getTransactions(m_blocks.get(i)->bl.transactionHashes, txs, missed_ids);
     if (!(!missed_ids.size())) { logger(ERROR, BRIGHT_RED) << "have missed transactions in own block in main blockchain"; return false; }
   }
 
@@ -1452,57 +2364,89 @@ bool Blockchain::getBlocks(uint32_t start_offset, uint32_t count, std::list<Bloc
 }
 
 bool Blockchain::getBlocks(uint32_t start_offset, uint32_t count, std::list<Block>& blocks) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (start_offset >= m_blocks.size()) {
     return false;
   }
 
   for (uint32_t i = start_offset; i < start_offset + count && i < m_blocks.size(); i++) {
-    blocks.push_back(m_blocks[i].bl);
+    blocks.push_back(m_blocks.get(i)->bl);
   }
 
   return true;
 }
 
 bool Blockchain::getTransactionsWithOutputGlobalIndexes(const std::vector<Crypto::Hash>& txs_ids, std::list<Crypto::Hash>& missed_txs, std::vector<std::pair<Transaction, std::vector<uint32_t>>>& txs) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   for (const auto& tx_id : txs_ids) {
-    auto it = m_transactionMap.find(tx_id);
-    if (it == m_transactionMap.end()) {
+    TransactionIndex transactionIndex;
+    if (!m_transactionMap.find(tx_id, transactionIndex)) {
       missed_txs.push_back(tx_id);
     }
     else {
-      const TransactionEntry& tx = transactionByIndex(it->second);
-      if (!(tx.m_global_output_indexes.size())) { logger(ERROR, BRIGHT_RED) << "internal error: global indexes for transaction " << tx_id << " is empty"; return false; }
-      txs.push_back(std::make_pair(tx.tx, tx.m_global_output_indexes));
+      std::shared_ptr<const TransactionEntry> tx = transactionByIndex(transactionIndex);
+      if (!(tx->m_global_output_indexes.size())) { logger(ERROR, BRIGHT_RED) << "internal error: global indexes for transaction " << tx_id << " is empty"; return false; }
+      txs.push_back(std::make_pair(loadTransaction(transactionIndex), tx->m_global_output_indexes));
     }
   }
 
   return true;
 }
 
+uint32_t Blockchain::visitRawBlocks(uint32_t startHeight, uint32_t count, const std::function<bool(const RawBlock&)>& visitor) {
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  uint32_t visited = 0;
+  RawBlock rawBlock;
+  for (uint32_t height = startHeight; visited < count && height < m_blocks.size(); ++height) {
+    BlockStoreIndexEntry header = m_blocks.header(height);
+    Common::ArrayView<uint8_t> entry = m_blocks.blob(height);
+    rawBlock.height = height;
+    rawBlock.hash = m_blockIndex.getBlockId(height);
+    rawBlock.timestamp = header.timestamp;
+    rawBlock.block = m_blocks.blockBlob(height);
+    rawBlock.transactions.clear();
+    rawBlock.globalIndexes.clear();
+    for (uint32_t i = 0; i < header.transactionCount; ++i) {
+      rawBlock.transactions.push_back(m_blocks.transactionBlob(height, i));
+    }
+
+    // a transaction entry is the transaction followed by its indexes, up to the next entry
+    for (uint32_t i = 0; i < header.transactionCount; ++i) {
+      const uint8_t* begin = rawBlock.transactions[i].getData() + rawBlock.transactions[i].getSize();
+      const uint8_t* end = i + 1 < header.transactionCount ? rawBlock.transactions[i + 1].getData() : entry.getData() + entry.getSize();
+      rawBlock.globalIndexes.push_back(Common::ArrayView<uint8_t>(begin, end - begin));
+    }
+
+    ++visited;
+    if (!visitor(rawBlock)) {
+      break;
+    }
+  }
+
+  return visited;
+}
+
 bool Blockchain::handleGetObjects(NOTIFY_REQUEST_GET_OBJECTS::request& arg, NOTIFY_RESPONSE_GET_OBJECTS::request& rsp) { //Deprecated. Should be removed with CryptoNoteProtocolHandler.
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   rsp.current_blockchain_height = getCurrentBlockchainHeight();
-  std::list<Block> blocks;
-  getBlocks(arg.blocks, blocks, rsp.missed_ids);
-  for (const auto& bl : blocks) {
-    std::list<Crypto::Hash> missed_tx_id;
-    std::list<Transaction> txs;
-    getTransactions(bl.transactionHashes, txs, missed_tx_id);
-    if (!(!missed_tx_id.size())) {
-      logger(ERROR, BRIGHT_RED) << "Internal error: have missed missed_tx_id.size()=" << missed_tx_id.size() << ENDL << "for block id = " << get_block_hash(bl);
-      rsp.missed_ids.insert(rsp.missed_ids.end(), missed_tx_id.begin(), missed_tx_id.end());
-      return false;
-    } //WTF???
+  for (const auto& id : arg.blocks) {
+    uint32_t height = 0;
+    if (!m_blockIndex.getBlockHeight(id, height)) {
+      rsp.missed_ids.push_back(id);
+      continue;
+    }
+
+    // blobs are shipped straight from the block store, skipping deserialization
+    BlockStoreIndexEntry header = m_blocks.header(height);
     rsp.blocks.push_back(block_complete_entry());
     block_complete_entry& e = rsp.blocks.back();
-    //pack block
-    e.block = asString(toBinaryArray(bl));
-    //pack transactions
-    for (Transaction& tx : txs) {
-      e.txs.push_back(asString(toBinaryArray(tx)));
+    Common::ArrayView<uint8_t> blockBlob = m_blocks.blockBlob(height);
+    e.block.assign(reinterpret_cast<const char*>(blockBlob.getData()), blockBlob.getSize());
+    //the base transaction goes inside the block
+    for (uint32_t i = 1; i < header.transactionCount; ++i) {
+      Common::ArrayView<uint8_t> transactionBlob = m_blocks.transactionBlob(height, i);
+      e.txs.push_back(std::string(reinterpret_cast<const char*>(transactionBlob.getData()), transactionBlob.getSize()));
     }
   }
 
@@ -1518,7 +2462,7 @@ bool Blockchain::handleGetObjects(NOTIFY_REQUEST_GET_OBJECTS::request& arg, NOTI
 }
 
 bool Blockchain::getAlternativeBlocks(std::list<Block>& blocks) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   for (auto& alt_bl : m_alternative_chains) {
     blocks.push_back(alt_bl.second.bl);
   }
@@ -1527,31 +2471,23 @@ bool Blockchain::getAlternativeBlocks(std::list<Block>& blocks) {
 }
 
 uint32_t Blockchain::getAlternativeBlocksCount() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return static_cast<uint32_t>(m_alternative_chains.size());
 }
 
-bool Blockchain::add_out_to_get_random_outs(std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& result_outs, uint64_t amount, size_t i) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-  const Transaction& tx = transactionByIndex(amount_outs[i].first).tx;
-  if (!(tx.outputs.size() > amount_outs[i].second)) {
-    logger(ERROR, BRIGHT_RED) << "internal error: in global outs index, transaction out index="
-      << amount_outs[i].second << " more than transaction outputs = " << tx.outputs.size() << ", for tx id = " << getObjectHash(tx); return false;
-  }
-  if (!(tx.outputs[amount_outs[i].second].target.type() == typeid(KeyOutput))) { logger(ERROR, BRIGHT_RED) << "unknown tx out type"; return false; }
-
+bool Blockchain::add_out_to_get_random_outs(const std::vector<OutputKeyInfo>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& result_outs, uint64_t amount, size_t i) {
   //check if transaction is unlocked
-  if (!is_tx_spendtime_unlocked(tx.unlockTime))
+  if (!is_tx_spendtime_unlocked(amount_outs[i].unlockTime))
     return false;
 
   COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::out_entry& oen = *result_outs.outs.insert(result_outs.outs.end(), COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::out_entry());
   oen.global_amount_index = static_cast<uint32_t>(i);
-  oen.out_key = boost::get<KeyOutput>(tx.outputs[amount_outs[i].second].target).key;
+  oen.out_key = amount_outs[i].key;
   return true;
 }
 
-size_t Blockchain::find_end_of_allowed_index(const std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+size_t Blockchain::find_end_of_allowed_index(const std::vector<OutputKeyInfo>& amount_outs) {
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (amount_outs.empty()) {
     return 0;
   }
@@ -1559,7 +2495,7 @@ size_t Blockchain::find_end_of_allowed_index(const std::vector<std::pair<Transac
   size_t i = amount_outs.size();
   do {
     --i;
-    if (amount_outs[i].first.block + (amount_outs[i].first.block < m_currency.minedMoneyUnlockWindow()) <= getCurrentBlockchainHeight()) {
+    if (amount_outs[i].height + (amount_outs[i].height < m_currency.minedMoneyUnlockWindow()) <= getCurrentBlockchainHeight()) {
       return i + 1;
     }
   } while (i != 0);
@@ -1567,20 +2503,34 @@ size_t Blockchain::find_end_of_allowed_index(const std::vector<std::pair<Transac
   return 0;
 }
 
+void Blockchain::buildOutputKeys() {
+  m_outputKeys.clear();
+  for (const outputs_container::value_type& amountOutputs : m_outputs) {
+    std::vector<OutputKeyInfo>& keys = m_outputKeys[amountOutputs.first];
+    keys.reserve(amountOutputs.second.size());
+    for (const auto& output : amountOutputs.second) {
+      std::shared_ptr<const TransactionEntry> transactionEntry = transactionByIndex(output.first);
+      const TransactionOutput& out = transactionEntry->tx.outputs[output.second];
+      OutputKeyInfo keyInfo = { ::boost::get<KeyOutput>(out.target).key, transactionEntry->tx.unlockTime, output.first.block };
+      keys.push_back(keyInfo);
+    }
+  }
+}
+
 bool Blockchain::getRandomOutsByAmount(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response& res) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   for (uint64_t amount : req.amounts) {
     COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& result_outs = *res.outs.insert(res.outs.end(), COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount());
     result_outs.amount = amount;
-    auto it = m_outputs.find(amount);
-    if (it == m_outputs.end()) {
+    auto it = m_outputKeys.find(amount);
+    if (it == m_outputKeys.end()) {
       logger(ERROR, BRIGHT_RED) <<
         "COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS: not outs for amount " << amount << ", wallet should use some real outs when it lookup for some mix, so, at least one out for this amount should exist";
       continue;//actually this is strange situation, wallet should use some real outs when it lookup for some mix, so, at least one out for this amount should exist
     }
 
-    std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs = it->second;
+    const std::vector<OutputKeyInfo>& amount_outs = it->second;
     //it is not good idea to use top fresh outs, because it increases possibility of transaction canceling on split
     //lets find upper bound of not fresh outs
     size_t up_index_limit = find_end_of_allowed_index(amount_outs);
@@ -1617,7 +2567,7 @@ uint32_t Blockchain::findBlockchainSupplement(const std::vector<Crypto::Hash>& q
   assert(!qblock_ids.empty());
   assert(qblock_ids.back() == m_blockIndex.getBlockId(0));
 
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   uint32_t blockIndex;
   // assert above guarantees that method returns true
   m_blockIndex.findSupplement(qblock_ids, blockIndex);
@@ -1625,38 +2575,39 @@ uint32_t Blockchain::findBlockchainSupplement(const std::vector<Crypto::Hash>& q
 }
 
 uint64_t Blockchain::blockDifficulty(size_t i) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (!(i < m_blocks.size())) { logger(ERROR, BRIGHT_RED) << "wrong block index i = " << i << " at Blockchain::block_difficulty()"; return false; }
   if (i == 0)
-    return m_blocks[i].cumulative_difficulty;
+    return m_blockColumns.cumulativeDifficulties()[i];
 
-  return m_blocks[i].cumulative_difficulty - m_blocks[i - 1].cumulative_difficulty;
+  return m_blockColumns.cumulativeDifficulties()[i] - m_blockColumns.cumulativeDifficulties()[i - 1];
 }
 
 uint64_t Blockchain::blockCumulativeDifficulty(size_t i) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (!(i < m_blocks.size())) { logger(ERROR, BRIGHT_RED) << "wrong block index i = " << i << " at Blockchain::block_difficulty()"; return false; }
 
-  return m_blocks[i].cumulative_difficulty;
+  return m_blockColumns.cumulativeDifficulties()[i];
 }
 
 bool Blockchain::getblockEntry(size_t i, uint64_t& block_cumulative_size, difficulty_type& difficulty, uint64_t& already_generated_coins, uint64_t& reward, uint64_t& transactions_count, uint64_t& timestamp) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (!(i < m_blocks.size())) { logger(ERROR, BRIGHT_RED) << "wrong block index i = " << i << " at Blockchain::get_block_entry()"; return false; }
 
-  block_cumulative_size = m_blocks[i].block_cumulative_size;
-  difficulty = m_blocks[i].cumulative_difficulty - m_blocks[i - 1].cumulative_difficulty;
-  already_generated_coins = m_blocks[i].already_generated_coins;
-  reward = m_blocks[i].already_generated_coins - m_blocks[i - 1].already_generated_coins;
-  timestamp = m_blocks[i].bl.timestamp;
-  transactions_count = m_blocks[i].bl.transactionHashes.size();
+  block_cumulative_size = m_blockColumns.cumulativeSizes()[i];
+  difficulty = m_blockColumns.cumulativeDifficulties()[i] - (i == 0 ? 0 : m_blockColumns.cumulativeDifficulties()[i - 1]);
+  already_generated_coins = m_blockColumns.generatedCoins()[i];
+  reward = m_blockColumns.generatedCoins()[i] - (i == 0 ? 0 : m_blockColumns.generatedCoins()[i - 1]);
+  timestamp = m_blockColumns.timestamps()[i];
+  // the base transaction is stored with the others but isn't listed in transactionHashes
+  transactions_count = m_blockColumns.transactionCounts()[i] - 1;
 
   return true;
 }
 
 void Blockchain::print_blockchain(uint64_t start_index, uint64_t end_index) {
   std::stringstream ss;
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (start_index >= m_blocks.size()) {
     logger(INFO, BRIGHT_WHITE) <<
       "Wrong starter index set: " << start_index << ", expected max index " << m_blocks.size() - 1;
@@ -1664,9 +2615,9 @@ void Blockchain::print_blockchain(uint64_t start_index, uint64_t end_index) {
   }
 
   for (size_t i = start_index; i != m_blocks.size() && i != end_index; i++) {
-    ss << "height " << i << ", timestamp " << m_blocks[i].bl.timestamp << ", cumul_dif " << m_blocks[i].cumulative_difficulty << ", cumul_size " << m_blocks[i].block_cumulative_size
-      << "\nid\t\t" << get_block_hash(m_blocks[i].bl)
-      << "\ndifficulty\t\t" << blockDifficulty(i) << ", nonce " << m_blocks[i].bl.nonce << ", tx_count " << m_blocks[i].bl.transactionHashes.size() << ENDL;
+    ss << "height " << i << ", timestamp " << m_blockColumns.timestamps()[i] << ", cumul_dif " << m_blockColumns.cumulativeDifficulties()[i] << ", cumul_size " << m_blockColumns.cumulativeSizes()[i]
+      << "\nid\t\t" << m_blockIndex.getBlockId(static_cast<uint32_t>(i))
+      << "\ndifficulty\t\t" << blockDifficulty(i) << ", nonce " << m_blocks.get(i)->bl.nonce << ", tx_count " << m_blocks.get(i)->bl.transactionHashes.size() << ENDL;
   }
   logger(DEBUGGING) <<
     "Current blockchain:" << ENDL << ss.str();
@@ -1676,7 +2627,7 @@ void Blockchain::print_blockchain(uint64_t start_index, uint64_t end_index) {
 
 void Blockchain::print_blockchain_index() {
   std::stringstream ss;
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   std::vector<Crypto::Hash> blockIds = m_blockIndex.getBlockIds(0, std::numeric_limits<uint32_t>::max());
   logger(INFO, BRIGHT_WHITE) << "Current blockchain index:";
@@ -1690,13 +2641,13 @@ void Blockchain::print_blockchain_index() {
 
 void Blockchain::print_blockchain_outs(const std::string& file) {
   std::stringstream ss;
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   for (const outputs_container::value_type& v : m_outputs) {
     const std::vector<std::pair<TransactionIndex, uint16_t>>& vals = v.second;
     if (!vals.empty()) {
       ss << "amount: " << v.first << ENDL;
       for (size_t i = 0; i != vals.size(); i++) {
-        ss << "\t" << getObjectHash(transactionByIndex(vals[i].first).tx) << ": " << vals[i].second << ENDL;
+        ss << "\t" << transactionHash(vals[i].first) << ": " << vals[i].second << ENDL;
       }
     }
   }
@@ -1716,7 +2667,7 @@ std::vector<Crypto::Hash> Blockchain::findBlockchainSupplement(const std::vector
   assert(!remoteBlockIds.empty());
   assert(remoteBlockIds.back() == m_blockIndex.getBlockId(0));
 
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   totalBlockCount = getCurrentBlockchainHeight();
   startBlockIndex = findBlockchainSupplement(remoteBlockIds);
 
@@ -1724,7 +2675,7 @@ std::vector<Crypto::Hash> Blockchain::findBlockchainSupplement(const std::vector
 }
 
 bool Blockchain::haveBlock(const Crypto::Hash& id) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (m_blockIndex.hasBlock(id))
     return true;
 
@@ -1735,30 +2686,53 @@ bool Blockchain::haveBlock(const Crypto::Hash& id) {
 }
 
 size_t Blockchain::getTotalTransactions() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_transactionMap.size();
 }
 
 bool Blockchain::getTransactionOutputGlobalIndexes(const Crypto::Hash& tx_id, std::vector<uint32_t>& indexs) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-  auto it = m_transactionMap.find(tx_id);
-  if (it == m_transactionMap.end()) {
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  TransactionIndex transactionIndex;
+  if (!m_transactionMap.find(tx_id, transactionIndex)) {
     logger(WARNING, YELLOW) << "warning: get_tx_outputs_gindexs failed to find transaction with id = " << tx_id;
     return false;
   }
 
-  const TransactionEntry& tx = transactionByIndex(it->second);
-  if (!(tx.m_global_output_indexes.size())) { logger(ERROR, BRIGHT_RED) << "internal error: global indexes for transaction " << tx_id << " is empty"; return false; }
-  indexs.resize(tx.m_global_output_indexes.size());
-  for (size_t i = 0; i < tx.m_global_output_indexes.size(); ++i) {
-    indexs[i] = tx.m_global_output_indexes[i];
+  std::shared_ptr<const TransactionEntry> tx = transactionByIndex(transactionIndex);
+  if (!(tx->m_global_output_indexes.size())) { logger(ERROR, BRIGHT_RED) << "internal error: global indexes for transaction " << tx_id << " is empty"; return false; }
+  indexs.resize(tx->m_global_output_indexes.size());
+  for (size_t i = 0; i < tx->m_global_output_indexes.size(); ++i) {
+    indexs[i] = tx->m_global_output_indexes[i];
+  }
+
+  return true;
+}
+
+bool Blockchain::getTransactionsOutputGlobalIndexes(const std::vector<Crypto::Hash>& txIds, std::vector<std::vector<uint32_t>>& indexes) {
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  indexes.clear();
+  indexes.reserve(txIds.size());
+  for (const Crypto::Hash& txId : txIds) {
+    TransactionIndex transactionIndex;
+    if (!m_transactionMap.find(txId, transactionIndex)) {
+      logger(WARNING, YELLOW) << "warning: getTransactionsOutputGlobalIndexes failed to find transaction with id = " << txId;
+      return false;
+    }
+
+    std::shared_ptr<const TransactionEntry> tx = transactionByIndex(transactionIndex);
+    if (tx->m_global_output_indexes.empty()) {
+      logger(ERROR, BRIGHT_RED) << "internal error: global indexes for transaction " << txId << " is empty";
+      return false;
+    }
+
+    indexes.emplace_back(tx->m_global_output_indexes.begin(), tx->m_global_output_indexes.end());
   }
 
   return true;
 }
 
 bool Blockchain::get_out_by_msig_gindex(uint64_t amount, uint64_t gindex, MultisignatureOutput& out) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   auto it = m_multisignatureOutputs.find(amount);
   if (it == m_multisignatureOutputs.end()) {
     return false;
@@ -1769,7 +2743,8 @@ bool Blockchain::get_out_by_msig_gindex(uint64_t amount, uint64_t gindex, Multis
   }
 
   auto msigUsage = it->second[gindex];
-  auto& targetOut = transactionByIndex(msigUsage.transactionIndex).tx.outputs[msigUsage.outputIndex].target;
+  std::shared_ptr<const TransactionEntry> transactionEntry = transactionByIndex(msigUsage.transactionIndex);
+  auto& targetOut = transactionEntry->tx.outputs[msigUsage.outputIndex].target;
   if (targetOut.type() != typeid(MultisignatureOutput)) {
     return false;
   }
@@ -1781,7 +2756,7 @@ bool Blockchain::get_out_by_msig_gindex(uint64_t amount, uint64_t gindex, Multis
 
 
 bool Blockchain::checkTransactionInputs(const Transaction& tx, uint32_t& max_used_block_height, Crypto::Hash& max_used_block_id, BlockInfo* tail) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   if (tail)
     tail->id = getTailId(tail->height);
@@ -1789,7 +2764,7 @@ bool Blockchain::checkTransactionInputs(const Transaction& tx, uint32_t& max_use
   bool res = checkTransactionInputs(tx, &max_used_block_height);
   if (!res) return false;
   if (!(max_used_block_height < m_blocks.size())) { logger(ERROR, BRIGHT_RED) << "internal error: max used block index=" << max_used_block_height << " is not less then blockchain size = " << m_blocks.size(); return false; }
-  get_block_hash(m_blocks[max_used_block_height].bl, max_used_block_id);
+  max_used_block_id = m_blockIndex.getBlockId(max_used_block_height);
   return true;
 }
 
@@ -1810,13 +2785,23 @@ bool Blockchain::checkTransactionInputs(const Transaction& tx, uint32_t* pmax_us
   return checkTransactionInputs(tx, tx_prefix_hash, pmax_used_block_height);
 }
 
-bool Blockchain::checkTransactionInputs(const Transaction& tx, const Crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height) {
+bool Blockchain::checkTransactionInputs(const Transaction& tx, const Crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height, std::vector<RingSignatureCheck>* deferred_signatures) {
+  if (!isInCheckpointZone(getCurrentBlockchainHeight()) && !keyImagesInDomain(tx)) {
+    logger(ERROR) << "Transaction uses key image not in the valid domain";
+    return false;
+  }
+
+  return checkTransactionInputsInChain(tx, getObjectHash(tx), tx_prefix_hash, pmax_used_block_height, deferred_signatures);
+}
+
+// The part of checkTransactionInputs() which depends on the chain: spent key images and the outputs referenced by the inputs
+bool Blockchain::checkTransactionInputsInChain(const Transaction& tx, const Crypto::Hash& transactionHash, const Crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height, std::vector<RingSignatureCheck>* deferred_signatures) {
   size_t inputIndex = 0;
   if (pmax_used_block_height) {
     *pmax_used_block_height = 0;
   }
 
-  Crypto::Hash transactionHash = getObjectHash(tx);
+  bool checkInputs = !isInCheckpointZone(getCurrentBlockchainHeight());
   for (const auto& txin : tx.inputs) {
     assert(inputIndex < tx.signatures.size());
     if (txin.type() == typeid(KeyInput)) {
@@ -1830,8 +2815,8 @@ bool Blockchain::checkTransactionInputs(const Transaction& tx, const Crypto::Has
         return false;
       }
 
-      if (!isInCheckpointZone(getCurrentBlockchainHeight())) {
-        if (!check_tx_input(in_to_key, tx_prefix_hash, tx.signatures[inputIndex], pmax_used_block_height)) {
+      if (checkInputs) {
+        if (!check_tx_input(in_to_key, tx_prefix_hash, tx.signatures[inputIndex], pmax_used_block_height, deferred_signatures)) {
           logger(INFO, BRIGHT_WHITE) <<
             "Failed to check input in transaction " << transactionHash;
           return false;
@@ -1840,7 +2825,7 @@ bool Blockchain::checkTransactionInputs(const Transaction& tx, const Crypto::Has
 
       ++inputIndex;
     } else if (txin.type() == typeid(MultisignatureInput)) {
-      if (!isInCheckpointZone(getCurrentBlockchainHeight())) {
+      if (checkInputs) {
         if (!validateInput(::boost::get<MultisignatureInput>(txin), transactionHash, tx_prefix_hash, tx.signatures[inputIndex])) {
           return false;
         }
@@ -1887,17 +2872,18 @@ bool Blockchain::is_tx_spendtime_unlocked(uint64_t unlock_time, uint32_t height)
   return false;
 }
 
-bool Blockchain::check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::Signature>& sig, uint32_t* pmax_related_block_height) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+bool Blockchain::check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::Signature>& sig, uint32_t* pmax_related_block_height, std::vector<RingSignatureCheck>* deferred_signatures) {
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
+  // keys are copied, the block cache may evict their transactions while other readers are running
   struct outputs_visitor {
-    std::vector<const Crypto::PublicKey *>& m_results_collector;
+    std::vector<Crypto::PublicKey>& m_results_collector;
     Blockchain& m_bch;
     LoggerRef logger;
-    outputs_visitor(std::vector<const Crypto::PublicKey *>& results_collector, Blockchain& bch, ILogger& logger) :m_results_collector(results_collector), m_bch(bch), logger(logger, "outputs_visitor") {
+    outputs_visitor(std::vector<Crypto::PublicKey>& results_collector, Blockchain& bch, ILogger& logger) :m_results_collector(results_collector), m_bch(bch), logger(logger, "outputs_visitor") {
     }
 
-    bool handle_output(const Transaction& tx, const TransactionOutput& out, size_t transactionOutputIndex) {
+    bool handle_output(const Transaction& tx, const TransactionOutput& out, const TransactionIndex& transactionIndex, size_t transactionOutputIndex) {
       //check tx unlock time
       if (!m_bch.is_tx_spendtime_unlocked(tx.unlockTime)) {
         logger(INFO, BRIGHT_WHITE) <<
@@ -1911,19 +2897,14 @@ bool Blockchain::check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_pre
         return false;
       }
 
-      m_results_collector.push_back(&boost::get<KeyOutput>(out.target).key);
+      m_results_collector.push_back(boost::get<KeyOutput>(out.target).key);
       return true;
     }
   };
 
-  // additional key_image check, fix discovered by Monero Lab and suggested by "fluffypony" (bitcointalk.org)
-  if (!(scalarmultKey(txin.keyImage, Crypto::EllipticCurveScalar2KeyImage(Crypto::L)) == Crypto::EllipticCurveScalar2KeyImage(Crypto::I))) {
-    logger(ERROR) << "Transaction uses key image not in the valid domain";
-    return false;
-  }
-
   //check ring signature
-  std::vector<const Crypto::PublicKey *> output_keys;
+  std::vector<Crypto::PublicKey> output_keys;
+  output_keys.reserve(txin.outputIndexes.size());
   outputs_visitor vi(output_keys, *this, logger.getLogger());
   if (!scanOutputKeysForIndexes(txin, vi, pmax_related_block_height)) {
     logger(INFO, BRIGHT_WHITE) <<
@@ -1943,13 +2924,295 @@ bool Blockchain::check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_pre
     return true;
   }
 
-  bool check_tx_ring_signature = Crypto::check_ring_signature(tx_prefix_hash, txin.keyImage, output_keys, sig.data());
+  if (deferred_signatures != NULL) {
+    RingSignatureCheck check = { tx_prefix_hash, txin.keyImage, std::move(output_keys), sig };
+    deferred_signatures->push_back(std::move(check));
+    return true;
+  }
+
+  bool check_tx_ring_signature = checkRingSignature(tx_prefix_hash, txin.keyImage, output_keys, sig.data());
   if (!check_tx_ring_signature) {
     logger(ERROR) << "Failed to check ring signature for keyImage: " << txin.keyImage;
   }
   return check_tx_ring_signature;
 }
 
+bool Blockchain::checkRingSignature(const Crypto::Hash& prefixHash, const Crypto::KeyImage& keyImage, const std::vector<Crypto::PublicKey>& outputKeys, const Crypto::Signature* signatures) {
+  // per thread scratch, rings of a block are checked without allocating after the first few
+  static thread_local std::vector<std::shared_ptr<const Crypto::RingMemberPrecomp>> members;
+  static thread_local std::vector<const Crypto::RingMemberPrecomp*> memberPointers;
+  members.clear();
+  memberPointers.clear();
+  for (const Crypto::PublicKey& key : outputKeys) {
+    members.push_back(m_ringMemberCache.get(key));
+    if (!members.back()) {
+      return false;
+    }
+
+    memberPointers.push_back(members.back().get());
+  }
+
+  bool valid = Crypto::check_ring_signature(prefixHash, keyImage, memberPointers.data(), memberPointers.size(), signatures);
+  members.clear(); // don't pin evicted tables until the thread's next check
+  return valid;
+}
+
+// Everything about the transactions of a block that doesn't depend on the chain. The key images are
+// checked against the curve only outside the checkpoint zone, as in checkTransactionInputs().
+void Blockchain::precheckTransactions(const std::vector<Transaction>& transactions, bool checkKeyImages, std::vector<TransactionPrecheck>& prechecks) {
+  prechecks.resize(transactions.size());
+  if (transactions.empty()) {
+    return;
+  }
+
+  size_t workersCount = getVerificationWorkersCount(transactions.size());
+  std::atomic<size_t> next(0);
+  auto precheck = [&transactions, &prechecks, &next, checkKeyImages] {
+    BinaryArray blob;
+    for (size_t i = next++; i < transactions.size(); i = next++) {
+      const Transaction& tx = transactions[i];
+      TransactionPrecheck& result = prechecks[i];
+      blob.clear();
+      toBinaryArray(tx, blob);
+      result.hash = getBinaryArrayHash(blob);
+      result.prefixHash = getTransactionPrefixHash(tx, blob);
+      result.blobSize = blob.size();
+      result.fee = 0;
+      result.valid = !tx.inputs.empty() && tx.inputs.size() == tx.signatures.size() &&
+        check_inputs_types_supported(tx) && check_money_overflow(tx) && checkMultisignatureInputsDiff(tx);
+      if (result.valid) {
+        uint64_t inputAmount = getInputAmount(tx);
+        uint64_t outputAmount = getOutputAmount(tx);
+        result.valid = inputAmount >= outputAmount && (!checkKeyImages || keyImagesInDomain(tx));
+        result.fee = inputAmount - outputAmount;
+      }
+    }
+  };
+
+  std::vector<std::future<void>> workers;
+  for (size_t w = 1; w < workersCount; ++w) {
+    workers.push_back(startVerificationWorker(precheck));
+  }
+
+  precheck();
+  for (auto& worker : workers) {
+    worker.get();
+  }
+}
+
+size_t Blockchain::getVerificationWorkersCount(size_t tasks) const {
+  size_t workersCount = m_verificationCpus.empty() ? std::thread::hardware_concurrency() : m_verificationCpus.size();
+  if (workersCount == 0) {
+    workersCount = 2;
+  }
+
+  return std::min(workersCount, tasks);
+}
+
+std::future<void> Blockchain::startVerificationWorker(const std::function<void()>& work) const {
+  // a new thread inherits the CPUs of its creator, usually the network thread
+  return std::async(std::launch::async, [this, work] {
+    Tools::setCurrentThreadAffinity(m_verificationCpus);
+    work();
+  });
+}
+
+bool Blockchain::checkRingSignatures(const std::vector<RingSignatureCheck>& checks) {
+  size_t workersCount = getVerificationWorkersCount(checks.size());
+  std::atomic<size_t> next(0);
+  std::atomic<bool> failed(false);
+  auto verify = [this, &checks, &next, &failed] {
+    for (size_t i = next++; i < checks.size() && !failed; i = next++) {
+      const RingSignatureCheck& check = checks[i];
+      if (!checkRingSignature(check.prefixHash, check.keyImage, check.outputKeys, check.signatures.data())) {
+        failed = true;
+      }
+    }
+  };
+
+  std::vector<std::future<void>> workers;
+  for (size_t w = 1; w < workersCount; ++w) {
+    workers.push_back(startVerificationWorker(verify));
+  }
+
+  verify();
+  for (auto& worker : workers) {
+    worker.get();
+  }
+
+  return !failed;
+}
+
+void Blockchain::precomputeLongHashes(const std::vector<Block>& blocks) {
+  uint32_t height;
+  std::vector<std::pair<const Block*, Crypto::Hash>> pending;
+  {
+    Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+    height = getCurrentBlockchainHeight();
+    for (size_t i = 0; i < blocks.size(); ++i) {
+      const Block& block = blocks[i];
+      // blocks under checkpoints are not hashed at all
+      if (m_checkpoints.is_in_checkpoint_zone(height + static_cast<uint32_t>(i)) || !isLongHashCacheable(block)) {
+        continue;
+      }
+
+      Crypto::Hash blockHash = get_block_hash(block);
+      if (!m_blockIndex.hasBlock(blockHash) && m_alternative_chains.count(blockHash) == 0 && !m_longHashCache.contains(blockHash)) {
+        pending.emplace_back(&block, blockHash);
+      }
+    }
+  }
+
+  if (pending.empty()) {
+    return;
+  }
+
+  size_t workersCount = getVerificationWorkersCount(pending.size());
+  // every worker takes up to SLOW_HASH_MAX_WAYS blocks at once and hashes them interleaved,
+  // unless there are too few blocks to keep all workers busy that way
+  const size_t batchSize = std::max<size_t>(1, std::min<size_t>(Crypto::SLOW_HASH_MAX_WAYS, pending.size() / workersCount));
+  std::vector<Crypto::Hash> longHashes(pending.size());
+  std::vector<uint8_t> computed(pending.size(), 0);
+  std::atomic<size_t> next(0);
+  auto hash = [&pending, &longHashes, &computed, &next, batchSize] {
+    Crypto::cn_context context;
+    Crypto::slow_hash_allocate_state();
+    if (batchSize > 1) {
+      Crypto::slow_hash_allocate_multi_state();
+    }
+
+    Tools::ScopeExit freeState([] { Crypto::slow_hash_free_state(); });
+
+    BinaryArray blobs[Crypto::SLOW_HASH_MAX_WAYS];
+    const void* data[Crypto::SLOW_HASH_MAX_WAYS];
+    size_t lengths[Crypto::SLOW_HASH_MAX_WAYS];
+    size_t indexes[Crypto::SLOW_HASH_MAX_WAYS];
+    Crypto::Hash hashes[Crypto::SLOW_HASH_MAX_WAYS];
+    for (size_t first = next.fetch_add(batchSize); first < pending.size(); first = next.fetch_add(batchSize)) {
+      size_t count = 0;
+      for (size_t i = first; i < std::min(first + batchSize, pending.size()); ++i) {
+        if (get_block_longhash_blob(*pending[i].first, blobs[count])) {
+          data[count] = blobs[count].data();
+          lengths[count] = blobs[count].size();
+          indexes[count++] = i;
+        }
+      }
+
+      Crypto::cn_slow_hash_multi(context, data, lengths, count, hashes);
+      for (size_t k = 0; k < count; ++k) {
+        longHashes[indexes[k]] = hashes[k];
+        computed[indexes[k]] = 1;
+      }
+    }
+  };
+
+  std::vector<std::future<void>> workers;
+  for (size_t w = 1; w < workersCount; ++w) {
+    workers.push_back(startVerificationWorker(hash));
+  }
+
+  hash();
+  for (auto& worker : workers) {
+    worker.get();
+  }
+
+  for (size_t i = 0; i < pending.size(); ++i) {
+    if (computed[i]) {
+      m_longHashCache.put(pending[i].second, longHashes[i]);
+    }
+  }
+}
+
+bool Blockchain::getBlockLongHash(const Block& block, Crypto::Hash& longHash) {
+  Crypto::Hash blockHash = get_block_hash(block);
+  if (isLongHashCacheable(block) && m_longHashCache.get(blockHash, longHash)) {
+    return true;
+  }
+
+  Crypto::cn_context context;
+  if (!get_block_longhash(context, block, longHash)) {
+    return false;
+  }
+
+  if (isLongHashCacheable(block)) {
+    m_longHashCache.put(blockHash, longHash);
+  }
+
+  return true;
+}
+
+void Blockchain::getLongHashCacheStatistics(uint64_t& hits, uint64_t& misses) const {
+  hits = m_longHashCache.hits();
+  misses = m_longHashCache.misses();
+}
+
+void Blockchain::writeMetrics(std::ostream& out) {
+  writeMetricHeader(out, "karbo_block_validation_seconds", "histogram", "Time spent validating and storing the blocks added to the main chain, by stage.");
+  writeMetricHistogram(out, "karbo_block_validation_seconds", "stage=\"pow\"", m_proofOfWorkTime, true);
+  writeMetricHistogram(out, "karbo_block_validation_seconds", "stage=\"inputs\"", m_inputsCheckTime, true);
+  writeMetricHistogram(out, "karbo_block_validation_seconds", "stage=\"ring_signatures\"", m_ringSignaturesTime, true);
+  writeMetricHistogram(out, "karbo_block_validation_seconds", "stage=\"store\"", m_blockStoreTime, true);
+  writeMetricHistogram(out, "karbo_block_validation_seconds", "stage=\"total\"", m_blockValidationTime, true);
+
+  writeMetricHeader(out, "karbo_reorganization_depth", "histogram", "Main chain blocks disconnected by a successful reorganization.");
+  writeMetricHistogram(out, "karbo_reorganization_depth", std::string(), m_reorganizationDepth, false);
+
+  size_t height;
+  size_t spentKeyImages;
+  size_t outputAmounts;
+  size_t outputs = 0;
+  size_t alternativeBlocks;
+  {
+    Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+    height = m_blocks.size();
+    spentKeyImages = m_spent_key_images.size();
+    outputAmounts = m_outputs.size();
+    for (const auto& amountOutputs : m_outputs) {
+      outputs += amountOutputs.second.size();
+    }
+
+    alternativeBlocks = m_alternative_chains.size();
+  }
+
+  writeMetricHeader(out, "karbo_blockchain_height", "gauge", "Blocks in the main chain.");
+  out << "karbo_blockchain_height " << height << '\n';
+  writeMetricHeader(out, "karbo_blockchain_spent_key_images", "gauge", "Key images spent in the main chain.");
+  out << "karbo_blockchain_spent_key_images " << spentKeyImages << '\n';
+  writeMetricHeader(out, "karbo_blockchain_output_amounts", "gauge", "Distinct output amounts in the main chain.");
+  out << "karbo_blockchain_output_amounts " << outputAmounts << '\n';
+  writeMetricHeader(out, "karbo_blockchain_outputs", "gauge", "Outputs in the main chain.");
+  out << "karbo_blockchain_outputs " << outputs << '\n';
+  writeMetricHeader(out, "karbo_blockchain_alternative_blocks", "gauge", "Blocks kept in alternative chains.");
+  out << "karbo_blockchain_alternative_blocks " << alternativeBlocks << '\n';
+
+  writeMetricHeader(out, "karbo_cache_entries", "gauge", "Entries in the validation caches.");
+  out << "karbo_cache_entries{cache=\"long_hash\"} " << m_longHashCache.size() << '\n';
+  out << "karbo_cache_entries{cache=\"ring_member\"} " << m_ringMemberCache.size() << '\n';
+  writeMetricHeader(out, "karbo_cache_hits_total", "counter", "Validation cache lookups which found the entry.");
+  out << "karbo_cache_hits_total{cache=\"long_hash\"} " << m_longHashCache.hits() << '\n';
+  out << "karbo_cache_hits_total{cache=\"ring_member\"} " << m_ringMemberCache.hits() << '\n';
+  writeMetricHeader(out, "karbo_cache_misses_total", "counter", "Validation cache lookups which missed.");
+  out << "karbo_cache_misses_total{cache=\"long_hash\"} " << m_longHashCache.misses() << '\n';
+  out << "karbo_cache_misses_total{cache=\"ring_member\"} " << m_ringMemberCache.misses() << '\n';
+}
+
+bool Blockchain::checkProofOfWork(const Block& block, const Crypto::Hash& blockHash, difficulty_type difficulty, Crypto::Hash& proofOfWork) {
+  if (!isLongHashCacheable(block)) {
+    return m_currency.checkProofOfWork(m_cn_context, block, difficulty, proofOfWork);
+  }
+
+  if (m_longHashCache.get(blockHash, proofOfWork)) {
+    return m_currency.checkProofOfWork(block, difficulty, proofOfWork);
+  }
+
+  if (!m_currency.checkProofOfWork(m_cn_context, block, difficulty, proofOfWork)) {
+    return false;
+  }
+
+  m_longHashCache.put(blockHash, proofOfWork);
+  return true;
+}
+
 uint64_t Blockchain::get_adjusted_time() {
   //TODO: add collecting median time
   return time(NULL);
@@ -1962,13 +3225,10 @@ bool Blockchain::check_block_timestamp_main(const Block& b) {
     return false;
   }
 
-  std::vector<uint64_t> timestamps;
   size_t offset = m_blocks.size() <= m_currency.timestampCheckWindow(b.majorVersion) ? 0 : m_blocks.size() - m_currency.timestampCheckWindow(b.majorVersion);
-  for (; offset != m_blocks.size(); ++offset) {
-    timestamps.push_back(m_blocks[offset].bl.timestamp);
-  }
+  m_timestampWindow.assign(m_blockColumns.timestamps().begin() + offset, m_blockColumns.timestamps().end());
 
-  return check_block_timestamp(std::move(timestamps), b);
+  return check_block_timestamp(m_timestampWindow, b);
 }
 
 //------------------------------------------------------------------
@@ -1979,7 +3239,7 @@ bool Blockchain::check_block_timestamp_main(const Block& b) {
 //   true if the block's timestamp is not less than the median timestamp
 //       of the selected blocks
 //   false otherwise
-bool Blockchain::check_block_timestamp(std::vector<uint64_t> timestamps, const Block& b) {
+bool Blockchain::check_block_timestamp(std::vector<uint64_t>& timestamps, const Block& b) {
   if (timestamps.size() < m_currency.timestampCheckWindow(b.majorVersion)) {
     return true;
   }
@@ -2042,12 +3302,25 @@ bool Blockchain::checkCumulativeBlockSize(const Crypto::Hash& blockId, size_t cu
 }
 
 // Returns true, if cumulativeSize is calculated precisely, else returns false.
+// Precondition: m_blockchain_lock is locked.
 bool Blockchain::getBlockCumulativeSize(const Block& block, size_t& cumulativeSize) {
+  cumulativeSize = getObjectBinarySize(block.baseTransaction);
+
+  // transactions of the main chain are measured by their stored blobs
+  std::vector<Crypto::Hash> unstoredTxs;
+  for (const Crypto::Hash& transactionHash : block.transactionHashes) {
+    TransactionIndex transactionIndex;
+    if (m_transactionMap.find(transactionHash, transactionIndex)) {
+      cumulativeSize += m_blocks.transactionBlob(transactionIndex.block, transactionIndex.transaction).getSize();
+    } else {
+      unstoredTxs.push_back(transactionHash);
+    }
+  }
+
   std::vector<Transaction> blockTxs;
   std::vector<Crypto::Hash> missedTxs;
-  getTransactions(block.transactionHashes, blockTxs, missedTxs, true);
+  getTransactions(unstoredTxs, blockTxs, missedTxs, true);
 
-  cumulativeSize = getObjectBinarySize(block.baseTransaction);
   for (const Transaction& tx : blockTxs) {
     cumulativeSize += getObjectBinarySize(tx);
   }
@@ -2060,10 +3333,7 @@ bool Blockchain::update_next_cumulative_size_limit() {
   uint8_t nextBlockMajorVersion = getBlockMajorVersionForHeight(static_cast<uint32_t>(m_blocks.size()));
   size_t nextBlockGrantedFullRewardZone = m_currency.blockGrantedFullRewardZoneByBlockVersion(nextBlockMajorVersion);
 
-  std::vector<size_t> sz;
-  get_last_n_blocks_sizes(sz, m_currency.rewardBlocksWindow());
-
-  uint64_t median = Common::medianValue(sz);
+  uint64_t median = m_lastBlocksSizes.median();
   if (median <= nextBlockGrantedFullRewardZone) {
     median = nextBlockGrantedFullRewardZone;
   }
@@ -2073,6 +3343,7 @@ bool Blockchain::update_next_cumulative_size_limit() {
 }
 
 bool Blockchain::addNewBlock(const Block& bl, block_verification_context& bvc) {
+  TraceSpan span("blockchain", "add_new_block");
   Crypto::Hash id;
   if (!get_block_hash(bl, id)) {
     logger(ERROR, BRIGHT_RED) <<
@@ -2081,6 +3352,8 @@ bool Blockchain::addNewBlock(const Block& bl, block_verification_context& bvc) {
     return false;
   }
 
+  span.setPodId(id);
+
   bool add_result;
 
   { //to avoid deadlock lets lock tx_pool for whole add/reorganize process
@@ -2101,24 +3374,49 @@ bool Blockchain::addNewBlock(const Block& bl, block_verification_context& bvc) {
                         << " as it doesn't refer to chain tail " << Common::podToHex(getTailId())
                         << ", its prev. block hash: " << Common::podToHex(bl.previousBlockHash);
       bvc.m_added_to_main_chain = false;
+      TraceSpan alternativeSpan("blockchain", "handle_alternative_block");
       add_result = handle_alternative_block(bl, id, bvc);
     } else {
-      add_result = pushBlock(bl, id, bvc);
+      {
+        TraceSpan pushSpan("blockchain", "push_block");
+        add_result = pushBlock(bl, id, bvc);
+      }
+
       if (add_result) {
+        TraceSpan messageSpan("observers", "new_block_message");
         sendMessage(BlockchainMessage(NewBlockMessage(id)));
       }
     }
   }
 
   if (add_result && bvc.m_added_to_main_chain) {
+    TraceSpan observersSpan("observers", "blockchain_updated");
     m_observerManager.notify(&IBlockchainStorageObserver::blockchainUpdated);
   }
 
   return add_result;
 }
 
-const Blockchain::TransactionEntry& Blockchain::transactionByIndex(TransactionIndex index) {
-  return m_blocks[index.block].transactions[index.transaction];
+// Keeps the whole block entry alive, so the result may outlive its SwappedVector cache slot.
+std::shared_ptr<const Blockchain::TransactionEntry> Blockchain::transactionByIndex(TransactionIndex index) {
+  std::shared_ptr<const BlockEntry> block = m_blocks.get(index.block);
+  return std::shared_ptr<const TransactionEntry>(block, &block->transactions[index.transaction]);
+}
+
+Transaction Blockchain::loadTransaction(TransactionIndex index) const {
+  Common::ArrayView<uint8_t> blob = m_blocks.transactionBlob(index.block, index.transaction);
+  Transaction transaction;
+  Common::MemoryInputStream stream(blob.getData(), blob.getSize());
+  BinaryInputStreamSerializer archive(stream);
+  CryptoNote::serialize(transaction, archive);
+  return transaction;
+}
+
+Crypto::Hash Blockchain::transactionHash(const TransactionIndex& index) const {
+  Common::ArrayView<uint8_t> blob = m_blocks.transactionBlob(index.block, index.transaction);
+  Crypto::Hash hash;
+  Crypto::cn_fast_hash(blob.getData(), blob.getSize(), hash);
+  return hash;
 }
 
 bool Blockchain::pushBlock(const Block& blockData, const Crypto::Hash& id, block_verification_context& bvc) {
@@ -2137,6 +3435,7 @@ bool Blockchain::pushBlock(const Block& blockData, const Crypto::Hash& id, block
 }
 
 bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction>& transactions, const Crypto::Hash& blockHash, block_verification_context& bvc) {
+  Common::AllocationScope allocationScope(Common::AllocationSubsystem::Blockchain);
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   auto blockProcessingStart = std::chrono::steady_clock::now();
@@ -2202,7 +3501,7 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
       return false;
     }
   } else {
-    if (!m_currency.checkProofOfWork(m_cn_context, blockData, currentDifficulty, proof_of_work)) {
+    if (!checkProofOfWork(blockData, blockHash, currentDifficulty, proof_of_work)) {
       logger(INFO, BRIGHT_WHITE) <<
         "Block " << blockHash << ", has too weak proof of work: " << proof_of_work << ", expected difficulty: " << currentDifficulty;
       bvc.m_verification_failed = true;
@@ -2210,7 +3509,8 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
     }
   }
 
-  auto longhash_calculating_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - longhashTimeStart).count();
+  auto proofOfWorkTime = std::chrono::steady_clock::now() - longhashTimeStart;
+  auto longhash_calculating_time = std::chrono::duration_cast<std::chrono::milliseconds>(proofOfWorkTime).count();
 
   if (!prevalidate_miner_transaction(blockData, static_cast<uint32_t>(m_blocks.size()))) {
     logger(INFO, BRIGHT_WHITE) <<
@@ -2223,24 +3523,39 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
 
   BlockEntry block;
   block.bl = blockData;
+  block.transactions.reserve(transactions.size() + 1);
   block.transactions.resize(1);
   block.transactions[0].tx = blockData.baseTransaction;
   TransactionIndex transactionIndex = { static_cast<uint32_t>(m_blocks.size()), static_cast<uint16_t>(0) };
+  auto storeStart = std::chrono::steady_clock::now();
   pushTransaction(block, minerTransactionHash, transactionIndex);
+  auto storeTime = std::chrono::steady_clock::now() - storeStart;
+  auto inputsCheckTime = std::chrono::steady_clock::duration::zero();
 
   size_t coinbase_blob_size = getObjectBinarySize(blockData.baseTransaction);
   size_t cumulative_block_size = coinbase_blob_size;
   uint64_t fee_summary = 0;
+  std::vector<RingSignatureCheck> ringSignatures;
+  ringSignatures.reserve(transactions.size());
+
+  // hashes, sizes, fees and the checks that don't need the chain are done for all transactions at once,
+  // only the spent key images and the referenced outputs are checked one transaction after another
+  auto inputsCheckStart = std::chrono::steady_clock::now();
+  precheckTransactions(transactions, !isInCheckpointZone(getCurrentBlockchainHeight()), m_transactionPrechecks);
+  inputsCheckTime += std::chrono::steady_clock::now() - inputsCheckStart;
   for (size_t i = 0; i < transactions.size(); ++i) {
     const Crypto::Hash& tx_id = blockData.transactionHashes[i];
+    const TransactionPrecheck& precheck = m_transactionPrechecks[i];
     block.transactions.resize(block.transactions.size() + 1);
-    size_t blob_size = 0;
-    uint64_t fee = 0;
+    size_t blob_size = precheck.blobSize;
+    uint64_t fee = precheck.fee;
     block.transactions.back().tx = transactions[i];
 
-    blob_size = toBinaryArray(block.transactions.back().tx).size();
-    fee = getInputAmount(block.transactions.back().tx) - getOutputAmount(block.transactions.back().tx);
-    if (!checkTransactionInputs(block.transactions.back().tx)) {
+    const Transaction& tx = block.transactions.back().tx;
+    inputsCheckStart = std::chrono::steady_clock::now();
+    bool inputsValid = precheck.valid && checkTransactionInputsInChain(tx, precheck.hash, precheck.prefixHash, NULL, &ringSignatures);
+    inputsCheckTime += std::chrono::steady_clock::now() - inputsCheckStart;
+    if (!inputsValid) {
       logger(INFO, BRIGHT_WHITE) <<
         "Block " << blockHash << " has at least one transaction with wrong inputs: " << tx_id;
       bvc.m_verification_failed = true;
@@ -2251,12 +3566,26 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
     }
 
     ++transactionIndex.transaction;
+    storeStart = std::chrono::steady_clock::now();
     pushTransaction(block, tx_id, transactionIndex);
+    storeTime += std::chrono::steady_clock::now() - storeStart;
 
     cumulative_block_size += blob_size;
     fee_summary += fee;
   }
 
+  // transaction inputs have been checked against the chain, the signatures of the whole block are verified at once
+  auto ringSignaturesStart = std::chrono::steady_clock::now();
+  bool ringSignaturesValid = checkRingSignatures(ringSignatures);
+  auto ringSignaturesTime = std::chrono::steady_clock::now() - ringSignaturesStart;
+  if (!ringSignaturesValid) {
+    logger(INFO, BRIGHT_WHITE) <<
+      "Block " << blockHash << " has at least one transaction with invalid ring signature";
+    bvc.m_verification_failed = true;
+    popTransactions(block, minerTransactionHash);
+    return false;
+  }
+
   if (!checkCumulativeBlockSize(blockHash, cumulative_block_size, m_blocks.size())) {
     bvc.m_verification_failed = true;
     return false;
@@ -2264,7 +3593,7 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
 
   int64_t emissionChange = 0;
   uint64_t reward = 0;
-  uint64_t already_generated_coins = m_blocks.empty() ? 0 : m_blocks.back().already_generated_coins;
+  uint64_t already_generated_coins = m_blockColumns.empty() ? 0 : m_blockColumns.generatedCoins().back();
   if (!validate_miner_transaction(blockData, static_cast<uint32_t>(m_blocks.size()), cumulative_block_size, already_generated_coins, fee_summary, reward, emissionChange)) {
     logger(INFO, BRIGHT_WHITE) << "Block " << blockHash << " has invalid miner transaction";
     bvc.m_verification_failed = true;
@@ -2277,12 +3606,21 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
   block.cumulative_difficulty = currentDifficulty;
   block.already_generated_coins = already_generated_coins + emissionChange;
   if (m_blocks.size() > 0) {
-    block.cumulative_difficulty += m_blocks.back().cumulative_difficulty;
+    block.cumulative_difficulty += m_blockColumns.cumulativeDifficulties().back();
   }
 
+  storeStart = std::chrono::steady_clock::now();
   pushBlock(block, blockHash);
+  addBlockSummary(block, proof_of_work);
+  storeTime += std::chrono::steady_clock::now() - storeStart;
 
-  auto block_processing_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - blockProcessingStart).count();
+  auto blockProcessingTime = std::chrono::steady_clock::now() - blockProcessingStart;
+  auto block_processing_time = std::chrono::duration_cast<std::chrono::milliseconds>(blockProcessingTime).count();
+  m_proofOfWorkTime.add(proofOfWorkTime);
+  m_inputsCheckTime.add(inputsCheckTime);
+  m_ringSignaturesTime.add(ringSignaturesTime);
+  m_blockStoreTime.add(storeTime);
+  m_blockValidationTime.add(blockProcessingTime);
 
   if (block.height % 1000 == 0) {
     logger(INFO) << "Blockchain loaded to height: " << block.height;
@@ -2304,15 +3642,24 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
   m_upgradeDetectorV5.blockPushed();
 
   update_next_cumulative_size_limit();
+  m_tx_pool.on_blockchain_inc(m_blocks.size(), blockHash);
 
   return true;
 }
 
 bool Blockchain::pushBlock(BlockEntry& block, const Crypto::Hash& blockHash) {
   m_blocks.push_back(block);
+  m_blockColumns.push(block.bl.timestamp, block.cumulative_difficulty, block.block_cumulative_size, block.already_generated_coins,
+    static_cast<uint32_t>(block.transactions.size()));
+  m_lastBlocksSizes.push_back(block.block_cumulative_size);
+  if (m_lastBlocksSizes.size() > m_currency.rewardBlocksWindow()) {
+    m_lastBlocksSizes.pop_front();
+  }
   m_blockIndex.push(blockHash);
   m_timestampIndex.add(block.bl.timestamp, blockHash);
   m_generatedTransactionsIndex.add(block.bl);
+  addBlockFilter(block, blockHash);
+  m_paymentIdIndex.setTop(static_cast<uint32_t>(m_blocks.size()), blockHash);
 
   assert(m_blockIndex.size() == m_blocks.size());
 
@@ -2320,19 +3667,23 @@ bool Blockchain::pushBlock(BlockEntry& block, const Crypto::Hash& blockHash) {
 }
 
 void Blockchain::popBlock() {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (m_blocks.empty()) {
     logger(ERROR, BRIGHT_RED) <<
       "Attempt to pop block from empty blockchain.";
     return;
   }
 
+  // the pool gets them back with their signatures
+  uint32_t height = static_cast<uint32_t>(m_blocks.size() - 1);
   std::vector<Transaction> transactions(m_blocks.back().transactions.size() - 1);
-  for (size_t i = 0; i < m_blocks.back().transactions.size() - 1; ++i) {
-    transactions[i] = m_blocks.back().transactions[1 + i].tx;
+  for (size_t i = 0; i < transactions.size(); ++i) {
+    transactions[i] = loadTransaction({ height, static_cast<uint16_t>(1 + i) });
   }
 
   saveTransactions(transactions);
   removeLastBlock();
+  m_tx_pool.on_blockchain_dec(m_blocks.size(), getTailId());
 
   m_upgradeDetectorV2.blockPopped();
   m_upgradeDetectorV3.blockPopped();
@@ -2341,8 +3692,7 @@ void Blockchain::popBlock() {
 }
 
 bool Blockchain::pushTransaction(BlockEntry& block, const Crypto::Hash& transactionHash, TransactionIndex transactionIndex) {
-  auto result = m_transactionMap.insert(std::make_pair(transactionHash, transactionIndex));
-  if (!result.second) {
+  if (!m_transactionMap.insert(transactionHash, transactionIndex)) {
     logger(ERROR, BRIGHT_RED) <<
       "Duplicate transaction was pushed to blockchain.";
     return false;
@@ -2359,8 +3709,7 @@ bool Blockchain::pushTransaction(BlockEntry& block, const Crypto::Hash& transact
 
   for (size_t i = 0; i < transaction.tx.inputs.size(); ++i) {
     if (transaction.tx.inputs[i].type() == typeid(KeyInput)) {
-      auto result = m_spent_key_images.insert(std::make_pair(::boost::get<KeyInput>(transaction.tx.inputs[i]).keyImage, block.height));
-      if (!result.second) {
+      if (!m_spent_key_images.insert(::boost::get<KeyInput>(transaction.tx.inputs[i]).keyImage, block.height)) {
         logger(ERROR, BRIGHT_RED) <<
           "Double spending transaction was pushed to blockchain.";
         for (size_t j = 0; j < i; ++j) {
@@ -2386,6 +3735,8 @@ bool Blockchain::pushTransaction(BlockEntry& block, const Crypto::Hash& transact
       auto& amountOutputs = m_outputs[transaction.tx.outputs[output].amount];
       transaction.m_global_output_indexes[output] = static_cast<uint32_t>(amountOutputs.size());
       amountOutputs.push_back(std::make_pair<>(transactionIndex, output));
+      OutputKeyInfo keyInfo = { ::boost::get<KeyOutput>(transaction.tx.outputs[output].target).key, transaction.tx.unlockTime, transactionIndex.block };
+      m_outputKeys[transaction.tx.outputs[output].amount].push_back(keyInfo);
     } else if (transaction.tx.outputs[output].target.type() == typeid(MultisignatureOutput)) {
       auto& amountOutputs = m_multisignatureOutputs[transaction.tx.outputs[output].amount];
       transaction.m_global_output_indexes[output] = static_cast<uint32_t>(amountOutputs.size());
@@ -2394,13 +3745,17 @@ bool Blockchain::pushTransaction(BlockEntry& block, const Crypto::Hash& transact
     }
   }
 
-  m_paymentIdIndex.add(transaction.tx);
+  m_paymentIdIndex.add(transaction.tx, transactionHash);
 
   return true;
 }
 
 void Blockchain::popTransaction(const Transaction& transaction, const Crypto::Hash& transactionHash) {
-  TransactionIndex transactionIndex = m_transactionMap.at(transactionHash);
+  TransactionIndex transactionIndex;
+  if (!m_transactionMap.find(transactionHash, transactionIndex)) {
+    throw std::out_of_range("Blockchain::popTransaction: unknown transaction " + Common::podToHex(transactionHash));
+  }
+
   for (size_t outputIndex = 0; outputIndex < transaction.outputs.size(); ++outputIndex) {
     const TransactionOutput& output = transaction.outputs[transaction.outputs.size() - 1 - outputIndex];
     if (output.target.type() == typeid(KeyOutput)) {
@@ -2433,6 +3788,14 @@ void Blockchain::popTransaction(const Transaction& transaction, const Crypto::Ha
       if (amountOutputs->second.empty()) {
         m_outputs.erase(amountOutputs);
       }
+
+      auto amountKeys = m_outputKeys.find(output.amount);
+      if (amountKeys != m_outputKeys.end() && !amountKeys->second.empty()) {
+        amountKeys->second.pop_back();
+        if (amountKeys->second.empty()) {
+          m_outputKeys.erase(amountKeys);
+        }
+      }
     } else if (output.target.type() == typeid(MultisignatureOutput)) {
       auto amountOutputs = m_multisignatureOutputs.find(output.amount);
       if (amountOutputs == m_multisignatureOutputs.end()) {
@@ -2491,7 +3854,7 @@ void Blockchain::popTransaction(const Transaction& transaction, const Crypto::Ha
     }
   }
 
-  m_paymentIdIndex.remove(transaction);
+  m_paymentIdIndex.remove(transaction, transactionHash);
 
   size_t count = m_transactionMap.erase(transactionHash);
   if (count != 1) {
@@ -2530,7 +3893,8 @@ bool Blockchain::validateInput(const MultisignatureInput& input, const Crypto::H
     return false;
   }
 
-  const Transaction& outputTransaction = m_blocks[outputIndex.transactionIndex.block].transactions[outputIndex.transactionIndex.transaction].tx;
+  std::shared_ptr<const TransactionEntry> outputTransactionEntry = transactionByIndex(outputIndex.transactionIndex);
+  const Transaction& outputTransaction = outputTransactionEntry->tx;
   if (!is_tx_spendtime_unlocked(outputTransaction.unlockTime)) {
     logger(DEBUGGING) <<
       "Transaction << " << transactionHash << " contains multisignature input which points to a locked transaction.";
@@ -2583,6 +3947,7 @@ bool Blockchain::checkCheckpoints(uint32_t& lastValidCheckpointHeight) {
 }
 
 void Blockchain::rollbackBlockchainTo(uint32_t height) {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   while (height + 1 < m_blocks.size()) {
     removeLastBlock();
   }
@@ -2596,14 +3961,28 @@ void Blockchain::removeLastBlock() {
   }
 
   logger(DEBUGGING) << "Removing last block with height " << m_blocks.back().height;
+  if (m_blocks.size() - 1 <= m_cacheSnapshotHeight) {
+    // the saved cache contains this block and can't be replayed forward any more
+    m_cacheSnapshotHeight = 0;
+  }
+
   popTransactions(m_blocks.back(), getObjectHash(m_blocks.back().bl.baseTransaction));
 
   Crypto::Hash blockHash = getBlockIdByHeight(m_blocks.back().height);
   m_timestampIndex.remove(m_blocks.back().bl.timestamp, blockHash);
   m_generatedTransactionsIndex.remove(m_blocks.back().bl);
+  m_blockFilterIndex.removeLast();
+  m_blockSummaryIndex.removeLast();
 
   m_blocks.pop_back();
+  m_blockColumns.pop();
+  m_lastBlocksSizes.pop_back();
+  if (m_blockColumns.size() >= m_currency.rewardBlocksWindow()) {
+    // the block that drops out of the window gets back in
+    m_lastBlocksSizes.push_front(m_blockColumns.cumulativeSizes()[m_blockColumns.size() - m_currency.rewardBlocksWindow()]);
+  }
   m_blockIndex.pop();
+  m_paymentIdIndex.setTop(static_cast<uint32_t>(m_blocks.size()), m_blocks.empty() ? NULL_HASH : m_blockIndex.getBlockId(static_cast<uint32_t>(m_blocks.size() - 1)));
 
   assert(m_blockIndex.size() == m_blocks.size());
 }
@@ -2621,45 +4000,55 @@ bool Blockchain::checkUpgradeHeight(const UpgradeDetector& upgradeDetector) {
 }
 
 bool Blockchain::getLowerBound(uint64_t timestamp, uint64_t startOffset, uint32_t& height) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   assert(startOffset < m_blocks.size());
 
-  auto bound = std::lower_bound(m_blocks.begin() + startOffset, m_blocks.end(), timestamp - m_currency.blockFutureTimeLimit(),
-    [](const BlockEntry& b, uint64_t timestamp) { return b.bl.timestamp < timestamp; });
-
-  if (bound == m_blocks.end()) {
+  uint64_t lowerTimestamp = timestamp > m_currency.blockFutureTimeLimit() ? timestamp - m_currency.blockFutureTimeLimit() : 0;
+  size_t first = m_blockColumns.lowerBound(lowerTimestamp, static_cast<size_t>(startOffset));
+  if (first == m_blocks.size()) {
     return false;
   }
 
-  height = static_cast<uint32_t>(std::distance(m_blocks.begin(), bound));
+  height = static_cast<uint32_t>(first);
   return true;
 }
 
+void Blockchain::getBlockHeightsByTimestamps(const std::vector<uint64_t>& timestamps, std::vector<uint32_t>& heights) {
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+
+  heights.clear();
+  heights.reserve(timestamps.size());
+  for (uint64_t timestamp : timestamps) {
+    uint64_t lowerTimestamp = timestamp > m_currency.blockFutureTimeLimit() ? timestamp - m_currency.blockFutureTimeLimit() : 0;
+    heights.push_back(static_cast<uint32_t>(m_blockColumns.lowerBound(lowerTimestamp)));
+  }
+}
+
 std::vector<Crypto::Hash> Blockchain::getBlockIds(uint32_t startHeight, uint32_t maxCount) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_blockIndex.getBlockIds(startHeight, maxCount);
 }
 
 bool Blockchain::getBlockContainingTransaction(const Crypto::Hash& txId, Crypto::Hash& blockId, uint32_t& blockHeight) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-  auto it = m_transactionMap.find(txId);
-  if (it == m_transactionMap.end()) {
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  TransactionIndex transactionIndex;
+  if (!m_transactionMap.find(txId, transactionIndex)) {
     return false;
   } else {
-    blockHeight = m_blocks[it->second.block].height;
+    blockHeight = m_blocks.get(transactionIndex.block)->height;
     blockId = getBlockIdByHeight(blockHeight);
     return true;
   }
 }
 
 bool Blockchain::getAlreadyGeneratedCoins(const Crypto::Hash& hash, uint64_t& generatedCoins) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   // try to find block in main chain
   uint32_t height = 0;
   if (m_blockIndex.getBlockHeight(hash, height)) {
-    generatedCoins = m_blocks[height].already_generated_coins;
+    generatedCoins = m_blockColumns.generatedCoins()[height];
     return true;
   }
 
@@ -2675,12 +4064,12 @@ bool Blockchain::getAlreadyGeneratedCoins(const Crypto::Hash& hash, uint64_t& ge
 }
 
 bool Blockchain::getBlockSize(const Crypto::Hash& hash, size_t& size) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   // try to find block in main chain
   uint32_t height = 0;
   if (m_blockIndex.getBlockHeight(hash, height)) {
-    size = m_blocks[height].block_cumulative_size;
+    size = m_blockColumns.cumulativeSizes()[height];
     return true;
   }
 
@@ -2696,7 +4085,7 @@ bool Blockchain::getBlockSize(const Crypto::Hash& hash, size_t& size) {
 }
 
 bool Blockchain::getMultisigOutputReference(const MultisignatureInput& txInMultisig, std::pair<Crypto::Hash, size_t>& outputReference) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   MultisignatureOutputsContainer::const_iterator amountIter = m_multisignatureOutputs.find(txInMultisig.amount);
   if (amountIter == m_multisignatureOutputs.end()) {
     logger(DEBUGGING) << "Transaction contains multisignature input with invalid amount.";
@@ -2707,14 +4096,13 @@ bool Blockchain::getMultisigOutputReference(const MultisignatureInput& txInMulti
     return false;
   }
   const MultisignatureOutputUsage& outputIndex = amountIter->second[txInMultisig.outputIndex];
-  const Transaction& outputTransaction = m_blocks[outputIndex.transactionIndex.block].transactions[outputIndex.transactionIndex.transaction].tx;
-  outputReference.first = getObjectHash(outputTransaction);
+  outputReference.first = transactionHash(outputIndex.transactionIndex);
   outputReference.second = outputIndex.outputIndex;
   return true;
 }
 
 bool Blockchain::storeBlockchainIndices() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   logger(INFO, BRIGHT_WHITE) << "Saving blockchain indices...";
   BlockchainIndicesSerializer ser(*this, getTailId(), logger.getLogger());
@@ -2727,58 +4115,156 @@ bool Blockchain::storeBlockchainIndices() {
   return true;
 }
 
-bool Blockchain::loadBlockchainIndices() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-
+bool Blockchain::readBlockchainIndices(const Crypto::Hash& lastBlockHash) {
   logger(INFO, BRIGHT_WHITE) << "Loading blockchain indices for BlockchainExplorer...";
-  BlockchainIndicesSerializer loader(*this, get_block_hash(m_blocks.back().bl), logger.getLogger());
+  BlockchainIndicesSerializer loader(*this, lastBlockHash, logger.getLogger());
 
   loadFromBinaryFile(loader, appendPath(m_config_folder, m_currency.blockchainIndicesFileName()));
+  return loader.loaded();
+}
 
-  if (!loader.loaded()) {
-    logger(WARNING, BRIGHT_YELLOW) << "No actual blockchain indices for BlockchainExplorer found, rebuilding...";
-    std::chrono::steady_clock::time_point timePoint = std::chrono::steady_clock::now();
+void Blockchain::rebuildBlockchainIndices() {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+
+  logger(WARNING, BRIGHT_YELLOW) << "No actual blockchain indices for BlockchainExplorer found, rebuilding...";
+  std::chrono::steady_clock::time_point timePoint = std::chrono::steady_clock::now();
+
+  m_generatedTransactionsIndex.clear();
+  m_blockFilterIndex.clear();
+  m_blockSummaryIndex.clear();
+  addBlockchainIndices(0);
+
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - timePoint;
+  logger(INFO, BRIGHT_WHITE) << "Rebuilding blockchain indices took: " << duration.count();
+}
+
+void Blockchain::addBlockchainIndices(uint32_t startHeight) {
+  for (uint32_t b = startHeight; b < m_blocks.size(); ++b) {
+    if (b % 1000 == 0) {
+      logger(INFO, BRIGHT_WHITE) << "Height " << b << " of " << m_blocks.size();
+    }
+    const BlockEntry& block = m_blocks[b];
+    m_generatedTransactionsIndex.add(block.bl);
+    addBlockFilter(block, get_block_hash(block.bl));
+    // the proof of work of the stored blocks isn't recomputed, it stays unknown
+    addBlockSummary(block, NULL_HASH);
+  }
+}
 
+// The payment id file is kept up to date with every block, it's only reindexed from where
+// it stopped following the main chain
+void Blockchain::loadPaymentIdIndex() {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+
+  uint32_t blockCount = m_paymentIdIndex.blockCount();
+  if (blockCount <= m_blocks.size() && (blockCount == 0 || m_blockIndex.getBlockId(blockCount - 1) == m_paymentIdIndex.topBlockHash())) {
+    m_paymentIdIndex.load();
+  } else {
     m_paymentIdIndex.clear();
-    m_timestampIndex.clear();
-    m_generatedTransactionsIndex.clear();
+    blockCount = 0;
+  }
 
-    for (uint32_t b = 0; b < m_blocks.size(); ++b) {
-      if (b % 1000 == 0) {
-        logger(INFO, BRIGHT_WHITE) << "Height " << b << " of " << m_blocks.size();
-      }
-      const BlockEntry& block = m_blocks[b];
-      m_timestampIndex.add(block.bl.timestamp, get_block_hash(block.bl));
-      m_generatedTransactionsIndex.add(block.bl);
-      for (uint16_t t = 0; t < block.transactions.size(); ++t) {
-        const TransactionEntry& transaction = block.transactions[t];
-        m_paymentIdIndex.add(transaction.tx);
-      }
+  if (blockCount < m_blocks.size()) {
+    logger(INFO, BRIGHT_WHITE) << "Indexing payment ids of " << m_blocks.size() - blockCount << " blocks...";
+  }
+
+  for (uint32_t b = blockCount; b < m_blocks.size(); ++b) {
+    const BlockEntry& block = m_blocks[b];
+    m_paymentIdIndex.add(block.bl.baseTransaction, getObjectHash(block.bl.baseTransaction));
+    for (size_t t = 1; t < block.transactions.size(); ++t) {
+      m_paymentIdIndex.add(block.transactions[t].tx, block.bl.transactionHashes[t - 1]);
     }
 
-    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - timePoint;
-    logger(INFO, BRIGHT_WHITE) << "Rebuilding blockchain indices took: " << duration.count();
+    m_paymentIdIndex.setTop(b + 1, m_blockIndex.getBlockId(b));
   }
-  return true;
 }
 
-bool Blockchain::getGeneratedTransactionsNumber(uint32_t height, uint64_t& generatedTransactions) {
+// the block store keeps the timestamps of all blocks, so this index isn't saved
+void Blockchain::loadTimestampIndex() {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+
+  m_timestampIndex.clear();
+  for (uint32_t b = 0; b < m_blockColumns.size(); ++b) {
+    m_timestampIndex.add(m_blockColumns.timestamps()[b], m_blockIndex.getBlockId(b));
+  }
+}
+
+bool Blockchain::getGeneratedTransactionsNumber(uint32_t height, uint64_t& generatedTransactions) {
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_generatedTransactionsIndex.find(height, generatedTransactions);
 }
 
 bool Blockchain::getOrphanBlockIdsByHeight(uint32_t height, std::vector<Crypto::Hash>& blockHashes) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_orphanBlocksIndex.find(height, blockHashes);
 }
 
+bool Blockchain::getBlockFilter(uint32_t height, std::string& filter, Crypto::Hash& header) {
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  return m_blockFilterIndex.find(height, filter, header);
+}
+
+bool Blockchain::getBlockFilterHeader(uint32_t height, Crypto::Hash& header) {
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  return m_blockFilterIndex.findHeader(height, header);
+}
+
+void Blockchain::addBlockFilter(const BlockEntry& block, const Crypto::Hash& blockHash) {
+  std::vector<Crypto::Hash> items;
+  for (const auto& transaction : block.transactions) {
+    std::vector<Crypto::Hash> transactionItems = BlockFilter::transactionItems(transaction.tx);
+    items.insert(items.end(), transactionItems.begin(), transactionItems.end());
+  }
+
+  m_blockFilterIndex.add(blockHash, items);
+}
+
+bool Blockchain::getBlockSummary(uint32_t height, BlockSummary& summary) {
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  return m_blockSummaryIndex.find(height, summary);
+}
+
+// Expects the block to be the last one pushed, the same values are calculated by
+// BlockchainExplorerDataBuilder::fillBlockDetails for the blocks not in the index
+void Blockchain::addBlockSummary(const BlockEntry& block, const Crypto::Hash& proofOfWork) {
+  if (!m_blockchainIndexesEnabled) {
+    return;
+  }
+
+  BlockSummary summary;
+  summary.proofOfWork = proofOfWork;
+  summary.reward = get_outs_money_amount(block.bl.baseTransaction);
+  for (size_t i = 1; i < block.transactions.size(); ++i) {
+    uint64_t fee = 0;
+    get_tx_fee(block.transactions[i].tx, fee);
+    summary.totalFee += fee;
+  }
+
+  size_t sizesEnd = block.height + 1;
+  size_t sizesBegin = sizesEnd - std::min<size_t>(sizesEnd, parameters::CRYPTONOTE_REWARD_BLOCKS_WINDOW);
+  std::vector<uint64_t> sizes(m_blockColumns.cumulativeSizes().begin() + sizesBegin, m_blockColumns.cumulativeSizes().begin() + sizesEnd);
+  summary.sizeMedian = Common::medianValue(sizes);
+
+  uint64_t prevGeneratedCoins = block.height == 0 ? 0 : m_blockColumns.generatedCoins()[block.height - 1];
+  uint64_t currentReward = 0;
+  int64_t emissionChange = 0;
+  if (m_currency.getBlockReward(block.bl.majorVersion, summary.sizeMedian, 0, prevGeneratedCoins, 0, summary.baseReward, emissionChange) &&
+      m_currency.getBlockReward(block.bl.majorVersion, summary.sizeMedian, block.block_cumulative_size, prevGeneratedCoins, 0, currentReward, emissionChange) &&
+      summary.baseReward > currentReward) {
+    summary.penalty = static_cast<double>(summary.baseReward - currentReward) / static_cast<double>(summary.baseReward);
+  }
+
+  summary.blockSize = getObjectBinarySize(block.bl) + block.block_cumulative_size - getObjectBinarySize(block.bl.baseTransaction);
+  m_blockSummaryIndex.add(summary);
+}
+
 bool Blockchain::getBlockIdsByTimestamp(uint64_t timestampBegin, uint64_t timestampEnd, uint32_t blocksNumberLimit, std::vector<Crypto::Hash>& hashes, uint32_t& blocksNumberWithinTimestamps) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_timestampIndex.find(timestampBegin, timestampEnd, blocksNumberLimit, hashes, blocksNumberWithinTimestamps);
 }
 
+// the index has locks of its own
 bool Blockchain::getTransactionIdsByPaymentId(const Crypto::Hash& paymentId, std::vector<Crypto::Hash>& transactionHashes) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_paymentIdIndex.find(paymentId, transactionHashes);
 }
 
@@ -19,23 +19,33 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
+#include <future>
+#include <mutex>
 #include <unordered_map>
 #include <parallel_hashmap/phmap.h>
 #include "google/sparse_hash_set"
 #include "google/sparse_hash_map"
 
+#include "Common/Metrics.h"
 #include "Common/ObserverManager.h"
+#include "Common/RecursiveSharedMutex.h"
+#include "Common/SlidingMedian.h"
 #include "Common/Util.h"
 #include "Checkpoints/Checkpoints.h"
+#include "CryptoNoteCore/BlockHeaderColumns.h"
 #include "CryptoNoteCore/BlockIndex.h"
+#include "CryptoNoteCore/BlockStore.h"
 #include "CryptoNoteCore/Currency.h"
 #include "CryptoNoteCore/IBlockchainStorageObserver.h"
+#include "CryptoNoteCore/LongHashCache.h"
+#include "CryptoNoteCore/RingMemberCache.h"
 #include "CryptoNoteCore/ITransactionValidator.h"
-#include "CryptoNoteCore/SwappedVector.h"
 #include "CryptoNoteCore/UpgradeDetector.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/TransactionPool.h"
 #include "CryptoNoteCore/BlockchainIndices.h"
+#include "CryptoNoteCore/BlockchainKeyValueIndex.h"
 
 #include "CryptoNoteCore/MessageQueue.h"
 #include "CryptoNoteCore/BlockchainMessages.h"
@@ -70,16 +80,43 @@ namespace CryptoNote {
     virtual bool checkTransactionSize(size_t blobSize) override;
 
     bool init() { return init(Tools::getDefaultDataDirectory(), true); }
-    bool init(const std::string& config_folder, bool load_existing);
+    // waitForPool, if set, blocks until the memory pool loading alongside is done, nothing is put into the pool before
+    bool init(const std::string& config_folder, bool load_existing, const std::function<void()>& waitForPool = std::function<void()>());
     bool deinit();
 
     bool getLowerBound(uint64_t timestamp, uint64_t startOffset, uint32_t& height);
+    // heights to start scanning from so that no block of the given timestamps or later is skipped
+    void getBlockHeightsByTimestamps(const std::vector<uint64_t>& timestamps, std::vector<uint32_t>& heights);
     std::vector<Crypto::Hash> getBlockIds(uint32_t startHeight, uint32_t maxCount);
 
     void setCheckpoints(Checkpoints&& chk_pts) { m_checkpoints = chk_pts; }
+    // keep the transaction map and the spent key images in file mapped tables, to be set before init
+    void setLowMemoryMode(bool lowMemory) { m_lowMemory = lowMemory; }
+    // CPUs of the parallel verification workers, empty to leave them unrestricted
+    void setVerificationCpus(const std::vector<unsigned>& cpus) { m_verificationCpus = cpus; }
+    // one worker per verification CPU, or per hardware thread, but no more than tasks
+    size_t getVerificationWorkersCount(size_t tasks) const;
+    std::future<void> startVerificationWorker(const std::function<void()>& work) const;
     bool getBlocks(uint32_t start_offset, uint32_t count, std::list<Block>& blocks, std::list<Transaction>& txs);
     bool getBlocks(uint32_t start_offset, uint32_t count, std::list<Block>& blocks);
     bool getTransactionsWithOutputGlobalIndexes(const std::vector<Crypto::Hash>& txs_ids, std::list<Crypto::Hash>& missed_txs, std::vector<std::pair<Transaction, std::vector<uint32_t>>>& txs);
+
+    // Serialized parts of a stored block, they point into the block store and stay valid
+    // only while the visitor runs. The base transaction comes first in the transactions,
+    // globalIndexes[i] holds the binary serialized global output indexes of transactions[i].
+    // The hash and the timestamp are taken from the indices, the block is not deserialized.
+    struct RawBlock {
+      uint32_t height;
+      Crypto::Hash hash;
+      uint64_t timestamp;
+      Common::ArrayView<uint8_t> block;
+      std::vector<Common::ArrayView<uint8_t>> transactions;
+      std::vector<Common::ArrayView<uint8_t>> globalIndexes;
+    };
+
+    // Visits the main chain blocks from startHeight on under the read lock, until count
+    // of them are visited, the chain ends or the visitor returns false. Returns the number visited.
+    uint32_t visitRawBlocks(uint32_t startHeight, uint32_t count, const std::function<bool(const RawBlock&)>& visitor);
     bool getAlternativeBlocks(std::list<Block>& blocks);
     uint32_t getAlternativeBlocksCount();
     Crypto::Hash getBlockIdByHeight(uint32_t height);
@@ -116,6 +153,7 @@ namespace CryptoNote {
     bool getRandomOutsByAmount(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_response& res);
     bool getBackwardBlocksSize(size_t from_height, std::vector<size_t>& sz, size_t count);
     bool getTransactionOutputGlobalIndexes(const Crypto::Hash& tx_id, std::vector<uint32_t>& indexs);
+    bool getTransactionsOutputGlobalIndexes(const std::vector<Crypto::Hash>& txIds, std::vector<std::vector<uint32_t>>& indexes);
     bool get_out_by_msig_gindex(uint64_t amount, uint64_t gindex, MultisignatureOutput& out);
     bool checkTransactionInputs(const Transaction& tx, uint32_t& pmax_used_block_height, Crypto::Hash& max_used_block_id, BlockInfo* tail = 0);
     uint64_t getCurrentCumulativeBlocksizeLimit();
@@ -128,10 +166,20 @@ namespace CryptoNote {
     bool getMultisigOutputReference(const MultisignatureInput& txInMultisig, std::pair<Crypto::Hash, size_t>& outputReference);
     bool getGeneratedTransactionsNumber(uint32_t height, uint64_t& generatedTransactions);
     bool getOrphanBlockIdsByHeight(uint32_t height, std::vector<Crypto::Hash>& blockHashes);
+    bool getBlockFilter(uint32_t height, std::string& filter, Crypto::Hash& header);
+    bool getBlockFilterHeader(uint32_t height, Crypto::Hash& header);
+    bool blockFiltersEnabled() const { return m_blockchainIndexesEnabled; }
+    bool getBlockSummary(uint32_t height, BlockSummary& summary);
     bool getBlockIdsByTimestamp(uint64_t timestampBegin, uint64_t timestampEnd, uint32_t blocksNumberLimit, std::vector<Crypto::Hash>& hashes, uint32_t& blocksNumberWithinTimestamps);
     bool getTransactionIdsByPaymentId(const Crypto::Hash& paymentId, std::vector<Crypto::Hash>& transactionHashes);
     bool isBlockInMainChain(const Crypto::Hash& blockId);
     bool isInCheckpointZone(const uint32_t height);
+    // Computes the long hashes of a downloaded batch on all cores so that pushing the blocks only has to compare them
+    void precomputeLongHashes(const std::vector<Block>& blocks);
+    bool getBlockLongHash(const Block& block, Crypto::Hash& longHash);
+    void getLongHashCacheStatistics(uint64_t& hits, uint64_t& misses) const;
+    // validation timings, reorganizations and index sizes in Prometheus text format
+    void writeMetrics(std::ostream& out);
 
     template<class visitor_t> bool scanOutputKeysForIndexes(const KeyInput& tx_in_to_key, visitor_t& vis, uint32_t* pmax_related_block_height = NULL);
 
@@ -140,7 +188,7 @@ namespace CryptoNote {
 
     template<class t_ids_container, class t_blocks_container, class t_missed_container>
     bool getBlocks(const t_ids_container& block_ids, t_blocks_container& blocks, t_missed_container& missed_bs) {
-      std::lock_guard<std::recursive_mutex> lk(m_blockchain_lock);
+      Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
       for (const auto& bl_id : block_ids) {
         try {
@@ -150,7 +198,7 @@ namespace CryptoNote {
           } else {
             if (!(height < m_blocks.size())) { logger(Logging::ERROR, Logging::BRIGHT_RED) << "Internal error: bl_id=" << Common::podToHex(bl_id)
             << " have index record with offset=" << height << ", bigger then m_blocks.size()=" << m_blocks.size(); return false; }
-            blocks.push_back(m_blocks[height].bl);
+            blocks.push_back(m_blocks.get(height)->bl);
           }
         } catch (const std::exception& e) {
           logger(Logging::ERROR, Logging::BRIGHT_RED) << "Exception in Core getBlocks: " << e.what();
@@ -162,14 +210,14 @@ namespace CryptoNote {
 
     template<class t_ids_container, class t_tx_container, class t_missed_container>
     void getBlockchainTransactions(const t_ids_container& txs_ids, t_tx_container& txs, t_missed_container& missed_txs) {
-      std::lock_guard<decltype(m_blockchain_lock)> bcLock(m_blockchain_lock);
+      Tools::SharedLockGuard<decltype(m_blockchain_lock)> bcLock(m_blockchain_lock);
 
       for (const auto& tx_id : txs_ids) {
-        auto it = m_transactionMap.find(tx_id);
-        if (it == m_transactionMap.end()) {
+        TransactionIndex transactionIndex;
+        if (!m_transactionMap.find(tx_id, transactionIndex)) {
           missed_txs.push_back(tx_id);
         } else {
-          txs.push_back(transactionByIndex(it->second).tx);
+          txs.push_back(loadTransaction(transactionIndex));
         }
       }
     }
@@ -205,6 +253,10 @@ namespace CryptoNote {
       }
     };
 
+    // hashes the stored blob, which works for the signature-less transactions of cached entries;
+    // the caller holds m_blockchain_lock, like the visitors of scanOutputKeysForIndexes
+    Crypto::Hash transactionHash(const TransactionIndex& index) const;
+
     void rollbackBlockchainTo(uint32_t height);
     bool have_tx_keyimg_as_spent(const Crypto::KeyImage &key_im);
 
@@ -215,8 +267,29 @@ namespace CryptoNote {
 
     void rebuildCache();
     bool storeCache();
+    // Saves a new cache snapshot once the chain has outgrown the last one by CRYPTONOTE_BLOCKSCACHE_SNAPSHOT_INTERVAL blocks
+    bool compactCache();
+    // Writes the blocks up to the last checkpoint and a cache built from them into folder
+    bool exportBootstrap(const std::string& folder);
+    // Copies a snapshot written by exportBootstrap into config_folder if it has no blocks yet,
+    // init then loads the cache instead of replaying the blocks. Only the top block is checked
+    // against the checkpoints, the snapshot is trusted to hold valid blocks
+    bool importBootstrap(const std::string& folder, const std::string& config_folder);
+    // Writes the main chain as block records, see BlockRecord.h
+    bool exportBlocks(const std::string& fileName);
+    // Appends the blocks of a block record file that continue the chain. Blocks in the checkpoint
+    // zone are only checked against the chain and the checkpoints and indexed in bulk afterwards.
+    bool importBlocks(const std::string& fileName);
 
   private:
+    void indexBlocks(uint32_t startHeight);
+    void addBlockchainIndices(uint32_t startHeight);
+    void loadPaymentIdIndex();
+    void loadTimestampIndex();
+    void loadBlockColumns();
+    bool importLegacyBlocks(const std::string& config_folder);
+    // Loads the cache of a bootstrap snapshot in folder and checks it against its block store
+    bool checkBootstrapIndexes(const std::string& folder, uint32_t height, const Crypto::Hash& blockHash);
 
     struct MultisignatureOutputUsage {
       TransactionIndex transactionIndex;
@@ -230,6 +303,22 @@ namespace CryptoNote {
       }
     };
 
+    // what decoy selection needs of a key output, so that getRandomOutsByAmount
+    // doesn't have to load the transaction holding it
+    struct OutputKeyInfo {
+      Crypto::PublicKey key;
+      uint64_t unlockTime;
+      uint32_t height;
+
+      void serialize(ISerializer& s) {
+        s(key, "key");
+        s(unlockTime, "unlock_time");
+        s(height, "height");
+      }
+    };
+
+    // Entries read through m_blocks have tx without signatures, they are needed only to hand a
+    // transaction out and loadTransaction() reads them from the store. Hash with transactionHash().
     struct TransactionEntry {
       Transaction tx;
       std::vector<uint32_t> m_global_output_indexes;
@@ -256,28 +345,86 @@ namespace CryptoNote {
         s(already_generated_coins, "already_generated_coins");
         s(transactions, "transactions");
       }
+
+      // signatures are most of the memory taken by an input
+      void dropSignatures() {
+        for (TransactionEntry& transaction : transactions) {
+          std::vector<std::vector<Crypto::Signature>>().swap(transaction.tx.signatures);
+        }
+      }
+    };
+
+    // ring signature collected while checking a block, verified together with the rest of the block
+    struct RingSignatureCheck {
+      Crypto::Hash prefixHash;
+      Crypto::KeyImage keyImage;
+      std::vector<Crypto::PublicKey> outputKeys;
+      std::vector<Crypto::Signature> signatures;
     };
 
-    typedef parallel_flat_hash_map<Crypto::KeyImage, uint32_t> key_images_container;
+    // what pushBlock learns about a block transaction without looking at the chain,
+    // computed for all transactions of the block in parallel
+    struct TransactionPrecheck {
+      Crypto::Hash hash;
+      Crypto::Hash prefixHash;
+      size_t blobSize;
+      uint64_t fee;
+      bool valid;
+    };
+
+    // a main chain block taken off by a reorganization: the entry keeps the transactions and
+    // their global output indexes, so the block can be put back without validating it again
+    struct DisconnectedBlock {
+      BlockEntry entry;
+      Crypto::Hash hash;
+      BlockSummary summary;
+      bool hasSummary;
+    };
+
+    // std::mutex turns on the per-submap locks, so that spent checks don't need m_blockchain_lock;
+    // the other template arguments are the defaults, which keeps spentkeys.dat compatible
+    typedef parallel_flat_hash_map<Crypto::KeyImage, uint32_t,
+      phmap::container_internal::hash_default_hash<Crypto::KeyImage>,
+      phmap::container_internal::hash_default_eq<Crypto::KeyImage>,
+      phmap::container_internal::Allocator<phmap::container_internal::Pair<const Crypto::KeyImage, uint32_t>>,
+      4, std::mutex> key_images_container;
     typedef parallel_flat_hash_map<Crypto::Hash, BlockEntry> blocks_ext_by_hash;
     typedef parallel_flat_hash_map<uint64_t, std::vector<std::pair<TransactionIndex, uint16_t>>> outputs_container; //Crypto::Hash - tx hash, size_t - index of out in transaction
     typedef parallel_flat_hash_map<uint64_t, std::vector<MultisignatureOutputUsage>> MultisignatureOutputsContainer;
+    typedef parallel_flat_hash_map<uint64_t, std::vector<OutputKeyInfo>> output_keys_container; // same order as outputs_container
 
     const Currency& m_currency;
     tx_memory_pool& m_tx_pool;
-    std::recursive_mutex m_blockchain_lock; // TODO: add here reader/writer lock
+    // shared for lookups, exclusive for anything changing the main or alternative chains
+    mutable Tools::RecursiveSharedMutex m_blockchain_lock;
     Crypto::cn_context m_cn_context;
+    // filled when a block passes the PoW check and by precomputeLongHashes()
+    LongHashCache m_longHashCache;
+    // decompressed ring members of recent signature checks
+    RingMemberCache m_ringMemberCache;
+    // scratch state of pushBlock, kept between blocks so that validation reuses its capacity;
+    // only touched under the exclusive m_blockchain_lock
+    std::vector<uint64_t> m_timestampWindow;
+    std::vector<TransactionPrecheck> m_transactionPrechecks;
+    // stages of the main chain blocks validation and the depth of the reorganizations
+    Common::MetricsHistogram m_proofOfWorkTime;
+    Common::MetricsHistogram m_inputsCheckTime;
+    Common::MetricsHistogram m_ringSignaturesTime;
+    Common::MetricsHistogram m_blockStoreTime;
+    Common::MetricsHistogram m_blockValidationTime;
+    Common::MetricsHistogram m_reorganizationDepth;
     Tools::ObserverManager<IBlockchainStorageObserver> m_observerManager;
 
-    key_images_container m_spent_key_images;
+    BlockchainKeyValueIndex<Crypto::KeyImage, uint32_t, key_images_container> m_spent_key_images;
     size_t m_current_block_cumul_sz_limit;
     blocks_ext_by_hash m_alternative_chains; // Crypto::Hash -> block_extended_info
     outputs_container m_outputs;
+    output_keys_container m_outputKeys;
 
     std::string m_config_folder;
     Checkpoints m_checkpoints;
 
-    typedef SwappedVector<BlockEntry> Blocks;
+    typedef BlockStore<BlockEntry> Blocks;
     typedef parallel_flat_hash_map<Crypto::Hash, uint32_t> BlockMap;
     typedef parallel_flat_hash_map<Crypto::Hash, TransactionIndex> TransactionMap;
     typedef BasicUpgradeDetector<Blocks> UpgradeDetector;
@@ -286,8 +433,15 @@ namespace CryptoNote {
     friend class BlockchainIndicesSerializer;
 
     Blocks m_blocks;
+    BlockHeaderColumns m_blockColumns; // mirrors the header values of m_blocks
+    // getDifficultyForNextBlock() of the m_blockColumns revision, written under the shared lock too
+    std::mutex m_nextDifficultyLock;
+    uint64_t m_nextDifficultyRevision;
+    uint8_t m_nextDifficultyVersion;
+    difficulty_type m_nextDifficulty;
+    Common::SlidingMedian<size_t> m_lastBlocksSizes; // cumulative sizes of the last rewardBlocksWindow() blocks
     CryptoNote::BlockIndex m_blockIndex;
-    TransactionMap m_transactionMap;
+    BlockchainKeyValueIndex<Crypto::Hash, TransactionIndex, TransactionMap> m_transactionMap;
     MultisignatureOutputsContainer m_multisignatureOutputs;
     UpgradeDetector m_upgradeDetectorV2;
     UpgradeDetector m_upgradeDetectorV3;
@@ -298,7 +452,13 @@ namespace CryptoNote {
     TimestampBlocksIndex m_timestampIndex;
     GeneratedTransactionsIndex m_generatedTransactionsIndex;
     OrphanBlocksIndex m_orphanBlocksIndex;
+    BlockFilterIndex m_blockFilterIndex;
+    BlockSummaryIndex m_blockSummaryIndex;
     bool m_blockchainIndexesEnabled;
+    bool m_lowMemory;
+    std::vector<unsigned> m_verificationCpus;
+    // height the saved blockchain cache was taken at, later blocks are replayed from m_blocks on load
+    std::atomic<uint32_t> m_cacheSnapshotHeight;
 
     IntrusiveLinkedList<MessageQueue<BlockchainMessage>> m_messageQueueList;
 
@@ -309,12 +469,15 @@ namespace CryptoNote {
     difficulty_type get_next_difficulty_for_alternative_chain(const std::list<blocks_ext_by_hash::iterator>& alt_chain, BlockEntry& bei);
     bool prevalidate_miner_transaction(const Block& b, uint32_t height);
     bool validate_miner_transaction(const Block& b, uint32_t height, size_t cumulativeBlockSize, uint64_t alreadyGeneratedCoins, uint64_t fee, uint64_t& reward, int64_t& emissionChange);
-    bool rollback_blockchain_switching(std::list<Block>& original_chain, size_t rollback_height);
+    bool rollback_blockchain_switching(std::list<DisconnectedBlock>& original_chain, size_t rollback_height);
+    void disconnectBlock(DisconnectedBlock& block);
+    bool reconnectBlock(DisconnectedBlock& block);
     bool get_last_n_blocks_sizes(std::vector<size_t>& sz, size_t count);
-    bool add_out_to_get_random_outs(std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount& result_outs, uint64_t amount, size_t i);
-    size_t find_end_of_allowed_index(const std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs);
+    bool add_out_to_get_random_outs(const std::vector<OutputKeyInfo>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount& result_outs, uint64_t amount, size_t i);
+    size_t find_end_of_allowed_index(const std::vector<OutputKeyInfo>& amount_outs);
+    void buildOutputKeys();
     bool check_block_timestamp_main(const Block& b);
-    bool check_block_timestamp(std::vector<uint64_t> timestamps, const Block& b);
+    bool check_block_timestamp(std::vector<uint64_t>& timestamps, const Block& b); // reorders timestamps
     uint64_t get_adjusted_time();
     bool complete_timestamps_vector(uint8_t blockMajorVersion, uint64_t start_height, std::vector<uint64_t>& timestamps);
     bool checkBlockVersion(const Block& b, const Crypto::Hash& blockHash);
@@ -323,13 +486,21 @@ namespace CryptoNote {
     std::vector<Crypto::Hash> doBuildSparseChain(const Crypto::Hash& startBlockId) const;
     bool getBlockCumulativeSize(const Block& block, size_t& cumulativeSize);
     bool update_next_cumulative_size_limit();
-    bool check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::Signature>& sig, uint32_t* pmax_related_block_height = NULL);
-    bool checkTransactionInputs(const Transaction& tx, const Crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height = NULL);
+    bool check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::Signature>& sig, uint32_t* pmax_related_block_height = NULL, std::vector<RingSignatureCheck>* deferred_signatures = NULL);
+    bool checkTransactionInputs(const Transaction& tx, const Crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height = NULL, std::vector<RingSignatureCheck>* deferred_signatures = NULL);
+    bool checkTransactionInputsInChain(const Transaction& tx, const Crypto::Hash& transactionHash, const Crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height, std::vector<RingSignatureCheck>* deferred_signatures);
+    void precheckTransactions(const std::vector<Transaction>& transactions, bool checkKeyImages, std::vector<TransactionPrecheck>& prechecks);
+    bool checkRingSignature(const Crypto::Hash& prefixHash, const Crypto::KeyImage& keyImage, const std::vector<Crypto::PublicKey>& outputKeys, const Crypto::Signature* signatures);
+    bool checkRingSignatures(const std::vector<RingSignatureCheck>& checks);
+    bool checkProofOfWork(const Block& block, const Crypto::Hash& blockHash, difficulty_type difficulty, Crypto::Hash& proofOfWork);
     bool checkTransactionInputs(const Transaction& tx, uint32_t* pmax_used_block_height = NULL);
-    const TransactionEntry& transactionByIndex(TransactionIndex index);
+    std::shared_ptr<const TransactionEntry> transactionByIndex(TransactionIndex index);
+    Transaction loadTransaction(TransactionIndex index) const;
     bool pushBlock(const Block& blockData, const Crypto::Hash& id, block_verification_context& bvc);
     bool pushBlock(const Block& blockData, const std::vector<Transaction>& transactions, const Crypto::Hash& blockHash, block_verification_context& bvc);
     bool pushBlock(BlockEntry& block, const Crypto::Hash& blockHash);
+    void addBlockFilter(const BlockEntry& block, const Crypto::Hash& blockHash);
+    void addBlockSummary(const BlockEntry& block, const Crypto::Hash& proofOfWork);
     void popBlock();
     bool pushTransaction(BlockEntry& block, const Crypto::Hash& transactionHash, TransactionIndex transactionIndex);
     void popTransaction(const Transaction& transaction, const Crypto::Hash& transactionHash);
@@ -340,7 +511,9 @@ namespace CryptoNote {
     bool checkUpgradeHeight(const UpgradeDetector& upgradeDetector);
 
     bool storeBlockchainIndices();
-    bool loadBlockchainIndices();
+    // reading the file needs no lock, the indices are rebuilt under the lock when it is missing or outdated
+    bool readBlockchainIndices(const Crypto::Hash& lastBlockHash);
+    void rebuildBlockchainIndices();
 
     bool loadTransactions(const Block& block, std::vector<Transaction>& transactions);
     void saveTransactions(const std::vector<Transaction>& transactions);
@@ -348,6 +521,7 @@ namespace CryptoNote {
     void sendMessage(const BlockchainMessage& message);
 
     friend class LockedBlockchainStorage;
+    friend class ReadOnlyLockedBlockchainStorage;
   };
 
   class LockedBlockchainStorage: boost::noncopyable {
@@ -363,19 +537,40 @@ namespace CryptoNote {
   private:
 
     Blockchain& m_bc;
-    std::lock_guard<std::recursive_mutex> m_lock;
+    std::lock_guard<Tools::RecursiveSharedMutex> m_lock;
+  };
+
+  // Holds the blockchain lock in shared mode: concurrent readers don't block each other,
+  // but the chain must not be modified through it.
+  class ReadOnlyLockedBlockchainStorage: boost::noncopyable {
+  public:
+
+    ReadOnlyLockedBlockchainStorage(Blockchain& bc)
+      : m_bc(bc), m_lock(bc.m_blockchain_lock) {}
+
+    Blockchain* operator -> () {
+      return &m_bc;
+    }
+
+  private:
+
+    Blockchain& m_bc;
+    Tools::SharedLockGuard<Tools::RecursiveSharedMutex> m_lock;
   };
 
   template<class visitor_t> bool Blockchain::scanOutputKeysForIndexes(const KeyInput& tx_in_to_key, visitor_t& vis, uint32_t* pmax_related_block_height) {
-    std::lock_guard<std::recursive_mutex> lk(m_blockchain_lock);
+    Tools::SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
     auto it = m_outputs.find(tx_in_to_key.amount);
     if (it == m_outputs.end() || !tx_in_to_key.outputIndexes.size())
       return false;
 
-    std::vector<uint32_t> absolute_offsets = relative_output_offsets_to_absolute(tx_in_to_key.outputIndexes);
+    // offsets are made absolute on the fly, without a copy of the index vector per input
     std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs_vec = it->second;
     size_t count = 0;
-    for (uint64_t i : absolute_offsets) {
+    uint32_t absolute_offset = 0;
+    for (uint32_t relative_offset : tx_in_to_key.outputIndexes) {
+      absolute_offset += relative_offset;
+      uint64_t i = absolute_offset;
       if(i >= amount_outs_vec.size() ) {
         logger(Logging::INFO) << "Wrong index in transaction inputs: " << i << ", expected maximum " << amount_outs_vec.size() - 1;
         return false;
@@ -384,22 +579,22 @@ namespace CryptoNote {
       //auto tx_it = m_transactionMap.find(amount_outs_vec[i].first);
       //if (!(tx_it != m_transactionMap.end())) { logger(ERROR, BRIGHT_RED) << "Wrong transaction id in output indexes: " << Common::podToHex(amount_outs_vec[i].first); return false; }
 
-      const TransactionEntry& tx = transactionByIndex(amount_outs_vec[i].first);
+      std::shared_ptr<const TransactionEntry> tx = transactionByIndex(amount_outs_vec[i].first);
 
-      if (!(amount_outs_vec[i].second < tx.tx.outputs.size())) {
+      if (!(amount_outs_vec[i].second < tx->tx.outputs.size())) {
         logger(Logging::ERROR, Logging::BRIGHT_RED)
             << "Wrong index in transaction outputs: "
             << amount_outs_vec[i].second << ", expected less then "
-            << tx.tx.outputs.size();
+            << tx->tx.outputs.size();
         return false;
       }
 
-      if (!vis.handle_output(tx.tx, tx.tx.outputs[amount_outs_vec[i].second], amount_outs_vec[i].second)) {
+      if (!vis.handle_output(tx->tx, tx->tx.outputs[amount_outs_vec[i].second], amount_outs_vec[i].first, amount_outs_vec[i].second)) {
         logger(Logging::INFO) << "Failed to handle_output for output no = " << count << ", with absolute offset " << i;
         return false;
       }
 
-      if(count++ == absolute_offsets.size()-1 && pmax_related_block_height) {
+      if(count++ == tx_in_to_key.outputIndexes.size()-1 && pmax_related_block_height) {
         if (*pmax_related_block_height < amount_outs_vec[i].first.block) {
           *pmax_related_block_height = amount_outs_vec[i].first.block;
         }
@@ -17,58 +17,72 @@
 
 #include "BlockchainIndices.h"
 
+#include <algorithm>
+
 #include "Common/StringTools.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "BlockchainExplorer/BlockchainExplorerDataBuilder.h"
 #include "CryptoNoteBasicImpl.h"
+#include "BlockFilter.h"
 
 namespace CryptoNote {
 
-namespace {
-  const size_t DEFAULT_BUCKET_COUNT = 5;
+PaymentIdIndex::PaymentIdIndex(bool _enabled) : enabled(_enabled) {
 }
 
-PaymentIdIndex::PaymentIdIndex(bool _enabled) : enabled(_enabled), index(DEFAULT_BUCKET_COUNT, paymentIdHash) {
+bool PaymentIdIndex::add(const Transaction& transaction) {
+  return enabled && add(transaction, getObjectHash(transaction));
 }
 
-bool PaymentIdIndex::add(const Transaction& transaction) {
+bool PaymentIdIndex::add(const Transaction& transaction, const Crypto::Hash& transactionHash) {
   if (!enabled) {
     return false;
   }
 
   Crypto::Hash paymentId;
-  Crypto::Hash transactionHash = getObjectHash(transaction);
   if (!BlockchainExplorerDataBuilder::getPaymentId(transaction, paymentId)) {
     return false;
   }
 
-  //index.emplace(paymentId, transactionHash);
-  index.insert(std::make_pair(paymentId, transactionHash));
+  insert(paymentId, transactionHash);
+  if (file.isOpened()) {
+    file.push_back(Entry{ paymentId, transactionHash });
+  }
 
   return true;
 }
 
 bool PaymentIdIndex::remove(const Transaction& transaction) {
+  return enabled && remove(transaction, getObjectHash(transaction));
+}
+
+bool PaymentIdIndex::remove(const Transaction& transaction, const Crypto::Hash& transactionHash) {
   if (!enabled) {
     return false;
   }
 
   Crypto::Hash paymentId;
-  Crypto::Hash transactionHash = getObjectHash(transaction);
   if (!BlockchainExplorerDataBuilder::getPaymentId(transaction, paymentId)) {
     return false;
   }
 
-  auto range = index.equal_range(paymentId);
-  for (auto iter = range.first; iter != range.second; ++iter){
-    if (iter->second == transactionHash) {
-      index.erase(iter);
-      return true;
+  if (!erase(paymentId, transactionHash)) {
+    return false;
+  }
+
+  // blocks are popped from the top, so their entries are the last ones
+  if (file.isOpened()) {
+    for (uint64_t i = file.size(); i > 0; --i) {
+      const Entry& entry = file[i - 1];
+      if (entry.paymentId == paymentId && entry.transactionHash == transactionHash) {
+        file.erase(file.begin() + (i - 1));
+        break;
+      }
     }
   }
 
-  return false;
+  return true;
 }
 
 bool PaymentIdIndex::find(const Crypto::Hash& paymentId, std::vector<Crypto::Hash>& transactionHashes) {
@@ -76,40 +90,173 @@ bool PaymentIdIndex::find(const Crypto::Hash& paymentId, std::vector<Crypto::Has
     throw std::runtime_error("Payment id index disabled.");
   }
 
-  bool found = false;
-  auto range = index.equal_range(paymentId);
-  for (auto iter = range.first; iter != range.second; ++iter){
-    found = true;
-    transactionHashes.emplace_back(iter->second);
+  Shard& s = shard(paymentId);
+  std::lock_guard<std::mutex> lock(s.lock);
+  auto it = s.index.find(paymentId);
+  if (it == s.index.end()) {
+    return false;
   }
-  return found;
+
+  transactionHashes.insert(transactionHashes.end(), it->second.begin(), it->second.end());
+  return true;
 }
 
 std::vector<Crypto::Hash> PaymentIdIndex::find(const Crypto::Hash& paymentId) {
-	if (!enabled) {
-		throw std::runtime_error("Payment id index disabled.");
-	}
-	std::vector<Crypto::Hash> transactionHashes;
-	auto range = index.equal_range(paymentId);
-	for (auto iter = range.first; iter != range.second; ++iter) {
-		transactionHashes.emplace_back(iter->second);
-	}
-	return transactionHashes;
+  std::vector<Crypto::Hash> transactionHashes;
+  find(paymentId, transactionHashes);
+  return transactionHashes;
 }
 
 void PaymentIdIndex::clear() {
   if (enabled) {
-    index.clear();
+    for (Shard& s : shards) {
+      std::lock_guard<std::mutex> lock(s.lock);
+      s.index.clear();
+    }
+
+    if (file.isOpened()) {
+      file.clear();
+      setTop(0, NULL_HASH);
+    }
   }
 }
 
+void PaymentIdIndex::open(const std::string& path) {
+  file.open(path, Common::FileMappedVectorOpenMode::OPEN_OR_CREATE, sizeof(FileHeader));
+  file.setAutoFlush(false);
+  if (file.size() > fileHeader().entryCount) {
+    file.erase(file.begin() + fileHeader().entryCount, file.end());
+  } else if (file.size() < fileHeader().entryCount) {
+    file.clear();
+    setTop(0, NULL_HASH);
+  }
+}
 
-void PaymentIdIndex::serialize(ISerializer& s) {
-  if (!enabled) {
-    throw std::runtime_error("Payment id index disabled.");
+void PaymentIdIndex::close() {
+  if (file.isOpened()) {
+    file.flush();
+    file.close();
   }
+}
 
-  s(index, "index");
+uint32_t PaymentIdIndex::blockCount() const {
+  return fileHeader().blockCount;
+}
+
+Crypto::Hash PaymentIdIndex::topBlockHash() const {
+  return fileHeader().topBlockHash;
+}
+
+void PaymentIdIndex::setTop(uint32_t blockCount, const Crypto::Hash& topBlockHash) {
+  if (file.isOpened()) {
+    FileHeader& header = fileHeader();
+    header.entryCount = file.size();
+    header.blockCount = blockCount;
+    header.topBlockHash = topBlockHash;
+  }
+}
+
+void PaymentIdIndex::load() {
+  for (const Entry& entry : file) {
+    insert(entry.paymentId, entry.transactionHash);
+  }
+}
+
+PaymentIdIndex::Shard& PaymentIdIndex::shard(const Crypto::Hash& paymentId) {
+  return shards[paymentIdHash(paymentId) % SHARD_COUNT];
+}
+
+void PaymentIdIndex::insert(const Crypto::Hash& paymentId, const Crypto::Hash& transactionHash) {
+  Shard& s = shard(paymentId);
+  std::lock_guard<std::mutex> lock(s.lock);
+  s.index[paymentId].push_back(transactionHash);
+}
+
+bool PaymentIdIndex::erase(const Crypto::Hash& paymentId, const Crypto::Hash& transactionHash) {
+  Shard& s = shard(paymentId);
+  std::lock_guard<std::mutex> lock(s.lock);
+  auto it = s.index.find(paymentId);
+  if (it == s.index.end()) {
+    return false;
+  }
+
+  std::vector<Crypto::Hash>& hashes = it->second;
+  auto hashIt = std::find(hashes.begin(), hashes.end(), transactionHash);
+  if (hashIt == hashes.end()) {
+    return false;
+  }
+
+  hashes.erase(hashIt);
+  if (hashes.empty()) {
+    s.index.erase(it);
+  }
+
+  return true;
+}
+
+PaymentIdIndex::FileHeader& PaymentIdIndex::fileHeader() {
+  return *reinterpret_cast<FileHeader*>(file.prefix());
+}
+
+const PaymentIdIndex::FileHeader& PaymentIdIndex::fileHeader() const {
+  return *reinterpret_cast<const FileHeader*>(file.prefix());
+}
+
+void TimestampHashIndex::add(uint64_t timestamp, const Crypto::Hash& hash) {
+  Entry entry(timestamp, hash);
+  auto it = std::upper_bound(buffer.begin(), buffer.end(), entry, [](const Entry& a, const Entry& b) { return a.first < b.first; });
+  buffer.insert(it, entry);
+  if (buffer.size() >= BUFFER_SIZE) {
+    merge();
+  }
+}
+
+bool TimestampHashIndex::remove(uint64_t timestamp, const Crypto::Hash& hash) {
+  for (std::vector<Entry>* entries : { &buffer, &sorted }) {
+    auto range = std::equal_range(entries->begin(), entries->end(), Entry(timestamp, hash), [](const Entry& a, const Entry& b) { return a.first < b.first; });
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == hash) {
+        entries->erase(it);
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+uint64_t TimestampHashIndex::find(uint64_t timestampBegin, uint64_t timestampEnd, uint64_t limit, std::vector<Crypto::Hash>& hashes) const {
+  auto less = [](const Entry& entry, uint64_t timestamp) { return entry.first < timestamp; };
+  auto greater = [](uint64_t timestamp, const Entry& entry) { return timestamp < entry.first; };
+  auto sortedIt = std::lower_bound(sorted.begin(), sorted.end(), timestampBegin, less);
+  auto sortedEnd = std::upper_bound(sortedIt, sorted.end(), timestampEnd, greater);
+  auto bufferIt = std::lower_bound(buffer.begin(), buffer.end(), timestampBegin, less);
+  auto bufferEnd = std::upper_bound(bufferIt, buffer.end(), timestampEnd, greater);
+
+  uint64_t count = static_cast<uint64_t>(std::distance(sortedIt, sortedEnd) + std::distance(bufferIt, bufferEnd));
+  for (uint64_t n = 0; n < limit && (sortedIt != sortedEnd || bufferIt != bufferEnd); ++n) {
+    if (bufferIt == bufferEnd || (sortedIt != sortedEnd && sortedIt->first <= bufferIt->first)) {
+      hashes.emplace_back((sortedIt++)->second);
+    } else {
+      hashes.emplace_back((bufferIt++)->second);
+    }
+  }
+
+  return count;
+}
+
+void TimestampHashIndex::clear() {
+  sorted.clear();
+  buffer.clear();
+}
+
+void TimestampHashIndex::merge() {
+  auto tail = std::upper_bound(sorted.begin(), sorted.end(), buffer.front(), [](const Entry& a, const Entry& b) { return a.first < b.first; });
+  size_t tailIndex = static_cast<size_t>(std::distance(sorted.begin(), tail));
+  size_t middleIndex = sorted.size();
+  sorted.insert(sorted.end(), buffer.begin(), buffer.end());
+  std::inplace_merge(sorted.begin() + tailIndex, sorted.begin() + middleIndex, sorted.end(), [](const Entry& a, const Entry& b) { return a.first < b.first; });
+  buffer.clear();
 }
 
 TimestampBlocksIndex::TimestampBlocksIndex(bool _enabled) : enabled(_enabled) {
@@ -120,7 +267,7 @@ bool TimestampBlocksIndex::add(uint64_t timestamp, const Crypto::Hash& hash) {
     return false;
   }
 
-  index.emplace(timestamp, hash);
+  index.add(timestamp, hash);
   return true;
 }
 
@@ -129,15 +276,7 @@ bool TimestampBlocksIndex::remove(uint64_t timestamp, const Crypto::Hash& hash)
     return false;
   }
 
-  auto range = index.equal_range(timestamp);
-  for (auto iter = range.first; iter != range.second; ++iter) {
-    if (iter->second == hash) {
-      index.erase(iter);
-      return true;
-    }
-  }
-
-  return false;
+  return index.remove(timestamp, hash);
 }
 
 bool TimestampBlocksIndex::find(uint64_t timestampBegin, uint64_t timestampEnd, uint32_t hashesNumberLimit, std::vector<Crypto::Hash>& hashes, uint32_t& hashesNumberWithinTimestamps) {
@@ -145,21 +284,13 @@ bool TimestampBlocksIndex::find(uint64_t timestampBegin, uint64_t timestampEnd,
     throw std::runtime_error("Timestamp block index disabled.");
   }
 
-  uint32_t hashesNumber = 0;
   if (timestampBegin > timestampEnd) {
-    //std::swap(timestampBegin, timestampEnd);
     return false;
   }
-  auto begin = index.lower_bound(timestampBegin);
-  auto end = index.upper_bound(timestampEnd);
-
-  hashesNumberWithinTimestamps = static_cast<uint32_t>(std::distance(begin, end));
 
-  for (auto iter = begin; iter != end && hashesNumber < hashesNumberLimit; ++iter){
-    ++hashesNumber;
-    hashes.emplace_back(iter->second);
-  }
-  return hashesNumber > 0;
+  size_t hashesNumber = hashes.size();
+  hashesNumberWithinTimestamps = static_cast<uint32_t>(index.find(timestampBegin, timestampEnd, hashesNumberLimit, hashes));
+  return hashes.size() > hashesNumber;
 }
 
 void TimestampBlocksIndex::clear() {
@@ -168,14 +299,6 @@ void TimestampBlocksIndex::clear() {
   }
 }
 
-void TimestampBlocksIndex::serialize(ISerializer& s) {
-  if (!enabled) {
-    throw std::runtime_error("Timestamp block index disabled.");
-  }
-
-  s(index, "index");
-}
-
 TimestampTransactionsIndex::TimestampTransactionsIndex(bool _enabled) : enabled(_enabled) {
 }
 
@@ -184,7 +307,7 @@ bool TimestampTransactionsIndex::add(uint64_t timestamp, const Crypto::Hash& has
     return false;
   }
 
-  index.emplace(timestamp, hash);
+  index.add(timestamp, hash);
   return true;
 }
 
@@ -193,37 +316,21 @@ bool TimestampTransactionsIndex::remove(uint64_t timestamp, const Crypto::Hash&
     return false;
   }
 
-  auto range = index.equal_range(timestamp);
-  for (auto iter = range.first; iter != range.second; ++iter) {
-    if (iter->second == hash) {
-      index.erase(iter);
-      return true;
-    }
-  }
-
-  return false;
+  return index.remove(timestamp, hash);
 }
 
 bool TimestampTransactionsIndex::find(uint64_t timestampBegin, uint64_t timestampEnd, uint64_t hashesNumberLimit, std::vector<Crypto::Hash>& hashes, uint64_t& hashesNumberWithinTimestamps) {
   if (!enabled) {
     throw std::runtime_error("Timestamp transactions index disabled.");
   }
-  
-  uint32_t hashesNumber = 0;
+
   if (timestampBegin > timestampEnd) {
-    //std::swap(timestampBegin, timestampEnd);
     return false;
   }
-  auto begin = index.lower_bound(timestampBegin);
-  auto end = index.upper_bound(timestampEnd);
 
-  hashesNumberWithinTimestamps = static_cast<uint32_t>(std::distance(begin, end));
-
-  for (auto iter = begin; iter != end && hashesNumber < hashesNumberLimit; ++iter) {
-    ++hashesNumber;
-    hashes.emplace_back(iter->second);
-  }
-  return hashesNumber > 0;
+  size_t hashesNumber = hashes.size();
+  hashesNumberWithinTimestamps = index.find(timestampBegin, timestampEnd, hashesNumberLimit, hashes);
+  return hashes.size() > hashesNumber;
 }
 
 void TimestampTransactionsIndex::clear() {
@@ -232,14 +339,6 @@ void TimestampTransactionsIndex::clear() {
   }
 }
 
-void TimestampTransactionsIndex::serialize(ISerializer& s) {
-  if (!enabled) {
-    throw std::runtime_error("Timestamp transactions index disabled.");
-  }
-
-  s(index, "index");
-}
-
 GeneratedTransactionsIndex::GeneratedTransactionsIndex(bool _enabled) : lastGeneratedTxNumber(0), enabled(_enabled) {
 }
 
@@ -318,6 +417,135 @@ void GeneratedTransactionsIndex::serialize(ISerializer& s) {
   s(lastGeneratedTxNumber, "lastGeneratedTxNumber");
 }
 
+BlockFilterIndex::BlockFilterIndex(bool _enabled) : enabled(_enabled) {
+}
+
+bool BlockFilterIndex::add(const Crypto::Hash& blockHash, const std::vector<Crypto::Hash>& items) {
+  if (!enabled) {
+    return false;
+  }
+
+  filters.push_back(BlockFilter::build(blockHash, items));
+  headers.push_back(BlockFilter::header(filters.back(), headers.empty() ? NULL_HASH : headers.back()));
+  return true;
+}
+
+bool BlockFilterIndex::removeLast() {
+  if (!enabled || filters.empty()) {
+    return false;
+  }
+
+  filters.pop_back();
+  headers.pop_back();
+  return true;
+}
+
+bool BlockFilterIndex::find(uint32_t height, std::string& filter, Crypto::Hash& header) const {
+  if (!enabled) {
+    throw std::runtime_error("Block filter index disabled.");
+  }
+
+  if (height >= filters.size()) {
+    return false;
+  }
+
+  filter = filters[height];
+  header = headers[height];
+  return true;
+}
+
+bool BlockFilterIndex::findHeader(uint32_t height, Crypto::Hash& header) const {
+  if (!enabled) {
+    throw std::runtime_error("Block filter index disabled.");
+  }
+
+  if (height >= headers.size()) {
+    return false;
+  }
+
+  header = headers[height];
+  return true;
+}
+
+uint32_t BlockFilterIndex::size() const {
+  return static_cast<uint32_t>(filters.size());
+}
+
+void BlockFilterIndex::clear() {
+  if (enabled) {
+    filters.clear();
+    headers.clear();
+  }
+}
+
+void BlockFilterIndex::serialize(ISerializer& s) {
+  if (!enabled) {
+    throw std::runtime_error("Block filter index disabled.");
+  }
+
+  s(filters, "filters");
+  s(headers, "headers");
+}
+
+void BlockSummary::serialize(ISerializer& s) {
+  s(reward, "reward");
+  s(totalFee, "totalFee");
+  s(baseReward, "baseReward");
+  // the binary serializer has no doubles, keep the bits as they are
+  s.binary(&penalty, sizeof(penalty), "penalty");
+  s(sizeMedian, "sizeMedian");
+  s(blockSize, "blockSize");
+  s(proofOfWork, "proofOfWork");
+}
+
+BlockSummaryIndex::BlockSummaryIndex(bool _enabled) : enabled(_enabled) {
+}
+
+bool BlockSummaryIndex::add(const BlockSummary& summary) {
+  if (!enabled) {
+    return false;
+  }
+
+  summaries.push_back(summary);
+  return true;
+}
+
+bool BlockSummaryIndex::removeLast() {
+  if (!enabled || summaries.empty()) {
+    return false;
+  }
+
+  summaries.pop_back();
+  return true;
+}
+
+bool BlockSummaryIndex::find(uint32_t height, BlockSummary& summary) const {
+  if (!enabled || height >= summaries.size()) {
+    return false;
+  }
+
+  summary = summaries[height];
+  return true;
+}
+
+uint32_t BlockSummaryIndex::size() const {
+  return static_cast<uint32_t>(summaries.size());
+}
+
+void BlockSummaryIndex::clear() {
+  if (enabled) {
+    summaries.clear();
+  }
+}
+
+void BlockSummaryIndex::serialize(ISerializer& s) {
+  if (!enabled) {
+    throw std::runtime_error("Block summary index disabled.");
+  }
+
+  s(summaries, "summaries");
+}
+
 OrphanBlocksIndex::OrphanBlocksIndex(bool _enabled) : enabled(_enabled) {
 }
 
@@ -18,11 +18,14 @@
 #pragma once
 
 #include <boost/functional/hash.hpp>
+#include <array>
 #include <map>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <parallel_hashmap/phmap.h>
 
+#include "Common/FileMappedVector.h"
 #include "crypto/hash.h"
 #include "CryptoNoteBasic.h"
 
@@ -36,27 +39,87 @@ inline size_t paymentIdHash(const Crypto::Hash& paymentId) {
   return boost::hash_range(std::begin(paymentId.data), std::end(paymentId.data));
 }
 
+// Transaction hashes by payment id in shards of flat hash maps with a lock each, lookups
+// don't need the lock of the blockchain or the pool and only wait for an update of their
+// shard. The blockchain index also keeps its entries in a file that is appended and
+// truncated along with the blocks, so it is never written out as a whole.
 class PaymentIdIndex {
 public:
   PaymentIdIndex(bool enabled);
 
   bool add(const Transaction& transaction);
   bool remove(const Transaction& transaction);
+  // for transactions that can't be hashed themselves, like the stored ones without signatures
+  bool add(const Transaction& transaction, const Crypto::Hash& transactionHash);
+  bool remove(const Transaction& transaction, const Crypto::Hash& transactionHash);
   bool find(const Crypto::Hash& paymentId, std::vector<Crypto::Hash>& transactionHashes);
   std::vector<Crypto::Hash> find(const Crypto::Hash& paymentId);
   void clear();
 
-  void serialize(ISerializer& s);
+  // entries added after the last setTop() are dropped, they belong to a block being pushed
+  void open(const std::string& path);
+  void close();
+  // the file covers blockCount() main chain blocks, the last of them topBlockHash()
+  uint32_t blockCount() const;
+  Crypto::Hash topBlockHash() const;
+  void setTop(uint32_t blockCount, const Crypto::Hash& topBlockHash);
+  // fills the shards from the file
+  void load();
 
-  template<class Archive> 
-  void serialize(Archive& archive, unsigned int version) {
-    archive & index;
-  }
 private:
-  std::unordered_multimap<Crypto::Hash, Crypto::Hash, std::function<decltype(paymentIdHash)>> index;
+  struct Entry {
+    Crypto::Hash paymentId;
+    Crypto::Hash transactionHash;
+  };
+
+  struct FileHeader {
+    uint64_t entryCount;
+    uint32_t blockCount;
+    uint32_t reserved;
+    Crypto::Hash topBlockHash;
+  };
+
+  struct Shard {
+    std::mutex lock;
+    flat_hash_map<Crypto::Hash, std::vector<Crypto::Hash>> index;
+  };
+
+  static const size_t SHARD_COUNT = 16;
+
+  Shard& shard(const Crypto::Hash& paymentId);
+  void insert(const Crypto::Hash& paymentId, const Crypto::Hash& transactionHash);
+  bool erase(const Crypto::Hash& paymentId, const Crypto::Hash& transactionHash);
+  FileHeader& fileHeader();
+  const FileHeader& fileHeader() const;
+
+  std::array<Shard, SHARD_COUNT> shards;
+  Common::FileMappedVector<Entry> file;
   bool enabled = false;
 };
 
+// Hashes by timestamp in a sorted flat array. New entries go to a small sorted buffer that
+// is merged into the array when full, since timestamps mostly grow the merge only moves
+// the tail of the array.
+class TimestampHashIndex {
+public:
+  void add(uint64_t timestamp, const Crypto::Hash& hash);
+  bool remove(uint64_t timestamp, const Crypto::Hash& hash);
+  // up to limit hashes of [timestampBegin, timestampEnd] in timestamp order, returns the number in the range
+  uint64_t find(uint64_t timestampBegin, uint64_t timestampEnd, uint64_t limit, std::vector<Crypto::Hash>& hashes) const;
+  void clear();
+
+private:
+  typedef std::pair<uint64_t, Crypto::Hash> Entry;
+
+  static const size_t BUFFER_SIZE = 1024;
+
+  void merge();
+
+  std::vector<Entry> sorted;
+  std::vector<Entry> buffer;
+};
+
+// main chain blocks by timestamp, built from the timestamps of the block store
 class TimestampBlocksIndex {
 public:
   TimestampBlocksIndex(bool enabled);
@@ -66,14 +129,8 @@ public:
   bool find(uint64_t timestampBegin, uint64_t timestampEnd, uint32_t hashesNumberLimit, std::vector<Crypto::Hash>& hashes, uint32_t& hashesNumberWithinTimestamps);
   void clear();
 
-  void serialize(ISerializer& s);
-
-  template<class Archive> 
-  void serialize(Archive& archive, unsigned int version) {
-    archive & index;
-  }
 private:
-  std::multimap<uint64_t, Crypto::Hash> index;
+  TimestampHashIndex index;
   bool enabled = false;
 };
 
@@ -86,14 +143,8 @@ public:
   bool find(uint64_t timestampBegin, uint64_t timestampEnd, uint64_t hashesNumberLimit, std::vector<Crypto::Hash>& hashes, uint64_t& hashesNumberWithinTimestamps);
   void clear();
 
-  void serialize(ISerializer& s);
-
-  template<class Archive>
-  void serialize(Archive& archive, unsigned int version) {
-    archive & index;
-  }
 private:
-  std::multimap<uint64_t, Crypto::Hash> index;
+  TimestampHashIndex index;
   bool enabled = false;
 };
 
@@ -120,6 +171,77 @@ private:
   bool enabled = false;
 };
 
+// compact filters of the main chain blocks by height, see BlockFilter
+class BlockFilterIndex {
+public:
+  BlockFilterIndex(bool enabled);
+
+  bool add(const Crypto::Hash& blockHash, const std::vector<Crypto::Hash>& items);
+  bool removeLast();
+  bool find(uint32_t height, std::string& filter, Crypto::Hash& header) const;
+  bool findHeader(uint32_t height, Crypto::Hash& header) const;
+  uint32_t size() const;
+  void clear();
+
+  void serialize(ISerializer& s);
+
+  template<class Archive>
+  void serialize(Archive& archive, unsigned int version) {
+    archive & filters;
+    archive & headers;
+  }
+private:
+  std::vector<std::string> filters;
+  std::vector<Crypto::Hash> headers;
+  bool enabled = false;
+};
+
+// values of a main chain block that the explorer methods would otherwise work out
+// from the block, its transactions and the blocks below it
+struct BlockSummary {
+  uint64_t reward = 0; // of the base transaction, fees included
+  uint64_t totalFee = 0;
+  uint64_t baseReward = 0; // without the size penalty and the fees
+  double penalty = 0;
+  uint64_t sizeMedian = 0;
+  uint64_t blockSize = 0; // of the block blob and its transactions
+  Crypto::Hash proofOfWork = NULL_HASH; // NULL_HASH when it wasn't checked, as in the checkpoint zone
+
+  void serialize(ISerializer& s);
+
+  template<class Archive>
+  void serialize(Archive& archive, unsigned int version) {
+    archive & reward;
+    archive & totalFee;
+    archive & baseReward;
+    archive & penalty;
+    archive & sizeMedian;
+    archive & blockSize;
+    archive & proofOfWork;
+  }
+};
+
+class BlockSummaryIndex {
+public:
+  BlockSummaryIndex(bool enabled);
+
+  bool add(const BlockSummary& summary);
+  bool removeLast();
+  bool find(uint32_t height, BlockSummary& summary) const;
+  uint32_t size() const;
+  void clear();
+
+  void serialize(ISerializer& s);
+
+  template<class Archive>
+  void serialize(Archive& archive, unsigned int version) {
+    archive & summaries;
+  }
+private:
+  std::vector<BlockSummary> summaries;
+  bool enabled = false;
+};
+
 class OrphanBlocksIndex {
 public:
   OrphanBlocksIndex(bool enabled);
@@ -0,0 +1,140 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <mutex>
+#include <string>
+
+#include "Common/FileMappedHashTable.h"
+
+namespace CryptoNote {
+
+// A key-value index of the blockchain cache: a hash map in memory, or for the low memory
+// profile a file mapped table of the data folder, which persists by itself and so isn't
+// part of the cache snapshot. The table has a lock of its own since it may be remapped by
+// an insertion, memory maps that need one bring it as their mutex policy.
+template<class Key, class Value, class MemoryMap>
+class BlockchainKeyValueIndex {
+public:
+  BlockchainKeyValueIndex() : m_onDisk(false) {
+  }
+
+  void openFile(const std::string& path) {
+    std::lock_guard<std::mutex> lock(m_tableLock);
+    m_map.clear();
+    m_table.open(path);
+    m_onDisk = true;
+  }
+
+  void closeFile() {
+    std::lock_guard<std::mutex> lock(m_tableLock);
+    if (m_onDisk) {
+      m_table.close();
+    }
+  }
+
+  bool onDisk() const {
+    return m_onDisk;
+  }
+
+  // the file was missing or not closed, the index has to be built again
+  bool fileWasReset() const {
+    return m_onDisk && m_table.wasReset();
+  }
+
+  // for the cache snapshot of the in memory index
+  MemoryMap& memoryMap() {
+    return m_map;
+  }
+
+  bool find(const Key& key, Value& value) const {
+    if (m_onDisk) {
+      std::lock_guard<std::mutex> lock(m_tableLock);
+      return m_table.find(key, value);
+    }
+
+    auto it = m_map.find(key);
+    if (it == m_map.end()) {
+      return false;
+    }
+
+    value = it->second;
+    return true;
+  }
+
+  bool contains(const Key& key) const {
+    if (m_onDisk) {
+      std::lock_guard<std::mutex> lock(m_tableLock);
+      return m_table.contains(key);
+    }
+
+    return m_map.find(key) != m_map.end();
+  }
+
+  bool insert(const Key& key, const Value& value) {
+    if (m_onDisk) {
+      std::lock_guard<std::mutex> lock(m_tableLock);
+      return m_table.insert(key, value);
+    }
+
+    return m_map.insert(std::make_pair(key, value)).second;
+  }
+
+  size_t erase(const Key& key) {
+    if (m_onDisk) {
+      std::lock_guard<std::mutex> lock(m_tableLock);
+      return m_table.erase(key);
+    }
+
+    return m_map.erase(key);
+  }
+
+  size_t size() const {
+    if (m_onDisk) {
+      std::lock_guard<std::mutex> lock(m_tableLock);
+      return static_cast<size_t>(m_table.size());
+    }
+
+    return m_map.size();
+  }
+
+  void clear() {
+    if (m_onDisk) {
+      std::lock_guard<std::mutex> lock(m_tableLock);
+      m_table.clear();
+      return;
+    }
+
+    m_map.clear();
+  }
+
+  void flush() {
+    if (m_onDisk) {
+      std::lock_guard<std::mutex> lock(m_tableLock);
+      m_table.flush();
+    }
+  }
+
+private:
+  MemoryMap m_map;
+  Common::FileMappedHashTable<Key, Value> m_table;
+  mutable std::mutex m_tableLock;
+  bool m_onDisk;
+};
+
+}
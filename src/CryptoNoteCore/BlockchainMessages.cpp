@@ -39,40 +39,30 @@ void ChainSwitchMessage::get(std::vector<Crypto::Hash>& hashes) const {
   hashes = blocksFromCommonRoot;
 }
 
-BlockchainMessage::BlockchainMessage(NewBlockMessage&& message) : type(MessageType::NEW_BLOCK_MESSAGE), newBlockMessage(std::move(message)) {}
+const std::vector<Crypto::Hash>& ChainSwitchMessage::hashes() const {
+  return blocksFromCommonRoot;
+}
 
-BlockchainMessage::BlockchainMessage(NewAlternativeBlockMessage&& message) : type(MessageType::NEW_ALTERNATIVE_BLOCK_MESSAGE), newAlternativeBlockMessage(std::move(message)) {}
+TipChangedMessage::TipChangedMessage(const Crypto::Hash& hash) : blockHash(hash) {}
 
-BlockchainMessage::BlockchainMessage(ChainSwitchMessage&& message) : type(MessageType::CHAIN_SWITCH_MESSAGE) {
-	chainSwitchMessage = new ChainSwitchMessage(std::move(message));
+void TipChangedMessage::get(Crypto::Hash& hash) const {
+  hash = blockHash;
 }
 
-BlockchainMessage::BlockchainMessage(const BlockchainMessage& other) : type(other.type) {
-  switch (type) {
-    case MessageType::NEW_BLOCK_MESSAGE:
-      new (&newBlockMessage) NewBlockMessage(other.newBlockMessage);
-      break;
-    case MessageType::NEW_ALTERNATIVE_BLOCK_MESSAGE:
-      new (&newAlternativeBlockMessage) NewAlternativeBlockMessage(other.newAlternativeBlockMessage);
-      break;
-    case MessageType::CHAIN_SWITCH_MESSAGE:
-	  chainSwitchMessage = new ChainSwitchMessage(*other.chainSwitchMessage);
-      break;
-  }
+BlockchainMessage::BlockchainMessage(NewBlockMessage&& message) : type(MessageType::NEW_BLOCK_MESSAGE) {
+  message.get(blockHash);
 }
 
-BlockchainMessage::~BlockchainMessage() {
-  switch (type) {
-    case MessageType::NEW_BLOCK_MESSAGE:
-      newBlockMessage.~NewBlockMessage();
-      break;
-    case MessageType::NEW_ALTERNATIVE_BLOCK_MESSAGE:
-      newAlternativeBlockMessage.~NewAlternativeBlockMessage();
-      break;
-    case MessageType::CHAIN_SWITCH_MESSAGE:
-	  delete chainSwitchMessage;
-      break;
-  }
+BlockchainMessage::BlockchainMessage(NewAlternativeBlockMessage&& message) : type(MessageType::NEW_ALTERNATIVE_BLOCK_MESSAGE) {
+  message.get(blockHash);
+}
+
+BlockchainMessage::BlockchainMessage(ChainSwitchMessage&& message) : type(MessageType::CHAIN_SWITCH_MESSAGE),
+  chainSwitchMessage(std::make_shared<const ChainSwitchMessage>(std::move(message))) {
+}
+
+BlockchainMessage::BlockchainMessage(TipChangedMessage&& message) : type(MessageType::TIP_CHANGED_MESSAGE) {
+  message.get(blockHash);
 }
 
 BlockchainMessage::MessageType BlockchainMessage::getType() const {
@@ -81,7 +71,7 @@ BlockchainMessage::MessageType BlockchainMessage::getType() const {
 
 bool BlockchainMessage::getNewBlockHash(Crypto::Hash& hash) const {
   if (type == MessageType::NEW_BLOCK_MESSAGE) {
-    newBlockMessage.get(hash);
+    hash = blockHash;
     return true;
   } else {
     return false;
@@ -90,7 +80,7 @@ bool BlockchainMessage::getNewBlockHash(Crypto::Hash& hash) const {
 
 bool BlockchainMessage::getNewAlternativeBlockHash(Crypto::Hash& hash) const {
   if (type == MessageType::NEW_ALTERNATIVE_BLOCK_MESSAGE) {
-    newAlternativeBlockMessage.get(hash);
+    hash = blockHash;
     return true;
   } else {
     return false;
@@ -106,4 +96,37 @@ bool BlockchainMessage::getChainSwitch(std::vector<Crypto::Hash>& hashes) const
   }
 }
 
+bool BlockchainMessage::getTipChange(Crypto::Hash& hash) const {
+  if (type == MessageType::TIP_CHANGED_MESSAGE) {
+    hash = blockHash;
+    return true;
+  } else {
+    return false;
+  }
+}
+
+void BlockchainMessage::coalesce(std::deque<BlockchainMessage>& queue, std::deque<BlockchainMessage>::iterator first, const BlockchainMessage& message) {
+  bool tipChanged = false;
+  Crypto::Hash tip;
+  auto update = [&](const BlockchainMessage& m) {
+    if (m.type == MessageType::NEW_BLOCK_MESSAGE || m.type == MessageType::TIP_CHANGED_MESSAGE) {
+      tip = m.blockHash;
+      tipChanged = true;
+    } else if (m.type == MessageType::CHAIN_SWITCH_MESSAGE && !m.chainSwitchMessage->hashes().empty()) {
+      tip = m.chainSwitchMessage->hashes().back();
+      tipChanged = true;
+    }
+  };
+
+  for (auto it = first; it != queue.end(); ++it) {
+    update(*it);
+  }
+
+  update(message);
+  queue.erase(first, queue.end());
+  if (tipChanged) {
+    queue.push_back(BlockchainMessage(TipChangedMessage(tip)));
+  }
+}
+
 }
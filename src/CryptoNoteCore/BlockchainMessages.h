@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <deque>
+#include <memory>
 #include <vector>
 
 #include <CryptoNote.h>
@@ -46,39 +48,52 @@ public:
   ChainSwitchMessage(std::vector<Crypto::Hash>&& hashes);
   ChainSwitchMessage(const ChainSwitchMessage& other);
   void get(std::vector<Crypto::Hash>& hashes) const;
+  const std::vector<Crypto::Hash>& hashes() const;
 private:
   std::vector<Crypto::Hash> blocksFromCommonRoot;
 };
 
+// Stands for messages a full queue dropped, the consumer has to look up how the main chain
+// got to the given top block
+class TipChangedMessage {
+public:
+  TipChangedMessage(const Crypto::Hash& hash);
+  TipChangedMessage() = default;
+  void get(Crypto::Hash& hash) const;
+private:
+  Crypto::Hash blockHash;
+};
+
+// Copies share the payload, a message is pushed to every queue of the blockchain
 class BlockchainMessage {
 public:
   enum class MessageType {
     NEW_BLOCK_MESSAGE,
     NEW_ALTERNATIVE_BLOCK_MESSAGE,
-    CHAIN_SWITCH_MESSAGE
+    CHAIN_SWITCH_MESSAGE,
+    TIP_CHANGED_MESSAGE
   };
 
   BlockchainMessage(NewBlockMessage&& message);
   BlockchainMessage(NewAlternativeBlockMessage&& message);
   BlockchainMessage(ChainSwitchMessage&& message);
-
-  BlockchainMessage(const BlockchainMessage& other);
-
-  ~BlockchainMessage();
+  BlockchainMessage(TipChangedMessage&& message);
 
   MessageType getType() const;
 
   bool getNewBlockHash(Crypto::Hash& hash) const;
   bool getNewAlternativeBlockHash(Crypto::Hash& hash) const;
   bool getChainSwitch(std::vector<Crypto::Hash>& hashes) const;
-private:
-  const MessageType type;
+  bool getTipChange(Crypto::Hash& hash) const;
 
-  union {
-    NewBlockMessage newBlockMessage;
-    NewAlternativeBlockMessage newAlternativeBlockMessage;
-    ChainSwitchMessage* chainSwitchMessage;
-  };
+  // MessageQueue overflow: the messages from first on and the new one become a tip change,
+  // alternative blocks don't move the top block and are dropped
+  static void coalesce(std::deque<BlockchainMessage>& queue, std::deque<BlockchainMessage>::iterator first, const BlockchainMessage& message);
+
+private:
+  MessageType type;
+  Crypto::Hash blockHash;
+  std::shared_ptr<const ChainSwitchMessage> chainSwitchMessage;
 };
 
 }
@@ -18,15 +18,24 @@
 
 #include "Core.h"
 
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iomanip>
 #include <sstream>
+#include <thread>
+#include <typeinfo>
 #include <unordered_set>
+#include <boost/core/demangle.hpp>
 #include <boost/utility/value_init.hpp>
 #include <boost/range/combine.hpp>
 #include "../CryptoNoteConfig.h"
 #include "../Common/CommandLine.h"
 #include "../Common/Util.h"
 #include "../Common/Math.h"
+#include "../Common/Metrics.h"
 #include "../Common/StringTools.h"
+#include "../Common/Tracing.h"
 #include "../crypto/crypto.h"
 #include "../CryptoNoteProtocol/CryptoNoteProtocolDefinitions.h"
 #include "../Logging/LoggerRef.h"
@@ -77,6 +86,12 @@ Core::Core(const Currency& currency, i_cryptonote_protocol* pprotocol, Logging::
   m_blockchain(currency, m_mempool, logger, blockchainIndexesEnabled),
   m_miner(new miner(currency, *this, logger)),
   m_starter_message_showed(false),
+  m_initialized(false),
+  m_txVerificationQueueSize(0),
+  m_txCommitQueueSize(0),
+  m_cacheCompactInterval(10 * 60, false),
+  m_liteBlocks(parameters::CRYPTONOTE_LITE_BLOCKS_CACHE_SIZE / 2),
+  m_liteBlocksWithIndexes(parameters::CRYPTONOTE_LITE_BLOCKS_CACHE_SIZE / 2),
   m_checkpoints(logger) {
     set_cryptonote_protocol(pprotocol);
     m_blockchain.addObserver(this);
@@ -173,6 +188,10 @@ bool Core::getblockEntry(uint32_t height, uint64_t& block_cumulative_size, diffi
   return m_blockchain.getblockEntry(static_cast<size_t>(height), block_cumulative_size, difficulty, already_generated_coins, reward, transactions_count, timestamp);
 }
 
+bool Core::getBlockSummary(uint32_t height, BlockSummary& summary) {
+  return m_blockchain.getBlockSummary(height, summary);
+}
+
 std::time_t Core::getStartTime() const {
   return start_time;
 }
@@ -180,10 +199,28 @@ std::time_t Core::getStartTime() const {
 //-----------------------------------------------------------------------------------------------
 bool Core::init(const CoreConfig& config, const MinerConfig& minerConfig, bool load_existing) {
   m_config_folder = config.configFolder;
-  bool r = m_mempool.init(m_config_folder);
-  if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to initialize memory pool"; return false; }
-
-  r = m_blockchain.init(m_config_folder, load_existing);
+  m_mempool.setMaxSize(config.poolMaxSize);
+  m_blockchain.setLowMemoryMode(config.lowMemory);
+  m_blockchain.setVerificationCpus(config.verificationCpus);
+
+  if (load_existing && !config.bootstrapFolder.empty()) {
+    bool r = m_blockchain.importBootstrap(config.bootstrapFolder, m_config_folder);
+    if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to import bootstrap snapshot"; return false; }
+  }
+
+  // the pool state is a file of its own, it is loaded while the blockchain loads
+  std::chrono::steady_clock::time_point timePoint = std::chrono::steady_clock::now();
+  double poolDuration = 0;
+  std::shared_future<bool> poolLoaded = std::async(std::launch::async, [this, timePoint, &poolDuration] {
+    bool loaded = m_mempool.init(m_config_folder);
+    poolDuration = std::chrono::duration<double>(std::chrono::steady_clock::now() - timePoint).count();
+    return loaded;
+  }).share();
+
+  bool r = m_blockchain.init(m_config_folder, load_existing, [&poolLoaded] { poolLoaded.wait(); });
+  double blockchainDuration = std::chrono::duration<double>(std::chrono::steady_clock::now() - timePoint).count();
+  if (!poolLoaded.get()) { logger(ERROR, BRIGHT_RED) << "Failed to initialize memory pool"; return false; }
+  double totalDuration = std::chrono::duration<double>(std::chrono::steady_clock::now() - timePoint).count();
   if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to initialize blockchain storage"; return false; }
 
   r = m_miner->init(minerConfig);
@@ -191,7 +228,15 @@ bool Core::init(const CoreConfig& config, const MinerConfig& minerConfig, bool l
 
   start_time = std::time(nullptr);
 
-  return load_state_data();
+  logger(INFO) << "Core loaded in " << std::fixed << std::setprecision(2) << totalDuration << " s: memory pool "
+    << poolDuration << " s, blockchain " << blockchainDuration << " s";
+
+  if (!load_state_data()) {
+    return false;
+  }
+
+  m_initialized = true;
+  return true;
 }
 
 bool Core::set_genesis_block(const Block& b) {
@@ -204,6 +249,7 @@ bool Core::load_state_data() {
 }
 
 bool Core::deinit() {
+  m_initialized = false;
   m_miner->stop();
   m_mempool.deinit();
   m_blockchain.deinit();
@@ -277,6 +323,109 @@ bool Core::handle_incoming_tx(const BinaryArray& tx_blob, tx_verification_contex
   return handleIncomingTransaction(tx, tx_hash, tx_blob.size(), tvc, keeped_by_block, blockHeight);
 }
 
+void Core::handle_incoming_txs(const std::vector<BinaryArray>& tx_blobs, std::vector<tx_verification_context>& tvcs) {
+  TraceSpan span("core", "handle_incoming_txs");
+  span.setId(tx_blobs.size());
+  struct IncomingTransaction {
+    Transaction tx;
+    Crypto::Hash hash;
+    BlockInfo maxUsedBlock;
+    BlockInfo tail;
+    bool inputsChecked;
+    bool accepted;
+  };
+
+  tvcs.assign(tx_blobs.size(), boost::value_initialized<tx_verification_context>());
+  if (tx_blobs.empty()) {
+    return;
+  }
+
+  std::vector<IncomingTransaction> incoming(tx_blobs.size());
+  m_txVerificationQueueSize += tx_blobs.size();
+
+  // Stage 1: everything that doesn't modify the pool, including ring signatures, runs in parallel
+  std::atomic<size_t> next(0);
+  auto verify = [this, &tx_blobs, &tvcs, &incoming, &next] {
+    TraceSpan span("core", "verify_transactions");
+    for (size_t i = next++; i < tx_blobs.size(); i = next++) {
+      const BinaryArray& blob = tx_blobs[i];
+      IncomingTransaction& in = incoming[i];
+      tx_verification_context& tvc = tvcs[i];
+      in.inputsChecked = false;
+      in.accepted = false;
+
+      if (blob.size() > m_currency.maxTransactionSizeLimit() && getCurrentBlockMajorVersion() >= BLOCK_MAJOR_VERSION_4) {
+        logger(INFO) << "WRONG TRANSACTION BLOB, too big size " << blob.size() << ", rejected";
+        tvc.m_verification_failed = true;
+      } else {
+        Crypto::Hash prefixHash;
+        Crypto::Hash blockId;
+        uint32_t blockHeight;
+        if (!parse_tx_from_blob(in.tx, in.hash, prefixHash, blob)) {
+          logger(INFO) << "WRONG TRANSACTION BLOB, Failed to parse, rejected";
+          tvc.m_verification_failed = true;
+        } else if (checkIncomingTransaction(in.tx, in.hash, blob.size(), tvc, false,
+                   getBlockContainingTx(in.hash, blockId, blockHeight) ? blockHeight : getCurrentBlockchainHeight())) {
+          in.accepted = true;
+          // known transactions are left to the commit stage, which drops them without an error
+          if (!m_blockchain.haveTransaction(in.hash) && !m_mempool.have_tx(in.hash)) {
+            if (!m_blockchain.checkTransactionInputs(in.tx, in.maxUsedBlock.height, in.maxUsedBlock.id, &in.tail)) {
+              logger(INFO) << "tx " << in.hash << " used wrong inputs, rejected";
+              tvc.m_verification_failed = true;
+              in.accepted = false;
+            } else {
+              in.inputsChecked = true;
+            }
+          }
+        }
+      }
+
+      --m_txVerificationQueueSize;
+      if (in.accepted) {
+        ++m_txCommitQueueSize;
+      }
+    }
+  };
+
+  size_t workersCount = m_blockchain.getVerificationWorkersCount(tx_blobs.size());
+  std::vector<std::future<void>> workers;
+  for (size_t w = 1; w < workersCount; ++w) {
+    workers.push_back(m_blockchain.startVerificationWorker(verify));
+  }
+
+  verify();
+  for (auto& worker : workers) {
+    worker.get();
+  }
+
+  // Stage 2: pool insertion stays serialized, in the order transactions were received.
+  // Input checks are reused only if the chain hasn't moved since they were done.
+  TraceSpan commitSpan("core", "commit_transactions");
+  for (size_t i = 0; i < incoming.size(); ++i) {
+    IncomingTransaction& in = incoming[i];
+    if (!in.accepted) {
+      continue;
+    }
+
+    const BlockInfo* checkedMaxUsedBlock = nullptr;
+    if (in.inputsChecked) {
+      uint32_t tailHeight;
+      Crypto::Hash tailId = m_blockchain.getTailId(tailHeight);
+      if (tailId == in.tail.id && tailHeight == in.tail.height) {
+        checkedMaxUsedBlock = &in.maxUsedBlock;
+      }
+    }
+
+    commitIncomingTransaction(in.tx, in.hash, tx_blobs[i].size(), tvcs[i], false, checkedMaxUsedBlock);
+    --m_txCommitQueueSize;
+  }
+}
+
+void Core::getTransactionAdmissionQueueSizes(uint64_t& verificationQueueSize, uint64_t& commitQueueSize) const {
+  verificationQueueSize = m_txVerificationQueueSize;
+  commitQueueSize = m_txCommitQueueSize;
+}
+
 bool Core::get_stat_info(core_stat_info& st_inf) {
   st_inf.mining_speed = m_miner->get_speed();
   st_inf.alternative_blocks = m_blockchain.getAlternativeBlocksCount();
@@ -325,6 +474,10 @@ bool Core::check_tx_fee(const Transaction& tx, const Crypto::Hash& txHash, size_
 
   const uint64_t fee = inputs_amount - outputs_amount;
   bool isFusionTransaction = fee == 0 && m_currency.isFusionTransaction(tx, blobSize, height);
+  return check_tx_fee(tx, txHash, fee, isFusionTransaction, tvc, height);
+}
+
+bool Core::check_tx_fee(const Transaction& tx, const Crypto::Hash& txHash, uint64_t fee, bool isFusionTransaction, tx_verification_context& tvc, uint32_t height) {
   if (!isFusionTransaction && !m_checkpoints.is_in_checkpoint_zone(height)) {
     bool enough = true;
 
@@ -471,9 +624,13 @@ size_t Core::getBlockchainTotalTransactions() {
 //}
 
 bool Core::add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block) {
+  return add_new_tx(tx, tx_hash, blob_size, tvc, keeped_by_block, nullptr);
+}
+
+bool Core::add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block, const BlockInfo* checkedMaxUsedBlock) {
   //Locking on m_mempool and m_blockchain closes possibility to add tx to memory pool which is already in blockchain 
   std::lock_guard<decltype(m_mempool)> lk(m_mempool);
-  LockedBlockchainStorage lbs(m_blockchain);
+  ReadOnlyLockedBlockchainStorage lbs(m_blockchain);
 
   if (m_blockchain.haveTransaction(tx_hash)) {
     logger(TRACE) << "tx " << tx_hash << " is already in blockchain";
@@ -485,7 +642,7 @@ bool Core::add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t
     return true;
   }
 
-  return m_mempool.add_tx(tx, tx_hash, blob_size, tvc, keeped_by_block);
+  return m_mempool.add_tx(tx, tx_hash, blob_size, tvc, keeped_by_block, checkedMaxUsedBlock);
 }
 
 bool Core::get_block_template(Block& b, const AccountPublicAddress& adr, difficulty_type& diffic, uint32_t& height, const BinaryArray& ex_nonce) {
@@ -635,6 +792,10 @@ bool Core::get_tx_outputs_gindexs(const Crypto::Hash& tx_id, std::vector<uint32_
   return m_blockchain.getTransactionOutputGlobalIndexes(tx_id, indexs);
 }
 
+bool Core::getTransactionsOutputGlobalIndexes(const std::vector<Crypto::Hash>& txIds, std::vector<std::vector<uint32_t>>& indexes) {
+  return m_blockchain.getTransactionsOutputGlobalIndexes(txIds, indexes);
+}
+
 bool Core::getOutByMSigGIndex(uint64_t amount, uint64_t gindex, MultisignatureOutput& out) {
   return m_blockchain.get_out_by_msig_gindex(amount, gindex, out);
 }
@@ -701,7 +862,45 @@ void Core::getPoolChanges(const std::vector<Crypto::Hash>& knownTxsIds, std::vec
   assert(misses.empty());
 }
 
+bool Core::getPoolChanges(const Crypto::Hash& tailBlockId, const std::vector<Crypto::Hash>& knownTxsIds, uint64_t& poolSequence,
+                          std::vector<Transaction>& addedTxs, std::vector<Crypto::Hash>& deletedTxsIds, bool& isPoolSequenceActual) {
+  std::vector<Crypto::Hash> addedTxsIds;
+  {
+    auto guard = m_mempool.obtainGuard();
+    isPoolSequenceActual = poolSequence != 0 && m_mempool.getChangesSince(poolSequence, addedTxsIds, deletedTxsIds);
+    if (!isPoolSequenceActual) {
+      addedTxsIds.clear();
+      deletedTxsIds.clear();
+      m_mempool.get_difference(knownTxsIds, addedTxsIds, deletedTxsIds);
+    }
+
+    poolSequence = m_mempool.getModificationCounter();
+    std::vector<Crypto::Hash> misses;
+    m_mempool.getTransactions(addedTxsIds, addedTxs, misses);
+    assert(misses.empty());
+  }
+
+  return tailBlockId == m_blockchain.getTailId();
+}
+
+bool Core::getPoolChangesLite(const Crypto::Hash& tailBlockId, const std::vector<Crypto::Hash>& knownTxsIds, uint64_t& poolSequence,
+                              std::vector<TransactionPrefixInfo>& addedTxs, std::vector<Crypto::Hash>& deletedTxsIds, bool& isPoolSequenceActual) {
+  std::vector<Transaction> added;
+  bool returnStatus = getPoolChanges(tailBlockId, knownTxsIds, poolSequence, added, deletedTxsIds, isPoolSequenceActual);
+
+  for (const auto& tx: added) {
+    TransactionPrefixInfo tpi;
+    tpi.txPrefix = tx;
+    tpi.txHash = getObjectHash(tx);
+
+    addedTxs.push_back(std::move(tpi));
+  }
+
+  return returnStatus;
+}
+
 bool Core::handle_incoming_block_blob(const BinaryArray& block_blob, block_verification_context& bvc, bool control_miner, bool relay_block) {
+  TraceSpan span("core", "handle_incoming_block_blob");
   if (block_blob.size() > m_currency.maxBlockBlobSize()) {
     logger(INFO) << "WRONG BLOCK BLOB, too big size " << block_blob.size() << ", rejected";
     bvc.m_verification_failed = true;
@@ -709,16 +908,58 @@ bool Core::handle_incoming_block_blob(const BinaryArray& block_blob, block_verif
   }
 
   Block b;
-  if (!fromBinaryArray(b, block_blob)) {
-    logger(INFO) << "Failed to parse and validate new block";
-    bvc.m_verification_failed = true;
-    return false;
+  {
+    TraceSpan parseSpan("core", "parse_block");
+    if (!fromBinaryArray(b, block_blob)) {
+      logger(INFO) << "Failed to parse and validate new block";
+      bvc.m_verification_failed = true;
+      return false;
+    }
   }
 
   return handle_incoming_block(b, bvc, control_miner, relay_block);
 }
 
+void Core::precomputeLongHashes(const std::vector<Block>& blocks) {
+  m_blockchain.precomputeLongHashes(blocks);
+}
+
+bool Core::getBlockLongHash(const Block& block, Crypto::Hash& longHash) {
+  return m_blockchain.getBlockLongHash(block, longHash);
+}
+
+void Core::getLongHashCacheStatistics(uint64_t& hits, uint64_t& misses) const {
+  m_blockchain.getLongHashCacheStatistics(hits, misses);
+}
+
+void Core::writeMetrics(std::ostream& out) {
+  m_blockchain.writeMetrics(out);
+  m_mempool.writeMetrics(out);
+
+  writeMetricHeader(out, "karbo_core_observer_queue", "gauge", "Blockchain and pool update notifications waiting for delivery to the observers.");
+  out << "karbo_core_observer_queue " << m_observerManager.queuedNotifications() << '\n';
+
+  writeMetricHeader(out, "karbo_lite_blocks_cache_hits_total", "counter", "Lite block entries served from the cache of recent blocks.");
+  out << "karbo_lite_blocks_cache_hits_total " << m_liteBlocks.hits() + m_liteBlocksWithIndexes.hits() << '\n';
+  writeMetricHeader(out, "karbo_lite_blocks_cache_misses_total", "counter", "Lite block entries of recent blocks built because they were not cached.");
+  out << "karbo_lite_blocks_cache_misses_total " << m_liteBlocks.misses() + m_liteBlocksWithIndexes.misses() << '\n';
+
+  std::vector<Tools::ObserverManager<ICoreObserver>::ObserverLag> lags = m_observerManager.lags();
+  writeMetricHeader(out, "karbo_core_observer_lag_seconds", "gauge", "Time from queuing the last update notification to the observer having handled it.");
+  for (const auto& lag : lags) {
+    out << "karbo_core_observer_lag_seconds{observer=\"" << boost::core::demangle(typeid(*lag.observer).name()) << "\"} " <<
+      formatMetricSeconds(std::chrono::duration_cast<std::chrono::microseconds>(lag.last).count()) << '\n';
+  }
+
+  writeMetricHeader(out, "karbo_core_observer_max_lag_seconds", "gauge", "Longest time from queuing an update notification to the observer having handled it.");
+  for (const auto& lag : lags) {
+    out << "karbo_core_observer_max_lag_seconds{observer=\"" << boost::core::demangle(typeid(*lag.observer).name()) << "\"} " <<
+      formatMetricSeconds(std::chrono::duration_cast<std::chrono::microseconds>(lag.max).count()) << '\n';
+  }
+}
+
 bool Core::handle_incoming_block(const Block& b, block_verification_context& bvc, bool control_miner, bool relay_block) {
+  TraceSpan span("core", "handle_incoming_block");
   if (control_miner) {
     pause_mining();
   }
@@ -726,10 +967,12 @@ bool Core::handle_incoming_block(const Block& b, block_verification_context& bvc
   m_blockchain.addNewBlock(b, bvc);
 
   if (control_miner) {
+    TraceSpan minerSpan("core", "update_miner_template");
     update_block_template_and_resume_mining();
   }
 
   if (relay_block && bvc.m_added_to_main_chain) {
+    TraceSpan relaySpan("core", "relay_block");
     std::list<Crypto::Hash> missed_txs;
     std::list<Transaction> txs;
     m_blockchain.getTransactions(b.transactionHashes, txs, missed_txs);
@@ -767,6 +1010,10 @@ size_t Core::getPoolTransactionsCount() {
   return m_mempool.get_transactions_count();
 }
 
+void Core::getPoolTransactionIdsByShortIds(const Crypto::Hash& key, const std::vector<uint64_t>& shortIds, std::vector<Crypto::Hash>& transactionIds) {
+  m_mempool.getTransactionIdsByShortIds(key, shortIds, transactionIds);
+}
+
 bool Core::have_block(const Crypto::Hash& id) {
   return m_blockchain.haveBlock(id);
 }
@@ -823,7 +1070,7 @@ std::vector<Crypto::Hash> Core::buildSparseChain() {
 }
 
 std::vector<Crypto::Hash> Core::buildSparseChain(const Crypto::Hash& startBlockId) {
-  LockedBlockchainStorage lbs(m_blockchain);
+  ReadOnlyLockedBlockchainStorage lbs(m_blockchain);
   assert(m_blockchain.haveBlock(startBlockId));
   return m_blockchain.buildSparseChain(startBlockId);
 }
@@ -833,7 +1080,7 @@ bool Core::handle_get_objects(NOTIFY_REQUEST_GET_OBJECTS::request& arg, NOTIFY_R
 }
 
 Crypto::Hash Core::getBlockIdByHeight(uint32_t height) {
-  LockedBlockchainStorage lbs(m_blockchain);
+  ReadOnlyLockedBlockchainStorage lbs(m_blockchain);
   if (height < m_blockchain.getCurrentBlockchainHeight()) {
     return m_blockchain.getBlockIdByHeight(height);
   } else {
@@ -877,6 +1124,7 @@ bool Core::on_idle() {
 
   m_miner->on_idle();
   m_mempool.on_idle();
+  m_cacheCompactInterval.call([this]() { return m_blockchain.compactCache(); });
   return true;
 }
 
@@ -889,7 +1137,8 @@ bool Core::removeObserver(ICoreObserver* observer) {
 }
 
 void Core::blockchainUpdated() {
-  m_observerManager.notify(&ICoreObserver::blockchainUpdated);
+  TraceSpan span("observers", "core_blockchain_updated");
+  m_observerManager.notifyAsync(&ICoreObserver::blockchainUpdated);
 }
 
 void Core::txDeletedFromPool() {
@@ -897,13 +1146,14 @@ void Core::txDeletedFromPool() {
 }
 
 void Core::poolUpdated() {
-  m_observerManager.notify(&ICoreObserver::poolUpdated);
+  TraceSpan span("observers", "core_pool_updated");
+  m_observerManager.notifyAsync(&ICoreObserver::poolUpdated);
 }
 
 bool Core::queryBlocks(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp,
   uint32_t& resStartHeight, uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockFullInfo>& entries) {
 
-  LockedBlockchainStorage lbs(m_blockchain);
+  ReadOnlyLockedBlockchainStorage lbs(m_blockchain);
 
   uint32_t currentHeight = lbs->getCurrentBlockchainHeight();
   uint32_t startOffset = 0;
@@ -931,36 +1181,29 @@ bool Core::queryBlocks(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t
     return true;
   }
 
-  std::list<Block> blocks;
-  lbs->getBlocks(startFullOffset, blocksLeft, blocks);
-
-  for (auto& b : blocks) {
+  // the stored blobs are copied as they are, the blocks are neither deserialized nor hashed
+  m_blockchain.visitRawBlocks(startFullOffset, blocksLeft, [&entries, timestamp](const Blockchain::RawBlock& rawBlock) {
     BlockFullInfo item;
+    item.block_id = rawBlock.hash;
 
-    item.block_id = get_block_hash(b);
-
-    if (b.timestamp >= timestamp) {
-      // query transactions
-      std::list<Transaction> txs;
-      std::list<Crypto::Hash> missedTxs;
-      lbs->getTransactions(b.transactionHashes, txs, missedTxs);
-
-      // fill data
+    if (rawBlock.timestamp >= timestamp) {
       block_complete_entry& completeEntry = item;
-      completeEntry.block = asString(toBinaryArray(b));
-      for (auto& tx : txs) {
-        completeEntry.txs.push_back(asString(toBinaryArray(tx)));
+      completeEntry.block.assign(reinterpret_cast<const char*>(rawBlock.block.getData()), rawBlock.block.getSize());
+      // the base transaction goes inside the block
+      for (size_t i = 1; i < rawBlock.transactions.size(); ++i) {
+        completeEntry.txs.push_back(std::string(reinterpret_cast<const char*>(rawBlock.transactions[i].getData()), rawBlock.transactions[i].getSize()));
       }
     }
 
     entries.push_back(std::move(item));
-  }
+    return true;
+  });
 
   return true;
 }
 
 bool Core::findStartAndFullOffsets(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp, uint32_t& startOffset, uint32_t& startFullOffset) {
-  LockedBlockchainStorage lbs(m_blockchain);
+  ReadOnlyLockedBlockchainStorage lbs(m_blockchain);
 
   if (knownBlockIds.empty()) {
     logger(ERROR, BRIGHT_RED) << "knownBlockIds is empty";
@@ -983,7 +1226,7 @@ bool Core::findStartAndFullOffsets(const std::vector<Crypto::Hash>& knownBlockId
 std::vector<Crypto::Hash> Core::findIdsForShortBlocks(uint32_t startOffset, uint32_t startFullOffset) {
   assert(startOffset <= startFullOffset);
 
-  LockedBlockchainStorage lbs(m_blockchain);
+  ReadOnlyLockedBlockchainStorage lbs(m_blockchain);
 
   std::vector<Crypto::Hash> result;
   if (startOffset < startFullOffset) {
@@ -994,8 +1237,8 @@ std::vector<Crypto::Hash> Core::findIdsForShortBlocks(uint32_t startOffset, uint
 }
 
 bool Core::queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp, uint32_t& resStartHeight,
-  uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockShortInfo>& entries) {
-  LockedBlockchainStorage lbs(m_blockchain);
+  uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockShortInfo>& entries, bool withGlobalIndexes) {
+  ReadOnlyLockedBlockchainStorage lbs(m_blockchain);
 
   resCurrentHeight = lbs->getCurrentBlockchainHeight();
   resStartHeight = 0;
@@ -1019,27 +1262,226 @@ bool Core::queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockIds, uint6
     return true;
   }
 
+  auto& cache = withGlobalIndexes ? m_liteBlocksWithIndexes : m_liteBlocks;
+  uint32_t endHeight = resFullOffset + std::min(blocksLeft, resCurrentHeight - resFullOffset);
+  for (uint32_t height = resFullOffset; height < endHeight; ++height) {
+    Crypto::Hash blockId = lbs->getBlockIdByHeight(height);
+    if (lbs->getBlockTimestamp(height) < timestamp) {
+      entries.push_back(BlockShortInfo());
+      entries.back().blockId = blockId;
+      continue;
+    }
+
+    // wallets mostly ask for the same recent window, older blocks are built per request
+    bool recent = height + parameters::CRYPTONOTE_LITE_BLOCKS_CACHE_DEPTH >= resCurrentHeight;
+    std::shared_ptr<BlockShortInfo> item = recent ? cache.find(blockId) : nullptr;
+    if (!item) {
+      item = std::make_shared<BlockShortInfo>();
+      if (!makeLiteBlock(height, withGlobalIndexes, *item)) {
+        return false;
+      }
+
+      if (recent) {
+        size_t size = item->block.size();
+        for (const auto& info : item->txPrefixes) {
+          size += getObjectBinarySize(info.txPrefix) + info.globalIndexes.size() * sizeof(uint32_t);
+        }
+
+        cache.insert(blockId, item, size);
+      }
+    }
+
+    entries.push_back(*item);
+  }
+
+  return true;
+}
+
+bool Core::makeLiteBlock(uint32_t height, bool withGlobalIndexes, BlockShortInfo& item) {
+  ReadOnlyLockedBlockchainStorage lbs(m_blockchain);
+
   std::list<Block> blocks;
-  lbs->getBlocks(resFullOffset, blocksLeft, blocks);
+  lbs->getBlocks(height, 1, blocks);
+  if (blocks.empty()) {
+    logger(ERROR, BRIGHT_RED) << "Failed to get block at height " << height;
+    return false;
+  }
 
-  for (auto& b : blocks) {
-    BlockShortInfo item;
+  const Block& b = blocks.front();
+  item.blockId = get_block_hash(b);
+  item.block = asString(toBinaryArray(b));
 
-    item.blockId = get_block_hash(b);
+  if (withGlobalIndexes) {
+    std::vector<Crypto::Hash> hashes;
+    hashes.reserve(b.transactionHashes.size() + 1);
+    hashes.push_back(getObjectHash(b.baseTransaction));
+    hashes.insert(hashes.end(), b.transactionHashes.begin(), b.transactionHashes.end());
+
+    std::vector<std::pair<Transaction, std::vector<uint32_t>>> txs;
+    std::list<Crypto::Hash> missedTxs;
+    if (!lbs->getTransactionsWithOutputGlobalIndexes(hashes, missedTxs, txs) || !missedTxs.empty()) {
+      logger(ERROR, BRIGHT_RED) << "Failed to get global indexes of transactions of block " << item.blockId;
+      return false;
+    }
+
+    item.baseTransactionGlobalIndexes = std::move(txs.front().second);
+
+    for (size_t i = 1; i < txs.size(); ++i) {
+      TransactionPrefixInfo info;
+      info.txPrefix = std::move(txs[i].first);
+      info.txHash = hashes[i];
+      info.globalIndexes = std::move(txs[i].second);
+
+      item.txPrefixes.push_back(std::move(info));
+    }
+  } else {
+    std::list<Transaction> txs;
+    std::list<Crypto::Hash> missedTxs;
+    lbs->getTransactions(b.transactionHashes, txs, missedTxs);
+
+    for (const auto& tx: txs) {
+      TransactionPrefixInfo info;
+      info.txPrefix = tx;
+      info.txHash = getObjectHash(tx);
+
+      item.txPrefixes.push_back(std::move(info));
+    }
+  }
+
+  return true;
+}
+
+bool Core::getBlockFilters(const std::vector<Crypto::Hash>& knownBlockIds, uint32_t count, uint32_t& resStartHeight, std::vector<BlockFilterInfo>& filters) {
+  if (!m_blockchain.blockFiltersEnabled()) {
+    return false;
+  }
+
+  ReadOnlyLockedBlockchainStorage lbs(m_blockchain);
+
+  uint32_t fullOffset;
+  if (!findStartAndFullOffsets(knownBlockIds, 0, resStartHeight, fullOffset)) {
+    return false;
+  }
+
+  uint32_t end = resStartHeight + std::min(count, lbs->getCurrentBlockchainHeight() - resStartHeight);
+  for (uint32_t height = resStartHeight; height < end; ++height) {
+    BlockFilterInfo item;
+    item.blockId = lbs->getBlockIdByHeight(height);
+    if (!lbs->getBlockFilter(height, item.filter, item.header)) {
+      return false;
+    }
+
+    filters.push_back(std::move(item));
+  }
+
+  return true;
+}
+
+bool Core::exportBootstrap(const std::string& folder) {
+  return m_blockchain.exportBootstrap(folder);
+}
+
+bool Core::exportBlocks(const std::string& fileName) {
+  return m_blockchain.exportBlocks(fileName);
+}
+
+bool Core::importBlocks(const std::string& fileName) {
+  return m_blockchain.importBlocks(fileName);
+}
+
+bool Core::getBlockFilterHeaders(uint32_t startHeight, uint32_t count, std::vector<Crypto::Hash>& headers) {
+  if (!m_blockchain.blockFiltersEnabled()) {
+    return false;
+  }
+
+  ReadOnlyLockedBlockchainStorage lbs(m_blockchain);
+
+  uint32_t height = lbs->getCurrentBlockchainHeight();
+  uint32_t end = startHeight < height ? startHeight + std::min(count, height - startHeight) : startHeight;
+  for (uint32_t h = startHeight; h < end; ++h) {
+    Crypto::Hash header;
+    if (!lbs->getBlockFilterHeader(h, header)) {
+      return false;
+    }
+
+    headers.push_back(header);
+  }
+
+  return true;
+}
+
+bool Core::queryBlocksFiltered(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp, ViewKeyScanner& scanner,
+  uint32_t& resStartHeight, uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockShortInfo>& entries) {
+  std::list<Block> blocks;
+  std::vector<std::vector<std::pair<Transaction, std::vector<uint32_t>>>> blockTransactions;
+
+  {
+    ReadOnlyLockedBlockchainStorage lbs(m_blockchain);
+
+    resCurrentHeight = lbs->getCurrentBlockchainHeight();
+    resStartHeight = 0;
+    resFullOffset = 0;
+
+    if (!findStartAndFullOffsets(knownBlockIds, timestamp, resStartHeight, resFullOffset)) {
+      return false;
+    }
+
+    std::vector<Crypto::Hash> blockIds = findIdsForShortBlocks(resStartHeight, resFullOffset);
+    entries.reserve(blockIds.size());
+
+    for (const auto& id : blockIds) {
+      entries.push_back(BlockShortInfo());
+      entries.back().blockId = id;
+    }
+
+    uint32_t blocksLeft = static_cast<uint32_t>(std::min(BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT - entries.size(), BLOCKS_FILTERED_SYNCHRONIZING_COUNT));
+    if (blocksLeft == 0) {
+      return true;
+    }
+
+    lbs->getBlocks(resFullOffset, blocksLeft, blocks);
+
+    for (const auto& b : blocks) {
+      blockTransactions.emplace_back();
+      if (b.timestamp < timestamp) {
+        continue;
+      }
+
+      std::vector<Crypto::Hash> hashes;
+      hashes.reserve(b.transactionHashes.size() + 1);
+      hashes.push_back(getObjectHash(b.baseTransaction));
+      hashes.insert(hashes.end(), b.transactionHashes.begin(), b.transactionHashes.end());
 
-    if (b.timestamp >= timestamp) {
-      std::list<Transaction> txs;
       std::list<Crypto::Hash> missedTxs;
-      lbs->getTransactions(b.transactionHashes, txs, missedTxs);
+      if (!lbs->getTransactionsWithOutputGlobalIndexes(hashes, missedTxs, blockTransactions.back()) || !missedTxs.empty()) {
+        logger(ERROR, BRIGHT_RED) << "Failed to get transactions of block " << get_block_hash(b) << " for a filtered query";
+        return false;
+      }
+    }
+  }
+
+  // the key derivations are computed without holding the blockchain lock
+  auto txsIt = blockTransactions.begin();
+  for (auto& b : blocks) {
+    BlockShortInfo item;
+    item.blockId = get_block_hash(b);
 
+    const auto& txs = *txsIt++;
+    std::vector<bool> matches = scanner.scan(txs);
+    if (std::find(matches.begin(), matches.end(), true) != matches.end()) {
       item.block = asString(toBinaryArray(b));
+      item.baseTransactionGlobalIndexes = txs.front().second;
 
-      for (const auto& tx: txs) {
-        TransactionPrefixInfo info;
-        info.txPrefix = tx;
-        info.txHash = getObjectHash(tx);
+      // the first one is the coinbase, it comes with the block
+      for (size_t i = 1; i < txs.size(); ++i) {
+        if (matches[i]) {
+          TransactionPrefixInfo info;
+          info.txPrefix = txs[i].first;
+          info.txHash = b.transactionHashes[i - 1];
+          info.globalIndexes = txs[i].second;
 
-        item.txPrefixes.push_back(std::move(info));
+          item.txPrefixes.push_back(std::move(info));
+        }
       }
     }
 
@@ -1070,15 +1512,16 @@ bool Core::scanOutputkeysForIndices(const KeyInput& txInToKey, std::list<std::pa
   struct outputs_visitor
   {
     std::list<std::pair<Crypto::Hash, size_t>>& m_resultsCollector;
-    outputs_visitor(std::list<std::pair<Crypto::Hash, size_t>>& resultsCollector):m_resultsCollector(resultsCollector){}
-    bool handle_output(const Transaction& tx, const TransactionOutput& out, size_t transactionOutputIndex)
+    Blockchain& m_blockchain;
+    outputs_visitor(std::list<std::pair<Crypto::Hash, size_t>>& resultsCollector, Blockchain& blockchain):m_resultsCollector(resultsCollector), m_blockchain(blockchain){}
+    bool handle_output(const Transaction& tx, const TransactionOutput& out, const Blockchain::TransactionIndex& transactionIndex, size_t transactionOutputIndex)
     {
-      m_resultsCollector.push_back(std::make_pair(getObjectHash(tx), transactionOutputIndex));
+      m_resultsCollector.push_back(std::make_pair(m_blockchain.transactionHash(transactionIndex), transactionOutputIndex));
       return true;
     }
   };
     
-  outputs_visitor vi(outputReferences);
+  outputs_visitor vi(outputReferences, m_blockchain);
     
   return m_blockchain.scanOutputKeysForIndexes(txInToKey, vi);
 }
@@ -1092,6 +1535,10 @@ bool Core::getBlockTimestamp(uint32_t height, uint64_t& timestamp) {
   return true;
 }
 
+void Core::getBlockHeightsByTimestamps(const std::vector<uint64_t>& timestamps, std::vector<uint32_t>& heights) {
+  m_blockchain.getBlockHeightsByTimestamps(timestamps, heights);
+}
+
 bool Core::getBlockDifficulty(uint32_t height, difficulty_type& difficulty) {
   difficulty = m_blockchain.blockDifficulty(height);
   return true;
@@ -1239,16 +1686,20 @@ uint8_t Core::getBlockMajorVersionForHeight(uint32_t height) const {
 }
 
 bool Core::getPaymentId(const Transaction& transaction, Crypto::Hash& paymentId) {
-  std::vector<TransactionExtraField> txExtraFields;
-  parseTransactionExtra(transaction.extra, txExtraFields);
-  TransactionExtraNonce extraNonce;
-  if (!findTransactionExtraFieldByType(txExtraFields, extraNonce)) {
+  TransactionExtraScan scan;
+  scanTransactionExtra(transaction.extra, scan);
+  return scan.getPaymentId(paymentId);
+}
+
+bool Core::handleIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height) {
+  if (!checkIncomingTransaction(tx, txHash, blobSize, tvc, keptByBlock, height)) {
     return false;
   }
-  return getPaymentIdFromTransactionExtraNonce(extraNonce.nonce, paymentId);
+
+  return commitIncomingTransaction(tx, txHash, blobSize, tvc, keptByBlock, nullptr);
 }
 
-bool Core::handleIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height) {
+bool Core::checkIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height) {
   if (!check_tx_syntax(tx, txHash)) {
     logger(INFO) << "WRONG TRANSACTION BLOB, Failed to check tx " << txHash << " syntax, rejected";
     tvc.m_verification_failed = true;
@@ -1288,7 +1739,11 @@ bool Core::handleIncomingTransaction(const Transaction& tx, const Crypto::Hash&
     return false;
   }
 
-  bool r = add_new_tx(tx, txHash, blobSize, tvc, keptByBlock);
+  return true;
+}
+
+bool Core::commitIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, const BlockInfo* checkedMaxUsedBlock) {
+  bool r = add_new_tx(tx, txHash, blobSize, tvc, keptByBlock, checkedMaxUsedBlock);
   if (tvc.m_verification_failed) {
     if (!tvc.m_tx_fee_too_small) {
       logger(ERROR) << "Transaction verification failed: " << txHash;
@@ -1309,7 +1764,7 @@ bool Core::handleIncomingTransaction(const Transaction& tx, const Crypto::Hash&
 
 std::unique_ptr<IBlock> Core::getBlock(const Crypto::Hash& blockId) {
   std::lock_guard<decltype(m_mempool)> lk(m_mempool);
-  LockedBlockchainStorage lbs(m_blockchain);
+  ReadOnlyLockedBlockchainStorage lbs(m_blockchain);
 
   std::unique_ptr<BlockWithTransactions> blockPtr(new BlockWithTransactions());
   if (!lbs->getBlockByHash(blockId, blockPtr->block)) {
@@ -1375,6 +1830,7 @@ bool Core::removeMessageQueue(MessageQueue<BlockchainMessage>& messageQueue) {
 void Core::rollbackBlockchain(const uint32_t height) {
   logger(INFO, BRIGHT_YELLOW) << "Rewinding blockchain to height: " << height;
   m_blockchain.rollbackBlockchainTo(height);
+  m_observerManager.notify(&ICoreObserver::blockchainRolledBack, height);
 }
 
 bool Core::saveBlockchain() {
@@ -23,14 +23,18 @@
 #include <boost/program_options/variables_map.hpp>
 #include "BlockchainExplorerData.h"
 #include "P2p/NetNodeCommon.h"
+#include "CryptoNoteProtocol/CryptoNoteProtocolDefinitions.h"
 #include "CryptoNoteProtocol/CryptoNoteProtocolHandlerCommon.h"
 #include "Currency.h"
 #include "TransactionPool.h"
 #include "Blockchain.h"
 #include "CryptoNoteCore/IMinerHandler.h"
 #include "CryptoNoteCore/MinerConfig.h"
+#include "CryptoNoteCore/OnceInInterval.h"
+#include "CryptoNoteCore/ViewKeyScanner.h"
 #include "ICore.h"
 #include "ICoreObserver.h"
+#include "Common/ClockCache.h"
 #include "Common/ObserverManager.h"
 #include "Checkpoints/Checkpoints.h"
 #include "System/Dispatcher.h"
@@ -51,8 +55,17 @@ namespace CryptoNote {
 
      bool on_idle() override;
      virtual bool handle_incoming_tx(const BinaryArray& tx_blob, tx_verification_context& tvc, bool keeped_by_block) override; //Deprecated. Should be removed with CryptoNoteProtocolHandler.
+     virtual void handle_incoming_txs(const std::vector<BinaryArray>& tx_blobs, std::vector<tx_verification_context>& tvcs) override;
+     void getTransactionAdmissionQueueSizes(uint64_t& verificationQueueSize, uint64_t& commitQueueSize) const;
+     uint64_t getPoolModificationCounter() const { return m_mempool.getModificationCounter(); }
+     void getPoolSizeStatistics(uint64_t& totalSize, uint64_t& maxSize, uint64_t& evictedCount) const { m_mempool.getSizeStatistics(totalSize, maxSize, evictedCount); }
      bool handle_incoming_block_blob(const BinaryArray& block_blob, block_verification_context& bvc, bool control_miner, bool relay_block) override;
      bool handle_incoming_block(const Block& b, block_verification_context& bvc, bool control_miner, bool relay_block) override;
+     virtual void precomputeLongHashes(const std::vector<Block>& blocks) override;
+     virtual bool getBlockLongHash(const Block& block, Crypto::Hash& longHash) override;
+     void getLongHashCacheStatistics(uint64_t& hits, uint64_t& misses) const;
+     // blockchain and memory pool metrics in Prometheus text format
+     void writeMetrics(std::ostream& out);
      virtual i_cryptonote_protocol* get_protocol() override {return m_pprotocol;}
      const Currency& currency() const { return m_currency; }
 
@@ -81,6 +94,7 @@ namespace CryptoNote {
      virtual bool getBlockDifficulty(uint32_t height, difficulty_type& difficulty) override;
      virtual bool getBlockCumulativeDifficulty(uint32_t height, difficulty_type& difficulty) override;
      virtual bool getBlockTimestamp(uint32_t height, uint64_t& timestamp) override;
+     virtual void getBlockHeightsByTimestamps(const std::vector<uint64_t>& timestamps, std::vector<uint32_t>& heights) override;
      virtual difficulty_type getAvgDifficulty(uint32_t height, size_t window) override;
      virtual difficulty_type getAvgDifficulty(uint32_t height) override;
      virtual bool getBlockContainingTx(const Crypto::Hash& txId, Crypto::Hash& blockId, uint32_t& blockHeight) override;
@@ -102,6 +116,8 @@ namespace CryptoNote {
      virtual bool removeMessageQueue(MessageQueue<BlockchainMessage>& messageQueue) override;
 
      virtual std::time_t getStartTime() const;
+     // false until init() has loaded the blockchain and the pool
+     bool isInitialized() const { return m_initialized; }
 
      uint32_t getCurrentBlockchainHeight() override;
      uint8_t getCurrentBlockMajorVersion() override;
@@ -123,10 +139,25 @@ namespace CryptoNote {
      {
        return m_blockchain.getBlocks(block_ids, blocks, missed_bs);
      }
+     uint32_t visitRawBlocks(uint32_t startHeight, uint32_t count, const std::function<bool(const Blockchain::RawBlock&)>& visitor)
+     {
+       return m_blockchain.visitRawBlocks(startHeight, count, visitor);
+     }
      virtual bool queryBlocks(const std::vector<Crypto::Hash>& block_ids, uint64_t timestamp,
        uint32_t& start_height, uint32_t& current_height, uint32_t& full_offset, std::vector<BlockFullInfo>& entries) override;
+     // withGlobalIndexes adds the global output indexes of every returned transaction, coinbase included
      virtual bool queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp,
-       uint32_t& resStartHeight, uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockShortInfo>& entries) override;
+       uint32_t& resStartHeight, uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockShortInfo>& entries,
+       bool withGlobalIndexes) override;
+     // compact filters of the blocks from the last one known by the client, see BlockFilter
+     virtual bool getBlockFilters(const std::vector<Crypto::Hash>& knownBlockIds, uint32_t count, uint32_t& resStartHeight, std::vector<BlockFilterInfo>& filters) override;
+     bool getBlockFilterHeaders(uint32_t startHeight, uint32_t count, std::vector<Crypto::Hash>& headers);
+     bool exportBootstrap(const std::string& folder);
+     bool exportBlocks(const std::string& fileName);
+     bool importBlocks(const std::string& fileName);
+     // same as queryBlocksLite with global indexes, but only the blocks with transactions found by the scanner carry their body and these transactions
+     bool queryBlocksFiltered(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp, ViewKeyScanner& scanner,
+       uint32_t& resStartHeight, uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockShortInfo>& entries);
      virtual Crypto::Hash getBlockIdByHeight(uint32_t height) override;
      void getTransactions(const std::vector<Crypto::Hash>& txs_ids, std::list<Transaction>& txs, std::list<Crypto::Hash>& missed_txs, bool checkTxPool = false) override;
      virtual bool getTransactionsWithOutputGlobalIndexes(const std::vector<Crypto::Hash>& txs_ids, std::list<Crypto::Hash>& missed_txs, std::vector<std::pair<Transaction, std::vector<uint32_t>>>& txs) override;
@@ -146,14 +177,17 @@ namespace CryptoNote {
      std::vector<Transaction> getPoolTransactions() override;
      bool getPoolTransaction(const Crypto::Hash& tx_hash, Transaction& transaction) override;
      virtual size_t getPoolTransactionsCount() override;
+     virtual void getPoolTransactionIdsByShortIds(const Crypto::Hash& key, const std::vector<uint64_t>& shortIds, std::vector<Crypto::Hash>& transactionIds) override;
      virtual size_t getBlockchainTotalTransactions() override;
      //bool get_outs(uint64_t amount, std::list<Crypto::PublicKey>& pkeys);
      virtual std::vector<Crypto::Hash> findBlockchainSupplement(const std::vector<Crypto::Hash>& remoteBlockIds, size_t maxCount,
        uint32_t& totalBlockCount, uint32_t& startBlockIndex) override;
      bool get_stat_info(core_stat_info& st_inf) override;
      virtual bool getblockEntry(uint32_t height, uint64_t& block_cumulative_size, difficulty_type& difficulty, uint64_t& already_generated_coins, uint64_t& reward, uint64_t& transactions_count, uint64_t& timestamp) override;
+     virtual bool getBlockSummary(uint32_t height, BlockSummary& summary) override;
 
      virtual bool get_tx_outputs_gindexs(const Crypto::Hash& tx_id, std::vector<uint32_t>& indexs) override;
+     virtual bool getTransactionsOutputGlobalIndexes(const std::vector<Crypto::Hash>& txIds, std::vector<std::vector<uint32_t>>& indexes) override;
      Crypto::Hash get_tail_id();
      virtual bool get_random_outs_for_amounts(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_response& res) override;
      void pause_mining() override;
@@ -171,6 +205,12 @@ namespace CryptoNote {
                                   std::vector<TransactionPrefixInfo>& addedTxs, std::vector<Crypto::Hash>& deletedTxsIds) override;
      virtual void getPoolChanges(const std::vector<Crypto::Hash>& knownTxsIds, std::vector<Transaction>& addedTxs,
                                  std::vector<Crypto::Hash>& deletedTxsIds) override;
+     // Like above, but only the changes after poolSequence are returned when the pool changelog still has them.
+     // Otherwise falls back to diffing against knownTxsIds. poolSequence is updated to the current value.
+     bool getPoolChanges(const Crypto::Hash& tailBlockId, const std::vector<Crypto::Hash>& knownTxsIds, uint64_t& poolSequence,
+                         std::vector<Transaction>& addedTxs, std::vector<Crypto::Hash>& deletedTxsIds, bool& isPoolSequenceActual);
+     bool getPoolChangesLite(const Crypto::Hash& tailBlockId, const std::vector<Crypto::Hash>& knownTxsIds, uint64_t& poolSequence,
+                             std::vector<TransactionPrefixInfo>& addedTxs, std::vector<Crypto::Hash>& deletedTxsIds, bool& isPoolSequenceActual);
 
      virtual void rollbackBlockchain(const uint32_t height) override;
 
@@ -188,6 +228,10 @@ namespace CryptoNote {
 
    private:
      bool add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block);
+     bool add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block, const BlockInfo* checkedMaxUsedBlock);
+     //checks that don't touch the pool, safe to run concurrently
+     bool checkIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height);
+     bool commitIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, const BlockInfo* checkedMaxUsedBlock);
      bool load_state_data();
      bool parse_tx_from_blob(Transaction& tx, Crypto::Hash& tx_hash, Crypto::Hash& tx_prefix_hash, const BinaryArray& blob);
 
@@ -198,6 +242,7 @@ namespace CryptoNote {
      bool check_tx_mixin(const Transaction& tx, const Crypto::Hash& txHash, uint32_t height);
      //check if the mixin is not too large
      virtual bool check_tx_fee(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, uint32_t height) override;
+     virtual bool check_tx_fee(const Transaction& tx, const Crypto::Hash& txHash, uint64_t fee, bool isFusionTransaction, tx_verification_context& tvc, uint32_t height) override;
      //check if tx is not sending unmixable outputs
      bool check_tx_unmixable(const Transaction& tx, const Crypto::Hash& txHash, uint32_t height);
 
@@ -210,6 +255,7 @@ namespace CryptoNote {
 
      bool findStartAndFullOffsets(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp, uint32_t& startOffset, uint32_t& startFullOffset);
      std::vector<Crypto::Hash> findIdsForShortBlocks(uint32_t startOffset, uint32_t startFullOffset);
+     bool makeLiteBlock(uint32_t height, bool withGlobalIndexes, BlockShortInfo& item);
 
      System::Dispatcher& m_dispatcher;
      const Currency& m_currency;
@@ -224,6 +270,14 @@ namespace CryptoNote {
      cryptonote_protocol_stub m_protocol_stub;
      friend class tx_validate_inputs;
      std::atomic<bool> m_starter_message_showed;
+     std::atomic<bool> m_initialized;
+     std::atomic<uint64_t> m_txVerificationQueueSize;
+     std::atomic<uint64_t> m_txCommitQueueSize;
+     OnceInInterval m_cacheCompactInterval;
+     // queryBlocksLite entries of the recent blocks, keyed by block hash: the hash commits to
+     // the whole chain below, so after a reorg the entries of the old branch are never matched
+     Common::ClockCache<Crypto::Hash, BlockShortInfo> m_liteBlocks;
+     Common::ClockCache<Crypto::Hash, BlockShortInfo> m_liteBlocksWithIndexes;
      Tools::ObserverManager<ICoreObserver> m_observerManager;
      time_t start_time;
    };
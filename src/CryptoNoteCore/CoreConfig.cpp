@@ -19,11 +19,27 @@
 
 #include "Common/Util.h"
 #include "Common/CommandLine.h"
+#include "CryptoNoteConfig.h"
 
 namespace CryptoNote {
 
+namespace {
+const command_line::arg_descriptor<uint64_t> arg_pool_max_size = { "pool-max-size",
+  "Maximum total size of transactions in the memory pool, in bytes, 0 for no limit",
+  parameters::CRYPTONOTE_MEMPOOL_DEFAULT_MAX_SIZE };
+const command_line::arg_descriptor<std::string> arg_bootstrap = { "bootstrap",
+  "<directory> Start an empty data directory from a snapshot written by --export-bootstrap. Only the top block is "
+  "checked against the checkpoints, the directory must come from a source you fully trust", "" };
+const command_line::arg_descriptor<bool> arg_low_memory = { "low-memory",
+  "Keep the transaction map and the spent key images in files of the data directory instead of memory", false };
+const command_line::arg_descriptor<std::string> arg_verification_cpus = { "verification-cpus",
+  "<list> CPUs for the block and transaction verification workers, e.g. 8-15", "" };
+}
+
 CoreConfig::CoreConfig() {
   configFolder = Tools::getDefaultDataDirectory();
+  poolMaxSize = parameters::CRYPTONOTE_MEMPOOL_DEFAULT_MAX_SIZE;
+  lowMemory = false;
 }
 
 void CoreConfig::init(const boost::program_options::variables_map& options) {
@@ -31,8 +47,28 @@ void CoreConfig::init(const boost::program_options::variables_map& options) {
     configFolder = command_line::get_arg(options, command_line::arg_data_dir);
     configFolderDefaulted = options[command_line::arg_data_dir.name].defaulted();
   }
+
+  if (options.count(arg_pool_max_size.name) != 0) {
+    poolMaxSize = command_line::get_arg(options, arg_pool_max_size);
+  }
+
+  if (options.count(arg_bootstrap.name) != 0) {
+    bootstrapFolder = command_line::get_arg(options, arg_bootstrap);
+  }
+
+  if (options.count(arg_low_memory.name) != 0) {
+    lowMemory = command_line::get_arg(options, arg_low_memory);
+  }
+
+  if (options.count(arg_verification_cpus.name) != 0) {
+    verificationCpus = Tools::parseCpuList(command_line::get_arg(options, arg_verification_cpus));
+  }
 }
 
 void CoreConfig::initOptions(boost::program_options::options_description& desc) {
+  command_line::add_arg(desc, arg_pool_max_size);
+  command_line::add_arg(desc, arg_bootstrap);
+  command_line::add_arg(desc, arg_low_memory);
+  command_line::add_arg(desc, arg_verification_cpus);
 }
 } //namespace CryptoNote
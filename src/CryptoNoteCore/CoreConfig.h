@@ -17,7 +17,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include <boost/program_options.hpp>
 
@@ -32,6 +34,10 @@ public:
 
   std::string configFolder;
   bool configFolderDefaulted = true;
+  uint64_t poolMaxSize;
+  std::string bootstrapFolder;
+  bool lowMemory;
+  std::vector<unsigned> verificationCpus;
 };
 
 } //namespace CryptoNote
@@ -18,6 +18,8 @@
 
 #include "CryptoNoteFormatUtils.h"
 
+#include <algorithm>
+#include <cstring>
 #include <set>
 
 #include <Logging/LoggerRef.h>
@@ -33,6 +35,7 @@
 #include "CryptoNoteBasicImpl.h"
 #include "CryptoNoteSerialization.h"
 #include "TransactionExtra.h"
+#include "TransactionUtils.h"
 #include "CryptoNoteTools.h"
 #include "Currency.h"
 #include "Rpc/CoreRpcServerCommandsDefinitions.h"
@@ -52,10 +55,29 @@ bool parseAndValidateTransactionFromBinaryArray(const BinaryArray& tx_blob, Tran
 
   //TODO: validate tx
   cn_fast_hash(tx_blob.data(), tx_blob.size(), tx_hash);
-  getObjectHash(*static_cast<TransactionPrefix*>(&tx), tx_prefix_hash);
+  tx_prefix_hash = getTransactionPrefixHash(tx, tx_blob);
   return true;
 }
 
+size_t getTransactionPrefixSize(const Transaction& tx, size_t tx_size) {
+  size_t signatures_size = 0;
+  for (const TransactionInput& in : tx.inputs) {
+    signatures_size += getRequiredSignaturesCount(in) * sizeof(Signature);
+  }
+
+  if (signatures_size > tx_size) {
+    throw std::runtime_error("Transaction size is less than the size of its signatures");
+  }
+
+  return tx_size - signatures_size;
+}
+
+Hash getTransactionPrefixHash(const Transaction& tx, const BinaryArray& tx_blob) {
+  Hash tx_prefix_hash;
+  cn_fast_hash(tx_blob.data(), getTransactionPrefixSize(tx, tx_blob.size()), tx_prefix_hash);
+  return tx_prefix_hash;
+}
+
 bool generate_key_image_helper(const AccountKeys& ack, const PublicKey& tx_public_key, size_t real_output_index, KeyPair& in_ephemeral, KeyImage& ki) {
   KeyDerivation recv_derivation;
   bool r = generate_key_derivation(tx_public_key, ack.viewSecretKey, recv_derivation);
@@ -507,8 +529,7 @@ bool get_parent_block_hashing_blob(const Block& b, BinaryArray& blob) {
   return toBinaryArray(serializer, blob);
 }
 
-bool get_block_hash(const Block& b, Hash& res) {
-  BinaryArray ba;
+bool get_block_header_blob(const Block& b, BinaryArray& ba) {
   if (!get_block_hashing_blob(b, ba)) {
     return false;
   }
@@ -523,6 +544,27 @@ bool get_block_hash(const Block& b, Hash& res) {
     ba.insert(ba.end(), parent_blob.begin(), parent_blob.end());
   }
 
+  return true;
+}
+
+bool parse_block_header_blob(const BinaryArray& blob, BlockHeader& header) {
+  try {
+    Common::MemoryInputStream stream(blob.data(), blob.size());
+    BinaryInputStreamSerializer serializer(stream);
+    serialize(header, serializer);
+  } catch (std::exception&) {
+    return false;
+  }
+
+  return true;
+}
+
+bool get_block_hash(const Block& b, Hash& res) {
+  BinaryArray ba;
+  if (!get_block_header_blob(b, ba)) {
+    return false;
+  }
+
   return getObjectHash(ba, res);
 }
 
@@ -541,17 +583,33 @@ bool get_aux_block_header_hash(const Block& b, Hash& res) {
   return getObjectHash(blob, res);
 }
 
-bool get_block_longhash(cn_context &context, const Block& b, Hash& res) {
-  BinaryArray bd;
+bool get_block_longhash_blob(const Block& b, BinaryArray& blob) {
   if (b.majorVersion == BLOCK_MAJOR_VERSION_1 || b.majorVersion >= BLOCK_MAJOR_VERSION_4) {
-    if (!get_block_hashing_blob(b, bd)) {
-      return false;
-    }
+    return get_block_hashing_blob(b, blob);
   } else if (b.majorVersion == BLOCK_MAJOR_VERSION_2 || b.majorVersion == BLOCK_MAJOR_VERSION_3) {
-    if (!get_parent_block_hashing_blob(b, bd)) {
-      return false;
-    }
-  } else {
+    return get_parent_block_hashing_blob(b, blob);
+  }
+
+  return false;
+}
+
+bool get_block_longhash_blob(const Block& b, BinaryArray& blob, size_t& nonceOffset) {
+  // locate the nonce by serializing the block once more with every nonce bit flipped
+  Block probe = b;
+  probe.nonce = ~b.nonce;
+  BinaryArray probeBlob;
+  if (!get_block_longhash_blob(b, blob) || !get_block_longhash_blob(probe, probeBlob) || blob.size() != probeBlob.size()) {
+    return false;
+  }
+
+  auto mismatch = std::mismatch(blob.begin(), blob.end(), probeBlob.begin());
+  nonceOffset = static_cast<size_t>(std::distance(blob.begin(), mismatch.first));
+  return nonceOffset + sizeof(b.nonce) <= blob.size() && memcmp(&blob[nonceOffset], &b.nonce, sizeof(b.nonce)) == 0;
+}
+
+bool get_block_longhash(cn_context &context, const Block& b, Hash& res) {
+  BinaryArray bd;
+  if (!get_block_longhash_blob(b, bd)) {
     return false;
   }
   cn_slow_hash(context, bd.data(), bd.size(), res);
@@ -597,11 +655,46 @@ Hash get_tx_tree_hash(const Block& b) {
   return get_tx_tree_hash(txs_ids);
 }
 
+Hash get_compact_block_key(const BinaryArray& compactBlock, uint64_t nonce) {
+  BinaryArray data = compactBlock;
+  const uint8_t* nonceBytes = reinterpret_cast<const uint8_t*>(&nonce);
+  data.insert(data.end(), nonceBytes, nonceBytes + sizeof(nonce));
+  return cn_fast_hash(data.data(), data.size());
+}
+
+uint64_t get_transaction_short_id(const Hash& key, const Hash& transactionHash) {
+  uint8_t data[sizeof(Hash) * 2];
+  memcpy(data, &key, sizeof(Hash));
+  memcpy(data + sizeof(Hash), &transactionHash, sizeof(Hash));
+
+  Hash h = cn_fast_hash(data, sizeof(data));
+  uint64_t shortId = 0;
+  memcpy(&shortId, &h, COMPACT_BLOCK_SHORT_ID_SIZE);
+  return shortId;
+}
+
 bool is_valid_decomposed_amount(uint64_t amount) {
-  auto it = std::lower_bound(Currency::PRETTY_AMOUNTS.begin(), Currency::PRETTY_AMOUNTS.end(), amount);
-  if (it == Currency::PRETTY_AMOUNTS.end() || amount != *it) {
-	  return false;
+  uint8_t order;
+  return get_decomposed_amount_order(amount, order);
+}
+
+// A decomposed amount is a single nonzero digit followed by zeros, the same as the Currency::PRETTY_AMOUNTS.
+// Most amounts are small, so the power of ten is searched upwards rather than by bisection.
+bool get_decomposed_amount_order(uint64_t amount, uint8_t& order) {
+  if (amount == 0) {
+    return false;
+  }
+
+  size_t k = 0;
+  while (k + 1 < POWERS_OF_TEN_COUNT && POWERS_OF_TEN[k + 1] <= amount) {
+    ++k;
   }
+
+  if (amount % POWERS_OF_TEN[k] != 0) {
+    return false;
+  }
+
+  order = static_cast<uint8_t>(k);
   return true;
 }
 
@@ -34,6 +34,10 @@ class ILogger;
 namespace CryptoNote {
 
 bool parseAndValidateTransactionFromBinaryArray(const BinaryArray& transactionBinaryArray, Transaction& transaction, Crypto::Hash& transactionHash, Crypto::Hash& transactionPrefixHash);
+// The binary transaction is its prefix followed by the signatures only, so the prefix size
+// and hash are taken from the blob of the transaction without serializing it again.
+size_t getTransactionPrefixSize(const Transaction& transaction, size_t transactionSize);
+Crypto::Hash getTransactionPrefixHash(const Transaction& transaction, const BinaryArray& transactionBinaryArray);
 
 struct TransactionSourceEntry {
   typedef std::pair<uint32_t, Crypto::PublicKey> OutputEntry;
@@ -82,6 +86,11 @@ bool get_parent_block_hashing_blob(const Block& b, BinaryArray& blob);
 bool get_aux_block_header_hash(const Block& b, Crypto::Hash& res);
 bool get_block_hash(const Block& b, Crypto::Hash& res);
 Crypto::Hash get_block_hash(const Block& b);
+// the data get_block_hash hashes, it starts with the serialized BlockHeader
+bool get_block_header_blob(const Block& b, BinaryArray& blob);
+bool parse_block_header_blob(const BinaryArray& blob, BlockHeader& header);
+bool get_block_longhash_blob(const Block& b, BinaryArray& blob);
+bool get_block_longhash_blob(const Block& b, BinaryArray& blob, size_t& nonceOffset);
 bool get_block_longhash(Crypto::cn_context &context, const Block& b, Crypto::Hash& res);
 bool get_inputs_money_amount(const Transaction& tx, uint64_t& money);
 uint64_t get_outs_money_amount(const Transaction& tx);
@@ -97,6 +106,15 @@ std::vector<uint32_t> relative_output_offsets_to_absolute(const std::vector<uint
 std::vector<uint32_t> absolute_output_offsets_to_relative(const std::vector<uint32_t>& off);
 
 
+// POWERS_OF_TEN[k] is 10^k, up to the largest power of ten that fits into uint64_t
+const size_t POWERS_OF_TEN_COUNT = 20;
+constexpr uint64_t POWERS_OF_TEN[POWERS_OF_TEN_COUNT] = {
+  UINT64_C(1), UINT64_C(10), UINT64_C(100), UINT64_C(1000), UINT64_C(10000),
+  UINT64_C(100000), UINT64_C(1000000), UINT64_C(10000000), UINT64_C(100000000), UINT64_C(1000000000),
+  UINT64_C(10000000000), UINT64_C(100000000000), UINT64_C(1000000000000), UINT64_C(10000000000000), UINT64_C(100000000000000),
+  UINT64_C(1000000000000000), UINT64_C(10000000000000000), UINT64_C(100000000000000000), UINT64_C(1000000000000000000), UINT64_C(10000000000000000000)
+};
+
 // 62387455827 -> 455827 + 7000000 + 80000000 + 300000000 + 2000000000 + 60000000000, where 455827 <= dust_threshold
 template<typename chunk_handler_t, typename dust_handler_t>
 void decompose_amount_into_digits(uint64_t amount, uint64_t dust_threshold, const chunk_handler_t& chunk_handler, const dust_handler_t& dust_handler) {
@@ -106,11 +124,9 @@ void decompose_amount_into_digits(uint64_t amount, uint64_t dust_threshold, cons
 
   bool is_dust_handled = false;
   uint64_t dust = 0;
-  uint64_t order = 1;
-  while (0 != amount) {
-    uint64_t chunk = (amount % 10) * order;
+  for (size_t order = 0; 0 != amount; ++order) {
+    uint64_t chunk = (amount % 10) * POWERS_OF_TEN[order];
     amount /= 10;
-    order *= 10;
 
     if (dust + chunk <= dust_threshold) {
       dust += chunk;
@@ -134,4 +150,11 @@ void get_tx_tree_hash(const std::vector<Crypto::Hash>& tx_hashes, Crypto::Hash&
 Crypto::Hash get_tx_tree_hash(const std::vector<Crypto::Hash>& tx_hashes);
 Crypto::Hash get_tx_tree_hash(const Block& b);
 bool is_valid_decomposed_amount(uint64_t amount);
+// as is_valid_decomposed_amount(), also gives the power of ten of the amount, e.g. 3 for 7000
+bool get_decomposed_amount_order(uint64_t amount, uint8_t& order);
+
+// compact blocks refer to their transactions by short ids salted per block
+const size_t COMPACT_BLOCK_SHORT_ID_SIZE = 6;
+Crypto::Hash get_compact_block_key(const BinaryArray& compactBlock, uint64_t nonce);
+uint64_t get_transaction_short_id(const Crypto::Hash& key, const Crypto::Hash& transactionHash);
 }
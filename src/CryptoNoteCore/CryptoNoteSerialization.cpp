@@ -228,14 +228,18 @@ void serialize(Transaction& tx, ISerializer& serializer) {
         throw std::runtime_error("Serialization error: unexpected signatures size");
       }
 
-      for (Crypto::Signature& sig : tx.signatures[i]) {
-        serializePod(sig, "", serializer);
+      if (signatureSize != 0 && !serializer.binaryItems(tx.signatures[i].data(), sizeof(Crypto::Signature), signatureSize)) {
+        for (Crypto::Signature& sig : tx.signatures[i]) {
+          serializePod(sig, "", serializer);
+        }
       }
 
     } else {
       std::vector<Crypto::Signature> signatures(signatureSize);
-      for (Crypto::Signature& sig : signatures) {
-        serializePod(sig, "", serializer);
+      if (signatureSize != 0 && !serializer.binaryItems(signatures.data(), sizeof(Crypto::Signature), signatureSize)) {
+        for (Crypto::Signature& sig : signatures) {
+          serializePod(sig, "", serializer);
+        }
       }
 
       tx.signatures[i] = std::move(signatures);
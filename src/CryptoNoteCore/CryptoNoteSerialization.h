@@ -20,6 +20,7 @@
 #include "CryptoNoteBasic.h"
 #include "crypto/chacha8.h"
 #include "Serialization/ISerializer.h"
+#include "Serialization/SerializationOverloads.h"
 #include "crypto/crypto.h"
 
 namespace Crypto {
@@ -37,6 +38,11 @@ bool serialize(EllipticCurvePoint& ecPoint, Common::StringView name, CryptoNote:
 
 namespace CryptoNote {
 
+template<> struct IsBinaryBlock<Crypto::Hash> : std::true_type {};
+template<> struct IsBinaryBlock<Crypto::PublicKey> : std::true_type {};
+template<> struct IsBinaryBlock<Crypto::KeyImage> : std::true_type {};
+template<> struct IsBinaryBlock<Crypto::Signature> : std::true_type {};
+
 struct AccountKeys;
 struct TransactionExtraMergeMiningTag;
 
@@ -19,6 +19,9 @@
 
 #include "Currency.h"
 #include <cctype>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/math/special_functions/round.hpp>
 #include <boost/lexical_cast.hpp>
@@ -40,6 +43,54 @@ using namespace Common;
 
 namespace CryptoNote {
 
+	// The orders of a payout are parsed by the service, by the wallet and again when they are converted to
+	// transfers, so the addresses that passed the key checks are remembered. Only valid addresses are added.
+	class Currency::AddressCache {
+	public:
+		static const size_t CAPACITY = 16384;
+
+		bool find(const std::string& str, uint64_t& prefix, AccountPublicAddress& addr) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto it = m_index.find(str);
+			if (it == m_index.end()) {
+				return false;
+			}
+
+			m_entries.splice(m_entries.begin(), m_entries, it->second);
+			prefix = it->second->prefix;
+			addr = it->second->address;
+			return true;
+		}
+
+		void insert(const std::string& str, uint64_t prefix, const AccountPublicAddress& addr) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_index.count(str) != 0) {
+				return;
+			}
+
+			m_entries.push_front(Entry{ str, prefix, addr });
+			m_index.emplace(str, m_entries.begin());
+			if (m_entries.size() > CAPACITY) {
+				m_index.erase(m_entries.back().str);
+				m_entries.pop_back();
+			}
+		}
+
+	private:
+		struct Entry {
+			std::string str;
+			uint64_t prefix;
+			AccountPublicAddress address;
+		};
+
+		std::mutex m_mutex;
+		std::list<Entry> m_entries;
+		std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+	};
+
+	Currency::Currency(Logging::ILogger& log) : logger(log, "currency"), m_addressCache(std::make_shared<AddressCache>()) {
+	}
+
 	const std::vector<uint64_t> Currency::PRETTY_AMOUNTS = {
 		1, 2, 3, 4, 5, 6, 7, 8, 9,
 		10, 20, 30, 40, 50, 60, 70, 80, 90,
@@ -82,6 +133,7 @@ namespace CryptoNote {
 			m_blocksFileName = "testnet_" + m_blocksFileName;
 			m_blocksCacheFileName = "testnet_" + m_blocksCacheFileName;
 			m_blockIndexesFileName = "testnet_" + m_blockIndexesFileName;
+			m_blockStoreFileName = "testnet_" + m_blockStoreFileName;
 			m_txPoolFileName = "testnet_" + m_txPoolFileName;
 			m_blockchainIndicesFileName = "testnet_" + m_blockchainIndicesFileName;
 		}
@@ -117,36 +169,6 @@ namespace CryptoNote {
 		return true;
 	}
 
-	size_t Currency::blockGrantedFullRewardZoneByBlockVersion(uint8_t blockMajorVersion) const {
-		if (blockMajorVersion >= BLOCK_MAJOR_VERSION_3) {
-			return m_blockGrantedFullRewardZone;
-		}
-		else if (blockMajorVersion == BLOCK_MAJOR_VERSION_2) {
-			return CryptoNote::parameters::CRYPTONOTE_BLOCK_GRANTED_FULL_REWARD_ZONE_V2;
-		}
-		else {
-			return CryptoNote::parameters::CRYPTONOTE_BLOCK_GRANTED_FULL_REWARD_ZONE_V1;
-		}
-	}
-
-	uint32_t Currency::upgradeHeight(uint8_t majorVersion) const {
-		if (majorVersion == BLOCK_MAJOR_VERSION_5) {
-			return m_upgradeHeightV5;
-		}
-		else if (majorVersion == BLOCK_MAJOR_VERSION_4) {
-			return m_upgradeHeightV4;
-		}
-		else if (majorVersion == BLOCK_MAJOR_VERSION_2) {
-			return m_upgradeHeightV2;
-		}
-		else if (majorVersion == BLOCK_MAJOR_VERSION_3) {
-			return m_upgradeHeightV3;
-		}
-		else {
-			return static_cast<uint32_t>(-1);
-		}
-	}
-
   uint64_t Currency::calculateReward(uint64_t alreadyGeneratedCoins) const {
     // assert(alreadyGeneratedCoins <= m_moneySupply);
     assert(m_emissionSpeedFactor > 0 && m_emissionSpeedFactor <= 8 * sizeof(uint64_t));
@@ -195,14 +217,6 @@ namespace CryptoNote {
     return true;
   }
 
-	size_t Currency::maxBlockCumulativeSize(uint64_t height) const {
-		assert(height <= std::numeric_limits<uint64_t>::max() / m_maxBlockSizeGrowthSpeedNumerator);
-		size_t maxSize = static_cast<size_t>(m_maxBlockSizeInitial +
-			(height * m_maxBlockSizeGrowthSpeedNumerator) / m_maxBlockSizeGrowthSpeedDenominator);
-		assert(maxSize >= m_maxBlockSizeInitial);
-		return maxSize;
-	}
-
 	bool Currency::constructMinerTx(uint8_t blockMajorVersion, uint32_t height, size_t medianSize, uint64_t alreadyGeneratedCoins, size_t currentBlockSize,
 		uint64_t fee, const AccountPublicAddress& minerAddress, Transaction& tx, const BinaryArray& extraNonce/* = BinaryArray()*/, size_t maxOuts/* = 1*/) const {
 
@@ -284,39 +298,70 @@ namespace CryptoNote {
 		return true;
 	}
 
-	bool Currency::isFusionTransaction(const std::vector<uint64_t>& inputsAmounts, const std::vector<uint64_t>& outputsAmounts, size_t size, uint32_t height) const {
+	namespace {
+
+		// Whether count amounts, read by amountAt, are the sorted decomposition of amount. The decomposition
+		// is sorted as it is generated, the dust first and then the chunks of growing orders, so it is
+		// compared on the fly instead of being collected and sorted.
+		template<class AmountAt>
+		bool isSortedDecomposition(uint64_t amount, uint64_t dustThreshold, size_t count, const AmountAt& amountAt) {
+			size_t index = 0;
+			bool match = true;
+			auto next = [&](uint64_t expected) {
+				match = match && index < count && amountAt(index) == expected;
+				++index;
+			};
+
+			decompose_amount_into_digits(amount, dustThreshold, next, next);
+			return match && index == count;
+		}
+
+	}
+
+	bool Currency::isFusionTransactionShape(size_t size, size_t inputCount, size_t outputCount, uint32_t height) const {
 		if (height <= CryptoNote::parameters::UPGRADE_HEIGHT_V3 ? size > CryptoNote::parameters::CRYPTONOTE_BLOCK_GRANTED_FULL_REWARD_ZONE_CURRENT * 30 / 100 : size > fusionTxMaxSize()) {
 			logger(ERROR) << "Fusion transaction verification failed: size exceeded max allowed size.";
 			return false;
 		}
 
-		if (inputsAmounts.size() < fusionTxMinInputCount()) {
+		if (inputCount < fusionTxMinInputCount()) {
 			logger(ERROR) << "Fusion transaction verification failed: inputs count is less than minimum.";
 			return false;
 		}
 
-		if (inputsAmounts.size() < outputsAmounts.size() * fusionTxMinInOutCountRatio()) {
+		if (inputCount < outputCount * fusionTxMinInOutCountRatio()) {
 			logger(ERROR) << "Fusion transaction verification failed: inputs to outputs count ratio is less than minimum.";
 			return false;
 		}
 
+		return true;
+	}
+
+	bool Currency::isFusionInputAmount(uint64_t amount, uint32_t height) const {
+		if (height < CryptoNote::parameters::UPGRADE_HEIGHT_V4 && amount < defaultDustThreshold()) {
+			logger(ERROR) << "Fusion transaction verification failed: amount " << amount << " is less than dust threshold.";
+			return false;
+		}
+
+		return true;
+	}
+
+	bool Currency::isFusionTransaction(const std::vector<uint64_t>& inputsAmounts, const std::vector<uint64_t>& outputsAmounts, size_t size, uint32_t height) const {
+		if (!isFusionTransactionShape(size, inputsAmounts.size(), outputsAmounts.size(), height)) {
+			return false;
+		}
+
 		uint64_t inputAmount = 0;
 		for (auto amount : inputsAmounts) {
-			if (height < CryptoNote::parameters::UPGRADE_HEIGHT_V4)
-				if (amount < defaultDustThreshold()) {
-					logger(ERROR) << "Fusion transaction verification failed: amount " << amount << " is less than dust threshold.";
-					return false;
-				}
+			if (!isFusionInputAmount(amount, height)) {
+				return false;
+			}
+
 			inputAmount += amount;
 		}
 
-		std::vector<uint64_t> expectedOutputsAmounts;
-		expectedOutputsAmounts.reserve(outputsAmounts.size());
-		decomposeAmount(inputAmount, height < CryptoNote::parameters::UPGRADE_HEIGHT_V4 ? defaultDustThreshold() : UINT64_C(0), expectedOutputsAmounts);
-		std::sort(expectedOutputsAmounts.begin(), expectedOutputsAmounts.end());
-
-		bool decompose = expectedOutputsAmounts == outputsAmounts;
-		if (!decompose) {
+		uint64_t dustThreshold = height < CryptoNote::parameters::UPGRADE_HEIGHT_V4 ? defaultDustThreshold() : UINT64_C(0);
+		if (!isSortedDecomposition(inputAmount, dustThreshold, outputsAmounts.size(), [&outputsAmounts](size_t i) { return outputsAmounts[i]; })) {
 			logger(ERROR) << "Fusion transaction verification failed: decomposed output amounts do not match expected.";
 			return false;
 		}
@@ -324,16 +369,47 @@ namespace CryptoNote {
 		return true;
 	}
 
+	// Same as the overload taking the amounts, but reads them from the transaction in place
 	bool Currency::isFusionTransaction(const Transaction& transaction, size_t size, uint32_t height) const {
 		assert(getObjectBinarySize(transaction) == size);
 
-		std::vector<uint64_t> outputsAmounts;
-		outputsAmounts.reserve(transaction.outputs.size());
-		for (const TransactionOutput& output : transaction.outputs) {
-			outputsAmounts.push_back(output.amount);
+		size_t inputCount = 0;
+		for (const auto& input : transaction.inputs) {
+			if (input.type() == typeid(KeyInput) || input.type() == typeid(MultisignatureInput)) {
+				++inputCount;
+			}
+		}
+
+		if (!isFusionTransactionShape(size, inputCount, transaction.outputs.size(), height)) {
+			return false;
+		}
+
+		uint64_t inputAmount = 0;
+		for (const auto& input : transaction.inputs) {
+			uint64_t amount;
+			if (input.type() == typeid(KeyInput)) {
+				amount = boost::get<KeyInput>(input).amount;
+			} else if (input.type() == typeid(MultisignatureInput)) {
+				amount = boost::get<MultisignatureInput>(input).amount;
+			} else {
+				continue;
+			}
+
+			if (!isFusionInputAmount(amount, height)) {
+				return false;
+			}
+
+			inputAmount += amount;
+		}
+
+		uint64_t dustThreshold = height < CryptoNote::parameters::UPGRADE_HEIGHT_V4 ? defaultDustThreshold() : UINT64_C(0);
+		const auto& outputs = transaction.outputs;
+		if (!isSortedDecomposition(inputAmount, dustThreshold, outputs.size(), [&outputs](size_t i) { return outputs[i].amount; })) {
+			logger(ERROR) << "Fusion transaction verification failed: decomposed output amounts do not match expected.";
+			return false;
 		}
 
-		return isFusionTransaction(getInputsAmounts(transaction), outputsAmounts, size, height);
+		return true;
 	}
 
 	bool Currency::isFusionTransaction(const Transaction& transaction, uint32_t height) const {
@@ -354,13 +430,7 @@ namespace CryptoNote {
 			return false;
 		}
 
-		auto it = std::lower_bound(PRETTY_AMOUNTS.begin(), PRETTY_AMOUNTS.end(), amount);
-		if (it == PRETTY_AMOUNTS.end() || amount != *it) {
-			return false;
-		}
-
-		amountPowerOfTen = static_cast<uint8_t>(std::distance(PRETTY_AMOUNTS.begin(), it) / 9);
-		return true;
+		return get_decomposed_amount_order(amount, amountPowerOfTen);
 	}
 
 	std::string Currency::accountAddressAsString(const AccountBase& account) const {
@@ -373,8 +443,12 @@ namespace CryptoNote {
 
 	bool Currency::parseAccountAddressString(const std::string& str, AccountPublicAddress& addr) const {
 		uint64_t prefix;
-		if (!CryptoNote::parseAccountAddressString(prefix, addr, str)) {
-			return false;
+		if (!m_addressCache->find(str, prefix, addr)) {
+			if (!CryptoNote::parseAccountAddressString(prefix, addr, str)) {
+				return false;
+			}
+
+			m_addressCache->insert(str, prefix, addr);
 		}
 
 		if (prefix != m_publicAddressBase58Prefix) {
@@ -758,7 +832,7 @@ namespace CryptoNote {
 			return false;
 		}
 
-		return check_hash(proofOfWork, currentDiffic);
+		return checkProofOfWorkV1(block, currentDiffic, proofOfWork);
 	}
 
 	bool Currency::checkProofOfWorkV2(Crypto::cn_context& context, const Block& block, difficulty_type currentDiffic,
@@ -771,6 +845,38 @@ namespace CryptoNote {
 			return false;
 		}
 
+		return checkProofOfWorkV2(block, currentDiffic, proofOfWork);
+	}
+
+	bool Currency::checkProofOfWork(Crypto::cn_context& context, const Block& block, difficulty_type currentDiffic, Crypto::Hash& proofOfWork) const {
+		switch (block.majorVersion) {
+		case BLOCK_MAJOR_VERSION_1:
+		case BLOCK_MAJOR_VERSION_4:
+		case BLOCK_MAJOR_VERSION_5:
+			return checkProofOfWorkV1(context, block, currentDiffic, proofOfWork);
+
+		case BLOCK_MAJOR_VERSION_2:
+		case BLOCK_MAJOR_VERSION_3:
+			return checkProofOfWorkV2(context, block, currentDiffic, proofOfWork);
+		}
+
+		logger(ERROR, BRIGHT_RED) << "Unknown block major version: " << block.majorVersion << "." << block.minorVersion;
+		return false;
+	}
+
+	bool Currency::checkProofOfWorkV1(const Block& block, difficulty_type currentDiffic, const Crypto::Hash& proofOfWork) const {
+		if (BLOCK_MAJOR_VERSION_2 == block.majorVersion || BLOCK_MAJOR_VERSION_3 == block.majorVersion) {
+			return false;
+		}
+
+		return check_hash(proofOfWork, currentDiffic);
+	}
+
+	bool Currency::checkProofOfWorkV2(const Block& block, difficulty_type currentDiffic, const Crypto::Hash& proofOfWork) const {
+		if (block.majorVersion < BLOCK_MAJOR_VERSION_2) {
+			return false;
+		}
+
 		if (!check_hash(proofOfWork, currentDiffic)) {
 			return false;
 		}
@@ -802,16 +908,16 @@ namespace CryptoNote {
 		return true;
 	}
 
-	bool Currency::checkProofOfWork(Crypto::cn_context& context, const Block& block, difficulty_type currentDiffic, Crypto::Hash& proofOfWork) const {
+	bool Currency::checkProofOfWork(const Block& block, difficulty_type currentDiffic, const Crypto::Hash& proofOfWork) const {
 		switch (block.majorVersion) {
 		case BLOCK_MAJOR_VERSION_1:
 		case BLOCK_MAJOR_VERSION_4:
 		case BLOCK_MAJOR_VERSION_5:
-			return checkProofOfWorkV1(context, block, currentDiffic, proofOfWork);
+			return checkProofOfWorkV1(block, currentDiffic, proofOfWork);
 
 		case BLOCK_MAJOR_VERSION_2:
 		case BLOCK_MAJOR_VERSION_3:
-			return checkProofOfWorkV2(context, block, currentDiffic, proofOfWork);
+			return checkProofOfWorkV2(block, currentDiffic, proofOfWork);
 		}
 
 		logger(ERROR, BRIGHT_RED) << "Unknown block major version: " << block.majorVersion << "." << block.minorVersion;
@@ -903,6 +1009,7 @@ namespace CryptoNote {
 		blocksFileName(parameters::CRYPTONOTE_BLOCKS_FILENAME);
 		blocksCacheFileName(parameters::CRYPTONOTE_BLOCKSCACHE_FILENAME);
 		blockIndexesFileName(parameters::CRYPTONOTE_BLOCKINDEXES_FILENAME);
+		blockStoreFileName(parameters::CRYPTONOTE_BLOCKSTORE_FILENAME);
 		txPoolFileName(parameters::CRYPTONOTE_POOLDATA_FILENAME);
 		blockchainIndicesFileName(parameters::CRYPTONOTE_BLOCKCHAIN_INDICES_FILENAME);
 
@@ -18,7 +18,10 @@
 
 #pragma once
 
+#include <cassert>
 #include <cstdint>
+#include <limits>
+#include <memory>
 #include <string>
 #include <vector>
 #include <boost/utility.hpp>
@@ -69,7 +72,15 @@ public:
 
   size_t rewardBlocksWindow() const { return m_rewardBlocksWindow; }
   size_t blockGrantedFullRewardZone() const { return m_blockGrantedFullRewardZone; }
-  size_t blockGrantedFullRewardZoneByBlockVersion(uint8_t blockMajorVersion) const;
+  size_t blockGrantedFullRewardZoneByBlockVersion(uint8_t blockMajorVersion) const {
+    if (blockMajorVersion >= BLOCK_MAJOR_VERSION_3) {
+      return m_blockGrantedFullRewardZone;
+    } else if (blockMajorVersion == BLOCK_MAJOR_VERSION_2) {
+      return parameters::CRYPTONOTE_BLOCK_GRANTED_FULL_REWARD_ZONE_V2;
+    } else {
+      return parameters::CRYPTONOTE_BLOCK_GRANTED_FULL_REWARD_ZONE_V1;
+    }
+  }
   size_t minerTxBlobReservedSize() const { return m_minerTxBlobReservedSize; }
   uint64_t maxTransactionSizeLimit() const { return m_maxTransactionSizeLimit; }
 
@@ -123,7 +134,16 @@ public:
   size_t fusionTxMinInputCount() const { return m_fusionTxMinInputCount; }
   size_t fusionTxMinInOutCountRatio() const { return m_fusionTxMinInOutCountRatio; }
 
-  uint32_t upgradeHeight(uint8_t majorVersion) const;
+  // inline like the other getters, block and transaction checks ask for these on every call
+  uint32_t upgradeHeight(uint8_t majorVersion) const {
+    switch (majorVersion) {
+    case BLOCK_MAJOR_VERSION_2: return m_upgradeHeightV2;
+    case BLOCK_MAJOR_VERSION_3: return m_upgradeHeightV3;
+    case BLOCK_MAJOR_VERSION_4: return m_upgradeHeightV4;
+    case BLOCK_MAJOR_VERSION_5: return m_upgradeHeightV5;
+    default: return static_cast<uint32_t>(-1);
+    }
+  }
   unsigned int upgradeVotingThreshold() const { return m_upgradeVotingThreshold; }
   uint32_t upgradeVotingWindow() const { return m_upgradeVotingWindow; }
   uint32_t upgradeWindow() const { return m_upgradeWindow; }
@@ -134,6 +154,7 @@ public:
   const std::string& blocksFileName() const { return m_blocksFileName; }
   const std::string& blocksCacheFileName() const { return m_blocksCacheFileName; }
   const std::string& blockIndexesFileName() const { return m_blockIndexesFileName; }
+  const std::string& blockStoreFileName() const { return m_blockStoreFileName; }
   const std::string& txPoolFileName() const { return m_txPoolFileName; }
   const std::string& blockchainIndicesFileName() const { return m_blockchainIndicesFileName; }
 
@@ -145,7 +166,12 @@ public:
   uint64_t calculateReward(uint64_t alreadyGeneratedCoins) const;
   bool getBlockReward(uint8_t blockMajorVersion, size_t medianSize, size_t currentBlockSize, uint64_t alreadyGeneratedCoins, uint64_t fee,
     uint64_t& reward, int64_t& emissionChange) const;
-  size_t maxBlockCumulativeSize(uint64_t height) const;
+  size_t maxBlockCumulativeSize(uint64_t height) const {
+    assert(height <= std::numeric_limits<uint64_t>::max() / m_maxBlockSizeGrowthSpeedNumerator);
+    size_t maxSize = static_cast<size_t>(m_maxBlockSizeInitial + (height * m_maxBlockSizeGrowthSpeedNumerator) / m_maxBlockSizeGrowthSpeedDenominator);
+    assert(maxSize >= m_maxBlockSizeInitial);
+    return maxSize;
+  }
 
   bool constructMinerTx(uint8_t blockMajorVersion, uint32_t height, size_t medianSize, uint64_t alreadyGeneratedCoins, size_t currentBlockSize,
     uint64_t fee, const AccountPublicAddress& minerAddress, Transaction& tx, const BinaryArray& extraNonce = BinaryArray(), size_t maxOuts = 1) const;
@@ -176,18 +202,23 @@ public:
   bool checkProofOfWorkV1(Crypto::cn_context& context, const Block& block, difficulty_type currentDiffic, Crypto::Hash& proofOfWork) const;
   bool checkProofOfWorkV2(Crypto::cn_context& context, const Block& block, difficulty_type currentDiffic, Crypto::Hash& proofOfWork) const;
   bool checkProofOfWork(Crypto::cn_context& context, const Block& block, difficulty_type currentDiffic, Crypto::Hash& proofOfWork) const;
+  // Same checks for a long hash that has already been computed, e.g. ahead of time by a worker thread
+  bool checkProofOfWorkV1(const Block& block, difficulty_type currentDiffic, const Crypto::Hash& proofOfWork) const;
+  bool checkProofOfWorkV2(const Block& block, difficulty_type currentDiffic, const Crypto::Hash& proofOfWork) const;
+  bool checkProofOfWork(const Block& block, difficulty_type currentDiffic, const Crypto::Hash& proofOfWork) const;
 
   size_t getApproximateMaximumInputCount(size_t transactionSize, size_t outputCount, size_t mixinCount) const;
 
   static const std::vector<uint64_t> PRETTY_AMOUNTS;
 
 private:
-  Currency(Logging::ILogger& log) : logger(log, "currency") {
-  }
+  Currency(Logging::ILogger& log);
 
   bool init();
 
   bool generateGenesisBlock();
+  bool isFusionTransactionShape(size_t size, size_t inputCount, size_t outputCount, uint32_t height) const;
+  bool isFusionInputAmount(uint64_t amount, uint32_t height) const;
 
 private:
   uint64_t m_maxBlockHeight;
@@ -253,6 +284,7 @@ private:
   std::string m_blocksFileName;
   std::string m_blocksCacheFileName;
   std::string m_blockIndexesFileName;
+  std::string m_blockStoreFileName;
   std::string m_txPoolFileName;
   std::string m_blockchainIndicesFileName;
 
@@ -263,6 +295,10 @@ private:
 
   Logging::LoggerRef logger;
 
+  // recently parsed addresses, shared by the copies of a currency
+  class AddressCache;
+  std::shared_ptr<AddressCache> m_addressCache;
+
   friend class CurrencyBuilder;
 };
 
@@ -339,6 +375,7 @@ public:
   CurrencyBuilder& blocksFileName(const std::string& val) { m_currency.m_blocksFileName = val; return *this; }
   CurrencyBuilder& blocksCacheFileName(const std::string& val) { m_currency.m_blocksCacheFileName = val; return *this; }
   CurrencyBuilder& blockIndexesFileName(const std::string& val) { m_currency.m_blockIndexesFileName = val; return *this; }
+  CurrencyBuilder& blockStoreFileName(const std::string& val) { m_currency.m_blockStoreFileName = val; return *this; }
   CurrencyBuilder& txPoolFileName(const std::string& val) { m_currency.m_txPoolFileName = val; return *this; }
   CurrencyBuilder& blockchainIndicesFileName(const std::string& val) { m_currency.m_blockchainIndicesFileName = val; return *this; }
   
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <cstdint>
+
 namespace CryptoNote {
 
 class ICoreObserver {
@@ -24,6 +26,7 @@ public:
   virtual ~ICoreObserver() {};
   virtual void blockchainUpdated() {};
   virtual void poolUpdated() {};
+  virtual void blockchainRolledBack(uint32_t height) {};
 };
 
 }
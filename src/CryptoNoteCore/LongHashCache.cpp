@@ -0,0 +1,72 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "LongHashCache.h"
+
+namespace CryptoNote {
+
+LongHashCache::LongHashCache(size_t capacity) : m_capacity(capacity), m_hits(0), m_misses(0) {
+}
+
+bool LongHashCache::get(const Crypto::Hash& blockHash, Crypto::Hash& longHash) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_index.find(blockHash);
+  if (it == m_index.end()) {
+    ++m_misses;
+    return false;
+  }
+
+  m_entries.splice(m_entries.begin(), m_entries, it->second);
+  longHash = it->second->second;
+  ++m_hits;
+  return true;
+}
+
+bool LongHashCache::contains(const Crypto::Hash& blockHash) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_index.count(blockHash) > 0;
+}
+
+void LongHashCache::put(const Crypto::Hash& blockHash, const Crypto::Hash& longHash) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_index.find(blockHash);
+  if (it != m_index.end()) {
+    it->second->second = longHash;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return;
+  }
+
+  m_entries.emplace_front(blockHash, longHash);
+  m_index.emplace(blockHash, m_entries.begin());
+  if (m_entries.size() > m_capacity) {
+    m_index.erase(m_entries.back().first);
+    m_entries.pop_back();
+  }
+}
+
+void LongHashCache::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_index.clear();
+  m_entries.clear();
+}
+
+size_t LongHashCache::size() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_entries.size();
+}
+
+}
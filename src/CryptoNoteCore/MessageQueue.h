@@ -17,7 +17,7 @@
 
 #pragma once
 
-#include <queue>
+#include <deque>
 
 #include "IntrusiveLinkedList.h"
 
@@ -26,9 +26,19 @@
 
 namespace CryptoNote {
 
+// What push() does when the queue is full: wait in the dispatcher for the consumer, which
+// only suits producers running there, or let MessageType::coalesce() squash the queue.
+enum class MessageQueueOverflow {
+  BLOCK,
+  COALESCE
+};
+
 template<class MessageType> class MessageQueue {
 public:
-  MessageQueue(System::Dispatcher& dispatcher);
+  // a capacity of 0 doesn't bound the queue
+  static const size_t DEFAULT_CAPACITY = 1024;
+
+  MessageQueue(System::Dispatcher& dispatcher, size_t capacity = DEFAULT_CAPACITY, MessageQueueOverflow overflow = MessageQueueOverflow::COALESCE);
 
   const MessageType& front();
   void pop();
@@ -40,8 +50,11 @@ public:
   
 private:
   void wait();
-  std::queue<MessageType> messageQueue;
+  std::deque<MessageType> messageQueue;
   System::Event event;
+  System::Event spaceEvent;
+  const size_t capacity;
+  const MessageQueueOverflow overflow;
   bool stopped;
 
   typename IntrusiveLinkedList<MessageQueue<MessageType>>::hook hook;
@@ -66,7 +79,8 @@ private:
 };
 
 template<class MessageType>
-MessageQueue<MessageType>::MessageQueue(System::Dispatcher& dispatcher) : event(dispatcher), stopped(false) {}
+MessageQueue<MessageType>::MessageQueue(System::Dispatcher& dispatcher, size_t capacity, MessageQueueOverflow overflow) :
+  event(dispatcher), spaceEvent(dispatcher), capacity(capacity), overflow(overflow), stopped(false) {}
 
 template<class MessageType>
 void MessageQueue<MessageType>::wait() {
@@ -91,12 +105,31 @@ const MessageType& MessageQueue<MessageType>::front() {
 template<class MessageType>
 void MessageQueue<MessageType>::pop() {
   wait();
-  messageQueue.pop();
+  messageQueue.pop_front();
+  spaceEvent.set();
 }
 
 template<class MessageType>
 void MessageQueue<MessageType>::push(const MessageType& message) {
-  messageQueue.push(message);
+  if (capacity != 0 && messageQueue.size() >= capacity) {
+    if (overflow == MessageQueueOverflow::BLOCK) {
+      while (!stopped && messageQueue.size() >= capacity) {
+        spaceEvent.clear();
+        spaceEvent.wait();
+      }
+
+      if (stopped) {
+        return;
+      }
+    } else {
+      // the consumer may hold a reference to the front message
+      MessageType::coalesce(messageQueue, messageQueue.begin() + 1, message);
+      event.set();
+      return;
+    }
+  }
+
+  messageQueue.push_back(message);
   event.set();
 }
 
@@ -104,6 +137,7 @@ template<class MessageType>
 void MessageQueue<MessageType>::stop() {
   stopped = true;
   event.set();
+  spaceEvent.set();
 }
 
 template<class MessageType>
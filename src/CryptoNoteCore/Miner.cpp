@@ -32,7 +32,9 @@
 #include "crypto/crypto.h"
 #include "crypto/random.h"
 #include "Common/CommandLine.h"
+#include "Common/ScopeExit.h"
 #include "Common/StringTools.h"
+#include "Common/Util.h"
 #include "Serialization/SerializationTools.h"
 
 #include "CryptoNoteFormatUtils.h"
@@ -167,6 +169,7 @@ namespace CryptoNote
   }
 
   bool miner::init(const MinerConfig& config) {
+    m_cpus = config.miningCpus;
     if (!config.extraMessages.empty()) {
       std::string buff;
       if (!Common::loadFileToString(config.extraMessages, buff)) {
@@ -307,7 +310,16 @@ namespace CryptoNote
   //-----------------------------------------------------------------------------------------------------
   bool miner::worker_thread(uint32_t th_local_index)
   {
-    logger(INFO) << "Miner thread was started ["<< th_local_index << "]";
+    // Pin the thread before allocating the scratchpad so that its pages
+    // end up on the NUMA node of the CPU that will be hashing with it.
+    bool pinned = m_cpus.empty() ? Tools::setCurrentThreadAffinity(th_local_index) :
+      Tools::setCurrentThreadAffinity(std::vector<unsigned>{ m_cpus[th_local_index % m_cpus.size()] });
+    Crypto::slow_hash_allocate_state();
+    Tools::ScopeExit freeState([] { Crypto::slow_hash_free_state(); });
+
+    logger(INFO) << "Miner thread was started ["<< th_local_index << "], huge pages: "
+      << (Crypto::slow_hash_state_is_huge_page() ? "yes" : "no") << ", CPU affinity: " << (pinned ? "pinned" : "not set")
+      << ", hash kernel: " << Crypto::slow_hash_kernel_name(Crypto::slow_hash_kernel());
     uint32_t nonce = m_starter_nonce + th_local_index;
     difficulty_type local_diff = 0;
     uint32_t local_template_ver = 0;
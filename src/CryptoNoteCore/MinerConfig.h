@@ -19,6 +19,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include <boost/program_options.hpp>
 
@@ -34,6 +35,8 @@ public:
   std::string extraMessages;
   std::string startMining;
   uint32_t miningThreads;
+  // mining thread i runs on miningCpus[i % size], empty to spread over all CPUs
+  std::vector<unsigned> miningCpus;
 };
 
 } //namespace CryptoNote
@@ -0,0 +1,67 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "RingMemberCache.h"
+
+namespace CryptoNote {
+
+RingMemberCache::RingMemberCache(size_t capacity) : m_capacity(capacity), m_hits(0), m_misses(0) {
+}
+
+std::shared_ptr<const Crypto::RingMemberPrecomp> RingMemberCache::get(const Crypto::PublicKey& key) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+      m_entries.splice(m_entries.begin(), m_entries, it->second);
+      ++m_hits;
+      return it->second->second;
+    }
+  }
+
+  // the tables are built outside of the lock, two threads may build the same member once each
+  ++m_misses;
+  std::shared_ptr<Crypto::RingMemberPrecomp> precomp = std::make_shared<Crypto::RingMemberPrecomp>();
+  if (!Crypto::precompute_ring_member(key, *precomp)) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_index.count(key) == 0) {
+    m_entries.emplace_front(key, precomp);
+    m_index.emplace(key, m_entries.begin());
+    if (m_entries.size() > m_capacity) {
+      m_index.erase(m_entries.back().first);
+      m_entries.pop_back();
+    }
+  }
+
+  return precomp;
+}
+
+void RingMemberCache::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_index.clear();
+  m_entries.clear();
+}
+
+size_t RingMemberCache::size() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_entries.size();
+}
+
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "crypto/crypto.h"
+
+namespace CryptoNote {
+
+// Bounded least recently used map from an output key to its decompressed ring
+// member tables. Recent outputs are picked as decoys by many rings, so a block's
+// signatures share most of their members with earlier blocks and the pool.
+// Safe to use from several threads.
+class RingMemberCache {
+public:
+  explicit RingMemberCache(size_t capacity);
+
+  // builds the tables on a miss, returns nullptr if the key is not a curve point
+  std::shared_ptr<const Crypto::RingMemberPrecomp> get(const Crypto::PublicKey& key);
+  void clear();
+
+  size_t size() const;
+  uint64_t hits() const { return m_hits; }
+  uint64_t misses() const { return m_misses; }
+
+private:
+  typedef std::list<std::pair<Crypto::PublicKey, std::shared_ptr<const Crypto::RingMemberPrecomp>>> Entries;
+
+  const size_t m_capacity;
+  mutable std::mutex m_mutex;
+  Entries m_entries; // most recently used first
+  std::unordered_map<Crypto::PublicKey, Entries::iterator> m_index;
+  std::atomic<uint64_t> m_hits;
+  std::atomic<uint64_t> m_misses;
+};
+
+}
@@ -21,18 +21,20 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
-#include <list>
 #include <unordered_map>
 #include <string>
 #include <vector>
 #include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/binary_iarchive.hpp>
 
+#include "Common/ClockCache.h"
+
 template<class Key, class T> class SwappedMap {
 private:
   struct Descriptor {
     uint64_t offset;
     uint64_t index;
+    uint32_t size;
   };
 
 public:
@@ -86,7 +88,8 @@ public:
   ~SwappedMap();
   //SwappedMap& operator=(const SwappedMap&) = delete;
 
-  bool open(const std::string& itemFileName, const std::string& indexFileName, size_t poolSize);
+  // cacheSize is the budget for deserialized items, counted in serialized bytes
+  bool open(const std::string& itemFileName, const std::string& indexFileName, size_t cacheSize);
   void close();
 
   uint64_t size() const;
@@ -102,17 +105,11 @@ public:
 private:
   std::fstream m_itemsFile;
   std::fstream m_indexesFile;
-  size_t m_poolSize;
   std::unordered_map<Key, Descriptor> m_descriptors;
   uint64_t m_itemsFileSize;
-  std::unordered_map<Key, T> m_items;
-  std::list<Key> m_cache;
-  std::unordered_map<Key, typename std::list<Key>::iterator> m_cacheIterators;
-  uint64_t m_cacheHits;
-  uint64_t m_cacheMisses;
+  Common::ClockCache<Key, std::pair<const Key, T>> m_cache;
   uint64_t descriptorsCounter;
 
-  std::pair<const Key, T>* prepare(const Key& key);
   const std::pair<const Key, T>* load(const Key& key, uint64_t offset);
 };
 
@@ -123,8 +120,8 @@ template<class Key, class T> SwappedMap<Key, T>::~SwappedMap() {
   close();
 }
 
-template<class Key, class T> bool SwappedMap<Key, T>::open(const std::string& itemFileName, const std::string& indexFileName, size_t poolSize) {
-  if (poolSize == 0) {
+template<class Key, class T> bool SwappedMap<Key, T>::open(const std::string& itemFileName, const std::string& indexFileName, size_t cacheSize) {
+  if (cacheSize == 0) {
     return false;
   }
   descriptorsCounter = 0;
@@ -160,7 +157,7 @@ template<class Key, class T> bool SwappedMap<Key, T>::open(const std::string& it
       }
 
       if (valid) {
-        Descriptor descriptor = { itemsFileSize, i };
+        Descriptor descriptor = { itemsFileSize, i, itemSize };
         descriptors.insert(std::make_pair(key, descriptor));
       }
       descriptorsCounter++;
@@ -186,17 +183,14 @@ template<class Key, class T> bool SwappedMap<Key, T>::open(const std::string& it
     m_itemsFileSize = 0;
   }
 
-  m_poolSize = poolSize;
-  m_items.clear();
-  m_cache.clear();
-  m_cacheIterators.clear();
-  m_cacheHits = 0;
-  m_cacheMisses = 0;
+  m_cache.reset(cacheSize);
   return true;
 }
 
 template<class Key, class T> void SwappedMap<Key, T>::close() {
-  std::cout << "SwappedMap cache hits: " << m_cacheHits << ", misses: " << m_cacheMisses << " (" << std::fixed << std::setprecision(2) << static_cast<double>(m_cacheMisses) / (m_cacheHits + m_cacheMisses) * 100 << "%)" << std::endl;
+  uint64_t hits = m_cache.hits();
+  uint64_t misses = m_cache.misses();
+  std::cout << "SwappedMap cache hits: " << hits << ", misses: " << misses << " (" << std::fixed << std::setprecision(2) << static_cast<double>(misses) / (hits + misses) * 100 << "%)" << std::endl;
 }
 
 template<class Key, class T> uint64_t SwappedMap<Key, T>::size() const {
@@ -233,9 +227,7 @@ template<class Key, class T> void SwappedMap<Key, T>::clear() {
 
   m_descriptors.clear();
   m_itemsFileSize = 0;
-  m_items.clear();
   m_cache.clear();
-  m_cacheIterators.clear();
   descriptorsCounter = 0;
 }
 
@@ -252,13 +244,8 @@ template<class Key, class T> void SwappedMap<Key, T>::erase(const_iterator itera
     throw std::runtime_error("SwappedMap::erase");
   }
 
+  m_cache.erase(descriptorsIterator->first);
   m_descriptors.erase(descriptorsIterator);
-  auto cacheIteratorsIterator = m_cacheIterators.find(descriptorsIterator->first);
-  if (cacheIteratorsIterator != m_cacheIterators.end()) {
-    m_items.erase(descriptorsIterator->first);
-    m_cache.erase(cacheIteratorsIterator->second);
-    m_cacheIterators.erase(cacheIteratorsIterator);
-  }
 }
 
 template<class Key, class T> std::pair<typename SwappedMap<Key, T>::const_iterator, bool> SwappedMap<Key, T>::insert(const std::pair<const Key, T>& value) {
@@ -312,41 +299,21 @@ template<class Key, class T> std::pair<typename SwappedMap<Key, T>::const_iterat
 
   }
 
-  Descriptor descriptor = { m_itemsFileSize, descriptorsCounter };
+  uint32_t itemSize = static_cast<uint32_t>(itemsFileSize - m_itemsFileSize);
+  Descriptor descriptor = { m_itemsFileSize, descriptorsCounter, itemSize };
   auto descriptorsInsert = m_descriptors.insert(std::make_pair(value.first, descriptor));
   m_itemsFileSize = itemsFileSize;
 
   descriptorsCounter++;
 
-  T* newItem = &prepare(value.first)->second;
-  *newItem = value.second;
+  m_cache.insert(value.first, std::make_shared<std::pair<const Key, T>>(value), itemSize);
   return std::make_pair(const_iterator(this, descriptorsInsert.first), true);
 }
 
-template<class Key, class T> std::pair<const Key, T>* SwappedMap<Key, T>::prepare(const Key& key) {
-  if (m_items.size() == m_poolSize) {
-    typename std::list<Key>::iterator cacheIter = m_cache.begin();
-    m_items.erase(*cacheIter);
-    m_cacheIterators.erase(*cacheIter);
-    m_cache.erase(cacheIter);
-  }
-
-  std::pair<typename std::unordered_map<Key, T>::iterator, bool> itemInsert = m_items.insert(std::make_pair(key, T()));
-  typename std::list<Key>::iterator cacheIter = m_cache.insert(m_cache.end(), key);
-  m_cacheIterators.insert(std::make_pair(key, cacheIter));
-  return &*itemInsert.first;
-}
-
 template<class Key, class T> const std::pair<const Key, T>* SwappedMap<Key, T>::load(const Key& key, uint64_t offset) {
-  auto itemIterator = m_items.find(key);
-  if (itemIterator != m_items.end()) {
-    auto cacheIteratorsIterator = m_cacheIterators.find(key);
-    if (cacheIteratorsIterator->second != --m_cache.end()) {
-      m_cache.splice(m_cache.end(), m_cache, cacheIteratorsIterator->second);
-    }
-
-    ++m_cacheHits;
-    return &*itemIterator;
+  std::shared_ptr<std::pair<const Key, T>> item = m_cache.find(key);
+  if (item) {
+    return item.get();
   }
 
   typename std::unordered_map<Key, Descriptor>::iterator descriptorsIterator = m_descriptors.find(key);
@@ -367,8 +334,7 @@ template<class Key, class T> const std::pair<const Key, T>* SwappedMap<Key, T>::
     throw std::runtime_error("SwappedMap::load");
   }
 
-  std::pair<const Key, T>* item = prepare(key);
-  std::swap(tempItem, item->second);
-  ++m_cacheMisses;
-  return item;
+  item = std::make_shared<std::pair<const Key, T>>(key, std::move(tempItem));
+  m_cache.insert(key, item, descriptorsIterator->second.size);
+  return item.get();
 }
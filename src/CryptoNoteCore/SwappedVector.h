@@ -25,11 +25,12 @@
 #include <cstdio>
 #include <iomanip>
 #include <iostream>
-#include <list>
-#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "Common/ClockCache.h"
 #include "Common/StdInputStream.h"
 #include "Common/StdOutputStream.h"
 #include "Serialization/BinaryInputStreamSerializer.h"
@@ -151,14 +152,18 @@ public:
   ~SwappedVector();
   //SwappedVector& operator=(const SwappedVector&) = delete;
 
-  bool open(const std::string& itemFileName, const std::string& indexFileName, size_t poolSize);
+  // cacheSize is the budget for deserialized items, counted in serialized bytes
+  bool open(const std::string& itemFileName, const std::string& indexFileName, size_t cacheSize);
   void close();
 
   bool empty() const;
   uint64_t size() const;
   const_iterator begin();
   const_iterator end();
+  // The reference stays valid until the item is evicted from the cache,
+  // callers which share the vector between threads should use get()
   const T& operator[](uint64_t index);
+  std::shared_ptr<const T> get(uint64_t index);
   const T& front();
   const T& back();
   void clear();
@@ -166,45 +171,35 @@ public:
   void push_back(const T& item);
 
 private:
-  struct ItemEntry;
-  struct CacheEntry;
-
-  struct ItemEntry {
-  public:
-    T item;
-    typename std::list<CacheEntry>::iterator cacheIter;
-  };
-
-  struct CacheEntry {
-  public:
-    typename std::map<uint64_t, ItemEntry>::iterator itemIter;
-  };
+  // a sequential scan reads this many items, but at most an eighth of the cache, per file access
+  static const size_t READAHEAD_COUNT = 32;
 
   std::fstream m_itemsFile;
   std::fstream m_indexesFile;
-  size_t m_poolSize;
   std::vector<uint64_t> m_offsets;
   uint64_t m_itemsFileSize;
-  std::map<uint64_t, ItemEntry> m_items;
-  std::list<CacheEntry> m_cache;
-  uint64_t m_cacheHits;
-  uint64_t m_cacheMisses;
+  Common::ClockCache<uint64_t, T> m_cache;
+  Common::SequentialReads m_sequentialReads;
+  mutable std::mutex m_mutex;
 
-  T* prepare(uint64_t index);
+  uint64_t itemSize(uint64_t index) const;
+  std::shared_ptr<T> read();
 };
 
-template<class T> SwappedVector<T>::SwappedVector() {
+template<class T> SwappedVector<T>::SwappedVector() : m_itemsFileSize(0) {
 }
 
 template<class T> SwappedVector<T>::~SwappedVector() {
   close();
 }
 
-template<class T> bool SwappedVector<T>::open(const std::string& itemFileName, const std::string& indexFileName, size_t poolSize) {
-  if (poolSize == 0) {
+template<class T> bool SwappedVector<T>::open(const std::string& itemFileName, const std::string& indexFileName, size_t cacheSize) {
+  if (cacheSize == 0) {
     return false;
   }
 
+  std::lock_guard<std::mutex> lk(m_mutex);
+
   m_itemsFile.open(itemFileName, std::ios::in | std::ios::out | std::ios::binary);
   m_indexesFile.open(indexFileName, std::ios::in | std::ios::out | std::ios::binary);
   if (m_itemsFile && m_indexesFile) {
@@ -256,23 +251,24 @@ template<class T> bool SwappedVector<T>::open(const std::string& itemFileName, c
     m_itemsFileSize = 0;
   }
 
-  m_poolSize = poolSize;
-  m_items.clear();
-  m_cache.clear();
-  m_cacheHits = 0;
-  m_cacheMisses = 0;
+  m_cache.reset(cacheSize);
+  m_sequentialReads.reset();
   return true;
 }
 
 template<class T> void SwappedVector<T>::close() {
-  std::cout << "SwappedVector cache hits: " << m_cacheHits << ", misses: " << m_cacheMisses << " (" << std::fixed << std::setprecision(2) << static_cast<double>(m_cacheMisses) / (m_cacheHits + m_cacheMisses) * 100 << "%)" << std::endl;
+  uint64_t hits = m_cache.hits();
+  uint64_t misses = m_cache.misses();
+  std::cout << "SwappedVector cache hits: " << hits << ", misses: " << misses << " (" << std::fixed << std::setprecision(2) << static_cast<double>(misses) / (hits + misses) * 100 << "%)" << std::endl;
 }
 
 template<class T> bool SwappedVector<T>::empty() const {
+  std::lock_guard<std::mutex> lk(m_mutex);
   return m_offsets.empty();
 }
 
 template<class T> uint64_t SwappedVector<T>::size() const {
+  std::lock_guard<std::mutex> lk(m_mutex);
   return m_offsets.size();
 }
 
@@ -281,18 +277,26 @@ template<class T> typename SwappedVector<T>::const_iterator SwappedVector<T>::be
 }
 
 template<class T> typename SwappedVector<T>::const_iterator SwappedVector<T>::end() {
-  return const_iterator(this, m_offsets.size());
+  return const_iterator(this, size());
 }
 
 template<class T> const T& SwappedVector<T>::operator[](uint64_t index) {
-  auto itemIter = m_items.find(index);
-  if (itemIter != m_items.end()) {
-    if (itemIter->second.cacheIter != --m_cache.end()) {
-      m_cache.splice(m_cache.end(), m_cache, itemIter->second.cacheIter);
-    }
+  return *get(index);
+}
 
-    ++m_cacheHits;
-    return itemIter->second.item;
+template<class T> std::shared_ptr<const T> SwappedVector<T>::get(uint64_t index) {
+  std::shared_ptr<T> item = m_cache.find(index);
+  if (item) {
+    return item;
+  }
+
+  std::lock_guard<std::mutex> lk(m_mutex);
+  if (m_cache.contains(index)) {
+    // read ahead or loaded by another thread meanwhile
+    item = m_cache.find(index);
+    if (item) {
+      return item;
+    }
   }
 
   if (index >= m_offsets.size()) {
@@ -304,16 +308,25 @@ template<class T> const T& SwappedVector<T>::operator[](uint64_t index) {
   }
 
   m_itemsFile.seekg(m_offsets[index]);
-  T tempItem;
-  
-  Common::StdInputStream stream(m_itemsFile);
-  CryptoNote::BinaryInputStreamSerializer archive(stream);
-  serialize(tempItem, archive);
+  item = read();
+
+  // items of a scan are inserted unreferenced, they are the first to be evicted
+  bool sequential = m_sequentialReads.miss(index);
+  m_cache.insert(index, item, static_cast<size_t>(itemSize(index)), !sequential);
+  if (sequential) {
+    // items are stored back to back, the file is positioned at the next one
+    uint64_t next = index + 1;
+    size_t budget = m_cache.capacity() / 8;
+    while (next < m_offsets.size() && next - index <= READAHEAD_COUNT && itemSize(next) <= budget && !m_cache.contains(next)) {
+      budget -= static_cast<size_t>(itemSize(next));
+      m_cache.insert(next, read(), static_cast<size_t>(itemSize(next)), false);
+      ++next;
+    }
+
+    m_sequentialReads.readAhead(next);
+  }
 
-  T* item = prepare(index);
-  std::swap(tempItem, *item);
-  ++m_cacheMisses;
-  return *item;
+  return item;
 }
 
 template<class T> const T& SwappedVector<T>::front() {
@@ -321,10 +334,11 @@ template<class T> const T& SwappedVector<T>::front() {
 }
 
 template<class T> const T& SwappedVector<T>::back() {
-  return operator[](m_offsets.size() - 1);
+  return operator[](size() - 1);
 }
 
 template<class T> void SwappedVector<T>::clear() {
+  std::lock_guard<std::mutex> lk(m_mutex);
   if (!m_indexesFile) {
     throw std::runtime_error("SwappedVector::clear");
   }
@@ -338,11 +352,11 @@ template<class T> void SwappedVector<T>::clear() {
 
   m_offsets.clear();
   m_itemsFileSize = 0;
-  m_items.clear();
   m_cache.clear();
 }
 
 template<class T> void SwappedVector<T>::pop_back() {
+  std::lock_guard<std::mutex> lk(m_mutex);
   if (!m_indexesFile) {
     throw std::runtime_error("SwappedVector::pop_back");
   }
@@ -356,14 +370,11 @@ template<class T> void SwappedVector<T>::pop_back() {
 
   m_itemsFileSize = m_offsets.back();
   m_offsets.pop_back();
-  auto itemIter = m_items.find(m_offsets.size());
-  if (itemIter != m_items.end()) {
-    m_cache.erase(itemIter->second.cacheIter);
-    m_items.erase(itemIter);
-  }
+  m_cache.erase(m_offsets.size());
 }
 
 template<class T> void SwappedVector<T>::push_back(const T& item) {
+  std::lock_guard<std::mutex> lk(m_mutex);
   uint64_t itemsFileSize;
 
   {
@@ -403,20 +414,19 @@ template<class T> void SwappedVector<T>::push_back(const T& item) {
   m_offsets.push_back(m_itemsFileSize);
   m_itemsFileSize = itemsFileSize;
 
-  T* newItem = prepare(m_offsets.size() - 1);
-  *newItem = item;
+  m_cache.insert(m_offsets.size() - 1, std::make_shared<T>(item), static_cast<size_t>(itemSize(m_offsets.size() - 1)));
 }
 
-template<class T> T* SwappedVector<T>::prepare(uint64_t index) {
-  if (m_items.size() == m_poolSize) {
-    auto cacheIter = m_cache.begin();
-    m_items.erase(cacheIter->itemIter);
-    m_cache.erase(cacheIter);
-  }
+// Precondition: m_mutex is locked.
+template<class T> uint64_t SwappedVector<T>::itemSize(uint64_t index) const {
+  return (index + 1 < m_offsets.size() ? m_offsets[index + 1] : m_itemsFileSize) - m_offsets[index];
+}
 
-  auto itemIter = m_items.insert(std::make_pair(index, ItemEntry()));
-  CacheEntry cacheEntry = { itemIter.first };
-  auto cacheIter = m_cache.insert(m_cache.end(), cacheEntry);
-  itemIter.first->second.cacheIter = cacheIter;
-  return &itemIter.first->second.item;
+// Precondition: m_mutex is locked, the file is positioned at an item.
+template<class T> std::shared_ptr<T> SwappedVector<T>::read() {
+  std::shared_ptr<T> item = std::make_shared<T>();
+  Common::StdInputStream stream(m_itemsFile);
+  CryptoNote::BinaryInputStreamSerializer archive(stream);
+  serialize(*item, archive);
+  return item;
 }
@@ -20,6 +20,8 @@
 #include "TransactionUtils.h"
 
 #include "Account.h"
+#include "Common/ParallelFor.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "CryptoNoteConfig.h"
 
@@ -104,6 +106,7 @@ namespace CryptoNote {
     virtual size_t addInput(const KeyInput& input) override;
     virtual size_t addInput(const MultisignatureInput& input) override;
     virtual size_t addInput(const AccountKeys& senderKeys, const TransactionTypes::InputKeyInfo& info, KeyPair& ephKeys) override;
+    virtual size_t addInputs(const std::vector<TransactionTypes::KeyInputSource>& inputs) override;
 
     virtual size_t addOutput(uint64_t amount, const AccountPublicAddress& to) override;
     virtual size_t addOutput(uint64_t amount, const std::vector<AccountPublicAddress>& to, uint32_t requiredSignatures) override;
@@ -111,6 +114,7 @@ namespace CryptoNote {
     virtual size_t addOutput(uint64_t amount, const MultisignatureOutput& out) override;
 
     virtual void signInputKey(size_t input, const TransactionTypes::InputKeyInfo& info, const KeyPair& ephKeys) override;
+    virtual void signInputKeys(size_t firstInput, const std::vector<TransactionTypes::KeyInputSource>& inputs) override;
     virtual void signInputMultisignature(size_t input, const PublicKey& sourceTransactionKey, size_t outputIndex, const AccountKeys& accountKeys) override;
     virtual void signInputMultisignature(size_t input, const KeyPair& ephemeralKeys) override;
 
@@ -122,7 +126,11 @@ namespace CryptoNote {
   private:
 
     void invalidateHash();
+    void invalidateSignedHash();
 
+    static KeyInput makeKeyInput(const AccountKeys& senderKeys, const TransactionTypes::InputKeyInfo& info, KeyPair& ephKeys);
+    static std::vector<Signature> makeRingSignature(const Hash& prefixHash, const KeyInput& input, const TransactionTypes::InputKeyInfo& info,
+      const KeyPair& ephKeys);
     std::vector<Signature>& getSignatures(size_t input);
 
     const SecretKey& txSecretKey() const {
@@ -141,7 +149,9 @@ namespace CryptoNote {
     CryptoNote::Transaction transaction;
     boost::optional<SecretKey> secretKey;
     mutable boost::optional<Hash> transactionHash;
-    TransactionExtra extra;
+    mutable boost::optional<Hash> transactionPrefixHash;
+    mutable boost::optional<Hash> transactionInputsHash;
+    TransactionExtraScan extraScan; // points into transaction.extra
   };
 
 
@@ -164,12 +174,14 @@ namespace CryptoNote {
   TransactionImpl::TransactionImpl() {
     CryptoNote::KeyPair txKeys(CryptoNote::generateKeyPair());
 
+    TransactionExtra extra;
     TransactionExtraPublicKey pk = { txKeys.publicKey };
     extra.set(pk);
 
     transaction.version = CURRENT_TRANSACTION_VERSION;
     transaction.unlockTime = 0;
     transaction.extra = extra.serialize();
+    scanTransactionExtra(transaction.extra, extraScan);
 
     secretKey = txKeys.secretKey;
   }
@@ -179,39 +191,70 @@ namespace CryptoNote {
       throw std::runtime_error("Invalid transaction data");
     }
 
-    extra.parse(transaction.extra);
-    transactionHash = getBinaryArrayHash(ba); // avoid serialization if we already have blob
+    scanTransactionExtra(transaction.extra, extraScan);
+    // avoid serialization if we already have blob
+    transactionHash = getBinaryArrayHash(ba);
+    transactionPrefixHash = CryptoNote::getTransactionPrefixHash(transaction, ba);
   }
 
   TransactionImpl::TransactionImpl(const CryptoNote::Transaction& tx) : transaction(tx) {
-    extra.parse(transaction.extra);
+    scanTransactionExtra(transaction.extra, extraScan);
   }
 
   void TransactionImpl::invalidateHash() {
     if (transactionHash.is_initialized()) {
       transactionHash = decltype(transactionHash)();
     }
+
+    if (transactionPrefixHash.is_initialized()) {
+      transactionPrefixHash = decltype(transactionPrefixHash)();
+    }
+
+    if (transactionInputsHash.is_initialized()) {
+      transactionInputsHash = decltype(transactionInputsHash)();
+    }
+  }
+
+  // signatures are not part of the prefix, so only the full hash changes
+  void TransactionImpl::invalidateSignedHash() {
+    if (transactionHash.is_initialized()) {
+      transactionHash = decltype(transactionHash)();
+    }
   }
 
   Hash TransactionImpl::getTransactionHash() const {
     if (!transactionHash.is_initialized()) {
-      transactionHash = getObjectHash(transaction);
+      BinaryArray ba;
+      if (toBinaryArray(transaction, ba)) {
+        transactionHash = getBinaryArrayHash(ba);
+        transactionPrefixHash = CryptoNote::getTransactionPrefixHash(transaction, ba);
+      } else {
+        transactionHash = NULL_HASH;
+      }
     }
 
     return transactionHash.get();
   }
 
   Hash TransactionImpl::getTransactionPrefixHash() const {
-    return getObjectHash(*static_cast<const TransactionPrefix*>(&transaction));
+    if (!transactionPrefixHash.is_initialized()) {
+      transactionPrefixHash = getObjectHash(*static_cast<const TransactionPrefix*>(&transaction));
+    }
+
+    return transactionPrefixHash.get();
   }
 
   Hash TransactionImpl::getTransactionInputsHash() const {
-    return getObjectHash(transaction.inputs);
+    if (!transactionInputsHash.is_initialized()) {
+      transactionInputsHash = getObjectHash(transaction.inputs);
+    }
+
+    return transactionInputsHash.get();
   }
 
   PublicKey TransactionImpl::getTransactionPublicKey() const {
     PublicKey pk(NULL_PUBLIC_KEY);
-    extra.getPublicKey(pk);
+    extraScan.getPublicKey(pk);
     return pk;
   }
 
@@ -239,7 +282,7 @@ namespace CryptoNote {
     PublicKey txPubKey;
 
     secret_key_to_public_key(sk, pk);
-    extra.getPublicKey(txPubKey);
+    extraScan.getPublicKey(txPubKey);
 
     if (txPubKey != pk) {
       throw std::runtime_error("Secret transaction key does not match public key");
@@ -257,6 +300,27 @@ namespace CryptoNote {
 
   size_t TransactionImpl::addInput(const AccountKeys& senderKeys, const TransactionTypes::InputKeyInfo& info, KeyPair& ephKeys) {
     checkIfSigning();
+    return addInput(makeKeyInput(senderKeys, info, ephKeys));
+  }
+
+  size_t TransactionImpl::addInputs(const std::vector<TransactionTypes::KeyInputSource>& inputs) {
+    checkIfSigning();
+
+    std::vector<KeyInput> keyInputs(inputs.size());
+    Common::parallelFor(inputs.size(), [&inputs, &keyInputs](size_t i) {
+      keyInputs[i] = makeKeyInput(inputs[i].senderKeys, *inputs[i].info, *inputs[i].ephKeys);
+    });
+
+    size_t firstInput = transaction.inputs.size();
+    for (auto& input : keyInputs) {
+      transaction.inputs.emplace_back(std::move(input));
+    }
+
+    invalidateHash();
+    return firstInput;
+  }
+
+  KeyInput TransactionImpl::makeKeyInput(const AccountKeys& senderKeys, const TransactionTypes::InputKeyInfo& info, KeyPair& ephKeys) {
     KeyInput input;
     input.amount = info.amount;
 
@@ -273,7 +337,7 @@ namespace CryptoNote {
     }
 
     input.outputIndexes = absolute_output_offsets_to_relative(input.outputIndexes);
-    return addInput(input);
+    return input;
   }
 
   size_t TransactionImpl::addInput(const MultisignatureInput& input) {
@@ -335,8 +399,32 @@ namespace CryptoNote {
 
   void TransactionImpl::signInputKey(size_t index, const TransactionTypes::InputKeyInfo& info, const KeyPair& ephKeys) {
     const auto& input = boost::get<KeyInput>(getInputChecked(transaction, index, TransactionTypes::InputType::Key));
+    getSignatures(index) = makeRingSignature(getTransactionPrefixHash(), input, info, ephKeys);
+    invalidateSignedHash();
+  }
+
+  void TransactionImpl::signInputKeys(size_t firstInput, const std::vector<TransactionTypes::KeyInputSource>& inputs) {
     Hash prefixHash = getTransactionPrefixHash();
 
+    std::vector<const KeyInput*> keyInputs;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      keyInputs.push_back(&boost::get<KeyInput>(getInputChecked(transaction, firstInput + i, TransactionTypes::InputType::Key)));
+    }
+
+    std::vector<std::vector<Signature>> signatures(inputs.size());
+    Common::parallelFor(inputs.size(), [&](size_t i) {
+      signatures[i] = makeRingSignature(prefixHash, *keyInputs[i], *inputs[i].info, *inputs[i].ephKeys);
+    });
+
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      getSignatures(firstInput + i) = std::move(signatures[i]);
+    }
+
+    invalidateSignedHash();
+  }
+
+  std::vector<Signature> TransactionImpl::makeRingSignature(const Hash& prefixHash, const KeyInput& input,
+    const TransactionTypes::InputKeyInfo& info, const KeyPair& ephKeys) {
     std::vector<Signature> signatures;
     std::vector<const PublicKey*> keysPtrs;
 
@@ -354,8 +442,7 @@ namespace CryptoNote {
       info.realOutput.transactionIndex,
       signatures.data());
 
-    getSignatures(index) = signatures;
-    invalidateHash();
+    return signatures;
   }
 
   void TransactionImpl::signInputMultisignature(size_t index, const PublicKey& sourceTransactionKey, size_t outputIndex, const AccountKeys& accountKeys) {
@@ -380,7 +467,7 @@ namespace CryptoNote {
       ephemeralPublicKey, ephemeralSecretKey, signature);
 
     getSignatures(index).push_back(signature);
-    invalidateHash();
+    invalidateSignedHash();
   }
 
   void TransactionImpl::signInputMultisignature(size_t index, const KeyPair& ephemeralKeys) {
@@ -390,7 +477,7 @@ namespace CryptoNote {
     generate_signature(txPrefixHash, ephemeralKeys.publicKey, ephemeralKeys.secretKey, signature);
 
     getSignatures(index).push_back(signature);
-    invalidateHash();
+    invalidateSignedHash();
   }
 
   std::vector<Signature>& TransactionImpl::getSignatures(size_t input) {
@@ -422,22 +509,16 @@ namespace CryptoNote {
   }
 
   bool TransactionImpl::getPaymentId(Hash& hash) const {
-    BinaryArray nonce;
-    if (getExtraNonce(nonce)) {
-      Hash paymentId;
-      if (getPaymentIdFromTransactionExtraNonce(nonce, paymentId)) {
-        hash = reinterpret_cast<const Hash&>(paymentId);
-        return true;
-      }
-    }
-    return false;
+    return extraScan.getPaymentId(hash);
   }
 
   void TransactionImpl::setExtraNonce(const BinaryArray& nonce) {
     checkIfSigning();
     TransactionExtraNonce extraNonce = { nonce };
+    TransactionExtra extra(transaction.extra);
     extra.set(extraNonce);
     transaction.extra = extra.serialize();
+    scanTransactionExtra(transaction.extra, extraScan);
     invalidateHash();
   }
 
@@ -445,15 +526,12 @@ namespace CryptoNote {
     checkIfSigning();
     transaction.extra.insert(
       transaction.extra.end(), extraData.begin(), extraData.end());
+    scanTransactionExtra(transaction.extra, extraScan);
+    invalidateHash();
   }
 
   bool TransactionImpl::getExtraNonce(BinaryArray& nonce) const {
-    TransactionExtraNonce extraNonce;
-    if (extra.get(extraNonce)) {
-      nonce = extraNonce.nonce;
-      return true;
-    }
-    return false;
+    return extraScan.getExtraNonce(nonce);
   }
 
   BinaryArray TransactionImpl::getExtra() const {
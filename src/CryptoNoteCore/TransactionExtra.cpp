@@ -95,6 +95,152 @@ bool parseTransactionExtra(const std::vector<uint8_t> &transactionExtra, std::ve
   return true;
 }
 
+namespace {
+
+bool readExtraVarint(const uint8_t*& it, const uint8_t* end, uint64_t& value) {
+  value = 0;
+  for (uint8_t shift = 0;; shift += 7) {
+    if (it == end) {
+      return false;
+    }
+
+    uint8_t piece = *it++;
+    if (shift >= sizeof(value) * 8 - 7 && piece >= 1 << (sizeof(value) * 8 - shift)) {
+      return false; // value overflow
+    }
+
+    value |= static_cast<uint64_t>(piece & 0x7f) << shift;
+    if ((piece & 0x80) == 0) {
+      return piece != 0 || shift == 0; // reject non-canonical representation
+    }
+  }
+}
+
+}
+
+bool scanTransactionExtra(const uint8_t* data, size_t size, TransactionExtraScan& scan) {
+  scan = TransactionExtraScan();
+
+  const uint8_t* it = data;
+  const uint8_t* end = data + size;
+  while (it != end) {
+    switch (*it++) {
+    case TX_EXTRA_TAG_PADDING: {
+      // padding always runs to the end of extra
+      if (end - it >= TX_EXTRA_PADDING_MAX_COUNT) {
+        return false;
+      }
+
+      if (std::find_if(it, end, [](uint8_t b) { return b != 0; }) != end) {
+        return false;
+      }
+
+      it = end;
+      break;
+    }
+
+    case TX_EXTRA_TAG_PUBKEY: {
+      if (static_cast<size_t>(end - it) < sizeof(PublicKey)) {
+        return false;
+      }
+
+      if (scan.publicKey == nullptr) {
+        scan.publicKey = reinterpret_cast<const PublicKey*>(it);
+      }
+
+      it += sizeof(PublicKey);
+      break;
+    }
+
+    case TX_EXTRA_NONCE: {
+      if (it == end) {
+        return false;
+      }
+
+      size_t nonceSize = *it++;
+      if (static_cast<size_t>(end - it) < nonceSize) {
+        return false;
+      }
+
+      if (scan.nonce == nullptr) {
+        scan.nonce = it;
+        scan.nonceSize = nonceSize;
+      }
+
+      it += nonceSize;
+      break;
+    }
+
+    case TX_EXTRA_MERGE_MINING_TAG: {
+      uint64_t fieldSize;
+      if (!readExtraVarint(it, end, fieldSize) || fieldSize > static_cast<uint64_t>(end - it)) {
+        return false;
+      }
+
+      const uint8_t* field = it;
+      uint64_t depth;
+      if (!readExtraVarint(it, field + fieldSize, depth) || static_cast<size_t>(field + fieldSize - it) < sizeof(Hash)) {
+        return false;
+      }
+
+      if (scan.mergeMiningTag == nullptr) {
+        scan.mergeMiningTag = field;
+        scan.mergeMiningTagSize = static_cast<size_t>(fieldSize);
+      }
+
+      it = field + fieldSize;
+      break;
+    }
+    }
+  }
+
+  return true;
+}
+
+bool scanTransactionExtra(const std::vector<uint8_t>& tx_extra, TransactionExtraScan& scan) {
+  return scanTransactionExtra(tx_extra.data(), tx_extra.size(), scan);
+}
+
+bool TransactionExtraScan::getPublicKey(PublicKey& key) const {
+  if (publicKey == nullptr) {
+    return false;
+  }
+
+  key = *publicKey;
+  return true;
+}
+
+bool TransactionExtraScan::getExtraNonce(BinaryArray& extraNonce) const {
+  if (nonce == nullptr) {
+    return false;
+  }
+
+  extraNonce.assign(nonce, nonce + nonceSize);
+  return true;
+}
+
+bool TransactionExtraScan::getPaymentId(Hash& paymentId) const {
+  if (nonce == nullptr || nonceSize != sizeof(Hash) + 1 || nonce[0] != TX_EXTRA_NONCE_PAYMENT_ID) {
+    return false;
+  }
+
+  memcpy(&paymentId, nonce + 1, sizeof(Hash));
+  return true;
+}
+
+bool TransactionExtraScan::getMergeMiningTag(TransactionExtraMergeMiningTag& mmTag) const {
+  if (mergeMiningTag == nullptr) {
+    return false;
+  }
+
+  const uint8_t* it = mergeMiningTag;
+  uint64_t depth;
+  readExtraVarint(it, mergeMiningTag + mergeMiningTagSize, depth);
+  mmTag.depth = static_cast<size_t>(depth);
+  memcpy(&mmTag.merkleRoot, it, sizeof(Hash));
+  return true;
+}
+
 struct ExtraSerializerVisitor : public boost::static_visitor<bool> {
   std::vector<uint8_t>& extra;
 
@@ -135,14 +281,12 @@ bool writeTransactionExtra(std::vector<uint8_t>& tx_extra, const std::vector<Tra
 }
 
 PublicKey getTransactionPublicKeyFromExtra(const std::vector<uint8_t>& tx_extra) {
-  std::vector<TransactionExtraField> tx_extra_fields;
-  parseTransactionExtra(tx_extra, tx_extra_fields);
-
-  TransactionExtraPublicKey pub_key_field;
-  if (!findTransactionExtraFieldByType(tx_extra_fields, pub_key_field))
-    return boost::value_initialized<PublicKey>();
+  TransactionExtraScan scan;
+  scanTransactionExtra(tx_extra, scan);
 
-  return pub_key_field.publicKey;
+  PublicKey publicKey = boost::value_initialized<PublicKey>();
+  scan.getPublicKey(publicKey);
+  return publicKey;
 }
 
 bool addTransactionPublicKeyToExtra(std::vector<uint8_t>& tx_extra, const PublicKey& tx_pub_key) {
@@ -183,10 +327,10 @@ bool appendMergeMiningTagToExtra(std::vector<uint8_t>& tx_extra, const Transacti
 }
 
 bool getMergeMiningTagFromExtra(const std::vector<uint8_t>& tx_extra, TransactionExtraMergeMiningTag& mm_tag) {
-  std::vector<TransactionExtraField> tx_extra_fields;
-  parseTransactionExtra(tx_extra, tx_extra_fields);
+  TransactionExtraScan scan;
+  scanTransactionExtra(tx_extra, scan);
 
-  return findTransactionExtraFieldByType(tx_extra_fields, mm_tag);
+  return scan.getMergeMiningTag(mm_tag);
 }
 
 void setPaymentIdToTransactionExtraNonce(std::vector<uint8_t>& extra_nonce, const Hash& payment_id) {
@@ -227,21 +371,12 @@ bool createTxExtraWithPaymentId(const std::string& paymentIdString, std::vector<
 }
 
 bool getPaymentIdFromTxExtra(const std::vector<uint8_t>& extra, Hash& paymentId) {
-  std::vector<TransactionExtraField> tx_extra_fields;
-  if (!parseTransactionExtra(extra, tx_extra_fields)) {
+  TransactionExtraScan scan;
+  if (!scanTransactionExtra(extra, scan)) {
     return false;
   }
 
-  TransactionExtraNonce extra_nonce;
-  if (findTransactionExtraFieldByType(tx_extra_fields, extra_nonce)) {
-    if (!getPaymentIdFromTransactionExtraNonce(extra_nonce.nonce, paymentId)) {
-      return false;
-    }
-  } else {
-    return false;
-  }
-
-  return true;
+  return scan.getPaymentId(paymentId);
 }
 
 
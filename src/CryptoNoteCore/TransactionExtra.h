@@ -73,6 +73,27 @@ bool findTransactionExtraFieldByType(const std::vector<TransactionExtraField>& t
   return true;
 }
 
+// Locations of the first public key, nonce and merge mining tag of a raw
+// tx_extra, found in one pass without copying anything. The pointers refer to
+// the scanned buffer, so the scan is only valid while that buffer is unchanged.
+struct TransactionExtraScan {
+  const Crypto::PublicKey* publicKey;
+  const uint8_t* nonce;
+  size_t nonceSize;
+  const uint8_t* mergeMiningTag; // serialized tag body: varint depth, merkle root
+  size_t mergeMiningTagSize;
+
+  bool getPublicKey(Crypto::PublicKey& publicKey) const;
+  bool getExtraNonce(BinaryArray& nonce) const;
+  bool getPaymentId(Crypto::Hash& paymentId) const;
+  bool getMergeMiningTag(TransactionExtraMergeMiningTag& mmTag) const;
+};
+
+// Accepts exactly what parseTransactionExtra accepts. Fields found before a
+// malformed one are still reported when false is returned.
+bool scanTransactionExtra(const uint8_t* data, size_t size, TransactionExtraScan& scan);
+bool scanTransactionExtra(const std::vector<uint8_t>& tx_extra, TransactionExtraScan& scan);
+
 bool parseTransactionExtra(const std::vector<uint8_t>& tx_extra, std::vector<TransactionExtraField>& tx_extra_fields);
 bool writeTransactionExtra(std::vector<uint8_t>& tx_extra, const std::vector<TransactionExtraField>& tx_extra_fields);
 
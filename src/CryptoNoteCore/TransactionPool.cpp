@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <ctime>
+#include <fstream>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
@@ -27,6 +28,8 @@
 #include <boost/filesystem.hpp>
 
 #include "Common/int-util.h"
+#include "Common/Metrics.h"
+#include "Common/Tracing.h"
 #include "Common/Util.h"
 #include "crypto/hash.h"
 
@@ -99,7 +102,14 @@ namespace CryptoNote {
 
   using CryptoNote::BlockInfo;
 
-  std::unordered_set<Crypto::Hash> m_validated_transactions;
+  const size_t POOL_CHANGELOG_MAX_SIZE = 10000;
+
+  // journal records are a type byte, a 32-bit little endian payload size and the payload
+  const char POOL_JOURNAL_ADD = 'a';
+  const char POOL_JOURNAL_REMOVE = 'r';
+  const uint32_t POOL_JOURNAL_MAX_RECORD_SIZE = 16 * 1024 * 1024;
+  // the journal is folded into the pool snapshot once it grows past this size
+  const uint64_t POOL_JOURNAL_COMPACTION_SIZE = 64 * 1024 * 1024;
 
   //---------------------------------------------------------------------------------
   tx_memory_pool::tx_memory_pool(
@@ -115,19 +125,39 @@ namespace CryptoNote {
     m_timeProvider(timeProvider), 
     m_txCheckInterval(60, timeProvider),
     m_fee_index(boost::get<1>(m_transactions)),
+    m_receiveTimeIndex(boost::get<2>(m_transactions)),
     logger(log, "txpool"),
     m_paymentIdIndex(blockchainIndexesEnabled),
-    m_timestampIndex(blockchainIndexesEnabled) {
+    m_timestampIndex(blockchainIndexesEnabled),
+    m_templateCandidatesOutdated(true),
+    m_modificationCounter(0),
+    m_totalSize(0),
+    m_maxSize(0),
+    m_evictedCount(0),
+    m_journalSize(0),
+    m_indicesOutdated(false),
+    m_admittedCount(0) {
+    for (auto& count : m_rejectedCounts) {
+      count = 0;
+    }
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::add_tx(const Transaction &tx, /*const Crypto::Hash& tx_prefix_hash,*/ const Crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool keptByBlock) {
+    return add_tx(tx, id, blobSize, tvc, keptByBlock, nullptr);
+  }
+
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::add_tx(const Transaction &tx, const Crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, const BlockInfo* checkedMaxUsedBlock) {
+    Common::TraceSpan span("pool", "add_tx", id);
     if (!check_inputs_types_supported(tx)) {
+      ++m_rejectedCounts[REJECT_UNSUPPORTED_INPUTS];
       tvc.m_verification_failed = true;
       return false;
     }
 
     uint64_t inputs_amount = 0;
     if (!get_inputs_money_amount(tx, inputs_amount)) {
+      ++m_rejectedCounts[REJECT_INVALID_AMOUNTS];
       tvc.m_verification_failed = true;
       return false;
     }
@@ -137,6 +167,7 @@ namespace CryptoNote {
     if (outputs_amount > inputs_amount) {
       logger(INFO) << "transaction use more money then it has: use " << m_currency.formatAmount(outputs_amount) <<
         ", have " << m_currency.formatAmount(inputs_amount);
+      ++m_rejectedCounts[REJECT_INVALID_AMOUNTS];
       tvc.m_verification_failed = true;
       return false;
     }
@@ -149,6 +180,7 @@ namespace CryptoNote {
       std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
       if (haveSpentInputs(tx)) {
         logger(INFO) << "Transaction with id= " << id << " used already spent inputs";
+        ++m_rejectedCounts[REJECT_SPENT_INPUTS];
         tvc.m_verification_failed = true;
         return false;
       }
@@ -156,12 +188,18 @@ namespace CryptoNote {
 
     BlockInfo maxUsedBlock;
 
-    // check inputs
-    bool inputsValid = m_validator.checkTransactionInputs(tx, maxUsedBlock);
+    // check inputs, unless the caller has already done it against the current tail
+    bool inputsValid = true;
+    if (checkedMaxUsedBlock != nullptr) {
+      maxUsedBlock = *checkedMaxUsedBlock;
+    } else {
+      inputsValid = m_validator.checkTransactionInputs(tx, maxUsedBlock);
+    }
 
     if (!inputsValid) {
       if (!keptByBlock) {
         logger(INFO) << "tx used wrong inputs, rejected";
+        ++m_rejectedCounts[REJECT_INVALID_INPUTS];
         tvc.m_verification_failed = true;
         return false;
       }
@@ -174,6 +212,7 @@ namespace CryptoNote {
       bool sizeValid = m_validator.checkTransactionSize(blobSize);
       if (!sizeValid) {
         logger(INFO) << "tx too big, rejected";
+        ++m_rejectedCounts[REJECT_TOO_BIG];
         tvc.m_verification_failed = true;
         return false;
       }
@@ -183,6 +222,7 @@ namespace CryptoNote {
 
     if (!keptByBlock && m_recentlyDeletedTransactions.find(id) != m_recentlyDeletedTransactions.end()) {
       logger(INFO) << "Trying to add recently deleted transaction. Ignore: " << id;
+      ++m_rejectedCounts[REJECT_RECENTLY_DELETED];
       tvc.m_verification_failed = false;
       tvc.m_should_be_relayed = false;
       tvc.m_added_to_pool = false;
@@ -199,6 +239,7 @@ namespace CryptoNote {
       txd.fee = fee;
       txd.keptByBlock = keptByBlock;
       txd.receiveTime = m_timeProvider.now();
+      txd.fusion = isFusionTransaction;
 
       txd.maxUsedBlock = maxUsedBlock;
       txd.lastFailedBlock.clear();
@@ -206,20 +247,47 @@ namespace CryptoNote {
       auto txd_p = m_transactions.insert(txd);
       if (!(txd_p.second)) {
         logger(ERROR, BRIGHT_RED) << "transaction already exists at inserting in memory pool";
+        ++m_rejectedCounts[REJECT_DUPLICATE];
         return false;
       }
-      m_paymentIdIndex.add(tx);
-      m_timestampIndex.add(txd.receiveTime, txd.id);
+      recordChange(id, true);
+      journalAdd(txd);
+      m_totalSize += blobSize;
+      if (!m_indicesOutdated) {
+        m_paymentIdIndex.add(tx);
+        m_timestampIndex.add(txd.receiveTime, txd.id);
+      }
+
+      // inputs were just checked against the current tail, no need to wait for the next template request
+      if (!keptByBlock && inputsValid) {
+        if (isTemplateFeeSufficient(*txd_p.first)) {
+          m_templateCandidates.insert(&*txd_p.first);
+        }
+      } else {
+        m_templateCandidatesOutdated = true;
+      }
     }
 
     tvc.m_added_to_pool = true;
     tvc.m_should_be_relayed = inputsValid && (fee > 0 || isFusionTransaction);
     tvc.m_verification_failed = true;
 
-    if (!addTransactionInputs(id, tx, keptByBlock))
+    if (!addTransactionInputs(id, tx, keptByBlock)) {
+      ++m_rejectedCounts[REJECT_SPENT_INPUTS];
       return false;
+    }
 
     tvc.m_verification_failed = false;
+
+    if (evictTransactions() != 0 && m_transactions.find(id) == m_transactions.end()) {
+      logger(INFO) << "Transaction " << id << " doesn't fit into the full pool, its fee is too low";
+      ++m_rejectedCounts[REJECT_LOW_FEE];
+      tvc.m_added_to_pool = false;
+      tvc.m_should_be_relayed = false;
+    } else {
+      ++m_admittedCount;
+    }
+
     //succeed
     return true;
   }
@@ -299,15 +367,11 @@ namespace CryptoNote {
     std::unordered_set<Crypto::Hash> ready_tx_ids;
     for (const auto& tx : m_transactions) {
       TransactionCheckInfo checkInfo(tx);
-	  if (m_validated_transactions.find(tx.id) != m_validated_transactions.end()) {
-		  ready_tx_ids.insert(tx.id);
-		  logger(TRACE) << "MemPool - tx " << tx.id << " loaded from cache";
-	  }
-	  else if (is_transaction_ready_to_go(tx.tx, checkInfo)) {
-		  ready_tx_ids.insert(tx.id);
-		  m_validated_transactions.insert(tx.id);
-		  logger(TRACE) << "MemPool - tx " << tx.id << " added to cache";
-	  }
+      if (!m_templateCandidatesOutdated && m_templateCandidates.count(&tx) != 0) {
+        ready_tx_ids.insert(tx.id);
+      } else if (is_transaction_ready_to_go(tx.tx, checkInfo)) {
+        ready_tx_ids.insert(tx.id);
+      }
     }
 
     std::unordered_set<Crypto::Hash> known_set(known_tx_ids.begin(), known_tx_ids.end());
@@ -328,19 +392,20 @@ namespace CryptoNote {
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::on_blockchain_inc(uint64_t new_block_height, const Crypto::Hash& top_block_id) {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
-    if (!m_validated_transactions.empty()) {
-      logger(DEBUGGING) << "MemPool - Block height incremented, cleared " << m_validated_transactions.size() << " cached transaction hashes. New height: " << new_block_height << " Top block: " << top_block_id;
-      m_validated_transactions.clear();
-	}
+    // the new block may spend candidate key images or raise the minimal fee, candidates are pruned lazily
+    logger(DEBUGGING) << "MemPool - Block height incremented, " << m_templateCandidates.size() << " block template candidates to recheck. New height: " << new_block_height << " Top block: " << top_block_id;
+    m_templateCandidatesOutdated = true;
     return true;
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::on_blockchain_dec(uint64_t new_block_height, const Crypto::Hash& top_block_id) {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
-    if (!m_validated_transactions.empty()) {
-      logger(DEBUGGING, YELLOW) << "MemPool - Block height decremented " << m_validated_transactions.size() << " cached transaction hashes. New height: " << new_block_height << " Top block: " << top_block_id;
-      m_validated_transactions.clear();
-	}
+    // used outputs may be gone together with the popped block, so every candidate has to be checked again
+    if (!m_templateCandidates.empty()) {
+      logger(DEBUGGING, YELLOW) << "MemPool - Block height decremented, cleared " << m_templateCandidates.size() << " block template candidates. New height: " << new_block_height << " Top block: " << top_block_id;
+      m_templateCandidates.clear();
+    }
+    m_templateCandidatesOutdated = true;
     return true;
   }
   //---------------------------------------------------------------------------------
@@ -417,52 +482,85 @@ namespace CryptoNote {
 
     BlockTemplate blockTemplate;
 
-    for (auto i = m_fee_index.begin(); i != m_fee_index.end(); ++i) {
+    updateTemplateCandidates();
+
+    for (const auto* candidate : m_templateCandidates) {
       if (counter == 127)
         break;
 
-      const auto& txd = *i;
+      const auto& txd = *candidate;
 
       size_t blockSizeLimit = (txd.fee == 0) ? median_size : max_total_size;
       if (blockSizeLimit < total_size + txd.blobSize) {
         continue;
       }
 
-      tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
-      if (!m_core.check_tx_fee(txd.tx, getObjectHash(txd.tx), txd.blobSize, tvc, m_core.getCurrentBlockchainHeight())) {
-        logger(DEBUGGING) << "Transaction " << txd.id << " not included to block template because fee is insufficient";
-        continue;
+      if (blockTemplate.addTransaction(txd.id, txd.tx)) {
+        total_size += txd.blobSize;
+        fee += txd.fee;
+        ++counter;
+        logger(DEBUGGING) << "Transaction " << txd.id << " included to block template";
+      } else {
+        logger(DEBUGGING) << "Transaction " << txd.id << " is failed to include to block template";
       }
+    }
 
-      TransactionCheckInfo checkInfo(txd);
-      bool ready = false;
-      if (m_validated_transactions.find(txd.id) != m_validated_transactions.end()) {
-        ready = true;
-        logger(DEBUGGING) << "Fill block template - tx added from cache: " << txd.id;
+    bl.transactionHashes = blockTemplate.getTransactions();
+    return true;
+  }
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::isTemplateFeeSufficient(const TransactionDetails& txd) const {
+    uint32_t height = m_core.getCurrentBlockchainHeight();
+    // the fusion rules only changed at heights long in the past, so the first answer holds
+    if (!txd.fusion.is_initialized()) {
+      txd.fusion = txd.fee == 0 && m_currency.isFusionTransaction(txd.tx, txd.blobSize, height);
+    }
+
+    tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+    if (!m_core.check_tx_fee(txd.tx, txd.id, txd.fee, txd.fusion.get(), tvc, height)) {
+      logger(DEBUGGING) << "Transaction " << txd.id << " not included to block template because fee is insufficient";
+      return false;
+    }
+
+    return true;
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::updateTemplateCandidates() {
+    if (!m_templateCandidatesOutdated) {
+      return;
+    }
+
+    // maxUsedBlock of the remaining candidates is still in the chain, only key images and fee can make them invalid
+    for (auto it = m_templateCandidates.begin(); it != m_templateCandidates.end();) {
+      if (m_validator.haveSpentKeyImages((*it)->tx) || !isTemplateFeeSufficient(**it)) {
+        logger(DEBUGGING) << "Transaction " << (*it)->id << " removed from block template candidates";
+        it = m_templateCandidates.erase(it);
+      } else {
+        ++it;
       }
-      else if (is_transaction_ready_to_go(txd.tx, checkInfo)) {
-        ready = true;
-        m_validated_transactions.insert(txd.id);
-        logger(DEBUGGING) << "Fill block template - tx added to cache: " << txd.id;
+    }
+
+    for (auto i = m_fee_index.begin(); i != m_fee_index.end(); ++i) {
+      const auto& txd = *i;
+      if (m_templateCandidates.count(&txd) != 0) {
+        continue;
       }
 
+      TransactionCheckInfo checkInfo(txd);
+      bool ready = is_transaction_ready_to_go(txd.tx, checkInfo);
+
       // update item state
       m_fee_index.modify(i, [&checkInfo](TransactionCheckInfo& item) {
         item = checkInfo;
       });
 
-      if (ready && blockTemplate.addTransaction(txd.id, txd.tx)) {
-        total_size += txd.blobSize;
-        fee += txd.fee;
-        ++counter;
-        logger(DEBUGGING) << "Transaction " << txd.id << " included to block template";
-      } else {
-        logger(DEBUGGING) << "Transaction " << txd.id << " is failed to include to block template";
+      if (ready && isTemplateFeeSufficient(txd)) {
+        m_templateCandidates.insert(&txd);
+        logger(DEBUGGING) << "Transaction " << txd.id << " added to block template candidates";
       }
     }
 
-    bl.transactionHashes = blockTemplate.getTransactions();
-    return true;
+    m_templateCandidatesOutdated = false;
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::init(const std::string& config_folder) {
@@ -470,26 +568,37 @@ namespace CryptoNote {
 
     m_config_folder = config_folder;
     std::string state_file_path = config_folder + "/" + m_currency.txPoolFileName();
+    std::string journal_file_path = state_file_path + ".journal";
     boost::system::error_code ec;
-    if (!boost::filesystem::exists(state_file_path, ec)) {
-      return true;
-    }
-
-    if (!loadFromBinaryFile(*this, state_file_path)) {
+    if (boost::filesystem::exists(state_file_path, ec) && !loadFromBinaryFile(*this, state_file_path)) {
       logger(ERROR) << "Failed to load memory pool from file " << state_file_path;
 
+      m_templateCandidates.clear();
       m_transactions.clear();
       m_spent_key_images.clear();
       m_spentOutputs.clear();
+      m_totalSize = 0;
+    }
 
-      m_paymentIdIndex.clear();
-      m_timestampIndex.clear();
-    } else {
-      buildIndices();
+    m_paymentIdIndex.clear();
+    m_timestampIndex.clear();
+    m_indicesOutdated = true;
+
+    // changes made after the snapshot was written, an interrupted last record is dropped
+    if (boost::filesystem::exists(journal_file_path, ec) && replayJournal(journal_file_path)) {
+      if (!storeToBinaryFile(*this, state_file_path)) {
+        logger(ERROR) << "Failed to serialize memory pool to file " << state_file_path;
+      }
     }
 
+    resetJournal();
     removeExpiredTransactions();
 
+    size_t evicted = evictTransactions();
+    if (evicted != 0) {
+      logger(INFO) << evicted << " transactions evicted from the pool to fit its size limit of " << m_maxSize << " bytes";
+    }
+
     // Ignore deserialization error
     return true;
   }
@@ -502,10 +611,15 @@ namespace CryptoNote {
 
     std::string state_file_path = m_config_folder + "/" + m_currency.txPoolFileName();
 
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
     if (!storeToBinaryFile(*this, state_file_path)) {
       logger(INFO) << "Failed to serialize memory pool to file " << state_file_path;
+    } else {
+      // everything journaled is in the snapshot now
+      resetJournal();
     }
 
+    m_journal.close();
     m_paymentIdIndex.clear();
     m_timestampIndex.clear();
     
@@ -541,8 +655,16 @@ namespace CryptoNote {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
 
     if (s.type() == ISerializer::INPUT) {
+      m_templateCandidates.clear();
+      m_templateCandidatesOutdated = true;
+      m_changelog.clear();
+      ++m_modificationCounter;
       m_transactions.clear();
       readSequence<TransactionDetails>(std::inserter(m_transactions, m_transactions.end()), "transactions", s);
+      m_totalSize = 0;
+      for (const auto& txd : m_transactions) {
+        m_totalSize += txd.blobSize;
+      }
     } else {
       writeSequence<TransactionDetails>(m_transactions.begin(), m_transactions.end(), "transactions", s);
     }
@@ -550,11 +672,175 @@ namespace CryptoNote {
     KV_MEMBER(m_spent_key_images);
     KV_MEMBER(m_spentOutputs);
     KV_MEMBER(m_recentlyDeletedTransactions);
+
+    if (s.type() == ISerializer::INPUT) {
+      m_deletionTimes.clear();
+      for (const auto& deleted : m_recentlyDeletedTransactions) {
+        m_deletionTimes.emplace(deleted.second, deleted.first);
+      }
+    }
   }
 
   //---------------------------------------------------------------------------------
   void tx_memory_pool::on_idle() {
     m_txCheckInterval.call([this](){ return removeExpiredTransactions(); });
+
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    if (m_journalSize > POOL_JOURNAL_COMPACTION_SIZE) {
+      compactJournal();
+    }
+  }
+
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::journalAdd(const TransactionDetails& txd) {
+    if (!m_journal.is_open()) {
+      return;
+    }
+
+    appendToJournal(POOL_JOURNAL_ADD, toBinaryArray(txd));
+  }
+
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::journalRemove(const Crypto::Hash& id) {
+    if (!m_journal.is_open()) {
+      return;
+    }
+
+    // the deletion time keeps the transaction from being readded after a restart
+    auto deleted = m_recentlyDeletedTransactions.find(id);
+    uint64_t deletionTime = deleted != m_recentlyDeletedTransactions.end() ? deleted->second : 0;
+
+    BinaryArray payload(sizeof(id) + sizeof(deletionTime));
+    memcpy(payload.data(), &id, sizeof(id));
+    for (size_t i = 0; i < sizeof(deletionTime); ++i) {
+      payload[sizeof(id) + i] = static_cast<uint8_t>(deletionTime >> (8 * i));
+    }
+
+    appendToJournal(POOL_JOURNAL_REMOVE, payload);
+  }
+
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::appendToJournal(char type, const BinaryArray& payload) {
+    char header[5];
+    header[0] = type;
+    uint32_t size = static_cast<uint32_t>(payload.size());
+    for (size_t i = 0; i < sizeof(size); ++i) {
+      header[1 + i] = static_cast<char>(size >> (8 * i));
+    }
+
+    m_journal.write(header, sizeof(header));
+    m_journal.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+    m_journal.flush();
+    if (m_journal.fail()) {
+      logger(ERROR) << "Failed to write memory pool journal, closing it until the next snapshot";
+      m_journal.close();
+      return;
+    }
+
+    m_journalSize += sizeof(header) + payload.size();
+  }
+
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::replayJournal(const std::string& path) {
+    std::ifstream journal(path, std::ios_base::binary | std::ios_base::in);
+    if (journal.fail()) {
+      logger(ERROR) << "Failed to open memory pool journal " << path;
+      return false;
+    }
+
+    size_t replayed = 0;
+    for (;;) {
+      char header[5];
+      if (!journal.read(header, sizeof(header))) {
+        break;
+      }
+
+      uint32_t size = 0;
+      for (size_t i = 0; i < sizeof(size); ++i) {
+        size |= static_cast<uint32_t>(static_cast<uint8_t>(header[1 + i])) << (8 * i);
+      }
+
+      if (size > POOL_JOURNAL_MAX_RECORD_SIZE) {
+        logger(WARNING) << "Memory pool journal record of " << size << " bytes is corrupted, the rest of the journal is ignored";
+        break;
+      }
+
+      BinaryArray payload(size);
+      if (size != 0 && !journal.read(reinterpret_cast<char*>(payload.data()), size)) {
+        logger(WARNING) << "Memory pool journal ends with an incomplete record, it is ignored";
+        break;
+      }
+
+      if (header[0] == POOL_JOURNAL_ADD) {
+        TransactionDetails txd;
+        if (!fromBinaryArray(txd, payload)) {
+          logger(WARNING) << "Memory pool journal record is corrupted, the rest of the journal is ignored";
+          break;
+        }
+
+        auto result = m_transactions.insert(txd);
+        if (result.second) {
+          m_totalSize += txd.blobSize;
+          addTransactionInputs(txd.id, txd.tx, txd.keptByBlock);
+        }
+      } else if (header[0] == POOL_JOURNAL_REMOVE && size == sizeof(Crypto::Hash) + sizeof(uint64_t)) {
+        Crypto::Hash id;
+        memcpy(&id, payload.data(), sizeof(id));
+        uint64_t deletionTime = 0;
+        for (size_t i = 0; i < sizeof(deletionTime); ++i) {
+          deletionTime |= static_cast<uint64_t>(payload[sizeof(id) + i]) << (8 * i);
+        }
+
+        auto it = m_transactions.find(id);
+        if (it != m_transactions.end()) {
+          removeTransactionInputs(it->id, it->tx, it->keptByBlock);
+          m_totalSize -= it->blobSize;
+          m_transactions.erase(it);
+        }
+
+        if (deletionTime != 0) {
+          rememberDeletedTransaction(id, deletionTime);
+        }
+      } else {
+        logger(WARNING) << "Unknown memory pool journal record, the rest of the journal is ignored";
+        break;
+      }
+
+      ++replayed;
+    }
+
+    if (replayed != 0) {
+      logger(INFO) << replayed << " memory pool changes replayed from " << path;
+      m_templateCandidates.clear();
+      m_templateCandidatesOutdated = true;
+    }
+
+    return replayed != 0;
+  }
+
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::resetJournal() {
+    std::string journal_file_path = m_config_folder + "/" + m_currency.txPoolFileName() + ".journal";
+    m_journal.close();
+    m_journal.clear();
+    m_journal.open(journal_file_path, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+    if (m_journal.fail()) {
+      logger(ERROR) << "Failed to open memory pool journal " << journal_file_path;
+      m_journal.close();
+    }
+
+    m_journalSize = 0;
+  }
+
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::compactJournal() {
+    std::string state_file_path = m_config_folder + "/" + m_currency.txPoolFileName();
+    if (!storeToBinaryFile(*this, state_file_path)) {
+      logger(ERROR) << "Failed to serialize memory pool to file " << state_file_path;
+      return;
+    }
+
+    resetJournal();
   }
 
   //---------------------------------------------------------------------------------
@@ -565,23 +851,29 @@ namespace CryptoNote {
 
       uint64_t now = m_timeProvider.now();
 
-      for (auto it = m_recentlyDeletedTransactions.begin(); it != m_recentlyDeletedTransactions.end();) {
-        uint64_t elapsedTimeSinceDeletion = now - it->second;
-        if (elapsedTimeSinceDeletion > m_currency.numberOfPeriodsToForgetTxDeletedFromPool() * m_currency.mempoolTxLiveTime()) {
-          it = m_recentlyDeletedTransactions.erase(it);
-        } else {
-          ++it;
+      // both are visited from the oldest, so the ones kept stop the scan
+      uint64_t forgetTime = m_currency.numberOfPeriodsToForgetTxDeletedFromPool() * m_currency.mempoolTxLiveTime();
+      while (!m_deletionTimes.empty() && m_deletionTimes.begin()->first + forgetTime < now) {
+        auto deleted = m_recentlyDeletedTransactions.find(m_deletionTimes.begin()->second);
+        if (deleted != m_recentlyDeletedTransactions.end() && deleted->second == m_deletionTimes.begin()->first) {
+          m_recentlyDeletedTransactions.erase(deleted);
         }
+
+        m_deletionTimes.erase(m_deletionTimes.begin());
       }
 
-      for (auto it = m_transactions.begin(); it != m_transactions.end();) {
+      // transactions kept by block live longer, these are passed over until they expire as well
+      uint64_t liveTime = std::min(m_currency.mempoolTxLiveTime(), m_currency.mempoolTxFromAltBlockLiveTime());
+      for (auto it = m_receiveTimeIndex.begin(); it != m_receiveTimeIndex.end() && static_cast<uint64_t>(it->receiveTime) + liveTime < now;) {
         uint64_t txAge = now - it->receiveTime;
         bool remove = txAge > (it->keptByBlock ? m_currency.mempoolTxFromAltBlockLiveTime() : m_currency.mempoolTxLiveTime());
 
         if (remove) {
           logger(TRACE) << "Tx " << it->id << " removed from tx pool due to outdated, age: " << txAge;
-          m_recentlyDeletedTransactions.emplace(it->id, now);
-          it = removeTransaction(it);
+          rememberDeletedTransaction(it->id, now);
+          auto next = std::next(it);
+          removeTransaction(m_transactions.project<0>(it));
+          it = next;
           somethingRemoved = true;
         } else {
           ++it;
@@ -596,14 +888,134 @@ namespace CryptoNote {
     return true;
   }
 
+  size_t tx_memory_pool::evictTransactions() {
+    size_t evicted = 0;
+    uint64_t now = m_timeProvider.now();
+
+    // the fee index is ordered from the most to the least profitable per byte.
+    // Transactions kept by block come from popped or alternative blocks and a chain switch
+    // takes them back from the pool, they stay even if the pool remains over its limit.
+    auto feeIt = m_fee_index.end();
+    while (m_maxSize != 0 && m_totalSize > m_maxSize && feeIt != m_fee_index.begin()) {
+      auto victim = std::prev(feeIt);
+      if (victim->keptByBlock) {
+        feeIt = victim;
+        continue;
+      }
+
+      auto it = m_transactions.project<0>(victim);
+      logger(DEBUGGING) << "Tx " << it->id << " evicted from tx pool, fee " << m_currency.formatAmount(it->fee) << ", size " << it->blobSize;
+      rememberDeletedTransaction(it->id, now);
+      removeTransaction(it);
+      ++evicted;
+    }
+
+    m_evictedCount += evicted;
+    return evicted;
+  }
+
+  void tx_memory_pool::rememberDeletedTransaction(const Crypto::Hash& id, uint64_t deletionTime) {
+    m_recentlyDeletedTransactions[id] = deletionTime;
+    m_deletionTimes.emplace(deletionTime, id);
+  }
+
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::recordChange(const Crypto::Hash& id, bool added) {
+    ++m_modificationCounter;
+    m_changelog.emplace_back(id, added);
+    if (m_changelog.size() > POOL_CHANGELOG_MAX_SIZE) {
+      m_changelog.pop_front();
+    }
+  }
+
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::getChangesSince(uint64_t modificationCounter, std::vector<Crypto::Hash>& addedTxsIds, std::vector<Crypto::Hash>& deletedTxsIds) const {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    uint64_t current = m_modificationCounter;
+    if (modificationCounter > current || current - modificationCounter > m_changelog.size()) {
+      return false;
+    }
+
+    // the first event of an id tells whether it was in the pool before, the last one whether it is there now
+    std::unordered_map<Crypto::Hash, std::pair<bool, bool>> changes;
+    for (size_t i = m_changelog.size() - (current - modificationCounter); i < m_changelog.size(); ++i) {
+      const auto& change = m_changelog[i];
+      auto it = changes.find(change.first);
+      if (it == changes.end()) {
+        changes.emplace(change.first, std::make_pair(!change.second, change.second));
+      } else {
+        it->second.second = change.second;
+      }
+    }
+
+    for (const auto& change : changes) {
+      bool wasInPool = change.second.first;
+      bool isInPool = change.second.second;
+      if (!wasInPool && isInPool) {
+        addedTxsIds.push_back(change.first);
+      } else if (wasInPool && !isInPool) {
+        deletedTxsIds.push_back(change.first);
+      }
+    }
+
+    return true;
+  }
+
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::setMaxSize(uint64_t maxSize) {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    m_maxSize = maxSize;
+  }
+
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::getSizeStatistics(uint64_t& totalSize, uint64_t& maxSize, uint64_t& evictedCount) const {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    totalSize = m_totalSize;
+    maxSize = m_maxSize;
+    evictedCount = m_evictedCount;
+  }
+
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::writeMetrics(std::ostream& out) const {
+    static const char* const REJECT_REASON_NAMES[REJECT_REASON_COUNT] = {
+      "unsupported_inputs", "invalid_amounts", "spent_inputs", "invalid_inputs", "too_big", "recently_deleted", "duplicate", "low_fee"
+    };
+
+    size_t count;
+    uint64_t totalSize;
+    uint64_t evictedCount;
+    {
+      std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+      count = m_transactions.size();
+      totalSize = m_totalSize;
+      evictedCount = m_evictedCount;
+    }
+
+    Common::writeMetricHeader(out, "karbo_pool_transactions", "gauge", "Transactions in the memory pool.");
+    out << "karbo_pool_transactions " << count << '\n';
+    Common::writeMetricHeader(out, "karbo_pool_bytes", "gauge", "Total blob size of the transactions in the memory pool.");
+    out << "karbo_pool_bytes " << totalSize << '\n';
+    Common::writeMetricHeader(out, "karbo_pool_admitted_total", "counter", "Transactions added to the memory pool.");
+    out << "karbo_pool_admitted_total " << m_admittedCount << '\n';
+    Common::writeMetricHeader(out, "karbo_pool_rejected_total", "counter", "Transactions not added to the memory pool, by reason.");
+    for (size_t i = 0; i < REJECT_REASON_COUNT; ++i) {
+      out << "karbo_pool_rejected_total{reason=\"" << REJECT_REASON_NAMES[i] << "\"} " << m_rejectedCounts[i] << '\n';
+    }
+
+    Common::writeMetricHeader(out, "karbo_pool_evicted_total", "counter", "Transactions evicted from the full memory pool.");
+    out << "karbo_pool_evicted_total " << evictedCount << '\n';
+  }
+
   tx_memory_pool::tx_container_t::iterator tx_memory_pool::removeTransaction(tx_memory_pool::tx_container_t::iterator i) {
     removeTransactionInputs(i->id, i->tx, i->keptByBlock);
-    m_paymentIdIndex.remove(i->tx);
-    m_timestampIndex.remove(i->receiveTime, i->id);
-    if (m_validated_transactions.find(i->id) != m_validated_transactions.end()) {
-      m_validated_transactions.erase(i->id);
-      logger(DEBUGGING) << "Removing transaction from MemPool cache " << i->id << ". Cache size: " << m_validated_transactions.size();
+    if (!m_indicesOutdated) {
+      m_paymentIdIndex.remove(i->tx);
+      m_timestampIndex.remove(i->receiveTime, i->id);
     }
+    m_templateCandidates.erase(&*i);
+    recordChange(i->id, false);
+    journalRemove(i->id);
+    m_totalSize -= i->blobSize;
     return m_transactions.erase(i);
   }
 
@@ -614,7 +1026,7 @@ namespace CryptoNote {
         auto it = m_spent_key_images.find(txin.keyImage);
         if (!(it != m_spent_key_images.end())) { logger(ERROR, BRIGHT_RED) << "failed to find transaction input in key images. img=" << txin.keyImage << std::endl
           << "transaction id = " << tx_id; return false; }
-        std::unordered_set<Crypto::Hash>& key_image_set = it->second;
+        auto& key_image_set = it->second;
         if (!(!key_image_set.empty())) { logger(ERROR, BRIGHT_RED) << "empty key_image set, img=" << txin.keyImage << std::endl
           << "transaction id = " << tx_id; return false; }
 
@@ -645,7 +1057,7 @@ namespace CryptoNote {
     for (const auto& in : tx.inputs) {
       if (in.type() == typeid(KeyInput)) {
         const auto& txin = boost::get<KeyInput>(in);
-        std::unordered_set<Crypto::Hash>& kei_image_set = m_spent_key_images[txin.keyImage];
+        auto& kei_image_set = m_spent_key_images[txin.keyImage];
         if (!(keptByBlock || kei_image_set.size() == 0)) {
           logger(ERROR, BRIGHT_RED)
               << "internal error: keptByBlock=" << keptByBlock
@@ -705,15 +1117,48 @@ namespace CryptoNote {
     }
   }
 
+  void tx_memory_pool::updateIndices() {
+    if (m_indicesOutdated) {
+      m_paymentIdIndex.clear();
+      m_timestampIndex.clear();
+      buildIndices();
+      m_indicesOutdated = false;
+    }
+  }
+
   bool tx_memory_pool::getTransactionIdsByPaymentId(const Crypto::Hash& paymentId, std::vector<Crypto::Hash>& transactionIds) {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    updateIndices();
     //return m_paymentIdIndex.find(paymentId, transactionIds);
 	transactionIds = m_paymentIdIndex.find(paymentId);
 	return true;
   }
 
+  void tx_memory_pool::getTransactionIdsByShortIds(const Crypto::Hash& key, const std::vector<uint64_t>& shortIds, std::vector<Crypto::Hash>& transactionIds) const {
+    // short ids are keyed per block, so the index is built for every lookup; ids shared by several transactions resolve to none
+    std::unordered_map<uint64_t, Crypto::Hash> shortIdIndex;
+    {
+      std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+      shortIdIndex.reserve(m_transactions.size());
+      for (const auto& txd : m_transactions) {
+        auto result = shortIdIndex.emplace(get_transaction_short_id(key, txd.id), txd.id);
+        if (!result.second) {
+          result.first->second = NULL_HASH;
+        }
+      }
+    }
+
+    transactionIds.clear();
+    transactionIds.reserve(shortIds.size());
+    for (uint64_t shortId : shortIds) {
+      auto it = shortIdIndex.find(shortId);
+      transactionIds.push_back(it != shortIdIndex.end() ? it->second : NULL_HASH);
+    }
+  }
+
   bool tx_memory_pool::getTransactionIdsByTimestamp(uint64_t timestampBegin, uint64_t timestampEnd, uint32_t transactionsNumberLimit, std::vector<Crypto::Hash>& hashes, uint64_t& transactionsNumberWithinTimestamps) {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    updateIndices();
     return m_timestampIndex.find(timestampBegin, timestampEnd, transactionsNumberLimit, hashes, transactionsNumberWithinTimestamps);
   }
 }
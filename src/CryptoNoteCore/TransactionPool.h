@@ -17,10 +17,16 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <map>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
 
+#include <boost/optional.hpp>
 #include <boost/utility.hpp>
 
 // multi index
@@ -29,6 +35,8 @@
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/member.hpp>
 
+#include <parallel_hashmap/phmap.h>
+
 #include "CryptoTypes.h"
 #include "Common/Util.h"
 #include "Common/int-util.h"
@@ -102,6 +110,8 @@ namespace CryptoNote {
 
     bool have_tx(const Crypto::Hash &id) const;
     bool add_tx(const Transaction &tx, const Crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool keeped_by_block);
+    // checkedMaxUsedBlock, if not null, is the result of a successful checkTransactionInputs() done by the caller
+    bool add_tx(const Transaction &tx, const Crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool keeped_by_block, const BlockInfo* checkedMaxUsedBlock);
     bool add_tx(const Transaction &tx, tx_verification_context& tvc, bool keeped_by_block);
     //gets tx and remove it from pool
     bool take_tx(const Crypto::Hash &id, Transaction &tx, size_t& blobSize, uint64_t& fee);
@@ -118,11 +128,21 @@ namespace CryptoNote {
     void get_transactions(std::list<Transaction>& txs) const;
     void get_difference(const std::vector<Crypto::Hash>& known_tx_ids, std::vector<Crypto::Hash>& new_tx_ids, std::vector<Crypto::Hash>& deleted_tx_ids) const;
     size_t get_transactions_count() const;
+    // total blob size cap in bytes, 0 disables it; the lowest priority transactions are evicted first
+    void setMaxSize(uint64_t maxSize);
+    void getSizeStatistics(uint64_t& totalSize, uint64_t& maxSize, uint64_t& evictedCount) const;
+    // size, admissions and rejections by reason in Prometheus text format
+    void writeMetrics(std::ostream& out) const;
+    // changes whenever a transaction is added to or removed from the pool
+    uint64_t getModificationCounter() const { return m_modificationCounter; }
+    // net changes after the given modification counter value, false if the changelog doesn't reach back that far
+    bool getChangesSince(uint64_t modificationCounter, std::vector<Crypto::Hash>& addedTxsIds, std::vector<Crypto::Hash>& deletedTxsIds) const;
     std::string print_pool(bool short_format) const;
 	
     void on_idle();
 
     bool getTransactionIdsByPaymentId(const Crypto::Hash& paymentId, std::vector<Crypto::Hash>& transactionIds);
+    void getTransactionIdsByShortIds(const Crypto::Hash& key, const std::vector<uint64_t>& shortIds, std::vector<Crypto::Hash>& transactionIds) const;
     bool getTransactionIdsByTimestamp(uint64_t timestampBegin, uint64_t timestampEnd, uint32_t transactionsNumberLimit, std::vector<Crypto::Hash>& hashes, uint64_t& transactionsNumberWithinTimestamps);
     bool getTransaction(const Crypto::Hash& id, Transaction& tx);
 
@@ -154,6 +174,9 @@ namespace CryptoNote {
       uint64_t fee;
       bool keptByBlock;
       time_t receiveTime;
+      // whether a transaction without fee is a fusion one, the template fee check asks again and again;
+      // not stored, so filled lazily after the pool is loaded
+      mutable boost::optional<bool> fusion;
     };
 
 	void getMemoryPool(std::list<CryptoNote::tx_memory_pool::TransactionDetails> txs) const;
@@ -182,16 +205,26 @@ namespace CryptoNote {
       }
     };
 
+    // pool elements are node based, so pointers to them stay valid until the transaction is removed
+    struct TemplateCandidateComparator {
+      bool operator()(const TransactionDetails* lhs, const TransactionDetails* rhs) const {
+        TransactionPriorityComparator byPriority;
+        return byPriority(*lhs, *rhs) || (!byPriority(*rhs, *lhs) && std::less<const TransactionDetails*>()(lhs, rhs));
+      }
+    };
+
     typedef hashed_unique<BOOST_MULTI_INDEX_MEMBER(TransactionDetails, Crypto::Hash, id)> main_index_t;
     typedef ordered_non_unique<identity<TransactionDetails>, TransactionPriorityComparator> fee_index_t;
+    typedef ordered_non_unique<BOOST_MULTI_INDEX_MEMBER(TransactionDetails, time_t, receiveTime)> receive_time_index_t;
 
     typedef multi_index_container<TransactionDetails,
-      indexed_by<main_index_t, fee_index_t>
+      indexed_by<main_index_t, fee_index_t, receive_time_index_t>
     > tx_container_t;
 
     typedef std::pair<uint64_t, uint64_t> GlobalOutput;
-    typedef std::set<GlobalOutput> GlobalOutputsContainer;
-    typedef std::unordered_map<Crypto::KeyImage, std::unordered_set<Crypto::Hash> > key_images_container;
+    // open addressing sets keep the double spending checks free of per entry allocations
+    typedef phmap::flat_hash_set<GlobalOutput> GlobalOutputsContainer;
+    typedef phmap::flat_hash_map<Crypto::KeyImage, phmap::flat_hash_set<Crypto::Hash> > key_images_container;
 
 
     // double spending checking
@@ -201,9 +234,26 @@ namespace CryptoNote {
 
     tx_container_t::iterator removeTransaction(tx_container_t::iterator i);
     bool removeExpiredTransactions();
+    size_t evictTransactions();
+    void rememberDeletedTransaction(const Crypto::Hash& id, uint64_t deletionTime);
+    void recordChange(const Crypto::Hash& id, bool added);
     bool is_transaction_ready_to_go(const Transaction& tx, TransactionCheckInfo& txd) const;
 
+    // block template candidates are the transactions already checked against the current chain tail
+    bool isTemplateFeeSufficient(const TransactionDetails& txd) const;
+    void updateTemplateCandidates();
+
+    // the indices are built on first use after loading the pool
     void buildIndices();
+    void updateIndices();
+
+    // adds and removals since the last pool snapshot, replayed over it on init
+    void journalAdd(const TransactionDetails& txd);
+    void journalRemove(const Crypto::Hash& id);
+    void appendToJournal(char type, const BinaryArray& payload);
+    bool replayJournal(const std::string& path);
+    void resetJournal();
+    void compactJournal();
 
     Tools::ObserverManager<ITxPoolObserver> m_observerManager;
     const CryptoNote::Currency& m_currency;
@@ -219,7 +269,37 @@ namespace CryptoNote {
 
     tx_container_t m_transactions;  
     tx_container_t::nth_index<1>::type& m_fee_index;
+    tx_container_t::nth_index<2>::type& m_receiveTimeIndex;
     std::unordered_map<Crypto::Hash, uint64_t> m_recentlyDeletedTransactions;
+    // the same deletions ordered by time, may hold outdated entries of transactions deleted again
+    std::multimap<uint64_t, Crypto::Hash> m_deletionTimes;
+    std::set<const TransactionDetails*, TemplateCandidateComparator> m_templateCandidates;
+    bool m_templateCandidatesOutdated;
+    std::atomic<uint64_t> m_modificationCounter;
+    // one entry per modification, the last one matches m_modificationCounter
+    std::deque<std::pair<Crypto::Hash, bool>> m_changelog;
+    uint64_t m_totalSize;
+    uint64_t m_maxSize;
+    uint64_t m_evictedCount;
+    std::ofstream m_journal;
+    uint64_t m_journalSize;
+    bool m_indicesOutdated;
+
+    enum RejectReason {
+      REJECT_UNSUPPORTED_INPUTS,
+      REJECT_INVALID_AMOUNTS,
+      REJECT_SPENT_INPUTS,
+      REJECT_INVALID_INPUTS,
+      REJECT_TOO_BIG,
+      REJECT_RECENTLY_DELETED,
+      REJECT_DUPLICATE,
+      REJECT_LOW_FEE,
+      REJECT_REASON_COUNT
+    };
+
+    // add_tx() outcomes, counted outside of m_transactions_lock
+    std::atomic<uint64_t> m_admittedCount;
+    std::array<std::atomic<uint64_t>, REJECT_REASON_COUNT> m_rejectedCounts;
 
     Logging::LoggerRef logger;
 
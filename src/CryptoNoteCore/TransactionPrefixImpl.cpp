@@ -20,6 +20,8 @@
 #include <numeric>
 #include <system_error>
 
+#include <boost/optional.hpp>
+
 #include "CryptoNoteCore/CryptoNoteBasic.h"
 #include "CryptoNoteCore/TransactionApiExtra.h"
 #include "TransactionUtils.h"
@@ -33,6 +35,7 @@ class TransactionPrefixImpl : public ITransactionReader {
 public:
   TransactionPrefixImpl();
   TransactionPrefixImpl(const TransactionPrefix& prefix, const Hash& transactionHash);
+  TransactionPrefixImpl(const TransactionPrefix& prefix, const Hash& transactionHash, const Hash& transactionPrefixHash);
 
   virtual ~TransactionPrefixImpl() { }
 
@@ -80,18 +83,30 @@ public:
 
 private:
   TransactionPrefix m_txPrefix;
-  TransactionExtra m_extra;
+  TransactionExtraScan m_extraScan; // points into m_txPrefix.extra
   Hash m_txHash;
+
+  // the prefix never changes, so derived values are computed on first use
+  mutable boost::optional<Hash> m_txPrefixHash;
+  mutable boost::optional<Hash> m_inputsHash;
+  mutable boost::optional<uint64_t> m_inputTotalAmount;
+  mutable boost::optional<uint64_t> m_outputTotalAmount;
 };
 
 TransactionPrefixImpl::TransactionPrefixImpl() {
+  scanTransactionExtra(m_txPrefix.extra, m_extraScan);
 }
 
 TransactionPrefixImpl::TransactionPrefixImpl(const TransactionPrefix& prefix, const Hash& transactionHash) {
-  m_extra.parse(prefix.extra);
-
   m_txPrefix = prefix;
   m_txHash = transactionHash;
+
+  scanTransactionExtra(m_txPrefix.extra, m_extraScan);
+}
+
+TransactionPrefixImpl::TransactionPrefixImpl(const TransactionPrefix& prefix, const Hash& transactionHash, const Hash& transactionPrefixHash) :
+  TransactionPrefixImpl(prefix, transactionHash) {
+  m_txPrefixHash = transactionPrefixHash;
 }
 
 Hash TransactionPrefixImpl::getTransactionHash() const {
@@ -99,16 +114,24 @@ Hash TransactionPrefixImpl::getTransactionHash() const {
 }
 
 Hash TransactionPrefixImpl::getTransactionPrefixHash() const {
-  return getObjectHash(m_txPrefix);
+  if (!m_txPrefixHash.is_initialized()) {
+    m_txPrefixHash = getObjectHash(m_txPrefix);
+  }
+
+  return m_txPrefixHash.get();
 }
 
 Hash TransactionPrefixImpl::getTransactionInputsHash() const {
-  return getObjectHash(m_txPrefix.inputs);
+  if (!m_inputsHash.is_initialized()) {
+    m_inputsHash = getObjectHash(m_txPrefix.inputs);
+  }
+
+  return m_inputsHash.get();
 }
 
 PublicKey TransactionPrefixImpl::getTransactionPublicKey() const {
   Crypto::PublicKey pk(NULL_PUBLIC_KEY);
-  m_extra.getPublicKey(pk);
+  m_extraScan.getPublicKey(pk);
   return pk;
 }
 
@@ -117,28 +140,11 @@ uint64_t TransactionPrefixImpl::getUnlockTime() const {
 }
 
 bool TransactionPrefixImpl::getPaymentId(Hash& hash) const {
-  BinaryArray nonce;
-
-  if (getExtraNonce(nonce)) {
-    Crypto::Hash paymentId;
-    if (getPaymentIdFromTransactionExtraNonce(nonce, paymentId)) {
-      hash = reinterpret_cast<const Hash&>(paymentId);
-      return true;
-    }
-  }
-
-  return false;
+  return m_extraScan.getPaymentId(hash);
 }
 
 bool TransactionPrefixImpl::getExtraNonce(BinaryArray& nonce) const {
-  TransactionExtraNonce extraNonce;
-
-  if (m_extra.get(extraNonce)) {
-    nonce = extraNonce.nonce;
-    return true;
-  }
-
-  return false;
+  return m_extraScan.getExtraNonce(nonce);
 }
 
 BinaryArray TransactionPrefixImpl::getExtra() const {
@@ -150,8 +156,12 @@ size_t TransactionPrefixImpl::getInputCount() const {
 }
 
 uint64_t TransactionPrefixImpl::getInputTotalAmount() const {
-  return std::accumulate(m_txPrefix.inputs.begin(), m_txPrefix.inputs.end(), 0ULL, [](uint64_t val, const TransactionInput& in) {
-    return val + getTransactionInputAmount(in); });
+  if (!m_inputTotalAmount.is_initialized()) {
+    m_inputTotalAmount = std::accumulate(m_txPrefix.inputs.begin(), m_txPrefix.inputs.end(), 0ULL, [](uint64_t val, const TransactionInput& in) {
+      return val + getTransactionInputAmount(in); });
+  }
+
+  return m_inputTotalAmount.get();
 }
 
 TransactionTypes::InputType TransactionPrefixImpl::getInputType(size_t index) const {
@@ -175,8 +185,12 @@ size_t TransactionPrefixImpl::getOutputCount() const {
 }
 
 uint64_t TransactionPrefixImpl::getOutputTotalAmount() const {
-  return std::accumulate(m_txPrefix.outputs.begin(), m_txPrefix.outputs.end(), 0ULL, [](uint64_t val, const TransactionOutput& out) {
-    return val + out.amount; });
+  if (!m_outputTotalAmount.is_initialized()) {
+    m_outputTotalAmount = std::accumulate(m_txPrefix.outputs.begin(), m_txPrefix.outputs.end(), 0ULL, [](uint64_t val, const TransactionOutput& out) {
+      return val + out.amount; });
+  }
+
+  return m_outputTotalAmount.get();
 }
 
 TransactionTypes::OutputType TransactionPrefixImpl::getOutputType(size_t index) const {
@@ -237,7 +251,9 @@ std::unique_ptr<ITransactionReader> createTransactionPrefix(const TransactionPre
 }
 
 std::unique_ptr<ITransactionReader> createTransactionPrefix(const Transaction& fullTransaction) {
-  return std::unique_ptr<ITransactionReader> (new TransactionPrefixImpl(fullTransaction, getObjectHash(fullTransaction)));
+  // both hashes come from a single serialization of the transaction
+  BinaryArray ba = toBinaryArray(fullTransaction);
+  return std::unique_ptr<ITransactionReader> (new TransactionPrefixImpl(fullTransaction, getBinaryArrayHash(ba), getTransactionPrefixHash(fullTransaction, ba)));
 }
 
 }
@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <ctime>
+#include <vector>
 
 #include "Common/StringTools.h"
 #include "CryptoNoteCore/CryptoNoteBasicImpl.h"
@@ -46,6 +47,7 @@ namespace CryptoNote {
       m_blockchain(blockchain),
       m_targetVersion(targetVersion),
       m_votingCompleteHeight(UNDEF_HEIGHT),
+      m_voteCount(0),
       logger(log, "upgrade") { }
 
     bool init() {
@@ -53,6 +55,8 @@ namespace CryptoNote {
       if (upgradeHeight == UNDEF_HEIGHT) {
         if (m_blockchain.empty()) {
           m_votingCompleteHeight = UNDEF_HEIGHT;
+          m_votes.assign(m_currency.upgradeVotingWindow(), false);
+          m_voteCount = 0;
 
         } else if (m_targetVersion - 1 == m_blockchain.back().bl.majorVersion) {
           m_votingCompleteHeight = findVotingCompleteHeight(static_cast<uint32_t>(m_blockchain.size()) - 1);
@@ -73,6 +77,7 @@ namespace CryptoNote {
           }
         } else {
           m_votingCompleteHeight = UNDEF_HEIGHT;
+          startCounting(static_cast<uint32_t>(m_blockchain.size()) - 1);
         }
       } else if (!m_blockchain.empty()) {
         if (m_blockchain.size() <= upgradeHeight + 1) {
@@ -153,6 +158,7 @@ namespace CryptoNote {
 
       } else {
         uint32_t lastBlockHeight = static_cast<uint32_t>(m_blockchain.size()) - 1;
+        countBlock(lastBlockHeight);
         if (isVotingComplete(lastBlockHeight)) {
           m_votingCompleteHeight = lastBlockHeight;
           logger(Logging::INFO, Logging::BRIGHT_GREEN) << "###### UPGRADE voting complete at block index " << m_votingCompleteHeight <<
@@ -168,9 +174,13 @@ namespace CryptoNote {
         if (m_blockchain.size() == m_votingCompleteHeight) {
           logger(Logging::INFO, Logging::BRIGHT_YELLOW) << "###### UPGRADE after block index " << upgradeHeight() << " has been canceled!";
           m_votingCompleteHeight = UNDEF_HEIGHT;
+          // the votes weren't counted since the voting completed
+          startCounting(static_cast<uint32_t>(m_blockchain.size()) - 1);
         } else {
           assert(m_blockchain.size() > m_votingCompleteHeight);
         }
+      } else if (m_currency.upgradeHeight(m_targetVersion) == UNDEF_HEIGHT) {
+        uncountBlock(static_cast<uint32_t>(m_blockchain.size()));
       }
     }
 
@@ -193,7 +203,12 @@ namespace CryptoNote {
       assert(m_currency.upgradeHeight(m_targetVersion) == UNDEF_HEIGHT);
 
       uint32_t probableVotingCompleteHeight = probableUpgradeHeight > m_currency.maxUpgradeDistance() ? probableUpgradeHeight - m_currency.maxUpgradeDistance() : 0;
+      startCounting(probableVotingCompleteHeight);
       for (uint32_t i = probableVotingCompleteHeight; i <= probableUpgradeHeight; ++i) {
+        if (i != probableVotingCompleteHeight) {
+          countBlock(i);
+        }
+
         if (isVotingComplete(i)) {
           return i;
         }
@@ -202,12 +217,55 @@ namespace CryptoNote {
       return UNDEF_HEIGHT;
     }
 
+    bool isVote(uint32_t height) {
+      const auto& b = m_blockchain[height].bl;
+      return (b.majorVersion == m_targetVersion - 1) && (b.minorVersion == BLOCK_MINOR_VERSION_1);
+    }
+
+    // The votes of the voting window ending at the given height are kept in a ring indexed
+    // by height modulo the window, so sliding the window by one block costs O(1)
+    void startCounting(uint32_t height) {
+      uint32_t window = m_currency.upgradeVotingWindow();
+      m_votes.assign(window, false);
+      m_voteCount = 0;
+      for (uint32_t i = height + 1 >= window ? height + 1 - window : 0; i <= height; ++i) {
+        m_votes[i % window] = isVote(i);
+        m_voteCount += m_votes[i % window] ? 1 : 0;
+      }
+    }
+
+    // the block at the height enters the window, the one a window below leaves it
+    void countBlock(uint32_t height) {
+      if (m_votes.empty()) {
+        startCounting(height);
+        return;
+      }
+
+      setVote(height % m_votes.size(), isVote(height));
+    }
+
+    // the block at the height is popped, the one a window below enters the window again
+    void uncountBlock(uint32_t height) {
+      if (m_votes.empty()) {
+        return;
+      }
+
+      setVote(height % m_votes.size(), height >= m_votes.size() && isVote(static_cast<uint32_t>(height - m_votes.size())));
+    }
+
+    void setVote(size_t index, bool vote) {
+      m_voteCount -= m_votes[index] ? 1 : 0;
+      m_votes[index] = vote;
+      m_voteCount += vote ? 1 : 0;
+    }
+
     bool isVotingComplete(uint32_t height) {
       assert(m_currency.upgradeHeight(m_targetVersion) == UNDEF_HEIGHT);
       assert(m_currency.upgradeVotingWindow() > 1);
       assert(m_currency.upgradeVotingThreshold() > 0 && m_currency.upgradeVotingThreshold() <= 100);
 
-      size_t voteCounter = getNumberOfVotes(height);
+      // the window ending at the height is the counted one
+      size_t voteCounter = height < m_currency.upgradeVotingWindow() - 1 ? 0 : m_voteCount;
       return m_currency.upgradeVotingThreshold() * m_currency.upgradeVotingWindow() <= 100 * voteCounter;
     }
 
@@ -217,5 +275,7 @@ namespace CryptoNote {
     BC& m_blockchain;
     uint8_t m_targetVersion;
     uint32_t m_votingCompleteHeight;
+    std::vector<bool> m_votes;
+    size_t m_voteCount;
   };
 }
@@ -0,0 +1,126 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "ViewKeyScanner.h"
+
+#include <memory>
+
+#include "CryptoNoteFormatUtils.h"
+#include "TransactionExtra.h"
+
+namespace CryptoNote {
+
+ViewKeyScanner::ViewKeyScanner(const Crypto::SecretKey& viewSecretKey, const std::vector<Crypto::PublicKey>& spendPublicKeys) :
+  m_viewSecretKey(viewSecretKey), m_spendKeys(spendPublicKeys.begin(), spendPublicKeys.end()) {
+}
+
+void ViewKeyScanner::watch(const OutputReference& output) {
+  m_watched.insert(output);
+}
+
+std::vector<bool> ViewKeyScanner::scan(const std::vector<std::pair<Transaction, std::vector<uint32_t>>>& transactions) {
+  size_t count = transactions.size();
+  std::vector<bool> result(count, false);
+  if (count == 0) {
+    return result;
+  }
+
+  std::vector<Crypto::PublicKey> txPublicKeys(count);
+  for (size_t i = 0; i < count; ++i) {
+    txPublicKeys[i] = getTransactionPublicKeyFromExtra(transactions[i].first.extra);
+  }
+
+  std::vector<Crypto::KeyDerivation> derivations(count);
+  std::unique_ptr<bool[]> derived(new bool[count]);
+  Crypto::generate_key_derivations(txPublicKeys.data(), count, m_viewSecretKey, derivations.data(), derived.get());
+
+  std::vector<const Crypto::KeyDerivation*> keyDerivations;
+  std::vector<size_t> keyIndexes;
+  std::vector<Crypto::PublicKey> keys;
+  std::vector<std::pair<size_t, size_t>> keyOwners; // transaction and output of every key
+
+  for (size_t i = 0; i < count; ++i) {
+    if (!derived[i]) {
+      continue;
+    }
+
+    const auto& outputs = transactions[i].first.outputs;
+    for (size_t idx = 0; idx < outputs.size(); ++idx) {
+      if (outputs[idx].target.type() == typeid(KeyOutput)) {
+        keyDerivations.push_back(&derivations[i]);
+        keyIndexes.push_back(idx);
+        keys.push_back(boost::get<KeyOutput>(outputs[idx].target).key);
+        keyOwners.emplace_back(i, idx);
+      }
+    }
+  }
+
+  std::vector<std::vector<OutputReference>> found(count);
+  if (!keys.empty()) {
+    std::vector<Crypto::PublicKey> spendCandidates(keys.size());
+    std::unique_ptr<bool[]> underived(new bool[keys.size()]);
+    Crypto::underive_public_keys(keyDerivations.data(), keyIndexes.data(), keys.data(), keys.size(), spendCandidates.data(), underived.get());
+
+    for (size_t k = 0; k < keys.size(); ++k) {
+      if (!underived[k] || m_spendKeys.count(spendCandidates[k]) == 0) {
+        continue;
+      }
+
+      const auto& tx = transactions[keyOwners[k].first];
+      size_t outputIndex = keyOwners[k].second;
+      if (outputIndex < tx.second.size()) {
+        found[keyOwners[k].first].emplace_back(tx.first.outputs[outputIndex].amount, tx.second[outputIndex]);
+      }
+    }
+  }
+
+  // an output can be spent later in the same batch, so spends are checked in order before
+  // the outputs of the transaction become watched
+  for (size_t i = 0; i < count; ++i) {
+    result[i] = !found[i].empty() || spendsWatched(transactions[i].first);
+    for (const auto& output : found[i]) {
+      m_watched.insert(output);
+      m_foundOutputs.push_back(output);
+    }
+  }
+
+  return result;
+}
+
+bool ViewKeyScanner::spendsWatched(const Transaction& transaction) const {
+  if (m_watched.empty()) {
+    return false;
+  }
+
+  for (const auto& input : transaction.inputs) {
+    if (input.type() != typeid(KeyInput)) {
+      continue;
+    }
+
+    const KeyInput& in = boost::get<KeyInput>(input);
+    for (uint32_t index : relative_output_offsets_to_absolute(in.outputIndexes)) {
+      if (m_watched.count(OutputReference(in.amount, index)) != 0) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+}
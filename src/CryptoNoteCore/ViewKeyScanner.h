@@ -0,0 +1,61 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "CryptoNote.h"
+#include "crypto/crypto.h"
+
+namespace CryptoNote {
+
+// Finds the transactions of an account knowing only its view secret key and spend public keys,
+// the way the wallet consumer does, so a trusted daemon can sync a light wallet. Without the
+// spend keys no key image can be computed, so the spends are found by the rings that reference
+// a watched output: the outputs supplied by the wallet and every output found while scanning.
+class ViewKeyScanner {
+public:
+  // amount and global index of a key output
+  typedef std::pair<uint64_t, uint32_t> OutputReference;
+
+  ViewKeyScanner(const Crypto::SecretKey& viewSecretKey, const std::vector<Crypto::PublicKey>& spendPublicKeys);
+
+  void watch(const OutputReference& output);
+
+  // transactions are paired with the global indexes of their outputs and must come in chain order,
+  // returns for every transaction whether it sends to or may spend from the account
+  std::vector<bool> scan(const std::vector<std::pair<Transaction, std::vector<uint32_t>>>& transactions);
+
+  // outputs sent to the account by the scanned transactions
+  const std::vector<OutputReference>& foundOutputs() const { return m_foundOutputs; }
+
+private:
+  bool spendsWatched(const Transaction& transaction) const;
+
+  Crypto::SecretKey m_viewSecretKey;
+  std::unordered_set<Crypto::PublicKey> m_spendKeys;
+  std::set<OutputReference> m_watched;
+  std::vector<OutputReference> m_foundOutputs;
+};
+
+}
@@ -62,10 +62,26 @@ namespace CryptoNote
   struct TransactionPrefixInfo {
     Crypto::Hash txHash;
     TransactionPrefix txPrefix;
+    std::vector<uint32_t> globalIndexes; // of the outputs, only sent when asked for
 
     void serialize(ISerializer& s) {
       KV_MEMBER(txHash);
       KV_MEMBER(txPrefix);
+      if (s.type() == ISerializer::INPUT || !globalIndexes.empty()) {
+        KV_MEMBER(globalIndexes);
+      }
+    }
+  };
+
+  struct BlockFilterInfo {
+    Crypto::Hash blockId;
+    std::string filter;
+    Crypto::Hash header;
+
+    void serialize(ISerializer& s) {
+      KV_MEMBER(blockId);
+      KV_MEMBER(filter);
+      KV_MEMBER(header);
     }
   };
 
@@ -73,11 +89,15 @@ namespace CryptoNote
     Crypto::Hash blockId;
     std::string block;
     std::vector<TransactionPrefixInfo> txPrefixes;
+    std::vector<uint32_t> baseTransactionGlobalIndexes; // same as TransactionPrefixInfo::globalIndexes
 
     void serialize(ISerializer& s) {
       KV_MEMBER(blockId);
       KV_MEMBER(block);
       KV_MEMBER(txPrefixes);
+      if (s.type() == ISerializer::INPUT || !baseTransactionGlobalIndexes.empty()) {
+        KV_MEMBER(baseTransactionGlobalIndexes);
+      }
     }
   };
 
@@ -251,4 +271,109 @@ namespace CryptoNote
     const static int ID = BC_COMMANDS_POOL_BASE + 10;
     typedef NOTIFY_MISSING_TXS_request request;
   };
-}
\ No newline at end of file
+
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  struct NOTIFY_NEW_COMPACT_BLOCK_request {
+    std::string block;                          // without transaction hashes
+    Crypto::Hash blockHash;
+    uint64_t nonce;                             // salts the short ids
+    std::string short_ids;                      // of the transactions that aren't prefilled, in block order
+    std::vector<uint32_t> prefilled_indexes;    // ascending positions of prefilled_txs in the block
+    std::vector<std::string> prefilled_txs;
+    uint32_t current_blockchain_height;
+    uint32_t hop;
+
+    void serialize(ISerializer& s) {
+      KV_MEMBER(block)
+      KV_MEMBER(blockHash)
+      KV_MEMBER(nonce)
+      KV_MEMBER(short_ids)
+      serializeAsBinary(prefilled_indexes, "prefilled_indexes", s);
+      KV_MEMBER(prefilled_txs)
+      KV_MEMBER(current_blockchain_height)
+      KV_MEMBER(hop)
+    }
+  };
+
+  struct NOTIFY_NEW_COMPACT_BLOCK {
+    const static int ID = BC_COMMANDS_POOL_BASE + 11;
+    typedef NOTIFY_NEW_COMPACT_BLOCK_request request;
+  };
+
+  struct NOTIFY_REQUEST_COMPACT_TXS_request {
+    Crypto::Hash blockHash;
+    uint32_t current_blockchain_height;
+    std::vector<uint32_t> indexes;              // positions of the requested transactions in the block
+
+    void serialize(ISerializer& s) {
+      KV_MEMBER(blockHash)
+      KV_MEMBER(current_blockchain_height)
+      serializeAsBinary(indexes, "indexes", s);
+    }
+  };
+
+  struct NOTIFY_REQUEST_COMPACT_TXS {
+    const static int ID = BC_COMMANDS_POOL_BASE + 12;
+    typedef NOTIFY_REQUEST_COMPACT_TXS_request request;
+  };
+
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  struct NOTIFY_TX_INVENTORY_request {
+    std::vector<Crypto::Hash> txs;
+
+    void serialize(ISerializer& s) {
+      serializeAsBinary(txs, "txs", s);
+    }
+  };
+
+  // hashes of fluffed transactions, announced periodically instead of the full blobs
+  struct NOTIFY_TX_INVENTORY {
+    const static int ID = BC_COMMANDS_POOL_BASE + 13;
+    typedef NOTIFY_TX_INVENTORY_request request;
+  };
+
+  // asks for announced transactions we don't have yet
+  struct NOTIFY_REQUEST_TXS {
+    const static int ID = BC_COMMANDS_POOL_BASE + 14;
+    typedef NOTIFY_TX_INVENTORY_request request;
+  };
+
+  // answers NOTIFY_REQUEST_TXS with the transactions found in the pool or the chain
+  struct NOTIFY_RESPONSE_TXS {
+    const static int ID = BC_COMMANDS_POOL_BASE + 15;
+    typedef NOTIFY_NEW_TRANSACTIONS_request request;
+  };
+
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  struct NOTIFY_REQUEST_BLOCK_HEADERS_request {
+    std::vector<Crypto::Hash> block_ids;
+
+    void serialize(ISerializer& s) {
+      serializeAsBinary(block_ids, "block_ids", s);
+    }
+  };
+
+  struct NOTIFY_REQUEST_BLOCK_HEADERS {
+    const static int ID = BC_COMMANDS_POOL_BASE + 16;
+    typedef NOTIFY_REQUEST_BLOCK_HEADERS_request request;
+  };
+
+  struct NOTIFY_RESPONSE_BLOCK_HEADERS_request {
+    std::vector<std::string> headers;           // header blobs of the requested blocks, in the same order
+
+    void serialize(ISerializer& s) {
+      KV_MEMBER(headers)
+    }
+  };
+
+  struct NOTIFY_RESPONSE_BLOCK_HEADERS {
+    const static int ID = BC_COMMANDS_POOL_BASE + 17;
+    typedef NOTIFY_RESPONSE_BLOCK_HEADERS_request request;
+  };
+}
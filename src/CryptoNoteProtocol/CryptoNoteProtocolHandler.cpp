@@ -22,14 +22,22 @@
 
 #include "CryptoNoteProtocolHandler.h"
 
+#include <algorithm>
+#include <cstring>
 #include <future>
+#include <limits>
 #include <random>
 #include <boost/optional.hpp>
 #include <boost/scope_exit.hpp>
+#include <boost/uuid/nil_generator.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <System/Dispatcher.h>
+#include <System/InterruptedException.h>
+#include <System/RemoteContext.h>
 
+#include "Common/Metrics.h"
 #include "Common/ShuffleGenerator.h"
+#include "Common/Tracing.h"
 #include "CryptoNoteCore/CryptoNoteBasicImpl.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
@@ -56,6 +64,46 @@ void relay_post_notify(IP2pEndpoint& p2p, typename t_parametr::request& arg, con
   p2p.externalRelayNotifyToAll(t_parametr::ID, LevinProtocol::encode(arg), excludeConnection);
 }
 
+// the connections a block goes to, with their round trip times
+typedef std::vector<std::pair<std::chrono::microseconds, boost::uuids::uuid>> RelayPeers;
+
+// the peers with the lowest measured latency first, so the block gets across the network sooner
+std::list<boost::uuids::uuid> orderByLatency(RelayPeers& peers) {
+  std::stable_sort(peers.begin(), peers.end(), [](const RelayPeers::value_type& a, const RelayPeers::value_type& b) {
+    return a.first.count() != 0 && (b.first.count() == 0 || a.first < b.first);
+  });
+
+  std::list<boost::uuids::uuid> ids;
+  for (const auto& peer : peers) {
+    ids.push_back(peer.second);
+  }
+
+  return ids;
+}
+
+// block download pipelining
+const size_t SYNC_MAX_REQUESTS_IN_FLIGHT = 2;                                       // per connection
+const size_t SYNC_MIN_CHUNK_SIZE = BLOCKS_SYNCHRONIZING_DEFAULT_COUNT / 8;
+const size_t SYNC_MAX_CHUNK_SIZE = BLOCKS_SYNCHRONIZING_DEFAULT_COUNT * 2;          // well below CURRENCY_PROTOCOL_MAX_OBJECT_REQUEST_COUNT
+const size_t SYNC_MAX_PENDING_BLOCKS = BLOCKS_SYNCHRONIZING_DEFAULT_COUNT * 16;     // requested and buffered blocks, bounds the reorder buffer
+
+// transaction announcements
+const size_t TX_INVENTORY_MAX_COUNT = 5000;                                         // hashes per announcement or request
+const time_t TX_REQUEST_TIMEOUT = 30;                                               // seconds before another announcer is asked
+const std::chrono::milliseconds SYNC_CHUNK_TARGET_TIME(3000);                       // chunk sizes are tuned for responses to take that long
+const std::chrono::seconds SYNC_REQUEST_TIMEOUT(120);
+const uint64_t SYNC_BLOCK_ENTRY_OVERHEAD = 1024;                                    // bytes of a block_complete_entry besides the blobs
+
+// messages carrying hashes and ids only
+const uint64_t CONTROL_MESSAGE_MAX_SIZE = 4 * 1024 * 1024;
+
+// sync peer quality
+const unsigned SYNC_PEERS_CHECK_INTERVAL = 30;                                      // seconds
+const uint64_t SYNC_SLOW_PEER_RATIO = 2;                                            // below the median speed divided by it a peer gets a request at a time
+const uint64_t SYNC_TOO_SLOW_PEER_RATIO = 8;                                        // and below this it is a candidate for being dropped
+const uint32_t SYNC_TOO_SLOW_PEER_CHECKS = 3;                                       // in a row before the peer is dropped during the initial sync
+const size_t SYNC_MIN_PEERS_TO_DROP_SLOW = 4;                                       // measured peers needed to tell slow ones
+
 }
 
 CryptoNoteProtocolHandler::CryptoNoteProtocolHandler(const Currency& currency, System::Dispatcher& dispatcher, ICore& rcore, IP2pEndpoint* p_net_layout, Logging::ILogger& log) :
@@ -66,11 +114,17 @@ CryptoNoteProtocolHandler::CryptoNoteProtocolHandler(const Currency& currency, S
   m_synchronized(false),
   m_stop(false),
   m_observedHeight(0),
+  m_processingBufferedBlocks(false),
+  m_blocksProcessingContext(dispatcher),
+  m_syncPeersCheckInterval(SYNC_PEERS_CHECK_INTERVAL),
+  m_syncMedianSpeed(0),
+  m_invalidSyncResponses(0),
   m_peersCount(0),
   m_dandelionStemSelectInterval(CryptoNote::parameters::DANDELION_EPOCH),
-  m_dandelionStemFluffInterval(CryptoNote::parameters::DANDELION_STEM_EMBARGO),
   logger(log, "protocol"),
-  m_stemPool() {
+  m_stemPool(CryptoNote::parameters::DANDELION_STEM_POOL_MAX_COUNT, CryptoNote::parameters::DANDELION_STEM_POOL_MAX_SIZE,
+    CryptoNote::parameters::DANDELION_STEM_EMBARGO),
+  m_txInventoryInterval(CryptoNote::P2P_TX_INVENTORY_INTERVAL) {
   
   if (!m_p2p) {
     m_p2p = &m_p2p_stub;
@@ -92,6 +146,8 @@ void CryptoNoteProtocolHandler::onConnectionOpened(CryptoNoteConnectionContext&
 }
 
 void CryptoNoteProtocolHandler::onConnectionClosed(CryptoNoteConnectionContext& context) {
+  releaseSyncRequests(context);
+
   bool updated = false;
   {
     std::lock_guard<std::mutex> lock(m_observedHeightMutex);
@@ -115,6 +171,11 @@ void CryptoNoteProtocolHandler::onConnectionClosed(CryptoNoteConnectionContext&
 
 void CryptoNoteProtocolHandler::stop() {
   m_stop = true;
+  m_blocksProcessingContext.interrupt();
+}
+
+void CryptoNoteProtocolHandler::waitBlocksProcessing() {
+  m_blocksProcessingContext.wait();
 }
 
 bool CryptoNoteProtocolHandler::start_sync(CryptoNoteConnectionContext& context) {
@@ -137,6 +198,35 @@ bool CryptoNoteProtocolHandler::get_stat_info(core_stat_info& stat_inf) {
   return m_core.get_stat_info(stat_inf);
 }
 
+void CryptoNoteProtocolHandler::writeMetrics(std::ostream& out) const {
+  size_t requestedBlocks = 0;
+  for (const auto& block : m_blocksInFlight) {
+    if (!block.second.is_nil()) {
+      ++requestedBlocks;
+    }
+  }
+
+  size_t bufferedBlocks = 0;
+  for (const auto& chunk : m_reorderBuffer) {
+    bufferedBlocks += chunk.second.blocks.size();
+  }
+
+  writeMetricHeader(out, "karbo_sync_requested_blocks", "gauge", "Blocks requested from peers and not received yet.");
+  out << "karbo_sync_requested_blocks " << requestedBlocks << '\n';
+  writeMetricHeader(out, "karbo_sync_buffered_blocks", "gauge", "Received blocks waiting in the reorder buffer.");
+  out << "karbo_sync_buffered_blocks " << bufferedBlocks << '\n';
+  writeMetricHeader(out, "karbo_sync_median_peer_speed_bytes", "gauge", "Median download speed of the synchronizing peers, in bytes per second.");
+  out << "karbo_sync_median_peer_speed_bytes " << m_syncMedianSpeed << '\n';
+  writeMetricHeader(out, "karbo_sync_invalid_responses_total", "counter", "Rejected responses to block requests.");
+  out << "karbo_sync_invalid_responses_total " << m_invalidSyncResponses << '\n';
+  writeMetricHeader(out, "karbo_sync_requested_transactions", "gauge", "Announced transactions requested from peers and not received yet.");
+  out << "karbo_sync_requested_transactions " << m_requestedTxs.size() << '\n';
+  writeMetricHeader(out, "karbo_dandelion_stem_transactions", "gauge", "Stem transactions waiting for their embargo to end.");
+  out << "karbo_dandelion_stem_transactions " << m_stemPool.getTransactionsCount() << '\n';
+  writeMetricHeader(out, "karbo_dandelion_stem_bytes", "gauge", "Size of the stem transactions waiting for their embargo to end.");
+  out << "karbo_dandelion_stem_bytes " << m_stemPool.getSize() << '\n';
+}
+
 void CryptoNoteProtocolHandler::log_connections() {
   std::stringstream ss;
 
@@ -150,7 +240,7 @@ void CryptoNoteProtocolHandler::log_connections() {
     ss << std::setw(25) << std::left << std::string(cntxt.m_is_income ? "[INC]" : "[OUT]") +
       Common::ipAddressToString(cntxt.m_remote_ip) + ":" + std::to_string(cntxt.m_remote_port)
       << std::setw(20) << std::hex << peer_id
-      // << std::setw(25) << std::to_string(cntxt.m_recv_cnt) + "(" + std::to_string(time(NULL) - cntxt.m_last_recv) + ")" + "/" + std::to_string(cntxt.m_send_cnt) + "(" + std::to_string(time(NULL) - cntxt.m_last_send) + ")"
+      << std::setw(25) << std::to_string(cntxt.m_recv_cnt) + "(" + std::to_string(time(NULL) - cntxt.m_last_recv) + ")" + "/" + std::to_string(cntxt.m_send_cnt) + "(" + std::to_string(time(NULL) - cntxt.m_last_send) + ")"
       << std::setw(25) << get_protocol_state_string(cntxt.m_state)
       << std::setw(20) << std::to_string(time(NULL) - cntxt.m_started) << ENDL;
   });
@@ -226,7 +316,7 @@ bool CryptoNoteProtocolHandler::get_payload_sync_data(CORE_SYNC_DATA& hshd) {
 }
 
 template <typename Command, typename Handler>
-int notifyAdaptor(const BinaryArray& reqBuf, CryptoNoteConnectionContext& ctx, Handler handler) {
+int notifyAdaptor(BinaryArray& reqBuf, CryptoNoteConnectionContext& ctx, Handler handler) {
 
   typedef typename Command::request Request;
   int command = Command::ID;
@@ -236,12 +326,14 @@ int notifyAdaptor(const BinaryArray& reqBuf, CryptoNoteConnectionContext& ctx, H
     throw std::runtime_error("Failed to load_from_binary in command " + std::to_string(command));
   }
 
+  // the request holds the data now, the message isn't kept during the handling
+  BinaryArray().swap(reqBuf);
   return handler(command, req, ctx);
 }
 
 #define HANDLE_NOTIFY(CMD, Handler) case CMD::ID: { ret = notifyAdaptor<CMD>(in, ctx, std::bind(Handler, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)); break; }
 
-int CryptoNoteProtocolHandler::handleCommand(bool is_notify, int command, const BinaryArray& in, BinaryArray& out, CryptoNoteConnectionContext& ctx, bool& handled) {
+int CryptoNoteProtocolHandler::handleCommand(bool is_notify, int command, BinaryArray& in, BinaryArray& out, CryptoNoteConnectionContext& ctx, bool& handled) {
   int ret = 0;
   handled = true;
 
@@ -255,6 +347,13 @@ int CryptoNoteProtocolHandler::handleCommand(bool is_notify, int command, const
     HANDLE_NOTIFY(NOTIFY_REQUEST_TX_POOL, &CryptoNoteProtocolHandler::handle_request_tx_pool)
     HANDLE_NOTIFY(NOTIFY_NEW_LITE_BLOCK, &CryptoNoteProtocolHandler::handle_notify_new_lite_block)
     HANDLE_NOTIFY(NOTIFY_MISSING_TXS, &CryptoNoteProtocolHandler::handle_notify_missing_txs)
+    HANDLE_NOTIFY(NOTIFY_TX_INVENTORY, &CryptoNoteProtocolHandler::handle_notify_tx_inventory)
+    HANDLE_NOTIFY(NOTIFY_REQUEST_TXS, &CryptoNoteProtocolHandler::handle_notify_request_txs)
+    HANDLE_NOTIFY(NOTIFY_RESPONSE_TXS, &CryptoNoteProtocolHandler::handle_notify_response_txs)
+    HANDLE_NOTIFY(NOTIFY_REQUEST_BLOCK_HEADERS, &CryptoNoteProtocolHandler::handle_request_block_headers)
+    HANDLE_NOTIFY(NOTIFY_RESPONSE_BLOCK_HEADERS, &CryptoNoteProtocolHandler::handle_response_block_headers)
+    HANDLE_NOTIFY(NOTIFY_NEW_COMPACT_BLOCK, &CryptoNoteProtocolHandler::handle_notify_new_compact_block)
+    HANDLE_NOTIFY(NOTIFY_REQUEST_COMPACT_TXS, &CryptoNoteProtocolHandler::handle_notify_request_compact_txs)
 
   default:
     handled = false;
@@ -265,7 +364,33 @@ int CryptoNoteProtocolHandler::handleCommand(bool is_notify, int command, const
 
 #undef HANDLE_NOTIFY
 
+uint64_t CryptoNoteProtocolHandler::getMaxMessageSize(int command, const CryptoNoteConnectionContext& context) const {
+  switch (command) {
+  case NOTIFY_REQUEST_GET_OBJECTS::ID:
+  case NOTIFY_REQUEST_CHAIN::ID:
+  case NOTIFY_RESPONSE_CHAIN_ENTRY::ID:
+  case NOTIFY_MISSING_TXS::ID:
+  case NOTIFY_REQUEST_COMPACT_TXS::ID:
+  case NOTIFY_TX_INVENTORY::ID:
+  case NOTIFY_REQUEST_TXS::ID:
+  case NOTIFY_REQUEST_BLOCK_HEADERS::ID:
+    return CONTROL_MESSAGE_MAX_SIZE;
+
+  case NOTIFY_RESPONSE_GET_OBJECTS::ID: {
+    // as many blocks as the oldest request in flight asked for, requests released meanwhile may
+    // still be answered with up to a full chunk
+    size_t blocks = context.m_requested_chunks.empty() ? SYNC_MAX_CHUNK_SIZE : context.m_requested_chunks.front().first;
+    uint64_t blockSize = m_currency.maxBlockCumulativeSize(context.m_remote_blockchain_height);
+    return blocks * (blockSize + SYNC_BLOCK_ENTRY_OVERHEAD);
+  }
+
+  default:
+    return 0;
+  }
+}
+
 int CryptoNoteProtocolHandler::handle_notify_new_block(int command, NOTIFY_NEW_BLOCK::request& arg, CryptoNoteConnectionContext& context) {
+  TraceSpan span("protocol", "notify_new_block");
   logger(Logging::TRACE) << context << "NOTIFY_NEW_BLOCK (hop " << arg.hop << ")";
 
   updateObservedHeight(arg.current_blockchain_height, context);
@@ -276,6 +401,13 @@ int CryptoNoteProtocolHandler::handle_notify_new_block(int command, NOTIFY_NEW_B
     return 1;
   }
 
+  Block b;
+  if (fromBinaryArray(b, asBinaryArray(arg.b.block))) {
+    Crypto::Hash blockHash = get_block_hash(b);
+    span.setPodId(blockHash);
+    context.m_known_objects.insert(blockHash);
+  }
+
   for (auto tx_blob_it = arg.b.txs.begin(); tx_blob_it != arg.b.txs.end(); tx_blob_it++) {
     CryptoNote::tx_verification_context tvc = boost::value_initialized<decltype(tvc)>();
 
@@ -300,10 +432,7 @@ int CryptoNoteProtocolHandler::handle_notify_new_block(int command, NOTIFY_NEW_B
   }
   if (bvc.m_added_to_main_chain) {
     ++arg.hop;
-    //TODO: Add here announce protocol usage
-    //relay_post_notify<NOTIFY_NEW_BLOCK>(*m_p2p, arg, &context.m_connection_id);
-    relay_block(arg);
-    // relay_block(arg, context);
+    relayBlock(arg);
 
     if (bvc.m_switched_to_alt_chain) {
       requestMissingPoolTransactions(context);
@@ -324,9 +453,15 @@ int CryptoNoteProtocolHandler::handle_notify_new_transactions(int command, NOTIF
   if (context.m_state != CryptoNoteConnectionContext::state_normal)
     return 1;
 
-  std::vector<Crypto::Hash> txHashes;
-
-  if (context.m_pending_lite_block) {
+  if (context.m_pending_compact_block) {
+    logger(Logging::TRACE) << context
+      << " Pending compact block detected, handling request as missing compact block transactions response";
+    std::vector<BinaryArray> _txs;
+    for (const auto& tx : arg.txs) {
+      _txs.push_back(asBinaryArray(tx));
+    }
+    return doPushCompactBlock(context.m_pending_compact_block->request, context, std::move(_txs));
+  } else if (context.m_pending_lite_block) {
     logger(Logging::TRACE) << context
       << " Pending lite block detected, handling request as missing lite block transactions response";
     std::vector<BinaryArray> _txs;
@@ -334,82 +469,68 @@ int CryptoNoteProtocolHandler::handle_notify_new_transactions(int command, NOTIF
       _txs.push_back(asBinaryArray(tx));
     }
     return doPushLiteBlock(context.m_pending_lite_block->request, context, std::move(_txs));
-  } else {
-    for (auto tx_blob_it = arg.txs.begin(); tx_blob_it != arg.txs.end();) {
-      auto transactionBinary = asBinaryArray(*tx_blob_it);
-      Crypto::Hash transactionHash = Crypto::cn_fast_hash(transactionBinary.data(), transactionBinary.size());
-      logger(DEBUGGING) << "Transaction " << transactionHash << " came in NOTIFY_NEW_TRANSACTIONS"
-                        << " as " << (arg.stem ? "stem" : "fluff");
-      CryptoNote::tx_verification_context tvc = boost::value_initialized<decltype(tvc)>();
-      m_core.handle_incoming_tx(transactionBinary, tvc, false);
-      if (tvc.m_verification_failed) {
-        logger(Logging::DEBUGGING) << context << "Transaction verification failed";
-      }
-      if (!tvc.m_verification_failed && tvc.m_should_be_relayed) {
-        if (!arg.stem) {
-          if (m_stemPool.hasTransaction(transactionHash)) {
-            logger(Logging::DEBUGGING) << "Removing transaction " << transactionHash << " from stempool as already broadcasted";
-            m_stemPool.removeTransaction(transactionHash);
-          }
-        }
-        else {
-          txHashes.push_back(transactionHash);
-          if (!m_stemPool.hasTransaction(transactionHash)) {
-            logger(Logging::DEBUGGING) << "Adding transaction " << transactionHash << " to stempool";
-            m_stemPool.addTransaction(transactionHash, *tx_blob_it);
-          }
-          else { // tx made roundtrip as stem, fluff it
-            logger(Logging::DEBUGGING) << "Removing transaction " << transactionHash << " from stempool and fluff";
-            m_stemPool.removeTransaction(transactionHash);
-            txHashes.erase(std::remove(txHashes.begin(), txHashes.end(), transactionHash), txHashes.end());
-            arg.stem = false;
-          }
+  }
+
+  return processNewTransactions(arg, context);
+}
+
+int CryptoNoteProtocolHandler::processNewTransactions(NOTIFY_NEW_TRANSACTIONS::request& arg, CryptoNoteConnectionContext& context) {
+  TraceSpan span("protocol", "new_transactions");
+  span.setId(arg.txs.size());
+  std::vector<Crypto::Hash> txHashes;
+
+  std::vector<BinaryArray> transactionBinaries;
+  transactionBinaries.reserve(arg.txs.size());
+  for (const auto& tx : arg.txs) {
+    transactionBinaries.push_back(asBinaryArray(tx));
+  }
+
+  std::vector<CryptoNote::tx_verification_context> tvcs;
+  m_core.handle_incoming_txs(transactionBinaries, tvcs);
+
+  size_t txIndex = 0;
+  for (auto tx_blob_it = arg.txs.begin(); tx_blob_it != arg.txs.end(); ++txIndex) {
+    const auto& transactionBinary = transactionBinaries[txIndex];
+    Crypto::Hash transactionHash = Crypto::cn_fast_hash(transactionBinary.data(), transactionBinary.size());
+    context.m_known_objects.insert(transactionHash);
+    logger(DEBUGGING) << "Transaction " << transactionHash << " came in NOTIFY_NEW_TRANSACTIONS"
+                      << " as " << (arg.stem ? "stem" : "fluff");
+    const CryptoNote::tx_verification_context& tvc = tvcs[txIndex];
+    if (tvc.m_verification_failed) {
+      logger(Logging::DEBUGGING) << context << "Transaction verification failed";
+    }
+    if (!tvc.m_verification_failed && tvc.m_should_be_relayed) {
+      if (!arg.stem) {
+        if (m_stemPool.removeTransaction(transactionHash)) {
+          logger(Logging::DEBUGGING) << "Removed transaction " << transactionHash << " from stempool as already broadcasted";
         }
-        ++tx_blob_it;
       }
-      else {
-        if (m_stemPool.hasTransaction(transactionHash)) {
-          logger(Logging::DEBUGGING) << "Removing transaction " << transactionHash << " from stempool as already broadcasted";
-          m_stemPool.removeTransaction(transactionHash);
-        }
-        tx_blob_it = arg.txs.erase(tx_blob_it);
+      else if (addStemTransaction(transactionHash, *tx_blob_it)) {
+        txHashes.push_back(transactionHash);
       }
+      else { // tx made roundtrip as stem, fluff it
+        logger(Logging::DEBUGGING) << "Removing transaction " << transactionHash << " from stempool and fluff";
+        m_stemPool.removeTransaction(transactionHash);
+        arg.stem = false;
+      }
+      ++tx_blob_it;
+    }
+    else {
+      if (m_stemPool.removeTransaction(transactionHash)) {
+        logger(Logging::DEBUGGING) << "Removed transaction " << transactionHash << " from stempool as already broadcasted";
+      }
+      tx_blob_it = arg.txs.erase(tx_blob_it);
     }
   }
 
   if (arg.txs.size()) {
-    //TODO: add announce usage here
-    if (arg.stem && !m_dandelion_stem.empty()) {
-      std::mt19937 rng = Random::generator();
-      std::uniform_int_distribution<> dis(0, 100);
-      auto coin_flip = dis(rng);
-      if (coin_flip < CryptoNote::parameters::DANDELION_STEM_TX_PROPAGATION_PROBABILITY) { // Stem propagation
-        for (const auto& dandelion_peer : m_dandelion_stem) {
-          if (dandelion_peer.m_state == CryptoNoteConnectionContext::state_normal || dandelion_peer.m_state == CryptoNoteConnectionContext::state_synchronizing) {
-            if (!post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, arg, dandelion_peer)) {
-              arg.stem = false;
-              logger(Logging::DEBUGGING) << "Failed to relay transactions to Dandelion peer " << dandelion_peer.m_connection_id << ", remove from stempool and broadcast as fluff:";
-              for (const auto& h : txHashes) {
-                m_stemPool.removeTransaction(h);
-                logger(Logging::DEBUGGING) << h;
-              }
-              relay_post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, arg, &context.m_connection_id); // Fluff broadcast
-              break;
-            }
-          }
-        }
-      } else { // Switch to fluff broadcast
-        arg.stem = false;
-        logger(Logging::DEBUGGING) << "Switching to fluff broadcast of stem transactions:";
-        for (const auto& h : txHashes) {
-          m_stemPool.removeTransaction(h);
-          logger(Logging::DEBUGGING) << h;
-        }
-        relay_post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, arg, &context.m_connection_id);
-      }
+    if (arg.stem) {
+      relayStemTransactions(arg, txHashes, context.m_connection_id, &context.m_connection_id);
     } else { // Fluff broadcast
-      arg.stem = false;
-      relay_post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, arg, &context.m_connection_id);
+      for (const auto& h : txHashes) {
+        m_stemPool.removeTransaction(h);
+      }
+      relayFluffTransactions(arg, &context.m_connection_id);
     }
   }
 
@@ -455,6 +576,7 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
   if (arg.blocks.empty())
   {
     logger(Logging::ERROR) << context << "sent wrong NOTIFY_HAVE_OBJECTS: no blocks, dropping connection";
+    countInvalidResponse(context);
     m_p2p->drop_connection(context, true);
     return 1;
   }
@@ -462,6 +584,7 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
   if (context.m_last_response_height > arg.current_blockchain_height) {
     logger(Logging::ERROR) << context << "sent wrong NOTIFY_HAVE_OBJECTS: arg.m_current_blockchain_height=" << arg.current_blockchain_height
       << " < m_last_response_height=" << context.m_last_response_height << ", dropping connection";
+    countInvalidResponse(context);
     context.m_state = CryptoNoteConnectionContext::state_shutdown;
     return 1;
   }
@@ -470,23 +593,37 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
 
   context.m_remote_blockchain_height = arg.current_blockchain_height;
 
+  if (context.m_requested_chunks.empty() && context.m_state == CryptoNoteConnectionContext::state_idle) {
+    logger(Logging::DEBUGGING) << context << "Ignoring blocks requested before the connection was set to idle state";
+    return 1;
+  }
+
+  if (context.m_requested_chunks.empty() || context.m_requested_chunks.front().first != arg.blocks.size()) {
+    logger(Logging::ERROR, Logging::BRIGHT_RED) << context << "returned not the requested number of objects (" << arg.blocks.size()
+      << " blocks), dropping connection";
+    countInvalidResponse(context);
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
   size_t count = 0;
-  std::vector<Crypto::Hash> block_hashes;
-  block_hashes.reserve(arg.blocks.size());
+  uint64_t bytes = 0;
   std::vector<parsed_block_entry> parsed_blocks;
   parsed_blocks.reserve(arg.blocks.size());
-  for (const block_complete_entry& block_entry : arg.blocks) {
+  for (block_complete_entry& block_entry : arg.blocks) {
     ++count;
     Block b;
     BinaryArray block_blob = asBinaryArray(block_entry.block);
     if (block_blob.size() > m_currency.maxBlockBlobSize()) {
       logger(Logging::ERROR) << context << "sent wrong block: too big size " << block_blob.size() << ", dropping connection";
+      countInvalidResponse(context);
       context.m_state = CryptoNoteConnectionContext::state_shutdown;
       return 1;
     }
     if (!fromBinaryArray(b, block_blob)) {
       logger(Logging::ERROR) << context << "sent wrong block: failed to parse and validate block: \r\n"
         << toHex(block_blob) << "\r\n dropping connection";
+      countInvalidResponse(context);
       context.m_state = CryptoNoteConnectionContext::state_shutdown;
       return 1;
     }
@@ -497,7 +634,7 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
       if (m_core.have_block(blockHash)) {
         context.m_state = CryptoNoteConnectionContext::state_idle;
         context.m_needed_objects.clear();
-        context.m_requested_objects.clear();
+        releaseSyncRequests(context);
         logger(Logging::DEBUGGING) << context << "Connection set to idle state.";
         return 1;
       }
@@ -507,83 +644,336 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
     if (req_it == context.m_requested_objects.end()) {
       logger(Logging::ERROR) << context << "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: block with id=" << Common::podToHex(blockHash)
         << " wasn't requested, dropping connection";
+      countInvalidResponse(context);
       context.m_state = CryptoNoteConnectionContext::state_shutdown;
       return 1;
     }
     if (b.transactionHashes.size() != block_entry.txs.size()) {
       logger(Logging::ERROR) << context << "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: block with id=" << Common::podToHex(blockHash)
         << ", transactionHashes.size()=" << b.transactionHashes.size() << " mismatch with block_complete_entry.m_txs.size()=" << block_entry.txs.size() << ", dropping connection";
+      countInvalidResponse(context);
       context.m_state = CryptoNoteConnectionContext::state_shutdown;
       return 1;
     }
 
     context.m_requested_objects.erase(req_it);
 
-    block_hashes.push_back(blockHash);
-
+    // the blobs are released as they are converted, so the response isn't held twice
     parsed_block_entry parsedBlock;
     parsedBlock.block = std::move(b);
+    bytes += block_entry.block.size();
+    std::string().swap(block_entry.block);
+    parsedBlock.txs.reserve(block_entry.txs.size());
     for (auto& tx_blob : block_entry.txs) {
-      auto transactionBinary = asBinaryArray(tx_blob);
-      parsedBlock.txs.push_back(transactionBinary);
+      bytes += tx_blob.size();
+      parsedBlock.txs.push_back(asBinaryArray(tx_blob));
+      std::string().swap(tx_blob);
     }
-    parsed_blocks.push_back(parsedBlock);
+    parsed_blocks.push_back(std::move(parsedBlock));
   }
 
-  if (context.m_requested_objects.size()) {
-    logger(Logging::ERROR, Logging::BRIGHT_RED) << context <<
-      "returned not all requested objects (context.m_requested_objects.size()="
-      << context.m_requested_objects.size() << "), dropping connection";
-    context.m_state = CryptoNoteConnectionContext::state_shutdown;
-    return 1;
+  // adapt the chunk size to the throughput of the peer, pipelined requests are timed from the previous response
+  auto now = std::chrono::steady_clock::now();
+  auto started = std::max(context.m_requested_chunks.front().second, context.m_last_objects_response_time);
+  auto elapsed = std::max<std::chrono::milliseconds>(std::chrono::duration_cast<std::chrono::milliseconds>(now - started), std::chrono::milliseconds(1));
+  size_t estimate = static_cast<size_t>(parsed_blocks.size() * SYNC_CHUNK_TARGET_TIME.count() / elapsed.count());
+  context.m_sync_chunk_size = std::max(SYNC_MIN_CHUNK_SIZE, std::min(SYNC_MAX_CHUNK_SIZE, (context.m_sync_chunk_size + estimate) / 2));
+  uint64_t speed = bytes * 1000 / static_cast<uint64_t>(elapsed.count());
+  context.m_download_speed = context.m_download_speed == 0 ? speed : (context.m_download_speed * 3 + speed) / 4;
+  context.m_requested_chunks.pop_front();
+  context.m_last_objects_response_time = now;
+
+  // the blocks are no longer in flight, but stay claimed until they are added to the chain
+  for (const auto& entry : parsed_blocks) {
+    m_blocksInFlight[get_block_hash(entry.block)] = boost::uuids::nil_uuid();
+  }
+
+  // the blocks are validated by the processing context, meanwhile the connection goes on downloading
+  const Crypto::Hash& previousBlockHash = parsed_blocks.front().block.previousBlockHash;
+  if (m_reorderBuffer.count(previousBlockHash) == 0) {
+    logger(Logging::DEBUGGING) << context << "Queueing " << parsed_blocks.size() << " blocks after " << Common::podToHex(previousBlockHash);
+    m_reorderBuffer.emplace(previousBlockHash, BufferedBlocks{ context.m_connection_id, std::move(parsed_blocks) });
+    startBlocksProcessing();
+  } else {
+    forgetDownloadedBlocks(parsed_blocks);
+  }
+
+  // with no more ids to fetch the next chain request is made once the blocks are added
+  if (!m_stop && context.m_state == CryptoNoteConnectionContext::state_synchronizing && !context.m_needed_objects.empty()) {
+    request_missing_objects(context, true);
   }
 
+  return 1;
+}
+
+int CryptoNoteProtocolHandler::processDownloadedBlocks(CryptoNoteConnectionContext& context, std::vector<parsed_block_entry>& parsed_blocks) {
+  BOOST_SCOPE_EXIT_ALL(this, &parsed_blocks) { forgetDownloadedBlocks(parsed_blocks); };
+
+  m_core.pause_mining();
+
+  // dismiss what another connection might already have done (likely everything)
   uint32_t height;
   Crypto::Hash top;
-  {
-    m_core.pause_mining();
-
-    // we lock all the rest to avoid having multiple connections redo a lot
-    // of the same work, and one of them doing it for nothing: subsequent
-    // connections will wait until the current one's added its blocks, then
-    // will add any extra it has, if any
-    std::lock_guard<std::recursive_mutex> lk(m_sync_lock);
-
-    // dismiss what another connection might already have done (likely everything)
-    m_core.get_blockchain_top(height, top);
-    uint64_t dismiss = 1;
-    for (const auto &h : block_hashes) {
-      if (top == h) {
-        logger(Logging::DEBUGGING) << "Found current top block in synced blocks, dismissing "
-          << dismiss << "/" << arg.blocks.size() << " blocks";
-        while (dismiss--) {
-          arg.blocks.erase(arg.blocks.begin());
-          parsed_blocks.erase(parsed_blocks.begin());
+  m_core.get_blockchain_top(height, top);
+  auto topIt = std::find_if(parsed_blocks.begin(), parsed_blocks.end(), [&top](const parsed_block_entry& entry) {
+    return get_block_hash(entry.block) == top;
+  });
+  if (topIt != parsed_blocks.end()) {
+    size_t dismiss = static_cast<size_t>(std::distance(parsed_blocks.begin(), topIt)) + 1;
+    logger(Logging::DEBUGGING) << "Found current top block in synced blocks, dismissing "
+      << dismiss << "/" << parsed_blocks.size() << " blocks";
+    for (auto it = parsed_blocks.begin(); it != topIt + 1; ++it) {
+      m_blocksInFlight.erase(get_block_hash(it->block));
+    }
+
+    parsed_blocks.erase(parsed_blocks.begin(), topIt + 1);
+  }
+
+  BOOST_SCOPE_EXIT_ALL(this) { m_core.update_block_template_and_resume_mining(); };
+
+  return processObjects(context, parsed_blocks);
+}
+
+void CryptoNoteProtocolHandler::startBlocksProcessing() {
+  if (m_processingBufferedBlocks || m_stop) {
+    return;
+  }
+
+  m_processingBufferedBlocks = true;
+  m_blocksProcessingContext.spawn([this] { processBufferedBlocks(); });
+}
+
+void CryptoNoteProtocolHandler::processBufferedBlocks() {
+  BOOST_SCOPE_EXIT_ALL(this) { m_processingBufferedBlocks = false; };
+
+  try {
+    while (!m_stop) {
+      uint32_t height;
+      Crypto::Hash top;
+      m_core.get_blockchain_top(height, top);
+      auto it = m_reorderBuffer.find(top);
+      if (it == m_reorderBuffer.end()) {
+        // a chunk may as well continue an alternative chain
+        it = std::find_if(m_reorderBuffer.begin(), m_reorderBuffer.end(), [this](const std::pair<const Crypto::Hash, BufferedBlocks>& chunk) {
+          return m_core.have_block(chunk.first);
+        });
+        if (it == m_reorderBuffer.end()) {
+          break;
         }
-        break;
       }
-      ++dismiss;
+
+      BufferedBlocks buffered = std::move(it->second);
+      m_reorderBuffer.erase(it);
+
+      // the peer may be gone already, its blocks are processed on its behalf
+      CryptoNoteConnectionContext provider;
+      provider.m_connection_id = buffered.peer;
+      provider.m_state = CryptoNoteConnectionContext::state_synchronizing;
+      m_p2p->for_each_connection([&provider](CryptoNoteConnectionContext& ctx, PeerIdType peerId) {
+        if (ctx.m_connection_id == provider.m_connection_id) {
+          provider.m_remote_ip = ctx.m_remote_ip;
+          provider.m_remote_port = ctx.m_remote_port;
+          provider.m_is_income = ctx.m_is_income;
+        }
+      });
+
+      logger(Logging::DEBUGGING) << provider << "Processing " << buffered.blocks.size() << " downloaded blocks";
+      processDownloadedBlocks(provider, buffered.blocks);
+
+      m_core.get_blockchain_top(height, top);
+      logger(DEBUGGING, BRIGHT_GREEN) << "Local blockchain updated, new height = " << height;
+
+      m_p2p->for_each_connection([this, &provider](CryptoNoteConnectionContext& ctx, PeerIdType peerId) {
+        if (ctx.m_connection_id != provider.m_connection_id || ctx.m_state == CryptoNoteConnectionContext::state_shutdown) {
+          return;
+        }
+
+        if (provider.m_state == CryptoNoteConnectionContext::state_shutdown) {
+          releaseSyncRequests(ctx);
+          m_p2p->drop_connection(ctx, true);
+        } else if (provider.m_state == CryptoNoteConnectionContext::state_idle) {
+          ctx.m_state = CryptoNoteConnectionContext::state_idle;
+          ctx.m_needed_objects.clear();
+          releaseSyncRequests(ctx);
+        } else if (!m_stop && ctx.m_state == CryptoNoteConnectionContext::state_synchronizing) {
+          request_missing_objects(ctx, true);
+        }
+      });
+
+      requestMoreBlocksFromWaitingPeers(provider.m_connection_id);
+    }
+  } catch (System::InterruptedException&) {
+    logger(DEBUGGING) << "Blocks processing interrupted";
+    return;
+  }
+
+  // chunks that start at a block we already have were delivered twice
+  for (auto it = m_reorderBuffer.begin(); it != m_reorderBuffer.end();) {
+    if (m_core.have_block(get_block_hash(it->second.blocks.front().block))) {
+      forgetDownloadedBlocks(it->second.blocks);
+      it = m_reorderBuffer.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void CryptoNoteProtocolHandler::forgetDownloadedBlocks(const std::vector<parsed_block_entry>& blocks) {
+  for (const auto& entry : blocks) {
+    m_blocksInFlight.erase(get_block_hash(entry.block));
+  }
+}
+
+void CryptoNoteProtocolHandler::releaseSyncRequests(CryptoNoteConnectionContext& context) {
+  for (const auto& blockHash : context.m_requested_objects) {
+    auto it = m_blocksInFlight.find(blockHash);
+    if (it != m_blocksInFlight.end() && it->second == context.m_connection_id) {
+      m_blocksInFlight.erase(it);
     }
+  }
+
+  context.m_requested_objects.clear();
+  context.m_requested_chunks.clear();
+}
+
+void CryptoNoteProtocolHandler::requestMoreBlocksFromWaitingPeers(const boost::uuids::uuid& except) {
+  if (m_stop) {
+    return;
+  }
 
-    BOOST_SCOPE_EXIT_ALL(this) { m_core.update_block_template_and_resume_mining(); };
+  // connections whose next blocks were claimed by others may have work again, the fastest get it first
+  auto waiting = [this, &except](const CryptoNoteConnectionContext& ctx) {
+    return ctx.m_connection_id != except && ctx.m_state == CryptoNoteConnectionContext::state_synchronizing &&
+      !ctx.m_needed_objects.empty() && ctx.m_requested_chunks.size() < maxSyncRequestsInFlight(ctx);
+  };
 
-    int result = processObjects(context, parsed_blocks);
-    if (result != 0) {
-      return result;
+  std::vector<std::pair<uint64_t, boost::uuids::uuid>> peers;
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& ctx, PeerIdType peerId) {
+    if (waiting(ctx)) {
+      peers.emplace_back(ctx.m_download_speed, ctx.m_connection_id);
     }
+  });
+
+  std::stable_sort(peers.begin(), peers.end(), [](const std::pair<uint64_t, boost::uuids::uuid>& a, const std::pair<uint64_t, boost::uuids::uuid>& b) {
+    return a.first > b.first;
+  });
+
+  for (const auto& peer : peers) {
+    m_p2p->for_each_connection([&](CryptoNoteConnectionContext& ctx, PeerIdType peerId) {
+      if (ctx.m_connection_id == peer.second && waiting(ctx)) {
+        request_missing_objects(ctx, true);
+      }
+    });
   }
+}
 
-  m_core.get_blockchain_top(height, top);
-  logger(DEBUGGING, BRIGHT_GREEN) << "Local blockchain updated, new height = " << height;
+size_t CryptoNoteProtocolHandler::maxSyncRequestsInFlight(const CryptoNoteConnectionContext& context) const {
+  // a slow peer holds fewer blocks the others may be waiting for
+  if (m_syncMedianSpeed != 0 && context.m_download_speed != 0 && context.m_download_speed * SYNC_SLOW_PEER_RATIO < m_syncMedianSpeed) {
+    return 1;
+  }
 
-  if (!m_stop && context.m_state == CryptoNoteConnectionContext::state_synchronizing) {
-    request_missing_objects(context, true);
+  return SYNC_MAX_REQUESTS_IN_FLIGHT;
+}
+
+bool CryptoNoteProtocolHandler::checkSyncPeers() {
+  std::vector<uint64_t> speeds;
+  m_p2p->for_each_connection([&speeds](CryptoNoteConnectionContext& ctx, PeerIdType peerId) {
+    if (ctx.m_state == CryptoNoteConnectionContext::state_synchronizing && ctx.m_download_speed != 0) {
+      speeds.push_back(ctx.m_download_speed);
+    }
+  });
+
+  if (speeds.empty()) {
+    m_syncMedianSpeed = 0;
+    return true;
   }
 
-  return 1;
+  std::nth_element(speeds.begin(), speeds.begin() + speeds.size() / 2, speeds.end());
+  m_syncMedianSpeed = speeds[speeds.size() / 2];
+
+  // during the initial sync the slowest of the peers that stay far behind the others is replaced,
+  // one at a time so the node doesn't run out of sync peers
+  bool dropSlow = !m_synchronized && speeds.size() >= SYNC_MIN_PEERS_TO_DROP_SLOW;
+  boost::uuids::uuid slowest = boost::uuids::nil_uuid();
+  uint64_t slowestSpeed = 0;
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& ctx, PeerIdType peerId) {
+    if (ctx.m_state != CryptoNoteConnectionContext::state_synchronizing || ctx.m_download_speed == 0) {
+      return;
+    }
+
+    if (!dropSlow || ctx.m_download_speed * SYNC_TOO_SLOW_PEER_RATIO >= m_syncMedianSpeed) {
+      ctx.m_slow_sync_checks = 0;
+      return;
+    }
+
+    ++ctx.m_slow_sync_checks;
+    if (ctx.m_slow_sync_checks >= SYNC_TOO_SLOW_PEER_CHECKS && (slowest.is_nil() || ctx.m_download_speed < slowestSpeed)) {
+      slowest = ctx.m_connection_id;
+      slowestSpeed = ctx.m_download_speed;
+    }
+  });
+
+  if (slowest.is_nil()) {
+    return true;
+  }
+
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& ctx, PeerIdType peerId) {
+    if (ctx.m_connection_id == slowest) {
+      logger(Logging::INFO) << ctx << "Downloads at " << ctx.m_download_speed << " bytes/s while the median is " << m_syncMedianSpeed
+        << " bytes/s, dropping connection";
+      releaseSyncRequests(ctx);
+      m_p2p->drop_connection(ctx, false);
+    }
+  });
+
+  requestMoreBlocksFromWaitingPeers(slowest);
+  return true;
+}
+
+void CryptoNoteProtocolHandler::countInvalidResponse(CryptoNoteConnectionContext& context) {
+  ++context.m_invalid_responses;
+  ++m_invalidSyncResponses;
+}
+
+void CryptoNoteProtocolHandler::dropStalledSyncRequests() {
+  auto now = std::chrono::steady_clock::now();
+  bool released = false;
+  m_p2p->for_each_connection([this, now, &released](CryptoNoteConnectionContext& ctx, PeerIdType peerId) {
+    if (!ctx.m_requested_chunks.empty() && now - ctx.m_requested_chunks.front().second > SYNC_REQUEST_TIMEOUT) {
+      logger(Logging::INFO) << ctx << "Blocks request timed out, dropping connection";
+      releaseSyncRequests(ctx);
+      m_p2p->drop_connection(ctx, false);
+      released = true;
+    }
+  });
+
+  if (released) {
+    requestMoreBlocksFromWaitingPeers(boost::uuids::nil_uuid());
+  }
 }
 
 int CryptoNoteProtocolHandler::processObjects(CryptoNoteConnectionContext& context, const std::vector<parsed_block_entry>& blocks) {
+  // validation takes long, the dispatcher keeps serving the connections until it's done
+  System::RemoteContext<int> validation(m_dispatcher, [this, &context, &blocks] {
+    return validateObjects(context, blocks);
+  });
+
+  return validation.get();
+}
+
+int CryptoNoteProtocolHandler::validateObjects(CryptoNoteConnectionContext& context, const std::vector<parsed_block_entry>& blocks) {
+  TraceSpan span("protocol", "validate_objects");
+  span.setId(blocks.size());
+  // hash the whole batch up front on all cores, the blocks below are still added one by one
+  std::vector<Block> batch;
+  batch.reserve(blocks.size());
+  for (const parsed_block_entry& block_entry : blocks) {
+    batch.push_back(block_entry.block);
+  }
+
+  m_core.precomputeLongHashes(batch);
+
   for (const parsed_block_entry& block_entry : blocks) {
     if (m_stop) {
       break;
@@ -628,12 +1018,8 @@ int CryptoNoteProtocolHandler::processObjects(CryptoNoteConnectionContext& conte
     } else if (bvc.m_already_exists) {
       logger(Logging::DEBUGGING) << context << "Block already exists, switching to idle state";
       context.m_state = CryptoNoteConnectionContext::state_idle;
-      context.m_needed_objects.clear();
-      context.m_requested_objects.clear();
       return 1;
     }
-
-    m_dispatcher.yield();
   }
 
   return 0;
@@ -641,6 +1027,7 @@ int CryptoNoteProtocolHandler::processObjects(CryptoNoteConnectionContext& conte
 
 bool CryptoNoteProtocolHandler::select_dandelion_stem() {
   m_dandelion_stem.clear();
+  m_dandelionRoutes.clear();
 
   //TODO: select from outgoing connections preferably supporting Dandelion: context.version >= P2P_VERSION_4)
 
@@ -677,35 +1064,55 @@ bool CryptoNoteProtocolHandler::select_dandelion_stem() {
 
 // Fail-safe to ensure stem txs are broadcasted
 bool CryptoNoteProtocolHandler::fluffStemPool() {
-  if (!m_stemPool.hasTransactions()) {
-    NOTIFY_NEW_TRANSACTIONS::request notification;
-    notification.stem = false;
-    logger(Logging::DEBUGGING) << "Broadcasting as fluff " << m_stemPool.getTransactionsCount() << " timeout stem transaction(s):";
-    std::vector<std::pair<Crypto::Hash, std::string>> stemTxs = m_stemPool.getTransactions();
-    for (const auto & s : stemTxs) {
-        notification.txs.push_back(s.second);
-      logger(Logging::DEBUGGING) << s.first;
-    }
-    auto buf = LevinProtocol::encode(notification);
-    m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_TRANSACTIONS::ID, buf, nullptr);
+  StemPool::Transactions expired;
+  m_stemPool.takeExpiredTransactions(time(nullptr), expired);
+  fluffStemTransactions(expired, "embargo timeout");
+  return true;
+}
 
-    m_stemPool.clearStemPool();
-  }
-  else {
-    logger(Logging::DEBUGGING) << "Nothing to broadcast in fluff mode...";
+bool CryptoNoteProtocolHandler::addStemTransaction(const Crypto::Hash& txHash, const std::string& txBlob) {
+  // the embargoes are exponential so that the node fluffing a transaction first is likely the closest to its source
+  std::exponential_distribution<double> embargoes(1.0 / CryptoNote::parameters::DANDELION_STEM_EMBARGO_AVERAGE);
+  time_t embargo = static_cast<time_t>(embargoes(Random::gen)) + 1;
+
+  StemPool::Transactions evicted;
+  if (!m_stemPool.addTransaction(txHash, txBlob, time(nullptr), embargo, evicted)) {
+    return false;
   }
-  
+
+  logger(Logging::DEBUGGING) << "Added transaction " << txHash << " to stempool, embargo " << embargo << " s";
+  fluffStemTransactions(evicted, "stempool full");
   return true;
 }
 
+void CryptoNoteProtocolHandler::fluffStemTransactions(const StemPool::Transactions& transactions, const char* reason) {
+  if (transactions.empty()) {
+    return;
+  }
+
+  NOTIFY_NEW_TRANSACTIONS::request notification;
+  notification.stem = false;
+  logger(Logging::DEBUGGING) << "Broadcasting as fluff " << transactions.size() << " stem transaction(s), " << reason << ":";
+  for (const auto& s : transactions) {
+    notification.txs.push_back(s.second);
+    logger(Logging::DEBUGGING) << s.first;
+  }
+
+  relayFluffTransactions(notification, nullptr);
+}
+
 bool CryptoNoteProtocolHandler::on_idle() {
+  dropStalledSyncRequests();
+  m_syncPeersCheckInterval.call([&]() { return checkSyncPeers(); });
   m_dandelionStemSelectInterval.call([&]() { return select_dandelion_stem(); });
-  m_dandelionStemFluffInterval.call([&]() { return fluffStemPool(); });
+  fluffStemPool();
+  m_txInventoryInterval.call([&]() { return announceTransactions(); });
   return m_core.on_idle();
 }
 
 int CryptoNoteProtocolHandler::doPushLiteBlock(NOTIFY_NEW_LITE_BLOCK::request arg, CryptoNoteConnectionContext &context,
                                               std::vector<BinaryArray> missingTxs) {
+  TraceSpan span("protocol", "push_lite_block");
   Block b;
   if (!fromBinaryArray(b, asBinaryArray(arg.block))) {
     logger(Logging::WARNING) << context << "Deserialization of Block Template failed, dropping connection";
@@ -713,6 +1120,10 @@ int CryptoNoteProtocolHandler::doPushLiteBlock(NOTIFY_NEW_LITE_BLOCK::request ar
     return 1;
   }
 
+  Crypto::Hash blockHash = get_block_hash(b);
+  span.setPodId(blockHash);
+  context.m_known_objects.insert(blockHash);
+
   std::unordered_map<Crypto::Hash, BinaryArray> provided_txs;
   provided_txs.reserve(missingTxs.size());
   for (const auto &missingTx : missingTxs) {
@@ -721,6 +1132,8 @@ int CryptoNoteProtocolHandler::doPushLiteBlock(NOTIFY_NEW_LITE_BLOCK::request ar
 
   std::vector<BinaryArray> have_txs;
   std::vector<Crypto::Hash> need_txs;
+  // what we lacked likely misses further down the network too
+  std::unordered_map<Crypto::Hash, BinaryArray> prefilled_txs;
 
   if (context.m_pending_lite_block) {
     for (const auto &requestedTxHash : context.m_pending_lite_block->missed_transactions) {
@@ -743,6 +1156,9 @@ int CryptoNoteProtocolHandler::doPushLiteBlock(NOTIFY_NEW_LITE_BLOCK::request ar
     auto providedSearch = provided_txs.find(transactionHash);
     if (providedSearch != provided_txs.end()) {
       have_txs.push_back(providedSearch->second);
+      if (!m_core.haveTransaction(transactionHash)) {
+        prefilled_txs.emplace(transactionHash, providedSearch->second);
+      }
     } else {
       Transaction tx;
       if (m_core.getTransaction(transactionHash, tx, true)) {
@@ -784,7 +1200,7 @@ int CryptoNoteProtocolHandler::doPushLiteBlock(NOTIFY_NEW_LITE_BLOCK::request ar
     if (bvc.m_added_to_main_chain) {
       ++arg.hop;
       //TODO: Add here announce protocol usage
-      relay_post_notify<NOTIFY_NEW_LITE_BLOCK>(*m_p2p, arg, &context.m_connection_id);
+      relayLiteBlock(arg, b, prefilled_txs, &context.m_connection_id);
 
       if (bvc.m_switched_to_alt_chain) {
         requestMissingPoolTransactions(context);
@@ -846,23 +1262,50 @@ int CryptoNoteProtocolHandler::handle_request_chain(int command, NOTIFY_REQUEST_
   return 1;
 }
 
+void CryptoNoteProtocolHandler::claimBlocksToRequest(CryptoNoteConnectionContext& context, bool check_having_blocks, std::vector<Crypto::Hash>& blocks) {
+  auto it = context.m_needed_objects.begin();
+  while (it != context.m_needed_objects.end() && blocks.size() < context.m_sync_chunk_size) {
+    if (check_having_blocks && m_core.have_block(*it)) {
+      it = context.m_needed_objects.erase(it);
+      continue;
+    }
+
+    if (m_blocksInFlight.count(*it) != 0) {
+      // claimed by another connection: keep the chunk contiguous, and keep the id needed in case that peer fails
+      if (!blocks.empty()) {
+        break;
+      }
+
+      ++it;
+      continue;
+    }
+
+    m_blocksInFlight.emplace(*it, context.m_connection_id);
+    context.m_requested_objects.insert(*it);
+    blocks.push_back(*it);
+    it = context.m_needed_objects.erase(it);
+  }
+}
+
 bool CryptoNoteProtocolHandler::request_missing_objects(CryptoNoteConnectionContext& context, bool check_having_blocks) {
   if (context.m_needed_objects.size()) {
-    //we know objects that we need, request this objects
-    NOTIFY_REQUEST_GET_OBJECTS::request req;
-    size_t count = 0;
-    auto it = context.m_needed_objects.begin();
-
-    while (it != context.m_needed_objects.end() && count < BLOCKS_SYNCHRONIZING_DEFAULT_COUNT) {
-      if (!(check_having_blocks && m_core.have_block(*it))) {
-        req.blocks.push_back(*it);
-        ++count;
-        context.m_requested_objects.insert(*it);
+    //we know objects that we need, request this objects, several chunks at once
+    // a connection with nothing in flight may always ask for a chunk, it may be the one the buffered blocks wait for
+    while (context.m_requested_chunks.size() < maxSyncRequestsInFlight(context) &&
+      (context.m_requested_chunks.empty() || m_blocksInFlight.size() < SYNC_MAX_PENDING_BLOCKS)) {
+      NOTIFY_REQUEST_GET_OBJECTS::request req;
+      claimBlocksToRequest(context, check_having_blocks, req.blocks);
+      if (req.blocks.empty()) {
+        // the rest is being downloaded from other connections, we get back here once they deliver
+        break;
       }
-      it = context.m_needed_objects.erase(it);
+
+      context.m_requested_chunks.emplace_back(req.blocks.size(), std::chrono::steady_clock::now());
+      logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_GET_OBJECTS: blocks.size()=" << req.blocks.size() << ", txs.size()=" << req.txs.size();
+      post_notify<NOTIFY_REQUEST_GET_OBJECTS>(*m_p2p, req, context);
     }
-    logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_GET_OBJECTS: blocks.size()=" << req.blocks.size() << ", txs.size()=" << req.txs.size();
-    post_notify<NOTIFY_REQUEST_GET_OBJECTS>(*m_p2p, req, context);
+  } else if (!context.m_requested_chunks.empty()) {
+    // wait for the blocks in flight before asking for more ids
   } else if (context.m_last_response_height < context.m_remote_blockchain_height - 1) {//we have to fetch more objects ids, request blockchain entry
 
     NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
@@ -945,7 +1388,23 @@ int CryptoNoteProtocolHandler::handle_response_chain_entry(int command, NOTIFY_R
     context.m_state = CryptoNoteConnectionContext::state_shutdown;
   }
 
-  for (auto& bl_id : arg.m_block_ids) {
+  if (context.version >= P2P_HEADERS_SYNC_VERSION && arg.m_block_ids.size() > 1) {
+    // make sure the ids form a chain before spending bandwidth on the blocks
+    context.m_unverified_block_ids = std::move(arg.m_block_ids);
+
+    NOTIFY_REQUEST_BLOCK_HEADERS::request req;
+    req.block_ids.assign(context.m_unverified_block_ids.begin() + 1, context.m_unverified_block_ids.end());
+    logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_BLOCK_HEADERS: block_ids.size()=" << req.block_ids.size();
+    post_notify<NOTIFY_REQUEST_BLOCK_HEADERS>(*m_p2p, req, context);
+    return 1;
+  }
+
+  requestChainObjects(context, arg.m_block_ids);
+  return 1;
+}
+
+void CryptoNoteProtocolHandler::requestChainObjects(CryptoNoteConnectionContext& context, const std::vector<Crypto::Hash>& blockIds) {
+  for (auto& bl_id : blockIds) {
     if (!m_core.have_block(bl_id))
       context.m_needed_objects.push_back(bl_id);
   }
@@ -954,7 +1413,74 @@ int CryptoNoteProtocolHandler::handle_response_chain_entry(int command, NOTIFY_R
     logger(Logging::DEBUGGING) << context << "Failed to request missing objects, dropping connection";
     m_p2p->drop_connection(context, true);
   }
+}
+
+int CryptoNoteProtocolHandler::handle_request_block_headers(int command, NOTIFY_REQUEST_BLOCK_HEADERS::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_REQUEST_BLOCK_HEADERS: block_ids.size()=" << arg.block_ids.size();
+
+  if (arg.block_ids.size() > BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT) {
+    logger(Logging::DEBUGGING) << context << "Too many block headers requested, dropping connection";
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  // stops at the first unknown block, e.g. one that was just switched away from
+  NOTIFY_RESPONSE_BLOCK_HEADERS::request rsp;
+  rsp.headers.reserve(arg.block_ids.size());
+  for (const auto& blockId : arg.block_ids) {
+    Block b;
+    BinaryArray header;
+    if (!m_core.getBlockByHash(blockId, b) || !get_block_header_blob(b, header)) {
+      break;
+    }
+
+    rsp.headers.push_back(asString(header));
+  }
+
+  logger(Logging::TRACE) << context << "-->>NOTIFY_RESPONSE_BLOCK_HEADERS: headers.size()=" << rsp.headers.size();
+  post_notify<NOTIFY_RESPONSE_BLOCK_HEADERS>(*m_p2p, rsp, context);
+  return 1;
+}
+
+int CryptoNoteProtocolHandler::handle_response_block_headers(int command, NOTIFY_RESPONSE_BLOCK_HEADERS::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_RESPONSE_BLOCK_HEADERS: headers.size()=" << arg.headers.size();
+
+  std::vector<Crypto::Hash> blockIds = std::move(context.m_unverified_block_ids);
+  context.m_unverified_block_ids.clear();
+  if (blockIds.empty()) {
+    logger(Logging::DEBUGGING) << context << "sent unrequested block headers, dropping connection";
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  if (arg.headers.size() != blockIds.size() - 1) {
+    logger(Logging::DEBUGGING) << context << "sent " << arg.headers.size() << " block headers instead of " << blockIds.size() - 1
+      << ", dropping connection";
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  // Every header has to hash to the announced id and point to the previous one. The proof of work
+  // can't be checked yet as the difficulty depends on the timestamps and sizes of the whole chain.
+  for (size_t i = 0; i < arg.headers.size(); ++i) {
+    BinaryArray headerBlob = asBinaryArray(arg.headers[i]);
+    BlockHeader header;
+    if (!parse_block_header_blob(headerBlob, header)) {
+      logger(Logging::DEBUGGING) << context << "sent malformed block header, dropping connection";
+      context.m_state = CryptoNoteConnectionContext::state_shutdown;
+      return 1;
+    }
+
+    Crypto::Hash blockId;
+    if (!getObjectHash(headerBlob, blockId) || blockId != blockIds[i + 1] || header.previousBlockHash != blockIds[i]) {
+      logger(Logging::DEBUGGING) << context << "sent block header " << Common::podToHex(blockIds[i + 1])
+        << " that doesn't fit the chain entry, dropping connection";
+      context.m_state = CryptoNoteConnectionContext::state_shutdown;
+      return 1;
+    }
+  }
 
+  requestChainObjects(context, blockIds);
   return 1;
 }
 
@@ -1026,98 +1552,578 @@ int CryptoNoteProtocolHandler::handle_notify_missing_txs(int command,  NOTIFY_MI
   return 1;
 }
 
-void CryptoNoteProtocolHandler::relay_block(NOTIFY_NEW_BLOCK::request& arg) {
-  // generate a lite block request from the received normal block
+int CryptoNoteProtocolHandler::handle_notify_tx_inventory(int command, NOTIFY_TX_INVENTORY::request &arg,
+                                                         CryptoNoteConnectionContext &context) {
+  logger(Logging::TRACE) << context << "NOTIFY_TX_INVENTORY: txs.size() = " << arg.txs.size();
+  if (context.m_state != CryptoNoteConnectionContext::state_normal) {
+    return 1;
+  }
+
+  if (arg.txs.size() > TX_INVENTORY_MAX_COUNT) {
+    logger(Logging::DEBUGGING) << context << "Too many transactions announced, dropping connection";
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  // every transaction is asked from the first announcer only, until the request times out
+  time_t now = time(nullptr);
+  NOTIFY_REQUEST_TXS::request req;
+  for (const auto& txHash : arg.txs) {
+    context.m_known_objects.insert(txHash);
+    if (m_core.haveTransaction(txHash)) {
+      continue;
+    }
+
+    auto requested = m_requestedTxs.find(txHash);
+    if (requested != m_requestedTxs.end() && now - requested->second < TX_REQUEST_TIMEOUT) {
+      continue;
+    }
+
+    m_requestedTxs[txHash] = now;
+    req.txs.push_back(txHash);
+  }
+
+  if (!req.txs.empty()) {
+    logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_TXS: txs.size() = " << req.txs.size();
+    post_notify<NOTIFY_REQUEST_TXS>(*m_p2p, req, context);
+  }
+
+  return 1;
+}
+
+int CryptoNoteProtocolHandler::handle_notify_request_txs(int command, NOTIFY_REQUEST_TXS::request &arg,
+                                                        CryptoNoteConnectionContext &context) {
+  logger(Logging::TRACE) << context << "NOTIFY_REQUEST_TXS: txs.size() = " << arg.txs.size();
+  if (arg.txs.size() > TX_INVENTORY_MAX_COUNT) {
+    logger(Logging::DEBUGGING) << context << "Too many transactions requested, dropping connection";
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  // unlike lite block transactions these may have been mined or evicted meanwhile, so just skip the missing ones
+  std::list<Transaction> txs;
+  std::list<Crypto::Hash> missedHashes;
+  m_core.getTransactions(arg.txs, txs, missedHashes, true);
+
+  NOTIFY_RESPONSE_TXS::request rsp;
+  rsp.stem = false;
+  for (auto& tx : txs) {
+    context.m_known_objects.insert(getObjectHash(tx));
+    rsp.txs.push_back(asString(toBinaryArray(tx)));
+  }
+
+  if (!rsp.txs.empty()) {
+    post_notify<NOTIFY_RESPONSE_TXS>(*m_p2p, rsp, context);
+  }
+
+  return 1;
+}
+
+int CryptoNoteProtocolHandler::handle_notify_response_txs(int command, NOTIFY_RESPONSE_TXS::request &arg,
+                                                         CryptoNoteConnectionContext &context) {
+  logger(Logging::TRACE) << context << "NOTIFY_RESPONSE_TXS: txs.size() = " << arg.txs.size();
+  for (const auto& tx : arg.txs) {
+    m_requestedTxs.erase(getBinaryArrayHash(asBinaryArray(tx)));
+  }
+
+  if (context.m_state != CryptoNoteConnectionContext::state_normal) {
+    return 1;
+  }
+
+  arg.stem = false;
+  return processNewTransactions(arg, context);
+}
+
+int CryptoNoteProtocolHandler::handle_notify_new_compact_block(int command, NOTIFY_NEW_COMPACT_BLOCK::request &arg,
+                                                              CryptoNoteConnectionContext &context) {
+  logger(Logging::DEBUGGING) << context << "NOTIFY_NEW_COMPACT_BLOCK (hop " << arg.hop << ")";
+  updateObservedHeight(arg.current_blockchain_height, context);
+  context.m_remote_blockchain_height = arg.current_blockchain_height;
+  if (context.m_state != CryptoNoteConnectionContext::state_normal) {
+    return 1;
+  }
+
+  context.m_known_objects.insert(arg.blockHash);
+
+  // a newer block supersedes the one still waiting for its transactions
+  context.m_pending_compact_block = boost::none;
+  return doPushCompactBlock(std::move(arg), context, {});
+}
+
+int CryptoNoteProtocolHandler::handle_notify_request_compact_txs(int command, NOTIFY_REQUEST_COMPACT_TXS::request &arg,
+                                                                CryptoNoteConnectionContext &context) {
+  logger(Logging::DEBUGGING) << context << "NOTIFY_REQUEST_COMPACT_TXS";
+
+  Block b;
+  if (!m_core.getBlockByHash(arg.blockHash, b)) {
+    logger(Logging::DEBUGGING) << context << "Transactions of unknown compact block " << arg.blockHash << " requested";
+    return 1;
+  }
+
+  std::vector<Crypto::Hash> txHashes;
+  txHashes.reserve(arg.indexes.size());
+  for (uint32_t index : arg.indexes) {
+    if (index >= b.transactionHashes.size()) {
+      logger(Logging::DEBUGGING) << context << "Requested transaction " << index << " of compact block " << arg.blockHash
+        << " out of " << b.transactionHashes.size() << ", dropping connection";
+      context.m_state = CryptoNoteConnectionContext::state_shutdown;
+      return 1;
+    }
+
+    txHashes.push_back(b.transactionHashes[index]);
+  }
+
+  std::list<Transaction> txs;
+  std::list<Crypto::Hash> missedHashes;
+  m_core.getTransactions(txHashes, txs, missedHashes, true);
+  if (!missedHashes.empty()) {
+    logger(Logging::DEBUGGING) << context << "Unable to retrieve " << missedHashes.size() << " transactions of compact block " << arg.blockHash;
+    return 1;
+  }
+
+  NOTIFY_NEW_TRANSACTIONS::request req;
+  for (auto& tx : txs) {
+    req.txs.push_back(asString(toBinaryArray(tx)));
+  }
+
+  logger(Logging::DEBUGGING) << context << "--> NOTIFY_RESPONSE_COMPACT_TXS: txs.size() = " << req.txs.size();
+  if (!post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, req, context)) {
+    logger(Logging::DEBUGGING) << context << "Error while sending compact block transactions to peer";
+  }
+
+  return 1;
+}
+
+int CryptoNoteProtocolHandler::doPushCompactBlock(NOTIFY_NEW_COMPACT_BLOCK::request arg, CryptoNoteConnectionContext &context,
+                                                 std::vector<BinaryArray> missingTxs) {
+  TraceSpan span("protocol", "push_compact_block");
+  Block b;
+  BinaryArray blockTemplate = asBinaryArray(arg.block);
+  if (!fromBinaryArray(b, blockTemplate) || !b.transactionHashes.empty() || arg.short_ids.size() % COMPACT_BLOCK_SHORT_ID_SIZE != 0 ||
+      arg.prefilled_indexes.size() != arg.prefilled_txs.size()) {
+    logger(Logging::WARNING) << context << "Malformed compact block, dropping connection";
+    context.m_pending_compact_block = boost::none;
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  const size_t txCount = arg.short_ids.size() / COMPACT_BLOCK_SHORT_ID_SIZE + arg.prefilled_txs.size();
+  std::vector<Crypto::Hash> txHashes(txCount, NULL_HASH);
+  std::vector<bool> prefilled(txCount, false);
+  std::unordered_map<Crypto::Hash, BinaryArray> provided_txs;
+
+  for (size_t i = 0; i < arg.prefilled_indexes.size(); ++i) {
+    uint32_t index = arg.prefilled_indexes[i];
+    if (index >= txCount || (i > 0 && index <= arg.prefilled_indexes[i - 1])) {
+      logger(Logging::WARNING) << context << "Compact block with wrong prefilled transaction indexes, dropping connection";
+      context.m_pending_compact_block = boost::none;
+      context.m_state = CryptoNoteConnectionContext::state_shutdown;
+      return 1;
+    }
+
+    BinaryArray transactionBinary = asBinaryArray(arg.prefilled_txs[i]);
+    txHashes[index] = getBinaryArrayHash(transactionBinary);
+    prefilled[index] = true;
+    provided_txs[txHashes[index]] = std::move(transactionBinary);
+  }
+
+  std::vector<uint64_t> shortIds;
+  std::vector<uint32_t> positions;
+  shortIds.reserve(txCount - arg.prefilled_txs.size());
+  positions.reserve(txCount - arg.prefilled_txs.size());
+  for (uint32_t position = 0; position < txCount; ++position) {
+    if (!prefilled[position]) {
+      uint64_t shortId = 0;
+      memcpy(&shortId, arg.short_ids.data() + shortIds.size() * COMPACT_BLOCK_SHORT_ID_SIZE, COMPACT_BLOCK_SHORT_ID_SIZE);
+      shortIds.push_back(shortId);
+      positions.push_back(position);
+    }
+  }
+
+  // transactions the sender returned for a previous request take precedence over the pool
+  Crypto::Hash key = get_compact_block_key(blockTemplate, arg.nonce);
+  std::unordered_map<uint64_t, Crypto::Hash> responded_txs;
+  for (auto& missingTx : missingTxs) {
+    Crypto::Hash transactionHash = getBinaryArrayHash(missingTx);
+    responded_txs[get_transaction_short_id(key, transactionHash)] = transactionHash;
+    provided_txs[transactionHash] = std::move(missingTx);
+  }
+
+  std::vector<Crypto::Hash> poolTxHashes;
+  m_core.getPoolTransactionIdsByShortIds(key, shortIds, poolTxHashes);
+
+  std::vector<uint32_t> missedIndexes;
+  for (size_t i = 0; i < shortIds.size(); ++i) {
+    auto respondedSearch = responded_txs.find(shortIds[i]);
+    if (respondedSearch != responded_txs.end()) {
+      txHashes[positions[i]] = respondedSearch->second;
+    } else if (poolTxHashes[i] != NULL_HASH) {
+      txHashes[positions[i]] = poolTxHashes[i];
+    } else {
+      missedIndexes.push_back(positions[i]);
+    }
+  }
+
+  if (missedIndexes.empty()) {
+    b.transactionHashes = std::move(txHashes);
+    if (get_block_hash(b) != arg.blockHash) {
+      // a pool transaction shares a short id with one of the block, ask for all of them
+      logger(Logging::DEBUGGING) << context << "Compact block " << arg.blockHash << " reconstructed wrong";
+      missedIndexes = positions;
+    }
+  }
+
+  if (!missedIndexes.empty()) {
+    if (context.m_pending_compact_block) {
+      logger(Logging::DEBUGGING) << context
+        << " Peer has a pending compact block but didn't provide all necessary transactions, dropping the connection.";
+      context.m_pending_compact_block = boost::none;
+      context.m_state = CryptoNoteConnectionContext::state_shutdown;
+      return 1;
+    }
+
+    NOTIFY_REQUEST_COMPACT_TXS::request req;
+    req.blockHash = arg.blockHash;
+    req.current_blockchain_height = arg.current_blockchain_height;
+    req.indexes = missedIndexes;
+    context.m_pending_compact_block = PendingCompactBlock{ std::move(arg), std::move(missedIndexes) };
+
+    logger(Logging::DEBUGGING) << context << "-->>NOTIFY_REQUEST_COMPACT_TXS: " << req.indexes.size() << " of " << txCount << " transactions";
+    if (!post_notify<NOTIFY_REQUEST_COMPACT_TXS>(*m_p2p, req, context)) {
+      logger(Logging::DEBUGGING) << context
+        << "Compact block is missing transactions but the publisher is not reachable, dropping connection.";
+      context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    }
+
+    return 1;
+  }
+
+  // all transactions are known, the rest is what a lite block goes through
+  context.m_pending_compact_block = boost::none;
+
   NOTIFY_NEW_LITE_BLOCK::request lite_arg;
+  lite_arg.block = asString(toBinaryArray(b));
   lite_arg.current_blockchain_height = arg.current_blockchain_height;
-  lite_arg.block = arg.b.block;
   lite_arg.hop = arg.hop;
 
-  // encoding the request for sending the blocks to peers
-  auto buf = LevinProtocol::encode(arg);
-  auto lite_buf = LevinProtocol::encode(lite_arg);
+  std::vector<BinaryArray> txs;
+  txs.reserve(provided_txs.size());
+  for (auto& providedTx : provided_txs) {
+    txs.push_back(std::move(providedTx.second));
+  }
+
+  return doPushLiteBlock(std::move(lite_arg), context, std::move(txs));
+}
+
+void CryptoNoteProtocolHandler::relayLiteBlock(const NOTIFY_NEW_LITE_BLOCK::request& arg, const Block& block,
+                                               const std::unordered_map<Crypto::Hash, BinaryArray>& prefilledTxs,
+                                               const net_connection_id* excludeConnection, std::list<boost::uuids::uuid>* normalBlockConnections) {
+  RelayPeers compactBlockPeers, liteBlockPeers, normalBlockPeers;
+  Crypto::Hash blockHash = get_block_hash(block);
+  TraceSpan span("protocol", "relay_lite_block", blockHash);
+
+  // peers whose chain reaches the height of the block have it or a rival already
+  uint32_t blockIndex = std::numeric_limits<uint32_t>::max();
+  if (block.baseTransaction.inputs.size() == 1 && block.baseTransaction.inputs[0].type() == typeid(BaseInput)) {
+    blockIndex = boost::get<BaseInput>(block.baseTransaction.inputs[0]).blockIndex;
+  }
+
+  // sort the peers that don't have the block yet into their support categories
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext &ctx, uint64_t peerId) {
+    if (excludeConnection != nullptr && ctx.m_connection_id == *excludeConnection) {
+      return;
+    }
 
-  // logging the msg size to see the difference in payload size
-  logger(Logging::DEBUGGING) << "NOTIFY_NEW_BLOCK - MSG_SIZE = " << buf.size();
-  logger(Logging::DEBUGGING) << "NOTIFY_NEW_LITE_BLOCK - MSG_SIZE = " << lite_buf.size();
+    if (ctx.m_known_objects.contains(blockHash) || ctx.m_remote_blockchain_height > blockIndex) {
+      return;
+    }
 
-  std::list<boost::uuids::uuid> liteBlockConnections, normalBlockConnections;
+    ctx.m_known_objects.insert(blockHash);
 
-  // sort the peers into their support categories
-  m_p2p->for_each_connection([this, &liteBlockConnections, &normalBlockConnections](
-    const CryptoNoteConnectionContext &ctx, uint64_t peerId) {
-    if (ctx.version >= P2P_LITE_BLOCKS_PROPOGATION_VERSION) {
-      logger(Logging::DEBUGGING) << ctx << "Peer supports lite-blocks... adding peer to lite block list";
-      liteBlockConnections.push_back(ctx.m_connection_id);
+    if (ctx.version >= P2P_COMPACT_BLOCKS_PROPOGATION_VERSION) {
+      compactBlockPeers.emplace_back(ctx.m_round_trip_time, ctx.m_connection_id);
+    } else if (ctx.version >= P2P_LITE_BLOCKS_PROPOGATION_VERSION || normalBlockConnections == nullptr) {
+      liteBlockPeers.emplace_back(ctx.m_round_trip_time, ctx.m_connection_id);
     } else {
-      logger(Logging::DEBUGGING) << ctx << "Peer doesn't support lite-blocks... adding peer to normal block list";
-      normalBlockConnections.push_back(ctx.m_connection_id);
+      normalBlockPeers.emplace_back(ctx.m_round_trip_time, ctx.m_connection_id);
     }
   });
 
-  // first send lite blocks as it's faster
+  std::list<boost::uuids::uuid> compactBlockConnections = orderByLatency(compactBlockPeers);
+  std::list<boost::uuids::uuid> liteBlockConnections = orderByLatency(liteBlockPeers);
+  if (normalBlockConnections != nullptr) {
+    *normalBlockConnections = orderByLatency(normalBlockPeers);
+  }
+
+  if (!compactBlockConnections.empty()) {
+    Block blockTemplate = block;
+    blockTemplate.transactionHashes.clear();
+    BinaryArray blockTemplateBlob = toBinaryArray(blockTemplate);
+
+    NOTIFY_NEW_COMPACT_BLOCK::request compact_arg;
+    compact_arg.block = asString(blockTemplateBlob);
+    compact_arg.blockHash = blockHash;
+    compact_arg.nonce = Random::randomValue<uint64_t>();
+    compact_arg.current_blockchain_height = arg.current_blockchain_height;
+    compact_arg.hop = arg.hop;
+
+    Crypto::Hash key = get_compact_block_key(blockTemplateBlob, compact_arg.nonce);
+    compact_arg.short_ids.reserve(block.transactionHashes.size() * COMPACT_BLOCK_SHORT_ID_SIZE);
+    for (uint32_t i = 0; i < block.transactionHashes.size(); ++i) {
+      auto prefilledSearch = prefilledTxs.find(block.transactionHashes[i]);
+      if (prefilledSearch != prefilledTxs.end()) {
+        compact_arg.prefilled_indexes.push_back(i);
+        compact_arg.prefilled_txs.push_back(asString(prefilledSearch->second));
+      } else {
+        uint64_t shortId = get_transaction_short_id(key, block.transactionHashes[i]);
+        compact_arg.short_ids.append(reinterpret_cast<const char*>(&shortId), COMPACT_BLOCK_SHORT_ID_SIZE);
+      }
+    }
+
+    auto compact_buf = LevinProtocol::encode(compact_arg);
+    logger(Logging::DEBUGGING) << "NOTIFY_NEW_COMPACT_BLOCK - MSG_SIZE = " << compact_buf.size()
+      << ", prefilled " << compact_arg.prefilled_txs.size() << "/" << block.transactionHashes.size();
+    m_p2p->externalRelayNotifyToList(NOTIFY_NEW_COMPACT_BLOCK::ID, compact_buf, compactBlockConnections);
+  }
+
   if (!liteBlockConnections.empty()) {
+    auto lite_buf = LevinProtocol::encode(arg);
+    logger(Logging::DEBUGGING) << "NOTIFY_NEW_LITE_BLOCK - MSG_SIZE = " << lite_buf.size();
     m_p2p->externalRelayNotifyToList(NOTIFY_NEW_LITE_BLOCK::ID, lite_buf, liteBlockConnections);
   }
+}
+
+void CryptoNoteProtocolHandler::relay_block(NOTIFY_NEW_BLOCK::request& arg) {
+  // the core relays mined blocks from other threads, the connections are only touched on the dispatcher
+  NOTIFY_NEW_BLOCK::request notification = arg;
+  m_dispatcher.remoteSpawn([this, notification]() mutable {
+    relayBlock(notification);
+  });
+}
+
+void CryptoNoteProtocolHandler::relayBlock(NOTIFY_NEW_BLOCK::request& arg) {
+  TraceSpan span("protocol", "relay_block");
+  Block b;
+  if (!fromBinaryArray(b, asBinaryArray(arg.b.block))) {
+    logger(Logging::ERROR) << "Failed to parse the block to relay";
+    return;
+  }
+
+  // generate a lite block request from the received normal block
+  NOTIFY_NEW_LITE_BLOCK::request lite_arg;
+  lite_arg.current_blockchain_height = arg.current_blockchain_height;
+  lite_arg.block = arg.b.block;
+  lite_arg.hop = arg.hop;
+
+  // peers are expected to have the transactions of our own blocks already, compact and lite blocks go first as they're faster
+  std::list<boost::uuids::uuid> normalBlockConnections;
+  relayLiteBlock(lite_arg, b, {}, nullptr, &normalBlockConnections);
 
   if (!normalBlockConnections.empty()) {
     auto buf = LevinProtocol::encode(arg);
-    m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_BLOCK::ID, buf, nullptr);
+    logger(Logging::DEBUGGING) << "NOTIFY_NEW_BLOCK - MSG_SIZE = " << buf.size();
+    m_p2p->externalRelayNotifyToList(NOTIFY_NEW_BLOCK::ID, buf, normalBlockConnections);
   }
 }
 
 void CryptoNoteProtocolHandler::relay_transactions(NOTIFY_NEW_TRANSACTIONS::request& arg) {
+  bool relayScheduled;
+  {
+    std::lock_guard<std::mutex> lk(m_relayQueueMutex);
+    relayScheduled = !m_stemRelayQueue.txs.empty() || !m_fluffRelayQueue.txs.empty();
+    auto& queue = arg.stem ? m_stemRelayQueue : m_fluffRelayQueue;
+    queue.txs.insert(queue.txs.end(), arg.txs.begin(), arg.txs.end());
+  }
+
+  // the transactions queued until the dispatcher gets to it are relayed along
+  if (!relayScheduled) {
+    m_dispatcher.remoteSpawn([this]() {
+      relayQueuedTransactions();
+    });
+  }
+}
+
+void CryptoNoteProtocolHandler::relayQueuedTransactions() {
+  NOTIFY_NEW_TRANSACTIONS::request stem;
+  NOTIFY_NEW_TRANSACTIONS::request fluff;
+  {
+    std::lock_guard<std::mutex> lk(m_relayQueueMutex);
+    stem.txs.swap(m_stemRelayQueue.txs);
+    fluff.txs.swap(m_fluffRelayQueue.txs);
+  }
+
+  if (!stem.txs.empty()) {
+    stem.stem = true;
+    relayTransactions(stem);
+  }
+
+  if (!fluff.txs.empty()) {
+    relayTransactions(fluff);
+  }
+}
+
+void CryptoNoteProtocolHandler::relayTransactions(NOTIFY_NEW_TRANSACTIONS::request& arg) {
+  TraceSpan span("protocol", "relay_transactions");
+  span.setId(arg.txs.size());
   if (arg.stem && !m_dandelion_stem.empty()) { // Dandelion broadcast
     std::vector<Crypto::Hash> txHashes;
-    for (auto tx_blob_it = arg.txs.begin(); tx_blob_it != arg.txs.end(); tx_blob_it++) {
-      auto transactionBinary = asBinaryArray(*tx_blob_it);
-      Crypto::Hash transactionHash = Crypto::cn_fast_hash(transactionBinary.data(), transactionBinary.size());
-      if (!m_stemPool.hasTransaction(transactionHash)) {
-        logger(Logging::DEBUGGING) << "Adding relayed transaction " << transactionHash << " to stempool";      
-        auto txblob = *tx_blob_it;
-        m_dispatcher.remoteSpawn([this, transactionHash, txblob] {
-          m_stemPool.addTransaction(transactionHash, txblob);
-        });
+    for (const auto& txBlob : arg.txs) {
+      Crypto::Hash transactionHash = getBinaryArrayHash(asBinaryArray(txBlob));
+      if (addStemTransaction(transactionHash, txBlob)) {
         txHashes.push_back(transactionHash);
       }
     }
 
-    std::mt19937 rng = Random::generator();
-    std::uniform_int_distribution<> dis(0, 100);
-    auto coin_flip = dis(rng);
-    if (coin_flip < CryptoNote::parameters::DANDELION_STEM_TX_PROPAGATION_PROBABILITY) { // Stem propagation
-      for (const auto& dandelion_peer : m_dandelion_stem) {
-        if (dandelion_peer.m_state == CryptoNoteConnectionContext::state_normal || dandelion_peer.m_state == CryptoNoteConnectionContext::state_synchronizing) {
-          if (!post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, arg, dandelion_peer)) {
-            logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Failed to relay transactions to Dandelion peer " << dandelion_peer.m_connection_id << ", broadcasting in dandelion fluff mode";
-            arg.stem = false;
-            for (const auto& h : txHashes) {
-              m_stemPool.removeTransaction(h);
-              logger(Logging::DEBUGGING) << h;
-            }
-
-            auto buf = LevinProtocol::encode(arg);
-            m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_TRANSACTIONS::ID, buf, nullptr);
-            break;
-          }
-        }
-      }
-    } else { // Switch to fluff broadcast
-      arg.stem = false;
-      logger(Logging::DEBUGGING) << "Switching to fluff broadcast of stem transactions:";
-      for (const auto& h : txHashes) {
-        m_stemPool.removeTransaction(h);
-        logger(Logging::DEBUGGING) << h;
-      }
-      auto buf = LevinProtocol::encode(arg);
-      m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_TRANSACTIONS::ID, buf, nullptr);
-    }
+    relayStemTransactions(arg, txHashes, boost::uuids::nil_uuid(), nullptr);
   } else { // Fluff broadcast
     logger(Logging::DEBUGGING) << "Not stem or no stem peers, fluff broadcast of transactions...";
+    relayFluffTransactions(arg, nullptr);
+  }
+}
+
+// The transactions go to one stem peer in a single notification, or are fluffed, in which case
+// they leave the stem pool.
+void CryptoNoteProtocolHandler::relayStemTransactions(NOTIFY_NEW_TRANSACTIONS::request& arg, const std::vector<Crypto::Hash>& stemTxHashes,
+                                                      const boost::uuids::uuid& source, const net_connection_id* excludeConnection) {
+  auto fluff = [&](const char* reason) {
     arg.stem = false;
+    logger(Logging::DEBUGGING) << reason << ", fluff broadcast of stem transactions:";
+    for (const auto& h : stemTxHashes) {
+      m_stemPool.removeTransaction(h);
+      logger(Logging::DEBUGGING) << h;
+    }
+
+    relayFluffTransactions(arg, excludeConnection);
+  };
+
+  if (m_dandelion_stem.empty()) {
+    fluff("No stem peers");
+    return;
+  }
+
+  if (Random::randomValue<int>(0, 99) >= CryptoNote::parameters::DANDELION_STEM_TX_PROPAGATION_PROBABILITY) {
+    fluff("Switching to fluff");
+    return;
+  }
+
+  auto route = m_dandelionRoutes.find(source);
+  if (route == m_dandelionRoutes.end()) {
+    // a transaction isn't sent back where it came from
+    std::vector<size_t> candidates;
+    for (size_t i = 0; i < m_dandelion_stem.size(); ++i) {
+      if (m_dandelion_stem[i].m_connection_id != source) {
+        candidates.push_back(i);
+      }
+    }
+
+    if (candidates.empty()) {
+      fluff("No stem peers besides the source");
+      return;
+    }
+
+    route = m_dandelionRoutes.emplace(source, candidates[Random::randomValue<size_t>(0, candidates.size() - 1)]).first;
+  }
+
+  const CryptoNoteConnectionContext& stemPeer = m_dandelion_stem[route->second];
+  if ((stemPeer.m_state != CryptoNoteConnectionContext::state_normal && stemPeer.m_state != CryptoNoteConnectionContext::state_synchronizing) ||
+      !post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, arg, stemPeer)) {
+    logger(Logging::DEBUGGING) << "Failed to relay transactions to Dandelion peer " << stemPeer.m_connection_id;
+    fluff("Stem peer unavailable");
+  }
+}
+
+void CryptoNoteProtocolHandler::relayFluffTransactions(NOTIFY_NEW_TRANSACTIONS::request& arg, const net_connection_id* excludeConnection) {
+  arg.stem = false;
+
+  std::vector<Crypto::Hash> txHashes;
+  txHashes.reserve(arg.txs.size());
+  for (const auto& tx : arg.txs) {
+    txHashes.push_back(getBinaryArrayHash(asBinaryArray(tx)));
+  }
+
+  // legacy peers get the whole notification unless they already know every transaction in it
+  std::list<boost::uuids::uuid> legacyConnections;
+  bool haveInventoryConnections = false;
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& ctx, uint64_t peerId) {
+    if (excludeConnection != nullptr && ctx.m_connection_id == *excludeConnection) {
+      return;
+    }
+
+    if (ctx.version >= P2P_TX_INVENTORY_VERSION) {
+      haveInventoryConnections = true;
+      return;
+    }
+
+    bool known = true;
+    for (const auto& txHash : txHashes) {
+      if (!ctx.m_known_objects.contains(txHash)) {
+        known = false;
+        ctx.m_known_objects.insert(txHash);
+      }
+    }
+
+    if (!known) {
+      legacyConnections.push_back(ctx.m_connection_id);
+    }
+  });
+
+  if (!legacyConnections.empty()) {
     auto buf = LevinProtocol::encode(arg);
-    m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_TRANSACTIONS::ID, buf, nullptr);
+    m_p2p->externalRelayNotifyToList(NOTIFY_NEW_TRANSACTIONS::ID, buf, legacyConnections);
+  }
+
+  if (haveInventoryConnections) {
+    boost::uuids::uuid source = excludeConnection != nullptr ? *excludeConnection : boost::uuids::nil_uuid();
+    for (const auto& txHash : txHashes) {
+      m_txInventory.push_back(TxAnnouncement{ txHash, source });
+    }
+  }
+}
+
+bool CryptoNoteProtocolHandler::announceTransactions() {
+  std::vector<TxAnnouncement> announcements;
+  announcements.swap(m_txInventory);
+
+  time_t now = time(nullptr);
+  for (auto it = m_requestedTxs.begin(); it != m_requestedTxs.end();) {
+    if (now - it->second >= TX_REQUEST_TIMEOUT) {
+      it = m_requestedTxs.erase(it);
+    } else {
+      ++it;
+    }
   }
+
+  if (announcements.empty()) {
+    return true;
+  }
+
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& ctx, uint64_t peerId) {
+    if (ctx.version < P2P_TX_INVENTORY_VERSION ||
+        (ctx.m_state != CryptoNoteConnectionContext::state_normal && ctx.m_state != CryptoNoteConnectionContext::state_synchronizing)) {
+      return;
+    }
+
+    NOTIFY_TX_INVENTORY::request notification;
+    for (const auto& announcement : announcements) {
+      if (announcement.source == ctx.m_connection_id || ctx.m_known_objects.contains(announcement.hash)) {
+        continue;
+      }
+
+      ctx.m_known_objects.insert(announcement.hash);
+      notification.txs.push_back(announcement.hash);
+      if (notification.txs.size() == TX_INVENTORY_MAX_COUNT) {
+        post_notify<NOTIFY_TX_INVENTORY>(*m_p2p, notification, ctx);
+        notification.txs.clear();
+      }
+    }
+
+    if (!notification.txs.empty()) {
+      post_notify<NOTIFY_TX_INVENTORY>(*m_p2p, notification, ctx);
+    }
+  });
+
+  logger(Logging::TRACE) << "Announced " << announcements.size() << " transaction(s)";
+  return true;
 }
 
 void CryptoNoteProtocolHandler::requestMissingPoolTransactions(const CryptoNoteConnectionContext& context) {
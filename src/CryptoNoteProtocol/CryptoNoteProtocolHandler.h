@@ -19,8 +19,13 @@
 #pragma once
 
 #include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+#include <boost/functional/hash.hpp>
 
 #include <Common/ObserverManager.h>
+#include <System/ContextGroup.h>
 
 #include "CryptoNoteCore/ICore.h"
 #include "CryptoNoteCore/OnceInInterval.h"
@@ -29,6 +34,7 @@
 #include "CryptoNoteProtocol/CryptoNoteProtocolHandlerCommon.h"
 #include "CryptoNoteProtocol/ICryptoNoteProtocolObserver.h"
 #include "CryptoNoteProtocol/ICryptoNoteProtocolQuery.h"
+#include "CryptoNoteProtocol/StemPool.h"
 
 #include "P2p/P2pProtocolDefinitions.h"
 #include "P2p/NetNodeCommon.h"
@@ -46,64 +52,6 @@ namespace CryptoNote
 {
   class Currency;
 
-  class StemPool {
-  public:
-
-    size_t getTransactionsCount() {
-      std::lock_guard<std::recursive_mutex> lk(m_stempool_mutex);
-      return m_stempool.size();
-    }
-
-    bool hasTransactions() {
-      std::lock_guard<std::recursive_mutex> lk(m_stempool_mutex);
-      return m_stempool.empty();
-    }
-
-    bool hasTransaction(const Crypto::Hash& txid) {
-      std::lock_guard<std::recursive_mutex> lk(m_stempool_mutex);
-      return m_stempool.find(txid) != m_stempool.end();
-    }
-
-    bool addTransaction(const Crypto::Hash& txid, std::string tx_blob) {
-      std::lock_guard<std::recursive_mutex> lk(m_stempool_mutex);
-      auto r = m_stempool.insert(tx_blob_by_hash::value_type(txid, tx_blob));
-
-      return true;
-    }
-
-    bool removeTransaction(const Crypto::Hash& txid) {
-      std::lock_guard<std::recursive_mutex> lk(m_stempool_mutex);
-
-      if (m_stempool.find(txid) != m_stempool.end()) {
-        m_stempool.erase(txid);
-        return true;
-      }
-
-      return false;
-    }
-
-    std::vector<std::pair<Crypto::Hash, std::string>> getTransactions() {
-      std::lock_guard<std::recursive_mutex> lk(m_stempool_mutex);
-      std::vector<std::pair<Crypto::Hash, std::string>> txs;
-      for (const auto & s : m_stempool) {
-        txs.push_back(std::make_pair(s.first, s.second));
-      }
-
-      return txs;
-    }
-
-    void clearStemPool() {
-      std::lock_guard<std::recursive_mutex> lk(m_stempool_mutex);
-
-      m_stempool.clear();
-    }
-
-  private:
-    typedef std::unordered_map<Crypto::Hash, std::string> tx_blob_by_hash;
-    tx_blob_by_hash m_stempool;
-    std::recursive_mutex m_stempool_mutex;
-  };
-
   class CryptoNoteProtocolHandler : 
     public i_cryptonote_protocol, 
     public ICryptoNoteProtocolQuery
@@ -131,10 +79,13 @@ namespace CryptoNote
     // ICore& get_core() { return m_core; }
     virtual bool isSynchronized() const override { return m_synchronized; }
     void log_connections();
+    // block and transaction requests in flight in Prometheus text format, on the dispatcher thread
+    void writeMetrics(std::ostream& out) const;
     virtual bool getConnections(std::vector<CryptoNoteConnectionContext>& connections) const override;
 
     // Interface t_payload_net_handler, where t_payload_net_handler is template argument of nodetool::node_server
     void stop();
+    void waitBlocksProcessing();
     bool start_sync(CryptoNoteConnectionContext& context);
     bool on_idle();
     void onConnectionOpened(CryptoNoteConnectionContext& context);
@@ -142,7 +93,10 @@ namespace CryptoNote
     bool get_stat_info(core_stat_info& stat_inf);
     bool get_payload_sync_data(CORE_SYNC_DATA& hshd);
     bool process_payload_sync_data(const CORE_SYNC_DATA& hshd, CryptoNoteConnectionContext& context, bool is_inital);
-    int handleCommand(bool is_notify, int command, const BinaryArray& in_buff, BinaryArray& buff_out, CryptoNoteConnectionContext& context, bool& handled);
+    // in_buff is released once it is decoded
+    int handleCommand(bool is_notify, int command, BinaryArray& in_buff, BinaryArray& buff_out, CryptoNoteConnectionContext& context, bool& handled);
+    // the largest message accepted from the connection, 0 for the protocol limit
+    uint64_t getMaxMessageSize(int command, const CryptoNoteConnectionContext& context) const;
     virtual size_t getPeerCount() const override;
     virtual uint32_t getObservedHeight() const override;
     void requestMissingPoolTransactions(const CryptoNoteConnectionContext& context);
@@ -160,6 +114,13 @@ namespace CryptoNote
     int handle_request_tx_pool(int command, NOTIFY_REQUEST_TX_POOL::request& arg, CryptoNoteConnectionContext& context);
     int handle_notify_new_lite_block(int command, NOTIFY_NEW_LITE_BLOCK::request &arg, CryptoNoteConnectionContext &context);
     int handle_notify_missing_txs(int command, NOTIFY_MISSING_TXS::request &arg, CryptoNoteConnectionContext &context);
+    int handle_notify_new_compact_block(int command, NOTIFY_NEW_COMPACT_BLOCK::request &arg, CryptoNoteConnectionContext &context);
+    int handle_notify_request_compact_txs(int command, NOTIFY_REQUEST_COMPACT_TXS::request &arg, CryptoNoteConnectionContext &context);
+    int handle_notify_tx_inventory(int command, NOTIFY_TX_INVENTORY::request &arg, CryptoNoteConnectionContext &context);
+    int handle_notify_request_txs(int command, NOTIFY_REQUEST_TXS::request &arg, CryptoNoteConnectionContext &context);
+    int handle_notify_response_txs(int command, NOTIFY_RESPONSE_TXS::request &arg, CryptoNoteConnectionContext &context);
+    int handle_request_block_headers(int command, NOTIFY_REQUEST_BLOCK_HEADERS::request &arg, CryptoNoteConnectionContext &context);
+    int handle_response_block_headers(int command, NOTIFY_RESPONSE_BLOCK_HEADERS::request &arg, CryptoNoteConnectionContext &context);
 
     //----------------- i_cryptonote_protocol ----------------------------------
     virtual void relay_block(NOTIFY_NEW_BLOCK::request& arg) override;
@@ -172,10 +133,36 @@ namespace CryptoNote
     void updateObservedHeight(uint32_t peerHeight, const CryptoNoteConnectionContext& context);
     void recalculateMaxObservedHeight(const CryptoNoteConnectionContext& context);
     int processObjects(CryptoNoteConnectionContext& context, const std::vector<parsed_block_entry>& blocks);
+    int validateObjects(CryptoNoteConnectionContext& context, const std::vector<parsed_block_entry>& blocks);
+    int processDownloadedBlocks(CryptoNoteConnectionContext& context, std::vector<parsed_block_entry>& blocks);
+    void startBlocksProcessing();
+    void processBufferedBlocks();
+    void claimBlocksToRequest(CryptoNoteConnectionContext& context, bool check_having_blocks, std::vector<Crypto::Hash>& blocks);
+    void forgetDownloadedBlocks(const std::vector<parsed_block_entry>& blocks);
+    void releaseSyncRequests(CryptoNoteConnectionContext& context);
+    void requestMoreBlocksFromWaitingPeers(const boost::uuids::uuid& except);
+    void dropStalledSyncRequests();
+    size_t maxSyncRequestsInFlight(const CryptoNoteConnectionContext& context) const;
+    bool checkSyncPeers();
+    void countInvalidResponse(CryptoNoteConnectionContext& context);
+    int processNewTransactions(NOTIFY_NEW_TRANSACTIONS::request& arg, CryptoNoteConnectionContext& context);
+    void relayFluffTransactions(NOTIFY_NEW_TRANSACTIONS::request& arg, const net_connection_id* excludeConnection);
+    void relayStemTransactions(NOTIFY_NEW_TRANSACTIONS::request& arg, const std::vector<Crypto::Hash>& stemTxHashes,
+      const boost::uuids::uuid& source, const net_connection_id* excludeConnection);
+    bool addStemTransaction(const Crypto::Hash& txHash, const std::string& txBlob);
+    void fluffStemTransactions(const StemPool::Transactions& transactions, const char* reason);
+    bool announceTransactions();
+    void relayBlock(NOTIFY_NEW_BLOCK::request& arg);
+    void relayTransactions(NOTIFY_NEW_TRANSACTIONS::request& arg);
+    void relayQueuedTransactions();
+    void requestChainObjects(CryptoNoteConnectionContext& context, const std::vector<Crypto::Hash>& blockIds);
     Logging::LoggerRef logger;
 
   private:
     int doPushLiteBlock(NOTIFY_NEW_LITE_BLOCK::request block, CryptoNoteConnectionContext &context, std::vector<BinaryArray> missingTxs);
+    int doPushCompactBlock(NOTIFY_NEW_COMPACT_BLOCK::request block, CryptoNoteConnectionContext &context, std::vector<BinaryArray> missingTxs);
+    void relayLiteBlock(const NOTIFY_NEW_LITE_BLOCK::request& arg, const Block& block, const std::unordered_map<Crypto::Hash, BinaryArray>& prefilledTxs,
+      const net_connection_id* excludeConnection, std::list<boost::uuids::uuid>* normalBlockConnections = nullptr);
 
     System::Dispatcher& m_dispatcher;
     ICore& m_core;
@@ -185,7 +172,26 @@ namespace CryptoNote
     IP2pEndpoint* m_p2p;
     std::atomic<bool> m_synchronized;
     std::atomic<bool> m_stop;
-    std::recursive_mutex m_sync_lock;
+
+    // Blocks are downloaded from several synchronizing peers at once: every block id is requested
+    // from one connection only and the received chunks wait in the reorder buffer until the
+    // processing context adds them to the chain, validation itself runs on a separate thread.
+    struct BufferedBlocks {
+      boost::uuids::uuid peer;
+      std::vector<parsed_block_entry> blocks;
+    };
+
+    std::unordered_map<Crypto::Hash, boost::uuids::uuid> m_blocksInFlight;    // requested or buffered block id -> requesting connection, nil once downloaded
+    std::unordered_map<Crypto::Hash, BufferedBlocks> m_reorderBuffer;        // keyed by the previous block id of the first block
+    bool m_processingBufferedBlocks;
+    System::ContextGroup m_blocksProcessingContext;
+
+    // The synchronizing peers are measured by their download speed: the fastest are given the
+    // released blocks first, slow ones have a single request in flight and during the initial
+    // sync the ones far behind the median are dropped for others to be dialed.
+    OnceInInterval m_syncPeersCheckInterval;
+    uint64_t m_syncMedianSpeed;               // bytes per second, 0 until measured
+    uint64_t m_invalidSyncResponses;
 
     mutable std::mutex m_observedHeightMutex;
     uint32_t m_observedHeight;
@@ -193,10 +199,29 @@ namespace CryptoNote
     std::atomic<size_t> m_peersCount;
     Tools::ObserverManager<ICryptoNoteProtocolObserver> m_observerManager;
 
+    // Stem transactions of one source connection go to the same stem peer during an epoch,
+    // our own ones have a nil source.
     OnceInInterval m_dandelionStemSelectInterval;
-    OnceInInterval m_dandelionStemFluffInterval;
     std::vector<CryptoNoteConnectionContext> m_dandelion_stem;
+    std::unordered_map<boost::uuids::uuid, size_t, boost::hash<boost::uuids::uuid>> m_dandelionRoutes;    // source -> index of the stem peer
 
     StemPool m_stemPool;
+
+    // Our own transactions are queued by relay_transactions() from any thread and relayed together
+    // by the dispatcher, so a burst of submissions goes out in one notification per peer.
+    std::mutex m_relayQueueMutex;
+    NOTIFY_NEW_TRANSACTIONS::request m_stemRelayQueue;
+    NOTIFY_NEW_TRANSACTIONS::request m_fluffRelayQueue;
+
+    // Fluffed transactions go out in full to legacy peers only, the others get their hashes
+    // batched every P2P_TX_INVENTORY_INTERVAL and fetch what they miss with NOTIFY_REQUEST_TXS.
+    struct TxAnnouncement {
+      Crypto::Hash hash;
+      boost::uuids::uuid source;    // nil for our own transactions
+    };
+
+    std::vector<TxAnnouncement> m_txInventory;
+    std::unordered_map<Crypto::Hash, time_t> m_requestedTxs;    // requested transaction -> request time
+    OnceInInterval m_txInventoryInterval;
   };
 }
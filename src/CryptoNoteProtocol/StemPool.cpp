@@ -0,0 +1,124 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "StemPool.h"
+
+#include <algorithm>
+
+namespace CryptoNote {
+
+StemPool::StemPool(size_t maxCount, size_t maxSize, time_t maxEmbargo) :
+  m_maxCount(maxCount),
+  m_maxSize(maxSize),
+  m_maxEmbargo(maxEmbargo),
+  m_wheel(static_cast<size_t>(maxEmbargo) + 1),
+  m_lastExpired(0),
+  m_size(0) {
+}
+
+size_t StemPool::getTransactionsCount() const {
+  return m_transactions.size();
+}
+
+size_t StemPool::getSize() const {
+  return m_size;
+}
+
+bool StemPool::hasTransaction(const Crypto::Hash& txid) const {
+  return m_transactions.count(txid) != 0;
+}
+
+bool StemPool::addTransaction(const Crypto::Hash& txid, const std::string& txBlob, time_t now, time_t embargo, Transactions& evicted) {
+  if (m_transactions.count(txid) != 0) {
+    return false;
+  }
+
+  if (m_lastExpired == 0) {
+    m_lastExpired = now - 1;
+  }
+
+  // the slot of the end has to come after the last emptied one and within a turn of the wheel
+  time_t embargoEnd = now + std::min(std::max<time_t>(embargo, 0), m_maxEmbargo);
+  embargoEnd = std::max(embargoEnd, m_lastExpired + 1);
+  embargoEnd = std::min(embargoEnd, m_lastExpired + static_cast<time_t>(m_wheel.size()));
+
+  m_ages.push_back(txid);
+  Entry entry = { txBlob, embargoEnd, std::prev(m_ages.end()) };
+  m_transactions.emplace(txid, std::move(entry));
+  m_wheel[slot(embargoEnd)].push_back(txid);
+  m_size += txBlob.size();
+
+  while (m_transactions.size() > m_maxCount || (m_size > m_maxSize && m_transactions.size() > 1)) {
+    take(m_transactions.find(m_ages.front()), evicted);
+  }
+
+  return true;
+}
+
+bool StemPool::removeTransaction(const Crypto::Hash& txid) {
+  auto it = m_transactions.find(txid);
+  if (it == m_transactions.end()) {
+    return false;
+  }
+
+  m_size -= it->second.blob.size();
+  m_ages.erase(it->second.age);
+  m_transactions.erase(it);
+  return true;
+}
+
+void StemPool::takeExpiredTransactions(time_t now, Transactions& expired) {
+  if (m_lastExpired == 0 || now <= m_lastExpired) {
+    return;
+  }
+
+  // after a longer pause every slot is looked at once
+  time_t first = std::max(m_lastExpired + 1, now - static_cast<time_t>(m_wheel.size()) + 1);
+  for (time_t second = first; second <= now; ++second) {
+    std::vector<Crypto::Hash>& hashes = m_wheel[slot(second)];
+    size_t kept = 0;
+    for (const Crypto::Hash& hash : hashes) {
+      auto it = m_transactions.find(hash);
+      if (it == m_transactions.end() || slot(it->second.embargoEnd) != slot(second)) {
+        continue;
+      }
+
+      if (it->second.embargoEnd <= now) {
+        take(it, expired);
+      } else {
+        hashes[kept++] = hash;
+      }
+    }
+
+    hashes.resize(kept);
+  }
+
+  m_lastExpired = now;
+}
+
+void StemPool::take(std::unordered_map<Crypto::Hash, Entry>::iterator it, Transactions& taken) {
+  taken.emplace_back(it->first, std::move(it->second.blob));
+  m_size -= taken.back().second.size();
+  m_ages.erase(it->second.age);
+  m_transactions.erase(it);
+}
+
+size_t StemPool::slot(time_t time) const {
+  return static_cast<size_t>(time) % m_wheel.size();
+}
+
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <ctime>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+// Dandelion stem transactions waiting for their embargo to end, after which they're fluffed
+// unless seen fluffed before. Every transaction has an embargo of its own, kept in a timer
+// wheel of one second slots, so expiring transactions costs only what expires. The pool is
+// bounded by a count and a size of the blobs, the oldest transactions are evicted to be
+// fluffed early. It is used on the dispatcher thread only.
+class StemPool {
+public:
+  typedef std::vector<std::pair<Crypto::Hash, std::string>> Transactions;
+
+  // embargoes longer than maxEmbargo seconds are shortened to it
+  StemPool(size_t maxCount, size_t maxSize, time_t maxEmbargo);
+
+  size_t getTransactionsCount() const;
+  size_t getSize() const;
+  bool hasTransaction(const Crypto::Hash& txid) const;
+
+  // false if the transaction is there already, the transactions evicted to make room are
+  // appended to evicted
+  bool addTransaction(const Crypto::Hash& txid, const std::string& txBlob, time_t now, time_t embargo, Transactions& evicted);
+  bool removeTransaction(const Crypto::Hash& txid);
+
+  // removes the transactions whose embargo ended by now and appends them to expired
+  void takeExpiredTransactions(time_t now, Transactions& expired);
+
+private:
+  struct Entry {
+    std::string blob;
+    time_t embargoEnd;
+    std::list<Crypto::Hash>::iterator age;
+  };
+
+  void take(std::unordered_map<Crypto::Hash, Entry>::iterator it, Transactions& taken);
+  size_t slot(time_t time) const;
+
+  const size_t m_maxCount;
+  const size_t m_maxSize;
+  const time_t m_maxEmbargo;
+
+  std::unordered_map<Crypto::Hash, Entry> m_transactions;
+  std::list<Crypto::Hash> m_ages;                  // oldest first
+  std::vector<std::vector<Crypto::Hash>> m_wheel;  // by embargo end modulo the wheel size, may hold removed ones
+  time_t m_lastExpired;                            // the last second whose slot was emptied, 0 before the first call
+  size_t m_size;
+};
+
+}
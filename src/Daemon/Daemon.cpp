@@ -20,6 +20,9 @@
 
 #include "version.h"
 
+#include <chrono>
+#include <iomanip>
+
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 
@@ -43,6 +46,8 @@
 #include "P2p/NetNodeConfig.h"
 #include "Rpc/RpcServer.h"
 #include "Rpc/RpcServerConfig.h"
+#include "Rpc/StratumServer.h"
+#include "System/RemoteContext.h"
 #include "version.h"
 
 #include <Logging/LoggerManager.h>
@@ -63,6 +68,10 @@ namespace
   const command_line::arg_descriptor<bool>        arg_os_version                = { "os-version", "" };
   const command_line::arg_descriptor<std::string> arg_log_file                  = { "log-file", "", "" };
   const command_line::arg_descriptor<int>         arg_log_level                 = { "log-level", "", 2 }; // info level
+  const command_line::arg_descriptor<bool>        arg_log_async                 = { "log-async", "Format and write log messages on a background thread" };
+  const command_line::arg_descriptor<uint64_t>    arg_log_max_size              = { "log-max-size", "Roll the log file over at this size in MB and gzip the old one, 0 - never", 0 };
+  const command_line::arg_descriptor<bool>        arg_log_rotate_daily          = { "log-rotate-daily", "Roll the log file over every day and gzip the old one" };
+  const command_line::arg_descriptor<uint64_t>    arg_log_max_files             = { "log-max-files", "Number of rolled over log files to keep, 0 - all", 0 };
   const command_line::arg_descriptor<bool>        arg_no_console                = { "no-console", "Disable daemon console commands" };
   const command_line::arg_descriptor<bool>        arg_print_genesis_tx          = { "print-genesis-tx", "Prints genesis' block tx hex to insert it to config and exits" };
   const command_line::arg_descriptor<bool>        arg_testnet_on                = { "testnet", "Used to deploy test nets. Checkpoints and hardcoded seeds are ignored, "
@@ -70,6 +79,9 @@ namespace
   const command_line::arg_descriptor<std::string> arg_load_checkpoints          = { "load-checkpoints", "<filename> Load checkpoints from csv file.", "" };
   const command_line::arg_descriptor<bool>        arg_disable_checkpoints       = { "without-checkpoints", "Synchronize without checkpoints" };
   const command_line::arg_descriptor<std::string> arg_rollback                  = { "rollback", "Rollback blockchain to <height>", "", true };
+  const command_line::arg_descriptor<std::string> arg_export_bootstrap          = { "export-bootstrap", "<directory> Write a bootstrap snapshot at the last checkpoint and exit", "" };
+  const command_line::arg_descriptor<std::string> arg_export_blocks             = { "export-blocks", "<file> Write the blockchain to a file and exit", "" };
+  const command_line::arg_descriptor<std::string> arg_import_blocks             = { "import-blocks", "<file> Import the blocks of a file written by --export-blocks and exit", "" };
 
   bool command_line_preprocessor(const boost::program_options::variables_map &vm, LoggerRef &logger) {
     bool exit = false;
@@ -98,7 +110,8 @@ namespace
     return;
   }
 
-  JsonValue buildLoggerConfiguration(Level level, const std::string& logfile) {
+  JsonValue buildLoggerConfiguration(Level level, const std::string& logfile, const po::variables_map& vm) {
+    bool async = command_line::get_arg(vm, arg_log_async);
     JsonValue loggerConfiguration(JsonValue::OBJECT);
     loggerConfiguration.insert("globalLevel", static_cast<int64_t>(level));
 
@@ -108,11 +121,16 @@ namespace
     fileLogger.insert("type", "file");
     fileLogger.insert("filename", logfile);
     fileLogger.insert("level", static_cast<int64_t>(TRACE));
+    fileLogger.insert("async", JsonValue(async));
+    fileLogger.insert("maxSize", static_cast<int64_t>(command_line::get_arg(vm, arg_log_max_size) * 1024 * 1024));
+    fileLogger.insert("daily", JsonValue(command_line::get_arg(vm, arg_log_rotate_daily)));
+    fileLogger.insert("maxFiles", static_cast<int64_t>(command_line::get_arg(vm, arg_log_max_files)));
 
     JsonValue& consoleLogger = cfgLoggers.pushBack(JsonValue::OBJECT);
     consoleLogger.insert("type", "console");
     consoleLogger.insert("level", static_cast<int64_t>(TRACE));
     consoleLogger.insert("pattern", "%D %T %L ");
+    consoleLogger.insert("async", JsonValue(async));
 
     return loggerConfiguration;
   }
@@ -146,12 +164,19 @@ int main(int argc, char* argv[])
 
     command_line::add_arg(desc_cmd_sett, arg_log_file);
     command_line::add_arg(desc_cmd_sett, arg_log_level);
+    command_line::add_arg(desc_cmd_sett, arg_log_async);
+    command_line::add_arg(desc_cmd_sett, arg_log_max_size);
+    command_line::add_arg(desc_cmd_sett, arg_log_rotate_daily);
+    command_line::add_arg(desc_cmd_sett, arg_log_max_files);
     command_line::add_arg(desc_cmd_sett, arg_no_console);
     command_line::add_arg(desc_cmd_sett, arg_testnet_on);
     command_line::add_arg(desc_cmd_sett, arg_print_genesis_tx);
     command_line::add_arg(desc_cmd_sett, arg_load_checkpoints);
     command_line::add_arg(desc_cmd_sett, arg_disable_checkpoints);
     command_line::add_arg(desc_cmd_sett, arg_rollback);
+    command_line::add_arg(desc_cmd_sett, arg_export_bootstrap);
+    command_line::add_arg(desc_cmd_sett, arg_export_blocks);
+    command_line::add_arg(desc_cmd_sett, arg_import_blocks);
 
     RpcServerConfig::initOptions(desc_cmd_sett);
     CoreConfig::initOptions(desc_cmd_sett);
@@ -212,7 +237,7 @@ int main(int argc, char* argv[])
     Level cfgLogLevel = static_cast<Level>(static_cast<int>(Logging::ERROR) + command_line::get_arg(vm, arg_log_level));
 
     // configure logging
-    logManager.configure(buildLoggerConfiguration(cfgLogLevel, cfgLogFile));
+    logManager.configure(buildLoggerConfiguration(cfgLogLevel, cfgLogFile, vm));
 
     logger(INFO) << CryptoNote::CRYPTONOTE_NAME << " v. " << PROJECT_VERSION_LONG;
 
@@ -270,6 +295,12 @@ int main(int argc, char* argv[])
       return 1;
     }
     CryptoNote::Currency currency = currencyBuilder.currency();
+
+    // threads started from here on, e.g. the RPC and SSL ones, inherit the dispatcher CPUs
+    if (!Tools::setCurrentThreadAffinity(netNodeConfig.getDispatcherCpus())) {
+      logger(WARNING, YELLOW) << "Failed to bind the dispatcher to the requested CPUs";
+    }
+
     System::Dispatcher dispatcher;
     CryptoNote::Core m_core(currency, nullptr, logManager, dispatcher, vm["enable-blockchain-indexes"].as<bool>());
 
@@ -281,7 +312,8 @@ int main(int argc, char* argv[])
       }
 
 #ifndef __ANDROID__
-      checkpoints.load_checkpoints_from_dns();
+      // the records are fetched while the core loads, the blockchain merges them when they arrive
+      checkpoints.refresh_checkpoints_from_dns();
 #endif
 
       bool manual_checkpoints = !command_line::get_arg(vm, arg_load_checkpoints).empty();
@@ -313,6 +345,7 @@ int main(int argc, char* argv[])
     CryptoNote::CryptoNoteProtocolHandler cprotocol(currency, dispatcher, m_core, nullptr, logManager);
     CryptoNote::NodeServer p2psrv(dispatcher, cprotocol, logManager);
     CryptoNote::RpcServer rpcServer(dispatcher, logManager, m_core, p2psrv, cprotocol);
+    CryptoNote::StratumServer stratumServer(dispatcher, logManager, currency, m_core, m_core);
 
     cprotocol.set_p2p_endpoint(&p2psrv);
     m_core.set_cryptonote_protocol(&cprotocol);
@@ -332,22 +365,123 @@ int main(int argc, char* argv[])
       dh_file_path = data_dir_path / dh_file_path;
     }
 
+    std::chrono::steady_clock::time_point startupTimePoint = std::chrono::steady_clock::now();
+    std::string exportBootstrapFolder = command_line::get_arg(vm, arg_export_bootstrap);
+    std::string exportBlocksFile = command_line::get_arg(vm, arg_export_blocks);
+    std::string importBlocksFile = command_line::get_arg(vm, arg_import_blocks);
+    bool offlineMode = !exportBootstrapFolder.empty() || !exportBlocksFile.empty() || !importBlocksFile.empty();
+
+    // the core loads on a thread of its own while the p2p and rpc servers start on this one
+    logger(INFO) << "Initializing core...";
+    double coreDuration = 0;
+    System::RemoteContext<bool> coreInit(dispatcher, [&] {
+      bool initialized = m_core.init(coreConfig, minerConfig, true);
+      coreDuration = std::chrono::duration<double>(std::chrono::steady_clock::now() - startupTimePoint).count();
+      return initialized;
+    });
+
     // initialize objects
     logger(INFO) << "Initializing p2p server...";
     if (!p2psrv.init(netNodeConfig)) {
       logger(ERROR, BRIGHT_RED) << "Failed to initialize p2p server.";
+      if (coreInit.get()) {
+        m_core.deinit();
+      }
       return 1;
     }
+    double p2pDuration = std::chrono::duration<double>(std::chrono::steady_clock::now() - startupTimePoint).count();
     logger(INFO) << "P2p server initialized OK";
 
-    // initialize Core here
-    logger(INFO) << "Initializing core...";
-    if (!m_core.init(coreConfig, minerConfig, true)) {
+    auto startRpcServer = [&]() -> bool {
+      bool server_ssl_enable = false;
+      if (rpcConfig.isEnabledSSL()) {
+        if (boost::filesystem::exists(chain_file_path, ec) &&
+          boost::filesystem::exists(key_file_path, ec) &&
+          boost::filesystem::exists(dh_file_path, ec)) {
+          rpcServer.setCerts(boost::filesystem::canonical(chain_file_path).string(),
+            boost::filesystem::canonical(key_file_path).string(),
+            boost::filesystem::canonical(dh_file_path).string());
+          server_ssl_enable = true;
+        }
+        else {
+          logger(ERROR, BRIGHT_RED) << "Start RPC SSL server was canceled because certificate file(s) could not be found" << std::endl;
+        }
+      }
+      std::string ssl_info = "";
+      if (server_ssl_enable) ssl_info += ", SSL on address " + rpcConfig.getBindAddressSSL();
+      logger(INFO) << "Starting core rpc server on address " << rpcConfig.getBindAddress() << ssl_info;
+      rpcServer.setWorkerThreads(rpcConfig.getWorkerThreads());
+      rpcServer.setConcurrencyLimit(CryptoNote::HttpServer::PRIORITY_NORMAL, rpcConfig.getMaxNormalRequests());
+      rpcServer.setConcurrencyLimit(CryptoNote::HttpServer::PRIORITY_LOW, rpcConfig.getMaxBulkRequests());
+      rpcServer.setMaxQueuedRequests(rpcConfig.getMaxQueuedRequests());
+      rpcServer.start(rpcConfig.getBindIP(), rpcConfig.getBindPort(), rpcConfig.getBindPortSSL(), server_ssl_enable);
+      rpcServer.restrictRpc(rpcConfig.restrictedRPC);
+      rpcServer.enableCors(rpcConfig.enableCors);
+      if (!rpcConfig.nodeFeeAddress.empty() && !rpcConfig.nodeFeeAmountStr.empty()) {
+        AccountPublicAddress acc = boost::value_initialized<AccountPublicAddress>();
+        if (!currency.parseAccountAddressString(rpcConfig.nodeFeeAddress, acc)) {
+          logger(ERROR, BRIGHT_RED) << "Bad fee address: " << rpcConfig.nodeFeeAddress;
+          return false;
+        }
+        rpcServer.setFeeAddress(rpcConfig.nodeFeeAddress, acc);
+
+        uint64_t fee;
+        if (!Common::Format::parseAmount(rpcConfig.nodeFeeAmountStr, fee)) {
+          logger(ERROR, BRIGHT_RED) << "Couldn't parse fee amount";
+          return false;
+        }
+        if (fee > CryptoNote::parameters::COIN) {
+          logger(ERROR, BRIGHT_RED) << "Maximum allowed fee is " 
+            << Common::Format::formatAmount(CryptoNote::parameters::COIN);
+          return false;
+        }
+
+        rpcServer.setFeeAmount(fee);
+      }
+    
+      if (!rpcConfig.nodeFeeViewKey.empty()) {
+        rpcServer.setViewKey(rpcConfig.nodeFeeViewKey);
+      }
+      if (!rpcConfig.contactInfo.empty()) {
+        rpcServer.setContactInfo(rpcConfig.contactInfo);
+      }
+      return true;
+    };
+
+    // until the core is loaded the rpc server answers getinfo and getheight with a busy status
+    double rpcDuration = 0;
+    if (!offlineMode) {
+      std::chrono::steady_clock::time_point rpcTimePoint = std::chrono::steady_clock::now();
+      if (!startRpcServer()) {
+        rpcServer.stop();
+        if (coreInit.get()) {
+          m_core.deinit();
+        }
+        p2psrv.deinit();
+        return 1;
+      }
+      rpcDuration = std::chrono::duration<double>(std::chrono::steady_clock::now() - rpcTimePoint).count();
+      logger(INFO) << "Core rpc server started ok";
+    }
+
+    if (!coreInit.get()) {
       logger(ERROR, BRIGHT_RED) << "Failed to initialize core";
+      rpcServer.stop();
+      p2psrv.deinit();
       return 1;
     }
     logger(INFO) << "Core initialized OK";
 
+    // the miners are handed templates of the loaded chain only
+    if (!offlineMode && rpcConfig.stratumBindPort != 0) {
+      logger(INFO) << "Starting stratum server on address " << rpcConfig.getStratumBindAddress();
+      stratumServer.start(rpcConfig.getBindIP(), rpcConfig.stratumBindPort, rpcConfig.stratumDifficulty);
+    }
+
+    std::chrono::duration<double> startupDuration = std::chrono::steady_clock::now() - startupTimePoint;
+    logger(INFO) << "Started in " << std::fixed << std::setprecision(2) << startupDuration.count() << " s: p2p server "
+      << p2pDuration << " s, rpc server " << rpcDuration << " s, core " << coreDuration << " s";
+
     if (command_line::has_arg(vm, arg_rollback)) {
       std::string rollback_str = command_line::get_arg(vm, arg_rollback);
       if (!rollback_str.empty()) {
@@ -360,60 +494,27 @@ int main(int argc, char* argv[])
       }
     }
 
-    // start components
-    if (!command_line::has_arg(vm, arg_no_console)) {
-      dch.start_handling();
-    }
-
-    bool server_ssl_enable = false;
-    if (rpcConfig.isEnabledSSL()) {
-      if (boost::filesystem::exists(chain_file_path, ec) &&
-        boost::filesystem::exists(key_file_path, ec) &&
-        boost::filesystem::exists(dh_file_path, ec)) {
-        rpcServer.setCerts(boost::filesystem::canonical(chain_file_path).string(),
-          boost::filesystem::canonical(key_file_path).string(),
-          boost::filesystem::canonical(dh_file_path).string());
-        server_ssl_enable = true;
+    if (offlineMode) {
+      bool done = true;
+      if (!importBlocksFile.empty()) {
+        done = m_core.importBlocks(importBlocksFile);
       }
-      else {
-        logger(ERROR, BRIGHT_RED) << "Start RPC SSL server was canceled because certificate file(s) could not be found" << std::endl;
+      if (done && !exportBlocksFile.empty()) {
+        done = m_core.exportBlocks(exportBlocksFile);
       }
-    }
-    std::string ssl_info = "";
-    if (server_ssl_enable) ssl_info += ", SSL on address " + rpcConfig.getBindAddressSSL();
-    logger(INFO) << "Starting core rpc server on address " << rpcConfig.getBindAddress() << ssl_info;
-    rpcServer.start(rpcConfig.getBindIP(), rpcConfig.getBindPort(), rpcConfig.getBindPortSSL(), server_ssl_enable);
-    rpcServer.restrictRpc(rpcConfig.restrictedRPC);
-    rpcServer.enableCors(rpcConfig.enableCors);
-    if (!rpcConfig.nodeFeeAddress.empty() && !rpcConfig.nodeFeeAmountStr.empty()) {
-      AccountPublicAddress acc = boost::value_initialized<AccountPublicAddress>();
-      if (!currency.parseAccountAddressString(rpcConfig.nodeFeeAddress, acc)) {
-        logger(ERROR, BRIGHT_RED) << "Bad fee address: " << rpcConfig.nodeFeeAddress;
-        return 1;
-      }
-      rpcServer.setFeeAddress(rpcConfig.nodeFeeAddress, acc);
-
-      uint64_t fee;
-      if (!Common::Format::parseAmount(rpcConfig.nodeFeeAmountStr, fee)) {
-        logger(ERROR, BRIGHT_RED) << "Couldn't parse fee amount";
-        return 1;
-      }
-      if (fee > CryptoNote::parameters::COIN) {
-        logger(ERROR, BRIGHT_RED) << "Maximum allowed fee is " 
-          << Common::Format::formatAmount(CryptoNote::parameters::COIN);
-        return 1;
+      if (done && !exportBootstrapFolder.empty()) {
+        done = m_core.exportBootstrap(exportBootstrapFolder);
       }
 
-      rpcServer.setFeeAmount(fee);
+      m_core.deinit();
+      p2psrv.deinit();
+      return done ? 0 : 1;
     }
-    
-    if (!rpcConfig.nodeFeeViewKey.empty()) {
-      rpcServer.setViewKey(rpcConfig.nodeFeeViewKey);
-    }
-    if (!rpcConfig.contactInfo.empty()) {
-      rpcServer.setContactInfo(rpcConfig.contactInfo);
+
+    // start components
+    if (!command_line::has_arg(vm, arg_no_console)) {
+      dch.start_handling();
     }
-    logger(INFO) << "Core rpc server started ok";
 
     Tools::SignalHandler::install([&dch, &p2psrv] {
       dch.stop_handling();
@@ -427,6 +528,8 @@ int main(int argc, char* argv[])
     dch.stop_handling();
 
     //stop components
+    logger(INFO) << "Stopping stratum server...";
+    stratumServer.stop();
     logger(INFO) << "Stopping core rpc server...";
     rpcServer.stop();
 
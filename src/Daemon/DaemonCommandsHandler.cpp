@@ -24,6 +24,7 @@
 #include <ctime>
 #include "P2p/NetNode.h"
 #include <Common/ColouredMsg.h>
+#include "Common/Tracing.h"
 #include "CryptoNoteCore/Miner.h"
 #include "CryptoNoteCore/Core.h"
 #include "CryptoNoteProtocol/CryptoNoteProtocolHandler.h"
@@ -71,6 +72,9 @@ DaemonCommandsHandler::DaemonCommandsHandler(CryptoNote::Core& core, CryptoNote:
   m_consoleHandler.setHandler("unban", boost::bind(&DaemonCommandsHandler::unban, this, boost::arg<1>()), "Unban a given <IP>, unban <IP>");
   m_consoleHandler.setHandler("status", boost::bind(&DaemonCommandsHandler::status, this, boost::arg<1>()), "Show daemon status");
   m_consoleHandler.setHandler("save", boost::bind(&DaemonCommandsHandler::save, this, boost::arg<1>()), "Store blockchain");
+  m_consoleHandler.setHandler("rpc_stats", boost::bind(&DaemonCommandsHandler::print_rpc_stats, this, boost::arg<1>()), "Print RPC call counters and latencies");
+  m_consoleHandler.setHandler("trace", boost::bind(&DaemonCommandsHandler::trace, this, boost::arg<1>()),
+    "Trace block and transaction processing, trace start [<max_events>] | stop | dump <file>, the dump opens in chrome://tracing");
 }
 
 //--------------------------------------------------------------------------------
@@ -461,4 +465,37 @@ bool DaemonCommandsHandler::unban(const std::vector<std::string>& args)
 bool DaemonCommandsHandler::save(const std::vector<std::string>& args) {
   return m_core.saveBlockchain();
 }
+//--------------------------------------------------------------------------------
+bool DaemonCommandsHandler::print_rpc_stats(const std::vector<std::string>& args) {
+  std::string summary = m_prpc_server->getMetrics().summary();
+  logger(Logging::INFO) << "RPC calls since start:" << ENDL << (summary.empty() ? "none\n" : summary);
+  return true;
+}
+//--------------------------------------------------------------------------------
+bool DaemonCommandsHandler::trace(const std::vector<std::string>& args) {
+  Common::Tracer& tracer = Common::Tracer::instance();
+  if (args.size() >= 1 && args.size() <= 2 && args[0] == "start") {
+    size_t maxEvents = Common::Tracer::DEFAULT_MAX_EVENTS;
+    if (args.size() == 2 && (!Common::fromString(args[1], maxEvents) || maxEvents == 0)) {
+      std::cout << "wrong number of events, use: trace start [<max_events>]" << ENDL;
+      return true;
+    }
+
+    tracer.start(maxEvents);
+    std::cout << "Tracing started, keeping the last " << maxEvents << " spans" << ENDL;
+  } else if (args.size() == 1 && args[0] == "stop") {
+    tracer.stop();
+    std::cout << "Tracing stopped, " << tracer.eventCount() << " spans collected" << ENDL;
+  } else if (args.size() == 2 && args[0] == "dump") {
+    if (!tracer.writeJson(args[1])) {
+      std::cout << "Failed to write " << args[1] << ENDL;
+    } else {
+      std::cout << tracer.eventCount() << " spans written to " << args[1] << ENDL;
+    }
+  } else {
+    std::cout << "use: trace start [<max_events>] | stop | dump <file>" << ENDL;
+  }
+
+  return true;
+}
 
@@ -87,4 +87,6 @@ private:
   bool unban(const std::vector<std::string>& args);
   bool status(const std::vector<std::string>& args);
   bool save(const std::vector<std::string>& args);
+  bool print_rpc_stats(const std::vector<std::string>& args);
+  bool trace(const std::vector<std::string>& args);
 };
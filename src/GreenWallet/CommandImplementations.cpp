@@ -408,7 +408,7 @@ void status(CryptoNote::INode &node, CryptoNote::WalletGreen &wallet)
 
 void reset(CryptoNote::INode &node, std::shared_ptr<WalletInfo> walletInfo)
 {
-	uint64_t scanHeight = getScanHeight();
+	uint64_t scanHeight = getScanHeight(node);
 
 	std::cout << std::endl
 		<< InformationMsg("This process may take some time to complete.")
@@ -58,8 +58,6 @@ std::string getInputAndWorkInBackground(const std::vector<T> &availableCommands,
        another thread. */
     if (backgroundRefresh)
     {
-        auto lastUpdated = std::chrono::system_clock::now();
-
         std::future<std::string> inputGetter = std::async(std::launch::async, 
         [&availableCommands, &prompt]
         {
@@ -80,18 +78,9 @@ std::string getInputAndWorkInBackground(const std::vector<T> &availableCommands,
                 return inputGetter.get();
             }
 
-            const auto currentTime = std::chrono::system_clock::now();
-
-            /* Otherwise check if we need to update the wallet cache */
-            if ((currentTime - lastUpdated) > std::chrono::seconds(5))
-            {
-                lastUpdated = currentTime;
-                checkForNewTransactions(walletInfo);
-            }
-
-            /* Sleep for enough for it to not be noticeable when the user
-               enters something, but enough that we're not starving the CPU */
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            /* Otherwise let the wallet run for a while. Short enough for it to
+               not be noticeable when the user enters something */
+            checkForNewTransactions(walletInfo, std::chrono::milliseconds(50));
         }
     }
     else
@@ -169,6 +169,11 @@ Config parseArguments(int argc, char **argv)
       config.disableVerify = true;
     }
 
+    if (cmdOptionExists(argv, argv+argc, "--server-scan"))
+    {
+        config.serverScan = true;
+    }
+
     return config;
 }
 
@@ -195,6 +200,9 @@ std::vector<CLICommand> getCLICommands()
 
         {"--daemon-no-verify", "Disable verification procedure", "", false, false},
 
+        {"--server-scan", "Send the view key to your own daemon to sync faster",
+         "", false, false},
+
         {"--wallet-file <file>", "Open the wallet <file>", "", false, true},
 
         {"--password <pass>", "Use the password <pass> to open the wallet", "",
@@ -9,6 +9,7 @@
 
 #include <Common/StringTools.h>
 
+#include <chrono>
 #include <iostream>
 
 #include <Common/ColouredMsg.h>
@@ -18,19 +19,39 @@
 #include <GreenWallet/Types.h>
 #include <GreenWallet/WalletConfig.h>
 
-void checkForNewTransactions(std::shared_ptr<WalletInfo> walletInfo)
+void checkForNewTransactions(std::shared_ptr<WalletInfo> walletInfo,
+                             std::chrono::milliseconds timeout)
 {
-    walletInfo->wallet.updateInternalCache();
+    CryptoNote::WalletEvent event;
 
-    const size_t newTransactionCount = walletInfo->wallet.getTransactionCount();
-
-    if (newTransactionCount != walletInfo->knownTransactionCount)
+    /* Waiting for the events runs the wallet on this thread. Only the
+       first wait can take the whole timeout, the rest drains the queue */
+    while (walletInfo->wallet.getEvent(event, timeout))
     {
-        for (size_t i = walletInfo->knownTransactionCount; 
-                    i < newTransactionCount; i++)
+        timeout = std::chrono::milliseconds(0);
+
+        size_t transactionCount;
+
+        if (event.type == CryptoNote::TRANSACTION_CREATED)
+        {
+            transactionCount = event.transactionCreated.transactionIndex + 1;
+        }
+        /* The creation events were lost in an overflow of the event
+           queue, the new transactions are found by the count instead */
+        else if (event.type == CryptoNote::EVENTS_DROPPED)
+        {
+            transactionCount = walletInfo->wallet.getTransactionCount();
+        }
+        else
+        {
+            continue;
+        }
+
+        for (; walletInfo->knownTransactionCount < transactionCount;
+               walletInfo->knownTransactionCount++)
         {
             const CryptoNote::WalletTransaction t 
-                = walletInfo->wallet.getTransaction(i);
+                = walletInfo->wallet.getTransaction(walletInfo->knownTransactionCount);
 
             /* Don't print outgoing or fusion transfers */
             if (t.totalAmount > 0)
@@ -49,8 +70,6 @@ void checkForNewTransactions(std::shared_ptr<WalletInfo> walletInfo)
                           << std::flush;
             }
         }
-
-        walletInfo->knownTransactionCount = newTransactionCount;
     }
 }
 
@@ -113,38 +132,22 @@ void syncWallet(CryptoNote::INode &node,
                   << std::endl << std::endl;
     }
 
-    int counter = 1;
+    auto lastSaved = std::chrono::steady_clock::now();
 
     while (walletHeight < localHeight)
     {
-        /* This MUST be called on the main thread! */
-        walletInfo->wallet.updateInternalCache();
-
-        localHeight = node.getLastLocalBlockHeight();
-        remoteHeight = node.getLastKnownBlockHeight();
         std::cout << SuccessMsg(std::to_string(walletHeight))
                   << " of " << InformationMsg(std::to_string(localHeight))
                   << "                                       \r" << std::flush;
 
-        const uint32_t tmpWalletHeight = walletInfo->wallet.getBlockCount();
-
-        int waitSeconds = 1;
-
-        /* Save periodically so if someone closes before completion they don't
-           lose all their progress */
-        if (counter % 600 == 0)
-        {
-            std::cout << std::endl
-                      << InformationMsg("Saving current progress...")
-                      << std::endl << std::endl;
-
-            walletInfo->wallet.save();
-        }
+        /* Waiting for an event runs the wallet on this thread. It reports
+           its progress after every batch of blocks, so a wallet that stays
+           quiet for the whole wait is one that doesn't move */
+        CryptoNote::WalletEvent event;
 
-        if (tmpWalletHeight == walletHeight)
+        if (!walletInfo->wallet.getEvent(event, std::chrono::seconds(3)))
         {
             stuckCounter++;
-            waitSeconds = 3;
 
             if (stuckCounter > 20)
             {
@@ -166,49 +169,64 @@ void syncWallet(CryptoNote::INode &node,
                    So we'll try this before warning the user.
                 */
 				walletInfo->wallet.save();
-                waitSeconds = 5;
             }
         }
-        else
+        else if (event.type == CryptoNote::TRANSACTION_CREATED
+              || event.type == CryptoNote::EVENTS_DROPPED)
         {
-            stuckCounter = 0;
-            walletHeight = tmpWalletHeight;
-
-            const size_t tmpTransactionCount = walletInfo
-                                             ->wallet.getTransactionCount();
-
-            if (tmpTransactionCount != transactionCount)
+            /* After an overflow of the event queue the new transactions
+               are found by the count, their creation events are lost */
+            const size_t newTransactionCount
+                = event.type == CryptoNote::EVENTS_DROPPED
+                ? walletInfo->wallet.getTransactionCount()
+                : event.transactionCreated.transactionIndex + 1;
+
+            for (; transactionCount < newTransactionCount; transactionCount++)
             {
-                for (size_t i = transactionCount; i < tmpTransactionCount; i++)
+                CryptoNote::WalletTransaction t
+                    = walletInfo->wallet.getTransaction(transactionCount);
+
+                /* Don't print out fusion transactions */
+                if (t.totalAmount != 0)
                 {
-                    CryptoNote::WalletTransaction t
-                        = walletInfo->wallet.getTransaction(i);
+                    std::cout << std::endl
+                              << InformationMsg("New transaction found!")
+                              << std::endl << std::endl;
 
-                    /* Don't print out fusion transactions */
-                    if (t.totalAmount != 0)
+                    if (t.totalAmount < 0)
+                    {
+                        printOutgoingTransfer(t, node);
+                    }
+                    else
                     {
-                        std::cout << std::endl
-                                  << InformationMsg("New transaction found!")
-                                  << std::endl << std::endl;
-
-                        if (t.totalAmount < 0)
-                        {
-                            printOutgoingTransfer(t, node);
-                        }
-                        else
-                        {
-                            printIncomingTransfer(t, node);
-                        }
+                        printIncomingTransfer(t, node);
                     }
                 }
-
-                transactionCount = tmpTransactionCount;
             }
         }
 
-        counter++;
+        const uint32_t tmpWalletHeight = walletInfo->wallet.getBlockCount();
 
-        std::this_thread::sleep_for(std::chrono::seconds(waitSeconds));
+        if (tmpWalletHeight != walletHeight)
+        {
+            stuckCounter = 0;
+            walletHeight = tmpWalletHeight;
+        }
+
+        localHeight = node.getLastLocalBlockHeight();
+        remoteHeight = node.getLastKnownBlockHeight();
+
+        /* Save periodically so if someone closes before completion they don't
+           lose all their progress */
+        if (std::chrono::steady_clock::now() - lastSaved > std::chrono::minutes(10))
+        {
+            std::cout << std::endl
+                      << InformationMsg("Saving current progress...")
+                      << std::endl << std::endl;
+
+            walletInfo->wallet.save();
+            lastSaved = std::chrono::steady_clock::now();
+        }
     }
 
     std::cout << std::endl
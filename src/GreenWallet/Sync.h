@@ -5,9 +5,14 @@
 
 #pragma once
 
+#include <chrono>
+
 #include <GreenWallet/Types.h>
 
 void syncWallet(CryptoNote::INode &node,
                 std::shared_ptr<WalletInfo> walletInfo);
 
-void checkForNewTransactions(std::shared_ptr<WalletInfo> walletInfo);
+/* Waits at most timeout for the wallet and prints the incoming transfers it
+   found meanwhile */
+void checkForNewTransactions(std::shared_ptr<WalletInfo> walletInfo,
+                             std::chrono::milliseconds timeout);
@@ -8,8 +8,10 @@
 ////////////////////////////
 
 #include <boost/algorithm/string.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
 
 #include <cmath>
+#include <future>
 
 #include <Common/Base58.h>
 #include <Common/StringTools.h>
@@ -230,7 +232,38 @@ std::string createIntegratedAddress(std::string address, std::string paymentID)
 	);
 }
 
-uint64_t getScanHeight()
+/* Asks the node for the height the blocks made at the date start from */
+bool dateToHeight(CryptoNote::INode &node, const std::string &date, uint64_t &height)
+{
+	uint64_t timestamp;
+
+	try
+	{
+		const boost::gregorian::date day = boost::gregorian::from_simple_string(date);
+		timestamp = (day - boost::gregorian::date(1970, 1, 1)).days() * 86400ULL;
+	}
+	catch (const std::exception &)
+	{
+		return false;
+	}
+
+	std::vector<uint32_t> heights;
+	std::promise<std::error_code> errorPromise;
+	auto error = errorPromise.get_future();
+
+	node.getBlockHeightsByTimestamps({ timestamp }, heights,
+		[&errorPromise](std::error_code e) { errorPromise.set_value(e); });
+
+	if (error.get() || heights.size() != 1)
+	{
+		return false;
+	}
+
+	height = heights.front();
+	return true;
+}
+
+uint64_t getScanHeight(CryptoNote::INode &node)
 {
 	while (true)
 	{
@@ -247,6 +280,10 @@ uint64_t getScanHeight()
 			<< "get missed."
 			<< std::endl
 			<< std::endl
+			<< "You can also enter the date the wallet was created "
+			<< "on, as YYYY-MM-DD."
+			<< std::endl
+			<< std::endl
 			<< InformationMsg("Hit enter for the sub-optimal default ")
 			<< InformationMsg("of zero: ");
 
@@ -262,6 +299,23 @@ uint64_t getScanHeight()
 			return 0;
 		}
 
+		if (stringHeight.find('-') != std::string::npos)
+		{
+			uint64_t height;
+
+			if (dateToHeight(node, stringHeight, height))
+			{
+				std::cout << InformationMsg("Scanning from height ")
+					<< InformationMsg(std::to_string(height))
+					<< std::endl << std::endl;
+				return height;
+			}
+
+			std::cout << WarningMsg("Failed to find the height of the date!")
+				<< std::endl << std::endl;
+			continue;
+		}
+
 		try
 		{
 			return std::stoi(stringHeight);
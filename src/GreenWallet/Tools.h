@@ -36,7 +36,7 @@ bool shutdown(std::shared_ptr<WalletInfo> walletInfo, CryptoNote::INode &node,
 
 uint64_t getDivisor();
 
-uint64_t getScanHeight();
+uint64_t getScanHeight(CryptoNote::INode &node);
 
 template <typename T, typename Function>
 std::vector<T> filter(std::vector<T> input, Function predicate)
@@ -1057,7 +1057,7 @@ std::string resolveAlias(const std::string& aliasUrl)
     std::string host, uri, address;
     std::vector<std::string>records;
 
-    if (!Common::fetch_dns_txt(aliasUrl, records)) {
+    if (!Common::fetch_dns_txt_cached(aliasUrl, records)) {
         throw std::runtime_error("Failed to lookup DNS record");
     }
 
@@ -87,6 +87,9 @@ struct Config
     /* Disable verify cert of domain */
     bool disableVerify = false;
 
+    /* Let the daemon find our transactions with the view key */
+    bool serverScan = false;
+
     /* The daemon port */
     uint16_t port = CryptoNote::RPC_DEFAULT_PORT;
 
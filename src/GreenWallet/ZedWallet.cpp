@@ -150,6 +150,11 @@ void run(CryptoNote::WalletGreen &wallet, CryptoNote::INode &node,
 
 	bool alreadyShuttingDown = false;
 
+	if (!quit && config.serverScan)
+	{
+		enableServerScan(walletInfo, node);
+	}
+
 	if (!quit)
 	{
 		/* Call shutdown on ctrl+c */
@@ -168,3 +173,46 @@ void run(CryptoNote::WalletGreen &wallet, CryptoNote::INode &node,
 
 	shutdown(walletInfo, node, alreadyShuttingDown);
 }
+
+void enableServerScan(std::shared_ptr<WalletInfo> walletInfo,
+                      CryptoNote::INode &node)
+{
+    auto *proxy = dynamic_cast<CryptoNote::NodeRpcProxy *>(&node);
+
+    if (proxy == nullptr)
+    {
+        return;
+    }
+
+    CryptoNote::WalletGreen &wallet = walletInfo->wallet;
+
+    std::vector<Crypto::PublicKey> spendKeys;
+
+    for (size_t i = 0; i < wallet.getAddressCount(); i++)
+    {
+        spendKeys.push_back(wallet.getAddressSpendKey(i).publicKey);
+    }
+
+    /* The daemon finds the spends by the rings that use our outputs, a view
+       wallet can't tell its spends anyway */
+    std::vector<std::pair<uint64_t, uint32_t>> outputs;
+
+    if (!walletInfo->viewWallet)
+    {
+        const auto transfers = wallet.getTransfers(0,
+            CryptoNote::ITransfersContainer::IncludeTypeKey
+          | CryptoNote::ITransfersContainer::IncludeStateAll);
+
+        for (const auto &transfer : transfers)
+        {
+            outputs.emplace_back(transfer.amount, transfer.globalOutputIndex);
+        }
+    }
+
+    proxy->setSyncFilter(wallet.getViewKey().secretKey, spendKeys, outputs);
+
+    std::cout << InformationMsg("The daemon scans the blockchain for your "
+                                "transactions, use this only with a "
+                                "daemon you trust.")
+              << std::endl;
+}
@@ -12,3 +12,6 @@ int main(int argc, char **argv);
 
 void run(CryptoNote::WalletGreen &wallet, CryptoNote::INode &node,
          Config &config);
+
+void enableServerScan(std::shared_ptr<WalletInfo> walletInfo,
+                      CryptoNote::INode &node);
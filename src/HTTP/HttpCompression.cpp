@@ -0,0 +1,179 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "HttpCompression.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <zlib.h>
+
+namespace CryptoNote {
+namespace HttpCompression {
+
+const char ENCODING_DEFLATE[] = "deflate";
+const char ENCODING_DICTIONARY[] = "x-karbo-deflate-1";
+const char ACCEPT_ENCODING[] = "x-karbo-deflate-1, deflate";
+
+namespace {
+
+// the higher levels hardly gain anything on keys and hashes but take several times longer
+const int COMPRESSION_LEVEL = 1;
+const size_t BUFFER_SIZE = 64 * 1024;
+
+// JSON and binary key-value serializations of a queryblockslite response with one block and
+// transaction, keys, hashes and zero runs cut out; the most frequent binary one is nearest to the data
+const char DICTIONARY[] =
+  "{\"status\":\"OK\",\"startHeight\":500000,\"currentHeight\":500100,\"fullOffset\":0,\"items\":[{\"blockId\":\""
+  "\",\"block\":\"\005\000\200\240\370\372\005\001\000\001\377\240\302\036\001\240\234\001\002!\001\",\"txPrefixe"
+  "s\":[{\"txHash\":\"\",\"txPrefix\":{\"version\":1,\"unlock_time\":0,\"vin\":[{\"type\":\"02\",\"value\":{\"amo"
+  "unt\":1000000,\"key_offsets\":[12345,230,40,5],\"k_image\":\"\"}},{\"type\":\"02\",\"value\":{\"amount\":10000"
+  "00,\"key_offsets\":[12345,230,40,5],\"k_image\":\"\"}}],\"vout\":[{\"amount\":20000,\"target\":{\"type\":\"02"
+  "\",\"data\":{\"key\":\"\"}}},{\"amount\":20000,\"target\":{\"type\":\"02\",\"data\":{\"key\":\"\"}}}],\"extra"
+  "\":\"01\"}}]}]}\001\021\001\001\001\001\002\001\001\024\006status\012\010OK\013startHeight\006 \241\007\000"
+  "\015currentHeight\006\204\241\007\000\012fullOffset\005\005items\214\004\014\007blockId\012\200\005block\012"
+  "\351\001\005\000\200\240\370\372\005\001\000\001\377\240\302\036\001\240\234\001\002!\001\012txPrefixes\214"
+  "\004\010\006txHash\012\200\010txPrefix\014\024\007version\010\001\013unlock_time\005\003vin\214\010\010\004typ"
+  "e\012\004\002\005value\014\014\006amount\005@B\017\013key_offsets\206\02090\000\000\346\000\000\000(\000\000"
+  "\000\005\000\000\000\007k_image\012\200\010\004type\012\004\002\005value\014\014\006amount\005@B\017\013key_of"
+  "fsets\206\02090\000\000\346\000\000\000(\000\000\000\005\000\000\000\007k_image\012\200\004vout\214\010\010"
+  "\006amount\005 N\006target\014\010\004type\012\004\002\004data\014\004\003key\012\200\010\006amount\005 N\006t"
+  "arget\014\010\004type\012\004\002\004data\014\004\003key\012\200\005extra\012\204\001";
+
+std::string trim(const std::string& value) {
+  size_t begin = value.find_first_not_of(" \t");
+  if (begin == std::string::npos) {
+    return std::string();
+  }
+
+  return value.substr(begin, value.find_last_not_of(" \t") - begin + 1);
+}
+
+std::string toLower(std::string value) {
+  std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+  return value;
+}
+
+bool usesDictionary(const std::string& encoding) {
+  if (encoding == ENCODING_DICTIONARY) {
+    return true;
+  } else if (encoding == ENCODING_DEFLATE) {
+    return false;
+  }
+
+  throw std::runtime_error("Unsupported content encoding: " + encoding);
+}
+
+}
+
+std::string negotiate(const std::string& acceptEncoding) {
+  bool deflate = false;
+  size_t begin = 0;
+  while (begin <= acceptEncoding.size()) {
+    size_t end = std::min(acceptEncoding.find(',', begin), acceptEncoding.size());
+    std::string item = acceptEncoding.substr(begin, end - begin);
+    begin = end + 1;
+
+    size_t parameters = item.find(';');
+    std::string coding = toLower(trim(item.substr(0, parameters)));
+    if (parameters != std::string::npos) {
+      std::string quality = trim(item.substr(parameters + 1));
+      if (quality.compare(0, 2, "q=") == 0 && std::strtod(quality.c_str() + 2, nullptr) <= 0) {
+        continue;
+      }
+    }
+
+    if (coding == ENCODING_DICTIONARY) {
+      return ENCODING_DICTIONARY;
+    } else if (coding == ENCODING_DEFLATE) {
+      deflate = true;
+    }
+  }
+
+  return deflate ? ENCODING_DEFLATE : std::string();
+}
+
+std::string compress(const std::string& data, const std::string& encoding) {
+  bool dictionary = usesDictionary(encoding);
+
+  z_stream stream = {};
+  if (deflateInit(&stream, COMPRESSION_LEVEL) != Z_OK) {
+    throw std::runtime_error("deflateInit failed");
+  }
+
+  std::string result;
+  int status = dictionary ? deflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(DICTIONARY), sizeof(DICTIONARY) - 1) : Z_OK;
+  if (status == Z_OK) {
+    result.resize(deflateBound(&stream, static_cast<uLong>(data.size())));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&result[0]);
+    stream.avail_out = static_cast<uInt>(result.size());
+    status = deflate(&stream, Z_FINISH);
+    result.resize(stream.total_out);
+  }
+
+  deflateEnd(&stream);
+  if (status != Z_STREAM_END) {
+    throw std::runtime_error("deflate failed");
+  }
+
+  return result;
+}
+
+std::string decompress(const std::string& data, const std::string& encoding) {
+  bool dictionary = usesDictionary(encoding);
+
+  z_stream stream = {};
+  if (inflateInit(&stream) != Z_OK) {
+    throw std::runtime_error("inflateInit failed");
+  }
+
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = static_cast<uInt>(data.size());
+
+  std::string result;
+  int status = Z_OK;
+  while (status == Z_OK) {
+    size_t offset = result.size();
+    result.resize(offset + BUFFER_SIZE);
+    stream.next_out = reinterpret_cast<Bytef*>(&result[offset]);
+    stream.avail_out = static_cast<uInt>(BUFFER_SIZE);
+    status = inflate(&stream, Z_NO_FLUSH);
+    if (status == Z_NEED_DICT && dictionary) {
+      // fails for a stream made with another dictionary
+      status = inflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(DICTIONARY), sizeof(DICTIONARY) - 1);
+      if (status == Z_OK) {
+        status = inflate(&stream, Z_NO_FLUSH);
+      }
+    }
+
+    result.resize(offset + BUFFER_SIZE - stream.avail_out);
+  }
+
+  inflateEnd(&stream);
+  if (status != Z_STREAM_END) {
+    throw std::runtime_error("Failed to decompress " + encoding + " content");
+  }
+
+  return result;
+}
+
+}
+}
@@ -0,0 +1,41 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <string>
+
+namespace CryptoNote {
+namespace HttpCompression {
+
+// zlib stream, as any HTTP client understands it
+extern const char ENCODING_DEFLATE[];
+// zlib stream with a preset dictionary of the RPC field names and structure bytes,
+// the version changes whenever the dictionary does
+extern const char ENCODING_DICTIONARY[];
+// Accept-Encoding value for the requests of our clients
+extern const char ACCEPT_ENCODING[];
+
+// the content coding to answer with, empty if the Accept-Encoding value allows none of ours
+std::string negotiate(const std::string& acceptEncoding);
+std::string compress(const std::string& data, const std::string& encoding);
+// throws std::runtime_error for damaged data or an unknown encoding
+std::string decompress(const std::string& data, const std::string& encoding);
+
+}
+}
@@ -15,31 +15,92 @@
 //
 // You should have received a copy of the GNU Lesser General Public License
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
-
 #include "HttpParser.h"
 
 #include <algorithm>
+#include <cstring>
 
 #include "HttpParserErrorCodes.h"
 
 namespace {
 
-void throwIfNotGood(std::istream& stream) {
-  if (!stream.good()) {
-    if (stream.eof()) {
-      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::END_OF_STREAM));
-    } else {
-      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::STREAM_NOT_GOOD));
+const char CRLF[] = "\r\n";
+const unsigned long long CHUNK_MAX_SIZE = 1ULL << 30;
+
+[[noreturn]] void throwParserError(CryptoNote::error::HttpParserErrorCodes code) {
+  throw std::system_error(make_error_code(code));
+}
+
+const char* findLineEnd(const char* begin, const char* end) {
+  const char* it = std::search(begin, end, CRLF, CRLF + 2);
+  return it == end ? nullptr : it;
+}
+
+const char* skipSpaces(const char* begin, const char* end) {
+  while (begin != end && (*begin == ' ' || *begin == '\t')) {
+    ++begin;
+  }
+
+  return begin;
+}
+
+// "name: value" lines up to the empty line, names are lowercased
+void parseHeaderLines(const char* begin, const char* end, std::map<std::string, std::string>& headers) {
+  while (begin != end) {
+    const char* eol = findLineEnd(begin, end);
+    if (eol == nullptr) {
+      throwParserError(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL);
+    }
+
+    const char* colon = std::find(begin, eol, ':');
+    if (colon == eol) {
+      throwParserError(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL);
+    }
+
+    if (colon == begin) {
+      throwParserError(CryptoNote::error::HttpParserErrorCodes::EMPTY_HEADER);
+    }
+
+    std::string name(begin, colon);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+    const char* valueEnd = eol;
+    while (valueEnd != colon + 1 && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t')) {
+      --valueEnd;
     }
+
+    const char* valueBegin = skipSpaces(colon + 1, valueEnd);
+    headers[std::move(name)].assign(valueBegin, valueEnd);
+    begin = eol + 2;
+  }
+}
+
+// splits the start line into its three space separated parts
+void splitStartLine(const char* begin, const char* end, std::string& first, std::string& second, std::string& rest) {
+  const char* space = std::find(begin, end, ' ');
+  if (space == end) {
+    throwParserError(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL);
   }
+
+  first.assign(begin, space);
+  begin = space + 1;
+  space = std::find(begin, end, ' ');
+  second.assign(begin, space);
+  rest.assign(space == end ? end : space + 1, end);
 }
 
 }
 
 namespace CryptoNote {
 
+const size_t HttpParser::HEADERS_MAX_SIZE;
+
+HttpParser::HttpParser() : m_scanned(0), m_headersSize(0), m_contentLength(0), m_chunked(false), m_chunkOffset(0) {
+}
+
 HttpResponse::HTTP_STATUS HttpParser::parseResponseStatusFromString(const std::string& status) {
   if (status == "200 OK" || status == "200 Ok") return CryptoNote::HttpResponse::STATUS_200;
+  else if (status == "304 Not Modified") return CryptoNote::HttpResponse::STATUS_304;
   else if (status.substr(0, 4) == "401 ") return CryptoNote::HttpResponse::STATUS_401;
   else if (status == "404 Not Found") return CryptoNote::HttpResponse::STATUS_404;
   else if (status == "500 Internal Server Error") return CryptoNote::HttpResponse::STATUS_500;
@@ -49,178 +110,168 @@ HttpResponse::HTTP_STATUS HttpParser::parseResponseStatusFromString(const std::s
   return CryptoNote::HttpResponse::STATUS_200; //unaccessible
 }
 
+size_t HttpParser::parseRequest(const char* data, size_t size, HttpRequest& request) {
+  if (m_headersSize == 0) {
+    if (!findHeadersEnd(data, size)) {
+      return 0;
+    }
 
-void HttpParser::receiveRequest(std::istream& stream, HttpRequest& request) {
-  readWord(stream, request.method);
-  readWord(stream, request.url);
-
-  std::string httpVersion;
-  readWord(stream, httpVersion);
-
-  readHeaders(stream, request.headers);
+    const char* headersEnd = data + m_headersSize - 2;
+    const char* eol = findLineEnd(data, headersEnd + 2);
+    std::string httpVersion;
+    splitStartLine(data, eol, request.method, request.url, httpVersion);
 
-  std::string body;
-  size_t bodyLen = getBodyLen(request.headers);
-  if (bodyLen) {
-    readBody(stream, request.body, bodyLen);
+    request.headers.clear();
+    parseHeaderLines(eol + 2, headersEnd, request.headers);
+    startBody(request.headers);
   }
+
+  return parseBody(data, size, request.body);
 }
 
+size_t HttpParser::parseResponse(const char* data, size_t size, HttpResponse& response) {
+  if (m_headersSize == 0) {
+    if (!findHeadersEnd(data, size)) {
+      return 0;
+    }
 
-void HttpParser::receiveResponse(std::istream& stream, HttpResponse& response) {
-  std::string httpVersion;
-  readWord(stream, httpVersion);
-  
-  std::string status;
-  char c;
-  
-  stream.get(c);
-  while (stream.good() && c != '\r') { //Till the end
-    status += c;
-    stream.get(c);
-  }
+    const char* headersEnd = data + m_headersSize - 2;
+    const char* eol = findLineEnd(data, headersEnd + 2);
+    std::string httpVersion;
+    std::string code;
+    std::string reason;
+    splitStartLine(data, eol, httpVersion, code, reason);
+    response.setStatus(parseResponseStatusFromString(reason.empty() ? code : code + " " + reason));
+
+    std::map<std::string, std::string> headers;
+    parseHeaderLines(eol + 2, headersEnd, headers);
+    for (const auto& header : headers) {
+      response.addHeader(header.first, header.second);
+    }
 
-  throwIfNotGood(stream);
+    startBody(headers);
+  }
 
-  if (c == '\r') {
-    stream.get(c);
-    if (c != '\n') {
-      throw std::runtime_error("Parser error: '\\n' symbol is expected");
-    }
+  size_t messageSize = parseBody(data, size, m_responseBody);
+  if (messageSize != 0) {
+    response.setBody(m_responseBody);
+    m_responseBody.clear();
   }
 
-  response.setStatus(parseResponseStatusFromString(status));
-  
-  std::string name;
-  std::string value;
+  return messageSize;
+}
 
-  while (readHeader(stream, name, value)) {
-    response.addHeader(name, value);
-    name.clear();
-    value.clear();
-  }
+bool HttpParser::findHeadersEnd(const char* data, size_t size) {
+  // resume the search where the previous call stopped, the terminator may straddle it
+  size_t from = m_scanned > 3 ? m_scanned - 3 : 0;
+  const char terminator[] = "\r\n\r\n";
+  const char* it = std::search(data + from, data + size, terminator, terminator + 4);
+  if (it == data + size) {
+    m_scanned = size;
+    if (size > HEADERS_MAX_SIZE) {
+      throwParserError(error::HttpParserErrorCodes::UNEXPECTED_SYMBOL);
+    }
 
-  response.addHeader(name, value);
-  auto headers = response.getHeaders();
-  size_t length = 0;
-  auto it = headers.find("content-length");
-  if (it != headers.end()) {
-    length = std::stoul(it->second);
-  }
-  
-  std::string body;
-  if (length) {
-    readBody(stream, body, length);
+    return false;
   }
 
-  response.setBody(body);
+  m_headersSize = it - data + 4;
+  return true;
 }
 
+void HttpParser::startBody(const std::map<std::string, std::string>& headers) {
+  m_contentLength = 0;
+  m_chunked = false;
+  m_chunkOffset = m_headersSize;
 
-void HttpParser::readWord(std::istream& stream, std::string& word) {
-  char c;
-
-  stream.get(c);
-  while (stream.good() && c != ' ' && c != '\r') {
-    word += c;
-    stream.get(c);
+  auto it = headers.find("transfer-encoding");
+  if (it != headers.end() && it->second.find("chunked") != std::string::npos) {
+    m_chunked = true;
+    return;
   }
 
-  throwIfNotGood(stream);
-
-  if (c == '\r') {
-    stream.get(c);
-    if (c != '\n') {
-      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL));
+  it = headers.find("content-length");
+  if (it != headers.end()) {
+    char* end = nullptr;
+    unsigned long long length = strtoull(it->second.c_str(), &end, 10);
+    if (end == it->second.c_str() || *end != '\0') {
+      throwParserError(error::HttpParserErrorCodes::UNEXPECTED_SYMBOL);
     }
+
+    m_contentLength = static_cast<size_t>(length);
   }
 }
 
-void HttpParser::readHeaders(std::istream& stream, HttpRequest::Headers& headers) {
-  std::string name;
-  std::string value;
+size_t HttpParser::parseBody(const char* data, size_t size, std::string& body) {
+  if (m_chunked) {
+    return parseChunkedBody(data, size, body);
+  }
 
-  while (readHeader(stream, name, value)) {
-    headers[name] = value; //use insert
-    name.clear();
-    value.clear();
+  if (size - m_headersSize < m_contentLength) {
+    return 0;
   }
 
-  headers[name] = value; //use insert
+  body.assign(data + m_headersSize, m_contentLength);
+  return finish(m_headersSize + m_contentLength);
 }
 
-bool HttpParser::readHeader(std::istream& stream, std::string& name, std::string& value) {
-  char c;
-  bool isName = true;
-
-  stream.get(c);
-  while (stream.good() && c != '\r') {
-    if (c == ':') {
-      if (stream.peek() == ' ') {
-        stream.get(c);
-      }
-
-      if (name.empty()) {
-        throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::EMPTY_HEADER));
-      }
+size_t HttpParser::parseChunkedBody(const char* data, size_t size, std::string& body) {
+  if (m_chunkOffset == m_headersSize) {
+    body.clear();
+  }
 
-      if (isName) {
-        isName = false;
-        stream.get(c);
-        continue;
-      }
+  const char* end = data + size;
+  for (;;) {
+    const char* line = data + m_chunkOffset;
+    const char* eol = findLineEnd(line, end);
+    if (eol == nullptr) {
+      return 0;
     }
 
-    if (isName) {
-      name += c;
-      stream.get(c);
-    } else {
-      value += c;
-      stream.get(c);
+    char* sizeEnd = nullptr;
+    unsigned long long chunkSize = strtoull(line, &sizeEnd, 16);
+    if (sizeEnd == line || (sizeEnd != eol && *sizeEnd != ';' && *sizeEnd != ' ') || chunkSize > CHUNK_MAX_SIZE) {
+      throwParserError(error::HttpParserErrorCodes::UNEXPECTED_SYMBOL);
     }
-  }
-
-  throwIfNotGood(stream);
 
-  stream.get(c);
-  if (c != '\n') {
-    throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL));
-  }
+    if (chunkSize == 0) {
+      // optional trailer headers, then an empty line
+      const char* trailer = eol + 2;
+      for (;;) {
+        const char* trailerEnd = findLineEnd(trailer, end);
+        if (trailerEnd == nullptr) {
+          return 0;
+        }
 
-  std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        if (trailerEnd == trailer) {
+          return finish(trailerEnd + 2 - data);
+        }
 
-  c = stream.peek();
-  if (c == '\r') {
-    stream.get(c).get(c);
-    if (c != '\n') {
-      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL));
+        trailer = trailerEnd + 2;
+      }
     }
 
-    return false; //no more headers
-  }
+    const char* chunk = eol + 2;
+    if (static_cast<unsigned long long>(end - chunk) < chunkSize + 2) {
+      return 0;
+    }
 
-  return true;
-}
+    if (chunk[chunkSize] != '\r' || chunk[chunkSize + 1] != '\n') {
+      throwParserError(error::HttpParserErrorCodes::UNEXPECTED_SYMBOL);
+    }
 
-size_t HttpParser::getBodyLen(const HttpRequest::Headers& headers) {
-  auto it = headers.find("content-length");
-  if (it != headers.end()) {
-    size_t bytes = std::stoul(it->second);
-    return bytes;
+    body.append(chunk, static_cast<size_t>(chunkSize));
+    m_chunkOffset = chunk + chunkSize + 2 - data;
   }
-
-  return 0;
 }
 
-void HttpParser::readBody(std::istream& stream, std::string& body, const size_t bodyLen) {
-  size_t read = 0;
-
-  while (stream.good() && read < bodyLen) {
-    body += stream.get();
-    ++read;
-  }
-
-  throwIfNotGood(stream);
+size_t HttpParser::finish(size_t messageSize) {
+  m_scanned = 0;
+  m_headersSize = 0;
+  m_contentLength = 0;
+  m_chunked = false;
+  m_chunkOffset = 0;
+  return messageSize;
 }
 
 }
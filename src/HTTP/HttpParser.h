@@ -1,4 +1,5 @@
 // Copyright (c) 2012-2016, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2014-2016 XDN developers
 //
 // This file is part of Karbo.
 //
@@ -14,11 +15,9 @@
 //
 // You should have received a copy of the GNU Lesser General Public License
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
-
 #ifndef HTTPPARSER_H_
 #define HTTPPARSER_H_
 
-#include <iostream>
 #include <map>
 #include <string>
 #include "HttpRequest.h"
@@ -26,20 +25,33 @@
 
 namespace CryptoNote {
 
-//Blocking HttpParser
+// Incremental HTTP/1.1 parser working over a connection's read buffer.
+// Call parseRequest()/parseResponse() with the same message object each time more data
+// has arrived, they return 0 until the message is complete and then its size. Bytes past
+// that belong to the next, pipelined, message. Content-Length and chunked bodies are supported.
 class HttpParser {
 public:
-  HttpParser() {};
+  static const size_t HEADERS_MAX_SIZE = 64 * 1024;
+
+  HttpParser();
 
-  void receiveRequest(std::istream& stream, HttpRequest& request);
-  void receiveResponse(std::istream& stream, HttpResponse& response);
+  size_t parseRequest(const char* data, size_t size, HttpRequest& request);
+  size_t parseResponse(const char* data, size_t size, HttpResponse& response);
   static HttpResponse::HTTP_STATUS parseResponseStatusFromString(const std::string& status);
+
 private:
-  void readWord(std::istream& stream, std::string& word);
-  void readHeaders(std::istream& stream, HttpRequest::Headers &headers);
-  bool readHeader(std::istream& stream, std::string& name, std::string& value);
-  size_t getBodyLen(const HttpRequest::Headers& headers);
-  void readBody(std::istream& stream, std::string& body, const size_t bodyLen);
+  bool findHeadersEnd(const char* data, size_t size);
+  void startBody(const std::map<std::string, std::string>& headers);
+  size_t parseBody(const char* data, size_t size, std::string& body);
+  size_t parseChunkedBody(const char* data, size_t size, std::string& body);
+  size_t finish(size_t messageSize);
+
+  size_t m_scanned;          // bytes already searched for the end of the headers
+  size_t m_headersSize;      // 0 until the headers are complete
+  size_t m_contentLength;
+  bool m_chunked;
+  size_t m_chunkOffset;      // next chunk header of a chunked body
+  std::string m_responseBody;
 };
 
 } //namespace CryptoNote
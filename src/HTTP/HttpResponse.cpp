@@ -19,6 +19,7 @@
 #include "HttpResponse.h"
 
 #include <stdexcept>
+#include <utility>
 
 namespace {
 
@@ -26,12 +27,16 @@ const char* getStatusString(CryptoNote::HttpResponse::HTTP_STATUS status) {
   switch (status) {
   case CryptoNote::HttpResponse::STATUS_200:
     return "200 OK";
+  case CryptoNote::HttpResponse::STATUS_304:
+    return "304 Not Modified";
   case CryptoNote::HttpResponse::STATUS_401:
     return "401 Unauthorized";
   case CryptoNote::HttpResponse::STATUS_404:
     return "404 Not Found";
   case CryptoNote::HttpResponse::STATUS_500:
     return "500 Internal Server Error";
+  case CryptoNote::HttpResponse::STATUS_503:
+    return "503 Service Unavailable";
   default:
     throw std::runtime_error("Unknown HTTP status code is given");
   }
@@ -47,6 +52,8 @@ const char* getErrorBody(CryptoNote::HttpResponse::HTTP_STATUS status) {
     return "Requested url is not found\n";
   case CryptoNote::HttpResponse::STATUS_500:
     return "Internal server error is occurred\n";
+  case CryptoNote::HttpResponse::STATUS_503:
+    return "Server is busy, try again later\n";
   default:
     throw std::runtime_error("Error body for given status is not available");
   }
@@ -67,7 +74,9 @@ HttpResponse::HttpResponse() {
 void HttpResponse::setStatus(HTTP_STATUS s) {
   status = s;
 
-  if (status != HttpResponse::STATUS_200) {
+  if (status == HttpResponse::STATUS_304) {
+    setBody(std::string());
+  } else if (status != HttpResponse::STATUS_200) {
     setBody(getErrorBody(status));
   }
 }
@@ -76,8 +85,8 @@ void HttpResponse::addHeader(const std::string& name, const std::string& value)
   headers[name] = value;
 }
 
-void HttpResponse::setBody(const std::string& b) {
-  body = b;
+void HttpResponse::setBody(std::string b) {
+  body = std::move(b);
   if (!body.empty()) {
     headers["Content-Length"] = std::to_string(body.size());
   } else {
@@ -85,6 +94,37 @@ void HttpResponse::setBody(const std::string& b) {
   }
 }
 
+void HttpResponse::setBodyProducer(BodyProducer producer) {
+  body.clear();
+  headers.erase("Content-Length");
+  headers["Transfer-Encoding"] = "chunked";
+  bodyProducer = std::move(producer);
+}
+
+bool HttpResponse::nextChunk(std::string& out) {
+  std::string data;
+  bool more;
+  do {
+    more = bodyProducer(data);
+  } while (data.empty() && more);
+
+  static const char digits[] = "0123456789abcdef";
+  std::string size;
+  for (size_t n = data.size(); n != 0; n >>= 4) {
+    size.insert(size.begin(), digits[n & 0xf]);
+  }
+
+  if (!data.empty()) {
+    out.append(size).append("\r\n").append(data).append("\r\n");
+  }
+
+  if (!more) {
+    out.append("0\r\n\r\n");
+  }
+
+  return more;
+}
+
 std::ostream& HttpResponse::printHttpResponse(std::ostream& os) const {
   os << "HTTP/1.1 " << getStatusString(status) << "\r\n";
 
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <functional>
 #include <ostream>
 #include <string>
 #include <map>
@@ -30,16 +31,26 @@ namespace CryptoNote {
   public:
     enum HTTP_STATUS {
       STATUS_200,
+      STATUS_304,
       STATUS_401,
       STATUS_404,
-      STATUS_500
+      STATUS_500,
+      STATUS_503
     };
 
+    // appends the next piece of a streamed body, returns false after the last one
+    typedef std::function<bool(std::string& data)> BodyProducer;
+
     HttpResponse();
 
     void setStatus(HTTP_STATUS s);
     void addHeader(const std::string& name, const std::string& value);
-    void setBody(const std::string& b);
+    void setBody(std::string b);
+    // the body is sent with chunked transfer encoding as the producer makes it
+    void setBodyProducer(BodyProducer producer);
+    bool isChunked() const { return static_cast<bool>(bodyProducer); }
+    // appends the next chunk in wire format, the terminating chunk included; false once it is written
+    bool nextChunk(std::string& out);
 
     const std::map<std::string, std::string>& getHeaders() const { return headers; }
     HTTP_STATUS getStatus() const { return status; }
@@ -52,6 +63,7 @@ namespace CryptoNote {
     HTTP_STATUS status;
     std::map<std::string, std::string> headers;
     std::string body;
+    BodyProducer bodyProducer;
   };
 
   inline std::ostream& operator<<(std::ostream& os, const HttpResponse& resp) {
@@ -106,8 +106,13 @@ bool InProcessNode::doShutdown() {
     return false;
   }
 
+  // the core notifies from a thread of its own and removeObserver() waits for a notification
+  // being delivered, which needs the mutex
+  lock.unlock();
   protocol.removeObserver(this);
   core.removeObserver(this);
+  lock.lock();
+
   resetLastLocalBlockHeaderInfo();
   state = NOT_INITIALIZED;
 
@@ -223,6 +228,52 @@ void InProcessNode::getTransactionOutsGlobalIndicesAsync(const Crypto::Hash& tra
   callback(ec);
 }
 
+void InProcessNode::getTransactionsOutsGlobalIndices(const std::vector<Crypto::Hash>& transactionHashes,
+    std::vector<std::vector<uint32_t>>& outsGlobalIndices, const Callback& callback)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  if (state != INITIALIZED) {
+    lock.unlock();
+    callback(make_error_code(CryptoNote::error::NOT_INITIALIZED));
+    return;
+  }
+
+  ioService.post([this, transactionHashes, &outsGlobalIndices, callback] () {
+    this->getTransactionsOutsGlobalIndicesAsync(transactionHashes, outsGlobalIndices, callback);
+  });
+}
+
+void InProcessNode::getTransactionsOutsGlobalIndicesAsync(const std::vector<Crypto::Hash>& transactionHashes,
+    std::vector<std::vector<uint32_t>>& outsGlobalIndices, const Callback& callback)
+{
+  std::error_code ec = doGetTransactionsOutsGlobalIndices(transactionHashes, outsGlobalIndices);
+  callback(ec);
+}
+
+//it's always protected with mutex
+std::error_code InProcessNode::doGetTransactionsOutsGlobalIndices(const std::vector<Crypto::Hash>& transactionHashes,
+    std::vector<std::vector<uint32_t>>& outsGlobalIndices) {
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (state != INITIALIZED) {
+      return make_error_code(CryptoNote::error::NOT_INITIALIZED);
+    }
+  }
+
+  try {
+    // one core call, the blockchain is locked once for the whole batch
+    if (!core.getTransactionsOutputGlobalIndexes(transactionHashes, outsGlobalIndices)) {
+      return make_error_code(CryptoNote::error::REQUEST_ERROR);
+    }
+  } catch (std::system_error& e) {
+    return e.code();
+  } catch (std::exception&) {
+    return make_error_code(CryptoNote::error::INTERNAL_NODE_ERROR);
+  }
+
+  return std::error_code();
+}
+
 //it's always protected with mutex
 std::error_code InProcessNode::doGetTransactionOutsGlobalIndices(const Crypto::Hash& transactionHash, std::vector<uint32_t>& outsGlobalIndices) {
   {
@@ -286,7 +337,7 @@ std::error_code InProcessNode::doGetRandomOutsByAmounts(std::vector<uint64_t>&&
   try {
     CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response res;
     CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request req;
-    req.amounts = amounts;
+    req.amounts = std::move(amounts);
     req.outs_count = outsCount;
 
     if(!core.get_random_outs_for_amounts(req, res)) {
@@ -628,6 +679,41 @@ void InProcessNode::queryBlocks(std::vector<Crypto::Hash>&& knownBlockIds, uint6
   );
 }
 
+void InProcessNode::getBlockFilters(std::vector<Crypto::Hash>&& knownBlockIds, std::vector<BlockFilterEntry>& filters,
+  uint32_t& startHeight, const Callback& callback) {
+  std::unique_lock<std::mutex> lock(mutex);
+  if (state != INITIALIZED) {
+    lock.unlock();
+    callback(make_error_code(CryptoNote::error::NOT_INITIALIZED));
+    return;
+  }
+
+  ioService.post(
+          std::bind(&InProcessNode::getBlockFiltersAsync,
+                  this,
+                  std::move(knownBlockIds),
+                  std::ref(filters),
+                  std::ref(startHeight),
+                  callback
+          )
+  );
+}
+
+void InProcessNode::getBlockFiltersAsync(std::vector<Crypto::Hash>& knownBlockIds, std::vector<BlockFilterEntry>& filters, uint32_t& startHeight,
+                         const Callback& callback) {
+  std::vector<CryptoNote::BlockFilterInfo> items;
+  if (!core.getBlockFilters(knownBlockIds, static_cast<uint32_t>(BLOCK_FILTERS_MAX_COUNT), startHeight, items)) {
+    callback(make_error_code(CryptoNote::error::INTERNAL_NODE_ERROR));
+    return;
+  }
+
+  for (auto& item : items) {
+    filters.push_back(BlockFilterEntry{ item.blockId, std::move(item.filter) });
+  }
+
+  callback(std::error_code());
+}
+
 void InProcessNode::queryBlocksLiteAsync(std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp, std::vector<BlockShortEntry>& newBlocks, uint32_t& startHeight,
                          const Callback& callback) {
   std::error_code ec = doQueryBlocksLite(std::move(knownBlockIds), timestamp, newBlocks, startHeight);
@@ -638,11 +724,12 @@ std::error_code InProcessNode::doQueryBlocksLite(std::vector<Crypto::Hash>&& kno
   uint32_t currentHeight, fullOffset;
   std::vector<CryptoNote::BlockShortInfo> entries;
 
-  if (!core.queryBlocksLite(knownBlockIds, timestamp, startHeight, currentHeight, fullOffset, entries)) {
+  if (!core.queryBlocksLite(knownBlockIds, timestamp, startHeight, currentHeight, fullOffset, entries, true)) {
     return make_error_code(CryptoNote::error::INTERNAL_NODE_ERROR);
   }
 
-  for (const auto& entry: entries) {
+  newBlocks.reserve(newBlocks.size() + entries.size());
+  for (auto& entry: entries) {
     BlockShortEntry bse;
     bse.blockHash = entry.blockId;
     bse.hasBlock = false;
@@ -654,10 +741,13 @@ std::error_code InProcessNode::doQueryBlocksLite(std::vector<Crypto::Hash>&& kno
       }
     }
 
-    for (const auto& tsi: entry.txPrefixes) {
+    bse.baseTransactionGlobalIndexes = std::move(entry.baseTransactionGlobalIndexes);
+    bse.txsShortInfo.reserve(entry.txPrefixes.size());
+    for (auto& tsi: entry.txPrefixes) {
       TransactionShortInfo tpi;
       tpi.txId = tsi.txHash;
-      tpi.txPrefix = tsi.txPrefix;
+      tpi.txPrefix = std::move(tsi.txPrefix);
+      tpi.globalIndexes = std::move(tsi.globalIndexes);
 
       bse.txsShortInfo.push_back(std::move(tpi));
     }
@@ -754,6 +844,30 @@ std::error_code InProcessNode::doGetBlockTimestampAsync(uint32_t height, uint64_
   return std::error_code();
 }
 
+void InProcessNode::getBlockHeightsByTimestamps(const std::vector<uint64_t>& timestamps, std::vector<uint32_t>& heights, const Callback& callback) {
+  std::unique_lock<std::mutex> lock(mutex);
+  if (state != INITIALIZED) {
+    lock.unlock();
+    callback(make_error_code(CryptoNote::error::NOT_INITIALIZED));
+    return;
+  }
+
+  ioService.post([this, timestamps, &heights, callback]() {
+    this->getBlockHeightsByTimestampsAsync(timestamps, heights, callback);
+  });
+}
+
+void InProcessNode::getBlockHeightsByTimestampsAsync(const std::vector<uint64_t>& timestamps, std::vector<uint32_t>& heights, const Callback& callback) {
+  std::error_code ec;
+  try {
+    core.getBlockHeightsByTimestamps(timestamps, heights);
+  } catch (std::exception&) {
+    ec = make_error_code(CryptoNote::error::INTERNAL_NODE_ERROR);
+  }
+
+  callback(ec);
+}
+
 void InProcessNode::getBlocks(const std::vector<uint32_t>& blockHeights, std::vector<std::vector<BlockDetails>>& blocks, const Callback& callback) {
   std::unique_lock<std::mutex> lock(mutex);
   if (state != INITIALIZED) {
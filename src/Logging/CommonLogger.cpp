@@ -17,10 +17,98 @@
 
 #include "CommonLogger.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace Logging {
 
+// Bounded multi-producer queue after Dmitry Vyukov: each cell carries a sequence number that tells
+// producers and the writer whose turn it is, so pushing takes no lock.
+struct CommonLogger::AsyncQueue {
+  struct Record {
+    std::string category;
+    Level level;
+    boost::posix_time::ptime time;
+    std::string body;
+  };
+
+  struct Cell {
+    std::atomic<size_t> sequence;
+    Record record;
+  };
+
+  explicit AsyncQueue(size_t size) : mask(0), enqueuePosition(0), dequeuePosition(0), stopping(false), dropped(0) {
+    size_t capacity = 2;
+    while (capacity < size) {
+      capacity *= 2;
+    }
+
+    mask = capacity - 1;
+    cells.reset(new Cell[capacity]);
+    for (size_t i = 0; i < capacity; ++i) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  bool push(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) {
+    size_t position = enqueuePosition.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells[position & mask];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+      if (difference == 0) {
+        if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          cell.record.category = category;
+          cell.record.level = level;
+          cell.record.time = time;
+          cell.record.body = body;
+          cell.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = enqueuePosition.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // single consumer, the writer thread
+  bool pop(Record& record) {
+    size_t position = dequeuePosition.load(std::memory_order_relaxed);
+    Cell& cell = cells[position & mask];
+    if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+      return false;
+    }
+
+    std::swap(record, cell.record);
+    dequeuePosition.store(position + 1, std::memory_order_relaxed);
+    cell.sequence.store(position + mask + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t size() const {
+    return enqueuePosition.load(std::memory_order_relaxed) - dequeuePosition.load(std::memory_order_relaxed);
+  }
+
+  std::unique_ptr<Cell[]> cells;
+  size_t mask;
+  std::atomic<size_t> enqueuePosition;
+  std::atomic<size_t> dequeuePosition;
+  std::atomic<bool> stopping;
+  std::atomic<uint64_t> dropped;
+  std::mutex wakeupMutex;
+  std::condition_variable wakeup;
+  std::thread writer;
+};
+
 namespace {
 
+const std::chrono::milliseconds ASYNC_FLUSH_INTERVAL(100);
+
 std::string formatPattern(const std::string& pattern, const std::string& category, Level level, boost::posix_time::ptime time) {
   std::stringstream s;
 
@@ -55,22 +143,111 @@ std::string formatPattern(const std::string& pattern, const std::string& categor
 
 }
 
+CommonLogger::~CommonLogger() {
+  stopAsync();
+}
+
 void CommonLogger::operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) {
   if (level <= logLevel && disabledCategories.count(category) == 0) {
-    std::string body2 = body;
-    if (!pattern.empty()) {
-      size_t insertPos = 0;
-      if (!body2.empty() && body2[0] == ILogger::COLOR_DELIMETER) {
-        size_t delimPos = body2.find(ILogger::COLOR_DELIMETER, 1);
-        if (delimPos != std::string::npos) {
-          insertPos = delimPos + 1;
-        }
+    if (asyncQueue) {
+      if (!asyncQueue->push(category, level, time, body)) {
+        ++asyncQueue->dropped;
       }
 
-      body2.insert(insertPos, formatPattern(pattern, category, level, time));
+      // the writer wakes up on its own every flush interval, it is only hurried when the queue fills up
+      if (asyncQueue->size() > asyncQueue->mask / 2) {
+        asyncQueue->wakeup.notify_one();
+      }
+
+      return;
     }
 
-    doLogString(body2);
+    doLogString(formatMessage(category, level, time, body));
+  }
+}
+
+std::string CommonLogger::formatMessage(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) const {
+  std::string body2 = body;
+  if (!pattern.empty()) {
+    size_t insertPos = 0;
+    if (!body2.empty() && body2[0] == ILogger::COLOR_DELIMETER) {
+      size_t delimPos = body2.find(ILogger::COLOR_DELIMETER, 1);
+      if (delimPos != std::string::npos) {
+        insertPos = delimPos + 1;
+      }
+    }
+
+    body2.insert(insertPos, formatPattern(pattern, category, level, time));
+  }
+
+  return body2;
+}
+
+void CommonLogger::enableAsync(size_t queueSize) {
+  if (asyncQueue) {
+    return;
+  }
+
+  asyncQueue.reset(new AsyncQueue(queueSize));
+  asyncQueue->writer = std::thread(&CommonLogger::writeAsync, this);
+}
+
+uint64_t CommonLogger::droppedMessages() const {
+  return asyncQueue ? asyncQueue->dropped.load() : 0;
+}
+
+bool CommonLogger::isAsync() const {
+  return asyncQueue != nullptr;
+}
+
+void CommonLogger::stopAsync() {
+  if (!asyncQueue) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(asyncQueue->wakeupMutex);
+    asyncQueue->stopping = true;
+  }
+
+  asyncQueue->wakeup.notify_one();
+  asyncQueue->writer.join();
+  asyncQueue.reset();
+}
+
+void CommonLogger::writeAsync() {
+  AsyncQueue& queue = *asyncQueue;
+  AsyncQueue::Record record;
+  uint64_t reportedDrops = 0;
+  for (;;) {
+    // read before draining, everything queued ahead of stopAsync() is still written
+    bool stopping = queue.stopping;
+    bool written = false;
+    while (queue.pop(record)) {
+      doLogString(formatMessage(record.category, record.level, record.time, record.body));
+      written = true;
+    }
+
+    uint64_t dropped = queue.dropped;
+    if (dropped != reportedDrops) {
+      doLogString(formatMessage("Logging", WARNING, boost::posix_time::microsec_clock::local_time(),
+        std::to_string(dropped - reportedDrops) + " log messages dropped, the queue was full\n"));
+      reportedDrops = dropped;
+      written = true;
+    }
+
+    if (written) {
+      doFlush();
+    }
+
+    if (stopping) {
+      break;
+    }
+
+    std::unique_lock<std::mutex> lock(queue.wakeupMutex);
+    if (!queue.stopping) {
+      queue.wakeup.wait_for(lock, ASYNC_FLUSH_INTERVAL);
+    }
   }
 }
 
@@ -88,6 +265,11 @@ void CommonLogger::disableCategory(const std::string& category) {
 
 void CommonLogger::setMaxLevel(Level level) {
   logLevel = level;
+  ++configurationVersion;
+}
+
+Level CommonLogger::getMaxLevel() const {
+  return logLevel;
 }
 
 CommonLogger::CommonLogger(Level level) : logLevel(level), pattern("%D %T %L [%C] ") {
@@ -96,4 +278,7 @@ CommonLogger::CommonLogger(Level level) : logLevel(level), pattern("%D %T %L [%C
 void CommonLogger::doLogString(const std::string& message) {
 }
 
+void CommonLogger::doFlush() {
+}
+
 }
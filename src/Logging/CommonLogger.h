@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <set>
 #include "ILogger.h"
 
@@ -24,14 +26,22 @@ namespace Logging {
 
 class CommonLogger : public ILogger {
 public:
+  virtual ~CommonLogger();
 
   virtual void operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) override;
   virtual void enableCategory(const std::string& category);
   virtual void disableCategory(const std::string& category);
   virtual void setMaxLevel(Level level);
+  virtual Level getMaxLevel() const override;
 
   void setPattern(const std::string& pattern);
 
+  // Moves formatting and writing to a background thread. Callers only filter and queue the message,
+  // the writer flushes once per batch. Messages that find the queue of queueSize entries full are
+  // dropped and counted, the writer logs how many were lost.
+  void enableAsync(size_t queueSize = 8192);
+  uint64_t droppedMessages() const;
+
 protected:
   std::set<std::string> disabledCategories;
   Level logLevel;
@@ -39,6 +49,20 @@ protected:
 
   CommonLogger(Level level);
   virtual void doLogString(const std::string& message);
+  virtual void doFlush();
+
+  bool isAsync() const;
+  // Writes out the queued messages and stops the writer. Loggers call it in their destructor,
+  // before the objects doLogString writes to are gone.
+  void stopAsync();
+
+private:
+  struct AsyncQueue;
+
+  std::string formatMessage(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) const;
+  void writeAsync();
+
+  std::unique_ptr<AsyncQueue> asyncQueue;
 };
 
 }
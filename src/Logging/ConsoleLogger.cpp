@@ -28,6 +28,10 @@ using Common::Console::Color;
 ConsoleLogger::ConsoleLogger(Level level) : CommonLogger(level) {
 }
 
+ConsoleLogger::~ConsoleLogger() {
+  stopAsync();
+}
+
 void ConsoleLogger::doLogString(const std::string& message) {
   std::lock_guard<std::mutex> lock(mutex);
   bool readingText = true;
@@ -76,4 +80,9 @@ void ConsoleLogger::doLogString(const std::string& message) {
   }
 }
 
+void ConsoleLogger::doFlush() {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::cout << std::flush;
+}
+
 }
@@ -25,9 +25,11 @@ namespace Logging {
 class ConsoleLogger : public CommonLogger {
 public:
   ConsoleLogger(Level level = DEBUGGING);
+  ~ConsoleLogger();
 
 protected:
   virtual void doLogString(const std::string& message) override;
+  virtual void doFlush() override;
 
 private:
   std::mutex mutex;
@@ -17,14 +17,194 @@
 
 #include "FileLogger.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <zlib.h>
+
 namespace Logging {
 
-FileLogger::FileLogger(Level level) : StreamLogger(level) {
+namespace {
+
+bool gzipFile(const std::string& source, const std::string& destination) {
+  std::ifstream input(source, std::ios::binary);
+  gzFile output = gzopen(destination.c_str(), "wb6");
+  if (!input || output == nullptr) {
+    if (output != nullptr) {
+      gzclose(output);
+    }
+
+    return false;
+  }
+
+  std::vector<char> buffer(1 << 16);
+  bool ok = true;
+  while (ok && input) {
+    input.read(buffer.data(), buffer.size());
+    std::streamsize read = input.gcount();
+    ok = read == 0 || gzwrite(output, buffer.data(), static_cast<unsigned>(read)) == read;
+  }
+
+  return gzclose(output) == Z_OK && ok;
+}
+
+// name-date-time[_index].ext, later files sort after earlier ones as text
+std::string rotatedFileName(const std::string& fileName, const boost::posix_time::ptime& time, unsigned index) {
+  boost::filesystem::path path(fileName);
+  std::string stamp = boost::gregorian::to_iso_string(time.date());
+  char clock[16];
+  snprintf(clock, sizeof(clock), "-%02d%02d%02d", static_cast<int>(time.time_of_day().hours()),
+    static_cast<int>(time.time_of_day().minutes()), static_cast<int>(time.time_of_day().seconds()));
+  stamp += clock;
+  if (index > 0) {
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "_%04u", index);
+    stamp += suffix;
+  }
+
+  return (path.parent_path() / (path.stem().string() + "-" + stamp + path.extension().string())).string();
+}
+
+}
+
+FileLogger::FileLogger(Level level) : StreamLogger(level), maxSize(0), daily(false), maxFiles(0), fileSize(0), rotationIndex(0), stopping(false) {
+}
+
+FileLogger::~FileLogger() {
+  stopAsync();
+  if (compressionThread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(compressionMutex);
+      stopping = true;
+    }
+
+    compressionQueued.notify_one();
+    compressionThread.join();
+  }
 }
 
 void FileLogger::init(const std::string& fileName) {
+  this->fileName = fileName;
   fileStream.open(fileName, std::ios::app);
+  fileStream.seekp(0, std::ios::end);
+  fileSize = fileStream ? static_cast<uint64_t>(fileStream.tellp()) : 0;
+  fileDate = boost::gregorian::day_clock::local_day();
   StreamLogger::attachToStream(fileStream);
 }
 
+void FileLogger::setRotation(uint64_t maxSize, bool daily, size_t maxFiles) {
+  std::lock_guard<std::mutex> lock(rotationMutex);
+  this->maxSize = maxSize;
+  this->daily = daily;
+  this->maxFiles = maxFiles;
+  if ((maxSize != 0 || daily) && !compressionThread.joinable()) {
+    compressionThread = std::thread(&FileLogger::compressRotatedFiles, this);
+  }
+}
+
+void FileLogger::doLogString(const std::string& message) {
+  {
+    std::lock_guard<std::mutex> lock(rotationMutex);
+    if ((maxSize != 0 && fileSize >= maxSize) || (daily && boost::gregorian::day_clock::local_day() != fileDate)) {
+      rotate();
+    }
+
+    fileSize += message.size();
+  }
+
+  StreamLogger::doLogString(message);
+}
+
+// Precondition: rotationMutex is locked. Only renames and reopens, the copy is compressed by compressionThread.
+void FileLogger::rotate() {
+  std::lock_guard<std::mutex> lock(mutex);
+  fileStream.close();
+
+  boost::posix_time::ptime now = boost::posix_time::second_clock::local_time();
+  // files of the same second are numbered on, even where older ones were removed already
+  rotationIndex = now == lastRotation ? rotationIndex + 1 : 0;
+  lastRotation = now;
+  std::string rotatedName;
+  boost::system::error_code ec;
+  for (;;) {
+    rotatedName = rotatedFileName(fileName, now, rotationIndex);
+    if (!boost::filesystem::exists(rotatedName, ec) && !boost::filesystem::exists(rotatedName + ".gz", ec)) {
+      break;
+    }
+
+    ++rotationIndex;
+  }
+
+  boost::filesystem::rename(fileName, rotatedName, ec);
+  fileStream.clear();
+  fileStream.open(fileName, std::ios::app);
+  fileSize = 0;
+  fileDate = now.date();
+
+  if (!ec) {
+    std::lock_guard<std::mutex> queueLock(compressionMutex);
+    filesToCompress.push_back(rotatedName);
+    compressionQueued.notify_one();
+  }
+}
+
+void FileLogger::compressRotatedFiles() {
+  for (;;) {
+    std::string rotatedName;
+    {
+      std::unique_lock<std::mutex> lock(compressionMutex);
+      compressionQueued.wait(lock, [this] { return stopping || !filesToCompress.empty(); });
+      if (filesToCompress.empty()) {
+        return;
+      }
+
+      rotatedName = filesToCompress.front();
+      filesToCompress.pop_front();
+    }
+
+    // a failed compression leaves the plain file in place
+    if (gzipFile(rotatedName, rotatedName + ".gz")) {
+      std::remove(rotatedName.c_str());
+    } else {
+      std::remove((rotatedName + ".gz").c_str());
+    }
+
+    removeOldFiles();
+  }
+}
+
+void FileLogger::removeOldFiles() {
+  size_t keep;
+  {
+    std::lock_guard<std::mutex> lock(rotationMutex);
+    keep = maxFiles;
+  }
+
+  if (keep == 0) {
+    return;
+  }
+
+  boost::filesystem::path path(fileName);
+  boost::filesystem::path directory = path.parent_path().empty() ? boost::filesystem::path(".") : path.parent_path();
+  std::string prefix = path.stem().string() + "-";
+  std::vector<std::string> rotated;
+  boost::system::error_code ec;
+  for (boost::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+    std::string name = it->path().filename().string();
+    if (name.compare(0, prefix.size(), prefix) == 0 && name.size() > 3 && name.compare(name.size() - 3, 3, ".gz") == 0) {
+      rotated.push_back(it->path().string());
+    }
+  }
+
+  if (rotated.size() <= keep) {
+    return;
+  }
+
+  std::sort(rotated.begin(), rotated.end());
+  for (size_t i = 0; i < rotated.size() - keep; ++i) {
+    boost::filesystem::remove(rotated[i], ec);
+  }
+}
+
 }
@@ -17,7 +17,11 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <mutex>
+#include <thread>
 #include "StreamLogger.h"
 
 namespace Logging {
@@ -25,10 +29,39 @@ namespace Logging {
 class FileLogger : public StreamLogger {
 public:
   FileLogger(Level level = DEBUGGING);
+  ~FileLogger();
   void init(const std::string& filename);
 
+  // Rolls the file over once it reaches maxSize bytes (0 turns size rotation off) and, if daily is set,
+  // with the first message of a new day. The rolled over file gets its start time in the name and is
+  // gzipped on a background thread; only the newest maxFiles of them are kept (0 keeps all).
+  void setRotation(uint64_t maxSize, bool daily, size_t maxFiles);
+
+protected:
+  virtual void doLogString(const std::string& message) override;
+
 private:
+  void rotate();
+  void compressRotatedFiles();
+  void removeOldFiles();
+
   std::ofstream fileStream;
+  std::string fileName;
+
+  std::mutex rotationMutex;
+  uint64_t maxSize;
+  bool daily;
+  size_t maxFiles;
+  uint64_t fileSize;
+  boost::gregorian::date fileDate;
+  boost::posix_time::ptime lastRotation;
+  unsigned rotationIndex;
+
+  std::mutex compressionMutex;
+  std::condition_variable compressionQueued;
+  std::deque<std::string> filesToCompress;
+  bool stopping;
+  std::thread compressionThread;
 };
 
 }
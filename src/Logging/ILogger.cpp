@@ -37,6 +37,8 @@ const std::string DEFAULT = "\x1F""DEFAULT\x1F";
 
 const char ILogger::COLOR_DELIMETER = '\x1F';
 
+std::atomic<uint32_t> ILogger::configurationVersion(1);
+
 const std::array<std::string, 6> ILogger::LEVEL_NAMES = {
   {"FATAL",
   "ERROR",
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <array>
 #include <boost/date_time/posix_time/posix_time.hpp>
@@ -57,6 +59,13 @@ public:
   const static std::array<std::string, 6> LEVEL_NAMES;
 
   virtual void operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) = 0;
+
+  // Most verbose level that may get through this logger. LoggerRef caches it and doesn't format
+  // messages above it; the cache is dropped whenever configurationVersion changes.
+  virtual Level getMaxLevel() const { return TRACE; }
+
+  // bumped on every change of a level or of the set of loggers in a group
+  static std::atomic<uint32_t> configurationVersion;
 };
 
 #ifndef ENDL
@@ -25,10 +25,21 @@ LoggerGroup::LoggerGroup(Level level) : CommonLogger(level) {
 
 void LoggerGroup::addLogger(ILogger& logger) {
   loggers.push_back(&logger);
+  ++configurationVersion;
 }
 
 void LoggerGroup::removeLogger(ILogger& logger) {
   loggers.erase(std::remove(loggers.begin(), loggers.end(), &logger), loggers.end());
+  ++configurationVersion;
+}
+
+Level LoggerGroup::getMaxLevel() const {
+  Level maxLevel = FATAL;
+  for (auto& logger : loggers) {
+    maxLevel = std::max(maxLevel, logger->getMaxLevel());
+  }
+
+  return std::min(maxLevel, logLevel);
 }
 
 void LoggerGroup::operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) {
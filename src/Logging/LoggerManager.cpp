@@ -32,6 +32,11 @@ void LoggerManager::operator()(const std::string& category, Level level, boost::
   LoggerGroup::operator()(category, level, time, body);
 }
 
+Level LoggerManager::getMaxLevel() const {
+  std::unique_lock<std::mutex> lock(reconfigureLock);
+  return LoggerGroup::getMaxLevel();
+}
+
 void LoggerManager::configure(const JsonValue& val) {
   std::unique_lock<std::mutex> lock(reconfigureLock);
   loggers.clear();
@@ -89,6 +94,11 @@ void LoggerManager::configure(const JsonValue& val) {
           auto fileLogger = new FileLogger(level);
           fileLogger->init(filename);
           logger.reset(fileLogger);
+
+          uint64_t maxSize = loggerConfiguration.contains("maxSize") ? loggerConfiguration("maxSize").getInteger() : 0;
+          bool daily = loggerConfiguration.contains("daily") && loggerConfiguration("daily").getBool();
+          uint64_t maxFiles = loggerConfiguration.contains("maxFiles") ? loggerConfiguration("maxFiles").getInteger() : 0;
+          fileLogger->setRotation(maxSize, daily, static_cast<size_t>(maxFiles));
         } else {
           throw std::runtime_error("Unknown logger type: " + type);
         }
@@ -97,6 +107,10 @@ void LoggerManager::configure(const JsonValue& val) {
           logger->setPattern(loggerConfiguration("pattern").getString());
         }
 
+        if (loggerConfiguration.contains("async") && loggerConfiguration("async").getBool()) {
+          logger->enableAsync();
+        }
+
         std::vector<std::string> disabledCategories;
         if (loggerConfiguration.contains("disabledCategories")) {
           auto disabledCategoriesVal = loggerConfiguration("disabledCategories");
@@ -31,16 +31,21 @@
 
 namespace Logging {
 
-LoggerMessage::LoggerMessage(ILogger& logger, const std::string& category, Level level, const std::string& color)
+LoggerMessage::LoggerMessage(ILogger& logger, const std::string& category, Level level, const std::string& color, bool enabled)
 	: std::ostream(this)
 	, std::streambuf()
 	, m_logger(logger)
-	, m_sCategory(category)
+	, m_sCategory(enabled ? category : std::string())
 	, m_nLogLevel(level)
-	, m_sMessage(color)
-	, m_tmTimeStamp(boost::posix_time::microsec_clock::local_time())
+	, m_sMessage(enabled ? color : std::string())
+	, m_tmTimeStamp(enabled ? boost::posix_time::microsec_clock::local_time() : boost::posix_time::ptime())
 	, m_bGotText(false)
-{}
+	, m_bEnabled(enabled)
+{
+	if (!enabled) {
+		setstate(std::ios::badbit);
+	}
+}
 
 #if defined __linux__ && !defined __ANDROID__
 LoggerMessage::LoggerMessage(LoggerMessage&& other)
@@ -50,8 +55,9 @@ LoggerMessage::LoggerMessage(LoggerMessage&& other)
   , m_nLogLevel(other.m_nLogLevel)
   , m_logger(other.m_logger)
   , m_sMessage(other.m_sMessage)
-  , m_tmTimeStamp(boost::posix_time::microsec_clock::local_time())
-  , m_bGotText(false) {
+  , m_tmTimeStamp(other.m_bEnabled ? boost::posix_time::microsec_clock::local_time() : boost::posix_time::ptime())
+  , m_bGotText(false)
+  , m_bEnabled(other.m_bEnabled) {
   if (this != &other) {
     _M_tie = nullptr;
     _M_streambuf = nullptr;
@@ -97,8 +103,9 @@ LoggerMessage::LoggerMessage(LoggerMessage&& other)
 	, m_sCategory(other.m_sCategory)
 	, m_nLogLevel(other.m_nLogLevel)
 	, m_sMessage(other.m_sMessage)
-	, m_tmTimeStamp(boost::posix_time::microsec_clock::local_time())
+	, m_tmTimeStamp(other.m_bEnabled ? boost::posix_time::microsec_clock::local_time() : boost::posix_time::ptime())
 	, m_bGotText(false)
+	, m_bEnabled(other.m_bEnabled)
 {
 	std::ostream::rdbuf(this);
 }
@@ -112,6 +119,10 @@ LoggerMessage::~LoggerMessage()
 
 int LoggerMessage::sync()
 {
+	if (!m_bEnabled) {
+		return 0;
+	}
+
 	m_logger(m_sCategory, m_nLogLevel, m_tmTimeStamp, m_sMessage);
 	m_bGotText = false;
 	m_sMessage = Logging::DEFAULT;
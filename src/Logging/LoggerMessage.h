@@ -37,7 +37,8 @@ namespace Logging {
 class LoggerMessage : public std::ostream, std::streambuf
 {
 public:
-	LoggerMessage(ILogger& logger, const std::string& category, Level level, const std::string& color);
+	// a disabled message is a stream in bad state, nothing written to it is formatted or logged
+	LoggerMessage(ILogger& logger, const std::string& category, Level level, const std::string& color, bool enabled = true);
 	LoggerMessage(LoggerMessage&& other);
 	~LoggerMessage();
 	LoggerMessage(const LoggerMessage&) = delete;
@@ -55,6 +56,7 @@ private:
 	std::string m_sMessage;
 	boost::posix_time::ptime m_tmTimeStamp;
 	bool m_bGotText;
+	bool m_bEnabled;
 };
 
 } //Logging
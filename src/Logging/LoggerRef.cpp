@@ -34,11 +34,39 @@ namespace Logging {
 LoggerRef::LoggerRef(ILogger& logger, const std::string& category) 
 	: m_logger(&logger)
 	, m_sCategory(category)
+	, m_cachedMaxLevel(0)
 {}
 
+LoggerRef::LoggerRef(const LoggerRef& other)
+	: m_logger(other.m_logger)
+	, m_sCategory(other.m_sCategory)
+	, m_cachedMaxLevel(0)
+{}
+
+LoggerRef& LoggerRef::operator=(const LoggerRef& other)
+{
+	m_logger = other.m_logger;
+	m_sCategory = other.m_sCategory;
+	m_cachedMaxLevel = 0;
+	return *this;
+}
+
 LoggerMessage LoggerRef::operator()(Level level, const std::string& color) const
 {
-	return LoggerMessage(*m_logger, m_sCategory, level, color);
+	return LoggerMessage(*m_logger, m_sCategory, level, color, isEnabled(level));
+}
+
+bool LoggerRef::isEnabled(Level level) const
+{
+	uint64_t version = ILogger::configurationVersion.load(std::memory_order_relaxed);
+	uint64_t cached = m_cachedMaxLevel.load(std::memory_order_relaxed);
+	if ((cached >> 8) != version) {
+		// the version is read first, a change while the level is computed invalidates it again
+		cached = version << 8 | static_cast<uint64_t>(m_logger->getMaxLevel());
+		m_cachedMaxLevel.store(cached, std::memory_order_relaxed);
+	}
+
+	return level <= static_cast<Level>(cached & 0xff);
 }
 
 ILogger& LoggerRef::getLogger() const
@@ -29,6 +29,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+
 #include "ILogger.h"
 #include "LoggerMessage.h"
 
@@ -38,12 +41,18 @@ class LoggerRef
 {
 public:
 	LoggerRef(ILogger& logger, const std::string& category);
+	LoggerRef(const LoggerRef& other);
+	LoggerRef& operator=(const LoggerRef& other);
+	// Messages above the logger's max level come back as a disabled stream, their << do nothing
 	LoggerMessage operator()(Level level = INFO, const std::string& color = DEFAULT) const;
+	bool isEnabled(Level level) const;
 	ILogger& getLogger() const;
 
 private:
 	ILogger* m_logger;
 	std::string m_sCategory;
+	// ILogger::configurationVersion << 8 | max level, 0 until the first message
+	mutable std::atomic<uint64_t> m_cachedMaxLevel;
 };
 
 } //Logging
@@ -27,6 +27,10 @@ StreamLogger::StreamLogger(Level level) : CommonLogger(level), stream(nullptr) {
 StreamLogger::StreamLogger(std::ostream& stream, Level level) : CommonLogger(level), stream(&stream) {
 }
 
+StreamLogger::~StreamLogger() {
+  stopAsync();
+}
+
 void StreamLogger::attachToStream(std::ostream& stream) {
   this->stream = &stream;
 }
@@ -43,6 +47,16 @@ void StreamLogger::doLogString(const std::string& message) {
       }
     }
 
+    // the async writer flushes once per batch
+    if (!isAsync()) {
+      *stream << std::flush;
+    }
+  }
+}
+
+void StreamLogger::doFlush() {
+  if (stream != nullptr && stream->good()) {
+    std::lock_guard<std::mutex> lock(mutex);
     *stream << std::flush;
   }
 }
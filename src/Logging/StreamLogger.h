@@ -26,16 +26,16 @@ class StreamLogger : public CommonLogger {
 public:
   StreamLogger(Level level = DEBUGGING);
   StreamLogger(std::ostream& stream, Level level = DEBUGGING);
+  ~StreamLogger();
   void attachToStream(std::ostream& stream);
 
 protected:
   virtual void doLogString(const std::string& message) override;
+  virtual void doFlush() override;
 
 protected:
   std::ostream* stream;
-
-private:
-  std::mutex mutex;
+  std::mutex mutex; // guards writes to stream
 };
 
 }
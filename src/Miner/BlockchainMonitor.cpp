@@ -31,11 +31,13 @@
 #undef ERROR
 #endif
 
-BlockchainMonitor::BlockchainMonitor(System::Dispatcher& dispatcher, const std::string& daemonHost, uint16_t daemonPort, size_t pollingInterval, Logging::ILogger& logger):
+BlockchainMonitor::BlockchainMonitor(System::Dispatcher& dispatcher, const std::string& daemonHost, uint16_t daemonPort, size_t pollingInterval,
+  const std::string& miningAddress, Logging::ILogger& logger):
   m_dispatcher(dispatcher),
   m_daemonHost(daemonHost),
   m_daemonPort(daemonPort),
   m_pollingInterval(pollingInterval),
+  m_miningAddress(miningAddress),
   m_stopped(false),
   m_httpEvent(dispatcher),
   m_sleepingContext(dispatcher),
@@ -48,6 +50,39 @@ void BlockchainMonitor::waitBlockchainUpdate() {
   m_logger(Logging::DEBUGGING) << "Waiting for blockchain updates";
   m_stopped = false;
 
+  std::string longPollId = requestBlockTemplateLongPollId(std::string());
+  if (longPollId.empty()) {
+    // daemon doesn't support long polling
+    pollLastBlockHash();
+  } else {
+    while (!m_stopped) {
+      std::string currentId = longPollId;
+      m_sleepingContext.spawn([this, &longPollId, &currentId] () {
+        try {
+          currentId = requestBlockTemplateLongPollId(longPollId);
+        } catch (System::InterruptedException&) {
+        } catch (std::exception&) {
+          System::Timer timer(m_dispatcher);
+          timer.sleep(std::chrono::seconds(m_pollingInterval));
+        }
+      });
+
+      m_sleepingContext.wait();
+
+      if (!m_stopped && currentId != longPollId) {
+        m_logger(Logging::DEBUGGING) << "Block template has been updated";
+        break;
+      }
+    }
+  }
+
+  if (m_stopped) {
+    m_logger(Logging::DEBUGGING) << "Blockchain monitor has been stopped";
+    throw System::InterruptedException();
+  }
+}
+
+void BlockchainMonitor::pollLastBlockHash() {
   Crypto::Hash lastBlockHash = requestLastBlockHash();
 
   while(!m_stopped) {
@@ -63,11 +98,6 @@ void BlockchainMonitor::waitBlockchainUpdate() {
       break;
     }
   }
-
-  if (m_stopped) {
-    m_logger(Logging::DEBUGGING) << "Blockchain monitor has been stopped";
-    throw System::InterruptedException();
-  }
 }
 
 void BlockchainMonitor::stop() {
@@ -107,3 +137,32 @@ Crypto::Hash BlockchainMonitor::requestLastBlockHash() {
     throw;
   }
 }
+
+std::string BlockchainMonitor::requestBlockTemplateLongPollId(const std::string& previousId) {
+  m_logger(Logging::DEBUGGING) << "Requesting block template, long poll id: " << previousId;
+
+  try {
+    CryptoNote::HttpClient client(m_dispatcher, m_daemonHost, m_daemonPort, false);
+
+    CryptoNote::COMMAND_RPC_GETBLOCKTEMPLATE::request request;
+    request.wallet_address = m_miningAddress;
+    request.reserve_size = 0;
+    request.long_poll_id = previousId;
+
+    CryptoNote::COMMAND_RPC_GETBLOCKTEMPLATE::response response;
+
+    System::EventLock lk(m_httpEvent);
+    CryptoNote::JsonRpc::invokeJsonRpcCommand(client, "getblocktemplate", request, response);
+
+    if (response.status != CORE_RPC_STATUS_OK) {
+      throw std::runtime_error("Core responded with wrong status: " + response.status);
+    }
+
+    return response.long_poll_id;
+  } catch (System::InterruptedException&) {
+    throw;
+  } catch (std::exception& e) {
+    m_logger(Logging::ERROR) << "Failed to request block template: " << e.what();
+    throw;
+  }
+}
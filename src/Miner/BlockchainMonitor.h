@@ -27,7 +27,8 @@
 
 class BlockchainMonitor {
 public:
-  BlockchainMonitor(System::Dispatcher& dispatcher, const std::string& daemonHost, uint16_t daemonPort, size_t pollingInterval, Logging::ILogger& logger);
+  BlockchainMonitor(System::Dispatcher& dispatcher, const std::string& daemonHost, uint16_t daemonPort, size_t pollingInterval,
+    const std::string& miningAddress, Logging::ILogger& logger);
 
   void waitBlockchainUpdate();
   void stop();
@@ -36,6 +37,7 @@ private:
   std::string m_daemonHost;
   uint16_t m_daemonPort;
   size_t m_pollingInterval;
+  std::string m_miningAddress;
   bool m_stopped;
   System::Event m_httpEvent;
   System::ContextGroup m_sleepingContext;
@@ -43,4 +45,6 @@ private:
   Logging::LoggerRef m_logger;
 
   Crypto::Hash requestLastBlockHash();
+  std::string requestBlockTemplateLongPollId(const std::string& previousId);
+  void pollLastBlockHash();
 };
@@ -18,8 +18,12 @@
 
 #include "Miner.h"
 
+#include <algorithm>
+#include <cstring>
 #include <functional>
 
+#include "Common/ScopeExit.h"
+#include "Common/Util.h"
 #include "crypto/crypto.h"
 #include "crypto/random.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
@@ -28,10 +32,26 @@
 
 namespace CryptoNote {
 
+namespace {
+
+// nonces a worker takes from the current job at once
+const uint32_t NONCE_RANGE_SIZE = 256;
+
+}
+
+struct Miner::MiningJob {
+  Block blockTemplate;
+  difficulty_type difficulty;
+  BinaryArray blob;
+  size_t nonceOffset;
+  std::atomic<uint32_t> nextNonce;
+};
+
 Miner::Miner(System::Dispatcher& dispatcher, Logging::ILogger& logger) :
   m_dispatcher(dispatcher),
   m_miningStopped(dispatcher),
   m_state(MiningState::MINING_STOPPED),
+  m_jobId(0),
   m_logger(logger, "Miner") {
 }
 
@@ -39,11 +59,15 @@ Miner::~Miner() {
   assert(m_state != MiningState::MINING_IN_PROGRESS);
 }
 
-Block Miner::mine(const BlockMiningParameters& blockMiningParameters, size_t threadCount) {
+Block Miner::mine(const BlockMiningParameters& blockMiningParameters, size_t threadCount, size_t hashWays) {
   if (threadCount == 0) {
     throw std::runtime_error("Miner requires at least one thread");
   }
 
+  if (hashWays == 0 || hashWays > Crypto::SLOW_HASH_MAX_WAYS) {
+    throw std::runtime_error("Miner hash ways must be 1.." + std::to_string(Crypto::SLOW_HASH_MAX_WAYS));
+  }
+
   if (m_state == MiningState::MINING_IN_PROGRESS) {
     throw std::runtime_error("Mining is already in progress");
   }
@@ -51,7 +75,7 @@ Block Miner::mine(const BlockMiningParameters& blockMiningParameters, size_t thr
   m_state = MiningState::MINING_IN_PROGRESS;
   m_miningStopped.clear();
 
-  runWorkers(blockMiningParameters, threadCount);
+  runWorkers(blockMiningParameters, threadCount, hashWays);
 
   assert(m_state != MiningState::MINING_IN_PROGRESS);
   if (m_state == MiningState::MINING_STOPPED) {
@@ -72,20 +96,63 @@ void Miner::stop() {
   }
 }
 
-void Miner::runWorkers(BlockMiningParameters blockMiningParameters, size_t threadCount) {
+bool Miner::updateBlockTemplate(const BlockMiningParameters& blockMiningParameters) {
+  std::shared_ptr<MiningJob> job = makeJob(blockMiningParameters);
+  if (!job) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(m_jobMutex);
+  if (!m_job) {
+    return false;
+  }
+
+  // a found block is about to be reported, the workers are finishing anyway
+  if (m_state == MiningState::MINING_IN_PROGRESS) {
+    m_logger(Logging::INFO) << "Switching mining to new block template, difficulty " << blockMiningParameters.difficulty;
+    m_job = std::move(job);
+    ++m_jobId;
+  }
+
+  return true;
+}
+
+std::shared_ptr<Miner::MiningJob> Miner::makeJob(const BlockMiningParameters& blockMiningParameters) {
+  std::shared_ptr<MiningJob> job = std::make_shared<MiningJob>();
+  job->blockTemplate = blockMiningParameters.blockTemplate;
+  job->difficulty = blockMiningParameters.difficulty;
+  if (!get_block_longhash_blob(job->blockTemplate, job->blob, job->nonceOffset)) {
+    m_logger(Logging::ERROR) << "Couldn't get hashing blob of the block template";
+    return nullptr;
+  }
+
+  job->nextNonce = Random::randomValue<uint32_t>();
+  return job;
+}
+
+void Miner::setJob(std::shared_ptr<MiningJob>&& job) {
+  std::lock_guard<std::mutex> lock(m_jobMutex);
+  m_job = std::move(job);
+  ++m_jobId;
+}
+
+void Miner::runWorkers(BlockMiningParameters blockMiningParameters, size_t threadCount, size_t hashWays) {
   assert(threadCount > 0);
 
   m_logger(Logging::INFO) << "Starting mining for difficulty " << blockMiningParameters.difficulty;
 
   try {
-    blockMiningParameters.blockTemplate.nonce = Random::randomValue<uint32_t>();
+    std::shared_ptr<MiningJob> job = makeJob(blockMiningParameters);
+    if (!job) {
+      throw std::runtime_error("Couldn't prepare mining job");
+    }
+
+    setJob(std::move(job));
 
     for (size_t i = 0; i < threadCount; ++i) {
       m_workers.emplace_back(std::unique_ptr<System::RemoteContext<void>> (
-        new System::RemoteContext<void>(m_dispatcher, std::bind(&Miner::workerFunc, this, blockMiningParameters.blockTemplate, blockMiningParameters.difficulty, (uint32_t)threadCount)))
+        new System::RemoteContext<void>(m_dispatcher, std::bind(&Miner::workerFunc, this, (uint32_t)i, hashWays)))
       );
-
-      blockMiningParameters.blockTemplate.nonce++;
     }
 
     m_workers.clear();
@@ -95,36 +162,90 @@ void Miner::runWorkers(BlockMiningParameters blockMiningParameters, size_t threa
     m_state = MiningState::MINING_STOPPED;
   }
 
+  {
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    m_job.reset();
+  }
+
   m_miningStopped.set();
 }
 
-void Miner::workerFunc(const Block& blockTemplate, difficulty_type difficulty, uint32_t nonceStep) {
+void Miner::workerFunc(uint32_t threadIndex, size_t hashWays) {
   try {
-    Block block = blockTemplate;
+    // Each worker runs on its own thread, pin it first so that the
+    // scratchpad is placed on the NUMA node it is going to be used from.
+    bool pinned = Tools::setCurrentThreadAffinity(threadIndex);
+    Crypto::slow_hash_allocate_state();
+    if (hashWays > 1) {
+      Crypto::slow_hash_allocate_multi_state();
+    }
+
+    Tools::ScopeExit freeState([] { Crypto::slow_hash_free_state(); });
+
+    m_logger(Logging::INFO) << "Worker " << threadIndex << " started, huge pages: "
+      << (Crypto::slow_hash_state_is_huge_page() ? "yes" : "no") << ", CPU affinity: " << (pinned ? "pinned" : "not set")
+      << ", hash kernel: " << Crypto::slow_hash_kernel_name(Crypto::slow_hash_kernel());
+
     Crypto::cn_context cryptoContext;
 
+    // every lane keeps its own copy of the job's hashing blob, only the nonce bytes are rewritten per hash
+    std::shared_ptr<MiningJob> job;
+    uint32_t jobId = 0;
+    BinaryArray blobs[Crypto::SLOW_HASH_MAX_WAYS];
+    const void* data[Crypto::SLOW_HASH_MAX_WAYS];
+    size_t lengths[Crypto::SLOW_HASH_MAX_WAYS];
+    Crypto::Hash hashes[Crypto::SLOW_HASH_MAX_WAYS];
+    uint32_t nonce = 0;
+    uint32_t rangeLeft = 0;
+
     while (m_state == MiningState::MINING_IN_PROGRESS) {
-      Crypto::Hash hash;
-      if (!get_block_longhash(cryptoContext, block, hash)) {
-        //error occured
-        m_logger(Logging::DEBUGGING) << "calculating long hash error occured";
-        m_state = MiningState::MINING_STOPPED;
-        return;
+      if (jobId != m_jobId.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        job = m_job;
+        jobId = m_jobId;
+        if (!job) {
+          return;
+        }
+
+        for (size_t i = 0; i < hashWays; ++i) {
+          blobs[i] = job->blob;
+          data[i] = blobs[i].data();
+          lengths[i] = blobs[i].size();
+        }
+
+        rangeLeft = 0;
       }
 
-      if (check_hash(hash, difficulty)) {
-        m_logger(Logging::INFO) << "Found block for difficulty " << difficulty;
+      if (rangeLeft == 0) {
+        nonce = job->nextNonce.fetch_add(NONCE_RANGE_SIZE);
+        rangeLeft = NONCE_RANGE_SIZE;
+      }
 
-        if (!setStateBlockFound()) {
-          m_logger(Logging::DEBUGGING) << "block is already found or mining stopped";
+      size_t count = std::min<size_t>(hashWays, rangeLeft);
+      for (size_t i = 0; i < count; ++i) {
+        uint32_t laneNonce = nonce + static_cast<uint32_t>(i);
+        memcpy(&blobs[i][job->nonceOffset], &laneNonce, sizeof(laneNonce));
+      }
+
+      Crypto::cn_slow_hash_multi(cryptoContext, data, lengths, count, hashes);
+
+      for (size_t i = 0; i < count; ++i) {
+        if (check_hash(hashes[i], job->difficulty)) {
+          m_logger(Logging::INFO) << "Found block for difficulty " << job->difficulty;
+
+          if (!setStateBlockFound()) {
+            m_logger(Logging::DEBUGGING) << "block is already found or mining stopped";
+            return;
+          }
+
+          m_block = job->blockTemplate;
+          m_block.nonce = nonce + static_cast<uint32_t>(i);
           return;
         }
-
-        m_block = block;
-        return;
       }
 
-      block.nonce += nonceStep;
+      nonce += static_cast<uint32_t>(count);
+      rangeLeft -= static_cast<uint32_t>(count);
     }
   } catch (std::exception& e) {
     m_logger(Logging::ERROR) << "Miner got error: " << e.what();
@@ -18,6 +18,8 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
+#include <mutex>
 #include <thread>
 
 #include <System/Dispatcher.h>
@@ -41,7 +43,11 @@ public:
   Miner(System::Dispatcher& dispatcher, Logging::ILogger& logger);
   ~Miner();
 
-  Block mine(const BlockMiningParameters& blockMiningParameters, size_t threadCount);
+  Block mine(const BlockMiningParameters& blockMiningParameters, size_t threadCount, size_t hashWays = 1);
+
+  // Hands a new template to the running workers without restarting them.
+  // Returns false if there is no mining run to update, the caller has to start a new one.
+  bool updateBlockTemplate(const BlockMiningParameters& blockMiningParameters);
 
   //NOTE! this is blocking method
   void stop();
@@ -55,12 +61,20 @@ private:
 
   std::vector<std::unique_ptr<System::RemoteContext<void>>>  m_workers;
 
+  // the template being mined, workers reload it when m_jobId changes
+  struct MiningJob;
+  std::mutex m_jobMutex;
+  std::shared_ptr<MiningJob> m_job;
+  std::atomic<uint32_t> m_jobId;
+
   Block m_block;
 
   Logging::LoggerRef m_logger;
 
-  void runWorkers(BlockMiningParameters blockMiningParameters, size_t threadCount);
-  void workerFunc(const Block& blockTemplate, difficulty_type difficulty, uint32_t nonceStep);
+  std::shared_ptr<MiningJob> makeJob(const BlockMiningParameters& blockMiningParameters);
+  void setJob(std::shared_ptr<MiningJob>&& job);
+  void runWorkers(BlockMiningParameters blockMiningParameters, size_t threadCount, size_t hashWays);
+  void workerFunc(uint32_t threadIndex, size_t hashWays);
   bool setStateBlockFound();
 };
 
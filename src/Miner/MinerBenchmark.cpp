@@ -0,0 +1,224 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "MinerBenchmark.h"
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "Common/ScopeExit.h"
+#include "Common/Util.h"
+#include "crypto/crypto.h"
+#include "crypto/random.h"
+#include "CryptoNoteConfig.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+
+using namespace Logging;
+
+namespace Miner {
+
+namespace {
+
+// random bytes in the coinbase extra, about what a pool puts there
+const size_t SYNTHETIC_EXTRA_SIZE = 64;
+
+// a block template of the current version, only the nonce is changed while hashing
+CryptoNote::Block makeSyntheticTemplate() {
+  CryptoNote::Block block;
+  block.majorVersion = CryptoNote::BLOCK_MAJOR_VERSION_5;
+  block.minorVersion = CryptoNote::BLOCK_MINOR_VERSION_0;
+  block.nonce = Random::randomValue<uint32_t>();
+  block.timestamp = static_cast<uint64_t>(time(nullptr));
+  Random::randomBytes(sizeof(block.previousBlockHash), block.previousBlockHash.data);
+
+  CryptoNote::BaseInput input;
+  input.blockIndex = Random::randomValue<uint32_t>() & 0xFFFFFF;
+  block.baseTransaction.version = CryptoNote::CURRENT_TRANSACTION_VERSION;
+  block.baseTransaction.unlockTime = input.blockIndex + CryptoNote::parameters::CRYPTONOTE_MINED_MONEY_UNLOCK_WINDOW;
+  block.baseTransaction.inputs.push_back(input);
+  block.baseTransaction.extra.resize(SYNTHETIC_EXTRA_SIZE);
+  Random::randomBytes(SYNTHETIC_EXTRA_SIZE, block.baseTransaction.extra.data());
+
+  return block;
+}
+
+}
+
+struct MinerBenchmark::ThreadResult {
+  uint64_t hashes = 0;
+  double seconds = 0;
+  bool hugePages = false;
+  bool pinned = false;
+  std::string error;
+};
+
+MinerBenchmark::MinerBenchmark(const CryptoNote::MiningConfig& config, Logging::ILogger& logger) :
+  m_config(config),
+  m_logger(logger, "MinerBenchmark"),
+  m_readyThreads(0),
+  m_started(false),
+  m_stopped(false) {
+}
+
+Common::JsonValue MinerBenchmark::run() {
+  Common::JsonValue configurations(Common::JsonValue::ARRAY);
+  for (int kernel = 0; kernel < Crypto::slow_hash_kernel_count(); ++kernel) {
+    if (Crypto::slow_hash_kernel_available(kernel)) {
+      configurations.pushBack(runConfiguration(kernel, 1));
+    }
+  }
+
+  if (m_config.hashWays > 1) {
+    configurations.pushBack(runConfiguration(Crypto::slow_hash_kernel(), m_config.hashWays));
+  }
+
+  Common::JsonValue result(Common::JsonValue::OBJECT);
+  result.insert("threads", static_cast<int64_t>(m_config.threadCount));
+  result.insert("duration", static_cast<int64_t>(m_config.benchmarkTime));
+  result.insert("default_kernel", std::string(Crypto::slow_hash_kernel_name(Crypto::slow_hash_kernel())));
+  result.insert("configurations", std::move(configurations));
+  return result;
+}
+
+Common::JsonValue MinerBenchmark::runConfiguration(int kernel, size_t hashWays) {
+  const char* kernelName = Crypto::slow_hash_kernel_name(kernel);
+  m_logger(INFO) << "Benchmarking kernel " << kernelName << ", hash ways " << hashWays << ", threads " << m_config.threadCount
+    << " for " << m_config.benchmarkTime << " seconds";
+
+  m_readyThreads = 0;
+  m_started = false;
+  m_stopped = false;
+
+  std::vector<ThreadResult> results(m_config.threadCount);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < m_config.threadCount; ++i) {
+    threads.emplace_back(&MinerBenchmark::workerFunc, this, static_cast<uint32_t>(i), kernel, hashWays, std::ref(results[i]));
+  }
+
+  // the scratchpads are allocated and the threads pinned before the clock starts
+  while (m_readyThreads < m_config.threadCount) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  m_started = true;
+  std::this_thread::sleep_for(std::chrono::seconds(m_config.benchmarkTime));
+  m_stopped = true;
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  Common::JsonValue threadsJson(Common::JsonValue::ARRAY);
+  double totalHashrate = 0;
+  bool hugePages = true;
+  for (size_t i = 0; i < results.size(); ++i) {
+    const ThreadResult& result = results[i];
+    if (!result.error.empty()) {
+      throw std::runtime_error("Benchmark thread " + std::to_string(i) + " failed: " + result.error);
+    }
+
+    double hashrate = result.seconds > 0 ? static_cast<double>(result.hashes) / result.seconds : 0;
+    totalHashrate += hashrate;
+    hugePages = hugePages && result.hugePages;
+
+    Common::JsonValue threadJson(Common::JsonValue::OBJECT);
+    threadJson.insert("thread", static_cast<int64_t>(i));
+    threadJson.insert("hashes", static_cast<int64_t>(result.hashes));
+    threadJson.insert("hashrate", hashrate);
+    threadJson.insert("huge_pages", Common::JsonValue(result.hugePages));
+    threadJson.insert("pinned", Common::JsonValue(result.pinned));
+    threadsJson.pushBack(std::move(threadJson));
+  }
+
+  m_logger(INFO) << "Kernel " << kernelName << ", hash ways " << hashWays << ": " << totalHashrate << " H/s";
+
+  Common::JsonValue configuration(Common::JsonValue::OBJECT);
+  configuration.insert("kernel", std::string(kernelName));
+  configuration.insert("hash_ways", static_cast<int64_t>(hashWays));
+  configuration.insert("huge_pages", Common::JsonValue(hugePages));
+  configuration.insert("hashrate", totalHashrate);
+  configuration.insert("threads", std::move(threadsJson));
+  return configuration;
+}
+
+void MinerBenchmark::workerFunc(uint32_t threadIndex, int kernel, size_t hashWays, ThreadResult& result) {
+  bool ready = false;
+  try {
+    // same setup as a mining worker, so that the numbers carry over
+    result.pinned = Tools::setCurrentThreadAffinity(threadIndex);
+    Crypto::slow_hash_allocate_state();
+    if (hashWays > 1) {
+      Crypto::slow_hash_allocate_multi_state();
+    }
+
+    Tools::ScopeExit freeState([] { Crypto::slow_hash_free_state(); });
+    result.hugePages = Crypto::slow_hash_state_is_huge_page() != 0;
+
+    CryptoNote::BinaryArray blobs[Crypto::SLOW_HASH_MAX_WAYS];
+    const void* data[Crypto::SLOW_HASH_MAX_WAYS];
+    size_t lengths[Crypto::SLOW_HASH_MAX_WAYS];
+    char hashes[Crypto::SLOW_HASH_MAX_WAYS * Crypto::HASH_SIZE];
+    size_t nonceOffset;
+
+    CryptoNote::Block blockTemplate = makeSyntheticTemplate();
+    CryptoNote::BinaryArray blob;
+    if (!CryptoNote::get_block_longhash_blob(blockTemplate, blob, nonceOffset)) {
+      throw std::runtime_error("Couldn't get hashing blob of the synthetic block template");
+    }
+
+    for (size_t i = 0; i < hashWays; ++i) {
+      blobs[i] = blob;
+      data[i] = blobs[i].data();
+      lengths[i] = blobs[i].size();
+    }
+
+    ready = true;
+    ++m_readyThreads;
+    while (!m_started) {
+      std::this_thread::yield();
+    }
+
+    uint32_t nonce = blockTemplate.nonce;
+    auto start = std::chrono::steady_clock::now();
+    while (!m_stopped) {
+      for (size_t i = 0; i < hashWays; ++i) {
+        uint32_t laneNonce = nonce + static_cast<uint32_t>(i);
+        memcpy(&blobs[i][nonceOffset], &laneNonce, sizeof(laneNonce));
+      }
+
+      if (hashWays == 1) {
+        Crypto::cn_slow_hash_kernel(kernel, data[0], lengths[0], hashes);
+      } else {
+        Crypto::cn_slow_hash_multi(data, lengths, hashWays, hashes);
+      }
+
+      nonce += static_cast<uint32_t>(hashWays);
+      result.hashes += hashWays;
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  } catch (std::exception& e) {
+    result.error = e.what();
+    if (!ready) {
+      ++m_readyThreads;
+    }
+  }
+}
+
+} //namespace Miner
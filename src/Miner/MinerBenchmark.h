@@ -0,0 +1,52 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+
+#include "Common/JsonValue.h"
+#include "Logging/LoggerRef.h"
+#include "MiningConfig.h"
+
+namespace Miner {
+
+// Hashes a synthetic block template offline for config.benchmarkTime seconds per configuration:
+// every hash kernel available on this CPU one hash at a time and, with --hash-ways above 1,
+// the interleaved kernel. Uses config.threadCount threads pinned like the mining workers.
+class MinerBenchmark {
+public:
+  MinerBenchmark(const CryptoNote::MiningConfig& config, Logging::ILogger& logger);
+
+  // per-thread and total hashrates, huge pages and kernel of every configuration
+  Common::JsonValue run();
+
+private:
+  struct ThreadResult;
+
+  const CryptoNote::MiningConfig& m_config;
+  Logging::LoggerRef m_logger;
+
+  std::atomic<size_t> m_readyThreads;
+  std::atomic<bool> m_started;
+  std::atomic<bool> m_stopped;
+
+  Common::JsonValue runConfiguration(int kernel, size_t hashWays);
+  void workerFunc(uint32_t threadIndex, int kernel, size_t hashWays, ThreadResult& result);
+};
+
+} //namespace Miner
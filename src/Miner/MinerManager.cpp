@@ -75,7 +75,7 @@ MinerManager::MinerManager(System::Dispatcher& dispatcher, const CryptoNote::Min
   m_contextGroup(dispatcher),
   m_config(config),
   m_miner(dispatcher, logger),
-  m_blockchainMonitor(dispatcher, m_config.daemonHost, m_config.daemonPort, m_config.scanPeriod, logger),
+  m_blockchainMonitor(dispatcher, m_config.daemonHost, m_config.daemonPort, m_config.scanPeriod, m_config.miningAddress, logger),
   m_eventOccurred(dispatcher),
   m_httpEvent(dispatcher),
   m_lastBlockTimestamp(0) {
@@ -143,13 +143,15 @@ void MinerManager::eventLoop() {
 
       case MinerEventType::BLOCKCHAIN_UPDATED: {
         m_logger(Logging::DEBUGGING) << "got BLOCKCHAIN_UPDATED event";
-        stopMining();
         stopBlockchainMonitoring();
         BlockMiningParameters params = requestMiningParameters(m_dispatcher, m_config.daemonHost, m_config.daemonPort, m_config.miningAddress);
         adjustBlockTemplate(params.blockTemplate);
 
         startBlockchainMonitoring();
-        startMining(params);
+        if (!m_miner.updateBlockTemplate(params)) {
+          stopMining();
+          startMining(params);
+        }
         break;
       }
 
@@ -180,7 +182,7 @@ void MinerManager::pushEvent(MinerEvent&& event) {
 void MinerManager::startMining(const CryptoNote::BlockMiningParameters& params) {
   m_contextGroup.spawn([this, params] () {
     try {
-      m_minedBlock = m_miner.mine(params, m_config.threadCount);
+      m_minedBlock = m_miner.mine(params, m_config.threadCount, m_config.hashWays);
       pushEvent(BlockMinedEvent());
     } catch (System::InterruptedException&) {
     } catch (std::exception& e) {
@@ -26,6 +26,7 @@
 #include <boost/program_options.hpp>
 
 #include "CryptoNoteConfig.h"
+#include "crypto/hash.h"
 #include "Logging/ILogger.h"
 
 namespace po = boost::program_options;
@@ -35,6 +36,7 @@ namespace CryptoNote {
 namespace {
 
 const size_t DEFAULT_SCANT_PERIOD = 30;
+const size_t DEFAULT_BENCHMARK_TIME = 20;
 const char* DEFAULT_DAEMON_HOST = "127.0.0.1";
 const size_t CONCURRENCY_LEVEL = std::thread::hardware_concurrency();
 
@@ -63,7 +65,7 @@ void parseDaemonAddress(const std::string& daemonAddress, std::string& daemonHos
 
 }
 
-MiningConfig::MiningConfig(): help(false) {
+MiningConfig::MiningConfig(): benchmark(false), help(false) {
   cmdOptions.add_options()
       ("help,h", "produce this help message and exit")
       ("address", po::value<std::string>(), "Valid cryptonote miner's address")
@@ -71,12 +73,15 @@ MiningConfig::MiningConfig(): help(false) {
       ("daemon-rpc-port", po::value<uint16_t>()->default_value(static_cast<uint16_t>(RPC_DEFAULT_PORT)), "Daemon's RPC port")
       ("daemon-address", po::value<std::string>(), "Daemon host:port. If you use this option you must not use --daemon-host and --daemon-port options")
       ("threads", po::value<size_t>()->default_value(CONCURRENCY_LEVEL), "Mining threads count. Must not be greater than you concurrency level. Default value is your hardware concurrency level")
+      ("hash-ways", po::value<size_t>()->default_value(1), "Hashes computed at once by every mining thread, 1..4. Values above 1 need 2 MB of fast cache per hash to pay off")
       ("scan-time", po::value<size_t>()->default_value(DEFAULT_SCANT_PERIOD), "Blockchain polling interval (seconds). How often miner will check blockchain for updates")
       ("log-level", po::value<int>()->default_value(1), "Log level. Must be 0..5")
       ("limit", po::value<size_t>()->default_value(0), "Mine exact quantity of blocks. 0 means no limit")
       ("first-block-timestamp", po::value<uint64_t>()->default_value(0), "Set timestamp to the first mined block. 0 means leave timestamp unchanged")
       ("block-timestamp-interval", po::value<int64_t>()->default_value(0), "Timestamp step for each subsequent block. May be set only if --first-block-timestamp has been set."
-                                                         " If not set blocks' timestamps remain unchanged");
+                                                         " If not set blocks' timestamps remain unchanged")
+      ("benchmark", "Hash synthetic block templates offline with every hash kernel and print the hashrates as JSON, no daemon or address needed")
+      ("benchmark-time", po::value<size_t>()->default_value(DEFAULT_BENCHMARK_TIME), "Seconds each benchmark configuration runs for");
 }
 
 void MiningConfig::parse(int argc, char** argv) {
@@ -89,6 +94,31 @@ void MiningConfig::parse(int argc, char** argv) {
     return;
   }
 
+  threadCount = options["threads"].as<size_t>();
+  if (threadCount == 0 || threadCount > CONCURRENCY_LEVEL) {
+    throw std::runtime_error("--threads option must be 1.." + std::to_string(CONCURRENCY_LEVEL));
+  }
+
+  hashWays = options["hash-ways"].as<size_t>();
+  if (hashWays == 0 || hashWays > Crypto::SLOW_HASH_MAX_WAYS) {
+    throw std::runtime_error("--hash-ways option must be 1.." + std::to_string(Crypto::SLOW_HASH_MAX_WAYS));
+  }
+
+  logLevel = static_cast<uint8_t>(options["log-level"].as<int>());
+  if (logLevel > static_cast<uint8_t>(Logging::TRACE)) {
+    throw std::runtime_error("--log-level value is too big");
+  }
+
+  if (options.count("benchmark") != 0) {
+    benchmark = true;
+    benchmarkTime = options["benchmark-time"].as<size_t>();
+    if (benchmarkTime == 0) {
+      throw std::runtime_error("--benchmark-time must not be zero");
+    }
+
+    return;
+  }
+
   if (options.count("address") == 0) {
     throw std::runtime_error("Specify --address option");
   }
@@ -106,21 +136,11 @@ void MiningConfig::parse(int argc, char** argv) {
     daemonPort = options["daemon-rpc-port"].as<uint16_t>();
   }
 
-  threadCount = options["threads"].as<size_t>();
-  if (threadCount == 0 || threadCount > CONCURRENCY_LEVEL) {
-    throw std::runtime_error("--threads option must be 1.." + std::to_string(CONCURRENCY_LEVEL));
-  }
-
   scanPeriod = options["scan-time"].as<size_t>();
   if (scanPeriod == 0) {
     throw std::runtime_error("--scan-time must not be zero");
   }
 
-  logLevel = static_cast<uint8_t>(options["log-level"].as<int>());
-  if (logLevel > static_cast<uint8_t>(Logging::TRACE)) {
-    throw std::runtime_error("--log-level value is too big");
-  }
-
   blocksLimit = options["limit"].as<size_t>();
 
   if (!options["block-timestamp-interval"].defaulted() && options["first-block-timestamp"].defaulted()) {
@@ -32,11 +32,14 @@ struct MiningConfig {
   std::string daemonHost;
   uint16_t daemonPort;
   size_t threadCount;
+  size_t hashWays;
   size_t scanPeriod;
   uint8_t logLevel;
   size_t blocksLimit;
   uint64_t firstBlockTimestamp;
   int64_t blockTimestampInterval;
+  bool benchmark;
+  size_t benchmarkTime;
   bool help;
 };
 
@@ -21,6 +21,7 @@
 #include "Logging/ConsoleLogger.h"
 #include "Logging/LoggerRef.h"
 
+#include "MinerBenchmark.h"
 #include "MinerManager.h"
 
 #include <System/Dispatcher.h>
@@ -39,6 +40,12 @@ int main(int argc, char** argv) {
     Logging::ConsoleLogger consoleLogger(static_cast<Logging::Level>(config.logLevel));
     loggerGroup.addLogger(consoleLogger);
 
+    if (config.benchmark) {
+      Miner::MinerBenchmark benchmark(config, loggerGroup);
+      std::cout << benchmark.run() << std::endl;
+      return 0;
+    }
+
     System::Dispatcher dispatcher;
     Miner::MinerManager app(dispatcher, config, loggerGroup);
 
@@ -37,6 +37,7 @@
  * that method of "backing up" one's wallet keys.
  */
 
+#include <algorithm>
 #include <string>
 #include <cassert>
 #include <map>
@@ -103,12 +104,36 @@ const static LanguageMap c_languageMap =
 
 namespace {
 
-uint32_t create_checksum_index(const std::vector<std::string> &word_list, uint32_t unique_prefix_length);
-bool checksum_test(std::vector<std::string> seed, uint32_t unique_prefix_length);
+uint32_t create_checksum_index(const std::vector<std::string> &word_list, size_t word_count, uint32_t unique_prefix_length);
+bool checksum_test(const std::vector<std::string> &seed, uint32_t unique_prefix_length);
+
+/*!
+* \brief All languages, constructed together on first use. The initialization of a
+*        function local static is thread safe, the Lazy entries of c_languageMap are not.
+* \return The languages in the order of c_languageMap.
+*/
+const std::vector<std::shared_ptr<Language::Base>>& get_languages()
+{
+	static const std::vector<std::shared_ptr<Language::Base>> languages = []()
+	{
+		std::vector<std::shared_ptr<Language::Base>> result;
+		for (auto it = Language::c_languageMap.cbegin(); it != Language::c_languageMap.cend(); ++it)
+		{
+			std::shared_ptr<Language::Base>& language = it->second;
+			result.push_back(language);
+		}
+
+		assert(result.size() < 32);
+		return result;
+	}();
+
+	return languages;
+}
 
 /*!
 * \brief Finds the word list that contains the seed words and puts the indices
-*        where matches occured in matched_indices.
+*        where matches occured in matched_indices. The seed is read once, every word
+*        is only looked up in the languages that had all the words before it.
 * \param  seed            List of words to match.
 * \param  has_checksum    The seed has a checksum word (maybe not checked).
 * \param  matched_indices The indices where the seed words were found are added to this.
@@ -118,72 +143,55 @@ bool checksum_test(std::vector<std::string> seed, uint32_t unique_prefix_length)
 bool find_seed_language(const std::vector<std::string> &seed, bool has_checksum, 
 	std::vector<uint32_t> &matched_indices, Language::Base **language)
 {
-	Language::Base *fallback = NULL;
+	const std::vector<std::shared_ptr<Language::Base>>& languages = get_languages();
 
-	// Iterate through all the languages and find a match
-	for (auto it1 = Language::c_languageMap.cbegin(); it1 != Language::c_languageMap.cend(); ++it1)
-	{
-		std::shared_ptr<Language::Base>& lang = it1->second;
-
-		const std::unordered_map<std::string, uint32_t> &word_map         = lang->get_word_map();
-		const std::unordered_map<std::string, uint32_t> &trimmed_word_map = lang->get_trimmed_word_map();
-		// To iterate through seed words
-		std::vector<std::string>::const_iterator it2;
-		bool full_match = true;
+	// one bit per language that has all the words seen so far
+	uint32_t candidates = (UINT32_C(1) << languages.size()) - 1;
+	std::vector<uint32_t> indices(languages.size() * seed.size());
 
-		std::string trimmed_word;
-		// Iterate through all the words and see if they're all present
-		for (it2 = seed.cbegin(); it2 != seed.cend(); ++it2)
+	for (size_t i = 0; i < seed.size() && candidates != 0; ++i)
+	{
+		for (size_t j = 0; j < languages.size(); ++j)
 		{
-			if (has_checksum)
-			{
-				trimmed_word = Language::utf8prefix(*it2, lang->get_unique_prefix_length());
-				// Use the trimmed words and map
-				if (trimmed_word_map.count(trimmed_word) == 0)
-				{
-					full_match = false;
-					break;
-				}
-				matched_indices.push_back(trimmed_word_map.at(trimmed_word));
-			}
+			if ((candidates & (UINT32_C(1) << j)) == 0)
+				continue;
+
+			const Language::Base& lang = *languages[j];
+			const std::unordered_map<std::string, uint32_t>& word_map = has_checksum ? lang.get_trimmed_word_map() : lang.get_word_map();
+			auto it = word_map.find(has_checksum ? Language::utf8prefix(seed[i], lang.get_unique_prefix_length()) : seed[i]);
+			if (it == word_map.end())
+				candidates &= ~(UINT32_C(1) << j);
 			else
-			{
-				if (word_map.count(*it2) == 0)
-				{
-					full_match = false;
-					break;
-				}
-				matched_indices.push_back(word_map.at(*it2));
-			}
+				indices[j * seed.size() + i] = it->second;
 		}
+	}
 
-		if (full_match)
-		{
-			// if we were using prefix only, and we have a checksum, check it now
-			// to avoid false positives due to prefix set being too common
-			if (has_checksum && 
-				!checksum_test(seed, lang->get_unique_prefix_length()))
-			{
-				fallback = lang.get();
-				full_match = false;
-			}
-		}
-		
-		if (full_match)
+	size_t fallback = languages.size();
+	for (size_t j = 0; j < languages.size(); ++j)
+	{
+		if ((candidates & (UINT32_C(1) << j)) == 0)
+			continue;
+
+		// if we were using prefix only, and we have a checksum, check it now
+		// to avoid false positives due to prefix set being too common
+		if (has_checksum && !checksum_test(seed, languages[j]->get_unique_prefix_length()))
 		{
-			*language = lang.get();
-			return true;
+			fallback = j;
+			continue;
 		}
-		// Some didn't match. Clear the index array.
-		matched_indices.clear();
+
+		*language = languages[j].get();
+		matched_indices.assign(indices.begin() + j * seed.size(), indices.begin() + (j + 1) * seed.size());
+		return true;
 	}
 
 	// if we get there, we've not found a good match, but we might have a fallback,
 	// if we detected a match which did not fit the checksum, which might be a badly
 	// typed/transcribed seed in the right language
-	if (fallback)
+	if (fallback < languages.size())
 	{
-		*language = fallback;
+		*language = languages[fallback].get();
+		matched_indices.assign(indices.begin() + fallback * seed.size(), indices.begin() + (fallback + 1) * seed.size());
 		return true;
 	}
 
@@ -193,14 +201,15 @@ bool find_seed_language(const std::vector<std::string> &seed, bool has_checksum,
 /*!
 * \brief Creates a checksum index in the word list array on the list of words.
 * \param  word_list            Vector of words
+* \param  word_count           Number of words from the start of word_list to use
 * \param unique_prefix_length  the prefix length of each word to use for checksum
 * \return                      Checksum index
 */
-uint32_t create_checksum_index(const std::vector<std::string> &word_list, uint32_t unique_prefix_length)
+uint32_t create_checksum_index(const std::vector<std::string> &word_list, size_t word_count, uint32_t unique_prefix_length)
 {
 	std::string trimmed_words = "";
 
-	for (auto it = word_list.cbegin(); it != word_list.cend(); ++it)
+	for (auto it = word_list.cbegin(); it != word_list.cbegin() + word_count; ++it)
 	{
 		if (it->length() > unique_prefix_length)
 			trimmed_words += Language::utf8prefix(*it, unique_prefix_length);
@@ -218,13 +227,12 @@ uint32_t create_checksum_index(const std::vector<std::string> &word_list, uint32
 * \param unique_prefix_length  the prefix length of each word to use for checksum
 * \return                      True if the test passed false if not.
 */
-bool checksum_test(std::vector<std::string> seed, uint32_t unique_prefix_length)
+bool checksum_test(const std::vector<std::string> &seed, uint32_t unique_prefix_length)
 {
 	// The last word is the checksum.
-	std::string last_word = seed.back();
-	seed.pop_back();
+	const std::string& last_word = seed.back();
 
-	std::string checksum = seed[create_checksum_index(seed, unique_prefix_length)];
+	const std::string& checksum = seed[create_checksum_index(seed, seed.size() - 1, unique_prefix_length)];
 
 	std::string trimmed_checksum = checksum.length() > unique_prefix_length ? 
 		Language::utf8prefix(checksum, unique_prefix_length) : checksum;
@@ -317,10 +325,12 @@ bool bytes_to_words(const Crypto::SecretKey& src, std::string& words, const std:
 {
 	if (sizeof(src.data) % 4 != 0 || sizeof(src.data) == 0) return false;
 
-	auto itLanguage = Language::c_languageMap.find(language_name);
-    if (itLanguage == Language::c_languageMap.cend())
+	const std::vector<std::shared_ptr<Language::Base>>& languages = get_languages();
+	auto itLanguage = std::find_if(languages.begin(), languages.end(),
+		[&](const std::shared_ptr<Language::Base>& language) { return language->get_language_name() == language_name; });
+	if (itLanguage == languages.end())
 		return false;
-	std::shared_ptr<Language::Base>& language = itLanguage->second;
+	const Language::Base* language = itLanguage->get();
 
 	const std::vector<std::string> &word_list = language->get_word_list();
 	// To store the words for random access to add the checksum word later.
@@ -351,7 +361,7 @@ bool bytes_to_words(const Crypto::SecretKey& src, std::string& words, const std:
 	}
 
 	words.pop_back();
-	words += (' ' + words_store[create_checksum_index(words_store, language->get_unique_prefix_length())]);
+	words += (' ' + words_store[create_checksum_index(words_store, words_store.size(), language->get_unique_prefix_length())]);
 	return true;
 }
 
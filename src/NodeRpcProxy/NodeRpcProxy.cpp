@@ -22,6 +22,7 @@
 #include <atomic>
 #include <system_error>
 #include <thread>
+#include <unordered_map>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <boost/lexical_cast.hpp>
@@ -31,7 +32,7 @@
 #include <System/ContextGroup.h>
 #include <System/Dispatcher.h>
 #include <System/Event.h>
-#include <System/EventLock.h>
+#include <System/InterruptedException.h>
 #include <System/Timer.h>
 #include <CryptoNoteCore/TransactionApi.h>
 #include "Common/FormatTools.h"
@@ -41,6 +42,7 @@
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "Rpc/CoreRpcServerCommandsDefinitions.h"
 #include "Rpc/HttpClient.h"
+#include "Rpc/HttpClientPool.h"
 #include "Rpc/JsonRpc.h"
 
 #ifndef AUTO_VAL_INIT
@@ -55,6 +57,29 @@ namespace CryptoNote {
 
 namespace {
 
+const uint32_t WAIT_FOR_CHANGES_TIMEOUT = 60; // seconds
+
+// Daemon connections are split by request class, so that a block download doesn't hold up
+// sending a transaction and a long poll doesn't hold up anything.
+enum RequestLane {
+  LANE_SYNC,   // blocks, pool changes and global indices of the synchronizers
+  LANE_WALLET, // building and relaying transactions
+  LANE_QUERY,  // node status and the other queries
+  LANE_WAIT    // wait_for_changes
+};
+
+const std::vector<size_t> LANE_CONNECTIONS = { 2, 2, 2, 1 };
+
+const std::unordered_map<std::string, RequestLane> REQUEST_LANES = {
+  { "getblocks.bin", LANE_SYNC }, { "queryblockslite.bin", LANE_SYNC }, { "queryblocksfiltered.bin", LANE_SYNC },
+  { "getblockfilters.bin", LANE_SYNC },  { "get_pool_changes_lite.bin", LANE_SYNC },  { "get_o_indexes.bin", LANE_SYNC }, { "get_txs_o_indexes.bin", LANE_SYNC }, { "getrandom_outs.bin", LANE_WALLET }, { "sendrawtransaction", LANE_WALLET }
+};
+
+size_t requestLane(const std::string& command) {
+  auto it = REQUEST_LANES.find(command);
+  return it != REQUEST_LANES.end() ? it->second : LANE_QUERY;
+}
+
 std::error_code interpretResponseStatus(const std::string& status) {
   if (CORE_RPC_STATUS_BUSY == status) {
     return make_error_code(error::NODE_BUSY);
@@ -64,6 +89,35 @@ std::error_code interpretResponseStatus(const std::string& status) {
   return std::error_code();
 }
 
+std::error_code toShortEntries(std::vector<BlockShortInfo>& items, std::vector<BlockShortEntry>& newBlocks) {
+  for (auto& item: items) {
+    BlockShortEntry bse;
+    bse.hasBlock = false;
+
+    bse.blockHash = std::move(item.blockId);
+    if (!item.block.empty()) {
+      if (!fromBinaryArray(bse.block, asBinaryArray(item.block))) {
+        return std::make_error_code(std::errc::invalid_argument);
+      }
+
+      bse.hasBlock = true;
+    }
+
+    bse.baseTransactionGlobalIndexes = std::move(item.baseTransactionGlobalIndexes);
+    for (auto& txp: item.txPrefixes) {
+      TransactionShortInfo tsi;
+      tsi.txId = txp.txHash;
+      tsi.txPrefix = std::move(txp.txPrefix);
+      tsi.globalIndexes = std::move(txp.globalIndexes);
+      bse.txsShortInfo.push_back(std::move(tsi));
+    }
+
+    newBlocks.push_back(std::move(bse));
+  }
+
+  return std::error_code();
+}
+
 }
 
 NodeRpcProxy::NodeRpcProxy(const std::string& nodeHost, unsigned short nodePort, const std::string &daemon_path, const bool &daemon_ssl) :
@@ -90,7 +144,8 @@ NodeRpcProxy::NodeRpcProxy(const std::string& nodeHost, unsigned short nodePort,
     m_incConnectionsCount(0),
     m_rpcConnectionsCount(0),
     m_whitePeerlistSize(0),
-    m_greyPeerlistSize(0)
+    m_greyPeerlistSize(0),
+    m_batchOutsIndices(true)
 {
   resetInternalState();
 }
@@ -110,6 +165,15 @@ void NodeRpcProxy::disableVerify() {
   if (!m_daemon_no_verify) m_daemon_no_verify = true;
 }
 
+void NodeRpcProxy::setSyncFilter(const Crypto::SecretKey& viewSecretKey, const std::vector<Crypto::PublicKey>& spendPublicKeys,
+  const std::vector<std::pair<uint64_t, uint32_t>>& watchedOutputs) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_syncFilter = true;
+  m_filterViewKey = viewSecretKey;
+  m_filterSpendKeys = spendPublicKeys;
+  m_filterWatched.insert(watchedOutputs.begin(), watchedOutputs.end());
+}
+
 void NodeRpcProxy::resetInternalState() {
   m_stop = false;
   m_peerCount.store(0, std::memory_order_relaxed);
@@ -126,6 +190,10 @@ void NodeRpcProxy::resetInternalState() {
   lastLocalBlockHeaderInfo.difficulty = 0;
   lastLocalBlockHeaderInfo.reward = 0;
   m_knownTxs.clear();
+  // the SSL client blocks the dispatcher thread while it waits for a response
+  m_waitForChanges = !m_daemon_ssl;
+  m_waitTailBlockId = CryptoNote::NULL_HASH;
+  m_waitPoolModificationCounter = 0;
 }
 
 void NodeRpcProxy::init(const INode::Callback& callback) {
@@ -160,6 +228,8 @@ bool NodeRpcProxy::shutdown() {
 
   m_dispatcher->remoteSpawn([this]() {
     m_stop = true;
+    // wakes the status loop from a long poll or its timer
+    m_status_context->interrupt();
     // Run all spawned contexts
     m_dispatcher->yield();
   });
@@ -178,13 +248,12 @@ void NodeRpcProxy::workerThread(const INode::Callback& initialized_callback) {
     m_dispatcher = &dispatcher;
     ContextGroup contextGroup(dispatcher);
     m_context_group = &contextGroup;
-    HttpClient httpClient(dispatcher, m_nodeHost, m_nodePort, m_daemon_ssl);
-    m_httpClient = &httpClient;
-    if (!m_daemon_cert.empty()) m_httpClient->setRootCert(m_daemon_cert);
-    if (m_daemon_no_verify) m_httpClient->disableVerify();
-    Event httpEvent(dispatcher);
-    m_httpEvent = &httpEvent;
-    m_httpEvent->set();
+    ContextGroup statusContext(dispatcher);
+    m_status_context = &statusContext;
+    HttpClientPool httpPool(dispatcher, m_nodeHost, m_nodePort, m_daemon_ssl, LANE_CONNECTIONS);
+    m_httpPool = &httpPool;
+    if (!m_daemon_cert.empty()) m_httpPool->setRootCert(m_daemon_cert);
+    if (m_daemon_no_verify) m_httpPool->disableVerify();
 
     {
       std::lock_guard<std::mutex> lock(m_mutex);
@@ -195,16 +264,20 @@ void NodeRpcProxy::workerThread(const INode::Callback& initialized_callback) {
 
     initialized_callback(std::error_code());
 
-    contextGroup.spawn([this]() {
+    statusContext.spawn([this]() {
       Timer pullTimer(*m_dispatcher);
-      while (!m_stop) {
-        updateNodeStatus();
-        if (!m_stop) {
-          pullTimer.sleep(std::chrono::milliseconds(m_pullInterval));
+      try {
+        while (!m_stop) {
+          updateNodeStatus();
+          if (!m_stop && !waitForNodeChanges()) {
+            pullTimer.sleep(std::chrono::milliseconds(m_pullInterval));
+          }
         }
+      } catch (InterruptedException&) {
       }
     });
 
+    statusContext.wait();
     contextGroup.wait();
     // Make sure all remote spawns are executed
     m_dispatcher->yield();
@@ -213,8 +286,8 @@ void NodeRpcProxy::workerThread(const INode::Callback& initialized_callback) {
 
   m_dispatcher = nullptr;
   m_context_group = nullptr;
-  m_httpClient = nullptr;
-  m_httpEvent = nullptr;
+  m_status_context = nullptr;
+  m_httpPool = nullptr;
   m_connected = false;
   m_rpcProxyObserverManager.notify(&INodeRpcProxyObserver::connectionStatusUpdated, m_connected);
 }
@@ -228,6 +301,48 @@ void NodeRpcProxy::updateNodeStatus() {
   getFeeAddress(); // Get public node's fee info
 }
 
+// Long polls the daemon in a lane of its own, so that other requests aren't held up.
+// Returns false if nothing changed or the daemon can't be waited on, the caller then sleeps m_pullInterval.
+bool NodeRpcProxy::waitForNodeChanges() {
+  if (!m_waitForChanges) {
+    return false;
+  }
+
+  COMMAND_RPC_WAIT_FOR_CHANGES::request req;
+  req.tailBlockId = m_waitTailBlockId;
+  req.poolModificationCounter = m_waitPoolModificationCounter;
+  req.timeout = WAIT_FOR_CHANGES_TIMEOUT;
+  COMMAND_RPC_WAIT_FOR_CHANGES::response rsp = AUTO_VAL_INIT(rsp);
+
+  try {
+    HttpRequest httpReq;
+    HttpResponse httpRes;
+    httpReq.addHeader("Connection", "keep-alive");
+    httpReq.addHeader("Content-Type", "application/json");
+    httpReq.setUrl(m_daemon_path + "wait_for_changes");
+    httpReq.setBody(storeToJson(req));
+    m_httpPool->acquire(LANE_WAIT).client().request(httpReq, httpRes);
+
+    if (httpRes.getStatus() == HttpResponse::STATUS_404) {
+      // daemons before the call are polled
+      m_waitForChanges = false;
+      return false;
+    }
+
+    if (httpRes.getStatus() != HttpResponse::STATUS_200 || !loadFromJson(rsp, httpRes.getBody()) || interpretResponseStatus(rsp.status)) {
+      return false;
+    }
+  } catch (const InterruptedException&) {
+    throw;
+  } catch (const std::exception&) {
+    return false;
+  }
+
+  m_waitTailBlockId = rsp.tailBlockId;
+  m_waitPoolModificationCounter = rsp.poolModificationCounter;
+  return rsp.isTailBlockChanged || rsp.isPoolChanged;
+}
+
 bool NodeRpcProxy::updatePoolStatus() {
   std::vector<Crypto::Hash> knownTxs = getKnownTxsVector();
   Crypto::Hash tailBlock = lastLocalBlockHeaderInfo.hash;
@@ -321,8 +436,8 @@ void NodeRpcProxy::updateBlockchainStatus() {
     }
   }
 
-  if (m_connected != m_httpClient->isConnected()) {
-    m_connected = m_httpClient->isConnected();
+  if (m_connected != m_httpPool->isConnected()) {
+    m_connected = m_httpPool->isConnected();
     m_rpcProxyObserverManager.notify(&INodeRpcProxyObserver::connectionStatusUpdated, m_connected);
   }
 }
@@ -525,6 +640,18 @@ void NodeRpcProxy::getTransactionOutsGlobalIndices(const Crypto::Hash& transacti
     std::ref(outsGlobalIndices)), callback);
 }
 
+void NodeRpcProxy::getTransactionsOutsGlobalIndices(const std::vector<Crypto::Hash>& transactionHashes,
+                                                    std::vector<std::vector<uint32_t>>& outsGlobalIndices, const Callback& callback) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_state != STATE_INITIALIZED) {
+    callback(make_error_code(error::NOT_INITIALIZED));
+    return;
+  }
+
+  scheduleRequest(std::bind(&NodeRpcProxy::doGetTransactionsOutsGlobalIndices, this, transactionHashes,
+    std::ref(outsGlobalIndices)), callback);
+}
+
 void NodeRpcProxy::queryBlocks(std::vector<Crypto::Hash>&& knownBlockIds, uint64_t timestamp, std::vector<BlockShortEntry>& newBlocks,
   uint32_t& startHeight, const Callback& callback) {
   std::lock_guard<std::mutex> lock(m_mutex);
@@ -537,6 +664,18 @@ void NodeRpcProxy::queryBlocks(std::vector<Crypto::Hash>&& knownBlockIds, uint64
           std::ref(newBlocks), std::ref(startHeight)), callback);
 }
 
+void NodeRpcProxy::getBlockFilters(std::vector<Crypto::Hash>&& knownBlockIds, std::vector<BlockFilterEntry>& filters, uint32_t& startHeight,
+        const Callback& callback) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_state != STATE_INITIALIZED) {
+    callback(make_error_code(error::NOT_INITIALIZED));
+    return;
+  }
+
+  scheduleRequest(std::bind(&NodeRpcProxy::doGetBlockFilters, this, std::move(knownBlockIds), std::ref(filters),
+          std::ref(startHeight)), callback);
+}
+
 void NodeRpcProxy::getPoolSymmetricDifference(std::vector<Crypto::Hash>&& knownPoolTxIds, Crypto::Hash knownBlockId, bool& isBcActual,
         std::vector<std::unique_ptr<ITransactionReader>>& newTxs, std::vector<Crypto::Hash>& deletedTxIds, const Callback& callback) {
   std::lock_guard<std::mutex> lock(m_mutex);
@@ -621,6 +760,40 @@ std::error_code NodeRpcProxy::doGetBlockTimestamp(uint32_t height, uint64_t& tim
   return ec;
 }
 
+void NodeRpcProxy::getBlockHeightsByTimestamps(const std::vector<uint64_t>& timestamps, std::vector<uint32_t>& heights, const Callback& callback) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_state != STATE_INITIALIZED) {
+    callback(make_error_code(error::NOT_INITIALIZED));
+    return;
+  }
+
+  scheduleRequest(std::bind(&NodeRpcProxy::doGetBlockHeightsByTimestamps, this, timestamps, std::ref(heights)), callback);
+}
+
+std::error_code NodeRpcProxy::doGetBlockHeightsByTimestamps(const std::vector<uint64_t>& timestamps, std::vector<uint32_t>& heights) {
+  heights.clear();
+  heights.reserve(timestamps.size());
+  for (size_t begin = 0; begin < timestamps.size(); begin += TIMESTAMPS_HEIGHTS_MAX_COUNT) {
+    size_t end = std::min(timestamps.size(), begin + TIMESTAMPS_HEIGHTS_MAX_COUNT);
+    COMMAND_RPC_GET_HEIGHTS_BY_TIMESTAMPS::request req = AUTO_VAL_INIT(req);
+    COMMAND_RPC_GET_HEIGHTS_BY_TIMESTAMPS::response rsp = AUTO_VAL_INIT(rsp);
+    req.timestamps.assign(timestamps.begin() + begin, timestamps.begin() + end);
+
+    std::error_code ec = jsonRpcCommand("getheightsbytimestamps", req, rsp);
+    if (ec) {
+      return ec;
+    }
+
+    if (rsp.heights.size() != req.timestamps.size()) {
+      return make_error_code(error::INTERNAL_NODE_ERROR);
+    }
+
+    heights.insert(heights.end(), rsp.heights.begin(), rsp.heights.end());
+  }
+
+  return std::error_code();
+}
+
 void NodeRpcProxy::getConnections(std::vector<p2pConnection>& connections, const Callback& callback) {
   std::lock_guard<std::mutex> lock(m_mutex);
   if (m_state != STATE_INITIALIZED) {
@@ -769,42 +942,128 @@ std::error_code NodeRpcProxy::doGetTransactionOutsGlobalIndices(const Crypto::Ha
   return ec;
 }
 
+std::error_code NodeRpcProxy::doGetTransactionsOutsGlobalIndices(const std::vector<Crypto::Hash>& transactionHashes,
+                                                                 std::vector<std::vector<uint32_t>>& outsGlobalIndices) {
+  outsGlobalIndices.clear();
+  outsGlobalIndices.reserve(transactionHashes.size());
+
+  bool batchFailed = false;
+  for (size_t begin = 0; begin < transactionHashes.size() && m_batchOutsIndices; begin += TRANSACTIONS_OUTPUT_INDEXES_MAX_COUNT) {
+    size_t end = std::min(transactionHashes.size(), begin + TRANSACTIONS_OUTPUT_INDEXES_MAX_COUNT);
+    CryptoNote::COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES::request req = AUTO_VAL_INIT(req);
+    CryptoNote::COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES::response rsp = AUTO_VAL_INIT(rsp);
+    req.txids.assign(transactionHashes.begin() + begin, transactionHashes.begin() + end);
+
+    std::error_code ec = binaryCommand("get_txs_o_indexes.bin", req, rsp);
+    if (ec == make_error_code(error::NETWORK_ERROR) && begin == 0) {
+      // either an older daemon without the method or the connection is lost, the single queries tell which
+      batchFailed = true;
+      break;
+    }
+
+    if (ec) {
+      return ec;
+    }
+
+    if (rsp.indexes.size() != req.txids.size()) {
+      return make_error_code(error::INTERNAL_NODE_ERROR);
+    }
+
+    for (auto& indexes : rsp.indexes) {
+      outsGlobalIndices.push_back(std::move(indexes.o_indexes));
+    }
+  }
+
+  // the rest one transaction at a time
+  while (outsGlobalIndices.size() < transactionHashes.size()) {
+    std::vector<uint32_t> indexes;
+    std::error_code ec = doGetTransactionOutsGlobalIndices(transactionHashes[outsGlobalIndices.size()], indexes);
+    if (ec) {
+      return ec;
+    }
+
+    outsGlobalIndices.push_back(std::move(indexes));
+  }
+
+  if (batchFailed) {
+    m_batchOutsIndices = false;
+  }
+
+  return std::error_code();
+}
+
 std::error_code NodeRpcProxy::doQueryBlocksLite(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp,
         std::vector<CryptoNote::BlockShortEntry>& newBlocks, uint32_t& startHeight) {
+  CryptoNote::COMMAND_RPC_QUERY_BLOCKS_FILTERED::request filteredReq = AUTO_VAL_INIT(filteredReq);
+  bool filtered;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    filtered = m_syncFilter;
+    if (filtered) {
+      filteredReq.viewSecretKey = m_filterViewKey;
+      filteredReq.spendPublicKeys = m_filterSpendKeys;
+      for (const auto& output : m_filterWatched) {
+        filteredReq.watchedOutputs.push_back(OutputReference{ output.first, output.second });
+      }
+    }
+  }
+
+  if (filtered) {
+    CryptoNote::COMMAND_RPC_QUERY_BLOCKS_FILTERED::response rsp = AUTO_VAL_INIT(rsp);
+    filteredReq.blockIds = knownBlockIds;
+    filteredReq.timestamp = timestamp;
+
+    if (!binaryCommand("queryblocksfiltered.bin", filteredReq, rsp)) {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& output : rsp.foundOutputs) {
+          m_filterWatched.emplace(output.amount, output.globalIndex);
+        }
+      }
+
+      startHeight = static_cast<uint32_t>(rsp.startHeight);
+      return toShortEntries(rsp.items, newBlocks);
+    }
+  }
+
   CryptoNote::COMMAND_RPC_QUERY_BLOCKS_LITE::request req = AUTO_VAL_INIT(req);
   CryptoNote::COMMAND_RPC_QUERY_BLOCKS_LITE::response rsp = AUTO_VAL_INIT(rsp);
 
   req.blockIds = knownBlockIds;
   req.timestamp = timestamp;
+  req.needGlobalIndexes = true;
 
   std::error_code ec = binaryCommand("queryblockslite.bin", req, rsp);
   if (ec) {
     return ec;
   }
 
-  startHeight = static_cast<uint32_t>(rsp.startHeight);
+  if (filtered) {
+    // the daemon answers the lite query only, it is either older or public
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_syncFilter = false;
+  }
 
-  for (auto& item: rsp.items) {
-    BlockShortEntry bse;
-    bse.hasBlock = false;
+  startHeight = static_cast<uint32_t>(rsp.startHeight);
+  return toShortEntries(rsp.items, newBlocks);
+}
 
-    bse.blockHash = std::move(item.blockId);
-    if (!item.block.empty()) {
-      if (!fromBinaryArray(bse.block, asBinaryArray(item.block))) {
-        return std::make_error_code(std::errc::invalid_argument);
-      }
+std::error_code NodeRpcProxy::doGetBlockFilters(const std::vector<Crypto::Hash>& knownBlockIds, std::vector<BlockFilterEntry>& filters,
+        uint32_t& startHeight) {
+  CryptoNote::COMMAND_RPC_GET_BLOCK_FILTERS::request req = AUTO_VAL_INIT(req);
+  CryptoNote::COMMAND_RPC_GET_BLOCK_FILTERS::response rsp = AUTO_VAL_INIT(rsp);
 
-      bse.hasBlock = true;
-    }
+  req.blockIds = knownBlockIds;
+  req.count = static_cast<uint32_t>(BLOCK_FILTERS_MAX_COUNT);
 
-    for (const auto& txp: item.txPrefixes) {
-      TransactionShortInfo tsi;
-      tsi.txId = txp.txHash;
-      tsi.txPrefix = txp.txPrefix;
-      bse.txsShortInfo.push_back(std::move(tsi));
-    }
+  std::error_code ec = binaryCommand("getblockfilters.bin", req, rsp);
+  if (ec) {
+    return ec;
+  }
 
-    newBlocks.push_back(std::move(bse));
+  startHeight = rsp.startHeight;
+  for (auto& item : rsp.items) {
+    filters.push_back(BlockFilterEntry{ item.blockId, std::move(item.filter) });
   }
 
   return std::error_code();
@@ -970,8 +1229,8 @@ void NodeRpcProxy::scheduleRequest(std::function<std::error_code()>&& procedure,
           callback(std::make_error_code(std::errc::operation_canceled));
         } else {
           std::error_code ec = procedure();
-          if (m_connected != m_httpClient->isConnected()) {
-            m_connected = m_httpClient->isConnected();
+          if (m_connected != m_httpPool->isConnected()) {
+            m_connected = m_httpPool->isConnected();
             m_rpcProxyObserverManager.notify(&INodeRpcProxyObserver::connectionStatusUpdated, m_connected);
           }
           callback(m_stop ? std::make_error_code(std::errc::operation_canceled) : ec);
@@ -987,8 +1246,8 @@ std::error_code NodeRpcProxy::binaryCommand(const std::string& comm, const Reque
   std::string rpc_url = this->m_daemon_path + comm;
 
   try {
-    EventLock eventLock(*m_httpEvent);
-    invokeBinaryCommand(*m_httpClient, rpc_url, req, res);
+    HttpClientPool::Lease lease = m_httpPool->acquire(requestLane(comm));
+    invokeBinaryCommand(lease.client(), rpc_url, req, res);
     ec = interpretResponseStatus(res.status);
   } catch (const ConnectException&) {
     ec = make_error_code(error::CONNECT_ERROR);
@@ -1006,8 +1265,8 @@ std::error_code NodeRpcProxy::jsonCommand(const std::string& comm, const Request
   std::string rpc_url = this->m_daemon_path + comm;
 
   try {
-    EventLock eventLock(*m_httpEvent);
-    invokeJsonCommand(*m_httpClient, rpc_url, req, res);
+    HttpClientPool::Lease lease = m_httpPool->acquire(requestLane(comm));
+    invokeJsonCommand(lease.client(), rpc_url, req, res);
     ec = interpretResponseStatus(res.status);
   } catch (const ConnectException&) {
     ec = make_error_code(error::CONNECT_ERROR);
@@ -1023,7 +1282,7 @@ std::error_code NodeRpcProxy::jsonRpcCommand(const std::string& method, const Re
   std::error_code ec = make_error_code(error::INTERNAL_NODE_ERROR);
 
   try {
-    EventLock eventLock(*m_httpEvent);
+    HttpClientPool::Lease lease = m_httpPool->acquire(requestLane(method));
 
     JsonRpc::JsonRpcRequest jsReq;
 
@@ -1039,7 +1298,7 @@ std::error_code NodeRpcProxy::jsonRpcCommand(const std::string& method, const Re
     httpReq.setUrl(rpc_url);
     httpReq.setBody(jsReq.getBody());
 
-    m_httpClient->request(httpReq, httpRes);
+    lease.client().request(httpReq, httpRes);
 
     JsonRpc::JsonRpcResponse jsRes;
 
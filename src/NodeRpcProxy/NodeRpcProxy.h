@@ -21,6 +21,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <set>
 #include <string>
 #include <thread>
 #include <unordered_set>
@@ -38,7 +39,7 @@ namespace System {
 
 namespace CryptoNote {
 
-class HttpClient;
+class HttpClientPool;
 
 class INodeRpcProxyObserver {
 public:
@@ -86,7 +87,9 @@ public:
   virtual void getRandomOutsByAmounts(std::vector<uint64_t>&& amounts, uint64_t outsCount, std::vector<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount>& result, const Callback& callback) override;
   virtual void getNewBlocks(std::vector<Crypto::Hash>&& knownBlockIds, std::vector<CryptoNote::block_complete_entry>& newBlocks, uint32_t& startHeight, const Callback& callback) override;
   virtual void getTransactionOutsGlobalIndices(const Crypto::Hash& transactionHash, std::vector<uint32_t>& outsGlobalIndices, const Callback& callback) override;
+  virtual void getTransactionsOutsGlobalIndices(const std::vector<Crypto::Hash>& transactionHashes, std::vector<std::vector<uint32_t>>& outsGlobalIndices, const Callback& callback) override;
   virtual void queryBlocks(std::vector<Crypto::Hash>&& knownBlockIds, uint64_t timestamp, std::vector<BlockShortEntry>& newBlocks, uint32_t& startHeight, const Callback& callback) override;
+  virtual void getBlockFilters(std::vector<Crypto::Hash>&& knownBlockIds, std::vector<BlockFilterEntry>& filters, uint32_t& startHeight, const Callback& callback) override;
   virtual void getPoolSymmetricDifference(std::vector<Crypto::Hash>&& knownPoolTxIds, Crypto::Hash knownBlockId, bool& isBcActual,
           std::vector<std::unique_ptr<ITransactionReader>>& newTxs, std::vector<Crypto::Hash>& deletedTxIds, const Callback& callback) override;
   virtual void getMultisignatureOutputByGlobalIndex(uint64_t amount, uint32_t gindex, MultisignatureOutput& out, const Callback& callback) override;
@@ -99,6 +102,7 @@ public:
   virtual void getTransactionsByPaymentId(const Crypto::Hash& paymentId, std::vector<TransactionDetails>& transactions, const Callback& callback) override;
   virtual void getPoolTransactions(uint64_t timestampBegin, uint64_t timestampEnd, uint32_t transactionsNumberLimit, std::vector<TransactionDetails>& transactions, uint64_t& transactionsNumberWithinTimestamps, const Callback& callback) override;
   virtual void getBlockTimestamp(uint32_t height, uint64_t& timestamp, const Callback& callback) override;
+  virtual void getBlockHeightsByTimestamps(const std::vector<uint64_t>& timestamps, std::vector<uint32_t>& heights, const Callback& callback) override;
   virtual void isSynchronized(bool& syncStatus, const Callback& callback) override;
   virtual void getConnections(std::vector<p2pConnection>& connections, const Callback& callback) override;
 
@@ -116,6 +120,12 @@ public:
   virtual void setRootCert(const std::string &path) override;
   virtual void disableVerify() override;
 
+  // hands the view key over to the daemon, which then returns the wallet transactions only,
+  // watchedOutputs are the unspent outputs (amount, global index) whose spends must be found;
+  // meant for a trusted daemon of the wallet owner, others decline the query
+  void setSyncFilter(const Crypto::SecretKey& viewSecretKey, const std::vector<Crypto::PublicKey>& spendPublicKeys,
+    const std::vector<std::pair<uint64_t, uint32_t>>& watchedOutputs);
+
 private:
   void resetInternalState();
   void workerThread(const Callback& initialized_callback);
@@ -123,6 +133,7 @@ private:
   std::vector<Crypto::Hash> getKnownTxsVector() const;
   void pullNodeStatusAndScheduleTheNext();
   void updateNodeStatus();
+  bool waitForNodeChanges();
   void updateBlockchainStatus();
   bool updatePoolStatus();
   void updatePeerCount(size_t peerCount);
@@ -136,8 +147,11 @@ private:
     std::vector<CryptoNote::block_complete_entry>& newBlocks, uint32_t& startHeight);
   std::error_code doGetTransactionOutsGlobalIndices(const Crypto::Hash& transactionHash,
                                                     std::vector<uint32_t>& outsGlobalIndices);
+  std::error_code doGetTransactionsOutsGlobalIndices(const std::vector<Crypto::Hash>& transactionHashes,
+                                                     std::vector<std::vector<uint32_t>>& outsGlobalIndices);
   std::error_code doQueryBlocksLite(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp,
     std::vector<CryptoNote::BlockShortEntry>& newBlocks, uint32_t& startHeight);
+  std::error_code doGetBlockFilters(const std::vector<Crypto::Hash>& knownBlockIds, std::vector<BlockFilterEntry>& filters, uint32_t& startHeight);
   std::error_code doGetPoolSymmetricDifference(std::vector<Crypto::Hash>&& knownPoolTxIds, Crypto::Hash knownBlockId, bool& isBcActual,
           std::vector<std::unique_ptr<ITransactionReader>>& newTxs, std::vector<Crypto::Hash>& deletedTxIds);
   std::error_code doGetBlocksByHeight(const std::vector<uint32_t>& blockHeights, std::vector<std::vector<BlockDetails>>& blocks);
@@ -147,6 +161,7 @@ private:
   std::error_code doGetTransaction(const Crypto::Hash& transactionHash, CryptoNote::Transaction& transaction);
   std::error_code doGetTransactions(const std::vector<Crypto::Hash>& transactionHashes, std::vector<TransactionDetails>& transactions);
   std::error_code doGetBlockTimestamp(uint32_t height, uint64_t& timestamp);
+  std::error_code doGetBlockHeightsByTimestamps(const std::vector<uint64_t>& timestamps, std::vector<uint32_t>& heights);
   std::error_code doGetConnections(std::vector<p2pConnection>& connections);
 
   void scheduleRequest(std::function<std::error_code()>&& procedure, const Callback& callback);
@@ -170,14 +185,24 @@ private:
   std::thread m_workerThread;
   System::Dispatcher* m_dispatcher = nullptr;
   System::ContextGroup* m_context_group = nullptr;
+  System::ContextGroup* m_status_context = nullptr;
   Tools::ObserverManager<CryptoNote::INodeObserver> m_observerManager;
   Tools::ObserverManager<CryptoNote::INodeRpcProxyObserver> m_rpcProxyObserverManager;
 
   unsigned int m_rpcTimeout;
-  HttpClient* m_httpClient = nullptr;
-  System::Event* m_httpEvent = nullptr;
+  HttpClientPool* m_httpPool = nullptr;
 
   uint64_t m_pullInterval;
+  // the daemon answers /wait_for_changes, status updates follow its changes instead of m_pullInterval
+  bool m_waitForChanges;
+  Crypto::Hash m_waitTailBlockId;
+  uint64_t m_waitPoolModificationCounter;
+
+  // blocks are queried with queryblocksfiltered.bin while set, guarded by m_mutex
+  bool m_syncFilter = false;
+  Crypto::SecretKey m_filterViewKey;
+  std::vector<Crypto::PublicKey> m_filterSpendKeys;
+  std::set<std::pair<uint64_t, uint32_t>> m_filterWatched;
 
   // Internal state
   bool m_stop = false;
@@ -196,6 +221,8 @@ private:
   std::atomic<uint64_t> m_rpcConnectionsCount;
   std::atomic<uint64_t> m_whitePeerlistSize;
   std::atomic<uint64_t> m_greyPeerlistSize;
+  // cleared when the daemon does not know get_txs_o_indexes.bin, the indices are then asked per transaction
+  std::atomic<bool> m_batchOutsIndices;
   std::string m_nodeVersion = "";
 
   BlockHeaderInfo lastLocalBlockHeaderInfo;
@@ -44,7 +44,7 @@ using namespace PaymentService;
 const uint64_t DEFAULT_THRESHOLD = UINT64_C(100000000000000);
 
 namespace {
-  const command_line::arg_descriptor<std::string> arg_address   = {"address", "Address of the wallet to optimize inputs. If not provided, all addresses will be checked and, if applicable, optimized using polling interval between each interaction. Default: All", "", true};
+  const command_line::arg_descriptor<std::string> arg_address   = {"address", "Address of the wallet to optimize inputs. If not provided, walletd optimizes all addresses by itself, or if it does not support it, all addresses will be checked and, if applicable, optimized using polling interval between each interaction. Default: All", "", true};
   const command_line::arg_descriptor<std::string> arg_ip        = {"walletd-ip", "IP address of walletd. Default: 127.0.0.1", "127.0.0.1"};
   const command_line::arg_descriptor<uint16_t>    arg_rpc_port  = {"walletd-port", "RPC port of walletd. Default: 8070", 8070};
   const command_line::arg_descriptor<std::string> arg_user      = {"walletd-user", "RPC user. Default: none", "", true};
@@ -242,6 +242,114 @@ void processWallets(po::variables_map& vm, std::vector<std::string>& containerAd
   return;
 }
 
+// Lets walletd send the fusion transactions of all addresses itself as their outputs unlock,
+// returns false if walletd does not support it
+bool runWalletdFusion(po::variables_map& vm, const std::chrono::time_point<std::chrono::steady_clock>& start) {
+  uint64_t threshold = DEFAULT_THRESHOLD;
+  uint16_t anonymity = 6;
+  uint16_t timeInterval = 5;
+  int32_t maxDuration = 0;
+  if (command_line::has_arg(vm, arg_threshold)) {
+    threshold = command_line::get_arg(vm, arg_threshold);
+  }
+  if (command_line::has_arg(vm, arg_anonimity)) {
+    anonymity = command_line::get_arg(vm, arg_anonimity);
+  }
+  if (command_line::has_arg(vm, arg_interval)) {
+    timeInterval = command_line::get_arg(vm, arg_interval);
+    if (timeInterval > 120) timeInterval = 120;
+    if (timeInterval < 1) timeInterval = 1;
+  }
+  if (command_line::has_arg(vm, arg_duration)) {
+    maxDuration = command_line::get_arg(vm, arg_duration);
+  }
+
+  PaymentService::StartFusion::Request req;
+  PaymentService::StartFusion::Response res;
+  req.threshold = threshold;
+  req.anonymity = anonymity;
+
+  try {
+    HttpClient httpClient(dispatcher, command_line::get_arg(vm, arg_ip), command_line::get_arg(vm, arg_rpc_port), false);
+    if (command_line::has_arg(vm, arg_user) && command_line::has_arg(vm, arg_pass)) {
+      JsonRpc::invokeJsonRpcCommand(httpClient, "startFusion", req, res, command_line::get_arg(vm, arg_user), command_line::get_arg(vm, arg_pass));
+    }
+    else {
+      JsonRpc::invokeJsonRpcCommand(httpClient, "startFusion", req, res);
+    }
+  }
+  catch (const JsonRpc::JsonRpcError& e) {
+    if (e.code == JsonRpc::errMethodNotFound) {
+      logger(INFO, YELLOW) << "walletd can't optimize by itself, optimizing address by address." << ENDL;
+      return false;
+    }
+
+    logger((Logging::Level) ERROR, RED) << "Failed to start optimizing: " << e.what() << ENDL;
+    return true;
+  }
+  catch (const std::exception& e) {
+    logger((Logging::Level) ERROR, RED) << "Failed to connect to walletd: " << e.what() << ENDL;
+    return true;
+  }
+
+  logger(INFO, GREEN) << "walletd is optimizing all wallets." << ENDL;
+  PaymentService::GetFusionStatus::Response status;
+  for (;;) {
+    std::this_thread::sleep_for(std::chrono::seconds(timeInterval));
+
+    PaymentService::GetFusionStatus::Request statusReq;
+    try {
+      HttpClient httpClient(dispatcher, command_line::get_arg(vm, arg_ip), command_line::get_arg(vm, arg_rpc_port), false);
+      if (command_line::has_arg(vm, arg_user) && command_line::has_arg(vm, arg_pass)) {
+        JsonRpc::invokeJsonRpcCommand(httpClient, "getFusionStatus", statusReq, status, command_line::get_arg(vm, arg_user), command_line::get_arg(vm, arg_pass));
+      }
+      else {
+        JsonRpc::invokeJsonRpcCommand(httpClient, "getFusionStatus", statusReq, status);
+      }
+    }
+    catch (const std::exception& e) {
+      logger((Logging::Level) ERROR, RED) << "Failed to connect to walletd: " << e.what() << ENDL;
+      return true;
+    }
+
+    logger(INFO, GREEN) << "Fusion transactions sent: " << status.transactionCount << ", outputs left to optimize: " << status.fusionReadyCount << ENDL;
+    if (!status.isActive) {
+      break;
+    }
+
+    if (maxDuration > 0) {
+      auto dur = std::chrono::steady_clock::now() - start;
+      if (std::chrono::duration_cast<std::chrono::minutes>(dur).count() >= maxDuration) {
+        logger(INFO, GREEN) << "Maximum duration time reached." << ENDL;
+
+        PaymentService::StopFusion::Request stopReq;
+        PaymentService::StopFusion::Response stopRes;
+        try {
+          HttpClient httpClient(dispatcher, command_line::get_arg(vm, arg_ip), command_line::get_arg(vm, arg_rpc_port), false);
+          if (command_line::has_arg(vm, arg_user) && command_line::has_arg(vm, arg_pass)) {
+            JsonRpc::invokeJsonRpcCommand(httpClient, "stopFusion", stopReq, stopRes, command_line::get_arg(vm, arg_user), command_line::get_arg(vm, arg_pass));
+          }
+          else {
+            JsonRpc::invokeJsonRpcCommand(httpClient, "stopFusion", stopReq, stopRes);
+          }
+        }
+        catch (const std::exception& e) {
+          logger((Logging::Level) ERROR, RED) << "Failed to stop optimizing: " << e.what() << ENDL;
+        }
+        break;
+      }
+    }
+  }
+
+  auto dur = std::chrono::steady_clock::now() - start;
+  std::cout   << "============== SUMMARY =============" << ENDL;
+  std::cout   << "   Fusion transactions sent : " << status.transactionCount << ENDL;
+  std::cout   << "   Outputs left to optimize : " << status.fusionReadyCount << ENDL;
+  std::cout   << "   Processing time (sec)    : " << std::chrono::duration_cast<std::chrono::seconds>(dur).count() << ENDL;
+  std::cout   << "====================================" << ENDL;
+  return true;
+}
+
 bool canConnect(po::variables_map& vm) {
 
   PaymentService::GetStatus::Request req;
@@ -267,6 +375,10 @@ bool canConnect(po::variables_map& vm) {
 bool run_optimizer(po::variables_map& vm) {
   if (canConnect(vm)) {
     std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+    if (!command_line::has_arg(vm, arg_address) && !command_line::has_arg(vm, arg_preview) && runWalletdFusion(vm, start)) {
+      return true;
+    }
+
     std::vector<std::string> addresses = getWalletsAddresses(vm);
     if (command_line::has_arg(vm, arg_address)) {
       logger(INFO, YELLOW) << "Starting optimizing." << ENDL;
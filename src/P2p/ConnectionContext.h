@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include <chrono>
+#include <deque>
 #include <list>
 #include <ostream>
 #include <unordered_set>
@@ -28,7 +30,9 @@
 
 #include "Common/StringTools.h"
 #include "crypto/hash.h"
+#include "CryptoNoteConfig.h"
 #include "P2p/PendingLiteBlock.h"
+#include "P2p/RollingBloomFilter.h"
 
 namespace CryptoNote {
 
@@ -52,10 +56,26 @@ struct CryptoNoteConnectionContext {
 
   state m_state = state_befor_handshake;
   boost::optional<PendingLiteBlock> m_pending_lite_block;
+  boost::optional<PendingCompactBlock> m_pending_compact_block;
+  std::vector<Crypto::Hash> m_unverified_block_ids;   // chain entry waiting for its headers
   std::list<Crypto::Hash> m_needed_objects;
   std::unordered_set<Crypto::Hash> m_requested_objects;
+  // block count and send time of every NOTIFY_REQUEST_GET_OBJECTS in flight, oldest first
+  std::deque<std::pair<size_t, std::chrono::steady_clock::time_point>> m_requested_chunks;
+  std::chrono::steady_clock::time_point m_last_objects_response_time;
+  size_t m_sync_chunk_size = BLOCKS_SYNCHRONIZING_DEFAULT_COUNT;
+  // peer quality the sync peers are picked by, the averages are 0 until measured
+  std::chrono::microseconds m_round_trip_time{0};   // smoothed over the timed syncs
+  uint64_t m_download_speed = 0;                    // bytes per second of NOTIFY_RESPONSE_GET_OBJECTS, smoothed
+  uint32_t m_invalid_responses = 0;
+  uint32_t m_slow_sync_checks = 0;                  // consecutive checks that found the peer too slow
   uint32_t m_remote_blockchain_height = 0;
   uint32_t m_last_response_height = 0;
+  uint64_t m_recv_cnt = 0;               // bytes
+  uint64_t m_send_cnt = 0;
+  time_t m_last_recv = 0;
+  time_t m_last_send = 0;
+  RollingBloomFilter m_known_objects;    // hashes of the blocks and transactions the peer sent us or we sent it
 };
 
 inline std::string get_protocol_state_string(CryptoNoteConnectionContext::state s) {
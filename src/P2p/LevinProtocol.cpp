@@ -16,7 +16,10 @@
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "LevinProtocol.h"
+#include <algorithm>
+#include <string>
 #include <System/TcpConnection.h>
+#include "Common/AllocationProfiler.h"
 
 using namespace CryptoNote;
 
@@ -27,6 +30,7 @@ const uint32_t LEVIN_PACKET_REQUEST = 0x00000001;
 const uint32_t LEVIN_PACKET_RESPONSE = 0x00000002;
 const uint32_t LEVIN_DEFAULT_MAX_PACKET_SIZE = 100000000;      //100MB by default
 const uint32_t LEVIN_PROTOCOL_VER_1 = 1;
+const size_t LEVIN_READ_CHUNK_SIZE = 1024 * 1024;              // the payload buffer grows by it as the data comes
 
 #pragma pack(push)
 #pragma pack(1)
@@ -60,18 +64,14 @@ void LevinProtocol::sendMessage(uint32_t command, const BinaryArray& out, bool n
   head.m_protocol_version = LEVIN_PROTOCOL_VER_1;
   head.m_flags = LEVIN_PACKET_REQUEST;
 
-  // write header and body in one operation
-  BinaryArray writeBuffer;
-  writeBuffer.reserve(sizeof(head) + out.size());
-
-  Common::VectorOutputStream stream(writeBuffer);
-  stream.writeSome(&head, sizeof(head));
-  stream.writeSome(out.data(), out.size());
-
-  writeStrict(writeBuffer.data(), writeBuffer.size());
+  writeMessage(&head, sizeof(head), out);
 }
 
 bool LevinProtocol::readCommand(Command& cmd) {
+  return readCommand(cmd, nullptr);
+}
+
+bool LevinProtocol::readCommand(Command& cmd, const std::function<uint64_t(const Command&)>& maxSize) {
   bucket_head2 head = { 0 };
 
   if (!readStrict(reinterpret_cast<uint8_t*>(&head), sizeof(head))) {
@@ -82,24 +82,38 @@ bool LevinProtocol::readCommand(Command& cmd) {
     throw std::runtime_error("Levin signature mismatch");
   }
 
-  if (head.m_cb > LEVIN_DEFAULT_MAX_PACKET_SIZE) {
-    throw std::runtime_error("Levin packet size is too big");
+  cmd.command = head.m_command;
+  cmd.isNotify = !head.m_have_to_return_data;
+  cmd.isResponse = (head.m_flags & LEVIN_PACKET_RESPONSE) == LEVIN_PACKET_RESPONSE;
+  cmd.buf.clear();
+
+  uint64_t limit = maxSize ? maxSize(cmd) : 0;
+  if (limit == 0 || limit > LEVIN_DEFAULT_MAX_PACKET_SIZE) {
+    limit = LEVIN_DEFAULT_MAX_PACKET_SIZE;
+  }
+
+  if (head.m_cb > limit) {
+    throw std::runtime_error("Levin packet size " + std::to_string(head.m_cb) + " of command " + std::to_string(head.m_command) +
+      " is too big, " + std::to_string(limit) + " bytes allowed");
   }
 
+  // memory is taken as the data arrives, not as much as the header claims up front
   BinaryArray buf;
+  size_t size = static_cast<size_t>(head.m_cb);
+  while (buf.size() < size) {
+    size_t offset = buf.size();
+    {
+      // not around the read, which switches to other contexts
+      Common::AllocationScope allocationScope(Common::AllocationSubsystem::P2p);
+      buf.resize(offset + std::min(size - offset, std::max(offset, LEVIN_READ_CHUNK_SIZE)));
+    }
 
-  if (head.m_cb != 0) {
-    buf.resize(head.m_cb);
-    if (!readStrict(&buf[0], head.m_cb)) {
+    if (!readStrict(&buf[offset], buf.size() - offset)) {
       return false;
     }
   }
 
-  cmd.command = head.m_command;
   cmd.buf = std::move(buf);
-  cmd.isNotify = !head.m_have_to_return_data;
-  cmd.isResponse = (head.m_flags & LEVIN_PACKET_RESPONSE) == LEVIN_PACKET_RESPONSE;
-
   return true;
 }
 
@@ -113,20 +127,59 @@ void LevinProtocol::sendReply(uint32_t command, const BinaryArray& out, int32_t
   head.m_flags = LEVIN_PACKET_RESPONSE;
   head.m_return_code = returnCode;
 
-  BinaryArray writeBuffer;
-  writeBuffer.reserve(sizeof(head) + out.size());
+  writeMessage(&head, sizeof(head), out);
+}
 
-  Common::VectorOutputStream stream(writeBuffer);
-  stream.writeSome(&head, sizeof(head));
-  stream.writeSome(out.data(), out.size());
+void LevinProtocol::sendMessages(const std::vector<Message>& messages) {
+  std::vector<bucket_head2> heads(messages.size());
+  std::vector<std::pair<const uint8_t*, size_t>> buffers;
+  buffers.reserve(messages.size() * 2);
+
+  for (size_t i = 0; i < messages.size(); ++i) {
+    const Message& msg = messages[i];
+    bucket_head2& head = heads[i];
+    head.m_signature = LEVIN_SIGNATURE;
+    head.m_cb = msg.body->size();
+    head.m_have_to_return_data = msg.isReply ? false : msg.needResponse;
+    head.m_command = msg.command;
+    head.m_protocol_version = LEVIN_PROTOCOL_VER_1;
+    head.m_flags = msg.isReply ? LEVIN_PACKET_RESPONSE : LEVIN_PACKET_REQUEST;
+    head.m_return_code = msg.isReply ? msg.returnCode : 0;
+
+    buffers.push_back(std::make_pair(reinterpret_cast<const uint8_t*>(&head), sizeof(head)));
+    if (!msg.body->empty()) {
+      buffers.push_back(std::make_pair(msg.body->data(), msg.body->size()));
+    }
+  }
 
-  writeStrict(writeBuffer.data(), writeBuffer.size());
+  if (!buffers.empty()) {
+    writeStrict(buffers.data(), buffers.size());
+  }
 }
 
-void LevinProtocol::writeStrict(const uint8_t* ptr, size_t size) {
-  size_t offset = 0;
-  while (offset < size) {
-    offset += m_conn.write(ptr + offset, size - offset);
+void LevinProtocol::writeMessage(const void* head, size_t headSize, const BinaryArray& body) {
+  // header and body go out in one operation straight from where they are
+  std::pair<const uint8_t*, size_t> buffers[] = {
+    { static_cast<const uint8_t*>(head), headSize },
+    { body.data(), body.size() }
+  };
+
+  writeStrict(buffers, body.empty() ? 1 : 2);
+}
+
+void LevinProtocol::writeStrict(std::pair<const uint8_t*, size_t>* buffers, size_t count) {
+  while (count > 0) {
+    size_t transferred = m_conn.writev(buffers, count);
+    while (count > 0 && transferred >= buffers->second) {
+      transferred -= buffers->second;
+      ++buffers;
+      --count;
+    }
+
+    if (count > 0) {
+      buffers->first += transferred;
+      buffers->second -= transferred;
+    }
   }
 }
 
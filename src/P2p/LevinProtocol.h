@@ -17,10 +17,12 @@
 
 #pragma once
 
+#include <functional>
+
 #include "CryptoNote.h"
 #include <Common/MemoryInputStream.h>
 #include <Common/VectorOutputStream.h>
-#include "Serialization/KVBinaryInputStreamSerializer.h"
+#include "Serialization/KVBinaryInputBufferSerializer.h"
 #include "Serialization/KVBinaryOutputStreamSerializer.h"
 
 namespace System {
@@ -47,14 +49,14 @@ public:
 
   LevinProtocol(System::TcpConnection& connection);
 
+  // Blocking round trip for connections nobody else reads from yet, like a handshake. Once a
+  // connection has a reader loop, requests go through P2pConnectionContext::pushInvoke instead.
   template <typename Request, typename Response>
   bool invoke(uint32_t command, const Request& request, Response& response) {
     sendMessage(command, encode(request), true);
 
     Command cmd;
-    readCommand(cmd);
-
-    if (!cmd.isResponse) {
+    if (!readCommand(cmd) || !cmd.isResponse || cmd.command != command) {
       return false;
     }
 
@@ -76,15 +78,28 @@ public:
   };
 
   bool readCommand(Command& cmd);
+  // maxSize gets the command with its header fields set and returns the largest payload accepted
+  // for it, 0 for the protocol limit; bigger messages are rejected before their payload is read
+  bool readCommand(Command& cmd, const std::function<uint64_t(const Command&)>& maxSize);
 
   void sendMessage(uint32_t command, const BinaryArray& out, bool needResponse);
   void sendReply(uint32_t command, const BinaryArray& out, int32_t returnCode);
 
+  struct Message {
+    uint32_t command;
+    const BinaryArray* body;
+    bool isReply;
+    bool needResponse;
+    int32_t returnCode;
+  };
+
+  // frames all the messages and hands them to the socket in one gathered write
+  void sendMessages(const std::vector<Message>& messages);
+
   template <typename T>
   static bool decode(const BinaryArray& buf, T& value) {
     try {
-      Common::MemoryInputStream stream(buf.data(), buf.size());
-      KVBinaryInputStreamSerializer serializer(stream);
+      KVBinaryInputBufferSerializer serializer(buf.data(), buf.size());
       serialize(value, serializer);
     } catch (std::exception&) {
       return false;
@@ -106,7 +121,8 @@ public:
 private:
 
   bool readStrict(uint8_t* ptr, size_t size);
-  void writeStrict(const uint8_t* ptr, size_t size);
+  void writeMessage(const void* head, size_t headSize, const BinaryArray& body);
+  void writeStrict(std::pair<const uint8_t*, size_t>* buffers, size_t count);
   System::TcpConnection& m_conn;
 };
 
@@ -26,8 +26,10 @@
 #include <chrono>
 #include <fstream>
 #include <future>
+#include <limits>
 #include <thread>
 
+#include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
 #include <boost/uuid/random_generator.hpp>
 #include <boost/uuid/uuid_io.hpp>
@@ -43,12 +45,16 @@
 #include <System/InterruptedException.h>
 #include <System/Ipv4Address.h>
 #include <System/Ipv4Resolver.h>
+#include <System/RemoteContext.h>
 #include <System/TcpListener.h>
 #include <System/TcpConnector.h>
  
 #include "version.h"
+#include "Common/Metrics.h"
 #include "Common/StdInputStream.h"
 #include "Common/StdOutputStream.h"
+#include "Common/StringOutputStream.h"
+#include "Common/Tracing.h"
 #include "Common/Util.h"
 #include "crypto/crypto.h"
 #include "crypto/random.h"
@@ -68,9 +74,21 @@ using namespace Logging;
 using namespace CryptoNote;
 
 const int64_t LAST_SEEN_EVICT_THRESHOLD = 3600 * 24 * 10; // 10 days before removing from gray list
+const size_t MAX_PARALLEL_DIALS = 8;
+const std::chrono::milliseconds DIAL_STAGGER(250);           // between the starts of parallel connection attempts
+const time_t DIAL_BACKOFF_BASE = 60;                         // seconds a peer is put off after a failed attempt, doubled for each next one
+const time_t DIAL_BACKOFF_MAX = 3600;
+const time_t DIAL_STATS_LIFETIME = 3600 * 24;
+const uint64_t PEERLIST_RESEND_AGE = 3600;                   // seconds a peer has to be seen later than sent to be sent again
+const uint64_t P2P_COMMAND_MAX_SIZE = 1024 * 1024;           // handshakes, timed syncs and pings, and anything before the handshake
+const std::chrono::milliseconds UPLOAD_THROTTLE_SLICE(100);
 
 namespace {
 
+uint64_t addressKey(uint32_t ip, uint32_t port) {
+  return (static_cast<uint64_t>(ip) << 32) | port;
+}
+
 size_t get_random_index_with_fixed_probability(size_t max_index) {
   //divide by zero workaround
   if (!max_index)
@@ -162,6 +180,31 @@ namespace CryptoNote
   }
 
 
+  //-----------------------------------------------------------------------------------
+  // P2pMessage implementation
+  //-----------------------------------------------------------------------------------
+
+  P2pMessage::Priority P2pMessage::priority() const {
+    if (type != NOTIFY) {
+      // handshakes, timed syncs and pings are small and time-critical
+      return PRIORITY_BLOCKS;
+    }
+
+    switch (command) {
+    case NOTIFY_NEW_BLOCK::ID:
+    case NOTIFY_NEW_LITE_BLOCK::ID:
+    case NOTIFY_NEW_COMPACT_BLOCK::ID:
+    case NOTIFY_MISSING_TXS::ID:
+    case NOTIFY_REQUEST_COMPACT_TXS::ID:
+      return PRIORITY_BLOCKS;
+    case NOTIFY_RESPONSE_GET_OBJECTS::ID:
+    case NOTIFY_RESPONSE_CHAIN_ENTRY::ID:
+      return PRIORITY_SYNC;
+    default:
+      return PRIORITY_TRANSACTIONS;
+    }
+  }
+
   //-----------------------------------------------------------------------------------
   // P2pConnectionContext implementation
   //-----------------------------------------------------------------------------------
@@ -175,26 +218,116 @@ namespace CryptoNote
       return false;
     }
 
-    writeQueue.push_back(std::move(msg));
+    P2pMessage::Priority priority = msg.priority();
+    writeQueues[priority].push_back(std::move(msg));
     queueEvent.set();
     return true;
   }
 
-  std::vector<P2pMessage> P2pConnectionContext::popBuffer() {
+  bool P2pConnectionContext::pushInvoke(P2pMessage&& msg, ResponseHandler&& handler) {
+    assert(msg.type == P2pMessage::COMMAND);
+    uint32_t command = msg.command;
+    if (!pushMessage(std::move(msg))) {
+      return false;
+    }
+
+    pendingResponses[command].push_back(std::move(handler));
+    return true;
+  }
+
+  bool P2pConnectionContext::dispatchResponse(uint32_t command, const BinaryArray& response) {
+    auto it = pendingResponses.find(command);
+    if (it == pendingResponses.end()) {
+      logger(DEBUGGING) << *this << "Unexpected response to command " << command << ", ignored";
+      return true;
+    }
+
+    ResponseHandler handler = std::move(it->second.front());
+    it->second.pop_front();
+    if (it->second.empty()) {
+      pendingResponses.erase(it);
+    }
+
+    return handler(*this, &response);
+  }
+
+  void P2pConnectionContext::cancelInvokes() {
+    auto pending = std::move(pendingResponses);
+    pendingResponses.clear();
+    for (auto& command : pending) {
+      for (auto& handler : command.second) {
+        handler(*this, nullptr);
+      }
+    }
+  }
+
+  void P2pConnectionContext::waitForMessages() {
     writeOperationStartTime = TimePoint();
 
-    while (writeQueue.empty() && !stopped) {
+    while (writeQueueEmpty() && !stopped) {
       queueEvent.wait();
     }
+  }
+
+  bool P2pConnectionContext::hasOnlySyncMessages() const {
+    for (size_t i = 0; i < P2pMessage::PRIORITY_SYNC; ++i) {
+      if (!writeQueues[i].empty()) {
+        return false;
+      }
+    }
+
+    return !writeQueues[P2pMessage::PRIORITY_SYNC].empty();
+  }
+
+  std::vector<P2pMessage> P2pConnectionContext::popBuffer() {
+    waitForMessages();
+
+    // Take messages in priority order until the batch reaches the high-water
+    // mark, so a block announced while a peer is being fed bulk sync data waits
+    // for at most one batch instead of the whole backlog.
+    std::vector<P2pMessage> msgs;
+    size_t batchSize = 0;
+    for (size_t priority = 0; priority < P2pMessage::PRIORITY_COUNT; ++priority) {
+      auto& queue = writeQueues[priority];
+      // sync responses are rate limited separately, never batch them with relayed data
+      if (priority == P2pMessage::PRIORITY_SYNC && !msgs.empty()) {
+        break;
+      }
 
-    std::vector<P2pMessage> msgs(std::move(writeQueue));
-    writeQueue.clear();
-    writeQueueSize = 0;
+      while (!queue.empty()) {
+        if (!msgs.empty() && batchSize + queue.front().size() > P2P_CONNECTION_WRITE_HIGH_WATER_MARK) {
+          break;
+        }
+
+        batchSize += queue.front().size();
+        msgs.push_back(std::move(queue.front()));
+        queue.pop_front();
+      }
+
+      if (!queue.empty()) {
+        break;
+      }
+    }
+
+    writeQueueSize -= batchSize;
     writeOperationStartTime = Clock::now();
-    queueEvent.clear();
+    if (writeQueueEmpty()) {
+      queueEvent.clear();
+    }
+
     return msgs;
   }
 
+  bool P2pConnectionContext::writeQueueEmpty() const {
+    for (const auto& queue : writeQueues) {
+      if (!queue.empty()) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
   uint64_t P2pConnectionContext::writeDuration(TimePoint now) const { // in milliseconds
     return writeOperationStartTime == TimePoint() ? 0 : std::chrono::duration_cast<std::chrono::milliseconds>(now - writeOperationStartTime).count();
   }
@@ -232,6 +365,8 @@ namespace CryptoNote
     m_payload_handler(payload_handler),
     m_allow_local_ip(false),
     m_hide_my_port(false),
+    m_syncUploadLimitPerPeer(0),
+    m_relayUploadLimitPerPeer(0),
     m_network_id(BYTECOIN_NETWORK),
     logger(log, "node_server"),
     m_stopEvent(m_dispatcher),
@@ -261,12 +396,14 @@ namespace CryptoNote
 
 #define INVOKE_HANDLER(CMD, Handler) case CMD::ID: { ret = invokeAdaptor<CMD>(cmd.buf, out, ctx,  boost::bind(Handler, this, boost::arg<1>(), boost::arg<2>(), boost::arg<3>(), boost::arg<4>())); break; }
 
-  int NodeServer::handleCommand(const LevinProtocol::Command& cmd, BinaryArray& out, P2pConnectionContext& ctx, bool& handled) {
+  int NodeServer::handleCommand(LevinProtocol::Command& cmd, BinaryArray& out, P2pConnectionContext& ctx, bool& handled) {
+    TraceSpan span("p2p", "command");
+    span.setId(cmd.command);
     int ret = 0;
     handled = true;
 
-    if (cmd.isResponse && cmd.command == COMMAND_TIMED_SYNC::ID) {
-      if (!handleTimedSyncResponse(cmd.buf, ctx)) {
+    if (cmd.isResponse) {
+      if (!ctx.dispatchResponse(cmd.command, cmd.buf)) {
         // invalid response, close connection
         ctx.m_state = CryptoNoteConnectionContext::state_shutdown;
       }
@@ -293,6 +430,14 @@ namespace CryptoNote
 
 #undef INVOKE_HANDLER
 
+  uint64_t NodeServer::getMaxMessageSize(const LevinProtocol::Command& cmd, const P2pConnectionContext& ctx) const {
+    if (cmd.command == COMMAND_HANDSHAKE::ID || cmd.command == COMMAND_TIMED_SYNC::ID || cmd.command == COMMAND_PING::ID || !ctx.peerId) {
+      return P2P_COMMAND_MAX_SIZE;
+    }
+
+    return m_payload_handler.getMaxMessageSize(cmd.command, ctx);
+  }
+
   //-----------------------------------------------------------------------------------
   
   bool NodeServer::init_config() {
@@ -345,21 +490,29 @@ namespace CryptoNote
 
   //----------------------------------------------------------------------------------- 
   void NodeServer::externalRelayNotifyToAll(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection) {
-    m_dispatcher.remoteSpawn([this, command, data_buff, excludeConnection] {
-      relay_notify_to_all(command, data_buff, excludeConnection);
+    auto buffer = std::make_shared<const BinaryArray>(data_buff);
+    net_connection_id excludeId = excludeConnection ? *excludeConnection : boost::value_initialized<net_connection_id>();
+    m_dispatcher.remoteSpawn([this, command, buffer, excludeId] {
+      relayNotifyToAll(command, buffer, excludeId);
     });
   }
 
   //----------------------------------------------------------------------------------- 
   void NodeServer::externalRelayNotifyToList(int command, const BinaryArray &data_buff, const std::list<boost::uuids::uuid> relayList) {
-    m_dispatcher.remoteSpawn([this, command, data_buff, relayList] {
-      forEachConnection([&](P2pConnectionContext &conn) {
-        if (std::find(relayList.begin(), relayList.end(), conn.m_connection_id) != relayList.end()) {
-          if (conn.peerId && (conn.m_state == CryptoNoteConnectionContext::state_normal || conn.m_state == CryptoNoteConnectionContext::state_synchronizing)) {
-            conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, data_buff));
-          }
+    auto buffer = std::make_shared<const BinaryArray>(data_buff);
+    m_dispatcher.remoteSpawn([this, command, buffer, relayList] {
+      // in the order of the list, the connections that come first are written to first
+      for (const auto& id : relayList) {
+        auto it = m_connections.find(id);
+        if (it == m_connections.end()) {
+          continue;
         }
-      });
+
+        P2pConnectionContext& conn = it->second;
+        if (conn.peerId && (conn.m_state == CryptoNoteConnectionContext::state_normal || conn.m_state == CryptoNoteConnectionContext::state_synchronizing)) {
+          conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, buffer));
+        }
+      }
     });
   }
 
@@ -491,6 +644,11 @@ namespace CryptoNote
 
     m_hide_my_port = config.getHideMyPort();
 
+    m_syncUploadLimit = TokenBucket(uint64_t(config.getSyncUploadLimit()) * 1024);
+    m_relayUploadLimit = TokenBucket(uint64_t(config.getRelayUploadLimit()) * 1024);
+    m_syncUploadLimitPerPeer = uint64_t(config.getSyncUploadLimitPerPeer()) * 1024;
+    m_relayUploadLimitPerPeer = uint64_t(config.getRelayUploadLimitPerPeer()) * 1024;
+
     std::vector<uint32_t> ban_list = config.getBanList();
     for (const auto& a : ban_list) {
       block_host(a, std::numeric_limits<time_t>::max());
@@ -562,6 +720,7 @@ namespace CryptoNote
     m_ip_address = 0;
 #ifdef ALLOW_DEBUG_COMMANDS
     m_last_stat_request_time = 0;
+    m_networkStatePeerlistCounter = std::numeric_limits<uint64_t>::max();
 #endif
 
     //configure self
@@ -612,6 +771,7 @@ namespace CryptoNote
     logger(INFO) << "Stopping NodeServer and its " << m_connections.size() << " connections...";
     m_workingContextGroup.interrupt();
     m_workingContextGroup.wait();
+    m_payload_handler.waitBlocksProcessing();
 
     logger(INFO) << "NodeServer loop stopped";
     return true;
@@ -623,6 +783,58 @@ namespace CryptoNote
     return m_connections.size();
   }
   //-----------------------------------------------------------------------------------
+
+  void NodeServer::writeMetrics(std::ostream& out) {
+    size_t incoming = 0;
+    for (const auto& c : m_connections) {
+      if (c.second.m_is_income) {
+        ++incoming;
+      }
+    }
+
+    writeMetricHeader(out, "karbo_p2p_connections", "gauge", "Open peer connections.");
+    out << "karbo_p2p_connections{direction=\"in\"} " << incoming << '\n';
+    out << "karbo_p2p_connections{direction=\"out\"} " << m_connections.size() - incoming << '\n';
+
+    writeMetricHeader(out, "karbo_p2p_received_messages_total", "counter", "Levin messages received, by command id.");
+    for (const auto& s : m_commandStatistics) {
+      out << "karbo_p2p_received_messages_total{command=\"" << s.first << "\"} " << s.second.receivedMessages << '\n';
+    }
+
+    writeMetricHeader(out, "karbo_p2p_received_bytes_total", "counter", "Levin message payloads received, by command id.");
+    for (const auto& s : m_commandStatistics) {
+      out << "karbo_p2p_received_bytes_total{command=\"" << s.first << "\"} " << s.second.receivedBytes << '\n';
+    }
+
+    writeMetricHeader(out, "karbo_p2p_sent_messages_total", "counter", "Levin messages sent, by command id.");
+    for (const auto& s : m_commandStatistics) {
+      out << "karbo_p2p_sent_messages_total{command=\"" << s.first << "\"} " << s.second.sentMessages << '\n';
+    }
+
+    writeMetricHeader(out, "karbo_p2p_sent_bytes_total", "counter", "Levin message payloads sent, by command id.");
+    for (const auto& s : m_commandStatistics) {
+      out << "karbo_p2p_sent_bytes_total{command=\"" << s.first << "\"} " << s.second.sentBytes << '\n';
+    }
+
+    writeMetricHeader(out, "karbo_p2p_peer_rtt_seconds", "gauge", "Smoothed round trip time of the timed syncs with a peer.");
+    for (const auto& c : m_connections) {
+      if (c.second.m_round_trip_time.count() != 0) {
+        out << "karbo_p2p_peer_rtt_seconds{peer=\"" << ipAddressToString(c.second.m_remote_ip) << ':' << c.second.m_remote_port << "\"} " <<
+          formatMetricSeconds(static_cast<uint64_t>(c.second.m_round_trip_time.count())) << '\n';
+      }
+    }
+
+    writeMetricHeader(out, "karbo_p2p_peer_download_bytes_per_second", "gauge", "Smoothed throughput of the blocks downloaded from a peer.");
+    for (const auto& c : m_connections) {
+      if (c.second.m_download_speed != 0) {
+        out << "karbo_p2p_peer_download_bytes_per_second{peer=\"" << ipAddressToString(c.second.m_remote_ip) << ':' << c.second.m_remote_port << "\"} " <<
+          c.second.m_download_speed << '\n';
+      }
+    }
+
+    m_payload_handler.writeMetrics(out);
+  }
+  //-----------------------------------------------------------------------------------
   
   bool NodeServer::deinit()  {
     return store_config();
@@ -631,6 +843,45 @@ namespace CryptoNote
   //-----------------------------------------------------------------------------------
   
   bool NodeServer::store_config()
+  {
+    try {
+      std::string state;
+      StringOutputStream stream(state);
+      BinaryOutputStreamSerializer a(stream);
+      CryptoNote::serialize(*this, a);
+      return write_config(state);
+    } catch (const std::exception& e) {
+      logger(TRACE) << "store_config failed: " << e.what();
+    }
+
+    return false;
+  }
+
+  //-----------------------------------------------------------------------------------
+
+  void NodeServer::store_config_async()
+  {
+    // the peer list is copied out on the dispatcher, the file is written by another thread
+    std::string state;
+    try {
+      StringOutputStream stream(state);
+      BinaryOutputStreamSerializer a(stream);
+      CryptoNote::serialize(*this, a);
+    } catch (const std::exception& e) {
+      logger(TRACE) << "store_config failed: " << e.what();
+      return;
+    }
+
+    System::RemoteContext<bool> writer(m_dispatcher, [this, &state] {
+      return write_config(state);
+    });
+
+    writer.get();
+  }
+
+  //-----------------------------------------------------------------------------------
+
+  bool NodeServer::write_config(const std::string& state)
   {
     try {
       if (!Tools::create_directories_if_necessary(m_config_folder)) {
@@ -638,17 +889,31 @@ namespace CryptoNote
         return false;
       }
 
+      // write a temporary file and rename it, so a crash never leaves a truncated state file
       std::string state_file_path = m_config_folder + "/" + m_p2p_state_filename;
-      std::ofstream p2p_data;
-      p2p_data.open(state_file_path, std::ios_base::binary | std::ios_base::out | std::ios::trunc);
-      if (p2p_data.fail())  {
-        logger(INFO) << "Failed to save config to file " << state_file_path;
+      std::string temp_file_path = state_file_path + ".tmp";
+      {
+        std::ofstream p2p_data;
+        p2p_data.open(temp_file_path, std::ios_base::binary | std::ios_base::out | std::ios::trunc);
+        if (p2p_data.fail())  {
+          logger(INFO) << "Failed to save config to file " << temp_file_path;
+          return false;
+        }
+
+        p2p_data.write(state.data(), state.size());
+        if (p2p_data.fail()) {
+          logger(INFO) << "Failed to save config to file " << temp_file_path;
+          return false;
+        }
+      }
+
+      boost::system::error_code ec;
+      boost::filesystem::rename(temp_file_path, state_file_path, ec);
+      if (ec) {
+        logger(INFO) << "Failed to save config to file " << state_file_path << ": " << ec.message();
         return false;
-      };
+      }
 
-      StdOutputStream stream(p2p_data);
-      BinaryOutputStreamSerializer a(stream);
-      CryptoNote::serialize(*this, a);
       return true;
     } catch (const std::exception& e) {
       logger(TRACE) << "store_config failed: " << e.what();
@@ -730,20 +995,29 @@ namespace CryptoNote
   bool NodeServer::timedSync() {
     COMMAND_TIMED_SYNC::request arg = boost::value_initialized<COMMAND_TIMED_SYNC::request>();
     m_payload_handler.get_payload_sync_data(arg.payload_data);
-    auto cmdBuf = LevinProtocol::encode<COMMAND_TIMED_SYNC::request>(arg);
+    auto cmdBuf = std::make_shared<const BinaryArray>(LevinProtocol::encode<COMMAND_TIMED_SYNC::request>(arg));
 
     forEachConnection([&](P2pConnectionContext& conn) {
       if (conn.peerId && 
           (conn.m_state == CryptoNoteConnectionContext::state_normal || 
-           conn.m_state == CryptoNoteConnectionContext::state_idle)) {
-        conn.pushMessage(P2pMessage(P2pMessage::COMMAND, COMMAND_TIMED_SYNC::ID, cmdBuf));
+           conn.m_state == CryptoNoteConnectionContext::state_idle ||
+           conn.m_state == CryptoNoteConnectionContext::state_synchronizing)) {
+        auto sendTime = P2pConnectionContext::Clock::now();
+        conn.pushInvoke(P2pMessage(P2pMessage::COMMAND, COMMAND_TIMED_SYNC::ID, cmdBuf),
+          [this, sendTime](P2pConnectionContext& context, const BinaryArray* response) {
+            return response == nullptr || handleTimedSyncResponse(*response, sendTime, context);
+          });
       }
     });
 
     return true;
   }
 
-  bool NodeServer::handleTimedSyncResponse(const BinaryArray& in, P2pConnectionContext& context) {
+  bool NodeServer::handleTimedSyncResponse(const BinaryArray& in, P2pConnectionContext::TimePoint sendTime, P2pConnectionContext& context) {
+    // the time the request waited in the write queue is included
+    auto roundTripTime = std::chrono::duration_cast<std::chrono::microseconds>(P2pConnectionContext::Clock::now() - sendTime);
+    context.m_round_trip_time = context.m_round_trip_time.count() == 0 ? roundTripTime : (context.m_round_trip_time * 3 + roundTripTime) / 4;
+
     COMMAND_TIMED_SYNC::response rsp;
     if (!LevinProtocol::decode<COMMAND_TIMED_SYNC::response>(in, rsp)) {
       return false;
@@ -787,13 +1061,7 @@ namespace CryptoNote
     if(m_config.m_peer_id == peer.id)
       return true; //dont make connections to ourself
 
-    for (const auto& kv : m_connections) {
-      const auto& cntxt = kv.second;
-      if(cntxt.peerId == peer.id || (!cntxt.m_is_income && peer.adr.ip == cntxt.m_remote_ip && peer.adr.port == cntxt.m_remote_port)) {
-        return true;
-      }
-    }
-    return false;
+    return m_connected_peer_ids.count(peer.id) != 0 || is_addr_connected(peer.adr);
   }
 
   //----------------------------------------------------------------------------------- 
@@ -801,23 +1069,40 @@ namespace CryptoNote
     if(m_config.m_peer_id == peer.id)
       return true; //dont make connections to ourself
 
-    for (const auto& kv : m_connections) {
-      const auto& cntxt = kv.second;
-      if(cntxt.peerId == peer.id || (!cntxt.m_is_income && peer.adr.ip == cntxt.m_remote_ip && peer.adr.port == cntxt.m_remote_port)) {
-        return true;
-      }
-    }
-    return false;
+    return m_connected_peer_ids.count(peer.id) != 0 || is_addr_connected(peer.adr);
   }
   //-----------------------------------------------------------------------------------
   
   bool NodeServer::is_addr_connected(const NetworkAddress& peer) {
-    for (const auto& conn : m_connections) {
-      if (!conn.second.m_is_income && peer.ip == conn.second.m_remote_ip && peer.port == conn.second.m_remote_port) {
-        return true;
+    return m_connected_addresses.count(addressKey(peer.ip, peer.port)) != 0;
+  }
+
+  //-----------------------------------------------------------------------------------
+  void NodeServer::add_connection_index(const P2pConnectionContext& context) {
+    if (context.peerId) {
+      ++m_connected_peer_ids[context.peerId];
+    }
+
+    if (!context.m_is_income) {
+      ++m_connected_addresses[addressKey(context.m_remote_ip, context.m_remote_port)];
+    }
+  }
+
+  //-----------------------------------------------------------------------------------
+  void NodeServer::remove_connection_index(const P2pConnectionContext& context) {
+    if (context.peerId) {
+      auto it = m_connected_peer_ids.find(context.peerId);
+      if (it != m_connected_peer_ids.end() && --it->second == 0) {
+        m_connected_peer_ids.erase(it);
+      }
+    }
+
+    if (!context.m_is_income) {
+      auto it = m_connected_addresses.find(addressKey(context.m_remote_ip, context.m_remote_port));
+      if (it != m_connected_addresses.end() && --it->second == 0) {
+        m_connected_addresses.erase(it);
       }
     }
-    return false;
   }
 
 
@@ -902,6 +1187,7 @@ namespace CryptoNote
       auto iter = m_connections.emplace(ctx.m_connection_id, std::move(ctx)).first;
       const boost::uuids::uuid& connectionId = iter->first;
       P2pConnectionContext& connectionContext = iter->second;
+      add_connection_index(connectionContext);
 
       m_workingContextGroup.spawn(std::bind(&NodeServer::connectionHandler, this, std::cref(connectionId), std::ref(connectionContext)));
 
@@ -917,55 +1203,66 @@ namespace CryptoNote
   }
 
   //-----------------------------------------------------------------------------------
-  bool NodeServer::make_new_connection_from_peerlist(bool use_white_list)
+  void NodeServer::add_dial_candidates_from_peerlist(bool use_white_list, size_t count, std::set<uint64_t>& tried, std::vector<DialCandidate>& candidates)
   {
     size_t local_peers_count = use_white_list ? m_peerlist.get_white_peers_count():m_peerlist.get_gray_peers_count();
     if(!local_peers_count)
-      return false;//no peers
+      return;//no peers
 
-    size_t max_random_index = std::min<uint64_t>(local_peers_count -1, 20);
+    // random peers come from the most recently seen ones, the window widens as they're tried
+    size_t max_random_index = std::min<uint64_t>(local_peers_count - 1, 20 + tried.size());
+    time_t now = time(nullptr);
 
-    std::set<size_t> tried_peers;
-
-    size_t try_count = 0;
+    std::vector<DialCandidate> picked;
+    std::set<uint64_t> pickedAddresses;
     size_t rand_count = 0;
-    while(rand_count < (max_random_index+1)*3 &&  try_count < 10 && !m_stop) {
+    while(rand_count < (max_random_index+1)*3 && picked.size() < count * 2 && !m_stop) {
       ++rand_count;
       size_t random_index = get_random_index_with_fixed_probability(max_random_index);
-      if (!(random_index < local_peers_count)) { logger(ERROR, BRIGHT_RED) << "random_starter_index < peers_local.size() failed!!"; return false; }
-
-      if(tried_peers.count(random_index))
-        continue;
+      if (!(random_index < local_peers_count)) { logger(ERROR, BRIGHT_RED) << "random_starter_index < peers_local.size() failed!!"; return; }
 
-      tried_peers.insert(random_index);
       PeerlistEntry pe = boost::value_initialized<PeerlistEntry>();
       bool r = use_white_list ? m_peerlist.get_white_peer_by_index(pe, random_index):m_peerlist.get_gray_peer_by_index(pe, random_index);
-      if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to get random peer from peerlist(white:" << use_white_list << ")"; return false; }
-
-      ++try_count;
+      if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to get random peer from peerlist(white:" << use_white_list << ")"; return; }
 
-      if(is_peer_used(pe))
+      uint64_t key = addressKey(pe.adr.ip, pe.adr.port);
+      if (tried.count(key) || !pickedAddresses.insert(key).second)
         continue;
 
-      if (!is_remote_host_allowed(pe.adr.ip))
+      if (is_peer_used(pe) || !is_remote_host_allowed(pe.adr.ip) || is_dial_backed_off(pe.adr, now)) {
+        tried.insert(key);
         continue;
-      
+      }
+
       logger(DEBUGGING) << "Selected peer: " << pe.id << " " << pe.adr << " [peer_list=" << (use_white_list ? white : gray)
                     << "] last_seen: " << (pe.last_seen ? Common::timeIntervalToString(time(NULL) - pe.last_seen) : "never");
-      
-      if(!try_to_connect_and_handshake_with_new_peer(pe.adr, false, pe.last_seen, use_white_list ? white : gray))
-        continue;
 
-      return true;
+      picked.push_back({ pe.adr, use_white_list ? white : gray, pe.last_seen, 0 });
+    }
+
+    // the ones likeliest to answer go first
+    std::stable_sort(picked.begin(), picked.end(), [this](const DialCandidate& a, const DialCandidate& b) {
+      return dial_score(a.adr) > dial_score(b.adr);
+    });
+
+    if (picked.size() > count) {
+      picked.resize(count);
+    }
+
+    for (const auto& candidate : picked) {
+      tried.insert(addressKey(candidate.adr.ip, candidate.adr.port));
+      candidates.push_back(candidate);
     }
-    return false;
   }
   //-----------------------------------------------------------------------------------
   
  
-  bool NodeServer::make_new_connection_from_anchor_peerlist(const std::vector<AnchorPeerlistEntry>& anchor_peerlist)
+  void NodeServer::add_dial_candidates_from_anchor_peerlist(std::vector<AnchorPeerlistEntry>& anchor_peerlist, size_t count, std::vector<DialCandidate>& candidates)
   {
-    for (const auto& pe : anchor_peerlist) {
+    size_t added = 0;
+    while (!anchor_peerlist.empty() && added < count) {
+      AnchorPeerlistEntry pe = anchor_peerlist.front();
+      anchor_peerlist.erase(anchor_peerlist.begin());
       logger(DEBUGGING) << "Considering connecting (out) to peer: " << pe.id << " " << Common::ipAddressToString(pe.adr.ip) << ":" << boost::lexical_cast<std::string>(pe.adr.port);
 
       if (is_peer_used(pe)) {
@@ -986,15 +1283,94 @@ namespace CryptoNote
         << "[peer_type=" << anchor
         << "] first_seen: " << Common::timeIntervalToString(time(NULL) - pe.first_seen);
 
-      if (!try_to_connect_and_handshake_with_new_peer(pe.adr, false, 0, anchor, pe.first_seen)) {
-        logger(DEBUGGING) << "Handshake failed";
-        continue;
-      }
+      candidates.push_back({ pe.adr, anchor, 0, static_cast<uint64_t>(pe.first_seen) });
+      ++added;
+    }
+  }
+  //-----------------------------------------------------------------------------------
 
-      return true;
+  // The candidates are dialed in parallel, each one DIAL_STAGGER after the previous, like happy
+  // eyeballs: a peer answering quickly gets the slot before the later attempts even start, and
+  // dead peers cost their timeout at the same time rather than one after another. The attempts
+  // still running are interrupted once needed connections are made.
+  size_t NodeServer::dial_candidates(std::vector<DialCandidate>& candidates, size_t needed)
+  {
+    size_t connected = 0;
+    size_t running = candidates.size();
+    System::Event finished(m_dispatcher);
+    System::ContextGroup dials(m_dispatcher);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      dials.spawn([this, &candidates, &connected, &running, &finished, &dials, needed, i] {
+        const DialCandidate& candidate = candidates[i];
+        try {
+          System::Timer(m_dispatcher).sleep(DIAL_STAGGER * static_cast<int>(i));
+          if (connected < needed && !is_addr_connected(candidate.adr)) {
+            bool ok = try_to_connect_and_handshake_with_new_peer(candidate.adr, false, candidate.last_seen, candidate.type, candidate.first_seen);
+            // attempts cut short by enough others connecting don't count against the peer
+            if (ok || connected < needed) {
+              record_dial_result(candidate.adr, ok);
+            }
+
+            if (ok && ++connected == needed) {
+              dials.interrupt();
+            }
+          }
+        } catch (System::InterruptedException&) {
+        }
+
+        if (--running == 0) {
+          finished.set();
+        }
+      });
     }
 
-    return false;
+    try {
+      finished.wait();
+    } catch (System::InterruptedException&) {
+      dials.interrupt();
+      dials.wait();
+      throw;
+    }
+
+    dials.wait();
+    return connected;
+  }
+  //-----------------------------------------------------------------------------------
+
+  void NodeServer::record_dial_result(const NetworkAddress& na, bool connected)
+  {
+    DialStats& stats = m_dial_stats[addressKey(na.ip, na.port)];
+    stats.last_attempt = time(nullptr);
+    if (connected) {
+      ++stats.successes;
+      stats.failures = 0;
+    } else {
+      ++stats.failures;
+    }
+  }
+  //-----------------------------------------------------------------------------------
+
+  bool NodeServer::is_dial_backed_off(const NetworkAddress& na, time_t now) const
+  {
+    auto it = m_dial_stats.find(addressKey(na.ip, na.port));
+    if (it == m_dial_stats.end() || it->second.failures == 0) {
+      return false;
+    }
+
+    time_t backoff = std::min(DIAL_BACKOFF_BASE << std::min<uint32_t>(it->second.failures - 1, 10), DIAL_BACKOFF_MAX);
+    return now - it->second.last_attempt < backoff;
+  }
+  //-----------------------------------------------------------------------------------
+
+  double NodeServer::dial_score(const NetworkAddress& na) const
+  {
+    // the estimated chance of a successful connection, a half for the peers never tried
+    auto it = m_dial_stats.find(addressKey(na.ip, na.port));
+    if (it == m_dial_stats.end()) {
+      return 0.5;
+    }
+
+    return (it->second.successes + 1.0) / (it->second.successes + it->second.failures + 2.0);
   }
   //-----------------------------------------------------------------------------------
 
@@ -1066,6 +1442,7 @@ namespace CryptoNote
       m_peerlist.get_and_empty_anchor_peerlist(apl);
     }
     
+    std::set<uint64_t> tried;
     size_t conn_count = get_outgoing_connections_count();
     //add new connections from white peers
     while(conn_count < expected_connections)
@@ -1073,15 +1450,16 @@ namespace CryptoNote
       if(m_stopEvent.get())
         return false;
 
-      if (peer_type == anchor && !make_new_connection_from_anchor_peerlist(apl)) {
-        break;
-      }
-
-      if (peer_type == white && !make_new_connection_from_peerlist(true)) {
-        break;
+      size_t needed = expected_connections - conn_count;
+      size_t count = std::min(MAX_PARALLEL_DIALS, needed * 2);
+      std::vector<DialCandidate> candidates;
+      if (peer_type == anchor) {
+        add_dial_candidates_from_anchor_peerlist(apl, count, candidates);
+      } else {
+        add_dial_candidates_from_peerlist(peer_type == white, count, tried, candidates);
       }
 
-      if (peer_type == gray && !make_new_connection_from_peerlist(false)) {
+      if (candidates.empty() || dial_candidates(candidates, needed) == 0) {
         break;
       }
 
@@ -1104,7 +1482,7 @@ namespace CryptoNote
   bool NodeServer::idle_worker() {
     try {
       m_connections_maker_interval.call(std::bind(&NodeServer::connections_maker, this));
-      m_peerlist_store_interval.call(std::bind(&NodeServer::store_config, this));
+      m_peerlist_store_interval.call([this] { store_config_async(); return true; });
       m_gray_peerlist_housekeeping_interval.call(std::bind(&NodeServer::gray_peerlist_housekeeping, this));
     } catch (std::exception& e) {
       logger(DEBUGGING) << "exception in idle_worker: " << e.what();
@@ -1233,7 +1611,16 @@ namespace CryptoNote
       rsp.connections_list.push_back(ce);
     }
 
-    m_peerlist.get_peerlist_full(rsp.local_peerlist_gray, rsp.local_peerlist_white);
+    if (m_networkStatePeerlistCounter != m_peerlist.getModificationCounter()) {
+      std::list<AnchorPeerlistEntry> anchor;
+      m_networkStateWhite.clear();
+      m_networkStateGray.clear();
+      m_peerlist.get_peerlist_full(anchor, m_networkStateGray, m_networkStateWhite);
+      m_networkStatePeerlistCounter = m_peerlist.getModificationCounter();
+    }
+
+    rsp.local_peerlist_white = m_networkStateWhite;
+    rsp.local_peerlist_gray = m_networkStateGray;
     rsp.my_id = m_config.m_peer_id;
     rsp.local_time = time(nullptr);
     return 1;
@@ -1250,12 +1637,15 @@ namespace CryptoNote
   //-----------------------------------------------------------------------------------
   void NodeServer::relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection) {
     net_connection_id excludeId = excludeConnection ? *excludeConnection : boost::value_initialized<net_connection_id>();
+    relayNotifyToAll(command, std::make_shared<const BinaryArray>(data_buff), excludeId);
+  }
 
+  void NodeServer::relayNotifyToAll(int command, const std::shared_ptr<const BinaryArray>& buffer, const net_connection_id& excludeId) {
     forEachConnection([&](P2pConnectionContext& conn) {
       if (conn.peerId && conn.m_connection_id != excludeId &&
           (conn.m_state == CryptoNoteConnectionContext::state_normal ||
            conn.m_state == CryptoNoteConnectionContext::state_synchronizing)) {
-        conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, data_buff));
+        conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, buffer));
       }
     });
   }
@@ -1329,16 +1719,8 @@ namespace CryptoNote
     //fill response
     rsp.local_time = time(nullptr);
 
-    std::vector<PeerlistEntry> local_peerlist;
-    m_peerlist.get_peerlist_head(local_peerlist);
-    //only include out peers we did not already send
-    rsp.local_peerlist.reserve(local_peerlist.size());
-    for (auto &pe : local_peerlist)
-    {
-      if (!context.sent_addresses.insert(pe.adr).second)
-        continue;
-      rsp.local_peerlist.push_back(std::move(pe));
-    }
+    //only the peers that are new to the connection or seen again since
+    m_peerlist.get_peerlist_delta(context.sent_peers, rsp.local_peerlist, PEERLIST_RESEND_AGE);
     
     m_payload_handler.get_payload_sync_data(rsp.payload_data);
     logger(Logging::TRACE) << context << "COMMAND_TIMED_SYNC";
@@ -1383,6 +1765,9 @@ namespace CryptoNote
     }
     //associate peer_id with this connection
     context.peerId = arg.node_data.peer_id;
+    if (context.peerId) {
+      ++m_connected_peer_ids[context.peerId];
+    }
 
     if(arg.node_data.peer_id != m_config.m_peer_id && arg.node_data.my_port) {
       PeerIdType peer_id_l = arg.node_data.peer_id;
@@ -1402,9 +1787,7 @@ namespace CryptoNote
     }
 
     //fill response
-    m_peerlist.get_peerlist_head(rsp.local_peerlist);
-    for (const auto &e : rsp.local_peerlist)
-      context.sent_addresses.insert(e.adr);
+    m_peerlist.get_peerlist_delta(context.sent_peers, rsp.local_peerlist, PEERLIST_RESEND_AGE);
     get_local_node_data(rsp.node_data);
     m_payload_handler.get_payload_sync_data(rsp.payload_data);
 
@@ -1518,8 +1901,22 @@ namespace CryptoNote
     if (!m_peerlist.get_gray_peer_by_index(pe, random_index))
       return false;
 
-    if (!try_to_connect_and_handshake_with_new_peer(pe.adr, false, 0, gray, pe.last_seen)) {
-      time_t now = time(nullptr);
+    time_t now = time(nullptr);
+    for (auto it = m_dial_stats.begin(); it != m_dial_stats.end();) {
+      if (now - it->second.last_attempt >= DIAL_STATS_LIFETIME) {
+        it = m_dial_stats.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    if (is_dial_backed_off(pe.adr, now))
+      return true;
+
+    bool connected = try_to_connect_and_handshake_with_new_peer(pe.adr, false, 0, gray, pe.last_seen);
+    record_dial_result(pe.adr, connected);
+    if (!connected) {
+      now = time(nullptr);
       if (now - pe.last_seen >= LAST_SEEN_EVICT_THRESHOLD) {
         m_peerlist.remove_from_peer_gray(pe);
         logger(DEBUGGING) << "PEER EVICTED FROM GRAY PEER LIST IP address: " << Common::ipAddressToString(pe.adr.ip) << " Peer ID: " << std::hex << pe.id;
@@ -1565,6 +1962,7 @@ namespace CryptoNote
         auto iter = m_connections.emplace(ctx.m_connection_id, std::move(ctx)).first;
         const boost::uuids::uuid& connectionId = iter->first;
         P2pConnectionContext& connection = iter->second;
+        add_connection_index(connection);
 
         m_workingContextGroup.spawn(std::bind(&NodeServer::connectionHandler, this, std::cref(connectionId), std::ref(connection)));
       } catch (System::InterruptedException&) {
@@ -1642,6 +2040,7 @@ namespace CryptoNote
 
         LevinProtocol proto(ctx.connection);
         LevinProtocol::Command cmd;
+        auto maxSize = [this, &ctx](const LevinProtocol::Command& command) { return getMaxMessageSize(command, ctx); };
 
         for (;;) {
           if (ctx.m_state == CryptoNoteConnectionContext::state_sync_required) {
@@ -1652,10 +2051,16 @@ namespace CryptoNote
             m_payload_handler.requestMissingPoolTransactions(ctx);
           }
 
-          if (!proto.readCommand(cmd)) {
+          if (!proto.readCommand(cmd, maxSize)) {
             break;
           }
 
+          ctx.m_recv_cnt += cmd.buf.size();
+          ctx.m_last_recv = time(nullptr);
+          CommandStatistics& statistics = m_commandStatistics[cmd.command];
+          ++statistics.receivedMessages;
+          statistics.receivedBytes += cmd.buf.size();
+
           BinaryArray response;
           bool handled = false;
           auto retcode = handleCommand(cmd, response, ctx, handled);
@@ -1684,7 +2089,9 @@ namespace CryptoNote
       writeContext.interrupt();
       writeContext.get();
 
+      ctx.cancelInvokes();
       on_connection_close(ctx);
+      remove_connection_index(ctx);
       m_connections.erase(connectionId);
     });
 
@@ -1702,29 +2109,62 @@ namespace CryptoNote
 
     try {
       LevinProtocol proto(ctx.connection);
+      System::Timer throttleTimer(m_dispatcher);
+      ctx.syncUploadLimit = TokenBucket(m_syncUploadLimitPerPeer);
+      ctx.relayUploadLimit = TokenBucket(m_relayUploadLimitPerPeer);
 
       for (;;) {
+        ctx.waitForMessages();
+
+        // While only sync responses are pending wait in short slices, so a block
+        // or transaction queued meanwhile is sent without waiting off the sync limit.
+        if (ctx.hasOnlySyncMessages()) {
+          auto delay = std::max(m_syncUploadLimit.delay(), ctx.syncUploadLimit.delay());
+          if (delay.count() > 0) {
+            throttleTimer.sleep(std::min(delay, UPLOAD_THROTTLE_SLICE));
+            continue;
+          }
+        }
+
         auto msgs = ctx.popBuffer();
         if (msgs.empty()) {
           break;
         }
 
+        bool syncBatch = msgs.front().priority() == P2pMessage::PRIORITY_SYNC;
+        if (!syncBatch) {
+          auto delay = std::max(m_relayUploadLimit.delay(), ctx.relayUploadLimit.delay());
+          if (delay.count() > 0) {
+            throttleTimer.sleep(delay);
+          }
+        }
+
+        uint64_t batchSize = 0;
+        std::vector<LevinProtocol::Message> frames;
+        frames.reserve(msgs.size());
         for (const auto& msg : msgs) {
+          batchSize += msg.size();
+          CommandStatistics& statistics = m_commandStatistics[msg.command];
+          ++statistics.sentMessages;
+          statistics.sentBytes += msg.size();
           logger(DEBUGGING) << ctx << "msg " << msg.type << ':' << msg.command;
-          switch (msg.type) {
-          case P2pMessage::COMMAND:
-            proto.sendMessage(msg.command, msg.buffer, true);
-            break;
-          case P2pMessage::NOTIFY:
-            proto.sendMessage(msg.command, msg.buffer, false);
-            break;
-          case P2pMessage::REPLY:
-            proto.sendReply(msg.command, msg.buffer, msg.returnCode);
-            break;
-          default:
-            assert(false);
-          }
+          assert(msg.type == P2pMessage::COMMAND || msg.type == P2pMessage::NOTIFY || msg.type == P2pMessage::REPLY);
+          LevinProtocol::Message frame = { msg.command, msg.buffer.get(), msg.type == P2pMessage::REPLY, msg.type == P2pMessage::COMMAND, msg.returnCode };
+          frames.push_back(frame);
         }
+
+        proto.sendMessages(frames);
+
+        if (syncBatch) {
+          m_syncUploadLimit.consume(batchSize);
+          ctx.syncUploadLimit.consume(batchSize);
+        } else {
+          m_relayUploadLimit.consume(batchSize);
+          ctx.relayUploadLimit.consume(batchSize);
+        }
+
+        ctx.m_send_cnt += batchSize;
+        ctx.m_last_send = time(nullptr);
       }
     } catch (System::InterruptedException&) {
       // connection stopped
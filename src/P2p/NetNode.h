@@ -20,7 +20,11 @@
 
 #pragma once
 
+#include <deque>
 #include <functional>
+#include <map>
+#include <memory>
+#include <set>
 #include <unordered_map>
 
 #include <boost/functional/hash.hpp>
@@ -46,6 +50,7 @@
 #include "P2pProtocolDefinitions.h"
 #include "P2pNetworks.h"
 #include "PeerListManager.h"
+#include "TokenBucket.h"
 
 namespace System {
 class TcpConnection;
@@ -63,7 +68,24 @@ namespace CryptoNote
       NOTIFY
     };
 
+    // the writer drains lower classes only when the higher ones are empty
+    enum Priority {
+      PRIORITY_BLOCKS,
+      PRIORITY_TRANSACTIONS,
+      PRIORITY_SYNC,
+      PRIORITY_COUNT
+    };
+
     P2pMessage(Type type, uint32_t command, const BinaryArray& buffer, int32_t returnCode = 0) :
+      type(type), command(command), buffer(std::make_shared<const BinaryArray>(buffer)), returnCode(returnCode) {
+    }
+
+    P2pMessage(Type type, uint32_t command, BinaryArray&& buffer, int32_t returnCode = 0) :
+      type(type), command(command), buffer(std::make_shared<const BinaryArray>(std::move(buffer))), returnCode(returnCode) {
+    }
+
+    // relayed messages share one encoded payload between all the connections
+    P2pMessage(Type type, uint32_t command, const std::shared_ptr<const BinaryArray>& buffer, int32_t returnCode = 0) :
       type(type), command(command), buffer(buffer), returnCode(returnCode) {
     }
 
@@ -71,13 +93,15 @@ namespace CryptoNote
       type(msg.type), command(msg.command), buffer(std::move(msg.buffer)), returnCode(msg.returnCode) {
     }
 
-    size_t size() {
-      return buffer.size();
+    size_t size() const {
+      return buffer->size();
     }
 
+    Priority priority() const;
+
     Type type;
     uint32_t command;
-    const BinaryArray buffer;
+    std::shared_ptr<const BinaryArray> buffer;
     int32_t returnCode;
   };
 
@@ -89,7 +113,13 @@ namespace CryptoNote
     System::Context<void>* context;
     PeerIdType peerId;
     System::TcpConnection connection;
-    std::set<NetworkAddress> sent_addresses;
+    std::map<NetworkAddress, uint64_t> sent_peers;    // peer list entries sent, address -> last_seen
+    TokenBucket syncUploadLimit;
+    TokenBucket relayUploadLimit;
+
+    // gets the response payload, or nullptr when the connection closes before it arrives;
+    // returning false drops the connection
+    typedef std::function<bool(P2pConnectionContext&, const BinaryArray*)> ResponseHandler;
 
     P2pConnectionContext(System::Dispatcher& dispatcher, Logging::ILogger& log, System::TcpConnection&& conn) :
       context(nullptr),
@@ -105,23 +135,38 @@ namespace CryptoNote
       context(ctx.context),
       peerId(ctx.peerId),
       connection(std::move(ctx.connection)),
+      sent_peers(std::move(ctx.sent_peers)),
+      syncUploadLimit(ctx.syncUploadLimit),
+      relayUploadLimit(ctx.relayUploadLimit),
       logger(ctx.logger.getLogger(), "node_server"),
       queueEvent(std::move(ctx.queueEvent)),
+      pendingResponses(std::move(ctx.pendingResponses)),
       stopped(std::move(ctx.stopped)) {
     }
 
     bool pushMessage(P2pMessage&& msg);
+    // Queues a request and leaves the handler waiting for its response. A peer answers the
+    // requests of one command in the order they came, so any number of them may be in flight.
+    bool pushInvoke(P2pMessage&& msg, ResponseHandler&& handler);
+    // passes the response to the oldest request of its command; returns false to drop the connection
+    bool dispatchResponse(uint32_t command, const BinaryArray& response);
+    void cancelInvokes();
+    void waitForMessages();
+    bool hasOnlySyncMessages() const;
     std::vector<P2pMessage> popBuffer();
     void interrupt();
 
     uint64_t writeDuration(TimePoint now) const;
 
   private:
+    bool writeQueueEmpty() const;
+
     Logging::LoggerRef logger;
     TimePoint writeOperationStartTime;
     System::Event queueEvent;
-    std::vector<P2pMessage> writeQueue;
+    std::deque<P2pMessage> writeQueues[P2pMessage::PRIORITY_COUNT];
     size_t writeQueueSize = 0;
+    std::map<uint32_t, std::deque<ResponseHandler>> pendingResponses;
     bool stopped;
   };
 
@@ -151,12 +196,16 @@ namespace CryptoNote
     bool ban_host(const uint32_t address_ip, time_t seconds = P2P_IP_BLOCKTIME) override;
     bool unban_host(const uint32_t address_ip) override;
     std::map<uint32_t, time_t> get_blocked_hosts() override { return m_blocked_hosts; };
+    // connections, traffic by command and sync state in Prometheus text format, on the dispatcher thread
+    void writeMetrics(std::ostream& out);
 
   private:
 
     enum PeerType { anchor = 0, white, gray };
 
-    int handleCommand(const LevinProtocol::Command& cmd, BinaryArray& buff_out, P2pConnectionContext& context, bool& handled);
+    // the payload of cmd may be released by the handler once it is decoded
+    int handleCommand(LevinProtocol::Command& cmd, BinaryArray& buff_out, P2pConnectionContext& context, bool& handled);
+    uint64_t getMaxMessageSize(const LevinProtocol::Command& cmd, const P2pConnectionContext& ctx) const;
 
     //----------------- commands handlers ----------------------------------------------
     int handle_handshake(int command, COMMAND_HANDSHAKE::request& arg, COMMAND_HANDSHAKE::response& rsp, P2pConnectionContext& context);
@@ -171,13 +220,15 @@ namespace CryptoNote
     bool init_config();
     bool make_default_config();
     bool store_config();
+    void store_config_async();
+    bool write_config(const std::string& state);
 #ifdef ALLOW_DEBUG_COMMANDS
     bool check_trust(const proof_of_trust& tr);
 #endif
 
     bool handshake(CryptoNote::LevinProtocol& proto, P2pConnectionContext& context, bool just_take_peerlist = false);
     bool timedSync();
-    bool handleTimedSyncResponse(const BinaryArray& in, P2pConnectionContext& context);
+    bool handleTimedSyncResponse(const BinaryArray& in, P2pConnectionContext::TimePoint sendTime, P2pConnectionContext& context);
     void forEachConnection(std::function<void(P2pConnectionContext&)> action);
 
     void on_connection_new(P2pConnectionContext& context);
@@ -190,6 +241,7 @@ namespace CryptoNote
     virtual void for_each_connection(std::function<void(CryptoNote::CryptoNoteConnectionContext&, PeerIdType)> f) override;
     virtual void externalRelayNotifyToAll(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection) override;
     virtual void externalRelayNotifyToList(int command, const BinaryArray &data_buff, const std::list<boost::uuids::uuid> relayList) override;
+    void relayNotifyToAll(int command, const std::shared_ptr<const BinaryArray>& buffer, const net_connection_id& excludeId);
 
     //-----------------------------------------------------------------------------------------------
     bool add_host_fail(const uint32_t address_ip);
@@ -206,12 +258,25 @@ namespace CryptoNote
     bool fix_time_delta(std::vector<PeerlistEntry>& local_peerlist, time_t local_time, int64_t& delta);
 
     bool connections_maker();
-    bool make_new_connection_from_peerlist(bool use_white_list);
-    bool make_new_connection_from_anchor_peerlist(const std::vector<AnchorPeerlistEntry>& anchor_peerlist);
+    struct DialCandidate {
+      NetworkAddress adr;
+      PeerType type;
+      uint64_t last_seen;
+      uint64_t first_seen;
+    };
+
+    void add_dial_candidates_from_peerlist(bool use_white_list, size_t count, std::set<uint64_t>& tried, std::vector<DialCandidate>& candidates);
+    void add_dial_candidates_from_anchor_peerlist(std::vector<AnchorPeerlistEntry>& anchor_peerlist, size_t count, std::vector<DialCandidate>& candidates);
+    size_t dial_candidates(std::vector<DialCandidate>& candidates, size_t needed);
+    void record_dial_result(const NetworkAddress& na, bool connected);
+    bool is_dial_backed_off(const NetworkAddress& na, time_t now) const;
+    double dial_score(const NetworkAddress& na) const;
     bool try_to_connect_and_handshake_with_new_peer(const NetworkAddress& na, bool just_take_peerlist = false, uint64_t last_seen_stamp = 0, PeerType peer_type = white, uint64_t first_seen_stamp = 0);
     bool is_peer_used(const PeerlistEntry& peer);
     bool is_peer_used(const AnchorPeerlistEntry& peer);
     bool is_addr_connected(const NetworkAddress& peer);  
+    void add_connection_index(const P2pConnectionContext& context);
+    void remove_connection_index(const P2pConnectionContext& context);
     bool try_ping(basic_node_data& node_data, P2pConnectionContext& context);
     bool make_expected_connections_count(PeerType peer_type, size_t expected_connections);
     bool is_priority_node(const NetworkAddress& na);
@@ -260,6 +325,12 @@ namespace CryptoNote
     bool m_hide_my_port;
     std::string m_p2p_state_filename;
 
+    // upload limits in bytes per second, shared by all connections and per connection
+    TokenBucket m_syncUploadLimit;
+    TokenBucket m_relayUploadLimit;
+    uint64_t m_syncUploadLimitPerPeer;
+    uint64_t m_relayUploadLimitPerPeer;
+
     System::Dispatcher& m_dispatcher;
     System::ContextGroup m_workingContextGroup;
     System::Event m_stopEvent;
@@ -282,6 +353,10 @@ namespace CryptoNote
     std::string m_port;
 #ifdef ALLOW_DEBUG_COMMANDS
     uint64_t m_last_stat_request_time;
+    // peer lists of the network state response, reused while the peer list is unchanged
+    uint64_t m_networkStatePeerlistCounter;
+    std::vector<PeerlistEntry> m_networkStateWhite;
+    std::vector<PeerlistEntry> m_networkStateGray;
 #endif
     std::vector<NetworkAddress> m_priority_peers;
     std::vector<NetworkAddress> m_exclusive_peers;
@@ -291,6 +366,31 @@ namespace CryptoNote
     boost::uuids::uuid m_network_id;
     std::map<uint32_t, time_t> m_blocked_hosts;
     std::map<uint32_t, uint64_t> m_host_fails_score;
+    // connection counts by peer id and by address of outgoing connections, for is_peer_used()
+    std::unordered_map<PeerIdType, size_t> m_connected_peer_ids;
+    std::unordered_map<uint64_t, size_t> m_connected_addresses;
+
+    // outcomes of our connection attempts by address: the peers that answered are tried first and
+    // the ones failing in a row are put off for exponentially longer
+    struct DialStats {
+      uint32_t successes;
+      uint32_t failures;
+      time_t last_attempt;
+    };
+
+    std::unordered_map<uint64_t, DialStats> m_dial_stats;
+
+    struct CommandStatistics {
+      CommandStatistics() : receivedMessages(0), receivedBytes(0), sentMessages(0), sentBytes(0) {}
+
+      uint64_t receivedMessages;
+      uint64_t receivedBytes;
+      uint64_t sentMessages;
+      uint64_t sentBytes;
+    };
+
+    // by command id, only touched on the dispatcher thread
+    std::map<uint32_t, CommandStatistics> m_commandStatistics;
 
     mutable std::mutex mutex;
   };
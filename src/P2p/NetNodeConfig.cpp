@@ -61,6 +61,11 @@ void NetNodeConfig::initOptions(boost::program_options::options_description& des
   command_line::add_arg(desc, arg_p2p_seed_node);
   command_line::add_arg(desc, arg_ban_list);
   command_line::add_arg(desc, arg_p2p_hide_my_port);
+  command_line::add_arg(desc, arg_p2p_sync_upload_limit);
+  command_line::add_arg(desc, arg_p2p_sync_upload_limit_per_peer);
+  command_line::add_arg(desc, arg_p2p_relay_upload_limit);
+  command_line::add_arg(desc, arg_p2p_relay_upload_limit_per_peer);
+  command_line::add_arg(desc, arg_dispatcher_cpus);
 }
 
 NetNodeConfig::NetNodeConfig() {
@@ -71,6 +76,10 @@ NetNodeConfig::NetNodeConfig() {
   hideMyPort = false;
   configFolder = Tools::getDefaultDataDirectory();
   testnet = false;
+  syncUploadLimit = 0;
+  syncUploadLimitPerPeer = 0;
+  relayUploadLimit = 0;
+  relayUploadLimitPerPeer = 0;
 }
 
 bool NetNodeConfig::init(const boost::program_options::variables_map& vm)
@@ -129,6 +138,12 @@ bool NetNodeConfig::init(const boost::program_options::variables_map& vm)
     hideMyPort = true;
   }
 
+  syncUploadLimit = command_line::get_arg(vm, arg_p2p_sync_upload_limit);
+  syncUploadLimitPerPeer = command_line::get_arg(vm, arg_p2p_sync_upload_limit_per_peer);
+  relayUploadLimit = command_line::get_arg(vm, arg_p2p_relay_upload_limit);
+  relayUploadLimitPerPeer = command_line::get_arg(vm, arg_p2p_relay_upload_limit_per_peer);
+  dispatcherCpus = Tools::parseCpuList(command_line::get_arg(vm, arg_dispatcher_cpus));
+
   if (command_line::has_arg(vm, CryptoNote::arg_ban_list)) {
     const std::string ban_list_file = command_line::get_arg(vm, CryptoNote::arg_ban_list);
 
@@ -255,5 +270,45 @@ void NetNodeConfig::setConfigFolder(const std::string& folder) {
   configFolder = folder;
 }
 
+uint32_t NetNodeConfig::getSyncUploadLimit() const {
+  return syncUploadLimit;
+}
+
+uint32_t NetNodeConfig::getSyncUploadLimitPerPeer() const {
+  return syncUploadLimitPerPeer;
+}
+
+uint32_t NetNodeConfig::getRelayUploadLimit() const {
+  return relayUploadLimit;
+}
+
+uint32_t NetNodeConfig::getRelayUploadLimitPerPeer() const {
+  return relayUploadLimitPerPeer;
+}
+
+std::vector<unsigned> NetNodeConfig::getDispatcherCpus() const {
+  return dispatcherCpus;
+}
+
+void NetNodeConfig::setSyncUploadLimit(uint32_t limit) {
+  syncUploadLimit = limit;
+}
+
+void NetNodeConfig::setSyncUploadLimitPerPeer(uint32_t limit) {
+  syncUploadLimitPerPeer = limit;
+}
+
+void NetNodeConfig::setRelayUploadLimit(uint32_t limit) {
+  relayUploadLimit = limit;
+}
+
+void NetNodeConfig::setRelayUploadLimitPerPeer(uint32_t limit) {
+  relayUploadLimitPerPeer = limit;
+}
+
+void NetNodeConfig::setDispatcherCpus(const std::vector<unsigned>& cpus) {
+  dispatcherCpus = cpus;
+}
+
 
 } //namespace nodetool
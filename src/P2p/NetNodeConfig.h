@@ -39,6 +39,11 @@ namespace CryptoNote {
   const command_line::arg_descriptor<std::vector<std::string> > arg_p2p_seed_node          = { "seed-node", "Connect to a node to retrieve peer addresses, and disconnect" };
   const command_line::arg_descriptor<std::string> arg_ban_list                             = { "ban-list", "Specify ban list file, one IP address per line", "", true };
   const command_line::arg_descriptor<bool> arg_p2p_hide_my_port                            = { "hide-my-port", "Do not announce yourself as peerlist candidate", false, true };
+  const command_line::arg_descriptor<uint32_t>    arg_p2p_sync_upload_limit                = { "p2p-sync-upload-limit", "Upload limit for serving blocks to synchronizing peers, kB/s, 0 - unlimited", 0 };
+  const command_line::arg_descriptor<uint32_t>    arg_p2p_sync_upload_limit_per_peer       = { "p2p-sync-upload-limit-per-peer", "Upload limit for serving blocks to one synchronizing peer, kB/s, 0 - unlimited", 0 };
+  const command_line::arg_descriptor<uint32_t>    arg_p2p_relay_upload_limit               = { "p2p-relay-upload-limit", "Upload limit for relaying blocks and transactions, kB/s, 0 - unlimited", 0 };
+  const command_line::arg_descriptor<uint32_t>    arg_p2p_relay_upload_limit_per_peer      = { "p2p-relay-upload-limit-per-peer", "Upload limit for relaying blocks and transactions to one peer, kB/s, 0 - unlimited", 0 };
+  const command_line::arg_descriptor<std::string> arg_dispatcher_cpus                      = { "dispatcher-cpus", "<list> CPUs for the network thread running P2P and RPC, e.g. 0-7", "" };
 
 class NetNodeConfig {
 public:
@@ -59,6 +64,11 @@ public:
   std::vector<uint32_t> getBanList() const;
   bool getHideMyPort() const;
   std::string getConfigFolder() const;
+  uint32_t getSyncUploadLimit() const;
+  uint32_t getSyncUploadLimitPerPeer() const;
+  uint32_t getRelayUploadLimit() const;
+  uint32_t getRelayUploadLimitPerPeer() const;
+  std::vector<unsigned> getDispatcherCpus() const;
 
   void setP2pStateFilename(const std::string& filename);
   void setTestnet(bool isTestnet);
@@ -72,6 +82,11 @@ public:
   void setSeedNodes(const std::vector<NetworkAddress>& addresses);
   void setHideMyPort(bool hide);
   void setConfigFolder(const std::string& folder);
+  void setSyncUploadLimit(uint32_t limit);
+  void setSyncUploadLimitPerPeer(uint32_t limit);
+  void setRelayUploadLimit(uint32_t limit);
+  void setRelayUploadLimitPerPeer(uint32_t limit);
+  void setDispatcherCpus(const std::vector<unsigned>& cpus);
 
 private:
   std::string bindIp;
@@ -87,6 +102,11 @@ private:
   std::string configFolder;
   std::string p2pStateFilename;
   bool testnet;
+  uint32_t syncUploadLimit;           // kB/s
+  uint32_t syncUploadLimitPerPeer;
+  uint32_t relayUploadLimit;
+  uint32_t relayUploadLimitPerPeer;
+  std::vector<unsigned> dispatcherCpus;
 };
 
 } //namespace nodetool
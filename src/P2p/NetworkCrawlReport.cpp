@@ -0,0 +1,128 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "NetworkCrawlReport.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+#include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "Serialization/ISerializer.h"
+#include "Serialization/SerializationOverloads.h"
+
+namespace CryptoNote {
+
+namespace {
+
+std::string addressToString(const NetworkAddress& address) {
+  std::ostringstream stream;
+  stream << address;
+  return stream.str();
+}
+
+}
+
+void CrawledNode::serialize(ISerializer& s) {
+  std::string addressString = addressToString(address);
+  s(addressString, "address");
+  KV_MEMBER(status)
+  if (status == "OK") {
+    KV_MEMBER(peerId)
+    KV_MEMBER(version)
+    KV_MEMBER(height)
+    KV_MEMBER(topId)
+    KV_MEMBER(connectMs)
+    KV_MEMBER(handshakeMs)
+  }
+
+  std::vector<std::string> peerStrings;
+  for (const NetworkAddress& peer : peers) {
+    peerStrings.push_back(addressToString(peer));
+  }
+
+  s(peerStrings, "peers");
+}
+
+void CrawlCount::serialize(ISerializer& s) {
+  KV_MEMBER(value)
+  KV_MEMBER(count)
+}
+
+void CrawlStatistics::serialize(ISerializer& s) {
+  KV_MEMBER(discovered)
+  KV_MEMBER(reached)
+  KV_MEMBER(maxHeight)
+  KV_MEMBER(behind)
+  KV_MEMBER(handshakeMsMedian)
+  KV_MEMBER(handshakeMs90)
+  KV_MEMBER(handshakeMsMax)
+  KV_MEMBER(versions)
+  KV_MEMBER(heights)
+}
+
+void CrawlReport::serialize(ISerializer& s) {
+  KV_MEMBER(statistics)
+  KV_MEMBER(nodes)
+}
+
+CrawlReport makeCrawlReport(const std::vector<CrawledNode>& nodes) {
+  CrawlReport report;
+  report.nodes = nodes;
+
+  CrawlStatistics& statistics = report.statistics;
+  statistics.discovered = nodes.size();
+  std::vector<uint64_t> handshakes;
+  std::map<uint64_t, uint64_t> versions;
+  std::map<uint64_t, uint64_t> heights;
+  for (const CrawledNode& node : nodes) {
+    if (node.status != "OK") {
+      continue;
+    }
+
+    ++statistics.reached;
+    statistics.maxHeight = std::max<uint64_t>(statistics.maxHeight, node.height);
+    handshakes.push_back(node.handshakeMs);
+    ++versions[node.version];
+    ++heights[node.height];
+  }
+
+  for (const CrawledNode& node : nodes) {
+    if (node.status == "OK" && node.height + CRAWL_BEHIND_BLOCKS < statistics.maxHeight) {
+      ++statistics.behind;
+    }
+  }
+
+  if (!handshakes.empty()) {
+    std::sort(handshakes.begin(), handshakes.end());
+    statistics.handshakeMsMedian = handshakes[handshakes.size() / 2];
+    statistics.handshakeMs90 = handshakes[handshakes.size() * 9 / 10];
+    statistics.handshakeMsMax = handshakes.back();
+  }
+
+  for (const auto& version : versions) {
+    statistics.versions.push_back(CrawlCount{ version.first, version.second });
+  }
+
+  for (auto it = heights.rbegin(); it != heights.rend(); ++it) {
+    statistics.heights.push_back(CrawlCount{ it->first, it->second });
+  }
+
+  return report;
+}
+
+}
@@ -0,0 +1,80 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "crypto/hash.h"
+#include "P2pProtocolTypes.h"
+
+namespace CryptoNote {
+
+class ISerializer;
+
+// one node visited by the network crawler, the peers it advertised are the topology edges
+struct CrawledNode {
+  NetworkAddress address;
+  std::string status;   // "OK" once the handshake succeeded, the error otherwise
+  PeerIdType peerId = 0;
+  uint8_t version = 0;
+  uint32_t height = 0;
+  Crypto::Hash topId = Crypto::Hash();
+  uint64_t connectMs = 0;
+  uint64_t handshakeMs = 0;
+  std::vector<NetworkAddress> peers;
+
+  void serialize(ISerializer& s);
+};
+
+struct CrawlCount {
+  uint64_t value;
+  uint64_t count;
+
+  void serialize(ISerializer& s);
+};
+
+struct CrawlStatistics {
+  uint64_t discovered = 0;
+  uint64_t reached = 0;
+  uint64_t maxHeight = 0;
+  // reached nodes more than a few blocks below the highest one, those are the propagation laggards
+  uint64_t behind = 0;
+  uint64_t handshakeMsMedian = 0;
+  uint64_t handshakeMs90 = 0;
+  uint64_t handshakeMsMax = 0;
+  std::vector<CrawlCount> versions;   // ascending
+  std::vector<CrawlCount> heights;    // highest first
+
+  void serialize(ISerializer& s);
+};
+
+struct CrawlReport {
+  CrawlStatistics statistics;
+  std::vector<CrawledNode> nodes;
+
+  void serialize(ISerializer& s);
+};
+
+// a node counts as behind when it is more than this many blocks below the highest one
+const uint64_t CRAWL_BEHIND_BLOCKS = 2;
+
+CrawlReport makeCrawlReport(const std::vector<CrawledNode>& nodes);
+
+}
@@ -19,6 +19,7 @@
 
 #include "PeerListManager.h"
 
+#include <algorithm>
 #include <time.h>
 #include <boost/foreach.hpp>
 #include <crypto/random.h>
@@ -75,6 +76,7 @@ void PeerlistManager::serialize(ISerializer& s) {
   s(m_peers_white, "whitelist");
   s(m_peers_gray, "graylist");
   s(m_peers_anchor, "anchorlist");
+  ++m_modificationCounter;
 }
 
 size_t PeerlistManager::Peerlist::count() const {
@@ -85,25 +87,28 @@ bool PeerlistManager::Peerlist::get(PeerlistEntry& entry, size_t i) const {
   if (i >= m_peers.size())
     return false;
 
-  peers_indexed::index<by_time>::type& by_time_index = m_peers.get<by_time>();
-
-  auto it = by_time_index.rbegin();
-  std::advance(it, i);
-  entry = *it;
+  // i counts from the most recently seen peer
+  const peers_indexed::index<by_time>::type& by_time_index = m_peers.get<by_time>();
+  entry = *by_time_index.nth(m_peers.size() - 1 - i);
 
   return true;
 }
 
-void PeerlistManager::Peerlist::trim() {
+bool PeerlistManager::Peerlist::trim() {
   peers_indexed::index<by_time>::type& sorted_index = m_peers.get<by_time>();
+  bool trimmed = false;
   while (m_peers.size() > m_maxSize) {
     sorted_index.erase(sorted_index.begin());
+    trimmed = true;
   }
+
+  return trimmed;
 }
 
 PeerlistManager::PeerlistManager() : 
   m_whitePeerlist(m_peers_white, CryptoNote::P2P_LOCAL_WHITE_PEERLIST_LIMIT),
-  m_grayPeerlist(m_peers_gray, CryptoNote::P2P_LOCAL_GRAY_PEERLIST_LIMIT) {}
+  m_grayPeerlist(m_peers_gray, CryptoNote::P2P_LOCAL_GRAY_PEERLIST_LIMIT),
+  m_modificationCounter(0) {}
 
 //--------------------------------------------------------------------------------------------------
 bool PeerlistManager::init(bool allow_local_ip)
@@ -114,18 +119,56 @@ bool PeerlistManager::init(bool allow_local_ip)
 
 //--------------------------------------------------------------------------------------------------
 void PeerlistManager::trim_white_peerlist() {
-  m_whitePeerlist.trim();
+  if (m_whitePeerlist.trim()) {
+    ++m_modificationCounter;
+  }
 }
 //--------------------------------------------------------------------------------------------------
 void PeerlistManager::trim_gray_peerlist() {
-  m_grayPeerlist.trim();
+  if (m_grayPeerlist.trim()) {
+    ++m_modificationCounter;
+  }
 }
 
 //--------------------------------------------------------------------------------------------------
 bool PeerlistManager::merge_peerlist(const std::vector<PeerlistEntry>& outer_bs)
-{ 
-  for(const PeerlistEntry& be : outer_bs) {
-    append_with_peer_gray(be);
+{
+  // the newest entry of every address, in address order like the index it is merged into
+  std::vector<PeerlistEntry> merged;
+  merged.reserve(outer_bs.size());
+  for (const PeerlistEntry& be : outer_bs) {
+    if (is_ip_allowed(be.adr.ip)) {
+      merged.push_back(be);
+    }
+  }
+
+  std::sort(merged.begin(), merged.end(), [](const PeerlistEntry& a, const PeerlistEntry& b) {
+    return a.adr < b.adr || (a.adr == b.adr && a.last_seen > b.last_seen);
+  });
+  merged.erase(std::unique(merged.begin(), merged.end(), [](const PeerlistEntry& a, const PeerlistEntry& b) {
+    return a.adr == b.adr;
+  }), merged.end());
+
+  try {
+    auto& white_by_addr = m_peers_white.get<by_addr>();
+    auto& gray_by_addr = m_peers_gray.get<by_addr>();
+    for (const PeerlistEntry& be : merged) {
+      if (white_by_addr.count(be.adr) != 0) {
+        continue;
+      }
+
+      // entries that are not newer than ours are left alone
+      auto it = gray_by_addr.lower_bound(be.adr);
+      if (it == gray_by_addr.end() || !(it->adr == be.adr)) {
+        gray_by_addr.insert(it, be);
+        ++m_modificationCounter;
+      } else if (it->last_seen < be.last_seen) {
+        gray_by_addr.replace(it, be);
+        ++m_modificationCounter;
+      }
+    }
+  } catch (std::exception&) {
+    return false;
   }
 
   // delete extra elements
@@ -187,6 +230,32 @@ bool PeerlistManager::get_peerlist_head(std::vector<PeerlistEntry>& bs_head, uin
 }
 //--------------------------------------------------------------------------------------------------
 
+bool PeerlistManager::get_peerlist_delta(std::map<NetworkAddress, uint64_t>& sent, std::vector<PeerlistEntry>& delta, uint64_t resendAge, uint32_t depth) const
+{
+  for (const PeerlistEntry& pe : m_peers_white) {
+    if (!pe.last_seen) {
+      continue;
+    }
+
+    auto it = sent.find(pe.adr);
+    if (it == sent.end() || pe.last_seen >= it->second + resendAge) {
+      delta.push_back(pe);
+    }
+  }
+
+  std::shuffle(delta.begin(), delta.end(), Random::gen);
+  if (delta.size() > depth) {
+    delta.resize(depth);
+  }
+
+  for (const PeerlistEntry& pe : delta) {
+    sent[pe.adr] = pe.last_seen;
+  }
+
+  return true;
+}
+//--------------------------------------------------------------------------------------------------
+
 bool PeerlistManager::get_peerlist_full(std::list<AnchorPeerlistEntry>& pl_anchor, std::vector<PeerlistEntry>& pl_gray, std::vector<PeerlistEntry>& pl_white) const
 {
   const anchor_peers_indexed::index<by_time>::type& by_time_index_an = m_peers_anchor.get<by_time>();
@@ -236,6 +305,7 @@ bool PeerlistManager::append_with_peer_anchor(const AnchorPeerlistEntry& ple)
     if (by_addr_it_anchor == m_peers_anchor.get<by_addr>().end()) {
       //put new record into white list
       m_peers_anchor.insert(ple);
+      ++m_modificationCounter;
     }
 
     return true;
@@ -262,6 +332,7 @@ bool PeerlistManager::append_with_peer_white(const PeerlistEntry& ple)
       //update record in white list 
       m_peers_white.replace(by_addr_it_wt, ple);
     }
+    ++m_modificationCounter;
     //remove from gray list, if need
     auto by_addr_it_gr = m_peers_gray.get<by_addr>().find(ple.adr);
     if (by_addr_it_gr != m_peers_gray.get<by_addr>().end()) {
@@ -297,6 +368,7 @@ bool PeerlistManager::append_with_peer_gray(const PeerlistEntry& ple)
       //update record in white list 
       m_peers_gray.replace(by_addr_it_gr, ple);
     }
+    ++m_modificationCounter;
     return true;
   } catch (std::exception&) {
   }
@@ -315,6 +387,7 @@ bool PeerlistManager::get_and_empty_anchor_peerlist(std::vector<AnchorPeerlistEn
     });
 
     m_peers_anchor.get<by_time>().clear();
+    ++m_modificationCounter;
     return true;
   }
   catch (std::exception&) {
@@ -330,6 +403,7 @@ bool PeerlistManager::remove_from_peer_anchor(const NetworkAddress& addr)
 
     if (iterator != m_peers_anchor.get<by_addr>().end()) {
       m_peers_anchor.erase(iterator);
+      ++m_modificationCounter;
     }
 
     return true;
@@ -347,6 +421,7 @@ bool PeerlistManager::remove_from_peer_gray(PeerlistEntry& p)
     auto iterator = m_peers_gray.get<by_addr>().find(p.adr);
     if (iterator != m_peers_gray.get<by_addr>().end()) {
       m_peers_gray.erase(iterator);
+      ++m_modificationCounter;
     }
 
     return true;
@@ -20,9 +20,11 @@
 #pragma once
 
 #include <list>
+#include <map>
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/ranked_index.hpp>
 #include <boost/multi_index/identity.hpp>
 #include <boost/multi_index/member.hpp>
 
@@ -45,8 +47,8 @@ class PeerlistManager {
     boost::multi_index::indexed_by<
     // access by peerlist_entry::net_adress
     boost::multi_index::ordered_unique<boost::multi_index::tag<by_addr>, boost::multi_index::member<PeerlistEntry, NetworkAddress, &PeerlistEntry::adr> >,
-    // sort by peerlist_entry::last_seen<
-    boost::multi_index::ordered_non_unique<boost::multi_index::tag<by_time>, boost::multi_index::member<PeerlistEntry, uint64_t, &PeerlistEntry::last_seen> >
+    // sort by peerlist_entry::last_seen, ranked for O(log n) access by position
+    boost::multi_index::ranked_non_unique<boost::multi_index::tag<by_time>, boost::multi_index::member<PeerlistEntry, uint64_t, &PeerlistEntry::last_seen> >
     >
   > peers_indexed;
 
@@ -67,7 +69,8 @@ public:
     Peerlist(peers_indexed& peers, size_t maxSize);
     size_t count() const;
     bool get(PeerlistEntry& entry, size_t index) const;
-    void trim();
+    // returns whether any peer was dropped
+    bool trim();
 
   private:
     peers_indexed& m_peers;
@@ -79,8 +82,14 @@ public:
   bool init(bool allow_local_ip);
   size_t get_white_peers_count() const { return m_peers_white.size(); }
   size_t get_gray_peers_count() const { return m_peers_gray.size(); }
+  // changes with every modification of the lists, so copies of them can be reused until then
+  uint64_t getModificationCounter() const { return m_modificationCounter; }
   bool merge_peerlist(const std::vector<PeerlistEntry>& outer_bs);
   bool get_peerlist_head(std::vector<PeerlistEntry>& bs_head, uint32_t depth = CryptoNote::P2P_DEFAULT_PEERS_IN_HANDSHAKE) const;
+  // like get_peerlist_head, but only with the white peers not in sent (address -> last_seen sent)
+  // or seen at least resendAge seconds later than when sent, the returned ones are recorded in sent
+  bool get_peerlist_delta(std::map<NetworkAddress, uint64_t>& sent, std::vector<PeerlistEntry>& delta, uint64_t resendAge,
+    uint32_t depth = CryptoNote::P2P_DEFAULT_PEERS_IN_HANDSHAKE) const;
   bool get_peerlist_full(std::list<AnchorPeerlistEntry>& pl_anchor, std::vector<PeerlistEntry>& pl_gray, std::vector<PeerlistEntry>& pl_white) const;
   bool get_white_peer_by_index(PeerlistEntry& p, size_t i) const;
   bool get_gray_peer_by_index(PeerlistEntry& p, size_t i) const;
@@ -111,6 +120,7 @@ private:
   anchor_peers_indexed m_peers_anchor;
   Peerlist m_whitePeerlist;
   Peerlist m_grayPeerlist;
+  uint64_t m_modificationCounter;
 };
 
 }
@@ -15,4 +15,10 @@ namespace CryptoNote
         NOTIFY_NEW_LITE_BLOCK_request request;
         std::unordered_set<Crypto::Hash> missed_transactions;
     };
+
+    struct PendingCompactBlock
+    {
+        NOTIFY_NEW_COMPACT_BLOCK_request request;
+        std::vector<uint32_t> missed_indexes;
+    };
 } // namespace CryptoNote
@@ -0,0 +1,117 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "CryptoTypes.h"
+#include "crypto/random.h"
+
+namespace CryptoNote {
+
+// Remembers roughly the last GENERATION_SIZE..2*GENERATION_SIZE inserted hashes in a fixed amount
+// of memory. Older hashes are forgotten a whole generation at a time. False positives are possible,
+// the salt is per filter so a peer can't grind hashes that collide in everyone's filters.
+class RollingBloomFilter {
+public:
+  static const size_t GENERATION_SIZE = 4096;
+  static const size_t BITS = 65536;                 // per generation, a power of 2
+  static const size_t HASH_COUNT = 11;
+
+  RollingBloomFilter() :
+    m_salt0(Random::randomValue<uint64_t>()),
+    m_salt1(Random::randomValue<uint64_t>()),
+    m_count(0),
+    m_current(BITS / 64, 0),
+    m_previous(BITS / 64, 0) {
+  }
+
+  void insert(const Crypto::Hash& hash) {
+    uint64_t h1, h2;
+    getHashes(hash, h1, h2);
+    if (test(m_current, h1, h2)) {
+      return;
+    }
+
+    if (m_count == GENERATION_SIZE) {
+      m_previous.swap(m_current);
+      std::fill(m_current.begin(), m_current.end(), 0);
+      m_count = 0;
+    }
+
+    for (size_t i = 0; i < HASH_COUNT; ++i) {
+      uint64_t bit = (h1 + i * h2) & (BITS - 1);
+      m_current[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+
+    ++m_count;
+  }
+
+  bool contains(const Crypto::Hash& hash) const {
+    uint64_t h1, h2;
+    getHashes(hash, h1, h2);
+    return test(m_current, h1, h2) || test(m_previous, h1, h2);
+  }
+
+  void clear() {
+    std::fill(m_current.begin(), m_current.end(), 0);
+    std::fill(m_previous.begin(), m_previous.end(), 0);
+    m_count = 0;
+  }
+
+private:
+  static uint64_t mix(uint64_t x) {
+    // splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+  }
+
+  void getHashes(const Crypto::Hash& hash, uint64_t& h1, uint64_t& h2) const {
+    uint64_t words[4];
+    static_assert(sizeof(words) == sizeof(hash.data), "unexpected hash size");
+    memcpy(words, hash.data, sizeof(words));
+    h1 = mix(words[0] ^ mix(words[2] ^ m_salt0));
+    h2 = mix(words[1] ^ mix(words[3] ^ m_salt1)) | 1;
+  }
+
+  static bool test(const std::vector<uint64_t>& bits, uint64_t h1, uint64_t h2) {
+    for (size_t i = 0; i < HASH_COUNT; ++i) {
+      uint64_t bit = (h1 + i * h2) & (BITS - 1);
+      if ((bits[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  uint64_t m_salt0;
+  uint64_t m_salt1;
+  size_t m_count;
+  std::vector<uint64_t> m_current;
+  std::vector<uint64_t> m_previous;
+};
+
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace CryptoNote {
+
+// Byte rate limiter: lets a burst of up to one second worth of traffic through, larger writes
+// go into debt which the caller waits off before the next one. A zero rate means no limit.
+class TokenBucket {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit TokenBucket(uint64_t bytesPerSecond = 0) :
+    m_rate(bytesPerSecond),
+    m_tokens(static_cast<int64_t>(bytesPerSecond)),
+    m_updated(Clock::now()) {
+  }
+
+  void consume(uint64_t bytes) {
+    if (m_rate == 0) {
+      return;
+    }
+
+    refill();
+    m_tokens -= static_cast<int64_t>(bytes);
+  }
+
+  // how long to wait before the next write
+  std::chrono::milliseconds delay() {
+    if (m_rate == 0) {
+      return std::chrono::milliseconds(0);
+    }
+
+    refill();
+    if (m_tokens >= 0) {
+      return std::chrono::milliseconds(0);
+    }
+
+    uint64_t debt = static_cast<uint64_t>(-m_tokens);
+    return std::chrono::milliseconds((debt * 1000 + m_rate - 1) / m_rate);
+  }
+
+private:
+  void refill() {
+    auto now = Clock::now();
+    uint64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - m_updated).count();
+    uint64_t added = m_rate * elapsed / 1000000;
+    if (added == 0) {
+      // keep the fraction for the next call
+      return;
+    }
+
+    m_updated = now;
+    m_tokens += static_cast<int64_t>(added);
+    if (m_tokens > static_cast<int64_t>(m_rate)) {
+      m_tokens = static_cast<int64_t>(m_rate);
+    }
+  }
+
+  uint64_t m_rate;
+  int64_t m_tokens;
+  Clock::time_point m_updated;
+};
+
+}
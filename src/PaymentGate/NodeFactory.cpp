@@ -72,6 +72,11 @@ public:
     callback(std::error_code());
   };
 
+  virtual void getBlockFilters(std::vector<Crypto::Hash>&& knownBlockIds, std::vector<CryptoNote::BlockFilterEntry>& filters,
+    uint32_t& startHeight, const Callback& callback) override {
+    callback(std::make_error_code(std::errc::function_not_supported));
+  }
+
   virtual void getPoolSymmetricDifference(std::vector<Crypto::Hash>&& knownPoolTxIds, Crypto::Hash knownBlockId, bool& isBcActual,
           std::vector<std::unique_ptr<CryptoNote::ITransactionReader>>& newTxs, std::vector<Crypto::Hash>& deletedTxIds, const Callback& callback) override {
     isBcActual = true;
@@ -105,6 +110,7 @@ public:
     const Callback& callback) override { callback(std::error_code()); }
 
   void getBlockTimestamp(uint32_t height, uint64_t& timestamp, const Callback& callback) { callback(std::error_code()); }
+  virtual void getBlockHeightsByTimestamps(const std::vector<uint64_t>& timestamps, std::vector<uint32_t>& heights, const Callback& callback) override { callback(std::error_code()); }
 
   virtual void isSynchronized(bool& syncStatus, const Callback& callback) override { callback(std::error_code()); }
 
@@ -374,6 +374,23 @@ void SendTransaction::Response::serialize(CryptoNote::ISerializer& serializer) {
   serializer(transactionSecretKey, "transactionSecretKey");
 }
 
+void SendTransactions::Request::serialize(CryptoNote::ISerializer& serializer) {
+  if (!serializer(transactions, "transactions")) {
+    throw RequestSerializationError();
+  }
+}
+
+void SendTransactions::Result::serialize(CryptoNote::ISerializer& serializer) {
+  serializer(transactionHash, "transactionHash");
+  serializer(transactionSecretKey, "transactionSecretKey");
+  serializer(errorCode, "errorCode");
+  serializer(errorMessage, "errorMessage");
+}
+
+void SendTransactions::Response::serialize(CryptoNote::ISerializer& serializer) {
+  serializer(results, "results");
+}
+
 void CreateDelayedTransaction::Request::serialize(CryptoNote::ISerializer& serializer) {
   serializer(addresses, "addresses");
 
@@ -460,4 +477,34 @@ void EstimateFusion::Response::serialize(CryptoNote::ISerializer& serializer) {
   serializer(totalOutputCount, "totalOutputCount");
 }
 
+void StartFusion::Request::serialize(CryptoNote::ISerializer& serializer) {
+  if (!serializer(threshold, "threshold")) {
+    throw RequestSerializationError();
+  }
+
+  if (!serializer(anonymity, "anonymity")) {
+    throw RequestSerializationError();
+  }
+
+  serializer(addresses, "addresses");
+}
+
+void StartFusion::Response::serialize(CryptoNote::ISerializer& serializer) {
+}
+
+void StopFusion::Request::serialize(CryptoNote::ISerializer& serializer) {
+}
+
+void StopFusion::Response::serialize(CryptoNote::ISerializer& serializer) {
+}
+
+void GetFusionStatus::Request::serialize(CryptoNote::ISerializer& serializer) {
+}
+
+void GetFusionStatus::Response::serialize(CryptoNote::ISerializer& serializer) {
+  serializer(isActive, "isActive");
+  serializer(transactionCount, "transactionCount");
+  serializer(fusionReadyCount, "fusionReadyCount");
+}
+
 }
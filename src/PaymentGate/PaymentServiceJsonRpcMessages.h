@@ -455,6 +455,30 @@ struct SendTransaction {
   };
 };
 
+struct SendTransactions {
+  struct Request {
+    std::vector<SendTransaction::Request> transactions;
+
+    void serialize(CryptoNote::ISerializer& serializer);
+  };
+
+  // errorCode is 0 for a sent transaction
+  struct Result {
+    std::string transactionHash;
+    std::string transactionSecretKey;
+    int32_t errorCode = 0;
+    std::string errorMessage;
+
+    void serialize(CryptoNote::ISerializer& serializer);
+  };
+
+  struct Response {
+    std::vector<Result> results;
+
+    void serialize(CryptoNote::ISerializer& serializer);
+  };
+};
+
 struct CreateDelayedTransaction {
   struct Request {
     std::vector<std::string> addresses;
@@ -545,4 +569,42 @@ struct EstimateFusion {
   };
 };
 
+struct StartFusion {
+  struct Request {
+    uint64_t threshold;
+    uint32_t anonymity = DEFAULT_ANONYMITY_LEVEL;
+    std::vector<std::string> addresses;
+
+    void serialize(CryptoNote::ISerializer& serializer);
+  };
+
+  struct Response {
+    void serialize(CryptoNote::ISerializer& serializer);
+  };
+};
+
+struct StopFusion {
+  struct Request {
+    void serialize(CryptoNote::ISerializer& serializer);
+  };
+
+  struct Response {
+    void serialize(CryptoNote::ISerializer& serializer);
+  };
+};
+
+struct GetFusionStatus {
+  struct Request {
+    void serialize(CryptoNote::ISerializer& serializer);
+  };
+
+  struct Response {
+    bool isActive;
+    uint32_t transactionCount; // fusion transactions sent since the start
+    uint32_t fusionReadyCount;
+
+    void serialize(CryptoNote::ISerializer& serializer);
+  };
+};
+
 } //namespace PaymentService
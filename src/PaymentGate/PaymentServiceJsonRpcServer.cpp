@@ -53,6 +53,7 @@ PaymentServiceJsonRpcServer::PaymentServiceJsonRpcServer(System::Dispatcher& sys
   handlers.emplace("getTransactionSecretKey", jsonHandler<GetTransactionSecretKey::Request, GetTransactionSecretKey::Response>(std::bind(&PaymentServiceJsonRpcServer::handleGetTransactionSecretKey, this, std::placeholders::_1, std::placeholders::_2)));
   handlers.emplace("getTransactionProof", jsonHandler<GetTransactionProof::Request, GetTransactionProof::Response>(std::bind(&PaymentServiceJsonRpcServer::handleGetTransactionProof, this, std::placeholders::_1, std::placeholders::_2)));
   handlers.emplace("sendTransaction", jsonHandler<SendTransaction::Request, SendTransaction::Response>(std::bind(&PaymentServiceJsonRpcServer::handleSendTransaction, this, std::placeholders::_1, std::placeholders::_2)));
+  handlers.emplace("sendTransactions", jsonHandler<SendTransactions::Request, SendTransactions::Response>(std::bind(&PaymentServiceJsonRpcServer::handleSendTransactions, this, std::placeholders::_1, std::placeholders::_2)));
   handlers.emplace("createDelayedTransaction", jsonHandler<CreateDelayedTransaction::Request, CreateDelayedTransaction::Response>(std::bind(&PaymentServiceJsonRpcServer::handleCreateDelayedTransaction, this, std::placeholders::_1, std::placeholders::_2)));
   handlers.emplace("getDelayedTransactionHashes", jsonHandler<GetDelayedTransactionHashes::Request, GetDelayedTransactionHashes::Response>(std::bind(&PaymentServiceJsonRpcServer::handleGetDelayedTransactionHashes, this, std::placeholders::_1, std::placeholders::_2)));
   handlers.emplace("deleteDelayedTransaction", jsonHandler<DeleteDelayedTransaction::Request, DeleteDelayedTransaction::Response>(std::bind(&PaymentServiceJsonRpcServer::handleDeleteDelayedTransaction, this, std::placeholders::_1, std::placeholders::_2)));
@@ -64,6 +65,9 @@ PaymentServiceJsonRpcServer::PaymentServiceJsonRpcServer(System::Dispatcher& sys
   handlers.emplace("getAddressesCount", jsonHandler<GetAddressesCount::Request, GetAddressesCount::Response>(std::bind(&PaymentServiceJsonRpcServer::handleGetAddressesCount, this, std::placeholders::_1, std::placeholders::_2)));
   handlers.emplace("sendFusionTransaction", jsonHandler<SendFusionTransaction::Request, SendFusionTransaction::Response>(std::bind(&PaymentServiceJsonRpcServer::handleSendFusionTransaction, this, std::placeholders::_1, std::placeholders::_2)));
   handlers.emplace("estimateFusion", jsonHandler<EstimateFusion::Request, EstimateFusion::Response>(std::bind(&PaymentServiceJsonRpcServer::handleEstimateFusion, this, std::placeholders::_1, std::placeholders::_2)));
+  handlers.emplace("startFusion", jsonHandler<StartFusion::Request, StartFusion::Response>(std::bind(&PaymentServiceJsonRpcServer::handleStartFusion, this, std::placeholders::_1, std::placeholders::_2)));
+  handlers.emplace("stopFusion", jsonHandler<StopFusion::Request, StopFusion::Response>(std::bind(&PaymentServiceJsonRpcServer::handleStopFusion, this, std::placeholders::_1, std::placeholders::_2)));
+  handlers.emplace("getFusionStatus", jsonHandler<GetFusionStatus::Request, GetFusionStatus::Response>(std::bind(&PaymentServiceJsonRpcServer::handleGetFusionStatus, this, std::placeholders::_1, std::placeholders::_2)));
   handlers.emplace("validateAddress", jsonHandler<ValidateAddress::Request, ValidateAddress::Response>(std::bind(&PaymentServiceJsonRpcServer::handleValidateAddress, this, std::placeholders::_1, std::placeholders::_2)));
   handlers.emplace("getReserveProof", jsonHandler<GetReserveProof::Request, GetReserveProof::Response>(std::bind(&PaymentServiceJsonRpcServer::handleGetReserveProof, this, std::placeholders::_1, std::placeholders::_2)));
   handlers.emplace("signMessage", jsonHandler<SignMessage::Request, SignMessage::Response>(std::bind(&PaymentServiceJsonRpcServer::handleSignMessage, this, std::placeholders::_1, std::placeholders::_2)));
@@ -236,6 +240,10 @@ std::error_code PaymentServiceJsonRpcServer::handleSendTransaction(const SendTra
   return service.sendTransaction(request, response.transactionHash, response.transactionSecretKey);
 }
 
+std::error_code PaymentServiceJsonRpcServer::handleSendTransactions(const SendTransactions::Request& request, SendTransactions::Response& response) {
+  return service.sendTransactions(request.transactions, response.results);
+}
+
 std::error_code PaymentServiceJsonRpcServer::handleCreateDelayedTransaction(const CreateDelayedTransaction::Request& request, CreateDelayedTransaction::Response& response) {
   return service.createDelayedTransaction(request, response.transactionHash);
 }
@@ -285,5 +293,17 @@ std::error_code PaymentServiceJsonRpcServer::handleEstimateFusion(const Estimate
   return service.estimateFusion(request.threshold, request.addresses, response.fusionReadyCount, response.totalOutputCount);
 }
 
+std::error_code PaymentServiceJsonRpcServer::handleStartFusion(const StartFusion::Request& request, StartFusion::Response& response) {
+  return service.startFusion(request.threshold, request.anonymity, request.addresses);
+}
+
+std::error_code PaymentServiceJsonRpcServer::handleStopFusion(const StopFusion::Request& request, StopFusion::Response& response) {
+  return service.stopFusion();
+}
+
+std::error_code PaymentServiceJsonRpcServer::handleGetFusionStatus(const GetFusionStatus::Request& request, GetFusionStatus::Response& response) {
+  return service.getFusionStatus(response.isActive, response.transactionCount, response.fusionReadyCount);
+}
+
 }
   
\ No newline at end of file
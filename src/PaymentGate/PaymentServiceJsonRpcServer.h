@@ -90,6 +90,7 @@ private:
   std::error_code handleGetTransactionSecretKey(const GetTransactionSecretKey::Request& request, GetTransactionSecretKey::Response& response);
   std::error_code handleGetTransactionProof(const GetTransactionProof::Request& request, GetTransactionProof::Response& response);
   std::error_code handleSendTransaction(const SendTransaction::Request& request, SendTransaction::Response& response);
+  std::error_code handleSendTransactions(const SendTransactions::Request& request, SendTransactions::Response& response);
   std::error_code handleCreateDelayedTransaction(const CreateDelayedTransaction::Request& request, CreateDelayedTransaction::Response& response);
   std::error_code handleGetDelayedTransactionHashes(const GetDelayedTransactionHashes::Request& request, GetDelayedTransactionHashes::Response& response);
   std::error_code handleDeleteDelayedTransaction(const DeleteDelayedTransaction::Request& request, DeleteDelayedTransaction::Response& response);
@@ -105,6 +106,9 @@ private:
   std::error_code handleVerifyMessage(const VerifyMessage::Request& request, VerifyMessage::Response& response);
   std::error_code handleSendFusionTransaction(const SendFusionTransaction::Request& request, SendFusionTransaction::Response& response);
   std::error_code handleEstimateFusion(const EstimateFusion::Request& request, EstimateFusion::Response& response);
+  std::error_code handleStartFusion(const StartFusion::Request& request, StartFusion::Response& response);
+  std::error_code handleStopFusion(const StopFusion::Request& request, StopFusion::Response& response);
+  std::error_code handleGetFusionStatus(const GetFusionStatus::Request& request, GetFusionStatus::Response& response);
 };
 
 }//namespace PaymentService
@@ -40,6 +40,7 @@
 #include "CryptoNoteCore/Account.h"
 
 #include <System/EventLock.h>
+#include <System/ReadWriteLock.h>
 
 #include "PaymentServiceJsonRpcMessages.h"
 
@@ -58,6 +59,9 @@ namespace PaymentService {
 
 namespace {
 
+// events taken from the wallet at once by the refresh loop
+const size_t REFRESH_EVENT_BATCH_SIZE = 256;
+
 bool checkPaymentId(const std::string& paymentId) {
   if (paymentId.size() != 64) {
     return false;
@@ -323,6 +327,31 @@ std::vector<CryptoNote::WalletOrder> convertWalletRpcOrdersToWalletOrders(const
   return result;
 }
 
+CryptoNote::TransactionParameters makeSendParameters(const SendTransaction::Request& request, const CryptoNote::Currency& currency, Logging::LoggerRef logger) {
+  validateAddresses(request.sourceAddresses, currency, logger);
+  validateAddresses(collectDestinationAddresses(request.transfers), currency, logger);
+  if (!request.changeAddress.empty()) {
+    validateAddresses({ request.changeAddress }, currency, logger);
+  }
+  validateMixin(request.anonymity, currency, logger);
+
+  CryptoNote::TransactionParameters sendParams;
+  if (!request.paymentId.empty()) {
+    addPaymentIdToExtra(request.paymentId, sendParams.extra);
+  } else {
+    sendParams.extra = getValidatedTransactionExtraString(request.extra);
+  }
+
+  sendParams.sourceAddresses = request.sourceAddresses;
+  sendParams.destinations = convertWalletRpcOrdersToWalletOrders(request.transfers);
+  sendParams.fee = request.fee;
+  sendParams.mixIn = request.anonymity;
+  sendParams.unlockTimestamp = request.unlockTime;
+  sendParams.changeDestination = request.changeAddress;
+
+  return sendParams;
+}
+
 }
 
 void generateNewWallet(const CryptoNote::Currency& currency, const WalletConfiguration& conf, Logging::ILogger& logger, System::Dispatcher& dispatcher, CryptoNote::INode& node) {
@@ -439,13 +468,21 @@ WalletService::WalletService(const CryptoNote::Currency& currency, System::Dispa
     inited(false),
     logger(logger, "WalletService"),
     dispatcher(sys),
-    readyEvent(dispatcher),
-    refreshContext(dispatcher)
+    readyLock(dispatcher),
+    saveEvent(dispatcher),
+    refreshContext(dispatcher),
+    fusionActive(false),
+    fusionGeneration(0),
+    fusionTransactionCount(0),
+    fusionContext(dispatcher)
 {
-  readyEvent.set();
+  saveEvent.set();
 }
 
 WalletService::~WalletService() {
+  stopFusionPlan();
+  fusionContext.wait();
+
   if (inited) {
     wallet.stop();
     refreshContext.wait();
@@ -483,7 +520,8 @@ void WalletService::loadTransactionIdIndex() {
 
 std::error_code WalletService::saveWalletNoThrow() {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
+    System::EventLock saveLk(saveEvent);
 
     logger(Logging::INFO, Logging::BRIGHT_WHITE) << "Saving wallet...";
 
@@ -506,7 +544,7 @@ std::error_code WalletService::saveWalletNoThrow() {
 
 std::error_code WalletService::resetWallet() {
   try {
-    System::EventLock lk(readyEvent);
+    System::ExclusiveLock lk(readyLock);
 
     logger(Logging::INFO, Logging::BRIGHT_WHITE) << "Resetting wallet";
 
@@ -530,7 +568,7 @@ std::error_code WalletService::resetWallet() {
 
 std::error_code WalletService::resetWallet(const uint32_t scanHeight) {
   try {
-    System::EventLock lk(readyEvent);
+    System::ExclusiveLock lk(readyLock);
 
     logger(Logging::INFO, Logging::BRIGHT_WHITE) << "Resetting wallet";
 
@@ -556,7 +594,8 @@ std::error_code WalletService::resetWallet(const uint32_t scanHeight) {
 
 std::error_code WalletService::exportWallet(const std::string& fileName) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
+    System::EventLock saveLk(saveEvent);
 
     if (!inited) {
       logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Export impossible: Wallet Service is not initialized";
@@ -581,7 +620,7 @@ std::error_code WalletService::exportWallet(const std::string& fileName) {
 
 std::error_code WalletService::replaceWithNewWallet(const std::string& viewSecretKeyText) {
   try {
-    System::EventLock lk(readyEvent);
+    System::ExclusiveLock lk(readyLock);
 
     Crypto::SecretKey viewSecretKey;
     if (!Common::podFromHex(viewSecretKeyText, viewSecretKey)) {
@@ -610,7 +649,7 @@ std::error_code WalletService::replaceWithNewWallet(const std::string& viewSecre
 
 std::error_code WalletService::replaceWithNewWallet(const std::string& viewSecretKeyText, const uint32_t scanHeight) {
   try {
-    System::EventLock lk(readyEvent);
+    System::ExclusiveLock lk(readyLock);
 
     Crypto::SecretKey viewSecretKey;
     if (!Common::podFromHex(viewSecretKeyText, viewSecretKey)) {
@@ -641,7 +680,7 @@ std::error_code WalletService::replaceWithNewWallet(const std::string& viewSecre
 
 std::error_code WalletService::createAddress(const std::string& spendSecretKeyText, bool reset, std::string& address) {
   try {
-    System::EventLock lk(readyEvent);
+    System::ExclusiveLock lk(readyLock);
 
     logger(Logging::DEBUGGING) << "Creating address";
 
@@ -664,7 +703,7 @@ std::error_code WalletService::createAddress(const std::string& spendSecretKeyTe
 
 std::error_code WalletService::createAddress(const std::string& spendSecretKeyText, const uint32_t scanHeight, std::string& address) {
   try {
-    System::EventLock lk(readyEvent);
+    System::ExclusiveLock lk(readyLock);
 
     logger(Logging::DEBUGGING) << "Creating address";
 
@@ -688,7 +727,7 @@ std::error_code WalletService::createAddress(const std::string& spendSecretKeyTe
 
 std::error_code WalletService::createAddressList(const std::vector<std::string>& spendSecretKeysText, bool reset, std::vector<std::string>& addresses) {
   try {
-    System::EventLock lk(readyEvent);
+    System::ExclusiveLock lk(readyLock);
 
     logger(Logging::DEBUGGING) << "Creating " << spendSecretKeysText.size() << " addresses...";
 
@@ -725,7 +764,7 @@ std::error_code WalletService::createAddressList(const std::vector<std::string>&
 
 std::error_code WalletService::createAddressList(const std::vector<std::string>& spendSecretKeysText, const std::vector<uint32_t>& scanHeights, std::vector<std::string>& addresses) {
   try {
-    System::EventLock lk(readyEvent);
+    System::ExclusiveLock lk(readyLock);
 
     logger(Logging::DEBUGGING) << "Creating " << spendSecretKeysText.size() << " addresses...";
 
@@ -763,7 +802,7 @@ std::error_code WalletService::createAddressList(const std::vector<std::string>&
 
 std::error_code WalletService::createAddress(std::string& address) {
   try {
-    System::EventLock lk(readyEvent);
+    System::ExclusiveLock lk(readyLock);
 
     logger(Logging::DEBUGGING) << "Creating address";
 
@@ -780,7 +819,7 @@ std::error_code WalletService::createAddress(std::string& address) {
 
 std::error_code WalletService::createTrackingAddress(const std::string& spendPublicKeyText, std::string& address) {
   try {
-    System::EventLock lk(readyEvent);
+    System::ExclusiveLock lk(readyLock);
 
     logger(Logging::DEBUGGING) << "Creating tracking address";
 
@@ -802,7 +841,7 @@ std::error_code WalletService::createTrackingAddress(const std::string& spendPub
 
 std::error_code WalletService::createTrackingAddress(const std::string& spendPublicKeyText, const uint32_t scanHeight, std::string& address) {
   try {
-    System::EventLock lk(readyEvent);
+    System::ExclusiveLock lk(readyLock);
 
     logger(Logging::DEBUGGING) << "Creating tracking address";
 
@@ -825,7 +864,7 @@ std::error_code WalletService::createTrackingAddress(const std::string& spendPub
 
 std::error_code WalletService::deleteAddress(const std::string& address) {
   try {
-    System::EventLock lk(readyEvent);
+    System::ExclusiveLock lk(readyLock);
 
     logger(Logging::DEBUGGING) << "Delete address request came";
     wallet.deleteAddress(address);
@@ -840,7 +879,7 @@ std::error_code WalletService::deleteAddress(const std::string& address) {
 
 std::error_code WalletService::getSpendkeys(const std::string& address, std::string& publicSpendKeyText, std::string& secretSpendKeyText) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
 
     CryptoNote::KeyPair key = wallet.getAddressSpendKey(address);
 
@@ -857,7 +896,7 @@ std::error_code WalletService::getSpendkeys(const std::string& address, std::str
 
 std::error_code WalletService::getBalance(const std::string& address, uint64_t& availableBalance, uint64_t& lockedAmount) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
     logger(Logging::DEBUGGING) << "Getting balance for address " << address;
 
     availableBalance = wallet.getActualBalance(address);
@@ -873,7 +912,7 @@ std::error_code WalletService::getBalance(const std::string& address, uint64_t&
 
 std::error_code WalletService::getBalance(uint64_t& availableBalance, uint64_t& lockedAmount) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
     logger(Logging::DEBUGGING) << "Getting wallet balance";
 
     availableBalance = wallet.getActualBalance();
@@ -889,7 +928,7 @@ std::error_code WalletService::getBalance(uint64_t& availableBalance, uint64_t&
 
 std::error_code WalletService::getBlockHashes(uint32_t firstBlockIndex, uint32_t blockCount, std::vector<std::string>& blockHashes) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
     std::vector<Crypto::Hash> hashes = wallet.getBlockHashes(firstBlockIndex, blockCount);
 
     blockHashes.reserve(hashes.size());
@@ -906,7 +945,7 @@ std::error_code WalletService::getBlockHashes(uint32_t firstBlockIndex, uint32_t
 
 std::error_code WalletService::getViewKey(std::string& viewSecretKey) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
     CryptoNote::KeyPair viewKey = wallet.getViewKey();
     viewSecretKey = Common::podToHex(viewKey.secretKey);
   } catch (std::system_error& x) {
@@ -919,7 +958,7 @@ std::error_code WalletService::getViewKey(std::string& viewSecretKey) {
 
 std::error_code WalletService::getMnemonicSeed(const std::string& address, std::string& mnemonicSeed) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
     CryptoNote::KeyPair key = wallet.getAddressSpendKey(address);
     CryptoNote::KeyPair viewKey = wallet.getViewKey();
 
@@ -949,7 +988,7 @@ std::error_code WalletService::getMnemonicSeed(const std::string& address, std::
 std::error_code WalletService::getTransactionHashes(const std::vector<std::string>& addresses, const std::string& blockHashString,
   uint32_t blockCount, const std::string& paymentId, std::vector<TransactionHashesInBlockRpcInfo>& transactionHashes) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
     validateAddresses(addresses, currency, logger);
 
     if (!paymentId.empty()) {
@@ -974,7 +1013,7 @@ std::error_code WalletService::getTransactionHashes(const std::vector<std::strin
 std::error_code WalletService::getTransactionHashes(const std::vector<std::string>& addresses, uint32_t firstBlockIndex,
   uint32_t blockCount, const std::string& paymentId, std::vector<TransactionHashesInBlockRpcInfo>& transactionHashes) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
     validateAddresses(addresses, currency, logger);
 
     if (!paymentId.empty()) {
@@ -998,7 +1037,7 @@ std::error_code WalletService::getTransactionHashes(const std::vector<std::strin
 std::error_code WalletService::getTransactions(const std::vector<std::string>& addresses, const std::string& blockHashString,
   uint32_t blockCount, const std::string& paymentId, std::vector<TransactionsInBlockRpcInfo>& transactions) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
     validateAddresses(addresses, currency, logger);
 
     if (!paymentId.empty()) {
@@ -1030,7 +1069,7 @@ std::error_code WalletService::getTransactions(const std::vector<std::string>& a
 std::error_code WalletService::getTransactions(const std::vector<std::string>& addresses, uint32_t firstBlockIndex,
   uint32_t blockCount, const std::string& paymentId, std::vector<TransactionsInBlockRpcInfo>& transactions) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
     validateAddresses(addresses, currency, logger);
 
     if (!paymentId.empty()) {
@@ -1059,7 +1098,7 @@ std::error_code WalletService::getTransactions(const std::vector<std::string>& a
 
 std::error_code WalletService::getTransaction(const std::string& transactionHash, TransactionRpcInfo& transaction) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
     Crypto::Hash hash = parseHash(transactionHash, logger);
 
     CryptoNote::WalletTransactionWithTransfers transactionWithTransfers = wallet.getTransaction(hash);
@@ -1086,7 +1125,7 @@ std::error_code WalletService::getTransaction(const std::string& transactionHash
 
 std::error_code WalletService::getTransactionSecretKey(const std::string& transactionHash, std::string& transactionSecretKey) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
     Crypto::Hash hash = parseHash(transactionHash, logger);
 
     Crypto::SecretKey txSecretKey = wallet.getTransactionSecretKey(hash);
@@ -1111,7 +1150,7 @@ std::error_code WalletService::getTransactionSecretKey(const std::string& transa
 
 std::error_code WalletService::getTransactionProof(const std::string& transactionHash, const std::string& destinationAddress, const std::string& transactionSecretKey, std::string& transactionProof) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
     Crypto::Hash hash = parseHash(transactionHash, logger);
 
     Crypto::SecretKey txSecretKey = wallet.getTransactionSecretKey(hash);
@@ -1165,7 +1204,7 @@ std::error_code WalletService::getTransactionProof(const std::string& transactio
 
 std::error_code WalletService::getReserveProof(std::string& reserveProof, const std::string& address, const std::string& message, const uint64_t& amount) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
 
     uint64_t balance = wallet.getActualBalance(address);
     if (amount != 0 && balance < amount) {
@@ -1187,7 +1226,7 @@ std::error_code WalletService::getReserveProof(std::string& reserveProof, const
 
 std::error_code WalletService::signMessage(const std::string& message, const std::string& address, std::string& signature) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
 
     signature = wallet.signMessage(message, address);
   }
@@ -1204,7 +1243,7 @@ std::error_code WalletService::signMessage(const std::string& message, const std
 
 std::error_code WalletService::verifyMessage(const std::string& message, const std::string& signature, const std::string& address, bool& isValid) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
 
     isValid = wallet.verifyMessage(message, address, signature);
   }
@@ -1221,7 +1260,7 @@ std::error_code WalletService::verifyMessage(const std::string& message, const s
 
 std::error_code WalletService::getAddresses(std::vector<std::string>& addresses) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
 
     addresses.clear();
     addresses.reserve(wallet.getAddressCount());
@@ -1239,7 +1278,7 @@ std::error_code WalletService::getAddresses(std::vector<std::string>& addresses)
 
 std::error_code WalletService::getAddressesCount(size_t& addressesCount) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
 
     addressesCount = wallet.getAddressCount();
   }
@@ -1253,28 +1292,9 @@ std::error_code WalletService::getAddressesCount(size_t& addressesCount) {
 
 std::error_code WalletService::sendTransaction(const SendTransaction::Request& request, std::string& transactionHash, std::string& transactionSecretKey) {
   try {
-    System::EventLock lk(readyEvent);
-
-    validateAddresses(request.sourceAddresses, currency, logger);
-    validateAddresses(collectDestinationAddresses(request.transfers), currency, logger);
-    if (!request.changeAddress.empty()) {
-      validateAddresses({ request.changeAddress }, currency, logger);
-    }
-	validateMixin(request.anonymity, currency, logger);
+    System::ExclusiveLock lk(readyLock);
 
-    CryptoNote::TransactionParameters sendParams;
-    if (!request.paymentId.empty()) {
-      addPaymentIdToExtra(request.paymentId, sendParams.extra);
-    } else {
-      sendParams.extra = getValidatedTransactionExtraString(request.extra);
-    }
-
-    sendParams.sourceAddresses = request.sourceAddresses;
-    sendParams.destinations = convertWalletRpcOrdersToWalletOrders(request.transfers);
-    sendParams.fee = request.fee;
-    sendParams.mixIn = request.anonymity;
-    sendParams.unlockTimestamp = request.unlockTime;
-    sendParams.changeDestination = request.changeAddress;
+    CryptoNote::TransactionParameters sendParams = makeSendParameters(request, currency, logger);
 
 	Crypto::SecretKey tx_key;
     size_t transactionId = wallet.transfer(sendParams, tx_key);
@@ -1293,9 +1313,65 @@ std::error_code WalletService::sendTransaction(const SendTransaction::Request& r
   return std::error_code();
 }
 
+std::error_code WalletService::sendTransactions(const std::vector<SendTransaction::Request>& requests, std::vector<SendTransactions::Result>& results) {
+  try {
+    System::ExclusiveLock lk(readyLock);
+
+    // every transaction is created first, outputs spent by one are not selected for the next ones,
+    // then all of them are relayed together
+    results.assign(requests.size(), SendTransactions::Result());
+    std::vector<size_t> transactionIds;
+    std::vector<size_t> createdRequests;
+    for (size_t i = 0; i < requests.size(); ++i) {
+      try {
+        size_t transactionId = wallet.makeTransaction(makeSendParameters(requests[i], currency, logger));
+        transactionIds.push_back(transactionId);
+        createdRequests.push_back(i);
+      } catch (std::system_error& x) {
+        logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Error while creating transaction " << i << " of batch: " << x.what();
+        results[i].errorCode = x.code().value();
+        results[i].errorMessage = x.code().message();
+      } catch (std::exception& x) {
+        logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Error while creating transaction " << i << " of batch: " << x.what();
+        std::error_code ec = make_error_code(CryptoNote::error::INTERNAL_WALLET_ERROR);
+        results[i].errorCode = ec.value();
+        results[i].errorMessage = ec.message();
+      }
+    }
+
+    std::vector<std::error_code> errors = wallet.commitTransactions(transactionIds);
+    for (size_t i = 0; i < transactionIds.size(); ++i) {
+      SendTransactions::Result& result = results[createdRequests[i]];
+      if (errors[i]) {
+        // a transaction that failed to relay is not left delayed
+        wallet.rollbackUncommitedTransaction(transactionIds[i]);
+        result.errorCode = errors[i].value();
+        result.errorMessage = errors[i].message();
+        continue;
+      }
+
+      CryptoNote::WalletTransaction transaction = wallet.getTransaction(transactionIds[i]);
+      result.transactionHash = Common::podToHex(transaction.hash);
+      if (transaction.secretKey) {
+        result.transactionSecretKey = Common::podToHex(transaction.secretKey.get());
+      }
+
+      logger(Logging::DEBUGGING) << "Transaction " << result.transactionHash << " has been sent";
+    }
+  } catch (std::system_error& x) {
+    logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Error while sending transactions: " << x.what();
+    return x.code();
+  } catch (std::exception& x) {
+    logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Error while sending transactions: " << x.what();
+    return make_error_code(CryptoNote::error::INTERNAL_WALLET_ERROR);
+  }
+
+  return std::error_code();
+}
+
 std::error_code WalletService::createDelayedTransaction(const CreateDelayedTransaction::Request& request, std::string& transactionHash) {
   try {
-    System::EventLock lk(readyEvent);
+    System::ExclusiveLock lk(readyLock);
 
     validateAddresses(request.addresses, currency, logger);
     validateAddresses(collectDestinationAddresses(request.transfers), currency, logger);
@@ -1334,7 +1410,7 @@ std::error_code WalletService::createDelayedTransaction(const CreateDelayedTrans
 
 std::error_code WalletService::getDelayedTransactionHashes(std::vector<std::string>& transactionHashes) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
 
     std::vector<size_t> transactionIds = wallet.getDelayedTransactionIds();
     transactionHashes.reserve(transactionIds.size());
@@ -1356,7 +1432,7 @@ std::error_code WalletService::getDelayedTransactionHashes(std::vector<std::stri
 
 std::error_code WalletService::deleteDelayedTransaction(const std::string& transactionHash) {
   try {
-    System::EventLock lk(readyEvent);
+    System::ExclusiveLock lk(readyLock);
 
     parseHash(transactionHash, logger); //validate transactionHash parameter
 
@@ -1382,7 +1458,7 @@ std::error_code WalletService::deleteDelayedTransaction(const std::string& trans
 
 std::error_code WalletService::sendDelayedTransaction(const std::string& transactionHash) {
   try {
-    System::EventLock lk(readyEvent);
+    System::ExclusiveLock lk(readyLock);
 
     parseHash(transactionHash, logger); //validate transactionHash parameter
 
@@ -1408,7 +1484,7 @@ std::error_code WalletService::sendDelayedTransaction(const std::string& transac
 
 std::error_code WalletService::getUnconfirmedTransactionHashes(const std::vector<std::string>& addresses, std::vector<std::string>& transactionHashes) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
 
     validateAddresses(addresses, currency, logger);
 
@@ -1434,7 +1510,7 @@ std::error_code WalletService::getUnconfirmedTransactionHashes(const std::vector
 
 std::error_code WalletService::getStatus(uint32_t& blockCount, uint32_t& knownBlockCount, uint32_t& localDaemonBlockCount, std::string& lastBlockHash, uint32_t& peerCount, uint64_t& minimalFee) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
 
     knownBlockCount = node.getKnownBlockCount();
     peerCount = static_cast<uint32_t>(node.getPeerCount());
@@ -1457,7 +1533,7 @@ std::error_code WalletService::getStatus(uint32_t& blockCount, uint32_t& knownBl
 
 std::error_code WalletService::validateAddress(const std::string& address, bool& isValid, std::string& _address, std::string& spendPublicKey, std::string& viewPublicKey) {
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
 
     CryptoNote::AccountPublicAddress acc = boost::value_initialized<AccountPublicAddress>();
     if (currency.parseAccountAddressString(address, acc)) {
@@ -1486,7 +1562,7 @@ std::error_code WalletService::sendFusionTransaction(uint64_t threshold, uint32_
   const std::string& destinationAddress, std::string& transactionHash) {
 
   try {
-    System::EventLock lk(readyEvent);
+    System::ExclusiveLock lk(readyLock);
 
     validateAddresses(addresses, currency, logger);
     if (!destinationAddress.empty()) {
@@ -1512,7 +1588,7 @@ std::error_code WalletService::estimateFusion(uint64_t threshold, const std::vec
   uint32_t& fusionReadyCount, uint32_t& totalOutputCount) {
 
   try {
-    System::EventLock lk(readyEvent);
+    System::SharedLock lk(readyLock);
 
     validateAddresses(addresses, currency, logger);
 
@@ -1530,14 +1606,163 @@ std::error_code WalletService::estimateFusion(uint64_t threshold, const std::vec
   return std::error_code();
 }
 
+std::error_code WalletService::startFusion(uint64_t threshold, uint32_t anonymity, const std::vector<std::string>& addresses) {
+  try {
+    System::ExclusiveLock lk(readyLock);
+
+    validateAddresses(addresses, currency, logger);
+    validateMixin(anonymity, currency, logger);
+    if (threshold <= currency.defaultDustThreshold()) {
+      logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Fusion threshold must be greater than " << currency.formatAmount(currency.defaultDustThreshold());
+      return make_error_code(CryptoNote::error::WRONG_PARAMETERS);
+    }
+
+    // throws if an address is not in the container
+    fusionManager.estimate(threshold, addresses);
+
+    stopFusionPlan();
+    fusionPlan.threshold = threshold;
+    fusionPlan.anonymity = anonymity;
+    fusionPlan.addresses = addresses;
+    fusionActive = true;
+    fusionTransactionCount = 0;
+
+    uint64_t generation = fusionGeneration;
+    fusionContext.spawn([this, generation] { runFusion(generation); });
+
+    logger(Logging::INFO, Logging::BRIGHT_WHITE) << "Fusion started, threshold " << currency.formatAmount(threshold) <<
+      ", addresses " << (addresses.empty() ? std::string("all") : std::to_string(addresses.size()));
+  } catch (std::system_error& x) {
+    logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Error while starting fusion: " << x.what();
+    return x.code();
+  } catch (std::exception& x) {
+    logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Error while starting fusion: " << x.what();
+    return make_error_code(CryptoNote::error::INTERNAL_WALLET_ERROR);
+  }
+
+  return std::error_code();
+}
+
+std::error_code WalletService::stopFusion() {
+  if (fusionActive) {
+    logger(Logging::INFO, Logging::BRIGHT_WHITE) << "Fusion stopped, transactions sent " << fusionTransactionCount;
+  }
+
+  stopFusionPlan();
+  return std::error_code();
+}
+
+std::error_code WalletService::getFusionStatus(bool& isActive, uint32_t& transactionCount, uint32_t& fusionReadyCount) {
+  try {
+    System::SharedLock lk(readyLock);
+
+    isActive = fusionActive;
+    transactionCount = static_cast<uint32_t>(fusionTransactionCount);
+    fusionReadyCount = 0;
+    if (fusionPlan.threshold != 0) {
+      fusionReadyCount = static_cast<uint32_t>(fusionManager.estimate(fusionPlan.threshold, fusionPlan.addresses).fusionReadyCount);
+    }
+  } catch (std::system_error& x) {
+    logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Failed to get fusion status: " << x.what();
+    return x.code();
+  } catch (std::exception& x) {
+    logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Failed to get fusion status: " << x.what();
+    return make_error_code(CryptoNote::error::INTERNAL_WALLET_ERROR);
+  }
+
+  return std::error_code();
+}
+
+// The plan is not interrupted, it returns on its own once it sees another generation, since the wallet
+// must not be left in the middle of creating a transaction
+void WalletService::stopFusionPlan() {
+  ++fusionGeneration;
+  fusionActive = false;
+}
+
+void WalletService::runFusion(uint64_t generation) {
+  try {
+    System::Timer timer(dispatcher);
+    while (generation == fusionGeneration) {
+      uint32_t height = node.getLastKnownBlockHeight();
+      bool finished;
+      {
+        System::ExclusiveLock lk(readyLock);
+        if (generation != fusionGeneration) {
+          return;
+        }
+
+        finished = sendFusionTransactions(generation);
+      }
+
+      if (finished) {
+        logger(Logging::INFO, Logging::BRIGHT_WHITE) << "Fusion finished, transactions sent " << fusionTransactionCount;
+        break;
+      }
+
+      // the outputs spent or received by this round become usable in the following blocks
+      while (generation == fusionGeneration && node.getLastKnownBlockHeight() == height) {
+        timer.sleep(std::chrono::seconds(1));
+      }
+    }
+  } catch (std::exception& e) {
+    logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Fusion is stopped: " << e.what();
+  }
+
+  if (generation == fusionGeneration) {
+    fusionActive = false;
+  }
+}
+
+// Sends as many fusion transactions as a block takes, returns true if nothing is left to optimize
+bool WalletService::sendFusionTransactions(uint64_t generation) {
+  size_t transactionBudget = std::max<size_t>(1, currency.blockGrantedFullRewardZone() / currency.fusionTxMaxSize());
+
+  std::vector<std::string> addresses = fusionPlan.addresses;
+  if (addresses.empty()) {
+    size_t addressCount = wallet.getAddressCount();
+    addresses.reserve(addressCount);
+    for (size_t i = 0; i < addressCount; ++i) {
+      addresses.push_back(wallet.getAddress(i));
+    }
+  }
+
+  bool hasLockedOutputs = false;
+  for (const auto& address : addresses) {
+    if (transactionBudget == 0 || generation != fusionGeneration) {
+      return false;
+    }
+
+    try {
+      std::vector<size_t> transactionIds = fusionManager.createFusionTransactions(fusionPlan.threshold, fusionPlan.anonymity,
+        transactionBudget, { address }, address);
+      for (size_t transactionId : transactionIds) {
+        ++fusionTransactionCount;
+        --transactionBudget;
+        logger(Logging::DEBUGGING) << "Fusion transaction " << Common::podToHex(wallet.getTransaction(transactionId).hash) << " has been sent";
+      }
+
+      hasLockedOutputs = hasLockedOutputs || wallet.getPendingBalance(address) != 0;
+    } catch (std::exception& x) {
+      logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Failed to optimize address " << address << ": " << x.what();
+    }
+  }
+
+  return transactionBudget != 0 && !hasLockedOutputs;
+}
+
 void WalletService::refresh() {
   try {
     logger(Logging::DEBUGGING) << "Refresh is started";
     for (;;) {
-      auto event = wallet.getEvent();
-      if (event.type == CryptoNote::TRANSACTION_CREATED) {
-        size_t transactionId = event.transactionCreated.transactionIndex;
-        transactionIdIndex.emplace(Common::podToHex(wallet.getTransaction(transactionId).hash), transactionId);
+      for (const auto& event : wallet.getEvents(REFRESH_EVENT_BATCH_SIZE)) {
+        if (event.type == CryptoNote::TRANSACTION_CREATED) {
+          size_t transactionId = event.transactionCreated.transactionIndex;
+          transactionIdIndex.emplace(Common::podToHex(wallet.getTransaction(transactionId).hash), transactionId);
+        } else if (event.type == CryptoNote::EVENTS_DROPPED) {
+          logger(Logging::DEBUGGING) << "Wallet events are dropped, reloading transaction index";
+          loadTransactionIdIndex();
+        }
       }
     }
   } catch (std::system_error& e) {
@@ -1548,6 +1773,7 @@ void WalletService::refresh() {
 }
 
 void WalletService::reset() {
+  stopFusionPlan();
   wallet.save(CryptoNote::WalletSaveLevel::SAVE_KEYS_ONLY);
   wallet.stop();
   wallet.shutdown();
@@ -1559,6 +1785,7 @@ void WalletService::reset() {
 }
 
 void WalletService::replaceWithNewWallet(const Crypto::SecretKey& viewSecretKey, const uint32_t scanHeight) {
+  stopFusionPlan();
   wallet.stop();
   wallet.shutdown();
   inited = false;
@@ -1587,6 +1814,7 @@ void WalletService::replaceWithNewWallet(const Crypto::SecretKey& viewSecretKey,
 }
 
 void WalletService::replaceWithNewWallet(const Crypto::SecretKey& viewSecretKey) {
+  stopFusionPlan();
   wallet.stop();
   wallet.shutdown();
   inited = false;
@@ -1614,8 +1842,9 @@ void WalletService::replaceWithNewWallet(const Crypto::SecretKey& viewSecretKey)
   inited = true;
 }
 
-std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(const Crypto::Hash& blockHash, size_t blockCount) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> result = wallet.getTransactions(blockHash, blockCount);
+std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(const Crypto::Hash& blockHash, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
+  std::vector<std::string> addresses(filter.addresses.begin(), filter.addresses.end());
+  std::vector<CryptoNote::TransactionsInBlockInfo> result = wallet.getTransactions(blockHash, blockCount, addresses, filter.havePaymentId ? &filter.paymentId : nullptr);
   if (result.empty()) {
     throw std::system_error(make_error_code(CryptoNote::error::WalletServiceErrorCode::OBJECT_NOT_FOUND));
   }
@@ -1623,8 +1852,9 @@ std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(
   return result;
 }
 
-std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(uint32_t firstBlockIndex, size_t blockCount) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> result = wallet.getTransactions(firstBlockIndex, blockCount);
+std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
+  std::vector<std::string> addresses(filter.addresses.begin(), filter.addresses.end());
+  std::vector<CryptoNote::TransactionsInBlockInfo> result = wallet.getTransactions(firstBlockIndex, blockCount, addresses, filter.havePaymentId ? &filter.paymentId : nullptr);
   if (result.empty()) {
     throw std::system_error(make_error_code(CryptoNote::error::WalletServiceErrorCode::OBJECT_NOT_FOUND));
   }
@@ -1633,25 +1863,25 @@ std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(
 }
 
 std::vector<TransactionHashesInBlockRpcInfo> WalletService::getRpcTransactionHashes(const Crypto::Hash& blockHash, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(blockHash, blockCount);
+  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(blockHash, blockCount, filter);
   std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
   return convertTransactionsInBlockInfoToTransactionHashesInBlockRpcInfo(filteredTransactions);
 }
 
 std::vector<TransactionHashesInBlockRpcInfo> WalletService::getRpcTransactionHashes(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(firstBlockIndex, blockCount);
+  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(firstBlockIndex, blockCount, filter);
   std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
   return convertTransactionsInBlockInfoToTransactionHashesInBlockRpcInfo(filteredTransactions);
 }
 
 std::vector<TransactionsInBlockRpcInfo> WalletService::getRpcTransactions(const Crypto::Hash& blockHash, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(blockHash, blockCount);
+  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(blockHash, blockCount, filter);
   std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
   return convertTransactionsInBlockInfoToTransactionsInBlockRpcInfo(filteredTransactions);
 }
 
 std::vector<TransactionsInBlockRpcInfo> WalletService::getRpcTransactions(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(firstBlockIndex, blockCount);
+  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(firstBlockIndex, blockCount, filter);
   std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
   return convertTransactionsInBlockInfoToTransactionsInBlockRpcInfo(filteredTransactions);
 }
@@ -23,6 +23,7 @@
 #include <System/ContextGroup.h>
 #include <System/Dispatcher.h>
 #include <System/Event.h>
+#include <System/ReadWriteLock.h>
 #include "IWallet.h"
 #include "INode.h"
 #include "CryptoNoteCore/Currency.h"
@@ -102,6 +103,7 @@ public:
   std::error_code getAddresses(std::vector<std::string>& addresses);
   std::error_code getAddressesCount(size_t& addressesCount);
   std::error_code sendTransaction(const SendTransaction::Request& request, std::string& transactionHash, std::string& transactionSecretKey);
+  std::error_code sendTransactions(const std::vector<SendTransaction::Request>& requests, std::vector<SendTransactions::Result>& results);
   std::error_code createDelayedTransaction(const CreateDelayedTransaction::Request& request, std::string& transactionHash);
   std::error_code getDelayedTransactionHashes(std::vector<std::string>& transactionHashes);
   std::error_code deleteDelayedTransaction(const std::string& transactionHash);
@@ -111,6 +113,9 @@ public:
   std::error_code sendFusionTransaction(uint64_t threshold, uint32_t anonymity, const std::vector<std::string>& addresses,
     const std::string& destinationAddress, std::string& transactionHash);
   std::error_code estimateFusion(uint64_t threshold, const std::vector<std::string>& addresses, uint32_t& fusionReadyCount, uint32_t& totalOutputCount);
+  std::error_code startFusion(uint64_t threshold, uint32_t anonymity, const std::vector<std::string>& addresses);
+  std::error_code stopFusion();
+  std::error_code getFusionStatus(bool& isActive, uint32_t& transactionCount, uint32_t& fusionReadyCount);
   std::error_code validateAddress(const std::string& address, bool& isValid, std::string& _address, std::string& spendPublicKey, std::string& viewPublicKey);
   std::error_code getReserveProof(std::string& reserveProof, const std::string& address, const std::string& message, const uint64_t& amount = 0);
   std::error_code signMessage(const std::string& message, const std::string& address, std::string& signature);
@@ -120,14 +125,18 @@ private:
   void refresh();
   void reset();
 
+  void runFusion(uint64_t generation);
+  bool sendFusionTransactions(uint64_t generation);
+  void stopFusionPlan();
+
   void loadWallet();
   void loadTransactionIdIndex();
 
   void replaceWithNewWallet(const Crypto::SecretKey& viewSecretKey);
   void replaceWithNewWallet(const Crypto::SecretKey& viewSecretKey, const uint32_t scanHeight);
 
-  std::vector<CryptoNote::TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t blockCount) const;
-  std::vector<CryptoNote::TransactionsInBlockInfo> getTransactions(uint32_t firstBlockIndex, size_t blockCount) const;
+  std::vector<CryptoNote::TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const;
+  std::vector<CryptoNote::TransactionsInBlockInfo> getTransactions(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const;
 
   std::vector<TransactionHashesInBlockRpcInfo> getRpcTransactionHashes(const Crypto::Hash& blockHash, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const;
   std::vector<TransactionHashesInBlockRpcInfo> getRpcTransactionHashes(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const;
@@ -143,10 +152,25 @@ private:
   bool inited;
   Logging::LoggerRef logger;
   System::Dispatcher& dispatcher;
-  System::Event readyEvent;
+  // reads share the wallet, changes to it take it alone
+  System::ReadWriteLock readyLock;
+  System::Event saveEvent;      // one save or export at a time, they only read the wallet
   System::ContextGroup refreshContext;
 
   std::map<std::string, size_t> transactionIdIndex;
+
+  // fusion transactions sent by walletd itself, every address is optimized into itself
+  struct FusionPlan {
+    uint64_t threshold = 0;
+    uint32_t anonymity = 0;
+    std::vector<std::string> addresses; // all addresses of the container if empty
+  };
+
+  FusionPlan fusionPlan;
+  bool fusionActive;
+  uint64_t fusionGeneration; // incremented on every start and stop, a running plan of another generation returns
+  size_t fusionTransactionCount;
+  System::ContextGroup fusionContext;
 };
 
 } //namespace PaymentService
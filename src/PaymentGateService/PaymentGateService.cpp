@@ -35,6 +35,7 @@
 #include "P2p/NetNode.h"
 #include "Rpc/RpcServer.h"
 #include <System/Context.h>
+#include <System/ContextGroup.h>
 #include "Wallet/WalletGreen.h"
 
 #ifdef ERROR
@@ -325,6 +326,11 @@ void PaymentGateService::runRpcProxy(Logging::LoggerRef& log) {
 }
 
 void PaymentGateService::runWalletService(const CryptoNote::Currency& currency, CryptoNote::INode& node) {
+  if (!config.gateConfiguration.containersFile.empty()) {
+    runHostedWallets(currency, node);
+    return;
+  }
+
   PaymentService::WalletConfiguration walletConfiguration{
     config.gateConfiguration.containerFile,
     config.gateConfiguration.containerPassword
@@ -388,3 +394,55 @@ void PaymentGateService::runWalletService(const CryptoNote::Currency& currency,
     }
   }
 }
+
+void PaymentGateService::runHostedWallets(const CryptoNote::Currency& currency, CryptoNote::INode& node) {
+  Logging::LoggerRef log(logger, "PaymentGateService");
+
+  std::vector<PaymentService::HostedContainer> containers;
+  try {
+    containers = PaymentService::loadHostedContainers(config.gateConfiguration.containersFile);
+  } catch (std::exception& e) {
+    log(Logging::ERROR, Logging::BRIGHT_RED) << e.what();
+    return;
+  }
+
+  // blocks are downloaded once and handed to the consumers of every container
+  CryptoNote::SharedBlockchainSynchronizer synchronizer(node, logger, currency.genesisBlockHash());
+  std::vector<std::unique_ptr<CryptoNote::WalletGreen>> wallets;
+  std::vector<std::unique_ptr<PaymentService::WalletService>> services;
+  for (const auto& container : containers) {
+    PaymentService::WalletConfiguration walletConfiguration{ container.containerFile, container.containerPassword };
+    wallets.emplace_back(new CryptoNote::WalletGreen(*dispatcher, currency, node, synchronizer, logger));
+    services.emplace_back(new PaymentService::WalletService(currency, *dispatcher, node, *wallets.back(), *wallets.back(), walletConfiguration, logger));
+    try {
+      services.back()->init();
+    } catch (std::exception& e) {
+      log(Logging::ERROR, Logging::BRIGHT_RED) << "Failed to init walletService for " << container.containerFile << " reason: " << e.what();
+      return;
+    }
+  }
+
+  std::vector<std::unique_ptr<PaymentService::PaymentServiceJsonRpcServer>> rpcServers;
+  System::ContextGroup serverContexts(*dispatcher);
+  for (size_t i = 0; i < containers.size(); ++i) {
+    rpcServers.emplace_back(new PaymentService::PaymentServiceJsonRpcServer(*dispatcher, *stopEvent, *services[i], logger));
+    PaymentService::PaymentServiceJsonRpcServer& rpcServer = *rpcServers.back();
+    uint16_t bindPort = containers[i].bindPort;
+    log(Logging::INFO) << "Serving " << containers[i].containerFile << " on port " << bindPort;
+    serverContexts.spawn([this, &rpcServer, bindPort] {
+      rpcServer.start(config.gateConfiguration.m_bind_address, bindPort, 0, false,
+        config.gateConfiguration.m_rpcUser, config.gateConfiguration.m_rpcPassword);
+    });
+  }
+
+  serverContexts.wait();
+  log(Logging::INFO, Logging::BRIGHT_WHITE) << "JSON-RPC servers stopped, stopping wallet services...";
+
+  for (size_t i = 0; i < services.size(); ++i) {
+    try {
+      services[i]->saveWallet();
+    } catch (std::exception& ex) {
+      Logging::LoggerRef(logger, "saveWallet")(Logging::WARNING, Logging::YELLOW) << "Couldn't save container " << containers[i].containerFile << ": " << ex.what();
+    }
+  }
+}
@@ -22,6 +22,8 @@
 
 #include <iostream>
 #include <algorithm>
+#include <fstream>
+#include <sstream>
 #include <boost/program_options.hpp>
 
 #include "Logging/ILogger.h"
@@ -73,6 +75,7 @@ void Configuration::initOptions(po::options_description& desc) {
       ("rpc-dh-file", po::value<std::string>()->default_value(std::string(CryptoNote::RPC_DEFAULT_DH_FILE)), "SSL DH file")
       ("container-file,w", po::value<std::string>(), "container file")
       ("container-password,p", po::value<std::string>(), "container password")
+      ("containers-file", po::value<std::string>(), "serve several containers synchronized together, one \"<container file> <bind port> <password>\" per line")
       ("change-password", po::value<std::string>(), "change container password and exit")
       ("generate-container,g", "generate new container file with one wallet and exit")
       ("view-key", po::value<std::string>(), "generate a container with this secret key view")
@@ -176,6 +179,10 @@ void Configuration::init(const po::variables_map& options) {
     containerPassword = options["container-password"].as<std::string>();
   }
 
+  if (options.count("containers-file") != 0) {
+    containersFile = options["containers-file"].as<std::string>();
+  }
+
   if (options.count("change-password") != 0) {
     changePassword = true;
     newContainerPassword = options["change-password"].as<std::string>();
@@ -217,7 +224,7 @@ void Configuration::init(const po::variables_map& options) {
     printAddresses = true;
   }
 
-  if (!registerService && !unregisterService) {
+  if (!registerService && !unregisterService && containersFile.empty()) {
     if (containerFile.empty() && containerPassword.empty()) {
       throw ConfigurationError("Both container-file and container-password parameters are required");
     }
@@ -230,4 +237,37 @@ void Configuration::init(const po::variables_map& options) {
   }
 }
 
+std::vector<HostedContainer> loadHostedContainers(const std::string& path) {
+  std::ifstream file(path);
+  if (!file) {
+    throw ConfigurationError(("Failed to open containers file " + path).c_str());
+  }
+
+  std::vector<HostedContainer> containers;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream fields(line);
+    HostedContainer container;
+    if (!(fields >> container.containerFile) || container.containerFile[0] == '#') {
+      continue;
+    }
+
+    unsigned port = 0;
+    if (!(fields >> port) || port == 0 || port > 0xffff) {
+      throw ConfigurationError(("Invalid bind port for container " + container.containerFile).c_str());
+    }
+
+    container.bindPort = static_cast<uint16_t>(port);
+    fields >> std::ws;
+    std::getline(fields, container.containerPassword);
+    containers.push_back(container);
+  }
+
+  if (containers.empty()) {
+    throw ConfigurationError(("No containers listed in " + path).c_str());
+  }
+
+  return containers;
+}
+
 } //namespace PaymentService
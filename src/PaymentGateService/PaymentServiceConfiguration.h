@@ -23,6 +23,7 @@
 #include <string>
 #include <stdexcept>
 #include <cstdint>
+#include <vector>
 
 #include <boost/program_options.hpp>
 
@@ -57,6 +58,7 @@ struct Configuration {
 
   std::string containerFile;
   std::string containerPassword;
+  std::string containersFile;
   std::string newContainerPassword;
   std::string logFile;
   std::string serverRoot;
@@ -78,4 +80,14 @@ struct Configuration {
   uint32_t scanHeight;
 };
 
+// a container served by the same walletd process as the others listed in containers-file
+struct HostedContainer {
+  std::string containerFile;
+  std::string containerPassword;
+  uint16_t bindPort;
+};
+
+// one "<container file> <bind port> <password>" per line, blank lines and lines starting with '#' are skipped
+std::vector<HostedContainer> loadHostedContainers(const std::string& path);
+
 } //namespace PaymentService
@@ -67,9 +67,13 @@ public:
   void pushContext(NativeContext* context);
   void remoteSpawn(std::function<void()>&& procedure);
   void yield();
+  // contexts spawned and not finished yet
+  size_t getRunningContextCount() const;
+  // contexts ready to run, waiting for the current one to yield
+  size_t getResumingContextCount() const;
 
   int getKqueue() const;
-  NativeContext& getReusableContext();
+  NativeContext& getReusableContext(size_t stackSize = 0);
   void pushReusableContext(NativeContext&);
   int getTimer();
   void pushTimer(int timer);
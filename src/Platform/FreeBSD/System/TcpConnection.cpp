@@ -16,6 +16,7 @@
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "TcpConnection.h"
+#include <algorithm>
 #include <cassert>
 
 #include <netinet/in.h>
@@ -24,6 +25,7 @@
 #include <sys/event.h>
 #include <sys/errno.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "Dispatcher.h"
@@ -33,6 +35,12 @@
 
 namespace System {
 
+namespace {
+
+const std::size_t MAX_WRITE_BUFFERS = 64;
+
+}
+
 TcpConnection::TcpConnection() : dispatcher(nullptr) {
 }
 
@@ -146,12 +154,28 @@ size_t TcpConnection::read(uint8_t* data, size_t size) {
 }
 
 size_t TcpConnection::write(const uint8_t* data, size_t size) {
+  std::pair<const uint8_t*, std::size_t> buffer(data, size);
+  return writev(&buffer, 1);
+}
+
+std::size_t TcpConnection::writev(const std::pair<const uint8_t*, std::size_t>* buffers, std::size_t count) {
   assert(dispatcher != nullptr);
   assert(writeContext == nullptr);
   if (dispatcher->interrupted()) {
     throw InterruptedException();
   }
 
+  iovec vectors[MAX_WRITE_BUFFERS];
+  msghdr messageHeader = {};
+  messageHeader.msg_iov = vectors;
+  messageHeader.msg_iovlen = static_cast<int>(std::min(count, MAX_WRITE_BUFFERS));
+  size_t size = 0;
+  for (size_t i = 0; i < static_cast<size_t>(messageHeader.msg_iovlen); ++i) {
+    vectors[i].iov_base = const_cast<uint8_t*>(buffers[i].first);
+    vectors[i].iov_len = buffers[i].second;
+    size += buffers[i].second;
+  }
+
   std::string message;
   if (size == 0) {
     if (shutdown(connection, SHUT_WR) == -1) {
@@ -161,7 +185,7 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
     return 0;
   }
 
-  ssize_t transferred = ::send(connection, (void *)data, size, 0);
+  ssize_t transferred = ::sendmsg(connection, &messageHeader, 0);
   if (transferred == -1) {
     if (errno != EAGAIN  && errno != EWOULDBLOCK) {
       message = "send failed, " + lastErrorMessage();
@@ -203,7 +227,7 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
           throw InterruptedException();
         }
 
-        ssize_t transferred = ::send(connection, (void *)data, size, 0);
+        ssize_t transferred = ::sendmsg(connection, &messageHeader, 0);
         if (transferred == -1) {
           message = "send failed, " + lastErrorMessage();
         } else {
@@ -36,6 +36,8 @@ public:
   TcpConnection& operator=(TcpConnection&& other);
   std::size_t read(uint8_t* data, std::size_t size);
   std::size_t write(const uint8_t* data, std::size_t size);
+  // the buffers go out in one send, the result may end inside any of them
+  std::size_t writev(const std::pair<const uint8_t*, std::size_t>* buffers, std::size_t count);
   std::pair<Ipv4Address, uint16_t> getPeerAddressAndPort() const;
 
 private:
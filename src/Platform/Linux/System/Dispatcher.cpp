@@ -16,6 +16,7 @@
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Dispatcher.h"
+#include <algorithm>
 #include <cassert>
 
 #include <sys/epoll.h>
@@ -24,8 +25,16 @@
 #include <fcntl.h>
 #include <stdexcept>
 #include <string.h>
+#include <sys/mman.h>
+#include <time.h>
 #include <ucontext.h>
 #include <unistd.h>
+#ifdef DISPATCHER_IO_URING
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/syscall.h>
+#include <System/InterruptedException.h>
+#endif
 #include "ErrorMessage.h"
 
 namespace System {
@@ -37,40 +46,280 @@ struct ContextMakingData {
   void* ucontext;
 };
 
-class MutextGuard {
-public:
-  MutextGuard(pthread_mutex_t& _mutex) : mutex(_mutex) {
-    auto ret = pthread_mutex_lock(&mutex);
-    if (ret != 0) {
-      throw std::runtime_error("pthread_mutex_lock failed, " + errorMessage(ret));
-    }
+const uint64_t TICK_NANOSECONDS = 1000000;
+
+uint64_t monotonicTime() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+uint64_t currentTick() {
+  return monotonicTime() / TICK_NANOSECONDS;
+}
+
+size_t roundToPages(size_t size) {
+  static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return (size + pageSize - 1) / pageSize * pageSize;
+}
+
+// The stack is reserved without committing memory, pages are backed as the context
+// touches them. The lowest page is left inaccessible so that an overflow faults
+// instead of overwriting the neighbouring allocation.
+uint8_t* allocateStack(size_t size) {
+  size_t guardSize = roundToPages(1);
+  void* base = mmap(nullptr, size + guardSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+  if (base == MAP_FAILED) {
+    throw std::runtime_error("mmap failed, " + lastErrorMessage());
   }
 
-  ~MutextGuard() {
-    pthread_mutex_unlock(&mutex);
+  if (mprotect(base, guardSize, PROT_NONE) == -1) {
+    std::string message = lastErrorMessage();
+    munmap(base, size + guardSize);
+    throw std::runtime_error("mprotect failed, " + message);
   }
 
-private:
-  pthread_mutex_t& mutex;
+  return static_cast<uint8_t*>(base);
+}
+
+void freeStack(void* base, size_t size) {
+  auto result = munmap(base, size + roundToPages(1));
+  assert(result == 0);
+  (void)result;
+}
+
+#if defined(__x86_64__) && !defined(DISPATCHER_UCONTEXT)
+
+// glibc swapcontext saves and restores the signal mask with a syscall on every switch,
+// the dispatcher never changes the mask, so only the registers the ABI requires a callee
+// to preserve are switched: they are pushed on the suspended stack, the context is its
+// stack pointer. A new stack starts in the trampoline, which calls entry(arg).
+asm(
+  ".text\n"
+  ".globl system_switch_context\n"
+  ".type system_switch_context, @function\n"
+  "system_switch_context:\n"
+  "  pushq %rbp\n"
+  "  pushq %rbx\n"
+  "  pushq %r12\n"
+  "  pushq %r13\n"
+  "  pushq %r14\n"
+  "  pushq %r15\n"
+  "  subq $16, %rsp\n"
+  "  stmxcsr 8(%rsp)\n"
+  "  fnstcw (%rsp)\n"
+  "  movq %rsp, (%rdi)\n"
+  "  movq %rsi, %rsp\n"
+  "  ldmxcsr 8(%rsp)\n"
+  "  fldcw (%rsp)\n"
+  "  addq $16, %rsp\n"
+  "  popq %r15\n"
+  "  popq %r14\n"
+  "  popq %r13\n"
+  "  popq %r12\n"
+  "  popq %rbx\n"
+  "  popq %rbp\n"
+  "  ret\n"
+  ".size system_switch_context, .-system_switch_context\n"
+  ".globl system_context_trampoline\n"
+  ".type system_context_trampoline, @function\n"
+  "system_context_trampoline:\n"
+  "  .cfi_startproc\n"
+  "  .cfi_undefined rip\n"
+  "  movq %r13, %rdi\n"
+  "  callq *%r12\n"
+  "  ud2\n"
+  "  .cfi_endproc\n"
+  ".size system_context_trampoline, .-system_context_trampoline\n"
+);
+
+extern "C" void system_switch_context(void** from, void* to);
+extern "C" void system_context_trampoline();
+
+struct Context {
+  void* stackPointer;
 };
 
-static_assert(Dispatcher::SIZEOF_PTHREAD_MUTEX_T == sizeof(pthread_mutex_t), "invalid pthread mutex size");
+Context* createContext() {
+  return new Context{nullptr};
+}
+
+void makeContext(Context* context, uint8_t* stack, size_t size, void (*entry)(void*), void* arg) {
+  // the trampoline is entered with a 16 byte aligned stack, as if it had been called
+  uintptr_t top = (reinterpret_cast<uintptr_t>(stack) + size) & ~static_cast<uintptr_t>(15);
+  uint64_t* frame = reinterpret_cast<uint64_t*>(top) - 9;
+  frame[0] = 0x037f; // x87 control word and MXCSR at their defaults
+  frame[1] = 0x1f80;
+  frame[2] = 0; // r15
+  frame[3] = 0; // r14
+  frame[4] = reinterpret_cast<uint64_t>(arg); // r13
+  frame[5] = reinterpret_cast<uint64_t>(entry); // r12
+  frame[6] = 0; // rbx
+  frame[7] = 0; // rbp
+  frame[8] = reinterpret_cast<uint64_t>(&system_context_trampoline);
+  context->stackPointer = frame;
+}
+
+void switchContext(Context* from, Context* to, const char*) {
+  system_switch_context(&from->stackPointer, to->stackPointer);
+}
+
+#else
+
+typedef ucontext_t Context;
+
+Context* createContext() {
+  Context* context = new ucontext_t;
+  if (getcontext(context) == -1) {
+    std::string message = lastErrorMessage();
+    delete context;
+    throw std::runtime_error("getcontext failed, " + message);
+  }
+
+  return context;
+}
+
+void makeContext(Context* context, uint8_t* stack, size_t size, void (*entry)(void*), void* arg) {
+  context->uc_stack.ss_sp = stack;
+  context->uc_stack.ss_size = size;
+  makecontext(context, (void(*)())entry, 1, reinterpret_cast<int*>(arg));
+}
+
+void switchContext(Context* from, Context* to, const char* caller) {
+  if (swapcontext(from, to) == -1) {
+    throw std::runtime_error(std::string(caller) + ", swapcontext failed, " + lastErrorMessage());
+  }
+}
 
-//const size_t STACK_SIZE = 64 * 1024;
-const size_t STACK_SIZE = 512 * 1024;
+#endif
+
+#ifdef DISPATCHER_IO_URING
+
+const unsigned RING_ENTRIES = 512;
+// user_data of the poll on the epoll descriptor, entries without a waiting context carry 0
+const uint64_t EPOLL_ENTRY = 1;
+
+#endif
 
 };
 
+#ifdef DISPATCHER_IO_URING
+
+struct IoRing {
+  int fd;
+  void* sqMap;
+  size_t sqMapSize;
+  void* cqMap;
+  size_t cqMapSize;
+  io_uring_sqe* sqes;
+  size_t sqesSize;
+  unsigned* sqHead;
+  unsigned* sqTail;
+  unsigned sqMask;
+  unsigned sqEntries;
+  unsigned tail; // entries up to here are filled, the kernel sees them on the next submit
+  unsigned* cqHead;
+  unsigned* cqTail;
+  unsigned cqMask;
+  io_uring_cqe* cqes;
+};
+
+namespace {
+
+void closeRing(IoRing* ring) {
+  if (ring->sqes != MAP_FAILED) {
+    munmap(ring->sqes, ring->sqesSize);
+  }
+
+  if (ring->cqMap != MAP_FAILED && ring->cqMap != ring->sqMap) {
+    munmap(ring->cqMap, ring->cqMapSize);
+  }
+
+  if (ring->sqMap != MAP_FAILED) {
+    munmap(ring->sqMap, ring->sqMapSize);
+  }
+
+  close(ring->fd);
+  delete ring;
+}
+
+// nullptr when the kernel has no io_uring or it is disabled, the dispatcher then works on epoll alone
+IoRing* openRing() {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = static_cast<int>(syscall(__NR_io_uring_setup, RING_ENTRIES, &params));
+  if (fd == -1) {
+    return nullptr;
+  }
+
+  IoRing* ring = new IoRing;
+  ring->fd = fd;
+  ring->sqMap = ring->cqMap = ring->sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+  // accept, cancellation and a completion queue that never drops entries all came with 5.5
+  if ((params.features & IORING_FEAT_NODROP) == 0) {
+    closeRing(ring);
+    return nullptr;
+  }
+
+  ring->sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (singleMap) {
+    ring->sqMapSize = ring->cqMapSize = std::max(ring->sqMapSize, ring->cqMapSize);
+  }
+
+  ring->sqMap = mmap(nullptr, ring->sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (ring->sqMap != MAP_FAILED) {
+    ring->cqMap = singleMap ? ring->sqMap : mmap(nullptr, ring->cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+  }
+
+  if (ring->cqMap != MAP_FAILED) {
+    ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    ring->sqes = static_cast<io_uring_sqe*>(mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+  }
+
+  if (ring->sqes == MAP_FAILED) {
+    closeRing(ring);
+    return nullptr;
+  }
+
+  uint8_t* sq = static_cast<uint8_t*>(ring->sqMap);
+  ring->sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  ring->sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  ring->sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  ring->sqEntries = params.sq_entries;
+  ring->tail = *ring->sqTail;
+  unsigned* array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  for (unsigned i = 0; i < params.sq_entries; ++i) {
+    array[i] = i;
+  }
+
+  uint8_t* cq = static_cast<uint8_t*>(ring->cqMap);
+  ring->cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  ring->cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  ring->cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  return ring;
+}
+
+}
+
+#endif
+
 Dispatcher::Dispatcher() {
   std::string message;
   epoll = ::epoll_create1(0);
   if (epoll == -1) {
     message = "epoll_create1 failed, " + lastErrorMessage();
   } else {
-    mainContext.ucontext = new ucontext_t;
-    if (getcontext(reinterpret_cast<ucontext_t*>(mainContext.ucontext)) == -1) {
-      message = "getcontext failed, " + lastErrorMessage();
-    } else {
+    try {
+      mainContext.ucontext = createContext();
+    } catch (std::exception& e) {
+      mainContext.ucontext = nullptr;
+      message = e.what();
+    }
+
+    if (mainContext.ucontext != nullptr) {
       remoteSpawnEvent = eventfd(0, O_NONBLOCK);
       if(remoteSpawnEvent == -1) {
         message = "eventfd failed, " + lastErrorMessage();
@@ -85,22 +334,59 @@ Dispatcher::Dispatcher() {
         if (epoll_ctl(epoll, EPOLL_CTL_ADD, remoteSpawnEvent, &remoteSpawnEventEpollEvent) == -1) {
           message = "epoll_ctl failed, " + lastErrorMessage();
         } else {
-          *reinterpret_cast<pthread_mutex_t*>(this->mutex) = pthread_mutex_t(PTHREAD_MUTEX_INITIALIZER);
-
-          mainContext.interrupted = false;
-          mainContext.group = &contextGroup;
-          mainContext.groupPrev = nullptr;
-          mainContext.groupNext = nullptr;
-          mainContext.inExecutionQueue = false;
-          contextGroup.firstContext = nullptr;
-          contextGroup.lastContext = nullptr;
-          contextGroup.firstWaiter = nullptr;
-          contextGroup.lastWaiter = nullptr;
-          currentContext = &mainContext;
-          firstResumingContext = nullptr;
-          firstReusableContext = nullptr;
-          runningContextCount = 0;
-          return;
+          timerWheel = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+          if (timerWheel == -1) {
+            message = "timerfd_create failed, " + lastErrorMessage();
+          } else {
+            timerWheelContext.writeContext = nullptr;
+            timerWheelContext.readContext = nullptr;
+
+            epoll_event timerWheelEvent;
+            timerWheelEvent.events = EPOLLIN;
+            timerWheelEvent.data.ptr = &timerWheelContext;
+
+            if (epoll_ctl(epoll, EPOLL_CTL_ADD, timerWheel, &timerWheelEvent) == -1) {
+              message = "epoll_ctl failed, " + lastErrorMessage();
+            } else {
+              mainContext.interrupted = false;
+              mainContext.group = &contextGroup;
+              mainContext.groupPrev = nullptr;
+              mainContext.groupNext = nullptr;
+              mainContext.inExecutionQueue = false;
+              contextGroup.firstContext = nullptr;
+              contextGroup.lastContext = nullptr;
+              contextGroup.firstWaiter = nullptr;
+              contextGroup.lastWaiter = nullptr;
+              currentContext = &mainContext;
+              firstResumingContext = nullptr;
+              firstReusableContext = nullptr;
+              runningContextCount = 0;
+              contextCount = 0;
+              reusableContextCount = 0;
+              maxReusableContexts = DEFAULT_MAX_REUSABLE_CONTEXTS;
+              stackMemory = 0;
+              wheelTime = currentTick();
+              wheelArmed = 0;
+              wheelTimerCount = 0;
+              for (unsigned level = 0; level < WHEEL_LEVELS; ++level) {
+                wheelOccupied[level] = 0;
+                for (unsigned slot = 0; slot < WHEEL_SLOTS; ++slot) {
+                  wheel[level][slot] = nullptr;
+                }
+              }
+    #ifdef DISPATCHER_IO_URING
+              ring = openRing();
+              epollReady = false;
+              if (ring != nullptr) {
+                armEpoll();
+              }
+    #endif
+              return;
+            }
+
+            auto result = close(timerWheel);
+            assert(result == 0);
+          }
         }
 
         auto result = close(remoteSpawnEvent);
@@ -121,54 +407,51 @@ Dispatcher::~Dispatcher() {
   }
 
   yield();
+#ifdef DISPATCHER_IO_URING
+  // cancelled ring operations may complete after the yield, wait for the contexts like a group does
+  if (contextGroup.firstContext != nullptr) {
+    currentContext->next = nullptr;
+    contextGroup.firstWaiter = currentContext;
+    contextGroup.lastWaiter = currentContext;
+    dispatch();
+  }
+#endif
+
   assert(contextGroup.firstContext == nullptr);
   assert(contextGroup.firstWaiter == nullptr);
   assert(firstResumingContext == nullptr);
   assert(runningContextCount == 0);
-  while (firstReusableContext != nullptr) {
-    auto ucontext = static_cast<ucontext_t*>(firstReusableContext->ucontext);
-    auto stackPtr = static_cast<uint8_t *>(firstReusableContext->stackPtr);
-    firstReusableContext = firstReusableContext->next;
-    delete[] stackPtr;
-    delete ucontext;
-  }
+  releaseReusableContexts();
+  releaseRetiredContexts();
 
-  while (!timers.empty()) {
-    int result = ::close(timers.top());
-    assert(result == 0);
-    timers.pop();
+#ifdef DISPATCHER_IO_URING
+  if (ring != nullptr) {
+    closeRing(ring);
   }
+#endif
 
-  auto result = close(epoll);
+  auto result = close(timerWheel);
   assert(result == 0);
-  result = close(remoteSpawnEvent);
+  result = close(epoll);
   assert(result == 0);
-  result = pthread_mutex_destroy(reinterpret_cast<pthread_mutex_t*>(this->mutex));
+  result = close(remoteSpawnEvent);
   assert(result == 0);
 }
 
 void Dispatcher::clear() {
-  while (firstReusableContext != nullptr) {
-    auto ucontext = static_cast<ucontext_t*>(firstReusableContext->ucontext);
-    auto stackPtr = static_cast<uint8_t *>(firstReusableContext->stackPtr);
-    firstReusableContext = firstReusableContext->next;
-    delete[] stackPtr;
-    delete ucontext;
-  }
-
-  while (!timers.empty()) {
-    int result = ::close(timers.top());
-    if (result == -1) {
-      throw std::runtime_error("Dispatcher::clear, close failed, "  + lastErrorMessage());
-    }
-
-    timers.pop();
-  }
+  releaseReusableContexts();
+  releaseRetiredContexts();
 }
 
 void Dispatcher::dispatch() {
   NativeContext* context;
   for (;;) {
+#ifdef DISPATCHER_IO_URING
+    if (ring != nullptr) {
+      reapRing();
+    }
+#endif
+
     if (firstResumingContext != nullptr) {
       context = firstResumingContext;
       firstResumingContext = context->next;
@@ -177,10 +460,31 @@ void Dispatcher::dispatch() {
       break;
     }
 
+#ifdef DISPATCHER_IO_URING
+    // the ring is the only place to block, epoll is polled through it and read once it is ready
+    if (ring != nullptr && !epollReady) {
+      submitRing(true);
+      continue;
+    }
+
+    epoll_event event;
+    int count = epoll_wait(epoll, &event, 1, ring != nullptr ? 0 : -1);
+    if (count == 0) {
+      epollReady = false;
+      armEpoll();
+      continue;
+    }
+#else
     epoll_event event;
     int count = epoll_wait(epoll, &event, 1, -1);
+#endif
     if (count == 1) {
       ContextPair *contextPair = static_cast<ContextPair*>(event.data.ptr);
+      if (contextPair == &timerWheelContext) {
+        processTimers();
+        continue;
+      }
+
       if(((event.events & (EPOLLIN | EPOLLOUT)) != 0) && contextPair->readContext == nullptr && contextPair->writeContext == nullptr) {
         uint64_t buf;
         auto transferred = read(remoteSpawnEvent, &buf, sizeof buf);
@@ -188,10 +492,10 @@ void Dispatcher::dispatch() {
             throw std::runtime_error("Dispatcher::dispatch, read(remoteSpawnEvent) failed, " + lastErrorMessage());
         }
 
-        MutextGuard guard(*reinterpret_cast<pthread_mutex_t*>(this->mutex));
-        while (!remoteSpawningProcedures.empty()) {
-          spawn(std::move(remoteSpawningProcedures.front()));
-          remoteSpawningProcedures.pop();
+        remoteSpawningProcedures.rearm();
+        std::function<void()> procedure;
+        while (remoteSpawningProcedures.pop(procedure)) {
+          spawn(std::move(procedure));
         }
 
         continue;
@@ -217,11 +521,10 @@ void Dispatcher::dispatch() {
   }
 
   if (context != currentContext) {
-    ucontext_t* oldContext = static_cast<ucontext_t*>(currentContext->ucontext);
+    Context* oldContext = static_cast<Context*>(currentContext->ucontext);
     currentContext = context;
-    if (swapcontext(oldContext, static_cast<ucontext_t *>(context->ucontext)) == -1) {
-      throw std::runtime_error("Dispatcher::dispatch, swapcontext failed, " + lastErrorMessage());
-    }
+    switchContext(oldContext, static_cast<Context*>(context->ucontext), "Dispatcher::dispatch");
+    releaseRetiredContexts();
   }
 }
 
@@ -229,6 +532,19 @@ NativeContext* Dispatcher::getCurrentContext() const {
   return currentContext;
 }
 
+size_t Dispatcher::getRunningContextCount() const {
+  return runningContextCount;
+}
+
+size_t Dispatcher::getResumingContextCount() const {
+  size_t count = 0;
+  for (NativeContext* context = firstResumingContext; context != nullptr; context = context->next) {
+    ++count;
+  }
+
+  return count;
+}
+
 void Dispatcher::interrupt() {
   interrupt(currentContext);
 }
@@ -271,14 +587,13 @@ void Dispatcher::pushContext(NativeContext* context) {
 }
 
 void Dispatcher::remoteSpawn(std::function<void()>&& procedure) {
-  {
-    MutextGuard guard(*reinterpret_cast<pthread_mutex_t*>(this->mutex));
-    remoteSpawningProcedures.push(std::move(procedure));
-  }
-  uint64_t one = 1;
-  auto transferred = write(remoteSpawnEvent, &one, sizeof one);
-  if(transferred == - 1) {
-    throw std::runtime_error("Dispatcher::remoteSpawn, write failed, " + lastErrorMessage());
+  // posts that find the dispatcher already signalled ride on the pending wake up
+  if (remoteSpawningProcedures.push(std::move(procedure))) {
+    uint64_t one = 1;
+    auto transferred = write(remoteSpawnEvent, &one, sizeof one);
+    if(transferred == - 1) {
+      throw std::runtime_error("Dispatcher::remoteSpawn, write failed, " + lastErrorMessage());
+    }
   }
 }
 
@@ -303,16 +618,36 @@ void Dispatcher::spawn(std::function<void()>&& procedure) {
 }
 
 void Dispatcher::yield() {
+#ifdef DISPATCHER_IO_URING
+  if (ring != nullptr) {
+    submitRing(false);
+    reapRing();
+  }
+
+  while (ring == nullptr || epollReady) {
+#else
   for(;;){
+#endif
     epoll_event events[16];
     int count = epoll_wait(epoll, events, 16, 0);
     if (count == 0) {
+#ifdef DISPATCHER_IO_URING
+      if (ring != nullptr) {
+        epollReady = false;
+        armEpoll();
+      }
+#endif
       break;
     }
 
     if(count > 0) {
       for(int i = 0; i < count; ++i) {
         ContextPair *contextPair = static_cast<ContextPair*>(events[i].data.ptr);
+        if (contextPair == &timerWheelContext) {
+          processTimers();
+          continue;
+        }
+
         if(((events[i].events & (EPOLLIN | EPOLLOUT)) != 0) && contextPair->readContext == nullptr && contextPair->writeContext == nullptr) {
           uint64_t buf;
           auto transferred = read(remoteSpawnEvent, &buf, sizeof buf);
@@ -320,10 +655,10 @@ void Dispatcher::yield() {
             throw std::runtime_error("Dispatcher::dispatch, read(remoteSpawnEvent) failed, " + lastErrorMessage());
           }
 
-          MutextGuard guard(*reinterpret_cast<pthread_mutex_t*>(this->mutex));
-          while (!remoteSpawningProcedures.empty()) {
-            spawn(std::move(remoteSpawningProcedures.front()));
-            remoteSpawningProcedures.pop();
+          remoteSpawningProcedures.rearm();
+          std::function<void()> procedure;
+          while (remoteSpawningProcedures.pop(procedure)) {
+            spawn(std::move(procedure));
           }
 
           continue;
@@ -368,76 +703,376 @@ int Dispatcher::getEpoll() const {
   return epoll;
 }
 
-NativeContext& Dispatcher::getReusableContext() {
-  if(firstReusableContext == nullptr) {
-    ucontext_t* newlyCreatedContext = new ucontext_t;
-    if (getcontext(newlyCreatedContext) == -1) { //makecontext precondition
-      throw std::runtime_error("Dispatcher::getReusableContext, getcontext failed, " + lastErrorMessage());
+NativeContext& Dispatcher::getReusableContext(size_t stackSize) {
+  if (stackSize == 0) {
+    stackSize = DEFAULT_STACK_SIZE;
+  }
+
+  stackSize = roundToPages(stackSize);
+  NativeContext** link = &firstReusableContext;
+  while (*link != nullptr && (*link)->stackSize != stackSize) {
+    link = &(*link)->next;
+  }
+
+  if (*link == nullptr) {
+    Context* newlyCreatedContext;
+    uint8_t* stackPointer;
+    try {
+      newlyCreatedContext = createContext();
+    } catch (std::exception& e) {
+      throw std::runtime_error(std::string("Dispatcher::getReusableContext, ") + e.what());
     }
 
-    auto stackPointer = new uint8_t[STACK_SIZE];
-    newlyCreatedContext->uc_stack.ss_sp = stackPointer;
-    newlyCreatedContext->uc_stack.ss_size = STACK_SIZE;
+    try {
+      stackPointer = allocateStack(stackSize);
+    } catch (std::exception& e) {
+      delete newlyCreatedContext;
+      throw std::runtime_error(std::string("Dispatcher::getReusableContext, ") + e.what());
+    }
 
     ContextMakingData makingContextData {this, newlyCreatedContext};
-    makecontext(newlyCreatedContext, (void(*)())contextProcedureStatic, 1, reinterpret_cast<int*>(&makingContextData));
+    makeContext(newlyCreatedContext, stackPointer + roundToPages(1), stackSize, contextProcedureStatic, &makingContextData);
 
-    ucontext_t* oldContext = static_cast<ucontext_t*>(currentContext->ucontext);
-    if (swapcontext(oldContext, newlyCreatedContext) == -1) {
-      throw std::runtime_error("Dispatcher::getReusableContext, swapcontext failed, " + lastErrorMessage());
-    }
+    Context* oldContext = static_cast<Context*>(currentContext->ucontext);
+    switchContext(oldContext, newlyCreatedContext, "Dispatcher::getReusableContext");
 
     assert(firstReusableContext != nullptr);
     assert(firstReusableContext->ucontext == newlyCreatedContext);
     firstReusableContext->stackPtr = stackPointer;
-  };
+    firstReusableContext->stackSize = stackSize;
+    ++contextCount;
+    ++reusableContextCount;
+    stackMemory += stackSize;
+    link = &firstReusableContext;
+  }
 
-  NativeContext* context = firstReusableContext;
-  firstReusableContext = firstReusableContext-> next;
+  NativeContext* context = *link;
+  *link = context->next;
+  --reusableContextCount;
   return *context;
 }
 
 void Dispatcher::pushReusableContext(NativeContext& context) {
+  --runningContextCount;
+  if (reusableContextCount >= maxReusableContexts) {
+    // the stack is still in use, it is released by the next context to run
+    context.procedure = nullptr;
+    context.interruptProcedure = nullptr;
+    retiredContexts.push_back({context.ucontext, context.stackPtr, context.stackSize});
+    --contextCount;
+    stackMemory -= context.stackSize;
+    return;
+  }
+
   context.next = firstReusableContext;
   firstReusableContext = &context;
-  --runningContextCount;
+  ++reusableContextCount;
+}
+
+void Dispatcher::setMaxReusableContexts(size_t count) {
+  maxReusableContexts = count;
+}
+
+size_t Dispatcher::getContextCount() const {
+  return contextCount;
 }
 
-int Dispatcher::getTimer() {
-  int timer;
-  if (timers.empty()) {
-    timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
-    epoll_event timerEvent;
-    timerEvent.events = 0;
-    timerEvent.data.ptr = nullptr;
+size_t Dispatcher::getReusableContextCount() const {
+  return reusableContextCount;
+}
+
+size_t Dispatcher::getStackMemory() const {
+  return stackMemory;
+}
+
+#ifdef DISPATCHER_IO_URING
+bool Dispatcher::hasRing() const {
+  return ring != nullptr;
+}
+
+io_uring_sqe* Dispatcher::getRingEntry() {
+  assert(ring != nullptr);
+  if (ring->tail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE) == ring->sqEntries) {
+    submitRing(false);
+    if (ring->tail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE) == ring->sqEntries) {
+      throw std::runtime_error("Dispatcher::getRingEntry, submission queue is full");
+    }
+  }
+
+  io_uring_sqe* entry = &ring->sqes[ring->tail & ring->sqMask];
+  memset(entry, 0, sizeof(*entry));
+  ++ring->tail;
+  return entry;
+}
+
+int Dispatcher::waitRingEntry(io_uring_sqe* entry) {
+  OperationContext operationContext;
+  operationContext.interrupted = false;
+  operationContext.context = currentContext;
+  operationContext.result = 0;
+  entry->user_data = reinterpret_cast<uint64_t>(&operationContext);
+  bool timeout = entry->opcode == IORING_OP_TIMEOUT;
+  currentContext->interruptProcedure = [this, &operationContext, timeout]() {
+    io_uring_sqe* cancel = getRingEntry();
+    cancel->opcode = timeout ? IORING_OP_TIMEOUT_REMOVE : IORING_OP_ASYNC_CANCEL;
+    cancel->fd = -1;
+    cancel->addr = reinterpret_cast<uint64_t>(&operationContext);
+    operationContext.interrupted = true;
+  };
+
+  if (timeout) {
+    // a timeout counts from its submission, it can't wait for the batch
+    submitRing(false);
+  }
 
-    if (epoll_ctl(getEpoll(), EPOLL_CTL_ADD, timer, &timerEvent) == -1) {
-      throw std::runtime_error("Dispatcher::getTimer, epoll_ctl failed, "  + lastErrorMessage());
+  dispatch();
+  currentContext->interruptProcedure = nullptr;
+  assert(operationContext.context == currentContext);
+  if (operationContext.interrupted) {
+    if (operationContext.result == -ECANCELED || operationContext.result == -EINTR) {
+      throw InterruptedException();
     }
+
+    // the operation completed before the cancellation reached it, the next one is interrupted instead
+    currentContext->interrupted = true;
+  }
+
+  return operationContext.result;
+}
+
+void Dispatcher::armEpoll() {
+  io_uring_sqe* entry = getRingEntry();
+  entry->opcode = IORING_OP_POLL_ADD;
+  entry->fd = epoll;
+  entry->poll_events = POLLIN;
+  entry->user_data = EPOLL_ENTRY;
+}
+
+void Dispatcher::submitRing(bool wait) {
+  unsigned count = ring->tail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE);
+  if (count == 0 && !wait) {
+    return;
+  }
+
+  __atomic_store_n(ring->sqTail, ring->tail, __ATOMIC_RELEASE);
+  if (syscall(__NR_io_uring_enter, ring->fd, count, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0) == -1) {
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      throw std::runtime_error("Dispatcher::dispatch, io_uring_enter failed, " + lastErrorMessage());
+    }
+  }
+}
+
+void Dispatcher::reapRing() {
+  unsigned head = *ring->cqHead;
+  unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+  for (; head != tail; ++head) {
+    const io_uring_cqe& completion = ring->cqes[head & ring->cqMask];
+    if (completion.user_data == EPOLL_ENTRY) {
+      epollReady = true;
+    } else if (completion.user_data != 0) {
+      OperationContext* operationContext = reinterpret_cast<OperationContext*>(completion.user_data);
+      operationContext->result = completion.res;
+      pushContext(operationContext->context);
+    }
+  }
+
+  __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+}
+#endif
+
+void Dispatcher::releaseContext(void* ucontext, void* stackPtr, size_t stackSize) {
+  freeStack(stackPtr, stackSize);
+  delete static_cast<Context*>(ucontext);
+}
+
+void Dispatcher::releaseRetiredContexts() {
+  for (auto& context : retiredContexts) {
+    releaseContext(context.ucontext, context.stackPtr, context.stackSize);
+  }
+
+  retiredContexts.clear();
+}
+
+void Dispatcher::releaseReusableContexts() {
+  while (firstReusableContext != nullptr) {
+    NativeContext* context = firstReusableContext;
+    firstReusableContext = context->next;
+    --contextCount;
+    --reusableContextCount;
+    stackMemory -= context->stackSize;
+    // the context lives on its own stack, so it is unusable after this
+    releaseContext(context->ucontext, context->stackPtr, context->stackSize);
+  }
+}
+
+void Dispatcher::addTimer(TimerEntry& timer, std::chrono::nanoseconds duration) {
+  if (wheelTimerCount == 0) {
+    wheelTime = currentTick();
+  }
+
+  // rounded up, the timer fires on the first tick at or after its deadline
+  timer.expires = (monotonicTime() + static_cast<uint64_t>(duration.count()) + TICK_NANOSECONDS - 1) / TICK_NANOSECONDS;
+  if (timer.expires <= wheelTime) {
+    timer.expires = wheelTime + 1;
+  }
+
+  insertTimer(timer);
+  ++wheelTimerCount;
+  armTimerWheel();
+}
+
+bool Dispatcher::removeTimer(TimerEntry& timer) {
+  if (timer.slot == nullptr) {
+    return false;
+  }
+
+  unlinkTimer(timer);
+  --wheelTimerCount;
+  return true;
+}
+
+void Dispatcher::insertTimer(TimerEntry& timer) {
+  assert(timer.expires > wheelTime);
+  uint64_t delta = timer.expires - wheelTime;
+  uint64_t expires = timer.expires;
+  unsigned level = 0;
+  while (level < WHEEL_LEVELS - 1 && delta >= (uint64_t(1) << (WHEEL_SLOT_BITS * (level + 1)))) {
+    ++level;
+  }
+
+  if (delta >= (uint64_t(1) << (WHEEL_SLOT_BITS * WHEEL_LEVELS))) {
+    // beyond the wheel, parked in the farthest slot and placed again when it cascades
+    expires = wheelTime + (uint64_t(1) << (WHEEL_SLOT_BITS * WHEEL_LEVELS)) - 1;
+  }
+
+  unsigned index = static_cast<unsigned>(expires >> (WHEEL_SLOT_BITS * level)) & (WHEEL_SLOTS - 1);
+  timer.slot = &wheel[level][index];
+  timer.prev = nullptr;
+  timer.next = *timer.slot;
+  if (timer.next != nullptr) {
+    timer.next->prev = &timer;
+  }
+
+  *timer.slot = &timer;
+  wheelOccupied[level] |= uint64_t(1) << index;
+}
+
+void Dispatcher::unlinkTimer(TimerEntry& timer) {
+  if (timer.prev != nullptr) {
+    timer.prev->next = timer.next;
   } else {
-    timer = timers.top();
-    timers.pop();
+    *timer.slot = timer.next;
+  }
+
+  if (timer.next != nullptr) {
+    timer.next->prev = timer.prev;
+  }
+
+  if (*timer.slot == nullptr) {
+    size_t position = timer.slot - &wheel[0][0];
+    wheelOccupied[position / WHEEL_SLOTS] &= ~(uint64_t(1) << (position % WHEEL_SLOTS));
   }
 
-  return timer;
+  timer.slot = nullptr;
 }
 
-void Dispatcher::pushTimer(int timer) {
-  timers.push(timer);
+// the next tick at which a slot has to fire or cascade, UINT64_MAX when the wheel is empty
+uint64_t Dispatcher::nextTimerTick() const {
+  uint64_t next = UINT64_MAX;
+  for (unsigned level = 0; level < WHEEL_LEVELS; ++level) {
+    uint64_t occupied = wheelOccupied[level];
+    if (occupied == 0) {
+      continue;
+    }
+
+    unsigned shift = WHEEL_SLOT_BITS * level;
+    uint64_t block = wheelTime >> shift;
+    unsigned start = static_cast<unsigned>(block + 1) & (WHEEL_SLOTS - 1);
+    uint64_t rotated = start == 0 ? occupied : (occupied >> start) | (occupied << (WHEEL_SLOTS - start));
+    uint64_t tick = (block + 1 + __builtin_ctzll(rotated)) << shift;
+    next = std::min(next, tick);
+  }
+
+  return next;
+}
+
+void Dispatcher::armTimerWheel() {
+  uint64_t next = nextTimerTick();
+  if (next == UINT64_MAX || (wheelArmed != 0 && wheelArmed <= next)) {
+    return;
+  }
+
+  itimerspec expires;
+  expires.it_interval.tv_sec = expires.it_interval.tv_nsec = 0;
+  expires.it_value.tv_sec = static_cast<time_t>(next * TICK_NANOSECONDS / 1000000000);
+  expires.it_value.tv_nsec = static_cast<long>(next * TICK_NANOSECONDS % 1000000000);
+  if (timerfd_settime(timerWheel, TFD_TIMER_ABSTIME, &expires, nullptr) == -1) {
+    throw std::runtime_error("Dispatcher::armTimerWheel, timerfd_settime failed, " + lastErrorMessage());
+  }
+
+  wheelArmed = next;
+}
+
+void Dispatcher::processTimers() {
+  uint64_t expirations;
+  if (::read(timerWheel, &expirations, sizeof expirations) == -1 && errno != EAGAIN) {
+    throw std::runtime_error("Dispatcher::processTimers, read failed, " + lastErrorMessage());
+  }
+
+  uint64_t now = currentTick();
+  if (wheelArmed <= now) {
+    wheelArmed = 0;
+  }
+
+  for (;;) {
+    uint64_t next = nextTimerTick();
+    if (next > now) {
+      break;
+    }
+
+    wheelTime = next;
+    for (unsigned level = WHEEL_LEVELS - 1; level > 0; --level) {
+      unsigned shift = WHEEL_SLOT_BITS * level;
+      if ((wheelTime & ((uint64_t(1) << shift) - 1)) != 0) {
+        continue;
+      }
+
+      TimerEntry** slot = &wheel[level][(wheelTime >> shift) & (WHEEL_SLOTS - 1)];
+      while (*slot != nullptr) {
+        TimerEntry* timer = *slot;
+        unlinkTimer(*timer);
+        if (timer->expires > wheelTime) {
+          insertTimer(*timer);
+        } else {
+          --wheelTimerCount;
+          pushContext(timer->context);
+        }
+      }
+    }
+
+    TimerEntry** slot = &wheel[0][wheelTime & (WHEEL_SLOTS - 1)];
+    while (*slot != nullptr) {
+      TimerEntry* timer = *slot;
+      unlinkTimer(*timer);
+      --wheelTimerCount;
+      pushContext(timer->context);
+    }
+  }
+
+  wheelTime = now;
+  armTimerWheel();
 }
 
 void Dispatcher::contextProcedure(void* ucontext) {
-  assert(firstReusableContext == nullptr);
   NativeContext context;
   context.ucontext = ucontext;
   context.interrupted = false;
-  context.next = nullptr;
+  context.next = firstReusableContext;
   context.inExecutionQueue = false;
   firstReusableContext = &context;
-  ucontext_t* oldContext = static_cast<ucontext_t*>(context.ucontext);
-  if (swapcontext(oldContext, static_cast<ucontext_t*>(currentContext->ucontext)) == -1) {
-    throw std::runtime_error("Dispatcher::contextProcedure, swapcontext failed, " + lastErrorMessage());
-  }
+  Context* oldContext = static_cast<Context*>(context.ucontext);
+  switchContext(oldContext, static_cast<Context*>(currentContext->ucontext), "Dispatcher::contextProcedure");
+  releaseRetiredContexts();
 
   for (;;) {
     ++runningContextCount;
@@ -17,22 +17,28 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
-#include <queue>
-#include <stack>
-#ifndef __GLIBC__
-#include <bits/reg.h>
+#include <vector>
+#include <System/RemoteSpawnQueue.h>
+
+#ifdef DISPATCHER_IO_URING
+struct io_uring_sqe;
 #endif
 
 namespace System {
 
 struct NativeContextGroup;
+#ifdef DISPATCHER_IO_URING
+struct IoRing;
+#endif
 
 struct NativeContext {
   void* ucontext;
   void* stackPtr{nullptr};
+  size_t stackSize{0};
   bool interrupted;
   bool inExecutionQueue;
   NativeContext* next{nullptr};
@@ -54,6 +60,15 @@ struct OperationContext {
   NativeContext *context;
   bool interrupted;
   uint32_t events;
+  int result;
+};
+
+struct TimerEntry {
+  uint64_t expires; // in timer wheel ticks
+  NativeContext* context;
+  TimerEntry** slot; // nullptr once the timer has fired or was removed
+  TimerEntry* prev;
+  TimerEntry* next;
 };
 
 struct ContextPair {
@@ -76,34 +91,59 @@ public:
   void pushContext(NativeContext* context);
   void remoteSpawn(std::function<void()>&& procedure);
   void yield();
+  // contexts spawned and not finished yet
+  size_t getRunningContextCount() const;
+  // contexts ready to run, waiting for the current one to yield
+  size_t getResumingContextCount() const;
 
   // system-dependent
   int getEpoll() const;
-  NativeContext& getReusableContext();
+  NativeContext& getReusableContext(size_t stackSize = 0);
   void pushReusableContext(NativeContext&);
-  int getTimer();
-  void pushTimer(int timer);
-
-#ifdef __x86_64__
-# if __WORDSIZE == 64
-  static const int SIZEOF_PTHREAD_MUTEX_T = 40;
-# else
-  static const int SIZEOF_PTHREAD_MUTEX_T = 32;
-# endif
-#elif defined(__aarch64__)
-  static const int SIZEOF_PTHREAD_MUTEX_T = 48;
-#else
-  static const int SIZEOF_PTHREAD_MUTEX_T = 24;
+  // all timers share one timerfd, armed for the earliest of them; pending timers are kept
+  // in a hierarchical wheel with millisecond ticks, a timer never fires early
+  void addTimer(TimerEntry& timer, std::chrono::nanoseconds duration);
+  // false when the timer has already fired
+  bool removeTimer(TimerEntry& timer);
+
+  static const size_t DEFAULT_STACK_SIZE = 512 * 1024;
+  static const size_t DEFAULT_MAX_REUSABLE_CONTEXTS = 128;
+
+  // finished contexts over the limit release their stacks instead of waiting to be reused
+  void setMaxReusableContexts(size_t count);
+  size_t getContextCount() const;
+  size_t getReusableContextCount() const;
+  // address space reserved for context stacks, pages are committed as the stacks grow
+  size_t getStackMemory() const;
+
+#ifdef DISPATCHER_IO_URING
+  // sockets and timers are driven through io_uring when the kernel provides it, epoll otherwise
+  bool hasRing() const;
+  // zeroed submission entry, entries are handed to the kernel together when the dispatcher waits
+  io_uring_sqe* getRingEntry();
+  // suspends the current context until the operation in the entry completes and returns its result,
+  // an interrupted operation is cancelled and throws InterruptedException
+  int waitRingEntry(io_uring_sqe* entry);
 #endif
 
 private:
   void spawn(std::function<void()>&& procedure);
   int epoll;
-  alignas(void*) uint8_t mutex[SIZEOF_PTHREAD_MUTEX_T];
   int remoteSpawnEvent;
   ContextPair remoteSpawnEventContext;
-  std::queue<std::function<void()>> remoteSpawningProcedures;
-  std::stack<int> timers;
+  RemoteSpawnQueue remoteSpawningProcedures;
+
+  static const unsigned WHEEL_LEVELS = 4;
+  static const unsigned WHEEL_SLOT_BITS = 6;
+  static const unsigned WHEEL_SLOTS = 1 << WHEEL_SLOT_BITS;
+
+  int timerWheel;
+  ContextPair timerWheelContext;
+  uint64_t wheelTime; // last processed tick
+  uint64_t wheelArmed; // tick the timerfd fires at, 0 when it is not armed
+  size_t wheelTimerCount;
+  uint64_t wheelOccupied[WHEEL_LEVELS];
+  TimerEntry* wheel[WHEEL_LEVELS][WHEEL_SLOTS];
 
   NativeContext mainContext;
   NativeContextGroup contextGroup;
@@ -113,6 +153,37 @@ private:
   NativeContext* firstReusableContext;
   size_t runningContextCount;
 
+  struct RetiredContext {
+    void* ucontext;
+    void* stackPtr;
+    size_t stackSize;
+  };
+
+  size_t contextCount;
+  size_t reusableContextCount;
+  size_t maxReusableContexts;
+  size_t stackMemory;
+  std::vector<RetiredContext> retiredContexts;
+
+#ifdef DISPATCHER_IO_URING
+  IoRing* ring;
+  bool epollReady;
+
+  void armEpoll();
+  void submitRing(bool wait);
+  void reapRing();
+#endif
+
+  void insertTimer(TimerEntry& timer);
+  void unlinkTimer(TimerEntry& timer);
+  uint64_t nextTimerTick() const;
+  void armTimerWheel();
+  void processTimers();
+
+  void releaseContext(void* ucontext, void* stackPtr, size_t stackSize);
+  void releaseRetiredContexts();
+  void releaseReusableContexts();
+
   void contextProcedure(void* ucontext);
   static void contextProcedureStatic(void* context);
 };
@@ -17,12 +17,18 @@
 
 #include "TcpConnection.h"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <cassert>
 #include <cstdint>
 #include <stdexcept>
 #include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
+#ifdef DISPATCHER_IO_URING
+#include <linux/io_uring.h>
+#endif
 
 #include <System/ErrorMessage.h>
 #include <System/InterruptedException.h>
@@ -30,6 +36,12 @@
 
 namespace System {
 
+namespace {
+
+const std::size_t MAX_WRITE_BUFFERS = 64;
+
+}
+
 TcpConnection::TcpConnection() : dispatcher(nullptr) {
 }
 
@@ -83,6 +95,23 @@ size_t TcpConnection::read(uint8_t* data, size_t size) {
   std::string message;
   ssize_t transferred = ::recv(connection, (void *)data, size, 0);
   if (transferred == -1) {
+#ifdef DISPATCHER_IO_URING
+    if (errno == EAGAIN && dispatcher->hasRing()) {
+      io_uring_sqe* entry = dispatcher->getRingEntry();
+      entry->opcode = IORING_OP_RECV;
+      entry->fd = connection;
+      entry->addr = reinterpret_cast<uint64_t>(data);
+      entry->len = static_cast<uint32_t>(size);
+      int result = dispatcher->waitRingEntry(entry);
+      if (result < 0) {
+        throw std::runtime_error("TcpConnection::read, recv failed, " + errorMessage(-result));
+      }
+
+      assert(result <= static_cast<ssize_t>(size));
+      return result;
+    }
+#endif
+
     if (errno != EAGAIN) {
       message = "recv failed, " + lastErrorMessage();
     } else {
@@ -162,12 +191,28 @@ size_t TcpConnection::read(uint8_t* data, size_t size) {
 }
 
 std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
+  std::pair<const uint8_t*, std::size_t> buffer(data, size);
+  return writev(&buffer, 1);
+}
+
+std::size_t TcpConnection::writev(const std::pair<const uint8_t*, std::size_t>* buffers, std::size_t count) {
   assert(dispatcher != nullptr);
   assert(contextPair.writeContext == nullptr);
   if (dispatcher->interrupted()) {
     throw InterruptedException();
   }
 
+  iovec vectors[MAX_WRITE_BUFFERS];
+  msghdr messageHeader = {};
+  messageHeader.msg_iov = vectors;
+  messageHeader.msg_iovlen = std::min(count, MAX_WRITE_BUFFERS);
+  size_t size = 0;
+  for (size_t i = 0; i < static_cast<size_t>(messageHeader.msg_iovlen); ++i) {
+    vectors[i].iov_base = const_cast<uint8_t*>(buffers[i].first);
+    vectors[i].iov_len = buffers[i].second;
+    size += buffers[i].second;
+  }
+
   std::string message;
   if(size == 0) {
     if(shutdown(connection, SHUT_WR) == -1) {
@@ -177,8 +222,26 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
     return 0;
   }
 
-  ssize_t transferred = ::send(connection, (void *)data, size, MSG_NOSIGNAL);
+  ssize_t transferred = ::sendmsg(connection, &messageHeader, MSG_NOSIGNAL);
   if (transferred == -1) {
+#ifdef DISPATCHER_IO_URING
+    if (errno == EAGAIN && dispatcher->hasRing()) {
+      io_uring_sqe* entry = dispatcher->getRingEntry();
+      entry->opcode = IORING_OP_SENDMSG;
+      entry->fd = connection;
+      entry->addr = reinterpret_cast<uint64_t>(&messageHeader);
+      entry->len = 1;
+      entry->msg_flags = MSG_NOSIGNAL;
+      int result = dispatcher->waitRingEntry(entry);
+      if (result < 0) {
+        throw std::runtime_error("TcpConnection::write, send failed, " + errorMessage(-result));
+      }
+
+      assert(result <= static_cast<ssize_t>(size));
+      return result;
+    }
+#endif
+
     if (errno != EAGAIN) {
       message = "send failed, " + lastErrorMessage();
     } else {
@@ -240,7 +303,7 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
           throw std::runtime_error("TcpConnection::write, events & (EPOLLERR | EPOLLHUP) != 0");
         }
 
-        ssize_t transferred = ::send(connection, (void *)data, size, 0);
+        ssize_t transferred = ::sendmsg(connection, &messageHeader, MSG_NOSIGNAL);
         if (transferred == -1) {
           message = "send failed, "  + lastErrorMessage();
         } else {
@@ -24,6 +24,9 @@
 #include <sys/epoll.h>
 #include <unistd.h>
 #include <string.h>
+#ifdef DISPATCHER_IO_URING
+#include <linux/io_uring.h>
+#endif
 
 #include "Dispatcher.h"
 #include "TcpConnection.h"
@@ -123,6 +126,25 @@ TcpConnection TcpListener::accept() {
     throw InterruptedException();
   }
 
+#ifdef DISPATCHER_IO_URING
+  if (dispatcher->hasRing()) {
+    sockaddr inAddr;
+    socklen_t inLen = sizeof(inAddr);
+    io_uring_sqe* entry = dispatcher->getRingEntry();
+    entry->opcode = IORING_OP_ACCEPT;
+    entry->fd = listener;
+    entry->addr = reinterpret_cast<uint64_t>(&inAddr);
+    entry->addr2 = reinterpret_cast<uint64_t>(&inLen);
+    entry->accept_flags = SOCK_NONBLOCK;
+    int connection = dispatcher->waitRingEntry(entry);
+    if (connection < 0) {
+      throw std::runtime_error("TcpListener::accept, accept failed, " + errorMessage(-connection));
+    }
+
+    return TcpConnection(*dispatcher, connection);
+  }
+#endif
+
   ContextPair contextPair;
   OperationContext listenerContext;
   listenerContext.interrupted = false;
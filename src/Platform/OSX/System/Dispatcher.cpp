@@ -213,6 +213,19 @@ NativeContext* Dispatcher::getCurrentContext() const {
   return currentContext;
 }
 
+size_t Dispatcher::getRunningContextCount() const {
+  return runningContextCount;
+}
+
+size_t Dispatcher::getResumingContextCount() const {
+  size_t count = 0;
+  for (NativeContext* context = firstResumingContext; context != nullptr; context = context->next) {
+    ++count;
+  }
+
+  return count;
+}
+
 void Dispatcher::interrupt() {
   interrupt(currentContext);
 }
@@ -341,7 +354,8 @@ int Dispatcher::getKqueue() const {
   return kqueue;
 }
 
-NativeContext& Dispatcher::getReusableContext() {
+// contexts share one stack size on this platform, the requested size is ignored
+NativeContext& Dispatcher::getReusableContext(size_t) {
   if(firstReusableContext == nullptr) {
    uctx* newlyCreatedContext = new uctx;
    uint8_t* stackPointer = new uint8_t[STACK_SIZE];
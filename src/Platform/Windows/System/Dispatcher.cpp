@@ -196,6 +196,19 @@ NativeContext* Dispatcher::getCurrentContext() const {
   return currentContext;
 }
 
+size_t Dispatcher::getRunningContextCount() const {
+  return runningContextCount;
+}
+
+size_t Dispatcher::getResumingContextCount() const {
+  size_t count = 0;
+  for (NativeContext* context = firstResumingContext; context != nullptr; context = context->next) {
+    ++count;
+  }
+
+  return count;
+}
+
 void Dispatcher::interrupt() {
   interrupt(currentContext);
 }
@@ -339,7 +352,8 @@ void* Dispatcher::getCompletionPort() const {
   return completionPort;
 }
 
-NativeContext& Dispatcher::getReusableContext() {
+// contexts share one stack size on this platform, the requested size is ignored
+NativeContext& Dispatcher::getReusableContext(size_t) {
   if (firstReusableContext == nullptr) {
     void* fiber = CreateFiberEx(STACK_SIZE, RESERVE_STACK_SIZE, 0, contextProcedureStatic, this);
     if (fiber == NULL) {
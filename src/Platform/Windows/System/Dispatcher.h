@@ -60,11 +60,15 @@ public:
   void pushContext(NativeContext* context);
   void remoteSpawn(std::function<void()>&& procedure);
   void yield();
+  // contexts spawned and not finished yet
+  size_t getRunningContextCount() const;
+  // contexts ready to run, waiting for the current one to yield
+  size_t getResumingContextCount() const;
 
   // Platform-specific
   void addTimer(uint64_t time, NativeContext* context);
   void* getCompletionPort() const;
-  NativeContext& getReusableContext();
+  NativeContext& getReusableContext(size_t stackSize = 0);
   void pushReusableContext(NativeContext&);
   void interruptTimer(uint64_t time, NativeContext* context);
 
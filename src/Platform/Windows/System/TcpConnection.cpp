@@ -32,6 +32,8 @@ namespace System {
 
 namespace {
 
+const std::size_t MAX_WRITE_BUFFERS = 64;
+
 struct TcpConnectionContext : public OVERLAPPED {
   NativeContext* context;
   bool interrupted;
@@ -147,12 +149,26 @@ size_t TcpConnection::read(uint8_t* data, size_t size) {
 }
 
 size_t TcpConnection::write(const uint8_t* data, size_t size) {
+  std::pair<const uint8_t*, std::size_t> buffer(data, size);
+  return writev(&buffer, 1);
+}
+
+std::size_t TcpConnection::writev(const std::pair<const uint8_t*, std::size_t>* buffers, std::size_t count) {
   assert(dispatcher != nullptr);
   assert(writeContext == nullptr);
   if (dispatcher->interrupted()) {
     throw InterruptedException();
   }
 
+  WSABUF bufs[MAX_WRITE_BUFFERS];
+  DWORD bufCount = static_cast<DWORD>(count < MAX_WRITE_BUFFERS ? count : MAX_WRITE_BUFFERS);
+  size_t size = 0;
+  for (DWORD i = 0; i < bufCount; ++i) {
+    bufs[i].len = static_cast<ULONG>(buffers[i].second);
+    bufs[i].buf = reinterpret_cast<char*>(const_cast<uint8_t*>(buffers[i].first));
+    size += buffers[i].second;
+  }
+
   if (size == 0) {
     if (shutdown(connection, SD_SEND) != 0) {
       throw std::runtime_error("TcpConnection::write, shutdown failed, " + errorMessage(WSAGetLastError()));
@@ -161,10 +177,9 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
     return 0;
   }
 
-  WSABUF buf{static_cast<ULONG>(size), reinterpret_cast<char*>(const_cast<uint8_t*>(data))};
   TcpConnectionContext context;
   context.hEvent = NULL;
-  if (WSASend(connection, &buf, 1, NULL, 0, &context, NULL) != 0) {
+  if (WSASend(connection, bufs, bufCount, NULL, 0, &context, NULL) != 0) {
     int lastError = WSAGetLastError();
     if (lastError != WSA_IO_PENDING) {
       throw std::runtime_error("TcpConnection::write, WSASend failed, " + errorMessage(lastError));
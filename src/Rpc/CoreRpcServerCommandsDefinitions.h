@@ -109,10 +109,12 @@ struct COMMAND_RPC_GET_POOL_CHANGES {
   struct request {
     Crypto::Hash tailBlockId;
     std::vector<Crypto::Hash> knownTxsIds;
+    uint64_t poolSequence = 0; // poolSequence of the previous response, knownTxsIds may then be left empty
 
     void serialize(ISerializer &s) {
       KV_MEMBER(tailBlockId)
       serializeAsBinary(knownTxsIds, "knownTxsIds", s);
+      KV_MEMBER(poolSequence)
     }
   };
 
@@ -120,12 +122,16 @@ struct COMMAND_RPC_GET_POOL_CHANGES {
     bool isTailBlockActual;
     std::vector<BinaryArray> addedTxs;       // Added transactions blobs
     std::vector<Crypto::Hash> deletedTxsIds; // IDs of not found transactions
+    uint64_t poolSequence;
+    bool isPoolSequenceActual;                   // false if the changes are relative to knownTxsIds
     std::string status;
 
     void serialize(ISerializer &s) {
       KV_MEMBER(isTailBlockActual)
       KV_MEMBER(addedTxs)
       serializeAsBinary(deletedTxsIds, "deletedTxsIds", s);
+      KV_MEMBER(poolSequence)
+      KV_MEMBER(isPoolSequenceActual)
       KV_MEMBER(status)
     }
   };
@@ -135,10 +141,12 @@ struct COMMAND_RPC_GET_POOL_CHANGES_LITE {
   struct request {
     Crypto::Hash tailBlockId;
     std::vector<Crypto::Hash> knownTxsIds;
+    uint64_t poolSequence = 0; // poolSequence of the previous response, knownTxsIds may then be left empty
 
     void serialize(ISerializer &s) {
       KV_MEMBER(tailBlockId)
       serializeAsBinary(knownTxsIds, "knownTxsIds", s);
+      KV_MEMBER(poolSequence)
     }
   };
 
@@ -146,18 +154,56 @@ struct COMMAND_RPC_GET_POOL_CHANGES_LITE {
     bool isTailBlockActual;
     std::vector<TransactionPrefixInfo> addedTxs; // Added transactions blobs
     std::vector<Crypto::Hash> deletedTxsIds;     // IDs of not found transactions
+    uint64_t poolSequence;
+    bool isPoolSequenceActual;                   // false if the changes are relative to knownTxsIds
     std::string status;
 
     void serialize(ISerializer &s) {
       KV_MEMBER(isTailBlockActual)
       KV_MEMBER(addedTxs)
       serializeAsBinary(deletedTxsIds, "deletedTxsIds", s);
+      KV_MEMBER(poolSequence)
+      KV_MEMBER(isPoolSequenceActual)
       KV_MEMBER(status)
     }
   };
 };
 
 //-----------------------------------------------
+// Long poll: answered once the tail block or the pool differs from the request or the timeout expires.
+// Requests served by the SSL server threads are answered right away.
+struct COMMAND_RPC_WAIT_FOR_CHANGES {
+  struct request {
+    Crypto::Hash tailBlockId;
+    uint64_t poolModificationCounter = 0; // poolModificationCounter of the previous response
+    uint32_t timeout = 0;                 // seconds, capped by the daemon, 0 - don't wait
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(tailBlockId)
+      KV_MEMBER(poolModificationCounter)
+      KV_MEMBER(timeout)
+    }
+  };
+
+  struct response {
+    Crypto::Hash tailBlockId;
+    uint32_t height;
+    uint64_t poolModificationCounter;
+    bool isTailBlockChanged;
+    bool isPoolChanged;
+    std::string status;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(tailBlockId)
+      KV_MEMBER(height)
+      KV_MEMBER(poolModificationCounter)
+      KV_MEMBER(isTailBlockChanged)
+      KV_MEMBER(isPoolChanged)
+      KV_MEMBER(status)
+    }
+  };
+};
+
 struct COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES {
   
   struct request {
@@ -178,6 +224,34 @@ struct COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES {
     }
   };
 };
+
+struct TransactionOutputIndexes {
+  std::vector<uint32_t> o_indexes;
+
+  void serialize(ISerializer &s) {
+    KV_MEMBER(o_indexes)
+  }
+};
+
+struct COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES {
+  struct request {
+    std::vector<Crypto::Hash> txids;
+
+    void serialize(ISerializer &s) {
+      serializeAsBinary(txids, "txids", s);
+    }
+  };
+
+  struct response {
+    std::vector<TransactionOutputIndexes> indexes; // in the order of the requested transactions
+    std::string status;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(indexes)
+      KV_MEMBER(status)
+    }
+  };
+};
 //-----------------------------------------------
 struct COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_request {
   std::vector<uint64_t> amounts;
@@ -299,6 +373,15 @@ struct COMMAND_RPC_GET_INFO {
     uint8_t block_major_version;
     std::string already_generated_coins;
     std::string contact;   
+    uint64_t longhash_cache_hits;
+    uint64_t longhash_cache_misses;
+    uint64_t tx_verification_queue_size;
+    uint64_t tx_commit_queue_size;
+    uint64_t transactions_pool_bytes;
+    uint64_t transactions_pool_max_bytes;
+    uint64_t transactions_pool_evicted;
+    uint64_t rpc_cache_hits;
+    uint64_t rpc_cache_misses;
 
     void serialize(ISerializer &s) {
       KV_MEMBER(status)
@@ -323,6 +406,15 @@ struct COMMAND_RPC_GET_INFO {
       KV_MEMBER(block_major_version)
       KV_MEMBER(already_generated_coins)
       KV_MEMBER(contact)      
+      KV_MEMBER(longhash_cache_hits)
+      KV_MEMBER(longhash_cache_misses)
+      KV_MEMBER(tx_verification_queue_size)
+      KV_MEMBER(tx_commit_queue_size)
+      KV_MEMBER(transactions_pool_bytes)
+      KV_MEMBER(transactions_pool_max_bytes)
+      KV_MEMBER(transactions_pool_evicted)
+      KV_MEMBER(rpc_cache_hits)
+      KV_MEMBER(rpc_cache_misses)
     }
   };
 };
@@ -370,6 +462,8 @@ struct p2p_connection_entry
   uint64_t started = 0;
   uint32_t remote_blockchain_height = 0;
   uint32_t last_response_height = 0;
+  uint64_t recv_bytes = 0;
+  uint64_t sent_bytes = 0;
 
   void serialize(ISerializer& s)
   {
@@ -382,6 +476,8 @@ struct p2p_connection_entry
     KV_MEMBER(started)
     KV_MEMBER(remote_blockchain_height)
     KV_MEMBER(last_response_height)
+    KV_MEMBER(recv_bytes)
+    KV_MEMBER(sent_bytes)
   }
 };
 
@@ -439,10 +535,12 @@ struct COMMAND_RPC_GETBLOCKTEMPLATE {
   struct request {
     uint64_t reserve_size; //max 255 bytes
     std::string wallet_address;
+    std::string long_poll_id; //if set, the call blocks until the template differs from this one
 
     void serialize(ISerializer &s) {
       KV_MEMBER(reserve_size)
       KV_MEMBER(wallet_address)
+      KV_MEMBER(long_poll_id)
     }
   };
 
@@ -452,6 +550,7 @@ struct COMMAND_RPC_GETBLOCKTEMPLATE {
     uint64_t reserved_offset;
     std::string blocktemplate_blob;
 	std::string blockhashing_blob;
+    std::string long_poll_id;
     std::string status;
 
     void serialize(ISerializer &s) {
@@ -460,6 +559,7 @@ struct COMMAND_RPC_GETBLOCKTEMPLATE {
       KV_MEMBER(reserved_offset)
       KV_MEMBER(blocktemplate_blob)
 	  KV_MEMBER(blockhashing_blob)
+      KV_MEMBER(long_poll_id)
       KV_MEMBER(status)
     }
   };
@@ -494,6 +594,7 @@ struct block_header_response {
   std::string hash;
   difficulty_type difficulty;
   uint64_t reward;
+  std::string pow_hash;
 
   void serialize(ISerializer &s) {
     KV_MEMBER(major_version)
@@ -507,6 +608,7 @@ struct block_header_response {
     KV_MEMBER(hash)
     KV_MEMBER(difficulty)
     KV_MEMBER(reward)
+    KV_MEMBER(pow_hash)
   }
 };
 
@@ -619,6 +721,26 @@ struct COMMAND_RPC_GET_BLOCK_TIMESTAMP_BY_HEIGHT {
   };
 };
 
+struct COMMAND_RPC_GET_HEIGHTS_BY_TIMESTAMPS {
+  struct request {
+    std::vector<uint64_t> timestamps;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(timestamps)
+    }
+  };
+
+  struct response {
+    std::vector<uint32_t> heights; // the chain height for a timestamp no block has reached yet
+    std::string status;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(heights)
+      KV_MEMBER(status)
+    }
+  };
+};
+
 struct COMMAND_RPC_GET_BLOCKS_LIST {
   struct request {
     uint32_t height;
@@ -736,10 +858,104 @@ struct COMMAND_RPC_QUERY_BLOCKS_LITE {
   struct request {
     std::vector<Crypto::Hash> blockIds;
     uint64_t timestamp;
+    bool needGlobalIndexes = false; // the transactions come with the global indexes of their outputs
+
+    void serialize(ISerializer &s) {
+      serializeAsBinary(blockIds, "block_ids", s);
+      KV_MEMBER(timestamp)
+      KV_MEMBER(needGlobalIndexes)
+    }
+  };
+
+  struct response {
+    std::string status;
+    uint32_t startHeight;
+    uint32_t currentHeight;
+    uint64_t fullOffset;
+    std::vector<BlockShortInfo> items;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(status)
+      KV_MEMBER(startHeight)
+      KV_MEMBER(currentHeight)
+      KV_MEMBER(fullOffset)
+      KV_MEMBER(items)
+    }
+  };
+};
+
+//-----------------------------------------------
+struct COMMAND_RPC_GET_BLOCK_FILTERS {
+  struct request {
+    std::vector<Crypto::Hash> blockIds;
+    uint32_t count;
+
+    void serialize(ISerializer &s) {
+      serializeAsBinary(blockIds, "block_ids", s);
+      KV_MEMBER(count)
+    }
+  };
+
+  struct response {
+    std::string status;
+    uint32_t startHeight;
+    std::vector<BlockFilterInfo> items;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(status)
+      KV_MEMBER(startHeight)
+      KV_MEMBER(items)
+    }
+  };
+};
+
+struct COMMAND_RPC_GET_BLOCK_FILTER_HEADERS {
+  struct request {
+    uint32_t startHeight;
+    uint32_t count;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(startHeight)
+      KV_MEMBER(count)
+    }
+  };
+
+  struct response {
+    std::string status;
+    std::vector<Crypto::Hash> headers;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(status)
+      serializeAsBinary(headers, "headers", s);
+    }
+  };
+};
+
+//-----------------------------------------------
+struct OutputReference {
+  uint64_t amount;
+  uint32_t globalIndex;
+
+  void serialize(ISerializer &s) {
+    KV_MEMBER(amount)
+    KV_MEMBER(globalIndex)
+  }
+};
+
+struct COMMAND_RPC_QUERY_BLOCKS_FILTERED {
+  struct request {
+    std::vector<Crypto::Hash> blockIds;
+    uint64_t timestamp;
+    Crypto::SecretKey viewSecretKey;
+    std::vector<Crypto::PublicKey> spendPublicKeys;
+    std::vector<OutputReference> watchedOutputs;
 
     void serialize(ISerializer &s) {
       serializeAsBinary(blockIds, "block_ids", s);
       KV_MEMBER(timestamp)
+      KV_MEMBER(viewSecretKey)
+      KV_MEMBER(spendPublicKeys)
+      KV_MEMBER(watchedOutputs)
     }
   };
 
@@ -749,6 +965,7 @@ struct COMMAND_RPC_QUERY_BLOCKS_LITE {
     uint32_t currentHeight;
     uint64_t fullOffset;
     std::vector<BlockShortInfo> items;
+    std::vector<OutputReference> foundOutputs;
 
     void serialize(ISerializer &s) {
       KV_MEMBER(status)
@@ -756,6 +973,7 @@ struct COMMAND_RPC_QUERY_BLOCKS_LITE {
       KV_MEMBER(currentHeight)
       KV_MEMBER(fullOffset)
       KV_MEMBER(items)
+      KV_MEMBER(foundOutputs)
     }
   };
 };
@@ -18,6 +18,7 @@
 
 #include "HttpClient.h"
 
+#include <HTTP/HttpCompression.h>
 #include <HTTP/HttpParser.h>
 #include <System/Ipv4Resolver.h>
 #include <System/Ipv4Address.h>
@@ -126,6 +127,10 @@ void HttpClient::request(HttpRequest &req, HttpResponse &res) {
     connect();
   }
   req.setHost(m_address);
+  if (req.getHeaders().find("Accept-Encoding") == req.getHeaders().end()) {
+    req.addHeader("Accept-Encoding", HttpCompression::ACCEPT_ENCODING);
+  }
+
   if (this->m_ssl_enable) {
     try {
       System::SocketStreambuf streambuf((char *) "", 1);
@@ -134,7 +139,6 @@ void HttpClient::request(HttpRequest &req, HttpResponse &res) {
       stream << req;
       stream.flush();
       std::vector<uint8_t> req_data;
-      std::vector<uint8_t> resp_data;
       streambuf.getRespdata(req_data);
       size_t req_data_size = (size_t) req_data.size();
       size_t write_size = 0;
@@ -148,56 +152,19 @@ void HttpClient::request(HttpRequest &req, HttpResponse &res) {
           break;
         }
       }
-      size_t resp_size = 0;
-      size_t resp_size_full = 0;
-      const size_t resp_buff_size = 1024;
-      char resp_buff[resp_buff_size];
-      const char *header_end_sep = "\r\n\r\n";
-      const char *content_lenght_name = "Content-Length";
-      const char *content_lenght_end_sep = "\r\n";
-      size_t header_end = 0;
-      size_t stream_len = 0;
-      bool header_found = false;
-      while (true) {
-        memset(resp_buff, 0x00, sizeof(char) * resp_buff_size);
-        resp_size = this->m_ssl_sock->read_some(boost::asio::buffer((char *) resp_buff,
-                                                resp_buff_size));
-        resp_size_full += resp_size;
-        if (resp_size > 0) {
-          resp_data.resize(resp_size_full);
-          memcpy(resp_data.data() + resp_size_full - resp_size, resp_buff, resp_size);
-          if (!header_found) {
-            std::string data = std::string((char *) resp_data.data());
-            data.push_back(0x00);
-            size_t header_end = data.find(header_end_sep);
-            if (header_end != std::string::npos) {
-              header_found = true;
-              data.resize(header_end + 2);
-              data.push_back(0x00);
-              size_t content_lenght_start = data.find(content_lenght_name);
-              size_t content_lenght_end = data.find(content_lenght_end_sep, content_lenght_start);
-              if (content_lenght_start != std::string::npos && content_lenght_end != std::string::npos) {
-                sscanf(data.substr(content_lenght_start + strlen(content_lenght_name) + 2,
-                                   content_lenght_end - content_lenght_start - strlen(content_lenght_name) - 2).c_str(),
-                       "%zu",
-                       &stream_len);
-                stream_len += header_end + 4;
-              }
-            }
-          }
-          if (header_found) {
-            if (stream_len > 0) {
-              if (resp_size_full >= stream_len) break;
-            } else {
-              if (resp_size_full == header_end + 4) break;
-            }
-          }
-        } else {
+      std::string resp_data;
+      char resp_buff[1024];
+      for (;;) {
+        size_t resp_size = this->m_ssl_sock->read_some(boost::asio::buffer(resp_buff, sizeof(resp_buff)));
+        if (resp_size == 0) {
+          throw std::runtime_error("Connection closed before the response is complete");
+        }
+
+        resp_data.append(resp_buff, resp_size);
+        if (parser.parseResponse(resp_data.data(), resp_data.size(), res) != 0) {
           break;
         }
       }
-      streambuf.setRespdata(resp_data);
-      parser.receiveResponse(stream, res);
     } catch (const std::exception &) {
       disconnect();
       throw;
@@ -208,12 +175,31 @@ void HttpClient::request(HttpRequest &req, HttpResponse &res) {
       HttpParser parser;
       stream << req;
       stream.flush();
-      parser.receiveResponse(stream, res);
+
+      std::string resp_data;
+      for (;;) {
+        size_t offset = resp_data.size();
+        resp_data.resize(offset + 4096);
+        size_t resp_size = m_connection.read(reinterpret_cast<uint8_t*>(&resp_data[offset]), 4096);
+        resp_data.resize(offset + resp_size);
+        if (resp_size == 0) {
+          throw std::runtime_error("Connection closed before the response is complete");
+        }
+
+        if (parser.parseResponse(resp_data.data(), resp_data.size(), res) != 0) {
+          break;
+        }
+      }
     } catch (const std::exception &) {
       disconnect();
       throw;
     }
   }
+
+  auto encoding = res.getHeaders().find("content-encoding");
+  if (encoding != res.getHeaders().end()) {
+    res.setBody(HttpCompression::decompress(res.getBody(), encoding->second));
+  }
 }
 
 void HttpClient::connect() {
@@ -280,7 +266,7 @@ void HttpClient::disconnect() {
   } else {
     m_streamBuf.reset();
     try {
-      m_connection.write(nullptr, 0); //Socket shutdown.
+      m_connection.write(static_cast<const uint8_t*>(nullptr), 0); //Socket shutdown.
     } catch (std::exception&) {
       //Ignoring possible exception.
     }
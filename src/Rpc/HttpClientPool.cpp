@@ -0,0 +1,101 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "HttpClientPool.h"
+
+#include <cassert>
+
+namespace CryptoNote {
+
+HttpClientPool::Lease::Lease(HttpClientPool& pool, size_t lane, HttpClient& client) : m_pool(&pool), m_lane(lane), m_client(&client) {
+}
+
+HttpClientPool::Lease::Lease(Lease&& other) : m_pool(other.m_pool), m_lane(other.m_lane), m_client(other.m_client) {
+  other.m_client = nullptr;
+}
+
+HttpClientPool::Lease::~Lease() {
+  if (m_client != nullptr) {
+    m_pool->release(m_lane, m_client);
+  }
+}
+
+HttpClientPool::HttpClientPool(System::Dispatcher& dispatcher, const std::string& address, uint16_t port, bool sslEnable,
+  const std::vector<size_t>& laneLimits) :
+  m_dispatcher(dispatcher), m_address(address), m_port(port), m_sslEnable(sslEnable), m_noVerify(false), m_connected(false) {
+  for (size_t limit : laneLimits) {
+    assert(limit > 0);
+    std::unique_ptr<Lane> lane(new Lane{ limit, {}, {}, System::Event(dispatcher) });
+    m_lanes.push_back(std::move(lane));
+  }
+}
+
+void HttpClientPool::setRootCert(const std::string& path) {
+  m_rootCert = path;
+  for (auto& lane : m_lanes) {
+    for (auto& client : lane->clients) {
+      client->setRootCert(path);
+    }
+  }
+}
+
+void HttpClientPool::disableVerify() {
+  m_noVerify = true;
+  for (auto& lane : m_lanes) {
+    for (auto& client : lane->clients) {
+      client->disableVerify();
+    }
+  }
+}
+
+HttpClientPool::Lease HttpClientPool::acquire(size_t lane) {
+  assert(lane < m_lanes.size());
+  Lane& l = *m_lanes[lane];
+  while (l.idle.empty() && l.clients.size() >= l.limit) {
+    l.released.wait();
+  }
+
+  HttpClient* client;
+  if (l.idle.empty()) {
+    l.clients.emplace_back(new HttpClient(m_dispatcher, m_address, m_port, m_sslEnable));
+    client = l.clients.back().get();
+    if (!m_rootCert.empty()) {
+      client->setRootCert(m_rootCert);
+    }
+
+    if (m_noVerify) {
+      client->disableVerify();
+    }
+  } else {
+    // the most recently used connection is the most likely to be still open
+    client = l.idle.back();
+    l.idle.pop_back();
+  }
+
+  return Lease(*this, lane, *client);
+}
+
+void HttpClientPool::release(size_t lane, HttpClient* client) {
+  Lane& l = *m_lanes[lane];
+  l.idle.push_back(client);
+  m_connected = client->isConnected();
+  l.released.set();
+  l.released.clear();
+}
+
+}
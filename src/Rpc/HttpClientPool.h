@@ -0,0 +1,88 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <System/Dispatcher.h>
+#include <System/Event.h>
+
+#include "HttpClient.h"
+
+namespace CryptoNote {
+
+// Keep-alive connections to one server shared by the contexts of a dispatcher. Requests are
+// split into lanes, so that a slow request class only holds up the connections of its own lane.
+// A lease takes an idle connection of the lane, opens another one below the lane limit or
+// waits for a connection to be released.
+class HttpClientPool {
+public:
+  class Lease {
+  public:
+    Lease(HttpClientPool& pool, size_t lane, HttpClient& client);
+    Lease(Lease&& other);
+    ~Lease();
+
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    HttpClient& client() const { return *m_client; }
+
+  private:
+    HttpClientPool* m_pool;
+    size_t m_lane;
+    HttpClient* m_client;
+  };
+
+  // one lane per element, each opens at most that many connections
+  HttpClientPool(System::Dispatcher& dispatcher, const std::string& address, uint16_t port, bool sslEnable, const std::vector<size_t>& laneLimits);
+
+  HttpClientPool(const HttpClientPool&) = delete;
+  HttpClientPool& operator=(const HttpClientPool&) = delete;
+
+  void setRootCert(const std::string& path);
+  void disableVerify();
+
+  Lease acquire(size_t lane);
+  // connection state after the last released request
+  bool isConnected() const { return m_connected; }
+
+private:
+  struct Lane {
+    size_t limit;
+    std::vector<std::unique_ptr<HttpClient>> clients;
+    std::vector<HttpClient*> idle;
+    System::Event released;
+  };
+
+  void release(size_t lane, HttpClient* client);
+
+  System::Dispatcher& m_dispatcher;
+  const std::string m_address;
+  const uint16_t m_port;
+  const bool m_sslEnable;
+  std::string m_rootCert;
+  bool m_noVerify;
+  bool m_connected;
+  std::vector<std::unique_ptr<Lane>> m_lanes;
+};
+
+}
@@ -18,21 +18,23 @@
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "HttpServer.h"
+#include <algorithm>
 #include <thread>
 #include <string.h>
-#include <streambuf>
+#include <sstream>
 #include <array>
 #include <vector>
 #include <boost/scope_exit.hpp>
 #include <boost/asio.hpp>
 #include <boost/asio/ssl/stream.hpp>
+#include <boost/asio/steady_timer.hpp>
 
 #include <Common/base64.hpp>
 #include <Common/StringTools.h>
 #include <HTTP/HttpParser.h>
 #include <System/InterruptedException.h>
+#include <System/RemoteContext.h>
 #include <System/TcpStream.h>
-#include <System/SocketStream.h>
 #include <System/Ipv4Address.h>
 
 using boost::asio::ip::tcp;
@@ -40,20 +42,172 @@ using namespace Logging;
 
 
 namespace {
+	const size_t SSL_SERVER_MAX_THREADS = 4;
+	const size_t SSL_REQUEST_MAX_SIZE = 1024 * 32;
+	const std::chrono::seconds SSL_IDLE_TIMEOUT(20);
+	const size_t READ_BUFFER_SIZE = 4096;
+	const size_t DEFAULT_MAX_QUEUED_REQUESTS = 100;
+	// heavy handlers are offloaded to worker threads, what runs in the connection context needs less than the default stack
+	const size_t CONNECTION_STACK_SIZE = 256 * 1024;
+
 	void fillUnauthorizedResponse(CryptoNote::HttpResponse& response) {
 		response.setStatus(CryptoNote::HttpResponse::STATUS_401);
 		response.addHeader("WWW-Authenticate", "Basic realm=\"RPC\"");
 		response.addHeader("Content-Type", "text/plain");
 		response.setBody("Authorization required");
 	}
+
+	// One TLS connection of the SSL server. All its handlers run through a strand,
+	// so a session is never served by two threads of the pool at once.
+	class SslSession : public std::enable_shared_from_this<SslSession> {
+	public:
+		typedef std::function<void(const CryptoNote::HttpRequest&, CryptoNote::HttpResponse&)> Handler;
+
+		SslSession(boost::asio::io_service& io, boost::asio::ssl::context& context, const Handler& handler, std::atomic<size_t>& clients) :
+			m_strand(io), m_stream(io, context), m_timer(io), m_handler(handler), m_clients(clients), m_started(false), m_chunked(false) {
+		}
+
+		~SslSession() {
+			if (m_started) {
+				--m_clients;
+			}
+		}
+
+		tcp::socket& socket() {
+			return m_stream.next_layer();
+		}
+
+		void start() {
+			m_started = true;
+			++m_clients;
+
+			auto self = shared_from_this();
+			armTimer();
+			m_stream.async_handshake(boost::asio::ssl::stream_base::server, m_strand.wrap([self](const boost::system::error_code& ec) {
+				if (ec) {
+					self->close();
+					return;
+				}
+
+				self->read();
+			}));
+		}
+
+	private:
+		void armTimer() {
+			auto self = shared_from_this();
+			m_timer.expires_from_now(SSL_IDLE_TIMEOUT);
+			m_timer.async_wait(m_strand.wrap([self](const boost::system::error_code& ec) {
+				// a timer rearmed after it fired still runs the old handler, with no error
+				if (!ec && self->m_timer.expires_from_now() <= std::chrono::steady_clock::duration::zero()) {
+					self->close();
+				}
+			}));
+		}
+
+		void read() {
+			auto self = shared_from_this();
+			m_stream.async_read_some(boost::asio::buffer(m_buffer), m_strand.wrap([self](const boost::system::error_code& ec, size_t transferred) {
+				if (ec) {
+					self->close();
+					return;
+				}
+
+				self->m_request.append(self->m_buffer.data(), transferred);
+				self->processBuffered();
+			}));
+		}
+
+		void processBuffered() {
+			CryptoNote::HttpResponse response;
+			try {
+				size_t length = m_parser.parseRequest(m_request.data(), m_request.size(), m_pending);
+				if (length == 0) {
+					if (m_request.size() >= SSL_REQUEST_MAX_SIZE) {
+						close();
+					} else {
+						read();
+					}
+
+					return;
+				}
+
+				m_request.erase(0, length);
+				CryptoNote::HttpRequest request;
+				std::swap(request, m_pending);
+				m_handler(request, response);
+			} catch (std::exception&) {
+				close();
+				return;
+			}
+
+			std::ostringstream out;
+			out << response;
+			m_response = out.str();
+			m_streamed = std::move(response);
+			m_chunked = m_streamed.isChunked();
+			write();
+		}
+
+		// streamed bodies are produced one chunk per write, so only one of them sits in memory
+		void write() {
+			auto self = shared_from_this();
+			boost::asio::async_write(m_stream, boost::asio::buffer(m_response), m_strand.wrap([self](const boost::system::error_code& ec, size_t) {
+				if (ec) {
+					self->close();
+					return;
+				}
+
+				if (self->m_chunked) {
+					self->m_response.clear();
+					try {
+						self->m_chunked = self->m_streamed.nextChunk(self->m_response);
+					} catch (std::exception&) {
+						self->close();
+						return;
+					}
+
+					self->armTimer();
+					self->write();
+					return;
+				}
+
+				self->m_streamed = CryptoNote::HttpResponse();
+				self->armTimer();
+				self->processBuffered();
+			}));
+		}
+
+		void close() {
+			boost::system::error_code ignored;
+			m_timer.cancel(ignored);
+			m_stream.lowest_layer().close(ignored);
+		}
+
+		boost::asio::io_service::strand m_strand;
+		boost::asio::ssl::stream<tcp::socket> m_stream;
+		boost::asio::steady_timer m_timer;
+		Handler m_handler;
+		std::atomic<size_t>& m_clients;
+		bool m_started;
+		std::array<char, READ_BUFFER_SIZE> m_buffer;
+		CryptoNote::HttpParser m_parser;
+		CryptoNote::HttpRequest m_pending;
+		std::string m_request;
+		std::string m_response;
+		CryptoNote::HttpResponse m_streamed;
+		bool m_chunked;
+	};
 }
 
 namespace CryptoNote {
 
 HttpServer::HttpServer(System::Dispatcher& dispatcher, Logging::ILogger& log)
-  : m_dispatcher(dispatcher), workingContextGroup(dispatcher), logger(log, "HttpServer") {
-  this->m_server_ssl_do = false;
-  this->m_server_ssl_is_run = false;
+  : m_dispatcher(dispatcher), m_dispatcherThreadId(std::this_thread::get_id()), m_workerThreads(0), m_busyWorkers(0), m_maxQueued(DEFAULT_MAX_QUEUED_REQUESTS),
+    m_workerReleased(dispatcher), workingContextGroup(dispatcher, CONNECTION_STACK_SIZE), logger(log, "HttpServer") {
+  m_limits.fill(0);
+  m_running.fill(0);
+  m_queued.fill(0);
   this->m_server_ssl_clients = 0;
   this->m_server_ssl_port = 0;
   this->m_address = "";
@@ -68,12 +222,73 @@ void HttpServer::setCerts(const std::string& chain_file, const std::string& key_
   this->m_key_file = key_file;
 }
 
+void HttpServer::setWorkerThreads(size_t count) {
+  m_workerThreads = count;
+}
+
+void HttpServer::setConcurrencyLimit(Priority priority, size_t limit) {
+  m_limits[priority] = limit;
+}
+
+void HttpServer::setMaxQueuedRequests(size_t count) {
+  m_maxQueued = count;
+}
+
+bool HttpServer::canStart(Priority priority) const {
+  if (m_busyWorkers >= m_workerThreads || (m_limits[priority] != 0 && m_running[priority] >= m_limits[priority])) {
+    return false;
+  }
+
+  // waiting requests of a higher priority go first, unless they are held by their own limit
+  for (size_t higher = 0; higher < priority; ++higher) {
+    if (m_queued[higher] != 0 && (m_limits[higher] == 0 || m_running[higher] < m_limits[higher])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool HttpServer::runConcurrently(const std::function<void()>& operation, Priority priority) {
+  if (m_workerThreads == 0 || std::this_thread::get_id() != m_dispatcherThreadId) {
+    operation();
+    return true;
+  }
+
+  if (!canStart(priority)) {
+    if (m_queued[priority] >= m_maxQueued) {
+      return false;
+    }
+
+    ++m_queued[priority];
+    BOOST_SCOPE_EXIT_ALL(this, priority) {
+      --m_queued[priority];
+    };
+
+    do {
+      m_workerReleased.wait();
+    } while (!canStart(priority));
+  }
+
+  ++m_busyWorkers;
+  ++m_running[priority];
+  BOOST_SCOPE_EXIT_ALL(this, priority) {
+    --m_busyWorkers;
+    --m_running[priority];
+    m_workerReleased.set();
+    m_workerReleased.clear();
+  };
+
+  System::RemoteContext<void> worker(m_dispatcher, std::function<void()>(operation));
+  worker.get();
+  return true;
+}
+
 void HttpServer::start(const std::string& address, uint16_t port, uint16_t port_ssl,
                        bool server_ssl_enable, const std::string& user, const std::string& password) {
   m_listener = System::TcpListener(m_dispatcher, System::Ipv4Address(address), port);
   workingContextGroup.spawn(std::bind(&HttpServer::acceptLoop, this));
 
-  this->m_server_ssl_do = server_ssl_enable;
   this->m_server_ssl_port = port_ssl;
   this->m_address = address;
 
@@ -82,210 +297,93 @@ void HttpServer::start(const std::string& address, uint16_t port, uint16_t port_
   }
 
   if (!this->m_chain_file.empty() && !this->m_key_file.empty() && !this->m_dh_file.empty() &&
-      this->m_server_ssl_port != 0 && this->m_server_ssl_do) {
-    this->m_ssl_server_thread = boost::thread(&HttpServer::sslServer, this);
-    this->m_ssl_server_thread.detach();
+      this->m_server_ssl_port != 0 && server_ssl_enable) {
+    startSslServer();
   }
 }
 
 void HttpServer::stop() {
   workingContextGroup.interrupt();
   workingContextGroup.wait();
-  this->m_server_ssl_do = false;
-  while (this->m_server_ssl_is_run) {
-    boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
-  }
+  stopSslServer();
 }
 
-void HttpServer::sslServerUnitControl(boost::asio::ssl::stream<tcp::socket&> &stream,
-                                      boost::system::error_code &ec,
-                                      bool &unit_do,
-                                      bool &unit_control_do,
-                                      size_t &stream_timeout_n) {
-  const size_t unit_timeout = 200;
-  while (unit_control_do) {
-    if (stream_timeout_n >= unit_timeout || !this->m_server_ssl_do) {
-      unit_do = false;
-      break;
-    } else {
-      stream_timeout_n++;
-    }
-    boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
-  }
-  if (unit_control_do && !unit_do) {
-    try {
-      stream.shutdown(ec);
-    } catch (std::exception& e) {
-      logger(ERROR, BRIGHT_RED) << "SSL server unit control error: " << e.what() << std::endl;
-    }
+void HttpServer::processSslRequest(const HttpRequest& request, HttpResponse& response) {
+  response.addHeader("Access-Control-Allow-Origin", "*");
+
+  if (authenticate(request)) {
+    processRequest(request, response);
+  } else {
+    logger(WARNING) << "Authorization required (SSL server)";
+    fillUnauthorizedResponse(response);
   }
 }
 
-void HttpServer::sslServerUnit(boost::asio::ip::tcp::socket &socket, boost::asio::ssl::context &ctx){
-  const size_t request_max_len = 1024 * 32;
-  bool keep_alive_conn = true;
-  bool unit_do = true;
-  bool unit_control_do = true;
-  size_t stream_timeout_n = 0;
-  boost::system::error_code ec;
-  boost::asio::ssl::stream<tcp::socket&> stream(socket, ctx);
-
-  boost::thread control_t(std::bind(&HttpServer::sslServerUnitControl, this, std::ref(stream),
-                                                                             std::ref(ec),
-                                                                             std::ref(unit_do),
-                                                                             std::ref(unit_control_do),
-                                                                             std::ref(stream_timeout_n)));
+void HttpServer::startSslServer() {
+  try {
+    m_ssl_context.reset(new boost::asio::ssl::context(boost::asio::ssl::context::sslv23));
+    m_ssl_context->set_options(boost::asio::ssl::context::default_workarounds | boost::asio::ssl::context::no_sslv2);
+    m_ssl_context->use_certificate_chain_file(this->m_chain_file);
+    m_ssl_context->use_private_key_file(this->m_key_file, boost::asio::ssl::context::pem);
+    m_ssl_context->use_tmp_dh_file(this->m_dh_file);
+
+    m_ssl_io_service.reset(new boost::asio::io_service());
+    m_ssl_acceptor.reset(new tcp::acceptor(*m_ssl_io_service, tcp::endpoint(boost::asio::ip::address::from_string(this->m_address),
+                                                                            this->m_server_ssl_port)));
+  } catch (std::exception& e) {
+    logger(ERROR, BRIGHT_RED) << "SSL server error: " << e.what();
+    m_ssl_acceptor.reset();
+    m_ssl_io_service.reset();
+    m_ssl_context.reset();
+    return;
+  }
 
-  this->m_server_ssl_clients++;
+  acceptSsl();
 
-  try {
-    stream.handshake(boost::asio::ssl::stream_base::server, ec);
-    if (!ec) {
-      char req_buff[request_max_len];
-      while (keep_alive_conn) {
-        const char *header_end_sep = "\r\n\r\n";
-        const char *content_lenght_name = "Content-Length";
-        const char *content_lenght_end_sep = "\r\n";
-        size_t req_size_full = 0;
-        size_t header_end = 0;
-        size_t stream_len = 0;
-        bool header_found = false;
-        memset(req_buff, 0x00, sizeof(char) * request_max_len);
-        while (unit_do) {
-          size_t req_size = 0;
-          if (unit_do) req_size = stream.read_some(boost::asio::buffer((char *) req_buff + req_size_full,
-                                                   request_max_len - req_size_full - 1),
-                                                   ec);
-          req_size_full += req_size;
-          if (req_size == 0) {
-            keep_alive_conn = false;
-            break;
-          } else {
-            if (!header_found) {
-              std::string data = std::string(req_buff);
-              header_end = data.find(header_end_sep);
-              if (header_end != std::string::npos) {
-                header_found = true;
-                data.resize(header_end + 2);
-                data.push_back(0x00);
-                size_t content_lenght_start = data.find(content_lenght_name);
-                size_t content_lenght_end = data.find(content_lenght_end_sep, content_lenght_start);
-                if (content_lenght_start != std::string::npos && content_lenght_end != std::string::npos) {
-                  sscanf(data.substr(content_lenght_start + strlen(content_lenght_name) + 2,
-                                     content_lenght_end - content_lenght_start - strlen(content_lenght_name) - 2).c_str(),
-                         "%zu",
-                         &stream_len);
-                  stream_len += header_end + 4;
-                }
-              }
-            }
-          }
-          if (header_found) {
-            if (stream_len > 0) {
-              if (req_size_full >= stream_len) break;
-            } else {
-              if (req_size_full == header_end + 4) break;
-            }
-          }
-        }
-        if (req_size_full > 0 && req_size_full < request_max_len && unit_do) {
-          System::SocketStreambuf streambuf((char *) req_buff, req_size_full);
-
-          HttpParser parser;
-          HttpRequest req;
-          HttpResponse resp;
-          resp.addHeader("Access-Control-Allow-Origin", "*");
-
-          std::iostream io_stream(&streambuf);
-          parser.receiveRequest(io_stream, req);
-
-          if (authenticate(req)) {
-            processRequest(req, resp);
-          } else {
-            logger(WARNING) << "Authorization required" << std::endl;
-          }
-          io_stream << resp;
-          io_stream.flush();
-
-          std::vector<uint8_t> resp_data;
-          streambuf.getRespdata(resp_data);
-          size_t resp_size_data = resp_data.size();
-          size_t resp_size_full = 0;
-          while (resp_size_full < resp_size_data && unit_do) {
-            size_t resp_size = 0;
-            if (unit_do) resp_size = stream.write_some(boost::asio::buffer(resp_data.data() + resp_size_full,
-                                                       resp_size_data - resp_size_full),
-                                                       ec);
-            if (resp_size > 0) {
-              resp_size_full += resp_size;
-            } else {
-              keep_alive_conn = false;
-              break;
-            }
-          }
-          stream_timeout_n = 0;
-        } else {
-          logger(DEBUGGING) << "Unable to process request (SSL server)" << std::endl;
-        }
+  size_t threads = std::max<size_t>(1, std::min<size_t>(SSL_SERVER_MAX_THREADS, std::thread::hardware_concurrency()));
+  for (size_t i = 0; i < threads; ++i) {
+    m_ssl_threads.create_thread([this] {
+      try {
+        m_ssl_io_service->run();
+      } catch (std::exception& e) {
+        logger(ERROR, BRIGHT_RED) << "SSL server error: " << e.what();
       }
-    }
-  } catch (std::exception& e) {
-    logger(ERROR, BRIGHT_RED) << "SSL server unit error: " << e.what() << std::endl;
+    });
   }
-  unit_control_do = false;
-  control_t.join();
-  this->m_server_ssl_clients--;
 }
 
-void HttpServer::sslServerControl(tcp::acceptor &accept) {
-  while (this->m_server_ssl_do) boost::this_thread::sleep_for(boost::chrono::milliseconds(1000));
-  while (this->m_server_ssl_clients > 0) {
-    boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+void HttpServer::stopSslServer() {
+  if (!m_ssl_io_service) {
+    return;
   }
-  if (accept.is_open()) {
-    boost::system::error_code ec;
-    accept.close(ec);
-    if (ec) {
-      logger(DEBUGGING) << "SSL server control error" << std::endl;
-    }
-  }
-  this->m_ssl_server_thread.interrupt();
-  this->m_server_ssl_is_run = false;
+
+  m_ssl_io_service->stop();
+  m_ssl_threads.join_all();
+
+  // pending handlers own the sessions, they go away with the io_service
+  m_ssl_acceptor.reset();
+  m_ssl_io_service.reset();
+  m_ssl_context.reset();
 }
 
-void HttpServer::sslServer() {
-  while (this->m_server_ssl_do) {
-    this->m_server_ssl_is_run = false;
-    try {
-      boost::asio::io_service io_service;
-      tcp::acceptor accept(io_service, tcp::endpoint(boost::asio::ip::address::from_string(this->m_address),
-                                                     this->m_server_ssl_port));
-
-      boost::thread control_t(std::bind(&HttpServer::sslServerControl, this, std::ref(accept)));
-      control_t.detach();
-
-      boost::asio::ssl::context ctx(boost::asio::ssl::context::sslv23);
-      ctx.set_options(boost::asio::ssl::context::default_workarounds | boost::asio::ssl::context::no_sslv2);
-      ctx.use_certificate_chain_file(this->m_chain_file);
-      ctx.use_private_key_file(this->m_key_file, boost::asio::ssl::context::pem);
-      ctx.use_tmp_dh_file(this->m_dh_file);
-
-      while (this->m_server_ssl_do) {
-        tcp::socket sock(io_service);
-        this->m_server_ssl_is_run = true;
-        accept.accept(sock);
-        if (this->m_server_ssl_do) {
-          boost::thread t(std::bind(&HttpServer::sslServerUnit, this, std::move(sock), std::ref(ctx)));
-          t.detach();
-        }
-      }
-    } catch (std::exception& e) {
-      if (this->m_server_ssl_do) {
-        logger(ERROR, BRIGHT_RED) << "SSL server error: " << e.what() << std::endl;
-      }
+void HttpServer::acceptSsl() {
+  auto session = std::make_shared<SslSession>(*m_ssl_io_service, *m_ssl_context,
+    [this](const HttpRequest& request, HttpResponse& response) { processSslRequest(request, response); },
+    m_server_ssl_clients);
+
+  m_ssl_acceptor->async_accept(session->socket(), [this, session](const boost::system::error_code& ec) {
+    if (ec == boost::asio::error::operation_aborted) {
+      return;
     }
-  }
-  this->m_server_ssl_is_run = false;
+
+    if (ec) {
+      logger(DEBUGGING) << "SSL server accept error: " << ec.message();
+    } else {
+      session->start();
+    }
+
+    acceptSsl();
+  });
 }
 
 void HttpServer::acceptLoop() {
@@ -325,15 +423,32 @@ void HttpServer::acceptLoop() {
     logger(DEBUGGING) << "Incoming connection from " << addr.first.toDottedDecimal() << ":" << addr.second;
 
     System::TcpStreambuf streambuf(connection);
-    std::iostream stream(&streambuf);
+    std::ostream stream(&streambuf);
     HttpParser parser;
+    std::string buffer;
 
     for (;;) {
       HttpRequest req;
       HttpResponse resp;
       resp.addHeader("Access-Control-Allow-Origin", "*");
 
-      parser.receiveRequest(stream, req);
+      // pipelined requests are already in the buffer, read only when it holds no whole request
+      size_t requestSize;
+      while ((requestSize = parser.parseRequest(buffer.data(), buffer.size(), req)) == 0) {
+        size_t offset = buffer.size();
+        buffer.resize(offset + READ_BUFFER_SIZE);
+        size_t transferred = connection.read(reinterpret_cast<uint8_t*>(&buffer[offset]), READ_BUFFER_SIZE);
+        buffer.resize(offset + transferred);
+        if (transferred == 0) {
+          break;
+        }
+      }
+
+      if (requestSize == 0) {
+        break;
+      }
+
+      buffer.erase(0, requestSize);
       if (authenticate(req)) {
         processRequest(req, resp);
       }
@@ -343,11 +458,17 @@ void HttpServer::acceptLoop() {
       }
 
       stream << resp;
-      stream.flush();
-
-      if (stream.peek() == std::iostream::traits_type::eof()) {
-        break;
+      if (resp.isChunked()) {
+        std::string chunk;
+        bool more;
+        do {
+          chunk.clear();
+          more = resp.nextChunk(chunk);
+          stream.write(chunk.data(), chunk.size());
+        } while (more);
       }
+
+      stream.flush();
     }
 
     logger(DEBUGGING) << "Closing connection from " << addr.first.toDottedDecimal() << ":" << addr.second << " total=" << m_connections.size();
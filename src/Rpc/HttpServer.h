@@ -19,13 +19,18 @@
 
 #pragma once 
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
 #include <unordered_set>
 #include <string.h>
 
 #include <HTTP/HttpRequest.h>
 #include <HTTP/HttpResponse.h>
 #include <boost/asio.hpp>
-#include <boost/asio/ssl/stream.hpp>
+#include <boost/asio/ssl/context.hpp>
 #include <boost/thread/thread.hpp>
 
 #include <System/ContextGroup.h>
@@ -42,8 +47,21 @@ namespace CryptoNote {
 class HttpServer {
 
 public:
+  // order in which requests waiting for a worker thread are let in
+  enum Priority {
+    PRIORITY_HIGH,
+    PRIORITY_NORMAL,
+    PRIORITY_LOW,
+    PRIORITY_COUNT
+  };
+
   HttpServer(System::Dispatcher& dispatcher, Logging::ILogger& log);
   void setCerts(const std::string& chain_file, const std::string& key_file, const std::string& dh_file);
+  void setWorkerThreads(size_t count);
+  // at most limit requests of the priority use worker threads at once, 0 - no limit
+  void setConcurrencyLimit(Priority priority, size_t limit);
+  // requests of a priority which find this many of it already waiting are rejected
+  void setMaxQueuedRequests(size_t count);
   void start(const std::string& address, uint16_t port, uint16_t port_ssl = 0,
              bool server_ssl_enable = false, const std::string& user = "", const std::string& password = "");
   void stop();
@@ -51,34 +69,48 @@ public:
   virtual size_t get_connections_count() const;
 
 protected:
+  // Runs the operation in a worker thread while the dispatcher keeps serving other
+  // connections, at most setWorkerThreads() of them at once. Waiting operations are
+  // started in priority order. Returns false without running the operation if the
+  // queue of its priority is full. Runs it in place if no workers are configured or
+  // when called from the SSL server threads.
+  bool runConcurrently(const std::function<void()>& operation, Priority priority = PRIORITY_NORMAL);
+
   System::Dispatcher& m_dispatcher;
+  std::thread::id m_dispatcherThreadId;
 
 private:
-  bool m_server_ssl_do;
-  bool m_server_ssl_is_run;
   uint16_t m_server_ssl_port;
-  unsigned int m_server_ssl_clients;
+  std::atomic<size_t> m_server_ssl_clients;
   std::string m_address;
   std::string m_chain_file;
   std::string m_dh_file;
   std::string m_key_file;
   std::string m_credentials;
   std::unordered_set<System::TcpConnection*> m_connections;
-  boost::thread m_ssl_server_thread;
+  size_t m_workerThreads;
+  size_t m_busyWorkers;
+  size_t m_maxQueued;
+  std::array<size_t, PRIORITY_COUNT> m_limits;
+  std::array<size_t, PRIORITY_COUNT> m_running;
+  std::array<size_t, PRIORITY_COUNT> m_queued;
+  System::Event m_workerReleased;
+  // declared in this order so that sessions destroyed with the io_service still have their context
+  std::unique_ptr<boost::asio::ssl::context> m_ssl_context;
+  std::unique_ptr<boost::asio::io_service> m_ssl_io_service;
+  std::unique_ptr<boost::asio::ip::tcp::acceptor> m_ssl_acceptor;
+  boost::thread_group m_ssl_threads;
   System::ContextGroup workingContextGroup;
   System::TcpListener m_listener;
   Logging::LoggerRef logger;
+  bool canStart(Priority priority) const;
   void acceptLoop();
   bool authenticate(const HttpRequest& request) const;
   void connectionHandler(System::TcpConnection&& conn);
-  void sslServerUnitControl(boost::asio::ssl::stream<boost::asio::ip::tcp::socket&> &stream,
-                            boost::system::error_code &ec,
-                            bool &unit_do,
-                            bool &unit_control_do,
-                            size_t &stream_timeout_n);
-  void sslServerUnit(boost::asio::ip::tcp::socket &socket, boost::asio::ssl::context &ctx);
-  void sslServerControl(boost::asio::ip::tcp::acceptor &accept);
-  void sslServer();
+  void processSslRequest(const HttpRequest& request, HttpResponse& response);
+  void startSslServer();
+  void stopSslServer();
+  void acceptSsl();
 
 };
 
@@ -17,6 +17,9 @@
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "JsonRpc.h"
+
+#include <cctype>
+
 #include "HttpClient.h"
 #include "CryptoNoteCore/TransactionPool.h"
 
@@ -65,6 +68,57 @@ void invokeJsonRpcCommand(HttpClient& httpClient, JsonRpcRequest& jsReq, JsonRpc
   }
 }
 
+bool splitBatchRequest(const std::string& body, std::vector<std::string>& calls) {
+  size_t pos = 0;
+  while (pos < body.size() && isspace(static_cast<unsigned char>(body[pos]))) {
+    ++pos;
+  }
+
+  if (pos == body.size() || body[pos] != '[') {
+    return false;
+  }
+
+  // only the nesting is tracked here, every call is validated when it is parsed
+  size_t depth = 0;
+  size_t begin = ++pos;
+  bool empty = true;
+  for (; pos < body.size(); ++pos) {
+    char c = body[pos];
+    if (c == '"') {
+      for (++pos; pos < body.size() && body[pos] != '"'; ++pos) {
+        if (body[pos] == '\\') {
+          ++pos;
+        }
+      }
+    } else if (c == '{' || c == '[') {
+      ++depth;
+    } else if (c == '}' || c == ']') {
+      if (depth == 0) {
+        if (c != ']') {
+          throw JsonRpcError(errParseError);
+        }
+
+        if (!empty) {
+          calls.push_back(body.substr(begin, pos - begin));
+        }
+
+        return true;
+      }
+
+      --depth;
+    } else if (c == ',' && depth == 0) {
+      calls.push_back(body.substr(begin, pos - begin));
+      begin = pos + 1;
+      continue;
+    }
+
+    if (!isspace(static_cast<unsigned char>(c))) {
+      empty = false;
+    }
+  }
+
+  throw JsonRpcError(errParseError);
+}
 
 }
 }
@@ -21,6 +21,7 @@
 #include <boost/optional.hpp>
 #include <boost/foreach.hpp>
 #include <functional>
+#include <memory>
 
 #include "CoreRpcServerCommandsDefinitions.h"
 #include <Common/JsonValue.h>
@@ -71,19 +72,18 @@ public:
 
   bool parseRequest(const std::string& requestBody) {
     try {
-      psReq = Common::JsonValue::fromString(requestBody);
+      reader.reset(new JsonInputReader(requestBody));
     } catch (std::exception&) {
       throw JsonRpcError(errParseError);
     }
 
-    if (!psReq.contains("method")) {
+    if (!(*reader)(method, "method")) {
       throw JsonRpcError(errInvalidRequest);
     }
 
-    method = psReq("method").getString();
-
-    if (psReq.contains("id")) {
-      id = psReq("id");
+    std::string idJson;
+    if (reader->rawValue("id", idJson)) {
+      id = Common::JsonValue::fromString(idJson);
     }
 
     return true;
@@ -91,8 +91,39 @@ public:
 
   template <typename T>
   bool loadParams(T& v) const {
-    loadFromJsonValue(v, psReq.contains("params") ? 
-      psReq("params") : Common::JsonValue(Common::JsonValue::NIL));
+    // params are read straight from the request text
+    if (!reader) {
+      throw std::runtime_error("Serializer doesn't support this type of serialization: Object expected.");
+    }
+
+    if (!reader->beginObject("params")) {
+      // omitted params leave the request with its defaults
+      std::string params;
+      if (reader->rawValue("params", params)) {
+        throw std::runtime_error("Serializer doesn't support this type of serialization: Object expected.");
+      }
+
+      return true;
+    }
+
+    serialize(v, *reader);
+    reader->endObject();
+    return true;
+  }
+
+  template <typename T>
+  bool loadParams(std::vector<T>& v) const {
+    size_t size = 0;
+    if (!reader || !reader->beginArray(size, "params")) {
+      throw std::runtime_error("JsonValue type is not ARRAY");
+    }
+
+    v.resize(size);
+    for (auto& item : v) {
+      (*reader)(item, "");
+    }
+
+    reader->endArray();
     return true;
   }
 
@@ -123,6 +154,7 @@ public:
 private:
 
   Common::JsonValue psReq;
+  std::unique_ptr<JsonInputReader> reader;
   OptionalId id;
   std::string method;
 };
@@ -162,12 +194,22 @@ public:
 
   std::string getBody() {
     psResp.set("jsonrpc", std::string("2.0"));
-    return psResp.toString();
+    std::string body = psResp.toString();
+    if (!result.empty()) {
+      // splice the already serialized result into the envelope object
+      body.pop_back();
+      body.reserve(body.size() + result.size() + 11);
+      body += ",\"result\":";
+      body += result;
+      body += '}';
+    }
+
+    return body;
   }
 
   template <typename T>
   bool setResult(const T& v) {
-    psResp.set("result", storeToJsonValue(v));
+    result = storeToJson(v);
     return true;
   }
 
@@ -183,11 +225,15 @@ public:
 
 private:
   Common::JsonValue psResp;
+  std::string result;
 };
 
 
 void invokeJsonRpcCommand(HttpClient& httpClient, JsonRpcRequest& req, JsonRpcResponse& res, const std::string& user = "", const std::string& password = "");
 
+// Splits a batch body into the texts of its calls, returns false if the body isn't an array
+bool splitBatchRequest(const std::string& body, std::vector<std::string>& calls);
+
 template <typename Request, typename Response>
 void invokeJsonRpcCommand(HttpClient& httpClient, const std::string& method, const Request& req, Response& res, const std::string& user = "", const std::string& password = "") {
   JsonRpcRequest jsReq;
@@ -0,0 +1,192 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "RpcMetrics.h"
+
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include "Common/RecursiveSharedMutex.h"
+
+namespace CryptoNote {
+
+using namespace Common;
+
+namespace {
+
+std::string formatMilliseconds(uint64_t microseconds, uint64_t count) {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(2) << (count == 0 ? 0.0 : static_cast<double>(microseconds) / count / 1000) << " ms";
+  return out.str();
+}
+
+}
+
+RpcMetrics::Call::Call(Endpoint& endpoint) : m_endpoint(endpoint), m_start(Clock::now()), m_lockWait(Clock::duration::zero()),
+  m_bytesIn(0), m_bytesOut(0), m_compressedBytesOut(0), m_compression(Clock::duration::zero()), m_compressed(false), m_failed(true) {
+  ++m_endpoint.inFlight;
+}
+
+RpcMetrics::Call::~Call() {
+  m_endpoint.latency.add(Clock::now() - m_start);
+  m_endpoint.lockWait.add(m_lockWait);
+  m_endpoint.bytesIn += m_bytesIn;
+  m_endpoint.bytesOut += m_bytesOut;
+  if (m_compressed) {
+    m_endpoint.compressedBytesOut += m_compressedBytesOut;
+    ++m_endpoint.compressedCalls;
+    m_endpoint.compression.add(m_compression);
+  }
+
+  ++m_endpoint.calls;
+  if (m_failed) {
+    ++m_endpoint.errors;
+  }
+
+  --m_endpoint.inFlight;
+}
+
+bool RpcMetrics::Call::execute(const std::function<bool()>& handler) {
+  Clock::duration waited = Tools::RecursiveSharedMutex::threadWaitTime();
+  bool result = handler();
+  m_lockWait += Tools::RecursiveSharedMutex::threadWaitTime() - waited;
+  return result;
+}
+
+void RpcMetrics::Call::setBytes(uint64_t in, uint64_t out) {
+  m_bytesIn = in;
+  m_bytesOut = out;
+}
+
+void RpcMetrics::Call::setCompressed(uint64_t out, Clock::duration time) {
+  m_compressedBytesOut = out;
+  m_compression = time;
+  m_compressed = true;
+}
+
+RpcMetrics::Endpoint& RpcMetrics::endpoint(const std::string& path, const std::string& method) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::unique_ptr<Endpoint>& endpoint = m_endpoints[Key(path, method)];
+  if (!endpoint) {
+    endpoint.reset(new Endpoint());
+  }
+
+  return *endpoint;
+}
+
+std::string RpcMetrics::prometheusText() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<std::pair<std::string, const Endpoint*>> endpoints;
+  for (const auto& entry : m_endpoints) {
+    std::string labels = "endpoint=\"" + entry.first.first + "\"";
+    if (!entry.first.second.empty()) {
+      labels += ",method=\"" + entry.first.second + "\"";
+    }
+
+    endpoints.emplace_back(labels, entry.second.get());
+  }
+
+  std::ostringstream out;
+  writeMetricHeader(out, "karbo_rpc_calls_total", "counter", "RPC calls handled.");
+  for (const auto& e : endpoints) {
+    out << "karbo_rpc_calls_total{" << e.first << "} " << e.second->calls << '\n';
+  }
+
+  writeMetricHeader(out, "karbo_rpc_errors_total", "counter", "RPC calls which failed.");
+  for (const auto& e : endpoints) {
+    out << "karbo_rpc_errors_total{" << e.first << "} " << e.second->errors << '\n';
+  }
+
+  writeMetricHeader(out, "karbo_rpc_in_flight", "gauge", "RPC calls being handled.");
+  for (const auto& e : endpoints) {
+    out << "karbo_rpc_in_flight{" << e.first << "} " << e.second->inFlight << '\n';
+  }
+
+  // JSON-RPC methods share the request body, bytes are counted for /json_rpc as a whole
+  writeMetricHeader(out, "karbo_rpc_received_bytes_total", "counter", "Request bodies received.");
+  for (const auto& e : endpoints) {
+    if (e.first.find(",method=") == std::string::npos) {
+      out << "karbo_rpc_received_bytes_total{" << e.first << "} " << e.second->bytesIn << '\n';
+    }
+  }
+
+  writeMetricHeader(out, "karbo_rpc_sent_bytes_total", "counter", "Response bodies sent.");
+  for (const auto& e : endpoints) {
+    if (e.first.find(",method=") == std::string::npos) {
+      out << "karbo_rpc_sent_bytes_total{" << e.first << "} " << e.second->bytesOut << '\n';
+    }
+  }
+
+  writeMetricHeader(out, "karbo_rpc_compressed_calls_total", "counter", "RPC calls answered with a compressed body.");
+  for (const auto& e : endpoints) {
+    if (e.first.find(",method=") == std::string::npos) {
+      out << "karbo_rpc_compressed_calls_total{" << e.first << "} " << e.second->compressedCalls << '\n';
+    }
+  }
+
+  writeMetricHeader(out, "karbo_rpc_compressed_sent_bytes_total", "counter", "Compressed response bodies sent.");
+  for (const auto& e : endpoints) {
+    if (e.first.find(",method=") == std::string::npos) {
+      out << "karbo_rpc_compressed_sent_bytes_total{" << e.first << "} " << e.second->compressedBytesOut << '\n';
+    }
+  }
+
+  writeMetricHeader(out, "karbo_rpc_call_duration_seconds", "histogram", "Time from the start of a call to its response.");
+  for (const auto& e : endpoints) {
+    writeMetricHistogram(out, "karbo_rpc_call_duration_seconds", e.first, e.second->latency, true);
+  }
+
+  writeMetricHeader(out, "karbo_rpc_lock_wait_seconds", "histogram", "Time a call was blocked on the blockchain lock.");
+  for (const auto& e : endpoints) {
+    writeMetricHistogram(out, "karbo_rpc_lock_wait_seconds", e.first, e.second->lockWait, true);
+  }
+
+  writeMetricHeader(out, "karbo_rpc_compression_seconds", "histogram", "Time spent compressing a response body.");
+  for (const auto& e : endpoints) {
+    if (e.first.find(",method=") == std::string::npos) {
+      writeMetricHistogram(out, "karbo_rpc_compression_seconds", e.first, e.second->compression, true);
+    }
+  }
+
+  return out.str();
+}
+
+std::string RpcMetrics::summary() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::ostringstream out;
+  for (const auto& entry : m_endpoints) {
+    const Endpoint& e = *entry.second;
+    out << entry.first.first << (entry.first.second.empty() ? "" : " " + entry.first.second) << ": calls " << e.calls <<
+      ", errors " << e.errors << ", in flight " << e.inFlight << ", avg " << formatMilliseconds(e.latency.sumMicroseconds(), e.latency.count()) <<
+      ", max " << formatMilliseconds(e.latency.maxMicroseconds(), 1) << ", lock wait avg " <<
+      formatMilliseconds(e.lockWait.sumMicroseconds(), e.lockWait.count());
+    if (entry.first.second.empty()) {
+      out << ", in " << e.bytesIn << " B, out " << e.bytesOut << " B";
+      if (e.compressedCalls != 0) {
+        out << ", compressed " << e.compressedCalls << " calls to " << e.compressedBytesOut << " B in " <<
+          formatMilliseconds(e.compression.sumMicroseconds(), e.compression.count()) << " avg";
+      }
+    }
+
+    out << '\n';
+  }
+
+  return out.str();
+}
+
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Common/Metrics.h"
+
+namespace CryptoNote {
+
+// Per endpoint call counters and latency histograms of the RPC server. An endpoint
+// is an HTTP path, JSON-RPC methods are counted separately under /json_rpc.
+class RpcMetrics {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  // latency histogram, bounded by Common::MetricsHistogram::DURATION_BOUNDS
+  class Histogram : public Common::MetricsHistogram {
+  public:
+    static const size_t BUCKETS = 10;
+
+    uint64_t sumMicroseconds() const { return sum(); }
+    uint64_t maxMicroseconds() const { return max(); }
+  };
+
+  struct Endpoint {
+    Endpoint() : calls(0), errors(0), inFlight(0), bytesIn(0), bytesOut(0), compressedBytesOut(0), compressedCalls(0) {}
+
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> errors;
+    std::atomic<int64_t> inFlight;
+    std::atomic<uint64_t> bytesIn;
+    std::atomic<uint64_t> bytesOut;
+    std::atomic<uint64_t> compressedBytesOut; // sent for the compressed responses, bytesOut counts them uncompressed
+    std::atomic<uint64_t> compressedCalls;
+    Histogram latency;
+    Histogram lockWait; // blocked on the blockchain lock, part of the latency
+    Histogram compression; // spent compressing the response body, part of the latency
+  };
+
+  // Counts one call from construction to destruction, as failed unless succeed() is called.
+  class Call {
+  public:
+    explicit Call(Endpoint& endpoint);
+    ~Call();
+    Call(const Call&) = delete;
+    Call& operator=(const Call&) = delete;
+
+    // runs the handler on the calling thread, adding the time it waited for the blockchain lock
+    bool execute(const std::function<bool()>& handler);
+    void setBytes(uint64_t in, uint64_t out);
+    void setCompressed(uint64_t out, Clock::duration time);
+    void succeed() { m_failed = false; }
+
+  private:
+    Endpoint& m_endpoint;
+    Clock::time_point m_start;
+    Clock::duration m_lockWait;
+    uint64_t m_bytesIn;
+    uint64_t m_bytesOut;
+    uint64_t m_compressedBytesOut;
+    Clock::duration m_compression;
+    bool m_compressed;
+    bool m_failed;
+  };
+
+  // the returned reference stays valid for the lifetime of the metrics
+  Endpoint& endpoint(const std::string& path, const std::string& method = std::string());
+
+  // Prometheus text exposition format
+  std::string prometheusText() const;
+  // one line per endpoint, for the daemon console
+  std::string summary() const;
+
+private:
+  typedef std::pair<std::string, std::string> Key;
+
+  mutable std::mutex m_mutex;
+  std::map<Key, std::unique_ptr<Endpoint>> m_endpoints;
+};
+
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+// Bounded least recently used map from a block or transaction hash to the
+// explorer data built for it, tagged with the height of the block it belongs to
+// so that entries can be dropped when the chain is rolled back. Safe to use from
+// several threads.
+template <typename Value>
+class RpcResponseCache {
+public:
+  explicit RpcResponseCache(size_t capacity) : m_capacity(capacity), m_hits(0), m_misses(0) {
+  }
+
+  bool get(const Crypto::Hash& key, Value& value) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+      ++m_misses;
+      return false;
+    }
+
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    value = it->second->value;
+    ++m_hits;
+    return true;
+  }
+
+  void put(const Crypto::Hash& key, uint32_t height, const Value& value) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+      it->second->height = height;
+      it->second->value = value;
+      m_entries.splice(m_entries.begin(), m_entries, it->second);
+      return;
+    }
+
+    m_entries.push_front({ key, height, value });
+    m_index.emplace(key, m_entries.begin());
+    if (m_entries.size() > m_capacity) {
+      m_index.erase(m_entries.back().key);
+      m_entries.pop_back();
+    }
+  }
+
+  // drops everything that belongs to blocks at or above the height
+  void removeFrom(uint32_t height) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+      if (it->height >= height) {
+        m_index.erase(it->key);
+        it = m_entries.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  uint64_t hits() const { return m_hits; }
+  uint64_t misses() const { return m_misses; }
+
+private:
+  struct Entry {
+    Crypto::Hash key;
+    uint32_t height;
+    Value value;
+  };
+
+  typedef std::list<Entry> Entries;
+
+  const size_t m_capacity;
+  std::mutex m_mutex;
+  Entries m_entries; // most recently used first
+  std::unordered_map<Crypto::Hash, typename Entries::iterator> m_index;
+  std::atomic<uint64_t> m_hits;
+  std::atomic<uint64_t> m_misses;
+};
+
+}
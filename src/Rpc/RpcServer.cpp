@@ -21,7 +21,9 @@
 #include "RpcServer.h"
 #include "version.h"
 
+#include <algorithm>
 #include <future>
+#include <limits>
 #include <unordered_map>
 #include <boost/lexical_cast.hpp>
 #include <boost/uuid/uuid.hpp>
@@ -29,10 +31,13 @@
 // CryptoNote
 #include <crypto/random.h>
 #include "BlockchainExplorerData.h"
+#include "Common/AllocationProfiler.h"
 #include "Common/Base58.h"
 #include "Common/DnsTools.h"
 #include "Common/Math.h"
+#include "Common/Metrics.h"
 #include "Common/StringTools.h"
+#include "CryptoNoteCore/BlockRecord.h"
 #include "CryptoNoteCore/TransactionUtils.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
@@ -41,8 +46,13 @@
 #include "CryptoNoteCore/Miner.h"
 #include "CryptoNoteCore/TransactionExtra.h"
 #include "CryptoNoteProtocol/ICryptoNoteProtocolQuery.h"
+#include "HTTP/HttpCompression.h"
 #include "P2p/ConnectionContext.h"
 #include "P2p/NetNode.h"
+#include <System/InterruptedException.h>
+#include <System/RemoteContext.h>
+#include <System/ThreadPool.h>
+#include <System/Timer.h>
 
 #include "CoreRpcServerErrorCodes.h"
 #include "JsonRpc.h"
@@ -51,6 +61,19 @@
 
 const uint32_t MAX_NUMBER_OF_BLOCKS_PER_STATS_REQUEST = 10000;
 const uint64_t BLOCK_LIST_MAX_COUNT = 1000;
+const time_t BLOCK_TEMPLATE_CACHE_LIFETIME = 10; // seconds, keeps template timestamps fresh
+const size_t BLOCK_TEMPLATE_CACHE_MAX_ENTRIES = 256;
+const std::chrono::seconds BLOCK_TEMPLATE_LONG_POLL_TIMEOUT(60);
+const uint32_t WAIT_FOR_CHANGES_MAX_TIMEOUT = 120; // seconds
+const size_t BLOCK_HEADER_CACHE_MAX_ENTRIES = 10000;
+const size_t BLOCK_DETAILS_CACHE_MAX_ENTRIES = 1000;
+const size_t TRANSACTION_DETAILS_CACHE_MAX_ENTRIES = 10000;
+const size_t JSON_RPC_BATCH_MAX_CALLS = 1000;
+const size_t RESERVE_PROOF_PROGRESS_INTERVAL = 1000; // checked entries between progress messages
+const size_t JSON_RPC_LOCKED_BATCH_MAX_CALLS = 100; // longer batches would hold off block imports
+const uint32_t STREAM_BLOCKS_CHUNK_MAX_BLOCKS = 1000;
+const size_t RESPONSE_COMPRESSION_MIN_SIZE = 1024; // bytes, smaller bodies fit a packet anyway
+const size_t STREAM_BLOCKS_CHUNK_SIZE = 1024 * 1024; // bytes, a chunk is cut after the block which crosses it
 
 namespace CryptoNote {
 
@@ -127,6 +150,21 @@ RpcServer::HandlerFunction httpMethod(bool (RpcServer::*handler)(typename Comman
   };
 }
 
+bool getQueryParameter(const std::string& url, const std::string& name, std::string& value) {
+  size_t pos = url.find('?');
+  while (pos != std::string::npos) {
+    size_t begin = pos + 1;
+    pos = url.find('&', begin);
+    std::string parameter = url.substr(begin, pos == std::string::npos ? std::string::npos : pos - begin);
+    if (parameter.size() > name.size() && parameter[name.size()] == '=' && parameter.compare(0, name.size(), name) == 0) {
+      value = parameter.substr(name.size() + 1);
+      return true;
+    }
+  }
+
+  return false;
+}
+
 }
 
 std::unordered_map<std::string, RpcServer::RpcHandler<RpcServer::HandlerFunction>> RpcServer::s_handlers = {
@@ -135,10 +173,16 @@ std::unordered_map<std::string, RpcServer::RpcHandler<RpcServer::HandlerFunction
   { "/getblocks.bin", { binMethod<COMMAND_RPC_GET_BLOCKS_FAST>(&RpcServer::on_get_blocks), true } },
   { "/queryblocks.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS>(&RpcServer::on_query_blocks), true } },
   { "/queryblockslite.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS_LITE>(&RpcServer::on_query_blocks_lite), true } },
+  { "/getblockfilters.bin", { binMethod<COMMAND_RPC_GET_BLOCK_FILTERS>(&RpcServer::on_get_block_filters), true } },
+  { "/getblockfilterheaders.bin", { binMethod<COMMAND_RPC_GET_BLOCK_FILTER_HEADERS>(&RpcServer::on_get_block_filter_headers), true } },
+  { "/queryblocksfiltered.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS_FILTERED>(&RpcServer::on_query_blocks_filtered), true } },
   { "/get_o_indexes.bin", { binMethod<COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES>(&RpcServer::on_get_indexes), true } },
+  { "/get_txs_o_indexes.bin", { binMethod<COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES>(&RpcServer::on_get_txs_indexes), true } },
   { "/getrandom_outs.bin", { binMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::on_get_random_outs), true } },
   { "/get_pool_changes.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::on_get_pool_changes), true } },
   { "/get_pool_changes_lite.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::on_get_pool_changes_lite), true } },
+  { "/stream_blocks.bin", { std::bind(&RpcServer::on_stream_blocks, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true } },
+  { "/metrics", { std::bind(&RpcServer::on_get_metrics, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true } },
 
   // plain text/html handlers
   { "/", { httpMethod<COMMAND_HTTP>(&RpcServer::on_get_index), true } },
@@ -149,9 +193,9 @@ std::unordered_map<std::string, RpcServer::RpcHandler<RpcServer::HandlerFunction
   { "/getinfo", { jsonMethod<COMMAND_RPC_GET_INFO>(&RpcServer::on_get_info), true } },
   { "/getheight", { jsonMethod<COMMAND_RPC_GET_HEIGHT>(&RpcServer::on_get_height), true } },
   { "/feeaddress", { jsonMethod<COMMAND_RPC_GET_FEE_ADDRESS>(&RpcServer::on_get_fee_address), true } },
-  { "/gettransactionspool", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_POOL_SHORT>(&RpcServer::on_get_transactions_pool_short), true } },
-  { "/gettransactionsinpool", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_POOL>(&RpcServer::on_get_transactions_pool), true } },
-  { "/getrawtransactionspool", { jsonMethod<COMMAND_RPC_GET_RAW_TRANSACTIONS_POOL>(&RpcServer::on_get_transactions_pool_raw), true } },
+  { "/gettransactionspool", { std::bind(&RpcServer::on_get_pool_listing_short, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true } },
+  { "/gettransactionsinpool", { std::bind(&RpcServer::on_get_pool_listing, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true } },
+  { "/getrawtransactionspool", { std::bind(&RpcServer::on_get_pool_listing_raw, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true } },
 
   // post json handlers
   { "/gettransactions", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS>(&RpcServer::on_get_transactions), false } },
@@ -163,6 +207,7 @@ std::unordered_map<std::string, RpcServer::RpcHandler<RpcServer::HandlerFunction
   { "/getrandom_outs", { jsonMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::on_get_random_outs), false } },
   { "/get_pool_changes", { jsonMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::on_get_pool_changes), true } },
   { "/get_pool_changes_lite", { jsonMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::on_get_pool_changes_lite), true } },
+  { "/wait_for_changes", { jsonMethod<COMMAND_RPC_WAIT_FOR_CHANGES>(&RpcServer::on_wait_for_changes), true } },
   { "/get_block_details_by_height", { jsonMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HEIGHT>(&RpcServer::on_get_block_details_by_height), true } },
   { "/get_block_details_by_hash", { jsonMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HASH>(&RpcServer::on_get_block_details_by_hash), true } },
   { "/get_blocks_details_by_heights", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS>(&RpcServer::on_get_blocks_details_by_heights), true } },
@@ -187,17 +232,61 @@ std::unordered_map<std::string, RpcServer::RpcHandler<RpcServer::HandlerFunction
 };
 
 RpcServer::RpcServer(System::Dispatcher& dispatcher, Logging::ILogger& log, CryptoNote::Core& core, NodeServer& p2p, ICryptoNoteProtocolQuery& protocolQuery) :
-  HttpServer(dispatcher, log), logger(log, "RpcServer"), m_core(core), m_p2p(p2p), m_protocolQuery(protocolQuery), blockchainExplorerDataBuilder(core, protocolQuery) {
+  HttpServer(dispatcher, log), logger(log, "RpcServer"), m_core(core), m_p2p(p2p), m_protocolQuery(protocolQuery), blockchainExplorerDataBuilder(core, protocolQuery),
+  m_coreChanged(dispatcher), m_peerListCounter(std::numeric_limits<uint64_t>::max()), m_blockHeaderCache(BLOCK_HEADER_CACHE_MAX_ENTRIES),
+  m_blockDetailsCache(BLOCK_DETAILS_CACHE_MAX_ENTRIES), m_transactionDetailsCache(TRANSACTION_DETAILS_CACHE_MAX_ENTRIES) {
+  m_core.addObserver(this);
+}
+
+// Heavy handlers that only read the blockchain through Core's locked queries,
+// they can run in the RPC worker threads without blocking the network thread.
+// Wallet queries go first, bulk explorer lists and stats are let in last.
+// The latency critical methods (sendrawtransaction, getblocktemplate, submitblock)
+// run on the network thread and never queue for a worker.
+const std::unordered_map<std::string, HttpServer::Priority> RpcServer::s_concurrentHandlers = {
+  { "/get_o_indexes.bin", PRIORITY_HIGH }, { "/get_txs_o_indexes.bin", PRIORITY_HIGH }, { "/getrandom_outs.bin", PRIORITY_HIGH }, { "/get_o_indexes", PRIORITY_HIGH },
+  { "/getrandom_outs", PRIORITY_HIGH }, { "/gettransactions", PRIORITY_HIGH },
+  { "/getblocks.bin", PRIORITY_NORMAL }, { "/queryblocks.bin", PRIORITY_NORMAL }, { "/queryblockslite.bin", PRIORITY_NORMAL },
+  { "/queryblocksfiltered.bin", PRIORITY_NORMAL }, { "/getblockfilters.bin", PRIORITY_NORMAL },
+  { "/getblocks", PRIORITY_NORMAL }, { "/queryblocks", PRIORITY_NORMAL }, { "/queryblockslite", PRIORITY_NORMAL },
+  { "/get_block_details_by_height", PRIORITY_NORMAL }, { "/get_block_details_by_hash", PRIORITY_NORMAL },
+  { "/get_transaction_details_by_hash", PRIORITY_NORMAL }, { "/get_transaction_hashes_by_payment_id", PRIORITY_NORMAL },
+  { "/get_blocks_details_by_heights", PRIORITY_LOW }, { "/get_blocks_details_by_hashes", PRIORITY_LOW },
+  { "/get_blocks_hashes_by_timestamps", PRIORITY_LOW }, { "/get_transaction_details_by_hashes", PRIORITY_LOW },
+  { "/get_transaction_details_by_heights", PRIORITY_LOW }, { "/get_raw_transactions_by_heights", PRIORITY_LOW }
+};
+
+const std::unordered_map<std::string, HttpServer::Priority> RpcServer::s_concurrentJsonRpcMethods = {
+  { "checktransactionkey", PRIORITY_HIGH }, { "checktransactionbyviewkey", PRIORITY_HIGH },
+  { "checktransactionproof", PRIORITY_HIGH }, { "checkreserveproof", PRIORITY_HIGH },
+  { "getblockbyheight", PRIORITY_NORMAL }, { "getblockbyhash", PRIORITY_NORMAL }, { "gettransaction", PRIORITY_NORMAL },
+  { "gettransactionsbypaymentid", PRIORITY_NORMAL }, { "gettransactionhashesbypaymentid", PRIORITY_NORMAL },
+  { "getblocksbyheights", PRIORITY_LOW }, { "getblocksbyhashes", PRIORITY_LOW }, { "getblockshashesbytimestamps", PRIORITY_LOW },
+  { "getblockslist", PRIORITY_LOW }, { "gettransactionsbyhashes", PRIORITY_LOW }, { "gettransactionsbyheights", PRIORITY_LOW },
+  { "getrawtransactionsbyheights", PRIORITY_LOW }, { "getstatsbyheights", PRIORITY_LOW }, { "getstatsinrange", PRIORITY_LOW }
+};
+
+// Blockchain-only queries that never touch the pool, so a batch of them can hold
+// the blockchain read lock throughout without inverting the pool -> chain lock order.
+const std::unordered_set<std::string> RpcServer::s_blockchainLockedJsonRpcMethods = {
+  "getblockcount", "getblockhash", "getblockheaderbyhash", "getblockheaderbyheight", "getblocktimestamp",
+  "getheightsbytimestamps", "getlastblockheader"
+};
+
+RpcServer::~RpcServer() {
+  m_core.removeObserver(this);
 }
 
 void RpcServer::processRequest(const HttpRequest& request, HttpResponse& response) {
+  Common::AllocationScope allocationScope(Common::AllocationSubsystem::Rpc);
   //logger(Logging::TRACE) << "RPC request came: \n" << request << std::endl;
 
   try {
 
   auto url = request.getUrl();
 
-  auto it = s_handlers.find(url);
+  std::string path = url.substr(0, url.find('?'));
+  auto it = s_handlers.find(path);
   if (it == s_handlers.end()) {
     if (Common::starts_with(url, "/api/")) {
 
@@ -312,19 +401,7 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
           return;
         }
 
-        COMMAND_RPC_GET_TRANSACTIONS_POOL::request req;
-        COMMAND_RPC_GET_TRANSACTIONS_POOL::response rsp;
-        bool r = on_get_transactions_pool(req, rsp);
-        if (r) {
-          response.addHeader("Content-Type", "application/json");
-          response.setStatus(HttpResponse::HTTP_STATUS::STATUS_200);
-          response.setBody(storeToJson(rsp));
-        }
-        else {
-          response.setStatus(HttpResponse::STATUS_500);
-          response.setBody("Internal error");
-        }
-
+        on_get_pool_listing(request, response);
         return;
 
       }
@@ -344,7 +421,29 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
     return;
   }
 
-  it->second.handler(this, request, response);
+  RpcMetrics::Call call(m_metrics.endpoint(path));
+  auto handler = [this, &it, &request, &response] { return it->second.handler(this, request, response); };
+  bool result = false;
+  // the response is compressed in the same thread as it is made
+  auto serve = [this, &call, &handler, &result, &request, &response] {
+    result = call.execute(handler);
+    call.setBytes(request.getBody().size(), response.getBody().size());
+    compressResponse(request, response, call);
+  };
+
+  auto concurrent = s_concurrentHandlers.find(path);
+  if (concurrent != s_concurrentHandlers.end()) {
+    if (!runConcurrently(serve, concurrent->second)) {
+      response.setStatus(HttpResponse::STATUS_503);
+      return;
+    }
+  } else {
+    serve();
+  }
+
+  if (result && (response.getStatus() == HttpResponse::STATUS_200 || response.getStatus() == HttpResponse::STATUS_304)) {
+    call.succeed();
+  }
 
   }
   catch (const JsonRpc::JsonRpcError& err) {
@@ -358,6 +457,29 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
   }
 }
 
+void RpcServer::compressResponse(const HttpRequest& request, HttpResponse& response, RpcMetrics::Call& call) {
+  if (response.isChunked() || response.getBody().size() < RESPONSE_COMPRESSION_MIN_SIZE) {
+    return;
+  }
+
+  auto accepted = request.getHeaders().find("accept-encoding");
+  if (accepted == request.getHeaders().end()) {
+    return;
+  }
+
+  std::string encoding = HttpCompression::negotiate(accepted->second);
+  if (encoding.empty()) {
+    return;
+  }
+
+  RpcMetrics::Clock::time_point start = RpcMetrics::Clock::now();
+  std::string body = HttpCompression::compress(response.getBody(), encoding);
+  call.setCompressed(body.size(), RpcMetrics::Clock::now() - start);
+  response.addHeader("Content-Encoding", encoding);
+  response.addHeader("Vary", "Accept-Encoding");
+  response.setBody(std::move(body));
+}
+
 bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse& response) {
 
   using namespace JsonRpc;
@@ -369,73 +491,187 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
     response.addHeader("Access-Control-Allow-Methods", "POST, GET");
   }  
 
-  JsonRpcRequest jsonRequest;
-  JsonRpcResponse jsonResponse;
+  std::vector<std::string> calls;
+  try {
+    if (!splitBatchRequest(request.getBody(), calls)) {
+      JsonRpcRequest jsonRequest;
+      JsonRpcResponse jsonResponse;
+      if (parseJsonRpcCall(request.getBody(), jsonRequest, jsonResponse)) {
+        executeJsonRpcCall(jsonRequest, jsonResponse, true);
+      }
+
+      JsonRpcError error;
+      if (jsonResponse.getError(error) && error.code == CORE_RPC_ERROR_CODE_SERVER_BUSY) {
+        response.setStatus(HttpResponse::STATUS_503);
+      }
+
+      response.setBody(jsonResponse.getBody());
+      return true;
+    }
+
+    if (calls.empty()) {
+      throw JsonRpcError(errInvalidRequest);
+    }
+
+    if (calls.size() > JSON_RPC_BATCH_MAX_CALLS) {
+      throw JsonRpcError(errInvalidRequest, "Too many calls in the batch, at most " + std::to_string(JSON_RPC_BATCH_MAX_CALLS) + " are allowed");
+    }
+  } catch (const JsonRpcError& err) {
+    JsonRpcResponse jsonResponse;
+    jsonResponse.setError(err);
+    response.setBody(jsonResponse.getBody());
+    return true;
+  }
+
+  std::vector<JsonRpcRequest> jsonRequests(calls.size());
+  std::vector<JsonRpcResponse> jsonResponses(calls.size());
+  std::vector<bool> parsed(calls.size());
+  bool allConcurrent = true;
+  bool allLocked = calls.size() <= JSON_RPC_LOCKED_BATCH_MAX_CALLS;
+  Priority priority = PRIORITY_HIGH; // the batch waits as its lowest priority call would
+  for (size_t i = 0; i < calls.size(); ++i) {
+    parsed[i] = parseJsonRpcCall(calls[i], jsonRequests[i], jsonResponses[i]);
+    if (parsed[i]) {
+      auto concurrent = s_concurrentJsonRpcMethods.find(jsonRequests[i].getMethod());
+      allConcurrent = allConcurrent && concurrent != s_concurrentJsonRpcMethods.end();
+      if (allConcurrent) {
+        priority = std::max(priority, concurrent->second);
+      }
+
+      allLocked = allLocked && s_blockchainLockedJsonRpcMethods.count(jsonRequests[i].getMethod()) != 0;
+    }
+  }
+
+  auto executeAll = [&](bool allowConcurrent) {
+    for (size_t i = 0; i < calls.size(); ++i) {
+      if (parsed[i]) {
+        executeJsonRpcCall(jsonRequests[i], jsonResponses[i], allowConcurrent);
+      }
+    }
+  };
+
+  if (allLocked) {
+    // chain queries only, answer them from one consistent snapshot
+    ReadOnlyLockedBlockchainStorage lock(m_core.get_blockchain_storage());
+    executeAll(false);
+  } else if (allConcurrent) {
+    if (!runConcurrently([&executeAll] { executeAll(false); }, priority)) {
+      response.setStatus(HttpResponse::STATUS_503);
+      for (size_t i = 0; i < calls.size(); ++i) {
+        if (parsed[i]) {
+          jsonResponses[i].setError(JsonRpcError(CORE_RPC_ERROR_CODE_SERVER_BUSY, "Server is busy"));
+        }
+      }
+    }
+  } else {
+    executeAll(true);
+  }
+
+  std::string body = "[";
+  for (size_t i = 0; i < jsonResponses.size(); ++i) {
+    if (i != 0) {
+      body += ',';
+    }
+
+    body += jsonResponses[i].getBody();
+  }
+
+  body += ']';
+  response.setBody(std::move(body));
+  return true;
+}
+
+bool RpcServer::parseJsonRpcCall(const std::string& call, JsonRpc::JsonRpcRequest& jsonRequest, JsonRpc::JsonRpcResponse& jsonResponse) {
+  using namespace JsonRpc;
 
   try {
-    //logger(Logging::TRACE) << "JSON-RPC request: " << request.getBody();
-    jsonRequest.parseRequest(request.getBody());
+    //logger(Logging::TRACE) << "JSON-RPC request: " << call;
+    jsonRequest.parseRequest(call);
     jsonResponse.setId(jsonRequest.getId()); // copy id
+    return true;
+  } catch (const JsonRpcError& err) {
+    jsonResponse.setError(err);
+  } catch (const std::exception& e) {
+    jsonResponse.setError(JsonRpcError(JsonRpc::errInternalError, e.what()));
+  }
 
-    static std::unordered_map<std::string, RpcServer::RpcHandler<JsonMemberMethod>> jsonRpcHandlers = {
-  
-      { "getblockcount", { makeMemberMethod(&RpcServer::on_getblockcount), true } },
-      { "getblockhash", { makeMemberMethod(&RpcServer::on_getblockhash), true } },
-      { "getblocktemplate", { makeMemberMethod(&RpcServer::on_getblocktemplate), true } },
-      { "getblockheaderbyhash", { makeMemberMethod(&RpcServer::on_get_block_header_by_hash), true } },
-      { "getblockheaderbyheight", { makeMemberMethod(&RpcServer::on_get_block_header_by_height), true } },
-      { "getblocktimestamp", { makeMemberMethod(&RpcServer::on_get_block_timestamp_by_height), true } },
-      { "getblockbyheight", { makeMemberMethod(&RpcServer::on_get_block_details_by_height), true } },
-      { "getblockbyhash", { makeMemberMethod(&RpcServer::on_get_block_details_by_hash), true } },
-      { "getblocksbyheights", { makeMemberMethod(&RpcServer::on_get_blocks_details_by_heights), true } },
-      { "getblocksbyhashes", { makeMemberMethod(&RpcServer::on_get_blocks_details_by_hashes), true } },
-      { "getblockshashesbytimestamps", { makeMemberMethod(&RpcServer::on_get_blocks_hashes_by_timestamps), true } },
-      { "getblockslist", { makeMemberMethod(&RpcServer::on_blocks_list_json), true } },
-      { "getaltblockslist", { makeMemberMethod(&RpcServer::on_alt_blocks_list_json), true } },
-      { "getlastblockheader", { makeMemberMethod(&RpcServer::on_get_last_block_header), true } },
-      { "gettransaction", { makeMemberMethod(&RpcServer::on_get_transaction_details_by_hash), true } },
-      { "gettransactionspool", { makeMemberMethod(&RpcServer::on_get_transactions_pool_short), true } },
-      { "getrawtransactionspool", { makeMemberMethod(&RpcServer::on_get_transactions_pool_raw), true } },
-      { "gettransactionsinpool", { makeMemberMethod(&RpcServer::on_get_transactions_pool), true } },
-      { "gettransactionsbypaymentid", { makeMemberMethod(&RpcServer::on_get_transactions_by_payment_id), true } },
-      { "gettransactionhashesbypaymentid", { makeMemberMethod(&RpcServer::on_get_transaction_hashes_by_paymentid), true } },
-      { "gettransactionsbyhashes", { makeMemberMethod(&RpcServer::on_get_transactions_details_by_hashes), true } },
-      { "gettransactionsbyheights", { makeMemberMethod(&RpcServer::on_get_transactions_details_by_heights), true } },
-      { "getrawtransactionsbyheights", { makeMemberMethod(&RpcServer::on_get_transactions_with_output_global_indexes_by_heights), true } },
-      { "getcurrencyid", { makeMemberMethod(&RpcServer::on_get_currency_id), true } },
-      { "getstatsbyheights", { makeMemberMethod(&RpcServer::on_get_stats_by_heights), false } },
-      { "getstatsinrange", { makeMemberMethod(&RpcServer::on_get_stats_by_heights_range), false } },
-      { "checktransactionkey", { makeMemberMethod(&RpcServer::on_check_transaction_key), true } },
-      { "checktransactionbyviewkey", { makeMemberMethod(&RpcServer::on_check_transaction_with_view_key), true } },
-      { "checktransactionproof", { makeMemberMethod(&RpcServer::on_check_transaction_proof), true } },
-      { "checkreserveproof", { makeMemberMethod(&RpcServer::on_check_reserve_proof), true } },
-      { "validateaddress", { makeMemberMethod(&RpcServer::on_validate_address), true } },
-      { "verifymessage", { makeMemberMethod(&RpcServer::on_verify_message), true } },
-      { "submitblock", { makeMemberMethod(&RpcServer::on_submitblock), false } },
-      { "resolveopenalias", { makeMemberMethod(&RpcServer::on_resolve_open_alias), true } },
+  return false;
+}
 
-    };
+void RpcServer::executeJsonRpcCall(JsonRpc::JsonRpcRequest& jsonRequest, JsonRpc::JsonRpcResponse& jsonResponse, bool allowConcurrent) {
+  using namespace JsonRpc;
+
+  try {
+  static std::unordered_map<std::string, RpcServer::RpcHandler<JsonMemberMethod>> jsonRpcHandlers = {
+
+    { "getblockcount", { makeMemberMethod(&RpcServer::on_getblockcount), true } },
+    { "getblockhash", { makeMemberMethod(&RpcServer::on_getblockhash), true } },
+    { "getblocktemplate", { makeMemberMethod(&RpcServer::on_getblocktemplate), true } },
+    { "getblockheaderbyhash", { makeMemberMethod(&RpcServer::on_get_block_header_by_hash), true } },
+    { "getblockheaderbyheight", { makeMemberMethod(&RpcServer::on_get_block_header_by_height), true } },
+    { "getblocktimestamp", { makeMemberMethod(&RpcServer::on_get_block_timestamp_by_height), true } },
+    { "getheightsbytimestamps", { makeMemberMethod(&RpcServer::on_get_heights_by_timestamps), true } },
+    { "getblockbyheight", { makeMemberMethod(&RpcServer::on_get_block_details_by_height), true } },
+    { "getblockbyhash", { makeMemberMethod(&RpcServer::on_get_block_details_by_hash), true } },
+    { "getblocksbyheights", { makeMemberMethod(&RpcServer::on_get_blocks_details_by_heights), true } },
+    { "getblocksbyhashes", { makeMemberMethod(&RpcServer::on_get_blocks_details_by_hashes), true } },
+    { "getblockshashesbytimestamps", { makeMemberMethod(&RpcServer::on_get_blocks_hashes_by_timestamps), true } },
+    { "getblockslist", { makeMemberMethod(&RpcServer::on_blocks_list_json), true } },
+    { "getaltblockslist", { makeMemberMethod(&RpcServer::on_alt_blocks_list_json), true } },
+    { "getlastblockheader", { makeMemberMethod(&RpcServer::on_get_last_block_header), true } },
+    { "gettransaction", { makeMemberMethod(&RpcServer::on_get_transaction_details_by_hash), true } },
+    { "gettransactionspool", { makeMemberMethod(&RpcServer::on_get_transactions_pool_short), true } },
+    { "getrawtransactionspool", { makeMemberMethod(&RpcServer::on_get_transactions_pool_raw), true } },
+    { "gettransactionsinpool", { makeMemberMethod(&RpcServer::on_get_transactions_pool), true } },
+    { "gettransactionsbypaymentid", { makeMemberMethod(&RpcServer::on_get_transactions_by_payment_id), true } },
+    { "gettransactionhashesbypaymentid", { makeMemberMethod(&RpcServer::on_get_transaction_hashes_by_paymentid), true } },
+    { "gettransactionsbyhashes", { makeMemberMethod(&RpcServer::on_get_transactions_details_by_hashes), true } },
+    { "gettransactionsbyheights", { makeMemberMethod(&RpcServer::on_get_transactions_details_by_heights), true } },
+    { "getrawtransactionsbyheights", { makeMemberMethod(&RpcServer::on_get_transactions_with_output_global_indexes_by_heights), true } },
+    { "getcurrencyid", { makeMemberMethod(&RpcServer::on_get_currency_id), true } },
+    { "getstatsbyheights", { makeMemberMethod(&RpcServer::on_get_stats_by_heights), false } },
+    { "getstatsinrange", { makeMemberMethod(&RpcServer::on_get_stats_by_heights_range), false } },
+    { "checktransactionkey", { makeMemberMethod(&RpcServer::on_check_transaction_key), true } },
+    { "checktransactionbyviewkey", { makeMemberMethod(&RpcServer::on_check_transaction_with_view_key), true } },
+    { "checktransactionproof", { makeMemberMethod(&RpcServer::on_check_transaction_proof), true } },
+    { "checkreserveproof", { makeMemberMethod(&RpcServer::on_check_reserve_proof), true } },
+    { "validateaddress", { makeMemberMethod(&RpcServer::on_validate_address), true } },
+    { "verifymessage", { makeMemberMethod(&RpcServer::on_verify_message), true } },
+    { "submitblock", { makeMemberMethod(&RpcServer::on_submitblock), false } },
+    { "resolveopenalias", { makeMemberMethod(&RpcServer::on_resolve_open_alias), true } },
+
+  };
 
     auto it = jsonRpcHandlers.find(jsonRequest.getMethod());
     if (it == jsonRpcHandlers.end()) {
       throw JsonRpcError(JsonRpc::errMethodNotFound);
     }
 
+    RpcMetrics::Call call(m_metrics.endpoint("/json_rpc", jsonRequest.getMethod()));
     if (!it->second.allowBusyCore && !isCoreReady()) {
       throw JsonRpcError(CORE_RPC_ERROR_CODE_CORE_BUSY, "Core is busy");
     }
 
-    it->second.handler(this, jsonRequest, jsonResponse);
+    auto handler = [this, &it, &jsonRequest, &jsonResponse] { return it->second.handler(this, jsonRequest, jsonResponse); };
+    bool result = false;
+    auto concurrent = s_concurrentJsonRpcMethods.find(jsonRequest.getMethod());
+    if (allowConcurrent && concurrent != s_concurrentJsonRpcMethods.end()) {
+      if (!runConcurrently([&call, &handler, &result] { result = call.execute(handler); }, concurrent->second)) {
+        throw JsonRpcError(CORE_RPC_ERROR_CODE_SERVER_BUSY, "Server is busy");
+      }
+    } else {
+      result = call.execute(handler);
+    }
+
+    if (result) {
+      call.succeed();
+    }
 
   } catch (const JsonRpcError& err) {
     jsonResponse.setError(err);
   } catch (const std::exception& e) {
     jsonResponse.setError(JsonRpcError(JsonRpc::errInternalError, e.what()));
   }
-
-  response.setBody(jsonResponse.getBody());
-  //logger(Logging::TRACE) << "JSON-RPC response: " << jsonResponse.getBody();
-  return true;
 }
 
 bool RpcServer::restrictRpc(const bool is_restricted) {
@@ -480,7 +716,7 @@ bool RpcServer::setContactInfo(const std::string& contact) {
 }
 
 bool RpcServer::isCoreReady() {
-  return m_core.currency().isTestnet() || m_p2p.get_payload_object().isSynchronized();
+  return m_core.isInitialized() && (m_core.currency().isTestnet() || m_p2p.get_payload_object().isSynchronized());
 }
 
 bool RpcServer::checkIncomingTransactionForFee(const BinaryArray& tx_blob) {
@@ -580,11 +816,64 @@ bool RpcServer::on_query_blocks_lite(const COMMAND_RPC_QUERY_BLOCKS_LITE::reques
   uint32_t startHeight;
   uint32_t currentHeight;
   uint32_t fullOffset;
-  if (!m_core.queryBlocksLite(req.blockIds, req.timestamp, startHeight, currentHeight, fullOffset, res.items)) {
+  if (!m_core.queryBlocksLite(req.blockIds, req.timestamp, startHeight, currentHeight, fullOffset, res.items, req.needGlobalIndexes)) {
+    res.status = "Failed to perform query";
+    return false;
+  }
+
+  res.startHeight = startHeight;
+  res.currentHeight = currentHeight;
+  res.fullOffset = fullOffset;
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
+bool RpcServer::on_get_block_filters(const COMMAND_RPC_GET_BLOCK_FILTERS::request& req, COMMAND_RPC_GET_BLOCK_FILTERS::response& res) {
+  uint32_t count = std::min(req.count, static_cast<uint32_t>(BLOCK_FILTERS_MAX_COUNT));
+  if (!m_core.getBlockFilters(req.blockIds, count, res.startHeight, res.items)) {
+    res.status = "Failed to get block filters";
+    return false;
+  }
+
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
+bool RpcServer::on_get_block_filter_headers(const COMMAND_RPC_GET_BLOCK_FILTER_HEADERS::request& req, COMMAND_RPC_GET_BLOCK_FILTER_HEADERS::response& res) {
+  uint32_t count = std::min(req.count, static_cast<uint32_t>(BLOCK_FILTER_HEADERS_MAX_COUNT));
+  if (!m_core.getBlockFilterHeaders(req.startHeight, count, res.headers)) {
+    res.status = "Failed to get block filter headers";
+    return false;
+  }
+
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
+bool RpcServer::on_query_blocks_filtered(const COMMAND_RPC_QUERY_BLOCKS_FILTERED::request& req, COMMAND_RPC_QUERY_BLOCKS_FILTERED::response& res) {
+  // the wallet hands over its view key, only a daemon of its own should get it
+  if (m_restricted_rpc) {
+    res.status = "Method disabled";
+    return false;
+  }
+
+  ViewKeyScanner scanner(req.viewSecretKey, req.spendPublicKeys);
+  for (const auto& output : req.watchedOutputs) {
+    scanner.watch(ViewKeyScanner::OutputReference(output.amount, output.globalIndex));
+  }
+
+  uint32_t startHeight;
+  uint32_t currentHeight;
+  uint32_t fullOffset;
+  if (!m_core.queryBlocksFiltered(req.blockIds, req.timestamp, scanner, startHeight, currentHeight, fullOffset, res.items)) {
     res.status = "Failed to perform query";
     return false;
   }
 
+  for (const auto& output : scanner.foundOutputs()) {
+    res.foundOutputs.push_back(OutputReference{ output.first, output.second });
+  }
+
   res.startHeight = startHeight;
   res.currentHeight = currentHeight;
   res.fullOffset = fullOffset;
@@ -605,6 +894,27 @@ bool RpcServer::on_get_indexes(const COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES::
   return true;
 }
 
+bool RpcServer::on_get_txs_indexes(const COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES::request& req, COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES::response& res) {
+  if (req.txids.size() > TRANSACTIONS_OUTPUT_INDEXES_MAX_COUNT) {
+    res.status = "Too many transactions requested";
+    return true;
+  }
+
+  std::vector<std::vector<uint32_t>> outputIndexes;
+  if (!m_core.getTransactionsOutputGlobalIndexes(req.txids, outputIndexes)) {
+    res.status = "Failed";
+    return true;
+  }
+
+  res.indexes.reserve(outputIndexes.size());
+  for (auto& indexes : outputIndexes) {
+    res.indexes.push_back(TransactionOutputIndexes{ std::move(indexes) });
+  }
+
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
 bool RpcServer::on_get_random_outs(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response& res) {
   res.status = "Failed";
   if (!m_core.get_random_outs_for_amounts(req, res)) {
@@ -637,7 +947,8 @@ bool RpcServer::on_get_random_outs(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOU
 bool RpcServer::on_get_pool_changes(const COMMAND_RPC_GET_POOL_CHANGES::request& req, COMMAND_RPC_GET_POOL_CHANGES::response& rsp) {
   rsp.status = CORE_RPC_STATUS_OK;
   std::vector<CryptoNote::Transaction> addedTransactions;
-  rsp.isTailBlockActual = m_core.getPoolChanges(req.tailBlockId, req.knownTxsIds, addedTransactions, rsp.deletedTxsIds);
+  rsp.poolSequence = req.poolSequence;
+  rsp.isTailBlockActual = m_core.getPoolChanges(req.tailBlockId, req.knownTxsIds, rsp.poolSequence, addedTransactions, rsp.deletedTxsIds, rsp.isPoolSequenceActual);
   for (auto& tx : addedTransactions) {
     BinaryArray txBlob;
     if (!toBinaryArray(tx, txBlob)) {
@@ -653,8 +964,80 @@ bool RpcServer::on_get_pool_changes(const COMMAND_RPC_GET_POOL_CHANGES::request&
 
 bool RpcServer::on_get_pool_changes_lite(const COMMAND_RPC_GET_POOL_CHANGES_LITE::request& req, COMMAND_RPC_GET_POOL_CHANGES_LITE::response& rsp) {
   rsp.status = CORE_RPC_STATUS_OK;
-  rsp.isTailBlockActual = m_core.getPoolChangesLite(req.tailBlockId, req.knownTxsIds, rsp.addedTxs, rsp.deletedTxsIds);
+  rsp.poolSequence = req.poolSequence;
+  rsp.isTailBlockActual = m_core.getPoolChangesLite(req.tailBlockId, req.knownTxsIds, rsp.poolSequence, rsp.addedTxs, rsp.deletedTxsIds, rsp.isPoolSequenceActual);
+
+  return true;
+}
 
+bool RpcServer::on_wait_for_changes(const COMMAND_RPC_WAIT_FOR_CHANGES::request& req, COMMAND_RPC_WAIT_FOR_CHANGES::response& rsp) {
+  uint32_t timeout = std::min(req.timeout, WAIT_FOR_CHANGES_MAX_TIMEOUT);
+  if (timeout > 0) {
+    waitCoreChange([this, &req] {
+      return m_core.get_tail_id() != req.tailBlockId || m_core.getPoolModificationCounter() != req.poolModificationCounter;
+    }, std::chrono::seconds(timeout));
+  }
+
+  m_core.get_blockchain_top(rsp.height, rsp.tailBlockId);
+  rsp.poolModificationCounter = m_core.getPoolModificationCounter();
+  rsp.isTailBlockChanged = rsp.tailBlockId != req.tailBlockId;
+  rsp.isPoolChanged = rsp.poolModificationCounter != req.poolModificationCounter;
+  rsp.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
+bool RpcServer::on_stream_blocks(const HttpRequest& request, HttpResponse& response) {
+  uint32_t height = m_core.getCurrentBlockchainHeight();
+  std::string from, to;
+  uint32_t first = 0, last = height - 1;
+  if (!getQueryParameter(request.getUrl(), "from", from) || !Common::fromString(from, first) ||
+      (getQueryParameter(request.getUrl(), "to", to) && !Common::fromString(to, last)) || first > last || first >= height) {
+    response.setStatus(HttpResponse::STATUS_500);
+    response.setBody("Invalid block range");
+    return false;
+  }
+
+  // blocks are read from the store chunk by chunk while the previous chunk is sent,
+  // the read lock is taken per chunk so imports go on in between
+  auto next = std::make_shared<uint32_t>(first);
+  last = std::min(last, height - 1);
+  response.addHeader("Content-Type", "application/octet-stream");
+  response.setBodyProducer([this, next, last](std::string& data) {
+    uint32_t visited = 0;
+    bool started = runConcurrently([this, next, last, &data, &visited] {
+      visited = m_core.visitRawBlocks(*next, std::min(last - *next + 1, STREAM_BLOCKS_CHUNK_MAX_BLOCKS), [&data](const Blockchain::RawBlock& rawBlock) {
+        appendBlockRecord(data, rawBlock);
+        return data.size() < STREAM_BLOCKS_CHUNK_SIZE;
+      });
+    }, PRIORITY_LOW);
+
+    if (!started) {
+      // the stream is cut short, the client resumes from the last whole record
+      throw std::runtime_error("Server is busy");
+    }
+
+    *next += visited;
+    return visited != 0 && *next <= last;
+  });
+
+  return true;
+}
+
+bool RpcServer::on_get_metrics(const HttpRequest& request, HttpResponse& response) {
+  // runs on the network thread, which owns the P2P and dispatcher state read below
+  std::ostringstream out;
+  out << m_metrics.prometheusText();
+  m_core.writeMetrics(out);
+  m_p2p.writeMetrics(out);
+  Common::writeAllocationMetrics(out);
+
+  Common::writeMetricHeader(out, "karbo_dispatcher_contexts", "gauge", "Dispatcher contexts spawned and not finished.");
+  out << "karbo_dispatcher_contexts " << m_dispatcher.getRunningContextCount() << '\n';
+  Common::writeMetricHeader(out, "karbo_dispatcher_run_queue", "gauge", "Dispatcher contexts ready to run.");
+  out << "karbo_dispatcher_run_queue " << m_dispatcher.getResumingContextCount() << '\n';
+
+  response.addHeader("Content-Type", "text/plain; version=0.0.4");
+  response.setBody(out.str());
   return true;
 }
 
@@ -735,15 +1118,18 @@ bool RpcServer::on_get_block_details_by_height(const COMMAND_RPC_GET_BLOCK_DETAI
         std::string("To big height: ") + std::to_string(req.blockHeight) + ", current blockchain height = " + std::to_string(m_core.getCurrentBlockchainHeight() - 1) };
     }
     Crypto::Hash block_hash = m_core.getBlockIdByHeight(req.blockHeight);
-    Block blk;
-    if (!m_core.getBlockByHash(block_hash, blk)) {
-      throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
-        "Internal error: can't get block by height " + std::to_string(req.blockHeight) + '.' };
-  }
-    if (!blockchainExplorerDataBuilder.fillBlockDetails(blk, blockDetails, true)) {
-      throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "Internal error: can't fill block details." };
+    if (!getCachedBlockDetails(block_hash, blockDetails)) {
+      Block blk;
+      if (!m_core.getBlockByHash(block_hash, blk)) {
+        throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
+          "Internal error: can't get block by height " + std::to_string(req.blockHeight) + '.' };
+      }
+      if (!blockchainExplorerDataBuilder.fillBlockDetails(blk, blockDetails, true)) {
+        throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "Internal error: can't fill block details." };
+      }
+      cacheBlockDetails(block_hash, blockDetails);
     }
-    rsp.block = blockDetails;
+    rsp.block = std::move(blockDetails);
   }
   catch (std::system_error& e) {
     throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, e.what() };
@@ -766,16 +1152,19 @@ bool RpcServer::on_get_block_details_by_hash(const COMMAND_RPC_GET_BLOCK_DETAILS
         CORE_RPC_ERROR_CODE_WRONG_PARAM,
         "Failed to parse hex representation of block hash. Hex = " + req.hash + '.' };
     }
-    Block blk;
-    if (!m_core.getBlockByHash(block_hash, blk)) {
-      throw JsonRpc::JsonRpcError{
-        CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
-        "Internal error: can't get block by hash. Hash = " + req.hash + '.' };
-    }
-    if (!blockchainExplorerDataBuilder.fillBlockDetails(blk, blockDetails, true)) {
-      throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "Internal error: can't fill block details." };
+    if (!getCachedBlockDetails(block_hash, blockDetails)) {
+      Block blk;
+      if (!m_core.getBlockByHash(block_hash, blk)) {
+        throw JsonRpc::JsonRpcError{
+          CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
+          "Internal error: can't get block by hash. Hash = " + req.hash + '.' };
+      }
+      if (!blockchainExplorerDataBuilder.fillBlockDetails(blk, blockDetails, true)) {
+        throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "Internal error: can't fill block details." };
+      }
+      cacheBlockDetails(block_hash, blockDetails);
     }
-    rsp.block = blockDetails;
+    rsp.block = std::move(blockDetails);
   }
   catch (std::system_error& e) {
     throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, e.what() };
@@ -866,19 +1255,25 @@ bool RpcServer::on_get_transaction_details_by_hash(const COMMAND_RPC_GET_TRANSAC
         CORE_RPC_ERROR_CODE_WRONG_PARAM,
         "Failed to parse hex representation of transaction hash. Hex = " + req.hash + '.' };
     }
-    hashes.push_back(tx_hash);
-    m_core.getTransactions(hashes, txs, missed_txs, true);
+    TransactionDetails transactionsDetails;
+    if (!m_transactionDetailsCache.get(tx_hash, transactionsDetails)) {
+      hashes.push_back(tx_hash);
+      m_core.getTransactions(hashes, txs, missed_txs, true);
 
-    if (txs.empty() || !missed_txs.empty()) {
-      std::string hash_str = Common::podToHex(missed_txs.back());
-      throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_WRONG_PARAM,
-        "transaction wasn't found. Hash = " + hash_str + '.' };
-    }
+      if (txs.empty() || !missed_txs.empty()) {
+        std::string hash_str = Common::podToHex(missed_txs.back());
+        throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_WRONG_PARAM,
+          "transaction wasn't found. Hash = " + hash_str + '.' };
+      }
 
-    TransactionDetails transactionsDetails;
-    if (!blockchainExplorerDataBuilder.fillTransactionDetails(txs.back(), transactionsDetails)) {
-      throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
-        "Internal error: can't fill transaction details." };
+      if (!blockchainExplorerDataBuilder.fillTransactionDetails(txs.back(), transactionsDetails)) {
+        throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
+          "Internal error: can't fill transaction details." };
+      }
+
+      if (transactionsDetails.inBlockchain && isCacheableHeight(transactionsDetails.blockHeight)) {
+        m_transactionDetailsCache.put(tx_hash, transactionsDetails.blockHeight, transactionsDetails);
+      }
     }
 
     rsp.transaction = std::move(transactionsDetails);
@@ -1176,6 +1571,18 @@ bool RpcServer::on_get_payment_id(const COMMAND_HTTP::request& req, COMMAND_HTTP
 //
 
 bool RpcServer::on_get_info(const COMMAND_RPC_GET_INFO::request& req, COMMAND_RPC_GET_INFO::response& res) {
+  // the server is up before the core has loaded, only the network side is known then
+  if (!m_core.isInitialized()) {
+    res = COMMAND_RPC_GET_INFO::response();
+    res.rpc_connections_count = get_connections_count();
+    res.white_peerlist_size = m_p2p.getPeerlistManager().get_white_peers_count();
+    res.grey_peerlist_size = m_p2p.getPeerlistManager().get_gray_peers_count();
+    res.version = PROJECT_VERSION_LONG;
+    res.contact = m_contact_info;
+    res.status = CORE_RPC_STATUS_BUSY;
+    return true;
+  }
+
   res.height = m_core.getCurrentBlockchainHeight();
   res.difficulty = m_core.getNextBlockDifficulty();
   res.transactions_count = m_core.getBlockchainTotalTransactions() - res.height; //without coinbase
@@ -1205,6 +1612,11 @@ bool RpcServer::on_get_info(const COMMAND_RPC_GET_INFO::request& req, COMMAND_RP
       CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "Internal error: can't get last cumulative difficulty." };
   }
   res.max_cumulative_block_size = (uint64_t)m_core.currency().maxBlockCumulativeSize(res.height);
+  m_core.getLongHashCacheStatistics(res.longhash_cache_hits, res.longhash_cache_misses);
+  m_core.getTransactionAdmissionQueueSizes(res.tx_verification_queue_size, res.tx_commit_queue_size);
+  m_core.getPoolSizeStatistics(res.transactions_pool_bytes, res.transactions_pool_max_bytes, res.transactions_pool_evicted);
+  res.rpc_cache_hits = m_blockHeaderCache.hits() + m_blockDetailsCache.hits() + m_transactionDetailsCache.hits();
+  res.rpc_cache_misses = m_blockHeaderCache.misses() + m_blockDetailsCache.misses() + m_transactionDetailsCache.misses();
 
   res.status = CORE_RPC_STATUS_OK;
   return true;
@@ -1292,6 +1704,12 @@ bool RpcServer::on_get_stats_by_heights_range(const COMMAND_RPC_GET_STATS_BY_HEI
 }
 
 bool RpcServer::on_get_height(const COMMAND_RPC_GET_HEIGHT::request& req, COMMAND_RPC_GET_HEIGHT::response& res) {
+  if (!m_core.isInitialized()) {
+    res.height = 0;
+    res.status = CORE_RPC_STATUS_BUSY;
+    return true;
+  }
+
   res.height = m_core.getCurrentBlockchainHeight();
   res.status = CORE_RPC_STATUS_OK;
   return true;
@@ -1446,26 +1864,34 @@ bool RpcServer::on_get_peer_list(const COMMAND_RPC_GET_PEER_LIST::request& req,
     return false;
   }
 
-  std::list<AnchorPeerlistEntry> pl_anchor;
-  std::vector<PeerlistEntry> pl_wite;
-  std::vector<PeerlistEntry> pl_gray;
-  m_p2p.getPeerlistManager().get_peerlist_full(pl_anchor, pl_gray, pl_wite);
-  for (const auto& pe : pl_anchor) {
-    std::stringstream ss;
-    ss << pe.adr;
-    res.anchor_peers.push_back(ss.str());
-  }
-  for (const auto& pe : pl_wite) {
-    std::stringstream ss;
-    ss << pe.adr;
-    res.white_peers.push_back(ss.str());
-  }
-  for (const auto& pe : pl_gray) {
-    std::stringstream ss;
-    ss << pe.adr;
-    res.gray_peers.push_back(ss.str());
+  const PeerlistManager& peerlist = m_p2p.getPeerlistManager();
+  if (m_peerListCounter != peerlist.getModificationCounter()) {
+    std::list<AnchorPeerlistEntry> pl_anchor;
+    std::vector<PeerlistEntry> pl_wite;
+    std::vector<PeerlistEntry> pl_gray;
+    peerlist.get_peerlist_full(pl_anchor, pl_gray, pl_wite);
+
+    m_peerList = COMMAND_RPC_GET_PEER_LIST::response();
+    for (const auto& pe : pl_anchor) {
+      std::stringstream ss;
+      ss << pe.adr;
+      m_peerList.anchor_peers.push_back(ss.str());
+    }
+    for (const auto& pe : pl_wite) {
+      std::stringstream ss;
+      ss << pe.adr;
+      m_peerList.white_peers.push_back(ss.str());
+    }
+    for (const auto& pe : pl_gray) {
+      std::stringstream ss;
+      ss << pe.adr;
+      m_peerList.gray_peers.push_back(ss.str());
+    }
+    m_peerList.status = CORE_RPC_STATUS_OK;
+    m_peerListCounter = peerlist.getModificationCounter();
   }
-  res.status = CORE_RPC_STATUS_OK;
+
+  res = m_peerList;
   return true;
 }
 
@@ -1492,6 +1918,8 @@ bool RpcServer::on_get_connections(const COMMAND_RPC_GET_CONNECTIONS::request& r
     c.started = static_cast<uint64_t>(p.m_started);
     c.remote_blockchain_height = p.m_remote_blockchain_height;
     c.last_response_height = p.m_last_response_height;
+    c.recv_bytes = p.m_recv_cnt;
+    c.sent_bytes = p.m_send_cnt;
 
     res.connections.push_back(c);
   }
@@ -1521,6 +1949,29 @@ bool RpcServer::on_blocks_list_json(const COMMAND_RPC_GET_BLOCKS_LIST::request&
 
   for (uint32_t i = req.height; i >= last_height; i--) {
     Crypto::Hash block_hash = m_core.getBlockIdByHeight(i);
+
+    // with the block summary index the listing doesn't need to load the blocks
+    BlockSummary summary;
+    uint64_t entryCumulativeSize, entryGeneratedCoins, entryReward, entryTransactionsCount, entryTimestamp;
+    difficulty_type entryDifficulty;
+    if (m_core.getBlockSummary(i, summary) &&
+        m_core.getblockEntry(i, entryCumulativeSize, entryDifficulty, entryGeneratedCoins, entryReward, entryTransactionsCount, entryTimestamp)) {
+      block_short_response block_short;
+      block_short.timestamp = entryTimestamp;
+      block_short.height = i;
+      block_short.hash = Common::podToHex(block_hash);
+      block_short.cumulative_size = summary.blockSize;
+      block_short.transactions_count = entryTransactionsCount + 1;
+      block_short.difficulty = entryDifficulty;
+      block_short.min_fee = m_core.getMinimalFeeForHeight(i);
+
+      res.blocks.push_back(block_short);
+
+      if (i == 0)
+        break;
+      continue;
+    }
+
     Block blk;
     if (!m_core.getBlockByHash(block_hash, blk)) {
       throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
@@ -1585,23 +2036,93 @@ bool RpcServer::on_alt_blocks_list_json(const COMMAND_RPC_GET_ALT_BLOCKS_LIST::r
 }
 
 bool RpcServer::on_get_transactions_pool_short(const COMMAND_RPC_GET_TRANSACTIONS_POOL_SHORT::request& req, COMMAND_RPC_GET_TRANSACTIONS_POOL_SHORT::response& res) {
+  res = getPoolListing(m_poolListingShort, &RpcServer::fillTransactionsPoolShort).response;
+  return true;
+}
+
+bool RpcServer::on_get_transactions_pool(const COMMAND_RPC_GET_TRANSACTIONS_POOL::request& req, COMMAND_RPC_GET_TRANSACTIONS_POOL::response& res) {
+  res = getPoolListing(m_poolListing, &RpcServer::fillTransactionsPool).response;
+  return true;
+}
+
+bool RpcServer::on_get_transactions_pool_raw(const COMMAND_RPC_GET_RAW_TRANSACTIONS_POOL::request& req, COMMAND_RPC_GET_RAW_TRANSACTIONS_POOL::response& res) {
+  res = getPoolListing(m_poolListingRaw, &RpcServer::fillTransactionsPoolRaw).response;
+  return true;
+}
+
+bool RpcServer::on_get_pool_listing_short(const HttpRequest& request, HttpResponse& response) {
+  return sendPoolListing(getPoolListing(m_poolListingShort, &RpcServer::fillTransactionsPoolShort), request, response);
+}
+
+bool RpcServer::on_get_pool_listing(const HttpRequest& request, HttpResponse& response) {
+  return sendPoolListing(getPoolListing(m_poolListing, &RpcServer::fillTransactionsPool), request, response);
+}
+
+bool RpcServer::on_get_pool_listing_raw(const HttpRequest& request, HttpResponse& response) {
+  return sendPoolListing(getPoolListing(m_poolListingRaw, &RpcServer::fillTransactionsPoolRaw), request, response);
+}
+
+template <typename Response>
+const RpcServer::PoolListing<Response>& RpcServer::getPoolListing(PoolListing<Response>& listing, void (RpcServer::*fill)(Response&)) {
+  // read before the pool is, a change in between only makes the next request rebuild again
+  uint64_t poolModificationCounter = m_core.getPoolModificationCounter();
+  Crypto::Hash tailId = m_core.get_tail_id();
+  if (listing.poolModificationCounter == poolModificationCounter && listing.tailId == tailId) {
+    return listing;
+  }
+
+  Response res;
+  (this->*fill)(res);
+  res.status = CORE_RPC_STATUS_OK;
+
+  listing.body = storeToJson(res);
+  listing.etag = "W/\"" + Common::podToHex(Crypto::cn_fast_hash(listing.body.data(), listing.body.size())) + "\"";
+  listing.response = std::move(res);
+  listing.poolModificationCounter = poolModificationCounter;
+  listing.tailId = tailId;
+  return listing;
+}
+
+template <typename Response>
+bool RpcServer::sendPoolListing(const PoolListing<Response>& listing, const HttpRequest& request, HttpResponse& response) {
+  std::string cors_domain = getCorsDomain();
+  if (!cors_domain.empty()) {
+    response.addHeader("Access-Control-Allow-Origin", cors_domain);
+    response.addHeader("Access-Control-Allow-Headers", "Origin, X-Requested-With, Content-Type, Accept");
+    response.addHeader("Access-Control-Allow-Methods", "POST, GET");
+  }
+
+  response.addHeader("ETag", listing.etag);
+  response.addHeader("Cache-Control", "no-cache");
+
+  auto ifNoneMatch = request.getHeaders().find("if-none-match");
+  if (ifNoneMatch != request.getHeaders().end() && ifNoneMatch->second.find(listing.etag) != std::string::npos) {
+    response.setStatus(HttpResponse::STATUS_304);
+    return true;
+  }
+
+  response.addHeader("Content-Type", "application/json");
+  response.setBody(listing.body);
+  return true;
+}
+
+void RpcServer::fillTransactionsPoolShort(COMMAND_RPC_GET_TRANSACTIONS_POOL_SHORT::response& res) {
   auto pool = m_core.getMemoryPool();
-  for (const CryptoNote::tx_memory_pool::TransactionDetails txd : pool) {
+  res.transactions.reserve(pool.size());
+  for (const auto& txd : pool) {
     transaction_pool_response mempool_transaction;
     mempool_transaction.hash = Common::podToHex(txd.id);
     mempool_transaction.fee = txd.fee;
-    mempool_transaction.amount_out = getOutputAmount(txd.tx);;
+    mempool_transaction.amount_out = getOutputAmount(txd.tx);
     mempool_transaction.size = txd.blobSize;
     mempool_transaction.receive_time = txd.receiveTime;
     res.transactions.push_back(mempool_transaction);
   }
-  res.status = CORE_RPC_STATUS_OK;
-  return true;
 }
 
-bool RpcServer::on_get_transactions_pool(const COMMAND_RPC_GET_TRANSACTIONS_POOL::request& req, COMMAND_RPC_GET_TRANSACTIONS_POOL::response& res) {
+void RpcServer::fillTransactionsPool(COMMAND_RPC_GET_TRANSACTIONS_POOL::response& res) {
   auto pool = m_core.getMemoryPool();
-
+  res.transactions.reserve(pool.size());
   for (const auto& txd : pool) {
     TransactionDetails transactionDetails;
     if (!blockchainExplorerDataBuilder.fillTransactionDetails(txd.tx, transactionDetails, txd.receiveTime)) {
@@ -1609,13 +2130,11 @@ bool RpcServer::on_get_transactions_pool(const COMMAND_RPC_GET_TRANSACTIONS_POOL
     }
     res.transactions.push_back(std::move(transactionDetails));
   }
-  res.status = CORE_RPC_STATUS_OK;
-  return true;
 }
 
-bool RpcServer::on_get_transactions_pool_raw(const COMMAND_RPC_GET_RAW_TRANSACTIONS_POOL::request& req, COMMAND_RPC_GET_RAW_TRANSACTIONS_POOL::response& res) {
+void RpcServer::fillTransactionsPoolRaw(COMMAND_RPC_GET_RAW_TRANSACTIONS_POOL::response& res) {
   auto pool = m_core.getMemoryPool();
-
+  res.transactions.reserve(pool.size());
   for (const auto& txd : pool) {
     res.transactions.push_back(tx_with_output_global_indexes());
     tx_with_output_global_indexes &e = res.transactions.back();
@@ -1627,8 +2146,6 @@ bool RpcServer::on_get_transactions_pool_raw(const COMMAND_RPC_GET_RAW_TRANSACTI
     e.transaction = *static_cast<const TransactionPrefix*>(&txd.tx);
     e.fee = txd.fee;
   }
-  res.status = CORE_RPC_STATUS_OK;
-  return true;
 }
 
 bool RpcServer::on_get_transactions_by_payment_id(const COMMAND_RPC_GET_TRANSACTIONS_BY_PAYMENT_ID::request& req, COMMAND_RPC_GET_TRANSACTIONS_BY_PAYMENT_ID::response& res) {
@@ -1720,6 +2237,17 @@ bool RpcServer::on_getblocktemplate(const COMMAND_RPC_GETBLOCKTEMPLATE::request&
     throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_WRONG_WALLET_ADDRESS, "Failed to parse wallet address" };
   }
 
+  if (!req.long_poll_id.empty()) {
+    waitBlockTemplateChange(req.long_poll_id);
+  }
+
+  if (getCachedBlockTemplate(req, res)) {
+    return true;
+  }
+
+  // taken before building, so a pool change during the build only makes the entry stale sooner
+  uint64_t poolModificationCounter = m_core.getPoolModificationCounter();
+
   Block b = boost::value_initialized<Block>();
   CryptoNote::BinaryArray blob_reserve;
   blob_reserve.resize(req.reserve_size, 0);
@@ -1758,11 +2286,148 @@ bool RpcServer::on_getblocktemplate(const COMMAND_RPC_GETBLOCKTEMPLATE::request&
 
   res.blocktemplate_blob = Common::toHex(block_blob);
   res.blockhashing_blob = Common::toHex(hashing_blob);
+  res.long_poll_id = getBlockTemplateLongPollId(b.previousBlockHash, poolModificationCounter);
   res.status = CORE_RPC_STATUS_OK;
 
+  cacheBlockTemplate(req, b.previousBlockHash, poolModificationCounter, res);
+
   return true;
 }
 
+std::string RpcServer::getBlockTemplateLongPollId(const Crypto::Hash& tailId, uint64_t poolModificationCounter) const {
+  return Common::podToHex(tailId) + std::to_string(poolModificationCounter);
+}
+
+void RpcServer::waitBlockTemplateChange(const std::string& longPollId) {
+  waitCoreChange([this, &longPollId] {
+    return getBlockTemplateLongPollId(m_core.get_tail_id(), m_core.getPoolModificationCounter()) != longPollId;
+  }, BLOCK_TEMPLATE_LONG_POLL_TIMEOUT);
+}
+
+void RpcServer::waitCoreChange(const std::function<bool()>& changed, std::chrono::seconds timeout) {
+  // dispatcher primitives can't be used from the SSL server thread, such requests are answered right away
+  if (std::this_thread::get_id() != m_dispatcherThreadId) {
+    return;
+  }
+
+  bool timedOut = false;
+  System::ContextGroup timeoutContext(m_dispatcher);
+  timeoutContext.spawn([this, &timedOut, timeout] {
+    try {
+      System::Timer(m_dispatcher).sleep(timeout);
+      timedOut = true;
+      notifyCoreChanged();
+    } catch (System::InterruptedException&) {
+    }
+  });
+
+  while (!timedOut && !changed()) {
+    m_coreChanged.wait();
+  }
+
+  timeoutContext.interrupt();
+  timeoutContext.wait();
+}
+
+void RpcServer::notifyCoreChanged() {
+  m_coreChanged.set();
+  m_coreChanged.clear();
+}
+
+void RpcServer::blockchainUpdated() {
+  m_dispatcher.remoteSpawn([this] { notifyCoreChanged(); });
+}
+
+void RpcServer::poolUpdated() {
+  m_dispatcher.remoteSpawn([this] { notifyCoreChanged(); });
+}
+
+void RpcServer::blockchainRolledBack(uint32_t height) {
+  m_blockHeaderCache.removeFrom(height + 1);
+  m_blockDetailsCache.removeFrom(height + 1);
+  m_transactionDetailsCache.removeFrom(height + 1);
+}
+
+bool RpcServer::isCacheableHeight(uint32_t height) {
+  return height + parameters::CRYPTONOTE_MINED_MONEY_UNLOCK_WINDOW < m_core.getCurrentBlockchainHeight();
+}
+
+bool RpcServer::getCachedBlockHeader(const Crypto::Hash& hash, block_header_response& header) {
+  if (!m_blockHeaderCache.get(hash, header)) {
+    return false;
+  }
+
+  header.depth = m_core.getCurrentBlockchainHeight() - header.height - 1;
+  return true;
+}
+
+void RpcServer::cacheBlockHeader(const Crypto::Hash& hash, const block_header_response& header) {
+  if (!header.orphan_status && isCacheableHeight(header.height)) {
+    m_blockHeaderCache.put(hash, header.height, header);
+  }
+}
+
+bool RpcServer::getCachedBlockDetails(const Crypto::Hash& hash, BlockDetails& details) {
+  if (!m_blockDetailsCache.get(hash, details)) {
+    return false;
+  }
+
+  details.depth = m_core.getCurrentBlockchainHeight() - details.height - 1;
+  return true;
+}
+
+void RpcServer::cacheBlockDetails(const Crypto::Hash& hash, const BlockDetails& details) {
+  if (!details.isOrphaned && isCacheableHeight(details.height)) {
+    m_blockDetailsCache.put(hash, details.height, details);
+  }
+}
+
+bool RpcServer::getCachedBlockTemplate(const COMMAND_RPC_GETBLOCKTEMPLATE::request& req, COMMAND_RPC_GETBLOCKTEMPLATE::response& res) {
+  Crypto::Hash tailId = m_core.get_tail_id();
+  uint64_t poolModificationCounter = m_core.getPoolModificationCounter();
+
+  std::lock_guard<std::mutex> lock(m_blockTemplateCacheLock);
+  auto it = m_blockTemplateCache.find(std::make_pair(req.wallet_address, req.reserve_size));
+  if (it == m_blockTemplateCache.end()) {
+    return false;
+  }
+
+  const BlockTemplateCacheEntry& entry = it->second;
+  if (entry.tailId != tailId || entry.poolModificationCounter != poolModificationCounter ||
+      time(nullptr) - entry.createdAt > BLOCK_TEMPLATE_CACHE_LIFETIME) {
+    m_blockTemplateCache.erase(it);
+    return false;
+  }
+
+  // the reserved bytes are zeroed in the shared blob, every miner writes its own extra nonce there
+  res = entry.response;
+  return true;
+}
+
+void RpcServer::cacheBlockTemplate(const COMMAND_RPC_GETBLOCKTEMPLATE::request& req, const Crypto::Hash& tailId, uint64_t poolModificationCounter,
+  const COMMAND_RPC_GETBLOCKTEMPLATE::response& res) {
+  std::lock_guard<std::mutex> lock(m_blockTemplateCacheLock);
+
+  // entries built on top of another tail are useless, drop them together with any overflow
+  for (auto it = m_blockTemplateCache.begin(); it != m_blockTemplateCache.end();) {
+    if (it->second.tailId != tailId) {
+      it = m_blockTemplateCache.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  if (m_blockTemplateCache.size() >= BLOCK_TEMPLATE_CACHE_MAX_ENTRIES) {
+    m_blockTemplateCache.clear();
+  }
+
+  BlockTemplateCacheEntry& entry = m_blockTemplateCache[std::make_pair(req.wallet_address, req.reserve_size)];
+  entry.tailId = tailId;
+  entry.poolModificationCounter = poolModificationCounter;
+  entry.createdAt = time(nullptr);
+  entry.response = res;
+}
+
 bool RpcServer::on_get_currency_id(const COMMAND_RPC_GET_CURRENCY_ID::request& /*req*/, COMMAND_RPC_GET_CURRENCY_ID::response& res) {
   Crypto::Hash currencyId = m_core.currency().genesisBlockHash();
   res.currency_id_blob = Common::podToHex(currencyId);
@@ -1814,6 +2479,9 @@ void RpcServer::fill_block_header_response(const Block& blk, bool orphan_status,
   responce.hash = Common::podToHex(hash);
   m_core.getBlockDifficulty(static_cast<uint32_t>(height), responce.difficulty);
   responce.reward = get_block_reward(blk);
+  Crypto::Hash proofOfWork = NULL_HASH;
+  m_core.getBlockLongHash(blk, proofOfWork);
+  responce.pow_hash = Common::podToHex(proofOfWork);
 }
 
 bool RpcServer::on_get_last_block_header(const COMMAND_RPC_GET_LAST_BLOCK_HEADER::request& req, COMMAND_RPC_GET_LAST_BLOCK_HEADER::response& res) {
@@ -1842,6 +2510,11 @@ bool RpcServer::on_get_block_header_by_hash(const COMMAND_RPC_GET_BLOCK_HEADER_B
       "Failed to parse hex representation of block hash. Hex = " + req.hash + '.' };
   }
 
+  if (getCachedBlockHeader(block_hash, res.block_header)) {
+    res.status = CORE_RPC_STATUS_OK;
+    return true;
+  }
+
   Block blk;
   if (!m_core.getBlockByHash(block_hash, blk)) {
     throw JsonRpc::JsonRpcError{
@@ -1859,6 +2532,7 @@ bool RpcServer::on_get_block_header_by_hash(const COMMAND_RPC_GET_BLOCK_HEADER_B
   Crypto::Hash tmp_hash = m_core.getBlockIdByHeight(block_height);
   bool is_orphaned = block_hash != tmp_hash;
   fill_block_header_response(blk, is_orphaned, block_height, block_hash, res.block_header);
+  cacheBlockHeader(block_hash, res.block_header);
   res.status = CORE_RPC_STATUS_OK;
   return true;
 }
@@ -1870,6 +2544,11 @@ bool RpcServer::on_get_block_header_by_height(const COMMAND_RPC_GET_BLOCK_HEADER
   }
 
   Crypto::Hash block_hash = m_core.getBlockIdByHeight(static_cast<uint32_t>(req.height));
+  if (getCachedBlockHeader(block_hash, res.block_header)) {
+    res.status = CORE_RPC_STATUS_OK;
+    return true;
+  }
+
   Block blk;
   if (!m_core.getBlockByHash(block_hash, blk)) {
     throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
@@ -1879,6 +2558,7 @@ bool RpcServer::on_get_block_header_by_height(const COMMAND_RPC_GET_BLOCK_HEADER
   Crypto::Hash tmp_hash = m_core.getBlockIdByHeight(req.height);
   bool is_orphaned = block_hash != tmp_hash;
   fill_block_header_response(blk, is_orphaned, req.height, block_hash, res.block_header);
+  cacheBlockHeader(block_hash, res.block_header);
   res.status = CORE_RPC_STATUS_OK;
   return true;
 }
@@ -1896,6 +2576,17 @@ bool RpcServer::on_get_block_timestamp_by_height(const COMMAND_RPC_GET_BLOCK_TIM
   return true;
 }
 
+bool RpcServer::on_get_heights_by_timestamps(const COMMAND_RPC_GET_HEIGHTS_BY_TIMESTAMPS::request& req, COMMAND_RPC_GET_HEIGHTS_BY_TIMESTAMPS::response& res) {
+  if (req.timestamps.size() > TIMESTAMPS_HEIGHTS_MAX_COUNT) {
+    throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_WRONG_PARAM,
+      std::string("Requested timestamps count: ") + std::to_string(req.timestamps.size()) + " exceeded max limit of " + std::to_string(TIMESTAMPS_HEIGHTS_MAX_COUNT) };
+  }
+
+  m_core.getBlockHeightsByTimestamps(req.timestamps, res.heights);
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
 bool RpcServer::on_check_transaction_key(const COMMAND_RPC_CHECK_TRANSACTION_KEY::request& req, COMMAND_RPC_CHECK_TRANSACTION_KEY::response& res) {
   // parse txid
   Crypto::Hash txid;
@@ -2214,72 +2905,88 @@ bool RpcServer::on_check_reserve_proof(const COMMAND_RPC_CHECK_RESERVE_PROOF::re
   std::vector<Transaction> transactions;
   std::copy(txs.begin(), txs.end(), std::inserter(transactions, transactions.end()));
 
-  // check spent status
-  res.total = 0;
-  res.spent = 0;
-  res.locked = 0;
   for (size_t i = 0; i < proofs.size(); ++i) {
-    const reserve_proof_entry& proof = proofs[i];
-
-    CryptoNote::TransactionPrefix tx = *static_cast<const TransactionPrefix*>(&transactions[i]);
-    
-    bool unlocked = m_core.is_tx_spendtime_unlocked(tx.unlockTime, req.height);
-
-    if (proof.index_in_transaction >= tx.outputs.size()) {
+    if (proofs[i].index_in_transaction >= transactions[i].outputs.size()) {
       throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "index_in_tx is out of bound" };
     }
 
-    const KeyOutput out_key = boost::get<KeyOutput>(tx.outputs[proof.index_in_transaction].target);
+    if (transactions[i].outputs[proofs[i].index_in_transaction].target.type() != typeid(KeyOutput)) {
+      throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "Output of reserve proof is not a key output" };
+    }
+  }
+
+  // the signatures and derivations of the entries are checked on the thread pool, they
+  // don't depend on each other and make almost all of the work for a large proof
+  enum class EntryStatus { badSharedSecret, badKeyImage, badDerivation, notOwned, owned };
+  std::vector<EntryStatus> statuses(proofs.size());
+  std::atomic<size_t> checked(0);
+  System::parallelFor(0, proofs.size(), [&](size_t i) {
+    const reserve_proof_entry& proof = proofs[i];
+    const TransactionPrefix& tx = transactions[i];
+    const KeyOutput& out_key = boost::get<KeyOutput>(tx.outputs[proof.index_in_transaction].target);
 
-    // get tx pub key
     Crypto::PublicKey txPubKey = getTransactionPublicKeyFromExtra(tx.extra);
-
+    const std::vector<const Crypto::PublicKey *>& pubs = { &out_key.key };
+    Crypto::KeyDerivation derivation;
+    Crypto::PublicKey pubkey;
     // check singature for shared secret
     if (!Crypto::check_tx_proof(prefix_hash, address.viewPublicKey, txPubKey, proof.shared_secret, proof.shared_secret_sig)) {
-      //throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "Failed to check singature for shared secret" };
-      res.good = false;
-      return true;
+      statuses[i] = EntryStatus::badSharedSecret;
+    } else if (!Crypto::check_ring_signature(prefix_hash, proof.key_image, &pubs[0], 1, &proof.key_image_sig)) {
+      // check signature for key image
+      statuses[i] = EntryStatus::badKeyImage;
+    } else if (!Crypto::generate_key_derivation(proof.shared_secret, Crypto::EllipticCurveScalar2SecretKey(Crypto::I), derivation)) {
+      statuses[i] = EntryStatus::badDerivation;
+    } else {
+      // check if the address really received the fund
+      bool derived = Crypto::derive_public_key(derivation, proof.index_in_transaction, address.spendPublicKey, pubkey);
+      statuses[i] = derived && pubkey == out_key.key ? EntryStatus::owned : EntryStatus::notOwned;
     }
 
-    // check signature for key image
-    const std::vector<const Crypto::PublicKey *>& pubs = { &out_key.key };
-    if (!Crypto::check_ring_signature(prefix_hash, proof.key_image, &pubs[0], 1, &proof.key_image_sig)) {
-      //throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "Failed to check signature for key image" };
+    size_t count = ++checked;
+    if (count % RESERVE_PROOF_PROGRESS_INTERVAL == 0) {
+      logger(Logging::INFO) << "Checked " << count << " of " << proofs.size() << " reserve proof entries";
+    }
+  }, System::ThreadPool::shared(), 16);
+
+  // check spent status
+  res.total = 0;
+  res.spent = 0;
+  res.locked = 0;
+  for (size_t i = 0; i < proofs.size(); ++i) {
+    const reserve_proof_entry& proof = proofs[i];
+    const TransactionPrefix& tx = transactions[i];
+
+    switch (statuses[i]) {
+    case EntryStatus::badSharedSecret:
+    case EntryStatus::badKeyImage:
       res.good = false;
       return true;
+    case EntryStatus::badDerivation:
+      throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "Failed to generate key derivation" };
+    case EntryStatus::notOwned:
+      continue;
+    case EntryStatus::owned:
+      break;
     }
 
-    // check if the address really received the fund
-    Crypto::KeyDerivation derivation;
-    if (!Crypto::generate_key_derivation(proof.shared_secret, Crypto::EllipticCurveScalar2SecretKey(Crypto::I), derivation)) {
-      throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "Failed to generate key derivation" };
+    bool unlocked = m_core.is_tx_spendtime_unlocked(tx.unlockTime, req.height);
+    uint64_t amount = tx.outputs[proof.index_in_transaction].amount;
+    res.total += amount;
+
+    if (!unlocked) {
+      res.locked += amount;
     }
-    try {
-      Crypto::PublicKey pubkey;
-      derive_public_key(derivation, proof.index_in_transaction, address.spendPublicKey, pubkey);
-      if (pubkey == out_key.key) {
-        uint64_t amount = tx.outputs[proof.index_in_transaction].amount;
-        res.total += amount;
-
-        if (!unlocked) {
-          res.locked += amount;
-        }
 
-        if (req.height != 0) {
-          if (m_core.is_key_image_spent(proof.key_image, req.height)) {
-            res.spent += amount;
-          }
-        } else {
-          if (m_core.is_key_image_spent(proof.key_image)) {
-            res.spent += amount;
-          }
-        }
+    if (req.height != 0) {
+      if (m_core.is_key_image_spent(proof.key_image, req.height)) {
+        res.spent += amount;
+      }
+    } else {
+      if (m_core.is_key_image_spent(proof.key_image)) {
+        res.spent += amount;
       }
     }
-    catch (...)
-    {
-      throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "Unknown error" };
-    }  
   }
 
   // check signature for address spend keys
@@ -2340,7 +3047,10 @@ bool RpcServer::on_verify_message(const COMMAND_RPC_VERIFY_MESSAGE::request& req
 
 bool RpcServer::on_resolve_open_alias(const COMMAND_RPC_RESOLVE_OPEN_ALIAS::request& req, COMMAND_RPC_RESOLVE_OPEN_ALIAS::response& res) {
   try {
-    res.address = Common::resolveAlias(req.url);
+    // the lookup may wait on the network, it runs in the thread pool
+    res.address = System::RemoteContext<std::string>(m_dispatcher, System::ThreadPool::shared(), [&req] {
+      return Common::resolveAlias(req.url);
+    }).get();
 
     AccountPublicAddress ignore;
     if (!m_core.currency().parseAccountAddressString(res.address, ignore)) {
@@ -20,9 +20,18 @@
 #pragma once
 
 #include "HttpServer.h"
+#include "RpcMetrics.h"
+#include "RpcResponseCache.h"
 
+#include <chrono>
+#include <ctime>
 #include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <Logging/LoggerRef.h>
 #include "ITransaction.h"
@@ -38,9 +47,15 @@ class NodeServer;
 class BlockchainExplorer;
 class ICryptoNoteProtocolQuery;
 
-class RpcServer : public HttpServer {
+namespace JsonRpc {
+class JsonRpcRequest;
+class JsonRpcResponse;
+}
+
+class RpcServer : public HttpServer, private ICoreObserver {
 public:
   RpcServer(System::Dispatcher& dispatcher, Logging::ILogger& log, Core& core, NodeServer& p2p, ICryptoNoteProtocolQuery& protocolQuery);
+  ~RpcServer();
 
   typedef std::function<bool(RpcServer*, const HttpRequest& request, HttpResponse& response)> HandlerFunction;
   bool restrictRpc(const bool is_resctricted);
@@ -51,6 +66,7 @@ public:
   bool setContactInfo(const std::string& contact);
   bool checkIncomingTransactionForFee(const BinaryArray& tx_blob);
   std::string getCorsDomain();
+  const RpcMetrics& getMetrics() const { return m_metrics; }
 
 private:
 
@@ -62,19 +78,36 @@ private:
 
   typedef void (RpcServer::*HandlerPtr)(const HttpRequest& request, HttpResponse& response);
   static std::unordered_map<std::string, RpcHandler<HandlerFunction>> s_handlers;
+  static const std::unordered_map<std::string, Priority> s_concurrentHandlers;
+  static const std::unordered_map<std::string, Priority> s_concurrentJsonRpcMethods;
+  static const std::unordered_set<std::string> s_blockchainLockedJsonRpcMethods;
 
   virtual void processRequest(const HttpRequest& request, HttpResponse& response) override;
   bool processJsonRpcRequest(const HttpRequest& request, HttpResponse& response);
+  // compresses bodies worth it in the best content coding the client accepts
+  void compressResponse(const HttpRequest& request, HttpResponse& response, RpcMetrics::Call& call);
+  bool parseJsonRpcCall(const std::string& call, JsonRpc::JsonRpcRequest& jsonRequest, JsonRpc::JsonRpcResponse& jsonResponse);
+  void executeJsonRpcCall(JsonRpc::JsonRpcRequest& jsonRequest, JsonRpc::JsonRpcResponse& jsonResponse, bool allowConcurrent);
   bool isCoreReady();
 
   // binary handlers
   bool on_get_blocks(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, COMMAND_RPC_GET_BLOCKS_FAST::response& res);
   bool on_query_blocks(const COMMAND_RPC_QUERY_BLOCKS::request& req, COMMAND_RPC_QUERY_BLOCKS::response& res);
   bool on_query_blocks_lite(const COMMAND_RPC_QUERY_BLOCKS_LITE::request& req, COMMAND_RPC_QUERY_BLOCKS_LITE::response& res);
+  bool on_get_block_filters(const COMMAND_RPC_GET_BLOCK_FILTERS::request& req, COMMAND_RPC_GET_BLOCK_FILTERS::response& res);
+  bool on_get_block_filter_headers(const COMMAND_RPC_GET_BLOCK_FILTER_HEADERS::request& req, COMMAND_RPC_GET_BLOCK_FILTER_HEADERS::response& res);
+  bool on_query_blocks_filtered(const COMMAND_RPC_QUERY_BLOCKS_FILTERED::request& req, COMMAND_RPC_QUERY_BLOCKS_FILTERED::response& res);
   bool on_get_indexes(const COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES::request& req, COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES::response& res);
+  bool on_get_txs_indexes(const COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES::request& req, COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES::response& res);
   bool on_get_random_outs(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response& res);
   bool on_get_pool_changes(const COMMAND_RPC_GET_POOL_CHANGES::request& req, COMMAND_RPC_GET_POOL_CHANGES::response& rsp);
   bool on_get_pool_changes_lite(const COMMAND_RPC_GET_POOL_CHANGES_LITE::request& req, COMMAND_RPC_GET_POOL_CHANGES_LITE::response& rsp);
+  bool on_wait_for_changes(const COMMAND_RPC_WAIT_FOR_CHANGES::request& req, COMMAND_RPC_WAIT_FOR_CHANGES::response& rsp);
+  bool on_stream_blocks(const HttpRequest& request, HttpResponse& response);
+  bool on_get_metrics(const HttpRequest& request, HttpResponse& response);
+  bool on_get_pool_listing_short(const HttpRequest& request, HttpResponse& response);
+  bool on_get_pool_listing(const HttpRequest& request, HttpResponse& response);
+  bool on_get_pool_listing_raw(const HttpRequest& request, HttpResponse& response);
 
   // http handlers
   bool on_get_index(const COMMAND_HTTP::request& req, COMMAND_HTTP::response& res);
@@ -117,6 +150,7 @@ private:
   bool on_get_block_header_by_hash(const COMMAND_RPC_GET_BLOCK_HEADER_BY_HASH::request& req, COMMAND_RPC_GET_BLOCK_HEADER_BY_HASH::response& res);
   bool on_get_block_header_by_height(const COMMAND_RPC_GET_BLOCK_HEADER_BY_HEIGHT::request& req, COMMAND_RPC_GET_BLOCK_HEADER_BY_HEIGHT::response& res);
   bool on_get_block_timestamp_by_height(const COMMAND_RPC_GET_BLOCK_TIMESTAMP_BY_HEIGHT::request& req, COMMAND_RPC_GET_BLOCK_TIMESTAMP_BY_HEIGHT::response& res);
+  bool on_get_heights_by_timestamps(const COMMAND_RPC_GET_HEIGHTS_BY_TIMESTAMPS::request& req, COMMAND_RPC_GET_HEIGHTS_BY_TIMESTAMPS::response& res);
   bool on_get_transactions_pool_short(const COMMAND_RPC_GET_TRANSACTIONS_POOL_SHORT::request& req, COMMAND_RPC_GET_TRANSACTIONS_POOL_SHORT::response& res);
   bool on_get_transactions_pool_raw(const COMMAND_RPC_GET_RAW_TRANSACTIONS_POOL::request& req, COMMAND_RPC_GET_RAW_TRANSACTIONS_POOL::response& res);
   bool on_get_transactions_pool(const COMMAND_RPC_GET_TRANSACTIONS_POOL::request& req, COMMAND_RPC_GET_TRANSACTIONS_POOL::response& res);
@@ -133,6 +167,55 @@ private:
 
   void fill_block_header_response(const Block& blk, bool orphan_status, uint32_t height, const Crypto::Hash& hash, block_header_response& responce);
 
+  struct BlockTemplateCacheEntry {
+    Crypto::Hash tailId;
+    uint64_t poolModificationCounter;
+    time_t createdAt;
+    COMMAND_RPC_GETBLOCKTEMPLATE::response response;
+  };
+
+  // keyed by wallet address and reserve size
+  typedef std::map<std::pair<std::string, uint64_t>, BlockTemplateCacheEntry> BlockTemplateCache;
+
+  // a pool listing with its JSON body, valid while the pool and the tail stay the same
+  template <typename Response>
+  struct PoolListing {
+    uint64_t poolModificationCounter = std::numeric_limits<uint64_t>::max();
+    Crypto::Hash tailId = NULL_HASH;
+    Response response;
+    std::string body;
+    std::string etag;
+  };
+
+  template <typename Response>
+  const PoolListing<Response>& getPoolListing(PoolListing<Response>& listing, void (RpcServer::*fill)(Response&));
+  template <typename Response>
+  bool sendPoolListing(const PoolListing<Response>& listing, const HttpRequest& request, HttpResponse& response);
+  void fillTransactionsPoolShort(COMMAND_RPC_GET_TRANSACTIONS_POOL_SHORT::response& res);
+  void fillTransactionsPool(COMMAND_RPC_GET_TRANSACTIONS_POOL::response& res);
+  void fillTransactionsPoolRaw(COMMAND_RPC_GET_RAW_TRANSACTIONS_POOL::response& res);
+
+  // ICoreObserver
+  virtual void blockchainUpdated() override;
+  virtual void poolUpdated() override;
+  virtual void blockchainRolledBack(uint32_t height) override;
+
+  bool isCacheableHeight(uint32_t height);
+  bool getCachedBlockHeader(const Crypto::Hash& hash, block_header_response& header);
+  void cacheBlockHeader(const Crypto::Hash& hash, const block_header_response& header);
+  bool getCachedBlockDetails(const Crypto::Hash& hash, BlockDetails& details);
+  void cacheBlockDetails(const Crypto::Hash& hash, const BlockDetails& details);
+
+  std::string getBlockTemplateLongPollId(const Crypto::Hash& tailId, uint64_t poolModificationCounter) const;
+  void waitBlockTemplateChange(const std::string& longPollId);
+  // suspends the request until changed() holds or the timeout expires, rechecked on every core change
+  void waitCoreChange(const std::function<bool()>& changed, std::chrono::seconds timeout);
+  void notifyCoreChanged();
+
+  bool getCachedBlockTemplate(const COMMAND_RPC_GETBLOCKTEMPLATE::request& req, COMMAND_RPC_GETBLOCKTEMPLATE::response& res);
+  void cacheBlockTemplate(const COMMAND_RPC_GETBLOCKTEMPLATE::request& req, const Crypto::Hash& tailId, uint64_t poolModificationCounter,
+    const COMMAND_RPC_GETBLOCKTEMPLATE::response& res);
+
   Logging::LoggerRef logger;
   CryptoNote::Core& m_core;
   CryptoNote::NodeServer& m_p2p;
@@ -145,6 +228,25 @@ private:
   std::string m_contact_info;
   Crypto::SecretKey m_view_key = NULL_SECRET_KEY;
   CryptoNote::AccountPublicAddress m_fee_acc;
+  BlockTemplateCache m_blockTemplateCache;
+  std::mutex m_blockTemplateCacheLock;
+  System::Event m_coreChanged;
+
+  // formatted /getpeers lists, rebuilt when the peer list changes (network thread only)
+  uint64_t m_peerListCounter;
+  COMMAND_RPC_GET_PEER_LIST::response m_peerList;
+
+  // pool listings polled by explorers, rebuilt on the first request after a pool change (network thread only)
+  PoolListing<COMMAND_RPC_GET_TRANSACTIONS_POOL_SHORT::response> m_poolListingShort;
+  PoolListing<COMMAND_RPC_GET_TRANSACTIONS_POOL::response> m_poolListing;
+  PoolListing<COMMAND_RPC_GET_RAW_TRANSACTIONS_POOL::response> m_poolListingRaw;
+
+  // explorer data of blocks deep enough not to change any more
+  RpcResponseCache<block_header_response> m_blockHeaderCache;
+  RpcResponseCache<BlockDetails> m_blockDetailsCache;
+  RpcResponseCache<TransactionDetails> m_transactionDetailsCache;
+
+  RpcMetrics m_metrics;
 };
 
 }
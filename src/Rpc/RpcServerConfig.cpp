@@ -31,6 +31,9 @@ namespace CryptoNote {
     const std::string DEFAULT_RPC_CHAIN_FILE = std::string(RPC_DEFAULT_CHAIN_FILE);
     const std::string DEFAULT_RPC_KEY_FILE = std::string(RPC_DEFAULT_KEY_FILE);
     const std::string DEFAULT_RPC_DH_FILE = std::string(RPC_DEFAULT_DH_FILE);
+    const uint32_t DEFAULT_RPC_MAX_BULK_REQUESTS = 2;
+    const uint32_t DEFAULT_RPC_MAX_QUEUED_REQUESTS = 100;
+    const uint64_t DEFAULT_STRATUM_DIFFICULTY = 5000;
 
     const command_line::arg_descriptor<std::string> arg_rpc_bind_ip     = { "rpc-bind-ip", "", DEFAULT_RPC_IP };
     const command_line::arg_descriptor<uint16_t>    arg_rpc_bind_port   = { "rpc-bind-port", "", DEFAULT_RPC_PORT };
@@ -45,6 +48,12 @@ namespace CryptoNote {
     const command_line::arg_descriptor<std::string> arg_set_fee_address = { "fee-address", "Sets fee address for light wallets.", "" };
     const command_line::arg_descriptor<std::string> arg_set_fee_amount  = { "fee-amount", "Sets flat rate fee for light wallets.", "" };
     const command_line::arg_descriptor<std::string> arg_set_view_key    = { "view-key", "Sets private view key to check for node's fee.", "" };
+    const command_line::arg_descriptor<uint32_t>    arg_rpc_threads     = { "rpc-threads", "Number of threads serving read-only RPC requests in parallel, 0 - serve everything on the network thread", 0 };
+    const command_line::arg_descriptor<uint32_t>    arg_rpc_max_normal  = { "rpc-max-normal-requests", "Number of threads serving block sync and single block or transaction queries at once, 0 - all of them", 0 };
+    const command_line::arg_descriptor<uint32_t>    arg_rpc_max_bulk    = { "rpc-max-bulk-requests", "Number of threads serving block and transaction lists or stats at once, 0 - all of them", DEFAULT_RPC_MAX_BULK_REQUESTS };
+    const command_line::arg_descriptor<uint32_t>    arg_rpc_max_queued  = { "rpc-max-queued-requests", "Number of requests of one priority waiting for a thread, more are answered with 503", DEFAULT_RPC_MAX_QUEUED_REQUESTS };
+    const command_line::arg_descriptor<uint16_t>    arg_stratum_port    = { "stratum-bind-port", "Port of the stratum server for solo miners on the rpc-bind-ip, 0 - disabled", 0 };
+    const command_line::arg_descriptor<uint64_t>    arg_stratum_diff    = { "stratum-difficulty", "Difficulty of the shares the stratum miners submit", DEFAULT_STRATUM_DIFFICULTY };
   }
 
 
@@ -58,6 +67,12 @@ namespace CryptoNote {
     nodeFeeAddress(""),
     nodeFeeAmountStr(""),
     nodeFeeViewKey(""),
+    workerThreads(0),
+    maxNormalRequests(0),
+    maxBulkRequests(DEFAULT_RPC_MAX_BULK_REQUESTS),
+    maxQueuedRequests(DEFAULT_RPC_MAX_QUEUED_REQUESTS),
+    stratumBindPort(0),
+    stratumDifficulty(DEFAULT_STRATUM_DIFFICULTY),
     bindPortSSL(RPC_DEFAULT_SSL_PORT) {
   }
 
@@ -68,8 +83,13 @@ namespace CryptoNote {
   std::string RpcServerConfig::getDhFile() const { return dhFile; }
   std::string RpcServerConfig::getChainFile() const { return chainFile; }
   std::string RpcServerConfig::getKeyFile() const { return keyFile; }
+  size_t RpcServerConfig::getWorkerThreads() const { return workerThreads; }
+  size_t RpcServerConfig::getMaxNormalRequests() const { return maxNormalRequests; }
+  size_t RpcServerConfig::getMaxBulkRequests() const { return maxBulkRequests; }
+  size_t RpcServerConfig::getMaxQueuedRequests() const { return maxQueuedRequests; }
   std::string RpcServerConfig::getBindAddress() const { return bindIp + ":" + std::to_string(bindPort); }
   std::string RpcServerConfig::getBindAddressSSL() const { return bindIp + ":" + std::to_string(bindPortSSL); }
+  std::string RpcServerConfig::getStratumBindAddress() const { return bindIp + ":" + std::to_string(stratumBindPort); }
 
   void RpcServerConfig::initOptions(boost::program_options::options_description& desc) {
     command_line::add_arg(desc, arg_rpc_bind_ip);
@@ -85,6 +105,12 @@ namespace CryptoNote {
     command_line::add_arg(desc, arg_set_fee_address);
     command_line::add_arg(desc, arg_set_fee_amount);
     command_line::add_arg(desc, arg_set_view_key);
+    command_line::add_arg(desc, arg_rpc_threads);
+    command_line::add_arg(desc, arg_rpc_max_normal);
+    command_line::add_arg(desc, arg_rpc_max_bulk);
+    command_line::add_arg(desc, arg_rpc_max_queued);
+    command_line::add_arg(desc, arg_stratum_port);
+    command_line::add_arg(desc, arg_stratum_diff);
   }
 
   void RpcServerConfig::init(const boost::program_options::variables_map& vm)  {
@@ -101,6 +127,12 @@ namespace CryptoNote {
     nodeFeeAddress = command_line::get_arg(vm, arg_set_fee_address);
     nodeFeeAmountStr = command_line::get_arg(vm, arg_set_fee_amount);
     nodeFeeViewKey = command_line::get_arg(vm, arg_set_view_key);
+    workerThreads = command_line::get_arg(vm, arg_rpc_threads);
+    maxNormalRequests = command_line::get_arg(vm, arg_rpc_max_normal);
+    maxBulkRequests = command_line::get_arg(vm, arg_rpc_max_bulk);
+    maxQueuedRequests = command_line::get_arg(vm, arg_rpc_max_queued);
+    stratumBindPort = command_line::get_arg(vm, arg_stratum_port);
+    stratumDifficulty = command_line::get_arg(vm, arg_stratum_diff);
   }
 
 }
@@ -39,6 +39,11 @@ public:
   std::string getDhFile() const;
   std::string getChainFile() const;
   std::string getKeyFile() const;
+  size_t getWorkerThreads() const;
+  size_t getMaxNormalRequests() const;
+  size_t getMaxBulkRequests() const;
+  size_t getMaxQueuedRequests() const;
+  std::string getStratumBindAddress() const;
 
 //private:
   bool        restrictedRPC;
@@ -54,6 +59,12 @@ public:
   std::string nodeFeeAddress;
   std::string nodeFeeAmountStr;
   std::string nodeFeeViewKey;
+  size_t      workerThreads;
+  size_t      maxNormalRequests;
+  size_t      maxBulkRequests;
+  size_t      maxQueuedRequests;
+  uint16_t    stratumBindPort;
+  uint64_t    stratumDifficulty;
 };
 
 }
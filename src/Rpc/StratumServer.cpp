@@ -0,0 +1,483 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "StratumServer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <System/InterruptedException.h>
+#include <System/Ipv4Address.h>
+#include <System/RemoteContext.h>
+#include <System/ThreadPool.h>
+#include <System/Timer.h>
+
+#include "Common/StringTools.h"
+#include "crypto/hash.h"
+#include "crypto/random.h"
+#include "CryptoNoteCore/CryptoNoteBasicImpl.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/Difficulty.h"
+#include "CryptoNoteCore/TransactionExtra.h"
+#include "CryptoNoteCore/VerificationContext.h"
+
+using namespace Common;
+using namespace Logging;
+
+namespace CryptoNote {
+
+namespace {
+
+const size_t STRATUM_MAX_MINERS = 256;
+const size_t STRATUM_MAX_LINE_SIZE = 16 * 1024;
+const size_t STRATUM_READ_BUFFER_SIZE = 4 * 1024;
+const size_t STRATUM_JOBS_PER_MINER = 4;   // shares for the previous jobs of a miner are still taken
+const std::chrono::seconds STRATUM_POOL_JOB_INTERVAL(10);
+
+// the 4 byte little endian target of the pools while it fits, 8 bytes above that
+std::string makeTarget(difficulty_type difficulty) {
+  if (difficulty <= UINT32_MAX) {
+    uint32_t target = static_cast<uint32_t>(UINT32_MAX / difficulty);
+    return podToHex(target);
+  }
+
+  uint64_t target = UINT64_MAX / difficulty;
+  return podToHex(target);
+}
+
+JsonValue makeStatus(const std::string& status) {
+  JsonValue result(JsonValue::OBJECT);
+  result.insert("status", status);
+  return result;
+}
+
+}
+
+StratumServer::StratumServer(System::Dispatcher& dispatcher, Logging::ILogger& log, const Currency& currency, ICore& core, IMinerHandler& minerHandler) :
+  m_dispatcher(dispatcher),
+  logger(log, "StratumServer"),
+  m_currency(currency),
+  m_core(core),
+  m_minerHandler(minerHandler),
+  m_workingContextGroup(dispatcher),
+  m_coreChanged(dispatcher),
+  m_shareDifficulty(1),
+  m_templatesTailId(NULL_HASH),
+  m_poolChanged(false),
+  m_nextExtraNonce(Random::randomValue<uint32_t>()),
+  m_nextJobId(0),
+  m_started(false) {
+}
+
+StratumServer::~StratumServer() {
+  stop();
+}
+
+void StratumServer::start(const std::string& address, uint16_t port, difficulty_type shareDifficulty) {
+  m_listener = System::TcpListener(m_dispatcher, System::Ipv4Address(address), port);
+  m_shareDifficulty = std::max<difficulty_type>(shareDifficulty, 1);
+  m_templatesTailId = getTailId();
+  m_poolChanged = false;
+  m_templatesTime = std::chrono::steady_clock::now();
+  m_core.addObserver(this);
+  m_started = true;
+
+  m_workingContextGroup.spawn(std::bind(&StratumServer::acceptLoop, this));
+  m_workingContextGroup.spawn(std::bind(&StratumServer::jobLoop, this));
+  m_workingContextGroup.spawn(std::bind(&StratumServer::refreshLoop, this));
+}
+
+void StratumServer::stop() {
+  if (!m_started) {
+    return;
+  }
+
+  m_started = false;
+  m_core.removeObserver(this);
+  m_workingContextGroup.interrupt();
+  m_workingContextGroup.wait();
+  m_miners.clear();
+  m_templates.clear();
+}
+
+size_t StratumServer::getMinersCount() const {
+  return m_miners.size();
+}
+
+void StratumServer::blockchainUpdated() {
+  m_dispatcher.remoteSpawn([this] { m_coreChanged.set(); });
+}
+
+void StratumServer::poolUpdated() {
+  m_dispatcher.remoteSpawn([this] {
+    m_poolChanged = true;
+    m_coreChanged.set();
+  });
+}
+
+void StratumServer::acceptLoop() {
+  try {
+    std::shared_ptr<Miner> miner = std::make_shared<Miner>();
+    bool accepted = false;
+    while (!accepted) {
+      try {
+        miner->connection = m_listener.accept();
+        accepted = true;
+      } catch (System::InterruptedException&) {
+        throw;
+      } catch (std::exception&) {
+        // try again
+      }
+    }
+
+    m_workingContextGroup.spawn(std::bind(&StratumServer::acceptLoop, this));
+
+    if (m_miners.size() >= STRATUM_MAX_MINERS) {
+      logger(DEBUGGING) << "Too many miners, connection dropped";
+      return;
+    }
+
+    m_miners.insert(miner);
+    std::string buffer;
+    try {
+      for (;;) {
+        size_t offset = buffer.size();
+        buffer.resize(offset + STRATUM_READ_BUFFER_SIZE);
+        size_t transferred = miner->connection.read(reinterpret_cast<uint8_t*>(&buffer[offset]), STRATUM_READ_BUFFER_SIZE);
+        buffer.resize(offset + transferred);
+        if (transferred == 0) {
+          break;
+        }
+
+        size_t lineStart = 0;
+        size_t lineEnd;
+        bool keep = true;
+        while (keep && (lineEnd = buffer.find('\n', lineStart)) != std::string::npos) {
+          keep = processLine(*miner, buffer.substr(lineStart, lineEnd - lineStart));
+          lineStart = lineEnd + 1;
+        }
+
+        buffer.erase(0, lineStart);
+        if (!keep || buffer.size() > STRATUM_MAX_LINE_SIZE) {
+          break;
+        }
+      }
+    } catch (System::InterruptedException&) {
+      m_miners.erase(miner);
+      throw;
+    } catch (std::exception& e) {
+      logger(DEBUGGING) << "Miner connection error: " << e.what();
+    }
+
+    m_miners.erase(miner);
+  } catch (System::InterruptedException&) {
+  } catch (std::exception& e) {
+    logger(WARNING) << "Stratum connection error: " << e.what();
+  }
+}
+
+void StratumServer::jobLoop() {
+  try {
+    for (;;) {
+      m_coreChanged.wait();
+      m_coreChanged.clear();
+
+      // a new block is pushed right away, transactions are picked up at the next interval
+      if (getTailId() != m_templatesTailId ||
+          (m_poolChanged &&
+           std::chrono::steady_clock::now() - m_templatesTime >= STRATUM_POOL_JOB_INTERVAL)) {
+        updateJobs();
+      }
+    }
+  } catch (System::InterruptedException&) {
+  }
+}
+
+void StratumServer::refreshLoop() {
+  try {
+    System::Timer timer(m_dispatcher);
+    for (;;) {
+      timer.sleep(STRATUM_POOL_JOB_INTERVAL);
+      m_coreChanged.set();
+    }
+  } catch (System::InterruptedException&) {
+  }
+}
+
+Crypto::Hash StratumServer::getTailId() {
+  uint32_t height;
+  Crypto::Hash tailId;
+  m_core.get_blockchain_top(height, tailId);
+  return tailId;
+}
+
+void StratumServer::updateJobs() {
+  m_templates.clear();
+  m_templatesTailId = getTailId();
+  m_poolChanged = false;
+  m_templatesTime = std::chrono::steady_clock::now();
+
+  for (const std::shared_ptr<Miner>& miner : m_miners) {
+    if (!miner->id.empty()) {
+      m_workingContextGroup.spawn(std::bind(&StratumServer::pushJob, this, miner));
+    }
+  }
+}
+
+void StratumServer::pushJob(const std::shared_ptr<Miner>& miner) {
+  try {
+    JsonValue notification(JsonValue::OBJECT);
+    notification.insert("jsonrpc", "2.0");
+    notification.insert("method", "job");
+    notification.insert("params", makeJob(*miner));
+    send(*miner, notification);
+  } catch (System::InterruptedException&) {
+  } catch (std::exception& e) {
+    logger(DEBUGGING) << "Couldn't push a job to miner " << miner->id << ": " << e.what();
+  }
+}
+
+bool StratumServer::processLine(Miner& miner, const std::string& line) {
+  if (line.find_first_not_of(" \t\r") == std::string::npos) {
+    return true;
+  }
+
+  JsonValue request;
+  try {
+    request = JsonValue::fromString(line);
+  } catch (std::exception&) {
+    logger(DEBUGGING) << "Malformed request from miner, connection dropped";
+    return false;
+  }
+
+  if (!request.isObject() || !request.contains("method") || !request("method").isString()) {
+    return false;
+  }
+
+  JsonValue response(JsonValue::OBJECT);
+  response.insert("id", request.contains("id") ? request("id") : JsonValue(nullptr));
+  response.insert("jsonrpc", "2.0");
+  try {
+    JsonValue params = request.contains("params") ? request("params") : JsonValue(JsonValue::OBJECT);
+    response.insert("result", processRequest(miner, request("method").getString(), params));
+    response.insert("error", JsonValue(nullptr));
+  } catch (System::InterruptedException&) {
+    throw;
+  } catch (std::exception& e) {
+    JsonValue error(JsonValue::OBJECT);
+    error.insert("code", static_cast<int64_t>(-1));
+    error.insert("message", std::string(e.what()));
+    response.insert("result", JsonValue(nullptr));
+    response.insert("error", std::move(error));
+  }
+
+  send(miner, response);
+  return true;
+}
+
+JsonValue StratumServer::processRequest(Miner& miner, const std::string& method, const JsonValue& params) {
+  if (method == "login") {
+    return login(miner, params);
+  }
+
+  if (miner.id.empty() || !params.isObject() || !params.contains("id") || !params("id").isString() ||
+      params("id").getString() != miner.id) {
+    throw std::runtime_error("Unauthenticated");
+  }
+
+  if (method == "getjob") {
+    return makeJob(miner);
+  } else if (method == "submit") {
+    return submit(miner, params);
+  } else if (method == "keepalived") {
+    return makeStatus("KEEPALIVED");
+  }
+
+  throw std::runtime_error("Unknown method");
+}
+
+JsonValue StratumServer::login(Miner& miner, const JsonValue& params) {
+  if (!miner.id.empty()) {
+    throw std::runtime_error("Already logged in");
+  }
+
+  if (!params.isObject() || !params.contains("login") || !params("login").isString()) {
+    throw std::runtime_error("Missing login");
+  }
+
+  // miners often append a worker name or a difficulty to the address
+  std::string address = params("login").getString();
+  address = address.substr(0, address.find_first_of(".+"));
+  if (!m_currency.parseAccountAddressString(address, miner.accountAddress)) {
+    throw std::runtime_error("Invalid address");
+  }
+
+  miner.address = address;
+  miner.extraNonce = m_nextExtraNonce++;
+  miner.id = podToHex(Random::randomValue<uint64_t>());
+
+  JsonValue result(JsonValue::OBJECT);
+  result.insert("id", miner.id);
+  result.insert("job", makeJob(miner));
+  result.insert("status", "OK");
+  logger(DEBUGGING) << "Miner " << miner.id << " logged in, mining to " << address;
+  return result;
+}
+
+JsonValue StratumServer::submit(Miner& miner, const JsonValue& params) {
+  if (!params.contains("job_id") || !params("job_id").isString() || !params.contains("nonce") || !params("nonce").isString()) {
+    throw std::runtime_error("Missing job id or nonce");
+  }
+
+  auto jobIt = std::find_if(miner.jobs.begin(), miner.jobs.end(), [&params](const std::shared_ptr<Job>& job) {
+    return job->id == params("job_id").getString();
+  });
+  if (jobIt == miner.jobs.end()) {
+    throw std::runtime_error("Block expired");
+  }
+
+  // held while hashing, a pushed job may drop it from the miner's jobs meanwhile
+  std::shared_ptr<Job> job = *jobIt;
+  uint32_t nonce;
+  if (!podFromHex(params("nonce").getString(), nonce)) {
+    throw std::runtime_error("Invalid nonce");
+  }
+
+  if (!job->nonces.insert(nonce).second) {
+    throw std::runtime_error("Duplicate share");
+  }
+
+  BinaryArray blob = job->blob;
+  memcpy(&blob[job->nonceOffset], &nonce, sizeof(nonce));
+  Crypto::Hash hash = System::RemoteContext<Crypto::Hash>(m_dispatcher, System::ThreadPool::shared(), [&blob] {
+    Crypto::cn_context context;
+    Crypto::Hash result;
+    Crypto::cn_slow_hash(context, blob.data(), blob.size(), result);
+    return result;
+  }).get();
+
+  Crypto::Hash claimed;
+  if (params.contains("result") && params("result").isString() && podFromHex(params("result").getString(), claimed) && claimed != hash) {
+    throw std::runtime_error("Invalid result");
+  }
+
+  if (!check_hash(hash, job->shareDifficulty)) {
+    throw std::runtime_error("Low difficulty share");
+  }
+
+  if (check_hash(hash, job->difficulty)) {
+    Block block = job->block;
+    block.nonce = nonce;
+    block_verification_context bvc = boost::value_initialized<block_verification_context>();
+    m_core.handle_incoming_block_blob(toBinaryArray(block), bvc, true, true);
+    if (bvc.m_added_to_main_chain) {
+      logger(INFO, BRIGHT_GREEN) << "Stratum miner " << miner.id << " found block " << get_block_hash(block) << " at height " << job->height;
+    } else {
+      logger(WARNING) << "Block " << get_block_hash(block) << " of stratum miner " << miner.id << " wasn't added to the main chain";
+    }
+  }
+
+  return makeStatus("OK");
+}
+
+JsonValue StratumServer::makeJob(Miner& miner) {
+  const Template& blockTemplate = getTemplate(miner);
+  std::shared_ptr<Job> job = std::make_shared<Job>();
+  job->block = blockTemplate.block;
+  memcpy(&job->block.baseTransaction.extra[blockTemplate.extraNonceOffset], &miner.extraNonce, sizeof(miner.extraNonce));
+  if (!get_block_longhash_blob(job->block, job->blob, job->nonceOffset)) {
+    throw std::runtime_error("Internal error: failed to get hashing blob");
+  }
+
+  job->id = std::to_string(++m_nextJobId);
+  job->difficulty = blockTemplate.difficulty;
+  job->shareDifficulty = std::min(m_shareDifficulty, blockTemplate.difficulty);
+  job->height = blockTemplate.height;
+
+  miner.jobs.push_back(job);
+  if (miner.jobs.size() > STRATUM_JOBS_PER_MINER) {
+    miner.jobs.pop_front();
+  }
+
+  JsonValue result(JsonValue::OBJECT);
+  result.insert("blob", toHex(job->blob));
+  result.insert("job_id", job->id);
+  result.insert("target", makeTarget(job->shareDifficulty));
+  result.insert("height", static_cast<int64_t>(job->height));
+  return result;
+}
+
+const StratumServer::Template& StratumServer::getTemplate(const Miner& miner) {
+  auto it = m_templates.find(miner.address);
+  if (it != m_templates.end()) {
+    return it->second;
+  }
+
+  Template blockTemplate;
+  BinaryArray reserved(sizeof(miner.extraNonce), 0);
+  if (!m_minerHandler.get_block_template(blockTemplate.block, miner.accountAddress, blockTemplate.difficulty, blockTemplate.height, reserved)) {
+    throw std::runtime_error("Internal error: failed to create block template");
+  }
+
+  // the reserved bytes follow the public key, the extra nonce tag and its size
+  const std::vector<uint8_t>& extra = blockTemplate.block.baseTransaction.extra;
+  Crypto::PublicKey txPublicKey = getTransactionPublicKeyFromExtra(extra);
+  auto keyIt = std::search(extra.begin(), extra.end(), txPublicKey.data, txPublicKey.data + sizeof(txPublicKey));
+  if (txPublicKey == NULL_PUBLIC_KEY || keyIt == extra.end()) {
+    throw std::runtime_error("Internal error: failed to find tx pub key in coinbase extra");
+  }
+
+  blockTemplate.extraNonceOffset = static_cast<size_t>(std::distance(extra.begin(), keyIt)) + sizeof(txPublicKey) + 2;
+  if (blockTemplate.extraNonceOffset + reserved.size() > extra.size() ||
+      extra[blockTemplate.extraNonceOffset - 2] != TX_EXTRA_NONCE) {
+    throw std::runtime_error("Internal error: failed to find the reserved space");
+  }
+
+  return m_templates.emplace(miner.address, std::move(blockTemplate)).first->second;
+}
+
+void StratumServer::send(Miner& miner, const JsonValue& message) {
+  miner.pending += message.toString();
+  miner.pending += '\n';
+
+  // a write in progress on another context takes the line along
+  if (miner.writing) {
+    return;
+  }
+
+  miner.writing = true;
+  try {
+    while (!miner.pending.empty()) {
+      std::string data;
+      data.swap(miner.pending);
+      size_t offset = 0;
+      while (offset < data.size()) {
+        offset += miner.connection.write(reinterpret_cast<const uint8_t*>(data.data() + offset), data.size() - offset);
+      }
+    }
+  } catch (...) {
+    miner.writing = false;
+    miner.pending.clear();
+    throw;
+  }
+
+  miner.writing = false;
+}
+
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <System/ContextGroup.h>
+#include <System/Dispatcher.h>
+#include <System/Event.h>
+#include <System/TcpConnection.h>
+#include <System/TcpListener.h>
+
+#include <Logging/LoggerRef.h>
+
+#include "Common/JsonValue.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/ICore.h"
+#include "CryptoNoteCore/ICoreObserver.h"
+#include "CryptoNoteCore/IMinerHandler.h"
+
+namespace CryptoNote {
+
+// Stratum server for solo miners, speaking the line delimited JSON-RPC of the CryptoNote pools
+// (login, getjob, submit, keepalived and the pushed job notifications). Miners mining to the
+// same address share one block template, every miner gets an extra nonce of its own written
+// into the reserved space of the coinbase, so the nonce ranges never overlap. Jobs keep their
+// hashing blob, a share is checked by rewriting the nonce in it and hashing once, the block
+// is built only when the share meets the block difficulty. New jobs are pushed as soon as the
+// chain changes and after pool changes at most every few seconds. It runs on the dispatcher.
+class StratumServer : private ICoreObserver {
+public:
+  StratumServer(System::Dispatcher& dispatcher, Logging::ILogger& log, const Currency& currency, ICore& core, IMinerHandler& minerHandler);
+  ~StratumServer();
+
+  void start(const std::string& address, uint16_t port, difficulty_type shareDifficulty);
+  void stop();
+  size_t getMinersCount() const;
+
+private:
+  struct Template {
+    Block block;
+    size_t extraNonceOffset;   // of the reserved bytes in the coinbase extra
+    difficulty_type difficulty;
+    uint32_t height;
+  };
+
+  struct Job {
+    std::string id;
+    Block block;
+    BinaryArray blob;          // hashing blob, only the nonce differs between shares
+    size_t nonceOffset;
+    difficulty_type difficulty;
+    difficulty_type shareDifficulty;
+    uint32_t height;
+    std::unordered_set<uint32_t> nonces;
+  };
+
+  struct Miner {
+    System::TcpConnection connection;
+    std::string id;
+    std::string address;
+    AccountPublicAddress accountAddress;
+    uint32_t extraNonce = 0;
+    std::deque<std::shared_ptr<Job>> jobs;   // newest last
+    std::string pending;                     // lines waiting for the write in progress
+    bool writing = false;
+  };
+
+  // ICoreObserver
+  virtual void blockchainUpdated() override;
+  virtual void poolUpdated() override;
+
+  void acceptLoop();
+  void jobLoop();
+  void refreshLoop();
+  Crypto::Hash getTailId();
+  void updateJobs();
+  void pushJob(const std::shared_ptr<Miner>& miner);
+  bool processLine(Miner& miner, const std::string& line);
+  Common::JsonValue processRequest(Miner& miner, const std::string& method, const Common::JsonValue& params);
+  Common::JsonValue login(Miner& miner, const Common::JsonValue& params);
+  Common::JsonValue submit(Miner& miner, const Common::JsonValue& params);
+  Common::JsonValue makeJob(Miner& miner);
+  const Template& getTemplate(const Miner& miner);
+  void send(Miner& miner, const Common::JsonValue& message);
+
+  System::Dispatcher& m_dispatcher;
+  Logging::LoggerRef logger;
+  const Currency& m_currency;
+  ICore& m_core;
+  IMinerHandler& m_minerHandler;
+  System::ContextGroup m_workingContextGroup;
+  System::TcpListener m_listener;
+  System::Event m_coreChanged;
+  difficulty_type m_shareDifficulty;
+  std::unordered_set<std::shared_ptr<Miner>> m_miners;
+  std::unordered_map<std::string, Template> m_templates;   // by the miner address
+  Crypto::Hash m_templatesTailId;
+  bool m_poolChanged;
+  std::chrono::steady_clock::time_point m_templatesTime;
+  uint32_t m_nextExtraNonce;
+  uint64_t m_nextJobId;
+  bool m_started;
+};
+
+}
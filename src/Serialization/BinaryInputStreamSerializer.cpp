@@ -9,6 +9,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <stdexcept>
 #include <Common/StreamTools.h>
 #include "SerializationOverloads.h"
@@ -17,15 +18,6 @@ using namespace Common;
 
 namespace CryptoNote {
 
-namespace {
-
-template<typename StorageType, typename T>
-void readVarintAs(IInputStream& s, T &i) {
-  i = static_cast<T>(readVarint<StorageType>(s));
-}
-
-}
-
 ISerializer::SerializerType BinaryInputStreamSerializer::type() const {
   return ISerializer::INPUT;
 }
@@ -38,7 +30,7 @@ void BinaryInputStreamSerializer::endObject() {
 }
 
 bool BinaryInputStreamSerializer::beginArray(size_t& size, Common::StringView name) {
-  readVarintAs<uint64_t>(stream, size);
+  size = static_cast<size_t>(readVarint<uint64_t>());
 
   return true;
 }
@@ -47,55 +39,51 @@ void BinaryInputStreamSerializer::endArray() {
 }
 
 bool BinaryInputStreamSerializer::operator()(uint8_t& value, Common::StringView name) {
-  readVarint(stream, value);
+  value = readVarint<uint8_t>();
   return true;
 }
 
 bool BinaryInputStreamSerializer::operator()(uint16_t& value, Common::StringView name) {
-  readVarint(stream, value);
+  value = readVarint<uint16_t>();
   return true;
 }
 
 bool BinaryInputStreamSerializer::operator()(int16_t& value, Common::StringView name) {
-  readVarintAs<uint16_t>(stream, value);
+  value = static_cast<int16_t>(readVarint<uint16_t>());
   return true;
 }
 
 bool BinaryInputStreamSerializer::operator()(uint32_t& value, Common::StringView name) {
-  readVarint(stream, value);
+  value = readVarint<uint32_t>();
   return true;
 }
 
 bool BinaryInputStreamSerializer::operator()(int32_t& value, Common::StringView name) {
-  readVarintAs<uint32_t>(stream, value);
+  value = static_cast<int32_t>(readVarint<uint32_t>());
   return true;
 }
 
 bool BinaryInputStreamSerializer::operator()(int64_t& value, Common::StringView name) {
-  readVarintAs<uint64_t>(stream, value);
+  value = static_cast<int64_t>(readVarint<uint64_t>());
   return true;
 }
 
 bool BinaryInputStreamSerializer::operator()(uint64_t& value, Common::StringView name) {
-  readVarint(stream, value);
+  value = readVarint<uint64_t>();
   return true;
 }
 
 bool BinaryInputStreamSerializer::operator()(bool& value, Common::StringView name) {
-  value = read<uint8_t>(stream) != 0;
+  value = readByte() != 0;
   return true;
 }
 
 bool BinaryInputStreamSerializer::operator()(std::string& value, Common::StringView name) {
-  uint64_t size;
-  readVarint(stream, size);
+  uint64_t size = readVarint<uint64_t>();
 
   if (size > 0) {
-    std::vector<char> temp;
-    temp.resize(size);
-    checkedRead(&temp[0], size);
-    value.reserve(size);
-    value.assign(&temp[0], size);
+    value.resize(size);
+    checkedRead(&value[0], size);
   } else {
     value.clear();
   }
@@ -112,6 +100,11 @@ bool BinaryInputStreamSerializer::binary(std::string& value, Common::StringView
   return (*this)(value, name);
 }
 
+bool BinaryInputStreamSerializer::binaryItems(void* items, size_t itemSize, size_t count) {
+  checkedRead(static_cast<char*>(items), itemSize * count);
+  return true;
+}
+
 bool BinaryInputStreamSerializer::operator()(double& value, Common::StringView name) {
   assert(false); //the method is not supported for this type of serialization
   throw std::runtime_error("double serialization is not supported in BinaryInputStreamSerializer");
@@ -119,7 +112,36 @@ bool BinaryInputStreamSerializer::operator()(double& value, Common::StringView n
 }
 
 void BinaryInputStreamSerializer::checkedRead(char* buf, size_t size) {
-  read(stream, buf, size);
+  size_t buffered = std::min(size, bufferEnd - bufferPosition);
+  if (buffered != 0) {
+    memcpy(buf, buffer.data() + bufferPosition, buffered);
+    bufferPosition += buffered;
+    buf += buffered;
+    size -= buffered;
+  }
+
+  if (size == 0) {
+    return;
+  }
+
+  if (size >= buffer.size()) {
+    read(stream, buf, size);
+    return;
+  }
+
+  bufferPosition = 0;
+  bufferEnd = 0;
+  while (bufferEnd < size) {
+    size_t readSize = stream.readSome(buffer.data() + bufferEnd, buffer.size() - bufferEnd);
+    if (readSize == 0) {
+      throw std::runtime_error("Failed to read from IInputStream");
+    }
+
+    bufferEnd += readSize;
+  }
+
+  memcpy(buf, buffer.data(), size);
+  bufferPosition = size;
 }
 
 }
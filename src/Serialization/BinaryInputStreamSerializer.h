@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include <stdexcept>
+#include <vector>
+
 #include <Common/IInputStream.h>
 #include "ISerializer.h"
 #include "SerializationOverloads.h"
@@ -25,7 +28,12 @@ namespace CryptoNote {
 
 class BinaryInputStreamSerializer : public ISerializer {
 public:
-  BinaryInputStreamSerializer(Common::IInputStream& strm) : stream(strm) {}
+  static const size_t READ_AHEAD_SIZE = 64 * 1024;
+
+  BinaryInputStreamSerializer(Common::IInputStream& strm) : stream(strm), bufferPosition(0), bufferEnd(0) {}
+  // reads the stream ahead by blocks of the buffer size, so it is left past the serialized data;
+  // for readers that consume the whole stream, like the blockchain caches
+  BinaryInputStreamSerializer(Common::IInputStream& strm, size_t bufferSize) : stream(strm), buffer(bufferSize), bufferPosition(0), bufferEnd(0) {}
   virtual ~BinaryInputStreamSerializer() {}
 
   virtual ISerializer::SerializerType type() const override;
@@ -48,6 +56,7 @@ public:
   virtual bool operator()(std::string& value, Common::StringView name) override;
   virtual bool binary(void* value, size_t size, Common::StringView name) override;
   virtual bool binary(std::string& value, Common::StringView name) override;
+  virtual bool binaryItems(void* items, size_t itemSize, size_t count) override;
 
   template<typename T>
   bool operator()(T& value, Common::StringView name) {
@@ -55,9 +64,43 @@ public:
   }
 
 private:
+  uint8_t readByte() {
+    if (bufferPosition < bufferEnd) {
+      return static_cast<uint8_t>(buffer[bufferPosition++]);
+    }
+
+    char value;
+    checkedRead(&value, 1);
+    return static_cast<uint8_t>(value);
+  }
+
+  template <typename T>
+  T readVarint() {
+    T value = 0;
+    for (uint8_t shift = 0;; shift += 7) {
+      uint8_t piece = readByte();
+      if (shift >= sizeof(value) * 8 - 7 && piece >= 1 << (sizeof(value) * 8 - shift)) {
+        throw std::runtime_error("readVarint, value overflow");
+      }
+
+      value |= static_cast<T>(static_cast<uint64_t>(piece & 0x7f) << shift);
+      if ((piece & 0x80) == 0) {
+        if (piece == 0 && shift != 0) {
+          throw std::runtime_error("readVarint, invalid value representation");
+        }
+
+        break;
+      }
+    }
+
+    return value;
+  }
 
   void checkedRead(char* buf, size_t size);
   Common::IInputStream& stream;
+  std::vector<char> buffer;
+  size_t bufferPosition;
+  size_t bufferEnd;
 };
 
 }
@@ -101,6 +101,11 @@ bool BinaryOutputStreamSerializer::binary(std::string& value, Common::StringView
   return (*this)(value, name);
 }
 
+bool BinaryOutputStreamSerializer::binaryItems(void* items, size_t itemSize, size_t count) {
+  checkedWrite(static_cast<const char*>(items), itemSize * count);
+  return true;
+}
+
 bool BinaryOutputStreamSerializer::operator()(double& value, Common::StringView name) {
   assert(false); //the method is not supported for this type of serialization
   throw std::runtime_error("double serialization is not supported in BinaryOutputStreamSerializer");
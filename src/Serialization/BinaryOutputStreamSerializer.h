@@ -48,6 +48,7 @@ public:
   virtual bool operator()(std::string& value, Common::StringView name) override;
   virtual bool binary(void* value, size_t size, Common::StringView name) override;
   virtual bool binary(std::string& value, Common::StringView name) override;
+  virtual bool binaryItems(void* items, size_t itemSize, size_t count) override;
 
   template<typename T>
   bool operator()(T& value, Common::StringView name) {
@@ -78,9 +78,10 @@ bool loadFromBinaryFile(T& obj, const std::string& filename) {
     }
 
     Common::StdInputStream stream(dataFile);
-    BinaryInputStreamSerializer in(stream);
+    BinaryInputStreamSerializer in(stream, BinaryInputStreamSerializer::READ_AHEAD_SIZE);
     serialize(obj, in);
-    return !dataFile.fail();
+    // the read ahead stops at the end of the file
+    return !dataFile.bad();
   } catch (std::exception&) {
     return false;
   }
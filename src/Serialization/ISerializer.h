@@ -56,6 +56,10 @@ public:
   virtual bool binary(void* value, size_t size, Common::StringView name) = 0;
   virtual bool binary(std::string& value, Common::StringView name) = 0;
 
+  // read/write count fixed size items stored back to back, as the elements of an array or in a row;
+  // false means the serializer keeps them separately and they have to be serialized one by one
+  virtual bool binaryItems(void* items, size_t itemSize, size_t count) { return false; }
+
   template<typename T>
   bool operator()(T& value, Common::StringView name);
 };
@@ -0,0 +1,446 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "JsonInputReader.h"
+
+#include <cassert>
+#include <cctype>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include "Common/StringTools.h"
+
+using namespace CryptoNote;
+
+JsonInputReader::JsonInputReader(std::string text) : m_text(std::move(text)) {
+  size_t pos = 0;
+  parseValue(pos, 0);
+  if (m_nodes.front().type != OBJECT) {
+    throw std::runtime_error("Serializer doesn't support this type of serialization: Object expected.");
+  }
+
+  m_scopes.push_back({ 0, 0 });
+}
+
+JsonInputReader::~JsonInputReader() {
+}
+
+ISerializer::SerializerType JsonInputReader::type() const {
+  return ISerializer::INPUT;
+}
+
+char JsonInputReader::readNonWsChar(size_t& pos) const {
+  while (pos < m_text.size() && isspace(static_cast<unsigned char>(m_text[pos]))) {
+    ++pos;
+  }
+
+  if (pos == m_text.size()) {
+    throw std::runtime_error("Unable to parse: unexpected end of stream");
+  }
+
+  return m_text[pos++];
+}
+
+void JsonInputReader::parseValue(size_t& pos, size_t depth) {
+  if (depth > MAX_DEPTH) {
+    throw std::runtime_error("Unable to parse: nesting is too deep");
+  }
+
+  char c = readNonWsChar(pos);
+  size_t index = m_nodes.size();
+
+  if (c == '{') {
+    m_nodes.push_back({ OBJECT, pos - 1, 0, 0, 0 });
+    c = readNonWsChar(pos);
+    if (c != '}') {
+      for (;;) {
+        if (c != '"') {
+          throw std::runtime_error("Unable to parse");
+        }
+
+        parseString(pos, STRING);
+        if (readNonWsChar(pos) != ':') {
+          throw std::runtime_error("Unable to parse");
+        }
+
+        parseValue(pos, depth + 1);
+        ++m_nodes[index].size;
+
+        c = readNonWsChar(pos);
+        if (c == '}') {
+          break;
+        }
+
+        if (c != ',') {
+          throw std::runtime_error("Unable to parse");
+        }
+
+        c = readNonWsChar(pos);
+      }
+    }
+  } else if (c == '[') {
+    m_nodes.push_back({ ARRAY, pos - 1, 0, 0, 0 });
+    size_t start = pos;
+    if (readNonWsChar(pos) != ']') {
+      pos = start;
+      for (;;) {
+        parseValue(pos, depth + 1);
+        ++m_nodes[index].size;
+
+        c = readNonWsChar(pos);
+        if (c == ']') {
+          break;
+        }
+
+        if (c != ',') {
+          throw std::runtime_error("Unable to parse");
+        }
+      }
+    }
+  } else if (c == '"') {
+    parseString(pos, STRING);
+    return;
+  } else if (c == '-' || (c >= '0' && c <= '9')) {
+    --pos;
+    parseNumber(pos);
+    return;
+  } else if (c == 't' || c == 'f' || c == 'n') {
+    const char* literal = c == 't' ? "true" : (c == 'f' ? "false" : "null");
+    size_t length = strlen(literal);
+    --pos;
+    if (m_text.compare(pos, length, literal) != 0) {
+      throw std::runtime_error("Unable to parse");
+    }
+
+    m_nodes.push_back({ c == 'n' ? NIL : BOOL, pos, pos + length, index + 1, 0 });
+    pos += length;
+    return;
+  } else {
+    throw std::runtime_error("Unable to parse");
+  }
+
+  m_nodes[index].end = pos;
+  m_nodes[index].next = m_nodes.size();
+}
+
+void JsonInputReader::parseString(size_t& pos, Type type) {
+  // escapes are kept as they are, like JsonValue does
+  size_t begin = pos - 1;
+  for (;;) {
+    if (pos >= m_text.size()) {
+      throw std::runtime_error("Unable to parse: unexpected end of stream");
+    }
+
+    char c = m_text[pos++];
+    if (c == '"') {
+      break;
+    }
+
+    if (c == '\\') {
+      ++pos;
+    }
+  }
+
+  m_nodes.push_back({ type, begin, pos, m_nodes.size() + 1, 0 });
+}
+
+void JsonInputReader::parseNumber(size_t& pos) {
+  size_t begin = pos;
+  size_t dots = 0;
+  size_t digits = 0;
+
+  if (m_text[pos] == '-') {
+    ++pos;
+  }
+
+  for (; pos < m_text.size(); ++pos) {
+    char c = m_text[pos];
+    if (c >= '0' && c <= '9') {
+      ++digits;
+    } else if (c == '.') {
+      ++dots;
+    } else {
+      break;
+    }
+  }
+
+  if (digits == 0 || dots > 1) {
+    throw std::runtime_error("Unable to parse");
+  }
+
+  Type type = INTEGER;
+  if (dots > 0) {
+    type = REAL;
+    if (pos < m_text.size() && m_text[pos] == 'e') {
+      ++pos;
+      if (pos < m_text.size() && (m_text[pos] == '+' || m_text[pos] == '-')) {
+        ++pos;
+      }
+
+      if (pos == m_text.size() || m_text[pos] < '0' || m_text[pos] > '9') {
+        throw std::runtime_error("Unable to parse");
+      }
+
+      while (pos < m_text.size() && m_text[pos] >= '0' && m_text[pos] <= '9') {
+        ++pos;
+      }
+    }
+  } else {
+    size_t first = m_text[begin] == '-' ? begin + 1 : begin;
+    if (m_text[first] == '0' && pos - begin > 1) {
+      throw std::runtime_error("Unable to parse");
+    }
+  }
+
+  m_nodes.push_back({ type, begin, pos, m_nodes.size() + 1, 0 });
+}
+
+const JsonInputReader::Node* JsonInputReader::findMember(const Node& object, Common::StringView name) const {
+  // duplicate names resolve to the last one, as in JsonValue
+  const Node* found = nullptr;
+  size_t key = static_cast<size_t>(&object - m_nodes.data()) + 1;
+  for (size_t i = 0; i < object.size; ++i) {
+    const Node& keyNode = m_nodes[key];
+    const Node& valueNode = m_nodes[key + 1];
+    if (keyNode.end - keyNode.begin - 2 == name.getSize() &&
+        memcmp(m_text.data() + keyNode.begin + 1, name.getData(), name.getSize()) == 0) {
+      found = &valueNode;
+    }
+
+    key = valueNode.next;
+  }
+
+  return found;
+}
+
+const JsonInputReader::Node* JsonInputReader::getValue(Common::StringView name) {
+  Scope& scope = m_scopes.back();
+  const Node& parent = m_nodes[scope.node];
+  if (parent.type == ARRAY) {
+    if (scope.cursor >= parent.next) {
+      throw std::runtime_error("Unable to read array element: out of range");
+    }
+
+    const Node* node = &m_nodes[scope.cursor];
+    scope.cursor = node->next;
+    return node;
+  }
+
+  return findMember(parent, name);
+}
+
+void JsonInputReader::beginScope(const Node& node) {
+  size_t index = static_cast<size_t>(&node - m_nodes.data());
+  m_scopes.push_back({ index, index + 1 });
+}
+
+bool JsonInputReader::beginObject(Common::StringView name) {
+  const Node* node = getValue(name);
+  if (node == nullptr) {
+    return false;
+  }
+
+  if (node->type != OBJECT) {
+    throw std::runtime_error("JsonValue type is not OBJECT");
+  }
+
+  beginScope(*node);
+  return true;
+}
+
+void JsonInputReader::endObject() {
+  assert(m_scopes.size() > 1);
+  m_scopes.pop_back();
+}
+
+bool JsonInputReader::beginArray(size_t& size, Common::StringView name) {
+  const Node* node = getValue(name);
+  if (node == nullptr) {
+    size = 0;
+    return false;
+  }
+
+  if (node->type != ARRAY) {
+    throw std::runtime_error("JsonValue type is not ARRAY");
+  }
+
+  size = node->size;
+  beginScope(*node);
+  return true;
+}
+
+void JsonInputReader::endArray() {
+  assert(m_scopes.size() > 1);
+  m_scopes.pop_back();
+}
+
+int64_t JsonInputReader::getInteger(const Node& node) const {
+  if (node.type != INTEGER) {
+    throw std::runtime_error("JsonValue type is not INTEGER");
+  }
+
+  size_t pos = node.begin;
+  bool negative = m_text[pos] == '-';
+  if (negative) {
+    ++pos;
+  }
+
+  // the whole uint64_t range is accepted, wrapping around like JsonOutputWriter writes it
+  uint64_t value = 0;
+  for (; pos < node.end; ++pos) {
+    uint64_t digit = static_cast<uint64_t>(m_text[pos] - '0');
+    if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+      throw std::runtime_error("Unable to parse: integer is out of range");
+    }
+
+    value = value * 10 + digit;
+  }
+
+  return static_cast<int64_t>(negative ? 0 - value : value);
+}
+
+double JsonInputReader::getReal(const Node& node) const {
+  if (node.type == INTEGER) {
+    return static_cast<double>(getInteger(node));
+  }
+
+  if (node.type != REAL) {
+    throw std::runtime_error("JsonValue type is not REAL");
+  }
+
+  double value = 0;
+  std::istringstream(m_text.substr(node.begin, node.end - node.begin)) >> value;
+  return value;
+}
+
+bool JsonInputReader::operator()(uint8_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputReader::operator()(int16_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputReader::operator()(uint16_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputReader::operator()(int32_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputReader::operator()(uint32_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputReader::operator()(int64_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputReader::operator()(uint64_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputReader::operator()(double& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputReader::operator()(bool& value, Common::StringView name) {
+  const Node* node = getValue(name);
+  if (node == nullptr) {
+    return false;
+  }
+
+  if (node->type != BOOL) {
+    throw std::runtime_error("JsonValue type is not BOOL");
+  }
+
+  value = m_text[node->begin] == 't';
+  return true;
+}
+
+bool JsonInputReader::operator()(std::string& value, Common::StringView name) {
+  const Node* node = getValue(name);
+  if (node == nullptr) {
+    return false;
+  }
+
+  if (node->type != STRING) {
+    throw std::runtime_error("JsonValue type is not STRING");
+  }
+
+  value.assign(m_text, node->begin + 1, node->end - node->begin - 2);
+  return true;
+}
+
+size_t JsonInputReader::hexToBinary(const Node& node, void* data, size_t size) const {
+  if (node.type != STRING) {
+    throw std::runtime_error("JsonValue type is not STRING");
+  }
+
+  size_t length = node.end - node.begin - 2;
+  if ((length & 1) != 0) {
+    throw std::runtime_error("fromHex: invalid string size");
+  }
+
+  if (length >> 1 > size) {
+    throw std::runtime_error("fromHex: invalid buffer size");
+  }
+
+  if (!Common::decodeHex(m_text.data() + node.begin + 1, length >> 1, data)) {
+    throw std::runtime_error("fromHex: invalid character");
+  }
+
+  return length >> 1;
+}
+
+bool JsonInputReader::binary(void* value, size_t size, Common::StringView name) {
+  const Node* node = getValue(name);
+  if (node == nullptr) {
+    return false;
+  }
+
+  hexToBinary(*node, value, size);
+  return true;
+}
+
+bool JsonInputReader::binary(std::string& value, Common::StringView name) {
+  const Node* node = getValue(name);
+  if (node == nullptr) {
+    return false;
+  }
+
+  if (node->type != STRING) {
+    throw std::runtime_error("JsonValue type is not STRING");
+  }
+
+  value.resize((node->end - node->begin - 2) / 2);
+  value.resize(hexToBinary(*node, &value[0], value.size()));
+  return true;
+}
+
+bool JsonInputReader::rawValue(Common::StringView name, std::string& json) {
+  const Node* node = getValue(name);
+  if (node == nullptr) {
+    return false;
+  }
+
+  json.assign(m_text, node->begin, node->end - node->begin);
+  return true;
+}
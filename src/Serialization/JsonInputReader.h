@@ -0,0 +1,116 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "ISerializer.h"
+
+namespace CryptoNote {
+
+// Deserializes straight from JSON text without building a JsonValue tree. The text is
+// scanned once into a flat list of token positions, values are decoded from the text
+// only when the target structure asks for them. Accepts the same input as
+// JsonInputValueSerializer and throws std::runtime_error where it would.
+class JsonInputReader : public ISerializer {
+public:
+  explicit JsonInputReader(std::string text);
+  virtual ~JsonInputReader();
+
+  SerializerType type() const override;
+
+  virtual bool beginObject(Common::StringView name) override;
+  virtual void endObject() override;
+
+  virtual bool beginArray(size_t& size, Common::StringView name) override;
+  virtual void endArray() override;
+
+  virtual bool operator()(uint8_t& value, Common::StringView name) override;
+  virtual bool operator()(int16_t& value, Common::StringView name) override;
+  virtual bool operator()(uint16_t& value, Common::StringView name) override;
+  virtual bool operator()(int32_t& value, Common::StringView name) override;
+  virtual bool operator()(uint32_t& value, Common::StringView name) override;
+  virtual bool operator()(int64_t& value, Common::StringView name) override;
+  virtual bool operator()(uint64_t& value, Common::StringView name) override;
+  virtual bool operator()(double& value, Common::StringView name) override;
+  virtual bool operator()(bool& value, Common::StringView name) override;
+  virtual bool operator()(std::string& value, Common::StringView name) override;
+  virtual bool binary(void* value, size_t size, Common::StringView name) override;
+  virtual bool binary(std::string& value, Common::StringView name) override;
+
+  template<typename T>
+  bool operator()(T& value, Common::StringView name) {
+    return ISerializer::operator()(value, name);
+  }
+
+  // JSON text of a member of the current object, as it appears in the input
+  bool rawValue(Common::StringView name, std::string& json);
+
+private:
+  enum Type : uint8_t { NIL, BOOL, INTEGER, REAL, STRING, ARRAY, OBJECT };
+
+  struct Node {
+    Type type;
+    size_t begin;
+    size_t end;
+    size_t next;  // index of the node after this one and its children
+    size_t size;  // number of elements or members
+  };
+
+  struct Scope {
+    size_t node;
+    size_t cursor;
+  };
+
+  static const size_t MAX_DEPTH = 128;
+
+  void parseValue(size_t& pos, size_t depth);
+  void parseString(size_t& pos, Type type);
+  void parseNumber(size_t& pos);
+  char readNonWsChar(size_t& pos) const;
+
+  const Node* getValue(Common::StringView name);
+  const Node* findMember(const Node& object, Common::StringView name) const;
+  int64_t getInteger(const Node& node) const;
+  double getReal(const Node& node) const;
+  void beginScope(const Node& node);
+  size_t hexToBinary(const Node& node, void* data, size_t size) const;
+
+  template <typename T>
+  bool getNumber(Common::StringView name, T& v) {
+    const Node* node = getValue(name);
+    if (node == nullptr) {
+      return false;
+    }
+
+    if (std::is_integral<T>::value) {
+      v = static_cast<T>(getInteger(*node));
+    } else {
+      v = static_cast<T>(getReal(*node));
+    }
+
+    return true;
+  }
+
+  std::string m_text;
+  std::vector<Node> m_nodes;
+  std::vector<Scope> m_scopes;
+};
+
+}
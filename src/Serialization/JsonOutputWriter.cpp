@@ -0,0 +1,181 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "JsonOutputWriter.h"
+#include <cassert>
+#include <cstdio>
+#include "Common/StringTools.h"
+
+using namespace CryptoNote;
+
+JsonOutputWriter::JsonOutputWriter(std::string& out) : m_out(out) {
+  m_out += '{';
+  m_scopes.push_back({ false, true });
+}
+
+JsonOutputWriter::~JsonOutputWriter() {
+}
+
+ISerializer::SerializerType JsonOutputWriter::type() const {
+  return ISerializer::OUTPUT;
+}
+
+void JsonOutputWriter::end() {
+  assert(m_scopes.size() == 1);
+  m_scopes.pop_back();
+  m_out += '}';
+}
+
+void JsonOutputWriter::writeName(Common::StringView name) {
+  assert(!m_scopes.empty());
+  Scope& scope = m_scopes.back();
+  if (!scope.empty) {
+    m_out += ',';
+  }
+
+  scope.empty = false;
+  if (!scope.isArray) {
+    m_out += '"';
+    m_out.append(name.getData(), name.getSize());
+    m_out += "\":";
+  }
+}
+
+void JsonOutputWriter::writeInteger(int64_t value) {
+  char buffer[24];
+  char* end = buffer + sizeof(buffer);
+  char* p = end;
+  uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+  do {
+    *--p = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+
+  if (value < 0) {
+    *--p = '-';
+  }
+
+  m_out.append(p, end);
+}
+
+bool JsonOutputWriter::beginObject(Common::StringView name) {
+  writeName(name);
+  m_out += '{';
+  m_scopes.push_back({ false, true });
+  return true;
+}
+
+void JsonOutputWriter::endObject() {
+  assert(m_scopes.size() > 1 && !m_scopes.back().isArray);
+  m_scopes.pop_back();
+  m_out += '}';
+}
+
+bool JsonOutputWriter::beginArray(size_t& size, Common::StringView name) {
+  writeName(name);
+  m_out += '[';
+  m_scopes.push_back({ true, true });
+  return true;
+}
+
+void JsonOutputWriter::endArray() {
+  assert(m_scopes.size() > 1 && m_scopes.back().isArray);
+  m_scopes.pop_back();
+  m_out += ']';
+}
+
+bool JsonOutputWriter::operator()(uint8_t& value, Common::StringView name) {
+  int64_t v = static_cast<int64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputWriter::operator()(int16_t& value, Common::StringView name) {
+  int64_t v = static_cast<int64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputWriter::operator()(uint16_t& value, Common::StringView name) {
+  int64_t v = static_cast<int64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputWriter::operator()(int32_t& value, Common::StringView name) {
+  int64_t v = static_cast<int64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputWriter::operator()(uint32_t& value, Common::StringView name) {
+  int64_t v = static_cast<int64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputWriter::operator()(uint64_t& value, Common::StringView name) {
+  // same as JsonOutputStreamSerializer, JsonValue has no unsigned integers
+  int64_t v = static_cast<int64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputWriter::operator()(int64_t& value, Common::StringView name) {
+  writeName(name);
+  writeInteger(value);
+  return true;
+}
+
+bool JsonOutputWriter::operator()(double& value, Common::StringView name) {
+  writeName(name);
+
+  // fixed with 11 digits and trailing zeros cut, the way JsonValue prints reals
+  char buffer[352];
+  int length = snprintf(buffer, sizeof(buffer), "%.11f", value);
+  if (length <= 0 || static_cast<size_t>(length) >= sizeof(buffer)) {
+    m_out += '0';
+    return true;
+  }
+
+  while (length > 1 && buffer[length - 2] != '.' && buffer[length - 1] == '0') {
+    --length;
+  }
+
+  m_out.append(buffer, length);
+  return true;
+}
+
+bool JsonOutputWriter::operator()(bool& value, Common::StringView name) {
+  writeName(name);
+  m_out += value ? "true" : "false";
+  return true;
+}
+
+bool JsonOutputWriter::operator()(std::string& value, Common::StringView name) {
+  writeName(name);
+  m_out += '"';
+  m_out += value;
+  m_out += '"';
+  return true;
+}
+
+bool JsonOutputWriter::binary(void* value, size_t size, Common::StringView name) {
+  writeName(name);
+  m_out += '"';
+  Common::toHex(value, size, m_out);
+  m_out += '"';
+  return true;
+}
+
+bool JsonOutputWriter::binary(std::string& value, Common::StringView name) {
+  return binary(const_cast<char*>(value.data()), value.size(), name);
+}
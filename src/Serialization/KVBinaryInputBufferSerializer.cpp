@@ -0,0 +1,397 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "KVBinaryInputBufferSerializer.h"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#include "KVBinaryCommon.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+size_t podSize(uint8_t type) {
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_INT64:
+  case BIN_KV_SERIALIZE_TYPE_UINT64:
+  case BIN_KV_SERIALIZE_TYPE_DOUBLE:
+    return 8;
+  case BIN_KV_SERIALIZE_TYPE_INT32:
+  case BIN_KV_SERIALIZE_TYPE_UINT32:
+    return 4;
+  case BIN_KV_SERIALIZE_TYPE_INT16:
+  case BIN_KV_SERIALIZE_TYPE_UINT16:
+    return 2;
+  case BIN_KV_SERIALIZE_TYPE_INT8:
+  case BIN_KV_SERIALIZE_TYPE_UINT8:
+  case BIN_KV_SERIALIZE_TYPE_BOOL:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+template <typename T>
+T loadPod(const uint8_t* data) {
+  T value;
+  memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+}
+
+KVBinaryInputBufferSerializer::KVBinaryInputBufferSerializer(const void* data, size_t size) :
+  m_end(static_cast<const uint8_t*>(data) + size) {
+  const uint8_t* position = static_cast<const uint8_t*>(data);
+  auto hdr = loadPod<KVBinaryStorageBlockHeader>(readBytes(position, sizeof(KVBinaryStorageBlockHeader)));
+
+  if (
+    hdr.m_signature_a != PORTABLE_STORAGE_SIGNATUREA ||
+    hdr.m_signature_b != PORTABLE_STORAGE_SIGNATUREB) {
+    throw std::runtime_error("Invalid binary storage signature");
+  }
+
+  if (hdr.m_ver != PORTABLE_STORAGE_FORMAT_VER) {
+    throw std::runtime_error("Unknown binary storage format version");
+  }
+
+  size_t count = readSize(position);
+  m_levels.push_back(Level{ false, 0, position, position, 0, count });
+}
+
+ISerializer::SerializerType KVBinaryInputBufferSerializer::type() const {
+  return ISerializer::INPUT;
+}
+
+bool KVBinaryInputBufferSerializer::beginObject(Common::StringView name) {
+  uint8_t type;
+  const uint8_t* position;
+  if (!findValue(name, type, position)) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_OBJECT) {
+    throw std::runtime_error("Binary storage object expected");
+  }
+
+  size_t count = readSize(position);
+  m_levels.push_back(Level{ false, 0, position, position, 0, count });
+  return true;
+}
+
+void KVBinaryInputBufferSerializer::endObject() {
+  assert(m_levels.size() > 1);
+
+  const Level& level = m_levels.back();
+  const uint8_t* position = level.cursor;
+  skipEntries(position, level.count - level.index);
+  m_levels.pop_back();
+  setCursor(position);
+}
+
+bool KVBinaryInputBufferSerializer::beginArray(size_t& size, Common::StringView name) {
+  if (m_levels.back().isArray) {
+    throw std::runtime_error("Nested arrays are not supported by binary storage");
+  }
+
+  uint8_t type;
+  const uint8_t* position;
+  if (!findValue(name, type, position)) {
+    size = 0;
+    return false;
+  }
+
+  if ((type & BIN_KV_SERIALIZE_FLAG_ARRAY) == 0) {
+    throw std::runtime_error("Binary storage array expected");
+  }
+
+  size = readSize(position);
+  m_levels.push_back(Level{ true, static_cast<uint8_t>(type & ~BIN_KV_SERIALIZE_FLAG_ARRAY), position, position, 0, size });
+  return true;
+}
+
+void KVBinaryInputBufferSerializer::endArray() {
+  assert(m_levels.size() > 1 && m_levels.back().isArray);
+
+  const Level& level = m_levels.back();
+  const uint8_t* position = level.cursor;
+  for (size_t i = level.index; i < level.count; ++i) {
+    skipValue(position, level.itemType);
+  }
+
+  m_levels.pop_back();
+  setCursor(position);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(uint8_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(int16_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(uint16_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(int32_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(uint32_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(int64_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(uint64_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(double& value, Common::StringView name) {
+  uint8_t type;
+  const uint8_t* position;
+  if (!findValue(name, type, position)) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_DOUBLE) {
+    throw std::runtime_error("Binary storage double expected");
+  }
+
+  value = loadPod<double>(readBytes(position, sizeof(double)));
+  setCursor(position);
+  return true;
+}
+
+bool KVBinaryInputBufferSerializer::operator()(bool& value, Common::StringView name) {
+  uint8_t type;
+  const uint8_t* position;
+  if (!findValue(name, type, position)) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_BOOL) {
+    throw std::runtime_error("Binary storage bool expected");
+  }
+
+  value = readByte(position) != 0;
+  setCursor(position);
+  return true;
+}
+
+bool KVBinaryInputBufferSerializer::operator()(std::string& value, Common::StringView name) {
+  uint8_t type;
+  const uint8_t* position;
+  if (!findValue(name, type, position)) {
+    return false;
+  }
+
+  size_t size = readStringSize(position, type);
+  const uint8_t* data = readBytes(position, size);
+  value.assign(reinterpret_cast<const char*>(data), size);
+  setCursor(position);
+  return true;
+}
+
+bool KVBinaryInputBufferSerializer::binary(void* value, size_t size, Common::StringView name) {
+  uint8_t type;
+  const uint8_t* position;
+  if (!findValue(name, type, position)) {
+    return false;
+  }
+
+  if (readStringSize(position, type) != size) {
+    throw std::runtime_error("Binary block size mismatch");
+  }
+
+  memcpy(value, readBytes(position, size), size);
+  setCursor(position);
+  return true;
+}
+
+bool KVBinaryInputBufferSerializer::binary(std::string& value, Common::StringView name) {
+  return (*this)(value, name); // load as string
+}
+
+bool KVBinaryInputBufferSerializer::findValue(Common::StringView name, uint8_t& type, const uint8_t*& value) {
+  Level& level = m_levels.back();
+  if (level.isArray) {
+    if (level.index == level.count) {
+      throw std::runtime_error("Binary storage array is shorter than read");
+    }
+
+    type = level.itemType;
+    value = level.cursor;
+    ++level.index;
+    return true;
+  }
+
+  // the entries are usually read in the stored order, so the search starts after the last read one
+  const uint8_t* position = level.cursor;
+  size_t index = level.index;
+  for (size_t visited = 0; visited < level.count; ++visited) {
+    if (index == level.count) {
+      position = level.begin;
+      index = 0;
+    }
+
+    size_t nameSize = readByte(position);
+    const uint8_t* entryName = readBytes(position, nameSize);
+    uint8_t entryType = readByte(position);
+    ++index;
+
+    if (nameSize == name.getSize() && memcmp(entryName, name.getData(), nameSize) == 0) {
+      type = entryType;
+      value = position;
+      level.cursor = position;
+      level.index = index;
+      return true;
+    }
+
+    skipValue(position, entryType);
+  }
+
+  return false;
+}
+
+void KVBinaryInputBufferSerializer::setCursor(const uint8_t* position) {
+  m_levels.back().cursor = position;
+}
+
+uint8_t KVBinaryInputBufferSerializer::readByte(const uint8_t*& position) const {
+  return *readBytes(position, 1);
+}
+
+const uint8_t* KVBinaryInputBufferSerializer::readBytes(const uint8_t*& position, size_t size) const {
+  if (size > static_cast<size_t>(m_end - position)) {
+    throw std::runtime_error("Unexpected end of binary storage");
+  }
+
+  const uint8_t* data = position;
+  position += size;
+  return data;
+}
+
+size_t KVBinaryInputBufferSerializer::readSize(const uint8_t*& position) const {
+  uint8_t b = readByte(position);
+  size_t bytesLeft = 0;
+
+  switch (b & PORTABLE_RAW_SIZE_MARK_MASK) {
+  case PORTABLE_RAW_SIZE_MARK_BYTE:
+    bytesLeft = 0;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_WORD:
+    bytesLeft = 1;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_DWORD:
+    bytesLeft = 3;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_INT64:
+    bytesLeft = 7;
+    break;
+  }
+
+  uint64_t value = b;
+  const uint8_t* data = readBytes(position, bytesLeft);
+  for (size_t i = 0; i < bytesLeft; ++i) {
+    value |= static_cast<uint64_t>(data[i]) << ((i + 1) * 8);
+  }
+
+  return static_cast<size_t>(value >> 2);
+}
+
+int64_t KVBinaryInputBufferSerializer::readInteger(const uint8_t*& position, uint8_t type) const {
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_INT64:  return loadPod<int64_t>(readBytes(position, 8));
+  case BIN_KV_SERIALIZE_TYPE_INT32:  return loadPod<int32_t>(readBytes(position, 4));
+  case BIN_KV_SERIALIZE_TYPE_INT16:  return loadPod<int16_t>(readBytes(position, 2));
+  case BIN_KV_SERIALIZE_TYPE_INT8:   return loadPod<int8_t>(readBytes(position, 1));
+  case BIN_KV_SERIALIZE_TYPE_UINT64: return static_cast<int64_t>(loadPod<uint64_t>(readBytes(position, 8)));
+  case BIN_KV_SERIALIZE_TYPE_UINT32: return loadPod<uint32_t>(readBytes(position, 4));
+  case BIN_KV_SERIALIZE_TYPE_UINT16: return loadPod<uint16_t>(readBytes(position, 2));
+  case BIN_KV_SERIALIZE_TYPE_UINT8:  return readByte(position);
+  default:
+    throw std::runtime_error("Binary storage integer expected");
+  }
+}
+
+size_t KVBinaryInputBufferSerializer::readStringSize(const uint8_t*& position, uint8_t type) const {
+  if (type != BIN_KV_SERIALIZE_TYPE_STRING) {
+    throw std::runtime_error("Binary storage string expected");
+  }
+
+  return readSize(position);
+}
+
+void KVBinaryInputBufferSerializer::skipValue(const uint8_t*& position, uint8_t type) const {
+  if (type & BIN_KV_SERIALIZE_FLAG_ARRAY) {
+    uint8_t itemType = type & ~BIN_KV_SERIALIZE_FLAG_ARRAY;
+    size_t count = readSize(position);
+    size_t itemSize = podSize(itemType);
+    if (itemSize != 0) {
+      if (count > static_cast<size_t>(m_end - position) / itemSize) {
+        throw std::runtime_error("Unexpected end of binary storage");
+      }
+
+      position += count * itemSize;
+      return;
+    }
+
+    while (count--) {
+      skipValue(position, itemType);
+    }
+
+    return;
+  }
+
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_STRING: {
+    size_t size = readSize(position);
+    readBytes(position, size);
+    break;
+  }
+  case BIN_KV_SERIALIZE_TYPE_OBJECT: {
+    size_t count = readSize(position);
+    skipEntries(position, count);
+    break;
+  }
+  default:
+    if (podSize(type) == 0) {
+      throw std::runtime_error("Unknown data type");
+    }
+
+    readBytes(position, podSize(type));
+    break;
+  }
+}
+
+void KVBinaryInputBufferSerializer::skipEntries(const uint8_t*& position, size_t count) const {
+  while (count--) {
+    size_t nameSize = readByte(position);
+    readBytes(position, nameSize);
+    uint8_t type = readByte(position);
+    skipValue(position, type);
+  }
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ISerializer.h"
+
+namespace CryptoNote {
+
+// Reads the key-value binary storage straight from a memory buffer into the
+// serialized objects, without building a JsonValue tree first. Fields are
+// looked up from the position of the last read one, so reading them in the
+// stored order never rescans a section.
+class KVBinaryInputBufferSerializer : public ISerializer {
+public:
+  KVBinaryInputBufferSerializer(const void* data, size_t size);
+
+  SerializerType type() const override;
+
+  virtual bool beginObject(Common::StringView name) override;
+  virtual void endObject() override;
+
+  virtual bool beginArray(size_t& size, Common::StringView name) override;
+  virtual void endArray() override;
+
+  virtual bool operator()(uint8_t& value, Common::StringView name) override;
+  virtual bool operator()(int16_t& value, Common::StringView name) override;
+  virtual bool operator()(uint16_t& value, Common::StringView name) override;
+  virtual bool operator()(int32_t& value, Common::StringView name) override;
+  virtual bool operator()(uint32_t& value, Common::StringView name) override;
+  virtual bool operator()(int64_t& value, Common::StringView name) override;
+  virtual bool operator()(uint64_t& value, Common::StringView name) override;
+  virtual bool operator()(double& value, Common::StringView name) override;
+  virtual bool operator()(bool& value, Common::StringView name) override;
+  virtual bool operator()(std::string& value, Common::StringView name) override;
+  virtual bool binary(void* value, size_t size, Common::StringView name) override;
+  virtual bool binary(std::string& value, Common::StringView name) override;
+
+  template<typename T>
+  bool operator()(T& value, Common::StringView name) {
+    return ISerializer::operator()(value, name);
+  }
+
+private:
+  struct Level {
+    bool isArray;
+    uint8_t itemType;       // of the array elements
+    const uint8_t* begin;   // first entry or element
+    const uint8_t* cursor;  // next entry or element
+    size_t index;           // of the next entry or element
+    size_t count;
+  };
+
+  // positions on the value of the named entry, or on the next array element
+  bool findValue(Common::StringView name, uint8_t& type, const uint8_t*& value);
+  void setCursor(const uint8_t* position);
+
+  uint8_t readByte(const uint8_t*& position) const;
+  const uint8_t* readBytes(const uint8_t*& position, size_t size) const;
+  size_t readSize(const uint8_t*& position) const;
+  int64_t readInteger(const uint8_t*& position, uint8_t type) const;
+  size_t readStringSize(const uint8_t*& position, uint8_t type) const;
+  void skipValue(const uint8_t*& position, uint8_t type) const;
+  void skipEntries(const uint8_t*& position, size_t count) const;
+
+  template <typename T>
+  bool getInteger(Common::StringView name, T& value) {
+    uint8_t type;
+    const uint8_t* position;
+    if (!findValue(name, type, position)) {
+      return false;
+    }
+
+    value = static_cast<T>(readInteger(position, type));
+    setCursor(position);
+    return true;
+  }
+
+  const uint8_t* m_end;
+  std::vector<Level> m_levels;
+};
+
+}
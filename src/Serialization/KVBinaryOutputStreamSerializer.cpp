@@ -70,11 +70,11 @@ size_t writeArraySize(IOutputStream& s, size_t val) {
 namespace CryptoNote {
 
 KVBinaryOutputStreamSerializer::KVBinaryOutputStreamSerializer() {
-  beginObject(std::string());
+  // the root count is written by dump(), ahead of the buffer
+  m_stack.push_back(Level(std::string()));
 }
 
 void KVBinaryOutputStreamSerializer::dump(IOutputStream& target) {
-  assert(m_objectsStack.size() == 1);
   assert(m_stack.size() == 1);
 
   KVBinaryStorageBlockHeader hdr;
@@ -84,7 +84,15 @@ void KVBinaryOutputStreamSerializer::dump(IOutputStream& target) {
 
   Common::write(target, &hdr, sizeof(hdr));
   writeArraySize(target, m_stack.front().count);
-  write(target, stream().data(), stream().size());
+
+  size_t written = 0;
+  for (const CountPatch& patch : m_patches) {
+    write(target, m_buffer.data() + written, patch.offset - written);
+    writeArraySize(target, patch.count);
+    written = patch.offset;
+  }
+
+  write(target, m_buffer.data() + written, m_buffer.size() - written);
 }
 
 ISerializer::SerializerType KVBinaryOutputStreamSerializer::type() const {
@@ -92,29 +100,20 @@ ISerializer::SerializerType KVBinaryOutputStreamSerializer::type() const {
 }
 
 bool KVBinaryOutputStreamSerializer::beginObject(Common::StringView name) {
-  checkArrayPreamble(BIN_KV_SERIALIZE_TYPE_OBJECT);
- 
+  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_OBJECT, name);
+
   m_stack.push_back(Level(name));
-  m_objectsStack.push_back(MemoryStream());
+  m_stack.back().patch = m_patches.size();
+  m_patches.push_back(CountPatch{ m_buffer.size(), 0 });
 
   return true;
 }
 
 void KVBinaryOutputStreamSerializer::endObject() {
-  assert(m_objectsStack.size());
+  assert(m_stack.size() > 1);
 
-  auto level = std::move(m_stack.back());
+  m_patches[m_stack.back().patch].count = m_stack.back().count;
   m_stack.pop_back();
-
-  auto objStream = std::move(m_objectsStack.back());
-  m_objectsStack.pop_back();
-
-  auto& out = stream();
-
-  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_OBJECT, level.name);
-
-  writeArraySize(out, level.count);
-  write(out, objStream.data(), objStream.size());
 }
 
 bool KVBinaryOutputStreamSerializer::beginArray(size_t& size, Common::StringView name) {
@@ -243,8 +242,7 @@ void KVBinaryOutputStreamSerializer::checkArrayPreamble(uint8_t type) {
 
 
 MemoryStream& KVBinaryOutputStreamSerializer::stream() {
-  assert(m_objectsStack.size());
-  return m_objectsStack.back();
+  return m_buffer;
 }
 
 }
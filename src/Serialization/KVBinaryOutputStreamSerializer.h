@@ -76,22 +76,33 @@ private:
     State state;
     std::string name;
     size_t count;
+    size_t patch; // of an object, where its count goes
 
     Level(Common::StringView nm) :
-      name(nm), state(State::Object), count(0) {}
+      name(nm), state(State::Object), count(0), patch(0) {}
 
     Level(Common::StringView nm, size_t arraySize) :
-      name(nm), state(State::ArrayPrefix), count(arraySize) {}
+      name(nm), state(State::ArrayPrefix), count(arraySize), patch(0) {}
 
     Level(Level&& rv) {
       state = rv.state;
       name = std::move(rv.name);
       count = rv.count;
+      patch = rv.patch;
     }
 
   };
 
-  std::vector<MemoryStream> m_objectsStack;
+  // The count of an object is known only at its end, after the members. All
+  // objects are written to one buffer without their counts, which dump()
+  // inserts at the recorded offsets, so nested objects are never copied.
+  struct CountPatch {
+    size_t offset;
+    size_t count;
+  };
+
+  MemoryStream m_buffer;
+  std::vector<CountPatch> m_patches; // ordered by offset
   std::vector<Level> m_stack;
 };
 
@@ -36,10 +36,16 @@
 #include <parallel_hashmap/phmap.h>
 
 using phmap::flat_hash_map;
+using phmap::flat_hash_set;
 using phmap::parallel_flat_hash_map;
 
 namespace CryptoNote {
 
+// Types serialized as one binary block of their size, arrays of them can be
+// read and written in one go by the serializers that support binaryItems().
+template<typename T>
+struct IsBinaryBlock : std::false_type {};
+
 template<typename T>
 typename std::enable_if<std::is_pod<T>::value>::type
 serializeAsBinary(std::vector<T>& value, Common::StringView name, CryptoNote::ISerializer& serializer) {
@@ -136,10 +142,35 @@ bool serializeEnumClass(E& value, Common::StringView name, CryptoNote::ISerializ
 }
 
 template<typename T>
-bool serialize(std::vector<T>& value, Common::StringView name, CryptoNote::ISerializer& serializer) {
+typename std::enable_if<!IsBinaryBlock<T>::value, bool>::type
+serialize(std::vector<T>& value, Common::StringView name, CryptoNote::ISerializer& serializer) {
   return serializeContainer(value, name, serializer);
 }
 
+template<typename T>
+typename std::enable_if<IsBinaryBlock<T>::value, bool>::type
+serialize(std::vector<T>& value, Common::StringView name, CryptoNote::ISerializer& serializer) {
+  size_t size = value.size();
+  if (!serializer.beginArray(size, name)) {
+    if (serializer.type() == ISerializer::INPUT) {
+      value.clear();
+    }
+
+    return false;
+  }
+
+  value.resize(size);
+
+  if (size != 0 && !serializer.binaryItems(value.data(), sizeof(T), size)) {
+    for (auto& item : value) {
+      serializer(item, "");
+    }
+  }
+
+  serializer.endArray();
+  return true;
+}
+
 template<typename T>
 bool serialize(std::list<T>& value, Common::StringView name, CryptoNote::ISerializer& serializer) {
   return serializeContainer(value, name, serializer);
@@ -222,6 +253,11 @@ bool serialize(std::set<K, Cmp>& value, Common::StringView name, CryptoNote::ISe
   return serializeSet(value, name, serializer);
 }
 
+template<typename K, typename Hash>
+bool serialize(flat_hash_set<K, Hash>& value, Common::StringView name, CryptoNote::ISerializer& serializer) {
+  return serializeSet(value, name, serializer);
+}
+
 template<typename K, typename V, typename Hash>
 bool serialize(std::unordered_map<K, V, Hash>& value, Common::StringView name, CryptoNote::ISerializer& serializer) {
   return serializeMap(value, name, serializer, [&value](size_t size) { value.reserve(size); });
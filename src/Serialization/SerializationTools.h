@@ -22,8 +22,11 @@
 #include <vector>
 #include <Common/MemoryInputStream.h>
 #include <Common/StringOutputStream.h>
+#include "JsonInputReader.h"
 #include "JsonInputStreamSerializer.h"
 #include "JsonOutputStreamSerializer.h"
+#include "JsonOutputWriter.h"
+#include "KVBinaryInputBufferSerializer.h"
 #include "KVBinaryInputStreamSerializer.h"
 #include "KVBinaryOutputStreamSerializer.h"
 #include "GreenWallet/Types.h"
@@ -114,11 +117,53 @@ void loadFromJsonValue(std::list<T>& v, const Common::JsonValue& js) {
 
 template <typename T>
 std::string storeToJson(const T& v) {
-  return storeToJsonValue(v).toString();
+  std::string json;
+  JsonOutputWriter s(json);
+  serialize(const_cast<T&>(v), s);
+  s.end();
+  return json;
 }
 
+// top level containers and strings aren't objects, these still go through JsonValue
+template <typename T>
+std::string storeToJson(const std::vector<T>& v) { return storeToJsonValue(v).toString(); }
+
+template <typename T>
+std::string storeToJson(const std::list<T>& v) { return storeToJsonValue(v).toString(); }
+
+inline std::string storeToJson(const std::string& v) { return storeToJsonValue(v).toString(); }
+
 template <typename T>
 bool loadFromJson(T& v, const std::string& buf) {
+  try {
+    if (buf.empty()) {
+      return true;
+    }
+    JsonInputReader s(buf);
+    serialize(v, s);
+  } catch (std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+// top level arrays aren't objects, these still go through JsonValue
+template <typename T>
+bool loadFromJson(std::vector<T>& v, const std::string& buf) {
+  try {
+    if (buf.empty()) {
+      return true;
+    }
+    auto js = Common::JsonValue::fromString(buf);
+    loadFromJsonValue(v, js);
+  } catch (std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+template <typename T>
+bool loadFromJson(std::list<T>& v, const std::string& buf) {
   try {
     if (buf.empty()) {
       return true;
@@ -145,8 +190,7 @@ std::string storeToBinaryKeyValue(const T& v) {
 template <typename T>
 bool loadFromBinaryKeyValue(T& v, const std::string& buf) {
   try {
-    Common::MemoryInputStream stream(buf.data(), buf.size());
-    KVBinaryInputStreamSerializer s(stream);
+    KVBinaryInputBufferSerializer s(buf.data(), buf.size());
     serialize(v, s);
     return true;
   } catch (std::exception&) {
@@ -24,6 +24,8 @@ namespace System {
 class ContextGroup {
 public:
   explicit ContextGroup(Dispatcher& dispatcher);
+  // contexts of the group run on stacks of the given size, 0 selects the dispatcher default
+  ContextGroup(Dispatcher& dispatcher, size_t stackSize);
   ContextGroup(const ContextGroup&) = delete;
   ContextGroup(ContextGroup&& other);
   ~ContextGroup();
@@ -35,6 +37,7 @@ public:
 
 private:
   Dispatcher* dispatcher;
+  size_t stackSize;
   NativeContextGroup contextGroup;
 };
 
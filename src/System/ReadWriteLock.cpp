@@ -0,0 +1,78 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ReadWriteLock.h"
+
+#include <cassert>
+
+namespace System {
+
+ReadWriteLock::ReadWriteLock(Dispatcher& dispatcher) : released(dispatcher), readers(0), writing(false) {
+}
+
+void ReadWriteLock::lockShared() {
+  while (writing) {
+    released.wait();
+  }
+
+  ++readers;
+}
+
+void ReadWriteLock::unlockShared() {
+  assert(readers > 0);
+  if (--readers == 0) {
+    notify();
+  }
+}
+
+void ReadWriteLock::lock() {
+  while (writing || readers != 0) {
+    released.wait();
+  }
+
+  writing = true;
+}
+
+void ReadWriteLock::unlock() {
+  assert(writing);
+  writing = false;
+  notify();
+}
+
+// every waiter is resumed and checks the lock again
+void ReadWriteLock::notify() {
+  released.set();
+  released.clear();
+}
+
+SharedLock::SharedLock(ReadWriteLock& lock) : lock(lock) {
+  lock.lockShared();
+}
+
+SharedLock::~SharedLock() {
+  lock.unlockShared();
+}
+
+ExclusiveLock::ExclusiveLock(ReadWriteLock& lock) : lock(lock) {
+  lock.lock();
+}
+
+ExclusiveLock::~ExclusiveLock() {
+  lock.unlock();
+}
+
+}
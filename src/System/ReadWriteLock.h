@@ -0,0 +1,70 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+
+#include <System/Event.h>
+
+namespace System {
+
+class Dispatcher;
+
+// Lock of the contexts of one dispatcher, held by any number of readers or by one writer.
+// Readers aren't held back by a waiting writer: they rarely yield, so the lock is free
+// again by the time the writer gets to run.
+class ReadWriteLock {
+public:
+  explicit ReadWriteLock(Dispatcher& dispatcher);
+  ReadWriteLock(const ReadWriteLock&) = delete;
+  ReadWriteLock& operator=(const ReadWriteLock&) = delete;
+
+  void lockShared();
+  void unlockShared();
+  void lock();
+  void unlock();
+
+private:
+  void notify();
+
+  Event released;
+  size_t readers;
+  bool writing;
+};
+
+class SharedLock {
+public:
+  explicit SharedLock(ReadWriteLock& lock);
+  ~SharedLock();
+  SharedLock& operator=(const SharedLock&) = delete;
+
+private:
+  ReadWriteLock& lock;
+};
+
+class ExclusiveLock {
+public:
+  explicit ExclusiveLock(ReadWriteLock& lock);
+  ~ExclusiveLock();
+  ExclusiveLock& operator=(const ExclusiveLock&) = delete;
+
+private:
+  ReadWriteLock& lock;
+};
+
+}
@@ -22,6 +22,7 @@
 #include <System/Event.h>
 #include <System/Future.h>
 #include <System/InterruptedException.h>
+#include <System/ThreadPool.h>
 
 namespace System {
 
@@ -32,6 +33,11 @@ public:
       : dispatcher(d), event(d), procedure(std::move(operation)), future(System::Detail::async<T>([this] { return asyncProcedure(); })), interrupted(false) {
   }
 
+  // Execute operation on a pool thread, continue execution of current context.
+  RemoteContext(Dispatcher& d, ThreadPool& pool, std::function<T()>&& operation)
+      : dispatcher(d), event(d), procedure(std::move(operation)), future(post(pool)), interrupted(false) {
+  }
+
   // Run other task on dispatcher until future is ready, then return lambda's result, or rethrow exception. UB if called more than once.
   T get() const {
     wait();
@@ -85,6 +91,13 @@ private:
     Event& event;
   };
 
+  System::Detail::Future<T> post(ThreadPool& pool) {
+    auto task = std::make_shared<std::packaged_task<T()>>([this] { return asyncProcedure(); });
+    System::Detail::Future<T> result = task->get_future();
+    pool.post([task] { (*task)(); });
+    return result;
+  }
+
   // This function is executed in future object
   T asyncProcedure() {
     NotifyOnDestruction guard(dispatcher, event);
@@ -0,0 +1,93 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "RemoteSpawnQueue.h"
+
+namespace System {
+
+RemoteSpawnQueue::RemoteSpawnQueue() : cells(new Cell[CAPACITY]), enqueuePosition(0), dequeuePosition(0), signalled(false), overflowing(false) {
+  for (size_t i = 0; i < CAPACITY; ++i) {
+    cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+bool RemoteSpawnQueue::push(std::function<void()>&& procedure) {
+  bool queued = false;
+  if (!overflowing.load(std::memory_order_acquire)) {
+    size_t position = enqueuePosition.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells[position % CAPACITY];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      if (sequence == position) {
+        if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          cell.procedure = std::move(procedure);
+          cell.sequence.store(position + 1, std::memory_order_release);
+          queued = true;
+          break;
+        }
+      } else if (sequence < position) {
+        break; // full
+      } else {
+        position = enqueuePosition.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  if (!queued) {
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    overflow.push_back(std::move(procedure));
+    overflowing.store(true, std::memory_order_release);
+  }
+
+  return !signalled.exchange(true);
+}
+
+void RemoteSpawnQueue::rearm() {
+  signalled.store(false);
+}
+
+bool RemoteSpawnQueue::pop(std::function<void()>& procedure) {
+  Cell& cell = cells[dequeuePosition % CAPACITY];
+  if (cell.sequence.load(std::memory_order_acquire) == dequeuePosition + 1) {
+    procedure = std::move(cell.procedure);
+    cell.procedure = nullptr;
+    cell.sequence.store(dequeuePosition + CAPACITY, std::memory_order_release);
+    ++dequeuePosition;
+    return true;
+  }
+
+  // a producer still filling the next cell wakes the consumer again once it is done, the
+  // overflow is taken only behind a drained ring so that it never overtakes earlier posts
+  if (enqueuePosition.load(std::memory_order_acquire) != dequeuePosition || !overflowing.load(std::memory_order_acquire)) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(overflowMutex);
+  if (overflow.empty()) {
+    return false;
+  }
+
+  procedure = std::move(overflow.front());
+  overflow.pop_front();
+  if (overflow.empty()) {
+    overflowing.store(false, std::memory_order_release);
+  }
+
+  return true;
+}
+
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace System {
+
+// Procedures posted to a dispatcher from other threads. Producers claim a cell of a fixed
+// ring with a compare-and-swap and move the procedure in place, so posting neither locks nor
+// allocates a queue node. When the ring is full, posts go to a locked overflow list until the
+// consumer empties it, which keeps the order of each producer. Only the dispatcher thread pops.
+class RemoteSpawnQueue {
+public:
+  static const size_t CAPACITY = 1024;
+
+  RemoteSpawnQueue();
+  RemoteSpawnQueue(const RemoteSpawnQueue&) = delete;
+  RemoteSpawnQueue& operator=(const RemoteSpawnQueue&) = delete;
+
+  // true when the consumer has to be woken up, which is only the first push after rearm()
+  bool push(std::function<void()>&& procedure);
+  // called by the consumer before it pops everything, later pushes ask for a new wake up
+  void rearm();
+  bool pop(std::function<void()>& procedure);
+
+private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    std::function<void()> procedure;
+  };
+
+  std::unique_ptr<Cell[]> cells;
+  // padding keeps producers and the consumer off each other's cache line; alignas would
+  // need an over-aligned operator new, which C++11 does not have for heap allocated dispatchers
+  char producerPadding[64];
+  std::atomic<size_t> enqueuePosition;
+  char consumerPadding[64];
+  size_t dequeuePosition;
+  std::atomic<bool> signalled;
+  std::atomic<bool> overflowing;
+  std::mutex overflowMutex;
+  std::deque<std::function<void()>> overflow;
+};
+
+}
@@ -0,0 +1,197 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ThreadPool.h"
+
+namespace System {
+
+namespace {
+
+thread_local ThreadPool* currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+
+}
+
+ThreadPool::ThreadPool(size_t threadCount) : nextWorker(0), pendingTasks(0), stopped(false) {
+  if (threadCount == 0) {
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  for (size_t i = 0; i < threadCount; ++i) {
+    workers.emplace_back(new Worker);
+  }
+
+  for (size_t i = 0; i < threadCount; ++i) {
+    threads.emplace_back(&ThreadPool::workerProcedure, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    stopped = true;
+  }
+
+  wakeUp.notify_all();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+ThreadPool& ThreadPool::shared() {
+  static ThreadPool pool;
+  return pool;
+}
+
+size_t ThreadPool::size() const {
+  return workers.size();
+}
+
+void ThreadPool::post(std::function<void()>&& task) {
+  size_t index = currentPool == this ? currentWorker : nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+  {
+    Worker& worker = *workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tasks.push_back(std::move(task));
+    ++pendingTasks;
+  }
+
+  // taking the lock orders the increment before a worker checks it and goes to sleep
+  { std::lock_guard<std::mutex> lock(sleepMutex); }
+  wakeUp.notify_one();
+}
+
+bool ThreadPool::runPendingTask() {
+  std::function<void()> task;
+  if (!takeTask(currentPool == this ? currentWorker : 0, task)) {
+    return false;
+  }
+
+  task();
+  return true;
+}
+
+bool ThreadPool::takeTask(size_t first, std::function<void()>& task) {
+  if (pendingTasks.load() == 0) {
+    return false;
+  }
+
+  for (size_t i = 0; i < workers.size(); ++i) {
+    Worker& worker = *workers[(first + i) % workers.size()];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (!worker.tasks.empty()) {
+      // own tasks newest first while they are still in cache, stolen ones oldest first
+      if (i == 0 && currentPool == this) {
+        task = std::move(worker.tasks.back());
+        worker.tasks.pop_back();
+      } else {
+        task = std::move(worker.tasks.front());
+        worker.tasks.pop_front();
+      }
+
+      --pendingTasks;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ThreadPool::workerProcedure(size_t index) {
+  currentPool = this;
+  currentWorker = index;
+  for (;;) {
+    std::function<void()> task;
+    if (takeTask(index, task)) {
+      task();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    wakeUp.wait(lock, [this] { return stopped || pendingTasks.load() != 0; });
+    if (stopped && pendingTasks.load() == 0) {
+      break;
+    }
+  }
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool) : pool(pool), pending(0) {
+}
+
+TaskGroup::~TaskGroup() {
+  try {
+    wait();
+  } catch (std::exception&) {
+  }
+}
+
+void TaskGroup::run(std::function<void()>&& task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++pending;
+  }
+
+  auto procedure = std::make_shared<std::function<void()>>(std::move(task));
+  pool.post([this, procedure]() mutable {
+    std::exception_ptr exception;
+    try {
+      (*procedure)();
+    } catch (...) {
+      exception = std::current_exception();
+    }
+
+    // the group may be destroyed as soon as pending drops to zero
+    procedure.reset();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (exception && !error) {
+      error = exception;
+    }
+
+    if (--pending == 0) {
+      finished.notify_all();
+    }
+  });
+}
+
+void TaskGroup::wait() {
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      if (pending == 0) {
+        break;
+      }
+    }
+
+    if (!pool.runPendingTask()) {
+      // everything left is already running, nested groups help on their own threads
+      std::unique_lock<std::mutex> lock(mutex);
+      finished.wait(lock, [this] { return pending == 0; });
+    }
+  }
+
+  std::exception_ptr exception;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::swap(exception, error);
+  }
+
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+}
@@ -0,0 +1,134 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace System {
+
+// Fixed set of worker threads for CPU bound work. Every worker owns a deque: tasks posted from
+// a worker go to the back of its own deque and are taken from there, idle workers steal from
+// the front of the others. Tasks posted from other threads are spread over the deques in turn.
+// Posted tasks must not throw, use TaskGroup or RemoteContext to get exceptions back.
+class ThreadPool {
+public:
+  // 0 means one thread per hardware thread
+  explicit ThreadPool(size_t threadCount = 0);
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  // runs what is still queued, then joins the workers
+  ~ThreadPool();
+
+  // pool shared by the whole process, started on first use
+  static ThreadPool& shared();
+
+  size_t size() const;
+  void post(std::function<void()>&& task);
+  // runs one queued task on the calling thread, false when there was nothing to take
+  bool runPendingTask();
+
+private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  bool takeTask(size_t first, std::function<void()>& task);
+  void workerProcedure(size_t index);
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<std::thread> threads;
+  std::atomic<size_t> nextWorker;
+  std::atomic<size_t> pendingTasks;
+  std::mutex sleepMutex;
+  std::condition_variable wakeUp;
+  bool stopped;
+};
+
+// Fork/join over a pool. wait() runs queued tasks on the calling thread while the group is
+// not finished, so groups can be nested inside pool tasks, and rethrows the first exception
+// thrown by a task of the group.
+class TaskGroup {
+public:
+  explicit TaskGroup(ThreadPool& pool = ThreadPool::shared());
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+  // waits for the tasks, an exception is dropped if wait() was not called
+  ~TaskGroup();
+
+  void run(std::function<void()>&& task);
+  void wait();
+
+private:
+  ThreadPool& pool;
+  std::mutex mutex;
+  std::condition_variable finished;
+  size_t pending;
+  std::exception_ptr error;
+};
+
+// Calls procedure(index) for every index in [begin, end), split into a few chunks per
+// pool thread but at least grain indices each. The calling thread takes part and runs the
+// whole range itself when it fits into one chunk. Exceptions are rethrown after all chunks end.
+template<class Procedure> void parallelFor(size_t begin, size_t end, const Procedure& procedure, ThreadPool& pool = ThreadPool::shared(), size_t grain = 1) {
+  if (begin >= end) {
+    return;
+  }
+
+  size_t chunk = std::max(std::max<size_t>(grain, 1), (end - begin + pool.size() * 4 - 1) / (pool.size() * 4));
+  if (end - begin <= chunk) {
+    for (size_t i = begin; i < end; ++i) {
+      procedure(i);
+    }
+
+    return;
+  }
+
+  TaskGroup group(pool);
+  for (size_t first = begin + chunk; first < end; first += chunk) {
+    size_t last = std::min(end, first + chunk);
+    group.run([&procedure, first, last] {
+      for (size_t i = first; i < last; ++i) {
+        procedure(i);
+      }
+    });
+  }
+
+  try {
+    for (size_t i = begin; i < begin + chunk; ++i) {
+      procedure(i);
+    }
+  } catch (...) {
+    group.wait();
+    throw;
+  }
+
+  group.wait();
+}
+
+}
@@ -26,6 +26,7 @@
 
 #include "Common/StreamTools.h"
 #include "Common/StringTools.h"
+#include "CryptoNoteCore/BlockFilter.h"
 #include "CryptoNoteCore/CryptoNoteBasicImpl.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/TransactionApi.h"
@@ -79,7 +80,14 @@ BlockchainSynchronizer::BlockchainSynchronizer(INode& node, Logging::ILogger& lo
   m_node(node),
   m_genesisBlockHash(genesisBlockHash),
   m_currentState(State::stopped),
-  m_futureState(State::stopped) {
+  m_futureState(State::stopped),
+  m_prefetchGeneration(0),
+  m_prefetchQueries(0),
+  m_prefetchPending(false),
+  m_prefetchWarm(false),
+  m_prefetchDepth(1),
+  m_nodeHasFilters(true),
+  m_poolTxConsumersValid(false) {
 }
 
 BlockchainSynchronizer::~BlockchainSynchronizer() {
@@ -97,6 +105,7 @@ void BlockchainSynchronizer::addConsumer(IBlockchainConsumer* consumer) {
   }
 
   m_consumers.insert(std::make_pair(consumer, std::make_shared<SynchronizationState>(m_genesisBlockHash)));
+  m_poolTxConsumersValid = false;
   m_logger(INFO, BRIGHT_WHITE) << "Consumer added, consumer " << consumer << ", count " << m_consumers.size();
 }
 
@@ -110,6 +119,7 @@ bool BlockchainSynchronizer::removeConsumer(IBlockchainConsumer* consumer) {
   }
 
   bool result = m_consumers.erase(consumer) > 0;
+  m_poolTxConsumersValid = false;
   if (result) {
     m_logger(INFO, BRIGHT_WHITE) << "Consumer removed, consumer " << consumer << ", count " << m_consumers.size();
   } else {
@@ -351,6 +361,12 @@ void BlockchainSynchronizer::start() {
     throw std::runtime_error(message);
   }
 
+  {
+    // the consumers may have loaded their pool transactions meanwhile
+    std::unique_lock<std::mutex> lk(m_consumersMutex);
+    m_poolTxConsumersValid = false;
+  }
+
   if (!setFutureStateIf(State::deleteOldTxs, [this] { return m_currentState == State::stopped && m_futureState == State::stopped; })) {
     auto message = "Failed to start: already started";
     m_logger(ERROR, BRIGHT_RED) << message;
@@ -370,6 +386,8 @@ void BlockchainSynchronizer::stop() {
   }
 
   workingThread.reset();
+  resetPrefetch();
+  waitPrefetchQueries();
   m_logger(INFO, BRIGHT_WHITE) << "Stopped";
 }
 
@@ -389,29 +407,67 @@ void BlockchainSynchronizer::poolChanged() {
 }
 //--------------------------- FSM END ------------------------------------
 
-void BlockchainSynchronizer::getPoolUnionAndIntersection(std::unordered_set<Crypto::Hash>& poolUnion, std::unordered_set<Crypto::Hash>& poolIntersection) const {
+void BlockchainSynchronizer::getPoolUnionAndIntersection(std::unordered_set<Crypto::Hash>& poolUnion, std::unordered_set<Crypto::Hash>& poolIntersection) {
   std::unique_lock<std::mutex> lk(m_consumersMutex);
 
-  auto itConsumers = m_consumers.begin();
-  poolUnion = itConsumers->first->getKnownPoolTxIds();
-  poolIntersection = itConsumers->first->getKnownPoolTxIds();
-  ++itConsumers;
+  if (!m_poolTxConsumersValid) {
+    m_poolTxConsumers.clear();
+    for (const auto& consumer : m_consumers) {
+      for (const auto& txId : consumer.first->getKnownPoolTxIds()) {
+        ++m_poolTxConsumers[txId];
+      }
+    }
 
-  for (; itConsumers != m_consumers.end(); ++itConsumers) {
-    const std::unordered_set<Crypto::Hash>& consumerKnownIds = itConsumers->first->getKnownPoolTxIds();
+    m_poolTxConsumersValid = true;
+  }
 
-    poolUnion.insert(consumerKnownIds.begin(), consumerKnownIds.end());
+  poolUnion.clear();
+  poolIntersection.clear();
+  poolUnion.reserve(m_poolTxConsumers.size());
+  for (const auto& tx : m_poolTxConsumers) {
+    poolUnion.insert(tx.first);
+    if (tx.second == m_consumers.size()) {
+      poolIntersection.insert(tx.first);
+    }
+  }
 
-    for (auto itIntersection = poolIntersection.begin(); itIntersection != poolIntersection.end();) {
-      if (consumerKnownIds.count(*itIntersection) == 0) {
-        itIntersection = poolIntersection.erase(itIntersection);
-      } else {
-        ++itIntersection;
+  m_logger(DEBUGGING) << "Pool union size " << poolUnion.size() << ", intersection size " << poolIntersection.size();
+}
+
+///pre: m_consumersMutex is locked
+std::error_code BlockchainSynchronizer::updateConsumerPool(IBlockchainConsumer* consumer, const std::vector<std::unique_ptr<ITransactionReader>>& addedTransactions,
+  const std::vector<Crypto::Hash>& deletedTransactions) {
+  // only the ids the update is about can change in the consumer's set
+  std::unordered_set<Crypto::Hash> changedIds(deletedTransactions.begin(), deletedTransactions.end());
+  for (const auto& tx : addedTransactions) {
+    changedIds.insert(tx->getTransactionHash());
+  }
+
+  const std::unordered_set<Crypto::Hash>& knownIds = consumer->getKnownPoolTxIds();
+  std::vector<std::pair<Crypto::Hash, bool>> known;
+  known.reserve(changedIds.size());
+  for (const auto& txId : changedIds) {
+    known.emplace_back(txId, knownIds.count(txId) != 0);
+  }
+
+  std::error_code ec = consumer->onPoolUpdated(addedTransactions, deletedTransactions);
+
+  if (m_poolTxConsumersValid) {
+    for (const auto& tx : known) {
+      bool isKnown = knownIds.count(tx.first) != 0;
+      if (isKnown && !tx.second) {
+        ++m_poolTxConsumers[tx.first];
+      } else if (!isKnown && tx.second) {
+        auto it = m_poolTxConsumers.find(tx.first);
+        assert(it != m_poolTxConsumers.end());
+        if (--it->second == 0) {
+          m_poolTxConsumers.erase(it);
+        }
       }
     }
   }
 
-  m_logger(DEBUGGING) << "Pool union size " << poolUnion.size() << ", intersection size " << poolIntersection.size();
+  return ec;
 }
 
 BlockchainSynchronizer::GetBlocksRequest BlockchainSynchronizer::getCommonHistory() {
@@ -423,6 +479,17 @@ BlockchainSynchronizer::GetBlocksRequest BlockchainSynchronizer::getCommonHistor
 
   auto shortest = m_consumers.begin();
   auto syncStart = shortest->first->getSyncStart();
+
+  std::shared_ptr<std::vector<Crypto::Hash>> filterItems = std::make_shared<std::vector<Crypto::Hash>>();
+  for (const auto& consumer : m_consumers) {
+    if (!consumer.first->getFilterItems(*filterItems)) {
+      filterItems.reset();
+      break;
+    }
+  }
+
+  request.filterItems = filterItems;
+
   auto it = shortest;
   ++it;
   for (; it != m_consumers.end(); ++it) {
@@ -448,42 +515,209 @@ BlockchainSynchronizer::GetBlocksRequest BlockchainSynchronizer::getCommonHistor
 void BlockchainSynchronizer::startBlockchainSync() {
   m_logger(DEBUGGING) << "Starting blockchain synchronization...";
 
-  GetBlocksResponse response;
-  GetBlocksRequest req = getCommonHistory();
-
   try {
-    if (!req.knownBlocks.empty()) {
-      auto queryBlocksCompleted = std::promise<std::error_code>();
-      auto queryBlocksWaitFuture = queryBlocksCompleted.get_future();
-
-      m_node.queryBlocks(
-        std::move(req.knownBlocks),
-        req.syncStart.timestamp,
-        response.newBlocks,
-        response.startHeight,
-        [&queryBlocksCompleted](std::error_code ec) {
-          auto detachedPromise = std::move(queryBlocksCompleted);
-          detachedPromise.set_value(ec);
-        });
-
-      std::error_code ec = queryBlocksWaitFuture.get();
-
-      if (ec) {
-        m_logger(ERROR, BRIGHT_RED) << "Failed to query blocks: " << ec << ", " << ec.message();
-        setFutureStateIf(State::idle, [this] { return m_futureState != State::stopped; });
-        m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, ec);
-      } else {
-        m_logger(DEBUGGING) << "Blocks received, start index " << response.startHeight << ", count " << response.newBlocks.size();
-        processBlocks(response);
+    if (!isPrefetching()) {
+      GetBlocksRequest req = getCommonHistory();
+      if (req.knownBlocks.empty()) {
+        return;
       }
+
+      startPrefetch(std::move(req));
+    }
+
+    std::shared_ptr<BlocksWindow> window = takeBlocksWindow();
+    if (window->ec) {
+      m_logger(ERROR, BRIGHT_RED) << "Failed to query blocks: " << window->ec << ", " << window->ec.message();
+      resetPrefetch();
+      setFutureStateIf(State::idle, [this] { return m_futureState != State::stopped; });
+      m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, window->ec);
+    } else {
+      m_logger(DEBUGGING) << "Blocks received, start index " << window->response.startHeight << ", count " << window->response.newBlocks.size();
+      processBlocks(window->response);
     }
   } catch (const std::exception& e) {
     m_logger(ERROR, BRIGHT_RED) << "Failed to query and process blocks: " << e.what();
+    resetPrefetch();
     setFutureStateIf(State::idle,  [this] { return m_futureState != State::stopped; });
     m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, std::make_error_code(std::errc::invalid_argument));
   }
 }
 
+//--------------------------- PREFETCH ------------------------------------
+
+// A prefetched window is a continuation of the node's chain as it was when the window was
+// requested, so after a reorganization checkInterval() finds the fork in it and the consumers
+// detach as they would for a window requested from their own history. Windows are only dropped
+// when the previous one didn't reach every consumer.
+
+void BlockchainSynchronizer::startPrefetch(GetBlocksRequest&& request) {
+  std::shared_ptr<BlocksWindow> window = std::make_shared<BlocksWindow>();
+  window->knownBlocks = request.knownBlocks;
+  window->timestamp = request.syncStart.timestamp;
+  window->filterItems = request.filterItems;
+
+  uint32_t generation;
+  {
+    std::unique_lock<std::mutex> lk(m_prefetchMutex);
+    m_prefetchHistory = std::move(request.knownBlocks);
+    m_prefetchPending = true;
+    m_prefetchWarm = false;
+    ++m_prefetchQueries;
+    generation = m_prefetchGeneration;
+  }
+
+  queryBlocksWindow(window, generation);
+}
+
+std::shared_ptr<BlockchainSynchronizer::BlocksWindow> BlockchainSynchronizer::takeBlocksWindow() {
+  std::unique_lock<std::mutex> lk(m_prefetchMutex);
+  if (m_prefetchedWindows.empty()) {
+    if (m_prefetchWarm && m_prefetchDepth < MAX_PREFETCH_DEPTH) {
+      // processing waits for the network, let more windows pile up while the download goes fast
+      ++m_prefetchDepth;
+    }
+
+    m_prefetchUpdated.wait(lk, [this] { return !m_prefetchedWindows.empty(); });
+  } else if (m_prefetchTail && m_prefetchDepth > 1) {
+    // the download waits for processing, don't hold more blocks than it needs
+    --m_prefetchDepth;
+  }
+
+  m_prefetchWarm = true;
+  std::shared_ptr<BlocksWindow> window = m_prefetchedWindows.front();
+  m_prefetchedWindows.pop_front();
+
+  std::shared_ptr<BlocksWindow> next;
+  if (m_prefetchTail) {
+    next = makeNextBlocksWindow(*m_prefetchTail);
+    m_prefetchTail.reset();
+    m_prefetchPending = true;
+    ++m_prefetchQueries;
+  }
+
+  uint32_t generation = m_prefetchGeneration;
+  lk.unlock();
+
+  if (next) {
+    queryBlocksWindow(next, generation);
+  }
+
+  return window;
+}
+
+/// \pre m_prefetchMutex is locked
+std::shared_ptr<BlockchainSynchronizer::BlocksWindow> BlockchainSynchronizer::makeNextBlocksWindow(const BlocksWindow& previous) const {
+  std::shared_ptr<BlocksWindow> window = std::make_shared<BlocksWindow>();
+  window->knownBlocks.reserve(m_prefetchHistory.size() + 1);
+  window->knownBlocks.push_back(previous.response.newBlocks.back().blockHash);
+  window->knownBlocks.insert(window->knownBlocks.end(), m_prefetchHistory.begin(), m_prefetchHistory.end());
+  window->timestamp = previous.timestamp;
+  window->filterItems = previous.filterItems;
+  return window;
+}
+
+void BlockchainSynchronizer::queryBlocksWindow(std::shared_ptr<BlocksWindow> window, uint32_t generation) {
+  if (window->filterItems && m_nodeHasFilters) {
+    queryFilteredBlocksWindow(window, generation);
+    return;
+  }
+
+  std::vector<Crypto::Hash> knownBlocks = window->knownBlocks;
+  // the node may call back right away, m_prefetchMutex must not be held here
+  m_node.queryBlocks(std::move(knownBlocks), window->timestamp, window->response.newBlocks, window->response.startHeight,
+    [this, window, generation](std::error_code ec) {
+      completeBlocksWindow(window, generation, ec);
+    });
+}
+
+// The filters of the blocks that follow the known ones come first. The leading blocks they rule
+// out make an id only window, consumers skip such blocks. Once the next block may match, the
+// window is queried in full from it.
+void BlockchainSynchronizer::queryFilteredBlocksWindow(std::shared_ptr<BlocksWindow> window, uint32_t generation) {
+  auto filters = std::make_shared<std::vector<BlockFilterEntry>>();
+  std::vector<Crypto::Hash> knownBlocks = window->knownBlocks;
+  m_node.getBlockFilters(std::move(knownBlocks), *filters, window->response.startHeight,
+    [this, window, generation, filters](std::error_code ec) {
+      size_t skipped = 1; // the first block is the known one
+      if (ec) {
+        m_logger(DEBUGGING) << "Node gives no block filters: " << ec << ", " << ec.message();
+        m_nodeHasFilters = false;
+      } else {
+        while (skipped < filters->size() &&
+          !BlockFilter::matchAny((*filters)[skipped].blockHash, (*filters)[skipped].filter, *window->filterItems)) {
+          ++skipped;
+        }
+      }
+
+      if (ec || skipped < 2) {
+        std::vector<Crypto::Hash> knownBlocks = window->knownBlocks;
+        m_node.queryBlocks(std::move(knownBlocks), window->timestamp, window->response.newBlocks, window->response.startHeight,
+          [this, window, generation](std::error_code ec) {
+            completeBlocksWindow(window, generation, ec);
+          });
+        return;
+      }
+
+      window->response.newBlocks.resize(skipped);
+      for (size_t i = 0; i < skipped; ++i) {
+        window->response.newBlocks[i].blockHash = (*filters)[i].blockHash;
+        window->response.newBlocks[i].hasBlock = false;
+      }
+
+      completeBlocksWindow(window, generation, std::error_code());
+    });
+}
+
+void BlockchainSynchronizer::completeBlocksWindow(std::shared_ptr<BlocksWindow> window, uint32_t generation, std::error_code ec) {
+  window->ec = ec;
+  bool last = ec || window->response.newBlocks.size() <= 1 ||
+    window->response.startHeight + window->response.newBlocks.size() > m_node.getLastLocalBlockHeight();
+
+  std::shared_ptr<BlocksWindow> next;
+  {
+    std::unique_lock<std::mutex> lk(m_prefetchMutex);
+    --m_prefetchQueries;
+    if (generation == m_prefetchGeneration) {
+      m_prefetchedWindows.push_back(window);
+      m_prefetchPending = false;
+      if (!last && m_prefetchedWindows.size() < m_prefetchDepth) {
+        next = makeNextBlocksWindow(*window);
+        m_prefetchPending = true;
+        ++m_prefetchQueries;
+      } else if (!last) {
+        m_prefetchTail = window;
+      }
+    }
+
+    m_prefetchUpdated.notify_all();
+  }
+
+  if (next) {
+    queryBlocksWindow(next, generation);
+  }
+}
+
+bool BlockchainSynchronizer::isPrefetching() const {
+  std::unique_lock<std::mutex> lk(m_prefetchMutex);
+  return m_prefetchPending || !m_prefetchedWindows.empty();
+}
+
+void BlockchainSynchronizer::resetPrefetch() {
+  std::unique_lock<std::mutex> lk(m_prefetchMutex);
+  ++m_prefetchGeneration;
+  m_prefetchedWindows.clear();
+  m_prefetchTail.reset();
+  m_prefetchHistory.clear();
+  m_prefetchPending = false;
+}
+
+void BlockchainSynchronizer::waitPrefetchQueries() {
+  std::unique_lock<std::mutex> lk(m_prefetchMutex);
+  m_prefetchUpdated.wait(lk, [this] { return m_prefetchQueries == 0; });
+}
+
+//--------------------------- PREFETCH END ------------------------------------
+
 void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
   m_logger(DEBUGGING) << "Process blocks, start index " << response.startHeight << ", count " << response.newBlocks.size();
 
@@ -502,14 +736,23 @@ void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
     if (block.hasBlock) {
       completeBlock.block = std::move(block.block);
       completeBlock.transactions.push_back(createTransactionPrefix(completeBlock.block->baseTransaction));
+      // the coinbase always has outputs, so its indexes tell whether the node sent them
+      if (!block.baseTransactionGlobalIndexes.empty()) {
+        completeBlock.globalIndexes.reserve(block.txsShortInfo.size() + 1);
+        completeBlock.globalIndexes.push_back(std::move(block.baseTransactionGlobalIndexes));
+      }
 
       try {
-        for (const auto& txShortInfo : block.txsShortInfo) {
+        for (auto& txShortInfo : block.txsShortInfo) {
           completeBlock.transactions.push_back(createTransactionPrefix(txShortInfo.txPrefix, reinterpret_cast<const Hash&>(txShortInfo.txId)));
+          if (!completeBlock.globalIndexes.empty()) {
+            completeBlock.globalIndexes.push_back(std::move(txShortInfo.globalIndexes));
+          }
         }
       } catch (const std::exception& e) {
         m_logger(ERROR, BRIGHT_RED) << "Failed to process blocks: " << e.what();
         setFutureStateIf(State::idle, [this] { return m_futureState != State::stopped; });
+        resetPrefetch();
         m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, std::make_error_code(std::errc::invalid_argument));
         return;
       }
@@ -525,6 +768,10 @@ void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
     auto result = updateConsumers(interval, blocks);
     lk.unlock();
 
+    if (result != UpdateConsumersResult::addedNewBlocks) {
+      resetPrefetch();
+    }
+
     switch (result) {
     case UpdateConsumersResult::errorOccurred:
       if (setFutureStateIf(State::idle, [this] { return m_futureState != State::stopped; })) {
@@ -556,6 +803,7 @@ void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
   }
 
   if (checkIfShouldStop()) { //Sic!
+    resetPrefetch();
     m_logger(WARNING, BRIGHT_YELLOW) << "Block processing is interrupted";
     m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, std::make_error_code(std::errc::interrupted));
   }
@@ -620,7 +868,7 @@ void BlockchainSynchronizer::removeOutdatedTransactions() {
 
     std::unique_lock<std::mutex> lock(m_consumersMutex);
     for (auto& consumer : m_consumers) {
-      ec = consumer.first->onPoolUpdated({}, response.deletedTxIds);
+      ec = updateConsumerPool(consumer.first, {}, response.deletedTxIds);
       if (ec) {
         m_logger(ERROR, BRIGHT_RED) << "Failed to process outdated pool transactions: " << ec << ", " << ec.message() << ", consumer " << consumer.first;
         break;
@@ -675,7 +923,7 @@ void BlockchainSynchronizer::startPoolSync() {
       m_logger(DEBUGGING) << "Transaction pool changes received, added " << unionResponse.newTxs.size() <<
         ", deleted " << unionResponse.deletedTxIds.size();
 
-      if (unionPoolHistory == intersectedPoolHistory) { //usual case, start pool processing
+      if (unionPoolHistory.size() == intersectedPoolHistory.size()) { //usual case, the intersection is a subset of the union
         m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, processPoolTxs(unionResponse));
       } else {
         GetPoolRequest intersectionRequest;
@@ -741,7 +989,7 @@ std::error_code BlockchainSynchronizer::processPoolTxs(GetPoolResponse& response
         return std::make_error_code(std::errc::interrupted);
       }
 
-      error = consumer.first->onPoolUpdated(response.newTxs, response.deletedTxIds);
+      error = updateConsumerPool(consumer.first, response.newTxs, response.deletedTxIds);
       if (error) {
         m_logger(ERROR, BRIGHT_RED) << "Failed to process pool transactions: " << error << ", " << error.message() << ", consumer " << consumer.first;
         break;
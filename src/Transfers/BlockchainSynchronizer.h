@@ -24,9 +24,11 @@
 #include "IStreamSerializable.h"
 
 #include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <atomic>
 #include <future>
+#include <unordered_map>
 
 #include "Logging/LoggerRef.h"
 
@@ -75,6 +77,7 @@ private:
     }
     SynchronizationStart syncStart;
     std::vector<Crypto::Hash> knownBlocks;
+    std::shared_ptr<const std::vector<Crypto::Hash>> filterItems; // null unless every consumer gave its items
   };
 
   struct GetPoolResponse {
@@ -88,6 +91,17 @@ private:
     Crypto::Hash lastKnownBlock;
   };
 
+  // one queryBlocks call of the read-ahead pipeline
+  struct BlocksWindow {
+    std::vector<Crypto::Hash> knownBlocks;
+    uint64_t timestamp;
+    std::shared_ptr<const std::vector<Crypto::Hash>> filterItems;
+    GetBlocksResponse response;
+    std::error_code ec;
+  };
+
+  static const size_t MAX_PREFETCH_DEPTH = 4;
+
   enum class State { //prioritized finite states
     idle = 0,           //DO
     poolSync = 1,       //NOT
@@ -108,8 +122,19 @@ private:
   void startBlockchainSync();
 
   void processBlocks(GetBlocksResponse& response);
+  void startPrefetch(GetBlocksRequest&& request);
+  std::shared_ptr<BlocksWindow> takeBlocksWindow();
+  std::shared_ptr<BlocksWindow> makeNextBlocksWindow(const BlocksWindow& previous) const;
+  void queryBlocksWindow(std::shared_ptr<BlocksWindow> window, uint32_t generation);
+  void queryFilteredBlocksWindow(std::shared_ptr<BlocksWindow> window, uint32_t generation);
+  void completeBlocksWindow(std::shared_ptr<BlocksWindow> window, uint32_t generation, std::error_code ec);
+  bool isPrefetching() const;
+  void resetPrefetch();
+  void waitPrefetchQueries();
   UpdateConsumersResult updateConsumers(const BlockchainInterval& interval, const std::vector<CompleteBlock>& blocks);
   std::error_code processPoolTxs(GetPoolResponse& response);
+  std::error_code updateConsumerPool(IBlockchainConsumer* consumer, const std::vector<std::unique_ptr<ITransactionReader>>& addedTransactions,
+    const std::vector<Crypto::Hash>& deletedTransactions);
   std::error_code getPoolSymmetricDifferenceSync(GetPoolRequest&& request, GetPoolResponse& response);
   std::error_code doAddUnconfirmedTransaction(const ITransactionReader& transaction);
   void doRemoveUnconfirmedTransaction(const Crypto::Hash& transactionHash);
@@ -125,7 +150,7 @@ private:
   void workingProcedure();
 
   GetBlocksRequest getCommonHistory();
-  void getPoolUnionAndIntersection(std::unordered_set<Crypto::Hash>& poolUnion, std::unordered_set<Crypto::Hash>& poolIntersection) const;
+  void getPoolUnionAndIntersection(std::unordered_set<Crypto::Hash>& poolUnion, std::unordered_set<Crypto::Hash>& poolIntersection);
   SynchronizationState* getConsumerSynchronizationState(IBlockchainConsumer* consumer) const ;
 
   typedef std::map<IBlockchainConsumer*, std::shared_ptr<SynchronizationState>> ConsumersMap;
@@ -143,6 +168,24 @@ private:
   std::list<std::pair<const ITransactionReader*, std::promise<std::error_code>>> m_addTransactionTasks;
   std::list<std::pair<const Crypto::Hash*, std::promise<void>>> m_removeTransactionTasks;
 
+  // windows are requested ahead of processing, each one chained on the last block of the previous
+  mutable std::mutex m_prefetchMutex;
+  std::condition_variable m_prefetchUpdated;
+  std::deque<std::shared_ptr<BlocksWindow>> m_prefetchedWindows; // received, not processed yet
+  std::shared_ptr<BlocksWindow> m_prefetchTail; // last received window the next request is not sent for
+  std::vector<Crypto::Hash> m_prefetchHistory;
+  uint32_t m_prefetchGeneration;
+  size_t m_prefetchQueries; // sent in any generation, not completed yet
+  bool m_prefetchPending;  // a query of the current generation is on the way
+  bool m_prefetchWarm;
+  size_t m_prefetchDepth;
+  std::atomic<bool> m_nodeHasFilters; // cleared when the node fails to give block filters
+
+  // pool transaction id -> number of consumers knowing it, kept up to date as the pool changes are
+  // processed and recounted when the consumers may have changed while stopped; under m_consumersMutex
+  std::unordered_map<Crypto::Hash, size_t> m_poolTxConsumers;
+  bool m_poolTxConsumersValid;
+
   mutable std::mutex m_consumersMutex;
   mutable std::mutex m_stateMutex;
   std::condition_variable m_hasWork;
@@ -38,6 +38,8 @@ struct CompleteBlock {
   boost::optional<CryptoNote::Block> block;
   // first transaction is always coinbase
   std::list<std::shared_ptr<ITransactionReader>> transactions;
+  // global output indexes in the order of transactions, empty if the node did not send them
+  std::vector<std::vector<uint32_t>> globalIndexes;
 };
 
 }
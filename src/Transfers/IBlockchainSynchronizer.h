@@ -52,6 +52,10 @@ public:
 
   virtual std::error_code addUnconfirmedTransaction(const ITransactionReader& transaction) = 0;
   virtual void removeUnconfirmedTransaction(const Crypto::Hash& transactionHash) = 0;
+
+  // payment ids and transaction public keys the consumer is after, when every consumer has
+  // them the blocks the compact filters rule out aren't downloaded; false if it needs all blocks
+  virtual bool getFilterItems(std::vector<Crypto::Hash>& items) const { return false; }
 };
 
 class IBlockchainConsumerObserver {
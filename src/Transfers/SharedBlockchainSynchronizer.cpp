@@ -0,0 +1,89 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "SharedBlockchainSynchronizer.h"
+
+namespace CryptoNote {
+
+SharedBlockchainSynchronizer::User::User(SharedBlockchainSynchronizer* shared) : m_shared(shared) {
+}
+
+SharedBlockchainSynchronizer::User::~User() {
+  leave();
+}
+
+void SharedBlockchainSynchronizer::User::pause() {
+  if (m_shared != nullptr) {
+    m_shared->pause(this);
+  }
+}
+
+void SharedBlockchainSynchronizer::User::resume() {
+  if (m_shared != nullptr) {
+    m_shared->resume(this);
+  }
+}
+
+void SharedBlockchainSynchronizer::User::leave() {
+  if (m_shared != nullptr) {
+    m_shared->leave(this);
+  }
+}
+
+SharedBlockchainSynchronizer::SharedBlockchainSynchronizer(INode& node, Logging::ILogger& logger, const Crypto::Hash& genesisBlockHash) :
+  m_synchronizer(node, logger, genesisBlockHash),
+  m_started(false) {
+}
+
+void SharedBlockchainSynchronizer::pause(const User* user) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_running.erase(user);
+  m_paused.insert(user);
+  update();
+}
+
+void SharedBlockchainSynchronizer::resume(const User* user) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_paused.erase(user);
+  m_running.insert(user);
+  update();
+}
+
+void SharedBlockchainSynchronizer::leave(const User* user) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_running.erase(user);
+  m_paused.erase(user);
+
+  // TransfersSyncronizer stops the synchronizer on its own when it is destroyed, which happens
+  // before the wallet leaves, so don't trust m_started here
+  m_synchronizer.stop();
+  m_started = false;
+  update();
+}
+
+void SharedBlockchainSynchronizer::update() {
+  bool run = m_paused.empty() && !m_running.empty();
+  if (run && !m_started) {
+    m_synchronizer.start();
+  } else if (!run && m_started) {
+    m_synchronizer.stop();
+  }
+
+  m_started = run;
+}
+
+}
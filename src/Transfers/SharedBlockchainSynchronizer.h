@@ -0,0 +1,71 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <mutex>
+#include <set>
+
+#include "BlockchainSynchronizer.h"
+
+namespace CryptoNote {
+
+// One BlockchainSynchronizer serving the containers of several wallets, so every block is downloaded
+// and parsed once and handed to the consumers of all of them. Consumers can only be added and removed
+// while the synchronizer is stopped: each wallet pauses it around such changes, and it runs while at
+// least one wallet has resumed it and no wallet holds it paused.
+class SharedBlockchainSynchronizer {
+public:
+  // a wallet's hold on the shared synchronizer, leaves it on destruction
+  class User {
+  public:
+    // nullptr for a wallet with a synchronizer of its own, all calls do nothing then
+    explicit User(SharedBlockchainSynchronizer* shared = nullptr);
+    User(const User&) = delete;
+    User& operator=(const User&) = delete;
+    ~User();
+
+    bool isShared() const { return m_shared != nullptr; }
+    void pause();
+    void resume();
+    // neither running nor paused, as if the wallet had no consumers
+    void leave();
+
+  private:
+    SharedBlockchainSynchronizer* m_shared;
+  };
+
+  SharedBlockchainSynchronizer(INode& node, Logging::ILogger& logger, const Crypto::Hash& genesisBlockHash);
+  SharedBlockchainSynchronizer(const SharedBlockchainSynchronizer&) = delete;
+  SharedBlockchainSynchronizer& operator=(const SharedBlockchainSynchronizer&) = delete;
+
+  BlockchainSynchronizer& synchronizer() { return m_synchronizer; }
+
+private:
+  void pause(const User* user);
+  void resume(const User* user);
+  void leave(const User* user);
+  void update();
+
+  BlockchainSynchronizer m_synchronizer;
+  std::mutex m_mutex;
+  std::set<const User*> m_running;
+  std::set<const User*> m_paused;
+  bool m_started;
+};
+
+}
@@ -19,14 +19,16 @@
 
 #include "TransfersConsumer.h"
 
+#include <algorithm>
 #include <numeric>
 #include <future>
 
 #include "CommonTypes.h"
+#include "Common/AllocationProfiler.h"
 #include "Common/StringTools.h"
-#include "Common/BlockingQueue.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/TransactionApi.h"
+#include "System/ThreadPool.h"
 
 #include "IWallet.h"
 #include "INode.h"
@@ -43,65 +45,85 @@ namespace {
 
 using namespace CryptoNote;
 
-void checkOutputKey(
-  const KeyDerivation& derivation,
-  const PublicKey& key,
-  size_t keyIndex,
-  size_t outputIndex,
-  const std::unordered_set<PublicKey>& spendKeys,
-  std::unordered_map<PublicKey, std::vector<uint32_t>>& outputs) {
-
-  PublicKey spendKey;
-  underive_public_key(derivation, keyIndex, key, spendKey);
-
-  if (spendKeys.find(spendKey) != spendKeys.end()) {
-    outputs[spendKey].push_back(static_cast<uint32_t>(outputIndex));
-  }
+// transactions scanned together; a batch shares its field inversions and is the unit handed to the pool
+const size_t TRANSACTIONS_PER_BATCH = 16;
 
-}
+// spend key -> indexes of the outputs sent to it
+typedef std::unordered_map<PublicKey, std::vector<uint32_t>> FoundOutputs;
 
 void findMyOutputs(
-  const ITransactionReader& tx,
+  const ITransactionReader* const* txs,
+  size_t count,
   const SecretKey& viewSecretKey,
   const std::unordered_set<PublicKey>& spendKeys,
-  std::unordered_map<PublicKey, std::vector<uint32_t>>& outputs) {
+  FoundOutputs* outputs) {
 
-  auto txPublicKey = tx.getTransactionPublicKey();
-  KeyDerivation derivation;
-
-  if (!generate_key_derivation(txPublicKey, viewSecretKey, derivation)) {
-    return;
+  std::vector<PublicKey> txPublicKeys(count);
+  for (size_t i = 0; i < count; ++i) {
+    txPublicKeys[i] = txs[i]->getTransactionPublicKey();
   }
 
-  size_t keyIndex = 0;
-  size_t outputCount = tx.getOutputCount();
+  std::vector<KeyDerivation> derivations(count);
+  std::unique_ptr<bool[]> derived(new bool[count]);
+  generate_key_derivations(txPublicKeys.data(), count, viewSecretKey, derivations.data(), derived.get());
 
-  for (size_t idx = 0; idx < outputCount; ++idx) {
+  std::vector<const KeyDerivation*> keyDerivations;
+  std::vector<size_t> keyIndexes;
+  std::vector<PublicKey> keys;
+  std::vector<std::pair<size_t, uint32_t>> keyOwners; // transaction and output of every key
 
-    auto outType = tx.getOutputType(size_t(idx));
+  auto addKey = [&](size_t txIndex, size_t keyIndex, size_t outputIndex, const PublicKey& key) {
+    keyDerivations.push_back(&derivations[txIndex]);
+    keyIndexes.push_back(keyIndex);
+    keys.push_back(key);
+    keyOwners.emplace_back(txIndex, static_cast<uint32_t>(outputIndex));
+  };
 
-    if (outType == TransactionTypes::OutputType::Key) {
+  for (size_t i = 0; i < count; ++i) {
+    if (!derived[i]) {
+      continue;
+    }
 
-      uint64_t amount;
-      KeyOutput out;
-      tx.getOutput(idx, out, amount);
+    const ITransactionReader& tx = *txs[i];
+    size_t keyIndex = 0;
+    size_t outputCount = tx.getOutputCount();
 
-      checkOutputKey(derivation, out.key, keyIndex, idx, spendKeys, outputs);
-      ++keyIndex;
+    for (size_t idx = 0; idx < outputCount; ++idx) {
 
-    } else if (outType == TransactionTypes::OutputType::Multisignature) {
+      auto outType = tx.getOutputType(size_t(idx));
 
-      uint64_t amount;
-      MultisignatureOutput out;
-      tx.getOutput(idx, out, amount);
+      if (outType == TransactionTypes::OutputType::Key) {
 
-      for (const auto& key : out.keys) {
-        checkOutputKey(derivation, key, idx, idx, spendKeys, outputs);
+        uint64_t amount;
+        KeyOutput out;
+        tx.getOutput(idx, out, amount);
 
+        addKey(i, keyIndex, idx, out.key);
         ++keyIndex;
+
+      } else if (outType == TransactionTypes::OutputType::Multisignature) {
+
+        uint64_t amount;
+        MultisignatureOutput out;
+        tx.getOutput(idx, out, amount);
+
+        for (const auto& key : out.keys) {
+          addKey(i, idx, idx, key);
+
+          ++keyIndex;
+        }
       }
     }
   }
+
+  std::vector<PublicKey> spendCandidates(keys.size());
+  std::unique_ptr<bool[]> underived(new bool[keys.size()]);
+  underive_public_keys(keyDerivations.data(), keyIndexes.data(), keys.data(), keys.size(), spendCandidates.data(), underived.get());
+  for (size_t k = 0; k < keys.size(); ++k) {
+    if (underived[k] && spendKeys.find(spendCandidates[k]) != spendKeys.end()) {
+      outputs[keyOwners[k].first][spendCandidates[k]].push_back(keyOwners[k].second);
+    }
+  }
 }
 
 std::vector<Crypto::Hash> getBlockHashes(const CryptoNote::CompleteBlock* blocks, size_t count) {
@@ -120,7 +142,7 @@ std::vector<Crypto::Hash> getBlockHashes(const CryptoNote::CompleteBlock* blocks
 namespace CryptoNote {
 
 TransfersConsumer::TransfersConsumer(const CryptoNote::Currency& currency, INode& node, Logging::ILogger& logger, const SecretKey& viewSecret) :
-  m_node(node), m_viewSecret(viewSecret), m_currency(currency), m_logger(logger, "TransfersConsumer") {
+  m_keyImageIndexValid(true), m_node(node), m_viewSecret(viewSecret), m_currency(currency), m_logger(logger, "TransfersConsumer") {
   updateSyncStart();
 }
 
@@ -146,9 +168,36 @@ ITransfersSubscription& TransfersConsumer::addSubscription(const AccountSubscrip
   return *res;
 }
 
+std::vector<ITransfersSubscription*> TransfersConsumer::addSubscriptions(const std::vector<AccountSubscription>& subscriptions) {
+  for (const auto& subscription : subscriptions) {
+    if (subscription.keys.viewSecretKey != m_viewSecret) {
+      throw std::runtime_error("TransfersConsumer: view secret key mismatch");
+    }
+  }
+
+  m_subscriptions.reserve(m_subscriptions.size() + subscriptions.size());
+  m_spendKeys.reserve(m_spendKeys.size() + subscriptions.size());
+
+  std::vector<ITransfersSubscription*> result;
+  result.reserve(subscriptions.size());
+  for (const auto& subscription : subscriptions) {
+    auto& res = m_subscriptions[subscription.keys.address.spendPublicKey];
+    if (res.get() == nullptr) {
+      res.reset(new TransfersSubscription(m_currency, m_logger.getLogger(), subscription));
+      m_spendKeys.insert(subscription.keys.address.spendPublicKey);
+    }
+
+    result.push_back(res.get());
+  }
+
+  updateSyncStart();
+  return result;
+}
+
 bool TransfersConsumer::removeSubscription(const AccountPublicAddress& address) {
   m_subscriptions.erase(address.spendPublicKey);
   m_spendKeys.erase(address.spendPublicKey);
+  invalidateKeyImageIndex();
   updateSyncStart();
   return m_subscriptions.empty();
 }
@@ -177,6 +226,28 @@ void TransfersConsumer::initTransactionPool(const std::unordered_set<Crypto::Has
   }
 }
 
+void TransfersConsumer::invalidateKeyImageIndex() {
+  m_keyImageIndexValid = false;
+  m_keyImageOwners.clear();
+}
+
+void TransfersConsumer::updateKeyImageIndex() {
+  if (m_keyImageIndexValid) {
+    return;
+  }
+
+  std::vector<KeyImage> keyImages;
+  for (const auto& kv : m_subscriptions) {
+    keyImages.clear();
+    kv.second->getKeyImages(keyImages);
+    for (const auto& keyImage : keyImages) {
+      m_keyImageOwners[keyImage] = kv.second.get();
+    }
+  }
+
+  m_keyImageIndexValid = true;
+}
+
 void TransfersConsumer::updateSyncStart() {
   SynchronizationStart start;
 
@@ -205,109 +276,128 @@ void TransfersConsumer::onBlockchainDetach(uint32_t height) {
 }
 
 bool TransfersConsumer::onNewBlocks(const CompleteBlock* blocks, uint32_t startHeight, uint32_t count) {
+  Common::AllocationScope allocationScope(Common::AllocationSubsystem::Transfers);
   assert(blocks);
   assert(count > 0);
 
   struct Tx {
     TransactionBlockInfo blockInfo;
     const ITransactionReader* tx;
+    const std::vector<uint32_t>* sentGlobalIdxs; // the ones that came with the block, if any
   };
 
   struct PreprocessedTx : Tx, PreprocessInfo {};
 
   std::vector<PreprocessedTx> preprocessedTransactions;
-  std::mutex preprocessedTransactionsMutex;
-
-  size_t workers = std::thread::hardware_concurrency();
-  if (workers == 0) {
-    workers = 2;
-  }
+  for (uint32_t i = 0; i < count; ++i) {
+    const auto& block = blocks[i].block;
 
-  BlockingQueue<Tx> inputQueue(workers * 2);
-
-  std::atomic<bool> stopProcessing(false);
-
-  auto pushingThread = std::async(std::launch::async, [&] {
-    for( uint32_t i = 0; i < count && !stopProcessing; ++i) {
-      const auto& block = blocks[i].block;
+    if (!block.is_initialized()) {
+      continue;
+    }
 
-      if (!block.is_initialized()) {
-        continue;
-      }
+    // filter by syncStartTimestamp
+    if (m_syncStart.timestamp && block->timestamp < m_syncStart.timestamp) {
+      continue;
+    }
 
-      // filter by syncStartTimestamp
-      if (m_syncStart.timestamp && block->timestamp < m_syncStart.timestamp) {
+    TransactionBlockInfo blockInfo;
+    blockInfo.height = startHeight + i;
+    blockInfo.timestamp = block->timestamp;
+    blockInfo.transactionIndex = 0; // position in block
+
+    bool hasGlobalIdxs = blocks[i].globalIndexes.size() == blocks[i].transactions.size();
+    for (const auto& tx : blocks[i].transactions) {
+      auto pubKey = tx->getTransactionPublicKey();
+      if (pubKey == NULL_PUBLIC_KEY) {
+        ++blockInfo.transactionIndex;
         continue;
       }
 
-      TransactionBlockInfo blockInfo;
-      blockInfo.height = startHeight + i;
-      blockInfo.timestamp = block->timestamp;
-      blockInfo.transactionIndex = 0; // position in block
-
-      for (const auto& tx : blocks[i].transactions) {
-        auto pubKey = tx->getTransactionPublicKey();
-        if (pubKey == NULL_PUBLIC_KEY) {
-          ++blockInfo.transactionIndex;
-          continue;
-        }
+      PreprocessedTx item;
+      item.blockInfo = blockInfo;
+      item.tx = tx.get();
+      item.sentGlobalIdxs = hasGlobalIdxs ? &blocks[i].globalIndexes[blockInfo.transactionIndex] : nullptr;
+      preprocessedTransactions.push_back(std::move(item));
+      ++blockInfo.transactionIndex;
+    }
+  }
 
-        Tx item = { blockInfo, tx.get() };
-        inputQueue.push(item);
-        ++blockInfo.transactionIndex;
+  // transactions stay in block order, every batch fills its own slots; a batch at the chain tip
+  // is usually a handful of transactions and is scanned on this thread
+  std::atomic<bool> stopProcessing(false);
+  std::error_code processingError;
+  std::mutex processingErrorMutex;
+  size_t batchCount = (preprocessedTransactions.size() + TRANSACTIONS_PER_BATCH - 1) / TRANSACTIONS_PER_BATCH;
+  std::vector<FoundOutputs> outputs(preprocessedTransactions.size());
+  try {
+    System::parallelFor(0, batchCount, [&](size_t batch) {
+      size_t first = batch * TRANSACTIONS_PER_BATCH;
+      size_t last = std::min(preprocessedTransactions.size(), first + TRANSACTIONS_PER_BATCH);
+      std::vector<const ITransactionReader*> txs;
+      for (size_t i = first; i < last; ++i) {
+        txs.push_back(preprocessedTransactions[i].tx);
       }
-    }
 
-    inputQueue.close();
-  });
+      findMyOutputs(txs.data(), txs.size(), m_viewSecret, m_spendKeys, outputs.data() + first);
+    });
 
-  auto processingFunction = [&] {
-    Tx item;
-    std::error_code ec;
-    while (!stopProcessing && inputQueue.pop(item)) {
-      PreprocessedTx output;
-      static_cast<Tx&>(output) = item;
-
-      ec = preprocessOutputs(item.blockInfo, *item.tx, output);
-      if (ec) {
-        stopProcessing = true;
-        break;
+    // the global indices of the transactions with found outputs either came with the blocks
+    // or are requested for all of them at once
+    std::vector<size_t> found;
+    std::vector<size_t> missing;
+    std::vector<Hash> missingHashes;
+    for (size_t i = 0; i < preprocessedTransactions.size(); ++i) {
+      if (outputs[i].empty()) {
+        continue;
       }
 
-      std::lock_guard<std::mutex> lk(preprocessedTransactionsMutex);
-      preprocessedTransactions.push_back(std::move(output));
+      found.push_back(i);
+      PreprocessedTx& item = preprocessedTransactions[i];
+      if (item.sentGlobalIdxs != nullptr && !item.sentGlobalIdxs->empty()) {
+        item.globalIdxs = *item.sentGlobalIdxs;
+      } else {
+        missing.push_back(i);
+        missingHashes.push_back(item.tx->getTransactionHash());
+      }
     }
-    return ec;
-  };
 
-  std::vector<std::future<std::error_code>> processingThreads;
-  for (size_t i = 0; i < workers; ++i) {
-    processingThreads.push_back(std::async(std::launch::async, processingFunction));
-  }
+    std::vector<std::vector<uint32_t>> missingGlobalIdxs;
+    if (!missing.empty()) {
+      processingError = getGlobalIndices(missingHashes, missingGlobalIdxs);
+    }
 
-  std::error_code processingError;
-  for (auto& f : processingThreads) {
-    try {
-      std::error_code ec = f.get();
-      if (!processingError && ec) {
-        processingError = ec;
+    if (!processingError) {
+      for (size_t i = 0; i < missing.size(); ++i) {
+        preprocessedTransactions[missing[i]].globalIdxs = std::move(missingGlobalIdxs[i]);
       }
-    } catch (const std::system_error& e) {
-      processingError = e.code();
-    } catch (const std::exception&) {
-      processingError = std::make_error_code(std::errc::operation_canceled);
+
+      System::parallelFor(0, (found.size() + TRANSACTIONS_PER_BATCH - 1) / TRANSACTIONS_PER_BATCH, [&](size_t batch) {
+        size_t first = batch * TRANSACTIONS_PER_BATCH;
+        size_t last = std::min(found.size(), first + TRANSACTIONS_PER_BATCH);
+        for (size_t i = first; i < last && !stopProcessing; ++i) {
+          PreprocessedTx& item = preprocessedTransactions[found[i]];
+          std::error_code ec = preprocessOutputs(item.blockInfo, *item.tx, outputs[found[i]], item);
+          if (ec) {
+            stopProcessing = true;
+            std::lock_guard<std::mutex> lk(processingErrorMutex);
+            if (!processingError) {
+              processingError = ec;
+            }
+          }
+        }
+      });
     }
+  } catch (const std::system_error& e) {
+    processingError = e.code();
+  } catch (const std::exception&) {
+    processingError = std::make_error_code(std::errc::operation_canceled);
   }
 
   std::vector<Crypto::Hash> blockHashes = getBlockHashes(blocks, count);
   if (!processingError) {
     m_observerManager.notify(&IBlockchainConsumerObserver::onBlocksAdded, this, blockHashes);
 
-    // sort by block height and transaction index in block
-    std::sort(preprocessedTransactions.begin(), preprocessedTransactions.end(), [](const PreprocessedTx& a, const PreprocessedTx& b) {
-      return std::tie(a.blockInfo.height, a.blockInfo.transactionIndex) < std::tie(b.blockInfo.height, b.blockInfo.transactionIndex);
-    });
-
     for (const auto& tx : preprocessedTransactions) {
       processTransaction(tx.blockInfo, *tx.tx, tx);
     }
@@ -409,12 +499,40 @@ std::error_code TransfersConsumer::createTransfers(
     }
   }
 
+  // key images of all key outputs are generated together, they share one field inversion
+  std::vector<PublicKey> ephemeralKeys;
+  std::vector<SecretKey> ephemeralSecrets;
+  std::vector<KeyImage> keyImages;
+  KeyDerivation derivation = {};
+  bool derivationGenerated = false;
   for (auto idx : outputs) {
-
     if (idx >= tx.getOutputCount()) {
       return std::make_error_code(std::errc::argument_out_of_domain);
     }
 
+    if (tx.getOutputType(size_t(idx)) != TransactionTypes::OutputType::Key) {
+      continue;
+    }
+
+    if (!derivationGenerated) {
+      derivationGenerated = generate_key_derivation(txPubKey, account.viewSecretKey, derivation);
+      assert(derivationGenerated && "failed to generate_key_derivation");
+    }
+
+    ephemeralKeys.emplace_back();
+    ephemeralSecrets.emplace_back();
+    bool derived = derive_public_key(derivation, idx, account.address.spendPublicKey, ephemeralKeys.back());
+    assert(derived && "failed to derive_public_key");
+    (void)derived;
+
+    derive_secret_key(derivation, idx, account.spendSecretKey, ephemeralSecrets.back());
+  }
+
+  keyImages.resize(ephemeralKeys.size());
+  generate_key_images(ephemeralKeys.data(), ephemeralSecrets.data(), ephemeralKeys.size(), keyImages.data());
+
+  size_t keyOutputIndex = 0;
+  for (auto idx : outputs) {
     auto outType = tx.getOutputType(size_t(idx));
 
     if (
@@ -436,15 +554,9 @@ std::error_code TransfersConsumer::createTransfers(
       KeyOutput out;
       tx.getOutput(idx, out, amount);
 
-      CryptoNote::KeyPair in_ephemeral;
-      CryptoNote::generate_key_image_helper(
-        account,
-        txPubKey,
-        idx,
-        in_ephemeral,
-        info.keyImage);
-
-      assert(out.key == reinterpret_cast<const PublicKey&>(in_ephemeral.publicKey));
+      info.keyImage = keyImages[keyOutputIndex];
+      assert(out.key == ephemeralKeys[keyOutputIndex]);
+      ++keyOutputIndex;
 
       std::unordered_set<Crypto::Hash>::iterator it = transactions_hash_seen.find(txHash);
 	  if (it == transactions_hash_seen.end()) {
@@ -496,21 +608,29 @@ std::error_code TransfersConsumer::createTransfers(
 }
 
 std::error_code TransfersConsumer::preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx, PreprocessInfo& info) {
-  std::unordered_map<PublicKey, std::vector<uint32_t>> outputs;
-  findMyOutputs(tx, m_viewSecret, m_spendKeys, outputs);
+  FoundOutputs outputs;
+  const ITransactionReader* txs[] = { &tx };
+  findMyOutputs(txs, 1, m_viewSecret, m_spendKeys, &outputs);
   if (outputs.empty()) {
     return std::error_code();
   }
 
-  std::error_code errorCode;
-  auto txHash = tx.getTransactionHash();
   if (blockInfo.height != WALLET_UNCONFIRMED_TRANSACTION_HEIGHT) {
-    errorCode = getGlobalIndices(reinterpret_cast<const Hash&>(txHash), info.globalIdxs);
+    std::vector<std::vector<uint32_t>> globalIdxs;
+    std::error_code errorCode = getGlobalIndices({ tx.getTransactionHash() }, globalIdxs);
     if (errorCode) {
       return errorCode;
     }
+
+    info.globalIdxs = std::move(globalIdxs.front());
   }
 
+  return preprocessOutputs(blockInfo, tx, outputs, info);
+}
+
+std::error_code TransfersConsumer::preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx,
+  const std::unordered_map<PublicKey, std::vector<uint32_t>>& outputs, PreprocessInfo& info) {
+  std::error_code errorCode;
   for (const auto& kv : outputs) {
     auto it = m_subscriptions.find(kv.first);
     if (it != m_subscriptions.end()) {
@@ -540,16 +660,24 @@ void TransfersConsumer::processTransaction(const TransactionBlockInfo& blockInfo
   std::vector<TransactionOutputInformationIn> emptyOutputs;
   std::vector<ITransfersContainer*> transactionContainers;
   bool someContainerUpdated = false;
-  for (auto& kv : m_subscriptions) {
-    auto it = info.outputs.find(kv.first);
+  for (TransfersSubscription* sub : getAffectedSubscriptions(tx, info)) {
+    auto it = info.outputs.find(sub->getKeys().address.spendPublicKey);
     auto& subscriptionOutputs = (it == info.outputs.end()) ? emptyOutputs : it->second;
 
     bool containerContainsTx;
     bool containerUpdated;
-    processOutputs(blockInfo, *kv.second, tx, subscriptionOutputs, info.globalIdxs, containerContainsTx, containerUpdated);
+    processOutputs(blockInfo, *sub, tx, subscriptionOutputs, info.globalIdxs, containerContainsTx, containerUpdated);
     someContainerUpdated = someContainerUpdated || containerUpdated;
     if (containerContainsTx) {
-      transactionContainers.emplace_back(&kv.second->getContainer());
+      transactionContainers.emplace_back(&sub->getContainer());
+    }
+
+    if (containerUpdated) {
+      for (const auto& output : subscriptionOutputs) {
+        if (output.type == TransactionTypes::OutputType::Key) {
+          m_keyImageOwners[output.keyImage] = sub;
+        }
+      }
     }
   }
 
@@ -558,6 +686,42 @@ void TransfersConsumer::processTransaction(const TransactionBlockInfo& blockInfo
   }
 }
 
+std::vector<TransfersSubscription*> TransfersConsumer::getAffectedSubscriptions(const ITransactionReader& tx, const PreprocessInfo& info) {
+  updateKeyImageIndex();
+
+  std::vector<TransfersSubscription*> subscriptions;
+  for (const auto& kv : info.outputs) {
+    auto it = m_subscriptions.find(kv.first);
+    if (it != m_subscriptions.end()) {
+      subscriptions.push_back(it->second.get());
+    }
+  }
+
+  for (size_t i = 0; i < tx.getInputCount(); ++i) {
+    auto inputType = tx.getInputType(i);
+    if (inputType == TransactionTypes::InputType::Key) {
+      KeyInput input;
+      tx.getInput(i, input);
+      auto it = m_keyImageOwners.find(input.keyImage);
+      if (it != m_keyImageOwners.end()) {
+        subscriptions.push_back(it->second);
+      }
+    } else if (inputType == TransactionTypes::InputType::Multisignature) {
+      // spent multisignature outputs are found by amount and global index, every container checks them
+      subscriptions.clear();
+      for (const auto& kv : m_subscriptions) {
+        subscriptions.push_back(kv.second.get());
+      }
+
+      return subscriptions;
+    }
+  }
+
+  std::sort(subscriptions.begin(), subscriptions.end());
+  subscriptions.erase(std::unique(subscriptions.begin(), subscriptions.end()), subscriptions.end());
+  return subscriptions;
+}
+
 void TransfersConsumer::processOutputs(const TransactionBlockInfo& blockInfo, TransfersSubscription& sub, const ITransactionReader& tx,
   const std::vector<TransactionOutputInformationIn>& transfers, const std::vector<uint32_t>& globalIdxs, bool& contains, bool& updated) {
 
@@ -579,7 +743,7 @@ void TransfersConsumer::processOutputs(const TransactionBlockInfo& blockInfo, Tr
   }
 }
 
-std::error_code TransfersConsumer::getGlobalIndices(const Hash& transactionHash, std::vector<uint32_t>& outsGlobalIndices) {  
+std::error_code TransfersConsumer::getGlobalIndices(const std::vector<Hash>& transactionHashes, std::vector<std::vector<uint32_t>>& outsGlobalIndices) {
   std::promise<std::error_code> prom;
   std::future<std::error_code> f = prom.get_future();
 
@@ -589,7 +753,7 @@ std::error_code TransfersConsumer::getGlobalIndices(const Hash& transactionHash,
   };
 
   outsGlobalIndices.clear();
-  m_node.getTransactionOutsGlobalIndices(transactionHash, outsGlobalIndices, cb);
+  m_node.getTransactionsOutsGlobalIndices(transactionHashes, outsGlobalIndices, cb);
 
   return f.get();
 }
@@ -41,12 +41,16 @@ public:
   TransfersConsumer(const CryptoNote::Currency& currency, INode& node, Logging::ILogger& logger, const Crypto::SecretKey& viewSecret);
 
   ITransfersSubscription& addSubscription(const AccountSubscription& subscription);
+  // adds many subscriptions in one pass, the sync start is updated once
+  std::vector<ITransfersSubscription*> addSubscriptions(const std::vector<AccountSubscription>& subscriptions);
   // returns true if no subscribers left
   bool removeSubscription(const AccountPublicAddress& address);
   ITransfersSubscription* getSubscription(const AccountPublicAddress& acc);
   void getSubscriptions(std::vector<AccountPublicAddress>& subscriptions);
 
   void initTransactionPool(const std::unordered_set<Crypto::Hash>& uncommitedTransactions);
+  // the containers were loaded, the key image index is rebuilt before the next transaction
+  void invalidateKeyImageIndex();
   void addPublicKeysSeen(const Crypto::Hash& transactionHash, const Crypto::PublicKey& outputKey);
   
   // IBlockchainConsumer
@@ -74,21 +78,30 @@ private:
   };
 
   std::error_code preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx, PreprocessInfo& info);
+  // outputs maps spend keys to the indexes of the outputs found for them, info.globalIdxs are already set for a confirmed transaction
+  std::error_code preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx,
+    const std::unordered_map<Crypto::PublicKey, std::vector<uint32_t>>& outputs, PreprocessInfo& info);
   std::error_code processTransaction(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx);
   void processTransaction(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx, const PreprocessInfo& info);
   void processOutputs(const TransactionBlockInfo& blockInfo, TransfersSubscription& sub, const ITransactionReader& tx,
     const std::vector<TransactionOutputInformationIn>& outputs, const std::vector<uint32_t>& globalIdxs, bool& contains, bool& updated);
   std::error_code createTransfers(const AccountKeys& account, const TransactionBlockInfo& blockInfo, const ITransactionReader& tx,
     const std::vector<uint32_t>& outputs, const std::vector<uint32_t>& globalIdxs, std::vector<TransactionOutputInformationIn>& transfers);
-  std::error_code getGlobalIndices(const Crypto::Hash& transactionHash, std::vector<uint32_t>& outsGlobalIndices);
+  std::error_code getGlobalIndices(const std::vector<Crypto::Hash>& transactionHashes, std::vector<std::vector<uint32_t>>& outsGlobalIndices);
 
   void updateSyncStart();
+  void updateKeyImageIndex();
+  // subscriptions a transaction pays to or spends from, only they can change with it
+  std::vector<TransfersSubscription*> getAffectedSubscriptions(const ITransactionReader& tx, const PreprocessInfo& info);
 
   SynchronizationStart m_syncStart;
   const Crypto::SecretKey m_viewSecret;
   // map { spend public key -> subscription }
   std::unordered_map<Crypto::PublicKey, std::unique_ptr<TransfersSubscription>> m_subscriptions;
   std::unordered_set<Crypto::PublicKey> m_spendKeys;
+  // owners of the key images of all outputs, may name a subscription whose output is gone
+  std::unordered_map<Crypto::KeyImage, TransfersSubscription*> m_keyImageOwners;
+  bool m_keyImageIndexValid;
   std::unordered_set<Crypto::Hash> m_poolTxs;
 
   INode& m_node;
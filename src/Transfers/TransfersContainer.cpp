@@ -43,6 +43,102 @@ void serialize(TransactionInformation& ti, CryptoNote::ISerializer& s) {
   s(ti.paymentId, "");
 }
 
+void TransactionRecord::serialize(ISerializer& s) {
+  CryptoNote::serialize(static_cast<TransactionInformation&>(*this), s);
+}
+
+TransactionOutputInformation TransactionOutputInformationEx::getOutputInformation() const {
+  TransactionOutputInformation info;
+  info.type = type;
+  info.amount = amount;
+  info.globalOutputIndex = globalOutputIndex;
+  info.outputInTransaction = outputInTransaction;
+  info.transactionHash = transaction->transactionHash;
+  info.transactionPublicKey = transaction->publicKey;
+  info.outputKey = outputKey;
+  return info;
+}
+
+struct TransfersContainer::StoredOutput {
+  TransactionTypes::OutputType type;
+  uint64_t amount;
+  uint32_t globalOutputIndex;
+  uint32_t outputInTransaction;
+  Crypto::PublicKey transactionPublicKey;
+  Crypto::KeyImage keyImage;
+  uint64_t unlockTime;
+  uint32_t blockHeight;
+  uint32_t transactionIndex;
+  Crypto::Hash transactionHash;
+  bool visible;
+
+  union {
+    Crypto::PublicKey outputKey;
+    uint32_t requiredSignatures;
+  };
+
+  StoredOutput() {
+  }
+
+  explicit StoredOutput(const TransactionOutputInformationEx& output) :
+    type(output.type),
+    amount(output.amount),
+    globalOutputIndex(output.globalOutputIndex),
+    outputInTransaction(output.outputInTransaction),
+    transactionPublicKey(output.transaction->publicKey),
+    keyImage(output.keyImage),
+    unlockTime(output.unlockTime()),
+    blockHeight(output.blockHeight()),
+    transactionIndex(output.transactionIndex()),
+    transactionHash(output.getTransactionHash()),
+    visible(output.visible),
+    outputKey(output.outputKey) {
+  }
+
+  void serialize(ISerializer& s) {
+    s(reinterpret_cast<uint8_t&>(type), "type");
+    s(amount, "");
+    serializeGlobalOutputIndex(s, globalOutputIndex, "");
+    s(outputInTransaction, "");
+    s(transactionPublicKey, "");
+    s(keyImage, "");
+    s(unlockTime, "");
+    serializeBlockHeight(s, blockHeight, "");
+    s(transactionIndex, "");
+    s(transactionHash, "");
+    s(visible, "");
+
+    if (type == TransactionTypes::OutputType::Key) {
+      s(outputKey, "");
+    } else if (type == TransactionTypes::OutputType::Multisignature) {
+      s(requiredSignatures, "");
+    }
+  }
+};
+
+struct TransfersContainer::StoredSpentOutput : StoredOutput {
+  TransactionBlockInfo spendingBlock;
+  Crypto::Hash spendingTransactionHash;
+  uint32_t inputInTransaction;
+
+  StoredSpentOutput() {
+  }
+
+  explicit StoredSpentOutput(const SpentTransactionOutput& output) :
+    StoredOutput(output),
+    spendingBlock(output.spendingBlock()),
+    spendingTransactionHash(output.getSpendingTransactionHash()),
+    inputInTransaction(output.inputInTransaction) {
+  }
+
+  void serialize(ISerializer& s) {
+    StoredOutput::serialize(s);
+    s(spendingBlock, "spendingBlock");
+    s(spendingTransactionHash, "spendingTransactionHash");
+    s(inputInTransaction, "inputInTransaction");
+  }
+};
+
 const uint32_t TRANSFERS_CONTAINER_STORAGE_VERSION = 0;
 
 namespace {
@@ -85,8 +181,8 @@ namespace {
   private:
     static bool lessTIterator(const TIterator& it1, const TIterator& it2) {
       return
-        (it1->blockHeight < it2->blockHeight) ||
-        (it1->blockHeight == it2->blockHeight && it1->transactionIndex < it2->transactionIndex);
+        (it1->blockHeight() < it2->blockHeight()) ||
+        (it1->blockHeight() == it2->blockHeight() && it1->transactionIndex() < it2->transactionIndex());
     }
 
   private:
@@ -98,6 +194,17 @@ namespace {
   TransferIteratorList<TIterator> createTransferIteratorList(const std::pair<TIterator, TIterator>& itPair) {
     return TransferIteratorList<TIterator>(itPair.first, itPair.second);
   }
+
+  template<typename TStored, typename TIterator>
+  void writeStoredSequence(TIterator begin, TIterator end, Common::StringView name, ISerializer& s) {
+    size_t size = std::distance(begin, end);
+    s.beginArray(size, name);
+    for (TIterator i = begin; i != end; ++i) {
+      TStored stored(*i);
+      s(stored, "");
+    }
+    s.endArray();
+  }
 }
 
 
@@ -119,6 +226,20 @@ SpentOutputDescriptor::SpentOutputDescriptor(const TransactionOutputInformationI
   }
 }
 
+SpentOutputDescriptor::SpentOutputDescriptor(const TransactionOutputInformationEx& transactionInfo) :
+    m_type(transactionInfo.type),
+    m_amount(0),
+    m_globalOutputIndex(0) {
+  if (m_type == TransactionTypes::OutputType::Key) {
+    m_keyImage = &transactionInfo.keyImage;
+  } else if (m_type == TransactionTypes::OutputType::Multisignature) {
+    m_amount = transactionInfo.amount;
+    m_globalOutputIndex = transactionInfo.globalOutputIndex;
+  } else {
+    assert(false);
+  }
+}
+
 SpentOutputDescriptor::SpentOutputDescriptor(const KeyImage* keyImage) {
   assign(keyImage);
 }
@@ -170,6 +291,7 @@ size_t SpentOutputDescriptor::hash() const {
 
 TransfersContainer::TransfersContainer(const Currency& currency, Logging::ILogger& logger, size_t transactionSpendableAge) :
   m_currentHeight(0),
+  m_balances(),
   m_currency(currency),
   m_logger(logger, "TransfersContainer"),
   m_transactionSpendableAge(transactionSpendableAge) {
@@ -178,9 +300,10 @@ TransfersContainer::TransfersContainer(const Currency& currency, Logging::ILogge
 bool TransfersContainer::addTransaction(const TransactionBlockInfo& block, const ITransactionReader& tx,
   const std::vector<TransactionOutputInformationIn>& transfers) {
 
-  try {
-    std::unique_lock<std::mutex> lock(m_mutex);
+  std::unique_lock<std::mutex> lock(m_mutex);
+  bool transactionAdded = false;
 
+  try {
     m_logger(TRACE) << "Adding transaction, block " << block.height << ", transaction index " << block.transactionIndex << ", hash " << tx.getTransactionHash();
 
     if (block.height < m_currentHeight) {
@@ -195,25 +318,29 @@ bool TransfersContainer::addTransaction(const TransactionBlockInfo& block, const
       throw std::invalid_argument(message);
     }
 
-    bool added = addTransactionOutputs(block, tx, transfers);
-    added |= addTransactionInputs(block, tx);
+    // the outputs and inputs refer to the transaction, so it is added first and removed if it turns out to be foreign
+    const TransactionRecord& transaction = addTransaction(block, tx);
+    transactionAdded = true;
+    bool added = addTransactionOutputs(transaction, tx, transfers);
+    added |= addTransactionInputs(transaction, tx);
 
-    if (added) {
-      addTransaction(block, tx);
-    } else {
+    if (!added) {
+      m_transactions.erase(tx.getTransactionHash());
+      transactionAdded = false;
       m_logger(TRACE) << "Transaction not added";
     }
 
     if (block.height != WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT) {
-      m_currentHeight = block.height;
+      setCurrentHeight(block.height);
     }
 
     return added;
   } catch (...) {
-    if (m_transactions.count(tx.getTransactionHash()) == 0) {
+    if (transactionAdded) {
       m_logger(ERROR, BRIGHT_RED) << "Failed to add transaction, remove transaction transfers, block " << block.height <<
         ", transaction hash " << tx.getTransactionHash();
       deleteTransactionTransfers(tx.getTransactionHash());
+      m_transactions.erase(tx.getTransactionHash());
     }
 
     throw;
@@ -223,11 +350,12 @@ bool TransfersContainer::addTransaction(const TransactionBlockInfo& block, const
 /**
  * \pre m_mutex is locked.
  */
-void TransfersContainer::addTransaction(const TransactionBlockInfo& block, const ITransactionReader& tx) {
+const TransactionRecord& TransfersContainer::addTransaction(const TransactionBlockInfo& block, const ITransactionReader& tx) {
   auto txHash = tx.getTransactionHash();
 
-  TransactionInformation txInfo;
+  TransactionRecord txInfo;
   txInfo.blockHeight = block.height;
+  txInfo.transactionIndex = block.transactionIndex;
   txInfo.timestamp = block.timestamp;
   txInfo.transactionHash = txHash;
   txInfo.unlockTime = tx.getUnlockTime();
@@ -241,19 +369,18 @@ void TransfersContainer::addTransaction(const TransactionBlockInfo& block, const
   }
 
   auto result = m_transactions.emplace(std::move(txInfo));
-  (void)result; // Disable unused warning
   assert(result.second);
+  return *result.first;
 }
 
 /**
  * \pre m_mutex is locked.
  */
-bool TransfersContainer::addTransactionOutputs(const TransactionBlockInfo& block, const ITransactionReader& tx,
+bool TransfersContainer::addTransactionOutputs(const TransactionRecord& transaction, const ITransactionReader& tx,
                                                const std::vector<TransactionOutputInformationIn>& transfers) {
   bool outputsAdded = false;
 
-  auto txHash = tx.getTransactionHash();
-  bool transactionIsUnconfimed = (block.height == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
+  bool transactionIsUnconfimed = (transaction.blockHeight == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
   for (const auto& transfer : transfers) {
     assert(transfer.outputInTransaction < tx.getOutputCount());
     assert(transfer.type == tx.getOutputType(transfer.outputInTransaction));
@@ -267,11 +394,13 @@ bool TransfersContainer::addTransactionOutputs(const TransactionBlockInfo& block
     }
 
     TransactionOutputInformationEx info;
-    static_cast<TransactionOutputInformationIn&>(info) = transfer;
-    info.blockHeight = block.height;
-    info.transactionIndex = block.transactionIndex;
-    info.unlockTime = tx.getUnlockTime();
-    info.transactionHash = txHash;
+    info.transaction = &transaction;
+    info.outputKey = transfer.outputKey;
+    info.keyImage = transfer.keyImage;
+    info.amount = transfer.amount;
+    info.globalOutputIndex = transfer.globalOutputIndex;
+    info.outputInTransaction = transfer.outputInTransaction;
+    info.type = transfer.type;
     info.visible = true;
 
     if (transferIsUnconfirmed) {
@@ -285,21 +414,21 @@ bool TransfersContainer::addTransactionOutputs(const TransactionBlockInfo& block
 
         auto availableRange = m_availableTransfers.get<SpentOutputDescriptorIndex>().equal_range(descriptor);
         for (auto it = availableRange.first; !duplicate && it != availableRange.second; ++it) {
-          if (it->transactionHash == info.transactionHash && it->outputInTransaction == info.outputInTransaction) {
+          if (it->transaction == info.transaction && it->outputInTransaction == info.outputInTransaction) {
             duplicate = true;
           }
         }
 
         auto spentRange = m_spentTransfers.get<SpentOutputDescriptorIndex>().equal_range(descriptor);
         for (auto it = spentRange.first; !duplicate && it != spentRange.second; ++it) {
-          if (it->transactionHash == info.transactionHash && it->outputInTransaction == info.outputInTransaction) {
+          if (it->transaction == info.transaction && it->outputInTransaction == info.outputInTransaction) {
             duplicate = true;
           }
         }
 
         if (duplicate) {
           auto message = "Failed to add transaction output: key output already exists";
-          m_logger(ERROR, BRIGHT_RED) << message << ", transaction hash " << info.transactionHash << ", output index " << info.outputInTransaction <<
+          m_logger(ERROR, BRIGHT_RED) << message << ", transaction hash " << transaction.transactionHash << ", output index " << info.outputInTransaction <<
             ", key image " << info.keyImage;
           throw std::runtime_error(message);
         }
@@ -314,8 +443,8 @@ bool TransfersContainer::addTransactionOutputs(const TransactionBlockInfo& block
       }
 
       auto result = m_availableTransfers.emplace(std::move(info));
-      (void)result; // Disable unused warning
       assert(result.second);
+      addToBalance(*result.first);
     }
 
     if (info.type == TransactionTypes::OutputType::Key) {
@@ -331,7 +460,7 @@ bool TransfersContainer::addTransactionOutputs(const TransactionBlockInfo& block
 /**
  * \pre m_mutex is locked.
  */
-bool TransfersContainer::addTransactionInputs(const TransactionBlockInfo& block, const ITransactionReader& tx) {
+bool TransfersContainer::addTransactionInputs(const TransactionRecord& transaction, const ITransactionReader& tx) {
   bool inputsAdded = false;
 
   for (size_t i = 0; i < tx.getInputCount(); ++i) {
@@ -349,18 +478,18 @@ bool TransfersContainer::addTransactionInputs(const TransactionBlockInfo& block,
         auto message = "Failed add key input: key image already spent";
         m_logger(ERROR, BRIGHT_RED) << message << ", key image " << input.keyImage << '\n' <<
           "    rejected transaction" <<
-          ": hash " << tx.getTransactionHash() <<
-          ", block " << block.height <<
-          ", transaction index " << block.transactionIndex <<
+          ": hash " << transaction.transactionHash <<
+          ", block " << transaction.blockHeight <<
+          ", transaction index " << transaction.transactionIndex <<
           ", input " << i << '\n' <<
           "    spending transaction" <<
-          ": hash " << spentOutput.spendingTransactionHash <<
-          ", block " << spentOutput.spendingBlock.height <<
+          ": hash " << spentOutput.getSpendingTransactionHash() <<
+          ", block " << spentOutput.spendingTransaction->blockHeight <<
           ", input " << spentOutput.inputInTransaction << '\n' <<
           "    spent output        " <<
-          ": hash " << spentOutput.transactionHash <<
-          ", block " << spentOutput.blockHeight <<
-          ", transaction index " << spentOutput.transactionIndex <<
+          ": hash " << spentOutput.getTransactionHash() <<
+          ", block " << spentOutput.blockHeight() <<
+          ", transaction index " << spentOutput.transactionIndex() <<
           ", output " << spentOutput.outputInTransaction <<
           ", amount " << m_currency.formatAmount(spentOutput.amount);
         throw std::runtime_error(message);
@@ -396,8 +525,9 @@ bool TransfersContainer::addTransactionInputs(const TransactionBlockInfo& block,
       }
 
       assert(spendingTransferIt->keyImage == input.keyImage);
-      copyToSpent(block, tx, i, *spendingTransferIt);
+      copyToSpent(transaction, i, *spendingTransferIt);
       // erase from available outputs
+      removeFromBalance(*spendingTransferIt);
       outputDescriptorIndex.erase(spendingTransferIt);
       updateTransfersVisibility(input.keyImage);
 
@@ -409,8 +539,9 @@ bool TransfersContainer::addTransactionInputs(const TransactionBlockInfo& block,
       auto& outputDescriptorIndex = m_availableTransfers.get<SpentOutputDescriptorIndex>();
       auto availableOutputIt = outputDescriptorIndex.find(SpentOutputDescriptor(input.amount, input.outputIndex));
       if (availableOutputIt != outputDescriptorIndex.end()) {
-        copyToSpent(block, tx, i, *availableOutputIt);
+        copyToSpent(transaction, i, *availableOutputIt);
         // erase from available outputs
+        removeFromBalance(*availableOutputIt);
         outputDescriptorIndex.erase(availableOutputIt);
 
         inputsAdded = true;
@@ -457,15 +588,16 @@ bool TransfersContainer::markTransactionConfirmed(const TransactionBlockInfo& bl
     return false;
   }
 
+  // the outputs and inputs of the transaction see the new block through its record
   auto txInfo = *transactionIt;
   txInfo.blockHeight = block.height;
   txInfo.timestamp = block.timestamp;
+  txInfo.transactionIndex = block.transactionIndex;
   m_transactions.replace(transactionIt, txInfo);
 
   auto availableRange = m_unconfirmedTransfers.get<ContainingTransactionIndex>().equal_range(transactionHash);
   for (auto transferIt = availableRange.first; transferIt != availableRange.second; ) {
     auto transfer = *transferIt;
-    assert(transfer.blockHeight == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
     assert(transfer.globalOutputIndex == UNCONFIRMED_TRANSACTION_GLOBAL_OUTPUT_INDEX);
     if (transfer.outputInTransaction >= globalIndices.size()) {
       auto message = "Failed to confirm transaction: not enough elements in globalIndices";
@@ -473,8 +605,6 @@ bool TransfersContainer::markTransactionConfirmed(const TransactionBlockInfo& bl
       throw std::invalid_argument(message);
     }
 
-    transfer.blockHeight = block.height;
-    transfer.transactionIndex = block.transactionIndex;
     transfer.globalOutputIndex = globalIndices[transfer.outputInTransaction];
 
     if (transfer.type == TransactionTypes::OutputType::Multisignature) {
@@ -489,8 +619,8 @@ bool TransfersContainer::markTransactionConfirmed(const TransactionBlockInfo& bl
     }
 
     auto result = m_availableTransfers.emplace(std::move(transfer));
-    (void)result; // Disable unused warning
     assert(result.second);
+    addToBalance(*result.first);
 
     transferIt = m_unconfirmedTransfers.get<ContainingTransactionIndex>().erase(transferIt);
 
@@ -499,16 +629,6 @@ bool TransfersContainer::markTransactionConfirmed(const TransactionBlockInfo& bl
     }
   }
 
-  auto& spendingTransactionIndex = m_spentTransfers.get<SpendingTransactionIndex>();
-  auto spentRange = spendingTransactionIndex.equal_range(transactionHash);
-  for (auto transferIt = spentRange.first; transferIt != spentRange.second; ++transferIt) {
-    auto transfer = *transferIt;
-    assert(transfer.spendingBlock.height == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
-
-    transfer.spendingBlock = block;
-    spendingTransactionIndex.replace(transferIt, transfer);
-  }
-
   return true;
 }
 
@@ -519,11 +639,12 @@ void TransfersContainer::deleteTransactionTransfers(const Hash& transactionHash)
   auto& spendingTransactionIndex = m_spentTransfers.get<SpendingTransactionIndex>();
   auto spentTransfersRange = spendingTransactionIndex.equal_range(transactionHash);
   for (auto it = spentTransfersRange.first; it != spentTransfersRange.second;) {
-    assert(it->blockHeight != WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
+    assert(it->blockHeight() != WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
     assert(it->globalOutputIndex != UNCONFIRMED_TRANSACTION_GLOBAL_OUTPUT_INDEX);
 
     auto result = m_availableTransfers.emplace(static_cast<const TransactionOutputInformationEx&>(*it));
     assert(result.second);
+    addToBalance(*result.first);
     it = spendingTransactionIndex.erase(it);
 
     if (result.first->type == TransactionTypes::OutputType::Key) {
@@ -545,6 +666,7 @@ void TransfersContainer::deleteTransactionTransfers(const Hash& transactionHash)
   auto& transactionTransfersIndex = m_availableTransfers.get<ContainingTransactionIndex>();
   auto transactionTransfersRange = transactionTransfersIndex.equal_range(transactionHash);
   for (auto it = transactionTransfersRange.first; it != transactionTransfersRange.second;) {
+    removeFromBalance(*it);
     if (it->type == TransactionTypes::OutputType::Key) {
       KeyImage keyImage = it->keyImage;
       it = transactionTransfersIndex.erase(it);
@@ -558,15 +680,13 @@ void TransfersContainer::deleteTransactionTransfers(const Hash& transactionHash)
 /**
  * \pre m_mutex is locked.
  */
-void TransfersContainer::copyToSpent(const TransactionBlockInfo& block, const ITransactionReader& tx, size_t inputIndex,
-                                     const TransactionOutputInformationEx& output) {
-  assert(output.blockHeight != WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
+void TransfersContainer::copyToSpent(const TransactionRecord& transaction, size_t inputIndex, const TransactionOutputInformationEx& output) {
+  assert(output.blockHeight() != WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
   assert(output.globalOutputIndex != UNCONFIRMED_TRANSACTION_GLOBAL_OUTPUT_INDEX);
 
   SpentTransactionOutput spentOutput;
   static_cast<TransactionOutputInformationEx&>(spentOutput) = output;
-  spentOutput.spendingBlock = block;
-  spentOutput.spendingTransactionHash = tx.getTransactionHash();
+  spentOutput.spendingTransaction = &transaction;
   spentOutput.inputInTransaction = static_cast<uint32_t>(inputIndex);
   auto result = m_spentTransfers.emplace(std::move(spentOutput));
   (void)result; // Disable unused warning
@@ -590,7 +710,7 @@ std::vector<Hash> TransfersContainer::detach(uint32_t height) {
     if (it->blockHeight == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT) {
       auto range = spendingTransactionIndex.equal_range(it->transactionHash);
       for (auto spentTransferIt = range.first; spentTransferIt != range.second; ++spentTransferIt) {
-        if (spentTransferIt->blockHeight >= height) {
+        if (spentTransferIt->blockHeight() >= height) {
           doDelete = true;
           break;
         }
@@ -609,20 +729,26 @@ std::vector<Hash> TransfersContainer::detach(uint32_t height) {
   }
 
   // TODO: notification on detach
-  m_currentHeight = height == 0 ? 0 : height - 1;
+  setCurrentHeight(height == 0 ? 0 : height - 1);
 
   return deletedTransactions;
 }
 
 namespace {
-  template<typename C, typename T>
-  void updateVisibility(C& collection, const T& range, bool visible) {
+  template<typename C, typename T, typename F>
+  void updateVisibility(C& collection, const T& range, bool visible, F&& onUpdate) {
     for (auto it = range.first; it != range.second; ++it) {
       auto updated = *it;
       updated.visible = visible;
+      onUpdate(*it, updated);
       collection.replace(it, updated);
     }
   }
+
+  template<typename C, typename T>
+  void updateVisibility(C& collection, const T& range, bool visible) {
+    updateVisibility(collection, range, visible, [](const TransactionOutputInformationEx&, const TransactionOutputInformationEx&) {});
+  }
 }
 
 /**
@@ -643,13 +769,18 @@ void TransfersContainer::updateTransfersVisibility(const KeyImage& keyImage) {
   size_t spentCount = std::distance(spentRange.first, spentRange.second);
   assert(spentCount == 0 || spentCount == 1);
 
+  auto updateBalance = [this](const TransactionOutputInformationEx& transfer, const TransactionOutputInformationEx& updated) {
+    removeFromBalance(transfer);
+    addToBalance(updated);
+  };
+
   if (spentCount > 0) {
     updateVisibility(unconfirmedIndex, unconfirmedRange, false);
-    updateVisibility(availableIndex, availableRange, false);
+    updateVisibility(availableIndex, availableRange, false, updateBalance);
     updateVisibility(spentIndex, spentRange, true);
   } else if (availableCount > 0) {
     updateVisibility(unconfirmedIndex, unconfirmedRange, false);
-    updateVisibility(availableIndex, availableRange, false);
+    updateVisibility(availableIndex, availableRange, false, updateBalance);
 
     auto iteratorList = createTransferIteratorList(availableRange);
     auto earliestTransferIt = iteratorList.minElement();
@@ -657,6 +788,7 @@ void TransfersContainer::updateTransfersVisibility(const KeyImage& keyImage) {
 
     auto earliestTransfer = *earliestTransferIt;
     earliestTransfer.visible = true;
+    updateBalance(*earliestTransferIt, earliestTransfer);
     availableIndex.replace(earliestTransferIt, earliestTransfer);
   } else {
     updateVisibility(unconfirmedIndex, unconfirmedRange, unconfirmedCount == 1);
@@ -667,13 +799,120 @@ bool TransfersContainer::advanceHeight(uint32_t height) {
   std::lock_guard<std::mutex> lk(m_mutex);
 
   if (m_currentHeight <= height) {
-    m_currentHeight = height;
+    setCurrentHeight(height);
     return true;
   }
 
   return false;
 }
 
+size_t TransfersContainer::balanceIndex(TransactionTypes::OutputType type, uint32_t state) {
+  assert(type == TransactionTypes::OutputType::Key || type == TransactionTypes::OutputType::Multisignature);
+  assert(state == IncludeStateUnlocked || state == IncludeStateLocked || state == IncludeStateSoftLocked);
+  return (type == TransactionTypes::OutputType::Key ? 0 : 3) + (state >> 1);
+}
+
+/**
+ * \pre m_mutex is locked.
+ */
+void TransfersContainer::addToBalance(const TransactionOutputInformationEx& info) {
+  if (info.visible && !isLockedByTime(info)) {
+    m_balances[balanceIndex(info.type, getTransferState(info, m_currentHeight))] += info.amount;
+  }
+}
+
+/**
+ * \pre m_mutex is locked.
+ */
+void TransfersContainer::removeFromBalance(const TransactionOutputInformationEx& info) {
+  if (info.visible && !isLockedByTime(info)) {
+    m_balances[balanceIndex(info.type, getTransferState(info, m_currentHeight))] -= info.amount;
+  }
+}
+
+/**
+ * \pre m_mutex is locked.
+ */
+void TransfersContainer::rebuildBalances() {
+  m_balances.fill(0);
+  for (const auto& transfer : m_availableTransfers) {
+    addToBalance(transfer);
+  }
+}
+
+/**
+ * \pre m_mutex is locked.
+ *
+ * Only the transfers whose lock or soft lock ends between the current and the new height change their state,
+ * they are found through the unlock time and block height indices and moved between the balances.
+ */
+void TransfersContainer::setCurrentHeight(uint32_t height) {
+  uint32_t previousHeight = m_currentHeight;
+  uint64_t low = std::min(previousHeight, height);
+  uint64_t high = std::max(previousHeight, height);
+
+  auto moveBalance = [this, previousHeight, height](const TransactionOutputInformationEx& transfer) {
+    if (transfer.visible) {
+      m_balances[balanceIndex(transfer.type, getTransferState(transfer, previousHeight))] -= transfer.amount;
+      m_balances[balanceIndex(transfer.type, getTransferState(transfer, height))] += transfer.amount;
+    }
+  };
+
+  // the lock of a transfer ends when its unlock time is reached by the height plus the allowed delta
+  uint64_t lockDelta = m_currency.lockedTxAllowedDeltaBlocks();
+  uint64_t firstUnlockTime = low + lockDelta + 1;
+  uint64_t lastUnlockTime = std::min<uint64_t>(high + lockDelta, m_currency.maxBlockHeight() - 1);
+  auto isUnlockedInRange = [firstUnlockTime, lastUnlockTime](const TransactionOutputInformationEx& transfer) {
+    return transfer.unlockTime() >= firstUnlockTime && transfer.unlockTime() <= lastUnlockTime;
+  };
+
+  if (firstUnlockTime <= lastUnlockTime) {
+    const auto& unlockTimeIndex = m_availableTransfers.get<UnlockTimeIndex>();
+    auto end = unlockTimeIndex.upper_bound(lastUnlockTime);
+    for (auto it = unlockTimeIndex.lower_bound(firstUnlockTime); it != end; ++it) {
+      moveBalance(*it);
+    }
+  }
+
+  // the soft lock ends transactionSpendableAge blocks after the transaction
+  if (high >= m_transactionSpendableAge) {
+    uint64_t firstBlockHeight = low + 1 > m_transactionSpendableAge ? low + 1 - m_transactionSpendableAge : 0;
+    uint64_t lastBlockHeight = high - m_transactionSpendableAge;
+    const auto& blockHeightIndex = m_availableTransfers.get<BlockHeightIndex>();
+    auto end = blockHeightIndex.upper_bound(static_cast<uint32_t>(lastBlockHeight));
+    for (auto it = blockHeightIndex.lower_bound(static_cast<uint32_t>(firstBlockHeight)); it != end; ++it) {
+      if (!isLockedByTime(*it) && !isUnlockedInRange(*it)) {
+        moveBalance(*it);
+      }
+    }
+  }
+
+  m_currentHeight = height;
+}
+
+void TransfersContainer::getKeyImages(std::vector<Crypto::KeyImage>& keyImages) const {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  keyImages.reserve(keyImages.size() + m_unconfirmedTransfers.size() + m_availableTransfers.size() + m_spentTransfers.size());
+
+  auto addKeyImage = [&keyImages](const TransactionOutputInformationEx& output) {
+    if (output.type == TransactionTypes::OutputType::Key) {
+      keyImages.push_back(output.keyImage);
+    }
+  };
+
+  for (const auto& output : m_unconfirmedTransfers) {
+    addKeyImage(output);
+  }
+
+  for (const auto& output : m_availableTransfers) {
+    addKeyImage(output);
+  }
+
+  for (const auto& output : m_spentTransfers) {
+    addKeyImage(output);
+  }
+}
+
 size_t TransfersContainer::transfersCount() const {
   std::lock_guard<std::mutex> lk(m_mutex);
   return m_unconfirmedTransfers.size() + m_availableTransfers.size() + m_spentTransfers.size();
@@ -688,9 +927,18 @@ uint64_t TransfersContainer::balance(uint32_t flags) const {
   std::lock_guard<std::mutex> lk(m_mutex);
   uint64_t amount = 0;
 
-  for (const auto& t : m_availableTransfers) {
-    if (t.visible && isIncluded(t, flags)) {
-      amount += t.amount;
+  for (auto type : { TransactionTypes::OutputType::Key, TransactionTypes::OutputType::Multisignature }) {
+    for (uint32_t state : { IncludeStateUnlocked, IncludeStateLocked, IncludeStateSoftLocked }) {
+      if (isIncluded(type, state, flags)) {
+        amount += m_balances[balanceIndex(type, state)];
+      }
+    }
+  }
+
+  const auto& unlockTimeIndex = m_availableTransfers.get<UnlockTimeIndex>();
+  for (auto it = unlockTimeIndex.lower_bound(m_currency.maxBlockHeight()); it != unlockTimeIndex.end(); ++it) {
+    if (it->visible && isIncluded(*it, flags)) {
+      amount += it->amount;
     }
   }
 
@@ -709,19 +957,35 @@ void TransfersContainer::getOutputs(std::vector<TransactionOutputInformation>& t
   std::lock_guard<std::mutex> lk(m_mutex);
   for (const auto& t : m_availableTransfers) {
     if (t.visible && isIncluded(t, flags)) {
-      transfers.push_back(t);
+      transfers.push_back(t.getOutputInformation());
     }
   }
 
   if ((flags & IncludeStateLocked) != 0) {
     for (const auto& t : m_unconfirmedTransfers) {
       if (t.visible && isIncluded(t.type, IncludeStateLocked, flags)) {
-        transfers.push_back(t);
+        transfers.push_back(t.getOutputInformation());
       }
     }
   }
 }
 
+void TransfersContainer::getLargestOutputs(std::vector<TransactionOutputInformation>& transfers, uint32_t flags,
+                                           uint64_t amount, size_t minCount) const {
+  std::lock_guard<std::mutex> lk(m_mutex);
+
+  uint64_t foundAmount = 0;
+  size_t foundCount = 0;
+  const auto& amountIndex = m_availableTransfers.get<AmountIndex>();
+  for (auto it = amountIndex.rbegin(); it != amountIndex.rend() && (foundAmount < amount || foundCount < minCount); ++it) {
+    if (it->visible && isIncluded(*it, flags)) {
+      transfers.push_back(it->getOutputInformation());
+      foundAmount += it->amount;
+      ++foundCount;
+    }
+  }
+}
+
 bool TransfersContainer::getTransactionInformation(const Hash& transactionHash, TransactionInformation& info, uint64_t* amountIn, uint64_t* amountOut) const {
   std::lock_guard<std::mutex> lk(m_mutex);
   auto it = m_transactions.find(transactionHash);
@@ -773,7 +1037,7 @@ std::vector<TransactionOutputInformation> TransfersContainer::getTransactionOutp
   for (auto i = availableRange.first; i != availableRange.second; ++i) {
     const auto& t = *i;
     if (isIncluded(t, flags)) {
-      result.push_back(t);
+      result.push_back(t.getOutputInformation());
     }
   }
 
@@ -781,7 +1045,7 @@ std::vector<TransactionOutputInformation> TransfersContainer::getTransactionOutp
     auto unconfirmedRange = m_unconfirmedTransfers.get<ContainingTransactionIndex>().equal_range(transactionHash);
     for (auto i = unconfirmedRange.first; i != unconfirmedRange.second; ++i) {
       if (isIncluded(i->type, IncludeStateLocked, flags)) {
-        result.push_back(*i);
+        result.push_back(i->getOutputInformation());
       }
     }
   }
@@ -790,7 +1054,7 @@ std::vector<TransactionOutputInformation> TransfersContainer::getTransactionOutp
     auto spentRange = m_spentTransfers.get<ContainingTransactionIndex>().equal_range(transactionHash);
     for (auto i = spentRange.first; i != spentRange.second; ++i) {
       if (isIncluded(i->type, IncludeStateAll, flags)) {
-        result.push_back(*i);
+        result.push_back(i->getOutputInformation());
       }
     }
   }
@@ -809,7 +1073,7 @@ std::vector<TransactionOutputInformation> TransfersContainer::getTransactionInpu
   auto transactionInputsRange = m_spentTransfers.get<SpendingTransactionIndex>().equal_range(transactionHash);
   for (auto it = transactionInputsRange.first; it != transactionInputsRange.second; ++it) {
     if (isIncluded(it->type, IncludeStateUnlocked, flags)) {
-      result.push_back(*it);
+      result.push_back(it->getOutputInformation());
     }
   }
 
@@ -835,11 +1099,11 @@ std::vector<TransactionSpentOutputInformation> TransfersContainer::getSpentOutpu
 
   for (const auto& o : m_spentTransfers) {
     TransactionSpentOutputInformation spentOutput;
-    static_cast<TransactionOutputInformation&>(spentOutput) = o;
+    static_cast<TransactionOutputInformation&>(spentOutput) = o.getOutputInformation();
 
-    spentOutput.spendingBlockHeight = o.spendingBlock.height;
-    spentOutput.timestamp = o.spendingBlock.timestamp;
-    spentOutput.spendingTransactionHash = o.spendingTransactionHash;
+    spentOutput.spendingBlockHeight = o.spendingTransaction->blockHeight;
+    spentOutput.timestamp = o.spendingTransaction->timestamp;
+    spentOutput.spendingTransactionHash = o.getSpendingTransactionHash();
     spentOutput.keyImage = o.keyImage;
     spentOutput.inputInTransaction = o.inputInTransaction;
 
@@ -857,10 +1121,10 @@ void TransfersContainer::save(std::ostream& os) {
   s(const_cast<uint32_t&>(TRANSFERS_CONTAINER_STORAGE_VERSION), "version");
 
   s(m_currentHeight, "height");
-  writeSequence<TransactionInformation>(m_transactions.begin(), m_transactions.end(), "transactions", s);
-  writeSequence<TransactionOutputInformationEx>(m_unconfirmedTransfers.begin(), m_unconfirmedTransfers.end(), "unconfirmedTransfers", s);
-  writeSequence<TransactionOutputInformationEx>(m_availableTransfers.begin(), m_availableTransfers.end(), "availableTransfers", s);
-  writeSequence<SpentTransactionOutput>(m_spentTransfers.begin(), m_spentTransfers.end(), "spentTransfers", s);
+  writeSequence<TransactionRecord>(m_transactions.begin(), m_transactions.end(), "transactions", s);
+  writeStoredSequence<StoredOutput>(m_unconfirmedTransfers.begin(), m_unconfirmedTransfers.end(), "unconfirmedTransfers", s);
+  writeStoredSequence<StoredOutput>(m_availableTransfers.begin(), m_availableTransfers.end(), "availableTransfers", s);
+  writeStoredSequence<StoredSpentOutput>(m_spentTransfers.begin(), m_spentTransfers.end(), "spentTransfers", s);
 }
 
 void TransfersContainer::load(std::istream& in) {
@@ -879,108 +1143,160 @@ void TransfersContainer::load(std::istream& in) {
 
   uint32_t currentHeight = 0;
   TransactionMultiIndex transactions;
-  UnconfirmedTransfersMultiIndex unconfirmedTransfers;
-  AvailableTransfersMultiIndex availableTransfers;
-  SpentTransfersMultiIndex spentTransfers;
+  std::vector<StoredOutput> unconfirmedTransfers;
+  std::vector<StoredOutput> availableTransfers;
+  std::vector<StoredSpentOutput> spentTransfers;
 
   s(currentHeight, "height");
-  readSequence<TransactionInformation>(std::inserter(transactions, transactions.end()), "transactions", s);
-  readSequence<TransactionOutputInformationEx>(std::inserter(unconfirmedTransfers, unconfirmedTransfers.end()), "unconfirmedTransfers", s);
-  readSequence<TransactionOutputInformationEx>(std::inserter(availableTransfers, availableTransfers.end()), "availableTransfers", s);
-  readSequence<SpentTransactionOutput>(std::inserter(spentTransfers, spentTransfers.end()), "spentTransfers", s);
+  readSequence<TransactionRecord>(std::inserter(transactions, transactions.end()), "transactions", s);
+  readSequence<StoredOutput>(std::back_inserter(unconfirmedTransfers), "unconfirmedTransfers", s);
+  readSequence<StoredOutput>(std::back_inserter(availableTransfers), "availableTransfers", s);
+  readSequence<StoredSpentOutput>(std::back_inserter(spentTransfers), "spentTransfers", s);
 
   m_currentHeight = currentHeight;
-  m_transactions = std::move(transactions);
-  m_unconfirmedTransfers = std::move(unconfirmedTransfers);
-  m_availableTransfers = std::move(availableTransfers);
-  m_spentTransfers = std::move(spentTransfers);
+  m_unconfirmedTransfers.clear();
+  m_availableTransfers.clear();
+  m_spentTransfers.clear();
+  m_transactions.swap(transactions);
 
-  // Repair the container if it was broken while handling addTransaction() in previous version of the code
-  repair();
+  restoreTransfers(unconfirmedTransfers, availableTransfers, spentTransfers);
 }
 
-void TransfersContainer::repair() {
+/**
+ * \pre m_mutex is locked, m_transactions is loaded and the transfer containers are empty.
+ *
+ * Links the stored transfers to their transactions. Transfers of transactions that are not in the container
+ * could be stored while handling addTransaction() in previous version of the code, the container is repaired
+ * by dropping them and returning the outputs spent by orphan inputs to available outputs.
+ */
+void TransfersContainer::restoreTransfers(const std::vector<StoredOutput>& unconfirmedTransfers,
+                                          const std::vector<StoredOutput>& availableTransfers,
+                                          const std::vector<StoredSpentOutput>& spentTransfers) {
+  auto findTransaction = [this](const Hash& transactionHash, uint32_t transactionIndex) -> const TransactionRecord* {
+    auto it = m_transactions.find(transactionHash);
+    if (it == m_transactions.end()) {
+      return nullptr;
+    }
+
+    m_transactions.modify(it, [transactionIndex](TransactionRecord& transaction) { transaction.transactionIndex = transactionIndex; });
+    return &*it;
+  };
+
+  auto restoreOutput = [](const StoredOutput& stored, const TransactionRecord& transaction) {
+    TransactionOutputInformationEx output;
+    output.transaction = &transaction;
+    output.outputKey = stored.outputKey;
+    output.keyImage = stored.keyImage;
+    output.amount = stored.amount;
+    output.globalOutputIndex = stored.globalOutputIndex;
+    output.outputInTransaction = stored.outputInTransaction;
+    output.type = stored.type;
+    output.visible = stored.visible;
+    return output;
+  };
+
+  std::vector<KeyImage> changedKeyImages;
+
   size_t deletedInputCount = 0;
-  for (auto it = m_spentTransfers.begin(); it != m_spentTransfers.end();) {
-    assert(it->blockHeight != WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
-    assert(it->globalOutputIndex != UNCONFIRMED_TRANSACTION_GLOBAL_OUTPUT_INDEX);
+  size_t deletedAvailableOutputCount = 0;
+  for (const auto& stored : spentTransfers) {
+    assert(stored.blockHeight != WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
+    assert(stored.globalOutputIndex != UNCONFIRMED_TRANSACTION_GLOBAL_OUTPUT_INDEX);
+
+    const TransactionRecord* transaction = findTransaction(stored.transactionHash, stored.transactionIndex);
+    const TransactionRecord* spendingTransaction = findTransaction(stored.spendingTransactionHash, stored.spendingBlock.transactionIndex);
+    if (transaction != nullptr && spendingTransaction != nullptr) {
+      SpentTransactionOutput spentOutput;
+      static_cast<TransactionOutputInformationEx&>(spentOutput) = restoreOutput(stored, *transaction);
+      spentOutput.spendingTransaction = spendingTransaction;
+      spentOutput.inputInTransaction = stored.inputInTransaction;
+      auto result = m_spentTransfers.emplace(std::move(spentOutput));
+      (void)result; // Disable unused warning
+      assert(result.second);
+      continue;
+    }
 
-    if (m_transactions.count(it->spendingTransactionHash) == 0) {
-      bool isInputConfirmed = it->spendingBlock.height != WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT;
+    if (spendingTransaction == nullptr) {
+      bool isInputConfirmed = stored.spendingBlock.height != WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT;
       m_logger(WARNING, BRIGHT_YELLOW) << "Orphan input found, remove it and return output spent by them to available outputs:\n" <<
         "    input       " <<
-        ": block " << std::setw(7) << (isInputConfirmed ? static_cast<int32_t>(it->spendingBlock.height) : -1) <<
-        ", transaction index " << std::setw(2) << (isInputConfirmed ? static_cast<int32_t>(it->spendingBlock.transactionIndex) : -1) <<
-        ", transaction hash " << it->spendingTransactionHash <<
-        ", input " << std::setw(3) << it->inputInTransaction << '\n' <<
+        ": block " << std::setw(7) << (isInputConfirmed ? static_cast<int32_t>(stored.spendingBlock.height) : -1) <<
+        ", transaction index " << std::setw(2) << (isInputConfirmed ? static_cast<int32_t>(stored.spendingBlock.transactionIndex) : -1) <<
+        ", transaction hash " << stored.spendingTransactionHash <<
+        ", input " << std::setw(3) << stored.inputInTransaction << '\n' <<
         "    spent output" <<
-        ": block " << std::setw(7) << it->blockHeight <<
-        ", transaction index " << std::setw(2) << it->transactionIndex <<
-        ", transaction hash " << it->transactionHash <<
-        ", output " << std::setw(2) << it->outputInTransaction;
-
-      auto result = m_availableTransfers.emplace(static_cast<const TransactionOutputInformationEx&>(*it));
-      assert(result.second);
-      it = m_spentTransfers.erase(it);
-
-      if (result.first->type == TransactionTypes::OutputType::Key) {
-        updateTransfersVisibility(result.first->keyImage);
-      }
-
+        ": block " << std::setw(7) << stored.blockHeight <<
+        ", transaction index " << std::setw(2) << stored.transactionIndex <<
+        ", transaction hash " << stored.transactionHash <<
+        ", output " << std::setw(2) << stored.outputInTransaction;
       ++deletedInputCount;
+    }
+
+    if (transaction == nullptr) {
+      m_logger(WARNING, BRIGHT_YELLOW) << "Orphan output found, remove it" <<
+        ", block " << std::setw(7) << stored.blockHeight <<
+        ", transaction index " << std::setw(2) << stored.transactionIndex <<
+        ", transaction hash " << stored.transactionHash <<
+        ", output " << std::setw(2) << stored.outputInTransaction <<
+        ", amount " << m_currency.formatAmount(stored.amount);
+      ++deletedAvailableOutputCount;
     } else {
-      ++it;
+      m_availableTransfers.emplace(restoreOutput(stored, *transaction));
+    }
+
+    if (stored.type == TransactionTypes::OutputType::Key) {
+      changedKeyImages.push_back(stored.keyImage);
     }
   }
 
   size_t deletedUnconfirmedOutputCount = 0;
-  for (auto it = m_unconfirmedTransfers.begin(); it != m_unconfirmedTransfers.end();) {
-    assert(it->blockHeight == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
-
-    if (m_transactions.count(it->transactionHash) == 0) {
-      m_logger(WARNING, BRIGHT_YELLOW) << "Orphan unconfirmed output found, remove it" <<
-        ", transaction hash " << it->transactionHash <<
-        ", output " << std::setw(2) << it->outputInTransaction <<
-        ", amount " << m_currency.formatAmount(it->amount);
-
-      if (it->type == TransactionTypes::OutputType::Key) {
-        KeyImage keyImage = it->keyImage;
-        it = m_unconfirmedTransfers.erase(it);
-        updateTransfersVisibility(keyImage);
-      } else {
-        it = m_unconfirmedTransfers.erase(it);
-      }
+  for (const auto& stored : unconfirmedTransfers) {
+    assert(stored.blockHeight == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
 
-      ++deletedUnconfirmedOutputCount;
-    } else {
-      ++it;
+    const TransactionRecord* transaction = findTransaction(stored.transactionHash, stored.transactionIndex);
+    if (transaction != nullptr) {
+      m_unconfirmedTransfers.emplace(restoreOutput(stored, *transaction));
+      continue;
     }
+
+    m_logger(WARNING, BRIGHT_YELLOW) << "Orphan unconfirmed output found, remove it" <<
+      ", transaction hash " << stored.transactionHash <<
+      ", output " << std::setw(2) << stored.outputInTransaction <<
+      ", amount " << m_currency.formatAmount(stored.amount);
+
+    if (stored.type == TransactionTypes::OutputType::Key) {
+      changedKeyImages.push_back(stored.keyImage);
+    }
+
+    ++deletedUnconfirmedOutputCount;
   }
 
-  size_t deletedAvailableOutputCount = 0;
-  for (auto it = m_availableTransfers.begin(); it != m_availableTransfers.end();) {
-    assert(it->blockHeight != WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
+  for (const auto& stored : availableTransfers) {
+    assert(stored.blockHeight != WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
 
-    if (m_transactions.count(it->transactionHash) == 0) {
-      m_logger(WARNING, BRIGHT_YELLOW) << "Orphan output found, remove it" <<
-        ", block " << std::setw(7) << it->blockHeight <<
-        ", transaction index " << std::setw(2) << it->transactionIndex <<
-        ", transaction hash " << it->transactionHash <<
-        ", output " << std::setw(2) << it->outputInTransaction <<
-        ", amount " << m_currency.formatAmount(it->amount);
-
-      if (it->type == TransactionTypes::OutputType::Key) {
-        KeyImage keyImage = it->keyImage;
-        it = m_availableTransfers.erase(it);
-        updateTransfersVisibility(keyImage);
-      } else {
-        it = m_availableTransfers.erase(it);
-      }
+    const TransactionRecord* transaction = findTransaction(stored.transactionHash, stored.transactionIndex);
+    if (transaction != nullptr) {
+      m_availableTransfers.emplace(restoreOutput(stored, *transaction));
+      continue;
+    }
 
-      ++deletedAvailableOutputCount;
-    } else {
-      ++it;
+    m_logger(WARNING, BRIGHT_YELLOW) << "Orphan output found, remove it" <<
+      ", block " << std::setw(7) << stored.blockHeight <<
+      ", transaction index " << std::setw(2) << stored.transactionIndex <<
+      ", transaction hash " << stored.transactionHash <<
+      ", output " << std::setw(2) << stored.outputInTransaction <<
+      ", amount " << m_currency.formatAmount(stored.amount);
+
+    if (stored.type == TransactionTypes::OutputType::Key) {
+      changedKeyImages.push_back(stored.keyImage);
     }
+
+    ++deletedAvailableOutputCount;
+  }
+
+  rebuildBalances();
+  for (const auto& keyImage : changedKeyImages) {
+    updateTransfersVisibility(keyImage);
   }
 
   if (deletedInputCount + deletedUnconfirmedOutputCount + deletedAvailableOutputCount > 0) {
@@ -993,10 +1309,10 @@ void TransfersContainer::repair() {
   }
 }
 
-bool TransfersContainer::isSpendTimeUnlocked(uint64_t unlockTime) const {
+bool TransfersContainer::isSpendTimeUnlocked(uint64_t unlockTime, uint32_t height) const {
   if (unlockTime < m_currency.maxBlockHeight()) {
     // interpret as block index
-    return m_currentHeight + m_currency.lockedTxAllowedDeltaBlocks() >= unlockTime;
+    return height + m_currency.lockedTxAllowedDeltaBlocks() >= unlockTime;
   } else {
     //interpret as time
     uint64_t current_time = static_cast<uint64_t>(time(NULL));
@@ -1006,17 +1322,23 @@ bool TransfersContainer::isSpendTimeUnlocked(uint64_t unlockTime) const {
   return false;
 }
 
-bool TransfersContainer::isIncluded(const TransactionOutputInformationEx& info, uint32_t flags) const {
-  uint32_t state;
-  if (info.blockHeight == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT || !isSpendTimeUnlocked(info.unlockTime)) {
-    state = IncludeStateLocked;
-  } else if (m_currentHeight < info.blockHeight + m_transactionSpendableAge) {
-    state = IncludeStateSoftLocked;
+bool TransfersContainer::isLockedByTime(const TransactionOutputInformationEx& info) const {
+  return info.unlockTime() >= m_currency.maxBlockHeight();
+}
+
+uint32_t TransfersContainer::getTransferState(const TransactionOutputInformationEx& info, uint32_t height) const {
+  const TransactionRecord& transaction = *info.transaction;
+  if (transaction.blockHeight == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT || !isSpendTimeUnlocked(transaction.unlockTime, height)) {
+    return IncludeStateLocked;
+  } else if (height < transaction.blockHeight + m_transactionSpendableAge) {
+    return IncludeStateSoftLocked;
   } else {
-    state = IncludeStateUnlocked;
+    return IncludeStateUnlocked;
   }
+}
 
-  return isIncluded(info.type, state, flags);
+bool TransfersContainer::isIncluded(const TransactionOutputInformationEx& info, uint32_t flags) const {
+  return isIncluded(info.type, getTransferState(info, m_currentHeight), flags);
 }
 
 bool TransfersContainer::isIncluded(TransactionTypes::OutputType type, uint32_t state, uint32_t flags) {
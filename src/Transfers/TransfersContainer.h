@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <unordered_map>
 #include <mutex>
@@ -41,11 +42,13 @@
 namespace CryptoNote {
 
 struct TransactionOutputInformationIn;
+struct TransactionOutputInformationEx;
 
 class SpentOutputDescriptor {
 public:
   SpentOutputDescriptor();
   SpentOutputDescriptor(const TransactionOutputInformationIn& transactionInfo);
+  SpentOutputDescriptor(const TransactionOutputInformationEx& transactionInfo);
   SpentOutputDescriptor(const Crypto::KeyImage* keyImage);
   SpentOutputDescriptor(uint64_t amount, uint32_t globalOutputIndex);
 
@@ -78,37 +81,6 @@ struct TransactionOutputInformationIn : public TransactionOutputInformation {
   Crypto::KeyImage keyImage;  //!< \attention Used only for TransactionTypes::OutputType::Key
 };
 
-struct TransactionOutputInformationEx : public TransactionOutputInformationIn {
-  uint64_t unlockTime;
-  uint32_t blockHeight;
-  uint32_t transactionIndex;
-  bool visible;
-
-  SpentOutputDescriptor getSpentOutputDescriptor() const { return SpentOutputDescriptor(*this); }
-  const Crypto::Hash& getTransactionHash() const { return transactionHash; }
-
-  void serialize(CryptoNote::ISerializer& s) {
-    s(reinterpret_cast<uint8_t&>(type), "type");
-    s(amount, "");
-    serializeGlobalOutputIndex(s, globalOutputIndex, "");
-    s(outputInTransaction, "");
-    s(transactionPublicKey, "");
-    s(keyImage, "");
-    s(unlockTime, "");
-    serializeBlockHeight(s, blockHeight, "");
-    s(transactionIndex, "");
-    s(transactionHash, "");
-    s(visible, "");
-
-    if (type == TransactionTypes::OutputType::Key) {
-      s(outputKey, "");
-    } else if (type == TransactionTypes::OutputType::Multisignature) {
-      s(requiredSignatures, "");
-    }
-  }
-
-};
-
 struct TransactionBlockInfo {
   uint32_t height;
   uint64_t timestamp;
@@ -121,20 +93,45 @@ struct TransactionBlockInfo {
   }
 };
 
+// Transaction kept by the container, shared by all its outputs and inputs
+struct TransactionRecord : TransactionInformation {
+  uint32_t transactionIndex = 0; // not serialized, restored from the transfers on load
+
+  void serialize(ISerializer& s);
+};
+
+// Output kept by the container. The transaction data are not copied into every output,
+// the output refers to the record of its transaction, which stays at the same address
+// for as long as the transaction is in the container.
+struct TransactionOutputInformationEx {
+  const TransactionRecord* transaction;
+  union {
+    Crypto::PublicKey outputKey; // Type: Key
+    uint32_t requiredSignatures; // Type: Multisignature
+  };
+  Crypto::KeyImage keyImage;  //!< \attention Used only for TransactionTypes::OutputType::Key
+  uint64_t amount;
+  uint32_t globalOutputIndex;
+  uint32_t outputInTransaction;
+  TransactionTypes::OutputType type;
+  bool visible;
+
+  SpentOutputDescriptor getSpentOutputDescriptor() const { return SpentOutputDescriptor(*this); }
+  const Crypto::Hash& getTransactionHash() const { return transaction->transactionHash; }
+  uint32_t blockHeight() const { return transaction->blockHeight; }
+  uint32_t transactionIndex() const { return transaction->transactionIndex; }
+  uint64_t unlockTime() const { return transaction->unlockTime; }
+
+  TransactionOutputInformation getOutputInformation() const;
+};
+
 struct SpentTransactionOutput : TransactionOutputInformationEx {
-  TransactionBlockInfo spendingBlock;
-  Crypto::Hash spendingTransactionHash;
+  const TransactionRecord* spendingTransaction;
   uint32_t inputInTransaction;
 
-  const Crypto::Hash& getSpendingTransactionHash() const {
-    return spendingTransactionHash;
-  }
-
-  void serialize(ISerializer& s) {
-    TransactionOutputInformationEx::serialize(s);
-    s(spendingBlock, "spendingBlock");
-    s(spendingTransactionHash, "spendingTransactionHash");
-    s(inputInTransaction, "inputInTransaction");
+  const Crypto::Hash& getSpendingTransactionHash() const { return spendingTransaction->transactionHash; }
+  TransactionBlockInfo spendingBlock() const {
+    return { spendingTransaction->blockHeight, spendingTransaction->timestamp, spendingTransaction->transactionIndex };
   }
 };
 
@@ -159,12 +156,15 @@ public:
 
   std::vector<Crypto::Hash> detach(uint32_t height);
   bool advanceHeight(uint32_t height);
+  // key images of the key outputs, spent or not
+  void getKeyImages(std::vector<Crypto::KeyImage>& keyImages) const;
 
   // ITransfersContainer
   virtual size_t transfersCount() const override;
   virtual size_t transactionsCount() const override;
   virtual uint64_t balance(uint32_t flags) const override;
   virtual void getOutputs(std::vector<TransactionOutputInformation>& transfers, uint32_t flags) const override;
+  virtual void getLargestOutputs(std::vector<TransactionOutputInformation>& transfers, uint32_t flags, uint64_t amount, size_t minCount) const override;
   virtual bool getTransactionInformation(const Crypto::Hash& transactionHash, TransactionInformation& info,
     uint64_t* amountIn = nullptr, uint64_t* amountOut = nullptr) const override;
   virtual std::vector<TransactionOutputInformation> getTransactionOutputs(const Crypto::Hash& transactionHash, uint32_t flags) const override;
@@ -178,12 +178,19 @@ public:
   virtual void load(std::istream& in) override;
 
 private:
+  // transfers as they are stored, with the data of their transactions
+  struct StoredOutput;
+  struct StoredSpentOutput;
+
   struct ContainingTransactionIndex { };
   struct SpendingTransactionIndex { };
   struct SpentOutputDescriptorIndex { };
+  struct AmountIndex { };
+  struct UnlockTimeIndex { };
+  struct BlockHeightIndex { };
 
   typedef boost::multi_index_container<
-    TransactionInformation,
+    TransactionRecord,
     boost::multi_index::indexed_by<
       boost::multi_index::hashed_unique<BOOST_MULTI_INDEX_MEMBER(TransactionInformation, Crypto::Hash, transactionHash)>,
       boost::multi_index::ordered_non_unique<BOOST_MULTI_INDEX_MEMBER(TransactionInformation, uint32_t, blockHeight)>
@@ -228,6 +235,25 @@ private:
           TransactionOutputInformationEx,
           const Crypto::Hash&,
           &TransactionOutputInformationEx::getTransactionHash>
+      >,
+      boost::multi_index::ordered_non_unique<
+        boost::multi_index::tag<AmountIndex>,
+        BOOST_MULTI_INDEX_MEMBER(TransactionOutputInformationEx, uint64_t, amount)
+      >,
+      // the lock and the soft lock of a transfer end at heights derived from these keys
+      boost::multi_index::ordered_non_unique<
+        boost::multi_index::tag<UnlockTimeIndex>,
+        boost::multi_index::const_mem_fun<
+          TransactionOutputInformationEx,
+          uint64_t,
+          &TransactionOutputInformationEx::unlockTime>
+      >,
+      boost::multi_index::ordered_non_unique<
+        boost::multi_index::tag<BlockHeightIndex>,
+        boost::multi_index::const_mem_fun<
+          TransactionOutputInformationEx,
+          uint32_t,
+          &TransactionOutputInformationEx::blockHeight>
       >
     >
   > AvailableTransfersMultiIndex;
@@ -261,18 +287,27 @@ private:
   > SpentTransfersMultiIndex;
 
 private:
-  void addTransaction(const TransactionBlockInfo& block, const ITransactionReader& tx);
-  bool addTransactionOutputs(const TransactionBlockInfo& block, const ITransactionReader& tx,
+  const TransactionRecord& addTransaction(const TransactionBlockInfo& block, const ITransactionReader& tx);
+  bool addTransactionOutputs(const TransactionRecord& transaction, const ITransactionReader& tx,
                              const std::vector<TransactionOutputInformationIn>& transfers);
-  bool addTransactionInputs(const TransactionBlockInfo& block, const ITransactionReader& tx);
+  bool addTransactionInputs(const TransactionRecord& transaction, const ITransactionReader& tx);
   void deleteTransactionTransfers(const Crypto::Hash& transactionHash);
-  bool isSpendTimeUnlocked(uint64_t unlockTime) const;
+  bool isSpendTimeUnlocked(uint64_t unlockTime, uint32_t height) const;
+  bool isLockedByTime(const TransactionOutputInformationEx& info) const;
+  uint32_t getTransferState(const TransactionOutputInformationEx& info, uint32_t height) const;
   bool isIncluded(const TransactionOutputInformationEx& info, uint32_t flags) const;
   static bool isIncluded(TransactionTypes::OutputType type, uint32_t state, uint32_t flags);
   void updateTransfersVisibility(const Crypto::KeyImage& keyImage);
 
-  void copyToSpent(const TransactionBlockInfo& block, const ITransactionReader& tx, size_t inputIndex, const TransactionOutputInformationEx& output);
-  void repair();
+  static size_t balanceIndex(TransactionTypes::OutputType type, uint32_t state);
+  void addToBalance(const TransactionOutputInformationEx& info);
+  void removeFromBalance(const TransactionOutputInformationEx& info);
+  void rebuildBalances();
+  void setCurrentHeight(uint32_t height);
+
+  void copyToSpent(const TransactionRecord& transaction, size_t inputIndex, const TransactionOutputInformationEx& output);
+  void restoreTransfers(const std::vector<StoredOutput>& unconfirmedTransfers, const std::vector<StoredOutput>& availableTransfers,
+                        const std::vector<StoredSpentOutput>& spentTransfers);
 
 private:
   TransactionMultiIndex m_transactions;
@@ -281,6 +316,9 @@ private:
   SpentTransfersMultiIndex m_spentTransfers;
 
   uint32_t m_currentHeight; // current height is needed to check if a transfer is unlocked
+  // amounts of the visible available transfers locked by height, by type and state at the current height,
+  // transfers locked by time are left out as their state follows the clock
+  std::array<uint64_t, 6> m_balances;
   size_t m_transactionSpendableAge;
   const CryptoNote::Currency& m_currency;
   mutable std::mutex m_mutex;
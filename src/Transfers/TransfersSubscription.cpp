@@ -66,6 +66,10 @@ AccountPublicAddress TransfersSubscription::getAddress() {
   return subscription.keys.address;
 }
 
+void TransfersSubscription::getKeyImages(std::vector<Crypto::KeyImage>& keyImages) const {
+  transfers.getKeyImages(keyImages);
+}
+
 ITransfersContainer& TransfersSubscription::getContainer() {
   return transfers;
 }
@@ -39,6 +39,7 @@ public:
 
   void deleteUnconfirmedTransaction(const Crypto::Hash& transactionHash);
   void markTransactionConfirmed(const TransactionBlockInfo& block, const Crypto::Hash& transactionHash, const std::vector<uint32_t>& globalIndices);
+  void getKeyImages(std::vector<Crypto::KeyImage>& keyImages) const;
 
   // ITransfersSubscription
   virtual AccountPublicAddress getAddress() override;
@@ -20,6 +20,10 @@
 #include "TransfersSynchronizer.h"
 #include "TransfersConsumer.h"
 
+#include <algorithm>
+#include <cassert>
+
+#include "Common/InputStreamBuffer.h"
 #include "Common/StdInputStream.h"
 #include "Common/StdOutputStream.h"
 #include "CryptoNoteCore/CryptoNoteBasicImpl.h"
@@ -51,18 +55,34 @@ void TransfersSyncronizer::initTransactionPool(const std::unordered_set<Crypto::
 }
 
 ITransfersSubscription& TransfersSyncronizer::addSubscription(const AccountSubscription& acc) {
-  auto it = m_consumers.find(acc.keys.address.viewPublicKey);
+  return getConsumer(acc.keys).addSubscription(acc);
+}
+
+std::vector<ITransfersSubscription*> TransfersSyncronizer::addSubscriptions(const std::vector<AccountSubscription>& subscriptions) {
+  if (subscriptions.empty()) {
+    return std::vector<ITransfersSubscription*>();
+  }
+
+  assert(std::all_of(subscriptions.begin(), subscriptions.end(), [&subscriptions](const AccountSubscription& acc) {
+    return acc.keys.address.viewPublicKey == subscriptions.front().keys.address.viewPublicKey;
+  }));
+
+  return getConsumer(subscriptions.front().keys).addSubscriptions(subscriptions);
+}
+
+TransfersConsumer& TransfersSyncronizer::getConsumer(const AccountKeys& keys) {
+  auto it = m_consumers.find(keys.address.viewPublicKey);
 
   if (it == m_consumers.end()) {
     std::unique_ptr<TransfersConsumer> consumer(
-      new TransfersConsumer(m_currency, m_node, m_logger.getLogger(), acc.keys.viewSecretKey));
+      new TransfersConsumer(m_currency, m_node, m_logger.getLogger(), keys.viewSecretKey));
 
     m_sync.addConsumer(consumer.get());
     consumer->addObserver(this);
-    it = m_consumers.insert(std::make_pair(acc.keys.address.viewPublicKey, std::move(consumer))).first;
+    it = m_consumers.insert(std::make_pair(keys.address.viewPublicKey, std::move(consumer))).first;
   }
-    
-  return it->second->addSubscription(acc);
+
+  return *it->second;
 }
 
 bool TransfersSyncronizer::removeSubscription(const AccountPublicAddress& acc) {
@@ -221,6 +241,20 @@ void setObjectState(IStreamSerializable& obj, const std::string& state) {
   obj.load(stream);
 }
 
+// loads a state saved as a string in place, without copying it out of the source first
+void loadObjectState(IStreamSerializable* obj, IInputStream& source, ISerializer& s) {
+  uint64_t size = 0;
+  s(size, "state");
+
+  InputStreamBuffer buffer(source, size);
+  if (obj != nullptr) {
+    std::istream stream(&buffer);
+    obj->load(stream);
+  }
+
+  buffer.skipRest();
+}
+
 }
 
 void TransfersSyncronizer::load(std::istream& is) {
@@ -254,9 +288,6 @@ void TransfersSyncronizer::load(std::istream& is) {
       PublicKey viewKey;
       s(viewKey, "view_key");
 
-      std::string blob;
-      s(blob, "state");
-
       auto subIter = m_consumers.find(viewKey);
       if (subIter != m_consumers.end()) {
         auto consumerState = m_sync.getConsumerState(subIter->second.get());
@@ -265,9 +296,9 @@ void TransfersSyncronizer::load(std::istream& is) {
         {
           // store previous state
           auto prevConsumerState = getObjectState(*consumerState);
-          // load consumer state
-          setObjectState(*consumerState, blob);
           updatedStates.push_back(ConsumerState{ viewKey, std::move(prevConsumerState) });
+          // load consumer state
+          loadObjectState(consumerState, inputStream, s);
         }
 
         // load subscriptions
@@ -278,19 +309,17 @@ void TransfersSyncronizer::load(std::istream& is) {
           s.beginObject("");
 
           AccountPublicAddress acc;
-          std::string state;
-
           s(acc, "address");
-          s(state, "state");
 
           auto sub = subIter->second->getSubscription(acc);
 
           if (sub != nullptr) {
             auto prevState = getObjectState(sub->getContainer());
-            setObjectState(sub->getContainer(), state);
             updatedStates.back().subscriptionStates.push_back(std::make_pair(acc, prevState));
+            loadObjectState(&sub->getContainer(), inputStream, s);
           } else {
             m_logger(Logging::DEBUGGING) << "Subscription not found: " << m_currency.accountAddressAsString(acc);
+            loadObjectState(nullptr, inputStream, s);
           }
 
           s.endObject();
@@ -299,6 +328,7 @@ void TransfersSyncronizer::load(std::istream& is) {
         s.endArray();
       } else {
         m_logger(Logging::DEBUGGING) << "Consumer not found: " << viewKey;
+        loadObjectState(nullptr, inputStream, s);
       }
 
       s.endObject();
@@ -315,9 +345,18 @@ void TransfersSyncronizer::load(std::istream& is) {
         setObjectState(consumer->getSubscription(sub.first)->getContainer(), sub.second);
       }
     }
+
+    for (auto& consumer : m_consumers) {
+      consumer.second->invalidateKeyImageIndex();
+    }
+
     throw;
   }
 
+  for (auto& consumer : m_consumers) {
+    consumer.second->invalidateKeyImageIndex();
+  }
+
 }
 
 bool TransfersSyncronizer::findViewKeyForConsumer(IBlockchainConsumer* consumer, Crypto::PublicKey& viewKey) const {
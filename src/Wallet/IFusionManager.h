@@ -33,6 +33,9 @@ public:
 
   virtual size_t createFusionTransaction(uint64_t threshold, uint64_t mixin,
     const std::vector<std::string>& sourceAddresses = {}, const std::string& destinationAddress = "") = 0;
+  // creates and sends up to maxTransactionCount fusion transactions from disjoint inputs, returns their ids
+  virtual std::vector<size_t> createFusionTransactions(uint64_t threshold, uint64_t mixin, size_t maxTransactionCount,
+    const std::vector<std::string>& sourceAddresses = {}, const std::string& destinationAddress = "") = 0;
   virtual bool isFusionTransaction(size_t transactionId) const = 0;
   virtual EstimateResult estimate(uint64_t threshold, const std::vector<std::string>& sourceAddresses = {}) const = 0;
 };
@@ -0,0 +1,437 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "WalletCacheChunks.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <system_error>
+#include <unordered_map>
+
+#include "Common/MemoryInputStream.h"
+#include "Common/StringOutputStream.h"
+#include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "Serialization/BinaryInputStreamSerializer.h"
+#include "Serialization/BinaryOutputStreamSerializer.h"
+#include "Serialization/SerializationOverloads.h"
+#include "Wallet/WalletErrors.h"
+
+namespace CryptoNote {
+
+namespace {
+
+const uint64_t MIN_CHUNK_SIZE = 4 * 1024;
+const uint64_t MAX_CHUNK_SIZE = 64 * 1024;
+const unsigned CHUNK_BOUNDARY_BITS = 14; // 16 KiB chunks on average
+
+// slots are kept in different disk sectors, so a torn write can damage only one of them
+const uint64_t SLOT_SIZE = 512;
+const uint64_t DATA_OFFSET = 2 * SLOT_SIZE;
+// rewrites of a cache of steady size settle at about this much room for appending past it
+const uint64_t SPARE_CACHES = 3;
+
+#pragma pack(push, 1)
+struct CommitSlot {
+  uint64_t sequence;
+  uint64_t recordOffset;
+  uint64_t recordSize;
+  Crypto::Hash recordHash;
+  Crypto::Hash checksum;
+};
+#pragma pack(pop)
+
+const std::array<uint64_t, 256>& gearTable() {
+  static const std::array<uint64_t, 256> table = [] {
+    std::array<uint64_t, 256> t;
+    uint64_t state = 0x4b6172626f436163;
+    for (auto& value : t) {
+      // splitmix64
+      uint64_t z = (state += 0x9e3779b97f4a7c15);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+      value = z ^ (z >> 31);
+    }
+
+    return t;
+  }();
+
+  return table;
+}
+
+Crypto::Hash slotChecksum(const CommitSlot& slot) {
+  return Crypto::cn_fast_hash(&slot, offsetof(CommitSlot, checksum));
+}
+
+size_t latestSlot(const uint8_t* suffix) {
+  CommitSlot slots[2];
+  std::memcpy(&slots[0], suffix, sizeof(CommitSlot));
+  std::memcpy(&slots[1], suffix + SLOT_SIZE, sizeof(CommitSlot));
+  return slots[1].sequence > slots[0].sequence ? 1 : 0;
+}
+
+}
+
+void WalletCacheChunks::Chunk::serialize(ISerializer& s) {
+  KV_MEMBER(offset)
+  KV_MEMBER(size)
+  KV_MEMBER(iv)
+  KV_MEMBER(hash)
+}
+
+WalletCacheChunks::WalletCacheChunks() {
+  reset();
+}
+
+void WalletCacheChunks::reset() {
+  m_chunks.clear();
+  m_valid = false;
+  m_slot = 0;
+  m_sequence = 0;
+  m_begin = 0;
+  m_end = 0;
+}
+
+class WalletCacheChunks::ChunkInputStream : public Common::IInputStream {
+public:
+  ChunkInputStream(const uint8_t* suffix, const std::vector<Chunk>& chunks, const Crypto::chacha8_key& key) :
+    m_suffix(suffix), m_chunks(chunks), m_key(key), m_next(0), m_position(0) {
+  }
+
+  size_t readSome(void* data, size_t size) override {
+    if (m_position == m_buffer.size()) {
+      if (m_next == m_chunks.size()) {
+        return 0;
+      }
+
+      const Chunk& chunk = m_chunks[m_next++];
+      m_buffer.resize(chunk.size);
+      chacha8(m_suffix + chunk.offset, chunk.size, m_key, chunk.iv, reinterpret_cast<char*>(m_buffer.data()));
+      if (Crypto::cn_fast_hash(m_buffer.data(), m_buffer.size()) != chunk.hash) {
+        throw std::system_error(make_error_code(error::INTERNAL_WALLET_ERROR), "Container cache is corrupted");
+      }
+
+      m_position = 0;
+    }
+
+    size = std::min(size, m_buffer.size() - m_position);
+    std::memcpy(data, m_buffer.data() + m_position, size);
+    m_position += size;
+    return size;
+  }
+
+private:
+  const uint8_t* m_suffix;
+  const std::vector<Chunk>& m_chunks;
+  const Crypto::chacha8_key& m_key;
+  size_t m_next;
+  size_t m_position;
+  BinaryArray m_buffer;
+};
+
+void WalletCacheChunks::load(const ContainerStorage& storage, const Crypto::chacha8_key& key, BinaryArray& data) {
+  reset();
+
+  if (storage.suffixSize() >= DATA_OFFSET) {
+    size_t latest = latestSlot(storage.suffix());
+    if (readChunks(storage, key, latest, data) || readChunks(storage, key, 1 - latest, data)) {
+      return;
+    }
+  }
+
+  throw std::system_error(make_error_code(error::INTERNAL_WALLET_ERROR), "Container cache is corrupted");
+}
+
+void WalletCacheChunks::load(const ContainerStorage& storage, const Crypto::chacha8_key& key, const std::function<void(Common::IInputStream&)>& reader) {
+  reset();
+
+  std::vector<Chunk> chunks;
+  uint64_t begin = 0;
+  uint64_t end = 0;
+  size_t slotIndex = 0;
+  bool found = false;
+  if (storage.suffixSize() >= DATA_OFFSET) {
+    slotIndex = latestSlot(storage.suffix());
+    found = readRecord(storage, key, slotIndex, chunks, begin, end);
+    if (!found) {
+      slotIndex = 1 - slotIndex;
+      found = readRecord(storage, key, slotIndex, chunks, begin, end);
+    }
+  }
+
+  if (!found) {
+    throw std::system_error(make_error_code(error::INTERNAL_WALLET_ERROR), "Container cache is corrupted");
+  }
+
+  ChunkInputStream stream(storage.suffix(), chunks, key);
+  reader(stream);
+
+  CommitSlot slot;
+  std::memcpy(&slot, storage.suffix() + slotIndex * SLOT_SIZE, sizeof(slot));
+  setLayout(std::move(chunks), slotIndex, slot.sequence, begin, end);
+}
+
+bool WalletCacheChunks::readRecord(const ContainerStorage& storage, const Crypto::chacha8_key& key, size_t slotIndex, std::vector<Chunk>& chunks,
+  uint64_t& begin, uint64_t& end) {
+
+  const uint8_t* suffix = storage.suffix();
+  const uint64_t suffixSize = storage.suffixSize();
+
+  CommitSlot slot;
+  std::memcpy(&slot, suffix + slotIndex * SLOT_SIZE, sizeof(slot));
+  if (slot.checksum != slotChecksum(slot) || slot.recordOffset < DATA_OFFSET || slot.recordOffset > suffixSize ||
+      slot.recordSize <= sizeof(Crypto::chacha8_iv) || slot.recordSize > suffixSize - slot.recordOffset) {
+    return false;
+  }
+
+  const uint8_t* record = suffix + slot.recordOffset;
+  if (Crypto::cn_fast_hash(record, slot.recordSize) != slot.recordHash) {
+    return false;
+  }
+
+  Crypto::chacha8_iv recordIv;
+  std::memcpy(&recordIv, record, sizeof(recordIv));
+  std::string plainRecord(slot.recordSize - sizeof(recordIv), '\0');
+  chacha8(record + sizeof(recordIv), plainRecord.size(), key, recordIv, &plainRecord[0]);
+
+  try {
+    Common::MemoryInputStream recordStream(plainRecord.data(), plainRecord.size());
+    BinaryInputStreamSerializer s(recordStream);
+    s(chunks, "chunks");
+  } catch (const std::exception&) {
+    return false;
+  }
+
+  begin = slot.recordOffset;
+  end = slot.recordOffset + slot.recordSize;
+  for (auto& chunk : chunks) {
+    chunk.stored = true;
+    if (chunk.offset < DATA_OFFSET || chunk.offset > suffixSize || chunk.size > suffixSize - chunk.offset) {
+      return false;
+    }
+
+    begin = std::min(begin, chunk.offset);
+    end = std::max(end, chunk.offset + chunk.size);
+  }
+
+  return true;
+}
+
+bool WalletCacheChunks::readChunks(const ContainerStorage& storage, const Crypto::chacha8_key& key, size_t slotIndex, BinaryArray& data) {
+  std::vector<Chunk> chunks;
+  uint64_t begin;
+  uint64_t end;
+  if (!readRecord(storage, key, slotIndex, chunks, begin, end)) {
+    return false;
+  }
+
+  uint64_t dataSize = 0;
+  for (const auto& chunk : chunks) {
+    dataSize += chunk.size;
+  }
+
+  data.resize(dataSize);
+  uint8_t* chunkData = data.data();
+  for (const auto& chunk : chunks) {
+    chacha8(storage.suffix() + chunk.offset, chunk.size, key, chunk.iv, reinterpret_cast<char*>(chunkData));
+    if (Crypto::cn_fast_hash(chunkData, chunk.size) != chunk.hash) {
+      return false;
+    }
+
+    chunkData += chunk.size;
+  }
+
+  CommitSlot slot;
+  std::memcpy(&slot, storage.suffix() + slotIndex * SLOT_SIZE, sizeof(slot));
+  setLayout(std::move(chunks), slotIndex, slot.sequence, begin, end);
+  return true;
+}
+
+void WalletCacheChunks::setLayout(std::vector<Chunk>&& chunks, size_t slotIndex, uint64_t sequence, uint64_t begin, uint64_t end) {
+  m_chunks = std::move(chunks);
+  m_valid = true;
+  m_slot = slotIndex;
+  m_sequence = sequence;
+  m_begin = begin;
+  m_end = end;
+}
+
+std::vector<WalletCacheChunks::Chunk> WalletCacheChunks::split(const uint8_t* data, size_t size) {
+  const auto& gear = gearTable();
+  const uint64_t boundaryMask = ~uint64_t(0) << (64 - CHUNK_BOUNDARY_BITS);
+
+  std::vector<Chunk> chunks;
+  size_t begin = 0;
+  while (begin < size) {
+    size_t end = std::min<size_t>(size, begin + MAX_CHUNK_SIZE);
+    if (end - begin > MIN_CHUNK_SIZE) {
+      uint64_t fingerprint = 0;
+      for (size_t i = begin + MIN_CHUNK_SIZE; i < end; ++i) {
+        fingerprint = (fingerprint << 1) + gear[data[i]];
+        if ((fingerprint & boundaryMask) == 0) {
+          end = i + 1;
+          break;
+        }
+      }
+    }
+
+    Chunk chunk;
+    chunk.offset = 0;
+    chunk.size = end - begin;
+    chunk.stored = false;
+    chunk.hash = Crypto::cn_fast_hash(data + begin, chunk.size);
+    chunks.push_back(chunk);
+    begin = end;
+  }
+
+  return chunks;
+}
+
+void WalletCacheChunks::save(ContainerStorage& storage, const Crypto::chacha8_key& key, const void* data, size_t size, const IvGenerator& nextIv) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  std::vector<Chunk> chunks = split(bytes, size);
+
+  if (!m_valid) {
+    // the suffix may still hold a cache in the previous format, write past it
+    store(storage, key, bytes, size, chunks, std::max(DATA_OFFSET, storage.suffixSize()), nextIv);
+    return;
+  }
+
+  std::unordered_map<Crypto::Hash, const Chunk*> stored;
+  for (const auto& chunk : m_chunks) {
+    stored.emplace(chunk.hash, &chunk);
+  }
+
+  for (auto& chunk : chunks) {
+    auto it = stored.find(chunk.hash);
+    if (it != stored.end() && it->second->size == chunk.size) {
+      chunk.offset = it->second->offset;
+      chunk.iv = it->second->iv;
+      chunk.stored = true;
+    }
+  }
+
+  // a suffix left over from a larger cache is compacted as soon as the cache fits below the stored chunks
+  bool fitsBelow = place(chunks, DATA_OFFSET) <= m_begin;
+  bool oversized = storage.suffixSize() > DATA_OFFSET + (SPARE_CACHES + 2) * size;
+  if (place(chunks, m_end) <= storage.suffixSize() && !(oversized && fitsBelow)) {
+    store(storage, key, bytes, size, chunks, m_end, nextIv);
+    return;
+  }
+
+  if (!fitsBelow) {
+    // no room for appending, write the whole cache once more, below the stored chunks if it fits there
+    for (auto& chunk : chunks) {
+      chunk.stored = false;
+    }
+
+    if (place(chunks, DATA_OFFSET) > m_begin) {
+      store(storage, key, bytes, size, chunks, m_end, nextIv);
+      return;
+    }
+  }
+
+  store(storage, key, bytes, size, chunks, DATA_OFFSET, nextIv);
+
+  // the caches past the committed one aren't needed any more
+  if (storage.suffixSize() > m_end + (SPARE_CACHES + 1) * size) {
+    storage.resizeSuffix(m_end + SPARE_CACHES * size);
+  }
+}
+
+void WalletCacheChunks::write(ContainerStorage& storage, const Crypto::chacha8_key& key, const void* data, size_t size, const IvGenerator& nextIv) {
+  reset();
+
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  std::vector<Chunk> chunks = split(bytes, size);
+  store(storage, key, bytes, size, chunks, DATA_OFFSET, nextIv);
+}
+
+uint64_t WalletCacheChunks::place(std::vector<Chunk>& chunks, uint64_t position) {
+  for (auto& chunk : chunks) {
+    if (!chunk.stored) {
+      chunk.offset = position;
+      position += chunk.size;
+    }
+  }
+
+  return position + sizeof(Crypto::chacha8_iv) + serializeRecord(chunks).size();
+}
+
+std::string WalletCacheChunks::serializeRecord(std::vector<Chunk>& chunks) {
+  std::string record;
+  Common::StringOutputStream recordStream(record);
+  BinaryOutputStreamSerializer s(recordStream);
+  s(chunks, "chunks");
+  return record;
+}
+
+void WalletCacheChunks::store(ContainerStorage& storage, const Crypto::chacha8_key& key, const uint8_t* data, size_t size, std::vector<Chunk>& chunks,
+  uint64_t position, const IvGenerator& nextIv) {
+
+  uint64_t required = place(chunks, position);
+  if (required > storage.suffixSize()) {
+    // leave the room rewrites settle at, so a cache of steady size doesn't resize the suffix again
+    storage.resizeSuffix(required + SPARE_CACHES * size);
+  }
+
+  uint8_t* suffix = storage.suffix();
+  const uint8_t* chunkData = data;
+  uint64_t begin = position;
+  uint64_t end = position;
+  for (auto& chunk : chunks) {
+    if (!chunk.stored) {
+      chunk.iv = nextIv();
+      chacha8(chunkData, chunk.size, key, chunk.iv, reinterpret_cast<char*>(suffix + chunk.offset));
+      chunk.stored = true;
+      position += chunk.size;
+    }
+
+    begin = std::min(begin, chunk.offset);
+    end = std::max(end, chunk.offset + chunk.size);
+    chunkData += chunk.size;
+  }
+
+  std::string plainRecord = serializeRecord(chunks);
+  Crypto::chacha8_iv recordIv = nextIv();
+  std::memcpy(suffix + position, &recordIv, sizeof(recordIv));
+  chacha8(plainRecord.data(), plainRecord.size(), key, recordIv, reinterpret_cast<char*>(suffix + position + sizeof(recordIv)));
+
+  CommitSlot slot;
+  slot.sequence = m_sequence + 1;
+  slot.recordOffset = position;
+  slot.recordSize = sizeof(recordIv) + plainRecord.size();
+  slot.recordHash = Crypto::cn_fast_hash(suffix + position, slot.recordSize);
+  slot.checksum = slotChecksum(slot);
+  assert(slot.recordOffset + slot.recordSize == required);
+
+  // the chunks and the record must reach the disk before the slot that points to them
+  storage.flush();
+
+  size_t slotIndex = m_valid ? 1 - m_slot : 0;
+  std::memcpy(suffix + slotIndex * SLOT_SIZE, &slot, sizeof(slot));
+  if (!m_valid) {
+    std::memset(suffix + (1 - slotIndex) * SLOT_SIZE, 0, sizeof(slot));
+  }
+
+  storage.flush();
+
+  setLayout(std::move(chunks), slotIndex, slot.sequence, begin, std::max(end, required));
+}
+
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Common/IInputStream.h"
+#include "CryptoNote.h"
+#include "crypto/chacha8.h"
+#include "crypto/hash.h"
+#include "Serialization/ISerializer.h"
+#include "WalletIndices.h"
+
+namespace CryptoNote {
+
+// Keeps the wallet cache in the container suffix as encrypted content defined chunks.
+// A save encrypts and appends only the chunks that are not stored yet, appends a record
+// listing all chunks of the cache and commits it by rewriting one of two checksummed
+// slots at the start of the suffix, so an interrupted save leaves the previous cache
+// readable. When the appended data do not fit any more, the whole cache is written again
+// either below the stored chunks or past them, growing the suffix. A suffix left over from
+// a larger cache is cut back once the cache has been rewritten at its start.
+class WalletCacheChunks {
+public:
+  typedef std::function<Crypto::chacha8_iv()> IvGenerator;
+
+  WalletCacheChunks();
+
+  // reads the last committed cache and remembers its layout for the following saves
+  void load(const ContainerStorage& storage, const Crypto::chacha8_key& key, BinaryArray& data);
+  // same, but decrypts the chunks one at a time while the reader consumes them, a damaged chunk throws
+  void load(const ContainerStorage& storage, const Crypto::chacha8_key& key, const std::function<void(Common::IInputStream&)>& reader);
+  // stores the cache reusing the chunks of the remembered layout, existing suffix data are kept intact
+  void save(ContainerStorage& storage, const Crypto::chacha8_key& key, const void* data, size_t size, const IvGenerator& nextIv);
+  // writes the whole cache from the start of a suffix that holds nothing worth keeping
+  void write(ContainerStorage& storage, const Crypto::chacha8_key& key, const void* data, size_t size, const IvGenerator& nextIv);
+  void reset();
+
+private:
+  struct Chunk {
+    uint64_t offset;
+    uint64_t size;
+    Crypto::chacha8_iv iv;
+    Crypto::Hash hash;
+    bool stored; // not serialized, false for a chunk still to be encrypted and written
+
+    void serialize(ISerializer& s);
+  };
+
+  static std::vector<Chunk> split(const uint8_t* data, size_t size);
+  // lays out the chunks that are not stored yet from the position, returns the end of the record that follows them
+  static uint64_t place(std::vector<Chunk>& chunks, uint64_t position);
+  static std::string serializeRecord(std::vector<Chunk>& chunks);
+  void store(ContainerStorage& storage, const Crypto::chacha8_key& key, const uint8_t* data, size_t size, std::vector<Chunk>& chunks,
+    uint64_t position, const IvGenerator& nextIv);
+  class ChunkInputStream;
+
+  bool readRecord(const ContainerStorage& storage, const Crypto::chacha8_key& key, size_t slotIndex, std::vector<Chunk>& chunks, uint64_t& begin, uint64_t& end);
+  bool readChunks(const ContainerStorage& storage, const Crypto::chacha8_key& key, size_t slotIndex, BinaryArray& data);
+  void setLayout(std::vector<Chunk>&& chunks, size_t slotIndex, uint64_t sequence, uint64_t begin, uint64_t end);
+
+  std::vector<Chunk> m_chunks;
+  bool m_valid;
+  size_t m_slot;
+  uint64_t m_sequence;
+  uint64_t m_begin; // extent of the committed chunks and record
+  uint64_t m_end;
+};
+
+}
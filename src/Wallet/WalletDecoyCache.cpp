@@ -0,0 +1,108 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "WalletDecoyCache.h"
+
+#include <algorithm>
+
+namespace CryptoNote {
+
+WalletDecoyCache::WalletDecoyCache(size_t batchSize, size_t amountCount) :
+  m_batchSize(batchSize),
+  m_amountCount(amountCount),
+  m_useCounter(0),
+  m_generation(0) {
+}
+
+bool WalletDecoyCache::take(uint64_t amount, size_t count, OutsForAmount& outs) {
+  AmountOuts& amountOuts = useAmount(amount);
+
+  while (!amountOuts.batches.empty()) {
+    Batch& batch = amountOuts.batches.front();
+    size_t left = batch.outs.size() - batch.next;
+    if (left >= count) {
+      outs.amount = amount;
+      outs.outs.assign(batch.outs.begin() + batch.next, batch.outs.begin() + batch.next + count);
+      batch.next += count;
+      amountOuts.count -= count;
+      if (batch.next == batch.outs.size()) {
+        amountOuts.batches.pop_front();
+      }
+
+      return true;
+    }
+
+    // the rest is too short for a ring, mixing it with the next batch could repeat outputs
+    amountOuts.count -= left;
+    amountOuts.batches.pop_front();
+  }
+
+  return false;
+}
+
+std::vector<uint64_t> WalletDecoyCache::amountsToRefill(size_t count) const {
+  std::vector<uint64_t> amounts;
+  for (const auto& amountOuts : m_amounts) {
+    if (amountOuts.second.count < count) {
+      amounts.push_back(amountOuts.first);
+    }
+  }
+
+  return amounts;
+}
+
+void WalletDecoyCache::add(std::vector<OutsForAmount>&& batches, uint64_t generation) {
+  if (generation != m_generation) {
+    return;
+  }
+
+  for (auto& batch : batches) {
+    auto it = m_amounts.find(batch.amount);
+    // a short answer means the node has few outputs of the amount, such rings are not worth keeping in advance
+    if (it == m_amounts.end() || batch.outs.size() < m_batchSize) {
+      continue;
+    }
+
+    it->second.count += batch.outs.size();
+    it->second.batches.push_back({ std::move(batch.outs), 0 });
+  }
+}
+
+void WalletDecoyCache::clear() {
+  m_amounts.clear();
+  ++m_generation;
+}
+
+WalletDecoyCache::AmountOuts& WalletDecoyCache::useAmount(uint64_t amount) {
+  auto it = m_amounts.find(amount);
+  if (it == m_amounts.end()) {
+    if (m_amounts.size() >= m_amountCount) {
+      auto leastUsed = std::min_element(m_amounts.begin(), m_amounts.end(), [](const std::pair<const uint64_t, AmountOuts>& a, const std::pair<const uint64_t, AmountOuts>& b) {
+        return a.second.lastUse < b.second.lastUse;
+      });
+
+      m_amounts.erase(leastUsed);
+    }
+
+    it = m_amounts.emplace(amount, AmountOuts{ {}, 0, 0 }).first;
+  }
+
+  it->second.lastUse = ++m_useCounter;
+  return it->second;
+}
+
+}
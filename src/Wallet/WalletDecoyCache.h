@@ -0,0 +1,72 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "Rpc/CoreRpcServerCommandsDefinitions.h"
+
+namespace CryptoNote {
+
+// Random outputs fetched in advance for the amounts spent by the wallet, so that a transaction
+// can be built without asking the node for mixins. Every output is handed out once and the
+// outputs of a ring always come from the same node response, so they never repeat in a ring.
+class WalletDecoyCache {
+public:
+  typedef COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount OutsForAmount;
+
+  // batchSize is the number of outputs requested per amount, at most amountCount amounts are kept
+  WalletDecoyCache(size_t batchSize, size_t amountCount);
+
+  size_t batchSize() const { return m_batchSize; }
+  // incremented by clear(), batches requested before it are dropped
+  uint64_t generation() const { return m_generation; }
+
+  // takes count outputs of the amount, returns false if they are not cached; the amount is remembered either way
+  bool take(uint64_t amount, size_t count, OutsForAmount& outs);
+  // amounts taken before that have less than count outputs left
+  std::vector<uint64_t> amountsToRefill(size_t count) const;
+  void add(std::vector<OutsForAmount>&& batches, uint64_t generation);
+  void clear();
+
+private:
+  struct Batch {
+    std::vector<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::out_entry> outs;
+    size_t next;
+  };
+
+  struct AmountOuts {
+    std::deque<Batch> batches;
+    size_t count;
+    uint64_t lastUse;
+  };
+
+  AmountOuts& useAmount(uint64_t amount);
+
+  const size_t m_batchSize;
+  const size_t m_amountCount;
+  std::unordered_map<uint64_t, AmountOuts> m_amounts;
+  uint64_t m_useCounter;
+  uint64_t m_generation;
+};
+
+}
@@ -30,8 +30,12 @@
 #include <tuple>
 #include <utility>
 
+#include <System/Context.h>
 #include <System/EventLock.h>
+#include <System/InterruptedException.h>
 #include <System/RemoteContext.h>
+#include <System/ThreadPool.h>
+#include <System/Timer.h>
 #ifdef USE_LITE_WALLET
 #include <boost/date_time/posix_time/posix_time.hpp>
 #endif
@@ -75,6 +79,19 @@ using namespace Logging;
 
 namespace {
 
+// unlocked outputs of a wallet collected for a transaction beyond the ones needed to cover its amount
+const size_t SPARE_SELECTION_OUTPUT_COUNT = 16;
+
+// random outputs requested in advance for every amount spent lately, and how many such amounts are kept
+const size_t DECOY_CACHE_BATCH_SIZE = 64;
+const size_t DECOY_CACHE_AMOUNT_COUNT = 256;
+// rings of each amount to have ready for the following transactions
+const size_t DECOY_CACHE_RING_COUNT = 4;
+
+// events kept for the consumers, an overflow replaces them by a single EVENTS_DROPPED event
+const size_t MAX_QUEUED_EVENT_COUNT = 100000;
+const uint64_t NO_EVENT = std::numeric_limits<uint64_t>::max();
+
 void asyncRequestCompletion(System::Event& requestFinished) {
   requestFinished.set();
 }
@@ -122,6 +139,16 @@ size_t getTransactionSize(const ITransactionReader& transaction) {
   return transaction.getTransactionData().size();
 }
 
+size_t getVarintSize(uint64_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+
+  return size;
+}
+
 uint64_t calculateDonationAmount(uint64_t freeAmount, uint64_t donationThreshold, uint64_t dustThreshold) {
   std::vector<uint64_t> decomposedAmounts;
   decomposeAmount(freeAmount, dustThreshold, decomposedAmounts);
@@ -146,23 +173,47 @@ uint64_t calculateDonationAmount(uint64_t freeAmount, uint64_t donationThreshold
 namespace CryptoNote {
 
 WalletGreen::WalletGreen(System::Dispatcher& dispatcher, const Currency& currency, INode& node, Logging::ILogger& logger, uint32_t transactionSoftLockTime) :
+  WalletGreen(dispatcher, currency, node, logger, transactionSoftLockTime, new BlockchainSynchronizer(node, logger, currency.genesisBlockHash()), nullptr)
+{
+}
+
+WalletGreen::WalletGreen(System::Dispatcher& dispatcher, const Currency& currency, INode& node, SharedBlockchainSynchronizer& sharedSynchronizer,
+  Logging::ILogger& logger, uint32_t transactionSoftLockTime) :
+  WalletGreen(dispatcher, currency, node, logger, transactionSoftLockTime, nullptr, &sharedSynchronizer)
+{
+}
+
+WalletGreen::WalletGreen(System::Dispatcher& dispatcher, const Currency& currency, INode& node, Logging::ILogger& logger, uint32_t transactionSoftLockTime,
+  BlockchainSynchronizer* ownSynchronizer, SharedBlockchainSynchronizer* sharedSynchronizer) :
   m_dispatcher(dispatcher),
   m_currency(currency),
   m_node(node),
   m_logger(logger, "WalletGreen/empty"),
   m_stopped(false),
   m_blockchainSynchronizerStarted(false),
-  m_blockchainSynchronizer(node, logger, currency.genesisBlockHash()),
+  m_ownBlockchainSynchronizer(ownSynchronizer),
+  m_sharedSynchronizerUser(sharedSynchronizer),
+  m_blockchainSynchronizer(sharedSynchronizer != nullptr ? sharedSynchronizer->synchronizer() : *ownSynchronizer),
   m_synchronizer(currency, logger, m_blockchainSynchronizer, node),
+  m_indexedTransactions(0),
   m_eventOccurred(m_dispatcher),
+  m_poppedEventCount(0),
+  m_progressEventNumber(NO_EVENT),
+  m_unlockEventNumber(NO_EVENT),
   m_readyEvent(m_dispatcher),
+  m_storageEvent(m_dispatcher),
+  m_decoyCache(DECOY_CACHE_BATCH_SIZE, DECOY_CACHE_AMOUNT_COUNT),
+  m_decoyRefillPending(false),
+  m_decoyRefillFinished(m_dispatcher),
   m_state(WalletState::NOT_INITIALIZED),
   m_actualBalance(0),
   m_pendingBalance(0),
+  m_balanceMinusDust(0),
   m_transactionSoftLockTime(transactionSoftLockTime)
 {
   m_upperTransactionSizeLimit = m_currency.maxTransactionSizeLimit();
   m_readyEvent.set();
+  m_storageEvent.set();
 }
 
 WalletGreen::~WalletGreen() {
@@ -234,13 +285,24 @@ void WalletGreen::doShutdown() {
   stopBlockchainSynchronizer();
   m_blockchainSynchronizer.removeObserver(this);
 
-  m_containerStorage.close();
+  // the node answers every request, the refill must not complete into a wallet that is gone
+  while (m_decoyRefillPending) {
+    m_decoyRefillFinished.wait();
+  }
+
+  m_decoyCache.clear();
+  {
+    System::EventLock lk(m_storageEvent);
+    m_containerStorage.close();
+    m_cacheChunks.reset();
+  }
   m_walletsContainer.clear();
   clearCaches(true, true);
 
-  std::queue<WalletEvent> noEvents;
-  std::swap(m_events, noEvents);
+  m_poppedEventCount += m_events.size();
+  std::deque<WalletEvent>().swap(m_events);
 
+  m_sharedSynchronizerUser.leave();
   m_state = WalletState::NOT_INITIALIZED;
 }
 
@@ -248,6 +310,7 @@ void WalletGreen::clearCaches(bool clearTransactions, bool clearCachedData) {
   if (clearTransactions) {
     m_transactions.clear();
     m_transfers.clear();
+    clearTransactionIndices();
   }
 
   if (clearCachedData) {
@@ -256,6 +319,8 @@ void WalletGreen::clearCaches(bool clearTransactions, bool clearCachedData) {
       m_walletsContainer.modify(it, [&walletIndex](WalletRecord& wallet) {
         wallet.actualBalance = 0;
         wallet.pendingBalance = 0;
+        wallet.balanceMinusDust = 0;
+        wallet.unlockedAmounts.clear();
         wallet.container = reinterpret_cast<CryptoNote::ITransfersContainer*>(walletIndex++); //dirty hack. container field must be unique
       });
     }
@@ -277,6 +342,7 @@ void WalletGreen::clearCaches(bool clearTransactions, bool clearCachedData) {
     m_unlockTransactionsJob.clear();
     m_actualBalance = 0;
     m_pendingBalance = 0;
+    m_balanceMinusDust = 0;
     m_fusionTxsCache.clear();
     m_blockchain.clear();
   }
@@ -392,8 +458,10 @@ void WalletGreen::save(WalletSaveLevel saveLevel, const std::string& extra) {
 
   stopBlockchainSynchronizer();
 
+  // the serialized cache is the snapshot, the wallet goes on while it is encrypted and written
+  std::string containerData;
   try {
-    saveWalletCache(m_containerStorage, m_key, saveLevel, extra);
+    serializeWalletCache(containerData, saveLevel, extra);
   } catch (const std::exception& e) {
     m_logger(ERROR, BRIGHT_RED) << "Failed to save container: " << e.what();
     startBlockchainSynchronizer();
@@ -401,6 +469,20 @@ void WalletGreen::save(WalletSaveLevel saveLevel, const std::string& extra) {
   }
 
   startBlockchainSynchronizer();
+
+  try {
+    System::EventLock lk(m_storageEvent);
+    System::RemoteContext<void> context(m_dispatcher, [this, &containerData] {
+      encryptAndSaveContainerData(m_containerStorage, m_key, containerData.data(), containerData.size(), m_cacheChunks);
+    });
+
+    context.get();
+  } catch (const std::exception& e) {
+    m_logger(ERROR, BRIGHT_RED) << "Failed to save container: " << e.what();
+    throw;
+  }
+
+  m_extra = extra;
   m_logger(INFO, BRIGHT_WHITE) << "Container saved";
 }
 
@@ -413,6 +495,7 @@ void WalletGreen::exportWallet(const std::string& path, bool encrypt, WalletSave
   stopBlockchainSynchronizer();
 
   try {
+    System::EventLock lk(m_storageEvent);
     bool storageCreated = false;
     Tools::ScopeExit failExitHandler([path, &storageCreated] {
       // Don't delete file if it has existed
@@ -535,6 +618,8 @@ void WalletGreen::load(const std::string& path, const std::string& password, std
     m_logger(ERROR, BRIGHT_RED) << "Failed to read output keys!! Continue without output keys: " << e.what();
   }
 
+  initUnlockedOutputs();
+
   m_blockchainSynchronizer.addObserver(this);
 
   initTransactionPool();
@@ -594,9 +679,6 @@ void WalletGreen::loadContainerStorage(const std::string& path) {
 void WalletGreen::loadWalletCache(std::unordered_set<Crypto::PublicKey>& addedKeys, std::unordered_set<Crypto::PublicKey>& deletedKeys, std::string& extra) {
   assert(m_containerStorage.isOpened());
 
-  BinaryArray contanerData;
-  loadAndDecryptContainerData(m_containerStorage, m_key, contanerData);
-
   WalletSerializerV2 s(
     *this,
     m_viewPublicKey,
@@ -613,8 +695,19 @@ void WalletGreen::loadWalletCache(std::unordered_set<Crypto::PublicKey>& addedKe
     m_transactionSoftLockTime
   );
 
-  Common::MemoryInputStream containerStream(contanerData.data(), contanerData.size());
-  s.load(containerStream, reinterpret_cast<const ContainerStoragePrefix*>(m_containerStorage.prefix())->version);
+  uint8_t version = reinterpret_cast<const ContainerStoragePrefix*>(m_containerStorage.prefix())->version;
+  if (version >= WalletSerializerV2::CHUNKED_CACHE_VERSION) {
+    // the cache is deserialized as its chunks are decrypted, no decrypted copy of the whole cache is kept
+    m_cacheChunks.load(m_containerStorage, m_key, [&s, version](Common::IInputStream& containerStream) {
+      s.load(containerStream, version);
+    });
+  } else {
+    BinaryArray contanerData;
+    loadAndDecryptContainerData(m_containerStorage, m_key, contanerData, m_cacheChunks);
+
+    Common::MemoryInputStream containerStream(contanerData.data(), contanerData.size());
+    s.load(containerStream, version);
+  }
   addedKeys = std::move(s.addedKeys());
   deletedKeys = std::move(s.deletedKeys());
 
@@ -622,6 +715,20 @@ void WalletGreen::loadWalletCache(std::unordered_set<Crypto::PublicKey>& addedKe
 }
 
 void WalletGreen::saveWalletCache(ContainerStorage& storage, const Crypto::chacha8_key& key, WalletSaveLevel saveLevel, const std::string& extra) {
+  std::string containerData;
+  serializeWalletCache(containerData, saveLevel, extra);
+
+  if (&storage == &m_containerStorage) {
+    encryptAndSaveContainerData(storage, key, containerData.data(), containerData.size(), m_cacheChunks);
+  } else {
+    WalletCacheChunks cacheChunks;
+    encryptAndSaveContainerData(storage, key, containerData.data(), containerData.size(), cacheChunks);
+  }
+
+  m_extra = extra;
+}
+
+void WalletGreen::serializeWalletCache(std::string& containerData, WalletSaveLevel saveLevel, const std::string& extra) {
   m_logger(DEBUGGING) << "Saving cache...";
 
   WalletTransactions transactions;
@@ -644,7 +751,6 @@ void WalletGreen::saveWalletCache(ContainerStorage& storage, const Crypto::chach
     });
   }
 
-  std::string containerData;
   Common::StringOutputStream containerStream(containerData);
 
   WalletSerializerV2 s(
@@ -665,11 +771,6 @@ void WalletGreen::saveWalletCache(ContainerStorage& storage, const Crypto::chach
 
   s.save(containerStream, saveLevel);
 
-  encryptAndSaveContainerData(storage, key, containerData.data(), containerData.size());
-  storage.flush();
-
-  m_extra = extra;
-
   m_logger(DEBUGGING) << "Container saving finished";
 }
 
@@ -682,20 +783,26 @@ void WalletGreen::copyContainerStorageKeys(ContainerStorage& src, const chacha8_
     dst.flush();
   });
 
-  size_t counter = 0;
+  // IVs are taken from the prefix in order, the records are re-encrypted in parallel
+  std::vector<Crypto::chacha8_iv> ivs;
+  ivs.reserve(src.size());
+  ContainerStoragePrefix* dstPrefix = reinterpret_cast<ContainerStoragePrefix*>(dst.prefix());
+  for (size_t i = 0; i < src.size(); ++i) {
+    ivs.push_back(dstPrefix->nextIv);
+    incIv(dstPrefix->nextIv);
+  }
 
-  for (auto& encryptedSpendKeys : src) {
+  std::vector<EncryptedWalletRecord> records(src.size());
+  System::parallelFor(0, src.size(), [&](size_t i) {
     Crypto::PublicKey publicKey;
     Crypto::SecretKey secretKey;
     uint64_t creationTimestamp;
-    decryptKeyPair(encryptedSpendKeys, publicKey, secretKey, creationTimestamp, srcKey);
+    decryptKeyPair(src[i], publicKey, secretKey, creationTimestamp, srcKey);
+    records[i] = encryptKeyPair(publicKey, secretKey, creationTimestamp, dstKey, ivs[i]);
+  }, System::ThreadPool::shared(), 64);
 
-    // push_back() can resize container, and dstPrefix address can be changed, so it is requested for each key pair
-    ContainerStoragePrefix* dstPrefix = reinterpret_cast<ContainerStoragePrefix*>(dst.prefix());
-    Crypto::chacha8_iv keyPairIv = dstPrefix->nextIv;
-    incIv(dstPrefix->nextIv);
-
-    dst.push_back(encryptKeyPair(publicKey, secretKey, creationTimestamp, dstKey, keyPairIv));
+  for (const auto& record : records) {
+    dst.push_back(record);
   }
 }
 
@@ -713,27 +820,39 @@ void WalletGreen::copyContainerStoragePrefix(ContainerStorage& src, const chacha
   incIv(dstPrefix->nextIv);
 }
 
-void WalletGreen::encryptAndSaveContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, const void* containerData, size_t containerDataSize) {
-  ContainerStoragePrefix* prefix = reinterpret_cast<ContainerStoragePrefix*>(storage.prefix());
-
-  Crypto::chacha8_iv suffixIv = prefix->nextIv;
-  incIv(prefix->nextIv);
+WalletCacheChunks::IvGenerator WalletGreen::containerIvGenerator(ContainerStorage& storage) {
+  // the prefix is requested for each IV, a resize of the suffix remaps the storage
+  return [&storage] {
+    ContainerStoragePrefix* prefix = reinterpret_cast<ContainerStoragePrefix*>(storage.prefix());
+    Crypto::chacha8_iv iv = prefix->nextIv;
+    incIv(prefix->nextIv);
+    return iv;
+  };
+}
 
-  BinaryArray encryptedContainer;
-  encryptedContainer.resize(containerDataSize);
-  chacha8(containerData, containerDataSize, key, suffixIv, reinterpret_cast<char*>(encryptedContainer.data()));
+void WalletGreen::encryptAndSaveContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, const void* containerData, size_t containerDataSize,
+  WalletCacheChunks& cacheChunks) {
 
-  std::string suffix;
-  Common::StringOutputStream suffixStream(suffix);
-  BinaryOutputStreamSerializer suffixSerializer(suffixStream);
-  suffixSerializer(suffixIv, "suffixIv");
-  suffixSerializer(encryptedContainer, "encryptedContainer");
+  reinterpret_cast<ContainerStoragePrefix*>(storage.prefix())->version = WalletSerializerV2::SERIALIZATION_VERSION;
 
-  storage.resizeSuffix(suffix.size());
-  std::copy(suffix.begin(), suffix.end(), storage.suffix());
+  try {
+    cacheChunks.save(storage, key, containerData, containerDataSize, containerIvGenerator(storage));
+  } catch (...) {
+    cacheChunks.reset();
+    throw;
+  }
 }
 
-void WalletGreen::loadAndDecryptContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, BinaryArray& containerData) {
+void WalletGreen::loadAndDecryptContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, BinaryArray& containerData,
+  WalletCacheChunks& cacheChunks) {
+
+  if (reinterpret_cast<const ContainerStoragePrefix*>(storage.prefix())->version >= WalletSerializerV2::CHUNKED_CACHE_VERSION) {
+    cacheChunks.load(storage, key, containerData);
+    return;
+  }
+
+  cacheChunks.reset();
+
   Common::MemoryInputStream suffixStream(storage.suffix(), storage.suffixSize());
   BinaryInputStreamSerializer suffixSerializer(suffixStream);
   Crypto::chacha8_iv suffixIv;
@@ -768,25 +887,37 @@ void WalletGreen::deleteOrphanTransactions(const std::unordered_set<Crypto::Publ
 }
 
 void WalletGreen::loadSpendKeys() {
-  bool isTrackingMode;
-  for (size_t i = 0; i < m_containerStorage.size(); ++i) {
-    WalletRecord wallet;
+  // decryption and the key checks run in parallel, the records are validated and added in order
+  size_t count = m_containerStorage.size();
+  std::vector<WalletRecord> wallets(count);
+  std::unique_ptr<bool[]> keysValid(new bool[count]);
+  System::parallelFor(0, count, [&](size_t i) {
+    WalletRecord& wallet = wallets[i];
     uint64_t creationTimestamp;
-    decryptKeyPair(m_containerStorage[i], wallet.spendPublicKey, wallet.spendSecretKey, creationTimestamp);
+    decryptKeyPair(m_containerStorage[i], wallet.spendPublicKey, wallet.spendSecretKey, creationTimestamp, m_key);
     wallet.creationTimestamp = creationTimestamp;
 
+    if (wallet.spendSecretKey != NULL_SECRET_KEY) {
+      Crypto::PublicKey publicKey;
+      keysValid[i] = Crypto::secret_key_to_public_key(wallet.spendSecretKey, publicKey) && publicKey == wallet.spendPublicKey;
+    } else {
+      keysValid[i] = Crypto::check_key(wallet.spendPublicKey);
+    }
+  }, System::ThreadPool::shared(), 64);
+
+  bool isTrackingMode;
+  for (size_t i = 0; i < count; ++i) {
+    WalletRecord& wallet = wallets[i];
+
     if (i == 0) {
       isTrackingMode = wallet.spendSecretKey == NULL_SECRET_KEY;
     } else if ((isTrackingMode && wallet.spendSecretKey != NULL_SECRET_KEY) || (!isTrackingMode && wallet.spendSecretKey == NULL_SECRET_KEY)) {
       throw std::system_error(make_error_code(error::BAD_ADDRESS), "All addresses must be whether tracking or not");
     }
 
-    if (wallet.spendSecretKey != NULL_SECRET_KEY) {
-      throwIfKeysMissmatch(wallet.spendSecretKey, wallet.spendPublicKey, "Restored spend public key doesn't correspond to secret key");
-    } else {
-      if (!Crypto::check_key(wallet.spendPublicKey)) {
-        throw std::system_error(make_error_code(error::WRONG_PASSWORD), "Public spend key is incorrect");
-      }
+    if (!keysValid[i]) {
+      throw std::system_error(make_error_code(error::WRONG_PASSWORD), wallet.spendSecretKey != NULL_SECRET_KEY ?
+        "Restored spend public key doesn't correspond to secret key" : "Public spend key is incorrect");
     }
 
     wallet.actualBalance = 0;
@@ -924,16 +1055,26 @@ void WalletGreen::changePassword(const std::string& oldPassword, const std::stri
   Crypto::chacha8_key newKey;
   Crypto::generate_chacha8_key(cnContext, newPassword, newKey);
 
-  m_containerStorage.atomicUpdate([this, newKey](ContainerStorage& newStorage) {
-    copyContainerStoragePrefix(m_containerStorage, m_key, newStorage, newKey);
-    copyContainerStorageKeys(m_containerStorage, m_key, newStorage, newKey);
-
-    if (m_containerStorage.suffixSize() > 0) {
-      BinaryArray containerData;
-      loadAndDecryptContainerData(m_containerStorage, m_key, containerData);
-      encryptAndSaveContainerData(newStorage, newKey, containerData.data(), containerData.size());
-    }
-  });
+  System::EventLock lk(m_storageEvent);
+  try {
+    m_containerStorage.atomicUpdate([this, newKey](ContainerStorage& newStorage) {
+      copyContainerStoragePrefix(m_containerStorage, m_key, newStorage, newKey);
+      copyContainerStorageKeys(m_containerStorage, m_key, newStorage, newKey);
+
+      if (m_containerStorage.suffixSize() > 0) {
+        BinaryArray containerData;
+        WalletCacheChunks cacheChunks;
+        loadAndDecryptContainerData(m_containerStorage, m_key, containerData, cacheChunks);
+
+        // the new storage replaces the current one, so its layout is the one to keep
+        reinterpret_cast<ContainerStoragePrefix*>(newStorage.prefix())->version = WalletSerializerV2::SERIALIZATION_VERSION;
+        m_cacheChunks.write(newStorage, newKey, containerData.data(), containerData.size(), containerIvGenerator(newStorage));
+      }
+    });
+  } catch (...) {
+    m_cacheChunks.reset();
+    throw;
+  }
 
   m_key = newKey;
   m_password = newPassword;
@@ -1070,17 +1211,9 @@ std::string WalletGreen::createAddress(const Crypto::PublicKey& spendPublicKey,
 }
 
 std::vector<std::string> WalletGreen::createAddressList(const std::vector<Crypto::SecretKey>& spendSecretKeys, bool reset) {
-  std::vector<NewAddressData> addressDataList(spendSecretKeys.size());
-  for (size_t i = 0; i < spendSecretKeys.size(); ++i) {
-    Crypto::PublicKey spendPublicKey;
-    if (!Crypto::secret_key_to_public_key(spendSecretKeys[i], spendPublicKey)) {
-      m_logger(ERROR, BRIGHT_RED) << "createAddressList(): failed to convert secret key to public key, secret key " << spendSecretKeys[i];
-      throw std::system_error(make_error_code(CryptoNote::error::KEY_GENERATION_ERROR));
-    }
-
-    addressDataList[i].spendSecretKey = spendSecretKeys[i];
-    addressDataList[i].spendPublicKey = spendPublicKey;
-    addressDataList[i].creationTimestamp = reset ? 0 : static_cast<uint64_t>(time(nullptr));
+  std::vector<NewAddressData> addressDataList = makeAddressDataList(spendSecretKeys);
+  for (auto& addressData : addressDataList) {
+    addressData.creationTimestamp = reset ? 0 : static_cast<uint64_t>(time(nullptr));
   }
 
   return doCreateAddressList(addressDataList);
@@ -1091,16 +1224,9 @@ std::vector<std::string> WalletGreen::createAddressList(const std::vector<Crypto
     m_logger(ERROR, BRIGHT_RED) << "createAddressList(): the sizes of keys and timestamps vectors do not match.";
     throw std::system_error(make_error_code(std::errc::invalid_argument));
   }
-  std::vector<NewAddressData> addressDataList(spendSecretKeys.size());
-  for (size_t i = 0; i < spendSecretKeys.size(); ++i) {
-    Crypto::PublicKey spendPublicKey;
-    if (!Crypto::secret_key_to_public_key(spendSecretKeys[i], spendPublicKey)) {
-      m_logger(ERROR, BRIGHT_RED) << "createAddressList(): failed to convert secret key to public key, secret key " << spendSecretKeys[i];
-      throw std::system_error(make_error_code(CryptoNote::error::KEY_GENERATION_ERROR));
-    }
 
-    addressDataList[i].spendSecretKey = spendSecretKeys[i];
-    addressDataList[i].spendPublicKey = spendPublicKey;
+  std::vector<NewAddressData> addressDataList = makeAddressDataList(spendSecretKeys);
+  for (size_t i = 0; i < addressDataList.size(); ++i) {
     addressDataList[i].creationTimestamp = creationTimestamps[i];
   }
 
@@ -1112,20 +1238,42 @@ std::vector<std::string> WalletGreen::createAddressList(const std::vector<Crypto
     m_logger(ERROR, BRIGHT_RED) << "createAddressList(): the sizes of keys and scan heights vectors do not match.";
     throw std::system_error(make_error_code(std::errc::invalid_argument));
   }
+
+  std::vector<NewAddressData> addressDataList = makeAddressDataList(spendSecretKeys);
+
+  // a batch usually shares a few scan heights, the node is asked once per height
+  std::unordered_map<uint32_t, uint64_t> timestamps;
+  uint32_t minScanHeight = std::numeric_limits<uint32_t>::max();
+  for (size_t i = 0; i < addressDataList.size(); ++i) {
+    auto it = timestamps.find(scanHeights[i]);
+    if (it == timestamps.end()) {
+      it = timestamps.emplace(scanHeights[i], scanHeightToTimestamp(scanHeights[i])).first;
+    }
+
+    addressDataList[i].creationTimestamp = it->second;
+    minScanHeight = std::min(minScanHeight, scanHeights[i]);
+  }
+
+  // the wallet has to go back only when it has already passed the lowest scan height
+  return doCreateAddressList(addressDataList, minScanHeight < m_blockchain.size());
+}
+
+std::vector<WalletGreen::NewAddressData> WalletGreen::makeAddressDataList(const std::vector<Crypto::SecretKey>& spendSecretKeys) {
   std::vector<NewAddressData> addressDataList(spendSecretKeys.size());
+  std::unique_ptr<bool[]> derived(new bool[spendSecretKeys.size()]);
+  System::parallelFor(0, spendSecretKeys.size(), [&](size_t i) {
+    addressDataList[i].spendSecretKey = spendSecretKeys[i];
+    derived[i] = Crypto::secret_key_to_public_key(spendSecretKeys[i], addressDataList[i].spendPublicKey);
+  }, System::ThreadPool::shared(), 64);
+
   for (size_t i = 0; i < spendSecretKeys.size(); ++i) {
-    Crypto::PublicKey spendPublicKey;
-    if (!Crypto::secret_key_to_public_key(spendSecretKeys[i], spendPublicKey)) {
+    if (!derived[i]) {
       m_logger(ERROR, BRIGHT_RED) << "createAddressList(): failed to convert secret key to public key, secret key " << spendSecretKeys[i];
       throw std::system_error(make_error_code(CryptoNote::error::KEY_GENERATION_ERROR));
     }
-
-    addressDataList[i].spendSecretKey = spendSecretKeys[i];
-    addressDataList[i].spendPublicKey = spendPublicKey;
-    addressDataList[i].creationTimestamp = scanHeightToTimestamp(scanHeights[i]);
   }
 
-  return doCreateAddressList(addressDataList);
+  return addressDataList;
 }
 
 std::string WalletGreen::doCreateAddress(const Crypto::PublicKey& spendPublicKey, const Crypto::SecretKey& spendSecretKey, uint64_t creationTimestamp) {
@@ -1140,6 +1288,17 @@ std::string WalletGreen::doCreateAddress(const Crypto::PublicKey& spendPublicKey
 }
 
 std::vector<std::string> WalletGreen::doCreateAddressList(const std::vector<NewAddressData>& addressDataList) {
+  uint64_t minCreationTimestamp = std::numeric_limits<uint64_t>::max();
+  for (auto& addressData : addressDataList) {
+    assert(addressData.creationTimestamp <= std::numeric_limits<uint64_t>::max() - m_currency.blockFutureTimeLimit());
+    minCreationTimestamp = std::min(minCreationTimestamp, addressData.creationTimestamp);
+  }
+
+  auto currentTime = static_cast<uint64_t>(time(nullptr));
+  return doCreateAddressList(addressDataList, minCreationTimestamp + m_currency.blockFutureTimeLimit() < currentTime);
+}
+
+std::vector<std::string> WalletGreen::doCreateAddressList(const std::vector<NewAddressData>& addressDataList, bool resetRequired) {
   throwIfNotInitialized();
   throwIfStopped();
 
@@ -1147,9 +1306,8 @@ std::vector<std::string> WalletGreen::doCreateAddressList(const std::vector<NewA
 
   std::vector<std::string> addresses;
   try {
-    uint64_t minCreationTimestamp = std::numeric_limits<uint64_t>::max();
-
     {
+      System::EventLock lk(m_storageEvent);
       if (addressDataList.size() > 1) {
         m_containerStorage.setAutoFlush(false);
       }
@@ -1161,19 +1319,17 @@ std::vector<std::string> WalletGreen::doCreateAddressList(const std::vector<NewA
         }
       });
 
-      for (auto& addressData : addressDataList) {
-        assert(addressData.creationTimestamp <= std::numeric_limits<uint64_t>::max() - m_currency.blockFutureTimeLimit());
-        std::string address = addWallet(addressData.spendPublicKey, addressData.spendSecretKey, addressData.creationTimestamp);
-        m_logger(INFO, BRIGHT_WHITE) << "New wallet added " << address << ", creation timestamp " << addressData.creationTimestamp;
-        addresses.push_back(std::move(address));
+      addresses = addWallets(addressDataList);
+    }
 
-        minCreationTimestamp = std::min(minCreationTimestamp, addressData.creationTimestamp);
-      }
+    if (addresses.size() == 1) {
+      m_logger(INFO, BRIGHT_WHITE) << "New wallet added " << addresses.front() << ", creation timestamp " << addressDataList.front().creationTimestamp;
+    } else {
+      m_logger(INFO, BRIGHT_WHITE) << addresses.size() << " new wallets added";
     }
 
     m_containerStorage.setAutoFlush(true);
-    auto currentTime = static_cast<uint64_t>(time(nullptr));
-    if (minCreationTimestamp + m_currency.blockFutureTimeLimit() < currentTime) {
+    if (resetRequired) {
       m_logger(DEBUGGING) << "Reset is required";
       save(WalletSaveLevel::SAVE_KEYS_AND_TRANSACTIONS, m_extra);
       shutdown();
@@ -1190,66 +1346,93 @@ std::vector<std::string> WalletGreen::doCreateAddressList(const std::vector<NewA
   return addresses;
 }
 
-std::string WalletGreen::addWallet(const Crypto::PublicKey& spendPublicKey, const Crypto::SecretKey& spendSecretKey, uint64_t creationTimestamp) {
+std::vector<std::string> WalletGreen::addWallets(const std::vector<NewAddressData>& addressDataList) {
   auto& index = m_walletsContainer.get<KeysIndex>();
 
   auto trackingMode = getTrackingMode();
 
-  if ((trackingMode == WalletTrackingMode::TRACKING && spendSecretKey != NULL_SECRET_KEY) ||
-      (trackingMode == WalletTrackingMode::NOT_TRACKING && spendSecretKey == NULL_SECRET_KEY)) {
-    m_logger(ERROR, BRIGHT_RED) << "Failed to add wallet: incompatible tracking mode and spend secret key, tracking mode=" << trackingMode <<
-      ", spendSecretKey " << (spendSecretKey == NULL_SECRET_KEY ? "is null" : "is not null");
-    throw std::system_error(make_error_code(error::WRONG_PARAMETERS));
-  }
+  // the whole list is checked before anything is added
+  std::unordered_set<Crypto::PublicKey> newKeys;
+  newKeys.reserve(addressDataList.size());
+  for (auto& addressData : addressDataList) {
+    if ((trackingMode == WalletTrackingMode::TRACKING && addressData.spendSecretKey != NULL_SECRET_KEY) ||
+        (trackingMode == WalletTrackingMode::NOT_TRACKING && addressData.spendSecretKey == NULL_SECRET_KEY)) {
+      m_logger(ERROR, BRIGHT_RED) << "Failed to add wallet: incompatible tracking mode and spend secret key, tracking mode=" << trackingMode <<
+        ", spendSecretKey " << (addressData.spendSecretKey == NULL_SECRET_KEY ? "is null" : "is not null");
+      throw std::system_error(make_error_code(error::WRONG_PARAMETERS));
+    }
 
-  auto insertIt = index.find(spendPublicKey);
-  if (insertIt != index.end()) {
-    m_logger(ERROR, BRIGHT_RED) << "Failed to add wallet: address already exists, " <<
-      m_currency.accountAddressAsString(AccountPublicAddress{spendPublicKey, m_viewPublicKey});
-    throw std::system_error(make_error_code(error::ADDRESS_ALREADY_EXISTS));
+    if (index.find(addressData.spendPublicKey) != index.end() || !newKeys.insert(addressData.spendPublicKey).second) {
+      m_logger(ERROR, BRIGHT_RED) << "Failed to add wallet: address already exists, " <<
+        m_currency.accountAddressAsString(AccountPublicAddress{addressData.spendPublicKey, m_viewPublicKey});
+      throw std::system_error(make_error_code(error::ADDRESS_ALREADY_EXISTS));
+    }
   }
 
-  m_containerStorage.push_back(encryptKeyPair(spendPublicKey, spendSecretKey, creationTimestamp));
-  incNextIv();
-
+  bool wasEmpty = index.empty();
+  size_t storageSize = m_containerStorage.size();
+  std::vector<std::string> addresses;
   try {
-    AccountSubscription sub;
-    sub.keys.address.viewPublicKey = m_viewPublicKey;
-    sub.keys.address.spendPublicKey = spendPublicKey;
-    sub.keys.viewSecretKey = m_viewSecretKey;
-    sub.keys.spendSecretKey = spendSecretKey;
-    sub.transactionSpendableAge = m_transactionSoftLockTime;
-    sub.syncStart.height = 0;
-    sub.syncStart.timestamp = std::max(creationTimestamp, ACCOUNT_CREATE_TIME_ACCURACY) - ACCOUNT_CREATE_TIME_ACCURACY;
-
-    auto& trSubscription = m_synchronizer.addSubscription(sub);
-    ITransfersContainer* container = &trSubscription.getContainer();
-
-    WalletRecord wallet;
-    wallet.spendPublicKey = spendPublicKey;
-    wallet.spendSecretKey = spendSecretKey;
-    wallet.container = container;
-    wallet.creationTimestamp = static_cast<time_t>(creationTimestamp);
-    trSubscription.addObserver(this);
-
-    index.insert(insertIt, std::move(wallet));
+    m_containerStorage.reserve(storageSize + addressDataList.size());
+
+    std::vector<AccountSubscription> subscriptions;
+    subscriptions.reserve(addressDataList.size());
+    for (auto& addressData : addressDataList) {
+      m_containerStorage.push_back(encryptKeyPair(addressData.spendPublicKey, addressData.spendSecretKey, addressData.creationTimestamp));
+      incNextIv();
+
+      AccountSubscription sub;
+      sub.keys.address.viewPublicKey = m_viewPublicKey;
+      sub.keys.address.spendPublicKey = addressData.spendPublicKey;
+      sub.keys.viewSecretKey = m_viewSecretKey;
+      sub.keys.spendSecretKey = addressData.spendSecretKey;
+      sub.transactionSpendableAge = m_transactionSoftLockTime;
+      sub.syncStart.height = 0;
+      sub.syncStart.timestamp = std::max(addressData.creationTimestamp, ACCOUNT_CREATE_TIME_ACCURACY) - ACCOUNT_CREATE_TIME_ACCURACY;
+      subscriptions.push_back(sub);
+    }
+
+    std::vector<ITransfersSubscription*> trSubscriptions = m_synchronizer.addSubscriptions(subscriptions);
+
+    addresses.reserve(addressDataList.size());
+    for (size_t i = 0; i < addressDataList.size(); ++i) {
+      const NewAddressData& addressData = addressDataList[i];
+
+      WalletRecord wallet;
+      wallet.spendPublicKey = addressData.spendPublicKey;
+      wallet.spendSecretKey = addressData.spendSecretKey;
+      wallet.container = &trSubscriptions[i]->getContainer();
+      wallet.creationTimestamp = static_cast<time_t>(addressData.creationTimestamp);
+      trSubscriptions[i]->addObserver(this);
+
+      index.insert(std::move(wallet));
+
+      addresses.push_back(m_currency.accountAddressAsString({ addressData.spendPublicKey, m_viewPublicKey }));
+      m_logger(DEBUGGING) << "Wallet added " << addresses.back() << ", creation timestamp " << addressData.creationTimestamp;
+    }
+
     m_logger(DEBUGGING) << "Wallet count " << m_walletsContainer.size();
 
-    if (index.size() == 1) {
+    if (wasEmpty && !index.empty()) {
       m_synchronizer.subscribeConsumerNotifications(m_viewPublicKey, this);
       initBlockchain(m_viewPublicKey);
     }
 
-    auto address = m_currency.accountAddressAsString({ spendPublicKey, m_viewPublicKey });
-    m_logger(DEBUGGING) << "Wallet added " << address << ", creation timestamp " << creationTimestamp;
-    return address;
+    return addresses;
   } catch (const std::exception& e) {
-    m_logger(ERROR) << "Failed to add wallet: " << e.what();
+    m_logger(ERROR) << "Failed to add wallets: " << e.what();
 
     try {
-      m_containerStorage.pop_back();
+      for (auto& addressData : addressDataList) {
+        index.erase(addressData.spendPublicKey);
+        m_synchronizer.removeSubscription(AccountPublicAddress{ addressData.spendPublicKey, m_viewPublicKey });
+      }
+
+      while (m_containerStorage.size() > storageSize) {
+        m_containerStorage.pop_back();
+      }
     } catch (...) {
-      m_logger(ERROR) << "Failed to rollback adding wallet to storage";
+      m_logger(ERROR) << "Failed to rollback adding wallets to storage";
     }
 
     throw;
@@ -1328,26 +1511,31 @@ void WalletGreen::reset(const uint64_t scanHeight)
     /* Stop so things can't be added to the container as we're looping */
     stop();
 
-    /* Grab the wallet encrypted prefix */
-    auto* prefix = reinterpret_cast<ContainerStoragePrefix*>(m_containerStorage.prefix());
+    /* Wait for a save that is still writing the container */
+    {
+        System::EventLock lk(m_storageEvent);
+
+        /* Grab the wallet encrypted prefix */
+        auto* prefix = reinterpret_cast<ContainerStoragePrefix*>(m_containerStorage.prefix());
 
-    uint64_t newTimestamp = scanHeightToTimestamp((uint32_t) scanHeight);
+        uint64_t newTimestamp = scanHeightToTimestamp((uint32_t) scanHeight);
 
-    /* Reencrypt with the new creation timestamp so we rescan from here when we relaunch */
-    prefix->encryptedViewKeys = encryptKeyPair(m_viewPublicKey, m_viewSecretKey, newTimestamp);
+        /* Reencrypt with the new creation timestamp so we rescan from here when we relaunch */
+        prefix->encryptedViewKeys = encryptKeyPair(m_viewPublicKey, m_viewSecretKey, newTimestamp);
 
-    /* As a reference so we can update it */
-    for (auto& encryptedSpendKeys : m_containerStorage)
-    {
-        Crypto::PublicKey publicKey;
-        Crypto::SecretKey secretKey;
-        uint64_t oldTimestamp;
+        /* As a reference so we can update it */
+        for (auto& encryptedSpendKeys : m_containerStorage)
+        {
+            Crypto::PublicKey publicKey;
+            Crypto::SecretKey secretKey;
+            uint64_t oldTimestamp;
 
-        /* Decrypt the key pair we're pointing to */
-        decryptKeyPair(encryptedSpendKeys, publicKey, secretKey, oldTimestamp);
+            /* Decrypt the key pair we're pointing to */
+            decryptKeyPair(encryptedSpendKeys, publicKey, secretKey, oldTimestamp);
 
-        /* Re-encrypt with the new timestamp */
-        encryptedSpendKeys = encryptKeyPair(publicKey, secretKey, newTimestamp);
+            /* Re-encrypt with the new timestamp */
+            encryptedSpendKeys = encryptKeyPair(publicKey, secretKey, newTimestamp);
+        }
     }
 
     /* Start again so we can save */
@@ -1384,6 +1572,7 @@ void WalletGreen::deleteAddress(const std::string& address) {
 
   m_actualBalance -= it->actualBalance;
   m_pendingBalance -= it->pendingBalance;
+  m_balanceMinusDust -= it->balanceMinusDust;
 
   if (it->actualBalance != 0 || it->pendingBalance != 0) {
     m_logger(INFO, BRIGHT_WHITE) << "Container balance updated, actual " << m_currency.formatAmount(m_actualBalance) <<
@@ -1402,7 +1591,10 @@ void WalletGreen::deleteAddress(const std::string& address) {
   assert(creationTimestamp == static_cast<uint64_t>(it->creationTimestamp));
 #endif
 
-  m_containerStorage.erase(std::next(m_containerStorage.begin(), addressIndex));
+  {
+    System::EventLock lk(m_storageEvent);
+    m_containerStorage.erase(std::next(m_containerStorage.begin(), addressIndex));
+  }
 
   m_synchronizer.removeSubscription(pubAddr);
 
@@ -1546,24 +1738,19 @@ size_t WalletGreen::transfer(const TransactionParameters& transactionParameters,
 
 uint64_t WalletGreen::getBalanceMinusDust(const std::vector<std::string>& addresses)
 {
-    std::vector<WalletOuts> wallets = addresses.empty() ? pickWalletsWithMoney() : pickWallets(addresses);
-    std::vector<OutputToTransfer> unused;
+  if (addresses.empty()) {
+    return m_balanceMinusDust;
+  }
 
-	/* We want to get the full balance, so don't stop getting outputs early */
-	uint64_t needed = std::numeric_limits<uint64_t>::max();
+  uint64_t balance = 0;
+  for (const auto& address : addresses) {
+    balance += getWalletRecord(address).balanceMinusDust;
+  }
 
-	return selectTransfers
-	(
-		needed,
-		/* Don't include dust outputs */
-		false,
-		m_currency.defaultDustThreshold(),
-		std::move(wallets),
-		unused
-	);
+  return balance;
 }
 
-void WalletGreen::prepareTransaction(std::vector<WalletOuts>&& wallets,
+void WalletGreen::prepareTransaction(const std::vector<std::string>& sourceAddresses,
   const std::vector<WalletOrder>& orders,
   uint64_t fee,
   uint64_t mixIn,
@@ -1578,6 +1765,7 @@ void WalletGreen::prepareTransaction(std::vector<WalletOuts>&& wallets,
   preparedTransaction.neededMoney = countNeededMoney(preparedTransaction.destinations, fee);
 
   std::vector<OutputToTransfer> selectedTransfers;
+  std::vector<WalletOuts> wallets = pickLargestOutputs(sourceAddresses, preparedTransaction.neededMoney);
   uint64_t foundMoney = selectTransfers(preparedTransaction.neededMoney, mixIn == 0, 0, std::move(wallets), selectedTransfers);
 
   if (foundMoney < preparedTransaction.neededMoney) {
@@ -1802,15 +1990,8 @@ size_t WalletGreen::doTransfer(const TransactionParameters& transactionParameter
   CryptoNote::AccountPublicAddress changeDestination = getChangeDestination(transactionParameters.changeDestination, transactionParameters.sourceAddresses);
   m_logger(DEBUGGING) << "Change address " << m_currency.accountAddressAsString(changeDestination);
 
-  std::vector<WalletOuts> wallets;
-  if (!transactionParameters.sourceAddresses.empty()) {
-    wallets = pickWallets(transactionParameters.sourceAddresses);
-  } else {
-    wallets = pickWalletsWithMoney();
-  }
-
   PreparedTransaction preparedTransaction;
-  prepareTransaction(std::move(wallets),
+  prepareTransaction(transactionParameters.sourceAddresses,
     transactionParameters.destinations,
     transactionParameters.fee,
     transactionParameters.mixIn,
@@ -1858,17 +2039,10 @@ size_t WalletGreen::makeTransaction(const TransactionParameters& sendingTransact
   CryptoNote::AccountPublicAddress changeDestination = getChangeDestination(sendingTransaction.changeDestination, sendingTransaction.sourceAddresses);
   m_logger(DEBUGGING) << "Change address " << m_currency.accountAddressAsString(changeDestination);
 
-  std::vector<WalletOuts> wallets;
-  if (!sendingTransaction.sourceAddresses.empty()) {
-    wallets = pickWallets(sendingTransaction.sourceAddresses);
-  } else {
-    wallets = pickWalletsWithMoney();
-  }
-
   PreparedTransaction preparedTransaction;
   Crypto::SecretKey txSecretKey;
   prepareTransaction(
-    std::move(wallets),
+    sendingTransaction.sourceAddresses,
     sendingTransaction.destinations,
     sendingTransaction.fee,
     sendingTransaction.mixIn,
@@ -1921,6 +2095,63 @@ void WalletGreen::commitTransaction(size_t transactionId) {
   m_logger(INFO, BRIGHT_WHITE) << "Delayed transaction sent, ID " << transactionId << ", hash " << m_transactions[transactionId].hash;
 }
 
+std::vector<std::error_code> WalletGreen::commitTransactions(const std::vector<size_t>& transactionIds) {
+  System::EventLock lk(m_readyEvent);
+
+  throwIfNotInitialized();
+  throwIfStopped();
+  throwIfTrackingMode();
+
+  std::vector<std::error_code> errors(transactionIds.size());
+  std::vector<size_t> relayed;
+  System::Event completion(m_dispatcher);
+  size_t pendingCount = 0;
+
+  for (size_t i = 0; i < transactionIds.size(); ++i) {
+    size_t transactionId = transactionIds[i];
+    if (transactionId >= m_transactions.size()) {
+      m_logger(ERROR, BRIGHT_RED) << "Failed to commit transaction: invalid index " << transactionId << ". Number of transactions: " << m_transactions.size();
+      errors[i] = make_error_code(CryptoNote::error::INDEX_OUT_OF_RANGE);
+      continue;
+    }
+
+    auto txIt = std::next(m_transactions.get<RandomAccessIndex>().begin(), transactionId);
+    if (m_uncommitedTransactions.count(transactionId) == 0 || txIt->state != WalletTransactionState::CREATED) {
+      m_logger(ERROR, BRIGHT_RED) << "Failed to commit transaction: bad transaction state. Transaction index " << transactionId << ", state " << txIt->state;
+      errors[i] = make_error_code(error::TX_TRANSFER_IMPOSSIBLE);
+      continue;
+    }
+
+    relayed.push_back(i);
+    ++pendingCount;
+    m_node.relayTransaction(m_uncommitedTransactions[transactionId], [&errors, &completion, &pendingCount, i, this](std::error_code error) {
+      this->m_dispatcher.remoteSpawn([&errors, &completion, &pendingCount, i, error] {
+        errors[i] = error;
+        if (--pendingCount == 0) {
+          completion.set();
+        }
+      });
+    });
+  }
+
+  if (pendingCount != 0) {
+    completion.wait();
+  }
+
+  for (size_t i : relayed) {
+    size_t transactionId = transactionIds[i];
+    if (errors[i]) {
+      m_logger(ERROR, BRIGHT_RED) << "Failed to relay transaction: " << errors[i] << ", " << errors[i].message() << ". Transaction index " << transactionId;
+    } else {
+      updateTransactionStateAndPushEvent(transactionId, WalletTransactionState::SUCCEEDED);
+      m_uncommitedTransactions.erase(transactionId);
+      m_logger(INFO, BRIGHT_WHITE) << "Delayed transaction sent, ID " << transactionId << ", hash " << m_transactions[transactionId].hash;
+    }
+  }
+
+  return errors;
+}
+
 void WalletGreen::rollbackUncommitedTransaction(size_t transactionId) {
   Tools::ScopeExit releaseContext([this] {
     m_dispatcher.yield();
@@ -1958,6 +2189,7 @@ void WalletGreen::pushBackOutgoingTransfers(size_t txId, const std::vector<Walle
     d.address = dest.address;
     d.amount = dest.amount;
 
+    indexTransfer(txId, d.address);
     m_transfers.emplace_back(txId, std::move(d));
   }
 }
@@ -2212,6 +2444,7 @@ void WalletGreen::appendTransfer(size_t transactionId, size_t firstTransferIdx,
 
   WalletTransfer transfer{ WalletTransferType::USUAL, address, amount };
   m_transfers.emplace(insertIt, std::piecewise_construct, std::forward_as_tuple(transactionId), std::forward_as_tuple(transfer));
+  indexTransfer(transactionId, address);
 }
 
 bool WalletGreen::adjustTransfer(size_t transactionId, size_t firstTransferIdx, const std::string& address, int64_t amount) {
@@ -2245,6 +2478,7 @@ bool WalletGreen::adjustTransfer(size_t transactionId, size_t firstTransferIdx,
   if (!firstAddressTransferFound) {
     WalletTransfer transfer{ WalletTransferType::USUAL, address, amount };
     m_transfers.emplace(it, std::piecewise_construct, std::forward_as_tuple(transactionId), std::forward_as_tuple(transfer));
+    indexTransfer(transactionId, address);
     updated = true;
   }
 
@@ -2306,14 +2540,14 @@ std::unique_ptr<CryptoNote::ITransaction> WalletGreen::makeTransaction(const std
   tx->setUnlockTime(unlockTimestamp);
   tx->appendExtra(Common::asBinaryArray(extra));
 
+  std::vector<TransactionTypes::KeyInputSource> inputs;
+  inputs.reserve(keysInfo.size());
   for (auto& input: keysInfo) {
-    tx->addInput(makeAccountKeys(*input.walletRecord), input.keyInfo, input.ephKeys);
+    inputs.push_back(TransactionTypes::KeyInputSource{makeAccountKeys(*input.walletRecord), &input.keyInfo, &input.ephKeys});
   }
 
-  size_t i = 0;
-  for(auto& input: keysInfo) {
-    tx->signInputKey(i++, input.keyInfo, input.ephKeys);
-  }
+  size_t firstInput = tx->addInputs(inputs);
+  tx->signInputKeys(firstInput, inputs);
 
   SecretKey txkey;
   tx->getTransactionSecretKey(txkey);
@@ -2417,34 +2651,88 @@ void WalletGreen::requestMixinOuts(
   uint64_t mixIn,
   std::vector<CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount>& mixinResult) {
 
+  throwIfStopped();
+
+  auto requestMixinCount = mixIn + 1; //+1 to allow to skip real output
+
   std::vector<uint64_t> amounts;
-  for (const auto& out: selectedTransfers) {
-    amounts.push_back(out.out.amount);
+  std::vector<size_t> requestedTransfers;
+  mixinResult.resize(selectedTransfers.size());
+  for (size_t i = 0; i < selectedTransfers.size(); ++i) {
+    if (!m_decoyCache.take(selectedTransfers[i].out.amount, requestMixinCount, mixinResult[i])) {
+      amounts.push_back(selectedTransfers[i].out.amount);
+      requestedTransfers.push_back(i);
+    }
   }
 
-  System::Event requestFinished(m_dispatcher);
-  std::error_code mixinError;
+  if (!amounts.empty()) {
+    System::Event requestFinished(m_dispatcher);
+    std::error_code mixinError;
+    std::vector<CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount> requestedOuts;
 
-  throwIfStopped();
+    m_logger(DEBUGGING) << "Requesting random outputs";
+    m_node.getRandomOutsByAmounts(std::move(amounts), requestMixinCount, requestedOuts, [&requestFinished, &mixinError, this] (std::error_code ec) {
+      mixinError = ec;
+      this->m_dispatcher.remoteSpawn(std::bind(asyncRequestCompletion, std::ref(requestFinished)));
+    });
 
-  auto requestMixinCount = mixIn + 1; //+1 to allow to skip real output
+    requestFinished.wait();
 
-  m_logger(DEBUGGING) << "Requesting random outputs";
-  m_node.getRandomOutsByAmounts(std::move(amounts), requestMixinCount, mixinResult, [&requestFinished, &mixinError, this] (std::error_code ec) {
-    mixinError = ec;
-    this->m_dispatcher.remoteSpawn(std::bind(asyncRequestCompletion, std::ref(requestFinished)));
-  });
+    checkIfEnoughMixins(requestedOuts, requestMixinCount);
+
+    if (mixinError) {
+      m_logger(ERROR, BRIGHT_RED) << "Failed to get random outputs: " << mixinError << ", " << mixinError.message();
+      throw std::system_error(mixinError);
+    }
+
+    if (requestedOuts.size() != requestedTransfers.size()) {
+      m_logger(ERROR, BRIGHT_RED) << "Failed to get random outputs: requested " << requestedTransfers.size() << " amounts, received " << requestedOuts.size();
+      throw std::system_error(make_error_code(error::INTERNAL_WALLET_ERROR), "Wrong number of random output amounts");
+    }
+
+    for (size_t i = 0; i < requestedTransfers.size(); ++i) {
+      mixinResult[requestedTransfers[i]] = std::move(requestedOuts[i]);
+    }
+  }
 
-  requestFinished.wait();
+  m_logger(DEBUGGING) << "Random outputs received, " << selectedTransfers.size() - requestedTransfers.size() << " of " <<
+    selectedTransfers.size() << " taken from cache";
+
+  refillDecoyCache(requestMixinCount);
+}
 
-  checkIfEnoughMixins(mixinResult, requestMixinCount);
+/**
+ * Asks the node in the background for random outputs of the amounts the cache runs short of,
+ * at most one request is in flight at a time.
+ */
+void WalletGreen::refillDecoyCache(uint64_t ringSize) {
+  if (m_decoyRefillPending) {
+    return;
+  }
 
-  if (mixinError) {
-    m_logger(ERROR, BRIGHT_RED) << "Failed to get random outputs: " << mixinError << ", " << mixinError.message();
-    throw std::system_error(mixinError);
+  auto amounts = m_decoyCache.amountsToRefill(DECOY_CACHE_RING_COUNT * ringSize);
+  if (amounts.empty()) {
+    return;
   }
 
-  m_logger(DEBUGGING) << "Random outputs received";
+  auto result = std::make_shared<std::vector<CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount>>();
+  uint64_t generation = m_decoyCache.generation();
+  m_decoyRefillPending = true;
+  m_decoyRefillFinished.clear();
+
+  m_logger(DEBUGGING) << "Refilling random outputs cache, amounts " << amounts.size();
+  m_node.getRandomOutsByAmounts(std::move(amounts), m_decoyCache.batchSize(), *result, [this, result, generation] (std::error_code ec) {
+    m_dispatcher.remoteSpawn([this, result, generation, ec] {
+      if (ec) {
+        m_logger(DEBUGGING) << "Failed to refill random outputs cache: " << ec << ", " << ec.message();
+      } else {
+        m_decoyCache.add(std::move(*result), generation);
+      }
+
+      m_decoyRefillPending = false;
+      m_decoyRefillFinished.set();
+    });
+  });
 }
 
 uint64_t WalletGreen::selectTransfers(
@@ -2525,6 +2813,11 @@ std::vector<WalletGreen::WalletOuts> WalletGreen::pickWallets(const std::vector<
   wallets.reserve(addresses.size());
 
   for (const auto& address: addresses) {
+    // there is no unlocked output to collect without an actual balance
+    if (getWalletRecord(address).actualBalance == 0) {
+      continue;
+    }
+
     WalletOuts wallet = pickWallet(address);
     if (!wallet.outs.empty()) {
       wallets.emplace_back(std::move(wallet));
@@ -2534,6 +2827,52 @@ std::vector<WalletGreen::WalletOuts> WalletGreen::pickWallets(const std::vector<
   return wallets;
 }
 
+/*
+ * Collects the largest unlocked outputs of the wallets, visited in random order, until they cover the needed money
+ * with a few spare outputs in every visited wallet. The outputs of a transaction are then picked at random among
+ * these candidates, so neither the selection cost nor the transaction size grows with the number of small outputs.
+ */
+std::vector<WalletGreen::WalletOuts> WalletGreen::pickLargestOutputs(const std::vector<std::string>& addresses, uint64_t neededMoney) const {
+  std::vector<WalletRecord*> candidates;
+  if (addresses.empty()) {
+    for (const auto& wallet : m_walletsContainer.get<RandomAccessIndex>()) {
+      if (wallet.actualBalance != 0) {
+        candidates.push_back(const_cast<WalletRecord*>(&wallet));
+      }
+    }
+  } else {
+    for (const auto& address : addresses) {
+      const auto& wallet = getWalletRecord(address);
+      if (wallet.actualBalance != 0) {
+        candidates.push_back(const_cast<WalletRecord*>(&wallet));
+      }
+    }
+  }
+
+  std::shuffle(candidates.begin(), candidates.end(), Random::generator());
+
+  std::vector<WalletOuts> walletOuts;
+  uint64_t foundMoney = 0;
+  for (auto wallet : candidates) {
+    if (foundMoney >= neededMoney) {
+      break;
+    }
+
+    WalletOuts outs;
+    outs.wallet = wallet;
+    wallet->container->getLargestOutputs(outs.outs, ITransfersContainer::IncludeKeyUnlocked, neededMoney - foundMoney, SPARE_SELECTION_OUTPUT_COUNT);
+    for (const auto& out : outs.outs) {
+      foundMoney += out.amount;
+    }
+
+    if (!outs.outs.empty()) {
+      walletOuts.push_back(std::move(outs));
+    }
+  }
+
+  return walletOuts;
+}
+
 std::vector<CryptoNote::WalletGreen::ReceiverAmounts> WalletGreen::splitDestinations(const std::vector<CryptoNote::WalletTransfer>& destinations,
   uint64_t dustThreshold,
   const CryptoNote::Currency& currency) {
@@ -2636,15 +2975,11 @@ std::vector<TransactionsInBlockInfo> WalletGreen::getTransactions(const Crypto::
   throwIfNotInitialized();
   throwIfStopped();
 
-  auto& hashIndex = m_blockchain.get<BlockHashIndex>();
-  auto it = hashIndex.find(blockHash);
-  if (it == hashIndex.end()) {
+  uint32_t blockIndex;
+  if (!getBlockIndex(blockHash, blockIndex)) {
     return std::vector<TransactionsInBlockInfo>();
   }
 
-  auto heightIt = m_blockchain.project<BlockHeightIndex>(it);
-
-  uint32_t blockIndex = static_cast<uint32_t>(std::distance(m_blockchain.get<BlockHeightIndex>().begin(), heightIt));
   return getTransactionsInBlocks(blockIndex, count);
 }
 
@@ -2655,6 +2990,27 @@ std::vector<TransactionsInBlockInfo> WalletGreen::getTransactions(uint32_t block
   return getTransactionsInBlocks(blockIndex, count);
 }
 
+std::vector<TransactionsInBlockInfo> WalletGreen::getTransactions(const Crypto::Hash& blockHash, size_t count,
+  const std::vector<std::string>& addresses, const Crypto::Hash* paymentId) const {
+  throwIfNotInitialized();
+  throwIfStopped();
+
+  uint32_t blockIndex;
+  if (!getBlockIndex(blockHash, blockIndex)) {
+    return std::vector<TransactionsInBlockInfo>();
+  }
+
+  return getTransactionsInBlocks(blockIndex, count, addresses, paymentId);
+}
+
+std::vector<TransactionsInBlockInfo> WalletGreen::getTransactions(uint32_t blockIndex, size_t count,
+  const std::vector<std::string>& addresses, const Crypto::Hash* paymentId) const {
+  throwIfNotInitialized();
+  throwIfStopped();
+
+  return getTransactionsInBlocks(blockIndex, count, addresses, paymentId);
+}
+
 std::vector<Crypto::Hash> WalletGreen::getBlockHashes(uint32_t blockIndex, size_t count) const {
   throwIfNotInitialized();
   throwIfStopped();
@@ -2919,10 +3275,59 @@ WalletEvent WalletGreen::getEvent() {
     throwIfStopped();
   }
 
-  WalletEvent event = std::move(m_events.front());
-  m_events.pop();
+  return popEvent();
+}
 
-  return event;
+std::vector<WalletEvent> WalletGreen::getEvents(size_t maxCount) {
+  throwIfNotInitialized();
+  throwIfStopped();
+
+  while (m_events.empty()) {
+    m_eventOccurred.wait();
+    m_eventOccurred.clear();
+    throwIfStopped();
+  }
+
+  std::vector<WalletEvent> events;
+  events.reserve(std::min(maxCount, m_events.size()));
+  while (events.size() < maxCount && !m_events.empty()) {
+    events.push_back(popEvent());
+  }
+
+  return events;
+}
+
+bool WalletGreen::getEvent(WalletEvent& event, std::chrono::milliseconds timeout) {
+  throwIfNotInitialized();
+  throwIfStopped();
+
+  if (m_events.empty()) {
+    bool timedOut = false;
+    System::Timer timer(m_dispatcher);
+    System::Context<> timeoutContext(m_dispatcher, [&] {
+      try {
+        timer.sleep(timeout);
+      } catch (System::InterruptedException&) {
+        return;
+      }
+
+      timedOut = true;
+      m_eventOccurred.set();
+    });
+
+    while (m_events.empty() && !timedOut) {
+      m_eventOccurred.wait();
+      m_eventOccurred.clear();
+      throwIfStopped();
+    }
+
+    if (m_events.empty()) {
+      return false;
+    }
+  }
+
+  event = popEvent();
+  return true;
 }
 
 void WalletGreen::throwIfNotInitialized() const {
@@ -3002,6 +3407,9 @@ void WalletGreen::blocksRollback(uint32_t blockIndex) {
 
   auto& blockHeightIndex = m_blockchain.get<BlockHeightIndex>();
   blockHeightIndex.erase(std::next(blockHeightIndex.begin(), blockIndex), blockHeightIndex.end());
+
+  // cached mixins could be outputs of the detached blocks
+  m_decoyCache.clear();
 }
 
 void WalletGreen::onTransactionDeleteBegin(const Crypto::PublicKey& viewPublicKey, Crypto::Hash transactionHash) {
@@ -3136,10 +3544,49 @@ void WalletGreen::transactionUpdated(const TransactionInformation& transactionIn
 }
 
 void WalletGreen::pushEvent(const WalletEvent& event) {
-  m_events.push(event);
+  // progress and unlock events only carry the latest state, so a queued one is updated in place
+  uint64_t* coalescedNumber = nullptr;
+  if (event.type == SYNC_PROGRESS_UPDATED) {
+    coalescedNumber = &m_progressEventNumber;
+  } else if (event.type == BALANCE_UNLOCKED) {
+    coalescedNumber = &m_unlockEventNumber;
+  } else if (event.type == SYNC_COMPLETED) {
+    // progress of the next synchronization is reported after the completion
+    m_progressEventNumber = NO_EVENT;
+  }
+
+  if (coalescedNumber != nullptr && *coalescedNumber != NO_EVENT && *coalescedNumber >= m_poppedEventCount) {
+    m_events[static_cast<size_t>(*coalescedNumber - m_poppedEventCount)] = event;
+    m_eventOccurred.set();
+    return;
+  }
+
+  if (m_events.size() >= MAX_QUEUED_EVENT_COUNT) {
+    m_logger(WARNING, BRIGHT_YELLOW) << "Event queue overflow, " << m_events.size() << " events are dropped";
+    m_poppedEventCount += m_events.size();
+    m_events.clear();
+
+    WalletEvent droppedEvent;
+    droppedEvent.type = EVENTS_DROPPED;
+    m_events.push_back(droppedEvent);
+  }
+
+  if (coalescedNumber != nullptr) {
+    *coalescedNumber = m_poppedEventCount + m_events.size();
+  }
+
+  m_events.push_back(event);
   m_eventOccurred.set();
 }
 
+WalletEvent WalletGreen::popEvent() {
+  assert(!m_events.empty());
+  WalletEvent event = std::move(m_events.front());
+  m_events.pop_front();
+  ++m_poppedEventCount;
+  return event;
+}
+
 size_t WalletGreen::getTransactionId(const Hash& transactionHash) const {
   auto it = m_transactions.get<TransactionIndex>().find(transactionHash);
 
@@ -3214,6 +3661,18 @@ void WalletGreen::deleteUnlockTransactionJob(const Hash& transactionHash) {
 }
 
 void WalletGreen::startBlockchainSynchronizer() {
+  if (m_sharedSynchronizerUser.isShared()) {
+    // releases the pause even when there is nothing to synchronize, other wallets keep going
+    if (m_walletsContainer.empty()) {
+      m_sharedSynchronizerUser.leave();
+    } else {
+      m_sharedSynchronizerUser.resume();
+    }
+
+    m_blockchainSynchronizerStarted = !m_walletsContainer.empty();
+    return;
+  }
+
   if (!m_walletsContainer.empty() && !m_blockchainSynchronizerStarted) {
     m_logger(DEBUGGING) << "Starting BlockchainSynchronizer";
     m_blockchainSynchronizer.start();
@@ -3222,6 +3681,13 @@ void WalletGreen::startBlockchainSynchronizer() {
 }
 
 void WalletGreen::stopBlockchainSynchronizer() {
+  if (m_sharedSynchronizerUser.isShared()) {
+    // consumers are about to change, which needs the synchronizer stopped even if this wallet never started it
+    m_sharedSynchronizerUser.pause();
+    m_blockchainSynchronizerStarted = false;
+    return;
+  }
+
   if (m_blockchainSynchronizerStarted) {
     m_logger(DEBUGGING) << "Stopping BlockchainSynchronizer";
     m_blockchainSynchronizer.stop();
@@ -3281,9 +3747,23 @@ void WalletGreen::updateBalance(CryptoNote::ITransfersContainer* container) {
   }
 
   if (updated) {
-    m_walletsContainer.get<TransfersContainerIndex>().modify(it, [actual, pending](WalletRecord& wallet) {
+    // the unlocked outputs can only change together with the actual balance
+    bool unlockedChanged = actual != it->actualBalance;
+    uint64_t minusDust = 0;
+    std::map<uint64_t, size_t> unlockedAmounts;
+    if (unlockedChanged) {
+      countUnlockedOutputs(container, minusDust, unlockedAmounts);
+      m_balanceMinusDust += minusDust;
+      m_balanceMinusDust -= it->balanceMinusDust;
+    }
+
+    m_walletsContainer.get<TransfersContainerIndex>().modify(it, [actual, pending, unlockedChanged, minusDust, &unlockedAmounts](WalletRecord& wallet) {
       wallet.actualBalance = actual;
       wallet.pendingBalance = pending;
+      if (unlockedChanged) {
+        wallet.balanceMinusDust = minusDust;
+        wallet.unlockedAmounts.swap(unlockedAmounts);
+      }
     });
 
     m_logger(INFO, BRIGHT_WHITE) << "Wallet balance updated, address " << m_currency.accountAddressAsString({ it->spendPublicKey, m_viewPublicKey }) <<
@@ -3294,6 +3774,62 @@ void WalletGreen::updateBalance(CryptoNote::ITransfersContainer* container) {
   }
 }
 
+void WalletGreen::countUnlockedOutputs(const CryptoNote::ITransfersContainer* container, uint64_t& balanceMinusDust,
+  std::map<uint64_t, size_t>& amounts) const {
+  std::vector<TransactionOutputInformation> outputs;
+  container->getOutputs(outputs, ITransfersContainer::IncludeKeyUnlocked);
+
+  balanceMinusDust = 0;
+  amounts.clear();
+  for (const auto& output : outputs) {
+    if (output.amount > m_currency.defaultDustThreshold()) {
+      balanceMinusDust += output.amount;
+    }
+
+    ++amounts[output.amount];
+  }
+}
+
+// The unlocked output counts are not stored in the cache, they are taken once the containers are loaded
+void WalletGreen::initUnlockedOutputs() {
+  m_balanceMinusDust = 0;
+
+  auto& index = m_walletsContainer.get<RandomAccessIndex>();
+  for (auto it = index.begin(); it != index.end(); ++it) {
+    uint64_t minusDust = 0;
+    std::map<uint64_t, size_t> amounts;
+    if (it->actualBalance != 0) {
+      countUnlockedOutputs(it->container, minusDust, amounts);
+    }
+
+    index.modify(it, [minusDust, &amounts](WalletRecord& wallet) {
+      wallet.balanceMinusDust = minusDust;
+      wallet.unlockedAmounts.swap(amounts);
+    });
+    m_balanceMinusDust += minusDust;
+  }
+}
+
+// number of unlocked outputs usable as fusion inputs by power of ten of their amounts
+std::array<size_t, std::numeric_limits<uint64_t>::digits10 + 1> WalletGreen::getFusionBuckets(const WalletRecord& wallet,
+  uint64_t threshold, uint32_t height) const {
+  std::array<size_t, std::numeric_limits<uint64_t>::digits10 + 1> bucketSizes;
+  bucketSizes.fill(0);
+  for (const auto& amount : wallet.unlockedAmounts) {
+    uint8_t powerOfTen = 0;
+    if (amount.first >= threshold) {
+      break;
+    }
+
+    if (m_currency.isAmountApplicableInFusionTransactionInput(amount.first, threshold, powerOfTen, height)) {
+      assert(powerOfTen < std::numeric_limits<uint64_t>::digits10 + 1);
+      bucketSizes[powerOfTen] += amount.second;
+    }
+  }
+
+  return bucketSizes;
+}
+
 const WalletRecord& WalletGreen::getWalletRecord(const PublicKey& key) const {
   auto it = m_walletsContainer.get<KeysIndex>().find(key);
   if (it == m_walletsContainer.get<KeysIndex>().end()) {
@@ -3356,11 +3892,18 @@ WalletGreen::WalletTrackingMode WalletGreen::getTrackingMode() const {
 size_t WalletGreen::createFusionTransaction(uint64_t threshold, uint64_t mixin,
   const std::vector<std::string>& sourceAddresses, const std::string& destinationAddress) {
 
-  size_t id = WALLET_INVALID_TRANSACTION_ID;
-  Tools::ScopeExit releaseContext([this, &id] {
+  std::vector<size_t> ids = createFusionTransactions(threshold, mixin, 1, sourceAddresses, destinationAddress);
+  return ids.empty() ? WALLET_INVALID_TRANSACTION_ID : ids.front();
+}
+
+std::vector<size_t> WalletGreen::createFusionTransactions(uint64_t threshold, uint64_t mixin, size_t maxTransactionCount,
+  const std::vector<std::string>& sourceAddresses, const std::string& destinationAddress) {
+
+  std::vector<size_t> ids;
+  Tools::ScopeExit releaseContext([this, &ids] {
     m_dispatcher.yield();
 
-    if (id != WALLET_INVALID_TRANSACTION_ID) {
+    for (size_t id : ids) {
       auto& tx = m_transactions[id];
       m_logger(INFO, BRIGHT_WHITE) << "Fusion transaction created and sent, ID " << id <<
         ", hash " << m_transactions[id].hash <<
@@ -3371,11 +3914,12 @@ size_t WalletGreen::createFusionTransaction(uint64_t threshold, uint64_t mixin,
 
   System::EventLock lk(m_readyEvent);
 
-  m_logger(INFO, BRIGHT_WHITE) << "createFusionTransaction" <<
+  m_logger(INFO, BRIGHT_WHITE) << "createFusionTransactions" <<
     ", from " << Common::makeContainerFormatter(sourceAddresses) <<
     ", to '" << destinationAddress << '\'' <<
     ", threshold " << m_currency.formatAmount(threshold) <<
-    ", mixin " << mixin;
+    ", mixin " << mixin <<
+    ", count " << maxTransactionCount;
 
   throwIfNotInitialized();
   throwIfTrackingMode();
@@ -3405,10 +3949,32 @@ size_t WalletGreen::createFusionTransaction(uint64_t threshold, uint64_t mixin,
     throw std::system_error(make_error_code(error::MIXIN_COUNT_TOO_BIG));
   }
 
-  auto fusionInputs = pickRandomFusionInputs(sourceAddresses, threshold, m_currency.fusionTxMinInputCount(), estimatedFusionInputsCount);
-  if (fusionInputs.size() < m_currency.fusionTxMinInputCount()) {
+  AccountPublicAddress destination = getChangeDestination(destinationAddress, sourceAddresses);
+  m_logger(DEBUGGING) << "Destination address " << m_currency.accountAddressAsString(destination);
+
+  // the outputs spent by a sent transaction are locked, so every round picks from the rest
+  while (ids.size() < maxTransactionCount) {
+    size_t id = makeFusionTransaction(threshold, mixin, estimatedFusionInputsCount, sourceAddresses, destination);
+    if (id == WALLET_INVALID_TRANSACTION_ID) {
+      break;
+    }
+
+    ids.push_back(id);
+  }
+
+  if (ids.empty()) {
     //nothing to optimize
     m_logger(WARNING, BRIGHT_YELLOW) << "Fusion transaction not created: nothing to optimize, threshold " << m_currency.formatAmount(threshold);
+  }
+
+  return ids;
+}
+
+size_t WalletGreen::makeFusionTransaction(uint64_t threshold, uint64_t mixin, size_t maxInputCount,
+  const std::vector<std::string>& sourceAddresses, const AccountPublicAddress& destination) {
+
+  auto fusionInputs = pickRandomFusionInputs(sourceAddresses, threshold, m_currency.fusionTxMinInputCount(), maxInputCount);
+  if (fusionInputs.size() < m_currency.fusionTxMinInputCount()) {
     return WALLET_INVALID_TRANSACTION_ID;
   }
 
@@ -3421,40 +3987,63 @@ size_t WalletGreen::createFusionTransaction(uint64_t threshold, uint64_t mixin,
   std::vector<InputInfo> keysInfo;
   prepareInputs(fusionInputs, mixinResult, mixin, keysInfo);
 
-  AccountPublicAddress destination = getChangeDestination(destinationAddress, sourceAddresses);
-  m_logger(DEBUGGING) << "Destination address " << m_currency.accountAddressAsString(destination);
-
-  std::unique_ptr<ITransaction> fusionTransaction;
+  // the input count is only approximate, drop the biggest inputs until the transaction fits and sign it once
+  ReceiverAmounts decomposedOutputs;
   size_t transactionSize;
-  int round = 0;
-  do {
-    if (round != 0) {
-      fusionInputs.pop_back();
-      keysInfo.pop_back();
-    }
-
+  for (;;) {
     uint64_t inputsAmount = std::accumulate(fusionInputs.begin(), fusionInputs.end(), static_cast<uint64_t>(0), [] (uint64_t amount, const OutputToTransfer& input) {
       return amount + input.out.amount;
     });
 
-    ReceiverAmounts decomposedOutputs = decomposeFusionOutputs(destination, inputsAmount);
-    assert(decomposedOutputs.amounts.size() <= MAX_FUSION_OUTPUT_COUNT);
+    decomposedOutputs = decomposeFusionOutputs(destination, inputsAmount);
+    transactionSize = getFusionTransactionSize(keysInfo, decomposedOutputs.amounts);
+    if (transactionSize <= m_currency.fusionTxMaxSize()) {
+      break;
+    }
 
-	Crypto::SecretKey txkey;
-    fusionTransaction = makeTransaction(std::vector<ReceiverAmounts>{decomposedOutputs}, keysInfo, "", 0, txkey);
+    if (fusionInputs.size() <= m_currency.fusionTxMinInputCount()) {
+      m_logger(ERROR, BRIGHT_RED) << "Unable to create fusion transaction";
+      throw std::runtime_error("Unable to create fusion transaction");
+    }
 
-    transactionSize = getTransactionSize(*fusionTransaction);
+    fusionInputs.pop_back();
+    keysInfo.pop_back();
+  }
 
-    ++round;
-  } while (transactionSize > m_currency.fusionTxMaxSize() && fusionInputs.size() >= m_currency.fusionTxMinInputCount());
+  Crypto::SecretKey txkey;
+  std::unique_ptr<ITransaction> fusionTransaction = makeTransaction(std::vector<ReceiverAmounts>{decomposedOutputs}, keysInfo, "", 0, txkey);
+  assert(getTransactionSize(*fusionTransaction) == transactionSize);
 
-  if (fusionInputs.size() < m_currency.fusionTxMinInputCount()) {
-    m_logger(ERROR, BRIGHT_RED) << "Unable to create fusion transaction";
-    throw std::runtime_error("Unable to create fusion transaction");
+  return validateSaveAndSendTransaction(*fusionTransaction, {}, true, true);
+}
+
+size_t WalletGreen::getFusionTransactionSize(const std::vector<InputInfo>& keysInfo, const std::vector<uint64_t>& outputAmounts) {
+  const size_t TAG_SIZE = sizeof(uint8_t);
+  const size_t EXTRA_SIZE = TAG_SIZE + sizeof(Crypto::PublicKey);
+
+  // prefix: version, zero unlock time, inputs, outputs and the extra holding the transaction public key
+  size_t size = getVarintSize(CURRENT_TRANSACTION_VERSION) + getVarintSize(0) + getVarintSize(keysInfo.size());
+  for (const InputInfo& input : keysInfo) {
+    const auto& outputs = input.keyInfo.outputs;
+    size += TAG_SIZE + getVarintSize(input.keyInfo.amount) + getVarintSize(outputs.size()) + sizeof(Crypto::KeyImage);
+
+    // ring members are stored as offsets relative to the previous one
+    uint32_t previousIndex = 0;
+    for (const auto& output : outputs) {
+      size += getVarintSize(output.outputIndex - previousIndex);
+      previousIndex = output.outputIndex;
+    }
+
+    size += outputs.size() * sizeof(Crypto::Signature);
   }
 
-  id = validateSaveAndSendTransaction(*fusionTransaction, {}, true, true);
-  return id;
+  size += getVarintSize(outputAmounts.size());
+  for (uint64_t amount : outputAmounts) {
+    size += getVarintSize(amount) + TAG_SIZE + sizeof(Crypto::PublicKey);
+  }
+
+  size += getVarintSize(EXTRA_SIZE) + EXTRA_SIZE;
+  return size;
 }
 
 WalletGreen::ReceiverAmounts WalletGreen::decomposeFusionOutputs(const AccountPublicAddress& address, uint64_t inputsAmount) {
@@ -3540,19 +4129,18 @@ IFusionManager::EstimateResult WalletGreen::estimate(uint64_t threshold, const s
   validateSourceAddresses(sourceAddresses);
 
   IFusionManager::EstimateResult result{0, 0};
-  auto walletOuts = sourceAddresses.empty() ? pickWalletsWithMoney() : pickWallets(sourceAddresses);
+  uint32_t height = m_node.getLastKnownBlockHeight();
   std::array<size_t, std::numeric_limits<uint64_t>::digits10 + 1> bucketSizes;
   bucketSizes.fill(0);
-  for (size_t walletIndex = 0; walletIndex < walletOuts.size(); ++walletIndex) {
-    for (auto& out : walletOuts[walletIndex].outs) {
-      uint8_t powerOfTen = 0;
-      if (m_currency.isAmountApplicableInFusionTransactionInput(out.amount, threshold, powerOfTen, m_node.getLastKnownBlockHeight())) {
-        assert(powerOfTen < std::numeric_limits<uint64_t>::digits10 + 1);
-        bucketSizes[powerOfTen]++;
-      }
+  for (const WalletRecord* wallet : getFusionWallets(sourceAddresses)) {
+    auto walletBuckets = getFusionBuckets(*wallet, threshold, height);
+    for (size_t i = 0; i < bucketSizes.size(); ++i) {
+      bucketSizes[i] += walletBuckets[i];
     }
 
-    result.totalOutputCount += walletOuts[walletIndex].outs.size();
+    for (const auto& amount : wallet->unlockedAmounts) {
+      result.totalOutputCount += amount.second;
+    }
   }
 
   for (auto bucketSize : bucketSizes) {
@@ -3564,21 +4152,41 @@ IFusionManager::EstimateResult WalletGreen::estimate(uint64_t threshold, const s
   return result;
 }
 
+// the wallets of the addresses, or of the whole container if none given, that have unlocked outputs
+std::vector<const WalletRecord*> WalletGreen::getFusionWallets(const std::vector<std::string>& addresses) const {
+  std::vector<const WalletRecord*> wallets;
+  if (addresses.empty()) {
+    for (const auto& wallet : m_walletsContainer.get<RandomAccessIndex>()) {
+      if (wallet.actualBalance != 0) {
+        wallets.push_back(&wallet);
+      }
+    }
+  } else {
+    for (const auto& address : addresses) {
+      const WalletRecord& wallet = getWalletRecord(address);
+      if (wallet.actualBalance != 0) {
+        wallets.push_back(&wallet);
+      }
+    }
+  }
+
+  return wallets;
+}
+
 std::vector<WalletGreen::OutputToTransfer> WalletGreen::pickRandomFusionInputs(const std::vector<std::string>& addresses,
   uint64_t threshold, size_t minInputCount, size_t maxInputCount) {
 
-  std::vector<WalletGreen::OutputToTransfer> allFusionReadyOuts;
-  auto walletOuts = addresses.empty() ? pickWalletsWithMoney() : pickWallets(addresses);
+  // the buckets are chosen from the output counts, only the wallets having outputs in the chosen one are read
+  uint32_t height = m_node.getLastKnownBlockHeight();
+  std::vector<const WalletRecord*> wallets = getFusionWallets(addresses);
+  std::vector<std::array<size_t, std::numeric_limits<uint64_t>::digits10 + 1>> walletBuckets;
+  walletBuckets.reserve(wallets.size());
   std::array<size_t, std::numeric_limits<uint64_t>::digits10 + 1> bucketSizes;
   bucketSizes.fill(0);
-  for (size_t walletIndex = 0; walletIndex < walletOuts.size(); ++walletIndex) {
-    for (auto& out : walletOuts[walletIndex].outs) {
-      uint8_t powerOfTen = 0;
-      if (m_currency.isAmountApplicableInFusionTransactionInput(out.amount, threshold, powerOfTen, m_node.getLastKnownBlockHeight())) {
-        allFusionReadyOuts.push_back({std::move(out), walletOuts[walletIndex].wallet});
-        assert(powerOfTen < std::numeric_limits<uint64_t>::digits10 + 1);
-        bucketSizes[powerOfTen]++;
-      }
+  for (const WalletRecord* wallet : wallets) {
+    walletBuckets.push_back(getFusionBuckets(*wallet, threshold, height));
+    for (size_t i = 0; i < bucketSizes.size(); ++i) {
+      bucketSizes[i] += walletBuckets.back()[i];
     }
   }
 
@@ -3608,13 +4216,25 @@ std::vector<WalletGreen::OutputToTransfer> WalletGreen::pickRandomFusionInputs(c
   uint64_t upperBound = selectedBucket == std::numeric_limits<uint64_t>::digits10 ? UINT64_MAX : lowerBound * 10;
   std::vector<WalletGreen::OutputToTransfer> selectedOuts;
   selectedOuts.reserve(bucketSizes[selectedBucket]);
-  for (size_t outIndex = 0; outIndex < allFusionReadyOuts.size(); ++outIndex) {
-    if (allFusionReadyOuts[outIndex].out.amount >= lowerBound && allFusionReadyOuts[outIndex].out.amount < upperBound) {
-      selectedOuts.push_back(std::move(allFusionReadyOuts[outIndex]));
+  for (size_t walletIndex = 0; walletIndex < wallets.size(); ++walletIndex) {
+    if (walletBuckets[walletIndex][selectedBucket] == 0) {
+      continue;
+    }
+
+    WalletRecord* wallet = const_cast<WalletRecord*>(wallets[walletIndex]);
+    std::vector<TransactionOutputInformation> outs;
+    wallet->container->getOutputs(outs, ITransfersContainer::IncludeKeyUnlocked);
+    for (auto& out : outs) {
+      if (out.amount >= lowerBound && out.amount < upperBound &&
+        m_currency.isAmountApplicableInFusionTransactionInput(out.amount, threshold, height)) {
+        selectedOuts.push_back({std::move(out), wallet});
+      }
     }
   }
 
-  assert(selectedOuts.size() >= minInputCount);
+  if (selectedOuts.size() < minInputCount) {
+    return {};
+  }
 
   auto outputsSortingFunction = [](const OutputToTransfer& l, const OutputToTransfer& r) { return l.out.amount < r.out.amount; };
   if (selectedOuts.size() <= maxInputCount) {
@@ -3673,6 +4293,130 @@ std::vector<TransactionsInBlockInfo> WalletGreen::getTransactionsInBlocks(uint32
   return result;
 }
 
+/// blocks are listed as by getTransactionsInBlocks(blockIndex, count), the transactions are looked up in the indices
+std::vector<TransactionsInBlockInfo> WalletGreen::getTransactionsInBlocks(uint32_t blockIndex, size_t count,
+  const std::vector<std::string>& addresses, const Crypto::Hash* paymentId) const {
+  if (addresses.empty() && paymentId == nullptr) {
+    return getTransactionsInBlocks(blockIndex, count);
+  }
+
+  if (count == 0) {
+    m_logger(ERROR, BRIGHT_RED) << "Bad argument: block count must be greater than zero";
+    throw std::system_error(make_error_code(error::WRONG_PARAMETERS), "blocks count must be greater than zero");
+  }
+
+  std::vector<TransactionsInBlockInfo> result;
+
+  if (blockIndex >= m_blockchain.size()) {
+    return result;
+  }
+
+  uint32_t stopIndex = static_cast<uint32_t>(std::min(m_blockchain.size(), blockIndex + count));
+  result.resize(stopIndex - blockIndex);
+  for (uint32_t height = blockIndex; height < stopIndex; ++height) {
+    result[height - blockIndex].blockHash = m_blockchain[height];
+  }
+
+  updateTransactionIndices();
+
+  std::vector<size_t> transactionIds;
+  if (paymentId != nullptr) {
+    auto it = m_paymentIdTransactions.find(*paymentId);
+    if (it != m_paymentIdTransactions.end()) {
+      transactionIds = it->second;
+    }
+  } else {
+    for (const std::string& address : addresses) {
+      auto it = m_addressTransactions.find(address);
+      if (it != m_addressTransactions.end()) {
+        transactionIds.insert(transactionIds.end(), it->second.begin(), it->second.end());
+      }
+    }
+
+    std::sort(transactionIds.begin(), transactionIds.end());
+    transactionIds.erase(std::unique(transactionIds.begin(), transactionIds.end()), transactionIds.end());
+  }
+
+  std::unordered_set<std::string> addressSet(addresses.begin(), addresses.end());
+  auto& transactions = m_transactions.get<RandomAccessIndex>();
+  for (size_t transactionId : transactionIds) {
+    const WalletTransaction& transaction = transactions[transactionId];
+    if (transaction.state != WalletTransactionState::SUCCEEDED || transaction.blockHeight < blockIndex || transaction.blockHeight >= stopIndex) {
+      continue;
+    }
+
+    auto bounds = getTransactionTransfersRange(transactionId);
+    if (!addressSet.empty() && std::none_of(bounds.first, bounds.second, [&addressSet](const TransactionTransferPair& transfer) {
+      return addressSet.count(transfer.second.address) != 0;
+    })) {
+      continue;
+    }
+
+    WalletTransactionWithTransfers transactionWithTransfers;
+    transactionWithTransfers.transaction = transaction;
+    for (auto it = bounds.first; it != bounds.second; ++it) {
+      transactionWithTransfers.transfers.emplace_back(it->second);
+    }
+
+    result[transaction.blockHeight - blockIndex].transactions.emplace_back(std::move(transactionWithTransfers));
+  }
+
+  return result;
+}
+
+bool WalletGreen::getBlockIndex(const Crypto::Hash& blockHash, uint32_t& blockIndex) const {
+  auto& hashIndex = m_blockchain.get<BlockHashIndex>();
+  auto it = hashIndex.find(blockHash);
+  if (it == hashIndex.end()) {
+    return false;
+  }
+
+  auto heightIt = m_blockchain.project<BlockHeightIndex>(it);
+  blockIndex = static_cast<uint32_t>(std::distance(m_blockchain.get<BlockHeightIndex>().begin(), heightIt));
+  return true;
+}
+
+void WalletGreen::updateTransactionIndices() const {
+  auto& transactions = m_transactions.get<RandomAccessIndex>();
+  for (; m_indexedTransactions < transactions.size(); ++m_indexedTransactions) {
+    size_t transactionId = m_indexedTransactions;
+
+    Crypto::Hash paymentId;
+    if (getPaymentIdFromTxExtra(asBinaryArray(transactions[transactionId].extra), paymentId)) {
+      m_paymentIdTransactions[paymentId].push_back(transactionId);
+    }
+
+    auto bounds = getTransactionTransfersRange(transactionId);
+    for (auto it = bounds.first; it != bounds.second; ++it) {
+      if (!it->second.address.empty()) {
+        std::vector<size_t>& ids = m_addressTransactions[it->second.address];
+        if (ids.empty() || ids.back() != transactionId) {
+          ids.push_back(transactionId);
+        }
+      }
+    }
+  }
+}
+
+void WalletGreen::indexTransfer(size_t transactionId, const std::string& address) const {
+  // transactions past m_indexedTransactions pick their transfers up when they are indexed
+  if (transactionId >= m_indexedTransactions || address.empty()) {
+    return;
+  }
+
+  // duplicates are dropped by the lookup
+  std::vector<size_t>& ids = m_addressTransactions[address];
+  if (ids.empty() || ids.back() != transactionId) {
+    ids.push_back(transactionId);
+  }
+}
+
+void WalletGreen::clearTransactionIndices() {
+  m_addressTransactions.clear();
+  m_paymentIdTransactions.clear();
+  m_indexedTransactions = 0;
+}
+
 Crypto::Hash WalletGreen::getBlockHashByIndex(uint32_t blockIndex) const {
   assert(blockIndex < m_blockchain.size());
   return m_blockchain.get<BlockHeightIndex>()[blockIndex];
@@ -3872,17 +4616,10 @@ size_t WalletGreen::getTxSize(const TransactionParameters &sendingTransaction)
 
   CryptoNote::AccountPublicAddress changeDestination = getChangeDestination(sendingTransaction.changeDestination, sendingTransaction.sourceAddresses);
 
-  std::vector<WalletOuts> wallets;
-  if (!sendingTransaction.sourceAddresses.empty()) {
-    wallets = pickWallets(sendingTransaction.sourceAddresses);
-  } else {
-    wallets = pickWalletsWithMoney();
-  }
-
   PreparedTransaction preparedTransaction;
   Crypto::SecretKey txSecretKey;
   prepareTransaction(
-    std::move(wallets),
+    sendingTransaction.sourceAddresses,
     sendingTransaction.destinations,
     sendingTransaction.fee,
     sendingTransaction.mixIn,
@@ -20,10 +20,16 @@
 
 #include "IWallet.h"
 
-#include <queue>
+#include <array>
+#include <chrono>
+#include <limits>
+#include <map>
+#include <deque>
 #include <unordered_map>
 
 #include "IFusionManager.h"
+#include "WalletCacheChunks.h"
+#include "WalletDecoyCache.h"
 #include "WalletIndices.h"
 
 #include "Logging/LoggerRef.h"
@@ -31,6 +37,7 @@
 #include <System/Event.h>
 #include "Transfers/TransfersSynchronizer.h"
 #include "Transfers/BlockchainSynchronizer.h"
+#include "Transfers/SharedBlockchainSynchronizer.h"
 #include "../CryptoNoteConfig.h"
 
 namespace CryptoNote {
@@ -42,6 +49,9 @@ class WalletGreen : public IWallet,
                     public IFusionManager {
 public:
   WalletGreen(System::Dispatcher& dispatcher, const Currency& currency, INode& node, Logging::ILogger& logger, uint32_t transactionSoftLockTime = CryptoNote::parameters::CRYPTONOTE_TX_SPENDABLE_AGE);
+  // the container is synchronized together with those of other wallets on the same shared synchronizer
+  WalletGreen(System::Dispatcher& dispatcher, const Currency& currency, INode& node, SharedBlockchainSynchronizer& sharedSynchronizer,
+    Logging::ILogger& logger, uint32_t transactionSoftLockTime = CryptoNote::parameters::CRYPTONOTE_TX_SPENDABLE_AGE);
   virtual ~WalletGreen();
 
   virtual void initialize(const std::string& path, const std::string& password) override;
@@ -93,6 +103,10 @@ public:
   virtual WalletTransactionWithTransfers getTransaction(const Crypto::Hash& transactionHash) const override;
   virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t count) const override;
   virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count) const override;
+  virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t count,
+    const std::vector<std::string>& addresses, const Crypto::Hash* paymentId) const override;
+  virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count,
+    const std::vector<std::string>& addresses, const Crypto::Hash* paymentId) const override;
   virtual std::vector<Crypto::Hash> getBlockHashes(uint32_t blockIndex, size_t count) const override;
   virtual uint32_t getBlockCount() const override;
   virtual std::vector<WalletTransactionWithTransfers> getUnconfirmedTransactions() const override;
@@ -108,14 +122,21 @@ public:
 
   virtual size_t makeTransaction(const TransactionParameters& sendingTransaction) override;
   virtual void commitTransaction(size_t) override;
+  virtual std::vector<std::error_code> commitTransactions(const std::vector<size_t>& transactionIds) override;
   virtual void rollbackUncommitedTransaction(size_t) override;
 
   virtual void start() override;
   virtual void stop() override;
   virtual WalletEvent getEvent() override;
+  virtual std::vector<WalletEvent> getEvents(size_t maxCount) override;
+  // Waits at most timeout for an event and returns false if none came. The wallet keeps running
+  // on the dispatcher meanwhile, so a caller on the dispatcher thread doesn't have to poll it
+  bool getEvent(WalletEvent& event, std::chrono::milliseconds timeout);
 
   virtual size_t createFusionTransaction(uint64_t threshold, uint64_t mixin,
     const std::vector<std::string>& sourceAddresses = {}, const std::string& destinationAddress = "") override;
+  virtual std::vector<size_t> createFusionTransactions(uint64_t threshold, uint64_t mixin, size_t maxTransactionCount,
+    const std::vector<std::string>& sourceAddresses = {}, const std::string& destinationAddress = "") override;
   virtual bool isFusionTransaction(size_t transactionId) const override;
   virtual IFusionManager::EstimateResult estimate(uint64_t threshold, const std::vector<std::string>& sourceAddresses = {}) const override;
 
@@ -132,6 +153,9 @@ public:
   uint64_t getBalanceMinusDust(const std::vector<std::string>& addresses);
 
 protected:
+  WalletGreen(System::Dispatcher& dispatcher, const Currency& currency, INode& node, Logging::ILogger& logger, uint32_t transactionSoftLockTime,
+    BlockchainSynchronizer* ownSynchronizer, SharedBlockchainSynchronizer* sharedSynchronizer);
+
   struct NewAddressData {
     Crypto::PublicKey spendPublicKey;
     Crypto::SecretKey spendSecretKey;
@@ -155,7 +179,9 @@ protected:
   void incNextIv();
   void initWithKeys(const std::string& path, const std::string& password, const Crypto::PublicKey& viewPublicKey, const Crypto::SecretKey& viewSecretKey, const uint64_t& _creationTimestamp);
   std::string doCreateAddress(const Crypto::PublicKey& spendPublicKey, const Crypto::SecretKey& spendSecretKey, uint64_t creationTimestamp);
+  std::vector<NewAddressData> makeAddressDataList(const std::vector<Crypto::SecretKey>& spendSecretKeys);
   std::vector<std::string> doCreateAddressList(const std::vector<NewAddressData>& addressDataList);
+  std::vector<std::string> doCreateAddressList(const std::vector<NewAddressData>& addressDataList, bool resetRequired);
 
   CryptoNote::BlockDetails getBlock(const uint32_t blockHeight);
   Crypto::SecretKey getTransactionDeterministicSecretKey(Crypto::Hash& transactionHash) const;
@@ -238,8 +264,12 @@ protected:
   std::vector<WalletOuts> pickWalletsWithMoney() const;
   WalletOuts pickWallet(const std::string& address) const;
   std::vector<WalletOuts> pickWallets(const std::vector<std::string>& addresses) const;
+  std::vector<WalletOuts> pickLargestOutputs(const std::vector<std::string>& addresses, uint64_t neededMoney) const;
 
   void updateBalance(CryptoNote::ITransfersContainer* container);
+  void countUnlockedOutputs(const CryptoNote::ITransfersContainer* container, uint64_t& balanceMinusDust, std::map<uint64_t, size_t>& amounts) const;
+  void initUnlockedOutputs();
+  std::array<size_t, std::numeric_limits<uint64_t>::digits10 + 1> getFusionBuckets(const WalletRecord& wallet, uint64_t threshold, uint32_t height) const;
   void unlockBalances(uint32_t height);
 
   const WalletRecord& getWalletRecord(const Crypto::PublicKey& key) const;
@@ -247,10 +277,11 @@ protected:
   const WalletRecord& getWalletRecord(CryptoNote::ITransfersContainer* container) const;
 
   CryptoNote::AccountPublicAddress parseAddress(const std::string& address) const;
-  std::string addWallet(const Crypto::PublicKey& spendPublicKey, const Crypto::SecretKey& spendSecretKey, uint64_t creationTimestamp);
+  std::vector<std::string> addWallets(const std::vector<NewAddressData>& addressDataList);
   AccountKeys makeAccountKeys(const WalletRecord& wallet) const;
   size_t getTransactionId(const Crypto::Hash& transactionHash) const;
   void pushEvent(const WalletEvent& event);
+  WalletEvent popEvent();
   bool isFusionTransaction(const WalletTransaction& walletTx) const;
 
   struct PreparedTransaction {
@@ -260,7 +291,7 @@ protected:
     uint64_t changeAmount;
   };
 
-  void prepareTransaction(std::vector<WalletOuts>&& wallets,
+  void prepareTransaction(const std::vector<std::string>& sourceAddresses,
     const std::vector<WalletOrder>& orders,
     uint64_t fee,
     uint64_t mixIn,
@@ -287,6 +318,7 @@ protected:
   void requestMixinOuts(const std::vector<OutputToTransfer>& selectedTransfers,
     uint64_t mixIn,
     std::vector<CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount>& mixinResult);
+  void refillDecoyCache(uint64_t ringSize);
 
   void prepareInputs(const std::vector<OutputToTransfer>& selectedTransfers,
     std::vector<CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount>& mixinResult,
@@ -335,18 +367,27 @@ protected:
   void copyContainerStorageKeys(ContainerStorage& src, const Crypto::chacha8_key& srcKey, ContainerStorage& dst, const Crypto::chacha8_key& dstKey);
   static void copyContainerStoragePrefix(ContainerStorage& src, const Crypto::chacha8_key& srcKey, ContainerStorage& dst, const Crypto::chacha8_key& dstKey);
   void deleteOrphanTransactions(const std::unordered_set<Crypto::PublicKey>& deletedKeys);
-  static void encryptAndSaveContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, const void* containerData, size_t containerDataSize);
-  static void loadAndDecryptContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, BinaryArray& containerData);
+  static WalletCacheChunks::IvGenerator containerIvGenerator(ContainerStorage& storage);
+  static void encryptAndSaveContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, const void* containerData, size_t containerDataSize,
+    WalletCacheChunks& cacheChunks);
+  static void loadAndDecryptContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, BinaryArray& containerData,
+    WalletCacheChunks& cacheChunks);
   void initTransactionPool();
   void loadSpendKeys();
   void loadContainerStorage(const std::string& path);
   void loadWalletCache(std::unordered_set<Crypto::PublicKey>& addedKeys, std::unordered_set<Crypto::PublicKey>& deletedKeys, std::string& extra);
   void saveWalletCache(ContainerStorage& storage, const Crypto::chacha8_key& key, WalletSaveLevel saveLevel, const std::string& extra);
+  void serializeWalletCache(std::string& containerData, WalletSaveLevel saveLevel, const std::string& extra);
   void subscribeWallets();
 
+  std::vector<const WalletRecord*> getFusionWallets(const std::vector<std::string>& addresses) const;
   std::vector<OutputToTransfer> pickRandomFusionInputs(const std::vector<std::string>& addresses,
     uint64_t threshold, size_t minInputCount, size_t maxInputCount);
   static ReceiverAmounts decomposeFusionOutputs(const AccountPublicAddress& address, uint64_t inputsAmount);
+  size_t makeFusionTransaction(uint64_t threshold, uint64_t mixin, size_t maxInputCount,
+    const std::vector<std::string>& sourceAddresses, const AccountPublicAddress& destination);
+  // the serialized size of a signed fusion transaction, known exactly once the ring members are chosen
+  static size_t getFusionTransactionSize(const std::vector<InputInfo>& keysInfo, const std::vector<uint64_t>& outputAmounts);
 
   enum class WalletState {
     INITIALIZED,
@@ -363,6 +404,12 @@ protected:
 
   TransfersRange getTransactionTransfersRange(size_t transactionIndex) const;
   std::vector<TransactionsInBlockInfo> getTransactionsInBlocks(uint32_t blockIndex, size_t count) const;
+  std::vector<TransactionsInBlockInfo> getTransactionsInBlocks(uint32_t blockIndex, size_t count,
+    const std::vector<std::string>& addresses, const Crypto::Hash* paymentId) const;
+  bool getBlockIndex(const Crypto::Hash& blockHash, uint32_t& blockIndex) const;
+  void updateTransactionIndices() const;
+  void indexTransfer(size_t transactionId, const std::string& address) const;
+  void clearTransactionIndices();
   Crypto::Hash getBlockHashByIndex(uint32_t blockIndex) const;
 
   std::vector<WalletTransfer> getTransactionTransfers(const WalletTransaction& transaction) const;
@@ -383,19 +430,37 @@ protected:
 
   WalletsContainer m_walletsContainer;
   ContainerStorage m_containerStorage;
+  WalletCacheChunks m_cacheChunks; // layout of the cache in m_containerStorage
   UnlockTransactionJobs m_unlockTransactionsJob;
   WalletTransactions m_transactions;
   WalletTransfers m_transfers; //sorted
+  // transactions by transfer address and by payment id, filled in lazily up to m_indexedTransactions.
+  // The address index may keep transactions whose transfers of the address are gone
+  mutable std::unordered_map<std::string, std::vector<size_t>> m_addressTransactions;
+  mutable std::unordered_map<Crypto::Hash, std::vector<size_t>> m_paymentIdTransactions;
+  mutable size_t m_indexedTransactions;
   mutable std::unordered_map<size_t, bool> m_fusionTxsCache; // txIndex -> isFusion
   UncommitedTransactions m_uncommitedTransactions;
 
   bool m_blockchainSynchronizerStarted;
-  BlockchainSynchronizer m_blockchainSynchronizer;
+  std::unique_ptr<BlockchainSynchronizer> m_ownBlockchainSynchronizer;
+  SharedBlockchainSynchronizer::User m_sharedSynchronizerUser; // leaves after m_synchronizer is destroyed
+  BlockchainSynchronizer& m_blockchainSynchronizer;
   TransfersSyncronizer m_synchronizer;
 
   System::Event m_eventOccurred;
-  std::queue<WalletEvent> m_events;
+  std::deque<WalletEvent> m_events;
+  // events are numbered in the order they are queued, a progress or unlock event still in the queue
+  // is updated in place instead of queueing another one
+  uint64_t m_poppedEventCount;
+  uint64_t m_progressEventNumber;
+  uint64_t m_unlockEventNumber;
   mutable System::Event m_readyEvent;
+  System::Event m_storageEvent; // held while the container file is changed, a save writes it off the dispatcher
+
+  WalletDecoyCache m_decoyCache;
+  bool m_decoyRefillPending;
+  System::Event m_decoyRefillFinished;
 
   WalletState m_state;
 
@@ -409,6 +474,7 @@ protected:
 
   uint64_t m_actualBalance;
   uint64_t m_pendingBalance;
+  uint64_t m_balanceMinusDust;
 
   uint64_t m_upperTransactionSizeLimit;
   uint32_t m_transactionSoftLockTime;
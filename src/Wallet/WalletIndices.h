@@ -43,6 +43,8 @@ struct WalletRecord {
   CryptoNote::ITransfersContainer* container = nullptr;
   uint64_t pendingBalance = 0;
   uint64_t actualBalance = 0;
+  uint64_t balanceMinusDust = 0; // unlocked key outputs above the default dust threshold
+  std::map<uint64_t, size_t> unlockedAmounts; // number of unlocked key outputs by amount
   time_t creationTimestamp;
 };
 
@@ -353,30 +353,18 @@ bool wallet_rpc_server::on_get_payments(const wallet_rpc::COMMAND_RPC_GET_PAYMEN
 		throw JsonRpc::JsonRpcError(WALLET_RPC_ERROR_CODE_WRONG_PAYMENT_ID, "Payment ID has invalid size");
 
 	expectedPaymentId = *reinterpret_cast<const Crypto::Hash*>(payment_id_blob.data());
-	size_t transactionsCount = m_wallet.getTransactionCount();
-	for (size_t transactionNumber = 0; transactionNumber < transactionsCount; ++transactionNumber)
+	std::vector<Payments> payments = m_wallet.getTransactionsByPaymentIds({ expectedPaymentId });
+	for (const WalletLegacyTransaction& txInfo : payments.front().transactions)
 	{
-		WalletLegacyTransaction txInfo;
-		m_wallet.getTransaction(transactionNumber, txInfo);
-		if (txInfo.state != WalletLegacyTransactionState::Active || txInfo.blockHeight == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT)
-			continue;
-		if (txInfo.totalAmount < 0)
+		if (txInfo.blockHeight < req.min_block_height)
 			continue;
-		std::vector<uint8_t> extraVec;
-		extraVec.reserve(txInfo.extra.size());
-		std::for_each(txInfo.extra.begin(), txInfo.extra.end(), 
-			[&extraVec](const char el) { extraVec.push_back(el); });
 
-		Crypto::Hash paymentId;
-		if (getPaymentIdFromTxExtra(extraVec, paymentId) && paymentId == expectedPaymentId)
-		{
-			wallet_rpc::payment_details rpc_payment;
-			rpc_payment.tx_hash      = Common::podToHex(txInfo.hash);
-			rpc_payment.amount       = txInfo.totalAmount;
-			rpc_payment.block_height = txInfo.blockHeight;
-			rpc_payment.unlock_time  = txInfo.unlockTime;
-			res.payments.push_back(rpc_payment);
-		}
+		wallet_rpc::payment_details rpc_payment;
+		rpc_payment.tx_hash      = Common::podToHex(txInfo.hash);
+		rpc_payment.amount       = txInfo.totalAmount;
+		rpc_payment.block_height = txInfo.blockHeight;
+		rpc_payment.unlock_time  = txInfo.unlockTime;
+		res.payments.push_back(rpc_payment);
 	}
 	return true;
 }
@@ -386,6 +374,10 @@ bool wallet_rpc_server::on_get_transfers(const wallet_rpc::COMMAND_RPC_GET_TRANS
 {
 	res.transfers.clear();
 	size_t transactionsCount = m_wallet.getTransactionCount();
+	res.transactions_count = transactionsCount;
+	size_t firstTransaction = static_cast<size_t>(std::min<uint64_t>(req.first_index, transactionsCount));
+	size_t lastTransaction = req.count == 0 ? transactionsCount :
+		static_cast<size_t>(std::min<uint64_t>(firstTransaction + req.count, transactionsCount));
 	uint64_t bc_height;
 	try {
 		bc_height = m_node.getKnownBlockCount();
@@ -394,7 +386,7 @@ bool wallet_rpc_server::on_get_transfers(const wallet_rpc::COMMAND_RPC_GET_TRANS
 		throw JsonRpc::JsonRpcError(WALLET_RPC_ERROR_CODE_UNKNOWN_ERROR, std::string("Failed to get blockchain height: ") + e.what());
 	}
 
-	for (size_t transactionNumber = 0; transactionNumber < transactionsCount; ++transactionNumber)
+	for (size_t transactionNumber = firstTransaction; transactionNumber < lastTransaction; ++transactionNumber)
 	{
 		WalletLegacyTransaction txInfo;
 		m_wallet.getTransaction(transactionNumber, txInfo);
@@ -139,10 +139,12 @@ using CryptoNote::ISerializer;
 		struct request
 		{
 			std::string payment_id;
+			uint64_t min_block_height = 0;   // only the payments from this height on
 
 			void serialize(ISerializer& s)
 			{
 				KV_MEMBER(payment_id)
+				KV_MEMBER(min_block_height)
 			}
 		};
 		struct response
@@ -189,14 +191,26 @@ using CryptoNote::ISerializer;
 
 	struct COMMAND_RPC_GET_TRANSFERS
 	{
-		typedef CryptoNote::EMPTY_STRUCT request;
+		struct request
+		{
+			uint64_t first_index = 0;   // of the wallet transactions to start from
+			uint64_t count = 0;         // of the wallet transactions to look at, 0 - all up to the last one
+
+			void serialize(ISerializer& s)
+			{
+				KV_MEMBER(first_index)
+				KV_MEMBER(count)
+			}
+		};
 		struct response
 		{
 			std::list<Transfer> transfers;
+			uint64_t transactions_count;   // in the wallet, where the paging ends
 
 			void serialize(ISerializer& s)
 			{
 				KV_MEMBER(transfers)
+				KV_MEMBER(transactions_count)
 			}
 		};
 	};
@@ -18,6 +18,7 @@
 
 #include "WalletSerializationV2.h"
 
+#include "Common/InputStreamBuffer.h"
 #include "CryptoNoteCore/CryptoNoteSerialization.h"
 #include "Serialization/BinaryInputStreamSerializer.h"
 #include "Serialization/BinaryOutputStreamSerializer.h"
@@ -165,7 +166,7 @@ void WalletSerializerV2::load(Common::IInputStream& source, uint8_t version) {
   }
 
   if (saveLevel == WalletSaveLevel::SAVE_ALL) {
-    loadTransfersSynchronizer(s);
+    loadTransfersSynchronizer(source, s);
     loadUnlockTransactionsJobs(s);
     s(m_uncommitedTransactions, "uncommitedTransactions");
   }
@@ -334,12 +335,15 @@ void WalletSerializerV2::saveTransfers(CryptoNote::ISerializer& serializer) {
   }
 }
 
-void WalletSerializerV2::loadTransfersSynchronizer(CryptoNote::ISerializer& serializer) {
-  std::string transfersSynchronizerData;
-  serializer(transfersSynchronizerData, "transfersSynchronizer");
+void WalletSerializerV2::loadTransfersSynchronizer(Common::IInputStream& source, CryptoNote::ISerializer& serializer) {
+  // the state is saved as a string, it is loaded straight from the source instead of being copied out
+  uint64_t size = 0;
+  serializer(size, "transfersSynchronizerSize");
 
-  std::stringstream stream(transfersSynchronizerData);
+  Common::InputStreamBuffer buffer(source, size);
+  std::istream stream(&buffer);
   m_synchronizer.load(stream);
+  buffer.skipRest();
 }
 
 void WalletSerializerV2::saveTransfersSynchronizer(CryptoNote::ISerializer& serializer) {
@@ -50,7 +50,9 @@ public:
   std::unordered_set<Crypto::PublicKey>& deletedKeys();
 
   static const uint8_t MIN_VERSION = 6;
-  static const uint8_t SERIALIZATION_VERSION = 6;
+  static const uint8_t SERIALIZATION_VERSION = 7;
+  // the container cache is kept as encrypted chunks, see WalletCacheChunks
+  static const uint8_t CHUNKED_CACHE_VERSION = 7;
 
 private:
   void loadKeyListAndBalances(CryptoNote::ISerializer& serializer, bool saveCache);
@@ -62,7 +64,7 @@ private:
   void loadTransfers(CryptoNote::ISerializer& serializer);
   void saveTransfers(CryptoNote::ISerializer& serializer);
 
-  void loadTransfersSynchronizer(CryptoNote::ISerializer& serializer);
+  void loadTransfersSynchronizer(Common::IInputStream& source, CryptoNote::ISerializer& serializer);
   void saveTransfersSynchronizer(CryptoNote::ISerializer& serializer);
 
   void loadUnlockTransactionsJobs(CryptoNote::ISerializer& serializer);
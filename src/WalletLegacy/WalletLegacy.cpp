@@ -436,6 +436,7 @@ void WalletLegacy::shutdown() {
     m_transferDetails = nullptr;
 
     m_transactionsCache.reset();
+    runAtomic(m_changesMutex, [this] () { this->m_transactionChanges.clear(); });
     m_lastNotifiedActualBalance = 0;
     m_lastNotifiedPendingBalance = 0;
     m_lastNotifiedUnmixableBalance = 0;
@@ -489,6 +490,7 @@ void WalletLegacy::doSave(std::ostream& destination, bool saveDetailed, bool sav
 
   try {
     m_blockchainSync.stop();
+    applyTransactionChanges();
     std::unique_lock<std::mutex> lock(m_cacheMutex);
     
     WalletLegacySerializer serializer(m_account, m_transactionsCache);
@@ -562,6 +564,9 @@ bool WalletLegacy::verify_message(const std::string &message, const CryptoNote::
 }
 
 std::vector<Payments> WalletLegacy::getTransactionsByPaymentIds(const std::vector<PaymentId>& paymentIds) const {
+  std::unique_lock<std::mutex> lock(m_cacheMutex);
+  throwIfNotInitialised();
+
   return m_transactionsCache.getTransactionsByPaymentIds(paymentIds);
 }
 
@@ -920,6 +925,7 @@ std::error_code WalletLegacy::cancelTransaction(size_t transactionId) {
 }
 
 void WalletLegacy::synchronizationProgressUpdated(uint32_t current, uint32_t total) {
+  applyTransactionChanges();
   auto deletedTransactions = deleteOutdatedUnconfirmedTransactions();
 
   // forward notification
@@ -934,6 +940,7 @@ void WalletLegacy::synchronizationProgressUpdated(uint32_t current, uint32_t tot
 }
 
 void WalletLegacy::synchronizationCompleted(std::error_code result) {
+  applyTransactionChanges();
   if (result != std::make_error_code(std::errc::interrupted)) {
     m_observerManager.notify(&IWalletLegacyObserver::synchronizationCompleted, result);
   }
@@ -951,35 +958,49 @@ void WalletLegacy::synchronizationCompleted(std::error_code result) {
 }
 
 void WalletLegacy::onTransactionUpdated(ITransfersSubscription* object, const Hash& transactionHash) {
-  std::shared_ptr<WalletLegacyEvent> event;
+  WalletUserTransactionsCache::TransactionChange change = {};
+  change.deleted = false;
 
-  TransactionInformation txInfo;
   uint64_t amountIn;
   uint64_t amountOut;
-  if (m_transferDetails->getTransactionInformation(transactionHash, txInfo, &amountIn, &amountOut)) {
-    std::unique_lock<std::mutex> lock(m_cacheMutex);
-    event = m_transactionsCache.onTransactionUpdated(txInfo, static_cast<int64_t>(amountOut) - static_cast<int64_t>(amountIn));
-  }
-
-  if (event.get()) {
-    event->notify(m_observerManager);
+  if (m_transferDetails->getTransactionInformation(transactionHash, change.txInfo, &amountIn, &amountOut)) {
+    change.txBalance = static_cast<int64_t>(amountOut) - static_cast<int64_t>(amountIn);
+    std::lock_guard<std::mutex> lock(m_changesMutex);
+    m_transactionChanges.push_back(std::move(change));
   }
 }
 
 void WalletLegacy::onTransactionDeleted(ITransfersSubscription* object, const Hash& transactionHash) {
-  std::shared_ptr<WalletLegacyEvent> event;
+  WalletUserTransactionsCache::TransactionChange change = {};
+  change.deleted = true;
+  change.txInfo.transactionHash = transactionHash;
+  change.txBalance = 0;
 
+  std::lock_guard<std::mutex> lock(m_changesMutex);
+  m_transactionChanges.push_back(std::move(change));
+}
+
+void WalletLegacy::applyTransactionChanges() {
+  std::vector<WalletUserTransactionsCache::TransactionChange> changes;
   {
-  std::unique_lock<std::mutex> lock(m_cacheMutex);
-    event = m_transactionsCache.onTransactionDeleted(transactionHash);
+    std::lock_guard<std::mutex> lock(m_changesMutex);
+    changes.swap(m_transactionChanges);
   }
 
-  if (event.get()) {
-    event->notify(m_observerManager);
+  if (changes.empty()) {
+    return;
   }
+
+  std::deque<std::shared_ptr<WalletLegacyEvent>> events;
+  {
+    std::unique_lock<std::mutex> lock(m_cacheMutex);
+    m_transactionsCache.onTransactionsChanged(changes, events);
+  }
+
+  notifyClients(events);
 }
 
-void WalletLegacy::throwIfNotInitialised() {
+void WalletLegacy::throwIfNotInitialised() const {
   if (m_state == NOT_INITIALIZED || m_state == LOADING) {
     throw std::system_error(make_error_code(CryptoNote::error::NOT_INITIALIZED));
   }
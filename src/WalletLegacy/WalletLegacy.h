@@ -146,7 +146,7 @@ private:
   virtual void onTransactionDeleted(ITransfersSubscription* object, const Crypto::Hash& transactionHash) override;
 
   void initSync();
-  void throwIfNotInitialised();
+  void throwIfNotInitialised() const;
 
   void doSave(std::ostream& destination, bool saveDetailed, bool saveCache);
   void doLoad(std::istream& source);
@@ -155,6 +155,7 @@ private:
   void sendTransactionCallback(WalletRequest::Callback callback, std::error_code ec);
   void notifyClients(std::deque<std::shared_ptr<WalletLegacyEvent> >& events);
   void notifyIfBalanceChanged();
+  void applyTransactionChanges();
 
   std::vector<TransactionId> deleteOutdatedUnconfirmedTransactions();
 
@@ -170,7 +171,7 @@ private:
   };
 
   WalletState m_state;
-  std::mutex m_cacheMutex;
+  mutable std::mutex m_cacheMutex;
   CryptoNote::AccountBase m_account;
   std::string m_password;
   const CryptoNote::Currency& m_currency;
@@ -189,6 +190,10 @@ private:
   WalletUserTransactionsCache m_transactionsCache;
   std::unique_ptr<WalletTransactionSender> m_sender;
 
+  // the transfers events since the last synchronization progress, applied to the cache at once
+  std::mutex m_changesMutex;
+  std::vector<WalletUserTransactionsCache::TransactionChange> m_transactionChanges;
+
   WalletAsyncContextCounter m_asyncContextCounter;
   Tools::ObserverManager<CryptoNote::IWalletLegacyObserver> m_observerManager;
 
@@ -43,6 +43,7 @@ bool WalletUserTransactionsCache::serialize(CryptoNote::ISerializer& s) {
     updateUnconfirmedTransactions();
     deleteOutdatedTransactions();
 	rebuildPaymentsIndex();
+    rebuildHashIndex();
   } else {
     UserTransactions txsToSave;
     UserTransfers transfersToSave;
@@ -56,6 +57,15 @@ bool WalletUserTransactionsCache::serialize(CryptoNote::ISerializer& s) {
   return true;
 }
 
+bool getPaymentIdFromExtra(const std::string& extra, PaymentId& paymentId) {
+  TransactionExtraScan scan;
+  if (!scanTransactionExtra(reinterpret_cast<const uint8_t*>(extra.data()), extra.size(), scan)) {
+    return false;
+  }
+
+  return scan.getPaymentId(paymentId);
+}
+
 bool paymentIdIsSet(const PaymentId& paymentId) {
   return paymentId != NULL_HASH;
 }
@@ -66,7 +76,19 @@ bool canInsertTransactionToIndex(const WalletLegacyTransaction& info) {
 }
 
 void WalletUserTransactionsCache::pushToPaymentsIndex(const PaymentId& paymentId, Offset distance) {
-  m_paymentsIndex[paymentId].push_back(distance);
+  // kept sorted, a transaction updated again is indexed once
+  auto& offsets = m_paymentsIndex[paymentId];
+  auto it = std::lower_bound(offsets.begin(), offsets.end(), distance);
+  if (it == offsets.end() || *it != distance) {
+    offsets.insert(it, distance);
+  }
+}
+
+void WalletUserTransactionsCache::pushToPaymentsIndexInternal(Offset distance, const WalletLegacyTransaction& info) {
+  PaymentId paymentId;
+  if (canInsertTransactionToIndex(info) && getPaymentIdFromExtra(info.extra, paymentId)) {
+    pushToPaymentsIndex(paymentId, distance);
+  }
 }
 
 void WalletUserTransactionsCache::popFromPaymentsIndex(const PaymentId& paymentId, Offset distance) {
@@ -81,19 +103,15 @@ void WalletUserTransactionsCache::popFromPaymentsIndex(const PaymentId& paymentI
   }
 
   it->second.erase(toErase);
+  if (it->second.empty()) {
+    m_paymentsIndex.erase(it);
+  }
 }
 
 void WalletUserTransactionsCache::rebuildPaymentsIndex() {
-  auto begin = std::begin(m_transactions);
-  auto end = std::end(m_transactions);
-  std::vector<uint8_t> extra;
-  for (auto it = begin; it != end; ++it) {
-    PaymentId paymentId;
-    extra.insert(extra.begin(), it->extra.begin(), it->extra.end());
-    if (canInsertTransactionToIndex(*it) && getPaymentIdFromTxExtra(extra, paymentId)) {
-      pushToPaymentsIndex(paymentId, std::distance(begin, it));
-    }
-    extra.clear();
+  m_paymentsIndex.clear();
+  for (Offset offset = 0; offset < m_transactions.size(); ++offset) {
+    pushToPaymentsIndexInternal(offset, m_transactions[offset]);
   }
 }
 
@@ -140,6 +158,7 @@ void WalletUserTransactionsCache::updateTransaction(
   auto& txInfo = m_transactions.at(transactionId);
   txInfo.extra.assign(tx.extra.begin(), tx.extra.end());
   txInfo.secretKey = tx_key;
+  m_hashIndex.emplace(txInfo.hash, transactionId);
   m_unconfirmedTransactions.add(tx, transactionId, amount, usedOutputs, tx_key);
 }
 
@@ -194,6 +213,17 @@ std::shared_ptr<WalletLegacyEvent> WalletUserTransactionsCache::onTransactionUpd
     event = std::make_shared<WalletTransactionUpdatedEvent>(id);
   }
 
+  // indexed while it's in a block
+  const WalletLegacyTransaction& transaction = m_transactions[id];
+  PaymentId paymentId;
+  if (getPaymentIdFromExtra(transaction.extra, paymentId)) {
+    if (canInsertTransactionToIndex(transaction)) {
+      pushToPaymentsIndex(paymentId, id);
+    } else {
+      popFromPaymentsIndex(paymentId, id);
+    }
+  }
+
   return event;
 }
 
@@ -210,9 +240,8 @@ std::shared_ptr<WalletLegacyEvent> WalletUserTransactionsCache::onTransactionDel
   std::shared_ptr<WalletLegacyEvent> event;
   if (id != CryptoNote::WALLET_LEGACY_INVALID_TRANSACTION_ID) {
     WalletLegacyTransaction& tr = getTransaction(id);
-	std::vector<uint8_t> extra(tr.extra.begin(), tr.extra.end());
     PaymentId paymentId;
-    if (getPaymentIdFromTxExtra(extra, paymentId)) {
+    if (getPaymentIdFromExtra(tr.extra, paymentId)) {
       popFromPaymentsIndex(paymentId, id);
     }
 
@@ -229,6 +258,17 @@ std::shared_ptr<WalletLegacyEvent> WalletUserTransactionsCache::onTransactionDel
   return event;
 }
 
+void WalletUserTransactionsCache::onTransactionsChanged(const std::vector<TransactionChange>& changes,
+  std::deque<std::shared_ptr<WalletLegacyEvent>>& events) {
+  for (const auto& change : changes) {
+    std::shared_ptr<WalletLegacyEvent> event = change.deleted ? onTransactionDeleted(change.txInfo.transactionHash) :
+      onTransactionUpdated(change.txInfo, change.txBalance);
+    if (event) {
+      events.push_back(std::move(event));
+    }
+  }
+}
+
 TransactionId WalletUserTransactionsCache::findTransactionByTransferId(TransferId transferId) const
 {
   TransactionId id;
@@ -290,16 +330,30 @@ bool WalletUserTransactionsCache::getTransfer(TransferId transferId, WalletLegac
 
 TransactionId WalletUserTransactionsCache::insertTransaction(WalletLegacyTransaction&& Transaction) {
   m_transactions.emplace_back(std::move(Transaction));
-  return m_transactions.size() - 1;
+  TransactionId id = m_transactions.size() - 1;
+  // a transaction being sent gets its hash later, in updateTransaction()
+  if (m_transactions.back().hash != NULL_HASH) {
+    m_hashIndex.emplace(m_transactions.back().hash, id);
+  }
+
+  return id;
 }
 
-TransactionId WalletUserTransactionsCache::findTransactionByHash(const Hash& hash) {
-  auto it = std::find_if(m_transactions.begin(), m_transactions.end(), [&hash](const WalletLegacyTransaction& tx) { return tx.hash == hash; });
+void WalletUserTransactionsCache::rebuildHashIndex() {
+  m_hashIndex.clear();
+  for (TransactionId id = 0; id < m_transactions.size(); ++id) {
+    if (m_transactions[id].hash != NULL_HASH) {
+      m_hashIndex.emplace(m_transactions[id].hash, id);
+    }
+  }
+}
 
-  if (it == m_transactions.end())
+TransactionId WalletUserTransactionsCache::findTransactionByHash(const Hash& hash) {
+  auto it = m_hashIndex.find(hash);
+  if (it == m_hashIndex.end())
     return CryptoNote::WALLET_LEGACY_INVALID_TRANSACTION_ID;
 
-  return std::distance(m_transactions.begin(), it);
+  return it->second;
 }
 
 bool WalletUserTransactionsCache::isUsed(const TransactionOutputInformation& out) const {
@@ -374,6 +428,8 @@ void WalletUserTransactionsCache::reset() {
   m_transactions.clear();
   m_transfers.clear();
   m_unconfirmedTransactions.reset();
+  m_paymentsIndex.clear();
+  m_hashIndex.clear();
 }
 
 std::vector<TransactionId> WalletUserTransactionsCache::deleteOutdatedTransactions() {
@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include <deque>
+#include <unordered_map>
+
 #include "crypto/hash.h"
 #include "IWalletLegacy.h"
 #include "ITransfersContainer.h"
@@ -50,6 +53,15 @@ public:
   std::shared_ptr<WalletLegacyEvent> onTransactionUpdated(const TransactionInformation& txInfo, int64_t txBalance);
   std::shared_ptr<WalletLegacyEvent> onTransactionDeleted(const Crypto::Hash& transactionHash);
 
+  struct TransactionChange {
+    bool deleted;
+    TransactionInformation txInfo; // only transactionHash is set for a deleted one
+    int64_t txBalance;
+  };
+
+  // applies the changes of a synchronized batch in their order
+  void onTransactionsChanged(const std::vector<TransactionChange>& changes, std::deque<std::shared_ptr<WalletLegacyEvent>>& events);
+
   TransactionId findTransactionByTransferId(TransferId transferId) const;
 
   bool getTransaction(TransactionId transactionId, WalletLegacyTransaction& transaction) const;
@@ -68,6 +80,7 @@ public:
 private:
 
   TransactionId insertTransaction(WalletLegacyTransaction&& Transaction);
+  void rebuildHashIndex();
   TransferId insertTransfers(const std::vector<WalletLegacyTransfer>& transfers);
   void updateUnconfirmedTransactions();
 
@@ -83,13 +96,14 @@ private:
 
   void rebuildPaymentsIndex();
   void pushToPaymentsIndex(const PaymentId& paymentId, Offset distance);
-  void pushToPaymentsIndexInternal(Offset distance, const WalletLegacyTransaction& info, std::vector<uint8_t>& extra);
+  void pushToPaymentsIndexInternal(Offset distance, const WalletLegacyTransaction& info);
   void popFromPaymentsIndex(const PaymentId& paymentId, Offset distance);
 
   UserTransactions m_transactions;
   UserTransfers m_transfers;
   WalletUnconfirmedTransactions m_unconfirmedTransactions;
   UserPaymentIndex m_paymentsIndex;
+  std::unordered_map<Crypto::Hash, TransactionId> m_hashIndex; // the first transaction with the hash
 };
 
 } //namespace CryptoNote
@@ -40,7 +40,8 @@ static const char sigma[] = "expand 32-byte k";
 namespace Crypto
 {
 
-void chacha8(const void* data, size_t length, const uint8_t* key, const uint8_t* iv, char* cipher) {
+// one block at a time, starting at the given block counter
+static void chacha8_blocks(const void* data, size_t length, const uint32_t state[16], uint64_t counter, char* cipher) {
   uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
   uint32_t j0, j1, j2, j3, j4, j5, j6, j7, j8, j9, j10, j11, j12, j13, j14, j15;
   char* ctarget = 0;
@@ -49,22 +50,22 @@ void chacha8(const void* data, size_t length, const uint8_t* key, const uint8_t*
 
   if (!length) return;
 
-  j0  = U8TO32_LITTLE(sigma + 0);
-  j1  = U8TO32_LITTLE(sigma + 4);
-  j2  = U8TO32_LITTLE(sigma + 8);
-  j3  = U8TO32_LITTLE(sigma + 12);
-  j4  = U8TO32_LITTLE(key + 0);
-  j5  = U8TO32_LITTLE(key + 4);
-  j6  = U8TO32_LITTLE(key + 8);
-  j7  = U8TO32_LITTLE(key + 12);
-  j8  = U8TO32_LITTLE(key + 16);
-  j9  = U8TO32_LITTLE(key + 20);
-  j10 = U8TO32_LITTLE(key + 24);
-  j11 = U8TO32_LITTLE(key + 28);
-  j12 = 0;
-  j13 = 0;
-  j14 = U8TO32_LITTLE(iv + 0);
-  j15 = U8TO32_LITTLE(iv + 4);
+  j0  = state[0];
+  j1  = state[1];
+  j2  = state[2];
+  j3  = state[3];
+  j4  = state[4];
+  j5  = state[5];
+  j6  = state[6];
+  j7  = state[7];
+  j8  = state[8];
+  j9  = state[9];
+  j10 = state[10];
+  j11 = state[11];
+  j12 = U32V(counter);
+  j13 = U32V(counter >> 32);
+  j14 = state[14];
+  j15 = state[15];
 
   for (;;) {
     if (length < 64) {
@@ -169,4 +170,198 @@ void chacha8(const void* data, size_t length, const uint8_t* key, const uint8_t*
   }
 }
 
+// the multi-block kernels keep one state word of every block in a register and
+// transpose groups of four words back into block order before the xor
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CHACHA8_SSE2
+#include <emmintrin.h>
+
+#define ROTATE128(v,c) (_mm_or_si128(_mm_slli_epi32((v),(c)), _mm_srli_epi32((v),32-(c))))
+
+#define QUARTERROUND128(a,b,c,d) \
+  a = _mm_add_epi32(a,b); d = ROTATE128(_mm_xor_si128(d,a),16); \
+  c = _mm_add_epi32(c,d); b = ROTATE128(_mm_xor_si128(b,c),12); \
+  a = _mm_add_epi32(a,b); d = ROTATE128(_mm_xor_si128(d,a), 8); \
+  c = _mm_add_epi32(c,d); b = ROTATE128(_mm_xor_si128(b,c), 7);
+
+#define XORSTORE128(offset,v) \
+  _mm_storeu_si128((__m128i*)(cipher + (offset)), _mm_xor_si128((v), _mm_loadu_si128((const __m128i*)(data + (offset)))));
+
+// four blocks, 256 bytes
+static void chacha8_x4_sse2(const uint8_t* data, const uint32_t state[16], uint64_t counter, uint8_t* cipher) {
+  __m128i j[16], x[16];
+  int i;
+
+  for (i = 0; i < 16; ++i) {
+    j[i] = _mm_set1_epi32((int)state[i]);
+  }
+
+  j[12] = _mm_set_epi32((int)U32V(counter + 3), (int)U32V(counter + 2), (int)U32V(counter + 1), (int)U32V(counter));
+  j[13] = _mm_set_epi32((int)U32V((counter + 3) >> 32), (int)U32V((counter + 2) >> 32), (int)U32V((counter + 1) >> 32), (int)U32V(counter >> 32));
+
+  for (i = 0; i < 16; ++i) {
+    x[i] = j[i];
+  }
+
+  for (i = 8;i > 0;i -= 2) {
+    QUARTERROUND128(x[0], x[4], x[8],x[12])
+    QUARTERROUND128(x[1], x[5], x[9],x[13])
+    QUARTERROUND128(x[2], x[6],x[10],x[14])
+    QUARTERROUND128(x[3], x[7],x[11],x[15])
+    QUARTERROUND128(x[0], x[5],x[10],x[15])
+    QUARTERROUND128(x[1], x[6],x[11],x[12])
+    QUARTERROUND128(x[2], x[7], x[8],x[13])
+    QUARTERROUND128(x[3], x[4], x[9],x[14])
+  }
+
+  for (i = 0; i < 16; i += 4) {
+    __m128i t0 = _mm_unpacklo_epi32(_mm_add_epi32(x[i], j[i]), _mm_add_epi32(x[i + 1], j[i + 1]));
+    __m128i t1 = _mm_unpacklo_epi32(_mm_add_epi32(x[i + 2], j[i + 2]), _mm_add_epi32(x[i + 3], j[i + 3]));
+    __m128i t2 = _mm_unpackhi_epi32(_mm_add_epi32(x[i], j[i]), _mm_add_epi32(x[i + 1], j[i + 1]));
+    __m128i t3 = _mm_unpackhi_epi32(_mm_add_epi32(x[i + 2], j[i + 2]), _mm_add_epi32(x[i + 3], j[i + 3]));
+
+    XORSTORE128(  0 + i * 4, _mm_unpacklo_epi64(t0, t1))
+    XORSTORE128( 64 + i * 4, _mm_unpackhi_epi64(t0, t1))
+    XORSTORE128(128 + i * 4, _mm_unpacklo_epi64(t2, t3))
+    XORSTORE128(192 + i * 4, _mm_unpackhi_epi64(t2, t3))
+  }
+}
+#endif
+
+#if defined(CHACHA8_SSE2) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define CHACHA8_AVX2
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#define ROTATE256(v,c) (_mm256_or_si256(_mm256_slli_epi32((v),(c)), _mm256_srli_epi32((v),32-(c))))
+
+// rotations by whole bytes are a single shuffle
+#define QUARTERROUND256(a,b,c,d) \
+  a = _mm256_add_epi32(a,b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d,a),rot16); \
+  c = _mm256_add_epi32(c,d); b = ROTATE256(_mm256_xor_si256(b,c),12); \
+  a = _mm256_add_epi32(a,b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d,a),rot8); \
+  c = _mm256_add_epi32(c,d); b = ROTATE256(_mm256_xor_si256(b,c), 7);
+
+// the low lane holds blocks 0-3, the high lane blocks 4-7
+#define XORSTORE256(offset,v) \
+  XORSTORE128((offset), _mm256_castsi256_si128(v)) \
+  XORSTORE128((offset) + 256, _mm256_extracti128_si256((v), 1))
+
+// eight blocks, 512 bytes
+TARGET_AVX2 static void chacha8_x8_avx2(const uint8_t* data, const uint32_t state[16], uint64_t counter, uint8_t* cipher) {
+  const __m256i rot16 = _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+    13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+  const __m256i rot8 = _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+    14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3);
+  __m256i j[16], x[16];
+  int i;
+
+  for (i = 0; i < 16; ++i) {
+    j[i] = _mm256_set1_epi32((int)state[i]);
+  }
+
+  j[12] = _mm256_set_epi32((int)U32V(counter + 7), (int)U32V(counter + 6), (int)U32V(counter + 5), (int)U32V(counter + 4),
+    (int)U32V(counter + 3), (int)U32V(counter + 2), (int)U32V(counter + 1), (int)U32V(counter));
+  j[13] = _mm256_set_epi32((int)U32V((counter + 7) >> 32), (int)U32V((counter + 6) >> 32), (int)U32V((counter + 5) >> 32), (int)U32V((counter + 4) >> 32),
+    (int)U32V((counter + 3) >> 32), (int)U32V((counter + 2) >> 32), (int)U32V((counter + 1) >> 32), (int)U32V(counter >> 32));
+
+  for (i = 0; i < 16; ++i) {
+    x[i] = j[i];
+  }
+
+  for (i = 8;i > 0;i -= 2) {
+    QUARTERROUND256(x[0], x[4], x[8],x[12])
+    QUARTERROUND256(x[1], x[5], x[9],x[13])
+    QUARTERROUND256(x[2], x[6],x[10],x[14])
+    QUARTERROUND256(x[3], x[7],x[11],x[15])
+    QUARTERROUND256(x[0], x[5],x[10],x[15])
+    QUARTERROUND256(x[1], x[6],x[11],x[12])
+    QUARTERROUND256(x[2], x[7], x[8],x[13])
+    QUARTERROUND256(x[3], x[4], x[9],x[14])
+  }
+
+  for (i = 0; i < 16; i += 4) {
+    __m256i t0 = _mm256_unpacklo_epi32(_mm256_add_epi32(x[i], j[i]), _mm256_add_epi32(x[i + 1], j[i + 1]));
+    __m256i t1 = _mm256_unpacklo_epi32(_mm256_add_epi32(x[i + 2], j[i + 2]), _mm256_add_epi32(x[i + 3], j[i + 3]));
+    __m256i t2 = _mm256_unpackhi_epi32(_mm256_add_epi32(x[i], j[i]), _mm256_add_epi32(x[i + 1], j[i + 1]));
+    __m256i t3 = _mm256_unpackhi_epi32(_mm256_add_epi32(x[i + 2], j[i + 2]), _mm256_add_epi32(x[i + 3], j[i + 3]));
+
+    XORSTORE256(  0 + i * 4, _mm256_unpacklo_epi64(t0, t1))
+    XORSTORE256( 64 + i * 4, _mm256_unpackhi_epi64(t0, t1))
+    XORSTORE256(128 + i * 4, _mm256_unpacklo_epi64(t2, t3))
+    XORSTORE256(192 + i * 4, _mm256_unpackhi_epi64(t2, t3))
+  }
+}
+
+static bool check_avx2() {
+  static int supported = -1;
+
+  if (supported >= 0)
+    return supported != 0;
+
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return (supported = 0) != 0;
+  // the OS has to save the ymm registers too
+  __cpuid(info, 1);
+  if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6)
+    return (supported = 0) != 0;
+  __cpuidex(info, 7, 0);
+  supported = (info[1] & (1 << 5)) != 0;
+#else
+  supported = __builtin_cpu_supports("avx2") != 0;
+#endif
+  return supported != 0;
+}
+#endif
+
+void chacha8(const void* data, size_t length, const uint8_t* key, const uint8_t* iv, char* cipher) {
+  uint32_t state[16];
+  const uint8_t* in = static_cast<const uint8_t*>(data);
+  uint8_t* out = reinterpret_cast<uint8_t*>(cipher);
+  uint64_t counter = 0;
+
+  state[0]  = U8TO32_LITTLE(sigma + 0);
+  state[1]  = U8TO32_LITTLE(sigma + 4);
+  state[2]  = U8TO32_LITTLE(sigma + 8);
+  state[3]  = U8TO32_LITTLE(sigma + 12);
+  state[4]  = U8TO32_LITTLE(key + 0);
+  state[5]  = U8TO32_LITTLE(key + 4);
+  state[6]  = U8TO32_LITTLE(key + 8);
+  state[7]  = U8TO32_LITTLE(key + 12);
+  state[8]  = U8TO32_LITTLE(key + 16);
+  state[9]  = U8TO32_LITTLE(key + 20);
+  state[10] = U8TO32_LITTLE(key + 24);
+  state[11] = U8TO32_LITTLE(key + 28);
+  state[12] = 0;
+  state[13] = 0;
+  state[14] = U8TO32_LITTLE(iv + 0);
+  state[15] = U8TO32_LITTLE(iv + 4);
+
+#if defined(CHACHA8_AVX2)
+  if (length >= 512 && check_avx2()) {
+    for (; length >= 512; length -= 512, in += 512, out += 512, counter += 8) {
+      chacha8_x8_avx2(in, state, counter, out);
+    }
+  }
+#endif
+
+#if defined(CHACHA8_SSE2)
+  for (; length >= 256; length -= 256, in += 256, out += 256, counter += 4) {
+    chacha8_x4_sse2(in, state, counter, out);
+  }
+#endif
+
+  chacha8_blocks(in, length, state, counter, reinterpret_cast<char*>(out));
+}
+
 } // namespace Crypto
@@ -26,6 +26,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <vector>
 
 #include "Common/Varint.h"
 #include "crypto.h"
@@ -288,6 +289,91 @@ namespace Crypto {
     return true;
   }
 
+  bool crypto_ops::precompute_key_derivation(const PublicKey &key1, KeyDerivationPrecomp &precomp) {
+    ge_p3 point;
+    if (ge_frombytes_vartime(&point, reinterpret_cast<const unsigned char*>(&key1)) != 0) {
+      return false;
+    }
+    ge_sm_precomp(precomp.multiples, &point);
+    return true;
+  }
+
+  bool crypto_ops::generate_key_derivation(const KeyDerivationPrecomp &key1, const SecretKey &key2, KeyDerivation &derivation) {
+    ge_p2 point2;
+    ge_p1p1 point3;
+    if (!(sc_check(reinterpret_cast<const unsigned char*>(&key2)) == 0)) {
+      return false;
+    }
+    ge_scalarmult_precomp(&point2, reinterpret_cast<const unsigned char*>(&key2), key1.multiples);
+    ge_mul8(&point3, &point2);
+    ge_p1p1_to_p2(&point2, &point3);
+    ge_tobytes(reinterpret_cast<unsigned char*>(&derivation), &point2);
+    return true;
+  }
+
+  static void encode_points(const std::vector<ge_p2> &points, const std::vector<size_t> &positions, EllipticCurvePoint *out) {
+    std::vector<EllipticCurvePoint> encoded(points.size());
+    std::unique_ptr<fe[]> scratch(new fe[points.size()]);
+    ge_tobytes_batch(reinterpret_cast<unsigned char*>(encoded.data()), points.data(), points.size(), scratch.get());
+    for (size_t i = 0; i < positions.size(); ++i) {
+      out[positions[i]] = encoded[i];
+    }
+  }
+
+  void crypto_ops::generate_key_derivations(const PublicKey *keys, size_t count, const SecretKey &key2, KeyDerivation *derivations, bool *valid) {
+    std::vector<ge_p2> points;
+    std::vector<size_t> positions;
+    bool secretValid = sc_check(reinterpret_cast<const unsigned char*>(&key2)) == 0;
+    points.reserve(count);
+    positions.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      ge_p3 point;
+      ge_p2 point2;
+      ge_p1p1 point3;
+      valid[i] = secretValid && ge_frombytes_vartime(&point, reinterpret_cast<const unsigned char*>(&keys[i])) == 0;
+      if (!valid[i]) {
+        continue;
+      }
+
+      ge_scalarmult(&point2, reinterpret_cast<const unsigned char*>(&key2), &point);
+      ge_mul8(&point3, &point2);
+      points.emplace_back();
+      ge_p1p1_to_p2(&points.back(), &point3);
+      positions.push_back(i);
+    }
+
+    encode_points(points, positions, reinterpret_cast<EllipticCurvePoint*>(derivations));
+  }
+
+  void crypto_ops::underive_public_keys(const KeyDerivation *const *derivations, const size_t *output_indexes,
+    const PublicKey *derived_keys, size_t count, PublicKey *bases, bool *valid) {
+    std::vector<ge_p2> points;
+    std::vector<size_t> positions;
+    points.reserve(count);
+    positions.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      EllipticCurveScalar scalar;
+      ge_p3 point1;
+      ge_p3 point2;
+      ge_cached point3;
+      ge_p1p1 point4;
+      valid[i] = ge_frombytes_vartime(&point1, reinterpret_cast<const unsigned char*>(&derived_keys[i])) == 0;
+      if (!valid[i]) {
+        continue;
+      }
+
+      derivation_to_scalar(*derivations[i], output_indexes[i], scalar);
+      ge_scalarmult_base(&point2, reinterpret_cast<unsigned char*>(&scalar));
+      ge_p3_to_cached(&point3, &point2);
+      ge_sub(&point4, &point1, &point3);
+      points.emplace_back();
+      ge_p1p1_to_p2(&points.back(), &point4);
+      positions.push_back(i);
+    }
+
+    encode_points(points, positions, reinterpret_cast<EllipticCurvePoint*>(bases));
+  }
+
 
   struct s_comm {
     Hash h;
@@ -512,6 +598,46 @@ namespace Crypto {
     ge_tobytes(reinterpret_cast<unsigned char*>(&image), &point2);
   }
   
+  void crypto_ops::generate_key_images(const PublicKey *pubs, const SecretKey *secs, size_t count, KeyImage *images) {
+    std::vector<ge_p2> points(count);
+    std::vector<size_t> positions(count);
+    for (size_t i = 0; i < count; ++i) {
+      ge_p3 point;
+      assert(sc_check(reinterpret_cast<const unsigned char*>(&secs[i])) == 0);
+      hash_to_ec(pubs[i], point);
+      ge_scalarmult(&points[i], reinterpret_cast<const unsigned char*>(&secs[i]), &point);
+      positions[i] = i;
+    }
+
+    encode_points(points, positions, reinterpret_cast<EllipticCurvePoint*>(images));
+  }
+
+  void crypto_ops::check_key_images(const KeyImage *images, size_t count, bool *valid) {
+    static const EllipticCurveScalar zero = { { 0 } };
+    std::vector<ge_p2> points;
+    std::vector<size_t> positions;
+    points.reserve(count);
+    positions.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      ge_p3 point;
+      valid[i] = ge_frombytes_vartime(&point, reinterpret_cast<const unsigned char*>(&images[i])) == 0;
+      if (!valid[i]) {
+        continue;
+      }
+
+      // key images are public, the variable time multiplication is safe here
+      points.emplace_back();
+      ge_double_scalarmult_base_vartime(&points.back(), reinterpret_cast<const unsigned char*>(&L), &point, reinterpret_cast<const unsigned char*>(&zero));
+      positions.push_back(i);
+    }
+
+    std::vector<KeyImage> products(count);
+    encode_points(points, positions, reinterpret_cast<EllipticCurvePoint*>(products.data()));
+    for (size_t i : positions) {
+      valid[i] = products[i] == EllipticCurveScalar2KeyImage(I);
+    }
+  }
+
   void crypto_ops::generate_incomplete_key_image(const PublicKey &pub, EllipticCurvePoint &incomplete_key_image) {
     ge_p3 point;
     hash_to_ec(pub, point);
@@ -634,4 +760,45 @@ namespace Crypto {
     return sc_isnonzero(reinterpret_cast<unsigned char*>(&h)) == 0;
   }
 
+  bool crypto_ops::precompute_ring_member(const PublicKey &pub, RingMemberPrecomp &precomp) {
+    ge_p3 point;
+    if (ge_frombytes_vartime(&point, reinterpret_cast<const unsigned char*>(&pub)) != 0) {
+      return false;
+    }
+    ge_dsm_precomp(precomp.key, &point);
+    hash_to_ec(pub, point);
+    ge_dsm_precomp(precomp.imageBase, &point);
+    return true;
+  }
+
+  bool crypto_ops::check_ring_signature(const Hash &prefix_hash, const KeyImage &image,
+    const RingMemberPrecomp *const *pubs, size_t pubs_count,
+    const Signature *sig) {
+    size_t i;
+    ge_p3 image_unp;
+    ge_dsmp image_pre;
+    EllipticCurveScalar sum, h;
+    rs_comm *const buf = reinterpret_cast<rs_comm *>(alloca(rs_comm_size(pubs_count)));
+    if (ge_frombytes_vartime(&image_unp, reinterpret_cast<const unsigned char*>(&image)) != 0) {
+      return false;
+    }
+    ge_dsm_precomp(image_pre, &image_unp);
+    sc_0(reinterpret_cast<unsigned char*>(&sum));
+    buf->h = prefix_hash;
+    for (i = 0; i < pubs_count; i++) {
+      ge_p2 tmp2;
+      if (sc_check(reinterpret_cast<const unsigned char*>(&sig[i])) != 0 || sc_check(reinterpret_cast<const unsigned char*>(&sig[i]) + 32) != 0) {
+        return false;
+      }
+      ge_double_scalarmult_base_precomp_vartime(&tmp2, reinterpret_cast<const unsigned char*>(&sig[i]), pubs[i]->key, reinterpret_cast<const unsigned char*>(&sig[i]) + 32);
+      ge_tobytes(reinterpret_cast<unsigned char*>(&buf->ab[i].a), &tmp2);
+      ge_double_scalarmult_precomp2_vartime(&tmp2, reinterpret_cast<const unsigned char*>(&sig[i]) + 32, pubs[i]->imageBase, reinterpret_cast<const unsigned char*>(&sig[i]), image_pre);
+      ge_tobytes(reinterpret_cast<unsigned char*>(&buf->ab[i].b), &tmp2);
+      sc_add(reinterpret_cast<unsigned char*>(&sum), reinterpret_cast<unsigned char*>(&sum), reinterpret_cast<const unsigned char*>(&sig[i]));
+    }
+    hash_to_scalar(buf, rs_comm_size(pubs_count), h);
+    sc_sub(reinterpret_cast<unsigned char*>(&h), reinterpret_cast<unsigned char*>(&h), reinterpret_cast<unsigned char*>(&sum));
+    return sc_isnonzero(reinterpret_cast<unsigned char*>(&h)) == 0;
+  }
+
 }
@@ -35,6 +35,19 @@
 
 namespace Crypto {
 
+  /* Multiples of a transaction public key, built once to derive it with several view keys */
+  struct KeyDerivationPrecomp {
+    ge_smp multiples;
+  };
+
+  /* Sliding window tables of a ring member key P and of its key image base Hp(P). Popular outputs
+   * appear in many rings, so a verifier can build these once per output and keep them.
+   */
+  struct RingMemberPrecomp {
+    ge_dsmp key;
+    ge_dsmp imageBase;
+  };
+
   class crypto_ops {
     crypto_ops();
     crypto_ops(const crypto_ops &);
@@ -55,6 +68,12 @@ namespace Crypto {
     friend bool secret_key_mult_public_key(const SecretKey &, const PublicKey &, PublicKey &);
     static bool generate_key_derivation(const PublicKey &, const SecretKey &, KeyDerivation &);
     friend bool generate_key_derivation(const PublicKey &, const SecretKey &, KeyDerivation &);
+    static bool precompute_key_derivation(const PublicKey &, KeyDerivationPrecomp &);
+    friend bool precompute_key_derivation(const PublicKey &, KeyDerivationPrecomp &);
+    static bool generate_key_derivation(const KeyDerivationPrecomp &, const SecretKey &, KeyDerivation &);
+    friend bool generate_key_derivation(const KeyDerivationPrecomp &, const SecretKey &, KeyDerivation &);
+    static void generate_key_derivations(const PublicKey *, size_t, const SecretKey &, KeyDerivation *, bool *);
+    friend void generate_key_derivations(const PublicKey *, size_t, const SecretKey &, KeyDerivation *, bool *);
     static bool derive_public_key(const KeyDerivation &, size_t, const PublicKey &, PublicKey &);
     friend bool derive_public_key(const KeyDerivation &, size_t, const PublicKey &, PublicKey &);
     friend bool derive_public_key(const KeyDerivation &, size_t, const PublicKey &, const uint8_t*, size_t, PublicKey &);
@@ -73,6 +92,8 @@ namespace Crypto {
     friend bool underive_public_key(const KeyDerivation &, size_t, const PublicKey &, PublicKey &);
     static bool underive_public_key(const KeyDerivation &, size_t, const PublicKey &, const uint8_t*, size_t, PublicKey &);
     friend bool underive_public_key(const KeyDerivation &, size_t, const PublicKey &, const uint8_t*, size_t, PublicKey &);
+    static void underive_public_keys(const KeyDerivation *const *, const size_t *, const PublicKey *, size_t, PublicKey *, bool *);
+    friend void underive_public_keys(const KeyDerivation *const *, const size_t *, const PublicKey *, size_t, PublicKey *, bool *);
     static void generate_signature(const Hash &, const PublicKey &, const SecretKey &, Signature &);
     friend void generate_signature(const Hash &, const PublicKey &, const SecretKey &, Signature &);
     static bool check_signature(const Hash &, const PublicKey &, const Signature &);
@@ -83,6 +104,10 @@ namespace Crypto {
     friend bool check_tx_proof(const Hash &, const PublicKey &, const PublicKey &, const PublicKey &, const Signature &);
     static void generate_key_image(const PublicKey &, const SecretKey &, KeyImage &);
     friend void generate_key_image(const PublicKey &, const SecretKey &, KeyImage &);
+    static void generate_key_images(const PublicKey *, const SecretKey *, size_t, KeyImage *);
+    friend void generate_key_images(const PublicKey *, const SecretKey *, size_t, KeyImage *);
+    static void check_key_images(const KeyImage *, size_t, bool *);
+    friend void check_key_images(const KeyImage *, size_t, bool *);
     static KeyImage scalarmultKey(const KeyImage & P, const KeyImage & a);
     friend KeyImage scalarmultKey(const KeyImage & P, const KeyImage & a);
     static void hash_data_to_ec(const uint8_t*, std::size_t, PublicKey&);
@@ -95,6 +120,12 @@ namespace Crypto {
       const PublicKey *const *, size_t, const Signature *);
     friend bool check_ring_signature(const Hash &, const KeyImage &,
       const PublicKey *const *, size_t, const Signature *);
+    static bool precompute_ring_member(const PublicKey &, RingMemberPrecomp &);
+    friend bool precompute_ring_member(const PublicKey &, RingMemberPrecomp &);
+    static bool check_ring_signature(const Hash &, const KeyImage &,
+      const RingMemberPrecomp *const *, size_t, const Signature *);
+    friend bool check_ring_signature(const Hash &, const KeyImage &,
+      const RingMemberPrecomp *const *, size_t, const Signature *);
   };
 
   void hash_to_scalar(const void *data, size_t length, EllipticCurveScalar &res);
@@ -141,6 +172,23 @@ namespace Crypto {
     return crypto_ops::generate_key_derivation(key1, key2, derivation);
   }
 
+  /* Precomputation for generate_key_derivation with the same transaction key and different view keys.
+   */
+  inline bool precompute_key_derivation(const PublicKey &key1, KeyDerivationPrecomp &precomp) {
+    return crypto_ops::precompute_key_derivation(key1, precomp);
+  }
+
+  inline bool generate_key_derivation(const KeyDerivationPrecomp &key1, const SecretKey &key2, KeyDerivation &derivation) {
+    return crypto_ops::generate_key_derivation(key1, key2, derivation);
+  }
+
+  /* generate_key_derivation of many transaction keys with the same secret key. The results share
+   * one field inversion, valid[i] is false where generate_key_derivation would have failed.
+   */
+  inline void generate_key_derivations(const PublicKey *keys, size_t count, const SecretKey &key2, KeyDerivation *derivations, bool *valid) {
+    crypto_ops::generate_key_derivations(keys, count, key2, derivations, valid);
+  }
+
   inline bool derive_public_key(const KeyDerivation &derivation, size_t output_index,
     const PublicKey &base, const uint8_t* prefix, size_t prefixLength, PublicKey &derived_key) {
     return crypto_ops::derive_public_key(derivation, output_index, base, prefix, prefixLength, derived_key);
@@ -180,6 +228,13 @@ namespace Crypto {
     return crypto_ops::underive_public_key(derivation, output_index, derived_key, base);
   }
 
+  /* underive_public_key of many outputs at once, output i uses *derivations[i] and output_indexes[i].
+   */
+  inline void underive_public_keys(const KeyDerivation *const *derivations, const size_t *output_indexes,
+    const PublicKey *derived_keys, size_t count, PublicKey *bases, bool *valid) {
+    crypto_ops::underive_public_keys(derivations, output_indexes, derived_keys, count, bases, valid);
+  }
+
   /* Generation and checking of a standard signature.
    */
   inline void generate_signature(const Hash &prefix_hash, const PublicKey &pub, const SecretKey &sec, Signature &sig) {
@@ -209,6 +264,20 @@ namespace Crypto {
     crypto_ops::generate_key_image(pub, sec, image);
   }
 
+  /* generate_key_image of many outputs at once. Every image takes the constant time multiplication
+   * of generate_key_image, the encodings share one field inversion.
+   */
+  inline void generate_key_images(const PublicKey *pubs, const SecretKey *secs, size_t count, KeyImage *images) {
+    crypto_ops::generate_key_images(pubs, secs, count, images);
+  }
+
+  /* Checks that key images are points of the prime order subgroup, i.e. L * image is the identity.
+   * valid[i] is false for images that fail to decode or lie outside the subgroup.
+   */
+  inline void check_key_images(const KeyImage *images, size_t count, bool *valid) {
+    crypto_ops::check_key_images(images, count, valid);
+  }
+
   inline KeyImage scalarmultKey(const KeyImage & P, const KeyImage & a) {
     return crypto_ops::scalarmultKey(P, a);
   }
@@ -229,6 +298,18 @@ namespace Crypto {
     return crypto_ops::check_ring_signature(prefix_hash, image, pubs, pubs_count, sig);
   }
 
+  /* Same check with the ring members' tables built beforehand by precompute_ring_member.
+   */
+  inline bool precompute_ring_member(const PublicKey &pub, RingMemberPrecomp &precomp) {
+    return crypto_ops::precompute_ring_member(pub, precomp);
+  }
+
+  inline bool check_ring_signature(const Hash &prefix_hash, const KeyImage &image,
+    const RingMemberPrecomp *const *pubs, size_t pubs_count,
+    const Signature *sig) {
+    return crypto_ops::check_ring_signature(prefix_hash, image, pubs, pubs_count, sig);
+  }
+
   /* Variants with vector<const PublicKey *> parameters.
    */
   inline void generate_ring_signature(const Hash &prefix_hash, const KeyImage &image,
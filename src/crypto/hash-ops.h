@@ -60,12 +60,25 @@ void hash_process(union hash_state *state, const uint8_t *buf, size_t count);
 enum {
   HASH_SIZE = 32,
   HASH_DATA_AREA = 136,
-  SLOW_HASH_CONTEXT_SIZE = 2097552
+  SLOW_HASH_CONTEXT_SIZE = 2097552,
+  SLOW_HASH_MAX_WAYS = 4,
+  FAST_HASH_WAYS = 4
 };
 
 void cn_fast_hash(const void *data, size_t length, char *hash);
+void cn_fast_hash_multi(const void *const *data, const size_t *length, size_t count, char *hash);
 
 void cn_slow_hash(const void *data, size_t length, char *hash);
+void cn_slow_hash_kernel(int kernel, const void *data, size_t length, char *hash);
+int slow_hash_kernel(void);
+int slow_hash_kernel_count(void);
+const char *slow_hash_kernel_name(int kernel);
+int slow_hash_kernel_available(int kernel);
+void cn_slow_hash_multi(const void *const *data, const size_t *length, size_t count, char *hash);
+void slow_hash_allocate_state(void);
+void slow_hash_allocate_multi_state(void);
+void slow_hash_free_state(void);
+int slow_hash_state_is_huge_page(void);
 
 void hash_extra_blake(const void *data, size_t length, char *hash);
 void hash_extra_groestl(const void *data, size_t length, char *hash);
@@ -35,3 +35,64 @@ void cn_fast_hash(const void *data, size_t length, char *hash) {
   hash_process(&state, data, length);
   memcpy(hash, &state, HASH_SIZE);
 }
+
+/*
+ * Hashes up to KECCAK_X4_WAYS messages per permutation call.  A message takes
+ * length / HASH_DATA_AREA + 1 blocks, the last one padded as in keccak(); a lane
+ * whose message is complete keeps being permuted with the others, its hash is
+ * taken right after its last block.
+ */
+void cn_fast_hash_multi(const void *const *data, const size_t *length, size_t count, char *hash) {
+  uint64_t state[25][KECCAK_X4_WAYS];
+  uint64_t block[HASH_DATA_AREA / 8];
+  size_t blocks[KECCAK_X4_WAYS];
+  size_t first, ways, lane, index, maxBlocks, i;
+
+  for (first = 0; first < count; first += ways) {
+    ways = count - first < KECCAK_X4_WAYS ? count - first : KECCAK_X4_WAYS;
+    if (ways == 1) {
+      cn_fast_hash(data[first], length[first], hash + first * HASH_SIZE);
+      continue;
+    }
+
+    maxBlocks = 0;
+    for (lane = 0; lane < ways; ++lane) {
+      blocks[lane] = length[first + lane] / HASH_DATA_AREA + 1;
+      if (blocks[lane] > maxBlocks) {
+        maxBlocks = blocks[lane];
+      }
+    }
+
+    memset(state, 0, sizeof(state));
+    for (index = 0; index < maxBlocks; ++index) {
+      for (lane = 0; lane < ways; ++lane) {
+        const uint8_t *in = (const uint8_t *) data[first + lane] + index * HASH_DATA_AREA;
+        if (index + 1 < blocks[lane]) {
+          memcpy(block, in, HASH_DATA_AREA);
+        } else if (index + 1 == blocks[lane]) {
+          size_t left = length[first + lane] - index * HASH_DATA_AREA;
+          memcpy(block, in, left);
+          ((uint8_t *) block)[left] = 1;
+          memset((uint8_t *) block + left + 1, 0, HASH_DATA_AREA - left - 1);
+          ((uint8_t *) block)[HASH_DATA_AREA - 1] |= 0x80;
+        } else {
+          continue;
+        }
+
+        for (i = 0; i < HASH_DATA_AREA / 8; ++i) {
+          state[i][lane] ^= block[i];
+        }
+      }
+
+      keccakf_x4(state, KECCAK_ROUNDS);
+
+      for (lane = 0; lane < ways; ++lane) {
+        if (index + 1 == blocks[lane]) {
+          for (i = 0; i < HASH_SIZE / 8; ++i) {
+            memcpy(hash + (first + lane) * HASH_SIZE + i * 8, &state[i][lane], 8);
+          }
+        }
+      }
+    }
+  }
+}
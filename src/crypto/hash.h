@@ -43,6 +43,11 @@ namespace Crypto {
     return h;
   }
 
+  // Computes 'count' independent hashes, FAST_HASH_WAYS of them per Keccak permutation
+  inline void cn_fast_hash_multi(const void *const *data, const size_t *length, size_t count, Hash *hashes) {
+    cn_fast_hash_multi(data, length, count, reinterpret_cast<char *>(hashes));
+  }
+
   class cn_context {
   public:
 
@@ -63,6 +68,11 @@ namespace Crypto {
     cn_slow_hash(data, length, reinterpret_cast<char *>(&hash));
   }
 
+  // Computes 'count' independent hashes, interleaving up to SLOW_HASH_MAX_WAYS of them per pass
+  inline void cn_slow_hash_multi(cn_context &context, const void *const *data, const size_t *length, size_t count, Hash *hashes) {
+    cn_slow_hash_multi(data, length, count, reinterpret_cast<char *>(hashes));
+  }
+
   inline void tree_hash(const Hash *hashes, size_t count, Hash &root_hash) {
     tree_hash(reinterpret_cast<const char (*)[HASH_SIZE]>(hashes), count, reinterpret_cast<char *>(&root_hash));
   }
@@ -70,6 +70,153 @@ void keccakf(uint64_t st[25], int rounds)
     }
 }
 
+// the same permutation on interleaved states, the lane loops are left to the compiler
+
+static void keccakf_x4_generic(uint64_t st[25][KECCAK_X4_WAYS], int rounds)
+{
+    int i, j, l, round;
+    uint64_t t[KECCAK_X4_WAYS], bc[5][KECCAK_X4_WAYS];
+
+    for (round = 0; round < rounds; round++) {
+
+        // Theta
+        for (i = 0; i < 5; i++)
+            for (l = 0; l < KECCAK_X4_WAYS; l++)
+                bc[i][l] = st[i][l] ^ st[i + 5][l] ^ st[i + 10][l] ^ st[i + 15][l] ^ st[i + 20][l];
+
+        for (i = 0; i < 5; i++) {
+            for (l = 0; l < KECCAK_X4_WAYS; l++)
+                t[l] = bc[(i + 4) % 5][l] ^ ROTL64(bc[(i + 1) % 5][l], 1);
+            for (j = 0; j < 25; j += 5)
+                for (l = 0; l < KECCAK_X4_WAYS; l++)
+                    st[j + i][l] ^= t[l];
+        }
+
+        // Rho Pi
+        for (l = 0; l < KECCAK_X4_WAYS; l++)
+            t[l] = st[1][l];
+        for (i = 0; i < 24; i++) {
+            j = keccakf_piln[i];
+            for (l = 0; l < KECCAK_X4_WAYS; l++) {
+                bc[0][l] = st[j][l];
+                st[j][l] = ROTL64(t[l], keccakf_rotc[i]);
+                t[l] = bc[0][l];
+            }
+        }
+
+        //  Chi
+        for (j = 0; j < 25; j += 5) {
+            for (i = 0; i < 5; i++)
+                for (l = 0; l < KECCAK_X4_WAYS; l++)
+                    bc[i][l] = st[j + i][l];
+            for (i = 0; i < 5; i++)
+                for (l = 0; l < KECCAK_X4_WAYS; l++)
+                    st[j + i][l] ^= (~bc[(i + 1) % 5][l]) & bc[(i + 2) % 5][l];
+        }
+
+        //  Iota
+        for (l = 0; l < KECCAK_X4_WAYS; l++)
+            st[0][l] ^= keccakf_rndc[round];
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define KECCAK_X4_AVX2
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// one 256 bit register holds the same word of all four states
+
+#define ROTL256(x, y) _mm256_or_si256(_mm256_sll_epi64((x), _mm_cvtsi32_si128(y)), _mm256_srl_epi64((x), _mm_cvtsi32_si128(64 - (y))))
+
+TARGET_AVX2 static void keccakf_x4_avx2(uint64_t st[25][KECCAK_X4_WAYS], int rounds)
+{
+    int i, j, round;
+    __m256i a[25], bc[5], t;
+
+    for (i = 0; i < 25; i++)
+        a[i] = _mm256_loadu_si256((const __m256i *) st[i]);
+
+    for (round = 0; round < rounds; round++) {
+
+        // Theta
+        for (i = 0; i < 5; i++)
+            bc[i] = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(a[i], a[i + 5]), _mm256_xor_si256(a[i + 10], a[i + 15])), a[i + 20]);
+
+        for (i = 0; i < 5; i++) {
+            t = _mm256_xor_si256(bc[(i + 4) % 5], ROTL256(bc[(i + 1) % 5], 1));
+            for (j = 0; j < 25; j += 5)
+                a[j + i] = _mm256_xor_si256(a[j + i], t);
+        }
+
+        // Rho Pi
+        t = a[1];
+        for (i = 0; i < 24; i++) {
+            j = keccakf_piln[i];
+            bc[0] = a[j];
+            a[j] = ROTL256(t, keccakf_rotc[i]);
+            t = bc[0];
+        }
+
+        //  Chi
+        for (j = 0; j < 25; j += 5) {
+            for (i = 0; i < 5; i++)
+                bc[i] = a[j + i];
+            for (i = 0; i < 5; i++)
+                a[j + i] = _mm256_xor_si256(a[j + i], _mm256_andnot_si256(bc[(i + 1) % 5], bc[(i + 2) % 5]));
+        }
+
+        //  Iota
+        a[0] = _mm256_xor_si256(a[0], _mm256_set1_epi64x((long long) keccakf_rndc[round]));
+    }
+
+    for (i = 0; i < 25; i++)
+        _mm256_storeu_si256((__m256i *) st[i], a[i]);
+}
+
+static int check_avx2(void)
+{
+    static int supported = -1;
+
+    if (supported >= 0)
+        return supported;
+
+#if defined(_MSC_VER)
+    {
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return supported = 0;
+        // the OS has to save the ymm registers too
+        __cpuid(info, 1);
+        if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6)
+            return supported = 0;
+        __cpuidex(info, 7, 0);
+        return supported = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    return supported = __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+void keccakf_x4(uint64_t st[25][KECCAK_X4_WAYS], int rounds)
+{
+#if defined(KECCAK_X4_AVX2)
+    if (check_avx2()) {
+        keccakf_x4_avx2(st, rounds);
+        return;
+    }
+#endif
+    keccakf_x4_generic(st, rounds);
+}
+
 // compute a keccak hash (md) of given byte length from "in"
 typedef uint64_t state_t[25];
 
@@ -21,6 +21,10 @@ int keccak(const uint8_t *in, int inlen, uint8_t *md, int mdlen);
 // update the state
 void keccakf(uint64_t st[25], int norounds);
 
+// update KECCAK_X4_WAYS interleaved states at once, st[i][l] is word i of state l
+#define KECCAK_X4_WAYS 4
+void keccakf_x4(uint64_t st[25][KECCAK_X4_WAYS], int norounds);
+
 void keccak1600(const uint8_t *in, int inlen, uint8_t *md);
 
 #endif
@@ -45,6 +45,17 @@
 #define INIT_SIZE_BLK   8
 #define INIT_SIZE_BYTE (INIT_SIZE_BLK * AES_BLOCK_SIZE)
 
+/* Every build below fills slow_hash_kernels with the CryptoNight kernels it
+ * compiled, in order of preference, and picks the default one in
+ * slow_hash_default_kernel.  A NULL 'available' means the kernel runs on any
+ * CPU the build targets. */
+struct slow_hash_kernel_info
+{
+    const char *name;
+    void (*hash)(const void *data, size_t length, char *hash);
+    int (*available)(void);
+};
+
 //extern void aesb_single_round(const uint8_t *in, uint8_t*out, const uint8_t *expandedKey);
 //extern void aesb_pseudo_round(const uint8_t *in, uint8_t *out, const uint8_t *expandedKey);
 
@@ -158,6 +169,9 @@ union cn_slow_hash_state
 
 THREADV uint8_t *hp_state = NULL;
 THREADV int hp_allocated = 0;
+/* Scratchpads of the extra lanes used by cn_slow_hash_multi, see below. */
+THREADV uint8_t *hp_multi_state = NULL;
+THREADV int hp_multi_allocated = 0;
 
 #if defined(_MSC_VER)
 #define cpuid(info,x)    __cpuidex(info,x,0)
@@ -435,55 +449,111 @@ BOOL SetLockPagesPrivilege(HANDLE hProcess, BOOL bEnable)
  * the allocated buffer.
  */
 
-void slow_hash_allocate_state(void)
+STATIC INLINE uint8_t *allocate_scratchpad(size_t size, int *huge)
 {
-    if(hp_state != NULL)
-        return;
+    uint8_t *scratchpad;
 
 #if defined(_MSC_VER) || defined(__MINGW32__)
     SetLockPagesPrivilege(GetCurrentProcess(), TRUE);
-    hp_state = (uint8_t *) VirtualAlloc(hp_state, MEMORY, MEM_LARGE_PAGES |
-                                        MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    scratchpad = (uint8_t *) VirtualAlloc(NULL, size, MEM_LARGE_PAGES |
+                                          MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
 #else
 #if defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || \
   defined(__DragonFly__)
-    hp_state = mmap(0, MEMORY, PROT_READ | PROT_WRITE,
-                    MAP_PRIVATE | MAP_ANON, 0, 0);
+    scratchpad = mmap(0, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANON, 0, 0);
 #else
-    hp_state = mmap(0, MEMORY, PROT_READ | PROT_WRITE,
-                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, 0, 0);
+    scratchpad = mmap(0, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, 0, 0);
 #endif
-    if(hp_state == MAP_FAILED)
-        hp_state = NULL;
+    if(scratchpad == MAP_FAILED)
+        scratchpad = NULL;
 #endif
-    hp_allocated = 1;
-    if(hp_state == NULL)
+    *huge = 1;
+    if(scratchpad == NULL)
+    {
+        *huge = 0;
+        scratchpad = (uint8_t *) malloc(size);
+        if(scratchpad == NULL)
+            return NULL;
+    }
+
+    /* Touch the scratchpad from the allocating thread so that the pages are
+     * faulted in on the NUMA node the thread is running on (first-touch
+     * policy) instead of on the first hashing round. */
+    memset(scratchpad, 0, size);
+    return scratchpad;
+}
+
+STATIC INLINE void free_scratchpad(uint8_t *scratchpad, size_t size, int huge)
+{
+    if(!huge)
+        free(scratchpad);
+    else
     {
-        hp_allocated = 0;
-        hp_state = (uint8_t *) malloc(MEMORY);
+#if defined(_MSC_VER) || defined(__MINGW32__)
+        VirtualFree(scratchpad, 0, MEM_RELEASE);
+#else
+        munmap(scratchpad, size);
+#endif
     }
 }
 
+void slow_hash_allocate_state(void)
+{
+    if(hp_state != NULL)
+        return;
+
+    hp_state = allocate_scratchpad(MEMORY, &hp_allocated);
+}
+
 /**
- *@brief frees the state allocated by slow_hash_allocate_state
+ * @brief reports whether the thread-local scratch buffer is backed by huge pages
+ *
+ * @return 1 if slow_hash_allocate_state obtained huge / large pages for the
+ * calling thread, 0 if the buffer is not allocated or fell back to malloc
  */
 
-void slow_hash_free_state(void)
+int slow_hash_state_is_huge_page(void)
 {
-    if(hp_state == NULL)
+    if(hp_state == NULL && hp_multi_state == NULL)
+        return 0;
+
+    return (hp_state == NULL || hp_allocated) && (hp_multi_state == NULL || hp_multi_allocated);
+}
+
+/**
+ * @brief allocates the SLOW_HASH_MAX_WAYS scratch buffers used by cn_slow_hash_multi
+ *
+ * Like slow_hash_allocate_state, the buffers are thread-local, kept until
+ * slow_hash_free_state is called and backed by huge pages when possible.
+ */
+
+void slow_hash_allocate_multi_state(void)
+{
+    if(hp_multi_state != NULL)
         return;
 
-    if(!hp_allocated)
-        free(hp_state);
-    else
+    hp_multi_state = allocate_scratchpad(MEMORY * SLOW_HASH_MAX_WAYS, &hp_multi_allocated);
+}
+
+/**
+ *@brief frees the state allocated by slow_hash_allocate_state
+ */
+
+void slow_hash_free_state(void)
+{
+    if(hp_multi_state != NULL)
     {
-#if defined(_MSC_VER) || defined(__MINGW32__)
-        VirtualFree(hp_state, 0, MEM_RELEASE);
-#else
-        munmap(hp_state, MEMORY);
-#endif
+        free_scratchpad(hp_multi_state, MEMORY * SLOW_HASH_MAX_WAYS, hp_multi_allocated);
+        hp_multi_state = NULL;
+        hp_multi_allocated = 0;
     }
 
+    if(hp_state == NULL)
+        return;
+
+    free_scratchpad(hp_state, MEMORY, hp_allocated);
     hp_state = NULL;
     hp_allocated = 0;
 }
@@ -517,10 +587,11 @@ void slow_hash_free_state(void)
  * @param data the data to hash
  * @param length the length in bytes of the data
  * @param hash a pointer to a buffer in which the final 256 bit hash will be stored
+ * @param useAes 1 for AES-NI, 0 for the table based software AES
  */
 
 
-void cn_slow_hash(const void *data, size_t length, char *hash)
+STATIC INLINE void cn_slow_hash_x86(const void *data, size_t length, char *hash, int useAes)
 {
     RDATA_ALIGN16 uint8_t expandedKey[240];  /* These buffers are aligned to use later with SSE functions */
 
@@ -535,7 +606,6 @@ void cn_slow_hash(const void *data, size_t length, char *hash)
     size_t i, j;
     uint64_t *p = NULL;
     oaes_ctx *aes_ctx = NULL;
-    int useAes = !force_software_aes() && check_aes_hw();
 
     static void (*const extra_hashes[4])(const void *, size_t, char *) =
     {
@@ -654,6 +724,184 @@ void cn_slow_hash(const void *data, size_t length, char *hash)
 		slow_hash_free_state();
 }
 
+static void cn_slow_hash_aes_ni(const void *data, size_t length, char *hash)
+{
+    cn_slow_hash_x86(data, length, hash, 1);
+}
+
+static void cn_slow_hash_software_aes(const void *data, size_t length, char *hash)
+{
+    cn_slow_hash_x86(data, length, hash, 0);
+}
+
+static int aes_ni_available(void)
+{
+    return check_aes_hw() != 0;
+}
+
+#define SLOW_HASH_KERNEL_AES_NI 0
+
+static const struct slow_hash_kernel_info slow_hash_kernels[] =
+{
+    { "aes-ni", cn_slow_hash_aes_ni, aes_ni_available },
+    { "software-aes", cn_slow_hash_software_aes, NULL }
+};
+
+/* MONERO_USE_SOFTWARE_AES only changes the default, AES-NI may still be called explicitly */
+static int slow_hash_default_kernel(void)
+{
+    return !force_software_aes() && aes_ni_available() ? SLOW_HASH_KERNEL_AES_NI : 1;
+}
+
+/**
+ * @brief CryptoNight over 'ways' independent inputs with interleaved main loops
+ *
+ * Every lane gets its own 2MB slice of hp_multi_state.  Steps 1, 2, 4 and 5
+ * are done lane by lane, as in cn_slow_hash.  In step 3 the scratchpad reads
+ * of all lanes are issued before any of them is consumed, so the latency of
+ * one lane's random access is hidden behind the work of the others.  The
+ * result for every lane is the same as cn_slow_hash on that input.
+ *
+ * Requires hardware AES and an allocated hp_multi_state.
+ */
+
+STATIC INLINE void cn_slow_hash_ways(const void *const *data, const size_t *length, char *hash, size_t ways)
+{
+    RDATA_ALIGN16 uint8_t expandedKey[240];
+
+    uint8_t text[INIT_SIZE_BYTE];
+    RDATA_ALIGN16 uint64_t la[SLOW_HASH_MAX_WAYS][2];
+    RDATA_ALIGN16 uint64_t lc[SLOW_HASH_MAX_WAYS][2];
+    RDATA_ALIGN16 uint64_t lb[2];
+    union cn_slow_hash_state state[SLOW_HASH_MAX_WAYS];
+    uint8_t *scratchpad[SLOW_HASH_MAX_WAYS];
+    __m128i _b[SLOW_HASH_MAX_WAYS], _c;
+    uint64_t hi, lo;
+
+    size_t i, j, l;
+    uint64_t *p = NULL;
+
+    static void (*const extra_hashes[4])(const void *, size_t, char *) =
+    {
+        hash_extra_blake, hash_extra_groestl, hash_extra_jh, hash_extra_skein
+    };
+
+    /* Steps 1 and 2, see cn_slow_hash */
+    for(l = 0; l < ways; l++)
+    {
+        scratchpad[l] = &hp_multi_state[l * MEMORY];
+
+        hash_process(&state[l].hs, data[l], length[l]);
+        memcpy(text, state[l].init, INIT_SIZE_BYTE);
+
+        aes_expand_key(state[l].hs.b, expandedKey);
+        for(i = 0; i < MEMORY / INIT_SIZE_BYTE; i++)
+        {
+            aes_pseudo_round(text, text, expandedKey, INIT_SIZE_BLK);
+            memcpy(&scratchpad[l][i * INIT_SIZE_BYTE], text, INIT_SIZE_BYTE);
+        }
+
+        U64(la[l])[0] = U64(&state[l].k[0])[0] ^ U64(&state[l].k[32])[0];
+        U64(la[l])[1] = U64(&state[l].k[0])[1] ^ U64(&state[l].k[32])[1];
+        U64(lb)[0] = U64(&state[l].k[16])[0] ^ U64(&state[l].k[48])[0];
+        U64(lb)[1] = U64(&state[l].k[16])[1] ^ U64(&state[l].k[48])[1];
+        _b[l] = _mm_load_si128(R128(lb));
+    }
+
+    /* Step 3: the AES half of the mixing function for all lanes, then the
+     * multiply half for all lanes. */
+    for(i = 0; i < ITER / 2; i++)
+    {
+        for(l = 0; l < ways; l++)
+        {
+            j = state_index(la[l]);
+            _c = _mm_load_si128(R128(&scratchpad[l][j]));
+            _c = _mm_aesenc_si128(_c, _mm_load_si128(R128(la[l])));
+            _mm_store_si128(R128(lc[l]), _c);
+            _mm_store_si128(R128(&scratchpad[l][j]), _mm_xor_si128(_b[l], _c));
+            _b[l] = _c;
+        }
+
+        for(l = 0; l < ways; l++)
+        {
+            const uint64_t *c = lc[l];
+            uint64_t *a = la[l];
+            uint64_t b[2];
+
+            j = state_index(c);
+            p = U64(&scratchpad[l][j]);
+            b[0] = p[0]; b[1] = p[1];
+            __mul();
+            a[0] += hi; a[1] += lo;
+            p[0] = a[0]; p[1] = a[1];
+            a[0] ^= b[0]; a[1] ^= b[1];
+        }
+    }
+
+    /* Steps 4 and 5, see cn_slow_hash */
+    for(l = 0; l < ways; l++)
+    {
+        memcpy(text, state[l].init, INIT_SIZE_BYTE);
+        aes_expand_key(&state[l].hs.b[32], expandedKey);
+        for(i = 0; i < MEMORY / INIT_SIZE_BYTE; i++)
+            aes_pseudo_round_xor(text, text, expandedKey, &scratchpad[l][i * INIT_SIZE_BYTE], INIT_SIZE_BLK);
+
+        memcpy(state[l].init, text, INIT_SIZE_BYTE);
+        hash_permutation(&state[l].hs);
+        extra_hashes[state[l].hs.b[0] & 3](&state[l], 200, hash + l * HASH_SIZE);
+    }
+}
+
+/**
+ * @brief computes CryptoNight for 'count' independent inputs
+ *
+ * Inputs are processed in groups of up to SLOW_HASH_MAX_WAYS with their main
+ * loops interleaved (see cn_slow_hash_ways); a single leftover input and
+ * builds whose active kernel is not AES-NI go through cn_slow_hash.  Like cn_slow_hash, the
+ * scratch buffers are allocated and freed locally unless the caller keeps
+ * them with slow_hash_allocate_multi_state.
+ *
+ * @param data pointers to the 'count' inputs
+ * @param length the lengths of the 'count' inputs
+ * @param count the number of inputs
+ * @param hash a buffer of count * HASH_SIZE bytes receiving the hashes in input order
+ */
+
+void cn_slow_hash_multi(const void *const *data, const size_t *length, size_t count, char *hash)
+{
+    size_t i = 0;
+    int bLocalStateAllocation = 0;
+
+    if(count >= 2 && slow_hash_kernel() == SLOW_HASH_KERNEL_AES_NI)
+    {
+        bLocalStateAllocation = (hp_multi_state == NULL);
+        if(bLocalStateAllocation)
+            slow_hash_allocate_multi_state();
+
+        if(hp_multi_state != NULL)
+        {
+            for(; count - i >= SLOW_HASH_MAX_WAYS; i += SLOW_HASH_MAX_WAYS)
+                cn_slow_hash_ways(&data[i], &length[i], hash + i * HASH_SIZE, SLOW_HASH_MAX_WAYS);
+
+            if(count - i >= 2)
+            {
+                cn_slow_hash_ways(&data[i], &length[i], hash + i * HASH_SIZE, count - i >= 3 ? 3 : 2);
+                i += count - i >= 3 ? 3 : 2;
+            }
+        }
+    }
+
+    for(; i < count; i++)
+        cn_slow_hash(data[i], length[i], hash + i * HASH_SIZE);
+
+    if(bLocalStateAllocation && hp_multi_state != NULL)
+    {
+        free_scratchpad(hp_multi_state, MEMORY * SLOW_HASH_MAX_WAYS, hp_multi_allocated);
+        hp_multi_state = NULL;
+        hp_multi_allocated = 0;
+    }
+}
+
 #elif !defined NO_AES && (defined(__arm__) || defined(__aarch64__))
 void slow_hash_allocate_state(void)
 {
@@ -667,6 +915,11 @@ void slow_hash_free_state(void)
   return;
 }
 
+int slow_hash_state_is_huge_page(void)
+{
+  return 0;
+}
+
 #if defined(__GNUC__)
 #define RDATA_ALIGN16 __attribute__ ((aligned(16)))
 #define STATIC static
@@ -854,7 +1107,7 @@ STATIC INLINE void aes_pseudo_round_xor(const uint8_t *in, uint8_t *out, const u
 	}
 }
 
-void cn_slow_hash(const void *data, size_t length, char *hash)
+static void cn_slow_hash_armv8_crypto(const void *data, size_t length, char *hash)
 {
     RDATA_ALIGN16 uint8_t expandedKey[240];
     RDATA_ALIGN16 uint8_t hp_state[MEMORY];
@@ -937,6 +1190,16 @@ void cn_slow_hash(const void *data, size_t length, char *hash)
     hash_permutation(&state.hs);
     extra_hashes[state.hs.b[0] & 3](&state, 200, hash);
 }
+
+static const struct slow_hash_kernel_info slow_hash_kernels[] =
+{
+    { "armv8-crypto", cn_slow_hash_armv8_crypto, NULL }
+};
+
+static int slow_hash_default_kernel(void)
+{
+    return 0;
+}
 #else /* aarch64 && crypto */
 
 // ND: Some minor optimizations for ARMv7 (raspberrry pi 2), effect seems to be ~40-50% faster.
@@ -1048,7 +1311,7 @@ STATIC INLINE void xor_blocks(uint8_t* a, const uint8_t* b)
   U64(a)[1] ^= U64(b)[1];
 }
 
-void cn_slow_hash(const void *data, size_t length, char *hash)
+static void cn_slow_hash_arm(const void *data, size_t length, char *hash)
 {
     uint8_t text[INIT_SIZE_BYTE];
     uint8_t a[AES_BLOCK_SIZE];
@@ -1131,6 +1394,16 @@ void cn_slow_hash(const void *data, size_t length, char *hash)
 
 	free(long_state);
 }
+
+static const struct slow_hash_kernel_info slow_hash_kernels[] =
+{
+    { "arm", cn_slow_hash_arm, NULL }
+};
+
+static int slow_hash_default_kernel(void)
+{
+    return 0;
+}
 #endif /* !aarch64 || !crypto */
 
 #else
@@ -1148,6 +1421,11 @@ void slow_hash_free_state(void)
   return;
 }
 
+int slow_hash_state_is_huge_page(void)
+{
+  return 0;
+}
+
 static void (*const extra_hashes[4])(const void *, size_t, char *) = {
   hash_extra_blake, hash_extra_groestl, hash_extra_jh, hash_extra_skein
 };
@@ -1210,7 +1488,7 @@ union cn_slow_hash_state {
 };
 #pragma pack(pop)
 
-void cn_slow_hash(const void *data, size_t length, char *hash) {
+static void cn_slow_hash_portable(const void *data, size_t length, char *hash) {
   uint8_t* long_state = (uint8_t*)malloc(MEMORY);
   union cn_slow_hash_state state;
   uint8_t text[INIT_SIZE_BYTE];
@@ -1282,4 +1560,90 @@ void cn_slow_hash(const void *data, size_t length, char *hash) {
   free(long_state);
 }
 
-#endif
\ No newline at end of file
+static const struct slow_hash_kernel_info slow_hash_kernels[] = {
+  { "portable", cn_slow_hash_portable, NULL }
+};
+
+static int slow_hash_default_kernel(void) {
+  return 0;
+}
+
+#endif
+
+#if defined NO_AES || !(defined(__x86_64__) || (defined(_MSC_VER) && defined(_WIN64)))
+void slow_hash_allocate_multi_state(void)
+{
+  // Only the AES-NI code path interleaves hashes and needs extra scratchpads
+  return;
+}
+
+void cn_slow_hash_multi(const void *const *data, const size_t *length, size_t count, char *hash)
+{
+  size_t i;
+  for (i = 0; i < count; i++)
+    cn_slow_hash(data[i], length[i], hash + i * HASH_SIZE);
+}
+#endif
+
+/* Resolved on first use, every thread resolves to the same kernel */
+static int slow_hash_active_kernel = -1;
+
+/**
+ * @brief the number of CryptoNight kernels compiled into this build
+ */
+
+int slow_hash_kernel_count(void)
+{
+    return (int) (sizeof(slow_hash_kernels) / sizeof(slow_hash_kernels[0]));
+}
+
+/**
+ * @return the name of 'kernel', or NULL if there is no such kernel
+ */
+
+const char *slow_hash_kernel_name(int kernel)
+{
+    if(kernel < 0 || kernel >= slow_hash_kernel_count())
+        return NULL;
+
+    return slow_hash_kernels[kernel].name;
+}
+
+/**
+ * @return 1 if 'kernel' exists and runs on this CPU, 0 otherwise
+ */
+
+int slow_hash_kernel_available(int kernel)
+{
+    if(kernel < 0 || kernel >= slow_hash_kernel_count())
+        return 0;
+
+    return slow_hash_kernels[kernel].available == NULL || slow_hash_kernels[kernel].available();
+}
+
+/**
+ * @return the kernel cn_slow_hash uses on this CPU
+ */
+
+int slow_hash_kernel(void)
+{
+    if(slow_hash_active_kernel < 0)
+        slow_hash_active_kernel = slow_hash_default_kernel();
+
+    return slow_hash_active_kernel;
+}
+
+/**
+ * @brief cn_slow_hash computed by the given kernel, which has to be available
+ */
+
+void cn_slow_hash_kernel(int kernel, const void *data, size_t length, char *hash)
+{
+    assert(slow_hash_kernel_available(kernel));
+    slow_hash_kernels[kernel].hash(data, length, hash);
+}
+
+void cn_slow_hash(const void *data, size_t length, char *hash)
+{
+    slow_hash_kernels[slow_hash_kernel()].hash(data, length, hash);
+}
@@ -28,6 +28,27 @@
 
 #include "hash-ops.h"
 
+/*
+ * out[j] = H(pairs[2j] || pairs[2j + 1]) for j < count, FAST_HASH_WAYS at a time.
+ * out may be pairs itself: a batch reads its pairs before its hashes are stored
+ * and never reads below 2j, so a level can be reduced in place.
+ */
+static void hash_pairs(const char (*pairs)[HASH_SIZE], size_t count, char (*out)[HASH_SIZE]) {
+  const void *data[FAST_HASH_WAYS];
+  size_t length[FAST_HASH_WAYS];
+  char hashes[FAST_HASH_WAYS][HASH_SIZE];
+  size_t i, j, ways;
+  for (i = 0; i < count; i += ways) {
+    ways = count - i < FAST_HASH_WAYS ? count - i : FAST_HASH_WAYS;
+    for (j = 0; j < ways; ++j) {
+      data[j] = pairs[2 * (i + j)];
+      length[j] = 2 * HASH_SIZE;
+    }
+    cn_fast_hash_multi(data, length, ways, hashes[0]);
+    memcpy(out[i], hashes, ways * HASH_SIZE);
+  }
+}
+
 void tree_hash(const char (*hashes)[HASH_SIZE], size_t count, char *root_hash) {
   assert(count > 0);
   if (count == 1) {
@@ -41,18 +62,16 @@ void tree_hash(const char (*hashes)[HASH_SIZE], size_t count, char *root_hash) {
       cnt |= cnt >> i;
     }
     cnt &= ~(cnt >> 1);
-    char *ints = calloc(cnt, HASH_SIZE);
+    char (*ints)[HASH_SIZE] = calloc(cnt, HASH_SIZE);
     assert(ints);
     memcpy(ints, hashes, (2 * cnt - count) * HASH_SIZE);
-    for (i = 2 * cnt - count, j = 2 * cnt - count; j < cnt; i += 2, ++j) {
-      cn_fast_hash(hashes[i], 2 * HASH_SIZE, ints + j * HASH_SIZE);
-    }
-    assert(i == count);
+    i = 2 * cnt - count;
+    j = 2 * cnt - count;
+    hash_pairs(hashes + i, cnt - j, ints + j);
+    assert(i + 2 * (cnt - j) == count);
     while (cnt > 2) {
       cnt >>= 1;
-      for (i = 0, j = 0; j < cnt; i += 2, ++j) {
-        cn_fast_hash(ints + i * HASH_SIZE, 2 * HASH_SIZE, ints + j * HASH_SIZE);
-      }
+      hash_pairs((const char (*)[HASH_SIZE]) ints, cnt, ints);
     }
     cn_fast_hash(ints, 2 * HASH_SIZE, root_hash);
     free(ints);
@@ -88,18 +107,16 @@ void tree_branch(const char (*hashes)[HASH_SIZE], size_t count, char (*branch)[H
   assert(depth == tree_depth(count));
   ints = alloca((cnt - 1) * HASH_SIZE);
   memcpy(ints, hashes + 1, (2 * cnt - count - 1) * HASH_SIZE);
-  for (i = 2 * cnt - count, j = 2 * cnt - count - 1; j < cnt - 1; i += 2, ++j) {
-    cn_fast_hash(hashes[i], 2 * HASH_SIZE, ints[j]);
-  }
-  assert(i == count);
+  i = 2 * cnt - count;
+  j = 2 * cnt - count - 1;
+  hash_pairs(hashes + i, cnt - 1 - j, ints + j);
+  assert(i + 2 * (cnt - 1 - j) == count);
   while (depth > 0) {
     assert(cnt == 1ULL << depth);
     cnt >>= 1;
     --depth;
     memcpy(branch[depth], ints[0], HASH_SIZE);
-    for (i = 1, j = 0; j < cnt - 1; i += 2, ++j) {
-      cn_fast_hash(ints[i], 2 * HASH_SIZE, ints[j]);
-    }
+    hash_pairs((const char (*)[HASH_SIZE]) ints + 1, cnt - 1, ints);
   }
 }
 
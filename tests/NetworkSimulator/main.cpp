@@ -0,0 +1,767 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+// Simulates block and transaction relay between many nodes connected by links
+// with latency and a limited upload bandwidth per node, and reports how fast
+// blocks and transactions spread, how many blocks go stale and how much each
+// node sends. Message sizes are those of the protocol messages as the node
+// encodes them, block and transaction checks are modelled as fixed delays.
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <queue>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <boost/program_options.hpp>
+
+#include "Common/CommandLine.h"
+#include "CryptoNoteConfig.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteProtocol/CryptoNoteProtocolDefinitions.h"
+#include "P2p/LevinProtocol.h"
+
+namespace po = boost::program_options;
+
+namespace {
+
+const command_line::arg_descriptor<uint32_t> arg_nodes = { "nodes", "Number of simulated nodes", 50 };
+const command_line::arg_descriptor<uint32_t> arg_peers = { "peers", "Outgoing connections of each node", 8 };
+const command_line::arg_descriptor<uint32_t> arg_min_latency = { "min-latency", "Lowest one-way link latency, ms", 20 };
+const command_line::arg_descriptor<uint32_t> arg_max_latency = { "max-latency", "Highest one-way link latency, ms", 200 };
+const command_line::arg_descriptor<uint32_t> arg_upload = { "upload", "Upload bandwidth of each node, kB/s", 1000 };
+const command_line::arg_descriptor<uint32_t> arg_duration = { "duration", "Simulated time, s", 3600 };
+const command_line::arg_descriptor<uint32_t> arg_block_interval = { "block-interval", "Average time between blocks, s", static_cast<uint32_t>(CryptoNote::parameters::DIFFICULTY_TARGET) };
+const command_line::arg_descriptor<double> arg_tx_rate = { "tx-rate", "Transactions created per second over the whole network", 1.0 };
+const command_line::arg_descriptor<uint32_t> arg_tx_size = { "tx-size", "Size of a transaction, bytes", 1500 };
+const command_line::arg_descriptor<uint32_t> arg_block_check = { "block-check", "Time to check a block, ms", 50 };
+const command_line::arg_descriptor<uint32_t> arg_tx_check = { "tx-check", "Time to check a transaction, ms", 2 };
+const command_line::arg_descriptor<std::string> arg_block_relay = { "block-relay", "Block relay: full, lite or compact", "compact" };
+const command_line::arg_descriptor<std::string> arg_tx_relay = { "tx-relay", "Transaction relay: push or inventory", "inventory" };
+const command_line::arg_descriptor<uint32_t> arg_seed = { "seed", "Seed of the random topology and load", 1 };
+
+typedef uint64_t Time; // microseconds of simulated time
+
+const Time MICROSECONDS_PER_MS = 1000;
+const Time MICROSECONDS_PER_SECOND = 1000000;
+// events still in flight when the load stops are given this long to settle
+const Time DRAIN_TIME = 120 * MICROSECONDS_PER_SECOND;
+// the Levin bucket header in front of every message
+const uint64_t LEVIN_HEADER_SIZE = 33;
+// a block header with its base transaction, without the transaction hashes
+const uint64_t BLOCK_TEMPLATE_SIZE = 250;
+const uint32_t NO_BLOCK = std::numeric_limits<uint32_t>::max();
+
+enum class BlockRelay { FULL, LITE, COMPACT };
+enum class TxRelay { PUSH, INVENTORY };
+
+enum MessageKind {
+  MESSAGE_NEW_TRANSACTIONS,
+  MESSAGE_TX_INVENTORY,
+  MESSAGE_REQUEST_TXS,
+  MESSAGE_RESPONSE_TXS,
+  MESSAGE_NEW_BLOCK,
+  MESSAGE_NEW_LITE_BLOCK,
+  MESSAGE_MISSING_TXS,
+  MESSAGE_NEW_COMPACT_BLOCK,
+  MESSAGE_REQUEST_COMPACT_TXS,
+  MESSAGE_BLOCK_TXS,
+  MESSAGE_KIND_COUNT
+};
+
+const char* const MESSAGE_NAMES[MESSAGE_KIND_COUNT] = {
+  "NOTIFY_NEW_TRANSACTIONS",
+  "NOTIFY_TX_INVENTORY",
+  "NOTIFY_REQUEST_TXS",
+  "NOTIFY_RESPONSE_TXS",
+  "NOTIFY_NEW_BLOCK",
+  "NOTIFY_NEW_LITE_BLOCK",
+  "NOTIFY_MISSING_TXS",
+  "NOTIFY_NEW_COMPACT_BLOCK",
+  "NOTIFY_REQUEST_COMPACT_TXS",
+  "missing block transactions"
+};
+
+// Encodes a message of each kind once per object count, with payloads of the configured sizes.
+class MessageSizes {
+public:
+  explicit MessageSizes(uint64_t txSize) : m_txSize(txSize) {
+  }
+
+  uint64_t size(MessageKind kind, size_t count) {
+    auto key = std::make_pair(kind, count);
+    auto it = m_sizes.find(key);
+    if (it == m_sizes.end()) {
+      it = m_sizes.emplace(key, LEVIN_HEADER_SIZE + encode(kind, count)).first;
+    }
+
+    return it->second;
+  }
+
+private:
+  uint64_t encode(MessageKind kind, size_t count) const {
+    using namespace CryptoNote;
+
+    std::vector<std::string> txs(count, std::string(m_txSize, '\x01'));
+    std::vector<Crypto::Hash> hashes(count, Crypto::Hash());
+    std::string block(BLOCK_TEMPLATE_SIZE + count * sizeof(Crypto::Hash), '\x01');
+
+    switch (kind) {
+    case MESSAGE_NEW_TRANSACTIONS:
+    case MESSAGE_RESPONSE_TXS:
+    case MESSAGE_BLOCK_TXS: {
+      NOTIFY_NEW_TRANSACTIONS::request request;
+      request.txs = std::move(txs);
+      return LevinProtocol::encode(request).size();
+    }
+    case MESSAGE_TX_INVENTORY:
+    case MESSAGE_REQUEST_TXS: {
+      NOTIFY_TX_INVENTORY::request request;
+      request.txs = std::move(hashes);
+      return LevinProtocol::encode(request).size();
+    }
+    case MESSAGE_NEW_BLOCK: {
+      NOTIFY_NEW_BLOCK::request request;
+      request.b.block = std::move(block);
+      request.b.txs = std::move(txs);
+      request.current_blockchain_height = 0;
+      request.hop = 0;
+      return LevinProtocol::encode(request).size();
+    }
+    case MESSAGE_NEW_LITE_BLOCK: {
+      NOTIFY_NEW_LITE_BLOCK::request request;
+      request.block = std::move(block);
+      request.current_blockchain_height = 0;
+      request.hop = 0;
+      return LevinProtocol::encode(request).size();
+    }
+    case MESSAGE_MISSING_TXS: {
+      NOTIFY_MISSING_TXS::request request;
+      request.current_blockchain_height = 0;
+      request.missing_txs = std::move(hashes);
+      return LevinProtocol::encode(request).size();
+    }
+    case MESSAGE_NEW_COMPACT_BLOCK: {
+      NOTIFY_NEW_COMPACT_BLOCK::request request;
+      request.block.assign(BLOCK_TEMPLATE_SIZE, '\x01');
+      request.nonce = 0;
+      request.short_ids.assign(count * COMPACT_BLOCK_SHORT_ID_SIZE, '\x01');
+      request.current_blockchain_height = 0;
+      request.hop = 0;
+      return LevinProtocol::encode(request).size();
+    }
+    case MESSAGE_REQUEST_COMPACT_TXS: {
+      NOTIFY_REQUEST_COMPACT_TXS::request request;
+      request.current_blockchain_height = 0;
+      request.indexes.assign(count, 0);
+      return LevinProtocol::encode(request).size();
+    }
+    default:
+      assert(false);
+      return 0;
+    }
+  }
+
+  uint64_t m_txSize;
+  std::map<std::pair<MessageKind, size_t>, uint64_t> m_sizes;
+};
+
+struct Config {
+  uint32_t nodes;
+  uint32_t peers;
+  Time minLatency;
+  Time maxLatency;
+  uint64_t uploadBytesPerSecond;
+  Time duration;
+  Time blockInterval;
+  double txRate;
+  uint32_t txSize;
+  Time blockCheck;
+  Time txCheck;
+  BlockRelay blockRelay;
+  TxRelay txRelay;
+  uint32_t seed;
+};
+
+struct Block {
+  uint32_t parent;
+  uint32_t height;
+  Time created;
+  std::vector<uint32_t> txs;
+};
+
+struct Link {
+  size_t peer;
+  size_t reverse;                             // index of the link back in the peer's links
+  Time latency;
+  std::unordered_set<uint32_t> knownTxs;      // sent to the peer or received from it
+  std::unordered_set<uint32_t> knownBlocks;
+};
+
+struct Node {
+  std::vector<Link> links;
+  std::vector<size_t> relayOrder;             // links by latency, blocks go to the closest peers first
+  Time uploadFreeAt = 0;
+  std::unordered_set<uint32_t> txs;           // received, checked or not
+  std::unordered_set<uint32_t> requestedTxs;
+  std::set<uint32_t> pool;
+  std::vector<uint32_t> inventory;            // checked transactions waiting for the next announcement
+  std::unordered_set<uint32_t> blocks;        // accepted
+  std::unordered_set<uint32_t> pendingBlocks; // being completed or checked
+  std::unordered_map<uint32_t, std::vector<uint32_t>> waitingForParent;
+  uint32_t tip = 0;
+  uint64_t sent = 0;
+  uint64_t received = 0;
+};
+
+class Simulator {
+public:
+  explicit Simulator(const Config& config) :
+    m_config(config), m_sizes(config.txSize), m_random(config.seed), m_nodes(config.nodes) {
+    m_sentByKind.fill(0);
+    m_blocks.push_back(Block{ NO_BLOCK, 0, 0, {} });
+    for (auto& node : m_nodes) {
+      node.blocks.insert(0);
+    }
+
+    connect();
+  }
+
+  void run() {
+    scheduleBlock();
+    scheduleTransaction();
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+      scheduleInventory(i, std::uniform_int_distribution<Time>(0, CryptoNote::P2P_TX_INVENTORY_INTERVAL * MICROSECONDS_PER_SECOND)(m_random));
+    }
+
+    while (!m_events.empty() && m_events.top().time <= m_config.duration + DRAIN_TIME) {
+      Event event = m_events.top();
+      m_events.pop();
+      m_now = event.time;
+      event.action();
+    }
+  }
+
+  void report(std::ostream& out) const {
+    size_t links = 0;
+    for (const auto& node : m_nodes) {
+      links += node.links.size();
+    }
+
+    double seconds = static_cast<double>(m_config.duration) / MICROSECONDS_PER_SECOND;
+    out << std::fixed << std::setprecision(1);
+    out << "Simulated " << seconds << " s, " << m_nodes.size() << " nodes, " << links / 2 << " connections" << std::endl;
+    out << "  blocks           " << m_blocks.size() - 1 << ", stale " << staleBlocks() << " (" <<
+      (m_blocks.size() > 1 ? 100.0 * staleBlocks() / (m_blocks.size() - 1) : 0.0) << "%)" << std::endl;
+    out << "  transactions     " << m_txCreated.size() << std::endl;
+    printPercentiles(out, "Block arrival after mining, ms:", m_blockDelays);
+    printPercentiles(out, "Transaction arrival after creation, ms:", m_txDelays);
+
+    std::vector<uint64_t> sent;
+    std::vector<uint64_t> received;
+    for (const auto& node : m_nodes) {
+      sent.push_back(node.sent);
+      received.push_back(node.received);
+    }
+
+    out << "Per node traffic, kB/s:" << std::endl;
+    printRange(out, "  upload          ", sent, seconds);
+    printRange(out, "  download        ", received, seconds);
+    out << "Traffic by message, MB:" << std::endl;
+    for (size_t kind = 0; kind < MESSAGE_KIND_COUNT; ++kind) {
+      if (m_sentByKind[kind] != 0) {
+        out << "  " << std::left << std::setw(30) << MESSAGE_NAMES[kind] << std::right << m_sentByKind[kind] / 1e6 << std::endl;
+      }
+    }
+  }
+
+private:
+  struct Event {
+    Time time;
+    uint64_t sequence;
+    std::function<void()> action;
+
+    bool operator>(const Event& other) const {
+      return time != other.time ? time > other.time : sequence > other.sequence;
+    }
+  };
+
+  void connect() {
+    std::uniform_int_distribution<size_t> nodeDistribution(0, m_nodes.size() - 1);
+    std::uniform_int_distribution<Time> latencyDistribution(m_config.minLatency, std::max(m_config.minLatency, m_config.maxLatency));
+    std::set<std::pair<size_t, size_t>> connected;
+    size_t peers = std::min<size_t>(m_config.peers, m_nodes.size() - 1);
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+      size_t outgoing = 0;
+      while (outgoing < peers) {
+        size_t peer = nodeDistribution(m_random);
+        if (peer == i || !connected.insert(std::minmax(i, peer)).second) {
+          // with few nodes the peers may already be connected from the other side
+          if (connected.size() * 2 >= m_nodes.size() * (m_nodes.size() - 1)) {
+            break;
+          }
+
+          continue;
+        }
+
+        Time latency = latencyDistribution(m_random) * MICROSECONDS_PER_MS;
+        Link forward = { peer, m_nodes[peer].links.size(), latency, {}, {} };
+        Link back = { i, m_nodes[i].links.size(), latency, {}, {} };
+        m_nodes[i].links.push_back(std::move(forward));
+        m_nodes[peer].links.push_back(std::move(back));
+        ++outgoing;
+      }
+    }
+
+    for (auto& node : m_nodes) {
+      node.relayOrder.resize(node.links.size());
+      for (size_t i = 0; i < node.links.size(); ++i) {
+        node.relayOrder[i] = i;
+      }
+
+      std::sort(node.relayOrder.begin(), node.relayOrder.end(), [&node](size_t a, size_t b) {
+        return node.links[a].latency < node.links[b].latency;
+      });
+    }
+  }
+
+  void schedule(Time time, std::function<void()>&& action) {
+    m_events.push(Event{ time, m_sequence++, std::move(action) });
+  }
+
+  // The message waits for the sender's upload link, then arrives after the link latency.
+  // The handler gets the receiving node and the index of its link back to the sender.
+  void send(size_t from, size_t linkIndex, MessageKind kind, size_t count, std::function<void(size_t, size_t)>&& onArrival) {
+    Node& node = m_nodes[from];
+    const Link& link = node.links[linkIndex];
+    uint64_t bytes = m_sizes.size(kind, count);
+    Time start = std::max(m_now, node.uploadFreeAt);
+    node.uploadFreeAt = start + bytes * MICROSECONDS_PER_SECOND / m_config.uploadBytesPerSecond;
+    node.sent += bytes;
+    m_sentByKind[kind] += bytes;
+
+    size_t to = link.peer;
+    size_t back = link.reverse;
+    schedule(node.uploadFreeAt + link.latency, [this, to, back, bytes, onArrival] {
+      m_nodes[to].received += bytes;
+      onArrival(to, back);
+    });
+  }
+
+  void scheduleTransaction() {
+    if (m_config.txRate <= 0) {
+      return;
+    }
+
+    Time time = m_now + static_cast<Time>(std::exponential_distribution<double>(m_config.txRate)(m_random) * MICROSECONDS_PER_SECOND);
+    if (time >= m_config.duration) {
+      return;
+    }
+
+    schedule(time, [this] {
+      uint32_t tx = static_cast<uint32_t>(m_txCreated.size());
+      m_txCreated.push_back(m_now);
+      size_t origin = std::uniform_int_distribution<size_t>(0, m_nodes.size() - 1)(m_random);
+      m_nodes[origin].txs.insert(tx);
+      acceptTransaction(origin, tx);
+      scheduleTransaction();
+    });
+  }
+
+  void receiveTransaction(size_t to, uint32_t tx) {
+    Node& node = m_nodes[to];
+    node.requestedTxs.erase(tx);
+    if (!node.txs.insert(tx).second) {
+      return;
+    }
+
+    m_txDelays.push_back(m_now - m_txCreated[tx]);
+    schedule(m_now + m_config.txCheck, [this, to, tx] {
+      acceptTransaction(to, tx);
+    });
+  }
+
+  void acceptTransaction(size_t nodeIndex, uint32_t tx) {
+    Node& node = m_nodes[nodeIndex];
+    if (m_txBlocks.count(tx) != 0 && isInChain(node, m_txBlocks[tx])) {
+      return;
+    }
+
+    node.pool.insert(tx);
+    if (m_config.txRelay == TxRelay::INVENTORY) {
+      node.inventory.push_back(tx);
+      return;
+    }
+
+    for (size_t i = 0; i < node.links.size(); ++i) {
+      if (node.links[i].knownTxs.insert(tx).second) {
+        send(nodeIndex, i, MESSAGE_NEW_TRANSACTIONS, 1, [this, tx](size_t to, size_t back) {
+          m_nodes[to].links[back].knownTxs.insert(tx);
+          receiveTransaction(to, tx);
+        });
+      }
+    }
+  }
+
+  void scheduleInventory(size_t nodeIndex, Time time) {
+    if (m_config.txRelay != TxRelay::INVENTORY || time >= m_config.duration + DRAIN_TIME) {
+      return;
+    }
+
+    schedule(time, [this, nodeIndex] {
+      announceInventory(nodeIndex);
+      scheduleInventory(nodeIndex, m_now + CryptoNote::P2P_TX_INVENTORY_INTERVAL * MICROSECONDS_PER_SECOND);
+    });
+  }
+
+  void announceInventory(size_t nodeIndex) {
+    Node& node = m_nodes[nodeIndex];
+    std::vector<uint32_t> inventory;
+    inventory.swap(node.inventory);
+    if (inventory.empty()) {
+      return;
+    }
+
+    for (size_t i = 0; i < node.links.size(); ++i) {
+      std::vector<uint32_t> announced;
+      for (uint32_t tx : inventory) {
+        if (node.links[i].knownTxs.insert(tx).second) {
+          announced.push_back(tx);
+        }
+      }
+
+      if (!announced.empty()) {
+        size_t count = announced.size();
+        send(nodeIndex, i, MESSAGE_TX_INVENTORY, count, [this, announced](size_t to, size_t back) {
+          receiveInventory(to, back, announced);
+        });
+      }
+    }
+  }
+
+  void receiveInventory(size_t nodeIndex, size_t linkIndex, const std::vector<uint32_t>& announced) {
+    Node& node = m_nodes[nodeIndex];
+    std::vector<uint32_t> wanted;
+    for (uint32_t tx : announced) {
+      node.links[linkIndex].knownTxs.insert(tx);
+      if (node.txs.count(tx) == 0 && node.requestedTxs.insert(tx).second) {
+        wanted.push_back(tx);
+      }
+    }
+
+    if (wanted.empty()) {
+      return;
+    }
+
+    size_t count = wanted.size();
+    send(nodeIndex, linkIndex, MESSAGE_REQUEST_TXS, count, [this, wanted](size_t to, size_t back) {
+      size_t count = wanted.size();
+      send(to, back, MESSAGE_RESPONSE_TXS, count, [this, wanted](size_t to, size_t) {
+        for (uint32_t tx : wanted) {
+          receiveTransaction(to, tx);
+        }
+      });
+    });
+  }
+
+  void scheduleBlock() {
+    Time time = m_now + static_cast<Time>(std::exponential_distribution<double>(1.0)(m_random) * m_config.blockInterval);
+    if (time >= m_config.duration) {
+      return;
+    }
+
+    schedule(time, [this] {
+      size_t miner = std::uniform_int_distribution<size_t>(0, m_nodes.size() - 1)(m_random);
+      Node& node = m_nodes[miner];
+      uint32_t id = static_cast<uint32_t>(m_blocks.size());
+      m_blocks.push_back(Block{ node.tip, m_blocks[node.tip].height + 1, m_now, std::vector<uint32_t>(node.pool.begin(), node.pool.end()) });
+      for (uint32_t tx : m_blocks[id].txs) {
+        m_txBlocks.emplace(tx, id);
+      }
+
+      node.pendingBlocks.insert(id);
+      acceptBlock(miner, id);
+      scheduleBlock();
+    });
+  }
+
+  void relayBlock(size_t nodeIndex, uint32_t id) {
+    Node& node = m_nodes[nodeIndex];
+    size_t count = m_blocks[id].txs.size();
+    for (size_t i : node.relayOrder) {
+      if (!node.links[i].knownBlocks.insert(id).second) {
+        continue;
+      }
+
+      switch (m_config.blockRelay) {
+      case BlockRelay::FULL:
+        send(nodeIndex, i, MESSAGE_NEW_BLOCK, count, [this, id](size_t to, size_t back) {
+          for (uint32_t tx : m_blocks[id].txs) {
+            if (m_nodes[to].txs.insert(tx).second) {
+              m_txDelays.push_back(m_now - m_txCreated[tx]);
+            }
+          }
+
+          receiveBlock(to, back, id, MESSAGE_KIND_COUNT);
+        });
+        break;
+      case BlockRelay::LITE:
+        send(nodeIndex, i, MESSAGE_NEW_LITE_BLOCK, count, [this, id](size_t to, size_t back) {
+          receiveBlock(to, back, id, MESSAGE_MISSING_TXS);
+        });
+        break;
+      case BlockRelay::COMPACT:
+        send(nodeIndex, i, MESSAGE_NEW_COMPACT_BLOCK, count, [this, id](size_t to, size_t back) {
+          receiveBlock(to, back, id, MESSAGE_REQUEST_COMPACT_TXS);
+        });
+        break;
+      }
+    }
+  }
+
+  // request is the message asking the sender for the transactions the node lacks
+  void receiveBlock(size_t nodeIndex, size_t linkIndex, uint32_t id, MessageKind request) {
+    Node& node = m_nodes[nodeIndex];
+    node.links[linkIndex].knownBlocks.insert(id);
+    if (node.blocks.count(id) != 0 || !node.pendingBlocks.insert(id).second) {
+      return;
+    }
+
+    std::vector<uint32_t> missing;
+    if (request != MESSAGE_KIND_COUNT) {
+      for (uint32_t tx : m_blocks[id].txs) {
+        if (node.txs.count(tx) == 0) {
+          missing.push_back(tx);
+        }
+      }
+    }
+
+    if (missing.empty()) {
+      checkBlock(nodeIndex, id, 0);
+      return;
+    }
+
+    size_t count = missing.size();
+    send(nodeIndex, linkIndex, request, count, [this, id, missing](size_t to, size_t back) {
+      size_t count = missing.size();
+      send(to, back, MESSAGE_BLOCK_TXS, count, [this, id, missing](size_t to, size_t) {
+        for (uint32_t tx : missing) {
+          if (m_nodes[to].txs.insert(tx).second) {
+            m_txDelays.push_back(m_now - m_txCreated[tx]);
+          }
+        }
+
+        checkBlock(to, id, missing.size());
+      });
+    });
+  }
+
+  void checkBlock(size_t nodeIndex, uint32_t id, size_t uncheckedTxs) {
+    schedule(m_now + m_config.blockCheck + uncheckedTxs * m_config.txCheck, [this, nodeIndex, id] {
+      acceptBlock(nodeIndex, id);
+    });
+  }
+
+  void acceptBlock(size_t nodeIndex, uint32_t id) {
+    Node& node = m_nodes[nodeIndex];
+    const Block& block = m_blocks[id];
+    if (node.blocks.count(block.parent) == 0) {
+      node.waitingForParent[block.parent].push_back(id);
+      return;
+    }
+
+    node.pendingBlocks.erase(id);
+    node.blocks.insert(id);
+    if (m_now != block.created) {
+      m_blockDelays.push_back(m_now - block.created);
+    }
+
+    for (uint32_t tx : block.txs) {
+      node.txs.insert(tx);
+      node.pool.erase(tx);
+    }
+
+    // the first block seen wins at equal height
+    if (block.height > m_blocks[node.tip].height) {
+      node.tip = id;
+    }
+
+    relayBlock(nodeIndex, id);
+
+    auto waiting = node.waitingForParent.find(id);
+    if (waiting != node.waitingForParent.end()) {
+      std::vector<uint32_t> children = std::move(waiting->second);
+      node.waitingForParent.erase(waiting);
+      for (uint32_t child : children) {
+        acceptBlock(nodeIndex, child);
+      }
+    }
+  }
+
+  bool isInChain(const Node& node, uint32_t id) const {
+    uint32_t height = m_blocks[id].height;
+    uint32_t block = node.tip;
+    while (block != NO_BLOCK && m_blocks[block].height > height) {
+      block = m_blocks[block].parent;
+    }
+
+    return block == id;
+  }
+
+  size_t staleBlocks() const {
+    uint32_t best = 0;
+    for (const auto& node : m_nodes) {
+      if (m_blocks[node.tip].height > m_blocks[best].height) {
+        best = node.tip;
+      }
+    }
+
+    return m_blocks.size() - 1 - m_blocks[best].height;
+  }
+
+  static void printPercentiles(std::ostream& out, const std::string& title, std::vector<Time> samples) {
+    out << title << std::endl;
+    if (samples.empty()) {
+      out << "  no samples" << std::endl;
+      return;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    for (size_t percentile : { 50, 90, 99, 100 }) {
+      size_t index = std::min(samples.size() - 1, percentile * samples.size() / 100);
+      out << "  p" << std::left << std::setw(15) << percentile << std::right << static_cast<double>(samples[index]) / MICROSECONDS_PER_MS << std::endl;
+    }
+  }
+
+  static void printRange(std::ostream& out, const std::string& title, std::vector<uint64_t> values, double seconds) {
+    std::sort(values.begin(), values.end());
+    out << title << "min " << values.front() / seconds / 1000 << ", median " << values[values.size() / 2] / seconds / 1000 <<
+      ", max " << values.back() / seconds / 1000 << std::endl;
+  }
+
+  Config m_config;
+  MessageSizes m_sizes;
+  std::mt19937_64 m_random;
+  std::vector<Node> m_nodes;
+  std::vector<Block> m_blocks;
+  std::vector<Time> m_txCreated;
+  std::unordered_map<uint32_t, uint32_t> m_txBlocks;  // the first block that took a transaction
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> m_events;
+  uint64_t m_sequence = 0;
+  Time m_now = 0;
+  std::vector<Time> m_blockDelays;
+  std::vector<Time> m_txDelays;
+  std::array<uint64_t, MESSAGE_KIND_COUNT> m_sentByKind;
+};
+
+}
+
+int main(int argc, char* argv[]) {
+  po::options_description desc_options("Allowed options");
+  command_line::add_arg(desc_options, command_line::arg_help);
+  command_line::add_arg(desc_options, arg_nodes);
+  command_line::add_arg(desc_options, arg_peers);
+  command_line::add_arg(desc_options, arg_min_latency);
+  command_line::add_arg(desc_options, arg_max_latency);
+  command_line::add_arg(desc_options, arg_upload);
+  command_line::add_arg(desc_options, arg_duration);
+  command_line::add_arg(desc_options, arg_block_interval);
+  command_line::add_arg(desc_options, arg_tx_rate);
+  command_line::add_arg(desc_options, arg_tx_size);
+  command_line::add_arg(desc_options, arg_block_check);
+  command_line::add_arg(desc_options, arg_tx_check);
+  command_line::add_arg(desc_options, arg_block_relay);
+  command_line::add_arg(desc_options, arg_tx_relay);
+  command_line::add_arg(desc_options, arg_seed);
+
+  po::variables_map vm;
+  bool r = command_line::handle_error_helper(desc_options, [&]() {
+    po::store(po::parse_command_line(argc, argv, desc_options), vm);
+    po::notify(vm);
+    return true;
+  });
+
+  if (!r) {
+    return 1;
+  }
+
+  if (command_line::get_arg(vm, command_line::arg_help)) {
+    std::cout << desc_options << std::endl;
+    return 0;
+  }
+
+  Config config;
+  config.nodes = command_line::get_arg(vm, arg_nodes);
+  config.peers = command_line::get_arg(vm, arg_peers);
+  config.minLatency = command_line::get_arg(vm, arg_min_latency);
+  config.maxLatency = command_line::get_arg(vm, arg_max_latency);
+  config.uploadBytesPerSecond = static_cast<uint64_t>(command_line::get_arg(vm, arg_upload)) * 1000;
+  config.duration = command_line::get_arg(vm, arg_duration) * MICROSECONDS_PER_SECOND;
+  config.blockInterval = command_line::get_arg(vm, arg_block_interval) * MICROSECONDS_PER_SECOND;
+  config.txRate = command_line::get_arg(vm, arg_tx_rate);
+  config.txSize = command_line::get_arg(vm, arg_tx_size);
+  config.blockCheck = command_line::get_arg(vm, arg_block_check) * MICROSECONDS_PER_MS;
+  config.txCheck = command_line::get_arg(vm, arg_tx_check) * MICROSECONDS_PER_MS;
+  config.seed = command_line::get_arg(vm, arg_seed);
+
+  std::string blockRelay = command_line::get_arg(vm, arg_block_relay);
+  if (blockRelay == "full") {
+    config.blockRelay = BlockRelay::FULL;
+  } else if (blockRelay == "lite") {
+    config.blockRelay = BlockRelay::LITE;
+  } else if (blockRelay == "compact") {
+    config.blockRelay = BlockRelay::COMPACT;
+  } else {
+    std::cout << "Unknown block relay " << blockRelay << std::endl;
+    return 1;
+  }
+
+  std::string txRelay = command_line::get_arg(vm, arg_tx_relay);
+  if (txRelay == "push") {
+    config.txRelay = TxRelay::PUSH;
+  } else if (txRelay == "inventory") {
+    config.txRelay = TxRelay::INVENTORY;
+  } else {
+    std::cout << "Unknown transaction relay " << txRelay << std::endl;
+    return 1;
+  }
+
+  if (config.nodes < 2 || config.peers == 0 || config.uploadBytesPerSecond == 0 || config.blockInterval == 0) {
+    std::cout << "At least two connected nodes with a nonzero upload and block interval are needed" << std::endl;
+    return 1;
+  }
+
+  try {
+    Simulator simulator(config);
+    simulator.run();
+    std::cout << "Block relay " << blockRelay << ", transaction relay " << txRelay << std::endl;
+    simulator.report(std::cout);
+  } catch (std::exception& e) {
+    std::cout << "Exception: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
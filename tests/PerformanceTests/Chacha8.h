@@ -0,0 +1,49 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <string>
+
+#include "crypto/chacha8.h"
+
+// size is in bytes: 72 is a container key record, the larger ones are wallet cache chunks
+template<size_t size>
+class test_chacha8 {
+public:
+  static const size_t loop_count = size < 65536 ? 10000 : 100;
+
+  bool init() {
+    m_data.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+      m_data[i] = static_cast<char>(i * 37 + 11);
+    }
+
+    m_key = Crypto::chacha8_key{ {1, 2, 3, 4, 5, 6, 7, 8} };
+    m_iv = Crypto::chacha8_iv{ {9, 10, 11, 12, 13, 14, 15, 16} };
+    return true;
+  }
+
+  bool test() {
+    Crypto::chacha8(m_data.data(), m_data.size(), m_key, m_iv, &m_data[0]);
+    return true;
+  }
+
+private:
+  std::string m_data;
+  Crypto::chacha8_key m_key;
+  Crypto::chacha8_iv m_iv;
+};
@@ -50,7 +50,8 @@ public:
     std::vector<TransactionDestinationEntry> destinations;
     destinations.push_back(TransactionDestinationEntry(this->m_source_amount, m_alice.getAccountKeys().address));
 
-    if (!constructTransaction(this->m_miners[this->real_source_idx].getAccountKeys(), this->m_sources, destinations, std::vector<uint8_t>(), m_tx, 0, this->m_logger))
+    Crypto::SecretKey txKey;
+    if (!constructTransaction(this->m_miners[this->real_source_idx].getAccountKeys(), this->m_sources, destinations, std::vector<uint8_t>(), m_tx, 0, txKey, this->m_logger))
       return false;
 
     getObjectHash(*static_cast<TransactionPrefix*>(&m_tx), m_tx_prefix_hash);
@@ -64,8 +65,48 @@ public:
     return Crypto::check_ring_signature(m_tx_prefix_hash, txin.keyImage, this->m_public_key_ptrs, ring_size, m_tx.signatures[0].data());
   }
 
+protected:
+  const CryptoNote::Transaction& tx() const { return m_tx; }
+  const Crypto::Hash& txPrefixHash() const { return m_tx_prefix_hash; }
+  const Crypto::PublicKey* const* publicKeys() const { return this->m_public_key_ptrs; }
+
 private:
   CryptoNote::AccountBase m_alice;
   CryptoNote::Transaction m_tx;
   Crypto::Hash m_tx_prefix_hash;
 };
+
+template<size_t a_ring_size>
+class test_check_ring_signature_precomp : private test_check_ring_signature<a_ring_size>
+{
+public:
+  static const size_t loop_count = test_check_ring_signature<a_ring_size>::loop_count;
+  static const size_t ring_size = a_ring_size;
+
+  typedef test_check_ring_signature<a_ring_size> base_class;
+
+  bool init()
+  {
+    if (!base_class::init())
+      return false;
+
+    for (size_t i = 0; i < ring_size; ++i) {
+      if (!Crypto::precompute_ring_member(*this->publicKeys()[i], m_precomps[i]))
+        return false;
+
+      m_precomp_ptrs[i] = &m_precomps[i];
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    const CryptoNote::KeyInput& txin = boost::get<CryptoNote::KeyInput>(this->tx().inputs[0]);
+    return Crypto::check_ring_signature(this->txPrefixHash(), txin.keyImage, m_precomp_ptrs, ring_size, this->tx().signatures[0].data());
+  }
+
+private:
+  Crypto::RingMemberPrecomp m_precomps[ring_size];
+  const Crypto::RingMemberPrecomp* m_precomp_ptrs[ring_size];
+};
@@ -0,0 +1,115 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vector>
+
+#include "crypto/hash.h"
+
+// Hashes FAST_HASH_WAYS messages of 'size' bytes one by one, compare with test_cn_fast_hash_multi
+template<size_t size>
+class test_cn_fast_hash {
+public:
+  static const size_t loop_count = 10000;
+
+  bool init() {
+    m_data.resize(Crypto::FAST_HASH_WAYS * size);
+    for (size_t i = 0; i < m_data.size(); ++i) {
+      m_data[i] = static_cast<uint8_t>(i * 37 + 11);
+    }
+
+    for (size_t i = 0; i < Crypto::FAST_HASH_WAYS; ++i) {
+      Crypto::cn_fast_hash(m_data.data() + i * size, size, m_expected[i]);
+    }
+
+    return true;
+  }
+
+  bool test() {
+    for (size_t i = 0; i < Crypto::FAST_HASH_WAYS; ++i) {
+      Crypto::Hash hash;
+      Crypto::cn_fast_hash(m_data.data() + i * size, size, hash);
+      if (hash != m_expected[i]) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+protected:
+  std::vector<uint8_t> m_data;
+  Crypto::Hash m_expected[Crypto::FAST_HASH_WAYS];
+};
+
+template<size_t size>
+class test_cn_fast_hash_multi : public test_cn_fast_hash<size> {
+public:
+  bool init() {
+    if (!test_cn_fast_hash<size>::init()) {
+      return false;
+    }
+
+    for (size_t i = 0; i < Crypto::FAST_HASH_WAYS; ++i) {
+      m_inputs[i] = this->m_data.data() + i * size;
+      m_lengths[i] = size;
+    }
+
+    return true;
+  }
+
+  bool test() {
+    Crypto::Hash hashes[Crypto::FAST_HASH_WAYS];
+    Crypto::cn_fast_hash_multi(m_inputs, m_lengths, Crypto::FAST_HASH_WAYS, hashes);
+    for (size_t i = 0; i < Crypto::FAST_HASH_WAYS; ++i) {
+      if (hashes[i] != this->m_expected[i]) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+private:
+  const void* m_inputs[Crypto::FAST_HASH_WAYS];
+  size_t m_lengths[Crypto::FAST_HASH_WAYS];
+};
+
+template<size_t count>
+class test_tree_hash {
+public:
+  static const size_t loop_count = 10000;
+
+  bool init() {
+    m_hashes.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      m_hashes[i] = Crypto::cn_fast_hash(&i, sizeof(i));
+    }
+
+    return true;
+  }
+
+  bool test() {
+    Crypto::Hash root;
+    Crypto::tree_hash(m_hashes.data(), m_hashes.size(), root);
+    return root != Crypto::Hash();
+  }
+
+private:
+  std::vector<Crypto::Hash> m_hashes;
+};
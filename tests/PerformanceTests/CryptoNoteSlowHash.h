@@ -52,8 +52,58 @@ public:
     return hash == m_expected_hash;
   }
 
-private:
+protected:
   data_t m_data;
   Crypto::Hash m_expected_hash;
   Crypto::cn_context m_context;
 };
+
+template<size_t ways>
+class test_cn_slow_hash_multi : public test_cn_slow_hash {
+public:
+  static_assert(ways > 0 && ways <= Crypto::SLOW_HASH_MAX_WAYS, "Invalid ways count");
+
+  bool init() {
+    if (!test_cn_slow_hash::init()) {
+      return false;
+    }
+
+    for (size_t i = 0; i < ways; ++i) {
+      m_inputs[i] = &m_data;
+      m_lengths[i] = sizeof(m_data);
+    }
+
+    return true;
+  }
+
+  // Each call computes 'ways' hashes of the same input, divide the time by 'ways' to compare with test_cn_slow_hash
+  bool test() {
+    Crypto::Hash hashes[ways];
+    Crypto::cn_slow_hash_multi(m_context, m_inputs, m_lengths, ways, hashes);
+    for (size_t i = 0; i < ways; ++i) {
+      if (hashes[i] != m_expected_hash) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+private:
+  const void* m_inputs[ways];
+  size_t m_lengths[ways];
+};
+
+// Runs the kernel chosen in main, every kernel available on the host gets a run
+class test_cn_slow_hash_kernel : public test_cn_slow_hash {
+public:
+  static int kernel;
+
+  bool test() {
+    Crypto::Hash hash;
+    Crypto::cn_slow_hash_kernel(kernel, &m_data, sizeof(m_data), reinterpret_cast<char*>(&hash));
+    return hash == m_expected_hash;
+  }
+};
+
+int test_cn_slow_hash_kernel::kernel = 0;
@@ -0,0 +1,97 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vector>
+
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+
+// amounts of wallet transfers: a few significant digits at the orders coins are usually sent in
+inline std::vector<uint64_t> decompose_amount_test_amounts()
+{
+  std::vector<uint64_t> amounts;
+  uint64_t amount = UINT64_C(1234567);
+  for (size_t i = 0; i < 256; ++i) {
+    amount = amount * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+    amounts.push_back((amount >> 24) % UINT64_C(100000000000000));
+  }
+
+  return amounts;
+}
+
+template<uint64_t dust_threshold>
+class test_decompose_amount
+{
+public:
+  static const size_t loop_count = 10000;
+
+  bool init()
+  {
+    m_amounts = decompose_amount_test_amounts();
+    return true;
+  }
+
+  bool test()
+  {
+    uint64_t sum = 0;
+    auto add = [&sum](uint64_t chunk) { sum += chunk; };
+    const uint64_t amount = m_amounts[m_next++ % m_amounts.size()];
+    CryptoNote::decompose_amount_into_digits(amount, dust_threshold, add, add);
+    return sum == amount;
+  }
+
+private:
+  std::vector<uint64_t> m_amounts;
+  size_t m_next = 0;
+};
+
+// the chunks of decomposed amounts, as in the outputs a wallet scans for fusion inputs, mixed with the
+// amounts themselves, which mostly aren't decomposed
+class test_is_valid_decomposed_amount
+{
+public:
+  static const size_t loop_count = 100000;
+
+  bool init()
+  {
+    for (uint64_t amount : decompose_amount_test_amounts()) {
+      size_t chunks = 0;
+      CryptoNote::decompose_amount_into_digits(amount, 0, [this, &chunks](uint64_t chunk) {
+        m_amounts.push_back(chunk);
+        m_valid.push_back(true);
+        ++chunks;
+      }, [](uint64_t) {});
+
+      m_amounts.push_back(amount);
+      m_valid.push_back(chunks == 1);
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    size_t i = m_next++ % m_amounts.size();
+    return CryptoNote::is_valid_decomposed_amount(m_amounts[i]) == m_valid[i];
+  }
+
+private:
+  std::vector<uint64_t> m_amounts;
+  std::vector<bool> m_valid;
+  size_t m_next = 0;
+};
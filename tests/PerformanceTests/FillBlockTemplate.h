@@ -0,0 +1,111 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/ITimeProvider.h"
+#include "CryptoNoteCore/ITransactionValidator.h"
+#include "CryptoNoteCore/TransactionExtra.h"
+#include "CryptoNoteCore/TransactionPool.h"
+#include "CryptoNoteCore/VerificationContext.h"
+#include "Logging/LoggerGroup.h"
+
+#include "../TestStubs/ICoreStub.h"
+
+class accepting_transaction_validator : public CryptoNote::ITransactionValidator
+{
+public:
+  virtual bool checkTransactionInputs(const CryptoNote::Transaction& tx, CryptoNote::BlockInfo& maxUsedBlock) override { return true; }
+  virtual bool checkTransactionInputs(const CryptoNote::Transaction& tx, CryptoNote::BlockInfo& maxUsedBlock, CryptoNote::BlockInfo& lastFailed) override { return true; }
+  virtual bool haveSpentKeyImages(const CryptoNote::Transaction& tx) override { return false; }
+  virtual bool checkTransactionSize(size_t blobSize) override { return true; }
+};
+
+// A template built right after a new block, when every pool transaction is checked again
+template<size_t a_tx_count>
+class test_fill_block_template
+{
+public:
+  static const size_t loop_count = a_tx_count < 100 ? 100 : 10;
+
+  test_fill_block_template() : m_currency(CryptoNote::CurrencyBuilder(m_logger).currency())
+  {
+  }
+
+  bool init()
+  {
+    using namespace CryptoNote;
+
+    m_pool.reset(new tx_memory_pool(m_currency, m_validator, m_core, m_timeProvider, m_logger, false));
+    AccountBase alice;
+    alice.generate();
+    for (size_t i = 0; i < a_tx_count; ++i) {
+      AccountBase miner;
+      miner.generate();
+      Transaction minerTx;
+      if (!m_currency.constructMinerTx(BLOCK_MAJOR_VERSION_1, 0, 0, 0, 2, 0, miner.getAccountKeys().address, minerTx))
+        return false;
+
+      TransactionSourceEntry source;
+      source.amount = minerTx.outputs[0].amount;
+      source.realTransactionPublicKey = getTransactionPublicKeyFromExtra(minerTx.extra);
+      source.realOutputIndexInTransaction = 0;
+      source.outputs.push_back(std::make_pair(0, boost::get<KeyOutput>(minerTx.outputs[0].target).key));
+      source.realOutput = 0;
+
+      // fees differ so that the pool has to order the transactions
+      uint64_t fee = m_currency.minimumFee() * (1 + i % 7);
+      std::vector<TransactionDestinationEntry> destinations;
+      destinations.push_back(TransactionDestinationEntry(source.amount - fee, alice.getAccountKeys().address));
+
+      Transaction tx;
+      Crypto::SecretKey txKey;
+      if (!constructTransaction(miner.getAccountKeys(), std::vector<TransactionSourceEntry>(1, source), destinations, std::vector<uint8_t>(), tx, 0, txKey, m_logger))
+        return false;
+
+      tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+      if (!m_pool->add_tx(tx, tvc, false) || !tvc.m_added_to_pool)
+        return false;
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    m_pool->on_blockchain_inc(1, CryptoNote::NULL_HASH);
+    CryptoNote::Block block;
+    size_t totalSize;
+    uint64_t fee;
+    return m_pool->fill_block_template(block, 1000000, std::numeric_limits<size_t>::max(), 0, totalSize, fee) && !block.transactionHashes.empty();
+  }
+
+private:
+  Logging::LoggerGroup m_logger;
+  CryptoNote::Currency m_currency;
+  accepting_transaction_validator m_validator;
+  ICoreStub m_core;
+  CryptoNote::RealTimeProvider m_timeProvider;
+  std::unique_ptr<CryptoNote::tx_memory_pool> m_pool;
+};
@@ -34,3 +34,27 @@ public:
     return true;
   }
 };
+
+class test_generate_key_derivation_precomp : public single_tx_test_base
+{
+public:
+  static const size_t loop_count = 1000;
+
+  bool init()
+  {
+    if (!single_tx_test_base::init())
+      return false;
+
+    return Crypto::precompute_key_derivation(m_tx_pub_key, m_precomp);
+  }
+
+  bool test()
+  {
+    Crypto::KeyDerivation recv_derivation;
+    Crypto::generate_key_derivation(m_precomp, m_bob.getAccountKeys().viewSecretKey, recv_derivation);
+    return true;
+  }
+
+private:
+  Crypto::KeyDerivationPrecomp m_precomp;
+};
@@ -55,3 +55,62 @@ public:
 private:
   CryptoNote::KeyPair m_in_ephemeral;
 };
+
+template<size_t count>
+class test_generate_key_images : public single_tx_test_base
+{
+public:
+  static const size_t loop_count = 1000 / count + 10;
+
+  bool init()
+  {
+    using namespace CryptoNote;
+
+    if (!single_tx_test_base::init())
+      return false;
+
+    AccountKeys bob_keys = m_bob.getAccountKeys();
+
+    Crypto::KeyDerivation recv_derivation;
+    Crypto::generate_key_derivation(m_tx_pub_key, bob_keys.viewSecretKey, recv_derivation);
+
+    for (size_t i = 0; i < count; ++i) {
+      Crypto::derive_public_key(recv_derivation, i, bob_keys.address.spendPublicKey, m_public_keys[i]);
+      Crypto::derive_secret_key(recv_derivation, i, bob_keys.spendSecretKey, m_secret_keys[i]);
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    Crypto::generate_key_images(m_public_keys, m_secret_keys, count, m_key_images);
+    return true;
+  }
+
+protected:
+  Crypto::PublicKey m_public_keys[count];
+  Crypto::SecretKey m_secret_keys[count];
+  Crypto::KeyImage m_key_images[count];
+};
+
+template<size_t count>
+class test_check_key_images : public test_generate_key_images<count>
+{
+public:
+  bool init()
+  {
+    if (!test_generate_key_images<count>::init())
+      return false;
+
+    test_generate_key_images<count>::test();
+    return true;
+  }
+
+  bool test()
+  {
+    bool valid[count];
+    Crypto::check_key_images(this->m_key_images, count, valid);
+    return valid[0];
+  }
+};
@@ -0,0 +1,75 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common/StringTools.h"
+
+// size is in bytes: 32 is a hash or a key, the larger ones are transaction blobs
+template<size_t size>
+class test_to_hex {
+public:
+  static const size_t loop_count = 10000;
+
+  bool init() {
+    m_data.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+      m_data[i] = static_cast<uint8_t>(i * 37 + 11);
+    }
+
+    return true;
+  }
+
+  bool test() {
+    m_text.clear();
+    Common::toHex(m_data, m_text);
+    return m_text.size() == 2 * size;
+  }
+
+private:
+  std::vector<uint8_t> m_data;
+  std::string m_text;
+};
+
+template<size_t size>
+class test_from_hex {
+public:
+  static const size_t loop_count = 10000;
+
+  bool init() {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+      data[i] = static_cast<uint8_t>(i * 37 + 11);
+    }
+
+    m_text = Common::toHex(data);
+    m_data.resize(size);
+    return true;
+  }
+
+  bool test() {
+    size_t decodedSize;
+    return Common::fromHex(m_text, m_data.data(), m_data.size(), decodedSize) && decodedSize == size;
+  }
+
+private:
+  std::string m_text;
+  std::vector<uint8_t> m_data;
+};
@@ -17,11 +17,19 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <string>
+#include <vector>
 #include <stdint.h>
 
 #include <boost/chrono.hpp>
 
+#include "Common/JsonValue.h"
+
 class performance_timer
 {
 public:
@@ -43,84 +51,243 @@ public:
     return static_cast<int>(boost::chrono::duration_cast<boost::chrono::milliseconds>(elapsed).count());
   }
 
+  uint64_t elapsed_ns()
+  {
+    clock::duration elapsed = clock::now() - m_start;
+    return static_cast<uint64_t>(boost::chrono::duration_cast<boost::chrono::nanoseconds>(elapsed).count());
+  }
+
 private:
   clock::time_point m_base;
   clock::time_point m_start;
 };
 
+// Time per call of one test in nanoseconds, a sample is the average of a batch of loop_count calls
+struct performance_result
+{
+  std::string name;
+  size_t loop_count;
+  std::vector<double> samples;
+  double median;
+  double p99;
+  double mean;
+  double stddev;
+  double min;
 
-template <typename T>
-class test_runner
+  void summarize()
+  {
+    std::vector<double> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+    median = percentile(sorted, 50);
+    p99 = percentile(sorted, 99);
+    min = sorted.front();
+
+    mean = 0;
+    for (double sample : sorted) {
+      mean += sample;
+    }
+
+    mean /= sorted.size();
+    double variance = 0;
+    for (double sample : sorted) {
+      variance += (sample - mean) * (sample - mean);
+    }
+
+    stddev = sorted.size() > 1 ? std::sqrt(variance / (sorted.size() - 1)) : 0;
+  }
+
+private:
+  // nearest rank
+  static double percentile(const std::vector<double>& sorted, unsigned percent)
+  {
+    size_t rank = (sorted.size() * percent + 99) / 100;
+    return sorted[rank == 0 ? 0 : rank - 1];
+  }
+};
+
+// Selection and results of a run, filled by run_test and written or compared by main
+class performance_suite
 {
 public:
-  test_runner()
-    : m_elapsed(0)
+  static performance_suite& instance()
   {
+    static performance_suite suite;
+    return suite;
   }
 
-  bool run()
+  std::string filter;      // substring of the test names to run
+  size_t repeat = 10;      // samples per test
+  bool list_only = false;
+  bool failed = false;
+  bool warmed_up = false;
+  std::vector<performance_result> results;
+
+  bool selected(const std::string& name) const
+  {
+    return filter.empty() || name.find(filter) != std::string::npos;
+  }
+
+  bool write_json(const std::string& path) const
+  {
+    Common::JsonValue tests(Common::JsonValue::ARRAY);
+    for (const performance_result& result : results) {
+      Common::JsonValue test(Common::JsonValue::OBJECT);
+      test.insert("name", result.name);
+      test.insert("loop_count", static_cast<Common::JsonValue::Integer>(result.loop_count));
+      test.insert("samples", static_cast<Common::JsonValue::Integer>(result.samples.size()));
+      test.insert("median_ns", result.median);
+      test.insert("p99_ns", result.p99);
+      test.insert("mean_ns", result.mean);
+      test.insert("stddev_ns", result.stddev);
+      test.insert("min_ns", result.min);
+      tests.pushBack(std::move(test));
+    }
+
+    Common::JsonValue root(Common::JsonValue::OBJECT);
+    root.insert("tests", std::move(tests));
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    file << root.toString() << std::endl;
+    return !file.fail();
+  }
+
+  // Compares the medians with a file written by write_json, false if a test got slower by more than tolerance percent
+  bool compare(const std::string& path, double tolerance) const
+  {
+    std::ifstream file(path);
+    Common::JsonValue baseline;
+    file >> baseline;
+    if (file.fail() || !baseline.isObject() || !baseline.contains("tests")) {
+      throw std::runtime_error("Failed to read baseline " + path);
+    }
+
+    bool passed = true;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Comparison with " << path << " (median, tolerance " << tolerance << "%):" << std::endl;
+    for (const performance_result& result : results) {
+      const Common::JsonValue* old = nullptr;
+      for (const Common::JsonValue& test : baseline("tests").getArray()) {
+        if (test("name").getString() == result.name) {
+          old = &test;
+          break;
+        }
+      }
+
+      if (old == nullptr) {
+        std::cout << "  " << result.name << ": not in the baseline" << std::endl;
+        continue;
+      }
+
+      const Common::JsonValue& median = (*old)("median_ns");
+      double oldMedian = median.isReal() ? median.getReal() : static_cast<double>(median.getInteger());
+      double change = oldMedian > 0 ? (result.median / oldMedian - 1) * 100 : 0;
+      bool regressed = change > tolerance;
+      passed = passed && !regressed;
+      std::cout << "  " << result.name << ": " << oldMedian << " -> " << result.median << " ns, " <<
+        std::showpos << change << std::noshowpos << "%" << (regressed ? " REGRESSION" : "") << std::endl;
+    }
+
+    return passed;
+  }
+
+private:
+  performance_suite()
+  {
+  }
+};
+
+template <typename T>
+class test_runner
+{
+public:
+  bool run(size_t repeat)
   {
     T test;
     if (!test.init())
       return false;
 
-    performance_timer timer;
-    timer.start();
     warm_up();
-    std::cout << "Warm up: " << timer.elapsed_ms() << " ms" << std::endl;
 
-    timer.start();
-    for (size_t i = 0; i < T::loop_count; ++i)
+    m_samples.clear();
+    performance_timer timer;
+    for (size_t r = 0; r < repeat; ++r)
     {
-      if (!test.test())
-        return false;
+      timer.start();
+      for (size_t i = 0; i < T::loop_count; ++i)
+      {
+        if (!test.test())
+          return false;
+      }
+
+      m_samples.push_back(static_cast<double>(timer.elapsed_ns()) / T::loop_count);
     }
-    m_elapsed = timer.elapsed_ms();
 
     return true;
   }
 
-  int elapsed_time() const { return m_elapsed; }
-
-  int time_per_call() const
-  {
-    static_assert(0 < T::loop_count, "T::loop_count must be greater than 0");
-    return m_elapsed / T::loop_count;
-  }
+  const std::vector<double>& samples() const { return m_samples; }
 
 private:
   /**
-   * Warm up processor core, enabling turbo boost, etc.
+   * Warm up processor core, enabling turbo boost, etc. Done once, later tests run on a warm core.
    */
-  uint64_t warm_up()
+  void warm_up()
   {
+    bool& warmed_up = performance_suite::instance().warmed_up;
+    if (warmed_up)
+      return;
+
+    performance_timer timer;
+    timer.start();
     const size_t warm_up_rounds = 1000 * 1000 * 1000;
     m_warm_up = 0;
     for (size_t i = 0; i < warm_up_rounds; ++i)
     {
       ++m_warm_up;
     }
-    return m_warm_up;
+
+    warmed_up = true;
+    std::cout << "Warm up: " << timer.elapsed_ms() << " ms" << std::endl;
   }
 
 private:
   volatile uint64_t m_warm_up;  ///<! This field is intended for preclude compiler optimizations
-  int m_elapsed;
+  std::vector<double> m_samples;
 };
 
 template <typename T>
-void run_test(const char* test_name)
+void run_test(const std::string& test_name)
 {
+  performance_suite& suite = performance_suite::instance();
+  if (!suite.selected(test_name))
+    return;
+
+  if (suite.list_only)
+  {
+    std::cout << test_name << std::endl;
+    return;
+  }
+
+  static_assert(0 < T::loop_count, "T::loop_count must be greater than 0");
   test_runner<T> runner;
-  if (runner.run())
+  if (runner.run(suite.repeat))
   {
+    performance_result result;
+    result.name = test_name;
+    result.loop_count = T::loop_count;
+    result.samples = runner.samples();
+    result.summarize();
+    suite.results.push_back(result);
+
     std::cout << test_name << " - OK:\n";
-    std::cout << "  loop count:    " << T::loop_count << '\n';
-    std::cout << "  elapsed:       " << runner.elapsed_time() << " ms\n";
-    std::cout << "  time per call: " << runner.time_per_call() << " ms/call\n" << std::endl;
+    std::cout << "  loop count:    " << T::loop_count << " x " << suite.repeat << '\n';
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "  median:        " << result.median / 1000 << " us/call\n";
+    std::cout << "  p99:           " << result.p99 / 1000 << " us/call\n";
+    std::cout << "  stddev:        " << result.stddev / 1000 << " us\n" << std::endl;
   }
   else
   {
+    suite.failed = true;
     std::cout << test_name << " - FAILED" << std::endl;
   }
 }
@@ -0,0 +1,86 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "CryptoNoteCore/CryptoNoteBasic.h"
+
+// One batch of the output scan of TransfersConsumer: the derivations of 16 transactions
+// with a shared inversion, then the spend key candidates of all their outputs, none of
+// which belong to the wallet as for most transactions of a block
+template<size_t a_out_count>
+class test_scan_outputs
+{
+public:
+  static const size_t loop_count = 100;
+  static const size_t tx_count = 16;
+
+  bool init()
+  {
+    CryptoNote::KeyPair view = CryptoNote::generateKeyPair();
+    m_view_secret = view.secretKey;
+    m_spend_keys.insert(CryptoNote::generateKeyPair().publicKey);
+
+    m_tx_keys.resize(tx_count);
+    m_derivations.resize(tx_count);
+    for (size_t i = 0; i < tx_count; ++i) {
+      m_tx_keys[i] = CryptoNote::generateKeyPair().publicKey;
+      for (size_t j = 0; j < a_out_count; ++j) {
+        m_output_indexes.push_back(j);
+        m_output_keys.push_back(CryptoNote::generateKeyPair().publicKey);
+        m_output_derivations.push_back(&m_derivations[i]);
+      }
+    }
+
+    m_candidates.resize(m_output_keys.size());
+    return true;
+  }
+
+  bool test()
+  {
+    bool derived[tx_count];
+    Crypto::generate_key_derivations(m_tx_keys.data(), tx_count, m_view_secret, m_derivations.data(), derived);
+
+    std::unique_ptr<bool[]> underived(new bool[m_output_keys.size()]);
+    Crypto::underive_public_keys(m_output_derivations.data(), m_output_indexes.data(), m_output_keys.data(), m_output_keys.size(),
+      m_candidates.data(), underived.get());
+
+    size_t found = 0;
+    for (size_t i = 0; i < m_candidates.size(); ++i) {
+      if (underived[i] && m_spend_keys.count(m_candidates[i]) != 0) {
+        ++found;
+      }
+    }
+
+    return found == 0;
+  }
+
+private:
+  Crypto::SecretKey m_view_secret;
+  std::unordered_set<Crypto::PublicKey> m_spend_keys;
+  std::vector<Crypto::PublicKey> m_tx_keys;
+  std::vector<Crypto::KeyDerivation> m_derivations;
+  std::vector<const Crypto::KeyDerivation*> m_output_derivations;
+  std::vector<size_t> m_output_indexes;
+  std::vector<Crypto::PublicKey> m_output_keys;
+  std::vector<Crypto::PublicKey> m_candidates;
+};
@@ -0,0 +1,141 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "Rpc/CoreRpcServerCommandsDefinitions.h"
+#include "Serialization/SerializationTools.h"
+
+#include "MultiTransactionTestBase.h"
+
+// a transaction with one input of ring_size members and out_count outputs
+template<size_t a_ring_size, size_t a_out_count>
+class serialization_test_base : protected multi_tx_test_base<a_ring_size>
+{
+public:
+  typedef multi_tx_test_base<a_ring_size> base_class;
+
+  bool init()
+  {
+    using namespace CryptoNote;
+
+    if (!base_class::init())
+      return false;
+
+    AccountBase alice;
+    alice.generate();
+    std::vector<TransactionDestinationEntry> destinations;
+    for (size_t i = 0; i < a_out_count; ++i) {
+      destinations.push_back(TransactionDestinationEntry(this->m_source_amount / a_out_count, alice.getAccountKeys().address));
+    }
+
+    Crypto::SecretKey txKey;
+    return constructTransaction(this->m_miners[this->real_source_idx].getAccountKeys(), this->m_sources, destinations, std::vector<uint8_t>(), m_tx, 0, txKey, this->m_logger);
+  }
+
+protected:
+  CryptoNote::Transaction m_tx;
+};
+
+template<size_t a_ring_size, size_t a_out_count>
+class test_serialize_tx : private serialization_test_base<a_ring_size, a_out_count>
+{
+public:
+  static const size_t loop_count = 1000;
+
+  typedef serialization_test_base<a_ring_size, a_out_count> base_class;
+
+  bool init()
+  {
+    return base_class::init();
+  }
+
+  bool test()
+  {
+    return !CryptoNote::toBinaryArray(this->m_tx).empty();
+  }
+};
+
+template<size_t a_ring_size, size_t a_out_count>
+class test_deserialize_tx : private serialization_test_base<a_ring_size, a_out_count>
+{
+public:
+  static const size_t loop_count = 1000;
+
+  typedef serialization_test_base<a_ring_size, a_out_count> base_class;
+
+  bool init()
+  {
+    if (!base_class::init())
+      return false;
+
+    m_blob = CryptoNote::toBinaryArray(this->m_tx);
+    return true;
+  }
+
+  bool test()
+  {
+    CryptoNote::Transaction tx;
+    return CryptoNote::fromBinaryArray(tx, m_blob);
+  }
+
+private:
+  CryptoNote::BinaryArray m_blob;
+};
+
+// the JSON body of a get_pool_changes_lite response, which wallets poll
+template<size_t a_tx_count>
+class test_rpc_json_pool_changes : private serialization_test_base<1, 2>
+{
+public:
+  static const size_t loop_count = a_tx_count < 100 ? 100 : 10;
+
+  typedef serialization_test_base<1, 2> base_class;
+
+  bool init()
+  {
+    if (!base_class::init())
+      return false;
+
+    m_response.isTailBlockActual = true;
+    m_response.poolSequence = 1;
+    m_response.isPoolSequenceActual = true;
+    m_response.status = CORE_RPC_STATUS_OK;
+    for (size_t i = 0; i < a_tx_count; ++i) {
+      CryptoNote::TransactionPrefixInfo info;
+      info.txPrefix = m_tx;
+      info.txHash = CryptoNote::getObjectHash(m_tx);
+      m_response.addedTxs.push_back(info);
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    return !CryptoNote::storeToJson(m_response).empty();
+  }
+
+private:
+  CryptoNote::COMMAND_RPC_GET_POOL_CHANGES_LITE::response m_response;
+};
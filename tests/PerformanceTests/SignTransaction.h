@@ -0,0 +1,84 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "ITransaction.h"
+#include "CryptoNoteCore/TransactionApi.h"
+
+#include "MultiTransactionTestBase.h"
+
+// signs a transaction spending a_in_count inputs, each one with a ring of a_ring_size outputs
+template<size_t a_in_count, size_t a_ring_size>
+class test_sign_tx : private multi_tx_test_base<a_ring_size>
+{
+  static_assert(0 < a_in_count, "in_count must be greater than 0");
+
+public:
+  static const size_t loop_count = (a_in_count < 10) ? 100 : 10;
+  static const size_t in_count = a_in_count;
+
+  typedef multi_tx_test_base<a_ring_size> base_class;
+
+  bool init()
+  {
+    using namespace CryptoNote;
+
+    if (!base_class::init())
+      return false;
+
+    const TransactionSourceEntry& source = this->m_sources.front();
+    m_info.amount = source.amount;
+    for (const auto& output : source.outputs)
+    {
+      m_info.outputs.push_back(TransactionTypes::GlobalOutput{output.second, static_cast<uint32_t>(output.first)});
+    }
+
+    m_info.realOutput.transactionPublicKey = source.realTransactionPublicKey;
+    m_info.realOutput.transactionIndex = source.realOutput;
+    m_info.realOutput.outputInTransaction = source.realOutputIndexInTransaction;
+
+    m_ephKeys.resize(in_count);
+    m_alice.generate();
+    return true;
+  }
+
+  bool test()
+  {
+    using namespace CryptoNote;
+
+    std::unique_ptr<ITransaction> tx = createTransaction();
+    std::vector<TransactionTypes::KeyInputSource> inputs;
+    for (size_t i = 0; i < in_count; ++i)
+    {
+      inputs.push_back(TransactionTypes::KeyInputSource{this->m_miners[this->real_source_idx].getAccountKeys(), &m_info, &m_ephKeys[i]});
+    }
+
+    size_t firstInput = tx->addInputs(inputs);
+    tx->addOutput(m_info.amount * in_count, m_alice.getAccountKeys().address);
+    tx->signInputKeys(firstInput, inputs);
+    return tx->getInputCount() == in_count;
+  }
+
+private:
+  CryptoNote::AccountBase m_alice;
+  CryptoNote::TransactionTypes::InputKeyInfo m_info;
+  std::vector<CryptoNote::KeyPair> m_ephKeys;
+};
@@ -0,0 +1,86 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+
+#include <boost/filesystem.hpp>
+
+#include "CryptoNoteCore/CryptoNoteBasic.h"
+#include "CryptoNoteCore/SwappedVector.h"
+#include "Serialization/ISerializer.h"
+
+struct swapped_vector_item
+{
+  CryptoNote::BinaryArray data;
+
+  void serialize(CryptoNote::ISerializer& s)
+  {
+    s(data, "data");
+  }
+};
+
+// Lookups of a SwappedVector holding item_count entries of 1 KB, at most cache_size bytes
+// of them are kept deserialized. A prime stride scatters the lookups, a stride of 1 scans.
+template<size_t cache_size, size_t stride>
+class test_swapped_vector_access
+{
+public:
+  static const size_t loop_count = 10000;
+  static const size_t item_count = 10000;
+
+  ~test_swapped_vector_access()
+  {
+    m_vector.reset();
+    boost::system::error_code ignoredError;
+    boost::filesystem::remove_all(m_folder, ignoredError);
+  }
+
+  bool init()
+  {
+    m_folder = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("performance_tests_%%%%%%%%%%%%");
+    if (!boost::filesystem::create_directory(m_folder))
+      return false;
+
+    m_vector.reset(new SwappedVector<swapped_vector_item>());
+    if (!m_vector->open((m_folder / "items.dat").string(), (m_folder / "indexes.dat").string(), cache_size))
+      return false;
+
+    swapped_vector_item item;
+    item.data.resize(1024);
+    for (size_t i = 0; i < item_count; ++i) {
+      item.data[0] = static_cast<uint8_t>(i);
+      m_vector->push_back(item);
+    }
+
+    m_next = 0;
+    return m_vector->size() == item_count;
+  }
+
+  bool test()
+  {
+    // a stride coprime to item_count visits all items before repeating one
+    m_next = (m_next + stride) % item_count;
+    return (*m_vector)[m_next].data[0] == static_cast<uint8_t>(m_next);
+  }
+
+private:
+  boost::filesystem::path m_folder;
+  std::unique_ptr<SwappedVector<swapped_vector_item>> m_vector;
+  uint64_t m_next;
+};
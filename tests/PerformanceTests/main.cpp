@@ -15,22 +15,77 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <boost/program_options.hpp>
+
+#include "Common/CommandLine.h"
+
 #include "PerformanceTests.h"
 #include "PerformanceUtils.h"
 
 // tests
 #include "ConstructTransaction.h"
+#include "Chacha8.h"
 #include "CheckRingSignature.h"
+#include "CryptoNoteFastHash.h"
 #include "CryptoNoteSlowHash.h"
+#include "DecomposeAmount.h"
 #include "DerivePublicKey.h"
 #include "DeriveSecretKey.h"
+#include "FillBlockTemplate.h"
 #include "GenerateKeyDerivation.h"
 #include "GenerateKeyImage.h"
 #include "GenerateKeyImageHelper.h"
+#include "HexConversion.h"
 #include "IsOutToAccount.h"
+#include "ScanOutputs.h"
+#include "Serialization.h"
+#include "SignTransaction.h"
+#include "SwappedVectorAccess.h"
+
+namespace po = boost::program_options;
+
+namespace
+{
+  const command_line::arg_descriptor<std::string> arg_filter    = {"filter", "Run only the tests whose name contains this text", ""};
+  const command_line::arg_descriptor<size_t>      arg_repeat    = {"repeat", "Samples taken of every test, each of loop_count calls", 10};
+  const command_line::arg_descriptor<bool>        arg_list      = {"list", "List the selected tests without running them"};
+  const command_line::arg_descriptor<std::string> arg_json      = {"json", "Write the results to this file as JSON", ""};
+  const command_line::arg_descriptor<std::string> arg_baseline  = {"baseline", "Compare the medians with a file written by --json and fail on regressions", ""};
+  const command_line::arg_descriptor<double>      arg_tolerance = {"tolerance", "Slowdown in percent accepted by --baseline", 10};
+}
 
 int main(int argc, char** argv)
 {
+  po::options_description desc_options("Allowed options");
+  command_line::add_arg(desc_options, command_line::arg_help);
+  command_line::add_arg(desc_options, arg_filter);
+  command_line::add_arg(desc_options, arg_repeat);
+  command_line::add_arg(desc_options, arg_list);
+  command_line::add_arg(desc_options, arg_json);
+  command_line::add_arg(desc_options, arg_baseline);
+  command_line::add_arg(desc_options, arg_tolerance);
+
+  po::variables_map vm;
+  bool r = command_line::handle_error_helper(desc_options, [&]()
+  {
+    po::store(po::parse_command_line(argc, argv, desc_options), vm);
+    po::notify(vm);
+    return true;
+  });
+  if (!r)
+    return 1;
+
+  if (command_line::get_arg(vm, command_line::arg_help))
+  {
+    std::cout << desc_options << std::endl;
+    return 0;
+  }
+
+  performance_suite& suite = performance_suite::instance();
+  suite.filter = command_line::get_arg(vm, arg_filter);
+  suite.repeat = std::max<size_t>(command_line::get_arg(vm, arg_repeat), 1);
+  suite.list_only = command_line::get_arg(vm, arg_list);
+
   set_process_affinity(1);
   set_thread_high_priority();
 
@@ -58,21 +113,106 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE2(test_construct_tx, 100, 10);
   TEST_PERFORMANCE2(test_construct_tx, 100, 100);
 
+  TEST_PERFORMANCE2(test_sign_tx, 100, 6);
+  TEST_PERFORMANCE2(test_sign_tx, 200, 6);
+
   TEST_PERFORMANCE1(test_check_ring_signature, 1);
   TEST_PERFORMANCE1(test_check_ring_signature, 2);
   TEST_PERFORMANCE1(test_check_ring_signature, 10);
   TEST_PERFORMANCE1(test_check_ring_signature, 100);
+  TEST_PERFORMANCE1(test_check_ring_signature_precomp, 1);
+  TEST_PERFORMANCE1(test_check_ring_signature_precomp, 2);
+  TEST_PERFORMANCE1(test_check_ring_signature_precomp, 10);
+  TEST_PERFORMANCE1(test_check_ring_signature_precomp, 100);
 
   TEST_PERFORMANCE0(test_is_out_to_acc);
   TEST_PERFORMANCE0(test_generate_key_image_helper);
   TEST_PERFORMANCE0(test_generate_key_derivation);
+  TEST_PERFORMANCE0(test_generate_key_derivation_precomp);
   TEST_PERFORMANCE0(test_generate_key_image);
+  TEST_PERFORMANCE1(test_generate_key_images, 1);
+  TEST_PERFORMANCE1(test_generate_key_images, 16);
+  TEST_PERFORMANCE1(test_generate_key_images, 128);
+  TEST_PERFORMANCE1(test_check_key_images, 1);
+  TEST_PERFORMANCE1(test_check_key_images, 16);
+  TEST_PERFORMANCE1(test_check_key_images, 128);
   TEST_PERFORMANCE0(test_derive_public_key);
   TEST_PERFORMANCE0(test_derive_secret_key);
 
+  if (!suite.list_only)
+    std::cout << "Slow hash kernel: " << Crypto::slow_hash_kernel_name(Crypto::slow_hash_kernel()) << std::endl;
   TEST_PERFORMANCE0(test_cn_slow_hash);
+  for (int kernel = 0; kernel < Crypto::slow_hash_kernel_count(); ++kernel) {
+    if (Crypto::slow_hash_kernel_available(kernel)) {
+      test_cn_slow_hash_kernel::kernel = kernel;
+      run_test<test_cn_slow_hash_kernel>(std::string("test_cn_slow_hash_kernel<") + Crypto::slow_hash_kernel_name(kernel) + ">");
+    }
+  }
+  TEST_PERFORMANCE1(test_cn_slow_hash_multi, 2);
+  TEST_PERFORMANCE1(test_cn_slow_hash_multi, 4);
+
+  TEST_PERFORMANCE1(test_cn_fast_hash, 64);
+  TEST_PERFORMANCE1(test_cn_fast_hash_multi, 64);
+  TEST_PERFORMANCE1(test_cn_fast_hash, 2048);
+  TEST_PERFORMANCE1(test_cn_fast_hash_multi, 2048);
+  TEST_PERFORMANCE1(test_tree_hash, 16);
+  TEST_PERFORMANCE1(test_tree_hash, 256);
+
+  TEST_PERFORMANCE1(test_to_hex, 32);
+  TEST_PERFORMANCE1(test_to_hex, 1024);
+  TEST_PERFORMANCE1(test_to_hex, 16384);
+  TEST_PERFORMANCE1(test_from_hex, 32);
+  TEST_PERFORMANCE1(test_from_hex, 1024);
+  TEST_PERFORMANCE1(test_from_hex, 16384);
+
+  TEST_PERFORMANCE1(test_chacha8, 72);
+  TEST_PERFORMANCE1(test_chacha8, 4096);
+  TEST_PERFORMANCE1(test_chacha8, 1048576);
+
+  TEST_PERFORMANCE2(test_serialize_tx, 1, 2);
+  TEST_PERFORMANCE2(test_serialize_tx, 10, 10);
+  TEST_PERFORMANCE2(test_deserialize_tx, 1, 2);
+  TEST_PERFORMANCE2(test_deserialize_tx, 10, 10);
+  TEST_PERFORMANCE1(test_rpc_json_pool_changes, 10);
+  TEST_PERFORMANCE1(test_rpc_json_pool_changes, 100);
+
+  TEST_PERFORMANCE1(test_fill_block_template, 100);
+  TEST_PERFORMANCE1(test_fill_block_template, 1000);
+
+  TEST_PERFORMANCE1(test_scan_outputs, 2);
+  TEST_PERFORMANCE1(test_scan_outputs, 10);
+
+  TEST_PERFORMANCE2(test_swapped_vector_access, 128 * 1024, 7919);
+  TEST_PERFORMANCE2(test_swapped_vector_access, 16 * 1024 * 1024, 7919);
+  TEST_PERFORMANCE2(test_swapped_vector_access, 128 * 1024, 1);
+
+  TEST_PERFORMANCE1(test_decompose_amount, 0);
+  TEST_PERFORMANCE1(test_decompose_amount, 1000000);
+  TEST_PERFORMANCE0(test_is_valid_decomposed_amount);
+
+  if (suite.list_only)
+    return 0;
 
   std::cout << "Tests finished. Elapsed time: " << timer.elapsed_ms() / 1000 << " sec" << std::endl;
 
-  return 0;
+  try
+  {
+    std::string json = command_line::get_arg(vm, arg_json);
+    if (!json.empty() && !suite.write_json(json))
+    {
+      std::cout << "Failed to write " << json << std::endl;
+      return 1;
+    }
+
+    std::string baseline = command_line::get_arg(vm, arg_baseline);
+    if (!baseline.empty() && !suite.compare(baseline, command_line::get_arg(vm, arg_tolerance)))
+      return 1;
+  }
+  catch (const std::exception& e)
+  {
+    std::cout << e.what() << std::endl;
+    return 1;
+  }
+
+  return suite.failed ? 1 : 0;
 }
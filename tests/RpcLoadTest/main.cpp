@@ -0,0 +1,387 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+// Sends a weighted mix of daemon and walletd RPC calls, either as fast as a number of
+// concurrent clients allows or at a fixed total rate, and reports the latency
+// percentiles and the errors of every method.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+
+#include <boost/program_options.hpp>
+
+#include "Common/CommandLine.h"
+#include "Common/StringTools.h"
+#include "CryptoNoteConfig.h"
+#include "CryptoNoteCore/Currency.h"
+#include "Logging/ConsoleLogger.h"
+#include "PaymentGate/PaymentServiceJsonRpcMessages.h"
+#include "Rpc/CoreRpcServerCommandsDefinitions.h"
+#include "Rpc/HttpClient.h"
+#include "System/ContextGroup.h"
+#include "System/Dispatcher.h"
+#include "System/Timer.h"
+
+namespace po = boost::program_options;
+
+namespace {
+
+const command_line::arg_descriptor<std::string> arg_daemon = { "daemon", "<host:port> Daemon RPC", "127.0.0.1:" + std::to_string(CryptoNote::RPC_DEFAULT_PORT) };
+const command_line::arg_descriptor<std::string> arg_walletd = { "walletd", "<host:port> walletd RPC", "127.0.0.1:" + std::to_string(CryptoNote::GATE_RPC_DEFAULT_PORT) };
+const command_line::arg_descriptor<std::string> arg_rpc_user = { "rpc-user", "Username of the RPC servers", "" };
+const command_line::arg_descriptor<std::string> arg_rpc_password = { "rpc-password", "Password of the RPC servers", "" };
+const command_line::arg_descriptor<std::string> arg_mix = { "mix", "<method:weight,...> of getblocktemplate, getrandom_outs, queryblockslite, getTransactions and sendTransaction",
+  "queryblockslite:1,getrandom_outs:1" };
+const command_line::arg_descriptor<uint32_t> arg_concurrency = { "concurrency", "Number of clients, each with its own connections", 4 };
+const command_line::arg_descriptor<double> arg_rate = { "rate", "Total calls per second shared by the clients, 0 for as fast as they get replies", 0 };
+const command_line::arg_descriptor<uint32_t> arg_duration = { "duration", "Seconds to run", 10 };
+const command_line::arg_descriptor<bool> arg_testnet = { "testnet", "The servers are on the test net" };
+const command_line::arg_descriptor<std::string> arg_address = { "address", "Wallet address for getblocktemplate and the transfers of sendTransaction", "" };
+const command_line::arg_descriptor<uint64_t> arg_amount = { "amount", "Amount of getrandom_outs and of the transfers of sendTransaction", CryptoNote::parameters::COIN };
+const command_line::arg_descriptor<uint64_t> arg_outs_count = { "outs-count", "Outputs asked for by getrandom_outs", 10 };
+const command_line::arg_descriptor<uint32_t> arg_block_count = { "block-count", "Blocks scanned by getTransactions", 1000 };
+const command_line::arg_descriptor<uint32_t> arg_anonymity = { "anonymity", "Anonymity of sendTransaction", PaymentService::DEFAULT_ANONYMITY_LEVEL };
+
+enum class Method {
+  GetBlockTemplate,
+  GetRandomOuts,
+  QueryBlocksLite,
+  GetTransactions,
+  SendTransaction
+};
+
+const std::map<std::string, Method> METHODS = {
+  { "getblocktemplate", Method::GetBlockTemplate },
+  { "getrandom_outs", Method::GetRandomOuts },
+  { "queryblockslite", Method::QueryBlocksLite },
+  { "getTransactions", Method::GetTransactions },
+  { "sendTransaction", Method::SendTransaction }
+};
+
+struct MethodStats {
+  std::vector<uint64_t> latencies; // ns, of the successful calls
+  std::map<std::string, size_t> errors;
+};
+
+struct LoadSettings {
+  std::string user;
+  std::string password;
+  std::string address;
+  uint64_t amount;
+  uint64_t outsCount;
+  uint32_t blockCount;
+  uint32_t anonymity;
+  Crypto::Hash genesisHash;
+};
+
+bool parseHost(const std::string& value, std::string& host, uint16_t& port) {
+  size_t colon = value.rfind(':');
+  if (colon == std::string::npos) {
+    return false;
+  }
+
+  host = value.substr(0, colon);
+  return Common::fromString(value.substr(colon + 1), port) && !host.empty();
+}
+
+bool parseMix(const std::string& value, std::vector<Method>& methods, std::vector<double>& weights) {
+  std::istringstream items(value);
+  std::string item;
+  while (std::getline(items, item, ',')) {
+    size_t colon = item.find(':');
+    auto it = METHODS.find(item.substr(0, colon));
+    double weight = 1;
+    if (it == METHODS.end() || (colon != std::string::npos && (!Common::fromString(item.substr(colon + 1), weight) || weight < 0))) {
+      std::cout << "Wrong mix entry " << item << std::endl;
+      return false;
+    }
+
+    if (weight > 0) {
+      methods.push_back(it->second);
+      weights.push_back(weight);
+    }
+  }
+
+  return !methods.empty();
+}
+
+std::string methodName(Method method) {
+  for (const auto& m : METHODS) {
+    if (m.second == method) {
+      return m.first;
+    }
+  }
+
+  return "";
+}
+
+// Throws on transport errors as well as on replies that aren't a success
+void call(Method method, CryptoNote::HttpClient& daemon, CryptoNote::HttpClient& walletd, const LoadSettings& settings) {
+  using namespace CryptoNote;
+
+  std::string status = CORE_RPC_STATUS_OK;
+  switch (method) {
+  case Method::GetBlockTemplate: {
+    COMMAND_RPC_GETBLOCKTEMPLATE::request req;
+    COMMAND_RPC_GETBLOCKTEMPLATE::response res;
+    req.reserve_size = 8;
+    req.wallet_address = settings.address;
+    invokeJsonRpcCommand(daemon, "getblocktemplate", req, res, settings.user, settings.password);
+    status = res.status;
+    break;
+  }
+  case Method::GetRandomOuts: {
+    COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request req;
+    COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response res;
+    req.amounts.push_back(settings.amount);
+    req.outs_count = settings.outsCount;
+    invokeBinaryCommand(daemon, "/getrandom_outs.bin", req, res, settings.user, settings.password);
+    status = res.status;
+    break;
+  }
+  case Method::QueryBlocksLite: {
+    // a wallet that starts from scratch
+    COMMAND_RPC_QUERY_BLOCKS_LITE::request req;
+    COMMAND_RPC_QUERY_BLOCKS_LITE::response res;
+    req.blockIds.push_back(settings.genesisHash);
+    req.timestamp = 0;
+    invokeBinaryCommand(daemon, "/queryblockslite.bin", req, res, settings.user, settings.password);
+    status = res.status;
+    break;
+  }
+  case Method::GetTransactions: {
+    PaymentService::GetTransactions::Request req;
+    PaymentService::GetTransactions::Response res;
+    req.firstBlockIndex = 0;
+    req.blockCount = settings.blockCount;
+    invokeJsonRpcCommand(walletd, "getTransactions", req, res, settings.user, settings.password);
+    break;
+  }
+  case Method::SendTransaction: {
+    PaymentService::SendTransaction::Request req;
+    PaymentService::SendTransaction::Response res;
+    PaymentService::WalletRpcOrder order;
+    order.address = settings.address;
+    order.amount = settings.amount;
+    req.transfers.push_back(order);
+    req.fee = CryptoNote::parameters::MINIMUM_FEE;
+    req.anonymity = settings.anonymity;
+    invokeJsonRpcCommand(walletd, "sendTransaction", req, res, settings.user, settings.password);
+    break;
+  }
+  }
+
+  if (status != CORE_RPC_STATUS_OK) {
+    throw std::runtime_error("status: " + status);
+  }
+}
+
+// nearest rank, the samples are sorted
+double percentile(const std::vector<uint64_t>& samples, double p) {
+  size_t rank = static_cast<size_t>(std::ceil(p / 100 * samples.size()));
+  return samples[std::max<size_t>(rank, 1) - 1] / 1e6;
+}
+
+void printReport(std::map<Method, MethodStats>& stats, double seconds, bool fixedRate) {
+  std::cout << std::left << std::setw(18) << "method" << std::right << std::setw(8) << "calls" << std::setw(8) << "errors" << std::setw(10) << "calls/s" <<
+    std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms" << std::setw(10) << "p99 ms" << std::setw(10) << "max ms" << std::endl;
+  std::cout << std::fixed << std::setprecision(2);
+  for (auto& entry : stats) {
+    MethodStats& methodStats = entry.second;
+    size_t errors = 0;
+    for (const auto& error : methodStats.errors) {
+      errors += error.second;
+    }
+
+    std::vector<uint64_t>& samples = methodStats.latencies;
+    std::sort(samples.begin(), samples.end());
+    std::cout << std::left << std::setw(18) << methodName(entry.first) << std::right << std::setw(8) << samples.size() + errors << std::setw(8) << errors <<
+      std::setw(10) << (samples.size() + errors) / seconds;
+    if (!samples.empty()) {
+      std::cout << std::setw(10) << percentile(samples, 50) << std::setw(10) << percentile(samples, 90) << std::setw(10) << percentile(samples, 99) <<
+        std::setw(10) << samples.back() / 1e6;
+    }
+
+    std::cout << std::endl;
+    for (const auto& error : methodStats.errors) {
+      std::cout << "  " << error.second << " x " << error.first << std::endl;
+    }
+  }
+
+  if (fixedRate) {
+    std::cout << "Latencies count from the scheduled send time, so they include the time a call waited for a busy client" << std::endl;
+  }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  po::options_description desc_options("Allowed options");
+  command_line::add_arg(desc_options, command_line::arg_help);
+  command_line::add_arg(desc_options, arg_daemon);
+  command_line::add_arg(desc_options, arg_walletd);
+  command_line::add_arg(desc_options, arg_rpc_user);
+  command_line::add_arg(desc_options, arg_rpc_password);
+  command_line::add_arg(desc_options, arg_mix);
+  command_line::add_arg(desc_options, arg_concurrency);
+  command_line::add_arg(desc_options, arg_rate);
+  command_line::add_arg(desc_options, arg_duration);
+  command_line::add_arg(desc_options, arg_testnet);
+  command_line::add_arg(desc_options, arg_address);
+  command_line::add_arg(desc_options, arg_amount);
+  command_line::add_arg(desc_options, arg_outs_count);
+  command_line::add_arg(desc_options, arg_block_count);
+  command_line::add_arg(desc_options, arg_anonymity);
+
+  po::variables_map vm;
+  bool r = command_line::handle_error_helper(desc_options, [&]() {
+    po::store(po::parse_command_line(argc, argv, desc_options), vm);
+    po::notify(vm);
+    return true;
+  });
+
+  if (!r) {
+    return 1;
+  }
+
+  if (command_line::get_arg(vm, command_line::arg_help)) {
+    std::cout << desc_options << std::endl;
+    return 0;
+  }
+
+  std::string daemonHost;
+  uint16_t daemonPort;
+  std::string walletdHost;
+  uint16_t walletdPort;
+  if (!parseHost(command_line::get_arg(vm, arg_daemon), daemonHost, daemonPort) || !parseHost(command_line::get_arg(vm, arg_walletd), walletdHost, walletdPort)) {
+    std::cout << "Addresses must be given as host:port" << std::endl;
+    return 1;
+  }
+
+  std::vector<Method> methods;
+  std::vector<double> weights;
+  if (!parseMix(command_line::get_arg(vm, arg_mix), methods, weights)) {
+    return 1;
+  }
+
+  LoadSettings settings;
+  settings.user = command_line::get_arg(vm, arg_rpc_user);
+  settings.password = command_line::get_arg(vm, arg_rpc_password);
+  settings.address = command_line::get_arg(vm, arg_address);
+  settings.amount = command_line::get_arg(vm, arg_amount);
+  settings.outsCount = command_line::get_arg(vm, arg_outs_count);
+  settings.blockCount = command_line::get_arg(vm, arg_block_count);
+  settings.anonymity = command_line::get_arg(vm, arg_anonymity);
+
+  bool needsAddress = std::find(methods.begin(), methods.end(), Method::GetBlockTemplate) != methods.end() ||
+    std::find(methods.begin(), methods.end(), Method::SendTransaction) != methods.end();
+  if (needsAddress && settings.address.empty()) {
+    std::cout << "getblocktemplate and sendTransaction need --" << arg_address.name << std::endl;
+    return 1;
+  }
+
+  uint32_t concurrency = std::max<uint32_t>(command_line::get_arg(vm, arg_concurrency), 1);
+  double rate = command_line::get_arg(vm, arg_rate);
+  auto duration = std::chrono::seconds(command_line::get_arg(vm, arg_duration));
+
+  try {
+    Logging::ConsoleLogger logger(Logging::WARNING);
+    CryptoNote::CurrencyBuilder currencyBuilder(logger);
+    currencyBuilder.testnet(command_line::get_arg(vm, arg_testnet));
+    settings.genesisHash = currencyBuilder.currency().genesisBlockHash();
+
+    System::Dispatcher dispatcher;
+    System::ContextGroup clients(dispatcher);
+    std::map<Method, MethodStats> stats;
+    uint64_t unsent = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + duration;
+
+    for (uint32_t i = 0; i < concurrency; ++i) {
+      clients.spawn([&, i] {
+        CryptoNote::HttpClient daemon(dispatcher, daemonHost, daemonPort, false);
+        CryptoNote::HttpClient walletd(dispatcher, walletdHost, walletdPort, false);
+        std::mt19937 generator(i);
+        std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+        System::Timer timer(dispatcher);
+
+        // at a fixed rate each client sends every concurrency / rate seconds, the
+        // clients being evenly offset from each other
+        std::chrono::steady_clock::duration interval = rate > 0 ?
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(concurrency / rate)) : std::chrono::steady_clock::duration::zero();
+        auto scheduled = start + interval * i / concurrency;
+
+        for (;;) {
+          auto now = std::chrono::steady_clock::now();
+          if (rate > 0) {
+            if (scheduled > now) {
+              timer.sleep(scheduled - now);
+            }
+          } else {
+            scheduled = now;
+          }
+
+          if (scheduled >= end) {
+            break;
+          }
+
+          // the calls a client is still behind with at the end are not sent
+          if (std::chrono::steady_clock::now() >= end) {
+            unsent += (end - scheduled) / interval + 1;
+            break;
+          }
+
+          Method method = methods[pick(generator)];
+          try {
+            call(method, daemon, walletd, settings);
+            stats[method].latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - scheduled).count());
+          } catch (std::exception& e) {
+            ++stats[method].errors[e.what()];
+          }
+
+          scheduled += interval;
+        }
+      });
+    }
+
+    clients.wait();
+    double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start).count();
+    std::cout << concurrency << " clients, ";
+    if (rate > 0) {
+      std::cout << rate << " calls/s";
+    } else {
+      std::cout << "unthrottled";
+    }
+
+    std::cout << ", " << std::fixed << std::setprecision(1) << seconds << " s" << std::endl;
+    printReport(stats, seconds, rate > 0);
+    if (unsent != 0) {
+      std::cout << unsent << " scheduled calls weren't sent, the servers or the clients couldn't keep up with the rate" << std::endl;
+    }
+  } catch (std::exception& e) {
+    std::cout << "Exception: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,229 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+// Replays the blocks of an existing blocks.dat into a fresh Core the way the
+// protocol handler does during synchronization and reports the import speed.
+// The source must not be in use by a running daemon.
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "Checkpoints/Checkpoints.h"
+#include "Checkpoints/CheckpointsData.h"
+#include "Common/CommandLine.h"
+#include "CryptoNoteCore/BlockStore.h"
+#include "CryptoNoteCore/Core.h"
+#include "CryptoNoteCore/CoreConfig.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/MinerConfig.h"
+#include "CryptoNoteCore/VerificationContext.h"
+#include "Logging/ConsoleLogger.h"
+#include "System/Dispatcher.h"
+
+namespace po = boost::program_options;
+
+namespace {
+
+const command_line::arg_descriptor<std::string> arg_blocks = { "blocks", "<file> blocks.dat of a stopped daemon, with its .index and .txs files", "" };
+const command_line::arg_descriptor<std::string> arg_work_dir = { "work-dir", "<dir> Folder for the imported chain, removed before and after the run", "sync_benchmark" };
+const command_line::arg_descriptor<uint32_t> arg_start_height = { "start-height", "Blocks below this height are imported before the measurement starts", 1 };
+const command_line::arg_descriptor<uint32_t> arg_count = { "count", "Number of measured blocks, 0 for all", 0 };
+const command_line::arg_descriptor<bool> arg_testnet = { "testnet", "The blocks are from the test net" };
+const command_line::arg_descriptor<bool> arg_without_checkpoints = { "without-checkpoints", "Validate the blocks in full, as above the last checkpoint" };
+
+// blob access of BlockStore doesn't need the entries to be deserialized
+struct RawEntry {
+};
+
+uint64_t peakResidentSize() {
+#ifdef _WIN32
+  return 0;
+#else
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+
+#ifdef __APPLE__
+  return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+  return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+bool importBlock(CryptoNote::Core& core, CryptoNote::BlockStore<RawEntry>& source, uint32_t height, size_t& transactions) {
+  CryptoNote::BlockStoreIndexEntry header = source.header(height);
+  // the first stored transaction is the base transaction, which is part of the block blob
+  for (uint32_t i = 1; i < header.transactionCount; ++i) {
+    Common::ArrayView<uint8_t> blob = source.transactionBlob(height, i);
+    CryptoNote::tx_verification_context tvc = boost::value_initialized<CryptoNote::tx_verification_context>();
+    core.handle_incoming_tx(CryptoNote::BinaryArray(blob.getData(), blob.getData() + blob.getSize()), tvc, true);
+    if (tvc.m_verification_failed) {
+      std::cout << "Transaction " << i << " of block " << height << " failed verification" << std::endl;
+      return false;
+    }
+  }
+
+  Common::ArrayView<uint8_t> blob = source.blockBlob(height);
+  CryptoNote::block_verification_context bvc = boost::value_initialized<CryptoNote::block_verification_context>();
+  core.handle_incoming_block_blob(CryptoNote::BinaryArray(blob.getData(), blob.getData() + blob.getSize()), bvc, false, false);
+  if (!bvc.m_added_to_main_chain) {
+    std::cout << "Block " << height << " wasn't added to the main chain" << std::endl;
+    return false;
+  }
+
+  transactions += header.transactionCount - 1;
+  return true;
+}
+
+// picks the per stage totals out of the block validation histograms
+void printStageTimes(CryptoNote::Core& core) {
+  std::ostringstream metrics;
+  core.writeMetrics(metrics);
+  std::istringstream lines(metrics.str());
+  const std::string prefix = "karbo_block_validation_seconds_sum{stage=\"";
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (line.compare(0, prefix.size(), prefix) == 0) {
+      size_t end = line.find('"', prefix.size());
+      std::cout << "  " << std::left << std::setw(17) << line.substr(prefix.size(), end - prefix.size()) << line.substr(line.rfind(' ') + 1) << " s" << std::endl;
+    }
+  }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  po::options_description desc_options("Allowed options");
+  command_line::add_arg(desc_options, command_line::arg_help);
+  command_line::add_arg(desc_options, arg_blocks);
+  command_line::add_arg(desc_options, arg_work_dir);
+  command_line::add_arg(desc_options, arg_start_height);
+  command_line::add_arg(desc_options, arg_count);
+  command_line::add_arg(desc_options, arg_testnet);
+  command_line::add_arg(desc_options, arg_without_checkpoints);
+
+  po::variables_map vm;
+  bool r = command_line::handle_error_helper(desc_options, [&]() {
+    po::store(po::parse_command_line(argc, argv, desc_options), vm);
+    po::notify(vm);
+    return true;
+  });
+
+  if (!r) {
+    return 1;
+  }
+
+  if (command_line::get_arg(vm, command_line::arg_help) || command_line::get_arg(vm, arg_blocks).empty()) {
+    std::cout << desc_options << std::endl;
+    return command_line::get_arg(vm, command_line::arg_help) ? 0 : 1;
+  }
+
+  try {
+    CryptoNote::BlockStore<RawEntry> source;
+    if (!source.open(command_line::get_arg(vm, arg_blocks), 1)) {
+      std::cout << "Failed to open " << command_line::get_arg(vm, arg_blocks) << std::endl;
+      return 1;
+    }
+
+    uint32_t startHeight = std::max<uint32_t>(command_line::get_arg(vm, arg_start_height), 1);
+    uint32_t endHeight = static_cast<uint32_t>(source.size());
+    uint32_t count = command_line::get_arg(vm, arg_count);
+    if (count != 0 && static_cast<uint64_t>(startHeight) + count < endHeight) {
+      endHeight = startHeight + count;
+    }
+
+    if (startHeight >= endHeight) {
+      std::cout << "The source has " << source.size() << " blocks, nothing to measure" << std::endl;
+      return 1;
+    }
+
+    Logging::ConsoleLogger logger(Logging::WARNING);
+    CryptoNote::CurrencyBuilder currencyBuilder(logger);
+    currencyBuilder.testnet(command_line::get_arg(vm, arg_testnet));
+    CryptoNote::Currency currency = currencyBuilder.currency();
+
+    boost::filesystem::path workDir(command_line::get_arg(vm, arg_work_dir));
+    boost::filesystem::remove_all(workDir);
+
+    System::Dispatcher dispatcher;
+    size_t transactions = 0;
+    size_t measuredTransactions = 0;
+    {
+      CryptoNote::Core core(currency, nullptr, logger, dispatcher, false);
+      if (!command_line::get_arg(vm, arg_without_checkpoints) && !command_line::get_arg(vm, arg_testnet)) {
+        CryptoNote::Checkpoints checkpoints(logger);
+        for (const auto& cp : CryptoNote::CHECKPOINTS) {
+          checkpoints.add_checkpoint(cp.height, cp.blockId);
+        }
+
+        core.set_checkpoints(std::move(checkpoints));
+      }
+
+      CryptoNote::CoreConfig coreConfig;
+      coreConfig.configFolder = workDir.string();
+      CryptoNote::MinerConfig minerConfig;
+      if (!core.init(coreConfig, minerConfig, false)) {
+        std::cout << "Failed to initialize core" << std::endl;
+        return 1;
+      }
+
+      bool imported = true;
+      for (uint32_t height = 1; imported && height < startHeight; ++height) {
+        imported = importBlock(core, source, height, transactions);
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      for (uint32_t height = startHeight; imported && height < endHeight; ++height) {
+        imported = importBlock(core, source, height, measuredTransactions);
+      }
+
+      std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+      if (imported) {
+        double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(elapsed).count();
+        std::cout << "Imported blocks " << startHeight << " - " << endHeight - 1 << (command_line::get_arg(vm, arg_without_checkpoints) ? " without" : " with") <<
+          " checkpoints in " << std::fixed << std::setprecision(3) << seconds << " s" << std::endl;
+        std::cout << "  blocks/s         " << (endHeight - startHeight) / seconds << std::endl;
+        std::cout << "  tx/s             " << measuredTransactions / seconds << std::endl;
+        std::cout << "  peak RSS         " << peakResidentSize() / (1024 * 1024) << " MiB" << std::endl;
+        std::cout << "Time per validation stage, including the genesis and warm-up blocks:" << std::endl;
+        printStageTimes(core);
+      }
+
+      core.deinit();
+      boost::filesystem::remove_all(workDir);
+      if (!imported) {
+        return 1;
+      }
+    }
+  } catch (std::exception& e) {
+    std::cout << "Exception: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
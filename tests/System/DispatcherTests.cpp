@@ -15,8 +15,12 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <cstring>
 #include <future>
+#include <iostream>
+#include <thread>
 #include <System/Context.h>
+#include <System/ContextGroup.h>
 #include <System/Dispatcher.h>
 #include <System/Event.h>
 #include <System/Timer.h>
@@ -386,3 +390,91 @@ TEST_F(DispatcherTests, yieldExecutesIoOnItsFront) {
   dispatcher.yield();
   ASSERT_TRUE(spawnDone);
 }
+
+TEST_F(DispatcherTests, DISABLED_contextSwitchRate) {
+  // two contexts hand control to each other through events, every handoff is a single switch
+  const size_t ROUNDS = 500000;
+  Event ping(dispatcher);
+  Event pong(dispatcher);
+  Context<> context(dispatcher, [&]() {
+    for (size_t i = 0; i < ROUNDS; ++i) {
+      ping.wait();
+      ping.clear();
+      pong.set();
+    }
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < ROUNDS; ++i) {
+    ping.set();
+    pong.wait();
+    pong.clear();
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  context.get();
+  std::cout << "context switches per second: " << (elapsed > 0 ? 2 * ROUNDS * 1000000 / elapsed : 0) << std::endl;
+}
+
+TEST_F(DispatcherTests, contextGroupRunsOnRequestedStackSize) {
+  bool done = false;
+  ContextGroup group(dispatcher, 64 * 1024);
+  group.spawn([&]() {
+    char buffer[32 * 1024];
+    memset(buffer, 1, sizeof(buffer));
+    done = buffer[sizeof(buffer) - 1] == 1;
+  });
+
+  group.wait();
+  ASSERT_TRUE(done);
+}
+
+#ifdef __linux__
+TEST_F(DispatcherTests, contextsAreReusedByStackSize) {
+  ContextGroup small(dispatcher, 64 * 1024);
+  ContextGroup large(dispatcher);
+  small.spawn([]() {});
+  small.wait();
+  ASSERT_EQ(1, dispatcher.getContextCount());
+  ASSERT_EQ(64 * 1024, dispatcher.getStackMemory());
+
+  large.spawn([]() {});
+  large.wait();
+  ASSERT_EQ(2, dispatcher.getContextCount());
+  ASSERT_EQ(64 * 1024 + Dispatcher::DEFAULT_STACK_SIZE, dispatcher.getStackMemory());
+
+  small.spawn([]() {});
+  small.wait();
+  ASSERT_EQ(2, dispatcher.getContextCount());
+  ASSERT_EQ(2, dispatcher.getReusableContextCount());
+}
+
+TEST_F(DispatcherTests, reusableContextsAreBounded) {
+  dispatcher.setMaxReusableContexts(2);
+  Event event(dispatcher);
+  ContextGroup group(dispatcher, 64 * 1024);
+  for (int i = 0; i < 10; ++i) {
+    group.spawn([&]() {
+      event.wait();
+    });
+  }
+
+  dispatcher.yield();
+  ASSERT_EQ(10, dispatcher.getContextCount());
+  ASSERT_EQ(0, dispatcher.getReusableContextCount());
+
+  event.set();
+  group.wait();
+  ASSERT_EQ(2, dispatcher.getContextCount());
+  ASSERT_EQ(2, dispatcher.getReusableContextCount());
+  ASSERT_EQ(2 * 64 * 1024, dispatcher.getStackMemory());
+
+  bool spawnDone = false;
+  group.spawn([&]() {
+    spawnDone = true;
+  });
+
+  group.wait();
+  ASSERT_TRUE(spawnDone);
+}
+#endif
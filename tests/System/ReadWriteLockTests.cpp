@@ -0,0 +1,90 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <System/Context.h>
+#include <System/Dispatcher.h>
+#include <System/Event.h>
+#include <System/ReadWriteLock.h>
+#include <gtest/gtest.h>
+
+using namespace System;
+
+TEST(ReadWriteLockTests, readersShareTheLock) {
+  Dispatcher dispatcher;
+  ReadWriteLock rwLock(dispatcher);
+  Event event(dispatcher);
+  size_t inside = 0;
+  auto reader = [&]() {
+    SharedLock lock(rwLock);
+    ++inside;
+    event.wait();
+  };
+
+  Context<> context1(dispatcher, reader);
+  Context<> context2(dispatcher, reader);
+  dispatcher.yield();
+  ASSERT_EQ(2, inside);
+  event.set();
+}
+
+TEST(ReadWriteLockTests, writerExcludesReaders) {
+  Dispatcher dispatcher;
+  ReadWriteLock rwLock(dispatcher);
+  Event event(dispatcher);
+  bool readerDone = false;
+  Context<> writer(dispatcher, [&]() {
+    ExclusiveLock lock(rwLock);
+    event.wait();
+  });
+
+  dispatcher.yield();
+  Context<> reader(dispatcher, [&]() {
+    SharedLock lock(rwLock);
+    readerDone = true;
+  });
+
+  dispatcher.yield();
+  ASSERT_FALSE(readerDone);
+  event.set();
+  writer.get();
+  reader.get();
+  ASSERT_TRUE(readerDone);
+}
+
+TEST(ReadWriteLockTests, writerWaitsForReaders) {
+  Dispatcher dispatcher;
+  ReadWriteLock rwLock(dispatcher);
+  Event event(dispatcher);
+  bool writerDone = false;
+  Context<> reader(dispatcher, [&]() {
+    SharedLock lock(rwLock);
+    event.wait();
+  });
+
+  dispatcher.yield();
+  Context<> writer(dispatcher, [&]() {
+    ExclusiveLock lock(rwLock);
+    writerDone = true;
+  });
+
+  dispatcher.yield();
+  ASSERT_FALSE(writerDone);
+  event.set();
+  reader.get();
+  writer.get();
+  ASSERT_TRUE(writerDone);
+}
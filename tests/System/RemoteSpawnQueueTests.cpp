@@ -0,0 +1,94 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <thread>
+#include <vector>
+#include <System/Dispatcher.h>
+#include <System/Event.h>
+#include <System/RemoteSpawnQueue.h>
+#include <gtest/gtest.h>
+
+using namespace System;
+
+TEST(RemoteSpawnQueueTests, keepsOrderThroughOverflow) {
+  RemoteSpawnQueue queue;
+  std::vector<size_t> order;
+  const size_t COUNT = RemoteSpawnQueue::CAPACITY + 100;
+  for (size_t i = 0; i < COUNT; ++i) {
+    queue.push([&order, i] { order.push_back(i); });
+  }
+
+  std::function<void()> procedure;
+  while (queue.pop(procedure)) {
+    procedure();
+  }
+
+  ASSERT_EQ(COUNT, order.size());
+  for (size_t i = 0; i < COUNT; ++i) {
+    ASSERT_EQ(i, order[i]);
+  }
+}
+
+TEST(RemoteSpawnQueueTests, asksForOneWakeUpPerDrain) {
+  RemoteSpawnQueue queue;
+  ASSERT_TRUE(queue.push([] {}));
+  ASSERT_FALSE(queue.push([] {}));
+  queue.rearm();
+  ASSERT_TRUE(queue.push([] {}));
+
+  std::function<void()> procedure;
+  size_t count = 0;
+  while (queue.pop(procedure)) {
+    ++count;
+  }
+
+  ASSERT_EQ(3, count);
+  ASSERT_FALSE(queue.pop(procedure));
+}
+
+TEST(RemoteSpawnQueueTests, concurrentProducersKeepTheirOrder) {
+  const size_t PRODUCERS = 4;
+  const size_t POSTS = 1000;
+  Dispatcher dispatcher;
+  Event done(dispatcher);
+  std::vector<size_t> last(PRODUCERS, 0);
+  size_t received = 0;
+  bool ordered = true;
+
+  std::vector<std::thread> producers;
+  for (size_t producer = 0; producer < PRODUCERS; ++producer) {
+    producers.emplace_back([&, producer] {
+      for (size_t i = 1; i <= POSTS; ++i) {
+        dispatcher.remoteSpawn([&, producer, i] {
+          ordered = ordered && last[producer] + 1 == i;
+          last[producer] = i;
+          if (++received == PRODUCERS * POSTS) {
+            done.set();
+          }
+        });
+      }
+    });
+  }
+
+  done.wait();
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  ASSERT_TRUE(ordered);
+  ASSERT_EQ(PRODUCERS * POSTS, received);
+}
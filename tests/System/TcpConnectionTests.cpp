@@ -89,6 +89,21 @@ TEST_F(TcpConnectionTests, sendAndClose) {
   ASSERT_EQ(0, size);
 }
 
+TEST_F(TcpConnectionTests, sendGatheredBuffers) {
+  connect();
+  std::pair<const uint8_t*, size_t> buffers[] = {
+    { reinterpret_cast<const uint8_t*>("Te"), 2 },
+    { reinterpret_cast<const uint8_t*>(""), 0 },
+    { reinterpret_cast<const uint8_t*>("st"), 2 }
+  };
+
+  ASSERT_EQ(4, connection1.writev(buffers, 3));
+  uint8_t data[1024];
+  size_t size = connection2.read(data, 1024);
+  ASSERT_EQ(4, size);
+  ASSERT_EQ(0, memcmp(data, "Test", 4));
+}
+
 TEST_F(TcpConnectionTests, stoppedState) {
   connect();
   bool stopped = false;
@@ -0,0 +1,139 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <System/ContextGroup.h>
+#include <System/Dispatcher.h>
+#include <System/RemoteContext.h>
+#include <System/ThreadPool.h>
+#include <System/Timer.h>
+#include <gtest/gtest.h>
+
+using namespace System;
+
+namespace {
+
+size_t fibonacci(ThreadPool& pool, size_t n) {
+  if (n < 2) {
+    return n;
+  }
+
+  size_t left = 0;
+  TaskGroup group(pool);
+  group.run([&] { left = fibonacci(pool, n - 1); });
+  size_t right = fibonacci(pool, n - 2);
+  group.wait();
+  return left + right;
+}
+
+}
+
+TEST(ThreadPoolTests, runsPostedTasks) {
+  std::atomic<size_t> done(0);
+  {
+    ThreadPool pool(4);
+    for (size_t i = 0; i < 1000; ++i) {
+      pool.post([&] { ++done; });
+    }
+  }
+
+  ASSERT_EQ(1000, done.load());
+}
+
+TEST(ThreadPoolTests, nestedGroupsDoNotDeadlock) {
+  ThreadPool pool(2);
+  ASSERT_EQ(6765, fibonacci(pool, 20));
+}
+
+TEST(ThreadPoolTests, groupRethrowsTaskException) {
+  ThreadPool pool(2);
+  std::atomic<size_t> done(0);
+  TaskGroup group(pool);
+  for (size_t i = 0; i < 10; ++i) {
+    group.run([&, i] {
+      if (i == 5) {
+        throw std::runtime_error("task failed");
+      }
+
+      ++done;
+    });
+  }
+
+  ASSERT_THROW(group.wait(), std::runtime_error);
+  ASSERT_EQ(9, done.load());
+  ASSERT_NO_THROW(group.wait());
+}
+
+TEST(ThreadPoolTests, parallelForVisitsEveryIndexOnce) {
+  ThreadPool pool(3);
+  std::vector<std::atomic<int>> visits(1001);
+  for (auto& visit : visits) {
+    visit = 0;
+  }
+
+  parallelFor(0, visits.size(), [&](size_t i) { ++visits[i]; }, pool);
+  for (auto& visit : visits) {
+    ASSERT_EQ(1, visit.load());
+  }
+}
+
+TEST(ThreadPoolTests, parallelForRunsSmallRangeOnCallingThread) {
+  ThreadPool pool(2);
+  std::thread::id caller = std::this_thread::get_id();
+  size_t foreign = 0;
+  parallelFor(0, 8, [&](size_t) {
+    if (std::this_thread::get_id() != caller) {
+      ++foreign;
+    }
+  }, pool, 8);
+
+  ASSERT_EQ(0, foreign);
+}
+
+TEST(ThreadPoolTests, remoteContextRunsOnPoolWithoutBlockingDispatcher) {
+  Dispatcher dispatcher;
+  ThreadPool pool(1);
+  std::atomic<bool> release(false);
+  bool timerFired = false;
+  RemoteContext<int> context(dispatcher, pool, [&] {
+    while (!release) {
+      std::this_thread::yield();
+    }
+
+    return 42;
+  });
+
+  ContextGroup group(dispatcher);
+  group.spawn([&] {
+    Timer(dispatcher).sleep(std::chrono::milliseconds(10));
+    timerFired = true;
+    release = true;
+  });
+
+  ASSERT_EQ(42, context.get());
+  ASSERT_TRUE(timerFired);
+  group.wait();
+}
+
+TEST(ThreadPoolTests, remoteContextRethrowsOnDispatcher) {
+  Dispatcher dispatcher;
+  RemoteContext<> context(dispatcher, ThreadPool::shared(), [] { throw std::runtime_error("failed"); });
+  ASSERT_THROW(context.get(), std::runtime_error);
+}
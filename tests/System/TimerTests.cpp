@@ -15,7 +15,9 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
 #include <thread>
+#include <vector>
 #include <System/Context.h>
 #include <System/Dispatcher.h>
 #include <System/ContextGroup.h>
@@ -278,3 +280,42 @@ TEST_F(TimerTests, timerWithZeroTimeIsYielding) {
   Timer(dispatcher).sleep(std::chrono::milliseconds(0));
   ASSERT_TRUE(done);
 }
+
+TEST_F(TimerTests, timersFireInDeadlineOrder) {
+  // spans the first two wheel levels, the longer ones have to cascade before firing
+  const int durations[] = { 130, 3, 70, 1, 64, 200, 65, 20, 5, 128 };
+  std::vector<int> fired;
+  for (int duration : durations) {
+    contextGroup.spawn([&, duration] {
+      Timer(dispatcher).sleep(std::chrono::milliseconds(duration));
+      fired.push_back(duration);
+    });
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  contextGroup.wait();
+  ASSERT_LE(200, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count());
+  std::vector<int> expected(std::begin(durations), std::end(durations));
+  std::sort(expected.begin(), expected.end());
+  ASSERT_EQ(expected, fired);
+}
+
+TEST_F(TimerTests, interruptedTimerLeavesOthersPending) {
+  bool longDone = false;
+  ContextGroup interrupted(dispatcher);
+  interrupted.spawn([&] {
+    ASSERT_THROW(Timer(dispatcher).sleep(std::chrono::milliseconds(50)), InterruptedException);
+  });
+
+  contextGroup.spawn([&] {
+    Timer(dispatcher).sleep(std::chrono::milliseconds(100));
+    longDone = true;
+  });
+
+  Timer(dispatcher).sleep(std::chrono::milliseconds(10));
+  interrupted.interrupt();
+  interrupted.wait();
+  ASSERT_FALSE(longDone);
+  contextGroup.wait();
+  ASSERT_TRUE(longDone);
+}
@@ -79,6 +79,15 @@ bool ICoreStub::get_tx_outputs_gindexs(const Crypto::Hash& tx_id, std::vector<ui
   return globalIndicesResult;
 }
 
+bool ICoreStub::getTransactionsOutputGlobalIndexes(const std::vector<Crypto::Hash>& txIds, std::vector<std::vector<uint32_t>>& indexes) {
+  indexes.assign(txIds.size(), globalIndices);
+  return globalIndicesResult;
+}
+
+void ICoreStub::getBlockHeightsByTimestamps(const std::vector<uint64_t>& timestamps, std::vector<uint32_t>& heights) {
+  heights.assign(timestamps.size(), 0);
+}
+
 CryptoNote::i_cryptonote_protocol* ICoreStub::get_protocol() {
   return nullptr;
 }
@@ -87,6 +96,10 @@ bool ICoreStub::handle_incoming_tx(CryptoNote::BinaryArray const& tx_blob, Crypt
   return true;
 }
 
+void ICoreStub::handle_incoming_txs(const std::vector<CryptoNote::BinaryArray>& tx_blobs, std::vector<CryptoNote::tx_verification_context>& tvcs) {
+  tvcs.assign(tx_blobs.size(), CryptoNote::tx_verification_context());
+}
+
 void ICoreStub::set_blockchain_top(uint32_t height, const Crypto::Hash& top_id) {
   topHeight = height;
   topId = top_id;
@@ -154,8 +167,13 @@ bool ICoreStub::queryBlocks(const std::vector<Crypto::Hash>& block_ids, uint64_t
   return true;
 }
 
+bool ICoreStub::getBlockFilters(const std::vector<Crypto::Hash>& knownBlockIds, uint32_t count, uint32_t& startHeight,
+  std::vector<CryptoNote::BlockFilterInfo>& filters) {
+  return false;
+}
+
 bool ICoreStub::queryBlocksLite(const std::vector<Crypto::Hash>& block_ids, uint64_t timestamp,
-  uint32_t& start_height, uint32_t& current_height, uint32_t& full_offset, std::vector<CryptoNote::BlockShortInfo>& entries) {
+  uint32_t& start_height, uint32_t& current_height, uint32_t& full_offset, std::vector<CryptoNote::BlockShortInfo>& entries, bool withGlobalIndexes) {
   //stub
   return true;
 }
@@ -246,6 +264,26 @@ void ICoreStub::getTransactions(const std::vector<Crypto::Hash>& txs_ids, std::l
   }
 }
 
+bool ICoreStub::getTransaction(const Crypto::Hash& id, CryptoNote::Transaction& tx, bool checkTxPool) {
+  auto iter = transactions.find(id);
+  if (iter != transactions.end()) {
+    tx = iter->second;
+    return true;
+  }
+
+  return checkTxPool && getPoolTransaction(id, tx);
+}
+
+bool ICoreStub::getPoolTransaction(const Crypto::Hash& tx_hash, CryptoNote::Transaction& transaction) {
+  auto iter = transactionPool.find(tx_hash);
+  if (iter == transactionPool.end()) {
+    return false;
+  }
+
+  transaction = iter->second;
+  return true;
+}
+
 bool ICoreStub::getBackwardBlocksSizes(uint32_t fromHeight, std::vector<size_t>& sizes, size_t count) {
   return true;
 }
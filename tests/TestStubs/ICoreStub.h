@@ -40,8 +40,11 @@ public:
   virtual bool get_random_outs_for_amounts(const CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_request& req,
       CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_response& res) override;
   virtual bool get_tx_outputs_gindexs(const Crypto::Hash& tx_id, std::vector<uint32_t>& indexs) override;
+  virtual bool getTransactionsOutputGlobalIndexes(const std::vector<Crypto::Hash>& txIds, std::vector<std::vector<uint32_t>>& indexes) override;
+  virtual void getBlockHeightsByTimestamps(const std::vector<uint64_t>& timestamps, std::vector<uint32_t>& heights) override;
   virtual CryptoNote::i_cryptonote_protocol* get_protocol() override;
   virtual bool handle_incoming_tx(CryptoNote::BinaryArray const& tx_blob, CryptoNote::tx_verification_context& tvc, bool keeped_by_block) override;
+  virtual void handle_incoming_txs(const std::vector<CryptoNote::BinaryArray>& tx_blobs, std::vector<CryptoNote::tx_verification_context>& tvcs) override;
   virtual std::vector<CryptoNote::Transaction> getPoolTransactions() override;
   virtual bool getPoolChanges(const Crypto::Hash& tailBlockId, const std::vector<Crypto::Hash>& knownTxsIds,
                               std::vector<CryptoNote::Transaction>& addedTxs, std::vector<Crypto::Hash>& deletedTxsIds) override;
@@ -52,7 +55,9 @@ public:
   virtual bool queryBlocks(const std::vector<Crypto::Hash>& block_ids, uint64_t timestamp,
     uint32_t& start_height, uint32_t& current_height, uint32_t& full_offset, std::vector<CryptoNote::BlockFullInfo>& entries) override;
   virtual bool queryBlocksLite(const std::vector<Crypto::Hash>& block_ids, uint64_t timestamp,
-    uint32_t& start_height, uint32_t& current_height, uint32_t& full_offset, std::vector<CryptoNote::BlockShortInfo>& entries) override;
+    uint32_t& start_height, uint32_t& current_height, uint32_t& full_offset, std::vector<CryptoNote::BlockShortInfo>& entries, bool withGlobalIndexes) override;
+  virtual bool getBlockFilters(const std::vector<Crypto::Hash>& knownBlockIds, uint32_t count, uint32_t& startHeight,
+    std::vector<CryptoNote::BlockFilterInfo>& filters) override;
 
   virtual bool have_block(const Crypto::Hash& id) override;
   std::vector<Crypto::Hash> buildSparseChain() override;
@@ -62,6 +67,11 @@ public:
   virtual void pause_mining() override {}
   virtual void update_block_template_and_resume_mining() override {}
   virtual bool handle_incoming_block_blob(const CryptoNote::BinaryArray& block_blob, CryptoNote::block_verification_context& bvc, bool control_miner, bool relay_block) override { return false; }
+  virtual void precomputeLongHashes(const std::vector<CryptoNote::Block>& blocks) override {}
+  virtual bool getBlockLongHash(const CryptoNote::Block& block, Crypto::Hash& longHash) override { return false; }
+  virtual void getPoolTransactionIdsByShortIds(const Crypto::Hash& key, const std::vector<uint64_t>& shortIds, std::vector<Crypto::Hash>& transactionIds) override {
+    transactionIds.assign(shortIds.size(), CryptoNote::NULL_HASH);
+  }
   virtual bool handle_get_objects(CryptoNote::NOTIFY_REQUEST_GET_OBJECTS::request& arg, CryptoNote::NOTIFY_RESPONSE_GET_OBJECTS::request& rsp) override { return false; }
   virtual void on_synchronized() override {}
   virtual bool getOutByMSigGIndex(uint64_t amount, uint64_t gindex, CryptoNote::MultisignatureOutput& out) override { return true; }
@@ -98,6 +108,34 @@ public:
   virtual uint8_t getBlockMajorVersionForHeight(uint32_t height) override;
   virtual uint8_t getCurrentBlockMajorVersion() override;
 
+  virtual bool haveTransaction(const Crypto::Hash& id) override { return transactions.count(id) != 0 || transactionPool.count(id) != 0; }
+  virtual bool handle_incoming_block(const CryptoNote::Block& b, CryptoNote::block_verification_context& bvc, bool control_miner, bool relay_block) override { return false; }
+  virtual bool getPoolTransaction(const Crypto::Hash& tx_hash, CryptoNote::Transaction& transaction) override;
+  virtual bool getTransactionHeight(const Crypto::Hash &txId, uint32_t& blockHeight) override { return false; }
+  virtual bool getTransactionsWithOutputGlobalIndexes(const std::vector<Crypto::Hash>& txs_ids, std::list<Crypto::Hash>& missed_txs,
+    std::vector<std::pair<CryptoNote::Transaction, std::vector<uint32_t>>>& txs) override { return false; }
+  virtual bool getTransaction(const Crypto::Hash& id, CryptoNote::Transaction& tx, bool checkTxPool = false) override;
+  virtual bool getBlockCumulativeDifficulty(uint32_t height, CryptoNote::difficulty_type& difficulty) override { return false; }
+  virtual bool getBlockTimestamp(uint32_t height, uint64_t& timestamp) override { return false; }
+  virtual CryptoNote::difficulty_type getAvgDifficulty(uint32_t height, size_t window) override { return 0; }
+  virtual CryptoNote::difficulty_type getAvgDifficulty(uint32_t height) override { return 0; }
+  virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) override { return std::vector<Crypto::Hash>(); }
+  virtual uint64_t getNextBlockDifficulty() override { return 0; }
+  virtual uint64_t getTotalGeneratedAmount() override { return 0; }
+  virtual bool check_tx_fee(const CryptoNote::Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, CryptoNote::tx_verification_context& tvc, uint32_t height) override { return true; }
+  virtual bool check_tx_fee(const CryptoNote::Transaction& tx, const Crypto::Hash& txHash, uint64_t fee, bool isFusionTransaction, CryptoNote::tx_verification_context& tvc, uint32_t height) override { return true; }
+  virtual size_t getPoolTransactionsCount() override { return transactionPool.size(); }
+  virtual size_t getBlockchainTotalTransactions() override { return transactions.size(); }
+  virtual uint32_t getCurrentBlockchainHeight() override { return topHeight; }
+  virtual size_t getAlternativeBlocksCount() override { return 0; }
+  virtual bool getblockEntry(uint32_t height, uint64_t& block_cumulative_size, CryptoNote::difficulty_type& difficulty, uint64_t& already_generated_coins,
+    uint64_t& reward, uint64_t& transactions_count, uint64_t& timestamp) override { return false; }
+  virtual bool getBlockSummary(uint32_t height, CryptoNote::BlockSummary& summary) override { return false; }
+  virtual void rollbackBlockchain(const uint32_t height) override {}
+  virtual bool saveBlockchain() override { return true; }
+  virtual bool getMixin(const CryptoNote::Transaction& transaction, uint64_t& mixin) override { return false; }
+  virtual bool isInCheckpointZone(uint32_t height) const override { return false; }
+
   void set_blockchain_top(uint32_t height, const Crypto::Hash& top_id);
   void set_outputs_gindexs(const std::vector<uint32_t>& indexs, bool result);
   void set_random_outs(const CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_response& resp, bool result);
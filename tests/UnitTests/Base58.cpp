@@ -535,3 +535,27 @@ TEST(parseAccountAddressString, fails_on_invalid_address_view_key)
   CryptoNote::AccountPublicAddress addr;
   ASSERT_FALSE(CryptoNote::parseAccountAddressString(prefix, addr, addr_str));
 }
+
+TEST(parseAccountAddressString, currency_parses_same_address_again)
+{
+  Logging::LoggerGroup logger;
+  CryptoNote::Currency currency = CryptoNote::CurrencyBuilder(logger).publicAddressBase58Prefix(TEST_PUBLIC_ADDRESS_BASE58_PREFIX).currency();
+
+  for (int i = 0; i < 2; ++i) {
+    CryptoNote::AccountPublicAddress addr;
+    ASSERT_TRUE(currency.parseAccountAddressString(test_keys_addr_str, addr));
+    ASSERT_EQ(Common::asString(CryptoNote::storeToBinary(addr)), test_serialized_keys);
+  }
+}
+
+TEST(parseAccountAddressString, currency_checks_prefix_of_parsed_address)
+{
+  Logging::LoggerGroup logger;
+  CryptoNote::CurrencyBuilder builder(logger);
+  CryptoNote::Currency currency = builder.publicAddressBase58Prefix(TEST_PUBLIC_ADDRESS_BASE58_PREFIX).currency();
+  CryptoNote::Currency otherCurrency = builder.publicAddressBase58Prefix(TEST_PUBLIC_ADDRESS_BASE58_PREFIX + 1).currency();
+
+  CryptoNote::AccountPublicAddress addr;
+  ASSERT_TRUE(currency.parseAccountAddressString(test_keys_addr_str, addr));
+  ASSERT_FALSE(otherCurrency.parseAccountAddressString(test_keys_addr_str, addr));
+}
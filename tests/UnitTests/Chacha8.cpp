@@ -20,6 +20,7 @@
 #include "gtest/gtest.h"
 
 #include "crypto/chacha8.h"
+#include "Common/StringTools.h"
 
 namespace
 {
@@ -95,3 +96,46 @@ TEST_CHACHA8(0)
 TEST_CHACHA8(1)
 TEST_CHACHA8(2)
 TEST_CHACHA8(3)
+
+// long buffers go through the multi-block kernels and end in the one block loop
+TEST(chacha8, longBufferMatchesReference)
+{
+  std::string plain(4133, '\0');
+  std::string cipher(plain.size(), '\0');
+  Crypto::chacha8(plain.data(), plain.size(), test_key_1, test_iv_1, &cipher[0]);
+
+  Crypto::Hash hash;
+  Crypto::cn_fast_hash(cipher.data(), cipher.size(), hash);
+  ASSERT_EQ("036aeca982739ca7fee1dcf227a89ca06786ea376d604cdc6dd2f0a049b7aea0", Common::podToHex(hash));
+}
+
+TEST(chacha8, everyLengthIsKeystreamPrefix)
+{
+  std::string plain(1100, '\0');
+  std::string keystream(plain.size(), '\0');
+  Crypto::chacha8(plain.data(), plain.size(), test_key_1, test_iv_1, &keystream[0]);
+
+  for (size_t length = 1; length <= plain.size(); ++length) {
+    std::string cipher(length, '\0');
+    Crypto::chacha8(plain.data(), length, test_key_1, test_iv_1, &cipher[0]);
+    ASSERT_EQ(keystream.substr(0, length), cipher) << "length " << length;
+  }
+}
+
+TEST(chacha8, encryptsInPlace)
+{
+  std::string plain(1300, '\0');
+  for (size_t i = 0; i < plain.size(); ++i) {
+    plain[i] = static_cast<char>(i * 31 + 7);
+  }
+
+  std::string cipher(plain.size(), '\0');
+  Crypto::chacha8(plain.data(), plain.size(), test_key_1, test_iv_1, &cipher[0]);
+
+  std::string buffer = plain;
+  Crypto::chacha8(buffer.data(), buffer.size(), test_key_1, test_iv_1, &buffer[0]);
+  ASSERT_EQ(cipher, buffer);
+
+  Crypto::chacha8(buffer.data(), buffer.size(), test_key_1, test_iv_1, &buffer[0]);
+  ASSERT_EQ(plain, buffer);
+}
@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/Currency.h"
 
 #define VEC_FROM_ARR(vec)                                               \
   std::vector<uint64_t> vec;                                            \
@@ -128,3 +129,34 @@ TEST_F(decompose_amount_into_digits_test, is_correct_6)
   ASSERT_EQ(m_chunk_handler.m_chunks, expected_chunks);
   ASSERT_EQ(m_dust_handler.m_dust, expected_dust);
 }
+
+TEST_F(decompose_amount_into_digits_test, is_correct_max)
+{
+  uint64_t expected_chunks_arr[] = {5, 10, 600, 1000, 50000, 500000, 9000000, 700000000, 3000000000, 70000000000,
+    4000000000000, 40000000000000, 700000000000000, 6000000000000000, 40000000000000000, 400000000000000000,
+    8000000000000000000ull, 10000000000000000000ull};
+  VEC_FROM_ARR(expected_chunks);
+  CryptoNote::decompose_amount_into_digits(UINT64_MAX, 0, m_chunk_handler, m_dust_handler);
+  ASSERT_EQ(m_chunk_handler.m_chunks, expected_chunks);
+  ASSERT_EQ(m_dust_handler.m_has_dust, false);
+}
+
+TEST(get_decomposed_amount_order, accepts_pretty_amounts_only)
+{
+  for (size_t i = 0; i < CryptoNote::Currency::PRETTY_AMOUNTS.size(); ++i)
+  {
+    uint64_t amount = CryptoNote::Currency::PRETTY_AMOUNTS[i];
+    uint8_t order = 0;
+    ASSERT_TRUE(CryptoNote::get_decomposed_amount_order(amount, order));
+    ASSERT_EQ(i / 9, order);
+    ASSERT_TRUE(CryptoNote::is_valid_decomposed_amount(amount));
+  }
+
+  uint64_t invalid_arr[] = {0, 11, 110, 1001, 25, 9000000000000000001ull, 10000000000000000001ull, UINT64_MAX};
+  VEC_FROM_ARR(invalid);
+  for (uint64_t amount : invalid)
+  {
+    uint8_t order;
+    ASSERT_FALSE(CryptoNote::get_decomposed_amount_order(amount, order)) << amount;
+  }
+}
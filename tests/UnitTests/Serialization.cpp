@@ -22,6 +22,8 @@
 #include "Serialization/BinaryInputStreamSerializer.h"
 #include "Serialization/BinaryOutputStreamSerializer.h"
 #include "Serialization/BinarySerializationTools.h"
+#include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "crypto/random.h"
 
 using namespace Common;
 using namespace CryptoNote;
@@ -55,6 +57,65 @@ TEST(BinarySerializer, uint16) {
   }
 }
 
+TEST(BinarySerializer, hashVectorIsStoredAsItemsInARow) {
+  std::vector<Crypto::Hash> hashes(100);
+  Random::randomBytes(hashes.size() * sizeof(Crypto::Hash), reinterpret_cast<uint8_t*>(hashes.data()));
+
+  std::stringstream ss;
+  {
+    StdOutputStream os(ss);
+    BinaryOutputStreamSerializer s(os);
+    s(hashes, "hashes");
+  }
+
+  // varint coded size followed by the hashes
+  std::string blob = ss.str();
+  ASSERT_EQ(1 + hashes.size() * sizeof(Crypto::Hash), blob.size());
+  ASSERT_EQ(0, memcmp(blob.data() + 1, hashes.data(), hashes.size() * sizeof(Crypto::Hash)));
+
+  StdInputStream is(ss);
+  BinaryInputStreamSerializer s(is);
+  std::vector<Crypto::Hash> loaded;
+  s(loaded, "hashes");
+  ASSERT_EQ(hashes, loaded);
+}
+
+TEST(BinarySerializer, readAheadReadsAcrossBlocks) {
+  std::stringstream ss;
+  std::vector<uint32_t> indexes;
+  std::vector<Crypto::Hash> hashes(10);
+  Random::randomBytes(hashes.size() * sizeof(Crypto::Hash), reinterpret_cast<uint8_t*>(hashes.data()));
+  std::string text(100, 'x');
+
+  for (uint32_t i = 0; i < 1000; ++i) {
+    indexes.push_back(i * 7919);
+  }
+
+  {
+    StdOutputStream os(ss);
+    BinaryOutputStreamSerializer s(os);
+    s(indexes, "indexes");
+    s(text, "text");
+    s(hashes, "hashes");
+  }
+
+  StdInputStream is(ss);
+  BinaryInputStreamSerializer s(is, 16);
+  std::vector<uint32_t> loadedIndexes;
+  std::string loadedText;
+  std::vector<Crypto::Hash> loadedHashes;
+  s(loadedIndexes, "indexes");
+  s(loadedText, "text");
+  s(loadedHashes, "hashes");
+
+  ASSERT_EQ(indexes, loadedIndexes);
+  ASSERT_EQ(text, loadedText);
+  ASSERT_EQ(hashes, loadedHashes);
+
+  uint8_t pastEnd;
+  ASSERT_ANY_THROW(s(pastEnd, "pastEnd"));
+}
+
 
 //#include <cstring>
 //#include <cstdint>
@@ -19,12 +19,15 @@
 
 #include <boost/lexical_cast.hpp>
 
+#include "Serialization/KVBinaryInputBufferSerializer.h"
 #include "Serialization/KVBinaryInputStreamSerializer.h"
+#include "Serialization/KVBinaryCommon.h"
 #include "Serialization/KVBinaryOutputStreamSerializer.h"
 #include "Serialization/SerializationOverloads.h"
 #include "Serialization/SerializationTools.h"
 
 #include <array>
+#include <Common/StringOutputStream.h>
 
 using namespace CryptoNote;
 
@@ -52,6 +55,18 @@ struct TestElement {
   }
 };
 
+struct TestElementReordered {
+  TestElement element;
+  bool missing;
+
+  void serialize(ISerializer& s) {
+    s.binary(element.blob.data(), element.blob.size(), "blob");
+    s(element.nonce, "nonce");
+    s(missing, "missing");
+    s(element.name, "name");
+  }
+};
+
 struct TestStruct {
   uint8_t u8;
   uint32_t u32;
@@ -134,3 +149,128 @@ TEST(KVSerialize, BigCollection) {
   ASSERT_TRUE(CryptoNote::loadFromBinaryKeyValue(ts2, buf));
   EXPECT_EQ(ts1, ts2);
 }
+
+TEST(KVSerialize, NestedObjectCountsPrecedeTheirMembers) {
+  KVBinaryOutputStreamSerializer s;
+  uint8_t a = 1;
+  uint8_t b = 2;
+  size_t size = 1;
+  s.beginObject("o");
+  s(a, "a");
+  s.endObject();
+  s.beginArray(size, "l");
+  s.beginObject("");
+  s(b, "b");
+  s.endObject();
+  s.endArray();
+
+  std::string buf;
+  Common::StringOutputStream stream(buf);
+  s.dump(stream);
+
+  const std::string expected("\x08"
+    "\x01o\x0c\x04" "\x01" "a\x08\x01"
+    "\x01l\x8c\x04" "\x04" "\x01" "b\x08\x02", 18);
+  ASSERT_EQ(sizeof(KVBinaryStorageBlockHeader) + expected.size(), buf.size());
+  EXPECT_EQ(expected, buf.substr(sizeof(KVBinaryStorageBlockHeader)));
+}
+
+TEST(KVSerialize, BufferReaderReadsFieldsInAnyOrder) {
+  TestElement element;
+  element.name = "hello";
+  element.nonce = 12345;
+  element.blob.fill(7);
+  element.u32array.resize(10, 3);
+
+  std::string buf = CryptoNote::storeToBinaryKeyValue(element);
+  KVBinaryInputBufferSerializer s(buf.data(), buf.size());
+  TestElementReordered loaded;
+  loaded.missing = true;
+  loaded.element.nonce = 0;
+  loaded.serialize(s);
+
+  EXPECT_EQ(element.name, loaded.element.name);
+  EXPECT_EQ(element.nonce, loaded.element.nonce);
+  EXPECT_EQ(element.blob, loaded.element.blob);
+  EXPECT_TRUE(loaded.missing);
+}
+
+TEST(KVSerialize, BufferReaderSkipsUnreadFields) {
+  TestStruct ts1;
+  ts1.u8 = 1;
+  ts1.u32 = 2;
+  ts1.u64 = 3;
+  ts1.root.name = "root";
+  TestElement sample;
+  sample.name = "sample";
+  sample.u32array.resize(5, 9);
+  ts1.vec1.resize(3, sample);
+  ts1.vec2.resize(2, sample);
+
+  std::string buf = CryptoNote::storeToBinaryKeyValue(ts1);
+  KVBinaryInputBufferSerializer s(buf.data(), buf.size());
+  uint64_t u64 = 0;
+  size_t size = 0;
+  ASSERT_TRUE(s.beginArray(size, "vec2"));
+  ASSERT_EQ(2, size);
+  ASSERT_TRUE(s.beginObject(""));
+  std::string name;
+  ASSERT_TRUE(s(name, "name"));
+  s.endObject();
+  s.endArray();
+  ASSERT_TRUE(s(u64, "u64"));
+
+  EXPECT_EQ("sample", name);
+  EXPECT_EQ(3, u64);
+}
+
+TEST(KVSerialize, BufferReaderRejectsTruncatedStorage) {
+  TestStruct ts1;
+  ts1.root.name = "hello";
+  TestElement sample;
+  ts1.vec1.resize(100, sample);
+
+  std::string buf = CryptoNote::storeToBinaryKeyValue(ts1);
+  TestStruct ts2;
+  ASSERT_FALSE(CryptoNote::loadFromBinaryKeyValue(ts2, buf.substr(0, buf.size() - 1)));
+}
+
+TEST(KVSerialize, BufferReaderPerformance) {
+  TestStruct ts1;
+  ts1.u8 = 100;
+  ts1.u32 = 0xff0000;
+  ts1.u64 = 1ULL << 60;
+  ts1.root.name = "hello";
+
+  TestElement sample;
+  sample.name = "element";
+  sample.nonce = 101;
+  sample.u32array.resize(16, 5);
+  ts1.vec1.resize(0x10000 >> 2, sample);
+
+  std::string buf = CryptoNote::storeToBinaryKeyValue(ts1);
+  const size_t rounds = 10;
+
+  TestStruct domLoaded;
+  HiResTimer domTimer;
+  for (size_t i = 0; i < rounds; ++i) {
+    Common::MemoryInputStream stream(buf.data(), buf.size());
+    KVBinaryInputStreamSerializer s(stream);
+    serialize(domLoaded, s);
+  }
+  auto domDuration = domTimer.duration();
+
+  TestStruct bufferLoaded;
+  HiResTimer bufferTimer;
+  for (size_t i = 0; i < rounds; ++i) {
+    KVBinaryInputBufferSerializer s(buf.data(), buf.size());
+    serialize(bufferLoaded, s);
+  }
+  auto bufferDuration = bufferTimer.duration();
+
+  std::cout << "JsonValue tree: " << domDuration.count() / rounds * 1000 << " ms, buffer reader: " <<
+    bufferDuration.count() / rounds * 1000 << " ms per " << buf.size() << " bytes" << std::endl;
+
+  EXPECT_EQ(ts1, domLoaded);
+  EXPECT_EQ(ts1, bufferLoaded);
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gtest/gtest.h"
+
+#include "crypto/crypto.h"
+#include "crypto/random.h"
+#include "CryptoNoteCore/BlockFilter.h"
+#include "CryptoNoteCore/TransactionExtra.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+Crypto::Hash randomHash() {
+  Crypto::Hash hash;
+  Random::randomBytes(sizeof(hash), reinterpret_cast<uint8_t*>(&hash));
+  return hash;
+}
+
+std::vector<Crypto::Hash> randomHashes(size_t count) {
+  std::vector<Crypto::Hash> hashes;
+  for (size_t i = 0; i < count; ++i) {
+    hashes.push_back(randomHash());
+  }
+
+  return hashes;
+}
+
+TEST(BlockFilter, matchesEveryItem) {
+  Crypto::Hash blockHash = randomHash();
+  std::vector<Crypto::Hash> items = randomHashes(200);
+  std::string filter = BlockFilter::build(blockHash, items);
+
+  for (const auto& item : items) {
+    ASSERT_TRUE(BlockFilter::matchAny(blockHash, filter, { randomHash(), item }));
+  }
+}
+
+TEST(BlockFilter, rulesOutOtherItems) {
+  Crypto::Hash blockHash = randomHash();
+  std::string filter = BlockFilter::build(blockHash, randomHashes(200));
+
+  size_t matches = 0;
+  for (size_t i = 0; i < 10000; ++i) {
+    if (BlockFilter::matchAny(blockHash, filter, { randomHash() })) {
+      ++matches;
+    }
+  }
+
+  ASSERT_GT(5, matches);
+  // about GOLOMB_BITS + 2 bits per item
+  ASSERT_GT(200 * 22 / 8 + 10, filter.size());
+}
+
+TEST(BlockFilter, itemsAreBoundToBlock) {
+  std::vector<Crypto::Hash> items = randomHashes(10);
+  std::string filter = BlockFilter::build(randomHash(), items);
+
+  ASSERT_FALSE(BlockFilter::matchAny(randomHash(), filter, items));
+}
+
+TEST(BlockFilter, emptyFilterMatchesNothing) {
+  Crypto::Hash blockHash = randomHash();
+  std::string filter = BlockFilter::build(blockHash, {});
+
+  ASSERT_FALSE(BlockFilter::matchAny(blockHash, filter, randomHashes(10)));
+  ASSERT_TRUE(BlockFilter::matchAny(blockHash, std::string(), randomHashes(1)));
+}
+
+TEST(BlockFilter, collectsTransactionKeyAndPaymentId) {
+  Transaction tx;
+  Crypto::PublicKey txKey;
+  Crypto::SecretKey txSecretKey;
+  Crypto::generate_keys(txKey, txSecretKey);
+  addTransactionPublicKeyToExtra(tx.extra, txKey);
+
+  Crypto::Hash paymentId = randomHash();
+  BinaryArray nonce;
+  setPaymentIdToTransactionExtraNonce(nonce, paymentId);
+  addExtraNonceToTransactionExtra(tx.extra, nonce);
+
+  std::vector<Crypto::Hash> items = BlockFilter::transactionItems(tx);
+  ASSERT_EQ(2, items.size());
+  ASSERT_EQ(reinterpret_cast<const Crypto::Hash&>(txKey), items[0]);
+  ASSERT_EQ(paymentId, items[1]);
+}
+
+TEST(BlockFilter, headersChainFilters) {
+  std::string first = BlockFilter::build(randomHash(), randomHashes(3));
+  std::string second = BlockFilter::build(randomHash(), randomHashes(3));
+
+  Crypto::Hash header = BlockFilter::header(first, Crypto::Hash());
+  ASSERT_NE(BlockFilter::header(second, header), BlockFilter::header(second, Crypto::Hash()));
+  ASSERT_NE(BlockFilter::header(first, header), BlockFilter::header(second, header));
+}
+
+}
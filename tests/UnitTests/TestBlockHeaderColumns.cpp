@@ -0,0 +1,63 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteCore/BlockHeaderColumns.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+BlockHeaderColumns makeColumns(const std::vector<uint64_t>& timestamps) {
+  BlockHeaderColumns columns;
+  for (uint64_t timestamp : timestamps) {
+    columns.push(timestamp, 0, 0, 0, 1);
+  }
+
+  return columns;
+}
+
+TEST(BlockHeaderColumns, lowerBoundOfMonotonicTimestamps) {
+  BlockHeaderColumns columns = makeColumns({ 10, 20, 30, 40 });
+
+  ASSERT_EQ(0, columns.lowerBound(5));
+  ASSERT_EQ(1, columns.lowerBound(20));
+  ASSERT_EQ(2, columns.lowerBound(21));
+  ASSERT_EQ(4, columns.lowerBound(41));
+  ASSERT_EQ(3, columns.lowerBound(0, 3));
+}
+
+TEST(BlockHeaderColumns, lowerBoundDoesNotSkipEarlierBlocksWithLaterTimestamps) {
+  BlockHeaderColumns columns = makeColumns({ 10, 50, 20, 30, 60 });
+
+  ASSERT_EQ(1, columns.lowerBound(40));
+  ASSERT_EQ(4, columns.lowerBound(55));
+}
+
+TEST(BlockHeaderColumns, lowerBoundFollowsPoppedBlocks) {
+  BlockHeaderColumns columns = makeColumns({ 10, 50, 20 });
+  columns.pop();
+  columns.pop();
+  columns.push(30, 0, 0, 0, 1);
+
+  ASSERT_EQ(1, columns.lowerBound(25));
+  ASSERT_EQ(2, columns.lowerBound(35));
+}
+
+}
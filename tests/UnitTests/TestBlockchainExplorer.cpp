@@ -22,7 +22,7 @@
 #include <boost/range/combine.hpp>
 
 #include "EventWaiter.h"
-#include "ICoreStub.h"
+#include "../TestStubs/ICoreStub.h"
 #include "ICryptoNoteProtocolQueryStub.h"
 #include "INodeStubs.h"
 #include "CryptoNoteCore/TransactionApi.h"
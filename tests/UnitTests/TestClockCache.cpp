@@ -0,0 +1,114 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gtest/gtest.h"
+
+#include "Common/ClockCache.h"
+
+using namespace Common;
+
+namespace {
+
+std::shared_ptr<int> value(int i) {
+  return std::make_shared<int>(i);
+}
+
+}
+
+TEST(ClockCache, findsInsertedItems) {
+  ClockCache<uint64_t, int> cache(100, 4);
+  cache.insert(1, value(10), 10);
+  cache.insert(2, value(20), 10);
+
+  ASSERT_EQ(10, *cache.find(1));
+  ASSERT_EQ(20, *cache.find(2));
+  ASSERT_TRUE(cache.find(3) == nullptr);
+  ASSERT_EQ(2, cache.hits());
+  ASSERT_EQ(1, cache.misses());
+}
+
+TEST(ClockCache, evictsBySize) {
+  ClockCache<uint64_t, int> cache(30, 1);
+  cache.insert(1, value(1), 10);
+  cache.insert(2, value(2), 10);
+  cache.insert(3, value(3), 10);
+  cache.insert(4, value(4), 20);
+
+  ASSERT_FALSE(cache.contains(1));
+  ASSERT_FALSE(cache.contains(2));
+  ASSERT_TRUE(cache.contains(3));
+  ASSERT_TRUE(cache.contains(4));
+}
+
+TEST(ClockCache, keepsItemLargerThanCapacity) {
+  ClockCache<uint64_t, int> cache(10, 1);
+  cache.insert(1, value(1), 5);
+  cache.insert(2, value(2), 50);
+
+  ASSERT_FALSE(cache.contains(1));
+  ASSERT_TRUE(cache.contains(2));
+}
+
+TEST(ClockCache, scanDoesNotFlushWorkingSet) {
+  ClockCache<uint64_t, int> cache(40, 1);
+  cache.insert(1, value(1), 10);
+  cache.insert(2, value(2), 10);
+
+  for (uint64_t i = 100; i < 200; ++i) {
+    cache.insert(i, value(static_cast<int>(i)), 10, false);
+    cache.find(1);
+    cache.find(2);
+  }
+
+  ASSERT_TRUE(cache.contains(1));
+  ASSERT_TRUE(cache.contains(2));
+  ASSERT_TRUE(cache.contains(199));
+}
+
+TEST(ClockCache, insertReplacesItem) {
+  ClockCache<uint64_t, int> cache(20, 1);
+  cache.insert(1, value(1), 10);
+  cache.insert(1, value(2), 10);
+  cache.insert(2, value(3), 10);
+
+  ASSERT_EQ(2, *cache.find(1));
+  ASSERT_TRUE(cache.contains(2));
+}
+
+TEST(ClockCache, eraseAndClear) {
+  ClockCache<uint64_t, int> cache(100, 2);
+  cache.insert(1, value(1), 10);
+  cache.insert(2, value(2), 10);
+  cache.erase(1);
+  ASSERT_FALSE(cache.contains(1));
+  ASSERT_TRUE(cache.contains(2));
+
+  cache.clear();
+  ASSERT_FALSE(cache.contains(2));
+}
+
+TEST(SequentialReads, detectsRunOfConsecutiveMisses) {
+  SequentialReads reads(2);
+  ASSERT_FALSE(reads.miss(10));
+  ASSERT_FALSE(reads.miss(11));
+  ASSERT_TRUE(reads.miss(12));
+
+  reads.readAhead(20);
+  ASSERT_TRUE(reads.miss(20));
+  ASSERT_FALSE(reads.miss(5));
+}
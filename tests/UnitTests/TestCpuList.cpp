@@ -0,0 +1,36 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+#include "Common/Util.h"
+
+TEST(CpuList, emptyMeansAllCpus) {
+  ASSERT_TRUE(Tools::parseCpuList("").empty());
+  ASSERT_TRUE(Tools::setCurrentThreadAffinity({}));
+}
+
+TEST(CpuList, parsesRangesSortedAndUnique) {
+  std::vector<unsigned> expected = { 0, 1, 2, 3, 8 };
+  ASSERT_EQ(expected, Tools::parseCpuList("8, 0-3,2"));
+}
+
+TEST(CpuList, rejectsMalformedLists) {
+  ASSERT_THROW(Tools::parseCpuList("3-1"), std::runtime_error);
+  ASSERT_THROW(Tools::parseCpuList("a"), std::runtime_error);
+  ASSERT_THROW(Tools::parseCpuList("1-"), std::runtime_error);
+  ASSERT_THROW(Tools::parseCpuList("-1"), std::runtime_error);
+}
@@ -0,0 +1,93 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "crypto/crypto.h"
+
+using namespace Crypto;
+
+TEST(CryptoPrecomp, keyDerivationMatchesPlainDerivation) {
+  PublicKey txPublic;
+  SecretKey txSecret;
+  generate_keys(txPublic, txSecret);
+
+  KeyDerivationPrecomp precomp;
+  ASSERT_TRUE(precompute_key_derivation(txPublic, precomp));
+  for (size_t i = 0; i < 4; ++i) {
+    PublicKey viewPublic;
+    SecretKey viewSecret;
+    generate_keys(viewPublic, viewSecret);
+
+    KeyDerivation expected;
+    KeyDerivation derivation;
+    ASSERT_TRUE(generate_key_derivation(txPublic, viewSecret, expected));
+    ASSERT_TRUE(generate_key_derivation(precomp, viewSecret, derivation));
+    ASSERT_EQ(expected, derivation);
+  }
+}
+
+TEST(CryptoPrecomp, ringSignatureCheckMatchesPlainCheck) {
+  const size_t RING_SIZE = 5;
+  const size_t REAL_INDEX = 2;
+  std::vector<PublicKey> keys(RING_SIZE);
+  SecretKey realSecret;
+  for (size_t i = 0; i < RING_SIZE; ++i) {
+    SecretKey secret;
+    generate_keys(keys[i], secret);
+    if (i == REAL_INDEX) {
+      realSecret = secret;
+    }
+  }
+
+  KeyImage image;
+  generate_key_image(keys[REAL_INDEX], realSecret, image);
+
+  std::vector<const PublicKey*> keyPointers;
+  std::vector<RingMemberPrecomp> precomps(RING_SIZE);
+  std::vector<const RingMemberPrecomp*> precompPointers;
+  for (size_t i = 0; i < RING_SIZE; ++i) {
+    keyPointers.push_back(&keys[i]);
+    ASSERT_TRUE(precompute_ring_member(keys[i], precomps[i]));
+    precompPointers.push_back(&precomps[i]);
+  }
+
+  Hash prefixHash = cn_fast_hash("prefix", 6);
+  std::vector<Signature> signatures(RING_SIZE);
+  generate_ring_signature(prefixHash, image, keyPointers.data(), RING_SIZE, realSecret, REAL_INDEX, signatures.data());
+
+  ASSERT_TRUE(check_ring_signature(prefixHash, image, keyPointers.data(), RING_SIZE, signatures.data()));
+  ASSERT_TRUE(check_ring_signature(prefixHash, image, precompPointers.data(), RING_SIZE, signatures.data()));
+
+  Hash otherHash = cn_fast_hash("other", 5);
+  ASSERT_FALSE(check_ring_signature(otherHash, image, precompPointers.data(), RING_SIZE, signatures.data()));
+}
+
+TEST(CryptoPrecomp, rejectsKeysThatAreNotPoints) {
+  PublicKey key;
+  for (size_t i = 0; i < sizeof(key.data); ++i) {
+    key.data[i] = 0xff;
+  }
+
+  key.data[31] = 0x7f;
+  KeyDerivationPrecomp derivationPrecomp;
+  RingMemberPrecomp memberPrecomp;
+  ASSERT_FALSE(precompute_key_derivation(key, derivationPrecomp));
+  ASSERT_FALSE(precompute_ring_member(key, memberPrecomp));
+}
@@ -0,0 +1,199 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Common/StringTools.h"
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+
+extern "C"
+{
+#include "crypto/keccak.h"
+}
+
+using namespace Crypto;
+
+namespace {
+
+// lengths on both sides of the 136 byte keccak rate and of its multiples
+const size_t LANE_LENGTHS[] = { 0, 1, 135, 136, 137, 271, 272, 273, 300 };
+const size_t LENGTH_COUNT = sizeof(LANE_LENGTHS) / sizeof(LANE_LENGTHS[0]);
+
+// vectors of tests/Hash/tests-tree.txt with 3, 5 and 16 leaves, root followed by leaves
+const char* const TREE_HASH_VECTORS[][2] = {
+  { "f8e26aaa7c36523cea4c5202f2df159c62bf70d10670c96aed516dbfd5cb5227",
+    "decc1e0aa505d7d5fbe8ed823d7f5da55307c4cc7008e306da82dbce492a0576dbcf0c26646d36b36a92408941f5f2539f7715bcb1e2b1309cedb86ae4211554"
+    "f56f5e6b2fce16536e44c851d473d1f994793873996ba448dd59b3b4b922b183" },
+  { "e678fb87749ec082a9f92537716de8e19d8bd5bc4c4d832bd3fcfd42498dac83",
+    "051a082e670c688e6a0fc2c8fd5b66b7a23cd380c7c49bd0cfffb0e80fb8c2334bb717c5e90db0ac353dfc0750c8b43a07edae0be99d6e820acc6da9f113123a"
+    "e084c38ccdbf9c6730e228b5d98e7beb9843cfb523747cc32f09f2b16def67f76765cee044883827b9af31c179d3135b16c30f04453943d9676a59b907a64396"
+    "58f6c98159b8fa1b152f1bcf748740754ca31c918501dbd577faf602c641df59" },
+  { "2d0ad2566627b50cd45125e89e963433b212b368cd2d91662c44813ba9ec90c2",
+    "21f750d5d938dd4ed1fa4daa4d260beb5b73509de9a9b145624d3f1afb671461b07d768cf1f5f8266b89ecdc150a2ad55ccd76d4c12d3a380b21862809a85af6"
+    "23269a23ee1b4694b26aa317b5cd4f259925f6b3288a8f60fb871b1ad3ac00cb1e6c55eddfc438e1f3e7b638ea6026cc01495010bafdfd789c47dff282c1af4c"
+    "6a8f83e5f2fca6940a756ef4faa15c7137082a7c31dffe0b2f5112d126ad4af1d536c0e626cc9d2fe1b72256f5285728558f22a3dbb36e0918bcfc01d4ae7284"
+    "d0bfb8e90647cdb01c292a53a31ff3fe6f350882f1dae2b09374db45f4d54c67d3b4e0829c4f9f63ad235d8ef838d8fb39546d90d99bbd831aff55dbbb642e2b"
+    "f529ceccd0479b9f194475c2a15143f0edac762e9bbce810436e765550c69e234c22276c41d7d7e28c10afc5e144a9ce32aa9c0f28bb4fcf171af7d7404fa5e2"
+    "8b79dc97bd4147f4df6d38b935bd83fb634414bae9d64a32ab45384fba5b8da5c147d51cd2a8f7f2a9c07b1bddc5b28b74bf0c0f0632ac2fc43d0d306dd1ac14"
+    "81cabe60a358d6043d4733202d489664a929d6bf76a39828954846beb47a3baacb35d2065cbe3ad34cf78bf895f6323a6d76fc1256306f58e4baecabd7a77938"
+    "8c6bf2734897c193d39c343fce49a456f0ef84cf963593c5401a14621cc6ec1bef01b53735ccb02bc96c5fd454105053e3b016174437ed83b25d2a79a88268f2" }
+};
+
+std::vector<uint8_t> randomBytes(std::mt19937& generator, size_t size) {
+  std::vector<uint8_t> bytes(size);
+  for (auto& byte : bytes) {
+    byte = static_cast<uint8_t>(generator());
+  }
+
+  return bytes;
+}
+
+// the plain pairwise reduction tree_hash has to agree with
+Hash referenceTreeHash(const std::vector<Hash>& leaves) {
+  if (leaves.size() == 1) {
+    return leaves[0];
+  }
+
+  size_t cnt = 1;
+  while (cnt * 2 < leaves.size()) {
+    cnt *= 2;
+  }
+
+  std::vector<Hash> level(leaves.begin(), leaves.begin() + (2 * cnt - leaves.size()));
+  for (size_t i = 2 * cnt - leaves.size(); i < leaves.size(); i += 2) {
+    level.push_back(cn_fast_hash(&leaves[i], 2 * sizeof(Hash)));
+  }
+
+  while (level.size() > 1) {
+    std::vector<Hash> next;
+    for (size_t i = 0; i < level.size(); i += 2) {
+      next.push_back(cn_fast_hash(&level[i], 2 * sizeof(Hash)));
+    }
+
+    level.swap(next);
+  }
+
+  return level[0];
+}
+
+}
+
+TEST(FastHashMulti, lanesMatchSingleHash) {
+  std::mt19937 generator(76);
+
+  for (size_t ways = 1; ways <= 2 * FAST_HASH_WAYS + 1; ++ways) {
+    // every lane gets its own message and, rotating with the pass, its own length
+    std::vector<std::vector<uint8_t>> inputs;
+    std::vector<const void*> data;
+    std::vector<size_t> length;
+    for (size_t lane = 0; lane < ways; ++lane) {
+      inputs.push_back(randomBytes(generator, LANE_LENGTHS[(ways + lane) % LENGTH_COUNT]));
+    }
+
+    for (const auto& input : inputs) {
+      data.push_back(input.data());
+      length.push_back(input.size());
+    }
+
+    std::vector<Hash> hashes(ways);
+    cn_fast_hash_multi(data.data(), length.data(), ways, hashes.data());
+    for (size_t lane = 0; lane < ways; ++lane) {
+      ASSERT_EQ(cn_fast_hash(inputs[lane].data(), inputs[lane].size()), hashes[lane]) << "ways " << ways << ", lane " << lane;
+    }
+  }
+}
+
+TEST(FastHashMulti, everyLengthMatchesSingleHash) {
+  std::mt19937 generator(136);
+
+  // all lanes of a pass share a length here, covering each block count up to three
+  for (size_t size = 0; size <= 3 * HASH_DATA_AREA + 1; ++size) {
+    std::vector<std::vector<uint8_t>> inputs;
+    const void* data[FAST_HASH_WAYS];
+    size_t length[FAST_HASH_WAYS];
+    for (size_t lane = 0; lane < FAST_HASH_WAYS; ++lane) {
+      inputs.push_back(randomBytes(generator, size));
+    }
+
+    for (size_t lane = 0; lane < FAST_HASH_WAYS; ++lane) {
+      data[lane] = inputs[lane].data();
+      length[lane] = size;
+    }
+
+    Hash hashes[FAST_HASH_WAYS];
+    cn_fast_hash_multi(data, length, FAST_HASH_WAYS, hashes);
+    for (size_t lane = 0; lane < FAST_HASH_WAYS; ++lane) {
+      ASSERT_EQ(cn_fast_hash(inputs[lane].data(), size), hashes[lane]) << "size " << size << ", lane " << lane;
+    }
+  }
+}
+
+TEST(FastHashMulti, keccakfX4MatchesKeccakf) {
+  std::mt19937_64 generator(25);
+  uint64_t states[KECCAK_X4_WAYS][25];
+  uint64_t interleaved[25][KECCAK_X4_WAYS];
+  for (size_t lane = 0; lane < KECCAK_X4_WAYS; ++lane) {
+    for (size_t i = 0; i < 25; ++i) {
+      states[lane][i] = generator();
+      interleaved[i][lane] = states[lane][i];
+    }
+  }
+
+  for (int round = 0; round < 3; ++round) {
+    keccakf_x4(interleaved, KECCAK_ROUNDS);
+    for (size_t lane = 0; lane < KECCAK_X4_WAYS; ++lane) {
+      keccakf(states[lane], KECCAK_ROUNDS);
+      for (size_t i = 0; i < 25; ++i) {
+        ASSERT_EQ(states[lane][i], interleaved[i][lane]) << "round " << round << ", lane " << lane << ", word " << i;
+      }
+    }
+  }
+}
+
+TEST(FastHashMulti, treeHashMatchesHashVectors) {
+  for (const auto& vector : TREE_HASH_VECTORS) {
+    Hash expected;
+    ASSERT_TRUE(Common::podFromHex(vector[0], expected));
+    std::vector<uint8_t> leaves = Common::fromHex(vector[1]);
+    ASSERT_EQ(0, leaves.size() % sizeof(Hash));
+
+    Hash root;
+    tree_hash(reinterpret_cast<const Hash*>(leaves.data()), leaves.size() / sizeof(Hash), root);
+    ASSERT_EQ(expected, root) << "leaves " << leaves.size() / sizeof(Hash);
+  }
+}
+
+TEST(FastHashMulti, treeHashMatchesPairwiseReduction) {
+  std::mt19937 generator(32);
+
+  for (size_t count = 1; count <= 40; ++count) {
+    std::vector<Hash> leaves(count);
+    for (auto& leaf : leaves) {
+      std::vector<uint8_t> bytes = randomBytes(generator, sizeof(Hash));
+      memcpy(&leaf, bytes.data(), sizeof(Hash));
+    }
+
+    Hash root;
+    tree_hash(leaves.data(), count, root);
+    ASSERT_EQ(referenceTreeHash(leaves), root) << "leaves " << count;
+  }
+}
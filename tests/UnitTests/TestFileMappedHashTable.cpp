@@ -0,0 +1,211 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+
+#include "Common/FileMappedHashTable.h"
+
+using namespace Common;
+
+namespace {
+
+const std::string TEST_FILE_NAME = "FileMappedHashTableTest.dat";
+const std::string TEST_FILE_NAME_NEW = TEST_FILE_NAME + ".new";
+
+// keys equal modulo the bucket count land on the same probe chain
+struct IdentityHash {
+  size_t operator()(uint64_t key) const {
+    return static_cast<size_t>(key);
+  }
+};
+
+typedef FileMappedHashTable<uint64_t, uint64_t, IdentityHash> Table;
+
+// counts the hashed keys, a rehash hashes every entry once more
+struct CountingHash {
+  static size_t calls;
+
+  size_t operator()(uint64_t key) const {
+    ++calls;
+    return static_cast<size_t>(key);
+  }
+};
+
+size_t CountingHash::calls = 0;
+
+class FileMappedHashTableTest : public ::testing::Test {
+protected:
+  virtual void SetUp() override {
+    clean();
+  }
+
+  virtual void TearDown() override {
+    clean();
+  }
+
+  void clean() {
+    boost::system::error_code ignore;
+    boost::filesystem::remove(TEST_FILE_NAME, ignore);
+    boost::filesystem::remove(TEST_FILE_NAME_NEW, ignore);
+  }
+};
+
+}
+
+TEST_F(FileMappedHashTableTest, insertFindErase) {
+  Table table;
+  table.open(TEST_FILE_NAME);
+
+  ASSERT_TRUE(table.insert(1, 10));
+  ASSERT_TRUE(table.insert(2, 20));
+  ASSERT_EQ(2, table.size());
+
+  uint64_t value;
+  ASSERT_TRUE(table.find(1, value));
+  ASSERT_EQ(10, value);
+  ASSERT_TRUE(table.find(2, value));
+  ASSERT_EQ(20, value);
+  ASSERT_FALSE(table.find(3, value));
+
+  ASSERT_EQ(1, table.erase(1));
+  ASSERT_EQ(0, table.erase(1));
+  ASSERT_FALSE(table.contains(1));
+  ASSERT_TRUE(table.contains(2));
+  ASSERT_EQ(1, table.size());
+}
+
+TEST_F(FileMappedHashTableTest, insertDoesNotOverwriteExistingKey) {
+  Table table;
+  table.open(TEST_FILE_NAME);
+
+  ASSERT_TRUE(table.insert(1, 10));
+  ASSERT_FALSE(table.insert(1, 11));
+
+  uint64_t value;
+  ASSERT_TRUE(table.find(1, value));
+  ASSERT_EQ(10, value);
+  ASSERT_EQ(1, table.size());
+}
+
+TEST_F(FileMappedHashTableTest, probesPastErasedSlots) {
+  Table table;
+  table.open(TEST_FILE_NAME);
+
+  ASSERT_TRUE(table.insert(1, 10));
+  ASSERT_TRUE(table.insert(1025, 20));
+  ASSERT_EQ(1, table.erase(1));
+
+  // the colliding key is found past the erased slot and isn't inserted twice
+  uint64_t value;
+  ASSERT_TRUE(table.find(1025, value));
+  ASSERT_EQ(20, value);
+  ASSERT_FALSE(table.insert(1025, 21));
+
+  ASSERT_TRUE(table.insert(2049, 30));
+  ASSERT_TRUE(table.find(2049, value));
+  ASSERT_EQ(30, value);
+  ASSERT_EQ(2, table.size());
+}
+
+TEST_F(FileMappedHashTableTest, reinsertReusesErasedSlot) {
+  FileMappedHashTable<uint64_t, uint64_t, CountingHash> table;
+  table.open(TEST_FILE_NAME);
+  ASSERT_TRUE(table.insert(5, 50));
+
+  // erased slots would fill the table and force rehashes if they weren't taken again
+  CountingHash::calls = 0;
+  for (uint64_t i = 0; i < 10000; ++i) {
+    ASSERT_TRUE(table.insert(1, i));
+    ASSERT_EQ(1, table.erase(1));
+  }
+
+  ASSERT_EQ(20000, CountingHash::calls);
+  ASSERT_EQ(1, table.size());
+  ASSERT_TRUE(table.contains(5));
+}
+
+TEST_F(FileMappedHashTableTest, growsOnRehash) {
+  Table table;
+  table.open(TEST_FILE_NAME);
+  table.flush();
+  auto fileSize = boost::filesystem::file_size(TEST_FILE_NAME);
+
+  for (uint64_t i = 0; i < 10000; ++i) {
+    ASSERT_TRUE(table.insert(i, i * 3));
+  }
+
+  ASSERT_EQ(10000, table.size());
+  for (uint64_t i = 0; i < 10000; ++i) {
+    uint64_t value;
+    ASSERT_TRUE(table.find(i, value));
+    ASSERT_EQ(i * 3, value);
+  }
+
+  table.flush();
+  ASSERT_LT(fileSize, boost::filesystem::file_size(TEST_FILE_NAME));
+  ASSERT_FALSE(boost::filesystem::exists(TEST_FILE_NAME_NEW));
+}
+
+TEST_F(FileMappedHashTableTest, newTableIsReset) {
+  Table table;
+  table.open(TEST_FILE_NAME);
+  ASSERT_TRUE(table.wasReset());
+  ASSERT_EQ(0, table.size());
+}
+
+TEST_F(FileMappedHashTableTest, reopensClosedTable) {
+  {
+    Table table;
+    table.open(TEST_FILE_NAME);
+    for (uint64_t i = 0; i < 2000; ++i) {
+      ASSERT_TRUE(table.insert(i, i + 1));
+    }
+
+    ASSERT_EQ(1, table.erase(7));
+    table.close();
+  }
+
+  Table table;
+  table.open(TEST_FILE_NAME);
+  ASSERT_FALSE(table.wasReset());
+  ASSERT_EQ(1999, table.size());
+  ASSERT_FALSE(table.contains(7));
+
+  uint64_t value;
+  ASSERT_TRUE(table.find(1999, value));
+  ASSERT_EQ(2000, value);
+}
+
+TEST_F(FileMappedHashTableTest, resetsTableThatWasNotClosed) {
+  {
+    Table table;
+    table.open(TEST_FILE_NAME);
+    ASSERT_TRUE(table.insert(1, 10));
+    table.flush();
+  }
+
+  Table table;
+  table.open(TEST_FILE_NAME);
+  ASSERT_TRUE(table.wasReset());
+  ASSERT_EQ(0, table.size());
+  ASSERT_FALSE(table.contains(1));
+}
@@ -771,6 +771,29 @@ TEST_F(FileMappedVectorTest, insertCanIncreaseCapacity) {
   ASSERT_LT(initialCapacity, vec.capacity());
 }
 
+TEST_F(FileMappedVectorTest, insertCanAppendSeveralElementsBeyondCapacity) {
+  createTestFile(TEST_FILE_NAME);
+  FileMappedVector<char> vec(TEST_FILE_NAME);
+
+  std::string str(static_cast<size_t>(TEST_VECTOR_CAPACITY), 'w');
+  auto it = vec.insert(vec.end(), str.begin(), str.end());
+  ASSERT_EQ(vec.cbegin() + TEST_VECTOR_SIZE, it);
+  ASSERT_EQ(TEST_VECTOR_SIZE + str.size(), vec.size());
+  ASSERT_LE(vec.size(), vec.capacity());
+  ASSERT_TRUE(std::equal(vec.begin(), vec.begin() + TEST_VECTOR_SIZE, TEST_VECTOR_DATA.begin()));
+  ASSERT_TRUE(std::equal(vec.begin() + TEST_VECTOR_SIZE, vec.end(), str.begin()));
+}
+
+TEST_F(FileMappedVectorTest, eraseOfTailKeepsCapacity) {
+  createTestFile(TEST_FILE_NAME);
+  FileMappedVector<char> vec(TEST_FILE_NAME);
+
+  vec.erase(vec.begin() + 2, vec.end());
+  ASSERT_EQ(2, vec.size());
+  ASSERT_EQ(TEST_VECTOR_CAPACITY, vec.capacity());
+  ASSERT_TRUE(std::equal(vec.begin(), vec.end(), TEST_VECTOR_DATA.begin()));
+}
+
 TEST_F(FileMappedVectorTest, insertReturnsIteratorPointsToFirstInsertedElement) {
   createTestFile(TEST_FILE_NAME);
   FileMappedVector<char> vec(TEST_FILE_NAME);
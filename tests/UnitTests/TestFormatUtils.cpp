@@ -17,6 +17,7 @@
 
 #include "gtest/gtest.h"
 
+#include <cstring>
 #include <vector>
 
 #include "Common/Util.h"
@@ -155,6 +156,87 @@ TEST(parse_and_validate_tx_extra, fails_on_wrong_size_in_extra_nonce)
   std::vector<CryptoNote::TransactionExtraField> tx_extra_fields;
   ASSERT_FALSE(CryptoNote::parseTransactionExtra(tx.extra, tx_extra_fields));
 }
+static Crypto::Hash randomHash() {
+  Crypto::Hash hash;
+  Random::randomBytes(sizeof(hash), hash.data);
+  return hash;
+}
+
+TEST(scanTransactionExtra, finds_fields_in_place)
+{
+  std::vector<uint8_t> extra;
+  Crypto::PublicKey pk = CryptoNote::generateKeyPair().publicKey;
+  ASSERT_TRUE(CryptoNote::addTransactionPublicKeyToExtra(extra, pk));
+  Crypto::Hash paymentId = randomHash();
+  std::vector<uint8_t> nonce;
+  CryptoNote::setPaymentIdToTransactionExtraNonce(nonce, paymentId);
+  ASSERT_TRUE(CryptoNote::addExtraNonceToTransactionExtra(extra, nonce));
+  CryptoNote::TransactionExtraMergeMiningTag mmTag = { 5, randomHash() };
+  ASSERT_TRUE(CryptoNote::appendMergeMiningTagToExtra(extra, mmTag));
+
+  CryptoNote::TransactionExtraScan scan;
+  ASSERT_TRUE(CryptoNote::scanTransactionExtra(extra, scan));
+  ASSERT_EQ(reinterpret_cast<const Crypto::PublicKey*>(extra.data() + 1), scan.publicKey);
+  ASSERT_EQ(extra.data() + 2 + sizeof(Crypto::PublicKey) + 1, scan.nonce);
+  ASSERT_EQ(nonce.size(), scan.nonceSize);
+
+  Crypto::Hash paymentId2;
+  ASSERT_TRUE(scan.getPaymentId(paymentId2));
+  ASSERT_EQ(paymentId, paymentId2);
+  CryptoNote::TransactionExtraMergeMiningTag mmTag2;
+  ASSERT_TRUE(scan.getMergeMiningTag(mmTag2));
+  ASSERT_EQ(mmTag.depth, mmTag2.depth);
+  ASSERT_EQ(mmTag.merkleRoot, mmTag2.merkleRoot);
+  ASSERT_EQ(pk, CryptoNote::getTransactionPublicKeyFromExtra(extra));
+}
+
+TEST(scanTransactionExtra, agrees_with_parseTransactionExtra)
+{
+  std::vector<uint8_t> valid;
+  CryptoNote::addTransactionPublicKeyToExtra(valid, CryptoNote::generateKeyPair().publicKey);
+  CryptoNote::addExtraNonceToTransactionExtra(valid, std::vector<uint8_t>(3, 7));
+  CryptoNote::appendMergeMiningTagToExtra(valid, CryptoNote::TransactionExtraMergeMiningTag{ 300, randomHash() });
+  CryptoNote::addTransactionPublicKeyToExtra(valid, CryptoNote::generateKeyPair().publicKey);
+  valid.push_back(42); // unknown tags are skipped
+  valid.resize(valid.size() + 10, 0);
+
+  // every truncation and single byte change of a valid extra
+  for (size_t i = 0; i <= valid.size(); ++i) {
+    for (int change = 0; change < 4; ++change) {
+      std::vector<uint8_t> extra(valid.begin(), valid.begin() + i);
+      if (change != 0 && i < valid.size()) {
+        extra.insert(extra.end(), valid.begin() + i, valid.end());
+        extra[i] = change == 1 ? 0 : change == 2 ? 0xff : static_cast<uint8_t>(extra[i] + 1);
+      }
+
+      std::vector<CryptoNote::TransactionExtraField> fields;
+      bool parsed = CryptoNote::parseTransactionExtra(extra, fields);
+      CryptoNote::TransactionExtraScan scan;
+      ASSERT_EQ(parsed, CryptoNote::scanTransactionExtra(extra, scan)) << "at " << i << ", change " << change;
+
+      CryptoNote::TransactionExtraPublicKey pk;
+      Crypto::PublicKey scannedPk;
+      ASSERT_EQ(CryptoNote::findTransactionExtraFieldByType(fields, pk), scan.getPublicKey(scannedPk));
+      CryptoNote::TransactionExtraNonce nonce;
+      std::vector<uint8_t> scannedNonce;
+      ASSERT_EQ(CryptoNote::findTransactionExtraFieldByType(fields, nonce), scan.getExtraNonce(scannedNonce));
+      CryptoNote::TransactionExtraMergeMiningTag mmTag;
+      CryptoNote::TransactionExtraMergeMiningTag scannedMmTag;
+      ASSERT_EQ(CryptoNote::findTransactionExtraFieldByType(fields, mmTag), scan.getMergeMiningTag(scannedMmTag));
+      if (scan.publicKey != nullptr) {
+        ASSERT_EQ(pk.publicKey, scannedPk);
+      }
+      if (scan.nonce != nullptr) {
+        ASSERT_EQ(nonce.nonce, scannedNonce);
+      }
+      if (scan.mergeMiningTag != nullptr) {
+        ASSERT_EQ(mmTag.depth, scannedMmTag.depth);
+        ASSERT_EQ(mmTag.merkleRoot, scannedMmTag.merkleRoot);
+      }
+    }
+  }
+}
+
 TEST(validate_parse_amount_case, validate_parse_amount)
 {
   Logging::LoggerGroup logger;
@@ -200,3 +282,85 @@ TEST(validate_parse_amount_case, validate_parse_amount)
   r = currency.parseAmount("1 00.00 00", res);
   ASSERT_FALSE(r);
 }
+
+namespace {
+
+void checkPatchedLongHashBlob(uint8_t majorVersion) {
+  CryptoNote::Block block = AUTO_VAL_INIT(block);
+  block.majorVersion = majorVersion;
+  block.minorVersion = 0;
+  block.timestamp = 1500000000;
+  block.nonce = 0x12345678;
+  block.parentBlock.majorVersion = 1;
+  block.parentBlock.minorVersion = 0;
+  block.parentBlock.transactionCount = 1;
+
+  CryptoNote::BinaryArray blob;
+  size_t nonceOffset;
+  ASSERT_TRUE(CryptoNote::get_block_longhash_blob(block, blob, nonceOffset));
+
+  block.nonce = 0xdeadbeef;
+  memcpy(&blob[nonceOffset], &block.nonce, sizeof(block.nonce));
+
+  CryptoNote::BinaryArray expected;
+  ASSERT_TRUE(CryptoNote::get_block_longhash_blob(block, expected));
+  ASSERT_EQ(expected, blob);
+}
+
+void checkBlockHeaderBlob(uint8_t majorVersion) {
+  CryptoNote::Block block = AUTO_VAL_INIT(block);
+  block.majorVersion = majorVersion;
+  block.minorVersion = 0;
+  block.timestamp = 1500000000;
+  block.nonce = 0x12345678;
+  block.previousBlockHash = Crypto::cn_fast_hash("previous", 8);
+  block.parentBlock.majorVersion = 1;
+  block.parentBlock.minorVersion = 0;
+  block.parentBlock.transactionCount = 1;
+  block.parentBlock.baseTransaction.version = CryptoNote::CURRENT_TRANSACTION_VERSION;
+  block.parentBlock.baseTransaction.unlockTime = 0;
+
+  CryptoNote::TransactionExtraMergeMiningTag mmTag;
+  mmTag.depth = 0;
+  mmTag.merkleRoot = Crypto::cn_fast_hash("aux", 3);
+  ASSERT_TRUE(CryptoNote::appendMergeMiningTagToExtra(block.parentBlock.baseTransaction.extra, mmTag));
+
+  CryptoNote::BinaryArray blob;
+  ASSERT_TRUE(CryptoNote::get_block_header_blob(block, blob));
+  ASSERT_EQ(CryptoNote::get_block_hash(block), CryptoNote::getObjectHash(blob));
+
+  CryptoNote::BlockHeader header;
+  ASSERT_TRUE(CryptoNote::parse_block_header_blob(blob, header));
+  ASSERT_EQ(majorVersion, header.majorVersion);
+  ASSERT_EQ(block.previousBlockHash, header.previousBlockHash);
+}
+
+}
+
+TEST(get_block_longhash_blob, nonce_can_be_patched_in_place)
+{
+  checkPatchedLongHashBlob(CryptoNote::BLOCK_MAJOR_VERSION_1);
+  checkPatchedLongHashBlob(CryptoNote::BLOCK_MAJOR_VERSION_2);
+  checkPatchedLongHashBlob(CryptoNote::BLOCK_MAJOR_VERSION_4);
+}
+
+TEST(get_transaction_short_id, is_salted_per_compact_block)
+{
+  CryptoNote::BinaryArray compactBlock(76, 0x42);
+  Crypto::Hash key = CryptoNote::get_compact_block_key(compactBlock, 1);
+  Crypto::Hash otherKey = CryptoNote::get_compact_block_key(compactBlock, 2);
+  ASSERT_NE(key, otherKey);
+
+  Crypto::Hash transactionHash = Crypto::cn_fast_hash("transaction", 11);
+  uint64_t shortId = CryptoNote::get_transaction_short_id(key, transactionHash);
+  ASSERT_EQ(shortId, CryptoNote::get_transaction_short_id(key, transactionHash));
+  ASSERT_EQ(0, shortId >> (CryptoNote::COMPACT_BLOCK_SHORT_ID_SIZE * 8));
+  ASSERT_NE(shortId, CryptoNote::get_transaction_short_id(otherKey, transactionHash));
+}
+
+TEST(get_block_header_blob, hashes_to_block_id_and_links_to_previous_block)
+{
+  checkBlockHeaderBlob(CryptoNote::BLOCK_MAJOR_VERSION_1);
+  checkBlockHeaderBlob(CryptoNote::BLOCK_MAJOR_VERSION_2);
+  checkBlockHeaderBlob(CryptoNote::BLOCK_MAJOR_VERSION_4);
+}
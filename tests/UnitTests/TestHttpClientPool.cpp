@@ -0,0 +1,101 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <vector>
+
+#include <System/ContextGroup.h>
+#include <System/Dispatcher.h>
+#include <System/Timer.h>
+
+#include "Rpc/HttpClientPool.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+class HttpClientPoolTest : public ::testing::Test {
+public:
+  HttpClientPoolTest() : pool(dispatcher, "127.0.0.1", 1, false, { 1, 2 }), group(dispatcher) {
+  }
+
+  // holds a connection of the lane for a while, yields so that the next leases queue up behind it
+  void hold(size_t lane, std::vector<int>& order, int id) {
+    group.spawn([this, lane, &order, id] {
+      HttpClientPool::Lease lease = pool.acquire(lane);
+      System::Timer(dispatcher).sleep(std::chrono::milliseconds(20));
+      order.push_back(id);
+    });
+
+    System::Timer(dispatcher).sleep(std::chrono::milliseconds(1));
+  }
+
+  System::Dispatcher dispatcher;
+  HttpClientPool pool;
+  System::ContextGroup group;
+};
+
+}
+
+TEST_F(HttpClientPoolTest, releasedConnectionIsReused) {
+  HttpClient* first;
+  {
+    HttpClientPool::Lease lease = pool.acquire(1);
+    first = &lease.client();
+  }
+
+  HttpClientPool::Lease lease = pool.acquire(1);
+  ASSERT_EQ(first, &lease.client());
+}
+
+TEST_F(HttpClientPoolTest, laneOpensConnectionsUpToLimit) {
+  HttpClientPool::Lease first = pool.acquire(1);
+  HttpClientPool::Lease second = pool.acquire(1);
+  ASSERT_NE(&first.client(), &second.client());
+}
+
+TEST_F(HttpClientPoolTest, fullLaneWaitsForRelease) {
+  std::vector<int> order;
+  hold(0, order, 1);
+  group.spawn([this, &order] {
+    pool.acquire(0);
+    order.push_back(2);
+  });
+
+  group.wait();
+  ASSERT_EQ(std::vector<int>({ 1, 2 }), order);
+}
+
+TEST_F(HttpClientPoolTest, busyLaneDoesNotHoldOthers) {
+  std::vector<int> order;
+  hold(0, order, 1);
+  group.spawn([this, &order] {
+    pool.acquire(0);
+    order.push_back(2);
+  });
+
+  group.spawn([this, &order] {
+    pool.acquire(1);
+    order.push_back(3);
+  });
+
+  group.wait();
+  ASSERT_EQ(std::vector<int>({ 3, 1, 2 }), order);
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+#include <string>
+
+#include "HTTP/HttpCompression.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+std::string sampleBody() {
+  std::string body;
+  for (int i = 0; i < 100; ++i) {
+    body += "{\"txHash\":\"" + std::to_string(i * 7919) + "\",\"txPrefix\":{\"version\":1,\"unlock_time\":0,\"vin\":[],\"vout\":[]}},";
+  }
+
+  return body;
+}
+
+}
+
+TEST(HttpCompression, dictionaryEncodingIsPreferred) {
+  ASSERT_EQ(HttpCompression::ENCODING_DICTIONARY, HttpCompression::negotiate("deflate, x-karbo-deflate-1"));
+  ASSERT_EQ(HttpCompression::ENCODING_DEFLATE, HttpCompression::negotiate("gzip, Deflate;q=0.5"));
+  ASSERT_EQ(HttpCompression::ENCODING_DICTIONARY, HttpCompression::negotiate(HttpCompression::ACCEPT_ENCODING));
+}
+
+TEST(HttpCompression, unknownOrRefusedEncodingsAreNotNegotiated) {
+  ASSERT_EQ("", HttpCompression::negotiate(""));
+  ASSERT_EQ("", HttpCompression::negotiate("gzip, br"));
+  ASSERT_EQ("", HttpCompression::negotiate("deflate;q=0, x-karbo-deflate-1;q=0.0"));
+}
+
+TEST(HttpCompression, compressedBodyIsRestored) {
+  std::string body = sampleBody();
+  for (const char* encoding : { HttpCompression::ENCODING_DEFLATE, HttpCompression::ENCODING_DICTIONARY }) {
+    std::string compressed = HttpCompression::compress(body, encoding);
+    ASSERT_GT(body.size(), compressed.size());
+    ASSERT_EQ(body, HttpCompression::decompress(compressed, encoding));
+  }
+}
+
+TEST(HttpCompression, largeBodyIsRestored) {
+  std::string body;
+  for (int i = 0; i < 20; ++i) {
+    body += sampleBody();
+  }
+
+  ASSERT_EQ(body, HttpCompression::decompress(HttpCompression::compress(body, HttpCompression::ENCODING_DICTIONARY),
+    HttpCompression::ENCODING_DICTIONARY));
+}
+
+TEST(HttpCompression, dictionaryShrinksSmallBodies) {
+  std::string body = "{\"status\":\"OK\",\"startHeight\":500000,\"currentHeight\":500100,\"fullOffset\":0,\"items\":[]}";
+  ASSERT_GT(HttpCompression::compress(body, HttpCompression::ENCODING_DEFLATE).size(),
+    HttpCompression::compress(body, HttpCompression::ENCODING_DICTIONARY).size());
+}
+
+TEST(HttpCompression, mismatchedOrDamagedContentIsRejected) {
+  std::string compressed = HttpCompression::compress(sampleBody(), HttpCompression::ENCODING_DICTIONARY);
+  ASSERT_THROW(HttpCompression::decompress(compressed, HttpCompression::ENCODING_DEFLATE), std::runtime_error);
+  ASSERT_THROW(HttpCompression::decompress(compressed.substr(0, compressed.size() / 2), HttpCompression::ENCODING_DICTIONARY), std::runtime_error);
+  ASSERT_THROW(HttpCompression::decompress(compressed, "gzip"), std::runtime_error);
+}
@@ -0,0 +1,93 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <system_error>
+
+#include "HTTP/HttpParser.h"
+
+using namespace CryptoNote;
+
+TEST(HttpParser, requestIsCompleteOnlyWithWholeBody) {
+  const std::string data = "POST /json_rpc HTTP/1.1\r\nHost: localhost\r\nContent-Length: 5\r\n\r\nhello";
+
+  HttpParser parser;
+  HttpRequest request;
+  for (size_t size = 0; size < data.size(); ++size) {
+    ASSERT_EQ(0, parser.parseRequest(data.data(), size, request));
+  }
+
+  ASSERT_EQ(data.size(), parser.parseRequest(data.data(), data.size(), request));
+  ASSERT_EQ("POST", request.getMethod());
+  ASSERT_EQ("/json_rpc", request.getUrl());
+  ASSERT_EQ("localhost", request.getHeaders().at("host"));
+  ASSERT_EQ("hello", request.getBody());
+}
+
+TEST(HttpParser, pipelinedRequests) {
+  const std::string first = "GET /getinfo HTTP/1.1\r\n\r\n";
+  const std::string second = "POST /getheight HTTP/1.1\r\ncontent-length: 2\r\n\r\n{}";
+  std::string data = first + second;
+
+  HttpParser parser;
+  HttpRequest request;
+  size_t size = parser.parseRequest(data.data(), data.size(), request);
+  ASSERT_EQ(first.size(), size);
+  ASSERT_EQ("/getinfo", request.getUrl());
+  ASSERT_TRUE(request.getBody().empty());
+
+  data.erase(0, size);
+  HttpRequest next;
+  ASSERT_EQ(second.size(), parser.parseRequest(data.data(), data.size(), next));
+  ASSERT_EQ("/getheight", next.getUrl());
+  ASSERT_EQ("{}", next.getBody());
+}
+
+TEST(HttpParser, chunkedBody) {
+  const std::string data = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n4\r\nWiki\r\n5;ext=1\r\npedia\r\n0\r\nExpires: never\r\n\r\n";
+
+  HttpParser parser;
+  HttpRequest request;
+  for (size_t size = 0; size < data.size(); ++size) {
+    ASSERT_EQ(0, parser.parseRequest(data.data(), size, request));
+  }
+
+  ASSERT_EQ(data.size(), parser.parseRequest(data.data(), data.size(), request));
+  ASSERT_EQ("Wikipedia", request.getBody());
+}
+
+TEST(HttpParser, response) {
+  const std::string data = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 2\r\n\r\n{}";
+
+  HttpParser parser;
+  HttpResponse response;
+  ASSERT_EQ(0, parser.parseResponse(data.data(), data.size() - 1, response));
+  ASSERT_EQ(data.size(), parser.parseResponse(data.data(), data.size(), response));
+  ASSERT_EQ(HttpResponse::STATUS_200, response.getStatus());
+  ASSERT_EQ("application/json", response.getHeaders().at("content-type"));
+  ASSERT_EQ("{}", response.getBody());
+}
+
+TEST(HttpParser, malformedRequestThrows) {
+  const std::string data = "GET / HTTP/1.1\r\n: empty\r\n\r\n";
+
+  HttpParser parser;
+  HttpRequest request;
+  ASSERT_THROW(parser.parseRequest(data.data(), data.size(), request), std::system_error);
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <string>
+
+#include "HTTP/HttpResponse.h"
+
+using namespace CryptoNote;
+
+TEST(HttpResponse, producedBodyIsSentInChunks) {
+  HttpResponse response;
+  response.setBody("replaced");
+  int calls = 0;
+  response.setBodyProducer([&calls](std::string& data) {
+    ++calls;
+    if (calls == 2) {
+      return true; // nothing this time, must not end the stream
+    }
+
+    data.append(calls == 1 ? std::string(26, 'x') : "end");
+    return calls < 3;
+  });
+
+  ASSERT_TRUE(response.isChunked());
+  ASSERT_EQ(0, response.getHeaders().count("Content-Length"));
+  ASSERT_EQ("chunked", response.getHeaders().at("Transfer-Encoding"));
+
+  std::ostringstream headers;
+  headers << response;
+  ASSERT_EQ(headers.str().size() - 4, headers.str().rfind("\r\n\r\n"));
+
+  std::string out;
+  ASSERT_TRUE(response.nextChunk(out));
+  ASSERT_EQ("1a\r\n" + std::string(26, 'x') + "\r\n", out);
+
+  out.clear();
+  ASSERT_FALSE(response.nextChunk(out));
+  ASSERT_EQ("3\r\nend\r\n0\r\n\r\n", out);
+}
+
+TEST(HttpResponse, emptyProducedBodyIsOnlyTheLastChunk) {
+  HttpResponse response;
+  response.setBodyProducer([](std::string&) { return false; });
+
+  std::string out;
+  ASSERT_FALSE(response.nextChunk(out));
+  ASSERT_EQ("0\r\n\r\n", out);
+}
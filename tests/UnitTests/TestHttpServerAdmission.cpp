@@ -0,0 +1,122 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <Logging/ConsoleLogger.h>
+#include <System/ContextGroup.h>
+#include <System/Dispatcher.h>
+#include <System/Timer.h>
+
+#include "Rpc/HttpServer.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+class TestServer : public HttpServer {
+public:
+  TestServer(System::Dispatcher& dispatcher, Logging::ILogger& log) : HttpServer(dispatcher, log) {
+  }
+
+  virtual void processRequest(const HttpRequest& request, HttpResponse& response) override {
+  }
+
+  using HttpServer::runConcurrently;
+};
+
+class HttpServerAdmission : public ::testing::Test {
+public:
+  HttpServerAdmission() : server(dispatcher, logger), group(dispatcher) {
+  }
+
+  // occupies a worker for a while, yields so that the next requests queue up behind it
+  void startBusy(HttpServer::Priority priority, std::vector<int>& order, int id) {
+    group.spawn([this, priority, &order, id] {
+      server.runConcurrently([] { std::this_thread::sleep_for(std::chrono::milliseconds(50)); }, priority);
+      order.push_back(id);
+    });
+
+    System::Timer(dispatcher).sleep(std::chrono::milliseconds(10));
+  }
+
+  void start(HttpServer::Priority priority, std::vector<int>& order, int id) {
+    group.spawn([this, priority, &order, id] {
+      if (server.runConcurrently([] {}, priority)) {
+        order.push_back(id);
+      } else {
+        order.push_back(-id);
+      }
+    });
+
+    System::Timer(dispatcher).sleep(std::chrono::milliseconds(1));
+  }
+
+  System::Dispatcher dispatcher;
+  Logging::ConsoleLogger logger;
+  TestServer server;
+  System::ContextGroup group;
+};
+
+}
+
+TEST_F(HttpServerAdmission, higherPriorityIsStartedFirst) {
+  server.setWorkerThreads(1);
+  std::vector<int> order;
+  startBusy(HttpServer::PRIORITY_NORMAL, order, 1);
+  start(HttpServer::PRIORITY_LOW, order, 2);
+  start(HttpServer::PRIORITY_NORMAL, order, 3);
+  start(HttpServer::PRIORITY_HIGH, order, 4);
+  group.wait();
+
+  ASSERT_EQ(std::vector<int>({ 1, 4, 3, 2 }), order);
+}
+
+TEST_F(HttpServerAdmission, fullQueueIsRejected) {
+  server.setWorkerThreads(1);
+  server.setMaxQueuedRequests(1);
+  std::vector<int> order;
+  startBusy(HttpServer::PRIORITY_LOW, order, 1);
+  start(HttpServer::PRIORITY_LOW, order, 2);
+  start(HttpServer::PRIORITY_LOW, order, 3);
+  start(HttpServer::PRIORITY_HIGH, order, 4);
+  group.wait();
+
+  ASSERT_EQ(std::vector<int>({ -3, 1, 4, 2 }), order);
+}
+
+TEST_F(HttpServerAdmission, limitedPriorityDoesNotHoldOthers) {
+  server.setWorkerThreads(2);
+  server.setConcurrencyLimit(HttpServer::PRIORITY_LOW, 1);
+  std::vector<int> order;
+  startBusy(HttpServer::PRIORITY_LOW, order, 1);
+  start(HttpServer::PRIORITY_LOW, order, 2);
+  start(HttpServer::PRIORITY_NORMAL, order, 3);
+  group.wait();
+
+  ASSERT_EQ(std::vector<int>({ 3, 1, 2 }), order);
+}
+
+TEST_F(HttpServerAdmission, runsInPlaceWithoutWorkers) {
+  bool done = false;
+  ASSERT_TRUE(server.runConcurrently([&done] { done = true; }, HttpServer::PRIORITY_LOW));
+  ASSERT_TRUE(done);
+}
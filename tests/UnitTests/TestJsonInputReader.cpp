@@ -0,0 +1,137 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "CryptoTypes.h"
+#include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "Serialization/JsonInputReader.h"
+#include "Serialization/SerializationOverloads.h"
+#include "Serialization/SerializationTools.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+struct Item {
+  std::string name;
+  uint32_t count = 0;
+
+  void serialize(ISerializer& s) {
+    KV_MEMBER(name)
+    KV_MEMBER(count)
+  }
+};
+
+struct Request {
+  std::string blob;
+  uint64_t height = 0;
+  int64_t delta = 0;
+  double ratio = 0;
+  bool flag = false;
+  Crypto::Hash hash;
+  std::vector<Crypto::Hash> hashes;
+  std::vector<Item> items;
+  Item extra;
+  std::string missing = "default";
+
+  void serialize(ISerializer& s) {
+    s.binary(blob, "blob");
+    KV_MEMBER(height)
+    KV_MEMBER(delta)
+    KV_MEMBER(ratio)
+    KV_MEMBER(flag)
+    KV_MEMBER(hash)
+    KV_MEMBER(hashes)
+    KV_MEMBER(items)
+    KV_MEMBER(extra)
+    KV_MEMBER(missing)
+  }
+};
+
+const std::string HASH = "0102030405060708091011121314151617181920212223242526272829303132";
+
+const std::string REQUEST =
+  " { \"height\" : 18446744073709551615, \"delta\":-5, \"ratio\": 0.25, \"flag\" : true,\n"
+  "\"blob\":\"00ff10\", \"hash\":\"" + HASH + "\", \"hashes\":[\"" + HASH + "\", \"" + HASH + "\"],\n"
+  "\"items\":[{\"name\":\"a\",\"count\":1}, {\"count\":2, \"name\":\"b\\\"c\"}], \"extra\":{}, \"unknown\":[[1],{}]}";
+
+void read(const std::string& json, Request& request) {
+  JsonInputReader s(json);
+  serialize(request, s);
+}
+
+}
+
+TEST(JsonInputReader, readsSameAsJsonValueSerializer) {
+  Request streamed;
+  read(REQUEST, streamed);
+
+  Request expected;
+  JsonInputValueSerializer s(Common::JsonValue::fromString(REQUEST));
+  serialize(expected, s);
+
+  ASSERT_EQ(expected.blob, streamed.blob);
+  ASSERT_EQ(std::string("\x00\xff\x10", 3), streamed.blob);
+  ASSERT_EQ(expected.delta, streamed.delta);
+  ASSERT_EQ(expected.ratio, streamed.ratio);
+  ASSERT_EQ(expected.flag, streamed.flag);
+  ASSERT_EQ(expected.hash, streamed.hash);
+  ASSERT_EQ(expected.hashes, streamed.hashes);
+  ASSERT_EQ(2, streamed.items.size());
+  ASSERT_EQ("a", streamed.items[0].name);
+  ASSERT_EQ(2, streamed.items[1].count);
+  ASSERT_EQ(expected.items[1].name, streamed.items[1].name);
+  ASSERT_EQ("default", streamed.missing);
+}
+
+TEST(JsonInputReader, readsFullUnsignedRange) {
+  Request request;
+  read(REQUEST, request);
+  ASSERT_EQ(UINT64_C(18446744073709551615), request.height);
+}
+
+TEST(JsonInputReader, rejectsMalformedInput) {
+  Request request;
+  ASSERT_THROW(read("", request), std::runtime_error);
+  ASSERT_THROW(read("[]", request), std::runtime_error);
+  ASSERT_THROW(read("{\"height\":", request), std::runtime_error);
+  ASSERT_THROW(read("{\"height\":01}", request), std::runtime_error);
+  ASSERT_THROW(read("{\"height\":1,}", request), std::runtime_error);
+  ASSERT_THROW(read("{\"name\":\"unterminated}", request), std::runtime_error);
+  ASSERT_THROW(read("{\"a\":" + std::string(1000, '[') + std::string(1000, ']') + "}", request), std::runtime_error);
+}
+
+TEST(JsonInputReader, rejectsWrongTypes) {
+  Request request;
+  ASSERT_THROW(read("{\"height\":1.5}", request), std::runtime_error);
+  ASSERT_THROW(read("{\"flag\":1}", request), std::runtime_error);
+  ASSERT_THROW(read("{\"hash\":\"" + HASH + "00\"}", request), std::runtime_error);
+  ASSERT_THROW(read("{\"items\":{}}", request), std::runtime_error);
+}
+
+TEST(JsonInputReader, loadFromJsonReportsErrors) {
+  Item item;
+  ASSERT_TRUE(loadFromJson(item, "{\"name\":\"x\",\"count\":3}"));
+  ASSERT_EQ("x", item.name);
+  ASSERT_EQ(3, item.count);
+  ASSERT_FALSE(loadFromJson(item, "{\"name\":3}"));
+}
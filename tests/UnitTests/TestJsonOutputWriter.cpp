@@ -0,0 +1,117 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+#include "CryptoTypes.h"
+#include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "Serialization/SerializationOverloads.h"
+#include "Serialization/SerializationTools.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+struct Item {
+  std::string name;
+  uint32_t count;
+
+  void serialize(ISerializer& s) {
+    KV_MEMBER(name)
+    KV_MEMBER(count)
+  }
+};
+
+struct Response {
+  std::string status;
+  uint64_t height;
+  int64_t delta;
+  double difficulty;
+  bool synced;
+  Crypto::Hash top;
+  std::vector<uint64_t> heights;
+  std::vector<Item> items;
+  Item last;
+
+  void serialize(ISerializer& s) {
+    KV_MEMBER(status)
+    KV_MEMBER(height)
+    KV_MEMBER(delta)
+    KV_MEMBER(difficulty)
+    KV_MEMBER(synced)
+    KV_MEMBER(top)
+    KV_MEMBER(heights)
+    KV_MEMBER(items)
+    KV_MEMBER(last)
+  }
+};
+
+Response makeResponse() {
+  Response r;
+  r.status = "OK";
+  r.height = 0xffffffffffffffffULL;
+  r.delta = -42;
+  r.difficulty = 1.5;
+  r.synced = true;
+  for (size_t i = 0; i < sizeof(r.top.data); ++i) {
+    r.top.data[i] = static_cast<uint8_t>(i);
+  }
+
+  r.heights = { 0, 1, 1000000 };
+  r.items = { { "a", 1 }, { "b", 2 } };
+  r.last = { "", 0 };
+  return r;
+}
+
+}
+
+TEST(JsonOutputWriter, matchesJsonValueOutput) {
+  Response r = makeResponse();
+
+  std::string streamed = storeToJson(r);
+  // JsonValue keeps members in insertion order, so the texts match as is
+  ASSERT_EQ(storeToJsonValue(r).toString(), streamed);
+  ASSERT_EQ(streamed, Common::JsonValue::fromString(streamed).toString());
+}
+
+TEST(JsonOutputWriter, keepsSerializationOrder) {
+  Item item = { "x", 7 };
+  ASSERT_EQ("{\"name\":\"x\",\"count\":7}", storeToJson(item));
+}
+
+TEST(JsonOutputWriter, formatsRealsLikeJsonValue) {
+  for (double value : { 0.0, 1.0, -2.25, 0.1, 123456.789, 1e-12 }) {
+    std::string json;
+    JsonOutputWriter s(json);
+    s(value, "v");
+    s.end();
+
+    Common::JsonValue expected(Common::JsonValue::OBJECT);
+    expected.insert("v", Common::JsonValue(value));
+    ASSERT_EQ(expected.toString(), json);
+  }
+}
+
+TEST(JsonOutputWriter, emptyObject) {
+  std::string json;
+  JsonOutputWriter s(json);
+  s.end();
+  ASSERT_EQ("{}", json);
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+#include "Rpc/JsonRpc.h"
+
+using namespace CryptoNote::JsonRpc;
+
+TEST(JsonRpcBatch, singleCallIsNotABatch) {
+  std::vector<std::string> calls;
+  ASSERT_FALSE(splitBatchRequest(" {\"method\":\"getblockcount\"}", calls));
+  ASSERT_TRUE(calls.empty());
+}
+
+TEST(JsonRpcBatch, splitsCallsInOrder) {
+  const std::string first = "{\"id\":1,\"method\":\"getblockhash\",\"params\":[10]}";
+  const std::string second = " {\"id\":\"a,]\\\"}\",\"method\":\"getblockheaderbyheight\",\"params\":{\"height\":10}} ";
+
+  std::vector<std::string> calls;
+  ASSERT_TRUE(splitBatchRequest("[" + first + "," + second + "]", calls));
+  ASSERT_EQ(2, calls.size());
+  ASSERT_EQ(first, calls[0]);
+  ASSERT_EQ(second, calls[1]);
+
+  JsonRpcRequest request;
+  request.parseRequest(calls[1]);
+  ASSERT_EQ("getblockheaderbyheight", request.getMethod());
+}
+
+TEST(JsonRpcBatch, emptyBatch) {
+  std::vector<std::string> calls;
+  ASSERT_TRUE(splitBatchRequest("[ ]", calls));
+  ASSERT_TRUE(calls.empty());
+}
+
+TEST(JsonRpcBatch, unterminatedBatchIsParseError) {
+  std::vector<std::string> calls;
+  ASSERT_THROW(splitBatchRequest("[{\"method\":\"getblockcount\"}", calls), JsonRpcError);
+  ASSERT_THROW(splitBatchRequest("[{\"method\":\"getblockcount\"}}", calls), JsonRpcError);
+}
@@ -65,3 +65,55 @@ TEST(JsonValue, testBadPatterns) {
   }
 }
 
+
+TEST(JsonValue, keepsInsertionOrder) {
+  JsonValue object(JsonValue::OBJECT);
+  object.insert("zeta", JsonValue::Integer(1));
+  object.insert("alpha", JsonValue::Integer(2));
+  object.set("mid", JsonValue::Integer(3));
+  object.set("zeta", JsonValue::Integer(4));
+  ASSERT_EQ("{\"zeta\":4,\"alpha\":2,\"mid\":3}", object.toString());
+
+  ASSERT_EQ(1, object.erase("alpha"));
+  ASSERT_EQ(0, object.erase("alpha"));
+  ASSERT_FALSE(object.contains("alpha"));
+  ASSERT_EQ("{\"zeta\":4,\"mid\":3}", object.toString());
+  ASSERT_THROW(object("alpha"), std::out_of_range);
+}
+
+TEST(JsonValue, parsedObjectRoundTrips) {
+  std::string source = "{\"b\":[1,{\"y\":true,\"x\":null}],\"a\":\"text\",\"c\":1.5}";
+  ASSERT_EQ(source, JsonValue::fromString(source).toString());
+}
+
+TEST(JsonValue, repeatedKeyKeepsFirstPositionAndLastValue) {
+  ASSERT_EQ("{\"a\":3,\"b\":2}", JsonValue::fromString("{\"a\":1,\"b\":2,\"a\":3}").toString());
+
+  std::string source = "{";
+  std::string expected = "{";
+  for (int i = 0; i < 100; ++i) {
+    source += "\"k" + std::to_string(i) + "\":" + std::to_string(i) + ",";
+    expected += (i == 0 ? "\"k" : ",\"k") + std::to_string(i) + "\":" + std::to_string(i == 7 ? 100 : i);
+  }
+
+  source += "\"k7\":100}";
+  expected += "}";
+  JsonValue value = JsonValue::fromString(source);
+  ASSERT_EQ(100, value.size());
+  ASSERT_EQ(expected, value.toString());
+}
+
+TEST(JsonValue, moveLeavesNil) {
+  JsonValue array(JsonValue::ARRAY);
+  array.pushBack(JsonValue("text"));
+  const JsonValue* element = &array[0];
+
+  JsonValue moved(std::move(array));
+  ASSERT_TRUE(array.isNil());
+  ASSERT_EQ(element, &moved[0]);
+
+  JsonValue assigned(JsonValue::OBJECT);
+  assigned = std::move(moved);
+  ASSERT_TRUE(moved.isNil());
+  ASSERT_EQ(element, &assigned[0]);
+}
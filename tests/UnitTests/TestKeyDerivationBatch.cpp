@@ -0,0 +1,100 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "crypto/crypto.h"
+
+using namespace Crypto;
+
+namespace {
+
+const size_t COUNT = 17;
+
+}
+
+TEST(KeyDerivationBatch, derivationsMatchSingleCalls) {
+  PublicKey viewPublic;
+  SecretKey viewSecret;
+  generate_keys(viewPublic, viewSecret);
+
+  std::vector<PublicKey> keys(COUNT);
+  for (auto& key : keys) {
+    SecretKey secret;
+    generate_keys(key, secret);
+  }
+
+  // not a point
+  keys[5].data[31] = 0x7f;
+  for (size_t i = 0; i < 31; ++i) {
+    keys[5].data[i] = 0xff;
+  }
+
+  std::vector<KeyDerivation> derivations(COUNT);
+  bool valid[COUNT];
+  generate_key_derivations(keys.data(), COUNT, viewSecret, derivations.data(), valid);
+  for (size_t i = 0; i < COUNT; ++i) {
+    KeyDerivation expected;
+    ASSERT_EQ(generate_key_derivation(keys[i], viewSecret, expected), valid[i]);
+    if (valid[i]) {
+      ASSERT_EQ(expected, derivations[i]);
+    }
+  }
+
+  ASSERT_FALSE(valid[5]);
+}
+
+TEST(KeyDerivationBatch, underivedKeysMatchSingleCalls) {
+  PublicKey txPublic;
+  SecretKey txSecret;
+  generate_keys(txPublic, txSecret);
+  PublicKey viewPublic;
+  SecretKey viewSecret;
+  generate_keys(viewPublic, viewSecret);
+  PublicKey spendPublic;
+  SecretKey spendSecret;
+  generate_keys(spendPublic, spendSecret);
+
+  KeyDerivation derivation;
+  ASSERT_TRUE(generate_key_derivation(txPublic, viewSecret, derivation));
+
+  std::vector<const KeyDerivation*> derivations(COUNT, &derivation);
+  std::vector<size_t> indexes(COUNT);
+  std::vector<PublicKey> outputKeys(COUNT);
+  for (size_t i = 0; i < COUNT; ++i) {
+    indexes[i] = i;
+    ASSERT_TRUE(derive_public_key(derivation, i, spendPublic, outputKeys[i]));
+  }
+
+  std::vector<PublicKey> bases(COUNT);
+  bool valid[COUNT];
+  underive_public_keys(derivations.data(), indexes.data(), outputKeys.data(), COUNT, bases.data(), valid);
+  for (size_t i = 0; i < COUNT; ++i) {
+    ASSERT_TRUE(valid[i]);
+    ASSERT_EQ(spendPublic, bases[i]);
+  }
+}
+
+TEST(KeyDerivationBatch, emptyBatch) {
+  SecretKey viewSecret;
+  PublicKey viewPublic;
+  generate_keys(viewPublic, viewSecret);
+  generate_key_derivations(nullptr, 0, viewSecret, nullptr, nullptr);
+  underive_public_keys(nullptr, nullptr, nullptr, 0, nullptr, nullptr);
+}
@@ -0,0 +1,69 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteCore/LongHashCache.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+Crypto::Hash makeHash(uint8_t value) {
+  Crypto::Hash hash = Crypto::Hash();
+  hash.data[0] = value;
+  return hash;
+}
+
+}
+
+TEST(LongHashCache, returnsStoredHash) {
+  LongHashCache cache(2);
+  cache.put(makeHash(1), makeHash(11));
+
+  Crypto::Hash longHash;
+  ASSERT_TRUE(cache.get(makeHash(1), longHash));
+  ASSERT_EQ(makeHash(11), longHash);
+  ASSERT_FALSE(cache.get(makeHash(2), longHash));
+  ASSERT_EQ(1, cache.hits());
+  ASSERT_EQ(1, cache.misses());
+}
+
+TEST(LongHashCache, evictsLeastRecentlyUsed) {
+  LongHashCache cache(2);
+  cache.put(makeHash(1), makeHash(11));
+  cache.put(makeHash(2), makeHash(12));
+
+  Crypto::Hash longHash;
+  ASSERT_TRUE(cache.get(makeHash(1), longHash));
+  cache.put(makeHash(3), makeHash(13));
+
+  ASSERT_EQ(2, cache.size());
+  ASSERT_TRUE(cache.contains(makeHash(1)));
+  ASSERT_FALSE(cache.contains(makeHash(2)));
+  ASSERT_TRUE(cache.contains(makeHash(3)));
+}
+
+TEST(LongHashCache, containsDoesNotCount) {
+  LongHashCache cache(1);
+  cache.put(makeHash(1), makeHash(11));
+
+  ASSERT_TRUE(cache.contains(makeHash(1)));
+  ASSERT_FALSE(cache.contains(makeHash(2)));
+  ASSERT_EQ(0, cache.hits());
+  ASSERT_EQ(0, cache.misses());
+}
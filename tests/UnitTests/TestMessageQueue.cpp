@@ -282,6 +282,40 @@ TEST_F(MessageQueueTest, interruptWaiting) {
   contextGroup.wait();
 }
 
+TEST_F(MessageQueueTest, fullQueueCoalescesToTipChange) {
+  MessageQueue<BlockchainMessage> queue(dispatcher, 2, MessageQueueOverflow::COALESCE);
+  MesageQueueGuard<MessageQueueTest, BlockchainMessage> guard(*this, queue);
+
+  const size_t NUMBER_OF_BLOCKS = 5;
+  std::vector<Crypto::Hash> randomHashes;
+  for (size_t i = 0; i < NUMBER_OF_BLOCKS; ++i) {
+    Crypto::Hash randomHash;
+    for (uint8_t& j : randomHash.data) {
+      j = rand();
+    }
+    randomHashes.push_back(randomHash);
+  }
+
+  for (auto h : randomHashes) {
+    ASSERT_NO_THROW(sendBlockchainMessage(BlockchainMessage(NewBlockMessage(h))));
+  }
+
+  ASSERT_NO_THROW(sendBlockchainMessage(BlockchainMessage(NewAlternativeBlockMessage(randomHashes[0]))));
+
+  contextGroup.spawn([&]() {
+    Crypto::Hash h;
+    ASSERT_TRUE(queue.front().getNewBlockHash(h));
+    ASSERT_EQ(h, randomHashes.front());
+    ASSERT_NO_THROW(queue.pop());
+
+    ASSERT_TRUE(queue.front().getTipChange(h));
+    ASSERT_EQ(h, randomHashes.back());
+    ASSERT_NO_THROW(queue.pop());
+  });
+
+  contextGroup.wait();
+}
+
 TEST_F(MessageQueueTest, doubleAddQueueToList) {
   MessageQueue<BlockchainMessage> queue(dispatcher);
   ASSERT_TRUE(blockchainMessageQueueList.insert(queue));
@@ -0,0 +1,57 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+#include "Common/Metrics.h"
+
+using namespace Common;
+
+TEST(Metrics, countHistogram) {
+  MetricsHistogram histogram({ 1, 2, 5 });
+  histogram.add(uint64_t(1));
+  histogram.add(uint64_t(3));
+  histogram.add(uint64_t(5));
+  histogram.add(uint64_t(100));
+
+  ASSERT_EQ(4, histogram.bucketCount());
+  ASSERT_EQ(1, histogram.bucket(0));
+  ASSERT_EQ(0, histogram.bucket(1));
+  ASSERT_EQ(2, histogram.bucket(2));
+  ASSERT_EQ(1, histogram.bucket(3));
+  ASSERT_EQ(109, histogram.sum());
+  ASSERT_EQ(100, histogram.max());
+
+  std::ostringstream out;
+  writeMetricHistogram(out, "depth", std::string(), histogram, false);
+  ASSERT_EQ("depth_bucket{le=\"1\"} 1\ndepth_bucket{le=\"2\"} 1\ndepth_bucket{le=\"5\"} 3\ndepth_bucket{le=\"+Inf\"} 4\n"
+    "depth_sum 109\ndepth_count 4\n", out.str());
+}
+
+TEST(Metrics, durationHistogram) {
+  MetricsHistogram histogram;
+  histogram.add(std::chrono::milliseconds(20));
+
+  std::ostringstream out;
+  writeMetricHistogram(out, "time_seconds", "stage=\"pow\"", histogram, true);
+  std::string text = out.str();
+  ASSERT_NE(std::string::npos, text.find("time_seconds_bucket{stage=\"pow\",le=\"0.01\"} 0\n"));
+  ASSERT_NE(std::string::npos, text.find("time_seconds_bucket{stage=\"pow\",le=\"0.05\"} 1\n"));
+  ASSERT_NE(std::string::npos, text.find("time_seconds_sum{stage=\"pow\"} 0.02\n"));
+}
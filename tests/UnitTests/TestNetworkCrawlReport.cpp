@@ -0,0 +1,125 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gtest/gtest.h"
+
+#include <System/Ipv4Address.h>
+
+#include "Common/JsonValue.h"
+#include "P2p/NetworkCrawlReport.h"
+#include "Serialization/SerializationTools.h"
+
+using namespace CryptoNote;
+using namespace Common;
+
+namespace {
+
+NetworkAddress address(const std::string& ip, uint32_t port) {
+  return NetworkAddress{ hostToNetwork(System::Ipv4Address(ip).getValue()), port };
+}
+
+CrawledNode reachedNode(const std::string& ip, uint8_t version, uint32_t height, uint64_t handshakeMs) {
+  CrawledNode node;
+  node.address = address(ip, 32347);
+  node.status = "OK";
+  node.version = version;
+  node.height = height;
+  node.handshakeMs = handshakeMs;
+  return node;
+}
+
+CrawledNode failedNode(const std::string& ip) {
+  CrawledNode node;
+  node.address = address(ip, 32347);
+  node.status = "ERROR: connection failed";
+  return node;
+}
+
+}
+
+TEST(NetworkCrawlReport, emptyCrawlHasZeroStatistics) {
+  CrawlReport report = makeCrawlReport(std::vector<CrawledNode>());
+  ASSERT_EQ(0, report.statistics.discovered);
+  ASSERT_EQ(0, report.statistics.reached);
+  ASSERT_EQ(0, report.statistics.maxHeight);
+  ASSERT_EQ(0, report.statistics.handshakeMsMedian);
+  ASSERT_TRUE(report.statistics.versions.empty());
+  ASSERT_TRUE(report.statistics.heights.empty());
+}
+
+TEST(NetworkCrawlReport, aggregatesReachedNodesOnly) {
+  std::vector<CrawledNode> nodes;
+  nodes.push_back(reachedNode("1.1.1.1", 3, 100, 40));
+  nodes.push_back(failedNode("2.2.2.2"));
+  nodes.push_back(reachedNode("3.3.3.3", 4, 99, 10));
+  nodes.push_back(reachedNode("4.4.4.4", 3, 90, 30));
+  nodes.push_back(reachedNode("5.5.5.5", 3, 100, 20));
+
+  CrawlStatistics statistics = makeCrawlReport(nodes).statistics;
+  ASSERT_EQ(5, statistics.discovered);
+  ASSERT_EQ(4, statistics.reached);
+  ASSERT_EQ(100, statistics.maxHeight);
+
+  // only the node more than CRAWL_BEHIND_BLOCKS below the top is behind
+  ASSERT_EQ(1, statistics.behind);
+
+  ASSERT_EQ(30, statistics.handshakeMsMedian);
+  ASSERT_EQ(40, statistics.handshakeMs90);
+  ASSERT_EQ(40, statistics.handshakeMsMax);
+
+  ASSERT_EQ(2, statistics.versions.size());
+  ASSERT_EQ(3, statistics.versions[0].value);
+  ASSERT_EQ(3, statistics.versions[0].count);
+  ASSERT_EQ(4, statistics.versions[1].value);
+  ASSERT_EQ(1, statistics.versions[1].count);
+
+  ASSERT_EQ(3, statistics.heights.size());
+  ASSERT_EQ(100, statistics.heights[0].value);
+  ASSERT_EQ(2, statistics.heights[0].count);
+  ASSERT_EQ(99, statistics.heights[1].value);
+  ASSERT_EQ(90, statistics.heights[2].value);
+}
+
+TEST(NetworkCrawlReport, serializesTopologyAsJson) {
+  std::vector<CrawledNode> nodes;
+  nodes.push_back(reachedNode("1.2.3.4", 3, 100, 15));
+  nodes.back().peers.push_back(address("5.6.7.8", 32347));
+  nodes.back().peers.push_back(address("9.9.9.9", 1000));
+  nodes.push_back(failedNode("5.6.7.8"));
+
+  JsonValue json = JsonValue::fromString(storeToJson(makeCrawlReport(nodes)));
+  ASSERT_EQ(2, json("statistics")("discovered").getInteger());
+  ASSERT_EQ(1, json("statistics")("reached").getInteger());
+  ASSERT_EQ(100, json("statistics")("heights")[0]("value").getInteger());
+
+  const JsonValue& reached = json("nodes")[0];
+  ASSERT_EQ("1.2.3.4:32347", reached("address").getString());
+  ASSERT_EQ("OK", reached("status").getString());
+  ASSERT_EQ(100, reached("height").getInteger());
+  ASSERT_EQ(15, reached("handshakeMs").getInteger());
+  ASSERT_EQ(2, reached("peers").size());
+  ASSERT_EQ("5.6.7.8:32347", reached("peers")[0].getString());
+  ASSERT_EQ("9.9.9.9:1000", reached("peers")[1].getString());
+
+  // a node that wasn't reached has only its address and error
+  const JsonValue& failed = json("nodes")[1];
+  ASSERT_EQ("5.6.7.8:32347", failed("address").getString());
+  ASSERT_EQ("ERROR: connection failed", failed("status").getString());
+  ASSERT_FALSE(failed.contains("height"));
+  ASSERT_EQ(0, failed("peers").size());
+}
@@ -74,3 +74,130 @@ TEST(peer_list, merge_peer_lists)
 
 
 }
+
+TEST(peer_list, peers_by_index_are_ordered_by_last_seen)
+{
+  PeerlistManager plm;
+  plm.init(false);
+
+  // appended out of order, index 0 must be the most recently seen one
+  const uint64_t stamps[] = { 500, 100, 900, 300, 700 };
+  for (size_t i = 0; i < sizeof(stamps) / sizeof(stamps[0]); ++i) {
+    ADD_WHITE_NODE(MAKE_IP(123, 43, 12, i + 1), 8080, 1000 + i, stamps[i]);
+  }
+
+  const uint64_t expected[] = { 900, 700, 500, 300, 100 };
+  for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) {
+    PeerlistEntry pe;
+    ASSERT_TRUE(plm.get_white_peer_by_index(pe, i));
+    ASSERT_EQ(expected[i], pe.last_seen);
+  }
+
+  PeerlistEntry pe;
+  ASSERT_FALSE(plm.get_white_peer_by_index(pe, 5));
+}
+
+TEST(peer_list, merge_keeps_the_newest_entries)
+{
+  PeerlistManager plm;
+  plm.init(false);
+  ADD_WHITE_NODE(MAKE_IP(123, 43, 12, 1), 8080, 1, 500);
+  ADD_GRAY_NODE(MAKE_IP(123, 43, 12, 2), 8080, 2, 500);
+
+  std::vector<PeerlistEntry> outer_bs;
+  auto add = [&outer_bs](uint32_t ip, uint64_t last_seen) {
+    PeerlistEntry ple;
+    ple.adr.ip = ip;
+    ple.adr.port = 8080;
+    ple.id = ip;
+    ple.last_seen = last_seen;
+    outer_bs.push_back(ple);
+  };
+
+  add(MAKE_IP(123, 43, 12, 1), 900);    // known white peer
+  add(MAKE_IP(123, 43, 12, 2), 100);    // older than ours
+  add(MAKE_IP(123, 43, 12, 3), 300);
+  add(MAKE_IP(123, 43, 12, 3), 700);    // duplicate, the newer wins
+  add(MAKE_IP(123, 43, 12, 3), 200);
+  add(MAKE_IP(127, 0, 0, 1), 900);      // not allowed
+  ASSERT_TRUE(plm.merge_peerlist(outer_bs));
+
+  ASSERT_EQ(1, plm.get_white_peers_count());
+  ASSERT_EQ(2, plm.get_gray_peers_count());
+
+  PeerlistEntry pe;
+  ASSERT_TRUE(plm.get_gray_peer_by_index(pe, 0));
+  ASSERT_EQ(MAKE_IP(123, 43, 12, 3), pe.adr.ip);
+  ASSERT_EQ(700, pe.last_seen);
+  ASSERT_TRUE(plm.get_gray_peer_by_index(pe, 1));
+  ASSERT_EQ(MAKE_IP(123, 43, 12, 2), pe.adr.ip);
+  ASSERT_EQ(500, pe.last_seen);
+}
+
+TEST(peer_list, delta_holds_only_new_and_seen_again_peers)
+{
+  PeerlistManager plm;
+  plm.init(false);
+  for (uint8_t i = 1; i <= 10; ++i) {
+    ADD_WHITE_NODE(MAKE_IP(123, 43, 12, i), 8080, i, 1000);
+  }
+
+  std::map<NetworkAddress, uint64_t> sent;
+  std::vector<PeerlistEntry> delta;
+  ASSERT_TRUE(plm.get_peerlist_delta(sent, delta, 100, 6));
+  ASSERT_EQ(6, delta.size());
+  ASSERT_EQ(6, sent.size());
+
+  // the rest, then nothing
+  delta.clear();
+  plm.get_peerlist_delta(sent, delta, 100, 6);
+  ASSERT_EQ(4, delta.size());
+  delta.clear();
+  plm.get_peerlist_delta(sent, delta, 100, 6);
+  ASSERT_TRUE(delta.empty());
+
+  // seen a bit later isn't worth sending, seen much later is
+  ADD_WHITE_NODE(MAKE_IP(123, 43, 12, 1), 8080, 1, 1050);
+  ADD_WHITE_NODE(MAKE_IP(123, 43, 12, 2), 8080, 2, 1100);
+  plm.get_peerlist_delta(sent, delta, 100, 6);
+  ASSERT_EQ(1, delta.size());
+  ASSERT_EQ(MAKE_IP(123, 43, 12, 2), delta[0].adr.ip);
+  ASSERT_EQ(1100, sent[delta[0].adr]);
+}
+
+TEST(peer_list, modification_counter_changes_only_with_lists)
+{
+  PeerlistManager plm;
+  plm.init(false);
+  uint64_t counter = plm.getModificationCounter();
+
+  // reading and merging nothing new leave it alone
+  std::list<AnchorPeerlistEntry> anchor;
+  std::vector<PeerlistEntry> gray;
+  std::vector<PeerlistEntry> white;
+  plm.get_peerlist_full(anchor, gray, white);
+  ASSERT_TRUE(plm.merge_peerlist(std::vector<PeerlistEntry>()));
+  ASSERT_EQ(counter, plm.getModificationCounter());
+
+  ADD_GRAY_NODE(MAKE_IP(123, 43, 12, 1), 8080, 1, 1000);
+  ASSERT_NE(counter, plm.getModificationCounter());
+  counter = plm.getModificationCounter();
+
+  PeerlistEntry older;
+  older.adr.ip = MAKE_IP(123, 43, 12, 1);
+  older.adr.port = 8080;
+  older.id = 1;
+  older.last_seen = 500;
+  ASSERT_TRUE(plm.merge_peerlist(std::vector<PeerlistEntry>{ older }));
+  ASSERT_EQ(counter, plm.getModificationCounter());
+
+  ADD_WHITE_NODE(MAKE_IP(123, 43, 12, 1), 8080, 1, 2000);
+  ASSERT_NE(counter, plm.getModificationCounter());
+  counter = plm.getModificationCounter();
+
+  PeerlistEntry missing;
+  missing.adr.ip = MAKE_IP(123, 43, 12, 9);
+  missing.adr.port = 8080;
+  ASSERT_TRUE(plm.remove_from_peer_gray(missing));
+  ASSERT_EQ(counter, plm.getModificationCounter());
+}
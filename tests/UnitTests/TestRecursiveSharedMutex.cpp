@@ -0,0 +1,141 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include "Common/RecursiveSharedMutex.h"
+
+using namespace Tools;
+
+namespace {
+
+const auto SETTLE_TIME = std::chrono::milliseconds(100);
+
+bool tryLockFromOtherThread(RecursiveSharedMutex& mutex) {
+  bool locked = false;
+  std::thread([&] {
+    locked = mutex.try_lock();
+    if (locked) {
+      mutex.unlock();
+    }
+  }).join();
+
+  return locked;
+}
+
+}
+
+TEST(RecursiveSharedMutex, exclusiveLockIsRecursive) {
+  RecursiveSharedMutex mutex;
+  mutex.lock();
+  mutex.lock();
+  ASSERT_TRUE(mutex.try_lock());
+  mutex.unlock();
+  mutex.unlock();
+  ASSERT_FALSE(tryLockFromOtherThread(mutex));
+
+  mutex.unlock();
+  ASSERT_TRUE(tryLockFromOtherThread(mutex));
+}
+
+TEST(RecursiveSharedMutex, sharedLockIsRecursive) {
+  RecursiveSharedMutex mutex;
+  mutex.lock_shared();
+  mutex.lock_shared();
+  mutex.unlock_shared();
+  ASSERT_FALSE(tryLockFromOtherThread(mutex));
+
+  mutex.unlock_shared();
+  ASSERT_TRUE(tryLockFromOtherThread(mutex));
+}
+
+TEST(RecursiveSharedMutex, upgradeThrowsInsteadOfDeadlocking) {
+  RecursiveSharedMutex mutex;
+  mutex.lock_shared();
+  ASSERT_THROW(mutex.lock(), std::logic_error);
+  ASSERT_FALSE(mutex.try_lock());
+  mutex.unlock_shared();
+
+  mutex.lock();
+  mutex.unlock();
+  ASSERT_TRUE(tryLockFromOtherThread(mutex));
+}
+
+TEST(RecursiveSharedMutex, writerTakesSharedLock) {
+  RecursiveSharedMutex mutex;
+  mutex.lock();
+  mutex.lock_shared();
+  mutex.lock_shared();
+  mutex.unlock_shared();
+  mutex.unlock_shared();
+  ASSERT_FALSE(tryLockFromOtherThread(mutex));
+
+  mutex.unlock();
+  ASSERT_TRUE(tryLockFromOtherThread(mutex));
+}
+
+TEST(RecursiveSharedMutex, sharedLockOutlivesExclusiveOne) {
+  RecursiveSharedMutex mutex;
+  mutex.lock();
+  mutex.lock_shared();
+  mutex.unlock();
+  ASSERT_FALSE(tryLockFromOtherThread(mutex));
+
+  mutex.unlock_shared();
+  ASSERT_TRUE(tryLockFromOtherThread(mutex));
+}
+
+TEST(RecursiveSharedMutex, waitingWriterBlocksNewReadersOnly) {
+  RecursiveSharedMutex mutex;
+  std::atomic<int> sequence(0);
+  std::atomic<int> writerOrder(0);
+  std::atomic<int> readerOrder(0);
+
+  mutex.lock_shared();
+  std::thread writer([&] {
+    mutex.lock();
+    writerOrder = ++sequence;
+    mutex.unlock();
+  });
+
+  std::this_thread::sleep_for(SETTLE_TIME);
+  std::thread reader([&] {
+    mutex.lock_shared();
+    readerOrder = ++sequence;
+    mutex.unlock_shared();
+  });
+
+  std::this_thread::sleep_for(SETTLE_TIME);
+  ASSERT_EQ(0, sequence.load());
+
+  // a thread already reading re-enters without waiting for the writer
+  mutex.lock_shared();
+  mutex.unlock_shared();
+  ASSERT_EQ(0, sequence.load());
+
+  mutex.unlock_shared();
+  writer.join();
+  reader.join();
+  ASSERT_EQ(1, writerOrder.load());
+  ASSERT_EQ(2, readerOrder.load());
+}
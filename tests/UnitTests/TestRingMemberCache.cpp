@@ -0,0 +1,79 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+
+#include "CryptoNoteCore/RingMemberCache.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+Crypto::PublicKey makeKey() {
+  Crypto::PublicKey publicKey;
+  Crypto::SecretKey secretKey;
+  Crypto::generate_keys(publicKey, secretKey);
+  return publicKey;
+}
+
+}
+
+TEST(RingMemberCache, returnsSameTablesOnHit) {
+  RingMemberCache cache(2);
+  Crypto::PublicKey key = makeKey();
+
+  auto first = cache.get(key);
+  auto second = cache.get(key);
+  ASSERT_TRUE(first != nullptr);
+  ASSERT_EQ(first, second);
+  ASSERT_EQ(1, cache.hits());
+  ASSERT_EQ(1, cache.misses());
+
+  Crypto::RingMemberPrecomp expected;
+  ASSERT_TRUE(Crypto::precompute_ring_member(key, expected));
+  ASSERT_EQ(0, std::memcmp(&expected, first.get(), sizeof(expected)));
+}
+
+TEST(RingMemberCache, evictsLeastRecentlyUsed) {
+  RingMemberCache cache(2);
+  Crypto::PublicKey key1 = makeKey();
+  Crypto::PublicKey key2 = makeKey();
+  Crypto::PublicKey key3 = makeKey();
+
+  cache.get(key1);
+  cache.get(key2);
+  cache.get(key1);
+  cache.get(key3);
+  ASSERT_EQ(2, cache.size());
+
+  cache.get(key1);
+  ASSERT_EQ(2, cache.hits());
+  cache.get(key2);
+  ASSERT_EQ(4, cache.misses());
+}
+
+TEST(RingMemberCache, rejectsKeyOffTheCurve) {
+  RingMemberCache cache(2);
+  Crypto::PublicKey key;
+  std::memset(&key, 0xff, sizeof(key));
+
+  ASSERT_TRUE(cache.get(key) == nullptr);
+  ASSERT_EQ(0, cache.size());
+}
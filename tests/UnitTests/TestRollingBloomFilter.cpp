@@ -0,0 +1,100 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+
+#include "crypto/hash.h"
+#include "P2p/RollingBloomFilter.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+Crypto::Hash makeHash(uint64_t n) {
+  return Crypto::cn_fast_hash(&n, sizeof(n));
+}
+
+}
+
+TEST(RollingBloomFilter, containsInsertedHashes) {
+  RollingBloomFilter filter;
+  for (uint64_t i = 0; i < RollingBloomFilter::GENERATION_SIZE; ++i) {
+    filter.insert(makeHash(i));
+  }
+
+  for (uint64_t i = 0; i < RollingBloomFilter::GENERATION_SIZE; ++i) {
+    ASSERT_TRUE(filter.contains(makeHash(i)));
+  }
+}
+
+TEST(RollingBloomFilter, hasFewFalsePositives) {
+  RollingBloomFilter filter;
+  for (uint64_t i = 0; i < 2 * RollingBloomFilter::GENERATION_SIZE; ++i) {
+    filter.insert(makeHash(i));
+  }
+
+  size_t falsePositives = 0;
+  for (uint64_t i = 0; i < 100000; ++i) {
+    if (filter.contains(makeHash(10000000 + i))) {
+      ++falsePositives;
+    }
+  }
+
+  ASSERT_LT(falsePositives, 500);
+}
+
+TEST(RollingBloomFilter, forgetsOldGenerations) {
+  RollingBloomFilter filter;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    filter.insert(makeHash(i));
+  }
+
+  for (uint64_t i = 0; i < 3 * RollingBloomFilter::GENERATION_SIZE; ++i) {
+    filter.insert(makeHash(1000000 + i));
+  }
+
+  size_t remembered = 0;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    if (filter.contains(makeHash(i))) {
+      ++remembered;
+    }
+  }
+
+  ASSERT_LT(remembered, 50);
+  ASSERT_TRUE(filter.contains(makeHash(1000000 + 3 * RollingBloomFilter::GENERATION_SIZE - 1)));
+}
+
+TEST(RollingBloomFilter, isSaltedPerInstance) {
+  RollingBloomFilter first;
+  RollingBloomFilter second;
+  size_t sameAnswers = 0;
+  for (uint64_t i = 0; i < 2 * RollingBloomFilter::GENERATION_SIZE; ++i) {
+    first.insert(makeHash(i));
+    second.insert(makeHash(i));
+  }
+
+  for (uint64_t i = 0; i < 100000; ++i) {
+    Crypto::Hash hash = makeHash(10000000 + i);
+    if (first.contains(hash) && second.contains(hash)) {
+      ++sameAnswers;
+    }
+  }
+
+  ASSERT_LT(sameAnswers, 10);
+}
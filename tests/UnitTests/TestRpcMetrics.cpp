@@ -0,0 +1,113 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+
+#include "Common/RecursiveSharedMutex.h"
+#include "Rpc/RpcMetrics.h"
+
+using namespace CryptoNote;
+
+TEST(RpcMetrics, countsCallsAndErrors) {
+  RpcMetrics metrics;
+  RpcMetrics::Endpoint& endpoint = metrics.endpoint("/getinfo");
+  {
+    RpcMetrics::Call call(endpoint);
+    ASSERT_EQ(1, endpoint.inFlight);
+    ASSERT_TRUE(call.execute([] { return true; }));
+    call.setBytes(3, 10);
+    call.succeed();
+  }
+
+  {
+    RpcMetrics::Call call(endpoint);
+  }
+
+  ASSERT_EQ(&endpoint, &metrics.endpoint("/getinfo"));
+  ASSERT_NE(&endpoint, &metrics.endpoint("/json_rpc", "getinfo"));
+  ASSERT_EQ(2, endpoint.calls);
+  ASSERT_EQ(1, endpoint.errors);
+  ASSERT_EQ(0, endpoint.inFlight);
+  ASSERT_EQ(3, endpoint.bytesIn);
+  ASSERT_EQ(10, endpoint.bytesOut);
+  ASSERT_EQ(2, endpoint.latency.count());
+}
+
+TEST(RpcMetrics, histogramBuckets) {
+  RpcMetrics::Histogram histogram;
+  histogram.add(std::chrono::microseconds(1000));
+  histogram.add(std::chrono::microseconds(1001));
+  histogram.add(std::chrono::seconds(60));
+
+  ASSERT_EQ(1, histogram.bucket(0));
+  ASSERT_EQ(1, histogram.bucket(1));
+  ASSERT_EQ(1, histogram.bucket(RpcMetrics::Histogram::BUCKETS - 1));
+  ASSERT_EQ(3, histogram.count());
+  ASSERT_EQ(60002001, histogram.sumMicroseconds());
+  ASSERT_EQ(60000000, histogram.maxMicroseconds());
+}
+
+TEST(RpcMetrics, prometheusText) {
+  RpcMetrics metrics;
+  {
+    RpcMetrics::Call call(metrics.endpoint("/json_rpc", "getblockcount"));
+    call.succeed();
+  }
+
+  std::string text = metrics.prometheusText();
+  ASSERT_NE(std::string::npos, text.find("# TYPE karbo_rpc_calls_total counter\n"));
+  ASSERT_NE(std::string::npos, text.find("karbo_rpc_calls_total{endpoint=\"/json_rpc\",method=\"getblockcount\"} 1\n"));
+  ASSERT_NE(std::string::npos, text.find("karbo_rpc_errors_total{endpoint=\"/json_rpc\",method=\"getblockcount\"} 0\n"));
+  ASSERT_NE(std::string::npos, text.find("karbo_rpc_call_duration_seconds_bucket{endpoint=\"/json_rpc\",method=\"getblockcount\",le=\"0.005\"} 1\n"));
+  ASSERT_NE(std::string::npos, text.find("karbo_rpc_lock_wait_seconds_bucket{endpoint=\"/json_rpc\",method=\"getblockcount\",le=\"+Inf\"} 1\n"));
+  ASSERT_NE(std::string::npos, text.find("karbo_rpc_lock_wait_seconds_sum{endpoint=\"/json_rpc\",method=\"getblockcount\"} 0\n"));
+  // bytes are not split between the methods of a request
+  ASSERT_EQ(std::string::npos, text.find("karbo_rpc_sent_bytes_total{endpoint=\"/json_rpc\",method"));
+}
+
+TEST(RpcMetrics, measuresBlockchainLockWait) {
+  Tools::RecursiveSharedMutex mutex;
+  RpcMetrics metrics;
+  RpcMetrics::Endpoint& endpoint = metrics.endpoint("/getblocks.bin");
+
+  std::promise<void> locked;
+  std::thread writer([&mutex, &locked] {
+    mutex.lock();
+    locked.set_value();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    mutex.unlock();
+  });
+
+  locked.get_future().wait();
+
+  {
+    RpcMetrics::Call call(endpoint);
+    call.execute([&mutex] {
+      Tools::SharedLockGuard<Tools::RecursiveSharedMutex> lock(mutex);
+      return true;
+    });
+  }
+
+  writer.join();
+  ASSERT_GE(endpoint.lockWait.sumMicroseconds(), 40000);
+  ASSERT_GE(endpoint.latency.sumMicroseconds(), endpoint.lockWait.sumMicroseconds());
+}
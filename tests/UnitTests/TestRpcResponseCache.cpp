@@ -0,0 +1,74 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "Rpc/RpcResponseCache.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+Crypto::Hash makeHash(uint8_t value) {
+  Crypto::Hash hash = Crypto::Hash();
+  hash.data[0] = value;
+  return hash;
+}
+
+}
+
+TEST(RpcResponseCache, returnsStoredValue) {
+  RpcResponseCache<std::string> cache(2);
+  cache.put(makeHash(1), 10, "one");
+
+  std::string value;
+  ASSERT_TRUE(cache.get(makeHash(1), value));
+  ASSERT_EQ("one", value);
+  ASSERT_FALSE(cache.get(makeHash(2), value));
+  ASSERT_EQ(1, cache.hits());
+  ASSERT_EQ(1, cache.misses());
+}
+
+TEST(RpcResponseCache, evictsLeastRecentlyUsed) {
+  RpcResponseCache<std::string> cache(2);
+  cache.put(makeHash(1), 10, "one");
+  cache.put(makeHash(2), 20, "two");
+
+  std::string value;
+  ASSERT_TRUE(cache.get(makeHash(1), value));
+  cache.put(makeHash(3), 30, "three");
+
+  ASSERT_TRUE(cache.get(makeHash(1), value));
+  ASSERT_FALSE(cache.get(makeHash(2), value));
+  ASSERT_TRUE(cache.get(makeHash(3), value));
+}
+
+TEST(RpcResponseCache, removesRolledBackBlocks) {
+  RpcResponseCache<std::string> cache(10);
+  cache.put(makeHash(1), 10, "one");
+  cache.put(makeHash(2), 20, "two");
+  cache.put(makeHash(3), 30, "three");
+
+  cache.removeFrom(20);
+
+  std::string value;
+  ASSERT_TRUE(cache.get(makeHash(1), value));
+  ASSERT_FALSE(cache.get(makeHash(2), value));
+  ASSERT_FALSE(cache.get(makeHash(3), value));
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "Common/Math.h"
+#include "Common/SlidingMedian.h"
+
+using namespace Common;
+
+namespace {
+
+size_t referenceMedian(const std::deque<size_t>& window) {
+  std::vector<size_t> values(window.begin(), window.end());
+  return medianValue(values);
+}
+
+}
+
+TEST(SlidingMedian, emptyWindowGivesDefaultValue) {
+  SlidingMedian<size_t> median;
+  ASSERT_EQ(0, median.median());
+}
+
+TEST(SlidingMedian, oddAndEvenSizes) {
+  SlidingMedian<size_t> median;
+  median.push_back(5);
+  ASSERT_EQ(5, median.median());
+  median.push_back(1);
+  ASSERT_EQ(3, median.median());
+  median.push_back(9);
+  ASSERT_EQ(5, median.median());
+  median.pop_front();
+  ASSERT_EQ(5, median.median());
+  median.push_front(9);
+  ASSERT_EQ(9, median.median());
+}
+
+TEST(SlidingMedian, matchesMedianValueOnSlidingWindow) {
+  const size_t WINDOW = 100;
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<size_t> sizes(0, 50);
+  std::deque<size_t> history;
+  std::deque<size_t> window;
+  SlidingMedian<size_t> median;
+
+  for (size_t i = 0; i < 2000; ++i) {
+    // mostly grow the chain, sometimes pop a few blocks like a reorganisation does
+    if (!history.empty() && generator() % 5 == 0) {
+      history.pop_back();
+      window.pop_back();
+      median.pop_back();
+      if (history.size() >= WINDOW) {
+        window.push_front(history[history.size() - WINDOW]);
+        median.push_front(history[history.size() - WINDOW]);
+      }
+    } else {
+      size_t value = sizes(generator);
+      history.push_back(value);
+      window.push_back(value);
+      median.push_back(value);
+      if (window.size() > WINDOW) {
+        window.pop_front();
+        median.pop_front();
+      }
+    }
+
+    ASSERT_EQ(window.size(), median.size());
+    ASSERT_EQ(referenceMedian(window), median.median());
+  }
+}
@@ -0,0 +1,109 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Common/StringTools.h"
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+
+using namespace Crypto;
+
+namespace {
+
+// vectors of tests/Hash/tests-slow.txt, hash followed by data
+const char* const SLOW_HASH_VECTORS[][2] = {
+  { "2f8e3df40bd11f9ac90c743ca8e32bb391da4fb98612aa3b6cdc639ee00b31f5", "6465206f6d6e69627573206475626974616e64756d" },
+  { "722fa8ccd594d40e4a41f3822734304c8d5eff7e1b528408e2229da38ba553c4", "6162756e64616e732063617574656c61206e6f6e206e6f636574" },
+  { "bbec2cacf69866a8e740380fe7b818fc78f8571221742d729d9d02d7f8989b87", "63617665617420656d70746f72" },
+  { "b1257de4efc5ce28c6b40ceb1c6c8f812a64634eb3e81c5220bee9b2b76a6f05", "6578206e6968696c6f206e6968696c20666974" }
+};
+
+const size_t VECTOR_COUNT = sizeof(SLOW_HASH_VECTORS) / sizeof(SLOW_HASH_VECTORS[0]);
+
+// lane lengths differ, some cross the 136 byte keccak rate
+const size_t LANE_LENGTHS[] = { 76, 1, 43, 137, 200 };
+
+void hashLanes(cn_context& context, const std::vector<std::vector<uint8_t>>& inputs, std::vector<Hash>& hashes) {
+  std::vector<const void*> data;
+  std::vector<size_t> length;
+  for (const auto& input : inputs) {
+    data.push_back(input.data());
+    length.push_back(input.size());
+  }
+
+  hashes.resize(inputs.size());
+  cn_slow_hash_multi(context, data.data(), length.data(), inputs.size(), hashes.data());
+}
+
+}
+
+TEST(SlowHashMulti, lanesMatchSingleHash) {
+  cn_context context;
+  std::mt19937 generator(19);
+
+  for (size_t ways = 2; ways <= 5; ++ways) {
+    std::vector<std::vector<uint8_t>> inputs;
+    for (size_t lane = 0; lane < ways; ++lane) {
+      std::vector<uint8_t> input(LANE_LENGTHS[lane]);
+      for (auto& byte : input) {
+        byte = static_cast<uint8_t>(generator());
+      }
+
+      inputs.push_back(input);
+    }
+
+    std::vector<Hash> hashes;
+    hashLanes(context, inputs, hashes);
+
+    for (size_t lane = 0; lane < ways; ++lane) {
+      Hash expected;
+      cn_slow_hash(context, inputs[lane].data(), inputs[lane].size(), expected);
+      ASSERT_EQ(expected, hashes[lane]) << "ways " << ways << ", lane " << lane;
+    }
+  }
+}
+
+TEST(SlowHashMulti, lanesMatchHashVectors) {
+  cn_context context;
+
+  for (size_t ways = 2; ways <= 5; ++ways) {
+    // every pass starts on another vector so each one lands in several lanes
+    for (size_t first = 0; first < VECTOR_COUNT; ++first) {
+      std::vector<std::vector<uint8_t>> inputs;
+      std::vector<Hash> expected;
+      for (size_t lane = 0; lane < ways; ++lane) {
+        const auto& vector = SLOW_HASH_VECTORS[(first + lane) % VECTOR_COUNT];
+        inputs.push_back(Common::fromHex(vector[1]));
+
+        Hash hash;
+        ASSERT_TRUE(Common::podFromHex(vector[0], hash));
+        expected.push_back(hash);
+      }
+
+      std::vector<Hash> hashes;
+      hashLanes(context, inputs, hashes);
+      for (size_t lane = 0; lane < ways; ++lane) {
+        ASSERT_EQ(expected[lane], hashes[lane]) << "ways " << ways << ", lane " << lane;
+      }
+    }
+  }
+}
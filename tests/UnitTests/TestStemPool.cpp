@@ -0,0 +1,134 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteProtocol/StemPool.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+Crypto::Hash makeHash(uint8_t n) {
+  Crypto::Hash hash = {};
+  hash.data[0] = n;
+  return hash;
+}
+
+const time_t START = 1000000;
+
+}
+
+TEST(StemPool, transactionsExpireWithTheirOwnEmbargo) {
+  StemPool pool(100, 1024 * 1024, 60);
+  StemPool::Transactions evicted;
+  ASSERT_TRUE(pool.addTransaction(makeHash(1), "a", START, 10, evicted));
+  ASSERT_TRUE(pool.addTransaction(makeHash(2), "b", START, 3, evicted));
+  ASSERT_TRUE(pool.addTransaction(makeHash(3), "c", START + 1, 3, evicted));
+  ASSERT_FALSE(pool.addTransaction(makeHash(3), "c", START + 1, 3, evicted));
+  ASSERT_TRUE(evicted.empty());
+
+  StemPool::Transactions expired;
+  pool.takeExpiredTransactions(START + 2, expired);
+  ASSERT_TRUE(expired.empty());
+
+  pool.takeExpiredTransactions(START + 3, expired);
+  ASSERT_EQ(1, expired.size());
+  ASSERT_EQ("b", expired[0].second);
+
+  expired.clear();
+  pool.takeExpiredTransactions(START + 4, expired);
+  ASSERT_EQ(1, expired.size());
+  ASSERT_EQ("c", expired[0].second);
+
+  expired.clear();
+  pool.takeExpiredTransactions(START + 20, expired);
+  ASSERT_EQ(1, expired.size());
+  ASSERT_EQ("a", expired[0].second);
+  ASSERT_EQ(0, pool.getTransactionsCount());
+  ASSERT_EQ(0, pool.getSize());
+}
+
+TEST(StemPool, removedTransactionsDontExpire) {
+  StemPool pool(100, 1024 * 1024, 60);
+  StemPool::Transactions evicted;
+  pool.addTransaction(makeHash(1), "a", START, 5, evicted);
+  ASSERT_TRUE(pool.removeTransaction(makeHash(1)));
+  ASSERT_FALSE(pool.removeTransaction(makeHash(1)));
+
+  // added again later, the old slot doesn't expire it early
+  pool.addTransaction(makeHash(1), "a", START + 2, 10, evicted);
+
+  StemPool::Transactions expired;
+  pool.takeExpiredTransactions(START + 5, expired);
+  ASSERT_TRUE(expired.empty());
+  pool.takeExpiredTransactions(START + 12, expired);
+  ASSERT_EQ(1, expired.size());
+}
+
+TEST(StemPool, embargoIsLimited) {
+  StemPool pool(100, 1024 * 1024, 60);
+  StemPool::Transactions evicted;
+  pool.addTransaction(makeHash(1), "a", START, 1000, evicted);
+
+  StemPool::Transactions expired;
+  pool.takeExpiredTransactions(START + 59, expired);
+  ASSERT_TRUE(expired.empty());
+  pool.takeExpiredTransactions(START + 60, expired);
+  ASSERT_EQ(1, expired.size());
+}
+
+TEST(StemPool, longPauseExpiresEverythingDue) {
+  StemPool pool(100, 1024 * 1024, 60);
+  StemPool::Transactions evicted;
+  for (uint8_t i = 0; i < 50; ++i) {
+    pool.addTransaction(makeHash(i), "x", START, i + 1, evicted);
+  }
+
+  StemPool::Transactions expired;
+  pool.takeExpiredTransactions(START + 10000, expired);
+  ASSERT_EQ(50, expired.size());
+}
+
+TEST(StemPool, oldestTransactionsAreEvicted) {
+  StemPool pool(3, 10, 60);
+  StemPool::Transactions evicted;
+  pool.addTransaction(makeHash(1), "aaaa", START, 5, evicted);
+  pool.addTransaction(makeHash(2), "bbbb", START, 5, evicted);
+  pool.addTransaction(makeHash(3), "cc", START, 5, evicted);
+  ASSERT_TRUE(evicted.empty());
+
+  // over the count
+  pool.addTransaction(makeHash(4), "d", START, 5, evicted);
+  ASSERT_EQ(1, evicted.size());
+  ASSERT_EQ("aaaa", evicted[0].second);
+
+  // over the size
+  evicted.clear();
+  pool.addTransaction(makeHash(5), "eeeeeeee", START, 5, evicted);
+  ASSERT_EQ(2, evicted.size());
+  ASSERT_EQ("bbbb", evicted[0].second);
+  ASSERT_EQ("cc", evicted[1].second);
+  ASSERT_EQ(2, pool.getTransactionsCount());
+  ASSERT_EQ(9, pool.getSize());
+  ASSERT_FALSE(pool.hasTransaction(makeHash(1)));
+  ASSERT_TRUE(pool.hasTransaction(makeHash(5)));
+
+  StemPool::Transactions expired;
+  pool.takeExpiredTransactions(START + 5, expired);
+  ASSERT_EQ(2, expired.size());
+}
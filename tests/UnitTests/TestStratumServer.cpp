@@ -0,0 +1,348 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <System/Dispatcher.h>
+#include <System/Ipv4Address.h>
+#include <System/TcpConnection.h>
+#include <System/TcpConnector.h>
+#include <System/Timer.h>
+
+#include "../TestStubs/ICoreStub.h"
+#include "Common/JsonValue.h"
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/IMinerHandler.h"
+#include "CryptoNoteCore/TransactionExtra.h"
+#include "CryptoNoteCore/VerificationContext.h"
+#include "Logging/LoggerGroup.h"
+#include "Rpc/StratumServer.h"
+
+using namespace CryptoNote;
+using namespace Common;
+
+namespace {
+
+const std::string LISTEN_ADDRESS = "127.0.0.1";
+const uint16_t LISTEN_PORT = 6668;
+
+// builds templates with a real coinbase and keeps the blocks submitted to it
+class StratumCoreStub : public ICoreStub, public IMinerHandler {
+public:
+  explicit StratumCoreStub(const Currency& currency) : difficulty(UINT64_MAX), templateCount(0), m_currency(currency) {
+  }
+
+  virtual bool handle_block_found(Block& b) override {
+    return false;
+  }
+
+  virtual bool get_block_template(Block& b, const AccountPublicAddress& adr, difficulty_type& diffic, uint32_t& height, const BinaryArray& ex_nonce) override {
+    b = boost::value_initialized<Block>();
+    b.majorVersion = BLOCK_MAJOR_VERSION_1;
+    b.timestamp = 1;
+    height = 1;
+    diffic = difficulty;
+    ++templateCount;
+    return m_currency.constructMinerTx(b.majorVersion, height, 0, 0, 0, 0, adr, b.baseTransaction, ex_nonce);
+  }
+
+  virtual bool handle_incoming_block_blob(const BinaryArray& block_blob, block_verification_context& bvc, bool control_miner, bool relay_block) override {
+    Block block;
+    if (!fromBinaryArray(block, block_blob)) {
+      return false;
+    }
+
+    blocks.push_back(block);
+    bvc.m_added_to_main_chain = true;
+    return true;
+  }
+
+  difficulty_type difficulty;
+  size_t templateCount;
+  std::vector<Block> blocks;
+
+private:
+  const Currency& m_currency;
+};
+
+struct Client {
+  System::TcpConnection connection;
+  std::string buffer;
+};
+
+}
+
+class StratumServerTest : public ::testing::Test {
+public:
+  StratumServerTest() :
+    currency(CurrencyBuilder(logger).currency()),
+    core(currency),
+    server(dispatcher, logger, currency, core, core) {
+    AccountBase account;
+    account.generate();
+    address = currency.accountAddressAsString(account);
+  }
+
+protected:
+  virtual void SetUp() override {
+    server.start(LISTEN_ADDRESS, LISTEN_PORT, 1);
+  }
+
+  virtual void TearDown() override {
+    server.stop();
+  }
+
+  Client connect() {
+    return Client{System::TcpConnector(dispatcher).connect(System::Ipv4Address(LISTEN_ADDRESS), LISTEN_PORT), std::string()};
+  }
+
+  void write(Client& client, const std::string& data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+      offset += client.connection.write(reinterpret_cast<const uint8_t*>(data.data() + offset), data.size() - offset);
+    }
+  }
+
+  // false once the server closed the connection
+  bool readLine(Client& client, std::string& line) {
+    size_t lineEnd;
+    while ((lineEnd = client.buffer.find('\n')) == std::string::npos) {
+      uint8_t data[4096];
+      size_t transferred;
+      try {
+        transferred = client.connection.read(data, sizeof(data));
+      } catch (std::exception&) {
+        return false;
+      }
+
+      if (transferred == 0) {
+        return false;
+      }
+
+      client.buffer.append(reinterpret_cast<const char*>(data), transferred);
+    }
+
+    line = client.buffer.substr(0, lineEnd);
+    client.buffer.erase(0, lineEnd + 1);
+    return true;
+  }
+
+  bool isClosed(Client& client) {
+    std::string line;
+    return !readLine(client, line);
+  }
+
+  JsonValue readResponse(Client& client) {
+    std::string line;
+    if (!readLine(client, line)) {
+      throw std::runtime_error("Connection closed");
+    }
+
+    return JsonValue::fromString(line);
+  }
+
+  JsonValue call(Client& client, const std::string& method, const JsonValue& params) {
+    JsonValue request(JsonValue::OBJECT);
+    request.insert("id", static_cast<int64_t>(1));
+    request.insert("jsonrpc", "2.0");
+    request.insert("method", method);
+    request.insert("params", params);
+    write(client, request.toString() + "\n");
+    return readResponse(client);
+  }
+
+  std::string errorOf(const JsonValue& response) {
+    return response("error").isNil() ? std::string() : response("error")("message").getString();
+  }
+
+  JsonValue login(Client& client, const std::string& login) {
+    JsonValue params(JsonValue::OBJECT);
+    params.insert("login", login);
+    params.insert("pass", "x");
+    return call(client, "login", params);
+  }
+
+  JsonValue submit(Client& client, const std::string& minerId, const std::string& jobId, const std::string& nonce) {
+    JsonValue params(JsonValue::OBJECT);
+    params.insert("id", minerId);
+    params.insert("job_id", jobId);
+    params.insert("nonce", nonce);
+    return call(client, "submit", params);
+  }
+
+  JsonValue getJob(Client& client, const std::string& minerId) {
+    JsonValue params(JsonValue::OBJECT);
+    params.insert("id", minerId);
+    return call(client, "getjob", params);
+  }
+
+  Logging::LoggerGroup logger;
+  Currency currency;
+  StratumCoreStub core;
+  System::Dispatcher dispatcher;
+  StratumServer server;
+  std::string address;
+};
+
+TEST_F(StratumServerTest, framesLinesAcrossReads) {
+  Client client = connect();
+  write(client, "\r\n{\"id\":1,\"method\":\"keep");
+  System::Timer(dispatcher).sleep(std::chrono::milliseconds(50));
+  write(client, "alived\"}\n  \n{\"id\":2,\"method\":\"keepalived\"}\n");
+
+  JsonValue first = readResponse(client);
+  JsonValue second = readResponse(client);
+  ASSERT_EQ(1, first("id").getInteger());
+  ASSERT_EQ(2, second("id").getInteger());
+  ASSERT_EQ("Unauthenticated", errorOf(first));
+  ASSERT_EQ("Unauthenticated", errorOf(second));
+}
+
+TEST_F(StratumServerTest, dropsConnectionOnLongLine) {
+  Client client = connect();
+  write(client, std::string(17 * 1024, ' '));
+  ASSERT_TRUE(isClosed(client));
+}
+
+TEST_F(StratumServerTest, keepsConnectionOnLongLineBelowLimit) {
+  Client client = connect();
+  write(client, std::string(15 * 1024, ' ') + "{\"id\":1,\"method\":\"keepalived\"}\n");
+  ASSERT_EQ("Unauthenticated", errorOf(readResponse(client)));
+}
+
+TEST_F(StratumServerTest, dropsConnectionOnMalformedRequest) {
+  Client client = connect();
+  write(client, "{\"id\":1,\"method\"\n");
+  ASSERT_TRUE(isClosed(client));
+}
+
+TEST_F(StratumServerTest, loginStripsWorkerNameAndDifficulty) {
+  Client worker = connect();
+  JsonValue response = login(worker, address + ".rig1");
+  ASSERT_EQ("", errorOf(response));
+  ASSERT_EQ("OK", response("result")("status").getString());
+  ASSERT_FALSE(response("result")("id").getString().empty());
+  ASSERT_TRUE(response("result")("job").contains("blob"));
+
+  Client fixedDifficulty = connect();
+  ASSERT_EQ("", errorOf(login(fixedDifficulty, address + "+5000")));
+
+  // both mine to the same address and share the template
+  ASSERT_EQ(1, core.templateCount);
+}
+
+TEST_F(StratumServerTest, loginRejectsInvalidAddress) {
+  Client client = connect();
+  ASSERT_EQ("Invalid address", errorOf(login(client, "K" + address.substr(2))));
+  ASSERT_EQ("Missing login", errorOf(call(client, "login", JsonValue(JsonValue::OBJECT))));
+  ASSERT_EQ(0, core.templateCount);
+}
+
+TEST_F(StratumServerTest, loginTwiceIsRejected) {
+  Client client = connect();
+  ASSERT_EQ("", errorOf(login(client, address)));
+  ASSERT_EQ("Already logged in", errorOf(login(client, address)));
+}
+
+TEST_F(StratumServerTest, requiresLoginForOtherMethods) {
+  Client client = connect();
+  ASSERT_EQ("Unauthenticated", errorOf(getJob(client, "")));
+  ASSERT_EQ("Unauthenticated", errorOf(submit(client, "", "1", "00000000")));
+
+  std::string minerId = login(client, address)("result")("id").getString();
+  ASSERT_EQ("Unauthenticated", errorOf(getJob(client, minerId + "0")));
+  ASSERT_EQ("Unauthenticated", errorOf(call(client, "getjob", JsonValue(JsonValue::OBJECT))));
+
+  ASSERT_EQ("", errorOf(getJob(client, minerId)));
+  JsonValue params(JsonValue::OBJECT);
+  params.insert("id", minerId);
+  ASSERT_EQ("KEEPALIVED", call(client, "keepalived", params)("result")("status").getString());
+  ASSERT_EQ("Unknown method", errorOf(call(client, "mining.subscribe", params)));
+}
+
+TEST_F(StratumServerTest, rejectsDuplicateShare) {
+  Client client = connect();
+  JsonValue result = login(client, address)("result");
+  std::string minerId = result("id").getString();
+  std::string jobId = result("job")("job_id").getString();
+
+  ASSERT_EQ("", errorOf(submit(client, minerId, jobId, "01000000")));
+  ASSERT_EQ("Duplicate share", errorOf(submit(client, minerId, jobId, "01000000")));
+  ASSERT_EQ("", errorOf(submit(client, minerId, jobId, "02000000")));
+  ASSERT_EQ("Invalid nonce", errorOf(submit(client, minerId, jobId, "0200")));
+  ASSERT_TRUE(core.blocks.empty());
+}
+
+TEST_F(StratumServerTest, rejectsShareForExpiredJob) {
+  Client client = connect();
+  JsonValue result = login(client, address)("result");
+  std::string minerId = result("id").getString();
+  std::string firstJobId = result("job")("job_id").getString();
+
+  std::string secondJobId = getJob(client, minerId)("result")("job_id").getString();
+  std::string lastJobId;
+  for (int i = 0; i < 3; ++i) {
+    lastJobId = getJob(client, minerId)("result")("job_id").getString();
+  }
+
+  // only the last four jobs of a miner are kept
+  ASSERT_EQ("Block expired", errorOf(submit(client, minerId, firstJobId, "01000000")));
+  ASSERT_EQ("", errorOf(submit(client, minerId, secondJobId, "01000000")));
+  ASSERT_EQ("", errorOf(submit(client, minerId, lastJobId, "01000000")));
+  ASSERT_EQ("Block expired", errorOf(submit(client, minerId, "unknown", "01000000")));
+}
+
+TEST_F(StratumServerTest, writesExtraNonceIntoReservedSpace) {
+  core.difficulty = 1;
+
+  Client first = connect();
+  Client second = connect();
+  JsonValue firstResult = login(first, address)("result");
+  JsonValue secondResult = login(second, address)("result");
+  ASSERT_NE(firstResult("job")("blob").getString(), secondResult("job")("blob").getString());
+
+  ASSERT_EQ("", errorOf(submit(first, firstResult("id").getString(), firstResult("job")("job_id").getString(), "01000000")));
+  ASSERT_EQ("", errorOf(submit(second, secondResult("id").getString(), secondResult("job")("job_id").getString(), "02000000")));
+  ASSERT_EQ(2, core.blocks.size());
+  ASSERT_EQ(1, core.blocks[0].nonce);
+  ASSERT_EQ(2, core.blocks[1].nonce);
+
+  // the extra nonces fill the reserved bytes of the coinbase, one per miner
+  std::vector<BinaryArray> extraNonces;
+  for (const Block& block : core.blocks) {
+    std::vector<TransactionExtraField> fields;
+    ASSERT_TRUE(parseTransactionExtra(block.baseTransaction.extra, fields));
+    TransactionExtraNonce extraNonce;
+    ASSERT_TRUE(findTransactionExtraFieldByType(fields, extraNonce));
+    ASSERT_EQ(sizeof(uint32_t), extraNonce.nonce.size());
+    ASSERT_EQ(getTransactionPublicKeyFromExtra(block.baseTransaction.extra), getTransactionPublicKeyFromExtra(core.blocks[0].baseTransaction.extra));
+    extraNonces.push_back(extraNonce.nonce);
+  }
+
+  uint32_t firstExtraNonce;
+  uint32_t secondExtraNonce;
+  memcpy(&firstExtraNonce, extraNonces[0].data(), sizeof(firstExtraNonce));
+  memcpy(&secondExtraNonce, extraNonces[1].data(), sizeof(secondExtraNonce));
+  ASSERT_EQ(firstExtraNonce + 1, secondExtraNonce);
+}
@@ -0,0 +1,44 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "P2p/TokenBucket.h"
+
+using namespace CryptoNote;
+
+TEST(TokenBucket, zeroRateIsUnlimited) {
+  TokenBucket bucket;
+  bucket.consume(1000000000);
+  ASSERT_EQ(0, bucket.delay().count());
+}
+
+TEST(TokenBucket, burstOfOneSecondPassesWithoutDelay) {
+  TokenBucket bucket(1000);
+  bucket.consume(1000);
+  ASSERT_EQ(0, bucket.delay().count());
+}
+
+TEST(TokenBucket, debtIsPaidOffAtConfiguredRate) {
+  TokenBucket bucket(1000);
+  bucket.consume(3000);
+
+  // 2000 bytes over the burst at 1000 B/s, give some slack for the time spent here
+  auto delay = bucket.delay().count();
+  ASSERT_GT(delay, 1500);
+  ASSERT_LE(delay, 2000);
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+#include "Common/Tracing.h"
+
+using namespace Common;
+
+TEST(Tracing, recordsOnlyWhileStarted) {
+  Tracer& tracer = Tracer::instance();
+  tracer.start();
+  tracer.stop();
+
+  { TraceSpan span("test", "disabled"); }
+  ASSERT_EQ(0, tracer.eventCount());
+
+  tracer.start();
+  {
+    TraceSpan span("test", "block");
+    span.setId(42);
+  }
+
+  tracer.stop();
+  { TraceSpan span("test", "stopped"); }
+
+  ASSERT_EQ(1, tracer.eventCount());
+  std::ostringstream out;
+  tracer.writeJson(out);
+  ASSERT_NE(std::string::npos, out.str().find("\"name\":\"block\",\"cat\":\"test\",\"ph\":\"X\""));
+  ASSERT_NE(std::string::npos, out.str().find("\"args\":{\"id\":\"42\"}"));
+}
+
+TEST(Tracing, keepsMostRecentSpans) {
+  Tracer& tracer = Tracer::instance();
+  tracer.start(2);
+  for (uint64_t i = 0; i < 5; ++i) {
+    TraceSpan span("test", "span");
+    span.setId(i);
+  }
+
+  tracer.stop();
+  ASSERT_EQ(2, tracer.eventCount());
+  std::ostringstream out;
+  tracer.writeJson(out);
+  std::string text = out.str();
+  ASSERT_EQ(std::string::npos, text.find("\"id\":\"2\""));
+  ASSERT_LT(text.find("\"id\":\"3\""), text.find("\"id\":\"4\""));
+}
@@ -15,6 +15,8 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <sstream>
+
 #include "gtest/gtest.h"
 
 #include "IWalletLegacy.h"
@@ -795,6 +797,31 @@ TEST_F(TransfersContainer_detach, threeRelatedTransactions) {
   ASSERT_EQ(TEST_OUTPUT_AMOUNT, container.balance(ITransfersContainer::IncludeAll));
 }
 
+TEST_F(TransfersContainer_detach, detachLocksTransfersUnlockedByHeightAgain) {
+  const uint64_t unlockHeight = TEST_BLOCK_HEIGHT + 10;
+  const uint32_t firstUnlockedHeight = static_cast<uint32_t>(unlockHeight - currency.lockedTxAllowedDeltaBlocks());
+
+  TestTransactionBuilder builder;
+  builder.setUnlockTime(unlockHeight);
+  builder.addTestInput(TEST_OUTPUT_AMOUNT + 1, account);
+  auto outInfo = builder.addTestKeyOutput(TEST_OUTPUT_AMOUNT, TEST_TRANSACTION_OUTPUT_GLOBAL_INDEX, account);
+  auto tx = builder.build();
+  ASSERT_TRUE(container.addTransaction(blockInfo(TEST_BLOCK_HEIGHT), *tx, { outInfo }));
+
+  container.advanceHeight(firstUnlockedHeight - 1);
+  ASSERT_EQ(TEST_OUTPUT_AMOUNT, container.balance(ITransfersContainer::IncludeAllLocked));
+  ASSERT_EQ(0, container.balance(ITransfersContainer::IncludeAllUnlocked));
+
+  container.advanceHeight(firstUnlockedHeight);
+  ASSERT_EQ(0, container.balance(ITransfersContainer::IncludeAllLocked));
+  ASSERT_EQ(TEST_OUTPUT_AMOUNT, container.balance(ITransfersContainer::IncludeAllUnlocked));
+
+  container.detach(firstUnlockedHeight);
+  ASSERT_EQ(1, container.transfersCount());
+  ASSERT_EQ(TEST_OUTPUT_AMOUNT, container.balance(ITransfersContainer::IncludeAllLocked));
+  ASSERT_EQ(0, container.balance(ITransfersContainer::IncludeAllUnlocked));
+}
+
 TEST_F(TransfersContainer_detach, detachConfirmedTransactionWithUnrelatedUnconfirmed) {
   auto tx1 = addTransaction(TEST_BLOCK_HEIGHT);
   auto tx2 = addTransaction(WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
@@ -1131,3 +1158,88 @@ TEST_F(TransfersContainer_getOutputs, filtersByStateAndKeySimultaneously) {
   ASSERT_EQ(AMOUNT_1 + AMOUNT_2, transfers.front().amount);
 }
 
+
+TEST_F(TransfersContainer_getOutputs, largestOutputsCoverAmountWithSpareOutputs) {
+  addTransaction(TEST_BLOCK_HEIGHT, AMOUNT_1);
+  addTransaction(TEST_BLOCK_HEIGHT, AMOUNT_2);
+  addTransaction(TEST_BLOCK_HEIGHT, AMOUNT_1 + AMOUNT_2);
+  addTransaction(WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT, 2 * (AMOUNT_1 + AMOUNT_2));
+  container.advanceHeight(TEST_CONTAINER_CURRENT_HEIGHT);
+
+  std::vector<TransactionOutputInformation> transfers;
+  container.getLargestOutputs(transfers, ITransfersContainer::IncludeKeyUnlocked, AMOUNT_1, 0);
+  ASSERT_EQ(1, transfers.size());
+  ASSERT_EQ(AMOUNT_1 + AMOUNT_2, transfers[0].amount);
+
+  transfers.clear();
+  container.getLargestOutputs(transfers, ITransfersContainer::IncludeKeyUnlocked, AMOUNT_1, 2);
+  ASSERT_EQ(2, transfers.size());
+  ASSERT_EQ(AMOUNT_2, transfers[1].amount);
+
+  transfers.clear();
+  container.getLargestOutputs(transfers, ITransfersContainer::IncludeKeyUnlocked, 10 * AMOUNT_2, 0);
+  ASSERT_EQ(3, transfers.size());
+  ASSERT_EQ(AMOUNT_1, transfers[2].amount);
+}
+
+//--------------------------------------------------------------------------- 
+// TransfersContainer_save
+//--------------------------------------------------------------------------- 
+class TransfersContainer_save : public TransfersContainerTest {
+public:
+  TransfersContainer_save() : loaded(currency, logger, TEST_TRANSACTION_SPENDABLE_AGE) {
+  }
+
+  void saveAndLoad() {
+    std::stringstream stream;
+    container.save(stream);
+    loaded.load(stream);
+  }
+
+  TransfersContainer loaded;
+};
+
+TEST_F(TransfersContainer_save, restoresTransfersAndTheirTransactions) {
+  auto tx1 = addTransaction(TEST_BLOCK_HEIGHT);
+  auto tx2 = addSpendingTransaction(tx1->getTransactionHash(), TEST_BLOCK_HEIGHT + 1, TEST_TRANSACTION_OUTPUT_GLOBAL_INDEX + 1, TEST_OUTPUT_AMOUNT / 2);
+  auto tx3 = addTransaction(WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
+  container.advanceHeight(TEST_CONTAINER_CURRENT_HEIGHT);
+
+  saveAndLoad();
+
+  ASSERT_EQ(container.transactionsCount(), loaded.transactionsCount());
+  ASSERT_EQ(container.transfersCount(), loaded.transfersCount());
+  ASSERT_EQ(container.balance(ITransfersContainer::IncludeAll), loaded.balance(ITransfersContainer::IncludeAll));
+  ASSERT_EQ(TEST_OUTPUT_AMOUNT / 2, loaded.balance(ITransfersContainer::IncludeAllUnlocked));
+  ASSERT_EQ(TEST_OUTPUT_AMOUNT, loaded.balance(ITransfersContainer::IncludeAllLocked));
+
+  auto outputs = loaded.getTransactionOutputs(tx2->getTransactionHash(), ITransfersContainer::IncludeAll);
+  ASSERT_EQ(1, outputs.size());
+  ASSERT_EQ(tx2->getTransactionHash(), outputs[0].transactionHash);
+  ASSERT_EQ(tx2->getTransactionPublicKey(), outputs[0].transactionPublicKey);
+
+  auto spentOutputs = loaded.getSpentOutputs();
+  ASSERT_EQ(1, spentOutputs.size());
+  ASSERT_EQ(tx1->getTransactionHash(), spentOutputs[0].transactionHash);
+  ASSERT_EQ(tx2->getTransactionHash(), spentOutputs[0].spendingTransactionHash);
+  ASSERT_EQ(TEST_BLOCK_HEIGHT + 1, spentOutputs[0].spendingBlockHeight);
+
+  std::vector<Crypto::Hash> unconfirmed;
+  loaded.getUnconfirmedTransactions(unconfirmed);
+  ASSERT_EQ(1, unconfirmed.size());
+  ASSERT_EQ(tx3->getTransactionHash(), unconfirmed[0]);
+}
+
+TEST_F(TransfersContainer_save, loadedTransfersFollowConfirmation) {
+  auto tx = addTransaction(WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
+
+  saveAndLoad();
+
+  ASSERT_TRUE(loaded.markTransactionConfirmed(blockInfo(TEST_BLOCK_HEIGHT), tx->getTransactionHash(), { TEST_TRANSACTION_OUTPUT_GLOBAL_INDEX }));
+  loaded.advanceHeight(TEST_CONTAINER_CURRENT_HEIGHT);
+
+  ASSERT_EQ(TEST_OUTPUT_AMOUNT, loaded.balance(ITransfersContainer::IncludeAllUnlocked));
+  TransactionInformation info;
+  ASSERT_TRUE(loaded.getTransactionInformation(tx->getTransactionHash(), info));
+  ASSERT_EQ(TEST_BLOCK_HEIGHT, info.blockHeight);
+}
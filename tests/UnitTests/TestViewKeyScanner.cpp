@@ -0,0 +1,134 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gtest/gtest.h"
+
+#include "crypto/crypto.h"
+#include "CryptoNoteConfig.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/TransactionExtra.h"
+#include "CryptoNoteCore/ViewKeyScanner.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+struct Keys {
+  Crypto::PublicKey viewPublicKey;
+  Crypto::SecretKey viewSecretKey;
+  Crypto::PublicKey spendPublicKey;
+  Crypto::SecretKey spendSecretKey;
+
+  Keys() {
+    Crypto::generate_keys(viewPublicKey, viewSecretKey);
+    Crypto::generate_keys(spendPublicKey, spendSecretKey);
+  }
+};
+
+typedef std::pair<Transaction, std::vector<uint32_t>> IndexedTransaction;
+
+// a transaction paying every receiver in turn, output i gets the global index firstIndex + i
+IndexedTransaction makeTransaction(const std::vector<const Keys*>& receivers, uint64_t amount, uint32_t firstIndex) {
+  IndexedTransaction result;
+  Transaction& tx = result.first;
+  tx.version = CURRENT_TRANSACTION_VERSION;
+  tx.unlockTime = 0;
+
+  Crypto::PublicKey txPublicKey;
+  Crypto::SecretKey txSecretKey;
+  Crypto::generate_keys(txPublicKey, txSecretKey);
+  addTransactionPublicKeyToExtra(tx.extra, txPublicKey);
+
+  for (size_t i = 0; i < receivers.size(); ++i) {
+    Crypto::KeyDerivation derivation;
+    Crypto::generate_key_derivation(receivers[i]->viewPublicKey, txSecretKey, derivation);
+
+    KeyOutput target;
+    Crypto::derive_public_key(derivation, i, receivers[i]->spendPublicKey, target.key);
+
+    TransactionOutput output;
+    output.amount = amount;
+    output.target = target;
+    tx.outputs.push_back(output);
+    result.second.push_back(firstIndex + static_cast<uint32_t>(i));
+  }
+
+  return result;
+}
+
+void addRing(IndexedTransaction& tx, uint64_t amount, const std::vector<uint32_t>& absoluteIndexes) {
+  KeyInput input = {};
+  input.amount = amount;
+  input.outputIndexes = absolute_output_offsets_to_relative(absoluteIndexes);
+  tx.first.inputs.push_back(input);
+}
+
+class ViewKeyScannerTest : public ::testing::Test {
+protected:
+  ViewKeyScanner scanner() {
+    return ViewKeyScanner(alice.viewSecretKey, { alice.spendPublicKey });
+  }
+
+  Keys alice;
+  Keys bob;
+};
+
+TEST_F(ViewKeyScannerTest, findsOutputsSentToAccount) {
+  std::vector<IndexedTransaction> txs;
+  txs.push_back(makeTransaction({ &bob }, 100, 0));
+  txs.push_back(makeTransaction({ &bob, &alice, &bob }, 100, 10));
+
+  ViewKeyScanner s = scanner();
+  auto matches = s.scan(txs);
+
+  ASSERT_EQ(std::vector<bool>({ false, true }), matches);
+  ASSERT_EQ(1, s.foundOutputs().size());
+  ASSERT_EQ(ViewKeyScanner::OutputReference(100, 11), s.foundOutputs()[0]);
+}
+
+TEST_F(ViewKeyScannerTest, findsSpendsOfWatchedOutputs) {
+  std::vector<IndexedTransaction> txs;
+  txs.push_back(makeTransaction({ &bob }, 100, 0));
+  addRing(txs.back(), 100, { 3, 7, 42 });
+  txs.push_back(makeTransaction({ &bob }, 100, 1));
+  addRing(txs.back(), 200, { 5, 42 });
+
+  ViewKeyScanner s = scanner();
+  s.watch(ViewKeyScanner::OutputReference(100, 7));
+  auto matches = s.scan(txs);
+
+  ASSERT_EQ(std::vector<bool>({ true, false }), matches);
+  ASSERT_TRUE(s.foundOutputs().empty());
+}
+
+TEST_F(ViewKeyScannerTest, findsSpendsOfOutputsFoundInSameBatch) {
+  std::vector<IndexedTransaction> txs;
+  txs.push_back(makeTransaction({ &alice }, 100, 20));
+  txs.push_back(makeTransaction({ &bob }, 100, 21));
+  addRing(txs.back(), 100, { 2, 20 });
+
+  ViewKeyScanner s = scanner();
+  ASSERT_EQ(std::vector<bool>({ true, true }), s.scan(txs));
+
+  std::vector<IndexedTransaction> later;
+  later.push_back(makeTransaction({ &bob }, 100, 30));
+  addRing(later.back(), 100, { 20, 25 });
+  ASSERT_EQ(std::vector<bool>({ true }), s.scan(later));
+}
+
+}
@@ -2152,6 +2152,21 @@ TEST_F(WalletApi, walletGetsSyncProgressUpdatedEvent) {
   ASSERT_TRUE(waitForWalletEvent(alice, CryptoNote::SYNC_PROGRESS_UPDATED, std::chrono::seconds(5)));
 }
 
+TEST_F(WalletApi, walletKeepsOneQueuedSyncProgressUpdatedEvent) {
+  generator.generateEmptyBlocks(10);
+  node.updateObservers();
+  ASSERT_TRUE(waitForWalletEvent(alice, CryptoNote::SYNC_COMPLETED, std::chrono::seconds(5)));
+
+  generator.generateEmptyBlocks(10);
+  node.updateObservers();
+  wait(500);
+
+  auto events = alice.getEvents(1000);
+  ASSERT_EQ(1, std::count_if(events.begin(), events.end(), [] (const CryptoNote::WalletEvent& event) {
+    return event.type == CryptoNote::SYNC_PROGRESS_UPDATED;
+  }));
+}
+
 struct CatchTransactionNodeStub : public INodeTrivialRefreshStub {
   CatchTransactionNodeStub(TestBlockchainGenerator& generator): INodeTrivialRefreshStub(generator), caught(false) {}
 
@@ -2203,6 +2218,20 @@ TEST_F(WalletApi, createFusionTransactionDoesnotAffectTotalBalance) {
   ASSERT_EQ(totalBalance, alice.getActualBalance() + alice.getPendingBalance());
 }
 
+TEST_F(WalletApi, createFusionTransactionsCreatesNoMoreThanRequested) {
+  generateFusionOutputsAndUnlock(alice, node, currency, FUSION_THRESHOLD);
+
+  auto totalBalance = alice.getActualBalance() + alice.getPendingBalance();
+  auto ids = alice.createFusionTransactions(FUSION_THRESHOLD, 2, 1);
+  ASSERT_EQ(1, ids.size());
+  ASSERT_TRUE(alice.isFusionTransaction(ids.front()));
+  ASSERT_EQ(totalBalance, alice.getActualBalance() + alice.getPendingBalance());
+}
+
+TEST_F(WalletApi, createFusionTransactionsReturnsEmptyIfNoTransfers) {
+  ASSERT_TRUE(alice.createFusionTransactions(FUSION_THRESHOLD, 0, 3).empty());
+}
+
 TEST_F(WalletApi, createFusionTransactionFailsIfMixinToobig) {
   generateFusionOutputsAndUnlock(alice, node, currency, FUSION_THRESHOLD);
   ASSERT_ANY_THROW(alice.createFusionTransaction(FUSION_THRESHOLD, 10000000));
@@ -0,0 +1,196 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+
+#include "crypto/crypto.h"
+#include "crypto/random.h"
+#include "Wallet/WalletCacheChunks.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const std::string TEST_FILE_NAME = "WalletCacheChunksTest.dat";
+const uint64_t TEST_PREFIX_SIZE = sizeof(Crypto::chacha8_iv);
+
+class WalletCacheChunksTest : public ::testing::Test {
+protected:
+  virtual void SetUp() override {
+    boost::filesystem::remove(TEST_FILE_NAME);
+    storage.open(TEST_FILE_NAME, Common::FileMappedVectorOpenMode::CREATE, TEST_PREFIX_SIZE);
+    *reinterpret_cast<Crypto::chacha8_iv*>(storage.prefix()) = Crypto::randomChachaIV();
+    Random::randomBytes(sizeof(key), reinterpret_cast<uint8_t*>(&key));
+  }
+
+  virtual void TearDown() override {
+    storage.close();
+    boost::filesystem::remove(TEST_FILE_NAME);
+  }
+
+  WalletCacheChunks::IvGenerator ivGenerator() {
+    return [this] {
+      auto* iv = reinterpret_cast<Crypto::chacha8_iv*>(storage.prefix());
+      Crypto::chacha8_iv result = *iv;
+      ++*reinterpret_cast<uint64_t*>(iv);
+      return result;
+    };
+  }
+
+  static std::string randomData(size_t size) {
+    std::string data(size, '\0');
+    Random::randomBytes(size, reinterpret_cast<uint8_t*>(&data[0]));
+    return data;
+  }
+
+  std::string load() {
+    WalletCacheChunks chunks;
+    BinaryArray data;
+    chunks.load(storage, key, data);
+    return std::string(data.begin(), data.end());
+  }
+
+  ContainerStorage storage;
+  Crypto::chacha8_key key;
+};
+
+TEST_F(WalletCacheChunksTest, savedDataIsLoaded) {
+  std::string data = randomData(300 * 1024);
+
+  WalletCacheChunks chunks;
+  chunks.save(storage, key, data.data(), data.size(), ivGenerator());
+
+  ASSERT_EQ(data, load());
+}
+
+TEST_F(WalletCacheChunksTest, savedDataIsStreamed) {
+  std::string data = randomData(300 * 1024);
+
+  WalletCacheChunks chunks;
+  chunks.save(storage, key, data.data(), data.size(), ivGenerator());
+
+  std::string streamed;
+  WalletCacheChunks loaded;
+  loaded.load(storage, key, [&streamed](Common::IInputStream& stream) {
+    char buffer[1000];
+    while (size_t size = stream.readSome(buffer, sizeof(buffer))) {
+      streamed.append(buffer, size);
+    }
+  });
+
+  ASSERT_EQ(data, streamed);
+}
+
+TEST_F(WalletCacheChunksTest, unchangedChunksAreNotWrittenAgain) {
+  std::string data = randomData(1024 * 1024);
+
+  WalletCacheChunks chunks;
+  chunks.save(storage, key, data.data(), data.size(), ivGenerator());
+  uint64_t suffixSize = storage.suffixSize();
+
+  data[data.size() / 2] ^= 1;
+  data += randomData(10);
+  chunks.save(storage, key, data.data(), data.size(), ivGenerator());
+
+  ASSERT_EQ(suffixSize, storage.suffixSize());
+  ASSERT_EQ(data, load());
+}
+
+TEST_F(WalletCacheChunksTest, repeatedSavesReuseSpace) {
+  std::string data = randomData(256 * 1024);
+
+  WalletCacheChunks chunks;
+  uint64_t suffixSize = 0;
+  for (size_t i = 0; i < 20; ++i) {
+    data = randomData(256 * 1024);
+    chunks.save(storage, key, data.data(), data.size(), ivGenerator());
+    if (i == 5) {
+      suffixSize = storage.suffixSize();
+    }
+  }
+
+  ASSERT_EQ(suffixSize, storage.suffixSize());
+  ASSERT_GT(5 * data.size(), storage.suffixSize());
+  ASSERT_EQ(data, load());
+}
+
+TEST_F(WalletCacheChunksTest, rewrittenCacheStaysBounded) {
+  WalletCacheChunks chunks;
+  std::string data;
+  for (size_t i = 0; i < 60; ++i) {
+    // nothing is reused, so every save that doesn't fit past the stored chunks rewrites the whole cache;
+    // the cache grows to 384 KiB and then drops to 64 KiB
+    data = randomData(i < 40 ? 64 * 1024 + i * 8 * 1024 : 64 * 1024);
+    chunks.save(storage, key, data.data(), data.size(), ivGenerator());
+    if (i < 40) {
+      ASSERT_GE(8 * data.size(), storage.suffixSize()) << "save " << i;
+    } else if (i > 42) {
+      ASSERT_GE(5 * data.size(), storage.suffixSize()) << "save " << i;
+    }
+  }
+
+  ASSERT_EQ(data, load());
+}
+
+TEST_F(WalletCacheChunksTest, loadedLayoutIsContinued) {
+  std::string data = randomData(200 * 1024);
+
+  WalletCacheChunks chunks;
+  chunks.write(storage, key, data.data(), data.size(), ivGenerator());
+
+  data[10] ^= 1;
+  WalletCacheChunks loaded;
+  BinaryArray stored;
+  loaded.load(storage, key, stored);
+  loaded.save(storage, key, data.data(), data.size(), ivGenerator());
+
+  ASSERT_EQ(data, load());
+}
+
+TEST_F(WalletCacheChunksTest, interruptedSaveKeepsPreviousCache) {
+  std::string data = randomData(100 * 1024);
+
+  WalletCacheChunks chunks;
+  chunks.save(storage, key, data.data(), data.size(), ivGenerator());
+  std::string saved = data;
+  data[0] ^= 1;
+  chunks.save(storage, key, data.data(), data.size(), ivGenerator());
+
+  // damage the slot of the last commit
+  storage.suffix()[512] ^= 1;
+
+  ASSERT_EQ(saved, load());
+}
+
+TEST_F(WalletCacheChunksTest, corruptedCacheIsRejected) {
+  std::string data = randomData(10 * 1024);
+
+  WalletCacheChunks chunks;
+  chunks.save(storage, key, data.data(), data.size(), ivGenerator());
+  // a byte of the only stored chunk
+  storage.suffix()[1024 + 100] ^= 1;
+
+  WalletCacheChunks loaded;
+  BinaryArray stored;
+  ASSERT_ANY_THROW(loaded.load(storage, key, stored));
+}
+
+}
@@ -0,0 +1,124 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+
+#include "gtest/gtest.h"
+
+#include "Wallet/WalletDecoyCache.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const size_t TEST_BATCH_SIZE = 8;
+const size_t TEST_AMOUNT_COUNT = 2;
+
+WalletDecoyCache::OutsForAmount makeBatch(uint64_t amount, size_t size, uint32_t firstIndex = 0) {
+  WalletDecoyCache::OutsForAmount batch;
+  batch.amount = amount;
+  for (uint32_t i = 0; i < size; ++i) {
+    COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::out_entry entry;
+    entry.global_amount_index = firstIndex + i;
+    entry.out_key = Crypto::PublicKey();
+    batch.outs.push_back(entry);
+  }
+
+  return batch;
+}
+
+void addBatch(WalletDecoyCache& cache, uint64_t amount, uint32_t firstIndex = 0) {
+  std::vector<WalletDecoyCache::OutsForAmount> batches;
+  batches.push_back(makeBatch(amount, TEST_BATCH_SIZE, firstIndex));
+  cache.add(std::move(batches), cache.generation());
+}
+
+TEST(WalletDecoyCache, unknownAmountIsRememberedForRefill) {
+  WalletDecoyCache cache(TEST_BATCH_SIZE, TEST_AMOUNT_COUNT);
+  WalletDecoyCache::OutsForAmount outs;
+
+  ASSERT_FALSE(cache.take(100, 3, outs));
+  ASSERT_EQ(std::vector<uint64_t>{100}, cache.amountsToRefill(3));
+}
+
+TEST(WalletDecoyCache, outputsAreHandedOutOnce) {
+  WalletDecoyCache cache(TEST_BATCH_SIZE, TEST_AMOUNT_COUNT);
+  WalletDecoyCache::OutsForAmount outs;
+  cache.take(100, 3, outs);
+  addBatch(cache, 100);
+
+  WalletDecoyCache::OutsForAmount first;
+  WalletDecoyCache::OutsForAmount second;
+  ASSERT_TRUE(cache.take(100, 3, first));
+  ASSERT_TRUE(cache.take(100, 3, second));
+  ASSERT_EQ(100, first.amount);
+  ASSERT_EQ(3, first.outs.size());
+  ASSERT_EQ(3, second.outs.size());
+  for (const auto& out : first.outs) {
+    for (const auto& other : second.outs) {
+      ASSERT_NE(out.global_amount_index, other.global_amount_index);
+    }
+  }
+
+  // only 2 outputs of the batch are left, a ring is never mixed from two batches
+  ASSERT_FALSE(cache.take(100, 3, outs));
+}
+
+TEST(WalletDecoyCache, shortAndUnrequestedBatchesAreIgnored) {
+  WalletDecoyCache cache(TEST_BATCH_SIZE, TEST_AMOUNT_COUNT);
+  WalletDecoyCache::OutsForAmount outs;
+  cache.take(100, 3, outs);
+
+  std::vector<WalletDecoyCache::OutsForAmount> batches;
+  batches.push_back(makeBatch(100, TEST_BATCH_SIZE - 1));
+  batches.push_back(makeBatch(200, TEST_BATCH_SIZE));
+  cache.add(std::move(batches), cache.generation());
+
+  ASSERT_FALSE(cache.take(100, 3, outs));
+  ASSERT_FALSE(cache.take(200, 3, outs));
+}
+
+TEST(WalletDecoyCache, clearDropsOutputsAndPendingBatches) {
+  WalletDecoyCache cache(TEST_BATCH_SIZE, TEST_AMOUNT_COUNT);
+  WalletDecoyCache::OutsForAmount outs;
+  cache.take(100, 3, outs);
+  addBatch(cache, 100);
+
+  uint64_t generation = cache.generation();
+  cache.clear();
+
+  ASSERT_FALSE(cache.take(100, 3, outs));
+  std::vector<WalletDecoyCache::OutsForAmount> batches;
+  batches.push_back(makeBatch(100, TEST_BATCH_SIZE));
+  cache.add(std::move(batches), generation);
+  ASSERT_FALSE(cache.take(100, 3, outs));
+}
+
+TEST(WalletDecoyCache, leastRecentlyUsedAmountIsEvicted) {
+  WalletDecoyCache cache(TEST_BATCH_SIZE, TEST_AMOUNT_COUNT);
+  WalletDecoyCache::OutsForAmount outs;
+  cache.take(100, 3, outs);
+  cache.take(200, 3, outs);
+  cache.take(100, 3, outs);
+  cache.take(300, 3, outs);
+
+  auto amounts = cache.amountsToRefill(3);
+  std::sort(amounts.begin(), amounts.end());
+  ASSERT_EQ((std::vector<uint64_t>{100, 300}), amounts);
+}
+
+}
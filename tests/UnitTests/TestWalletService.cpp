@@ -88,6 +88,10 @@ struct IWalletBaseStub : public CryptoNote::IWallet, public CryptoNote::IFusionM
   virtual WalletTransactionWithTransfers getTransaction(const Crypto::Hash& transactionHash) const override { return WalletTransactionWithTransfers(); }
   virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t count) const override { return {}; }
   virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count) const override { return {}; }
+  virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t count,
+    const std::vector<std::string>& addresses, const Crypto::Hash* paymentId) const override { return {}; }
+  virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count,
+    const std::vector<std::string>& addresses, const Crypto::Hash* paymentId) const override { return {}; }
   virtual std::vector<Crypto::Hash> getBlockHashes(uint32_t blockIndex, size_t count) const override { return {}; }
   virtual uint32_t getBlockCount() const override { return 0; }
   virtual std::vector<WalletTransactionWithTransfers> getUnconfirmedTransactions() const override { return {}; }
@@ -97,6 +101,7 @@ struct IWalletBaseStub : public CryptoNote::IWallet, public CryptoNote::IFusionM
 
   virtual size_t makeTransaction(const TransactionParameters& sendingTransaction) override { return 0; }
   virtual void commitTransaction(size_t transactionId) override { }
+  virtual std::vector<std::error_code> commitTransactions(const std::vector<size_t>& transactionIds) override { return std::vector<std::error_code>(transactionIds.size()); }
   virtual void rollbackUncommitedTransaction(size_t transactionId) override { }
 
   virtual void start() override { m_stopped = false; }
@@ -118,6 +123,17 @@ struct IWalletBaseStub : public CryptoNote::IWallet, public CryptoNote::IFusionM
     return event;
   }
 
+  virtual std::vector<WalletEvent> getEvents(size_t maxCount) override {
+    std::vector<WalletEvent> events;
+    events.push_back(getEvent());
+    while (events.size() < maxCount && !m_events.empty()) {
+      events.push_back(std::move(m_events.front()));
+      m_events.pop();
+    }
+
+    return events;
+  }
+
   void pushEvent(const WalletEvent& event) {
     m_events.push(event);
     m_eventOccurred.set();
@@ -129,6 +145,11 @@ struct IWalletBaseStub : public CryptoNote::IWallet, public CryptoNote::IFusionM
     throw std::runtime_error("Not implemented");
   }
 
+  virtual std::vector<size_t> createFusionTransactions(uint64_t threshold, uint64_t mixin, size_t maxTransactionCount,
+    const std::vector<std::string>& sourceAddresses = {}, const std::string& destinationAddress = "") override {
+    throw std::runtime_error("Not implemented");
+  }
+
   virtual bool isFusionTransaction(size_t transactionId) const override {
     throw std::runtime_error("Not implemented");
   }
@@ -552,9 +573,38 @@ public:
     return transactions;
   }
 
+  virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t count,
+    const std::vector<std::string>& addresses, const Crypto::Hash* paymentId) const override {
+    return getTransactions(0, count, addresses, paymentId);
+  }
+
+  // doesn't filter, the service has to filter again
+  virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count,
+    const std::vector<std::string>& addresses, const Crypto::Hash* paymentId) const override {
+    requestedAddresses = addresses;
+    requestedPaymentId = paymentId != nullptr ? Common::podToHex(*paymentId) : "";
+    return transactions;
+  }
+
   std::vector<TransactionsInBlockInfo> transactions;
+  mutable std::vector<std::string> requestedAddresses;
+  mutable std::string requestedPaymentId;
 };
 
+TEST_F(WalletServiceTest_getTransactions, filterIsPassedToWallet) {
+  WalletGetTransactionsStub wallet(dispatcher);
+  wallet.transactions = testTransactions;
+
+  auto service = createWalletService(wallet);
+
+  std::vector<TransactionsInBlockRpcInfo> transactions;
+  auto ec = service->getTransactions({RANDOM_ADDRESS1}, 0, 1, PAYMENT_ID, transactions);
+
+  ASSERT_FALSE(ec);
+  ASSERT_EQ(std::vector<std::string>{RANDOM_ADDRESS1}, wallet.requestedAddresses);
+  ASSERT_EQ(PAYMENT_ID, wallet.requestedPaymentId);
+}
+
 TEST_F(WalletServiceTest_getTransactions, addressesFilter_emptyReturnsTransaction) {
   WalletGetTransactionsStub wallet(dispatcher);
   wallet.transactions = testTransactions;
@@ -0,0 +1,134 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gtest/gtest.h"
+
+#include "crypto/crypto.h"
+#include "crypto/random.h"
+#include "CryptoNoteCore/TransactionExtra.h"
+#include "WalletLegacy/WalletUserTransactionsCache.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+WalletUserTransactionsCache::TransactionChange updated(const Crypto::Hash& hash, uint32_t height, int64_t balance) {
+  WalletUserTransactionsCache::TransactionChange change;
+  change.deleted = false;
+  change.txInfo = TransactionInformation();
+  change.txInfo.transactionHash = hash;
+  change.txInfo.blockHeight = height;
+  change.txInfo.totalAmountIn = 100;
+  change.txInfo.totalAmountOut = 90;
+  change.txBalance = balance;
+  return change;
+}
+
+WalletUserTransactionsCache::TransactionChange deleted(const Crypto::Hash& hash) {
+  WalletUserTransactionsCache::TransactionChange change;
+  change.deleted = true;
+  change.txInfo = TransactionInformation();
+  change.txInfo.transactionHash = hash;
+  change.txBalance = 0;
+  return change;
+}
+
+Crypto::Hash randomHash() {
+  Crypto::Hash hash;
+  Random::randomBytes(sizeof(hash), reinterpret_cast<uint8_t*>(&hash));
+  return hash;
+}
+
+}
+
+TEST(WalletUserTransactionsCache, changesAreAppliedInOrder) {
+  WalletUserTransactionsCache cache;
+  std::vector<Crypto::Hash> hashes;
+  std::vector<WalletUserTransactionsCache::TransactionChange> changes;
+  for (uint32_t i = 0; i < 100; ++i) {
+    hashes.push_back(randomHash());
+    changes.push_back(updated(hashes.back(), WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT, i));
+  }
+
+  // the first one gets into a block, then the second one leaves the pool
+  changes.push_back(updated(hashes[0], 10, 0));
+  changes.push_back(deleted(hashes[1]));
+
+  std::deque<std::shared_ptr<WalletLegacyEvent>> events;
+  cache.onTransactionsChanged(changes, events);
+
+  ASSERT_EQ(changes.size(), events.size());
+  ASSERT_EQ(hashes.size(), cache.getTransactionCount());
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    ASSERT_EQ(i, cache.findTransactionByHash(hashes[i]));
+    ASSERT_EQ(static_cast<int64_t>(i), cache.getTransaction(i).totalAmount);
+  }
+
+  ASSERT_EQ(10, cache.getTransaction(0).blockHeight);
+  ASSERT_EQ(WalletLegacyTransactionState::Deleted, cache.getTransaction(1).state);
+  ASSERT_EQ(WalletLegacyTransactionState::Active, cache.getTransaction(2).state);
+}
+
+TEST(WalletUserTransactionsCache, resetForgetsTransactionHashes) {
+  WalletUserTransactionsCache cache;
+  Crypto::Hash hash = randomHash();
+  std::deque<std::shared_ptr<WalletLegacyEvent>> events;
+  cache.onTransactionsChanged({ updated(hash, 5, 1) }, events);
+  ASSERT_EQ(0, cache.findTransactionByHash(hash));
+
+  cache.reset();
+  ASSERT_EQ(WALLET_LEGACY_INVALID_TRANSACTION_ID, cache.findTransactionByHash(hash));
+}
+
+TEST(WalletUserTransactionsCache, paymentsIndexFollowsTransactions) {
+  WalletUserTransactionsCache cache;
+  Crypto::Hash paymentId = randomHash();
+  BinaryArray extraNonce;
+  setPaymentIdToTransactionExtraNonce(extraNonce, paymentId);
+
+  std::vector<Crypto::Hash> hashes;
+  std::vector<WalletUserTransactionsCache::TransactionChange> changes;
+  for (uint32_t i = 0; i < 3; ++i) {
+    hashes.push_back(randomHash());
+    changes.push_back(updated(hashes.back(), WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT, 10));
+    addExtraNonceToTransactionExtra(changes.back().txInfo.extra, extraNonce);
+  }
+
+  std::deque<std::shared_ptr<WalletLegacyEvent>> events;
+  cache.onTransactionsChanged(changes, events);
+  ASSERT_TRUE(cache.getTransactionsByPaymentIds({ paymentId })[0].transactions.empty());
+
+  // indexed when they get into a block, once however often they're updated
+  changes[0].txInfo.blockHeight = 5;
+  changes[2].txInfo.blockHeight = 6;
+  cache.onTransactionsChanged({ changes[2], changes[0], changes[0] }, events);
+  std::vector<Payments> payments = cache.getTransactionsByPaymentIds({ paymentId, randomHash() });
+  ASSERT_EQ(2, payments.size());
+  ASSERT_EQ(2, payments[0].transactions.size());
+  ASSERT_EQ(hashes[0], payments[0].transactions[0].hash);
+  ASSERT_EQ(hashes[2], payments[0].transactions[1].hash);
+  ASSERT_TRUE(payments[1].transactions.empty());
+
+  cache.onTransactionsChanged({ deleted(hashes[0]) }, events);
+  payments = cache.getTransactionsByPaymentIds({ paymentId });
+  ASSERT_EQ(1, payments[0].transactions.size());
+  ASSERT_EQ(hashes[2], payments[0].transactions[0].hash);
+
+  cache.reset();
+  ASSERT_TRUE(cache.getTransactionsByPaymentIds({ paymentId })[0].transactions.empty());
+}
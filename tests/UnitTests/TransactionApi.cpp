@@ -249,6 +249,61 @@ TEST_F(TransactionApi, prefixHash) {
   ASSERT_EQ(hash, reloadedTx(tx)->getTransactionPrefixHash());
 }
 
+TEST_F(TransactionApi, prefixHashOfSignedTransactionIsTakenFromBlob) {
+  TransactionTypes::InputKeyInfo info = createInputInfo(1000);
+  KeyPair ephKeys;
+  size_t index = tx->addInput(sender, info, ephKeys);
+  tx->addOutput(500, sender.address);
+  tx->signInputKey(index, info, ephKeys);
+
+  auto txBlob = tx->getTransactionData();
+  Transaction transaction;
+  Crypto::Hash transactionHash;
+  Crypto::Hash transactionPrefixHash;
+  ASSERT_TRUE(parseAndValidateTransactionFromBinaryArray(txBlob, transaction, transactionHash, transactionPrefixHash));
+
+  TransactionPrefix& prefix = transaction;
+  ASSERT_EQ(toBinaryArray(prefix).size(), getTransactionPrefixSize(transaction, txBlob.size()));
+  ASSERT_EQ(getObjectHash(prefix), transactionPrefixHash);
+  ASSERT_EQ(tx->getTransactionPrefixHash(), transactionPrefixHash);
+  ASSERT_EQ(transactionPrefixHash, reloadedTx(tx)->getTransactionPrefixHash());
+}
+
+TEST_F(TransactionApi, signingKeepsPrefixAndInputsHashes) {
+  TransactionTypes::InputKeyInfo info = createInputInfo(1000);
+  KeyPair ephKeys;
+  size_t index = tx->addInput(sender, info, ephKeys);
+  tx->addOutput(500, sender.address);
+
+  auto prefixHash = tx->getTransactionPrefixHash();
+  auto inputsHash = tx->getTransactionInputsHash();
+  txHash = tx->getTransactionHash();
+  tx->signInputKey(index, info, ephKeys);
+
+  EXPECT_NO_FATAL_FAILURE(checkHashChanged());
+  ASSERT_EQ(prefixHash, tx->getTransactionPrefixHash());
+  ASSERT_EQ(inputsHash, tx->getTransactionInputsHash());
+  ASSERT_EQ(inputsHash, reloadedTx(tx)->getTransactionInputsHash());
+}
+
+TEST_F(TransactionApi, prefixReaderHashesMatchTransaction) {
+  TransactionTypes::InputKeyInfo info = createInputInfo(1000);
+  KeyPair ephKeys;
+  size_t index = tx->addInput(sender, info, ephKeys);
+  tx->addOutput(500, sender.address);
+  tx->signInputKey(index, info, ephKeys);
+
+  Transaction transaction;
+  ASSERT_TRUE(fromBinaryArray(transaction, tx->getTransactionData()));
+
+  auto reader = createTransactionPrefix(transaction);
+  ASSERT_EQ(tx->getTransactionHash(), reader->getTransactionHash());
+  ASSERT_EQ(tx->getTransactionPrefixHash(), reader->getTransactionPrefixHash());
+  ASSERT_EQ(tx->getTransactionInputsHash(), reader->getTransactionInputsHash());
+  ASSERT_EQ(tx->getInputTotalAmount(), reader->getInputTotalAmount());
+  ASSERT_EQ(tx->getOutputTotalAmount(), reader->getOutputTotalAmount());
+}
+
 TEST_F(TransactionApi, findOutputs) {
   AccountKeys accounts[] = { generateAccountKeys(), generateAccountKeys(), generateAccountKeys() };
 
@@ -322,6 +377,15 @@ TEST_F(TransactionApi, appendExtra) {
   ASSERT_EQ(0, memcmp(newExtra.data() + extra.size(), ba.data(), ba.size()));
 }
 
+TEST_F(TransactionApi, appendExtraChangesHash) {
+  auto prefixHash = tx->getTransactionPrefixHash();
+  tx->appendExtra(BinaryArray(10, 0));
+
+  EXPECT_NO_FATAL_FAILURE(checkHashChanged());
+  ASSERT_NE(prefixHash, tx->getTransactionPrefixHash());
+  ASSERT_EQ(tx->getTransactionPrefixHash(), reloadedTx(tx)->getTransactionPrefixHash());
+}
+
 
 TEST_F(TransactionApi, doubleSpendInTransactionKey) {
   TransactionTypes::InputKeyInfo info = createInputInfo(1000);
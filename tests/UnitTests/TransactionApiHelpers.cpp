@@ -145,7 +145,9 @@ size_t TestTransactionBuilder::addFakeMultisignatureInput(uint64_t amount, uint3
     accs.push_back(generateAccount());
   }
 
-  msigInputs[idx] = MsigInfo{ Crypto::rand<PublicKey>(), 0, std::move(accs) };
+  PublicKey txPublicKey;
+  Random::randomBytes(sizeof(txPublicKey.data), txPublicKey.data);
+  msigInputs[idx] = MsigInfo{ txPublicKey, 0, std::move(accs) };
   return idx;
 }
 
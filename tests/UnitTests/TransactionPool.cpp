@@ -27,7 +27,7 @@
 #include "CryptoNoteCore/Currency.h"
 #include "CryptoNoteCore/TransactionExtra.h"
 #include "CryptoNoteCore/TransactionPool.h"
-#include "ICoreStub.h"
+#include "../TestStubs/ICoreStub.h"
 #include <Logging/ConsoleLogger.h>
 #include <Logging/LoggerGroup.h>
 
@@ -123,7 +123,8 @@ public:
       destinations.push_back(TransactionDestinationEntry(amountPerOut, rv_acc.getAccountKeys().address));
     }
 
-    constructTransaction(m_realSenderKeys, m_sources, destinations, std::vector<uint8_t>(), tx, 0, m_logger);
+    Crypto::SecretKey txKey;
+    constructTransaction(m_realSenderKeys, m_sources, destinations, std::vector<uint8_t>(), tx, 0, txKey, m_logger);
   }
 
   std::vector<AccountBase> m_miners;
@@ -275,6 +276,84 @@ TEST_F(tx_pool, double_spend_tx)
 }
 
 
+TEST_F(tx_pool, evicts_lowest_fee_tx_when_full)
+{
+  TestPool<TransactionValidator, RealTimeProvider> pool(currency, logger);
+  uint64_t fee = currency.minimumFee();
+
+  Transaction cheapTx;
+  Transaction expensiveTx;
+  GenerateTransaction(currency, cheapTx, fee, 1);
+  GenerateTransaction(currency, expensiveTx, fee * 2, 1);
+
+  pool.setMaxSize(getObjectBinarySize(cheapTx) + getObjectBinarySize(expensiveTx) - 1);
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(cheapTx, tvc, false));
+  ASSERT_TRUE(tvc.m_added_to_pool);
+
+  tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(expensiveTx, tvc, false));
+  ASSERT_TRUE(tvc.m_added_to_pool);
+
+  ASSERT_FALSE(pool.have_tx(getObjectHash(cheapTx)));
+  ASSERT_TRUE(pool.have_tx(getObjectHash(expensiveTx)));
+
+  uint64_t totalSize;
+  uint64_t maxSize;
+  uint64_t evictedCount;
+  pool.getSizeStatistics(totalSize, maxSize, evictedCount);
+  ASSERT_EQ(getObjectBinarySize(expensiveTx), totalSize);
+  ASSERT_EQ(1, evictedCount);
+
+  // a transaction cheaper than everything in the full pool is not admitted
+  Transaction anotherCheapTx;
+  GenerateTransaction(currency, anotherCheapTx, fee, 1);
+  tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(anotherCheapTx, tvc, false));
+  ASSERT_FALSE(tvc.m_added_to_pool);
+  ASSERT_FALSE(tvc.m_verification_failed);
+  ASSERT_TRUE(pool.have_tx(getObjectHash(expensiveTx)));
+}
+
+TEST_F(tx_pool, does_not_evict_tx_kept_by_block)
+{
+  TestPool<TransactionValidator, RealTimeProvider> pool(currency, logger);
+  uint64_t fee = currency.minimumFee();
+
+  Transaction keptTx;
+  Transaction cheapTx;
+  Transaction expensiveTx;
+  GenerateTransaction(currency, keptTx, fee, 1);
+  GenerateTransaction(currency, cheapTx, fee, 1);
+  GenerateTransaction(currency, expensiveTx, fee * 2, 1);
+
+  pool.setMaxSize(getObjectBinarySize(keptTx) + getObjectBinarySize(expensiveTx));
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(keptTx, tvc, true));
+  tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(cheapTx, tvc, false));
+  tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(expensiveTx, tvc, false));
+  ASSERT_TRUE(tvc.m_added_to_pool);
+
+  // the transaction of a popped block is as cheap as the evicted one, but stays
+  ASSERT_TRUE(pool.have_tx(getObjectHash(keptTx)));
+  ASSERT_FALSE(pool.have_tx(getObjectHash(cheapTx)));
+  ASSERT_TRUE(pool.have_tx(getObjectHash(expensiveTx)));
+
+  // nor is it evicted when nothing else is left to make room
+  pool.setMaxSize(1);
+  tvc = boost::value_initialized<tx_verification_context>();
+  Transaction anotherTx;
+  GenerateTransaction(currency, anotherTx, fee * 3, 1);
+  ASSERT_TRUE(pool.add_tx(anotherTx, tvc, false));
+  ASSERT_FALSE(tvc.m_added_to_pool);
+  ASSERT_TRUE(pool.have_tx(getObjectHash(keptTx)));
+  ASSERT_EQ(1, pool.get_transactions_count());
+}
+
 TEST_F(tx_pool, fillblock_same_fee)
 {
   TestPool<TransactionValidator, RealTimeProvider> pool(currency, logger);
@@ -662,6 +741,50 @@ TEST_F(tx_pool, RecentlyDeletedTxInfoIsSerializedAndDeserialized) {
   ASSERT_EQ(1, pool->get_transactions_count());
 }
 
+TEST_F(tx_pool, JournalWithTruncatedLastRecordIsReplayedIntoSnapshot) {
+  TransactionValidator validator;
+  FakeTimeProvider timeProvider;
+  boost::filesystem::create_directories(m_configDir);
+  boost::filesystem::path statePath = m_configDir / currency.txPoolFileName();
+  boost::filesystem::path journalPath = m_configDir / (currency.txPoolFileName() + ".journal");
+
+  std::unique_ptr<tx_memory_pool> pool(new tx_memory_pool(currency, validator, coreStub, timeProvider, logger, false));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+
+  std::vector<Crypto::Hash> ids;
+  for (size_t i = 0; i < 3; ++i) {
+    Transaction tx;
+    GenerateTransaction(currency, tx, currency.minimumFee(), 1);
+
+    tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+    ASSERT_TRUE(pool->add_tx(tx, tvc, false));
+    ASSERT_TRUE(tvc.m_added_to_pool);
+    ids.push_back(getObjectHash(tx));
+  }
+
+  // the pool isn't deinitialized, as if the daemon was killed in the middle of the last write
+  pool.reset();
+  ASSERT_FALSE(boost::filesystem::exists(statePath));
+  boost::filesystem::resize_file(journalPath, boost::filesystem::file_size(journalPath) - 1);
+
+  pool.reset(new tx_memory_pool(currency, validator, coreStub, timeProvider, logger, false));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+  ASSERT_EQ(2, pool->get_transactions_count());
+  ASSERT_TRUE(pool->have_tx(ids[0]));
+  ASSERT_TRUE(pool->have_tx(ids[1]));
+  ASSERT_FALSE(pool->have_tx(ids[2]));
+
+  // the replayed changes are in the snapshot and the journal starts over
+  ASSERT_TRUE(boost::filesystem::exists(statePath));
+  ASSERT_EQ(0, boost::filesystem::file_size(journalPath));
+
+  pool.reset(new tx_memory_pool(currency, validator, coreStub, timeProvider, logger, false));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+  ASSERT_EQ(2, pool->get_transactions_count());
+  ASSERT_TRUE(pool->have_tx(ids[0]));
+  ASSERT_TRUE(pool->have_tx(ids[1]));
+}
+
 TEST_F(tx_pool, TxPoolAcceptsValidFusionTransaction) {
   TransactionValidator validator;
   FakeTimeProvider timeProvider;